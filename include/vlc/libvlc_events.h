@@ -119,6 +119,11 @@ enum libvlc_event_e {
     libvlc_MediaPlayerAudioVolume,
     libvlc_MediaPlayerAudioDevice,
     libvlc_MediaPlayerChapterChanged,
+    /**
+     * The statistics of the current media were updated (about once per
+     * second, if the "stats" option is enabled).
+     */
+    libvlc_MediaPlayerStatsChanged,
 
     /**
      * A \link #libvlc_media_t media item\endlink was added to a
@@ -256,6 +261,11 @@ typedef struct libvlc_event_t
             int new_chapter;
         } media_player_chapter_changed;
         struct
+        {
+            /** only valid from the event callback */
+            const struct libvlc_media_stats_t *stats;
+        } media_player_stats_changed;
+        struct
         {
             float new_position;
         } media_player_position_changed;
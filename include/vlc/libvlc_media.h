@@ -110,6 +110,19 @@ typedef enum libvlc_track_type_t
     libvlc_track_text      = 2
 } libvlc_track_type_t;
 
+/**
+ * Number of buckets of the frame pacing histograms of libvlc_media_stats_t:
+ * bucket 0 counts the durations below 1 ms, bucket i those within
+ * [2^(i-1), 2^i) ms, and the last bucket all the longer ones.
+ */
+#define LIBVLC_MEDIA_STATS_PACING_BUCKETS 8
+
+/**
+ * Number of buckets of the audio output histograms of libvlc_media_stats_t,
+ * with the same layout as the frame pacing ones.
+ */
+#define LIBVLC_MEDIA_STATS_AOUT_BUCKETS 12
+
 typedef struct libvlc_media_stats_t
 {
     /* Input */
@@ -125,14 +138,49 @@ typedef struct libvlc_media_stats_t
     /* Decoders */
     int         i_decoded_video;
     int         i_decoded_audio;
+    /* Decode call duration histograms, with the frame pacing layout, and
+     * the blocks and bytes currently waiting in the decoder fifos */
+    int         i_video_decode_time[LIBVLC_MEDIA_STATS_PACING_BUCKETS];
+    int         i_audio_decode_time[LIBVLC_MEDIA_STATS_PACING_BUCKETS];
+    int         i_video_fifo_blocks;
+    int64_t     i_video_fifo_bytes;
+    int         i_audio_fifo_blocks;
+    int64_t     i_audio_fifo_bytes;
 
     /* Video Output */
     int         i_displayed_pictures;
     int         i_lost_pictures;
+    /* Frame pacing histograms: lateness of the displayed pictures against
+     * their clock date, duration of the display prepare and display calls */
+    int         i_late_pictures[LIBVLC_MEDIA_STATS_PACING_BUCKETS];
+    int         i_prepare_time[LIBVLC_MEDIA_STATS_PACING_BUCKETS];
+    int         i_display_time[LIBVLC_MEDIA_STATS_PACING_BUCKETS];
 
     /* Audio output */
     int         i_played_abuffers;
     int         i_lost_abuffers;
+    /* Audio output timing histograms: delay reported by the output and drift
+     * against the clock; count of underruns reported by the output, of
+     * resampling rate adjustments and sum of their magnitudes in Hz */
+    int         i_aout_latency[LIBVLC_MEDIA_STATS_AOUT_BUCKETS];
+    int         i_aout_drift[LIBVLC_MEDIA_STATS_AOUT_BUCKETS];
+    int         i_aout_underruns;
+    int         i_aout_resamplings;
+    int         i_aout_resampling_hz;
+
+    /* Input clock of live sources, in microseconds: drift of the stream
+     * clock, arrival jitter of its references, and the delay added to absorb
+     * this jitter */
+    int64_t     i_clock_drift;
+    int64_t     i_clock_jitter;
+    int64_t     i_dejitter;
+
+    /* Network accesses (HTTP, adaptive streaming): requests sent, estimated
+     * throughput in bits per second, and last round-trip time in
+     * microseconds (-1 if unknown) */
+    int64_t     i_net_requests;
+    int64_t     i_net_throughput;
+    int64_t     i_net_rtt;
 } libvlc_media_stats_t;
 
 typedef struct libvlc_audio_track_t
@@ -502,6 +502,65 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
                                         libvlc_video_format_cb setup,
                                         libvlc_video_cleanup_cb cleanup );
 
+/**
+ * Opaque reference to a decoded video frame lent to the application.
+ */
+typedef struct libvlc_video_frame_t libvlc_video_frame_t;
+
+/**
+ * Callback prototype to receive a decoded video frame without copy.
+ *
+ * When the video frame needs to be shown, as determined by the media playback
+ * clock, the frame callback is invoked with the picture buffers of LibVLC.
+ * The pixel planes remain valid and unmodified until the application releases
+ * the frame with libvlc_video_frame_release(), from any thread.
+ *
+ * \param opaque private pointer as passed to
+ *               libvlc_video_set_frame_callbacks() [IN]
+ * \param frame reference to the frame, to be released [IN]
+ * \param planes start address of the pixel planes [IN]
+ * \param pitches scanline pitch in bytes of each pixel plane [IN]
+ * \param lines number of scanlines of each pixel plane [IN]
+ * \param pts presentation timestamp of the frame, in microseconds [IN]
+ */
+typedef void (*libvlc_video_frame_cb)(void *opaque,
+                                      libvlc_video_frame_t *frame,
+                                      void *const *planes,
+                                      const unsigned *pitches,
+                                      const unsigned *lines,
+                                      int64_t pts);
+
+/**
+ * Set a callback to receive the decoded video frames by reference, instead of
+ * copying them into application buffers with libvlc_video_set_callbacks().
+ * Use libvlc_video_set_format() or libvlc_video_set_format_callbacks()
+ * to configure the decoded format; the pitches and lines of the format
+ * callback are ignored.
+ *
+ * Frames are dropped while the application holds max_frames of them. Holding
+ * frames for long may also stall the video decoder, which reuses them.
+ *
+ * \param mp the media player
+ * \param frame callback to receive the frames (cannot be NULL)
+ * \param max_frames maximum number of frames held by the application at once
+ * \param opaque private pointer for the callback (as first parameter)
+ * \version LibVLC 4.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_set_frame_callbacks( libvlc_media_player_t *mp,
+                                       libvlc_video_frame_cb frame,
+                                       unsigned max_frames,
+                                       void *opaque );
+
+/**
+ * Release a frame received from the @ref libvlc_video_frame_cb callback.
+ *
+ * \param frame the frame to release
+ * \version LibVLC 4.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_frame_release( libvlc_video_frame_t *frame );
+
 
 typedef struct
 {
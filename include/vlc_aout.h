@@ -121,6 +121,7 @@ struct vlc_audio_output_events {
     void (*hotplug_report)(audio_output_t *, const char *, const char *);
     void (*restart_request)(audio_output_t *, unsigned);
     int (*gain_request)(audio_output_t *, float);
+    void (*underrun_report)(audio_output_t *, unsigned);
 };
 
 /** Audio output object
@@ -455,6 +456,18 @@ static inline void aout_RestartRequest(audio_output_t *aout, unsigned mode)
     aout->events->restart_request(aout, mode);
 }
 
+/**
+ * Report underruns of the audio output to the core statistics.
+ *
+ * This function is lock-free and can be called from any thread, including
+ * the real-time audio server callback.
+ * \param count number of underruns since the last report
+ */
+static inline void aout_UnderrunReport(audio_output_t *aout, unsigned count)
+{
+    aout->events->underrun_report(aout, count);
+}
+
 /**
  * Default implementation for audio_output_t.time_get
  */
@@ -480,6 +493,81 @@ static inline void aout_PauseDefault(audio_output_t *aout, bool paused,
     (void) date;
 }
 
+/* Audio output ring buffer */
+
+/**
+ * Lock-free single producer, single consumer ring of audio frames
+ *
+ * It lets an audio output module hand the samples of play() over to the
+ * real-time callback of the audio server (pull model), without any lock or
+ * allocation on the real-time thread.
+ *
+ * aout_RingWrite(), aout_RingFlush() and aout_RingDelete() must be called
+ * from the producer side, typically play(), flush() and stop().
+ * aout_RingPeek(), aout_RingConsume() and aout_RingRead() must be called
+ * from the consumer side, typically the audio server callback.
+ * aout_RingCount() and aout_RingGetUnderruns() can be called from any
+ * thread.
+ */
+typedef struct aout_ring aout_ring_t;
+
+/**
+ * Creates a ring.
+ *
+ * \param frame_size size of an audio frame in bytes
+ * \param frames minimum capacity of the ring in frames
+ * \return the ring, or NULL on memory error
+ */
+VLC_API aout_ring_t *aout_RingNew(size_t frame_size, size_t frames) VLC_USED;
+VLC_API void aout_RingDelete(aout_ring_t *);
+
+/**
+ * Queues audio frames.
+ *
+ * \return the number of frames queued, less than requested if the ring is
+ * full
+ */
+VLC_API size_t aout_RingWrite(aout_ring_t *, const void *buf, size_t frames);
+
+/**
+ * Discards all queued frames.
+ */
+VLC_API void aout_RingFlush(aout_ring_t *);
+
+/**
+ * Gets contiguous queued frames, without dequeuing them.
+ *
+ * \param bufp pointer to the first frame [OUT]
+ * \param frames maximum number of frames
+ * \return the number of contiguous frames at *bufp
+ */
+VLC_API size_t aout_RingPeek(aout_ring_t *, const void **bufp, size_t frames);
+
+/**
+ * Dequeues the frames gotten with aout_RingPeek().
+ *
+ * \return false if the ring was flushed meanwhile, in which case the frames
+ * should be considered stale, true otherwise
+ */
+VLC_API bool aout_RingConsume(aout_ring_t *, const void *buf, size_t frames);
+
+/**
+ * Dequeues audio frames, filling the missing ones with silence.
+ *
+ * \return the number of frames dequeued
+ */
+VLC_API size_t aout_RingRead(aout_ring_t *, void *buf, size_t frames);
+
+/**
+ * Gets the number of queued frames.
+ */
+VLC_API size_t aout_RingCount(aout_ring_t *);
+
+/**
+ * Gets and resets the number of reads that ran out of frames.
+ */
+VLC_API unsigned aout_RingGetUnderruns(aout_ring_t *);
+
 /* Audio output filters */
 
 /**
@@ -306,6 +306,29 @@ VLC_API block_t *block_File(int fd, bool write) VLC_USED VLC_MALLOC;
  */
 VLC_API block_t *block_FilePath(const char *, bool write) VLC_USED VLC_MALLOC;
 
+/**
+ * Block allocator cache statistics.
+ */
+struct block_cache_stats
+{
+    uint64_t hits; /**< Allocations served from a thread cache */
+    uint64_t misses; /**< Cacheable allocations served by the heap */
+    uint64_t remote_frees; /**< Blocks released by a foreign thread */
+    uint64_t uncached; /**< Allocations too large to be cached */
+};
+
+/**
+ * Reads the block allocator cache statistics.
+ *
+ * block_Alloc() recycles small and medium blocks through per-thread caches.
+ * This function returns the cumulative counters of those caches, across all
+ * threads, since the process started. This is meant to help sizing the
+ * caches. All counters are zero if the cache is disabled at build time.
+ *
+ * @param stats structure to fill with the counters [OUT]
+ */
+VLC_API void block_CacheGetStats(struct block_cache_stats *stats);
+
 static inline void block_Cleanup (void *block)
 {
     block_Release ((block_t *)block);
@@ -328,6 +351,8 @@ static inline void block_Cleanup (void *block)
  * - block_ChainRelease : release a chain of block
  * - block_ChainExtract : extract data from a chain, return real bytes counts
  * - block_ChainGather : gather a chain, free it and return one block.
+ * - block_ChainGatherPadded : same, with zeroed room after the payload so
+ *      that decoders needing input padding don't have to reallocate.
  ****************************************************************************/
 static inline void block_ChainAppend( block_t **pp_list, block_t *p_block )
 {
@@ -405,7 +430,8 @@ static inline void block_ChainProperties( block_t *p_list, int *pi_count, size_t
         *pi_count = i_count;
 }
 
-static inline block_t *block_ChainGather( block_t *p_list )
+static inline block_t *block_ChainGatherPadded( block_t *p_list,
+                                                 size_t i_padding )
 {
     size_t  i_total = 0;
     vlc_tick_t i_length = 0;
@@ -416,10 +442,12 @@ static inline block_t *block_ChainGather( block_t *p_list )
 
     block_ChainProperties( p_list, NULL, &i_total, &i_length );
 
-    g = block_Alloc( i_total );
+    g = block_Alloc( i_total + i_padding );
     if( !g )
         return NULL;
-    block_ChainExtract( p_list, g->p_buffer, g->i_buffer );
+    block_ChainExtract( p_list, g->p_buffer, i_total );
+    memset( &g->p_buffer[i_total], 0, i_padding );
+    g->i_buffer = i_total;
 
     g->i_flags = p_list->i_flags;
     g->i_pts   = p_list->i_pts;
@@ -431,6 +459,11 @@ static inline block_t *block_ChainGather( block_t *p_list )
     return g;
 }
 
+static inline block_t *block_ChainGather( block_t *p_list )
+{
+    return block_ChainGatherPadded( p_list, 0 );
+}
+
 /**
  * @}
  * \defgroup fifo Block FIFO
@@ -639,6 +672,93 @@ static inline void vlc_fifo_Cleanup(void *fifo)
 
 /** @} */
 
+/**
+ * \defgroup spsc_fifo Single producer single consumer block FIFO
+ * \ingroup fifo
+ *
+ * Lock-free variant of the block FIFO for the common case of exactly one
+ * thread queueing blocks and exactly one (other) thread dequeueing them.
+ *
+ * Queueing and dequeueing never take a lock. The consumer only goes through
+ * the kernel when the queue is empty and it actually needs to sleep, and the
+ * producer only signals it in that case.
+ *
+ * Having more than one concurrent producer or more than one concurrent
+ * consumer is undefined behaviour. Use a \ref block_fifo_t instead.
+ * @{
+ */
+
+typedef struct vlc_spsc_fifo vlc_spsc_fifo_t;
+
+/**
+ * Creates a single producer single consumer FIFO.
+ *
+ * The created queue must be released with vlc_spsc_fifo_Delete().
+ *
+ * @return the FIFO or NULL on memory error
+ */
+VLC_API vlc_spsc_fifo_t *vlc_spsc_fifo_New(void) VLC_USED VLC_MALLOC;
+
+/**
+ * Destroys a FIFO created by vlc_spsc_fifo_New().
+ *
+ * @note Any queued blocks are also destroyed.
+ * @warning No other threads may be using the FIFO at this point.
+ */
+VLC_API void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *);
+
+/**
+ * Queues a linked-list of blocks into a FIFO.
+ *
+ * This function must only be called from the producer thread.
+ *
+ * @param block the head of the list of blocks
+ *              (if NULL, this function has no effects)
+ */
+VLC_API void vlc_spsc_fifo_Queue(vlc_spsc_fifo_t *, block_t *block);
+
+/**
+ * Dequeues the first block from a FIFO, if any.
+ *
+ * This function never waits. It must only be called from the consumer
+ * thread.
+ *
+ * @return the first block in the FIFO or NULL if the FIFO is empty
+ */
+VLC_API block_t *vlc_spsc_fifo_Dequeue(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Dequeues the first block from a FIFO, waiting if needed.
+ *
+ * This function must only be called from the consumer thread.
+ * It is a cancellation point.
+ *
+ * @return a valid block
+ */
+VLC_API block_t *vlc_spsc_fifo_Get(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Counts blocks in a FIFO.
+ *
+ * This can be called from any thread. The value is only a snapshot and may be
+ * stale by the time it is returned, like vlc_fifo_GetCount().
+ *
+ * @return the number of blocks in the FIFO
+ */
+VLC_API size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Counts bytes in a FIFO.
+ *
+ * Same as vlc_fifo_GetBytes(), with the same accuracy as
+ * vlc_spsc_fifo_GetCount().
+ *
+ * @return the total number of bytes
+ */
+VLC_API size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *) VLC_USED;
+
+/** @} */
+
 /** @} */
 
 #endif /* VLC_BLOCK_H */
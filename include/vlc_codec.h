@@ -68,6 +68,9 @@ struct decoder_owner_callbacks
             /* Display rate
              * cf. decoder_GetDisplayRate */
             float       (*get_display_rate)( decoder_t * );
+            /* Frame skipping level
+             * cf. decoder_GetSkipLevel */
+            int         (*get_skip_level)( decoder_t * );
         } video;
         struct
         {
@@ -368,6 +371,25 @@ VLC_API picture_t *decoder_NewPicture( decoder_t *dec );
  */
 VLC_API void decoder_AbortPictures( decoder_t *dec, bool b_abort );
 
+/**
+ * Reserves threads from the budget shared by all the decoders.
+ *
+ * Software decoders should call this before creating their worker threads,
+ * so that many concurrent decoders do not oversubscribe the CPUs. Each
+ * decoder gets a share of the "dec-threads" budget weighted by the
+ * "dec-threads-priority" of its input.
+ *
+ * \param wanted number of threads the decoder would use on its own
+ * \return the number of threads to use, between 1 and wanted;
+ * it must be given back with decoder_ReleaseThreads()
+ */
+VLC_API unsigned decoder_AcquireThreads( decoder_t *dec, unsigned wanted );
+
+/**
+ * Gives back threads reserved with decoder_AcquireThreads().
+ */
+VLC_API void decoder_ReleaseThreads( decoder_t *dec, unsigned count );
+
 /**
  * Initialize a decoder structure before creating the decoder.
  *
@@ -544,6 +566,35 @@ static inline float decoder_GetDisplayRate( decoder_t *dec )
     return dec->cbs->video.get_display_rate( dec );
 }
 
+/**
+ * Decoding shortcuts, from the cheapest to the most visible, that the decoder
+ * owner requests while the pictures are displayed late.
+ */
+enum vlc_decoder_skip
+{
+    VLC_DECODER_SKIP_NONE,        /**< decode everything */
+    VLC_DECODER_SKIP_NONREF,      /**< skip the non-reference frames */
+    VLC_DECODER_SKIP_LOOP_FILTER, /**< also skip the loop filter */
+    VLC_DECODER_SKIP_NONKEY,      /**< decode only the key frames */
+};
+
+/**
+ * This function returns how much decoding the decoder should skip to catch
+ * up with the clock, as a vlc_decoder_skip value.
+ *
+ * It is only meaningful if b_frame_drop_allowed is set.
+ */
+VLC_USED
+static inline int decoder_GetSkipLevel( decoder_t *dec )
+{
+    vlc_assert( dec->fmt_in.i_cat == VIDEO_ES && dec->cbs != NULL );
+
+    if( !dec->cbs->video.get_skip_level )
+        return VLC_DECODER_SKIP_NONE;
+
+    return dec->cbs->video.get_skip_level( dec );
+}
+
 /** @} */
 
 /**
@@ -60,8 +60,54 @@ typedef struct demux_meta_t
 
     int i_attachments;                  /**< number of attachments */
     input_attachment_t **attachments;    /**< array of attachments */
+
+    vlc_tick_t i_duration; /**< duration, or VLC_TICK_INVALID if unknown */
 } demux_meta_t;
 
+/* DEMUX_GET_TS_STATS histogram buckets */
+#define VLC_TS_STATS_BUCKETS 8
+
+/**
+ * Per PID statistics of a transport stream
+ */
+typedef struct vlc_ts_pid_stats
+{
+    uint16_t i_pid;
+    uint64_t i_packets;     /**< packets received */
+    uint64_t i_bitrate;     /**< bits per second, over the last second */
+    uint32_t i_cc_errors;   /**< continuity counter errors */
+    uint32_t i_pes_errors;  /**< PES packets with an invalid header */
+} vlc_ts_pid_stats_t;
+
+/**
+ * Per program clock statistics of a transport stream
+ *
+ * Jitter is the difference between the PCR increments and the arrival time
+ * increments, bucketed by absolute value at 1, 2, 5, 10, 20, 50 and 100 ms.
+ * Intervals are the delays between two PCRs, bucketed at 10, 20, 40, 60,
+ * 100, 200 and 500 ms.
+ */
+typedef struct vlc_ts_program_stats
+{
+    int        i_program;
+    uint32_t   jitter[VLC_TS_STATS_BUCKETS];
+    uint32_t   interval[VLC_TS_STATS_BUCKETS];
+    vlc_tick_t i_drift;     /**< PCR clock advance over the arrival clock */
+} vlc_ts_program_stats_t;
+
+/**
+ * Transport stream statistics, see DEMUX_GET_TS_STATS
+ *
+ * The arrays are part of the same allocation as the structure.
+ */
+typedef struct vlc_ts_stats
+{
+    size_t                  i_pids;
+    vlc_ts_pid_stats_t     *p_pids;
+    size_t                  i_programs;
+    vlc_ts_program_stats_t *p_programs;
+} vlc_ts_stats_t;
+
 /**
  * Control query identifiers for use with demux_t.pf_control
  *
@@ -119,6 +165,12 @@ enum demux_query_e
      * arg1=double *quality, arg2=double *strength */
     DEMUX_GET_SIGNAL = 0x107,
 
+    /** Retrieves the transfer statistics of network accesses.
+     * Can fail.
+     *
+     * arg1= struct vlc_stream_network * */
+    DEMUX_GET_NETWORK = 0x10a,
+
     /** Sets the paused or playing/resumed state.
      *
      * Streams are initially in playing state. The control always specifies a
@@ -271,7 +323,23 @@ enum demux_query_e
      * work in future VLC versions, nor with all demux filters
      */
     DEMUX_FILTER_ENABLE,
-    DEMUX_FILTER_DISABLE
+    DEMUX_FILTER_DISABLE,
+
+    /** Retrieves transport stream statistics.
+     * Can fail if the demuxer is not a transport stream demuxer.
+     * The result must be released with free().
+     *
+     * arg1= vlc_ts_stats_t ** */
+    DEMUX_GET_TS_STATS,
+
+    /** Finds the closest keyframe at or before a time, for frame accurate
+     * seeking: the caller seeks to the keyframe time, then skips the given
+     * count of video frames (in decoding order) to reach the time.
+     * Can fail if the demuxer has no index.
+     *
+     * arg1= vlc_tick_t i_time, arg2= vlc_tick_t *pi_keyframe,
+     * arg3= unsigned *pi_skip */
+    DEMUX_GET_KEYFRAME,
 };
 
 /*************************************************************************
@@ -64,6 +64,19 @@ typedef struct
     float      pf_gain[AUDIO_REPLAY_GAIN_MAX];
 } audio_replay_gain_t;
 
+/**
+ * Audio gapless playback information
+ *
+ * Encoders add priming samples before the signal, and padding samples after
+ * it. The decoded samples outside of the signal are trimmed, so that tracks
+ * follow each other without gaps.
+ */
+typedef struct
+{
+    uint32_t i_delay; /**< decoded samples before the signal */
+    uint64_t i_samples; /**< samples of the signal, or 0 if unknown */
+} audio_gapless_t;
+
 
 /**
  * Audio channel type
@@ -641,6 +654,7 @@ struct es_format_t
         struct {
             audio_format_t  audio;    /**< description of audio format */
             audio_replay_gain_t audio_replay_gain; /*< audio replay gain information */
+            audio_gapless_t audio_gapless; /*< audio gapless information */
         };
         video_format_t video;     /**< description of video format */
         subs_format_t  subs;      /**< description of subtitle format */
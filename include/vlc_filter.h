@@ -51,12 +51,18 @@ struct filter_subpicture_callbacks
     subpicture_t *(*buffer_new)(filter_t *);
 };
 
+struct filter_audio_callbacks
+{
+    block_t *(*buffer_new)(filter_t *, size_t);
+};
+
 typedef struct filter_owner_t
 {
     union
     {
         const struct filter_video_callbacks *video;
         const struct filter_subpicture_callbacks *sub;
+        const struct filter_audio_callbacks *audio;
     };
     void *sys;
 } filter_owner_t;
@@ -148,6 +154,21 @@ struct filter_t
                                const struct vlc_mouse_t *p_new );
     };
 
+    /** Filter pixels in place (video filter, optional).
+     *
+     * Filters processing each pixel independently of the others, with the
+     * same input and output formats, can set this in addition to
+     * pf_video_filter. The filter chain then runs consecutive such filters
+     * in a single pass, over bands of lines of a picture it owns.
+     *
+     * The destination can be the same picture as the source. The pictures
+     * can be horizontal bands of the full pictures: only their planes are
+     * to be processed, not their formats. This can be called several times
+     * per picture, and must not fail.
+     */
+    void (*pf_video_filter_inplace)( filter_t *, picture_t *p_dst,
+                                     picture_t *p_src );
+
     /* Input attachments
      * XXX use filter_GetInputAttachments */
     int (*pf_get_attachments)( filter_t *, input_attachment_t ***, int * );
@@ -226,6 +247,24 @@ static inline vlc_decoder_device * filter_HoldDecoderDeviceType( filter_t *p_fil
 /**
  * This function will drain, then flush an audio filter.
  */
+/**
+ * This function will return a new audio buffer usable by p_filter as an
+ * output buffer. Audio filters should process samples in place whenever they
+ * can, and only resort to this function when they cannot.
+ *
+ * The buffer may be recycled from a pool of the owner.
+ *
+ * \param size size of the buffer in bytes
+ * \return a new block, or NULL on error
+ */
+static inline block_t *filter_NewAudioBuffer( filter_t *p_filter, size_t size )
+{
+    if( p_filter->owner.audio != NULL
+     && p_filter->owner.audio->buffer_new != NULL )
+        return p_filter->owner.audio->buffer_new( p_filter, size );
+    return block_Alloc( size );
+}
+
 static inline block_t *filter_DrainAudio( filter_t *p_filter )
 {
     if( p_filter->pf_audio_drain )
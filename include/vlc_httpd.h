@@ -123,6 +123,15 @@ typedef struct httpd_file_t     httpd_file_t;
 typedef struct httpd_file_sys_t httpd_file_sys_t;
 typedef int (*httpd_file_callback_t)( httpd_file_sys_t *, httpd_file_t *, uint8_t *psz_request, uint8_t **pp_data, int *pi_data );
 VLC_API httpd_file_t * httpd_FileNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password, httpd_file_callback_t pf_fill, httpd_file_sys_t * ) VLC_USED;
+/**
+ * Serves a file from the file system.
+ *
+ * The file is opened and its current content sent for each request.
+ * On unencrypted hosts, the data is sent without copying through user space
+ * where the operating system supports it.
+ * The resulting object must be deleted with httpd_FileDelete().
+ */
+VLC_API httpd_file_t * httpd_FilePathNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password, const char *psz_path ) VLC_USED;
 VLC_API httpd_file_sys_t * httpd_FileDelete( httpd_file_t * );
 
 
@@ -142,6 +151,15 @@ VLC_API void httpd_StreamDelete( httpd_stream_t * );
 VLC_API int httpd_StreamHeader( httpd_stream_t *, uint8_t *p_data, int i_data );
 VLC_API int httpd_StreamSend( httpd_stream_t *, const block_t *p_block );
 VLC_API int httpd_StreamSetHTTPHeaders(httpd_stream_t *, const httpd_header *, size_t);
+/**
+ * Keeps a keyframe-aligned backlog of the stream.
+ *
+ * When the stream data signals keyframes (BLOCK_FLAG_TYPE_I), the last
+ * \p count groups of pictures are kept, so that new clients start at once
+ * from a keyframe, and clients that fall behind skip whole GOPs.
+ * Zero disables the backlog (this is the default).
+ */
+VLC_API int httpd_StreamSetGOPCount(httpd_stream_t *, unsigned count);
 
 /* Msg functions facilities */
 VLC_API void httpd_MsgAdd( httpd_message_t *, const char *psz_name, const char *psz_value, ... ) VLC_FORMAT( 3, 4 );
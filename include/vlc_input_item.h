@@ -466,6 +466,13 @@ typedef enum input_item_meta_request_option_t
     META_REQUEST_OPTION_FETCH_NETWORK = 0x08,
     META_REQUEST_OPTION_FETCH_ANY     = 0x0C,
     META_REQUEST_OPTION_DO_INTERACT   = 0x10,
+    /* The item is shown to the user: preparse it before the queued ones */
+    META_REQUEST_OPTION_PRIORITY_VISIBLE  = 0x20,
+    /* Speculative request: preparse it after the queued ones */
+    META_REQUEST_OPTION_PRIORITY_PREFETCH = 0x40,
+    /* Only the meta data and the duration are needed (not the tracks): local
+     * files may be read by a "meta reader" module, without opening them */
+    META_REQUEST_OPTION_META_ONLY         = 0x80,
 } input_item_meta_request_option_t;
 
 /* status of the on_preparse_ended() callback */
@@ -500,6 +507,46 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+
+/**
+ * Number of buckets of the frame pacing histograms: bucket 0 counts the
+ * durations below 1 ms, bucket i those within [2^(i-1), 2^i) ms, and the
+ * last bucket all the longer ones.
+ */
+#define INPUT_STATS_PACING_BUCKETS 8
+
+/** Frame pacing histograms of the video outputs */
+typedef struct input_pacing_stats_t
+{
+    int64_t i_late[INPUT_STATS_PACING_BUCKETS];    /**< display vs clock date */
+    int64_t i_prepare[INPUT_STATS_PACING_BUCKETS]; /**< prepare duration */
+    int64_t i_display[INPUT_STATS_PACING_BUCKETS]; /**< display duration */
+} input_pacing_stats_t;
+
+/**
+ * Number of buckets of the audio output histograms, with the same layout as
+ * the frame pacing ones, so that the last bucket starts at 1 s.
+ */
+#define INPUT_STATS_AOUT_BUCKETS 12
+
+/** Timing statistics of the audio outputs */
+typedef struct input_aout_stats_t
+{
+    int64_t i_latency[INPUT_STATS_AOUT_BUCKETS]; /**< reported output delay */
+    int64_t i_drift[INPUT_STATS_AOUT_BUCKETS];   /**< drift vs the clock */
+    int64_t i_underruns;     /**< underruns reported by the output */
+    int64_t i_resamplings;   /**< resampling rate adjustments */
+    int64_t i_resampling_hz; /**< sum of the adjustments magnitudes */
+} input_aout_stats_t;
+
+/** Statistics of the decoders of one ES category */
+typedef struct input_decoder_stats_t
+{
+    int64_t i_decode[INPUT_STATS_PACING_BUCKETS]; /**< decode call duration */
+    int64_t i_fifo_blocks; /**< blocks waiting to be decoded, currently */
+    int64_t i_fifo_bytes;  /**< bytes waiting to be decoded, currently */
+} input_decoder_stats_t;
+
 struct input_stats_t
 {
     /* Input */
@@ -517,14 +564,33 @@ struct input_stats_t
     /* Decoders */
     int64_t i_decoded_audio;
     int64_t i_decoded_video;
+    input_decoder_stats_t video_decoder;
+    input_decoder_stats_t audio_decoder;
 
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    input_pacing_stats_t pacing;
 
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+    input_aout_stats_t aout;
+
+    /* Input clock of live sources */
+    vlc_tick_t i_clock_drift;   /**< drift of the stream clock */
+    vlc_tick_t i_clock_jitter;  /**< arrival jitter of the clock references */
+    vlc_tick_t i_dejitter;      /**< delay added to absorb the jitter */
+
+    /* Network accesses, as reported by the master source */
+    int64_t i_net_requests;     /**< requests sent */
+    int64_t i_net_throughput;   /**< estimated throughput, in bits/s */
+    vlc_tick_t i_net_rtt;       /**< last round-trip time, or
+                                     VLC_TICK_INVALID if unknown */
+
+    /* Processing */
+    vlc_tick_t i_cpu_time;      /**< CPU time used by the input thread, or
+                                     VLC_TICK_INVALID if unknown */
 };
 
 /**
@@ -200,6 +200,54 @@ VLC_API ssize_t net_Write( vlc_object_t *p_this, int fd, const void *p_data, siz
 
 VLC_API int vlc_close(int);
 
+/**
+ * \defgroup reactor Shared socket reactor
+ *
+ * Waits for many sockets from a single shared thread, instead of one thread
+ * per socket blocked in poll().
+ *
+ * A registered socket is one-shot: once its callback has been invoked, it is
+ * not waited for until vlc_reactor_Arm() is called again (typically from the
+ * callback, after non-blocking I/O returned EAGAIN).
+ * Callbacks run on the reactor thread, and must not block.
+ * @{
+ */
+
+typedef struct vlc_reactor_fd vlc_reactor_fd_t;
+
+/**
+ * Registers a socket with the reactor.
+ *
+ * \param fd socket (should be non-blocking)
+ * \param events poll() events to wait for (or 0 to register it disarmed)
+ * \param cb callback invoked with the poll() returned events
+ * \param opaque data for the callback
+ * \return a registration handle, or NULL on error (not supported, or out of
+ * memory), in which case the caller should wait for the socket by itself
+ */
+VLC_API vlc_reactor_fd_t *vlc_reactor_Add(int fd, short events,
+                                          void (*cb)(void *opaque, int fd,
+                                                     short revents),
+                                          void *opaque) VLC_USED;
+
+/**
+ * Waits again for events on a registered socket.
+ *
+ * This can be called from any thread, including from the callback.
+ */
+VLC_API void vlc_reactor_Arm(vlc_reactor_fd_t *, short events);
+
+/**
+ * Unregisters a socket.
+ *
+ * Once this function returns, the callback is not running, and will not be
+ * invoked anymore, unless this is called from the callback itself.
+ * The socket is not closed.
+ */
+VLC_API void vlc_reactor_Remove(vlc_reactor_fd_t *);
+
+/** @} */
+
 /** @} */
 
 #ifdef _WIN32
@@ -149,6 +149,7 @@ struct picture_t
     bool            b_progressive;          /**< is it a progressive frame? */
     bool            b_top_field_first;             /**< which field is first */
     unsigned int    i_nb_fields;                  /**< number of displayed fields */
+    bool            b_keyframe;   /**< encode as a key (IDR) frame */
     picture_context_t *context;      /**< video format-specific data pointer */
     /**@}*/
 
@@ -402,6 +402,24 @@ enum vlc_player_restore_playback_pos
 VLC_API int
 vlc_player_SetCurrentMedia(vlc_player_t *player, input_item_t *media);
 
+/**
+ * Set the medias to keep opened in standby
+ *
+ * The player keeps these medias opened, their demuxers running but none of
+ * their tracks decoded, so that switching to one of them with
+ * vlc_player_SetCurrentMedia() does not need to open it again. This is meant
+ * for live streams, like the channels next to the current one.
+ *
+ * The medias previously in standby and not in the list are closed.
+ *
+ * @param player locked player instance
+ * @param medias array of medias (will be held by the player)
+ * @param count number of medias, 0 to close all the standby medias
+ */
+VLC_API void
+vlc_player_SetStandbyMedias(vlc_player_t *player, input_item_t *const *medias,
+                            size_t count);
+
 /**
  * Get the current played media.
  *
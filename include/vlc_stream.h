@@ -146,6 +146,18 @@ struct stream_t
     void *p_sys;
 };
 
+/**
+ * Transfer statistics of network accesses.
+ *
+ * \see STREAM_GET_NETWORK
+ */
+struct vlc_stream_network
+{
+    uint64_t requests;   /**< requests sent so far */
+    uint64_t throughput; /**< estimated throughput, in bits per second */
+    vlc_tick_t rtt;      /**< last round-trip time, or VLC_TICK_INVALID */
+};
+
 /**
  * Possible commands to send to vlc_stream_Control() and vlc_stream_vaControl()
  */
@@ -156,6 +168,8 @@ enum stream_query_e
     STREAM_CAN_FASTSEEK,        /**< arg1= bool *   res=cannot fail*/
     STREAM_CAN_PAUSE,           /**< arg1= bool *   res=cannot fail*/
     STREAM_CAN_CONTROL_PACE,    /**< arg1= bool *   res=cannot fail*/
+    STREAM_IS_MAPPED,           /**< arg1= bool *   res=can fail
+                                     (blocks map the content in place) */
     /* */
     STREAM_GET_SIZE=6,          /**< arg1= uint64_t *     res=can fail */
 
@@ -168,6 +182,9 @@ enum stream_query_e
     STREAM_GET_CONTENT_TYPE,    /**< arg1= char **         res=can fail */
     STREAM_GET_SIGNAL,      /**< arg1=double *pf_quality, arg2=double *pf_strength   res=can fail */
     STREAM_GET_TAGS,        /**< arg1=const block_t ** res=can fail */
+    STREAM_GET_VALIDATOR,   /**< arg1= char ** (entity tag or modification
+                                 time of the content) res=can fail */
+    STREAM_GET_NETWORK,     /**< arg1= struct vlc_stream_network * res=can fail */
 
     STREAM_SET_PAUSE_STATE = 0x200, /**< arg1= bool        res=can fail */
     STREAM_SET_TITLE,       /**< arg1= int          res=can fail */
@@ -43,6 +43,24 @@ typedef struct vlc_thumbnailer_request_t vlc_thumbnailer_request_t;
  */
 typedef void(*vlc_thumbnailer_cb)( void* data, picture_t* thumbnail );
 
+/**
+ * \brief vlc_thumbnailer_batch_cb defines a callback invoked for each
+ * thumbnail of a batch request
+ *
+ * This callback is called once for each requested time, in the order of the
+ * request, unless the request is cancelled. Once a thumbnail failed, the
+ * remaining ones are all reported as failed.
+ * The picture, if any, is owned by the thumbnailer, and must be acquired by
+ * using \link picture_Hold \endlink to use it pass the callback's scope.
+ *
+ * \param data Is the opaque pointer passed as the request last parameter
+ * \param index The index of the requested time
+ * \param thumbnail The generated thumbnail, or NULL in case of failure or
+ *                  timeout
+ */
+typedef void(*vlc_thumbnailer_batch_cb)( void* data, size_t index,
+                                         picture_t* thumbnail );
+
 
 /**
  * \brief vlc_thumbnailer_Create Creates a thumbnailer object
@@ -112,6 +130,42 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
                               input_item_t *input_item, vlc_tick_t timeout,
                               vlc_thumbnailer_cb cb, void* user_data );
 
+/**
+ * \brief vlc_thumbnailer_RequestBatchByTime Requests thumbnails at several
+ * times of the same media
+ * \param thumbnailer A thumbnailer object
+ * \param times The times at which the thumbnails should be taken (preferably
+ *              in increasing order)
+ * \param count The number of times (must not be 0)
+ * \param speed The seeking speed \sa{enum vlc_thumbnailer_seek_speed}
+ * \param input_item The input item to generate the thumbnails for
+ * \param timeout A timeout value for the whole batch, or VLC_TICK_INVALID to
+ *                disable timeout
+ * \param cb A user callback to be called for each thumbnail
+ * \param user_data An opaque value, provided as cb's first parameter
+ * \return An opaque request object, or NULL in case of failure
+ *
+ * The thumbnails are generated with a single input (and decoder), which is
+ * seeked from one time to the next, instead of opening the media for each
+ * thumbnail.
+ *
+ * If this function returns a valid request object, the callback is
+ * guaranteed to be called count times, even in case of later failure.
+ * The returned request object must not be used after the last callback has
+ * been invoked. That request object is owned by the thumbnailer, and must not
+ * be released.
+ * The provided input_item will be held by the thumbnailer and can safely be
+ * released after calling this function.
+ */
+VLC_API vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatchByTime( vlc_thumbnailer_t *thumbnailer,
+                                    const vlc_tick_t *times, size_t count,
+                                    enum vlc_thumbnailer_seek_speed speed,
+                                    input_item_t *input_item,
+                                    vlc_tick_t timeout,
+                                    vlc_thumbnailer_batch_cb cb,
+                                    void* user_data );
+
 /**
  * \brief vlc_thumbnailer_Cancel Cancel a thumbnail request
  * \param thumbnailer A thumbnailer object
@@ -120,6 +120,12 @@ struct vlc_tls_operations
      * if there is one. See also \ref vlc_tls_SessionDelete().
      */
     void (*close)(struct vlc_tls *);
+
+    /** Callback for zero-copy sending (optional).
+     *
+     * See \ref vlc_tls_GetSendFD().
+     */
+    int (*get_send_fd)(struct vlc_tls *);
 };
 
 /**
@@ -328,6 +334,25 @@ static inline int vlc_tls_GetFD(vlc_tls_t *tls)
     return vlc_tls_GetPollFD(tls, &events);
 }
 
+/**
+ * Returns the file descriptor to send raw data to.
+ *
+ * This function returns the socket underlying the transport layer stream
+ * object if data written directly to it is sent as is on the stream, that is
+ * if the stream is a plain socket, or a TLS session whose records are
+ * encrypted by the kernel. The socket can then be used with sendfile() or
+ * splice() for zero-copy sending. Pending data must be flushed first.
+ * This function is reentrant and is not a cancellation point.
+ *
+ * @return a socket file descriptor, or -1 if not supported
+ */
+static inline int vlc_tls_GetSendFD(vlc_tls_t *tls)
+{
+    if (tls->ops->get_send_fd == NULL)
+        return -1;
+    return tls->ops->get_send_fd(tls);
+}
+
 /**
  * Receives data through a socket.
  *
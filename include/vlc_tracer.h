@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * vlc_tracer.h: tracing interface
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TRACER_H
+#define VLC_TRACER_H
+
+/**
+ * \defgroup tracer Tracer
+ * \ingroup os
+ * Timeline of the pipeline events
+ *
+ * The tracer records timestamped spans and instants of the main processing
+ * stages (demux, decoding, filtering, display...), so that the journey of a
+ * frame through the pipeline can be followed. It is only enabled when a
+ * tracer module is selected with the "tracer" option; otherwise tracing
+ * costs little more than a pointer test.
+ * @{
+ * \file
+ * Tracer interface
+ */
+
+enum vlc_tracer_phase
+{
+    VLC_TRACER_BEGIN, /**< start of a span */
+    VLC_TRACER_END, /**< end of the last span begun by the same thread */
+    VLC_TRACER_INSTANT, /**< single point in time */
+};
+
+/**
+ * Trace event.
+ *
+ * The strings must be static constants: they are not copied.
+ */
+struct vlc_tracer_event
+{
+    const char *category; /**< pipeline stage, e.g. "demux" */
+    const char *name; /**< event name */
+    enum vlc_tracer_phase phase;
+    vlc_tick_t date; /**< system date of the event */
+    unsigned long thread; /**< thread ID, as vlc_thread_id() */
+    const void *object; /**< emitting object, to tell instances apart */
+    vlc_tick_t pts; /**< media timestamp, or VLC_TICK_INVALID */
+};
+
+/**
+ * Tracer module operations.
+ */
+struct vlc_tracer_operations
+{
+    /**
+     * Records an event.
+     *
+     * This is called from any thread, in the hot paths of the pipeline. It
+     * must neither block nor log.
+     */
+    void (*trace)(void *opaque, const struct vlc_tracer_event *event);
+    void (*destroy)(void *opaque);
+};
+
+struct vlc_tracer;
+
+/**
+ * Records an event.
+ *
+ * \param tracer tracer (cannot be NULL)
+ * \param category static string of the pipeline stage
+ * \param name static string of the event
+ * \param phase span begin or end, or instant event
+ * \param object emitting object
+ * \param pts media timestamp of the processed data, or VLC_TICK_INVALID
+ */
+VLC_API void vlc_tracer_Trace(struct vlc_tracer *tracer, const char *category,
+                              const char *name, enum vlc_tracer_phase phase,
+                              const void *object, vlc_tick_t pts);
+
+/**
+ * Gets the tracer of the LibVLC instance of an object.
+ *
+ * \return the tracer, or NULL if tracing is disabled
+ */
+VLC_API struct vlc_tracer *vlc_object_get_tracer(vlc_object_t *obj);
+#define vlc_object_get_tracer(o) vlc_object_get_tracer(VLC_OBJECT(o))
+
+static inline void vlc_tracer_Begin(struct vlc_tracer *tracer,
+                                    const char *category, const char *name,
+                                    const void *object, vlc_tick_t pts)
+{
+    if (tracer != NULL)
+        vlc_tracer_Trace(tracer, category, name, VLC_TRACER_BEGIN, object,
+                         pts);
+}
+
+static inline void vlc_tracer_End(struct vlc_tracer *tracer,
+                                  const char *category, const char *name,
+                                  const void *object, vlc_tick_t pts)
+{
+    if (tracer != NULL)
+        vlc_tracer_Trace(tracer, category, name, VLC_TRACER_END, object, pts);
+}
+
+static inline void vlc_tracer_Instant(struct vlc_tracer *tracer,
+                                      const char *category, const char *name,
+                                      const void *object, vlc_tick_t pts)
+{
+    if (tracer != NULL)
+        vlc_tracer_Trace(tracer, category, name, VLC_TRACER_INSTANT, object,
+                         pts);
+}
+
+/** @} */
+#endif
@@ -59,6 +59,7 @@ typedef struct
     struct
     {
         bool b_loop;    /*< this vlc_media_t broadcast item should loop */
+        bool b_share;   /*< demux identical inputs once for all the outputs */
     } broadcast;        /*< Broadcast specific information */
     struct
     {
@@ -77,6 +78,9 @@ typedef struct
     double      d_position; /*< vlm media instance position in stream */
     bool        b_paused;   /*< vlm media instance is paused */
     float       f_rate;     // normal is 1.0f
+    float       f_cpu;      /*< input thread CPU usage, in percent */
+    int64_t     i_bitrate;  /*< input bitrate, in bits per second */
+    bool        b_shared;   /*< the input is shared with other instances */
 } vlm_media_instance_t;
 
 #if 0
@@ -102,6 +106,7 @@ enum vlm_event_type_e
     VLM_EVENT_MEDIA_INSTANCE_STARTED    = 0x200,
     VLM_EVENT_MEDIA_INSTANCE_STOPPED,
     VLM_EVENT_MEDIA_INSTANCE_STATE,
+    VLM_EVENT_MEDIA_INSTANCE_STATISTICS,
 };
 
 typedef enum vlm_state_e
@@ -121,6 +126,8 @@ typedef struct
     const char    *psz_name;          /* Media name */
     const char    *psz_instance_name; /* Instance name or NULL */
     vlm_state_e    input_state;       /* Input instance event type */
+    float          f_cpu;             /* CPU usage (statistics event) */
+    int64_t        i_bitrate;         /* Bitrate (statistics event) */
 } vlm_event_t;
 
 /** VLM control query */
@@ -221,6 +228,7 @@ static inline void vlm_media_Init( vlm_media_t *p_media )
 
     p_media->vod.psz_mux = NULL;
     p_media->broadcast.b_loop = false;
+    p_media->broadcast.b_share = false;
 }
 
 /**
@@ -260,6 +268,7 @@ vlm_media_Copy( vlm_media_t *p_dst, const vlm_media_t *p_src )
     else
     {
         p_dst->broadcast.b_loop = p_src->broadcast.b_loop;
+        p_dst->broadcast.b_share = p_src->broadcast.b_share;
     }
 }
 
@@ -335,6 +344,9 @@ static inline void vlm_media_instance_Init( vlm_media_instance_t *p_instance )
     p_instance->d_position = 0.0;
     p_instance->b_paused = false;
     p_instance->f_rate = 1.0f;
+    p_instance->f_cpu = 0.f;
+    p_instance->i_bitrate = 0;
+    p_instance->b_shared = false;
 }
 
 /**
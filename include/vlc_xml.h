@@ -81,6 +81,15 @@ VLC_API xml_reader_t * xml_ReaderCreate(vlc_object_t *, stream_t *) VLC_USED;
 #define xml_ReaderCreate( a, s ) xml_ReaderCreate(VLC_OBJECT(a), s)
 VLC_API void xml_ReaderDelete(xml_reader_t *);
 
+/**
+ * Moves to the next node.
+ *
+ * \param pval where to store the element name or the text (or NULL)
+ * \return the node type (XML_READER_*), 0 at the end, or XML_READER_ERROR
+ * \note The returned string is owned by the reader, and is only valid until
+ * the next call to xml_ReaderNextNode(). Readers should not copy it, so that
+ * pull parsers can read large documents without allocating per node.
+ */
 static inline int xml_ReaderNextNode( xml_reader_t *reader, const char **pval )
 {
     return reader->pf_next_node( reader, pval );
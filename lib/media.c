@@ -106,6 +106,11 @@ static const libvlc_meta_t vlc_to_libvlc_meta[] =
     [vlc_meta_DiscTotal]    = libvlc_meta_DiscTotal
 };
 
+static_assert(
+    LIBVLC_MEDIA_STATS_PACING_BUCKETS == INPUT_STATS_PACING_BUCKETS &&
+    LIBVLC_MEDIA_STATS_AOUT_BUCKETS == INPUT_STATS_AOUT_BUCKETS,
+    "Mismatch between libvlc_media_stats_t and input_stats_t histograms" );
+
 static_assert(
     ORIENT_TOP_LEFT     == (int) libvlc_video_orient_top_left &&
     ORIENT_TOP_RIGHT    == (int) libvlc_video_orient_top_right &&
@@ -713,6 +718,15 @@ bool libvlc_media_get_stats(libvlc_media_t *p_md,
         return false;
     }
 
+    libvlc_media_stats_from_input( p_stats, p_itm_stats );
+
+    vlc_mutex_unlock( &item->lock );
+    return true;
+}
+
+void libvlc_media_stats_from_input( libvlc_media_stats_t *p_stats,
+                                    const input_stats_t *p_itm_stats )
+{
     p_stats->i_read_bytes = p_itm_stats->i_read_bytes;
     p_stats->f_input_bitrate = p_itm_stats->f_input_bitrate;
 
@@ -723,15 +737,46 @@ bool libvlc_media_get_stats(libvlc_media_t *p_md,
 
     p_stats->i_decoded_video = p_itm_stats->i_decoded_video;
     p_stats->i_decoded_audio = p_itm_stats->i_decoded_audio;
+    for( unsigned i = 0; i < LIBVLC_MEDIA_STATS_PACING_BUCKETS; i++ )
+    {
+        p_stats->i_video_decode_time[i] =
+            p_itm_stats->video_decoder.i_decode[i];
+        p_stats->i_audio_decode_time[i] =
+            p_itm_stats->audio_decoder.i_decode[i];
+    }
+    p_stats->i_video_fifo_blocks = p_itm_stats->video_decoder.i_fifo_blocks;
+    p_stats->i_video_fifo_bytes = p_itm_stats->video_decoder.i_fifo_bytes;
+    p_stats->i_audio_fifo_blocks = p_itm_stats->audio_decoder.i_fifo_blocks;
+    p_stats->i_audio_fifo_bytes = p_itm_stats->audio_decoder.i_fifo_bytes;
 
     p_stats->i_displayed_pictures = p_itm_stats->i_displayed_pictures;
     p_stats->i_lost_pictures = p_itm_stats->i_lost_pictures;
+    for( unsigned i = 0; i < LIBVLC_MEDIA_STATS_PACING_BUCKETS; i++ )
+    {
+        p_stats->i_late_pictures[i] = p_itm_stats->pacing.i_late[i];
+        p_stats->i_prepare_time[i] = p_itm_stats->pacing.i_prepare[i];
+        p_stats->i_display_time[i] = p_itm_stats->pacing.i_display[i];
+    }
 
     p_stats->i_played_abuffers = p_itm_stats->i_played_abuffers;
     p_stats->i_lost_abuffers = p_itm_stats->i_lost_abuffers;
-
-    vlc_mutex_unlock( &item->lock );
-    return true;
+    for( unsigned i = 0; i < LIBVLC_MEDIA_STATS_AOUT_BUCKETS; i++ )
+    {
+        p_stats->i_aout_latency[i] = p_itm_stats->aout.i_latency[i];
+        p_stats->i_aout_drift[i] = p_itm_stats->aout.i_drift[i];
+    }
+    p_stats->i_aout_underruns = p_itm_stats->aout.i_underruns;
+    p_stats->i_aout_resamplings = p_itm_stats->aout.i_resamplings;
+    p_stats->i_aout_resampling_hz = p_itm_stats->aout.i_resampling_hz;
+
+    p_stats->i_clock_drift = US_FROM_VLC_TICK(p_itm_stats->i_clock_drift);
+    p_stats->i_clock_jitter = US_FROM_VLC_TICK(p_itm_stats->i_clock_jitter);
+    p_stats->i_dejitter = US_FROM_VLC_TICK(p_itm_stats->i_dejitter);
+
+    p_stats->i_net_requests = p_itm_stats->i_net_requests;
+    p_stats->i_net_throughput = p_itm_stats->i_net_throughput;
+    p_stats->i_net_rtt = p_itm_stats->i_net_rtt != VLC_TICK_INVALID
+                       ? US_FROM_VLC_TICK(p_itm_stats->i_net_rtt) : -1;
 }
 
 /**************************************************************************
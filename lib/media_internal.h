@@ -56,4 +56,8 @@ libvlc_media_t * libvlc_media_new_from_input_item(
 void libvlc_media_set_state( libvlc_media_t *, libvlc_state_t );
 void libvlc_media_add_subtree(libvlc_media_t *, input_item_node_t *);
 
+/* Statistics */
+void libvlc_media_stats_from_input( libvlc_media_stats_t *,
+                                    const input_stats_t * );
+
 #endif
@@ -371,6 +371,24 @@ on_chapter_selection_changed(vlc_player_t *player,
     libvlc_event_send(&mp->event_manager, &event);
 }
 
+static void
+on_statistics_changed(vlc_player_t *player, const struct input_stats_t *stats,
+                      void *data)
+{
+    (void) player;
+
+    libvlc_media_player_t *mp = data;
+    libvlc_media_stats_t media_stats;
+
+    libvlc_media_stats_from_input(&media_stats, stats);
+
+    libvlc_event_t event;
+    event.type = libvlc_MediaPlayerStatsChanged;
+    event.u.media_player_stats_changed.stats = &media_stats;
+
+    libvlc_event_send(&mp->event_manager, &event);
+}
+
 static void
 on_media_subitems_changed(vlc_player_t *player, input_item_t *media,
                           input_item_node_t *new_subitems, void *data)
@@ -485,6 +503,7 @@ static const struct vlc_player_cbs vlc_player_cbs = {
     .on_program_selection_changed = on_program_selection_changed,
     .on_title_selection_changed = on_title_selection_changed,
     .on_chapter_selection_changed = on_chapter_selection_changed,
+    .on_statistics_changed = on_statistics_changed,
     .on_media_subitems_changed = on_media_subitems_changed,
     .on_cork_changed = on_cork_changed,
     .on_vout_changed = on_vout_changed,
@@ -588,6 +607,8 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-data", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-setup", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-cleanup", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-frame", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-frames", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-chroma", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-width", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-height", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
@@ -1010,6 +1031,7 @@ void libvlc_video_set_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-unlock", unlock_cb );
     var_SetAddress( mp, "vmem-display", display_cb );
     var_SetAddress( mp, "vmem-data", opaque );
+    var_SetAddress( mp, "vmem-frame", NULL );
     var_SetString( mp, "dec-dev", "none" );
     var_SetString( mp, "vout", "vmem" );
     var_SetString( mp, "window", "dummy" );
@@ -1023,6 +1045,26 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-cleanup", cleanup );
 }
 
+void libvlc_video_set_frame_callbacks( libvlc_media_player_t *mp,
+                                       libvlc_video_frame_cb frame_cb,
+                                       unsigned max_frames, void *opaque )
+{
+    var_SetAddress( mp, "vmem-frame", frame_cb );
+    var_SetInteger( mp, "vmem-frames", max_frames );
+    var_SetAddress( mp, "vmem-lock", NULL );
+    var_SetAddress( mp, "vmem-unlock", NULL );
+    var_SetAddress( mp, "vmem-display", NULL );
+    var_SetAddress( mp, "vmem-data", opaque );
+    var_SetString( mp, "dec-dev", "none" );
+    var_SetString( mp, "vout", "vmem" );
+    var_SetString( mp, "window", "dummy" );
+}
+
+void libvlc_video_frame_release( libvlc_video_frame_t *frame )
+{
+    picture_Release( (picture_t *)frame );
+}
+
 void libvlc_video_set_format( libvlc_media_player_t *mp, const char *chroma,
                               unsigned width, unsigned height, unsigned pitch )
 {
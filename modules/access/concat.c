@@ -28,18 +28,38 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_access.h>
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+
+/* The next part is opened and pre-buffered from a background thread when
+ * the current one has less than this left, so that the switch does not
+ * stall on the connection and the first read, e.g. for network parts. */
+#define CONCAT_PREFETCH_MARGIN (4 << 20)
+#define CONCAT_PREFETCH_SIZE   (512 << 10)
 
 struct access_entry
 {
     struct access_entry *next;
+    uint64_t size; /**< UINT64_MAX if unknown */
     char mrl[1];
 };
 
 typedef struct
 {
     stream_t *access;
+    block_t *data; /**< pre-buffered head of the access, not read yet */
+    struct access_entry *current;
     struct access_entry *next;
     struct access_entry *first;
+    struct
+    {
+        vlc_thread_t thread;
+        vlc_interrupt_t *interrupt;
+        struct access_entry *entry;
+        stream_t *access;
+        block_t *data;
+        bool active;
+    } prefetch;
     bool can_seek;
     bool can_seek_fast;
     bool can_pause;
@@ -48,6 +68,115 @@ typedef struct
     vlc_tick_t caching;
 } access_sys_t;
 
+static void *PrefetchThread(void *data)
+{
+    stream_t *access = data;
+    access_sys_t *sys = access->p_sys;
+    block_t *block = NULL;
+
+    vlc_interrupt_set(sys->prefetch.interrupt);
+
+    stream_t *a = vlc_access_NewMRL(VLC_OBJECT(access),
+                                    sys->prefetch.entry->mrl);
+    if (a != NULL)
+    {
+        if (a->pf_read != NULL)
+        {
+            block = block_Alloc(CONCAT_PREFETCH_SIZE);
+            if (likely(block != NULL))
+            {
+                ssize_t val = vlc_stream_Read(a, block->p_buffer,
+                                              block->i_buffer);
+                if (val > 0)
+                    block->i_buffer = val;
+                else
+                {
+                    block_Release(block);
+                    block = NULL;
+                }
+            }
+        }
+        else if (a->pf_block != NULL)
+            block = vlc_stream_ReadBlock(a);
+    }
+
+    /* Only looked at by the owner after joining */
+    sys->prefetch.access = a;
+    sys->prefetch.data = block;
+    return NULL;
+}
+
+static void PrefetchStart(stream_t *access, stream_t *a)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->prefetch.active || sys->next == NULL)
+        return;
+
+    /* Without a known size, the end cannot be anticipated: open right away */
+    if (sys->current->size != UINT64_MAX
+     && vlc_stream_Tell(a) + CONCAT_PREFETCH_MARGIN < sys->current->size)
+        return;
+
+    sys->prefetch.interrupt = vlc_interrupt_create();
+    if (unlikely(sys->prefetch.interrupt == NULL))
+        return;
+
+    sys->prefetch.entry = sys->next;
+    sys->prefetch.access = NULL;
+    sys->prefetch.data = NULL;
+
+    if (vlc_clone(&sys->prefetch.thread, PrefetchThread, access,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_interrupt_destroy(sys->prefetch.interrupt);
+        return;
+    }
+    sys->prefetch.active = true;
+}
+
+static void PrefetchJoin(access_sys_t *sys)
+{
+    void *data[2];
+
+    assert(sys->prefetch.active);
+
+    vlc_interrupt_forward_start(sys->prefetch.interrupt, data);
+    vlc_join(sys->prefetch.thread, NULL);
+    vlc_interrupt_forward_stop(data);
+    vlc_interrupt_destroy(sys->prefetch.interrupt);
+    sys->prefetch.active = false;
+}
+
+static void PrefetchCancel(access_sys_t *sys)
+{
+    if (!sys->prefetch.active)
+        return;
+
+    vlc_interrupt_kill(sys->prefetch.interrupt);
+    PrefetchJoin(sys);
+
+    if (sys->prefetch.data != NULL)
+        block_Release(sys->prefetch.data);
+    if (sys->prefetch.access != NULL)
+        vlc_stream_Delete(sys->prefetch.access);
+}
+
+static void CloseAccess(access_sys_t *sys)
+{
+    if (sys->data != NULL)
+    {
+        block_Release(sys->data);
+        sys->data = NULL;
+    }
+
+    if (sys->access != NULL)
+    {
+        vlc_stream_Delete(sys->access);
+        sys->access = NULL;
+    }
+}
+
 static stream_t *GetAccess(stream_t *access)
 {
     access_sys_t *sys = access->p_sys;
@@ -55,7 +184,7 @@ static stream_t *GetAccess(stream_t *access)
 
     if (a != NULL)
     {
-        if (!vlc_stream_Eof(a))
+        if (sys->data != NULL || !vlc_stream_Eof(a))
             return a;
 
         vlc_stream_Delete(a);
@@ -65,17 +194,27 @@ static stream_t *GetAccess(stream_t *access)
     if (sys->next == NULL)
         return NULL;
 
-    a = vlc_access_NewMRL(VLC_OBJECT(access), sys->next->mrl);
+    if (sys->prefetch.active)
+    {   /* the next part was (or is being) opened in the background */
+        assert(sys->prefetch.entry == sys->next);
+        PrefetchJoin(sys);
+        a = sys->prefetch.access;
+        sys->data = sys->prefetch.data;
+    }
+    else
+        a = vlc_access_NewMRL(VLC_OBJECT(access), sys->next->mrl);
     if (a == NULL)
         return NULL;
 
     sys->access = a;
+    sys->current = sys->next;
     sys->next = sys->next->next;
     return a;
 }
 
 static ssize_t Read(stream_t *access, void *buf, size_t len)
 {
+    access_sys_t *sys = access->p_sys;
     stream_t *a = GetAccess(access);
     if (a == NULL)
         return 0;
@@ -86,11 +225,32 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     if (unlikely(a->pf_read == NULL))
         return 0;
 
+    PrefetchStart(access, a);
+
+    block_t *block = sys->data;
+    if (block != NULL)
+    {
+        if (len > block->i_buffer)
+            len = block->i_buffer;
+
+        memcpy(buf, block->p_buffer, len);
+        block->p_buffer += len;
+        block->i_buffer -= len;
+
+        if (block->i_buffer == 0)
+        {
+            block_Release(block);
+            sys->data = NULL;
+        }
+        return len;
+    }
+
     return vlc_stream_ReadPartial(a, buf, len);
 }
 
 static block_t *Block(stream_t *access, bool *restrict eof)
 {
+    access_sys_t *sys = access->p_sys;
     stream_t *a = GetAccess(access);
     if (a == NULL)
     {
@@ -98,19 +258,58 @@ static block_t *Block(stream_t *access, bool *restrict eof)
         return NULL;
     }
 
+    PrefetchStart(access, a);
+
+    block_t *block = sys->data;
+    if (block != NULL)
+    {
+        sys->data = NULL;
+        return block;
+    }
+
     return vlc_stream_ReadBlock(a);
 }
 
-static int Seek(stream_t *access, uint64_t position)
+static int SeekCached(stream_t *access, uint64_t position)
 {
     access_sys_t *sys = access->p_sys;
+    uint64_t offset = 0;
+    struct access_entry *e = sys->first;
 
-    if (sys->access != NULL)
+    /* Find the part from the sizes recorded while opening */
+    while (e != NULL && position - offset >= e->size)
     {
-        vlc_stream_Delete(sys->access);
-        sys->access = NULL;
+        offset += e->size;
+        e = e->next;
     }
 
+    if (e == NULL)
+        return VLC_EGENERIC;
+
+    sys->next = e;
+
+    stream_t *a = GetAccess(access);
+    if (a == NULL)
+        return VLC_EGENERIC;
+
+    bool can_seek;
+    vlc_stream_Control(a, STREAM_CAN_SEEK, &can_seek);
+    if (!can_seek || vlc_stream_Seek(a, position - offset))
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+static int Seek(stream_t *access, uint64_t position)
+{
+    access_sys_t *sys = access->p_sys;
+
+    PrefetchCancel(sys);
+    CloseAccess(sys);
+
+    /* The part sizes are all known if the total size is */
+    if (sys->size != UINT64_MAX)
+        return SeekCached(access, position);
+
     sys->next = sys->first;
 
     for (uint64_t offset = 0;;)
@@ -200,6 +399,9 @@ static int Open(vlc_object_t *obj)
     bool read_cb = true;
 
     sys->access = NULL;
+    sys->data = NULL;
+    sys->current = NULL;
+    sys->prefetch.active = false;
     sys->can_seek = true;
     sys->can_seek_fast = true;
     sys->can_pause = true;
@@ -251,15 +453,11 @@ static int Open(vlc_object_t *obj)
         if (sys->can_control_pace)
             vlc_stream_Control(a, STREAM_CAN_CONTROL_PACE,
                                &sys->can_control_pace);
+        if (vlc_stream_GetSize(a, &e->size))
+            e->size = UINT64_MAX;
         if (sys->size != UINT64_MAX)
-        {
-            uint64_t size;
-
-            if (vlc_stream_GetSize(a, &size))
-                sys->size = UINT64_MAX;
-            else
-                sys->size += size;
-        }
+            sys->size = (e->size != UINT64_MAX) ? sys->size + e->size
+                                                : UINT64_MAX;
 
         vlc_tick_t caching;
         vlc_stream_Control(a, STREAM_GET_PTS_DELAY, &caching);
@@ -288,8 +486,8 @@ static void Close(vlc_object_t *obj)
     stream_t *access = (stream_t *)obj;
     access_sys_t *sys = access->p_sys;
 
-    if (sys->access != NULL)
-        vlc_stream_Delete(sys->access);
+    PrefetchCancel(sys);
+    CloseAccess(sys);
 
     for (struct access_entry *e = sys->first, *next; e != NULL; e = next)
     {
@@ -45,6 +45,8 @@
 #include "sdi.h"
 
 #include <atomic>
+#include <new>
+#include <vector>
 
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
@@ -135,12 +137,14 @@ static int Control(demux_t *, int, va_list);
 namespace {
 
 class DeckLinkCaptureDelegate;
+class DeckLinkFramePool;
 
 struct demux_sys_t
 {
     IDeckLink *card;
     IDeckLinkInput *input;
     DeckLinkCaptureDelegate *delegate;
+    DeckLinkFramePool *pool;
 
     /* We need to hold onto the IDeckLinkConfiguration object, or our settings will not apply.
        See section 2.4.15 of the Blackmagic DeckLink SDK documentation. */
@@ -236,6 +240,147 @@ static es_format_t GetModeSettings(demux_t *demux, IDeckLinkDisplayMode *m,
 }
 namespace {
 
+/*
+ * Allocates the capture frame buffers, so that the driver is not limited to
+ * its own small set of buffers while captured frames are held downstream
+ * (see CaptureBlock below). Released buffers are recycled.
+ */
+class DeckLinkFramePool : public IDeckLinkMemoryAllocator
+{
+public:
+    DeckLinkFramePool() : ref_(1), size_(0)
+    {
+        vlc_mutex_init(&lock_);
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, LPVOID *) { return E_NOINTERFACE; }
+
+    virtual ULONG STDMETHODCALLTYPE AddRef(void)
+    {
+        return ref_.fetch_add(1) + 1;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE Release(void)
+    {
+        ULONG ref = ref_.fetch_sub(1) - 1;
+        if (ref == 0)
+            delete this;
+        return ref;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE AllocateBuffer(uint32_t size, void **buffer)
+    {
+        void *buf = NULL;
+
+        vlc_mutex_lock(&lock_);
+        if (size != size_) { /* new video mode */
+            Drain();
+            size_ = size;
+        }
+        if (!free_.empty()) {
+            buf = free_.back();
+            free_.pop_back();
+        }
+        vlc_mutex_unlock(&lock_);
+
+        if (buf == NULL) {
+            /* the header keeps the size, and the payload aligned */
+            buf = aligned_alloc(HEADER_SIZE,
+                                (HEADER_SIZE + size + HEADER_SIZE - 1) & ~(HEADER_SIZE - 1));
+            if (buf == NULL)
+                return E_OUTOFMEMORY;
+            *static_cast<uint32_t *>(buf) = size;
+        }
+        *buffer = static_cast<uint8_t *>(buf) + HEADER_SIZE;
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE ReleaseBuffer(void *buffer)
+    {
+        void *buf = static_cast<uint8_t *>(buffer) - HEADER_SIZE;
+
+        vlc_mutex_lock(&lock_);
+        if (*static_cast<uint32_t *>(buf) == size_ && free_.size() < MAX_FREE) {
+            free_.push_back(buf);
+            buf = NULL;
+        }
+        vlc_mutex_unlock(&lock_);
+        aligned_free(buf);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Commit(void) { return S_OK; }
+
+    virtual HRESULT STDMETHODCALLTYPE Decommit(void)
+    {
+        vlc_mutex_lock(&lock_);
+        Drain();
+        vlc_mutex_unlock(&lock_);
+        return S_OK;
+    }
+
+private:
+    static const size_t HEADER_SIZE = 64;
+    static const size_t MAX_FREE = 16;
+
+    virtual ~DeckLinkFramePool()
+    {
+        Drain();
+        vlc_mutex_destroy(&lock_);
+    }
+
+    void Drain()
+    {
+        for (void *buf : free_)
+            aligned_free(buf);
+        free_.clear();
+    }
+
+    std::atomic_ulong ref_;
+    vlc_mutex_t lock_;
+    uint32_t size_;
+    std::vector<void *> free_;
+};
+
+/*
+ * Wraps a captured frame, which is kept alive until the block is released,
+ * instead of copying it.
+ */
+struct CaptureBlock
+{
+    block_t self;
+    IDeckLinkVideoInputFrame *frame;
+    DeckLinkFramePool *pool;
+};
+
+static void CaptureBlockRelease(block_t *block)
+{
+    CaptureBlock *cb = container_of(block, CaptureBlock, self);
+
+    cb->frame->Release();
+    cb->pool->Release(); /* after the frame, which returns its buffer */
+    delete cb;
+}
+
+static const struct vlc_block_callbacks capture_block_cbs = {
+    CaptureBlockRelease,
+};
+
+static block_t *CaptureBlockNew(IDeckLinkVideoInputFrame *frame,
+                                DeckLinkFramePool *pool, void *bytes,
+                                size_t size)
+{
+    CaptureBlock *cb = new (std::nothrow) CaptureBlock;
+    if (cb == NULL)
+        return NULL;
+
+    frame->AddRef();
+    pool->AddRef();
+    cb->frame = frame;
+    cb->pool = pool;
+    return block_Init(&cb->self, &capture_block_cbs, bytes, size);
+}
+
 class DeckLinkCaptureDelegate : public IDeckLinkInputCallback
 {
 public:
@@ -340,13 +485,20 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
                 bpp = 2;
                 break;
         };
-        block_t *video_frame = block_Alloc(width * height * bpp);
-        if (!video_frame)
-            return S_OK;
-
         const uint32_t *frame_bytes;
         videoFrame->GetBytes((void**)&frame_bytes);
 
+        /* Packed 8-bits frames without padding are passed as is */
+        block_t *video_frame;
+        if (sys->pool != NULL && sys->video_fmt.i_codec != VLC_CODEC_I422_10L &&
+            stride == width * bpp)
+            video_frame = CaptureBlockNew(videoFrame, sys->pool,
+                                          (void *)frame_bytes, stride * height);
+        else
+            video_frame = block_Alloc(width * height * bpp);
+        if (!video_frame)
+            return S_OK;
+
         BMDTimeValue stream_time, frame_duration;
         videoFrame->GetStreamTime(&stream_time, &frame_duration, CLOCK_FREQ);
         video_frame->i_flags = BLOCK_FLAG_TYPE_I | sys->dominance_flags;
@@ -385,13 +537,14 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
                 }
                 vanc->Release();
             }
-        } else if (sys->video_fmt.i_codec == VLC_CODEC_UYVY) {
-            for (int y = 0; y < height; ++y) {
-                const uint8_t *src = (const uint8_t *)frame_bytes + stride * y;
-                uint8_t *dst = video_frame->p_buffer + width * 2 * y;
-                memcpy(dst, src, width * 2);
-            }
-        } else {
+        } else if (video_frame->p_buffer != (const uint8_t *)frame_bytes) {
+            if (sys->video_fmt.i_codec == VLC_CODEC_UYVY) {
+                for (int y = 0; y < height; ++y) {
+                    const uint8_t *src = (const uint8_t *)frame_bytes + stride * y;
+                    uint8_t *dst = video_frame->p_buffer + width * 2 * y;
+                    memcpy(dst, src, width * 2);
+                }
+            } else
                 memcpy(video_frame->p_buffer, frame_bytes, width * height * bpp);
         }
 
@@ -683,6 +836,14 @@ static int Open(vlc_object_t *p_this)
         goto finish;
     }
 
+    sys->pool = new (std::nothrow) DeckLinkFramePool();
+    if (sys->pool != NULL &&
+        sys->input->SetVideoInputFrameMemoryAllocator(sys->pool) != S_OK) {
+        msg_Warn(demux, "Cannot set the frame allocator, frames will be copied");
+        sys->pool->Release();
+        sys->pool = NULL;
+    }
+
     if (sys->input->EnableVideoInput(htonl(u.id), fmt, flags) != S_OK) {
         msg_Err(demux, "Failed to enable video input");
         goto finish;
@@ -776,6 +937,10 @@ static void Close(vlc_object_t *p_this)
         sys->input->Release();
     }
 
+    /* The frames still held downstream keep their own reference */
+    if (sys->pool)
+        sys->pool->Release();
+
     if (sys->card)
         sys->card->Release();
 
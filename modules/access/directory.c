@@ -108,10 +108,39 @@ void DirClose(vlc_object_t *obj)
     closedir(sys->dir);
 }
 
+#if defined (DT_DIR) && defined (HAVE_FSTATAT) && !defined (__OS2__)
+/* The directory entry type avoids a stat() round trip per entry, which is
+ * very slow on network file systems. Symbolic links must be followed. */
+static const char *DirReadEntry(DIR *dir, mode_t *restrict mode)
+{
+    struct dirent *ent = readdir(dir);
+    if (ent == NULL)
+        return NULL;
+
+    switch (ent->d_type)
+    {
+        case DT_BLK: *mode = S_IFBLK; break;
+        case DT_CHR: *mode = S_IFCHR; break;
+        case DT_FIFO: *mode = S_IFIFO; break;
+        case DT_REG: *mode = S_IFREG; break;
+        case DT_DIR: *mode = S_IFDIR; break;
+        default: *mode = 0; /* unknown, or link */
+    }
+    return ent->d_name;
+}
+#else
+static const char *DirReadEntry(DIR *dir, mode_t *restrict mode)
+{
+    *mode = 0;
+    return vlc_readdir(dir);
+}
+#endif
+
 int DirRead (stream_t *access, input_item_node_t *node)
 {
     access_sys_t *sys = access->p_sys;
     const char *entry;
+    mode_t mode;
     int ret = VLC_SUCCESS;
 
     bool special_files = var_InheritBool(access, "list-special-files");
@@ -119,22 +148,28 @@ int DirRead (stream_t *access, input_item_node_t *node)
     struct vlc_readdir_helper rdh;
     vlc_readdir_helper_init(&rdh, access, node);
 
-    while (ret == VLC_SUCCESS && (entry = vlc_readdir(sys->dir)) != NULL)
+    while (ret == VLC_SUCCESS
+        && (entry = DirReadEntry(sys->dir, &mode)) != NULL)
     {
-        struct stat st;
         int type;
 
+        if (mode == 0)
+        {
+            struct stat st;
 #ifdef HAVE_FSTATAT
-        if (fstatat(dirfd(sys->dir), entry, &st, 0))
-            continue;
+            if (fstatat(dirfd(sys->dir), entry, &st, 0))
+                continue;
 #else
-        char path[PATH_MAX];
+            char path[PATH_MAX];
 
-        if (snprintf(path, PATH_MAX, "%s"DIR_SEP"%s", access->psz_filepath,
-                     entry) >= PATH_MAX || vlc_stat(path, &st))
-            continue;
+            if (snprintf(path, PATH_MAX, "%s"DIR_SEP"%s", access->psz_filepath,
+                         entry) >= PATH_MAX || vlc_stat(path, &st))
+                continue;
 #endif
-        switch (st.st_mode & S_IFMT)
+            mode = st.st_mode;
+        }
+
+        switch (mode & S_IFMT)
         {
 #ifdef S_IFBLK
             case S_IFBLK:
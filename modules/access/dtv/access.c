@@ -47,6 +47,10 @@
 #define BUDGET_LONGTEXT N_( \
     "Only useful programs are normally demultiplexed from the transponder. " \
     "This option will disable demultiplexing and receive all programs.")
+#define BUFFER_SIZE_TEXT N_("Kernel buffer size")
+#define BUFFER_SIZE_LONGTEXT N_( \
+    "Size in bytes of the kernel buffer holding the received packets. " \
+    "A larger buffer avoids losing packets at high bit rates under load.")
 
 #define NAME_TEXT N_("Network name")
 #define NAME_LONGTEXT N_("Unique network name in the System Tuning Spaces")
@@ -263,6 +267,9 @@ vlc_module_begin ()
         change_integer_range (0, 255)
         change_safe ()
     add_bool ("dvb-budget-mode", false, BUDGET_TEXT, BUDGET_LONGTEXT, true)
+    add_integer ("dvb-buffer-size", 8 << 20, BUFFER_SIZE_TEXT,
+                 BUFFER_SIZE_LONGTEXT, true)
+        change_integer_range (0, 1 << 30)
 #endif
 #ifdef _WIN32
     add_integer ("dvb-adapter", -1, ADAPTER_TEXT, ADAPTER_LONGTEXT, true)
@@ -425,11 +432,15 @@ vlc_module_begin ()
 #endif
 vlc_module_end ()
 
+#define READ_MIN (20*188)
+#define READ_MAX (32*READ_MIN)
+
 typedef struct
 {
     dvb_device_t *dev;
     uint8_t signal_poll;
     tuner_setup_t pf_setup;
+    size_t read_size;
 } access_sys_t;
 
 static block_t *Read (stream_t *, bool *);
@@ -460,6 +471,7 @@ static int Open (vlc_object_t *obj)
     sys->dev = dev;
     sys->signal_poll = 0;
     sys->pf_setup = NULL;
+    sys->read_size = READ_MIN;
     access->p_sys = sys;
 
     uint64_t freq = var_InheritFrequency (obj);
@@ -502,13 +514,12 @@ static void Close (vlc_object_t *obj)
 
 static block_t *Read (stream_t *access, bool *restrict eof)
 {
-#define BUFSIZE (20*188)
-    block_t *block = block_Alloc (BUFSIZE);
+    access_sys_t *sys = access->p_sys;
+    block_t *block = block_Alloc (sys->read_size);
     if (unlikely(block == NULL))
         return NULL;
 
-    access_sys_t *sys = access->p_sys;
-    ssize_t val = dvb_read (sys->dev, block->p_buffer, BUFSIZE, -1);
+    ssize_t val = dvb_read (sys->dev, block->p_buffer, sys->read_size, -1);
 
     if (val <= 0)
     {
@@ -520,6 +531,13 @@ static block_t *Read (stream_t *access, bool *restrict eof)
 
     block->i_buffer = val;
 
+    /* Follow the bit rate: a full read means more data is pending, so read
+     * larger blocks, with fewer system calls, until they are not filled. */
+    if ((size_t)val == sys->read_size && sys->read_size < READ_MAX)
+        sys->read_size *= 2;
+    else if ((size_t)val < sys->read_size / 4 && sys->read_size > READ_MIN)
+        sys->read_size /= 2;
+
     return block;
 }
 
@@ -179,6 +179,20 @@ static int dvb_open_node (dvb_device_t *d, const char *type, int flags)
     return vlc_openat (d->dir, path, flags | O_NONBLOCK);
 }
 
+/** Expands the kernel buffer of the TS tap (demux or DVR device node) */
+static void dvb_set_buffer_size (dvb_device_t *d)
+{
+    unsigned long size = var_InheritInteger (d->obj, "dvb-buffer-size");
+
+    if (size == 0)
+        return; /* keep the driver default */
+    if (ioctl (d->demux, DMX_SET_BUFFER_SIZE, size) < 0)
+        msg_Warn (d->obj, "cannot set %lu bytes buffer: %s", size,
+                  vlc_strerror_c(errno));
+    else
+        msg_Dbg (d->obj, "using %lu bytes buffer", size);
+}
+
 /**
  * Opens the DVB tuner
  */
@@ -219,9 +233,7 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
            return NULL;
        }
 
-       if (ioctl (d->demux, DMX_SET_BUFFER_SIZE, 1 << 20) < 0)
-           msg_Warn (obj, "cannot expand demultiplexing buffer: %s",
-                     vlc_strerror_c(errno));
+       dvb_set_buffer_size (d);
 
        /* We need to filter at least one PID. The tap for TS demultiplexing
         * cannot be configured otherwise. So add the PAT. */
@@ -252,6 +264,7 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
             free (d);
             return NULL;
         }
+        dvb_set_buffer_size (d);
 #endif
     }
 
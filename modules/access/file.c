@@ -50,6 +50,9 @@
 #else
 #   include <unistd.h>
 #endif
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 #include <dirent.h>
 
 #include <vlc_common.h>
@@ -65,6 +68,14 @@
 typedef struct
 {
     int fd;
+#ifdef HAVE_LIBURING
+    struct file_uring *uring;
+#endif
+#ifdef HAVE_MMAP
+    bool b_mmap;
+    uint64_t mmap_pos; /**< File offset of the next mapping */
+    uint64_t mmap_drop; /**< Start of the last mapping, if sequential */
+#endif
 
     bool b_pace_control;
 } access_sys_t;
@@ -124,11 +135,119 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
 
 static ssize_t Read (stream_t *, void *, size_t);
 static int FileSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
 
+#ifdef HAVE_MMAP
+/* Size of each mapping: large enough that demuxers hardly ever peek
+ * across two of them, small enough to fit 32-bits address spaces. */
+# define MMAP_WINDOW (UINT64_C(64) << 20)
+/* How much to read ahead right away from the new read position */
+# define MMAP_AHEAD (UINT64_C(4) << 20)
+
+static block_t *MmapBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct stat st;
+
+    if (fstat (p_sys->fd, &st))
+    {
+        msg_Err (p_access, "read error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    uint64_t pos = p_sys->mmap_pos;
+    if (pos >= (uint64_t)st.st_size)
+    {
+        *eof = true;
+        return NULL;
+    }
+
+    uint64_t start = pos & ~(uint64_t)(sysconf (_SC_PAGESIZE) - 1);
+    uint64_t length = st.st_size - start;
+    if (length > MMAP_WINDOW)
+        length = MMAP_WINDOW;
+
+    void *addr = mmap (NULL, length, PROT_READ, MAP_SHARED, p_sys->fd, start);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "cannot map file: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    size_t skip = pos - start;
+
+    posix_madvise (addr, length, POSIX_MADV_SEQUENTIAL);
+    posix_madvise (addr, skip + MMAP_AHEAD < length ? skip + MMAP_AHEAD
+                                                    : length,
+                   POSIX_MADV_WILLNEED);
+
+    /* Sequential playback: drop what is behind the new mapping from the page
+     * cache. Pages still mapped by the previous block are not affected. */
+    if (p_sys->mmap_drop != UINT64_MAX)
+        posix_fadvise (p_sys->fd, p_sys->mmap_drop, start - p_sys->mmap_drop,
+                       POSIX_FADV_DONTNEED);
+
+    block_t *block = block_mmap_Alloc (addr, length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    block->p_buffer += skip;
+    block->i_buffer -= skip;
+    p_sys->mmap_pos = start + length;
+    p_sys->mmap_drop = start;
+    return block;
+}
+#endif
+
+#ifdef HAVE_LIBURING
+static block_t *UringBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    block_t *block = FileUringRead (p_sys->uring, p_access);
+
+    if (block == NULL)
+        *eof = true;
+    return block;
+}
+
+static void UringSetup (stream_t *p_access, access_sys_t *p_sys)
+{
+    unsigned depth = var_InheritInteger (p_access, "file-uring-depth");
+    if (depth == 0)
+        return;
+
+    size_t size = var_InheritInteger (p_access, "file-uring-size") * 1024;
+
+    p_sys->uring = FileUringNew (p_access, p_sys->fd, depth, size);
+    if (p_sys->uring == NULL)
+        return;
+
+    /* Starts from the current file offset, normally zero */
+    off_t pos = lseek (p_sys->fd, 0, SEEK_CUR);
+    if (pos > 0)
+        FileUringSeek (p_sys->uring, pos);
+
+    p_access->pf_read = NULL;
+    p_access->pf_block = UringBlock;
+
+# ifdef O_DIRECT
+    /* Only safe with io_uring: all reads are then suitably aligned. */
+    if (var_InheritBool (p_access, "file-direct")
+     && fcntl (p_sys->fd, F_SETFL, fcntl (p_sys->fd, F_GETFL) | O_DIRECT))
+        msg_Warn (p_access, "cannot bypass page cache: %s",
+                  vlc_strerror_c(errno));
+# endif
+}
+#endif
+
 /*****************************************************************************
  * FileOpen: open the file
  *****************************************************************************/
@@ -210,6 +329,12 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+#ifdef HAVE_LIBURING
+    p_sys->uring = NULL;
+#endif
+#ifdef HAVE_MMAP
+    p_sys->b_mmap = false;
+#endif
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -228,6 +353,22 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_MMAP
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap"))
+        {
+            off_t pos = lseek (fd, 0, SEEK_CUR);
+
+            p_sys->b_mmap = true;
+            p_sys->mmap_pos = (pos > 0) ? pos : 0;
+            p_sys->mmap_drop = UINT64_MAX;
+            p_access->pf_read = NULL;
+            p_access->pf_block = MmapBlock;
+        }
+#endif
+#ifdef HAVE_LIBURING
+        if (S_ISREG (st.st_mode) && p_access->pf_block == NULL)
+            UringSetup (p_access, p_sys);
 #endif
     }
     else
@@ -250,7 +391,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_readdir != NULL)
     {
         DirClose (p_this);
         return;
@@ -258,6 +399,10 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_LIBURING
+    if (p_sys->uring != NULL)
+        FileUringDelete (p_sys->uring);
+#endif
     vlc_close (p_sys->fd);
 }
 
@@ -291,6 +436,21 @@ static int FileSeek (stream_t *p_access, uint64_t i_pos)
 {
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_MMAP
+    if (sys->b_mmap)
+    {   /* The next block is mapped from there, nothing else to do. */
+        sys->mmap_pos = i_pos;
+        sys->mmap_drop = UINT64_MAX;
+        return VLC_SUCCESS;
+    }
+#endif
+#ifdef HAVE_LIBURING
+    if (sys->uring != NULL)
+    {
+        FileUringSeek(sys->uring, i_pos);
+        return VLC_SUCCESS;
+    }
+#endif
     if (lseek(sys->fd, i_pos, SEEK_SET) == (off_t)-1)
         return VLC_EGENERIC;
     return VLC_SUCCESS;
@@ -319,6 +479,14 @@ static int FileControl( stream_t *p_access, int i_query, va_list args )
             *pb_bool = p_sys->b_pace_control;
             break;
 
+        case STREAM_IS_MAPPED:
+#ifdef HAVE_MMAP
+            *va_arg( args, bool * ) = p_sys->b_mmap;
+            break;
+#else
+            return VLC_EGENERIC;
+#endif
+
         case STREAM_GET_SIZE:
         {
             struct stat st;
@@ -0,0 +1,243 @@
+/*****************************************************************************
+ * file_uring.c: io_uring read-ahead for the file input
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+
+#include <liburing.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+#include "fs.h"
+
+/* Buffer, offset and length alignment, suitable for O_DIRECT */
+#define URING_ALIGN 4096
+
+struct file_uring_slot
+{
+    block_t *block;
+    int      res;
+    bool     done;
+};
+
+/**
+ * Read-ahead engine state
+ *
+ * Slots form a ring: the slot at index head is the oldest pending read, i.e.
+ * the next one to be handed to the stream, and reads complete out of order.
+ */
+struct file_uring
+{
+    struct io_uring ring;
+    int fd;
+    unsigned depth;
+    size_t read_size;
+
+    uint64_t offset; /**< Offset of the next read to submit */
+    size_t skip; /**< Bytes to discard from the head slot (after a seek) */
+    unsigned head;
+    unsigned inflight;
+    bool eof; /**< A short read was seen, stop submitting */
+
+    struct file_uring_slot slots[];
+};
+
+static void FileUringSubmit(struct file_uring *u)
+{
+    unsigned count = 0;
+
+    while (!u->eof && u->inflight < u->depth)
+    {
+        struct file_uring_slot *slot =
+            &u->slots[(u->head + u->inflight) % u->depth];
+        void *buf = aligned_alloc(URING_ALIGN, u->read_size);
+        if (unlikely(buf == NULL))
+            break;
+
+        block_t *block = block_heap_Alloc(buf, u->read_size);
+        if (unlikely(block == NULL))
+            break;
+
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&u->ring);
+        if (unlikely(sqe == NULL))
+        {
+            block_Release(block);
+            break;
+        }
+
+        io_uring_prep_read(sqe, u->fd, block->p_buffer, u->read_size,
+                           u->offset);
+        io_uring_sqe_set_data(sqe, slot);
+        slot->block = block;
+        slot->done = false;
+        u->offset += u->read_size;
+        u->inflight++;
+        count++;
+    }
+
+    if (count > 0)
+        io_uring_submit(&u->ring);
+}
+
+/** Waits for one completion, in any slot. */
+static int FileUringReap(struct file_uring *u)
+{
+    struct io_uring_cqe *cqe;
+    int ret;
+
+    do
+        ret = io_uring_wait_cqe(&u->ring, &cqe);
+    while (ret == -EINTR);
+
+    if (ret < 0)
+        return ret;
+
+    struct file_uring_slot *slot = io_uring_cqe_get_data(cqe);
+
+    slot->res = cqe->res;
+    slot->done = true;
+    io_uring_cqe_seen(&u->ring, cqe);
+    return 0;
+}
+
+/** Waits for all pending reads, and discards their data. */
+static void FileUringDrain(struct file_uring *u)
+{
+    while (u->inflight > 0)
+    {
+        struct file_uring_slot *slot = &u->slots[u->head];
+
+        while (!slot->done)
+            if (FileUringReap(u))
+                abort(); /* Buffers cannot be freed while in use */
+
+        block_Release(slot->block);
+        slot->block = NULL;
+        u->head = (u->head + 1) % u->depth;
+        u->inflight--;
+    }
+    u->head = 0;
+}
+
+struct file_uring *FileUringNew(stream_t *obj, int fd, unsigned depth,
+                                size_t read_size)
+{
+    struct file_uring *u = malloc(sizeof (*u) + depth * sizeof (u->slots[0]));
+    if (unlikely(u == NULL))
+        return NULL;
+
+    int val = io_uring_queue_init(depth, &u->ring, 0);
+    if (val < 0)
+    {
+        msg_Warn(obj, "io_uring not available: %s", vlc_strerror_c(-val));
+        free(u);
+        return NULL;
+    }
+
+    u->fd = fd;
+    u->depth = depth;
+    u->read_size = (read_size + URING_ALIGN - 1) & ~(size_t)(URING_ALIGN - 1);
+    u->offset = 0;
+    u->skip = 0;
+    u->head = 0;
+    u->inflight = 0;
+    u->eof = false;
+
+    for (unsigned i = 0; i < depth; i++)
+        u->slots[i].block = NULL;
+
+    msg_Dbg(obj, "io_uring read-ahead: %u x %zu bytes", depth, u->read_size);
+    return u;
+}
+
+void FileUringDelete(struct file_uring *u)
+{
+    FileUringDrain(u);
+    io_uring_queue_exit(&u->ring);
+    free(u);
+}
+
+void FileUringSeek(struct file_uring *u, uint64_t pos)
+{
+    FileUringDrain(u);
+    /* Reads are submitted lazily, so that seek bursts cost nothing. */
+    u->offset = pos & ~(uint64_t)(URING_ALIGN - 1);
+    u->skip = pos - u->offset;
+    u->eof = false;
+}
+
+block_t *FileUringRead(struct file_uring *u, stream_t *obj)
+{
+    FileUringSubmit(u);
+
+    if (u->inflight == 0)
+        return NULL;
+
+    struct file_uring_slot *slot = &u->slots[u->head];
+
+    while (!slot->done)
+    {
+        int val = FileUringReap(u);
+        if (val < 0)
+        {
+            msg_Err(obj, "io_uring error: %s", vlc_strerror_c(-val));
+            return NULL;
+        }
+    }
+
+    block_t *block = slot->block;
+    int res = slot->res;
+
+    slot->block = NULL;
+    u->head = (u->head + 1) % u->depth;
+    u->inflight--;
+
+    if (res < 0)
+    {
+        msg_Err(obj, "read error: %s", vlc_strerror_c(-res));
+        u->eof = true;
+        block_Release(block);
+        return NULL;
+    }
+
+    if ((size_t)res < u->read_size)
+        u->eof = true;
+
+    if ((size_t)res <= u->skip)
+    {   /* End of file */
+        u->eof = true;
+        block_Release(block);
+        return NULL;
+    }
+
+    block->p_buffer += u->skip;
+    block->i_buffer = res - u->skip;
+    u->skip = 0;
+
+    /* Keep the queue full while the caller processes this block. */
+    FileUringSubmit(u);
+    return block;
+}
@@ -30,6 +30,24 @@
 #include "fs.h"
 #include <vlc_plugin.h>
 
+#define URING_DEPTH_TEXT N_("Read-ahead depth")
+#define URING_DEPTH_LONGTEXT N_( \
+    "Number of reads kept in flight with io_uring for each regular file. " \
+    "0 disables io_uring and uses plain synchronous reads." )
+#define URING_SIZE_TEXT N_("Read-ahead size (KiB)")
+#define URING_SIZE_LONGTEXT N_( \
+    "Size of each read submitted with io_uring." )
+#define DIRECT_TEXT N_("Bypass the page cache")
+#define DIRECT_LONGTEXT N_( \
+    "Read regular files with O_DIRECT, so that playing them does not " \
+    "evict other data from the page cache. This requires io_uring " \
+    "read-ahead." )
+#define MMAP_TEXT N_("Memory-map files")
+#define MMAP_LONGTEXT N_( \
+    "Map regular files into memory instead of reading them, so that " \
+    "demuxers can peek into the file without copies. " \
+    "Files must not be truncated while they are played." )
+
 vlc_module_begin ()
     set_description( N_("File input") )
     set_shortname( N_("File") )
@@ -39,6 +57,18 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+#ifdef HAVE_LIBURING
+    add_integer( "file-uring-depth", 0, URING_DEPTH_TEXT,
+                 URING_DEPTH_LONGTEXT, true )
+        change_integer_range( 0, 64 )
+    add_integer( "file-uring-size", 1024, URING_SIZE_TEXT,
+                 URING_SIZE_LONGTEXT, true )
+        change_integer_range( 4, 65536 )
+    add_bool( "file-direct", false, DIRECT_TEXT, DIRECT_LONGTEXT, true )
+#endif
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, MMAP_TEXT, MMAP_LONGTEXT, true )
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
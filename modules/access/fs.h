@@ -23,6 +23,16 @@
 int FileOpen (vlc_object_t *);
 void FileClose (vlc_object_t *);
 
+#ifdef HAVE_LIBURING
+struct file_uring;
+
+struct file_uring *FileUringNew(stream_t *, int fd, unsigned depth,
+                                size_t read_size);
+void FileUringDelete(struct file_uring *);
+void FileUringSeek(struct file_uring *, uint64_t pos);
+block_t *FileUringRead(struct file_uring *, stream_t *);
+#endif
+
 int DirOpen (vlc_object_t *);
 int DirInit (stream_t *p_access, DIR *handle);
 int DirRead (stream_t *, input_item_node_t *);
@@ -40,20 +40,48 @@
 #include "resource.h"
 #include "file.h"
 #include "live.h"
+#include "parallel.h"
+
+/* Smallest file worth downloading through several connections */
+#define PARALLEL_MIN_SIZE (16 << 20)
 
 typedef struct
 {
     struct vlc_http_mgr *manager;
     struct vlc_http_resource *resource;
+    struct vlc_http_parallel *parallel;
+    uint64_t bytes; /**< received payload */
+    vlc_tick_t busy; /**< time spent waiting for the payload */
 } access_sys_t;
 
+static void AddTransfer(access_sys_t *sys, const block_t *b, vlc_tick_t start)
+{
+    if (b == NULL)
+        return;
+    sys->bytes += b->i_buffer;
+    sys->busy += vlc_tick_now() - start;
+}
+
+static int GetNetwork(access_sys_t *sys, struct vlc_stream_network *net)
+{
+    net->requests = sys->resource->requests;
+    net->rtt = sys->resource->rtt;
+    net->throughput = (sys->busy > 0)
+        ? sys->bytes * 8 * CLOCK_FREQ / sys->busy : 0;
+    return VLC_SUCCESS;
+}
+
 static block_t *FileRead(stream_t *access, bool *restrict eof)
 {
     access_sys_t *sys = access->p_sys;
+    vlc_tick_t start = vlc_tick_now();
 
-    block_t *b = vlc_http_file_read(sys->resource);
+    block_t *b = (sys->parallel != NULL)
+        ? vlc_http_parallel_read(sys->parallel)
+        : vlc_http_file_read(sys->resource);
     if (b == NULL)
         *eof = true;
+    AddTransfer(sys, b, start);
     return b;
 }
 
@@ -61,6 +89,12 @@ static int FileSeek(stream_t *access, uint64_t pos)
 {
     access_sys_t *sys = access->p_sys;
 
+    if (sys->parallel != NULL)
+    {
+        vlc_http_parallel_seek(sys->parallel, pos);
+        return VLC_SUCCESS;
+    }
+
     if (vlc_http_file_seek(sys->resource, pos))
         return VLC_EGENERIC;
     return VLC_SUCCESS;
@@ -104,6 +138,19 @@ static int FileControl(stream_t *access, int query, va_list args)
             *va_arg(args, char **) = vlc_http_file_get_type(sys->resource);
             break;
 
+        case STREAM_GET_VALIDATOR:
+        {
+            char *str = vlc_http_file_get_validator(sys->resource);
+            if (str == NULL)
+                return VLC_EGENERIC;
+
+            *va_arg(args, char **) = str;
+            break;
+        }
+
+        case STREAM_GET_NETWORK:
+            return GetNetwork(sys, va_arg(args, struct vlc_stream_network *));
+
         case STREAM_SET_PAUSE_STATE:
             break;
 
@@ -116,10 +163,12 @@ static int FileControl(stream_t *access, int query, va_list args)
 static block_t *LiveRead(stream_t *access, bool *restrict eof)
 {
     access_sys_t *sys = access->p_sys;
+    vlc_tick_t start = vlc_tick_now();
 
     block_t *b = vlc_http_live_read(sys->resource);
     if (b == NULL) /* TODO: loop instead of EOF, see vlc_http_live_read() */
         *eof = true;
+    AddTransfer(sys, b, start);
     return b;
 }
 
@@ -145,6 +194,9 @@ static int LiveControl(stream_t *access, int query, va_list args)
             *va_arg(args, char **) = vlc_http_live_get_type(sys->resource);
             break;
 
+        case STREAM_GET_NETWORK:
+            return GetNetwork(sys, va_arg(args, struct vlc_stream_network *));
+
         default:
             return VLC_EGENERIC;
     }
@@ -162,6 +214,9 @@ static int Open(vlc_object_t *obj)
 
     sys->manager = NULL;
     sys->resource = NULL;
+    sys->parallel = NULL;
+    sys->bytes = 0;
+    sys->busy = 0;
 
     void *jar = NULL;
     if (var_InheritBool(obj, "http-forward-cookies"))
@@ -237,6 +292,26 @@ static int Open(vlc_object_t *obj)
         goto error;
     }
 
+    unsigned conns = var_InheritInteger(obj, "http-parallel");
+    if (!live && conns > 1 && vlc_http_file_can_seek(sys->resource))
+    {
+        uintmax_t size = vlc_http_file_get_size(sys->resource);
+
+        if (size != (uintmax_t)-1 && size >= PARALLEL_MIN_SIZE)
+        {
+            char *ua = var_InheritString(obj, "http-user-agent");
+            char *referer = var_InheritString(obj, "http-referrer");
+
+            sys->parallel = vlc_http_parallel_create(obj, jar,
+                access->psz_url, ua, referer, crd.psz_username,
+                crd.psz_password, size, conns);
+            free(referer);
+            free(ua);
+            if (sys->parallel == NULL)
+                msg_Warn(access, "cannot start parallel download");
+        }
+    }
+
     vlc_credential_store(&crd, obj);
     free(psz_realm);
     vlc_credential_clean(&crd);
@@ -275,6 +350,8 @@ static void Close(vlc_object_t *obj)
     stream_t *access = (stream_t *)obj;
     access_sys_t *sys = access->p_sys;
 
+    if (sys->parallel != NULL)
+        vlc_http_parallel_destroy(sys->parallel);
     vlc_http_res_destroy(sys->resource);
     vlc_http_mgr_destroy(sys->manager);
     free(sys);
@@ -292,6 +369,12 @@ vlc_module_begin()
     add_bool("http-continuous", false, N_("Continuous stream"),
              N_("Keep reading a resource that keeps being updated."), true)
         change_volatile()
+    add_integer("http-parallel", 1, N_("Parallel connections"),
+                N_("Maximum number of connections used to download large "
+                   "files. More connections can fill high latency links "
+                   "better. The actual number adapts to the throughput."),
+                true)
+        change_integer_range(1, 16)
     add_bool("http-forward-cookies", true, N_("Cookies forwarding"),
              N_("Forward cookies across HTTP redirections."), true)
     add_string("http-referrer", NULL, N_("Referrer"),
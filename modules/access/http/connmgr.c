@@ -76,6 +76,42 @@ vlc_tls_t *vlc_https_connect(vlc_tls_client_t *creds, const char *name,
     return tls;
 }
 
+/**
+ * Connects to an alternative service for an HTTPS origin (IETF RFC7838).
+ *
+ * The server is authenticated with the origin host name, and it must agree
+ * on HTTP/2, the only protocol alternatives are recorded for.
+ */
+static vlc_tls_t *vlc_https_connect_alt(vlc_tls_client_t *creds,
+                                        const char *name, const char *alt,
+                                        unsigned port)
+{
+    const char *alpn[] = { "h2", NULL };
+    char *alp;
+
+    vlc_tls_t *sock = vlc_tls_SocketOpenTCP(vlc_object_parent(creds),
+                                            alt, port);
+    if (sock == NULL)
+        return NULL;
+
+    vlc_tls_t *tls = vlc_tls_ClientSessionCreate(creds, sock, name, "https",
+                                                 alpn, &alp);
+    if (tls == NULL)
+    {
+        vlc_tls_SessionDelete(sock);
+        return NULL;
+    }
+
+    bool two = (alp != NULL) && !strcmp(alp, "h2");
+    free(alp);
+    if (!two)
+    {
+        vlc_tls_Close(tls);
+        return NULL;
+    }
+    return tls;
+}
+
 static char *vlc_http_proxy_find(const char *hostname, unsigned port,
                                  bool secure)
 {
@@ -96,6 +132,159 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
+/* Idle connections kept for the next managers requesting the same origin,
+ * e.g. when switching between playlist items on the same server */
+#define VLC_HTTP_POOL_SIZE 4
+#define VLC_HTTP_POOL_IDLE VLC_TICK_FROM_SEC(30)
+
+struct vlc_http_pool_entry
+{
+    struct vlc_http_conn *conn;
+    char *host;
+    unsigned port;
+    bool secure;
+    vlc_tick_t expiry;
+};
+
+static vlc_mutex_t vlc_http_pool_lock = VLC_STATIC_MUTEX;
+static struct vlc_http_pool_entry vlc_http_pool[VLC_HTTP_POOL_SIZE];
+static unsigned vlc_http_pool_count = 0;
+/* X.509 credentials shared by managers and pooled connections */
+static vlc_tls_client_t *vlc_http_pool_creds = NULL;
+static unsigned vlc_http_pool_creds_refs = 0;
+
+static vlc_tls_client_t *vlc_http_creds_hold(vlc_object_t *obj)
+{
+    vlc_tls_client_t *creds;
+
+    vlc_mutex_lock(&vlc_http_pool_lock);
+    if (vlc_http_pool_creds == NULL)
+    {   /* Not tied to the input, so that it can outlive it */
+        assert(vlc_http_pool_creds_refs == 0);
+        vlc_http_pool_creds =
+            vlc_tls_ClientCreate(VLC_OBJECT(vlc_object_instance(obj)));
+    }
+    creds = vlc_http_pool_creds;
+    if (creds != NULL)
+        vlc_http_pool_creds_refs++;
+    vlc_mutex_unlock(&vlc_http_pool_lock);
+    return creds;
+}
+
+static void vlc_http_creds_release(void)
+{
+    vlc_mutex_lock(&vlc_http_pool_lock);
+    assert(vlc_http_pool_creds_refs > 0);
+    if (--vlc_http_pool_creds_refs == 0)
+    {
+        vlc_tls_ClientDelete(vlc_http_pool_creds);
+        vlc_http_pool_creds = NULL;
+    }
+    vlc_mutex_unlock(&vlc_http_pool_lock);
+}
+
+static void vlc_http_pool_entry_release(struct vlc_http_pool_entry *e)
+{
+    vlc_http_conn_release(e->conn);
+    free(e->host);
+    if (e->secure)
+        vlc_http_creds_release();
+}
+
+/**
+ * Removes the expired entries, and the oldest one if the pool is full.
+ *
+ * @return the number of removed entries, to be released by the caller
+ */
+static unsigned vlc_http_pool_purge(struct vlc_http_pool_entry *tab,
+                                    bool room)
+{
+    vlc_tick_t now = vlc_tick_now();
+    unsigned n = 0;
+
+    for (unsigned i = 0; i < vlc_http_pool_count;)
+    {
+        if (vlc_http_pool[i].expiry <= now)
+        {
+            tab[n++] = vlc_http_pool[i];
+            vlc_http_pool[i] = vlc_http_pool[--vlc_http_pool_count];
+        }
+        else
+            i++;
+    }
+
+    if (room && vlc_http_pool_count == VLC_HTTP_POOL_SIZE)
+    {
+        unsigned oldest = 0;
+
+        for (unsigned i = 1; i < vlc_http_pool_count; i++)
+            if (vlc_http_pool[i].expiry < vlc_http_pool[oldest].expiry)
+                oldest = i;
+
+        tab[n++] = vlc_http_pool[oldest];
+        vlc_http_pool[oldest] = vlc_http_pool[--vlc_http_pool_count];
+    }
+    return n;
+}
+
+static struct vlc_http_conn *vlc_http_pool_take(const char *host,
+                                                unsigned port, bool secure)
+{
+    struct vlc_http_pool_entry dead[VLC_HTTP_POOL_SIZE];
+    struct vlc_http_conn *conn = NULL;
+
+    vlc_mutex_lock(&vlc_http_pool_lock);
+    unsigned n = vlc_http_pool_purge(dead, false);
+
+    for (unsigned i = 0; i < vlc_http_pool_count; i++)
+    {
+        struct vlc_http_pool_entry *e = &vlc_http_pool[i];
+
+        if (e->port == port && e->secure == secure && !strcmp(e->host, host))
+        {
+            conn = e->conn;
+            free(e->host);
+            /* The taker holds its own reference to the credentials */
+            assert(!secure || vlc_http_pool_creds_refs > 1);
+            if (secure)
+                vlc_http_pool_creds_refs--;
+            *e = vlc_http_pool[--vlc_http_pool_count];
+            break;
+        }
+    }
+    vlc_mutex_unlock(&vlc_http_pool_lock);
+
+    while (n > 0)
+        vlc_http_pool_entry_release(&dead[--n]);
+    return conn;
+}
+
+static void vlc_http_pool_put(struct vlc_http_conn *conn, const char *host,
+                              unsigned port, bool secure)
+{
+    struct vlc_http_pool_entry dead[VLC_HTTP_POOL_SIZE + 1];
+    char *name = strdup(host);
+
+    if (unlikely(name == NULL))
+    {
+        vlc_http_conn_release(conn);
+        return;
+    }
+
+    vlc_mutex_lock(&vlc_http_pool_lock);
+    unsigned n = vlc_http_pool_purge(dead, true);
+
+    assert(vlc_http_pool_count < VLC_HTTP_POOL_SIZE);
+    vlc_http_pool[vlc_http_pool_count++] = (struct vlc_http_pool_entry) {
+        conn, name, port, secure, vlc_tick_now() + VLC_HTTP_POOL_IDLE };
+    if (secure)
+        vlc_http_pool_creds_refs++;
+    vlc_mutex_unlock(&vlc_http_pool_lock);
+
+    while (n > 0)
+        vlc_http_pool_entry_release(&dead[--n]);
+}
+
 struct vlc_http_mgr
 {
     struct vlc_logger *logger;
@@ -103,13 +292,120 @@ struct vlc_http_mgr
     vlc_tls_client_t *creds;
     struct vlc_http_cookie_jar_t *jar;
     struct vlc_http_conn *conn;
+    /* Origin of the connection, NULL if through a proxy */
+    char *conn_host;
+    unsigned conn_port;
+    bool conn_secure;
+
+    /* Alternative service for new connections to the origin */
+    struct
+    {
+        char *origin;
+        unsigned origin_port;
+        char *host;
+        unsigned port;
+        vlc_tick_t expiry;
+    } alt;
 };
 
+static void vlc_http_mgr_altsvc_clear(struct vlc_http_mgr *mgr)
+{
+    free(mgr->alt.origin);
+    free(mgr->alt.host);
+    mgr->alt.origin = NULL;
+    mgr->alt.host = NULL;
+}
+
+/**
+ * Records the alternative service advertised by an HTTPS origin, if any.
+ */
+static struct vlc_http_msg *vlc_http_mgr_altsvc(struct vlc_http_mgr *mgr,
+                                                const char *host,
+                                                unsigned port,
+                                                struct vlc_http_msg *resp)
+{
+    if (vlc_http_msg_get_token(resp, "Alt-Svc", "clear") != NULL)
+    {
+        vlc_http_mgr_altsvc_clear(mgr);
+        return resp;
+    }
+
+    unsigned maxage;
+    char *authority = vlc_http_msg_get_altsvc(resp, "h3", &maxage);
+    if (authority != NULL)
+    {   /* TODO: HTTP/3 needs a QUIC transport */
+        vlc_http_dbg(mgr->logger, "HTTP/3 service at %s not supported",
+                     authority);
+        free(authority);
+    }
+
+    authority = vlc_http_msg_get_altsvc(resp, "h2", &maxage);
+    if (authority == NULL)
+        return resp;
+
+    /* Split the authority: [host]:port */
+    char *colon = strrchr(authority, ':');
+    unsigned altport;
+
+    if (colon == NULL || sscanf(colon + 1, "%u", &altport) != 1
+     || altport == 0 || altport > 65535 || vlc_http_port_blocked(altport))
+    {
+        free(authority);
+        return resp;
+    }
+    *colon = '\0';
+
+    const char *althost = (authority[0] != '\0') ? authority : host;
+    if (!strcmp(althost, host) && altport == (port ? port : 443))
+    {   /* Same as the origin */
+        free(authority);
+        return resp;
+    }
+
+    vlc_http_mgr_altsvc_clear(mgr);
+    mgr->alt.origin = strdup(host);
+    mgr->alt.host = strdup(althost);
+    free(authority);
+
+    if (unlikely(mgr->alt.origin == NULL || mgr->alt.host == NULL))
+    {
+        vlc_http_mgr_altsvc_clear(mgr);
+        return resp;
+    }
+
+    mgr->alt.origin_port = port;
+    mgr->alt.port = altport;
+    mgr->alt.expiry = vlc_tick_now() + vlc_tick_from_sec(maxage);
+    vlc_http_dbg(mgr->logger, "alternative service for %s: %s port %u",
+                 host, mgr->alt.host, altport);
+    return resp;
+}
+
+static void vlc_http_mgr_set_conn(struct vlc_http_mgr *mgr,
+                                  struct vlc_http_conn *conn, bool secure,
+                                  const char *host, unsigned port)
+{
+    assert(mgr->conn == NULL);
+    mgr->conn = conn;
+    mgr->conn_host = (host != NULL) ? strdup(host) : NULL;
+    mgr->conn_port = port;
+    mgr->conn_secure = secure;
+}
+
 static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
+                                               bool secure,
                                                const char *host, unsigned port)
 {
-    (void) host; (void) port;
-    return mgr->conn;
+    if (mgr->conn != NULL)
+        return mgr->conn;
+
+    struct vlc_http_conn *conn = vlc_http_pool_take(host, port, secure);
+    if (conn != NULL)
+    {
+        vlc_http_dbg(mgr->logger, "reusing idle connection to %s", host);
+        vlc_http_mgr_set_conn(mgr, conn, secure, host, port);
+    }
+    return conn;
 }
 
 static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
@@ -117,16 +413,18 @@ static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
 {
     assert(mgr->conn == conn);
     mgr->conn = NULL;
+    free(mgr->conn_host);
+    mgr->conn_host = NULL;
 
     vlc_http_conn_release(conn);
 }
 
 static
-struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
+struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr, bool secure,
                                         const char *host, unsigned port,
                                         const struct vlc_http_msg *req)
 {
-    struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
+    struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, secure, host, port);
     if (conn == NULL)
         return NULL;
 
@@ -159,17 +457,19 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
 
     if (mgr->creds == NULL)
     {   /* First TLS connection: load x509 credentials */
-        mgr->creds = vlc_tls_ClientCreate(mgr->obj);
+        mgr->creds = vlc_http_creds_hold(mgr->obj);
         if (mgr->creds == NULL)
             return NULL;
     }
 
     /* TODO? non-idempotent request support */
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
-    if (resp != NULL)
-        return resp; /* existing connection reused */
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, true, host, port,
+                                                   req);
+    if (resp != NULL) /* existing connection reused */
+        return vlc_http_mgr_altsvc(mgr, host, port, resp);
 
     char *proxy = vlc_http_proxy_find(host, port, true);
+    bool direct = proxy == NULL;
     if (proxy != NULL)
     {
         tls = vlc_https_connect_proxy(mgr->creds, mgr->creds,
@@ -177,7 +477,22 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         free(proxy);
     }
     else
-        tls = vlc_https_connect(mgr->creds, host, port, &http2);
+    {
+        tls = NULL;
+
+        if (mgr->alt.origin != NULL && !strcmp(mgr->alt.origin, host)
+         && mgr->alt.origin_port == port)
+        {
+            if (vlc_tick_now() < mgr->alt.expiry)
+                tls = vlc_https_connect_alt(mgr->creds, host, mgr->alt.host,
+                                            mgr->alt.port);
+            if (tls == NULL) /* Expired or failed, use the origin */
+                vlc_http_mgr_altsvc_clear(mgr);
+        }
+
+        if (tls == NULL)
+            tls = vlc_https_connect(mgr->creds, host, port, &http2);
+    }
 
     if (tls == NULL)
         return NULL;
@@ -202,9 +517,12 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    vlc_http_mgr_set_conn(mgr, conn, true, direct ? host : NULL, port);
 
-    return vlc_http_mgr_reuse(mgr, host, port, req);
+    resp = vlc_http_mgr_reuse(mgr, true, host, port, req);
+    if (resp != NULL)
+        resp = vlc_http_mgr_altsvc(mgr, host, port, resp);
+    return resp;
 }
 
 static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
@@ -214,7 +532,8 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
     if (mgr->creds != NULL && mgr->conn != NULL)
         return NULL; /* switch from HTTPS to HTTP not implemented */
 
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, false, host, port,
+                                                   req);
     if (resp != NULL)
         return resp;
 
@@ -222,6 +541,7 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
     struct vlc_http_stream *stream;
 
     char *proxy = vlc_http_proxy_find(host, port, false);
+    bool direct = proxy == NULL;
     if (proxy != NULL)
     {
         vlc_url_t url;
@@ -252,7 +572,7 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    vlc_http_mgr_set_conn(mgr, conn, false, direct ? host : NULL, port);
     return resp;
 }
 
@@ -283,14 +603,27 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->creds = NULL;
     mgr->jar = jar;
     mgr->conn = NULL;
+    mgr->conn_host = NULL;
+    mgr->alt.origin = NULL;
+    mgr->alt.host = NULL;
     return mgr;
 }
 
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
     if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
+    {
+        if (mgr->conn_host != NULL)
+        {   /* Keep the connection for a later manager */
+            vlc_http_pool_put(mgr->conn, mgr->conn_host, mgr->conn_port,
+                              mgr->conn_secure);
+            free(mgr->conn_host);
+        }
+        else
+            vlc_http_mgr_release(mgr, mgr->conn);
+    }
     if (mgr->creds != NULL)
-        vlc_tls_ClientDelete(mgr->creds);
+        vlc_http_creds_release();
+    vlc_http_mgr_altsvc_clear(mgr);
     free(mgr);
 }
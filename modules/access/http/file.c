@@ -43,6 +43,7 @@ struct vlc_http_file
 {
     struct vlc_http_resource resource;
     uintmax_t offset;
+    uintmax_t end;
 };
 
 static int vlc_http_file_req(const struct vlc_http_resource *res,
@@ -69,6 +70,13 @@ static int vlc_http_file_req(const struct vlc_http_resource *res,
         }
     }
 
+    if (file->end != UINTMAX_MAX && file->end > *offset)
+    {
+        if (vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-%"
+                                    PRIuMAX, *offset, file->end - 1))
+            return -1;
+    }
+    else
     if (vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-", *offset)
      && *offset != 0)
         return -1;
@@ -126,6 +134,7 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
     }
 
     file->offset = 0;
+    file->end = UINTMAX_MAX;
     return &file->resource;
 }
 
@@ -201,6 +210,36 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *res)
     return vlc_http_msg_can_seek(res->response);
 }
 
+char *vlc_http_file_get_validator(struct vlc_http_resource *res)
+{
+    int status = vlc_http_res_get_status(res);
+    if (status < 200 || status >= 300)
+        return NULL;
+
+    const char *str = vlc_http_msg_get_header(res->response, "ETag");
+    if (str != NULL)
+    {
+        if (!memcmp(str, "W/", 2))
+            str += 2; /* skip weak mark */
+        return strdup(str);
+    }
+
+    time_t mtime = vlc_http_msg_get_mtime(res->response);
+    char *ret;
+
+    if (mtime == -1
+     || asprintf(&ret, "%" PRIdMAX, (intmax_t)mtime) < 0)
+        return NULL;
+    return ret;
+}
+
+void vlc_http_file_set_end(struct vlc_http_resource *res, uintmax_t end)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    file->end = end;
+}
+
 int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
 {
     struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
@@ -72,6 +72,27 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *);
  */
 int vlc_http_file_seek(struct vlc_http_resource *, uintmax_t offset);
 
+/**
+ * Gets the file validator.
+ *
+ * Returns a string that changes whenever the remote file content changes,
+ * that is the entity tag, or the modification time if there are none.
+ *
+ * @return a heap-allocated string or NULL if unknown
+ */
+char *vlc_http_file_get_validator(struct vlc_http_resource *);
+
+/**
+ * Sets the end of the requested range.
+ *
+ * Limits the data requested after the next seek to the bytes before the
+ * given end offset, so that the connection can be reused afterward.
+ *
+ * @param end byte offset of the end of the range, or UINTMAX_MAX for the end
+ *            of the file
+ */
+void vlc_http_file_set_end(struct vlc_http_resource *, uintmax_t end);
+
 /**
  * Reads data.
  *
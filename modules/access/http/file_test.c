@@ -47,6 +47,7 @@ static const char *replies[2] = { NULL, NULL };
 static uintmax_t offset = 0;
 static bool secure = true;
 static bool etags = false;
+static uintmax_t range_end = UINTMAX_MAX;
 static int lang = -1;
 
 static vlc_http_cookie_jar_t *jar;
@@ -72,6 +73,7 @@ int main(void)
     assert(vlc_http_file_get_size(f) == (uintmax_t)-1);
     assert(!vlc_http_file_can_seek(f));
     assert(vlc_http_file_get_type(f) == NULL);
+    assert(vlc_http_file_get_validator(f) == NULL);
     assert(vlc_http_file_read(f) == NULL);
     vlc_http_res_destroy(f);
 
@@ -110,6 +112,9 @@ int main(void)
     assert(f != NULL);
     assert(vlc_http_file_can_seek(f));
     assert(vlc_http_file_get_size(f) == 2345);
+    str = vlc_http_file_get_validator(f);
+    assert(str != NULL && !strcmp(str, "\"foobar42\""));
+    free(str);
     assert(vlc_http_file_read(f) == NULL);
 
     /* Seek success */
@@ -123,6 +128,16 @@ int main(void)
     assert(vlc_http_file_get_size(f) == 3456);
     assert(vlc_http_file_read(f) == NULL);
 
+    /* Bounded range */
+    replies[0] = "HTTP/1.1 206 Partial Content\r\n"
+                 "Content-Range: bytes 2000-2999/3456\r\n"
+                 "ETag: W/\"foobar42\"\r\n"
+                 "\r\n";
+    vlc_http_file_set_end(f, range_end = 3000);
+    assert(vlc_http_file_seek(f, offset = 2000) == 0);
+    assert(vlc_http_file_get_size(f) == 3456);
+    vlc_http_file_set_end(f, range_end = UINTMAX_MAX);
+
     /* Seek too far */
     replies[0] = "HTTP/1.1 416 Range Not Satisfiable\r\n"
                  "Content-Range: bytes */4567\r\n"
@@ -175,6 +190,9 @@ int main(void)
     f = vlc_http_file_create(NULL, url, ua, NULL);
     assert(f != NULL);
     assert(vlc_http_file_can_seek(f));
+    str = vlc_http_file_get_validator(f);
+    assert(str != NULL && !strcmp(str, "1382386402"));
+    free(str);
 
     replies[0] = "HTTP/1.1 206 Partial Content\r\n"
                  "Content-Range: bytes 1234-3455/3456\r\n"
@@ -374,6 +392,10 @@ struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
     str = vlc_http_msg_get_header(req, "Range");
     assert(str != NULL && !strncmp(str, "bytes=", 6)
         && strtoul(str + 6, &end, 10) == offset && *end == '-');
+    if (range_end != UINTMAX_MAX)
+        assert(strtoul(end + 1, &end, 10) == range_end - 1 && *end == '\0');
+    else
+        assert(end[1] == '\0');
 
     time_t mtime = vlc_http_msg_get_time(req, "If-Unmodified-Since");
     str = vlc_http_msg_get_header(req, "If-Match");
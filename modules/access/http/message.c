@@ -936,6 +936,47 @@ int vlc_http_msg_add_cookies(struct vlc_http_msg *m,
     return val;
 }
 
+char *vlc_http_msg_get_altsvc(const struct vlc_http_msg *m, const char *proto,
+                              unsigned *restrict maxage)
+{   /* IETF RFC7838 §3 */
+    const char *value = vlc_http_msg_get_token(m, "Alt-Svc", proto);
+    if (value == NULL)
+        return NULL;
+
+    char *authority = vlc_http_get_token_value(value, proto);
+    if (authority == NULL)
+        return NULL;
+
+    /* Skip to the parameters of this alternative */
+    value += vlc_http_token_length(value);
+    value += strspn(value, " \t=");
+    value += vlc_http_quoted_length(value);
+
+    *maxage = 86400; /* 24 hours by default */
+
+    for (;;)
+    {
+        value += strspn(value, " \t"); /* OWS */
+        if (*value != ';')
+            break;
+        value++;
+        value += strspn(value, " \t"); /* OWS */
+
+        size_t len = vlc_http_token_length(value);
+        if (len == 2 && !strncasecmp(value, "ma", 2) && value[2] == '=')
+            *maxage = strtoul(value + 3, NULL, 10);
+
+        value += len;
+        if (*value == '=')
+        {
+            value++;
+            len = vlc_http_quoted_length(value);
+            value += len ? len : vlc_http_token_length(value);
+        }
+    }
+    return authority;
+}
+
 char *vlc_http_msg_get_basic_realm(const struct vlc_http_msg *m)
 {
     const char *auth;
@@ -148,6 +148,20 @@ void vlc_http_msg_get_cookies(const struct vlc_http_msg *,
 int vlc_http_msg_add_cookies(struct vlc_http_msg *,
                              struct vlc_http_cookie_jar_t *);
 
+/**
+ * Looks up an alternative service.
+ *
+ * Finds the first alternative service advertised for a given protocol in the
+ * HTTP message.
+ *
+ * @param proto ALPN protocol identifier, e.g. "h2" or "h3"
+ * @param maxage storage space for the validity time in seconds [OUT]
+ * @return the alternative authority as a heap-allocated string
+ *         ("host:port" or ":port" if it is the same host), NULL if none.
+ */
+char *vlc_http_msg_get_altsvc(const struct vlc_http_msg *, const char *proto,
+                              unsigned *restrict maxage);
+
 char *vlc_http_msg_get_basic_realm(const struct vlc_http_msg *);
 
 /**
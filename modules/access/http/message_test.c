@@ -161,6 +161,29 @@ static time_t parse_date(const char *str)
     return t1;
 }
 
+static void check_altsvc(const char *line, const char *proto,
+                         const char *authority, unsigned maxage)
+{
+    struct vlc_http_msg *m;
+    char *value;
+    unsigned ma;
+
+    m = vlc_http_resp_create(200);
+    assert(m != NULL);
+    assert(vlc_http_msg_add_header(m, "Alt-Svc", "%s", line) == 0);
+    value = vlc_http_msg_get_altsvc(m, proto, &ma);
+    if (authority == NULL)
+        assert(value == NULL);
+    else
+    {
+        assert(value != NULL);
+        assert(!strcmp(value, authority));
+        assert(ma == maxage);
+        free(value);
+    }
+    vlc_http_msg_destroy(m);
+}
+
 static const char *check_realm(const char *line, const char *realm)
 {
     struct vlc_http_msg *m;
@@ -234,6 +257,14 @@ int main(void)
                        "Realm is \"Hello world!\""));
     assert(check_realm("Basic", NULL) == NULL);
 
+    /* Alternative services */
+    check_altsvc("h2=\":8443\"", "h2", ":8443", 86400);
+    check_altsvc("h3=\":443\"; ma=3600, h2=\"alt.example.com:443\"; ma=60",
+                 "h2", "alt.example.com:443", 60);
+    check_altsvc("h3=\":443\"; ma=3600; persist=1", "h3", ":443", 3600);
+    check_altsvc("h3=\":443\"", "h2", NULL, 0);
+    check_altsvc("clear", "h2", NULL, 0);
+
     m = vlc_http_req_create("PRI", "https", "*", NULL);
     assert(m != NULL);
 
@@ -0,0 +1,443 @@
+/*****************************************************************************
+ * parallel.c: HTTP parallel ranged download
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+#include "connmgr.h"
+#include "resource.h"
+#include "file.h"
+#include "parallel.h"
+
+#pragma GCC visibility push(default)
+
+/* Size of the ranges requested by each connection */
+#define PARALLEL_CHUNK_SIZE (2 << 20)
+/* Attempts to fetch a range before giving up */
+#define PARALLEL_RETRIES 3
+/* Throughput measurement period */
+#define PARALLEL_PERIOD VLC_TICK_FROM_SEC(1)
+
+enum
+{
+    CHUNK_PENDING,
+    CHUNK_FETCHING,
+    CHUNK_DONE,
+    CHUNK_FAILED,
+};
+
+struct vlc_http_chunk
+{
+    uint64_t id; /* zero if discarded */
+    uintmax_t offset; /* offset of the next byte to fetch */
+    uintmax_t end;
+    block_t *data;
+    block_t **tailp;
+    unsigned retries;
+    int state;
+};
+
+struct vlc_http_worker
+{
+    struct vlc_http_parallel *owner;
+    struct vlc_http_mgr *manager;
+    struct vlc_http_resource *resource;
+    vlc_interrupt_t *interrupt;
+    vlc_thread_t thread;
+};
+
+struct vlc_http_parallel
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait_data;
+    vlc_cond_t wait_work;
+
+    uintmax_t size;
+    uintmax_t next; /* offset of the next chunk to queue */
+    uint64_t next_id;
+
+    /* Circular queue of chunks, in offset order */
+    struct vlc_http_chunk *chunks;
+    unsigned head;
+    unsigned count;
+    unsigned depth;
+
+    /* Adaptation */
+    unsigned active; /* number of connections allowed to fetch */
+    unsigned last_active;
+    unsigned holdoff;
+    bool starved;
+    uintmax_t bytes;
+    vlc_tick_t since;
+    double rate;
+
+    bool interrupted;
+    bool quit;
+
+    unsigned max;
+    struct vlc_http_worker workers[];
+};
+
+static void vlc_http_parallel_fill(struct vlc_http_parallel *p)
+{
+    while (p->count < p->depth && p->next < p->size)
+    {
+        struct vlc_http_chunk *c =
+            &p->chunks[(p->head + p->count) % p->depth];
+
+        c->id = p->next_id++;
+        c->offset = p->next;
+        c->end = p->next + __MIN(p->size - p->next, PARALLEL_CHUNK_SIZE);
+        c->data = NULL;
+        c->tailp = &c->data;
+        c->retries = 0;
+        c->state = CHUNK_PENDING;
+        p->next = c->end;
+        p->count++;
+    }
+    vlc_cond_broadcast(&p->wait_work);
+}
+
+static struct vlc_http_chunk *vlc_http_parallel_get(struct vlc_http_parallel *p)
+{
+    for (unsigned i = 0; i < p->count; i++)
+    {
+        struct vlc_http_chunk *c = &p->chunks[(p->head + i) % p->depth];
+
+        if (c->state == CHUNK_PENDING)
+            return c;
+    }
+    return NULL;
+}
+
+/**
+ * Adapts the number of connections to the throughput.
+ *
+ * One more connection is tried whenever the reader had to wait for data.
+ * It is dropped if the aggregate throughput did not increase with it.
+ */
+static void vlc_http_parallel_adapt(struct vlc_http_parallel *p)
+{
+    vlc_tick_t now = vlc_tick_now();
+    vlc_tick_t elapsed = now - p->since;
+
+    if (elapsed < PARALLEL_PERIOD)
+        return;
+
+    double rate = p->bytes / secf_from_vlc_tick(elapsed);
+    unsigned active = p->active;
+
+    if (p->holdoff > 0)
+        p->holdoff--;
+
+    if (active > p->last_active && rate < p->rate * 1.1)
+    {   /* No gain from the last connection */
+        active--;
+        p->holdoff = 10;
+    }
+    else if (p->starved && p->holdoff == 0 && active < p->max)
+        active++;
+
+    p->last_active = p->active;
+    p->active = active;
+    p->rate = rate;
+    p->bytes = 0;
+    p->since = now;
+    p->starved = false;
+
+    if (active > p->last_active)
+        vlc_cond_broadcast(&p->wait_work);
+}
+
+static void *vlc_http_parallel_thread(void *data)
+{
+    struct vlc_http_worker *w = data;
+    struct vlc_http_parallel *p = w->owner;
+    const unsigned index = w - p->workers;
+
+    vlc_interrupt_set(w->interrupt);
+    vlc_mutex_lock(&p->lock);
+
+    while (!p->quit)
+    {
+        struct vlc_http_chunk *c = NULL;
+
+        if (index < p->active)
+            c = vlc_http_parallel_get(p);
+        if (c == NULL)
+        {
+            vlc_cond_wait(&p->wait_work, &p->lock);
+            continue;
+        }
+
+        const uint64_t id = c->id;
+        uintmax_t offset = c->offset;
+
+        c->state = CHUNK_FETCHING;
+        vlc_http_file_set_end(w->resource, c->end);
+        vlc_mutex_unlock(&p->lock);
+
+        bool ok = vlc_http_file_seek(w->resource, offset) == 0;
+
+        for (;;)
+        {
+            block_t *b = ok ? vlc_http_file_read(w->resource) : NULL;
+
+            vlc_mutex_lock(&p->lock);
+            if (c->id != id)
+            {   /* Discarded by a seek */
+                if (b != NULL)
+                    block_Release(b);
+                break;
+            }
+
+            if (b == NULL)
+            {   /* Try again from where it stopped */
+                c->state = (++c->retries < PARALLEL_RETRIES) ? CHUNK_PENDING
+                                                             : CHUNK_FAILED;
+                vlc_cond_signal(&p->wait_data);
+                vlc_cond_broadcast(&p->wait_work);
+                break;
+            }
+
+            assert(b->p_next == NULL);
+            if (b->i_buffer > c->end - c->offset)
+                b->i_buffer = c->end - c->offset;
+
+            c->offset += b->i_buffer;
+            c->retries = 0;
+            *(c->tailp) = b;
+            c->tailp = &b->p_next;
+            p->bytes += b->i_buffer;
+            vlc_cond_signal(&p->wait_data);
+
+            if (c->offset == c->end)
+            {
+                c->state = CHUNK_DONE;
+                break;
+            }
+            vlc_mutex_unlock(&p->lock);
+        }
+
+        vlc_http_parallel_adapt(p);
+    }
+
+    vlc_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+static void vlc_http_parallel_wake_up(void *data)
+{
+    struct vlc_http_parallel *p = data;
+
+    vlc_mutex_lock(&p->lock);
+    p->interrupted = true;
+    vlc_cond_signal(&p->wait_data);
+    vlc_mutex_unlock(&p->lock);
+}
+
+block_t *vlc_http_parallel_read(struct vlc_http_parallel *p)
+{
+    block_t *b = NULL;
+
+    vlc_interrupt_register(vlc_http_parallel_wake_up, p);
+    vlc_mutex_lock(&p->lock);
+
+    while (p->count > 0)
+    {
+        struct vlc_http_chunk *c = &p->chunks[p->head];
+
+        if (c->data != NULL)
+        {
+            b = c->data;
+            c->data = b->p_next;
+            if (c->data == NULL)
+                c->tailp = &c->data;
+            b->p_next = NULL;
+            break;
+        }
+
+        if (c->state == CHUNK_DONE)
+        {   /* Fully read: make room for the next chunk */
+            c->id = 0;
+            p->head = (p->head + 1) % p->depth;
+            p->count--;
+            vlc_http_parallel_fill(p);
+            continue;
+        }
+
+        if (c->state == CHUNK_FAILED || p->interrupted)
+            break;
+
+        p->starved = true;
+        vlc_cond_wait(&p->wait_data, &p->lock);
+    }
+
+    p->interrupted = false;
+    vlc_mutex_unlock(&p->lock);
+    vlc_interrupt_unregister();
+    return b;
+}
+
+void vlc_http_parallel_seek(struct vlc_http_parallel *p, uintmax_t offset)
+{
+    vlc_mutex_lock(&p->lock);
+    for (unsigned i = 0; i < p->count; i++)
+    {
+        struct vlc_http_chunk *c = &p->chunks[(p->head + i) % p->depth];
+
+        block_ChainRelease(c->data);
+        c->id = 0;
+    }
+
+    p->head = 0;
+    p->count = 0;
+    p->next = offset;
+    vlc_http_parallel_fill(p);
+    vlc_mutex_unlock(&p->lock);
+}
+
+static void vlc_http_parallel_stop(struct vlc_http_parallel *p, unsigned n)
+{
+    vlc_mutex_lock(&p->lock);
+    p->quit = true;
+    vlc_cond_broadcast(&p->wait_work);
+    vlc_mutex_unlock(&p->lock);
+
+    for (unsigned i = 0; i < n; i++)
+        vlc_interrupt_kill(p->workers[i].interrupt);
+    for (unsigned i = 0; i < n; i++)
+        vlc_join(p->workers[i].thread, NULL);
+}
+
+static void vlc_http_worker_clean(struct vlc_http_worker *w)
+{
+    if (w->interrupt != NULL)
+        vlc_interrupt_destroy(w->interrupt);
+    if (w->resource != NULL)
+        vlc_http_res_destroy(w->resource);
+    if (w->manager != NULL)
+        vlc_http_mgr_destroy(w->manager);
+}
+
+struct vlc_http_parallel *vlc_http_parallel_create(vlc_object_t *obj,
+                                    struct vlc_http_cookie_jar_t *jar,
+                                    const char *url, const char *ua,
+                                    const char *ref, const char *user,
+                                    const char *pwd, uintmax_t size,
+                                    unsigned max_conns)
+{
+    assert(max_conns > 0);
+
+    struct vlc_http_parallel *p = malloc(sizeof (*p)
+                                  + max_conns * sizeof (p->workers[0]));
+    if (unlikely(p == NULL))
+        return NULL;
+
+    p->depth = max_conns + 2;
+    p->chunks = vlc_alloc(p->depth, sizeof (*p->chunks));
+    if (unlikely(p->chunks == NULL))
+    {
+        free(p);
+        return NULL;
+    }
+
+    vlc_mutex_init(&p->lock);
+    vlc_cond_init(&p->wait_data);
+    vlc_cond_init(&p->wait_work);
+    p->size = size;
+    p->next = 0;
+    p->next_id = 1;
+    p->head = 0;
+    p->count = 0;
+    p->active = p->last_active = __MIN(max_conns, 2);
+    p->holdoff = 0;
+    p->starved = false;
+    p->bytes = 0;
+    p->since = vlc_tick_now();
+    p->rate = 0.;
+    p->interrupted = false;
+    p->quit = false;
+    p->max = max_conns;
+
+    unsigned n;
+
+    for (n = 0; n < max_conns; n++)
+    {
+        struct vlc_http_worker *w = &p->workers[n];
+
+        w->owner = p;
+        w->manager = vlc_http_mgr_create(obj, jar);
+        w->resource = (w->manager != NULL)
+            ? vlc_http_file_create(w->manager, url, ua, ref) : NULL;
+        w->interrupt = vlc_interrupt_create();
+
+        if (w->resource == NULL || w->interrupt == NULL)
+        {
+            vlc_http_worker_clean(w);
+            break;
+        }
+
+        if (user != NULL)
+            vlc_http_res_set_login(w->resource, user, pwd);
+
+        if (vlc_clone(&w->thread, vlc_http_parallel_thread, w,
+                      VLC_THREAD_PRIORITY_INPUT))
+        {
+            vlc_http_worker_clean(w);
+            break;
+        }
+    }
+
+    if (n == 0)
+    {
+        free(p->chunks);
+        free(p);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&p->lock);
+    p->max = n;
+    p->active = p->last_active = __MIN(n, p->active);
+    vlc_http_parallel_fill(p);
+    vlc_mutex_unlock(&p->lock);
+    return p;
+}
+
+void vlc_http_parallel_destroy(struct vlc_http_parallel *p)
+{
+    vlc_http_parallel_stop(p, p->max);
+
+    for (unsigned i = 0; i < p->count; i++)
+        block_ChainRelease(p->chunks[(p->head + i) % p->depth].data);
+    for (unsigned i = 0; i < p->max; i++)
+        vlc_http_worker_clean(&p->workers[i]);
+
+    free(p->chunks);
+    free(p);
+}
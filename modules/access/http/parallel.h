@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * parallel.h: HTTP parallel ranged download declarations
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/**
+ * \defgroup http_parallel Parallel downloads
+ * HTTP read-only files fetched through several connections
+ * \ingroup http_res
+ * @{
+ */
+
+struct vlc_http_parallel;
+struct vlc_http_cookie_jar_t;
+struct block_t;
+
+/**
+ * Starts a parallel download.
+ *
+ * Fetches consecutive ranges of a remote file of known size through up to
+ * the given number of connections, and reassembles them in order. The number
+ * of connections in use is adapted to the measured throughput.
+ *
+ * @param url URL of the file to read
+ * @param ua user agent string (or NULL to ignore)
+ * @param ref referral URL (or NULL to ignore)
+ * @param user user name (or NULL to ignore)
+ * @param pwd password (or NULL to ignore)
+ * @param size file size in bytes
+ * @param max_conns maximum number of connections
+ *
+ * @return a parallel download object pointer, or NULL on error
+ */
+struct vlc_http_parallel *vlc_http_parallel_create(vlc_object_t *obj,
+                                    struct vlc_http_cookie_jar_t *jar,
+                                    const char *url, const char *ua,
+                                    const char *ref, const char *user,
+                                    const char *pwd, uintmax_t size,
+                                    unsigned max_conns);
+
+/**
+ * Reads data.
+ *
+ * Waits for the data at the current offset and advances the offset.
+ *
+ * @return a data block, or NULL at the end of the file or on error
+ */
+struct block_t *vlc_http_parallel_read(struct vlc_http_parallel *);
+
+/**
+ * Sets the read offset.
+ *
+ * Ranges fetched or being fetched are discarded.
+ */
+void vlc_http_parallel_seek(struct vlc_http_parallel *, uintmax_t offset);
+
+/**
+ * Stops the download and releases resources.
+ */
+void vlc_http_parallel_destroy(struct vlc_http_parallel *);
+
+/** @} */
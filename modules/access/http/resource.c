@@ -90,14 +90,20 @@ retry:
     if (unlikely(req == NULL))
         return NULL;
 
+    vlc_tick_t start = vlc_tick_now();
     struct vlc_http_msg *resp = vlc_http_mgr_request(res->manager, res->secure,
                                                     res->host, res->port, req);
     vlc_http_msg_destroy(req);
+    res->requests++;
 
     resp = vlc_http_msg_get_final(resp);
     if (resp == NULL)
         return NULL;
 
+    /* The request is small: this is the round trip, plus the server time and
+     * the connection set-up, if any */
+    res->rtt = vlc_tick_now() - start;
+
     vlc_http_msg_get_cookies(resp, vlc_http_mgr_get_jar(res->manager),
                              res->host, res->path);
 
@@ -208,6 +214,8 @@ int vlc_http_res_init(struct vlc_http_resource *restrict res,
     res->secure = secure;
     res->negotiate = true;
     res->failure = false;
+    res->requests = 0;
+    res->rtt = VLC_TICK_INVALID;
     res->host = strdup(url.psz_host);
     res->port = url.i_port;
     res->authority = vlc_http_authority(url.psz_host, url.i_port);
@@ -56,6 +56,8 @@ struct vlc_http_resource
     char *password;
     char *agent;
     char *referrer;
+    unsigned requests; /**< requests sent */
+    vlc_tick_t rtt; /**< delay of the last response headers */
 };
 
 int vlc_http_res_init(struct vlc_http_resource *,
@@ -140,6 +140,7 @@ static const struct vlc_tls_operations vlc_tls_proxy_ops =
     vlc_tls_ProxyWrite,
     vlc_tls_ProxyShutdown,
     vlc_tls_ProxyClose,
+    NULL,
 };
 
 vlc_tls_t *vlc_https_connect_proxy(void *ctx, vlc_tls_client_t *creds,
@@ -49,6 +49,13 @@
 #define AUTO_GUID_TEXT N_("Set NFS uid/guid automatically")
 #define AUTO_GUID_LONGTEXT N_("If uid/gid are not specified in " \
     "the url, VLC will automatically set a uid/gid.")
+#define READ_AHEAD_TEXT N_("Read-ahead requests")
+#define READ_AHEAD_LONGTEXT N_("Number of file read requests kept in " \
+    "flight. More requests improve the throughput over high latency links.")
+
+/* Bounds of the size of each read request */
+#define NFS_READ_SIZE_MIN 32768
+#define NFS_READ_SIZE_MAX 1048576
 
 static int Open(vlc_object_t *);
 static void Close(vlc_object_t *);
@@ -59,11 +66,23 @@ vlc_module_begin()
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_ACCESS)
     add_bool("nfs-auto-guid", true, AUTO_GUID_TEXT, AUTO_GUID_LONGTEXT, true)
+    add_integer_with_range("nfs-read-ahead", 4, 1, 16, READ_AHEAD_TEXT,
+                           READ_AHEAD_LONGTEXT, true)
     set_capability("access", 0)
     add_shortcut("nfs")
     set_callbacks(Open, Close)
 vlc_module_end()
 
+struct nfs_read
+{
+    stream_t *p_access;
+    uint8_t *p_buf;
+    uint64_t i_offset;
+    size_t i_len; /**< Bytes received */
+    size_t i_pos; /**< Bytes consumed */
+    bool b_pending;
+};
+
 typedef struct
 {
     struct rpc_context *    p_mount; /* used to to get exports mount point */
@@ -79,21 +98,22 @@ typedef struct
     bool                    b_error;
     bool                    b_auto_guid;
 
+    /* Read-ahead ring of asynchronous read requests */
+    struct nfs_read *       p_reads;
+    uint8_t *               p_read_bufs;
+    unsigned                i_read_depth;
+    unsigned                i_read_first;
+    unsigned                i_read_count;
+    unsigned                i_read_pending;
+    size_t                  i_read_size;
+    uint64_t                i_read_offset; /**< Offset of the next request */
+
     union {
         struct
         {
             char **         ppsz_names;
             int             i_count;
         } exports;
-        struct
-        {
-            uint8_t *p_buf;
-            size_t i_len;
-        } read;
-        struct
-        {
-            bool b_done;
-        } seek;
     } res;
 } access_sys_t;
 
@@ -178,71 +198,135 @@ nfs_read_cb(int i_status, struct nfs_context *p_nfs, void *p_data,
             void *p_private_data)
 {
     VLC_UNUSED(p_nfs);
-    stream_t *p_access = p_private_data;
+    struct nfs_read *p_read = p_private_data;
+    stream_t *p_access = p_read->p_access;
     access_sys_t *p_sys = p_access->p_sys;
     assert(p_sys->p_nfs == p_nfs);
+    assert(p_read->b_pending);
+
+    p_read->b_pending = false;
+    p_sys->i_read_pending--;
     if (NFS_CHECK_STATUS(p_access, i_status, p_data))
         return;
 
-    if (i_status == 0)
-        p_sys->b_eof = true;
-    else
-    {
-        p_sys->res.read.i_len = i_status;
-        memcpy(p_sys->res.read.p_buf, p_data, i_status);
-    }
+    p_read->i_len = i_status;
+    memcpy(p_read->p_buf, p_data, i_status);
 }
 
 static bool
 nfs_read_finished_cb(stream_t *p_access)
 {
     access_sys_t *p_sys = p_access->p_sys;
-    return p_sys->res.read.i_len > 0 || p_sys->b_eof;
+    return !p_sys->p_reads[p_sys->i_read_first].b_pending;
 }
 
-static ssize_t
-FileRead(stream_t *p_access, void *p_buf, size_t i_len)
+static bool
+nfs_read_drained_cb(stream_t *p_access)
 {
     access_sys_t *p_sys = p_access->p_sys;
+    return p_sys->i_read_pending == 0;
+}
 
-    if (p_sys->b_eof)
-        return 0;
-
-    p_sys->res.read.i_len = 0;
-    p_sys->res.read.p_buf = p_buf;
-    if (nfs_read_async(p_sys->p_nfs, p_sys->p_nfsfh, i_len, nfs_read_cb,
-                       p_access) < 0)
-    {
-        msg_Err(p_access, "nfs_read_async failed");
-        return -1;
-    }
+/* Waits for all requests in flight, so that their buffers can be reused */
+static int
+ReadReset(stream_t *p_access, uint64_t i_offset)
+{
+    access_sys_t *p_sys = p_access->p_sys;
 
-    if (vlc_nfs_mainloop(p_access, nfs_read_finished_cb) < 0)
+    if (vlc_nfs_mainloop(p_access, nfs_read_drained_cb) < 0)
         return -1;
 
-    return p_sys->res.read.i_len;
+    p_sys->i_read_first = 0;
+    p_sys->i_read_count = 0;
+    p_sys->i_read_offset = i_offset;
+    return 0;
 }
 
-static void
-nfs_seek_cb(int i_status, struct nfs_context *p_nfs, void *p_data,
-            void *p_private_data)
+/* Sends read requests until the read-ahead ring is full. Requests are not
+ * sent past the end of the file, unless nothing else is left to read. */
+static int
+ReadQueue(stream_t *p_access)
 {
-    VLC_UNUSED(p_nfs);
-    stream_t *p_access = p_private_data;
     access_sys_t *p_sys = p_access->p_sys;
-    assert(p_sys->p_nfs == p_nfs);
-    (void) p_data;
-    if (NFS_CHECK_STATUS(p_access, i_status, p_data))
-        return;
 
-    p_sys->res.seek.b_done = true;
+    while (p_sys->i_read_count < p_sys->i_read_depth
+        && (p_sys->i_read_count == 0
+         || p_sys->i_read_offset < p_sys->stat.nfs_size))
+    {
+        unsigned i_idx = (p_sys->i_read_first + p_sys->i_read_count)
+                       % p_sys->i_read_depth;
+        struct nfs_read *p_read = &p_sys->p_reads[i_idx];
+
+        if (p_read->b_pending)
+            break; /* still owned by a discarded request */
+
+        p_read->i_offset = p_sys->i_read_offset;
+        p_read->i_len = 0;
+        p_read->i_pos = 0;
+        p_read->b_pending = true;
+
+        if (nfs_pread_async(p_sys->p_nfs, p_sys->p_nfsfh, p_read->i_offset,
+                            p_sys->i_read_size, nfs_read_cb, p_read) < 0)
+        {
+            p_read->b_pending = false;
+            msg_Err(p_access, "nfs_pread_async failed");
+            return -1;
+        }
+
+        p_sys->i_read_pending++;
+        p_sys->i_read_count++;
+        p_sys->i_read_offset += p_sys->i_read_size;
+    }
+    return 0;
 }
 
-static bool
-nfs_seek_finished_cb(stream_t *p_access)
+static ssize_t
+FileRead(stream_t *p_access, void *p_buf, size_t i_len)
 {
     access_sys_t *p_sys = p_access->p_sys;
-    return p_sys->res.seek.b_done;
+
+    if (p_sys->b_eof)
+        return 0;
+
+    if (ReadQueue(p_access) < 0
+     || vlc_nfs_mainloop(p_access, nfs_read_finished_cb) < 0)
+        return -1;
+
+    struct nfs_read *p_read = &p_sys->p_reads[p_sys->i_read_first];
+
+    if (p_read->i_pos >= p_read->i_len)
+    {
+        if (p_read->i_len == 0)
+        {
+            p_sys->b_eof = true;
+            return 0;
+        }
+        /* Seek target beyond a short read */
+        return ReadReset(p_access, p_read->i_offset + p_read->i_pos) < 0 ? -1
+             : FileRead(p_access, p_buf, i_len);
+    }
+
+    if (i_len > p_read->i_len - p_read->i_pos)
+        i_len = p_read->i_len - p_read->i_pos;
+    memcpy(p_buf, p_read->p_buf + p_read->i_pos, i_len);
+    p_read->i_pos += i_len;
+
+    if (p_read->i_pos == p_read->i_len)
+    {
+        p_sys->i_read_first = (p_sys->i_read_first + 1) % p_sys->i_read_depth;
+        p_sys->i_read_count--;
+
+        if (p_read->i_len < p_sys->i_read_size
+         && p_read->i_offset + p_read->i_len < p_sys->stat.nfs_size)
+        {   /* The server truncated the request: the following requests are
+             * misaligned. Use smaller requests from now on. */
+            msg_Dbg(p_access, "read size limited to %zu bytes", p_read->i_len);
+            p_sys->i_read_size = p_read->i_len;
+            if (ReadReset(p_access, p_read->i_offset + p_read->i_len) < 0)
+                return -1;
+        }
+    }
+    return i_len;
 }
 
 static int
@@ -250,19 +334,27 @@ FileSeek(stream_t *p_access, uint64_t i_pos)
 {
     access_sys_t *p_sys = p_access->p_sys;
 
-    p_sys->res.seek.b_done = false;
-    if (nfs_lseek_async(p_sys->p_nfs, p_sys->p_nfsfh, i_pos, SEEK_SET,
-                        nfs_seek_cb, p_access) < 0)
+    p_sys->b_eof = false;
+
+    /* Keep the requests following the new offset, if it is ahead */
+    while (p_sys->i_read_count > 0)
     {
-        msg_Err(p_access, "nfs_seek_async failed");
-        return VLC_EGENERIC;
+        struct nfs_read *p_read = &p_sys->p_reads[p_sys->i_read_first];
+
+        if (i_pos < p_read->i_offset)
+            break;
+        if (i_pos < p_read->i_offset + p_sys->i_read_size)
+        {
+            p_read->i_pos = i_pos - p_read->i_offset;
+            return VLC_SUCCESS;
+        }
+        p_sys->i_read_first = (p_sys->i_read_first + 1) % p_sys->i_read_depth;
+        p_sys->i_read_count--;
     }
 
-    if (vlc_nfs_mainloop(p_access, nfs_seek_finished_cb) < 0)
+    if (ReadReset(p_access, i_pos) < 0)
         return VLC_EGENERIC;
 
-    p_sys->b_eof = false;
-
     return VLC_SUCCESS;
 }
 
@@ -692,6 +784,26 @@ Open(vlc_object_t *p_obj)
 
         if (p_sys->p_nfsfh != NULL)
         {
+            size_t i_size = nfs_get_readmax(p_sys->p_nfs);
+
+            p_sys->i_read_size = VLC_CLIP(i_size, NFS_READ_SIZE_MIN,
+                                          NFS_READ_SIZE_MAX);
+            p_sys->i_read_depth = var_InheritInteger(p_access,
+                                                     "nfs-read-ahead");
+            p_sys->p_reads = vlc_obj_calloc(p_obj, p_sys->i_read_depth,
+                                            sizeof (*p_sys->p_reads));
+            p_sys->p_read_bufs = malloc(p_sys->i_read_depth
+                                        * p_sys->i_read_size);
+            if (unlikely(p_sys->p_reads == NULL
+                      || p_sys->p_read_bufs == NULL))
+                goto error;
+            for (unsigned i = 0; i < p_sys->i_read_depth; i++)
+            {
+                p_sys->p_reads[i].p_access = p_access;
+                p_sys->p_reads[i].p_buf = p_sys->p_read_bufs
+                                        + i * p_sys->i_read_size;
+            }
+
             p_access->pf_read = FileRead;
             p_access->pf_seek = FileSeek;
             p_access->pf_control = FileControl;
@@ -750,13 +862,18 @@ Close(vlc_object_t *p_obj)
     access_sys_t *p_sys = p_access->p_sys;
 
     if (p_sys->p_nfsfh != NULL)
+    {
+        if (p_sys->i_read_pending > 0)
+            vlc_nfs_mainloop(p_access, nfs_read_drained_cb);
         nfs_close(p_sys->p_nfs, p_sys->p_nfsfh);
+    }
 
     if (p_sys->p_nfsdir != NULL)
         nfs_closedir(p_sys->p_nfs, p_sys->p_nfsdir);
 
     if (p_sys->p_nfs != NULL)
         nfs_destroy_context(p_sys->p_nfs);
+    free(p_sys->p_read_bufs);
 
     if (p_sys->p_mount != NULL)
     {
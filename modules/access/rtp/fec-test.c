@@ -0,0 +1,162 @@
+/*
+ * RTP forward error correction test
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <string.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include "fec.h"
+
+#define COLS 4
+#define ROWS 3
+#define BASE 65530 /* exercise sequence number wrap-around */
+
+static block_t *media[COLS * ROWS];
+
+static block_t *media_packet (unsigned i)
+{
+    size_t len = 12 + 20 + 7 * i; /* unequal payload lengths */
+    block_t *block = block_Alloc (len);
+    assert (block != NULL);
+
+    uint8_t *buf = block->p_buffer;
+    buf[0] = 0x80;
+    buf[1] = 33 | ((i % COLS == COLS - 1) ? 0x80 : 0);
+    SetWBE (buf + 2, BASE + i);
+    SetDWBE (buf + 4, 90000 + 3000 * i);
+    SetDWBE (buf + 8, 0xdeadbeef);
+    for (size_t j = 12; j < len; j++)
+        buf[j] = i * 31 + j;
+    return block;
+}
+
+/* Generates the XOR FEC packet protecting na packets from first */
+static block_t *fec_packet (unsigned first, unsigned offset, unsigned na,
+                            bool row)
+{
+    size_t len = 0;
+    for (unsigned i = 0; i < na; i++)
+        len = __MAX(len, media[first + i * offset]->i_buffer - 12);
+
+    block_t *block = block_Alloc (12 + 16 + len);
+    assert (block != NULL);
+    memset (block->p_buffer, 0, block->i_buffer);
+
+    uint8_t *buf = block->p_buffer, *hdr = buf + 12;
+    uint16_t lenrec = 0;
+    uint32_t tsrec = 0;
+    uint8_t byte0 = 0, byte1 = 0;
+
+    for (unsigned i = 0; i < na; i++)
+    {
+        const block_t *m = media[first + i * offset];
+
+        lenrec ^= m->i_buffer - 12;
+        byte0 ^= m->p_buffer[0];
+        byte1 ^= m->p_buffer[1];
+        tsrec ^= GetDWBE (m->p_buffer + 4);
+        for (size_t j = 12; j < m->i_buffer; j++)
+            hdr[16 + j - 12] ^= m->p_buffer[j];
+    }
+
+    buf[0] = 0x80 | (byte0 & 0x3F);
+    buf[1] = (byte1 & 0x80) | 96;
+    SetWBE (buf + 2, first);
+    SetWBE (hdr, BASE + first);
+    SetWBE (hdr + 2, lenrec);
+    hdr[4] = 0x80 | (byte1 & 0x7F);
+    SetDWBE (hdr + 8, tsrec);
+    hdr[12] = row ? 0x40 : 0;
+    hdr[13] = offset;
+    hdr[14] = na;
+    return block;
+}
+
+static unsigned check_recovered (block_t *block)
+{
+    unsigned count = 0;
+
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+        unsigned i = (uint16_t)(GetWBE (block->p_buffer + 2) - BASE);
+
+        assert (i < COLS * ROWS);
+        assert (block->i_buffer == media[i]->i_buffer);
+        assert (!memcmp (block->p_buffer, media[i]->p_buffer,
+                         block->i_buffer));
+        block_Release (block);
+        block = next;
+        count++;
+    }
+    return count;
+}
+
+static bool lost (unsigned i)
+{   /* L-shaped loss: one row and one column have two losses each */
+    return i == 0 || i == 1 || i == COLS;
+}
+
+int main (void)
+{
+    for (unsigned i = 0; i < COLS * ROWS; i++)
+        media[i] = media_packet (i);
+
+    rtp_fec_t *fec = rtp_fec_create ();
+    assert (fec != NULL);
+
+    for (unsigned i = 0; i < COLS * ROWS; i++)
+        if (!lost (i))
+            rtp_fec_record (fec, media[i]);
+
+    /* Neither the first row nor the first column can be repaired alone */
+    assert (rtp_fec_recover (fec, fec_packet (0, 1, COLS, true)) == NULL);
+    assert (rtp_fec_recover (fec, fec_packet (0, COLS, ROWS, false)) == NULL);
+
+    /* Nothing is missing from the last row */
+    assert (rtp_fec_recover (fec, fec_packet (COLS * (ROWS - 1), 1, COLS,
+                                              true)) == NULL);
+
+    /* The second column restores packet 1, which completes the first row,
+     * which in turn completes the first column. */
+    unsigned n = check_recovered (rtp_fec_recover (fec,
+                                            fec_packet (1, COLS, ROWS, false)));
+    assert (n == 3);
+
+    /* Repeated FEC packets are useless now */
+    assert (rtp_fec_recover (fec, fec_packet (0, 1, COLS, true)) == NULL);
+
+    /* Truncated FEC packet */
+    block_t *bad = fec_packet (0, COLS, ROWS, false);
+    bad->i_buffer = 20;
+    assert (rtp_fec_recover (fec, bad) == NULL);
+
+    rtp_fec_destroy (fec);
+
+    for (unsigned i = 0; i < COLS * ROWS; i++)
+        block_Release (media[i]);
+    return 0;
+}
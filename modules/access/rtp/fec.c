@@ -0,0 +1,303 @@
+/**
+ * @file fec.c
+ * @brief RTP forward error correction (SMPTE 2022-1)
+ */
+/*****************************************************************************
+ * Copyright © 2021 VLC authors and VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ ****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#include "fec.h"
+
+#define FEC_HISTORY 1024 /* must be a power of two */
+#define FEC_PACKET_MAX 1500
+#define FEC_PENDING_MAX 64
+#define FEC_HEADER_SIZE 16
+
+struct rtp_fec_packet
+{
+    bool     valid;
+    uint16_t seq;
+    uint16_t len;
+    uint8_t  data[FEC_PACKET_MAX];
+};
+
+struct rtp_fec_t
+{
+    block_t  *pending; /* FEC packets waiting for more media packets */
+    unsigned  pending_count;
+    uint16_t  last_seq; /* most recent media sequence number */
+    bool      started;
+    struct rtp_fec_packet history[FEC_HISTORY];
+};
+
+/** Parsed FEC header (see also IETF RFC 2733) */
+struct rtp_fec_info
+{
+    uint16_t snbase;
+    uint16_t length_recovery;
+    uint8_t  pt_recovery;
+    uint32_t ts_recovery;
+    uint8_t  offset;
+    uint8_t  na;
+    uint8_t  byte0; /* P, X, CC recovery */
+    uint8_t  byte1; /* M recovery */
+    const uint8_t *payload;
+    size_t   payload_len;
+};
+
+rtp_fec_t *rtp_fec_create (void)
+{
+    rtp_fec_t *fec = malloc (sizeof (*fec));
+    if (fec == NULL)
+        return NULL;
+
+    fec->pending = NULL;
+    fec->pending_count = 0;
+    fec->started = false;
+    for (unsigned i = 0; i < FEC_HISTORY; i++)
+        fec->history[i].valid = false;
+    return fec;
+}
+
+void rtp_fec_destroy (rtp_fec_t *fec)
+{
+    block_ChainRelease (fec->pending);
+    free (fec);
+}
+
+static const struct rtp_fec_packet *
+rtp_fec_lookup (const rtp_fec_t *fec, uint16_t seq)
+{
+    const struct rtp_fec_packet *pkt = &fec->history[seq % FEC_HISTORY];
+
+    return (pkt->valid && pkt->seq == seq) ? pkt : NULL;
+}
+
+void rtp_fec_record (rtp_fec_t *fec, const block_t *block)
+{
+    if (block->i_buffer < 12 || block->i_buffer > FEC_PACKET_MAX)
+        return;
+
+    uint16_t seq = GetWBE (block->p_buffer + 2);
+    struct rtp_fec_packet *pkt = &fec->history[seq % FEC_HISTORY];
+
+    pkt->valid = true;
+    pkt->seq = seq;
+    pkt->len = block->i_buffer;
+    memcpy (pkt->data, block->p_buffer, block->i_buffer);
+
+    if (!fec->started || (int16_t)(seq - fec->last_seq) > 0)
+        fec->last_seq = seq;
+    fec->started = true;
+}
+
+static int rtp_fec_parse (const block_t *block, struct rtp_fec_info *info)
+{
+    const uint8_t *buf = block->p_buffer;
+    size_t skip = 12;
+
+    if (block->i_buffer < skip)
+        return -1;
+
+    skip += (buf[0] & 0x0F) * 4; /* CSRC */
+    if (buf[0] & 0x10) /* RTP header extension */
+    {
+        if (block->i_buffer < skip + 4)
+            return -1;
+        skip += 4 + 4 * GetWBE (buf + skip + 2);
+    }
+    if (block->i_buffer < skip + FEC_HEADER_SIZE)
+        return -1;
+
+    const uint8_t *p = buf + skip;
+
+    if (p[12] & 0x80) /* FEC header extension */
+        return -1;
+    if ((p[12] & 0x3F) != 0) /* XOR type, index 0 */
+        return -1;
+    if (p[13] == 0 || p[14] == 0)
+        return -1;
+
+    info->snbase = GetWBE (p);
+    info->length_recovery = GetWBE (p + 2);
+    info->pt_recovery = p[4] & 0x7F;
+    info->ts_recovery = GetDWBE (p + 8);
+    info->offset = p[13];
+    info->na = p[14];
+    info->byte0 = buf[0];
+    info->byte1 = buf[1];
+    info->payload = p + FEC_HEADER_SIZE;
+    info->payload_len = block->i_buffer - skip - FEC_HEADER_SIZE;
+    return 0;
+}
+
+/**
+ * Tries to restore the media packet protected by a FEC packet.
+ *
+ * @return 0 if the FEC packet is no longer needed, 1 to try again later
+ */
+static int rtp_fec_try (rtp_fec_t *fec, const block_t *block,
+                        block_t **restrict recovered)
+{
+    struct rtp_fec_info info;
+    unsigned missing = 0;
+    uint16_t lost = 0;
+
+    *recovered = NULL;
+
+    if (rtp_fec_parse (block, &info))
+        return 0;
+
+    for (unsigned i = 0; i < info.na; i++)
+    {
+        uint16_t seq = info.snbase + i * info.offset;
+
+        if (rtp_fec_lookup (fec, seq) == NULL)
+        {
+            missing++;
+            lost = seq;
+        }
+    }
+
+    if (missing == 0)
+        return 0; /* nothing to repair */
+
+    /* Give up if the protected packets are too old */
+    uint16_t last = info.snbase + (info.na - 1) * info.offset;
+    if (fec->started && (int16_t)(fec->last_seq - last) > FEC_HISTORY / 2)
+        return 0;
+
+    if (missing > 1)
+        return 1;
+
+    uint16_t len = info.length_recovery;
+    uint8_t byte0 = info.byte0, byte1 = info.byte1, pt = info.pt_recovery;
+    uint32_t ts = info.ts_recovery, ssrc = 0;
+
+    for (unsigned i = 0; i < info.na; i++)
+    {
+        const struct rtp_fec_packet *pkt =
+            rtp_fec_lookup (fec, info.snbase + i * info.offset);
+        if (pkt == NULL)
+            continue;
+
+        len ^= pkt->len - 12;
+        byte0 ^= pkt->data[0];
+        byte1 ^= pkt->data[1];
+        pt ^= pkt->data[1] & 0x7F;
+        ts ^= GetDWBE (pkt->data + 4);
+        ssrc = GetDWBE (pkt->data + 8);
+    }
+
+    if (len > info.payload_len || 12u + len > FEC_PACKET_MAX)
+        return 0; /* corrupt FEC packet */
+
+    block_t *rec = block_Alloc (12 + len);
+    if (unlikely(rec == NULL))
+        return 0;
+
+    uint8_t *buf = rec->p_buffer;
+
+    buf[0] = 0x80 | (byte0 & 0x3F);
+    buf[1] = (byte1 & 0x80) | (pt & 0x7F);
+    SetWBE (buf + 2, lost);
+    SetDWBE (buf + 4, ts);
+    SetDWBE (buf + 8, ssrc);
+    memcpy (buf + 12, info.payload, len);
+
+    for (unsigned i = 0; i < info.na; i++)
+    {
+        const struct rtp_fec_packet *pkt =
+            rtp_fec_lookup (fec, info.snbase + i * info.offset);
+        if (pkt == NULL)
+            continue;
+
+        size_t n = __MIN((size_t)(pkt->len - 12), (size_t)len);
+        for (size_t j = 0; j < n; j++)
+            buf[12 + j] ^= pkt->data[12 + j];
+    }
+
+    rtp_fec_record (fec, rec);
+    *recovered = rec;
+    return 0;
+}
+
+block_t *rtp_fec_recover (rtp_fec_t *fec, block_t *block)
+{
+    block_t *out = NULL, **tailp = &out;
+
+    /* Queue the FEC packet, dropping the oldest one if needed */
+    if (fec->pending_count >= FEC_PENDING_MAX)
+    {
+        block_t *old = fec->pending;
+
+        fec->pending = old->p_next;
+        fec->pending_count--;
+        block_Release (old);
+    }
+
+    block_t **pp = &fec->pending;
+    while (*pp != NULL)
+        pp = &(*pp)->p_next;
+    block->p_next = NULL;
+    *pp = block;
+    fec->pending_count++;
+
+    /* Restoring a packet can complete another row or column: iterate */
+    bool progress;
+    do
+    {
+        progress = false;
+        pp = &fec->pending;
+
+        while (*pp != NULL)
+        {
+            block_t *fecblock = *pp, *rec;
+
+            if (rtp_fec_try (fec, fecblock, &rec) > 0)
+            {
+                pp = &fecblock->p_next;
+                continue;
+            }
+
+            *pp = fecblock->p_next;
+            fec->pending_count--;
+            block_Release (fecblock);
+
+            if (rec != NULL)
+            {
+                *tailp = rec;
+                tailp = &rec->p_next;
+                progress = true;
+            }
+        }
+    }
+    while (progress);
+
+    return out;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file fec.h
+ * @brief RTP forward error correction (SMPTE 2022-1) declarations
+ */
+/*****************************************************************************
+ * Copyright © 2021 VLC authors and VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ ****************************************************************************/
+
+#ifndef VLC_RTP_FEC_H
+# define VLC_RTP_FEC_H 1
+
+typedef struct rtp_fec_t rtp_fec_t;
+
+/**
+ * Creates a FEC decoder.
+ *
+ * The decoder keeps copies of the recent media packets: the XOR parity of
+ * a row or a column of the FEC matrix can restore one missing packet.
+ */
+rtp_fec_t *rtp_fec_create (void);
+void rtp_fec_destroy (rtp_fec_t *);
+
+/**
+ * Records a received media RTP packet (with its RTP header).
+ */
+void rtp_fec_record (rtp_fec_t *, const block_t *);
+
+/**
+ * Processes a row or column FEC packet (with its RTP header).
+ *
+ * FEC packets that cannot be used yet, because too many of their media
+ * packets are missing, are kept and tried again later.
+ *
+ * @param block FEC packet (always consumed)
+ * @return a chain of restored media RTP packets, or NULL if none
+ */
+block_t *rtp_fec_recover (rtp_fec_t *, block_t *block);
+
+#endif
@@ -40,6 +40,7 @@
 #endif
 
 #include "rtp.h"
+#include "fec.h"
 #ifdef HAVE_SRTP
 # include "srtp.h"
 #endif
@@ -59,6 +60,10 @@ static void rtp_process (demux_t *demux, block_t *block)
     if (ptype >= 72 && ptype <= 76)
         goto drop; /* Muxed RTCP, ignore for now FIXME */
 
+    /* Keep a copy as received, the FEC protects the packet on the wire */
+    if (sys->fec != NULL)
+        rtp_fec_record (sys->fec, block);
+
 #ifdef HAVE_SRTP
     if (sys->srtp != NULL)
     {
@@ -85,6 +90,37 @@ drop:
     block_Release (block);
 }
 
+/**
+ * Receives a packet from a FEC socket and restores lost RTP packets.
+ */
+static void rtp_fec_process (demux_t *demux, int fd)
+{
+    demux_sys_t *sys = demux->p_sys;
+    block_t *block = block_Alloc (DEFAULT_MRU);
+    if (unlikely(block == NULL))
+        return;
+
+    ssize_t len = recv (fd, block->p_buffer, block->i_buffer, 0);
+    if (len == -1)
+    {
+        block_Release (block);
+        return;
+    }
+    block->i_buffer = len;
+
+    block = rtp_fec_recover (sys->fec, block);
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = NULL;
+        msg_Dbg (demux, "recovered RTP packet %"PRIu16,
+                 GetWBE (block->p_buffer + 2));
+        rtp_process (demux, block);
+        block = next;
+    }
+}
+
 static int rtp_timeout (vlc_tick_t deadline)
 {
     if (deadline == VLC_TICK_INVALID)
@@ -125,13 +161,21 @@ void *rtp_dgram_thread (void *opaque)
         .msg_iovlen = 1,
     };
 
-    struct pollfd ufd[1];
+    struct pollfd ufd[3];
+    unsigned nfd = 1;
     ufd[0].fd = rtp_fd;
     ufd[0].events = POLLIN;
+    for (unsigned i = 0; i < 2; i++)
+        if (sys->fec_fd[i] != -1)
+        {
+            ufd[nfd].fd = sys->fec_fd[i];
+            ufd[nfd].events = POLLIN;
+            nfd++;
+        }
 
     for (;;)
     {
-        int n = poll (ufd, 1, rtp_timeout (deadline));
+        int n = poll (ufd, nfd, rtp_timeout (deadline));
         if (n == -1)
             continue;
 
@@ -180,6 +224,10 @@ void *rtp_dgram_thread (void *opaque)
             }
         }
 
+        for (unsigned i = 1; i < nfd; i++)
+            if (ufd[i].revents)
+                rtp_fec_process (demux, ufd[i].fd);
+
     dequeue:
         if (!rtp_dequeue (demux, sys->session, &deadline))
             deadline = VLC_TICK_INVALID;
@@ -35,6 +35,7 @@
 #include <vlc_aout.h> /* aout_FormatPrepare() */
 
 #include "rtp.h"
+#include "fec.h"
 #ifdef HAVE_SRTP
 # include "srtp.h"
 # include <gcrypt.h>
@@ -55,7 +56,30 @@
 #define SRTP_SALT_TEXT N_("SRTP salt (hexadecimal)")
 #define SRTP_SALT_LONGTEXT N_( \
     "Secure RTP requires a (non-secret) master salt value. " \
-    "This must be a 28-character-long hexadecimal string.")
+    "This must be a 28-character-long hexadecimal string " \
+    "(24 characters with AES-GCM).")
+
+#define SRTP_SUITE_TEXT N_("SRTP crypto suite")
+#define SRTP_SUITE_LONGTEXT N_( \
+    "Cipher and authentication of the Secure RTP packets. AES-GCM " \
+    "encrypts and authenticates in a single pass.")
+
+#ifdef HAVE_SRTP
+static const char *const srtp_suite_list[] = {
+    "AES_CM_128_HMAC_SHA1_80", "AEAD_AES_128_GCM" };
+static const char *const srtp_suite_list_text[] = {
+    N_("AES counter mode with HMAC-SHA1"), N_("AES-GCM") };
+#endif
+
+#define RTP_FEC_TEXT N_("SMPTE 2022-1 forward error correction")
+#define RTP_FEC_LONGTEXT N_( \
+    "Lost RTP packets will be recovered from the column and row FEC " \
+    "streams, received on the RTP port plus two and plus four.")
+
+#define RTP_FEC_LATENCY_TEXT N_("FEC latency (ms)")
+#define RTP_FEC_LATENCY_LONGTEXT N_( \
+    "How long to wait for FEC packets before a lost RTP packet is skipped. " \
+    "This should cover the duration of the FEC matrix.")
 
 #define RTP_MAX_SRC_TEXT N_("Maximum RTP sources")
 #define RTP_MAX_SRC_LONGTEXT N_( \
@@ -110,7 +134,15 @@ vlc_module_begin ()
     add_string ("srtp-salt", "",
                 SRTP_SALT_TEXT, SRTP_SALT_LONGTEXT, false)
         change_safe ()
+    add_string ("srtp-suite", "AES_CM_128_HMAC_SHA1_80",
+                SRTP_SUITE_TEXT, SRTP_SUITE_LONGTEXT, true)
+        change_string_list (srtp_suite_list, srtp_suite_list_text)
+        change_safe ()
 #endif
+    add_bool ("rtp-fec", false, RTP_FEC_TEXT, RTP_FEC_LONGTEXT, true)
+    add_integer ("rtp-fec-latency", 100, RTP_FEC_LATENCY_TEXT,
+                 RTP_FEC_LATENCY_LONGTEXT, true)
+        change_integer_range (0, 10000)
     add_integer ("rtp-max-src", 1, RTP_MAX_SRC_TEXT,
                  RTP_MAX_SRC_LONGTEXT, true)
         change_integer_range (1, 255)
@@ -209,6 +241,7 @@ static int Open (vlc_object_t *obj)
 
     /* Try to connect */
     int fd = -1, rtcp_fd = -1;
+    int fec_fd[2] = { -1, -1 };
 
     switch (tp)
     {
@@ -219,6 +252,13 @@ static int Open (vlc_object_t *obj)
                 break;
             if (rtcp_dport > 0) /* XXX: source port is unknown */
                 rtcp_fd = net_OpenDgram (obj, dhost, rtcp_dport, shost, 0, tp);
+            if (var_CreateGetBool (obj, "rtp-fec") && dport <= 65531)
+            {   /* SMPTE 2022-1 column and row FEC streams */
+                fec_fd[0] = net_OpenDgram (obj, dhost, dport + 2, shost, 0, tp);
+                fec_fd[1] = net_OpenDgram (obj, dhost, dport + 4, shost, 0, tp);
+                if (fec_fd[0] == -1 && fec_fd[1] == -1)
+                    msg_Warn (obj, "cannot receive FEC streams");
+            }
             break;
 
          case IPPROTO_DCCP:
@@ -253,6 +293,9 @@ static int Open (vlc_object_t *obj)
         net_Close (fd);
         if (rtcp_fd != -1)
             net_Close (rtcp_fd);
+        for (unsigned i = 0; i < 2; i++)
+            if (fec_fd[i] != -1)
+                net_Close (fec_fd[i]);
         return VLC_EGENERIC;
     }
 
@@ -262,6 +305,10 @@ static int Open (vlc_object_t *obj)
 #endif
     p_sys->fd           = fd;
     p_sys->rtcp_fd      = rtcp_fd;
+    p_sys->fec_fd[0]    = fec_fd[0];
+    p_sys->fec_fd[1]    = fec_fd[1];
+    p_sys->fec          = NULL;
+    p_sys->fec_latency  = 0;
     p_sys->max_src      = var_CreateGetInteger (obj, "rtp-max-src");
     p_sys->timeout      = vlc_tick_from_sec( var_CreateGetInteger (obj, "rtp-timeout") );
     p_sys->max_dropout  = var_CreateGetInteger (obj, "rtp-max-dropout");
@@ -277,13 +324,29 @@ static int Open (vlc_object_t *obj)
     if (p_sys->session == NULL)
         goto error;
 
+    if (fec_fd[0] != -1 || fec_fd[1] != -1)
+    {
+        p_sys->fec = rtp_fec_create ();
+        if (p_sys->fec == NULL)
+            goto error;
+        p_sys->fec_latency = VLC_TICK_FROM_MS(
+                                var_InheritInteger (obj, "rtp-fec-latency"));
+    }
+
 #ifdef HAVE_SRTP
     char *key = var_CreateGetNonEmptyString (demux, "srtp-key");
     if (key)
     {
         vlc_gcrypt_init ();
-        p_sys->srtp = srtp_create (SRTP_ENCR_AES_CM, SRTP_AUTH_HMAC_SHA1, 10,
-                                   SRTP_PRF_AES_CM, SRTP_RCC_MODE1);
+
+        char *suite = var_InheritString (demux, "srtp-suite");
+        if (suite != NULL && !strcmp (suite, "AEAD_AES_128_GCM"))
+            p_sys->srtp = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL,
+                                       SRTP_GCM_TAG_LEN, SRTP_PRF_AES_CM, 0);
+        else
+            p_sys->srtp = srtp_create (SRTP_ENCR_AES_CM, SRTP_AUTH_HMAC_SHA1,
+                                       10, SRTP_PRF_AES_CM, SRTP_RCC_MODE1);
+        free (suite);
         if (p_sys->srtp == NULL)
         {
             free (key);
@@ -336,6 +399,11 @@ static void Close (vlc_object_t *obj)
 #endif
     if (p_sys->session)
         rtp_session_destroy (demux, p_sys->session);
+    if (p_sys->fec != NULL)
+        rtp_fec_destroy (p_sys->fec);
+    for (unsigned i = 0; i < 2; i++)
+        if (p_sys->fec_fd[i] != -1)
+            net_Close (p_sys->fec_fd[i]);
     if (p_sys->rtcp_fd != -1)
         net_Close (p_sys->rtcp_fd);
     net_Close (p_sys->fd);
@@ -71,9 +71,12 @@ typedef struct
 #endif
     int           fd;
     int           rtcp_fd;
+    int           fec_fd[2]; /**< Column and row FEC sockets (or -1) */
+    struct rtp_fec_t *fec;
     vlc_thread_t  thread;
 
     vlc_tick_t    timeout;
+    vlc_tick_t    fec_latency; /**< Extra reordering delay for FEC */
     uint16_t      max_dropout; /**< Max packet forward misordering */
     uint16_t      max_misorder; /**< Max packet backward misordering */
     uint8_t       max_src; /**< Max simultaneous RTP sources */
@@ -393,6 +393,7 @@ static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *);
 bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
                   vlc_tick_t *restrict deadlinep)
 {
+    demux_sys_t *p_sys = demux->p_sys;
     vlc_tick_t now = vlc_tick_now ();
     bool pending = false;
 
@@ -440,6 +441,9 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
             /* Make sure we wait at least for 25 msec */
             if (deadline < VLC_TICK_FROM_MS(25))
                 deadline = VLC_TICK_FROM_MS(25);
+            /* and long enough for the FEC to restore the missing packet */
+            if (deadline < p_sys->fec_latency)
+                deadline = p_sys->fec_latency;
 
             /* Additionnaly, we implicitly wait for the packetization time
              * multiplied by the number of missing packets. block is the first
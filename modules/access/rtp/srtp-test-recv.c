@@ -166,6 +166,103 @@ int main (void)
     assert (val == EACCES);
     assert (len == 0x10c);
 
+    srtp_destroy (se);
+    srtp_destroy (sd);
+
+    /* AES-GCM requires its own tag length and no separate authentication */
+    se = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_HMAC_SHA1, 16,
+                      SRTP_PRF_AES_CM, 0);
+    assert (se == NULL);
+    se = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, 10,
+                      SRTP_PRF_AES_CM, 0);
+    assert (se == NULL);
+
+    se = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, SRTP_GCM_TAG_LEN,
+                      SRTP_PRF_AES_CM, 0);
+    assert (se != NULL);
+    sd = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, SRTP_GCM_TAG_LEN,
+                      SRTP_PRF_AES_CM, 0);
+    assert (sd != NULL);
+
+    /* AES-GCM master salt is 96 bits */
+    val = srtp_setkeystring (se, key, salt);
+    assert (val == EINVAL);
+
+    static const char gcm_salt[] = "1234567890" "1234567890" "1234";
+    val = srtp_setkeystring (se, key, gcm_salt);
+    assert (val == 0);
+    val = srtp_setkeystring (sd, key, gcm_salt);
+    assert (val == 0);
+
+    /* Too small buffer (seq=1) */
+    len = 20;
+    memset (buf, 0, len);
+    buf[0] = 0x80;
+    buf[3] = 1;
+    val = srtp_send (se, buf, &len, 35);
+    assert (val == ENOSPC);
+    assert (len == 36);
+
+    /* OK (seq=3) */
+    buf[0] = 0x80;
+    buf[3] = 3;
+    for (unsigned i = 0; i < 256; i++)
+        buf[i + 12] = i;
+    len = 0x10c;
+    val = srtp_send (se, buf, &len, sizeof (buf));
+    assert (val == 0);
+    assert (len == 0x10c + SRTP_GCM_TAG_LEN);
+
+    memcpy (buf2, buf, len);
+    val = srtp_recv (sd, buf2, &len);
+    assert (val == 0);
+    assert (len == 0x10c);
+    for (unsigned i = 0; i < 256; i++)
+        assert (buf2[i + 12] == i); // test actual decryption
+
+    /* Replay attack (seq=3) */
+    len = 0x10c + SRTP_GCM_TAG_LEN;
+    memcpy (buf2, buf, len);
+    val = srtp_recv (sd, buf2, &len);
+    assert (val == EACCES);
+
+    /* Tampered header (seq=4) */
+    buf[0] = 0x80;
+    buf[3] = 4;
+    for (unsigned i = 0; i < 256; i++)
+        buf[i + 12] = i;
+    len = 0x10c;
+    val = srtp_send (se, buf, &len, sizeof (buf));
+    assert (val == 0);
+    buf[1] ^= 1;
+    val = srtp_recv (sd, buf, &len);
+    assert (val == EACCES);
+
+    /* SRTCP round trip */
+    len = 28;
+    memset (buf, 0, len);
+    buf[0] = 0x80;
+    buf[1] = 200;
+    for (unsigned i = 8; i < 28; i++)
+        buf[i] = i;
+    val = srtcp_send (se, buf, &len, 47);
+    assert (val == ENOSPC);
+    val = srtcp_send (se, buf, &len, sizeof (buf));
+    assert (val == 0);
+    assert (len == 28 + SRTP_GCM_TAG_LEN + 4);
+
+    memcpy (buf2, buf, len);
+    val = srtcp_recv (sd, buf2, &len);
+    assert (val == 0);
+    assert (len == 28);
+    for (unsigned i = 8; i < 28; i++)
+        assert (buf2[i] == i);
+
+    /* SRTCP replay attack */
+    len = 28 + SRTP_GCM_TAG_LEN + 4;
+    val = srtcp_recv (sd, buf, &len);
+    assert (val == EACCES);
+
     srtp_destroy (se);
     srtp_destroy (sd);
     return 0;
@@ -66,6 +66,7 @@ struct srtp_session_t
     uint16_t rtp_seq;
     uint16_t rtp_rcc;
     uint8_t  tag_len;
+    bool     aead; /* AES-GCM: the cipher authenticates the packets */
 };
 
 enum
@@ -105,9 +106,9 @@ void srtp_destroy (srtp_session_t *s)
 }
 
 
-static int proto_create (srtp_proto_t *p, int gcipher, int gmd)
+static int proto_create (srtp_proto_t *p, int gcipher, int gmode, int gmd)
 {
-    if (gcry_cipher_open (&p->cipher, gcipher, GCRY_CIPHER_MODE_CTR, 0) == 0)
+    if (gcry_cipher_open (&p->cipher, gcipher, gmode, 0) == 0)
     {
         if (gcry_md_open (&p->mac, gmd, GCRY_MD_FLAG_HMAC) == 0)
             return 0;
@@ -128,6 +129,9 @@ static int proto_create (srtp_proto_t *p, int gcipher, int gmd)
  * @param tag_len authentication tag byte length (NOT including RCC)
  * @param flags OR'ed optional flags.
  *
+ * AES-GCM authenticates the packets itself: it requires SRTP_AUTH_NULL,
+ * a tag length of SRTP_GCM_TAG_LEN bytes, and no flags.
+ *
  * @return NULL in case of error
  */
 srtp_session_t *
@@ -136,7 +140,7 @@ srtp_create (int encr, int auth, unsigned tag_len, int prf, unsigned flags)
     if ((flags & ~SRTP_FLAGS_MASK))
         return NULL;
 
-    int cipher, md;
+    int cipher, mode = GCRY_CIPHER_MODE_CTR, md;
     switch (encr)
     {
         case SRTP_ENCR_NULL:
@@ -147,6 +151,14 @@ srtp_create (int encr, int auth, unsigned tag_len, int prf, unsigned flags)
             cipher = GCRY_CIPHER_AES;
             break;
 
+        case SRTP_ENCR_AES_GCM:
+            if (auth != SRTP_AUTH_NULL || tag_len != SRTP_GCM_TAG_LEN
+             || flags != 0)
+                return NULL;
+            cipher = GCRY_CIPHER_AES;
+            mode = GCRY_CIPHER_MODE_GCM;
+            break;
+
         default:
             return NULL;
     }
@@ -165,7 +177,7 @@ srtp_create (int encr, int auth, unsigned tag_len, int prf, unsigned flags)
             return NULL;
     }
 
-    if (tag_len > gcry_md_get_algo_dlen (md))
+    if (mode != GCRY_CIPHER_MODE_GCM && tag_len > gcry_md_get_algo_dlen (md))
         return NULL;
 
     if (prf != SRTP_PRF_AES_CM)
@@ -179,15 +191,16 @@ srtp_create (int encr, int auth, unsigned tag_len, int prf, unsigned flags)
     s->flags = flags;
     s->tag_len = tag_len;
     s->rtp_rcc = 1; /* Default RCC rate */
+    s->aead = mode == GCRY_CIPHER_MODE_GCM;
     if (rcc_mode (s))
     {
         if (tag_len < 4)
             goto error;
     }
 
-    if (proto_create (&s->rtp, cipher, md) == 0)
+    if (proto_create (&s->rtp, cipher, mode, md) == 0)
     {
-        if (proto_create (&s->rtcp, cipher, md) == 0)
+        if (proto_create (&s->rtcp, cipher, mode, md) == 0)
             return s;
         proto_destroy (&s->rtp);
     }
@@ -205,26 +218,49 @@ error:
 static int
 do_ctr_crypt (gcry_cipher_hd_t hd, const void *ctr, uint8_t *data, size_t len)
 {
-    const size_t ctrlen = 16;
-    div_t d = div (len, ctrlen);
-
-    if (gcry_cipher_setctr (hd, ctr, ctrlen)
-     || gcry_cipher_encrypt (hd, data, d.quot * ctrlen, NULL, 0))
+    /* The CTR mode of libgcrypt handles the truncated last block itself:
+     * a single call lets it process the whole packet in parallel. */
+    if (gcry_cipher_setctr (hd, ctr, 16)
+     || gcry_cipher_encrypt (hd, data, len, NULL, 0))
         return -1;
 
-    if (d.rem)
-    {
-        /* Truncated last block */
-        uint8_t dummy[ctrlen];
-        data += d.quot * ctrlen;
-        memcpy (dummy, data, d.rem);
-        memset (dummy + d.rem, 0, ctrlen - d.rem);
+    return 0;
+}
 
-        if (gcry_cipher_encrypt (hd, dummy, ctrlen, data, ctrlen))
-            return -1;
-        memcpy (data, dummy, d.rem);
-    }
 
+/**
+ * Galois/Counter Mode authenticated encryption/decryption (IV = 12 bytes,
+ * tag = SRTP_GCM_TAG_LEN bytes)
+ *
+ * @param aad additional authenticated (but not encrypted) data
+ * @param tag authentication tag, written when encrypting, checked otherwise
+ *
+ * @return 0 on success, in case of error:
+ *  EINVAL  internal error
+ *  EACCES  authentication failed
+ */
+static int
+do_gcm_crypt (gcry_cipher_hd_t hd, const uint8_t *iv, const void *aad,
+              size_t aadlen, uint8_t *data, size_t len, uint8_t *tag,
+              bool encrypt)
+{
+    if (gcry_cipher_setiv (hd, iv, 12)
+     || gcry_cipher_authenticate (hd, aad, aadlen))
+        return EINVAL;
+
+    if (encrypt)
+    {
+        if (gcry_cipher_encrypt (hd, data, len, NULL, 0)
+         || gcry_cipher_gettag (hd, tag, SRTP_GCM_TAG_LEN))
+            return EINVAL;
+    }
+    else
+    {
+        if (gcry_cipher_decrypt (hd, data, len, NULL, 0))
+            return EINVAL;
+        if (gcry_cipher_checktag (hd, tag, SRTP_GCM_TAG_LEN))
+            return EACCES;
+    }
     return 0;
 }
 
@@ -268,11 +304,15 @@ srtp_setkey (srtp_session_t *s, const void *key, size_t keylen,
 {
     /* SRTP/SRTCP cipher/salt/MAC keys derivation */
     gcry_cipher_hd_t prf;
-    uint8_t r[6], keybuf[20];
+    uint8_t r[6], keybuf[20], msalt[14];
 
-    if (saltlen != 14)
+    if (saltlen != (s->aead ? 12 : 14))
         return EINVAL;
 
+    /* The AES-GCM master salt is zero-padded for the PRF (RFC 7714 §11) */
+    memcpy (msalt, salt, saltlen);
+    memset (msalt + saltlen, 0, sizeof (msalt) - saltlen);
+
     if (gcry_cipher_open (&prf, GCRY_CIPHER_AES, GCRY_CIPHER_MODE_CTR, 0)
      || gcry_cipher_setkey (prf, key, keylen))
         return EINVAL;
@@ -293,20 +333,22 @@ srtp_setkey (srtp_session_t *s, const void *key, size_t keylen,
     else
 #endif
         memset (r, 0, sizeof (r));
-    if (do_derive (prf, salt, r, 6, SRTP_CRYPT, keybuf, 16)
+    if (do_derive (prf, msalt, r, 6, SRTP_CRYPT, keybuf, 16)
      || gcry_cipher_setkey (s->rtp.cipher, keybuf, 16)
-     || do_derive (prf, salt, r, 6, SRTP_AUTH, keybuf, 20)
-     || gcry_md_setkey (s->rtp.mac, keybuf, 20)
-     || do_derive (prf, salt, r, 6, SRTP_SALT, s->rtp.salt, 14))
+     || (!s->aead
+      && (do_derive (prf, msalt, r, 6, SRTP_AUTH, keybuf, 20)
+       || gcry_md_setkey (s->rtp.mac, keybuf, 20)))
+     || do_derive (prf, msalt, r, 6, SRTP_SALT, s->rtp.salt, saltlen))
         return -1;
 
     /* SRTCP key derivation */
     memcpy (r, &(uint32_t){ htonl (s->rtcp_index) }, 4);
-    if (do_derive (prf, salt, r, 4, SRTCP_CRYPT, keybuf, 16)
+    if (do_derive (prf, msalt, r, 4, SRTCP_CRYPT, keybuf, 16)
      || gcry_cipher_setkey (s->rtcp.cipher, keybuf, 16)
-     || do_derive (prf, salt, r, 4, SRTCP_AUTH, keybuf, 20)
-     || gcry_md_setkey (s->rtcp.mac, keybuf, 20)
-     || do_derive (prf, salt, r, 4, SRTCP_SALT, s->rtcp.salt, 14))
+     || (!s->aead
+      && (do_derive (prf, msalt, r, 4, SRTCP_AUTH, keybuf, 20)
+       || gcry_md_setkey (s->rtcp.mac, keybuf, 20)))
+     || do_derive (prf, msalt, r, 4, SRTCP_SALT, s->rtcp.salt, saltlen))
         return -1;
 
     (void)gcry_cipher_close (prf);
@@ -447,26 +489,17 @@ rtp_digest (gcry_md_hd_t md, const uint8_t *data, size_t len,
 
 
 /**
- * Encrypts/decrypts a RTP packet and updates SRTP context
- * (CTR block cypher mode of operation has identical encryption and
- * decryption function).
- *
- * @param buf RTP packet to be en-/decrypted
- * @param len RTP packet length
+ * Computes the offset of the RTP payload (after the CSRC and extension).
  *
- * @return 0 on success, in case of error:
- *  EINVAL  malformatted RTP packet
- *  EACCES  replayed packet or out-of-window or sync lost
+ * @return the offset, or -1 if the RTP packet is malformatted
  */
-static int srtp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
+static int rtp_payload_offset (const uint8_t *buf, size_t len)
 {
-    assert (s != NULL);
     assert (len >= 12u);
 
     if ((buf[0] >> 6) != 2)
-        return EINVAL;
+        return -1;
 
-    /* Computes encryption offset */
     uint16_t offset = 12;
     offset += (buf[0] & 0xf) * 4; // skips CSRC
 
@@ -476,37 +509,76 @@ static int srtp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
 
         offset += 4;
         if (len < offset)
-            return EINVAL;
+            return -1;
 
         memcpy (&extlen, buf + offset - 2, 2);
         offset += htons (extlen); // skips RTP extension header
     }
 
     if (len < offset)
-        return EINVAL;
+        return -1;
+    return offset;
+}
 
-    /* Determines RTP 48-bits counter and SSRC */
-    uint16_t seq = rtp_seq (buf);
-    uint32_t roc = srtp_compute_roc (s, seq), ssrc;
-    memcpy (&ssrc, buf + 8, 4);
 
-    /* Updates ROC and sequence (it's safe now) */
+/** Checks a RTP sequence number against the replay window */
+static bool srtp_replayed (const srtp_session_t *s, uint16_t seq)
+{
+    int16_t diff = seq - s->rtp_seq;
+    if (diff > 0)
+        return false; /* Sequence in the future, good */
+
+    /* Sequence in the past/present, bad */
+    unsigned back = -(int)diff;
+    return (back >= 64) || ((s->rtp.window >> back) & 1);
+}
+
+
+/** Updates ROC, sequence and replay window with an accepted packet */
+static void srtp_accept (srtp_session_t *s, uint16_t seq, uint32_t roc)
+{
     int16_t diff = seq - s->rtp_seq;
     if (diff > 0)
     {
-        /* Sequence in the future, good */
-        s->rtp.window = s->rtp.window << diff;
+        s->rtp.window = (diff < 64) ? (s->rtp.window << diff) : 0;
         s->rtp.window |= UINT64_C(1);
         s->rtp_seq = seq, s->rtp_roc = roc;
     }
     else
-    {
-        /* Sequence in the past/present, bad */
-        diff = -diff;
-        if ((diff >= 64) || ((s->rtp.window >> diff) & 1))
-            return EACCES; /* Replay attack */
-        s->rtp.window |= UINT64_C(1) << diff;
-    }
+        s->rtp.window |= UINT64_C(1) << -(int)diff;
+}
+
+
+/**
+ * Encrypts/decrypts a RTP packet and updates SRTP context
+ * (CTR block cypher mode of operation has identical encryption and
+ * decryption function).
+ *
+ * @param buf RTP packet to be en-/decrypted
+ * @param len RTP packet length
+ *
+ * @return 0 on success, in case of error:
+ *  EINVAL  malformatted RTP packet
+ *  EACCES  replayed packet or out-of-window or sync lost
+ */
+static int srtp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
+{
+    assert (s != NULL);
+
+    /* Computes encryption offset */
+    int offset = rtp_payload_offset (buf, len);
+    if (offset < 0)
+        return EINVAL;
+
+    /* Determines RTP 48-bits counter and SSRC */
+    uint16_t seq = rtp_seq (buf);
+    uint32_t roc = srtp_compute_roc (s, seq), ssrc;
+    memcpy (&ssrc, buf + 8, 4);
+
+    /* Updates ROC and sequence (it's safe now) */
+    if (srtp_replayed (s, seq))
+        return EACCES; /* Replay attack */
+    srtp_accept (s, seq, roc);
 
     /* Encrypt/Decrypt */
     if (s->flags & SRTP_UNENCRYPTED)
@@ -520,6 +592,50 @@ static int srtp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
 }
 
 
+/**
+ * Encrypts and authenticates, or authenticates and decrypts a RTP packet
+ * with AES-GCM (RFC 7714), then updates SRTP context.
+ *
+ * @param buf RTP packet to be en-/decrypted, followed by the tag
+ * @param len RTP packet length (NOT including the tag)
+ *
+ * @return 0 on success, in case of error:
+ *  EINVAL  malformatted RTP packet
+ *  EACCES  authentication failed, replayed packet or out-of-window
+ */
+static int srtp_gcm_crypt (srtp_session_t *s, uint8_t *buf, size_t len,
+                           bool encrypt)
+{
+    int offset = rtp_payload_offset (buf, len);
+    if (offset < 0)
+        return EINVAL;
+
+    uint16_t seq = rtp_seq (buf);
+    uint32_t roc = srtp_compute_roc (s, seq);
+
+    if (srtp_replayed (s, seq))
+        return EACCES;
+
+    /* IV = (0x0000 || SSRC || ROC || SEQ) XOR salt */
+    const uint8_t *salt = (const uint8_t *)s->rtp.salt;
+    uint8_t iv[12];
+
+    iv[0] = iv[1] = 0;
+    memcpy (iv + 2, buf + 8, 4);
+    memcpy (iv + 6, &(uint32_t){ htonl (roc) }, 4);
+    memcpy (iv + 10, buf + 2, 2);
+    for (unsigned i = 0; i < sizeof (iv); i++)
+        iv[i] ^= salt[i];
+
+    /* The header is authenticated, the payload encrypted */
+    int val = do_gcm_crypt (s->rtp.cipher, iv, buf, offset, buf + offset,
+                            len - offset, buf + len, encrypt);
+    if (val == 0)
+        srtp_accept (s, seq, roc);
+    return val;
+}
+
+
 /**
  * Turns a RTP packet into a SRTP packet: encrypt it, then computes
  * the authentication tag and appends it.
@@ -547,6 +663,14 @@ srtp_send (srtp_session_t *s, uint8_t *buf, size_t *lenp, size_t bufsize)
     if (len < 12u)
         return EINVAL;
 
+    if (s->aead)
+    {
+        *lenp = len + SRTP_GCM_TAG_LEN;
+        if (bufsize < *lenp)
+            return ENOSPC;
+        return srtp_gcm_crypt (s, buf, len, true);
+    }
+
     if (!(s->flags & SRTP_UNAUTHENTICATED))
     {
         tag_len = s->tag_len;
@@ -626,6 +750,18 @@ srtp_recv (srtp_session_t *s, uint8_t *buf, size_t *lenp)
     if (len < 12u)
         return EINVAL;
 
+    if (s->aead)
+    {
+        if (len < 12u + SRTP_GCM_TAG_LEN)
+            return EINVAL;
+        len -= SRTP_GCM_TAG_LEN;
+
+        int val = srtp_gcm_crypt (s, buf, len, false);
+        if (val == 0)
+            *lenp = len;
+        return val;
+    }
+
     if (!(s->flags & SRTP_UNAUTHENTICATED))
     {
         size_t tag_len = s->tag_len, roc_len = 0;
@@ -764,6 +900,122 @@ static int srtcp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
 }
 
 
+/** Checks a SRTCP index against the replay window */
+static bool srtcp_replayed (const srtp_session_t *s, uint32_t index)
+{
+    int32_t diff = index - s->rtcp_index;
+    if (diff > 0)
+        return false; /* Packet in the future, good */
+
+    uint32_t back = s->rtcp_index - index;
+    return (back >= 64) || ((s->rtcp.window >> back) & 1);
+}
+
+
+/** Updates SRTCP index and replay window with an accepted packet */
+static void srtcp_accept (srtp_session_t *s, uint32_t index)
+{
+    int32_t diff = index - s->rtcp_index;
+    if (diff > 0)
+    {
+        s->rtcp.window = (diff < 64) ? (s->rtcp.window << diff) : 0;
+        s->rtcp.window |= UINT64_C(1);
+        s->rtcp_index = index;
+    }
+    else
+        s->rtcp.window |= UINT64_C(1) << (s->rtcp_index - index);
+}
+
+
+/**
+ * AES-GCM for RTCP (RFC 7714): computes the IV,
+ * (0x0000 || SSRC || 0x0000 || SRTCP index) XOR salt,
+ * and the additional authenticated data, header || E-bit || SRTCP index.
+ */
+static void srtcp_gcm_params (const srtp_session_t *s, const uint8_t *buf,
+                              uint32_t index, uint8_t *iv, uint8_t *aad)
+{
+    const uint8_t *salt = (const uint8_t *)s->rtcp.salt;
+
+    iv[0] = iv[1] = iv[6] = iv[7] = 0;
+    memcpy (iv + 2, buf + 4, 4);
+    memcpy (iv + 8, &(uint32_t){ htonl (index) }, 4);
+    for (unsigned i = 0; i < 12; i++)
+        iv[i] ^= salt[i];
+
+    memcpy (aad, buf, 8);
+    memcpy (aad + 8, &(uint32_t){ htonl (index | 0x80000000) }, 4);
+}
+
+
+/**
+ * Turns a RTCP packet into a SRTCP packet with AES-GCM: encrypt and
+ * authenticate it, then append the tag and the SRTCP index.
+ */
+static int
+srtcp_gcm_send (srtp_session_t *s, uint8_t *buf, size_t *lenp, size_t bufsize)
+{
+    size_t len = *lenp;
+
+    if ((len < 8) || ((buf[0] >> 6) != 2))
+        return EINVAL;
+    if (bufsize < (len + SRTP_GCM_TAG_LEN + 4))
+        return ENOSPC;
+
+    uint32_t index = ++s->rtcp_index;
+    if (index >> 31)
+        s->rtcp_index = index = 0; /* 31-bit wrap */
+
+    uint8_t iv[12], aad[12];
+    srtcp_gcm_params (s, buf, index, iv, aad);
+
+    int val = do_gcm_crypt (s->rtcp.cipher, iv, aad, sizeof (aad), buf + 8,
+                            len - 8, buf + len, true);
+    if (val)
+        return val;
+
+    memcpy (buf + len + SRTP_GCM_TAG_LEN, aad + 8, 4);
+    *lenp = len + SRTP_GCM_TAG_LEN + 4;
+    return 0;
+}
+
+
+/**
+ * Turns a SRTCP packet into a RTCP packet with AES-GCM: authenticate and
+ * decrypt it, then updates SRTCP context.
+ */
+static int srtcp_gcm_recv (srtp_session_t *s, uint8_t *buf, size_t *lenp)
+{
+    size_t len = *lenp;
+
+    if ((len < (8u + SRTP_GCM_TAG_LEN + 4)) || ((buf[0] >> 6) != 2))
+        return EINVAL;
+    len -= SRTP_GCM_TAG_LEN + 4;
+
+    uint32_t index;
+    memcpy (&index, buf + len + SRTP_GCM_TAG_LEN, 4);
+    index = ntohl (index);
+    if ((index >> 31) == 0)
+        return EINVAL; /* unencrypted SRTCP is not supported with AES-GCM */
+    index &= ~(1u << 31);
+
+    if (srtcp_replayed (s, index))
+        return EACCES; // replay attack!
+
+    uint8_t iv[12], aad[12];
+    srtcp_gcm_params (s, buf, index, iv, aad);
+
+    int val = do_gcm_crypt (s->rtcp.cipher, iv, aad, sizeof (aad), buf + 8,
+                            len - 8, buf + len, false);
+    if (val)
+        return val;
+
+    srtcp_accept (s, index);
+    *lenp = len;
+    return 0;
+}
+
+
 /**
  * Turns a RTCP packet into a SRTCP packet: encrypt it, then computes
  * the authentication tag and appends it.
@@ -780,6 +1032,9 @@ static int srtcp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
 int
 srtcp_send (srtp_session_t *s, uint8_t *buf, size_t *lenp, size_t bufsize)
 {
+    if (s->aead)
+        return srtcp_gcm_send (s, buf, lenp, bufsize);
+
     size_t len = *lenp;
     if (bufsize < (len + 4 + s->tag_len))
         return ENOSPC;
@@ -820,6 +1075,9 @@ srtcp_send (srtp_session_t *s, uint8_t *buf, size_t *lenp, size_t bufsize)
 int
 srtcp_recv (srtp_session_t *s, uint8_t *buf, size_t *lenp)
 {
+    if (s->aead)
+        return srtcp_gcm_recv (s, buf, lenp);
+
     size_t len = *lenp;
 
     if (len < (4u + s->tag_len))
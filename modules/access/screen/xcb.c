@@ -28,6 +28,9 @@
 #include <errno.h>
 #include <xcb/xcb.h>
 #include <xcb/composite.h>
+#ifdef HAVE_XCB_DAMAGE
+# include <xcb/damage.h>
+#endif
 #ifdef HAVE_SYS_SHM_H
 # include <sys/shm.h>
 # include <xcb/shm.h>
@@ -60,6 +63,11 @@
 #define FOLLOW_MOUSE_LONGTEXT N_( \
     "Follow the mouse when capturing a subscreen." )
 
+#define DAMAGE_TEXT N_("Capture changes only")
+#define DAMAGE_LONGTEXT N_( \
+    "Skip the frames where the captured content did not change, " \
+    "except for one frame per second.")
+
 static int  Open (vlc_object_t *);
 static void Close (vlc_object_t *);
 
@@ -89,6 +97,9 @@ vlc_module_begin ()
         change_safe ()
     add_bool ("screen-follow-mouse", false, FOLLOW_MOUSE_TEXT,
               FOLLOW_MOUSE_LONGTEXT, true)
+#ifdef HAVE_XCB_DAMAGE
+    add_bool ("screen-damage", true, DAMAGE_TEXT, DAMAGE_LONGTEXT, true)
+#endif
 
     add_shortcut ("screen", "window")
 vlc_module_end ()
@@ -118,6 +129,13 @@ typedef struct
     bool              shm; /**< Whether to use MIT-SHM */
     bool              follow_mouse;
     uint16_t          cur_w, cur_h; /**< Actual capture pixel dimensions */
+#ifdef HAVE_XCB_DAMAGE
+    xcb_damage_damage_t damage; /**< Damage object XID, or 0 */
+    uint8_t           damage_event; /**< Damage extension first event */
+    bool              damaged; /**< Content changed since last capture */
+    int               last_x, last_y; /**< Last capture coordinates */
+    vlc_tick_t        last_capture; /**< Last capture date */
+#endif
     /* Timer does not use this, only input thread: */
     vlc_timer_t       timer;
 } demux_sys_t;
@@ -138,6 +156,78 @@ static bool CheckSHM (xcb_connection_t *conn)
 #endif
 }
 
+#ifdef HAVE_XCB_DAMAGE
+/** Tracks the changes of the captured window with the Damage extension */
+static void InitDamage (vlc_object_t *obj, demux_sys_t *sys)
+{
+    xcb_connection_t *conn = sys->conn;
+
+    sys->damage = 0;
+    sys->damaged = true;
+    sys->last_capture = VLC_TICK_INVALID;
+
+    if (!var_InheritBool (obj, "screen-damage"))
+        return;
+
+    const xcb_query_extension_reply_t *ext =
+        xcb_get_extension_data (conn, &xcb_damage_id);
+    if (ext == NULL || !ext->present)
+        return;
+
+    xcb_damage_query_version_reply_t *r =
+        xcb_damage_query_version_reply (conn,
+            xcb_damage_query_version (conn, 1, 1), NULL);
+    if (r == NULL)
+        return;
+    msg_Dbg (obj, "using Damage extension v%"PRIu32".%"PRIu32,
+             r->major_version, r->minor_version);
+    free (r);
+
+    sys->damage = xcb_generate_id (conn);
+    sys->damage_event = ext->first_event;
+    xcb_damage_create (conn, sys->damage, sys->window,
+                       XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+}
+
+/**
+ * Checks whether the captured region may have changed since the last frame.
+ * Otherwise, the frame is skipped, but a frame is still sent every second
+ * for the late joiners and the encoders expecting regular key frames.
+ */
+static bool CheckDamage (demux_sys_t *sys, int x, int y)
+{
+    xcb_connection_t *conn = sys->conn;
+    xcb_generic_event_t *ev;
+
+    if (sys->damage == 0)
+        return true;
+
+    while ((ev = xcb_poll_for_event (conn)) != NULL)
+    {
+        if ((ev->response_type & 0x7f)
+             == sys->damage_event + XCB_DAMAGE_NOTIFY)
+            sys->damaged = true;
+        free (ev);
+    }
+
+    vlc_tick_t now = vlc_tick_now ();
+    if (x != sys->last_x || y != sys->last_y)
+        sys->damaged = true;
+    if (!sys->damaged && sys->last_capture != VLC_TICK_INVALID
+     && now - sys->last_capture < VLC_TICK_FROM_SEC(1))
+        return false;
+
+    /* Re-arm the notification, before the capture so that no change made
+     * during the capture is missed. */
+    xcb_damage_subtract (conn, sys->damage, XCB_NONE, XCB_NONE);
+    sys->damaged = false;
+    sys->last_x = x;
+    sys->last_y = y;
+    sys->last_capture = now;
+    return true;
+}
+#endif
+
 /**
  * Probes and initializes.
  */
@@ -249,6 +339,9 @@ static int Open (vlc_object_t *obj)
     p_sys->cur_h = 0;
     p_sys->bpp = 0;
     p_sys->es = NULL;
+#ifdef HAVE_XCB_DAMAGE
+    InitDamage (obj, p_sys);
+#endif
     if (vlc_timer_create (&p_sys->timer, Demux, demux))
         goto error;
     vlc_timer_schedule_asap (p_sys->timer, interval);
@@ -429,8 +522,21 @@ discard:
             sys->cur_h = h;
             sys->bpp /= 8; /* bits -> bytes */
         }
+#ifdef HAVE_XCB_DAMAGE
+        sys->damaged = true;
+#endif
     }
 
+#ifdef HAVE_XCB_DAMAGE
+    if (!CheckDamage (sys, x, y))
+    {   /* Nothing changed: keep the clock running without a new frame */
+        free (geo);
+        if (sys->es != NULL)
+            es_out_SetPCR (demux->out, vlc_tick_now ());
+        return;
+    }
+#endif
+
     /* Capture screen */
     xcb_drawable_t drawable =
         (sys->window != geo->root) ? sys->pixmap : sys->window;
@@ -58,6 +58,13 @@
 
 #include "smb_common.h"
 
+#define READ_AHEAD_TEXT N_("Read-ahead requests")
+#define READ_AHEAD_LONGTEXT N_("Number of file read requests kept in " \
+    "flight. More requests improve the throughput over high latency links.")
+
+/* Size of each read request (and of each read-ahead buffer) */
+#define SMB2_READ_SIZE 262144
+
 static int Open(vlc_object_t *);
 static void Close(vlc_object_t *);
 
@@ -71,10 +78,22 @@ vlc_module_begin()
     add_string("smb-user", NULL, SMB_USER_TEXT, SMB_USER_LONGTEXT, false)
     add_password("smb-pwd", NULL, SMB_PASS_TEXT, SMB_PASS_LONGTEXT)
     add_string("smb-domain", NULL, SMB_DOMAIN_TEXT, SMB_DOMAIN_LONGTEXT, false)
+    add_integer_with_range("smb2-read-ahead", 4, 1, 16, READ_AHEAD_TEXT,
+                           READ_AHEAD_LONGTEXT, true)
     add_shortcut("smb", "smb2")
     set_callbacks(Open, Close)
 vlc_module_end()
 
+struct smb2_read
+{
+    stream_t *access;
+    uint8_t *buf;
+    uint64_t offset;
+    size_t len; /**< Bytes received */
+    size_t pos; /**< Bytes consumed */
+    bool pending;
+};
+
 struct access_sys
 {
     struct smb2_context *   smb2;
@@ -87,13 +106,17 @@ struct access_sys
     bool                    smb2_connected;
     int                     error_status;
 
+    /* Read-ahead ring of asynchronous read requests */
+    struct smb2_read *      reads;
+    uint8_t *               read_bufs;
+    unsigned                read_depth;
+    unsigned                read_first;
+    unsigned                read_count;
+    unsigned                read_pending;
+    size_t                  read_size;
+    uint64_t                read_offset; /**< Offset of the next request */
+
     bool res_done;
-    union {
-        struct
-        {
-            size_t len;
-        } read;
-    } res;
 };
 
 static int
@@ -221,13 +244,82 @@ static void
 smb2_read_cb(struct smb2_context *smb2, int status, void *data,
              void *private_data)
 {
-    VLC_UNUSED(data);
-    VLC_SMB2_GENERIC_CB();
+    VLC_UNUSED(smb2); VLC_UNUSED(data);
+    struct smb2_read *rd = private_data;
+    stream_t *access = rd->access;
+    struct access_sys *sys = access->p_sys;
 
-    if (status == 0)
-        sys->eof = true;
-    else
-        sys->res.read.len = status;
+    assert(sys->smb2 == smb2);
+    assert(rd->pending);
+    rd->pending = false;
+    sys->read_pending--;
+
+    if (VLC_SMB2_CHECK_STATUS(access, status))
+        return;
+
+    rd->len = status;
+}
+
+/* Waits for all requests in flight, so that their buffers can be reused */
+static int
+vlc_smb2_read_drain(stream_t *access, bool teardown)
+{
+    struct access_sys *sys = access->p_sys;
+
+    while (sys->read_pending > 0)
+        if (vlc_smb2_mainloop(access, teardown) < 0)
+            return -1;
+    return 0;
+}
+
+static int
+vlc_smb2_read_reset(stream_t *access, uint64_t offset)
+{
+    struct access_sys *sys = access->p_sys;
+
+    if (vlc_smb2_read_drain(access, false) < 0)
+        return -1;
+
+    sys->read_first = 0;
+    sys->read_count = 0;
+    sys->read_offset = offset;
+    return 0;
+}
+
+/* Sends read requests until the read-ahead ring is full. Requests are not
+ * sent past the end of the file, unless nothing else is left to read. */
+static int
+vlc_smb2_read_queue(stream_t *access)
+{
+    struct access_sys *sys = access->p_sys;
+
+    while (sys->read_count < sys->read_depth
+        && (sys->read_count == 0 || sys->read_offset < sys->smb2_size))
+    {
+        unsigned idx = (sys->read_first + sys->read_count) % sys->read_depth;
+        struct smb2_read *rd = &sys->reads[idx];
+
+        if (rd->pending)
+            break; /* still owned by a discarded request */
+
+        rd->offset = sys->read_offset;
+        rd->len = 0;
+        rd->pos = 0;
+        rd->pending = true;
+
+        if (smb2_pread_async(sys->smb2, sys->smb2fh, rd->buf, sys->read_size,
+                             rd->offset, smb2_read_cb, rd) < 0)
+        {
+            rd->pending = false;
+            VLC_SMB2_SET_ERROR(access, "smb2_pread_async", 1);
+            return -1;
+        }
+
+        sys->read_pending++;
+        sys->read_count++;
+        sys->read_offset += sys->read_size;
+    }
+    return 0;
 }
 
 static ssize_t
@@ -241,24 +333,48 @@ FileRead(stream_t *access, void *buf, size_t len)
     if (sys->eof)
         return 0;
 
-    /* Limit the read size since smb2_read_async() will complete only after
-     * reading the whole requested data and not when whatever data is available
-     * (high read size means a faster I/O but a higher latency). */
-    if (len > 262144)
-        len = 262144;
+    if (vlc_smb2_read_queue(access) < 0)
+        return -1;
+
+    struct smb2_read *rd = &sys->reads[sys->read_first];
+
+    while (rd->pending)
+        if (vlc_smb2_mainloop(access, false) < 0)
+            return -1;
 
-    sys->res.read.len = 0;
-    if (smb2_read_async(sys->smb2, sys->smb2fh, buf, len,
-                        smb2_read_cb, access) < 0)
+    if (rd->pos >= rd->len)
     {
-        VLC_SMB2_SET_ERROR(access, "smb2_read_async", 1);
-        return -1;
+        if (rd->len == 0)
+        {
+            sys->eof = true;
+            return 0;
+        }
+        /* Seek target beyond a short read */
+        return vlc_smb2_read_reset(access, rd->offset + rd->pos) < 0 ? -1
+             : FileRead(access, buf, len);
     }
 
-    if (vlc_smb2_mainloop(access, false) < 0)
-        return -1;
+    if (len > rd->len - rd->pos)
+        len = rd->len - rd->pos;
+    memcpy(buf, rd->buf + rd->pos, len);
+    rd->pos += len;
 
-    return sys->res.read.len;
+    if (rd->pos == rd->len)
+    {
+        sys->read_first = (sys->read_first + 1) % sys->read_depth;
+        sys->read_count--;
+
+        if (rd->len < sys->read_size
+         && rd->offset + rd->len < sys->smb2_size)
+        {   /* The server truncated the request: the following requests are
+             * misaligned. Use smaller requests from now on. */
+            msg_Dbg(access, "read size limited to %zu bytes", rd->len);
+            sys->read_size = rd->len;
+            if (vlc_smb2_read_reset(access, rd->offset + rd->len) < 0)
+                return -1;
+        }
+    }
+    return len;
 }
 
 static int
@@ -269,12 +385,26 @@ FileSeek(stream_t *access, uint64_t i_pos)
     if (sys->error_status != 0)
         return VLC_EGENERIC;
 
-    if (smb2_lseek(sys->smb2, sys->smb2fh, i_pos, SEEK_SET, NULL) < 0)
+    sys->eof = false;
+
+    /* Keep the requests following the new offset, if it is ahead */
+    while (sys->read_count > 0)
     {
-        VLC_SMB2_SET_ERROR(access, "smb2_seek_async", 1);
-        return VLC_EGENERIC;
+        struct smb2_read *rd = &sys->reads[sys->read_first];
+
+        if (i_pos < rd->offset)
+            break;
+        if (i_pos < rd->offset + sys->read_size)
+        {
+            rd->pos = i_pos - rd->offset;
+            return VLC_SUCCESS;
+        }
+        sys->read_first = (sys->read_first + 1) % sys->read_depth;
+        sys->read_count--;
     }
-    sys->eof = false;
+
+    if (vlc_smb2_read_reset(access, i_pos) < 0)
+        return VLC_EGENERIC;
 
     return VLC_SUCCESS;
 }
@@ -703,6 +833,23 @@ Open(vlc_object_t *p_obj)
 
     if (sys->smb2fh != NULL)
     {
+        sys->read_depth = var_InheritInteger(access, "smb2-read-ahead");
+        sys->read_size = SMB2_READ_SIZE;
+        sys->reads = vlc_obj_calloc(p_obj, sys->read_depth,
+                                    sizeof (*sys->reads));
+        sys->read_bufs = malloc(sys->read_depth * SMB2_READ_SIZE);
+        if (unlikely(sys->reads == NULL || sys->read_bufs == NULL))
+        {
+            free(sys->read_bufs);
+            vlc_smb2_close_fh(access);
+            goto error;
+        }
+        for (unsigned i = 0; i < sys->read_depth; i++)
+        {
+            sys->reads[i].access = access;
+            sys->reads[i].buf = sys->read_bufs + i * SMB2_READ_SIZE;
+        }
+
         access->pf_read = FileRead;
         access->pf_seek = FileSeek;
         access->pf_control = FileControl;
@@ -753,7 +900,10 @@ Close(vlc_object_t *p_obj)
     struct access_sys *sys = access->p_sys;
 
     if (sys->smb2fh != NULL)
+    {
+        vlc_smb2_read_drain(access, true);
         vlc_smb2_close_fh(access);
+    }
     else if (sys->smb2dir != NULL)
         smb2_closedir(sys->smb2, sys->smb2dir);
     else if (sys->share_enum != NULL)
@@ -763,6 +913,7 @@ Close(vlc_object_t *p_obj)
 
     vlc_smb2_disconnect_share(access);
     smb2_destroy_context(sys->smb2);
+    free(sys->read_bufs);
 
     vlc_UrlClean(&sys->encoded_url);
 }
@@ -42,6 +42,10 @@ typedef struct
     char       *psz_host;
     int         i_port;
     int         i_chunks; /* Number of chunks to allocate in the next read */
+#ifdef SRT_HAVE_GROUPS
+    bool        b_group;
+    vlc_tick_t  i_stats_date;
+#endif
 } stream_sys_t;
 
 
@@ -98,6 +102,9 @@ static bool srt_schedule_reconnect(stream_t *p_stream)
     char *psz_passphrase = var_InheritString( p_stream, SRT_PARAM_PASSPHRASE );
     bool passphrase_needs_free = true;
     char *url = NULL;
+#ifdef SRT_HAVE_GROUPS
+    char *psz_group = NULL;
+#endif
     srt_params_t params;
     struct addrinfo hints = {
         .ai_socktype = SOCK_DGRAM,
@@ -125,7 +132,14 @@ static bool srt_schedule_reconnect(stream_t *p_stream)
         srt_close( p_sys->sock );
     }
 
-    p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
+#ifdef SRT_HAVE_GROUPS
+    psz_group = var_InheritString( p_stream, SRT_PARAM_GROUP_TYPE );
+    p_sys->b_group = psz_group != NULL && psz_group[0] != '\0';
+    if ( p_sys->b_group )
+        p_sys->sock = srt_group_create( strm_obj, psz_group );
+    else
+#endif
+        p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
     if ( p_sys->sock == SRT_INVALID_SOCK )
     {
         msg_Err( p_stream, "Failed to open socket." );
@@ -189,11 +203,26 @@ static bool srt_schedule_reconnect(stream_t *p_stream)
     msg_Dbg( p_stream, "Schedule SRT connect (dest addresss: %s, port: %d).",
         p_sys->psz_host, p_sys->i_port);
 
-    stat = srt_connect( p_sys->sock, res->ai_addr, res->ai_addrlen );
-    if (stat == SRT_ERROR) {
-        msg_Err( p_stream, "Failed to connect to server (reason: %s)",
-                srt_getlasterror_str() );
-        failed = true;
+#ifdef SRT_HAVE_GROUPS
+    if ( p_sys->b_group )
+    {
+        char *psz_links = var_InheritString( p_stream, SRT_PARAM_GROUP_LINKS );
+
+        stat = srt_group_connect( strm_obj, p_sys->sock, res, psz_links );
+        free( psz_links );
+        if ( stat == SRT_ERROR )
+            failed = true;
+        p_sys->i_stats_date = vlc_tick_now() + SRT_GROUP_STATS_PERIOD;
+    }
+    else
+#endif
+    {
+        stat = srt_connect( p_sys->sock, res->ai_addr, res->ai_addrlen );
+        if (stat == SRT_ERROR) {
+            msg_Err( p_stream, "Failed to connect to server (reason: %s)",
+                    srt_getlasterror_str() );
+            failed = true;
+        }
     }
 
     /* Reset the number of chunks to allocate as the bitrate of
@@ -211,6 +240,9 @@ out:
 
     if (passphrase_needs_free)
         free( psz_passphrase );
+#ifdef SRT_HAVE_GROUPS
+    free( psz_group );
+#endif
     freeaddrinfo( res );
     free( url );
 
@@ -294,6 +326,14 @@ static block_t *BlockSRT(stream_t *p_stream, bool *restrict eof)
             pkt->i_buffer += (size_t)stat;
         }
 
+#ifdef SRT_HAVE_GROUPS
+        if ( p_sys->b_group && vlc_tick_now() >= p_sys->i_stats_date )
+        {
+            srt_group_log_stats( VLC_OBJECT(p_stream), p_sys->sock );
+            p_sys->i_stats_date += SRT_GROUP_STATS_PERIOD;
+        }
+#endif
+
         msg_Dbg ( p_stream, "Read %zu bytes out of a max of %zu"
             " (%d chunks of %zu bytes)", pkt->i_buffer,
             p_sys->i_chunks * i_chunk_size_actual, p_sys->i_chunks,
@@ -433,6 +473,13 @@ vlc_module_begin ()
     add_integer( SRT_PARAM_KEY_LENGTH, SRT_DEFAULT_KEY_LENGTH,
             SRT_KEY_LENGTH_TEXT, SRT_KEY_LENGTH_TEXT, false )
     change_integer_list( srt_key_lengths, srt_key_length_names )
+#ifdef SRT_HAVE_GROUPS
+    add_string( SRT_PARAM_GROUP_TYPE, "", SRT_GROUP_TYPE_TEXT,
+            SRT_GROUP_TYPE_LONGTEXT, true )
+    change_string_list( srt_group_types, srt_group_type_names )
+    add_string( SRT_PARAM_GROUP_LINKS, NULL, SRT_GROUP_LINKS_TEXT,
+            SRT_GROUP_LINKS_LONGTEXT, true )
+#endif
 
     set_capability("access", 0)
     add_shortcut("srt")
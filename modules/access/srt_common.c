@@ -23,6 +23,8 @@
 
 #include "srt_common.h"
 
+#include <vlc_network.h>
+
 const char * const srt_key_length_names[] = { N_( "16 bytes" ), N_(
         "24 bytes" ), N_( "32 bytes" ), };
 
@@ -166,3 +168,135 @@ int srt_set_socket_option(vlc_object_t *this, const char *srt_param,
     return stat;
 }
 
+
+#ifdef SRT_HAVE_GROUPS
+const char * const srt_group_type_names[] = { N_( "None" ),
+        N_( "Broadcast" ), N_( "Main/backup" ), };
+
+SRTSOCKET srt_group_create(vlc_object_t *this, const char *type)
+{
+    SRT_GROUP_TYPE gtype;
+    SRTSOCKET group;
+
+    if (strcmp( type, "broadcast" ) == 0)
+        gtype = SRT_GTYPE_BROADCAST;
+    else if (strcmp( type, "backup" ) == 0)
+        gtype = SRT_GTYPE_BACKUP;
+    else {
+        msg_Err( this, "Unknown socket group type %s", type );
+        return SRT_INVALID_SOCK;
+    }
+
+    group = srt_create_group( gtype );
+    if (group == SRT_INVALID_SOCK)
+        msg_Err( this, "Failed to create socket group (reason: %s)",
+                srt_getlasterror_str() );
+    return group;
+}
+
+/* Resolves host[:port], modifying the string */
+static struct addrinfo *srt_resolve(vlc_object_t *this, char *addr, int port)
+{
+    struct addrinfo hints = {
+        .ai_socktype = SOCK_DGRAM,
+    }, *res = NULL;
+    char *host = addr, *psz_port = addr;
+
+    if (host[0] == '[') {
+        host++;
+        psz_port = strchr( host, ']' );
+        if (psz_port != NULL)
+            *psz_port++ = '\0';
+    }
+
+    psz_port = (psz_port != NULL) ? strchr( psz_port, ':' ) : NULL;
+    if (psz_port != NULL) {
+        *psz_port++ = '\0';
+        port = atoi( psz_port );
+    }
+
+    int stat = vlc_getaddrinfo( host, port, &hints, &res );
+    if (stat) {
+        msg_Err( this, "Cannot resolve [%s]:%d (reason: %s)", host, port,
+                gai_strerror( stat ) );
+        return NULL;
+    }
+    return res;
+}
+
+int srt_group_connect(vlc_object_t *this, SRTSOCKET group,
+        const struct addrinfo *dst, const char *links)
+{
+    SRT_SOCKGROUPCONFIG config[SRT_GROUP_MAX_LINKS];
+    int count = 0;
+    char *list = (links != NULL) ? strdup( links ) : NULL;
+    char *saveptr;
+
+    config[count++] = srt_prepare_endpoint( NULL, dst->ai_addr,
+            dst->ai_addrlen );
+
+    for (char *link = (list != NULL) ? strtok_r( list, ",", &saveptr )
+                                     : NULL;
+         link != NULL && count < SRT_GROUP_MAX_LINKS;
+         link = strtok_r( NULL, ",", &saveptr )) {
+        char *local = strchr( link, '@' );
+        struct addrinfo *peer, *src = NULL;
+
+        if (local != NULL)
+            *local++ = '\0';
+
+        peer = srt_resolve( this, link, SRT_DEFAULT_PORT );
+        if (peer == NULL)
+            continue;
+        if (local != NULL) {
+            src = srt_resolve( this, local, 0 );
+            if (src == NULL) {
+                freeaddrinfo( peer );
+                continue;
+            }
+        }
+
+        /* The addresses are copied */
+        config[count++] = srt_prepare_endpoint(
+                (src != NULL) ? src->ai_addr : NULL,
+                peer->ai_addr, peer->ai_addrlen );
+        if (src != NULL)
+            freeaddrinfo( src );
+        freeaddrinfo( peer );
+    }
+    free( list );
+
+    msg_Dbg( this, "Schedule SRT group connect (%d links).", count );
+
+    int stat = srt_connect_group( group, config, count );
+    if (stat == SRT_ERROR)
+        msg_Err( this, "Failed to connect socket group (reason: %s)",
+                srt_getlasterror_str() );
+    return stat;
+}
+
+void srt_group_log_stats(vlc_object_t *this, SRTSOCKET group)
+{
+    SRT_SOCKGROUPDATA data[SRT_GROUP_MAX_LINKS];
+    size_t count = ARRAY_SIZE( data );
+
+    if (srt_group_data( group, data, &count ) == SRT_ERROR)
+        return;
+
+    for (size_t i = 0; i < count; i++) {
+        SRT_TRACEBSTATS perf;
+
+        if (srt_bstats( data[i].id, &perf, true ) == SRT_ERROR)
+            continue;
+
+        msg_Dbg( this, "link %zu (%s): RTT %.1f ms, send %.2f Mb/s, "
+                "receive %.2f Mb/s, %"PRId64" packets sent, %d lost, "
+                "%d retransmitted, %"PRId64" packets received, %d lost", i,
+                data[i].memberstate == SRT_GST_RUNNING ? "running" :
+                data[i].memberstate == SRT_GST_BROKEN ? "broken" : "idle",
+                perf.msRTT, perf.mbpsSendRate, perf.mbpsRecvRate,
+                perf.pktSent, perf.pktSndLoss, perf.pktRetrans,
+                perf.pktRecv, perf.pktRcvLoss );
+    }
+}
+#endif
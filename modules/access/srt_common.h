@@ -39,6 +39,8 @@
 #define SRT_PARAM_CHUNK_SIZE                  "chunk-size"
 #define SRT_PARAM_POLL_TIMEOUT                "poll-timeout"
 #define SRT_PARAM_KEY_LENGTH                  "key-length"
+#define SRT_PARAM_GROUP_TYPE                  "group-type"
+#define SRT_PARAM_GROUP_LINKS                 "group-links"
 
 
 #define SRT_DEFAULT_BANDWIDTH_OVERHEAD_LIMIT 25
@@ -62,6 +64,37 @@ static const int srt_key_lengths[] = { 16, 24, 32, };
 
 extern const char * const srt_key_length_names[];
 
+/* Socket groups (connection bonding) appeared in libsrt 1.5.0 */
+#if SRT_VERSION_VALUE >= SRT_MAKE_VERSION_VALUE(1, 5, 0)
+# define SRT_HAVE_GROUPS 1
+
+#define SRT_GROUP_TYPE_TEXT N_("Socket group type")
+#define SRT_GROUP_TYPE_LONGTEXT N_("Bond several links into a socket " \
+    "group. Broadcast sends every packet over all the links, main/backup " \
+    "only over the best link, switching when it fails.")
+#define SRT_GROUP_LINKS_TEXT N_("Socket group links")
+#define SRT_GROUP_LINKS_LONGTEXT N_("Comma-separated list of the other " \
+    "links of the group, besides the address of the URL, as " \
+    "host[:port][@local-address]. The local address selects the network " \
+    "interface of the link.")
+/* Maximum number of links of a socket group */
+#define SRT_GROUP_MAX_LINKS 8
+/* Interval between the per-link statistics in the debug log */
+#define SRT_GROUP_STATS_PERIOD VLC_TICK_FROM_SEC(10)
+
+static const char * const srt_group_types[] = { "", "broadcast", "backup", };
+extern const char * const srt_group_type_names[];
+
+struct addrinfo;
+
+SRTSOCKET srt_group_create(vlc_object_t *obj, const char *type);
+
+int srt_group_connect(vlc_object_t *obj, SRTSOCKET group,
+        const struct addrinfo *dst, const char *links);
+
+void srt_group_log_stats(vlc_object_t *obj, SRTSOCKET group);
+#endif
+
 typedef struct srt_params {
     int latency;
     const char* passphrase;
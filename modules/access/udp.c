@@ -47,19 +47,49 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_RECVMMSG
+# include <sys/socket.h>
+#endif
 
 /* Buffer can be max theoretical datagram content minus anticipated MTU.
  * IPv6 headers are larger than IPv4, ignore IPv6 jumbograms.
  */
 #define MRU 65507u
 
+#ifdef HAVE_RECVMMSG
+/* Maximum number of datagrams received per system call */
+# define VLEN 64
+/* Initial receive block size, enough for Ethernet and RTP/TS (7x188) */
+# define UDP_BLOCK_SIZE 1500u
+
+struct udp_batch {
+    size_t mru;
+    unsigned count;
+    unsigned index;
+    bool timestamps;
+    block_t *blocks[VLEN];
+    struct mmsghdr msgs[VLEN];
+    struct iovec iovecs[VLEN];
+# ifdef SO_TIMESTAMPNS
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof (struct timespec))];
+    } cmsgs[VLEN];
+# endif
+};
+#endif
+
 typedef struct {
     int fd;
     int timeout;
 
+#ifdef HAVE_RECVMMSG
+    struct udp_batch batch;
+#else
     size_t length;
     char *offset;
     char buf[MRU];
+#endif
 } access_sys_t;
 
 static int Control(stream_t *access, int query, va_list args)
@@ -83,6 +113,153 @@ static int Control(stream_t *access, int query, va_list args)
     return VLC_SUCCESS;
 }
 
+#ifdef HAVE_RECVMMSG
+static void BatchRelease(struct udp_batch *batch)
+{
+    for (unsigned i = 0; i < VLEN; i++)
+        if (batch->blocks[i] != NULL)
+        {
+            block_Release(batch->blocks[i]);
+            batch->blocks[i] = NULL;
+        }
+}
+
+static vlc_tick_t BatchTimestamp(struct udp_batch *batch, unsigned i,
+                                 vlc_tick_t realtime_offset)
+{
+# ifdef SO_TIMESTAMPNS
+    struct msghdr *msg = &batch->msgs[i].msg_hdr;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg);
+         cmsg != NULL;
+         cmsg = CMSG_NXTHDR(msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET
+         && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            struct timespec ts;
+
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof (ts));
+            return vlc_tick_from_timespec(&ts) + realtime_offset;
+        }
+    }
+# else
+    VLC_UNUSED(batch); VLC_UNUSED(i); VLC_UNUSED(realtime_offset);
+# endif
+    return VLC_TICK_INVALID;
+}
+
+/**
+ * Receives as many pending datagrams as possible in a single system call.
+ */
+static int BatchReceive(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    struct udp_batch *batch = &sys->batch;
+    unsigned n;
+
+    for (n = 0; n < VLEN; n++)
+    {
+        block_t *block = batch->blocks[n];
+
+        if (block == NULL || block->i_size < batch->mru)
+        {
+            if (block != NULL)
+                block_Release(block);
+
+            block = batch->blocks[n] = block_Alloc(batch->mru);
+            if (unlikely(block == NULL))
+                break;
+        }
+
+        batch->iovecs[n].iov_base = block->p_buffer;
+        batch->iovecs[n].iov_len = batch->mru;
+
+        struct msghdr *msg = &batch->msgs[n].msg_hdr;
+
+        msg->msg_iov = &batch->iovecs[n];
+        msg->msg_iovlen = 1;
+# ifdef SO_TIMESTAMPNS
+        if (batch->timestamps)
+        {
+            msg->msg_control = batch->cmsgs[n].buf;
+            msg->msg_controllen = sizeof (batch->cmsgs[n].buf);
+        }
+# endif
+    }
+
+    if (unlikely(n == 0))
+        return -1;
+
+    /* MSG_TRUNC reports the real datagram length in msg_len */
+    int val = recvmmsg(sys->fd, batch->msgs, n, MSG_DONTWAIT | MSG_TRUNC,
+                       NULL);
+    if (val <= 0)
+        return -1;
+
+    vlc_tick_t realtime_offset = 0;
+# ifdef SO_TIMESTAMPNS
+    if (batch->timestamps)
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        realtime_offset = vlc_tick_now() - vlc_tick_from_timespec(&ts);
+    }
+# endif
+
+    for (int i = 0; i < val; i++)
+    {
+        block_t *block = batch->blocks[i];
+        size_t len = batch->msgs[i].msg_len;
+
+        block->i_dts = BatchTimestamp(batch, i, realtime_offset);
+        if (unlikely(len > batch->mru))
+        {   /* Datagram did not fit, grow the buffers for the next ones */
+            msg_Warn(access, "%zu bytes datagram truncated", len);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            batch->mru = (len < MRU) ? len : MRU;
+            len = block->i_buffer;
+        }
+        block->i_buffer = len;
+    }
+
+    batch->count = val;
+    batch->index = 0;
+    return 0;
+}
+
+static block_t *BlockUDP(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+    struct udp_batch *batch = &sys->batch;
+
+    if (batch->index >= batch->count)
+    {
+        struct pollfd ufd[1];
+
+        ufd[0].fd = sys->fd;
+        ufd[0].events = POLLIN;
+
+        switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
+            case 0:
+                msg_Err(access, "receive time-out");
+                *eof = true;
+                /* fall through */
+            case -1:
+                return NULL;
+        }
+
+        if (BatchReceive(access))
+            return NULL;
+    }
+
+    block_t *block = batch->blocks[batch->index];
+
+    batch->blocks[batch->index++] = NULL;
+    return block;
+}
+#else
 static ssize_t Read(stream_t *access, void *buf, size_t len)
 {
     access_sys_t *sys = access->p_sys;
@@ -132,6 +309,8 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     return val;
 }
 
+#endif
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -147,10 +326,17 @@ static int Open( vlc_object_t *p_this )
     if( unlikely( sys == NULL ) )
         return VLC_ENOMEM;
 
-    sys->length = 0;
     p_access->p_sys = sys;
+#ifdef HAVE_RECVMMSG
+    memset(&sys->batch, 0, sizeof (sys->batch));
+    sys->batch.mru = UDP_BLOCK_SIZE;
+    p_access->pf_read = NULL;
+    p_access->pf_block = BlockUDP;
+#else
+    sys->length = 0;
     p_access->pf_read = Read;
     p_access->pf_block = NULL;
+#endif
     p_access->pf_control = Control;
     p_access->pf_seek = NULL;
 
@@ -217,6 +403,12 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#if defined(HAVE_RECVMMSG) && defined(SO_TIMESTAMPNS)
+    /* Kernel receive time stamps */
+    sys->batch.timestamps = setsockopt( sys->fd, SOL_SOCKET, SO_TIMESTAMPNS,
+                                        &(int){ 1 }, sizeof (int) ) == 0;
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -228,6 +420,9 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    BatchRelease( &sys->batch );
+#endif
     net_Close( sys->fd );
 }
 
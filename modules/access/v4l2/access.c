@@ -46,7 +46,7 @@ typedef struct
         uint32_t bufc;
         uint32_t blocksize;
     };
-    struct buffer_t *bufv;
+    vlc_v4l2_buffers_t *bufv;
     vlc_v4l2_ctrl_t *controls;
 } access_sys_t;
 
@@ -164,7 +164,7 @@ int InitVideo (stream_t *access, int fd, uint32_t caps)
     /* Init I/O method */
     if (caps & V4L2_CAP_STREAMING)
     {
-        sys->bufc = 4;
+        sys->bufc = var_InheritInteger (access, CFG_PREFIX"buffers");
         sys->bufv = StartMmap (VLC_OBJECT(access), fd, &sys->bufc);
         if (sys->bufv == NULL)
             return -1;
@@ -191,7 +191,7 @@ void AccessClose( vlc_object_t *obj )
     access_sys_t *sys = access->p_sys;
 
     if (sys->bufv != NULL)
-        StopMmap (sys->fd, sys->bufv, sys->bufc);
+        StopMmap (sys->bufv);
     ControlsDeinit(vlc_object_parent(obj), sys->controls);
     v4l2_close (sys->fd);
     free( sys );
@@ -217,7 +217,7 @@ static block_t *MMapBlock (stream_t *access, bool *restrict eof)
     if (AccessPoll (access))
         return NULL;
 
-    block_t *block = GrabVideo (VLC_OBJECT(access), sys->fd, sys->bufv);
+    block_t *block = GrabVideo (VLC_OBJECT(access), sys->bufv);
     if( block != NULL )
     {
         block->i_pts = block->i_dts = vlc_tick_now();
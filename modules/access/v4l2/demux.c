@@ -47,7 +47,7 @@ typedef struct
     int fd;
     vlc_thread_t thread;
 
-    struct buffer_t *bufv;
+    vlc_v4l2_buffers_t *bufv;
     union
     {
         uint32_t bufc;
@@ -569,7 +569,7 @@ static int InitVideo (demux_t *demux, int fd, uint32_t caps)
         }
         else /* fall back to memory map */
         {
-            sys->bufc = 4;
+            sys->bufc = var_InheritInteger (demux, CFG_PREFIX"buffers");
             sys->bufv = StartMmap (VLC_OBJECT(demux), fd, &sys->bufc);
             if (sys->bufv == NULL)
                 return -1;
@@ -608,7 +608,7 @@ static int InitVideo (demux_t *demux, int fd, uint32_t caps)
             CloseVBI (sys->vbi);
 #endif
         if (sys->bufv != NULL)
-            StopMmap (sys->fd, sys->bufv, sys->bufc);
+            StopMmap (sys->bufv);
         return -1;
     }
     return 0;
@@ -622,7 +622,7 @@ void DemuxClose( vlc_object_t *obj )
     vlc_cancel (sys->thread);
     vlc_join (sys->thread, NULL);
     if (sys->bufv != NULL)
-        StopMmap (sys->fd, sys->bufv, sys->bufc);
+        StopMmap (sys->bufv);
     ControlsDeinit(vlc_object_parent(obj), sys->controls);
     v4l2_close (sys->fd);
 
@@ -754,7 +754,7 @@ static void *MmapThread (void *data)
         if( ufd[0].revents )
         {
             int canc = vlc_savecancel ();
-            block_t *block = GrabVideo (VLC_OBJECT(demux), fd, sys->bufv);
+            block_t *block = GrabVideo (VLC_OBJECT(demux), sys->bufv);
             if (block != NULL)
             {
                 block->i_flags |= sys->block_flags;
@@ -31,12 +31,7 @@ extern int (*v4l2_munmap) (void *, size_t);
 #define CFG_PREFIX "v4l2-"
 
 typedef struct vlc_v4l2_ctrl vlc_v4l2_ctrl_t;
-
-struct buffer_t
-{
-    void *  start;
-    size_t  length;
-};
+typedef struct vlc_v4l2_buffers vlc_v4l2_buffers_t;
 
 /* v4l2.c */
 void ParseMRL(vlc_object_t *, const char *);
@@ -52,11 +47,11 @@ int SetupFormat (vlc_object_t *, int, uint32_t,
 int SetupTuner (vlc_object_t *, int fd, uint32_t);
 
 int StartUserPtr (vlc_object_t *, int);
-struct buffer_t *StartMmap (vlc_object_t *, int, uint32_t *);
-void StopMmap (int, struct buffer_t *, uint32_t);
+vlc_v4l2_buffers_t *StartMmap (vlc_object_t *, int, uint32_t *);
+void StopMmap (vlc_v4l2_buffers_t *);
 
 vlc_tick_t GetBufferPTS (const struct v4l2_buffer *);
-block_t* GrabVideo (vlc_object_t *, int, const struct buffer_t *);
+block_t* GrabVideo (vlc_object_t *, vlc_v4l2_buffers_t *);
 
 #ifdef ZVBI_COMPILED
 /* vbi.c */
@@ -577,11 +577,79 @@ vlc_tick_t GetBufferPTS (const struct v4l2_buffer *buf)
     return pts;
 }
 
+/* Memory-mapped buffers are lent to the blocks, rather than copied, as long
+ * as the driver keeps at least that many buffers to capture into. */
+#define MMAP_MIN_QUEUED 2
+
+struct buffer_t
+{
+    void *  start;
+    size_t  length;
+};
+
+struct vlc_v4l2_buffers
+{
+    int fd;
+    uint32_t count;
+    bool lend;
+
+    vlc_mutex_t lock;
+    unsigned refs; /**< owner plus lent blocks */
+    uint32_t queued; /**< buffers owned by the driver */
+    bool streaming;
+
+    struct buffer_t bufv[];
+};
+
+struct mmap_block
+{
+    block_t self;
+    vlc_v4l2_buffers_t *pool;
+    struct v4l2_buffer buf;
+};
+
+static void ReleaseBuffers (vlc_v4l2_buffers_t *pool)
+{
+    vlc_mutex_lock (&pool->lock);
+    bool last = --pool->refs == 0;
+    vlc_mutex_unlock (&pool->lock);
+
+    if (!last)
+        return;
+
+    for (uint32_t i = 0; i < pool->count; i++)
+        v4l2_munmap (pool->bufv[i].start, pool->bufv[i].length);
+    free (pool);
+}
+
+static void QueueBuffer (vlc_v4l2_buffers_t *pool, struct v4l2_buffer *buf)
+{
+    vlc_mutex_lock (&pool->lock);
+    /* Once streaming is stopped, the device may be closed already */
+    if (pool->streaming && v4l2_ioctl (pool->fd, VIDIOC_QBUF, buf) == 0)
+        pool->queued++;
+    vlc_mutex_unlock (&pool->lock);
+}
+
+static void mmap_block_Release (block_t *block)
+{
+    struct mmap_block *mb = container_of (block, struct mmap_block, self);
+    vlc_v4l2_buffers_t *pool = mb->pool;
+
+    QueueBuffer (pool, &mb->buf);
+    ReleaseBuffers (pool);
+    free (mb);
+}
+
+static const struct vlc_block_callbacks mmap_block_cbs =
+{
+    mmap_block_Release,
+};
+
 /*****************************************************************************
  * GrabVideo: Grab a video frame
  *****************************************************************************/
-block_t *GrabVideo (vlc_object_t *demux, int fd,
-                    const struct buffer_t *restrict bufv)
+block_t *GrabVideo (vlc_object_t *demux, vlc_v4l2_buffers_t *pool)
 {
     struct v4l2_buffer buf = {
         .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
@@ -589,7 +657,7 @@ block_t *GrabVideo (vlc_object_t *demux, int fd,
     };
 
     /* Wait for next frame */
-    if (v4l2_ioctl (fd, VIDIOC_DQBUF, &buf) < 0)
+    if (v4l2_ioctl (pool->fd, VIDIOC_DQBUF, &buf) < 0)
     {
         switch (errno)
         {
@@ -604,20 +672,54 @@ block_t *GrabVideo (vlc_object_t *demux, int fd,
         }
     }
 
+    const struct buffer_t *bufv = &pool->bufv[buf.index];
+    block_t *block;
+
+    vlc_mutex_lock (&pool->lock);
+    pool->queued--;
+    bool lend = pool->lend && pool->queued >= MMAP_MIN_QUEUED;
+    if (lend)
+        pool->refs++;
+    vlc_mutex_unlock (&pool->lock);
+
+    if (lend)
+    {   /* Zero copy: the buffer is queued again when the block is released */
+        struct mmap_block *mb = malloc (sizeof (*mb));
+        if (likely(mb != NULL))
+        {
+            block = block_Init (&mb->self, &mmap_block_cbs, bufv->start,
+                                bufv->length);
+            block->i_buffer = buf.bytesused;
+            block->i_pts = block->i_dts = GetBufferPTS (&buf);
+            mb->pool = pool;
+            mb->buf = buf;
+            return block;
+        }
+        ReleaseBuffers (pool);
+    }
+
     /* Copy frame */
-    block_t *block = block_Alloc (buf.bytesused);
-    if (unlikely(block == NULL))
-        return NULL;
-    block->i_pts = block->i_dts = GetBufferPTS (&buf);
-    memcpy (block->p_buffer, bufv[buf.index].start, buf.bytesused);
+    block = block_Alloc (buf.bytesused);
+    if (likely(block != NULL))
+    {
+        block->i_pts = block->i_dts = GetBufferPTS (&buf);
+        memcpy (block->p_buffer, bufv->start, buf.bytesused);
+    }
 
     /* Unlock */
-    if (v4l2_ioctl (fd, VIDIOC_QBUF, &buf) < 0)
+    vlc_mutex_lock (&pool->lock);
+    if (v4l2_ioctl (pool->fd, VIDIOC_QBUF, &buf) == 0)
+        pool->queued++;
+    else
     {
         msg_Err (demux, "queue error: %s", vlc_strerror_c(errno));
-        block_Release (block);
-        return NULL;
+        if (block != NULL)
+        {
+            block_Release (block);
+            block = NULL;
+        }
     }
+    vlc_mutex_unlock (&pool->lock);
     return block;
 }
 
@@ -649,9 +751,9 @@ int StartUserPtr (vlc_object_t *obj, int fd)
 /**
  * Allocates memory-mapped buffers, queues them and start streaming.
  * @param n requested buffers count [IN], allocated buffers count [OUT]
- * @return array of allocated buffers (use free()), or NULL on error.
+ * @return allocated buffers (use StopMmap()), or NULL on error.
  */
-struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
+vlc_v4l2_buffers_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
 {
     struct v4l2_requestbuffers req = {
         .count = *n,
@@ -671,10 +773,21 @@ struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
         return NULL;
     }
 
-    struct buffer_t *bufv = vlc_alloc (req.count, sizeof (*bufv));
-    if (unlikely(bufv == NULL))
+    vlc_v4l2_buffers_t *pool = malloc (sizeof (*pool)
+                                       + req.count * sizeof (pool->bufv[0]));
+    if (unlikely(pool == NULL))
         return NULL;
 
+    pool->fd = fd;
+    pool->count = 0;
+    /* Buffers emulated by libv4l2 cannot be lent beyond the device lifetime */
+    pool->lend = v4l2_munmap == munmap;
+    vlc_mutex_init (&pool->lock);
+    pool->refs = 1;
+    pool->queued = 0;
+    pool->streaming = true;
+
+    struct buffer_t *bufv = pool->bufv;
     uint32_t bufc = 0;
     while (bufc < req.count)
     {
@@ -700,7 +813,7 @@ struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
             goto error;
         }
         bufv[bufc].length = buf.length;
-        bufc++;
+        pool->count = ++bufc;
 
         /* Some drivers refuse to queue buffers before they are mapped. Bug? */
         if (v4l2_ioctl (fd, VIDIOC_QBUF, &buf) < 0)
@@ -709,6 +822,7 @@ struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
                      vlc_strerror_c(errno));
             goto error;
         }
+        pool->queued++;
     }
 
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -718,19 +832,23 @@ struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
         goto error;
     }
     *n = bufc;
-    return bufv;
+    return pool;
 error:
-    StopMmap (fd, bufv, bufc);
+    StopMmap (pool);
     return NULL;
 }
 
-void StopMmap (int fd, struct buffer_t *bufv, uint32_t bufc)
+void StopMmap (vlc_v4l2_buffers_t *pool)
 {
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
+    vlc_mutex_lock (&pool->lock);
     /* STREAMOFF implicitly dequeues all buffers */
-    v4l2_ioctl (fd, VIDIOC_STREAMOFF, &type);
-    for (uint32_t i = 0; i < bufc; i++)
-        v4l2_munmap (bufv[i].start, bufv[i].length);
-    free (bufv);
+    v4l2_ioctl (pool->fd, VIDIOC_STREAMOFF, &type);
+    pool->queued = 0;
+    pool->streaming = false;
+    vlc_mutex_unlock (&pool->lock);
+
+    /* The lent buffers remain mapped until their blocks are released */
+    ReleaseBuffers (pool);
 }
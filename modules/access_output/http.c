@@ -59,6 +59,11 @@ static void Close( vlc_object_t * );
 #define METACUBE_TEXT N_("Metacube")
 #define METACUBE_LONGTEXT N_("Use the Metacube protocol. Needed for streaming " \
                              "to the Cubemap reflector.")
+#define GOP_TEXT N_("Cached GOPs")
+#define GOP_LONGTEXT N_("Number of groups of pictures kept for new " \
+                        "clients, so that they start immediately from a " \
+                        "keyframe. This requires a muxer that signals " \
+                        "keyframes. 0 disables the cache.")
 
 
 vlc_module_begin ()
@@ -75,6 +80,9 @@ vlc_module_begin ()
                 MIME_TEXT, MIME_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "metacube", false,
               METACUBE_TEXT, METACUBE_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "gop-cache", 0, GOP_TEXT, GOP_LONGTEXT,
+                 true )
+        change_integer_range( 0, 16 )
     set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -83,7 +91,7 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "user", "pwd", "mime", "metacube", NULL
+    "user", "pwd", "mime", "metacube", "gop-cache", NULL
 };
 
 static ssize_t Write( sout_access_out_t *, block_t * );
@@ -271,6 +279,9 @@ static int Open( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    httpd_StreamSetGOPCount( p_sys->p_httpd_stream,
+                        var_GetInteger( p_access, SOUT_CFG_PREFIX "gop-cache" ) );
+
     if( p_sys->b_metacube )
     {
         const httpd_header headers[] = {
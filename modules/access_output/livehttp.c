@@ -57,6 +57,9 @@
 
 #define MAX_RENAME_RETRIES        10
 
+/* Segments queued for the writer thread before the muxer is held back */
+#define MAX_PENDING_SEGMENTS      4
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -105,6 +108,12 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define CMAF_TEXT N_("Fragmented MP4 segments")
+#define CMAF_LONGTEXT N_("Expect the fragmented MP4 output of the mp4stream " \
+    "muxer: the initialization section is written to its own file, with " \
+    "\"init\" in place of the segment number, and the segments are split at " \
+    "the fragment boundaries.")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -125,6 +134,8 @@ vlc_module_begin ()
               NOCACHE_TEXT, NOCACHE_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "generate-iv", false,
               RANDOMIV_TEXT, RANDOMIV_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "cmaf", false,
+              CMAF_TEXT, CMAF_LONGTEXT, true )
     add_string( SOUT_CFG_PREFIX "index", NULL,
                 INDEX_TEXT, INDEX_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "index-url", NULL,
@@ -156,6 +167,7 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "cmaf",
     NULL
 };
 
@@ -173,6 +185,15 @@ typedef struct output_segment
     uint8_t aes_ivs[16];
 } output_segment_t;
 
+/* Work handed over to the writer thread, in order */
+typedef struct writer_job
+{
+    block_t *p_chain; /* whole segment, or initialization section */
+    bool b_init;
+    bool b_isend;
+    struct writer_job *p_next;
+} writer_job_t;
+
 typedef struct
 {
     char *psz_cursegPath;
@@ -202,13 +223,34 @@ typedef struct
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+    /* Fragmented MP4 */
+    bool b_cmaf;
+    char *psz_initPath;
+    char *psz_initUri;
+
+    /* Segment writer thread: files, encryption and index, off the mux path.
+     * The fields above, save the segment queues, are only used there once
+     * the thread is started. */
+    vlc_thread_t writer;
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /* job queued or stop requested */
+    vlc_cond_t room; /* job taken */
+    writer_job_t *jobs;
+    writer_job_t **jobs_end;
+    unsigned i_jobs;
+    bool b_stop;
 } sout_access_out_sys_t;
 
 static int LoadCryptFile( sout_access_out_t *p_access);
 static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
-static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
-static ssize_t writeSegment( sout_access_out_t *p_access );
+static void CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
+static ssize_t writeSegment( sout_access_out_t *p_access, block_t *output );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static char *formatSegmentPath( char *psz_path, uint32_t i_seg );
+static char *formatInitPath( char *psz_path );
+static void PostJob( sout_access_out_t *p_access, block_t *p_chain,
+                     bool b_init, bool b_isend );
+static void *WriterThread( void * );
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -246,6 +288,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_ratecontrol = var_GetBool( p_access, SOUT_CFG_PREFIX "ratecontrol") ;
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
+    p_sys->b_cmaf = var_GetBool( p_access, SOUT_CFG_PREFIX "cmaf" );
     p_sys->b_segment_has_data = false;
 
     vlc_array_init( &p_sys->segments_t );
@@ -273,10 +316,28 @@ static int Open( vlc_object_t *p_this )
     p_sys->psz_keyfile  = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-loadfile" );
     p_sys->key_uri      = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-uri" );
 
+    if( p_sys->b_cmaf )
+    {
+        p_sys->psz_initPath = formatInitPath( p_access->psz_path );
+        p_sys->psz_initUri = formatInitPath( p_sys->psz_indexUrl ?
+                                             p_sys->psz_indexUrl : p_access->psz_path );
+        if( !p_sys->psz_initPath || !p_sys->psz_initUri )
+        {
+            free( p_sys->psz_initPath );
+            free( p_sys->psz_initUri );
+            free( p_sys->psz_indexUrl );
+            free( p_sys->psz_indexPath );
+            free( p_sys );
+            return VLC_ENOMEM;
+        }
+    }
+
     p_access->p_sys = p_sys;
 
     if( p_sys->psz_keyfile && ( LoadCryptFile( p_access ) < 0 ) )
     {
+        free( p_sys->psz_initPath );
+        free( p_sys->psz_initUri );
         free( p_sys->psz_indexUrl );
         free( p_sys->psz_indexPath );
         free( p_sys );
@@ -285,6 +346,8 @@ static int Open( vlc_object_t *p_this )
     }
     else if( !p_sys->psz_keyfile && ( CryptSetup( p_access, NULL ) < 0 ) )
     {
+        free( p_sys->psz_initPath );
+        free( p_sys->psz_initUri );
         free( p_sys->psz_indexUrl );
         free( p_sys->psz_indexPath );
         free( p_sys );
@@ -296,6 +359,31 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
 
+    vlc_mutex_init( &p_sys->lock );
+    vlc_cond_init( &p_sys->wait );
+    vlc_cond_init( &p_sys->room );
+    p_sys->jobs = NULL;
+    p_sys->jobs_end = &p_sys->jobs;
+    p_sys->i_jobs = 0;
+    p_sys->b_stop = false;
+
+    if( vlc_clone( &p_sys->writer, WriterThread, p_access,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        if( p_sys->key_uri )
+        {
+            gcry_cipher_close( p_sys->aes_ctx );
+            free( p_sys->key_uri );
+        }
+        free( p_sys->psz_keyfile );
+        free( p_sys->psz_initPath );
+        free( p_sys->psz_initUri );
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_indexPath );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
@@ -499,6 +587,27 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
     return psz_result;
 }
 
+/*****************************************************************************
+ * formatInitPath: create the initialization section path name
+ *****************************************************************************/
+static char *formatInitPath( char *psz_path )
+{
+    char *psz_result;
+
+    if ( ! ( psz_result = vlc_strftime( psz_path ) ) )
+        return NULL;
+
+    char *psz_firstNumSign = psz_result + strcspn( psz_result, SEG_NUMBER_PLACEHOLDER );
+    int i_cnt = strspn( psz_firstNumSign, SEG_NUMBER_PLACEHOLDER );
+    char *psz_newResult;
+
+    *psz_firstNumSign = '\0';
+    if ( asprintf( &psz_newResult, "%sinit%s", psz_result, psz_firstNumSign + i_cnt ) < 0 )
+        psz_newResult = NULL;
+    free( psz_result );
+    return psz_newResult;
+}
+
 static void destroySegment( output_segment_t *segment )
 {
     free( segment->psz_filename );
@@ -588,8 +697,9 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
             return -1;
         }
 
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
+        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:%d\n#EXT-X-ALLOW-CACHE:%s"
                           "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", ceil(secf_from_vlc_tick( p_sys->segment_max_length )) ,
+                          p_sys->b_cmaf ? 7 : 3,
                           p_sys->b_caching ? "YES" : "NO",
                           p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
                           i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
@@ -599,6 +709,14 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
             fclose( fp );
             return -1;
         }
+        /* Before any key: the initialization section is not encrypted */
+        if ( p_sys->b_cmaf &&
+             fprintf( fp, "#EXT-X-MAP:URI=\"%s\"\n", p_sys->psz_initUri ) < 0 )
+        {
+            free( psz_idxTmp );
+            fclose( fp );
+            return -1;
+        }
         char *psz_current_uri=NULL;
 
 
@@ -762,36 +880,20 @@ static void Close( vlc_object_t * p_this )
     p_sys->ongoing_segment = NULL;
     p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
 
-    block_t *output_block = p_sys->full_segments;
+    /* The last segment ends the playlist */
+    PostJob( p_access, p_sys->full_segments, false, true );
     p_sys->full_segments = NULL;
     p_sys->full_segments_end = &p_sys->full_segments;
 
-    while( output_block )
-    {
-        block_t *p_next = output_block->p_next;
-        output_block->p_next = NULL;
-
-        Write( p_access, output_block );
-        output_block = p_next;
-    }
-    if( p_sys->ongoing_segment )
-    {
-        block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
-        p_sys->ongoing_segment = NULL;
-        p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
-    }
-
-    ssize_t writevalue = writeSegment( p_access );
-    msg_Dbg( p_access, "Writing.. %zd", writevalue );
-    if( unlikely( writevalue < 0 ) )
-    {
-        if( p_sys->full_segments )
-            block_ChainRelease( p_sys->full_segments );
-        if( p_sys->ongoing_segment )
-            block_ChainRelease( p_sys->ongoing_segment );
-    }
-
-    closeCurrentSegment( p_access, p_sys, true );
+    /* Wait for all the queued segments to be written */
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_stop = true;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
+    vlc_join( p_sys->writer, NULL );
+    vlc_cond_destroy( &p_sys->room );
+    vlc_cond_destroy( &p_sys->wait );
+    vlc_mutex_destroy( &p_sys->lock );
 
     if( p_sys->key_uri )
     {
@@ -812,6 +914,8 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    free( p_sys->psz_initPath );
+    free( p_sys->psz_initUri );
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -900,10 +1004,9 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
 /*****************************************************************************
  * CheckSegmentChange: Check if segment needs to be closed and new opened
  *****************************************************************************/
-static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
+static void CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
-    ssize_t writevalue = 0;
 
     vlc_tick_t current_length = 0;
     vlc_tick_t ongoing_length = 0;
@@ -911,36 +1014,129 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     block_ChainProperties( p_sys->full_segments, NULL, NULL, &current_length );
     block_ChainProperties( p_sys->ongoing_segment, NULL, NULL, &ongoing_length );
 
-    if( p_sys->i_handle > 0 &&
+    if( p_sys->full_segments &&
        (( p_buffer->i_length + current_length + ongoing_length ) >= p_sys->segment_max_length ) )
     {
-        writevalue = writeSegment( p_access );
-        if( unlikely( writevalue < 0 ) )
+        PostJob( p_access, p_sys->full_segments, false, false );
+        p_sys->full_segments = NULL;
+        p_sys->full_segments_end = &p_sys->full_segments;
+    }
+}
+
+/*****************************************************************************
+ * PostJob: Queue a segment or the initialization section for writing
+ *****************************************************************************/
+static void PostJob( sout_access_out_t *p_access, block_t *p_chain,
+                     bool b_init, bool b_isend )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    writer_job_t *job = malloc( sizeof( *job ) );
+    if( unlikely( !job ) )
+    {
+        block_ChainRelease( p_chain );
+        return;
+    }
+    job->p_chain = p_chain;
+    job->b_init = b_init;
+    job->b_isend = b_isend;
+    job->p_next = NULL;
+
+    vlc_mutex_lock( &p_sys->lock );
+    /* Only hold the muxer back if the storage cannot keep up at all */
+    while( p_sys->i_jobs >= MAX_PENDING_SEGMENTS )
+        vlc_cond_wait( &p_sys->room, &p_sys->lock );
+    *p_sys->jobs_end = job;
+    p_sys->jobs_end = &job->p_next;
+    p_sys->i_jobs++;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
+}
+
+/*****************************************************************************
+ * writeInitSection: Write the fragmented MP4 initialization section
+ *****************************************************************************/
+static void writeInitSection( sout_access_out_t *p_access, block_t *p_init )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    int fd = vlc_open( p_sys->psz_initPath, O_WRONLY | O_CREAT | O_LARGEFILE |
+                       O_TRUNC, 0666 );
+    if ( fd == -1 )
+    {
+        msg_Err( p_access, "cannot open `%s' (%s)", p_sys->psz_initPath,
+                 vlc_strerror_c(errno) );
+        block_ChainRelease( p_init );
+        return;
+    }
+
+    for( block_t *p_block = p_init; p_block; p_block = p_block->p_next )
+    {
+        if( vlc_write( fd, p_block->p_buffer, p_block->i_buffer )
+            != (ssize_t)p_block->i_buffer )
         {
-            block_ChainRelease ( p_buffer );
-            return -1;
+            msg_Err( p_access, "cannot write `%s'", p_sys->psz_initPath );
+            break;
         }
-        closeCurrentSegment( p_access, p_sys, false );
-        return writevalue;
     }
+    vlc_close( fd );
+    block_ChainRelease( p_init );
+    msg_Dbg( p_access, "LiveHttpInitComplete: %s", p_sys->psz_initPath );
+}
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+/*****************************************************************************
+ * WriterThread: Write the segments and update the index, in order
+ *****************************************************************************/
+static void *WriterThread( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( ;; )
     {
-        if ( openNextFile( p_access, p_sys ) < 0 )
-           return -1;
+        while( !p_sys->jobs && !p_sys->b_stop )
+            vlc_cond_wait( &p_sys->wait, &p_sys->lock );
+
+        writer_job_t *job = p_sys->jobs;
+        if( !job )
+            break; /* stopped, and everything written */
+        p_sys->jobs = job->p_next;
+        if( !p_sys->jobs )
+            p_sys->jobs_end = &p_sys->jobs;
+        p_sys->i_jobs--;
+        vlc_cond_signal( &p_sys->room );
+        vlc_mutex_unlock( &p_sys->lock );
+
+        if( job->b_init )
+            writeInitSection( p_access, job->p_chain );
+        else if( job->p_chain )
+        {
+            if( openNextFile( p_access, p_sys ) < 0 )
+                block_ChainRelease( job->p_chain );
+            else
+            {
+                if( writeSegment( p_access, job->p_chain ) < 0 )
+                    msg_Err( p_access, "Error writing segment %"PRIu32,
+                             p_sys->i_segment );
+                closeCurrentSegment( p_access, p_sys, job->b_isend );
+            }
+        }
+        else if( job->b_isend && vlc_array_count( &p_sys->segments_t ) > 0 )
+            updateIndexAndDel( p_access, p_sys, true );
+        free( job );
+
+        vlc_mutex_lock( &p_sys->lock );
     }
-    return writevalue;
+    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
 }
 
-static ssize_t writeSegment( sout_access_out_t *p_access )
+static ssize_t writeSegment( sout_access_out_t *p_access, block_t *output )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     msg_Dbg( p_access, "Writing all full segments" );
 
-    block_t *output = p_sys->full_segments;
-    p_sys->full_segments = NULL;
-    p_sys->full_segments_end = &p_sys->full_segments;
-
     vlc_tick_t current_length = 0;
     block_ChainProperties( output, NULL, NULL, &current_length );
 
@@ -974,6 +1170,7 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
             if( err )
             {
                 msg_Err( p_access, "Encryption failure: %s ", gpg_strerror(err) );
+                block_ChainRelease( output );
                 return -1;
             }
             crypted=true;
@@ -985,6 +1182,7 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
         {
            if ( errno == EINTR )
               continue;
+           block_ChainRelease( output );
            return -1;
         }
 
@@ -1013,12 +1211,27 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
     size_t i_write = 0;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
+    /* Fragmented MP4 has its headers once, and each fragment starts with
+     * a moof flagged as a key frame */
+    const uint32_t i_split_flag = p_sys->b_cmaf ? BLOCK_FLAG_TYPE_I
+                                                : BLOCK_FLAG_HEADER;
     while( p_buffer )
     {
+        block_t *p_temp = p_buffer->p_next;
+        p_buffer->p_next = NULL;
+
+        if( p_sys->b_cmaf && ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) )
+        {
+            i_write += p_buffer->i_buffer;
+            PostJob( p_access, p_buffer, true, false );
+            p_buffer = p_temp;
+            continue;
+        }
+
         /* Check if current block is already past segment-length
             and we want to write gathered blocks into segment
             and update playlist */
-        if( p_sys->ongoing_segment && ( p_sys->b_splitanywhere  || ( p_buffer->i_flags & BLOCK_FLAG_HEADER ) ) )
+        if( p_sys->ongoing_segment && ( p_sys->b_splitanywhere  || ( p_buffer->i_flags & i_split_flag ) ) )
         {
             msg_Dbg( p_access, "Moving ongoing segment to full segments-queue" );
             block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
@@ -1027,16 +1240,9 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
             p_sys->b_segment_has_data = true;
         }
 
-        ssize_t ret = CheckSegmentChange( p_access, p_buffer );
-        if( ret < 0 )
-        {
-            msg_Err( p_access, "Error in write loop");
-            return ret;
-        }
-        i_write += ret;
+        CheckSegmentChange( p_access, p_buffer );
+        i_write += p_buffer->i_buffer;
 
-        block_t *p_temp = p_buffer->p_next;
-        p_buffer->p_next = NULL;
         block_ChainLastAppend( &p_sys->ongoing_segment_end, p_buffer );
         p_buffer = p_temp;
     }
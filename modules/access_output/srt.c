@@ -37,6 +37,10 @@ typedef struct
     int           i_poll_id;
     bool          b_interrupted;
     vlc_mutex_t   lock;
+#ifdef SRT_HAVE_GROUPS
+    bool          b_group;
+    vlc_tick_t    i_stats_date;
+#endif
 } sout_access_out_sys_t;
 
 static void srt_wait_interrupted(void *p_data)
@@ -71,6 +75,9 @@ static bool srt_schedule_reconnect(sout_access_out_t *p_access)
     int i_max_bandwidth_limit =
     var_InheritInteger( p_access, SRT_PARAM_BANDWIDTH_OVERHEAD_LIMIT );
     char *url = NULL;
+#ifdef SRT_HAVE_GROUPS
+    char *psz_group = NULL;
+#endif
     srt_params_t params;
     struct addrinfo hints = {
         .ai_socktype = SOCK_DGRAM,
@@ -116,7 +123,14 @@ static bool srt_schedule_reconnect(sout_access_out_t *p_access)
         srt_close( p_sys->sock );
     }
 
-    p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
+#ifdef SRT_HAVE_GROUPS
+    psz_group = var_InheritString( p_access, SRT_PARAM_GROUP_TYPE );
+    p_sys->b_group = psz_group != NULL && psz_group[0] != '\0';
+    if ( p_sys->b_group )
+        p_sys->sock = srt_group_create( access_obj, psz_group );
+    else
+#endif
+        p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
     if ( p_sys->sock == SRT_INVALID_SOCK )
     {
         msg_Err( p_access, "Failed to open socket." );
@@ -186,12 +200,27 @@ static bool srt_schedule_reconnect(sout_access_out_t *p_access)
     msg_Dbg( p_access, "Schedule SRT connect (dest addresss: %s, port: %d).",
         psz_dst_addr, i_dst_port );
 
-    stat = srt_connect( p_sys->sock, res->ai_addr, res->ai_addrlen );
-    if ( stat == SRT_ERROR )
+#ifdef SRT_HAVE_GROUPS
+    if ( p_sys->b_group )
     {
-        msg_Err( p_access, "Failed to connect to server (reason: %s)",
-                 srt_getlasterror_str() );
-        failed = true;
+        char *psz_links = var_InheritString( p_access, SRT_PARAM_GROUP_LINKS );
+
+        stat = srt_group_connect( access_obj, p_sys->sock, res, psz_links );
+        free( psz_links );
+        if ( stat == SRT_ERROR )
+            failed = true;
+        p_sys->i_stats_date = vlc_tick_now() + SRT_GROUP_STATS_PERIOD;
+    }
+    else
+#endif
+    {
+        stat = srt_connect( p_sys->sock, res->ai_addr, res->ai_addrlen );
+        if ( stat == SRT_ERROR )
+        {
+            msg_Err( p_access, "Failed to connect to server (reason: %s)",
+                     srt_getlasterror_str() );
+            failed = true;
+        }
     }
 
 out:
@@ -204,6 +233,9 @@ out:
 
     if (passphrase_needs_free)
         free( psz_passphrase );
+#ifdef SRT_HAVE_GROUPS
+    free( psz_group );
+#endif
     free( psz_dst_addr );
     free( url );
     freeaddrinfo( res );
@@ -295,17 +327,25 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
             if ( readycnt > 0  && ready[0] == p_sys->sock
                 && srt_getsockstate( p_sys->sock ) == SRTS_CONNECTED)
             {
-                size_t i_write = __MIN( p_buffer->i_buffer, i_chunk_size );
-                if (srt_sendmsg2( p_sys->sock,
-                    (char *)p_buffer->p_buffer, i_write, 0 ) == SRT_ERROR )
+                /* Queue as many chunks as the library accepts before
+                 * polling again */
+                while( p_buffer->i_buffer )
                 {
-                    msg_Warn( p_access, "send error: %s", srt_getlasterror_str() );
-                    i_len = VLC_EGENERIC;
-                    goto out;
+                    size_t i_write = __MIN( p_buffer->i_buffer, i_chunk_size );
+                    if (srt_sendmsg2( p_sys->sock,
+                        (char *)p_buffer->p_buffer, i_write, 0 ) == SRT_ERROR )
+                    {
+                        if ( srt_getlasterror( NULL ) == SRT_EASYNCSND )
+                            break; /* Sender buffer full */
+
+                        msg_Warn( p_access, "send error: %s", srt_getlasterror_str() );
+                        i_len = VLC_EGENERIC;
+                        goto out;
+                    }
+
+                    p_buffer->p_buffer += i_write;
+                    p_buffer->i_buffer -= i_write;
                 }
-
-                p_buffer->p_buffer += i_write;
-                p_buffer->i_buffer -= i_write;
             }
         }
 
@@ -332,6 +372,14 @@ out:
     }
     vlc_mutex_unlock( &p_sys->lock );
 
+#ifdef SRT_HAVE_GROUPS
+    if ( p_sys->b_group && vlc_tick_now() >= p_sys->i_stats_date )
+    {
+        srt_group_log_stats( VLC_OBJECT(p_access), p_sys->sock );
+        p_sys->i_stats_date += SRT_GROUP_STATS_PERIOD;
+    }
+#endif
+
     if ( i_len <= 0 ) block_ChainRelease( p_buffer );
     return i_len;
 }
@@ -448,6 +496,13 @@ vlc_module_begin()
     add_integer( SRT_PARAM_KEY_LENGTH, SRT_DEFAULT_KEY_LENGTH, SRT_KEY_LENGTH_TEXT,
             SRT_KEY_LENGTH_TEXT, false )
     change_integer_list( srt_key_lengths, srt_key_length_names )
+#ifdef SRT_HAVE_GROUPS
+    add_string( SRT_PARAM_GROUP_TYPE, "", SRT_GROUP_TYPE_TEXT,
+            SRT_GROUP_TYPE_LONGTEXT, true )
+    change_string_list( srt_group_types, srt_group_type_names )
+    add_string( SRT_PARAM_GROUP_LINKS, NULL, SRT_GROUP_LINKS_TEXT,
+            SRT_GROUP_LINKS_LONGTEXT, true )
+#endif
 
     set_capability( "sout access", 0 )
     add_shortcut( "srt" )
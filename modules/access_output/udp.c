@@ -48,6 +48,14 @@
 
 #include <vlc_network.h>
 
+#if defined(__linux__) && defined(HAVE_SENDMMSG)
+#   include <time.h>
+#   include <linux/net_tstamp.h>
+#   ifdef SO_TXTIME
+#       define HAVE_TXTIME 1
+#   endif
+#endif
+
 #define MAX_EMPTY_BLOCKS 200
 
 /*****************************************************************************
@@ -69,6 +77,25 @@ static void Close( vlc_object_t * );
                           "of packets that will be sent at a time. It " \
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
+#define WINDOW_TEXT N_("Batching window (ms)")
+#define WINDOW_LONGTEXT N_("Packets due within this interval after a " \
+                           "pacing point are sent together, with a " \
+                           "single system call. This reduces the system " \
+                           "call overhead at the expense of pacing " \
+                           "accuracy.")
+#define TXTIME_TEXT N_("Kernel pacing clock")
+#define TXTIME_LONGTEXT N_("Stamp each datagram with its transmission time " \
+                           "(SO_TXTIME) and let the kernel queueing " \
+                           "discipline pace the output, instead of " \
+                           "sleeping before sending. Use the monotonic " \
+                           "clock with the fq qdisc, or the TAI clock " \
+                           "with the etf qdisc.")
+
+#ifdef HAVE_TXTIME
+static const char *const ppsz_txtime_values[] = { "", "monotonic", "tai" };
+static const char *const ppsz_txtime_descriptions[] = {
+    N_("Disabled"), N_("Monotonic (fq)"), N_("TAI (etf)") };
+#endif
 
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
@@ -78,6 +105,16 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+#ifdef HAVE_SENDMMSG
+    add_integer( SOUT_CFG_PREFIX "window", 0, WINDOW_TEXT, WINDOW_LONGTEXT,
+                 true )
+        change_integer_range( 0, 1000 )
+#endif
+#ifdef HAVE_TXTIME
+    add_string( SOUT_CFG_PREFIX "txtime", "", TXTIME_TEXT, TXTIME_LONGTEXT,
+                true )
+        change_string_list( ppsz_txtime_values, ppsz_txtime_descriptions )
+#endif
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -91,6 +128,12 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+#ifdef HAVE_SENDMMSG
+    "window",
+#endif
+#ifdef HAVE_TXTIME
+    "txtime",
+#endif
     NULL
 };
 
@@ -114,9 +157,15 @@ typedef struct
     bool          b_mtu_warning;
     size_t        i_mtu;
 
-    block_fifo_t *p_fifo;
+    /* Write() is the only producer, ThreadWrite() the only consumer */
+    vlc_spsc_fifo_t *p_fifo;
     block_t      *p_buffer;
 
+#ifdef HAVE_TXTIME
+    /* Kernel pacing reference clock, or -1 for userland pacing */
+    clockid_t     txtime_clock;
+#endif
+
     vlc_thread_t  thread;
 } sout_access_out_sys_t;
 
@@ -206,14 +255,37 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_handle = i_handle;
     p_sys->i_mtu = var_CreateGetInteger( p_this, "mtu" );
     p_sys->b_mtu_warning = false;
-    p_sys->p_fifo = block_FifoNew();
+    p_sys->p_fifo = vlc_spsc_fifo_New();
     p_sys->p_buffer = NULL;
 
+#ifdef HAVE_TXTIME
+    p_sys->txtime_clock = -1;
+
+    char *psz_txtime = var_GetNonEmptyString( p_access,
+                                              SOUT_CFG_PREFIX "txtime" );
+    if( psz_txtime != NULL )
+    {
+        struct sock_txtime txtime = {
+            .clockid = strcmp( psz_txtime, "tai" ) ? CLOCK_MONOTONIC
+                                                   : CLOCK_TAI,
+            .flags = 0,
+        };
+
+        if( setsockopt( i_handle, SOL_SOCKET, SO_TXTIME, &txtime,
+                        sizeof (txtime) ) == 0 )
+            p_sys->txtime_clock = txtime.clockid;
+        else
+            msg_Warn( p_access, "kernel pacing not available: %s",
+                      vlc_strerror_c(errno) );
+        free( psz_txtime );
+    }
+#endif
+
     if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
     {
         msg_Err( p_access, "cannot spawn sout access thread" );
-        block_FifoRelease( p_sys->p_fifo );
+        vlc_spsc_fifo_Delete( p_sys->p_fifo );
         net_Close (i_handle);
         free (p_sys);
         return VLC_EGENERIC;
@@ -235,7 +307,7 @@ static void Close( vlc_object_t * p_this )
 
     vlc_cancel( p_sys->thread );
     vlc_join( p_sys->thread, NULL );
-    block_FifoRelease( p_sys->p_fifo );
+    vlc_spsc_fifo_Delete( p_sys->p_fifo );
 
     if( p_sys->p_buffer ) block_Release( p_sys->p_buffer );
 
@@ -290,7 +362,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                          now - p_sys->p_buffer->i_dts
                           - p_sys->i_caching );
             }
-            block_FifoPut( p_sys->p_fifo, p_sys->p_buffer );
+            vlc_spsc_fifo_Queue( p_sys->p_fifo, p_sys->p_buffer );
             p_sys->p_buffer = NULL;
         }
 
@@ -332,7 +404,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                              vlc_tick_now() - p_sys->p_buffer->i_dts
                               - p_sys->i_caching );
                 }
-                block_FifoPut( p_sys->p_fifo, p_sys->p_buffer );
+                vlc_spsc_fifo_Queue( p_sys->p_fifo, p_sys->p_buffer );
                 p_sys->p_buffer = NULL;
             }
         }
@@ -348,6 +420,97 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 /*****************************************************************************
  * ThreadWrite: Write a packet on the network at the good time.
  *****************************************************************************/
+#ifdef HAVE_SENDMMSG
+/* Maximum number of datagrams sent per system call */
+#define VLEN 64
+
+struct udp_batch
+{
+    block_t *pending;
+    unsigned count;
+    block_t *blocks[VLEN];
+    struct mmsghdr msgs[VLEN];
+    struct iovec iovecs[VLEN];
+#ifdef HAVE_TXTIME
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof (uint64_t))];
+    } cmsgs[VLEN];
+#endif
+};
+
+static void BatchCleanup( void *data )
+{
+    struct udp_batch *batch = data;
+
+    for( unsigned i = 0; i < batch->count; i++ )
+        block_Release( batch->blocks[i] );
+    batch->count = 0;
+    if( batch->pending != NULL )
+        block_Release( batch->pending );
+    batch->pending = NULL;
+}
+
+static void BatchSend( sout_access_out_t *p_access, struct udp_batch *batch )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+#ifdef HAVE_TXTIME
+    vlc_tick_t i_clock_offset = 0;
+
+    if( p_sys->txtime_clock != CLOCK_MONOTONIC && p_sys->txtime_clock != -1 )
+    {   /* vlc_tick_now() is based on the monotonic clock */
+        struct timespec ts;
+
+        clock_gettime( p_sys->txtime_clock, &ts );
+        i_clock_offset = vlc_tick_from_timespec( &ts ) - vlc_tick_now();
+    }
+#endif
+
+    for( unsigned i = 0; i < batch->count; i++ )
+    {
+        batch->iovecs[i].iov_base = batch->blocks[i]->p_buffer;
+        batch->iovecs[i].iov_len = batch->blocks[i]->i_buffer;
+        memset( &batch->msgs[i], 0, sizeof (batch->msgs[i]) );
+        batch->msgs[i].msg_hdr.msg_iov = &batch->iovecs[i];
+        batch->msgs[i].msg_hdr.msg_iovlen = 1;
+#ifdef HAVE_TXTIME
+        if( p_sys->txtime_clock != -1 )
+        {
+            struct msghdr *msg = &batch->msgs[i].msg_hdr;
+            uint64_t txtime = NS_FROM_VLC_TICK( batch->blocks[i]->i_dts
+                                                + p_sys->i_caching
+                                                + i_clock_offset );
+
+            msg->msg_control = batch->cmsgs[i].buf;
+            msg->msg_controllen = sizeof (batch->cmsgs[i].buf);
+
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR( msg );
+
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TXTIME;
+            cmsg->cmsg_len = CMSG_LEN( sizeof (txtime) );
+            memcpy( CMSG_DATA( cmsg ), &txtime, sizeof (txtime) );
+        }
+#endif
+    }
+
+    for( unsigned i = 0; i < batch->count; )
+    {
+        int val = sendmmsg( p_sys->i_handle, batch->msgs + i,
+                            batch->count - i, 0 );
+        if( val == -1 )
+        {
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            val = 1; /* skip the failed datagram */
+        }
+        i += val;
+    }
+
+    for( unsigned i = 0; i < batch->count; i++ )
+        block_Release( batch->blocks[i] );
+    batch->count = 0;
+}
+
 static void* ThreadWrite( void *data )
 {
     sout_access_out_t *p_access = data;
@@ -355,12 +518,116 @@ static void* ThreadWrite( void *data )
     vlc_tick_t i_date_last = -1;
     const unsigned i_group = var_GetInteger( p_access,
                                              SOUT_CFG_PREFIX "group" );
+    const vlc_tick_t i_window = VLC_TICK_FROM_MS(
+                        var_GetInteger( p_access, SOUT_CFG_PREFIX "window" ) );
     int i_to_send = i_group;
     unsigned i_dropped_packets = 0;
+    /* Pacing date of the current batch, if any */
+    vlc_tick_t i_deadline = VLC_TICK_INVALID;
+    struct udp_batch batch = { .pending = NULL, .count = 0 };
+#ifdef HAVE_TXTIME
+    /* With kernel pacing, queue datagrams as soon as possible */
+    const bool b_kernel_pacing = p_sys->txtime_clock != -1;
+#else
+    const bool b_kernel_pacing = false;
+#endif
 
+    vlc_cleanup_push( BatchCleanup, &batch );
     for (;;)
     {
-        block_t *p_pk = block_FifoGet( p_sys->p_fifo );
+        block_t *p_pk = batch.pending;
+
+        batch.pending = NULL;
+        if( p_pk == NULL )
+            p_pk = batch.count ? vlc_spsc_fifo_Dequeue( p_sys->p_fifo )
+                               : vlc_spsc_fifo_Get( p_sys->p_fifo );
+
+        if( p_pk != NULL )
+        {
+            vlc_tick_t i_date = p_sys->i_caching + p_pk->i_dts;
+
+            if( i_date_last > 0 )
+            {
+                if( i_date - i_date_last > VLC_TICK_FROM_SEC(2) )
+                {
+                    if( !i_dropped_packets )
+                        msg_Dbg( p_access, "mmh, hole (%"PRId64" > 2s) -> drop",
+                                 i_date - i_date_last );
+
+                    block_Release( p_pk );
+
+                    i_date_last = i_date;
+                    i_dropped_packets++;
+                    continue;
+                }
+                else if( i_date - i_date_last < VLC_TICK_FROM_MS(-1) )
+                {
+                    if( !i_dropped_packets )
+                        msg_Dbg( p_access, "mmh, packets in the past (%"PRId64")",
+                                 i_date_last - i_date );
+                }
+            }
+
+            bool b_pace = i_to_send == 1 || (p_pk->i_flags & BLOCK_FLAG_CLOCK);
+
+            if( batch.count == VLEN
+             || (!b_kernel_pacing && i_deadline != VLC_TICK_INVALID
+              && i_date > i_deadline + i_window)
+             || (!b_kernel_pacing && i_deadline == VLC_TICK_INVALID
+              && b_pace && batch.count) )
+            {   /* Send the current batch first */
+                batch.pending = p_pk;
+            }
+            else
+            {
+                batch.blocks[batch.count++] = p_pk;
+                if( --i_to_send == 0 || b_pace )
+                {
+                    if( i_deadline == VLC_TICK_INVALID )
+                        i_deadline = i_date;
+                    i_to_send = i_group;
+                }
+
+                if( i_dropped_packets )
+                {
+                    msg_Dbg( p_access, "dropped %i packets", i_dropped_packets );
+                    i_dropped_packets = 0;
+                }
+                i_date_last = i_date;
+                continue;
+            }
+        }
+
+        /* Nothing else is due within the window: flush */
+        if( i_deadline != VLC_TICK_INVALID && !b_kernel_pacing )
+            vlc_tick_wait( i_deadline );
+        BatchSend( p_access, &batch );
+        i_deadline = VLC_TICK_INVALID;
+
+        vlc_tick_t i_late = vlc_tick_now() - i_date_last;
+        if ( i_late > VLC_TICK_FROM_MS(20) + i_window )
+        {
+            msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
+                     i_late );
+        }
+    }
+    vlc_cleanup_pop();
+    return NULL;
+}
+#else
+static void* ThreadWrite( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    vlc_tick_t i_date_last = -1;
+    const unsigned i_group = var_GetInteger( p_access,
+                                             SOUT_CFG_PREFIX "group" );
+    int i_to_send = i_group;
+    unsigned i_dropped_packets = 0;
+
+    for (;;)
+    {
+        block_t *p_pk = vlc_spsc_fifo_Get( p_sys->p_fifo );
         vlc_tick_t    i_date;
 
         i_date = p_sys->i_caching + p_pk->i_dts;
@@ -419,3 +686,4 @@ static void* ThreadWrite( void *data )
     }
     return NULL;
 }
+#endif
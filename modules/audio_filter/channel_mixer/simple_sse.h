@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * simple_sse.h : simple channel mixer plug-in using SSE intrinsics
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <vlc_cpu.h>
+#include <xmmintrin.h>
+
+/* Only conversion to Mono and Stereo right now */
+/* Only from 7/7.1/6.1/5/5.1
+ * XXX 5.X rear and middle are handled the same way */
+
+/* Each output sample is the dot product of the (up to 8) input channels of
+ * the frame with a row of coefficients; the LFE, if any, is left out. */
+typedef float simple_matrix_t[2][8];
+
+static inline unsigned SimpleStride( filter_t *p_filter, unsigned channels )
+{
+    return channels +
+        !!(p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE);
+}
+
+static inline float SimpleDot( const float *p_src, const float *p_coef,
+                               unsigned stride )
+{
+    float sum = 0.f;
+    for( unsigned i = 0; i < stride; i++ )
+        sum += p_src[i] * p_coef[i];
+    return sum;
+}
+
+__attribute__ ((__target__ ("sse")))
+static void SimpleMix_SSE( float *p_dest, const float *p_src, int frames,
+                           unsigned stride, const simple_matrix_t matrix,
+                           bool stereo )
+{
+    const __m128 l_lo = _mm_loadu_ps( matrix[0] );
+    const __m128 l_hi = _mm_loadu_ps( matrix[0] + 4 );
+    const __m128 r_lo = _mm_loadu_ps( matrix[1] );
+    const __m128 r_hi = _mm_loadu_ps( matrix[1] + 4 );
+
+    /* Eight channels are loaded: leave the last frames to the scalar code
+     * so as not to read past the end of the buffer. */
+    int simd = frames - (8 - 1) / stride;
+
+    for( ; simd > 0; simd--, frames-- )
+    {
+        __m128 lo = _mm_loadu_ps( p_src );
+        __m128 hi = _mm_loadu_ps( p_src + 4 );
+        __m128 l = _mm_add_ps( _mm_mul_ps( lo, l_lo ), _mm_mul_ps( hi, l_hi ) );
+
+        if( stereo )
+        {
+            __m128 r = _mm_add_ps( _mm_mul_ps( lo, r_lo ),
+                                   _mm_mul_ps( hi, r_hi ) );
+            /* l0+l2 r0+r2 l1+l3 r1+r3 */
+            __m128 s = _mm_add_ps( _mm_unpacklo_ps( l, r ),
+                                   _mm_unpackhi_ps( l, r ) );
+            _mm_storel_pi( (__m64 *)p_dest, _mm_add_ps( s, _mm_movehl_ps( s, s ) ) );
+            p_dest += 2;
+        }
+        else
+        {
+            __m128 s = _mm_add_ps( l, _mm_movehl_ps( l, l ) );
+            s = _mm_add_ss( s, _mm_shuffle_ps( s, s, _MM_SHUFFLE(1,1,1,1) ) );
+            _mm_store_ss( p_dest++, s );
+        }
+        p_src += stride;
+    }
+
+    for( ; frames > 0; frames-- )
+    {
+        *p_dest++ = SimpleDot( p_src, matrix[0], stride );
+        if( stereo )
+            *p_dest++ = SimpleDot( p_src, matrix[1], stride );
+        p_src += stride;
+    }
+}
+
+#define SSE_WRAPPER(in, out, channels, stereo, ...) \
+    static void DoWork_##in##_to_##out##_sse( filter_t *p_filter, block_t *p_in_buf, block_t *p_out_buf ) \
+    { \
+        static const simple_matrix_t matrix = __VA_ARGS__; \
+        SimpleMix_SSE( (float *)p_out_buf->p_buffer, \
+                       (const float *)p_in_buf->p_buffer, p_in_buf->i_nb_samples, \
+                       SimpleStride( p_filter, channels ), matrix, stereo ); \
+    } \
+    static inline void (*GET_WORK_##in##_to_##out##_sse())(filter_t*, block_t*, block_t*) \
+    { \
+        return vlc_CPU_SSE() ? DoWork_##in##_to_##out##_sse : DoWork_##in##_to_##out; \
+    }
+
+SSE_WRAPPER(7_x,2_0, 7, true,
+            { { 1.f, 0.f, .25f, 0.f, .25f, 0.f, .7071f, 0.f },
+              { 0.f, 1.f, 0.f, .25f, 0.f, .25f, .7071f, 0.f } })
+/* 6.1 always has the LFE */
+SSE_WRAPPER(6_1,2_0, 6, true,
+            { { 1.f, 0.f, .7071f, 1.f, 0.f, .7071f, 0.f, 0.f },
+              { 0.f, 1.f, .7071f, 0.f, 1.f, .7071f, 0.f, 0.f } })
+SSE_WRAPPER(5_x,2_0, 5, true,
+            { { 1.f, 0.f, .7071f, 0.f, .7071f, 0.f, 0.f, 0.f },
+              { 0.f, 1.f, 0.f, .7071f, .7071f, 0.f, 0.f, 0.f } })
+SSE_WRAPPER(7_x,1_0, 7, false,
+            { { .25f, .25f, .125f, .125f, .125f, .125f, 1.f, 0.f } })
+SSE_WRAPPER(5_x,1_0, 5, false,
+            { { .7071f, .7071f, .5f, .5f, 1.f, 0.f, 0.f, 0.f } })
+
+/* TODO: the following conversions are not handled in SSE */
+
+#define C_WRAPPER(in, out) \
+    static inline void (*GET_WORK_##in##_to_##out##_sse())(filter_t*, block_t*, block_t*) \
+    { \
+        return DoWork_##in##_to_##out; \
+    }
+
+C_WRAPPER(4_0,2_0)
+C_WRAPPER(3_x,2_0)
+C_WRAPPER(4_0,1_0)
+C_WRAPPER(3_x,1_0)
+C_WRAPPER(2_x,1_0)
+C_WRAPPER(7_x,4_0)
+C_WRAPPER(5_x,4_0)
+C_WRAPPER(7_x,5_x)
+C_WRAPPER(6_1,5_x)
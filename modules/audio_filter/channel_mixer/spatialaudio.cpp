@@ -118,6 +118,7 @@ struct filter_spatialaudio
     CAmbisonicDecoder speakerDecoder;
     CAmbisonicProcessor processor;
     CAmbisonicZoomer zoomer;
+    CBFormat inData;
 
     CAmbisonicSpeaker *speakers;
 
@@ -138,6 +139,7 @@ struct filter_spatialaudio
     float f_phi;
     float f_roll;
     float f_zoom;
+    bool b_viewpoint_changed; // the rotation and zoom need to be refreshed
 };
 
 static std::string getHRTFPath(filter_t *p_filter)
@@ -183,7 +185,7 @@ static block_t *Mix( filter_t *p_filter, block_t *p_buf )
     const size_t i_outputBlockSize = sizeof(float) * p_sys->i_outputNb * AMB_BLOCK_TIME_LEN;
     const size_t i_nbBlocks = p_sys->inputSamples.size() * sizeof(float) / i_inputBlockSize;
 
-    block_t *p_out_buf = block_Alloc(i_outputBlockSize * i_nbBlocks);
+    block_t *p_out_buf = filter_NewAudioBuffer(p_filter, i_outputBlockSize * i_nbBlocks);
     if (unlikely(p_out_buf == NULL))
     {
         block_Release(p_buf);
@@ -221,19 +223,24 @@ static block_t *Mix( filter_t *p_filter, block_t *p_buf )
             case filter_spatialaudio::AMBISONICS_DECODER:
             case filter_spatialaudio::AMBISONICS_BINAURAL_DECODER:
             {
-                CBFormat inData;
-                inData.Configure(p_sys->i_order, true, AMB_BLOCK_TIME_LEN);
+                CBFormat &inData = p_sys->inData;
 
                 for (unsigned i = 0; i < p_sys->i_inputNb - p_sys->i_nondiegetic; ++i)
                     inData.InsertStream(p_sys->inBuf[i], i, AMB_BLOCK_TIME_LEN);
 
-                Orientation ori(p_sys->f_teta, p_sys->f_phi, p_sys->f_roll);
-                p_sys->processor.SetOrientation(ori);
-                p_sys->processor.Refresh();
-                p_sys->processor.Process(&inData, inData.GetSampleCount());
+                /* The rotation and zoom coefficients only need to be
+                 * recomputed when the viewpoint moves. */
+                if (p_sys->b_viewpoint_changed)
+                {
+                    Orientation ori(p_sys->f_teta, p_sys->f_phi, p_sys->f_roll);
+                    p_sys->processor.SetOrientation(ori);
+                    p_sys->processor.Refresh();
 
-                p_sys->zoomer.SetZoom(p_sys->f_zoom);
-                p_sys->zoomer.Refresh();
+                    p_sys->zoomer.SetZoom(p_sys->f_zoom);
+                    p_sys->zoomer.Refresh();
+                    p_sys->b_viewpoint_changed = false;
+                }
+                p_sys->processor.Process(&inData, inData.GetSampleCount());
                 p_sys->zoomer.Process(&inData, inData.GetSampleCount());
 
                 if (p_sys->mode == filter_spatialaudio::AMBISONICS_DECODER)
@@ -289,15 +296,26 @@ static void ChangeViewpoint( filter_t *p_filter, const vlc_viewpoint_t *p_vp)
     filter_spatialaudio *p_sys = reinterpret_cast<filter_spatialaudio *>(p_filter->p_sys);
 
 #define RAD(d) ((float) ((d) * M_PI / 180.f))
-    p_sys->f_teta = -RAD(p_vp->yaw);
-    p_sys->f_phi = RAD(p_vp->pitch);
-    p_sys->f_roll = RAD(p_vp->roll);
+    float f_teta = -RAD(p_vp->yaw);
+    float f_phi = RAD(p_vp->pitch);
+    float f_roll = RAD(p_vp->roll);
+    float f_zoom;
 
     if (p_vp->fov >= FIELD_OF_VIEW_DEGREES_DEFAULT)
-        p_sys->f_zoom = 0.f; // no unzoom as it does not really make sense.
+        f_zoom = 0.f; // no unzoom as it does not really make sense.
     else
-        p_sys->f_zoom = (FIELD_OF_VIEW_DEGREES_DEFAULT - p_vp->fov) / (FIELD_OF_VIEW_DEGREES_DEFAULT - FIELD_OF_VIEW_DEGREES_MIN);
+        f_zoom = (FIELD_OF_VIEW_DEGREES_DEFAULT - p_vp->fov) / (FIELD_OF_VIEW_DEGREES_DEFAULT - FIELD_OF_VIEW_DEGREES_MIN);
 #undef RAD
+
+    if (f_teta != p_sys->f_teta || f_phi != p_sys->f_phi
+     || f_roll != p_sys->f_roll || f_zoom != p_sys->f_zoom)
+    {
+        p_sys->f_teta = f_teta;
+        p_sys->f_phi = f_phi;
+        p_sys->f_roll = f_roll;
+        p_sys->f_zoom = f_zoom;
+        p_sys->b_viewpoint_changed = true;
+    }
 }
 
 static int allocateBuffers(filter_spatialaudio *p_sys)
@@ -436,6 +454,7 @@ static int Open(vlc_object_t *p_this)
     p_sys->f_phi = 0.f;
     p_sys->f_roll = 0.f;
     p_sys->f_zoom = 0.f;
+    p_sys->b_viewpoint_changed = true;
     p_sys->i_inputNb = p_filter->fmt_in.audio.i_channels;
     p_sys->i_outputNb = p_filter->fmt_out.audio.i_channels;
 
@@ -549,6 +568,12 @@ static int Open(vlc_object_t *p_this)
         return VLC_EGENERIC;
     }
 
+    if (!p_sys->inData.Configure(p_sys->i_order, true, AMB_BLOCK_TIME_LEN))
+    {
+        delete p_sys;
+        return VLC_ENOMEM;
+    }
+
     p_filter->p_sys = p_sys;
     p_filter->pf_audio_filter = Mix;
     p_filter->pf_flush = Flush;
@@ -38,6 +38,14 @@
 #include <vlc_aout.h>
 #include <vlc_block.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -85,7 +93,7 @@ static int Open(vlc_object_t *object)
 /*** from U8 ***/
 static block_t *U8toS16(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -102,7 +110,7 @@ out:
 
 static block_t *U8toFl32(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 4);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -119,7 +127,7 @@ out:
 
 static block_t *U8toS32(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 4);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -136,7 +144,7 @@ out:
 
 static block_t *U8toFl64(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 8);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 8);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -167,7 +175,7 @@ static block_t *S16toU8(filter_t *filter, block_t *b)
 
 static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -195,7 +203,7 @@ out:
 
 static block_t *S16toS32(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -212,7 +220,7 @@ out:
 
 static block_t *S16toFl64(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 4);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -298,7 +306,7 @@ static block_t *Fl32toS32(filter_t *filter, block_t *b)
 
 static block_t *Fl32toFl64(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -351,7 +359,7 @@ static block_t *S32toFl32(filter_t *filter, block_t *b)
 
 static block_t *S32toFl64(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -438,6 +446,224 @@ static block_t *Fl64toS32(filter_t *filter, block_t *b)
 }
 
 
+
+#ifdef HAVE_SSE2_INTRINSICS
+/*** SSE2 versions of the FL32 <-> S16N/S32N conversions, giving the same
+ * results as the C ones, but for the rounding of exact halves ***/
+# define SSE2 __attribute__ ((__target__ ("sse2")))
+
+SSE2 static block_t *S16toFl32SSE2(filter_t *filter, block_t *bsrc)
+{
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
+    if (unlikely(bdst == NULL))
+        goto out;
+
+    block_CopyProperties(bdst, bsrc);
+    const int16_t *src = (const int16_t *)bsrc->p_buffer;
+    float *dst = (float *)bdst->p_buffer;
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    size_t n = bsrc->i_buffer / 2, i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    for (; i < n; i++)
+        dst[i] = src[i] / 32768.f;
+out:
+    block_Release(bsrc);
+    VLC_UNUSED(filter);
+    return bdst;
+}
+
+SSE2 static block_t *Fl32toS16SSE2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    const float *src = (const float *)b->p_buffer;
+    int16_t *dst = (int16_t *)b->p_buffer;
+    const __m128 scale = _mm_set1_ps(32768.f);
+    const __m128 max = _mm_set1_ps(32767.f), min = _mm_set1_ps(-32768.f);
+    size_t n = b->i_buffer / 4, i = 0;
+
+    /* In place: the samples are loaded before the narrower ones are stored */
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+        lo = _mm_max_ps(_mm_min_ps(lo, max), min);
+        hi = _mm_max_ps(_mm_min_ps(hi, max), min);
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(lo),
+                                         _mm_cvtps_epi32(hi)));
+    }
+    for (; i < n; i++)
+    {
+        float s = src[i] * 32768.f;
+        dst[i] = s >= 32767.f ? 32767 : s <= -32768.f ? -32768 : lroundf(s);
+    }
+    b->i_buffer /= 2;
+    return b;
+}
+
+SSE2 static block_t *Fl32toS32SSE2(filter_t *filter, block_t *b)
+{
+    float   *src = (float *)b->p_buffer;
+    int32_t *dst = (int32_t *)src;
+    const __m128 scale = _mm_set1_ps(2147483648.f);
+    const __m128 min = _mm_set1_ps(-2147483648.f);
+    size_t n = b->i_buffer / 4, i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 s = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        /* Too large values convert to INT32_MIN: flip them to INT32_MAX */
+        __m128i over = _mm_castps_si128(_mm_cmpge_ps(s, scale));
+        __m128i v = _mm_cvtps_epi32(_mm_max_ps(s, min));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(v, over));
+    }
+    for (; i < n; i++)
+    {
+        float s = src[i] * 2147483648.f;
+        dst[i] = s >= 2147483647.f ? 2147483647
+               : s <= -2147483648.f ? -2147483648 : lroundf(s);
+    }
+    VLC_UNUSED(filter);
+    return b;
+}
+
+SSE2 static block_t *S32toFl32SSE2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    int32_t *src = (int32_t*)b->p_buffer;
+    float   *dst = (float *)src;
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    size_t n = b->i_buffer / 4, i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    }
+    for (; i < n; i++)
+        dst[i] = (float)src[i] / 2147483648.f;
+    return b;
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+/*** AVX2 versions of the same conversions ***/
+# define AVX2 __attribute__ ((__target__ ("avx2")))
+
+AVX2 static block_t *S16toFl32AVX2(filter_t *filter, block_t *bsrc)
+{
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
+    if (unlikely(bdst == NULL))
+        goto out;
+
+    block_CopyProperties(bdst, bsrc);
+    const int16_t *src = (const int16_t *)bsrc->p_buffer;
+    float *dst = (float *)bdst->p_buffer;
+    const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+    size_t n = bsrc->i_buffer / 2, i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + i + 8)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(dst + i + 8,
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+    for (; i < n; i++)
+        dst[i] = src[i] / 32768.f;
+out:
+    block_Release(bsrc);
+    VLC_UNUSED(filter);
+    return bdst;
+}
+
+AVX2 static block_t *Fl32toS16AVX2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    const float *src = (const float *)b->p_buffer;
+    int16_t *dst = (int16_t *)b->p_buffer;
+    const __m256 scale = _mm256_set1_ps(32768.f);
+    const __m256 max = _mm256_set1_ps(32767.f), min = _mm256_set1_ps(-32768.f);
+    size_t n = b->i_buffer / 4, i = 0;
+
+    /* In place: the samples are loaded before the narrower ones are stored */
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256 lo = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        __m256 hi = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale);
+        lo = _mm256_max_ps(_mm256_min_ps(lo, max), min);
+        hi = _mm256_max_ps(_mm256_min_ps(hi, max), min);
+        /* The pack works within 128-bits lanes: restore the order */
+        __m256i v = _mm256_packs_epi32(_mm256_cvtps_epi32(lo),
+                                       _mm256_cvtps_epi32(hi));
+        _mm256_storeu_si256((__m256i *)(dst + i),
+                            _mm256_permute4x64_epi64(v, 0xd8));
+    }
+    for (; i < n; i++)
+    {
+        float s = src[i] * 32768.f;
+        dst[i] = s >= 32767.f ? 32767 : s <= -32768.f ? -32768 : lroundf(s);
+    }
+    b->i_buffer /= 2;
+    return b;
+}
+
+AVX2 static block_t *Fl32toS32AVX2(filter_t *filter, block_t *b)
+{
+    float   *src = (float *)b->p_buffer;
+    int32_t *dst = (int32_t *)src;
+    const __m256 scale = _mm256_set1_ps(2147483648.f);
+    const __m256 min = _mm256_set1_ps(-2147483648.f);
+    size_t n = b->i_buffer / 4, i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 s = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        /* Too large values convert to INT32_MIN: flip them to INT32_MAX */
+        __m256i over = _mm256_castps_si256(_mm256_cmp_ps(s, scale, _CMP_GE_OQ));
+        __m256i v = _mm256_cvtps_epi32(_mm256_max_ps(s, min));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(v, over));
+    }
+    for (; i < n; i++)
+    {
+        float s = src[i] * 2147483648.f;
+        dst[i] = s >= 2147483647.f ? 2147483647
+               : s <= -2147483648.f ? -2147483648 : lroundf(s);
+    }
+    VLC_UNUSED(filter);
+    return b;
+}
+
+AVX2 static block_t *S32toFl32AVX2(filter_t *filter, block_t *b)
+{
+    VLC_UNUSED(filter);
+    int32_t *src = (int32_t*)b->p_buffer;
+    float   *dst = (float *)src;
+    const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+    size_t n = b->i_buffer / 4, i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    }
+    for (; i < n; i++)
+        dst[i] = (float)src[i] / 2147483648.f;
+    return b;
+}
+#endif
+
 /* */
 /* */
 static const struct {
@@ -473,8 +699,35 @@ static const struct {
     { 0, 0, NULL }
 };
 
+static const struct {
+    vlc_fourcc_t src;
+    vlc_fourcc_t dst;
+    cvt_t convert;
+    unsigned cpu; /* required VLC_CPU_* flags */
+} cvt_simds[] = {
+#ifdef HAVE_AVX2_INTRINSICS
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32AVX2, VLC_CPU_AVX2 },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16AVX2, VLC_CPU_AVX2 },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32AVX2, VLC_CPU_AVX2 },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32AVX2, VLC_CPU_AVX2 },
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32SSE2, VLC_CPU_SSE2 },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16SSE2, VLC_CPU_SSE2 },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32SSE2, VLC_CPU_SSE2 },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32SSE2, VLC_CPU_SSE2 },
+#endif
+    { 0, 0, NULL, 0 }
+};
+
 static cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst)
 {
+    for (int i = 0; cvt_simds[i].convert; i++) {
+        if (cvt_simds[i].src == src &&
+            cvt_simds[i].dst == dst &&
+            (vlc_CPU() & cvt_simds[i].cpu) == cvt_simds[i].cpu)
+            return cvt_simds[i].convert;
+    }
     for (int i = 0; cvt_directs[i].convert; i++) {
         if (cvt_directs[i].src == src &&
             cvt_directs[i].dst == dst)
@@ -31,6 +31,7 @@
 #include <assert.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_plugin.h>
 
 #include <vlc_aout.h>
@@ -50,8 +51,34 @@ vlc_module_begin ()
     set_callbacks( Open, Close )
 vlc_module_end ()
 
+/* The bursts are assembled in recycled buffers: the output keeps a few
+ * hundred milliseconds of them queued, and allocating tens of kilobytes per
+ * burst (TrueHD, E-AC3, DTS-HD) costs fresh pages at a high rate. The pool
+ * lives until the filter is closed and the last queued burst is released. */
+#define SPDIF_POOL_MAX 32
+
+typedef struct spdif_pool spdif_pool_t;
+
+struct spdif_burst
+{
+    block_t self;
+    spdif_pool_t *p_pool;
+    size_t i_size;
+    struct spdif_burst *p_next;
+    max_align_t p_data[];
+};
+
+struct spdif_pool
+{
+    vlc_atomic_rc_t rc;
+    vlc_mutex_t lock;
+    struct spdif_burst *p_free;
+    unsigned i_free;
+};
+
 typedef struct
 {
+    spdif_pool_t *p_pool;
     block_t *p_out_buf;
     size_t i_out_offset;
 
@@ -86,6 +113,77 @@ typedef struct
 #define SPDIF_SUCCESS VLC_SUCCESS
 #define SPDIF_ERROR VLC_EGENERIC
 
+static void spdif_pool_Release( spdif_pool_t *p_pool )
+{
+    if( !vlc_atomic_rc_dec( &p_pool->rc ) )
+        return;
+
+    for( struct spdif_burst *p_burst = p_pool->p_free, *p_next;
+         p_burst != NULL; p_burst = p_next )
+    {
+        p_next = p_burst->p_next;
+        free( p_burst );
+    }
+    free( p_pool );
+}
+
+static void spdif_burst_Release( block_t *p_block )
+{
+    struct spdif_burst *p_burst =
+        container_of( p_block, struct spdif_burst, self );
+    spdif_pool_t *p_pool = p_burst->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    if( p_pool->i_free < SPDIF_POOL_MAX )
+    {
+        p_burst->p_next = p_pool->p_free;
+        p_pool->p_free = p_burst;
+        p_pool->i_free++;
+        p_burst = NULL;
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+
+    free( p_burst );
+    spdif_pool_Release( p_pool );
+}
+
+static const struct vlc_block_callbacks spdif_burst_cbs =
+{
+    spdif_burst_Release,
+};
+
+static block_t *spdif_pool_Alloc( spdif_pool_t *p_pool, size_t i_size )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    struct spdif_burst *p_burst = p_pool->p_free;
+    if( p_burst != NULL )
+    {
+        p_pool->p_free = p_burst->p_next;
+        p_pool->i_free--;
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+
+    /* The burst size only changes with the codec frame length */
+    if( p_burst != NULL && p_burst->i_size < i_size )
+    {
+        free( p_burst );
+        p_burst = NULL;
+    }
+
+    if( p_burst == NULL )
+    {
+        p_burst = malloc( sizeof( *p_burst ) + i_size );
+        if( unlikely( p_burst == NULL ) )
+            return NULL;
+        p_burst->p_pool = p_pool;
+        p_burst->i_size = i_size;
+    }
+
+    vlc_atomic_rc_inc( &p_pool->rc );
+    return block_Init( &p_burst->self, &spdif_burst_cbs, p_burst->p_data,
+                       i_size );
+}
+
 static bool is_big_endian( filter_t *p_filter, block_t *p_in_buf )
 {
     switch( p_filter->fmt_in.audio.i_format )
@@ -179,7 +277,7 @@ static int write_init( filter_t *p_filter, block_t *p_in_buf,
     assert( p_sys->p_out_buf == NULL );
     assert( i_out_size > SPDIF_HEADER_SIZE && ( i_out_size & 3 ) == 0 );
 
-    p_sys->p_out_buf = block_Alloc( i_out_size );
+    p_sys->p_out_buf = spdif_pool_Alloc( p_sys->p_pool, i_out_size );
     if( !p_sys->p_out_buf )
         return VLC_ENOMEM;
     p_sys->p_out_buf->i_dts = p_in_buf->i_dts;
@@ -617,6 +715,17 @@ static int Open( vlc_object_t *p_this )
     if( unlikely( p_sys == NULL ) )
         return VLC_ENOMEM;
 
+    p_sys->p_pool = malloc( sizeof(*p_sys->p_pool) );
+    if( unlikely( p_sys->p_pool == NULL ) )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+    vlc_atomic_rc_init( &p_sys->p_pool->rc );
+    vlc_mutex_init( &p_sys->p_pool->lock );
+    p_sys->p_pool->p_free = NULL;
+    p_sys->p_pool->i_free = 0;
+
     p_filter->pf_audio_filter = DoWork;
     p_filter->pf_flush = Flush;
 
@@ -627,6 +736,9 @@ static void Close( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    filter_sys_t *p_sys = p_filter->p_sys;
+
     Flush( p_filter );
-    free( p_filter->p_sys );
+    spdif_pool_Release( p_sys->p_pool );
+    free( p_sys );
 }
@@ -36,11 +36,21 @@
 
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+#endif
 
 #include "equalizer_presets.h"
 
 /* TODO:
- *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
  *    computation (not too hard once the Q is found).
  *  - support for external preset
@@ -100,35 +110,51 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+/* The bands are filtered side by side in the SIMD lanes: their coefficients
+ * and states are padded to whole vectors with zeroes. */
+#define EQZ_LANES 16
+
 typedef struct
+{
+    float x[2];            /* x[n-1], x[n-2] */
+    float y[2][EQZ_LANES]; /* y[n-1], y[n-2] of each band */
+} eqz_state_t;
+
+typedef struct filter_sys_t filter_sys_t;
+
+/* Filters samples with the given stride in place, and scales them by gain */
+typedef void (*eqz_pass_t)( float *, unsigned, unsigned, float,
+                            eqz_state_t *, const filter_sys_t * );
+
+struct filter_sys_t
 {
     /* Filter static config */
     int i_band;
-    float *f_alpha;
-    float *f_beta;
-    float *f_gamma;
+    float f_alpha[EQZ_LANES];
+    float f_beta[EQZ_LANES];
+    float f_gamma[EQZ_LANES];
 
     /* Filter dyn config */
-    float *f_amp;   /* Per band amp */
+    float f_amp[EQZ_LANES];   /* Per band amp */
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
+    eqz_pass_t pass;
+
     /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
+    eqz_state_t state[32];
 
     /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    eqz_state_t state2[32];
 
     vlc_mutex_t lock;
-} filter_sys_t;
+};
 
 static block_t *DoWork( filter_t *, block_t * );
 
 #define EQZ_IN_FACTOR (0.25f)
 static int  EqzInit( filter_t *, int );
-static void EqzFilter( filter_t *, float *, float *, int, int );
+static void EqzFilter( filter_t *, float *, int, int );
 static void EqzClean( filter_t * );
 
 static int PresetCallback ( vlc_object_t *, char const *, vlc_value_t,
@@ -190,8 +216,7 @@ static void Close( vlc_object_t *p_this )
  *****************************************************************************/
 static block_t * DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
-    EqzFilter( p_filter, (float*)p_in_buf->p_buffer,
-               (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples,
+    EqzFilter( p_filter, (float*)p_in_buf->p_buffer, p_in_buf->i_nb_samples,
                aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
     return p_in_buf;
 }
@@ -276,61 +301,274 @@ static inline float EqzConvertdB( float db )
     return EQZ_IN_FACTOR * ( powf( 10.0f, db / 20.0f ) - 1.0f );
 }
 
+/*****************************************************************************
+ * Filter passes
+ *****************************************************************************/
+
+/* Zeroes the states that decayed to nothing, before they turn into slow
+ * denormals */
+static void EqzFlushState( eqz_state_t *st )
+{
+    for( int j = 0; j < EQZ_LANES; j++ )
+    {
+        if( fabsf( st->y[0][j] ) < 1e-20f )
+            st->y[0][j] = 0.0f;
+        if( fabsf( st->y[1][j] ) < 1e-20f )
+            st->y[1][j] = 0.0f;
+    }
+}
+
+static void EqzPass_c( float *buf, unsigned stride, unsigned samples,
+                       float gain, eqz_state_t *st, const filter_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < samples; i++, buf += stride )
+    {
+        const float x = *buf;
+        float o = 0.0f;
+
+        for( int j = 0; j < p_sys->i_band; j++ )
+        {
+            float y = p_sys->f_alpha[j] * ( x - st->x[1] ) +
+                      p_sys->f_gamma[j] * st->y[0][j] -
+                      p_sys->f_beta[j]  * st->y[1][j];
+
+            st->y[1][j] = st->y[0][j];
+            st->y[0][j] = y;
+
+            o += y * p_sys->f_amp[j];
+        }
+        st->x[1] = st->x[0];
+        st->x[0] = x;
+
+        /* We add source PCM + filtered PCM */
+        *buf = gain * ( EQZ_IN_FACTOR * x + o );
+    }
+    EqzFlushState( st );
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+#define EQZ_SSE_VECS ((EQZ_BANDS_MAX + 3) / 4)
+
+VLC_SSE
+static void EqzPass_sse( float *buf, unsigned stride, unsigned samples,
+                         float gain, eqz_state_t *st,
+                         const filter_sys_t *p_sys )
+{
+    __m128 alpha[EQZ_SSE_VECS], beta[EQZ_SSE_VECS], gamma[EQZ_SSE_VECS];
+    __m128 amp[EQZ_SSE_VECS], y1[EQZ_SSE_VECS], y2[EQZ_SSE_VECS];
+    float x1 = st->x[0], x2 = st->x[1];
+
+    for( int v = 0; v < EQZ_SSE_VECS; v++ )
+    {
+        alpha[v] = _mm_loadu_ps( &p_sys->f_alpha[4 * v] );
+        beta[v]  = _mm_loadu_ps( &p_sys->f_beta[4 * v] );
+        gamma[v] = _mm_loadu_ps( &p_sys->f_gamma[4 * v] );
+        amp[v]   = _mm_loadu_ps( &p_sys->f_amp[4 * v] );
+        y1[v]    = _mm_loadu_ps( &st->y[0][4 * v] );
+        y2[v]    = _mm_loadu_ps( &st->y[1][4 * v] );
+    }
+
+    /* Flush denormal results to zero */
+    const unsigned csr = _mm_getcsr();
+    _mm_setcsr( csr | _MM_FLUSH_ZERO_ON );
+
+    for( unsigned i = 0; i < samples; i++, buf += stride )
+    {
+        const float x = *buf;
+        const __m128 dx = _mm_set1_ps( x - x2 );
+        __m128 o = _mm_setzero_ps();
+
+        for( int v = 0; v < EQZ_SSE_VECS; v++ )
+        {
+            __m128 y = _mm_add_ps( _mm_mul_ps( alpha[v], dx ),
+                                   _mm_sub_ps( _mm_mul_ps( gamma[v], y1[v] ),
+                                               _mm_mul_ps( beta[v], y2[v] ) ) );
+            y2[v] = y1[v];
+            y1[v] = y;
+            o = _mm_add_ps( o, _mm_mul_ps( y, amp[v] ) );
+        }
+        x2 = x1;
+        x1 = x;
+
+        o = _mm_add_ps( o, _mm_movehl_ps( o, o ) );
+        o = _mm_add_ss( o, _mm_shuffle_ps( o, o, 1 ) );
+        *buf = gain * ( EQZ_IN_FACTOR * x + _mm_cvtss_f32( o ) );
+    }
+    _mm_setcsr( csr );
+
+    for( int v = 0; v < EQZ_SSE_VECS; v++ )
+    {
+        _mm_storeu_ps( &st->y[0][4 * v], y1[v] );
+        _mm_storeu_ps( &st->y[1][4 * v], y2[v] );
+    }
+    st->x[0] = x1;
+    st->x[1] = x2;
+    EqzFlushState( st );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+#define EQZ_AVX_VECS ((EQZ_BANDS_MAX + 7) / 8)
+
+__attribute__ ((__target__ ("avx")))
+static void EqzPass_avx( float *buf, unsigned stride, unsigned samples,
+                         float gain, eqz_state_t *st,
+                         const filter_sys_t *p_sys )
+{
+    __m256 alpha[EQZ_AVX_VECS], beta[EQZ_AVX_VECS], gamma[EQZ_AVX_VECS];
+    __m256 amp[EQZ_AVX_VECS], y1[EQZ_AVX_VECS], y2[EQZ_AVX_VECS];
+    float x1 = st->x[0], x2 = st->x[1];
+
+    for( int v = 0; v < EQZ_AVX_VECS; v++ )
+    {
+        alpha[v] = _mm256_loadu_ps( &p_sys->f_alpha[8 * v] );
+        beta[v]  = _mm256_loadu_ps( &p_sys->f_beta[8 * v] );
+        gamma[v] = _mm256_loadu_ps( &p_sys->f_gamma[8 * v] );
+        amp[v]   = _mm256_loadu_ps( &p_sys->f_amp[8 * v] );
+        y1[v]    = _mm256_loadu_ps( &st->y[0][8 * v] );
+        y2[v]    = _mm256_loadu_ps( &st->y[1][8 * v] );
+    }
+
+    /* Flush denormal results to zero */
+    const unsigned csr = _mm_getcsr();
+    _mm_setcsr( csr | _MM_FLUSH_ZERO_ON );
+
+    for( unsigned i = 0; i < samples; i++, buf += stride )
+    {
+        const float x = *buf;
+        const __m256 dx = _mm256_set1_ps( x - x2 );
+        __m256 o = _mm256_setzero_ps();
+
+        for( int v = 0; v < EQZ_AVX_VECS; v++ )
+        {
+            __m256 y = _mm256_add_ps( _mm256_mul_ps( alpha[v], dx ),
+                           _mm256_sub_ps( _mm256_mul_ps( gamma[v], y1[v] ),
+                                          _mm256_mul_ps( beta[v], y2[v] ) ) );
+            y2[v] = y1[v];
+            y1[v] = y;
+            o = _mm256_add_ps( o, _mm256_mul_ps( y, amp[v] ) );
+        }
+        x2 = x1;
+        x1 = x;
+
+        __m128 s = _mm_add_ps( _mm256_castps256_ps128( o ),
+                               _mm256_extractf128_ps( o, 1 ) );
+        s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+        s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+        *buf = gain * ( EQZ_IN_FACTOR * x + _mm_cvtss_f32( s ) );
+    }
+    _mm_setcsr( csr );
+
+    for( int v = 0; v < EQZ_AVX_VECS; v++ )
+    {
+        _mm256_storeu_ps( &st->y[0][8 * v], y1[v] );
+        _mm256_storeu_ps( &st->y[1][8 * v], y2[v] );
+    }
+    st->x[0] = x1;
+    st->x[1] = x2;
+    EqzFlushState( st );
+}
+#endif
+
+#ifdef __ARM_NEON
+#define EQZ_NEON_VECS ((EQZ_BANDS_MAX + 3) / 4)
+
+/* The ARM vector unit flushes denormals to zero by itself */
+static void EqzPass_neon( float *buf, unsigned stride, unsigned samples,
+                          float gain, eqz_state_t *st,
+                          const filter_sys_t *p_sys )
+{
+    float32x4_t alpha[EQZ_NEON_VECS], beta[EQZ_NEON_VECS];
+    float32x4_t gamma[EQZ_NEON_VECS], amp[EQZ_NEON_VECS];
+    float32x4_t y1[EQZ_NEON_VECS], y2[EQZ_NEON_VECS];
+    float x1 = st->x[0], x2 = st->x[1];
+
+    for( int v = 0; v < EQZ_NEON_VECS; v++ )
+    {
+        alpha[v] = vld1q_f32( &p_sys->f_alpha[4 * v] );
+        beta[v]  = vld1q_f32( &p_sys->f_beta[4 * v] );
+        gamma[v] = vld1q_f32( &p_sys->f_gamma[4 * v] );
+        amp[v]   = vld1q_f32( &p_sys->f_amp[4 * v] );
+        y1[v]    = vld1q_f32( &st->y[0][4 * v] );
+        y2[v]    = vld1q_f32( &st->y[1][4 * v] );
+    }
+
+    for( unsigned i = 0; i < samples; i++, buf += stride )
+    {
+        const float x = *buf;
+        float32x4_t o = vdupq_n_f32( 0.f );
+
+        for( int v = 0; v < EQZ_NEON_VECS; v++ )
+        {
+            float32x4_t y = vmulq_n_f32( alpha[v], x - x2 );
+            y = vmlaq_f32( y, gamma[v], y1[v] );
+            y = vmlsq_f32( y, beta[v], y2[v] );
+            y2[v] = y1[v];
+            y1[v] = y;
+            o = vmlaq_f32( o, y, amp[v] );
+        }
+        x2 = x1;
+        x1 = x;
+
+        float32x2_t s = vadd_f32( vget_low_f32( o ), vget_high_f32( o ) );
+        *buf = gain * ( EQZ_IN_FACTOR * x
+                      + vget_lane_f32( vpadd_f32( s, s ), 0 ) );
+    }
+
+    for( int v = 0; v < EQZ_NEON_VECS; v++ )
+    {
+        vst1q_f32( &st->y[0][4 * v], y1[v] );
+        vst1q_f32( &st->y[1][4 * v], y2[v] );
+    }
+    st->x[0] = x1;
+    st->x[1] = x2;
+    EqzFlushState( st );
+}
+#endif
+
 static int EqzInit( filter_t *p_filter, int i_rate )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = vlc_object_parent(p_filter);
-    int i_ret = VLC_ENOMEM;
 
     bool b_vlcFreqs = var_InheritBool( p_aout, "equalizer-vlcfreqs" );
     EqzCoeffs( i_rate, 1.0f, b_vlcFreqs, &cfg );
 
-    /* Create the static filter config */
+    /* Create the static filter config, the padding lanes stay zero */
+    static_assert( EQZ_BANDS_MAX <= EQZ_LANES, "Too many bands" );
     p_sys->i_band = cfg.i_band;
-    p_sys->f_alpha = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_beta  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    p_sys->f_gamma = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_alpha || !p_sys->f_beta || !p_sys->f_gamma )
-        goto error;
-
-    for( i = 0; i < p_sys->i_band; i++ )
+    for( i = 0; i < EQZ_LANES; i++ )
     {
-        p_sys->f_alpha[i] = cfg.band[i].f_alpha;
-        p_sys->f_beta[i]  = cfg.band[i].f_beta;
-        p_sys->f_gamma[i] = cfg.band[i].f_gamma;
+        p_sys->f_alpha[i] = i < p_sys->i_band ? cfg.band[i].f_alpha : 0.0f;
+        p_sys->f_beta[i]  = i < p_sys->i_band ? cfg.band[i].f_beta  : 0.0f;
+        p_sys->f_gamma[i] = i < p_sys->i_band ? cfg.band[i].f_gamma : 0.0f;
+        p_sys->f_amp[i]   = 0.0f;
     }
 
     /* Filter dyn config */
     p_sys->b_2eqz = false;
     p_sys->f_gamp = 1.0f;
-    p_sys->f_amp  = vlc_alloc( p_sys->i_band, sizeof(float) );
-    if( !p_sys->f_amp )
-        goto error;
-
-    for( i = 0; i < p_sys->i_band; i++ )
-    {
-        p_sys->f_amp[i] = 0.0f;
-    }
 
     /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
+    memset( p_sys->state, 0, sizeof( p_sys->state ) );
+    memset( p_sys->state2, 0, sizeof( p_sys->state2 ) );
 
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
+    p_sys->pass = EqzPass_c;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE() )
+        p_sys->pass = EqzPass_sse;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX() )
+        p_sys->pass = EqzPass_avx;
+#endif
+#ifdef __ARM_NEON
+    if( vlc_CPU_ARM_NEON() )
+        p_sys->pass = EqzPass_neon;
+#endif
 
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
@@ -356,9 +594,7 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     {
         msg_Err(p_filter, "No preset selected");
         free( val2.psz_string );
-        free( p_sys->f_amp );
-        i_ret = VLC_EGENERIC;
-        goto error;
+        return VLC_EGENERIC;
     }
     free( val2.psz_string );
 
@@ -377,73 +613,28 @@ static int EqzInit( filter_t *p_filter, int i_rate )
                  p_sys->f_alpha[i], p_sys->f_beta[i], p_sys->f_gamma[i]);
     }
     return VLC_SUCCESS;
-
-error:
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-    return i_ret;
 }
 
-static void EqzFilter( filter_t *p_filter, float *out, float *in,
+static void EqzFilter( filter_t *p_filter, float *buf,
                        int i_samples, int i_channels )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
 
     vlc_mutex_lock( &p_sys->lock );
-    for( i = 0; i < i_samples; i++ )
+    /* Each channel is filtered on its own, with its states in registers */
+    for( int ch = 0; ch < i_channels; ch++ )
     {
-        for( ch = 0; ch < i_channels; ch++ )
+        if( p_sys->b_2eqz )
         {
-            const float x = in[ch];
-            float o = 0.0f;
-
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
-
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
-
-                o += y * p_sys->f_amp[j];
-            }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
-
-            /* Second filter */
-            if( p_sys->b_2eqz )
-            {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
-
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
-
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
-            {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
-            }
+            p_sys->pass( &buf[ch], i_channels, i_samples, 1.0f,
+                         &p_sys->state[ch], p_sys );
+            p_sys->pass( &buf[ch], i_channels, i_samples,
+                         p_sys->f_gamp * p_sys->f_gamp,
+                         &p_sys->state2[ch], p_sys );
         }
-
-        in  += i_channels;
-        out += i_channels;
+        else
+            p_sys->pass( &buf[ch], i_channels, i_samples, p_sys->f_gamp,
+                         &p_sys->state[ch], p_sys );
     }
     vlc_mutex_unlock( &p_sys->lock );
 }
@@ -457,12 +648,6 @@ static void EqzClean( filter_t *p_filter )
     var_DelCallback( p_aout, "equalizer-preset", PresetCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-preamp", PreampCallback, p_sys );
     var_DelCallback( p_aout, "equalizer-2pass", TwoPassCallback, p_sys );
-
-    free( p_sys->f_alpha );
-    free( p_sys->f_beta );
-    free( p_sys->f_gamma );
-
-    free( p_sys->f_amp );
 }
 
 
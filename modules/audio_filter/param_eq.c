@@ -35,6 +35,17 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -43,8 +54,6 @@ static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 static void CalcPeakEQCoeffs( float, float, float, float, float * );
 static void CalcShelfEQCoeffs( float, float, float, int, float, float * );
-static void ProcessEQ( const float *, float *, float *, unsigned, unsigned,
-                       const float *, unsigned );
 static block_t *DoWork( filter_t *, block_t * );
 
 vlc_module_begin ()
@@ -82,6 +91,28 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+#define EQ_COUNT 5
+
+/* The intrinsics filter the channels side by side in the SIMD lanes */
+#define EQ_VECS_MAX ((AOUT_CHAN_MAX + 3) / 4)
+
+typedef void (*eq_process_t)( float *, float *, unsigned, unsigned, unsigned,
+                              const float * );
+static void ProcessEQ_c( float *, float *, unsigned, unsigned, unsigned,
+                         const float * );
+#ifdef HAVE_SSE2_INTRINSICS
+static void ProcessEQ_sse( float *, float *, unsigned, unsigned, unsigned,
+                           const float * );
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+static void ProcessEQ_avx( float *, float *, unsigned, unsigned, unsigned,
+                           const float * );
+#endif
+#ifdef __ARM_NEON
+static void ProcessEQ_neon( float *, float *, unsigned, unsigned, unsigned,
+                            const float * );
+#endif
+
 typedef struct
 {
     /* Filter static config */
@@ -91,9 +122,11 @@ typedef struct
     float   f_f3, f_Q3, f_gain3;
     float   f_highf, f_highgain;
     /* Filter computed coeffs */
-    float   coeffs[5*5];
+    float   coeffs[EQ_COUNT*5];
     /* State */
     float  *p_state;
+    unsigned i_lanes;
+    eq_process_t process;
 } filter_sys_t;
 
 
@@ -145,8 +178,40 @@ static int Open( vlc_object_t *p_this )
                       i_samplerate, p_sys->coeffs+3*5);
     CalcShelfEQCoeffs(p_sys->f_highf, 1, p_sys->f_highgain, 0,
                       i_samplerate, p_sys->coeffs+4*5);
-    p_sys->p_state = (float*)calloc( p_filter->fmt_in.audio.i_channels*5*4,
+    /* The vectors need as many channels as they have lanes, and the
+     * states are stored by whole vectors */
+    const unsigned i_channels = p_filter->fmt_in.audio.i_channels;
+    p_sys->process = ProcessEQ_c;
+    p_sys->i_lanes = i_channels;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE() && i_channels >= 4 )
+    {
+        p_sys->process = ProcessEQ_sse;
+        p_sys->i_lanes = ( i_channels + 3 ) & ~3;
+    }
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX() && i_channels >= 8 )
+    {
+        p_sys->process = ProcessEQ_avx;
+        p_sys->i_lanes = ( i_channels + 7 ) & ~7;
+    }
+#endif
+#ifdef __ARM_NEON
+    if( vlc_CPU_ARM_NEON() && i_channels >= 4 )
+    {
+        p_sys->process = ProcessEQ_neon;
+        p_sys->i_lanes = ( i_channels + 3 ) & ~3;
+    }
+#endif
+
+    p_sys->p_state = (float*)calloc( p_sys->i_lanes*EQ_COUNT*4,
                                      sizeof(float) );
+    if( !p_sys->p_state )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
 
     return VLC_SUCCESS;
 }
@@ -167,10 +232,17 @@ static void Close( vlc_object_t *p_this )
 static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    ProcessEQ( (float*)p_in_buf->p_buffer, (float*)p_in_buf->p_buffer,
-               p_sys->p_state,
-               p_filter->fmt_in.audio.i_channels, p_in_buf->i_nb_samples,
-               p_sys->coeffs, 5 );
+    const unsigned i_lanes = p_sys->i_lanes;
+
+    p_sys->process( (float*)p_in_buf->p_buffer, p_sys->p_state,
+                    p_filter->fmt_in.audio.i_channels, i_lanes,
+                    p_in_buf->i_nb_samples, p_sys->coeffs );
+
+    /* Zero the states that decayed to nothing, before they turn into slow
+     * denormals */
+    for( unsigned i = 0; i < i_lanes * EQ_COUNT * 4; i++ )
+        if( fabsf( p_sys->p_state[i] ) < 1e-20f )
+            p_sys->p_state[i] = 0.f;
     return p_in_buf;
 }
 
@@ -276,48 +348,209 @@ static void CalcShelfEQCoeffs( float f0, float slope, float gainDB, int high,
 }
 
 /*
-  src is assumed to be interleaved
-  dest is assumed to be interleaved
-  size of state is 4*channels*eqCount
+  buf is interleaved, and filtered in place
+  the state of each channel is in its own lane: 4 rows of lanes for each
+  eq, x[n-1], x[n-2], y[n-1], y[n-2]
   samples is not premultiplied by channels
-  size of coeffs is 5*eqCount
+  size of coeffs is 5*EQ_COUNT
 */
-void ProcessEQ( const float *src, float *dest, float *state,
-                unsigned channels, unsigned samples, const float *coeffs,
-                unsigned eqCount )
+static void ProcessEQ_c( float *buf, float *state, unsigned channels,
+                         unsigned lanes, unsigned samples,
+                         const float *coeffs )
 {
-    unsigned i, chn, eq;
-    float   b0, b1, b2, a1, a2;
-    float   x, y = 0;
-    const float *src1 = src;
-    float *dest1 = dest;
-
-    for (i = 0; i < samples; i++)
+    for( unsigned i = 0; i < samples; i++, buf += channels )
     {
-        float *state1 = state;
-        for (chn = 0; chn < channels; chn++)
+        for( unsigned chn = 0; chn < channels; chn++ )
         {
+            float *state1 = state + chn;
             const float *coeffs1 = coeffs;
-            x = *src1++;
+            float x = buf[chn];
+
             /* Direct form 1 IIRs */
-            for (eq = 0; eq < eqCount; eq++)
+            for( unsigned eq = 0; eq < EQ_COUNT; eq++ )
             {
-                b0 = coeffs1[0];
-                b1 = coeffs1[1];
-                b2 = coeffs1[2];
-                a1 = coeffs1[3];
-                a2 = coeffs1[4];
-                coeffs1 += 5;
-                y = x*b0 + state1[0]*b1 + state1[1]*b2 - state1[2]*a1 - state1[3]*a2;
-                state1[1] = state1[0];
+                float y = x*coeffs1[0] + state1[0]*coeffs1[1]
+                        + state1[lanes]*coeffs1[2]
+                        - state1[2*lanes]*coeffs1[3]
+                        - state1[3*lanes]*coeffs1[4];
+                state1[lanes] = state1[0];
                 state1[0] = x;
-                state1[3] = state1[2];
-                state1[2] = y;
+                state1[3*lanes] = state1[2*lanes];
+                state1[2*lanes] = y;
                 x = y;
-                state1 += 4;
+                coeffs1 += 5;
+                state1 += 4*lanes;
+            }
+            buf[chn] = x;
+        }
+    }
+}
+
+/* The channels are loaded in vectors of W, the last one overlapping the one
+ * before if the channels are not a multiple of W: the overlapping channels
+ * are filtered twice, with the same states. */
+#ifdef HAVE_SSE2_INTRINSICS
+VLC_SSE
+static void ProcessEQ_sse( float *buf, float *state, unsigned channels,
+                           unsigned lanes, unsigned samples,
+                           const float *coeffs )
+{
+    const unsigned vecs = lanes / 4;
+    unsigned offset[EQ_VECS_MAX];
+
+    for( unsigned v = 0; v < vecs; v++ )
+        offset[v] = __MIN( 4 * v, channels - 4 );
+
+    /* Flush denormal results to zero */
+    const unsigned csr = _mm_getcsr();
+    _mm_setcsr( csr | _MM_FLUSH_ZERO_ON );
+
+    for( unsigned i = 0; i < samples; i++, buf += channels )
+    {
+        __m128 x[EQ_VECS_MAX];
+
+        for( unsigned v = 0; v < vecs; v++ )
+            x[v] = _mm_loadu_ps( &buf[offset[v]] );
+
+        for( unsigned v = 0; v < vecs; v++ )
+        {
+            float *state1 = state + 4 * v;
+            const float *coeffs1 = coeffs;
+
+            for( unsigned eq = 0; eq < EQ_COUNT; eq++ )
+            {
+                __m128 x1 = _mm_loadu_ps( state1 );
+                __m128 x2 = _mm_loadu_ps( state1 + lanes );
+                __m128 y1 = _mm_loadu_ps( state1 + 2*lanes );
+                __m128 y2 = _mm_loadu_ps( state1 + 3*lanes );
+                __m128 y = _mm_mul_ps( x[v], _mm_set1_ps( coeffs1[0] ) );
+
+                y = _mm_add_ps( y, _mm_mul_ps( x1, _mm_set1_ps( coeffs1[1] ) ) );
+                y = _mm_add_ps( y, _mm_mul_ps( x2, _mm_set1_ps( coeffs1[2] ) ) );
+                y = _mm_sub_ps( y, _mm_mul_ps( y1, _mm_set1_ps( coeffs1[3] ) ) );
+                y = _mm_sub_ps( y, _mm_mul_ps( y2, _mm_set1_ps( coeffs1[4] ) ) );
+                _mm_storeu_ps( state1 + lanes, x1 );
+                _mm_storeu_ps( state1, x[v] );
+                _mm_storeu_ps( state1 + 3*lanes, y1 );
+                _mm_storeu_ps( state1 + 2*lanes, y );
+                x[v] = y;
+                coeffs1 += 5;
+                state1 += 4*lanes;
             }
-            *dest1++ = y;
         }
+
+        for( unsigned v = 0; v < vecs; v++ )
+            _mm_storeu_ps( &buf[offset[v]], x[v] );
     }
+    _mm_setcsr( csr );
 }
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx")))
+static void ProcessEQ_avx( float *buf, float *state, unsigned channels,
+                           unsigned lanes, unsigned samples,
+                           const float *coeffs )
+{
+    const unsigned vecs = lanes / 8;
+    unsigned offset[EQ_VECS_MAX];
+
+    for( unsigned v = 0; v < vecs; v++ )
+        offset[v] = __MIN( 8 * v, channels - 8 );
+
+    /* Flush denormal results to zero */
+    const unsigned csr = _mm_getcsr();
+    _mm_setcsr( csr | _MM_FLUSH_ZERO_ON );
+
+    for( unsigned i = 0; i < samples; i++, buf += channels )
+    {
+        __m256 x[EQ_VECS_MAX];
 
+        for( unsigned v = 0; v < vecs; v++ )
+            x[v] = _mm256_loadu_ps( &buf[offset[v]] );
+
+        for( unsigned v = 0; v < vecs; v++ )
+        {
+            float *state1 = state + 8 * v;
+            const float *coeffs1 = coeffs;
+
+            for( unsigned eq = 0; eq < EQ_COUNT; eq++ )
+            {
+                __m256 x1 = _mm256_loadu_ps( state1 );
+                __m256 x2 = _mm256_loadu_ps( state1 + lanes );
+                __m256 y1 = _mm256_loadu_ps( state1 + 2*lanes );
+                __m256 y2 = _mm256_loadu_ps( state1 + 3*lanes );
+                __m256 y = _mm256_mul_ps( x[v], _mm256_set1_ps( coeffs1[0] ) );
+
+                y = _mm256_add_ps( y, _mm256_mul_ps( x1, _mm256_set1_ps( coeffs1[1] ) ) );
+                y = _mm256_add_ps( y, _mm256_mul_ps( x2, _mm256_set1_ps( coeffs1[2] ) ) );
+                y = _mm256_sub_ps( y, _mm256_mul_ps( y1, _mm256_set1_ps( coeffs1[3] ) ) );
+                y = _mm256_sub_ps( y, _mm256_mul_ps( y2, _mm256_set1_ps( coeffs1[4] ) ) );
+                _mm256_storeu_ps( state1 + lanes, x1 );
+                _mm256_storeu_ps( state1, x[v] );
+                _mm256_storeu_ps( state1 + 3*lanes, y1 );
+                _mm256_storeu_ps( state1 + 2*lanes, y );
+                x[v] = y;
+                coeffs1 += 5;
+                state1 += 4*lanes;
+            }
+        }
+
+        for( unsigned v = 0; v < vecs; v++ )
+            _mm256_storeu_ps( &buf[offset[v]], x[v] );
+    }
+    _mm_setcsr( csr );
+}
+#endif
+
+#ifdef __ARM_NEON
+/* The ARM vector unit flushes denormals to zero by itself */
+static void ProcessEQ_neon( float *buf, float *state, unsigned channels,
+                            unsigned lanes, unsigned samples,
+                            const float *coeffs )
+{
+    const unsigned vecs = lanes / 4;
+    unsigned offset[EQ_VECS_MAX];
+
+    for( unsigned v = 0; v < vecs; v++ )
+        offset[v] = __MIN( 4 * v, channels - 4 );
+
+    for( unsigned i = 0; i < samples; i++, buf += channels )
+    {
+        float32x4_t x[EQ_VECS_MAX];
+
+        for( unsigned v = 0; v < vecs; v++ )
+            x[v] = vld1q_f32( &buf[offset[v]] );
+
+        for( unsigned v = 0; v < vecs; v++ )
+        {
+            float *state1 = state + 4 * v;
+            const float *coeffs1 = coeffs;
+
+            for( unsigned eq = 0; eq < EQ_COUNT; eq++ )
+            {
+                float32x4_t x1 = vld1q_f32( state1 );
+                float32x4_t x2 = vld1q_f32( state1 + lanes );
+                float32x4_t y1 = vld1q_f32( state1 + 2*lanes );
+                float32x4_t y2 = vld1q_f32( state1 + 3*lanes );
+                float32x4_t y = vmulq_n_f32( x[v], coeffs1[0] );
+
+                y = vmlaq_n_f32( y, x1, coeffs1[1] );
+                y = vmlaq_n_f32( y, x2, coeffs1[2] );
+                y = vmlsq_n_f32( y, y1, coeffs1[3] );
+                y = vmlsq_n_f32( y, y2, coeffs1[4] );
+                vst1q_f32( state1 + lanes, x1 );
+                vst1q_f32( state1, x[v] );
+                vst1q_f32( state1 + 3*lanes, y1 );
+                vst1q_f32( state1 + 2*lanes, y );
+                x[v] = y;
+                coeffs1 += 5;
+                state1 += 4*lanes;
+            }
+        }
+
+        for( unsigned v = 0; v < vecs; v++ )
+            vst1q_f32( &buf[offset[v]], x[v] );
+    }
+}
+#endif
@@ -0,0 +1,471 @@
+/*****************************************************************************
+ * polyphase.c : polyphase FIR audio resampler
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Kaiser-windowed sinc interpolation, from a bank of precomputed filter
+ * phases. The output samples between two phases are linearly interpolated,
+ * so any ratio can be used, and changing it (such as when the audio output
+ * corrects the clock drift) is only a matter of changing the step. The bank
+ * is only rebuilt when the cutoff frequency must move, i.e. when the
+ * downsampling ratio changes significantly. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+#endif
+
+#define TAPS_TEXT N_("Filter length")
+#define TAPS_LONGTEXT N_("Number of input samples used for each output " \
+    "sample. Longer filters are sharper but slower.")
+
+static const int taps_values[] = { 16, 24, 32, 48, 64 };
+static const char *const taps_texts[] = {
+    N_("Fastest"), N_("Fast"), N_("Normal"), N_("Good"), N_("Best") };
+
+static int Open( vlc_object_t * );
+static int OpenResampler( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname( N_("Polyphase resampler") )
+    set_description( N_("Polyphase FIR audio resampler") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_RESAMPLER )
+    add_integer( "polyphase-resampler-taps", 32, TAPS_TEXT, TAPS_LONGTEXT,
+                 true )
+        change_integer_list( taps_values, taps_texts )
+    set_capability( "audio converter", 30 )
+    set_callbacks( Open, Close )
+
+    add_submodule()
+    set_capability( "audio resampler", 30 )
+    set_callbacks( OpenResampler, Close )
+    add_shortcut( "polyphase" )
+vlc_module_end ()
+
+#define PHASES_BITS 8
+#define PHASES (1 << PHASES_BITS)
+#define KAISER_BETA 8.
+#define CUTOFF 0.95 /* relative to the lowest Nyquist frequency */
+#define CUTOFF_TOLERANCE 0.01
+
+typedef float (*dot_t)( const float *, const float *, const float *,
+                        unsigned, float );
+
+typedef struct
+{
+    unsigned channels;
+    unsigned taps;
+    double cutoff; /* of the current bank */
+    float *bank; /* (PHASES + 1) phases of taps coefficients */
+
+    /* Planar input history */
+    float *buf;
+    size_t size; /* allocated frames per channel */
+    size_t frames; /* stored frames per channel */
+    uint64_t pos; /* 32.32 fixed point position of the next output frame */
+
+    dot_t dot;
+} filter_sys_t;
+
+static block_t *Resample( filter_t *, block_t * );
+static block_t *Drain( filter_t * );
+static void     Flush( filter_t * );
+
+/*****************************************************************************
+ * Dot products of the input with two adjacent phases, interpolated
+ *****************************************************************************/
+static float dot_c( const float *x, const float *h0, const float *h1,
+                    unsigned n, float w )
+{
+    float a = 0.f, b = 0.f;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        a += x[i] * h0[i];
+        b += x[i] * h1[i];
+    }
+    return a + w * (b - a);
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse")))
+static float dot_sse( const float *x, const float *h0, const float *h1,
+                      unsigned n, float w )
+{
+    __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+
+    /* n is a multiple of 8 */
+    for( unsigned i = 0; i < n; i += 4 )
+    {
+        __m128 v = _mm_loadu_ps( x + i );
+        a = _mm_add_ps( a, _mm_mul_ps( v, _mm_loadu_ps( h0 + i ) ) );
+        b = _mm_add_ps( b, _mm_mul_ps( v, _mm_loadu_ps( h1 + i ) ) );
+    }
+    a = _mm_add_ps( a, _mm_mul_ps( _mm_sub_ps( b, a ), _mm_set1_ps( w ) ) );
+    a = _mm_add_ps( a, _mm_movehl_ps( a, a ) );
+    a = _mm_add_ss( a, _mm_shuffle_ps( a, a, 1 ) );
+    return _mm_cvtss_f32( a );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx")))
+static float dot_avx( const float *x, const float *h0, const float *h1,
+                      unsigned n, float w )
+{
+    __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+
+    for( unsigned i = 0; i < n; i += 8 )
+    {
+        __m256 v = _mm256_loadu_ps( x + i );
+        a = _mm256_add_ps( a, _mm256_mul_ps( v, _mm256_loadu_ps( h0 + i ) ) );
+        b = _mm256_add_ps( b, _mm256_mul_ps( v, _mm256_loadu_ps( h1 + i ) ) );
+    }
+    a = _mm256_add_ps( a, _mm256_mul_ps( _mm256_sub_ps( b, a ),
+                                         _mm256_set1_ps( w ) ) );
+
+    __m128 s = _mm_add_ps( _mm256_castps256_ps128( a ),
+                           _mm256_extractf128_ps( a, 1 ) );
+    s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+    s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+    return _mm_cvtss_f32( s );
+}
+#endif
+
+#ifdef __ARM_NEON
+static float dot_neon( const float *x, const float *h0, const float *h1,
+                       unsigned n, float w )
+{
+    float32x4_t a = vdupq_n_f32( 0.f ), b = vdupq_n_f32( 0.f );
+
+    for( unsigned i = 0; i < n; i += 4 )
+    {
+        float32x4_t v = vld1q_f32( x + i );
+        a = vmlaq_f32( a, v, vld1q_f32( h0 + i ) );
+        b = vmlaq_f32( b, v, vld1q_f32( h1 + i ) );
+    }
+    a = vmlaq_n_f32( a, vsubq_f32( b, a ), w );
+
+    float32x2_t s = vadd_f32( vget_low_f32( a ), vget_high_f32( a ) );
+    return vget_lane_f32( vpadd_f32( s, s ), 0 );
+}
+#endif
+
+/*****************************************************************************
+ * Filter bank
+ *****************************************************************************/
+static double BesselI0( double x )
+{
+    double sum = 1., term = 1.;
+
+    for( unsigned k = 1; term > sum * 1e-12; k++ )
+    {
+        term *= (x / (2. * k)) * (x / (2. * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static void BuildBank( filter_sys_t *p_sys, double cutoff )
+{
+    const unsigned taps = p_sys->taps, half = taps / 2;
+    const double norm = BesselI0( KAISER_BETA );
+
+    for( unsigned p = 0; p <= PHASES; p++ )
+    {
+        float *h = p_sys->bank + p * taps;
+        double sum = 0.;
+
+        for( unsigned k = 0; k < taps; k++ )
+        {
+            /* Distance to the interpolated point, in input samples */
+            double d = (double)k - (half - 1) - (double)p / PHASES;
+            double x = d / half;
+            double v = cutoff;
+
+            if( d != 0. )
+                v = sin( M_PI * cutoff * d ) / (M_PI * d);
+            v *= (x * x < 1.) ? BesselI0( KAISER_BETA * sqrt( 1. - x * x ) )
+                                / norm : 0.;
+            h[k] = v;
+            sum += v;
+        }
+        /* Unity gain at DC */
+        for( unsigned k = 0; k < taps; k++ )
+            h[k] /= sum;
+    }
+    p_sys->cutoff = cutoff;
+}
+
+static double GetCutoff( unsigned irate, unsigned orate )
+{
+    return (orate < irate) ? CUTOFF * orate / irate : CUTOFF;
+}
+
+/*****************************************************************************
+ * History
+ *****************************************************************************/
+static void Reset( filter_sys_t *p_sys )
+{
+    /* Prime with silence, so that the first output matches the first input
+     * sample, since the filter is centered on the interpolated point. */
+    p_sys->frames = p_sys->taps / 2 - 1;
+    p_sys->pos = 0;
+    memset( p_sys->buf, 0, p_sys->frames * p_sys->channels * sizeof (float) );
+}
+
+static int Append( filter_sys_t *p_sys, const float *src, size_t n )
+{
+    const unsigned channels = p_sys->channels;
+    size_t frames = p_sys->frames + n;
+
+    if( frames > p_sys->size )
+    {
+        size_t size = __MAX( frames, 2 * p_sys->size );
+        float *buf = vlc_alloc( size * channels, sizeof (float) );
+        if( unlikely(buf == NULL) )
+            return VLC_ENOMEM;
+
+        for( unsigned c = 0; c < channels; c++ )
+            memcpy( buf + c * size, p_sys->buf + c * p_sys->size,
+                    p_sys->frames * sizeof (float) );
+        free( p_sys->buf );
+        p_sys->buf = buf;
+        p_sys->size = size;
+    }
+
+    for( unsigned c = 0; c < channels; c++ )
+    {
+        float *dst = p_sys->buf + c * p_sys->size + p_sys->frames;
+
+        if( src != NULL )
+            for( size_t i = 0; i < n; i++ )
+                dst[i] = src[i * channels + c];
+        else
+            memset( dst, 0, n * sizeof (float) );
+    }
+    p_sys->frames = frames;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Process: resamples the stored history into a new block
+ *****************************************************************************/
+static block_t *Process( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned irate = p_filter->fmt_in.audio.i_rate;
+    const unsigned orate = p_filter->fmt_out.audio.i_rate;
+    const unsigned channels = p_sys->channels, taps = p_sys->taps;
+
+    double cutoff = GetCutoff( irate, orate );
+    if( fabs( cutoff - p_sys->cutoff ) > CUTOFF_TOLERANCE )
+        BuildBank( p_sys, cutoff );
+
+    if( p_sys->frames < taps )
+        return NULL;
+
+    const uint64_t step = ((uint64_t)irate << 32) / orate;
+    const uint64_t end = (uint64_t)(p_sys->frames - taps + 1) << 32;
+    size_t count = 0;
+    if( p_sys->pos < end )
+        count = (end - p_sys->pos + step - 1) / step;
+    if( count == 0 )
+        return NULL;
+
+    block_t *p_out = filter_NewAudioBuffer( p_filter, count * channels * sizeof (float) );
+    if( unlikely(p_out == NULL) )
+        return NULL;
+
+    float *p_dst = (float *)p_out->p_buffer;
+    uint64_t pos = p_sys->pos;
+
+    for( size_t i = 0; i < count; i++, pos += step )
+    {
+        const size_t offset = pos >> 32;
+        const uint32_t frac = pos;
+
+        if( frac == 0 && step == (UINT64_C(1) << 32) )
+        {   /* Same rates, in phase: copy the input samples */
+            for( unsigned c = 0; c < channels; c++ )
+                *(p_dst++) = p_sys->buf[c * p_sys->size + offset
+                                        + taps / 2 - 1];
+            continue;
+        }
+
+        const float *h0 = p_sys->bank + (frac >> (32 - PHASES_BITS)) * taps;
+        const float w = (frac & ((UINT32_C(1) << (32 - PHASES_BITS)) - 1))
+                      * (1.f / (UINT32_C(1) << (32 - PHASES_BITS)));
+
+        for( unsigned c = 0; c < channels; c++ )
+            *(p_dst++) = p_sys->dot( p_sys->buf + c * p_sys->size + offset,
+                                     h0, h0 + taps, taps, w );
+    }
+
+    /* Drop the consumed history */
+    size_t consumed = __MIN( (size_t)(pos >> 32), p_sys->frames );
+    p_sys->frames -= consumed;
+    for( unsigned c = 0; c < channels; c++ )
+    {
+        float *buf = p_sys->buf + c * p_sys->size;
+        memmove( buf, buf + consumed, p_sys->frames * sizeof (float) );
+    }
+    p_sys->pos = pos - ((uint64_t)consumed << 32);
+
+    p_out->i_nb_samples = count;
+    p_out->i_buffer = count * channels * sizeof (float);
+    p_out->i_length = vlc_tick_from_samples( count, orate );
+    return p_out;
+}
+
+static block_t *Resample( filter_t *p_filter, block_t *p_in )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out = NULL;
+
+    if( Append( p_sys, (const float *)p_in->p_buffer,
+                p_in->i_nb_samples ) == VLC_SUCCESS )
+    {
+        p_out = Process( p_filter );
+        if( p_out != NULL )
+            p_out->i_pts = p_in->i_pts;
+    }
+    block_Release( p_in );
+    return p_out;
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out = NULL;
+
+    /* Push the last input samples out of the filter */
+    if( Append( p_sys, NULL, p_sys->taps / 2 ) == VLC_SUCCESS )
+        p_out = Process( p_filter );
+    Reset( p_sys );
+    return p_out;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    Reset( p_filter->p_sys );
+}
+
+/*****************************************************************************
+ * Open/Close
+ *****************************************************************************/
+static int OpenResampler( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32
+     || p_filter->fmt_out.audio.i_format != VLC_CODEC_FL32
+     || p_filter->fmt_in.audio.i_channels != p_filter->fmt_out.audio.i_channels
+     || p_filter->fmt_in.audio.i_channels == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    int64_t taps = var_InheritInteger( p_this, "polyphase-resampler-taps" );
+    if( taps < 8 || taps > 256 )
+        taps = 32;
+
+    p_sys->channels = p_filter->fmt_in.audio.i_channels;
+    p_sys->taps = (taps + 7) & ~7; /* multiple of the SIMD width */
+    p_sys->size = 4096;
+    p_sys->bank = vlc_alloc( (PHASES + 1) * p_sys->taps, sizeof (float) );
+    p_sys->buf = vlc_alloc( p_sys->size * p_sys->channels, sizeof (float) );
+    if( unlikely(p_sys->bank == NULL || p_sys->buf == NULL) )
+    {
+        free( p_sys->bank );
+        free( p_sys->buf );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    BuildBank( p_sys, GetCutoff( p_filter->fmt_in.audio.i_rate,
+                                 p_filter->fmt_out.audio.i_rate ) );
+    Reset( p_sys );
+
+    p_sys->dot = dot_c;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE() )
+        p_sys->dot = dot_sse;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX() )
+        p_sys->dot = dot_avx;
+#endif
+#ifdef __ARM_NEON
+    if( vlc_CPU_ARM_NEON() )
+        p_sys->dot = dot_neon;
+#endif
+
+    msg_Dbg( p_filter, "%u taps polyphase resampler from %uHz to %uHz",
+             p_sys->taps, p_filter->fmt_in.audio.i_rate,
+             p_filter->fmt_out.audio.i_rate );
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = Resample;
+    p_filter->pf_flush = Flush;
+    p_filter->pf_audio_drain = Drain;
+    return VLC_SUCCESS;
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    /* Will change rate */
+    if( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate )
+        return VLC_EGENERIC;
+    return OpenResampler( p_this );
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    free( p_sys->bank );
+    free( p_sys->buf );
+    free( p_sys );
+}
@@ -33,10 +33,22 @@
 #include <vlc_atomic.h>
 #include <vlc_filter.h>
 #include <vlc_modules.h>
+#include <vlc_cpu.h>
 
+#include <math.h>
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
 
+#ifdef HAVE_SSE2_INTRINSICS
+# include <xmmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -88,6 +100,8 @@ vlc_module_end ()
  * Scaletempo smooths the overlap further by searching within the input buffer
  * for the best overlap position.  Scaletempo uses a statistical cross correlation
  * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here.
+ * The dot-products are vectorized; for long searches, the whole correlation
+ * is computed at once with a FFT.
  *
  * NOTE:
  * sample: a single audio sample for one channel
@@ -129,6 +143,12 @@ typedef struct
     void     *buf_pre_corr;
     void     *table_window;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    float   (*dot_product)( const float *a, const float *b, unsigned n );
+    /* FFT correlation */
+    unsigned  fft_size;
+    float    *fft_buf;      /* fft_size complex values */
+    float    *fft_twiddle;  /* fft_size / 2 complex values */
+    unsigned *fft_bitrev;
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -136,6 +156,121 @@ typedef struct
 #endif
 } filter_sys_t;
 
+/*****************************************************************************
+ * dot_product: correlation of two sample buffers
+ *****************************************************************************/
+static float dot_product_c( const float *a, const float *b, unsigned n )
+{
+    float corr = 0;
+    for( unsigned i = 0; i < n; i++ )
+        corr += a[i] * b[i];
+    return corr;
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+VLC_SSE
+static float dot_product_sse( const float *a, const float *b, unsigned n )
+{
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 8 <= n; i += 8 ) {
+        acc0 = _mm_add_ps( acc0, _mm_mul_ps( _mm_loadu_ps( a + i ),
+                                             _mm_loadu_ps( b + i ) ) );
+        acc1 = _mm_add_ps( acc1, _mm_mul_ps( _mm_loadu_ps( a + i + 4 ),
+                                             _mm_loadu_ps( b + i + 4 ) ) );
+    }
+    acc0 = _mm_add_ps( acc0, acc1 );
+    acc0 = _mm_add_ps( acc0, _mm_movehl_ps( acc0, acc0 ) );
+    acc0 = _mm_add_ss( acc0, _mm_shuffle_ps( acc0, acc0, 1 ) );
+
+    float corr = _mm_cvtss_f32( acc0 );
+    for( ; i < n; i++ )
+        corr += a[i] * b[i];
+    return corr;
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx")))
+static float dot_product_avx( const float *a, const float *b, unsigned n )
+{
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 ) {
+        acc0 = _mm256_add_ps( acc0, _mm256_mul_ps( _mm256_loadu_ps( a + i ),
+                                                   _mm256_loadu_ps( b + i ) ) );
+        acc1 = _mm256_add_ps( acc1, _mm256_mul_ps( _mm256_loadu_ps( a + i + 8 ),
+                                                   _mm256_loadu_ps( b + i + 8 ) ) );
+    }
+    acc0 = _mm256_add_ps( acc0, acc1 );
+
+    __m128 acc = _mm_add_ps( _mm256_castps256_ps128( acc0 ),
+                             _mm256_extractf128_ps( acc0, 1 ) );
+    acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+    acc = _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 1 ) );
+
+    float corr = _mm_cvtss_f32( acc );
+    for( ; i < n; i++ )
+        corr += a[i] * b[i];
+    return corr;
+}
+#endif
+
+#ifdef __ARM_NEON
+static float dot_product_neon( const float *a, const float *b, unsigned n )
+{
+    float32x4_t acc0 = vdupq_n_f32( 0.f ), acc1 = vdupq_n_f32( 0.f );
+    unsigned i = 0;
+
+    for( ; i + 8 <= n; i += 8 ) {
+        acc0 = vmlaq_f32( acc0, vld1q_f32( a + i ), vld1q_f32( b + i ) );
+        acc1 = vmlaq_f32( acc1, vld1q_f32( a + i + 4 ), vld1q_f32( b + i + 4 ) );
+    }
+    acc0 = vaddq_f32( acc0, acc1 );
+
+    float32x2_t acc = vadd_f32( vget_low_f32( acc0 ), vget_high_f32( acc0 ) );
+    float corr = vget_lane_f32( vpadd_f32( acc, acc ), 0 );
+    for( ; i < n; i++ )
+        corr += a[i] * b[i];
+    return corr;
+}
+#endif
+
+/*****************************************************************************
+ * fft: in-place radix-2 complex FFT of p_sys->fft_buf
+ *****************************************************************************/
+static void fft( filter_sys_t *p, bool inverse )
+{
+    const unsigned n = p->fft_size;
+    float *x = p->fft_buf;
+
+    for( unsigned i = 0; i < n; i++ ) {
+        unsigned j = p->fft_bitrev[i];
+        if( i < j ) {
+            float re = x[2 * i], im = x[2 * i + 1];
+            x[2 * i] = x[2 * j]; x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j] = re;       x[2 * j + 1] = im;
+        }
+    }
+
+    const float sign = inverse ? -1.f : 1.f;
+    for( unsigned len = 2; len <= n; len <<= 1 ) {
+        const unsigned half = len / 2, step = n / len;
+        for( unsigned k = 0; k < n; k += len ) {
+            for( unsigned j = 0; j < half; j++ ) {
+                const float *w = &p->fft_twiddle[2 * j * step];
+                float *u = &x[2 * ( k + j )], *v = &x[2 * ( k + j + half )];
+                float vr = v[0] * w[0] - sign * v[1] * w[1];
+                float vi = v[1] * w[0] + sign * v[0] * w[1];
+                v[0] = u[0] - vr; v[1] = u[1] - vi;
+                u[0] += vr;       u[1] += vi;
+            }
+        }
+    }
+}
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
@@ -146,6 +281,7 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     float best_corr = INT_MIN;
     unsigned best_off = 0;
     unsigned i, off;
+    const unsigned samples_corr = p->samples_overlap - p->samples_per_frame;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -157,12 +293,7 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
+      float corr = p->dot_product( p->buf_pre_corr, search_start, samples_corr );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
@@ -173,6 +304,99 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     return best_off * p->bytes_per_frame;
 }
 
+/*****************************************************************************
+ * best_overlap_offset_fft: same as best_overlap_offset_float, computing all
+ * the correlations at once in the frequency domain
+ *****************************************************************************/
+static unsigned best_overlap_offset_fft( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned n = p->fft_size;
+    const unsigned samples_corr = p->samples_overlap - p->samples_per_frame;
+    const unsigned samples_search = ( p->frames_search - 1 ) * p->samples_per_frame
+                                  + samples_corr;
+    const float *pw = p->table_window;
+    const float *po = (float *)p->buf_overlap + p->samples_per_frame;
+    const float *ps = (float *)p->buf_queue + p->samples_per_frame;
+    float *x = p->fft_buf;
+
+    /* Transform both real signals at once: the search window as the real
+     * part, and the windowed overlap as the imaginary part */
+    for( unsigned i = 0; i < n; i++ ) {
+        x[2 * i]     = i < samples_search ? ps[i] : 0.f;
+        x[2 * i + 1] = i < samples_corr ? pw[i] * po[i] : 0.f;
+    }
+    fft( p, false );
+
+    /* Split the spectra S and P, and compute S * conj(P) */
+    for( unsigned k = 0; k <= n / 2; k++ ) {
+        const unsigned m = ( n - k ) & ( n - 1 );
+        float xr = x[2 * k], xi = x[2 * k + 1];
+        float yr = x[2 * m], yi = x[2 * m + 1];
+        float sr = ( xr + yr ) * .5f, si = ( xi - yi ) * .5f;
+        float pr = ( xi + yi ) * .5f, pi = ( yr - xr ) * .5f;
+        float cr = sr * pr + si * pi, ci = si * pr - sr * pi;
+
+        x[2 * k] = cr; x[2 * k + 1] = ci;
+        x[2 * m] = cr; x[2 * m + 1] = -ci;
+    }
+    fft( p, true );
+
+    /* The correlation is real: pick the best frame offset */
+    float best_corr = -INFINITY;
+    unsigned best_off = 0;
+    for( unsigned off = 0; off < p->frames_search; off++ ) {
+        float corr = x[2 * off * p->samples_per_frame];
+        if( corr > best_corr ) {
+            best_corr = corr;
+            best_off  = off;
+        }
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
+/*****************************************************************************
+ * init_fft: set up the FFT correlation if cheaper than the direct one
+ *****************************************************************************/
+static int init_fft( filter_sys_t *p )
+{
+    const unsigned samples_corr = p->samples_overlap - p->samples_per_frame;
+    const unsigned samples_search = ( p->frames_search - 1 ) * p->samples_per_frame
+                                  + samples_corr;
+    unsigned n = 1, log2n = 0;
+
+    while( n < samples_search ) {
+        n <<= 1;
+        log2n++;
+    }
+
+    /* Rough cost, in multiplications, of two complex FFTs against the
+     * direct dot-products */
+    if( (uint64_t)p->frames_search * samples_corr < (uint64_t)4 * n * log2n )
+        return VLC_SUCCESS;
+
+    p->fft_buf     = vlc_alloc( 2 * n, sizeof (float) );
+    p->fft_twiddle = vlc_alloc( n, sizeof (float) );
+    p->fft_bitrev  = vlc_alloc( n, sizeof (unsigned) );
+    if( !p->fft_buf || !p->fft_twiddle || !p->fft_bitrev )
+        return VLC_ENOMEM;
+
+    for( unsigned i = 0; i < n / 2; i++ ) {
+        p->fft_twiddle[2 * i]     = cosf( 2.f * (float)M_PI * i / n );
+        p->fft_twiddle[2 * i + 1] = -sinf( 2.f * (float)M_PI * i / n );
+    }
+    for( unsigned i = 0; i < n; i++ ) {
+        unsigned r = 0;
+        for( unsigned b = 0; b < log2n; b++ )
+            r |= ( ( i >> b ) & 1 ) << ( log2n - 1 - b );
+        p->fft_bitrev[i] = r;
+    }
+    p->fft_size = n;
+    p->best_overlap_offset = best_overlap_offset_fft;
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * output_overlap: blend end of previous stride with beginning of current stride
  *****************************************************************************/
@@ -352,6 +576,8 @@ static int reinit_buffers( filter_t *p_filter )
                 *pw++ = v;
         }
         p->best_overlap_offset = best_overlap_offset_float;
+        if( init_fft( p ) )
+            return VLC_ENOMEM;
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -381,7 +607,7 @@ static int reinit_buffers( filter_t *p_filter )
     p->frames_stride_scaled = p->bytes_stride_scaled / p->bytes_per_frame;
 
     msg_Dbg( VLC_OBJECT(p_filter),
-             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode",
+             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode, %s correlation",
              p->scale,
              p->frames_stride_scaled,
              (int)( p->bytes_stride / p->bytes_per_frame ),
@@ -389,7 +615,8 @@ static int reinit_buffers( filter_t *p_filter )
              (int)( p->bytes_overlap / p->bytes_per_frame ),
              p->frames_search,
              (int)( p->bytes_queue_max / p->bytes_per_frame ),
-             "fl32");
+             "fl32",
+             p->fft_size ? "fft" : "direct" );
 
     return VLC_SUCCESS;
 }
@@ -430,11 +657,29 @@ static int Open( vlc_object_t *p_this )
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->fft_size       = 0;
+    p_sys->fft_buf        = NULL;
+    p_sys->fft_twiddle    = NULL;
+    p_sys->fft_bitrev     = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
     p_sys->frames_stride_error = 0;
 
+    p_sys->dot_product = dot_product_c;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE() )
+        p_sys->dot_product = dot_product_sse;
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX() )
+        p_sys->dot_product = dot_product_avx;
+#endif
+#ifdef __ARM_NEON
+    if( vlc_CPU_ARM_NEON() )
+        p_sys->dot_product = dot_product_neon;
+#endif
+
     if( reinit_buffers( p_filter ) != VLC_SUCCESS )
     {
         Close( p_this );
@@ -526,6 +771,9 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->fft_buf );
+    free( p_sys->fft_twiddle );
+    free( p_sys->fft_bitrev );
     free( p_sys );
 }
 
@@ -571,7 +819,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
                                    p_in_buf->i_buffer, 0 );
     if( i_outsize > 0 )
     {
-        p_out_buf = block_Alloc( i_outsize );
+        p_out_buf = filter_NewAudioBuffer( p_filter, i_outsize );
         if( p_out_buf == NULL )
         {
             block_Release( p_in_buf );
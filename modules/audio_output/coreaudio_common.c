@@ -387,7 +387,10 @@ ca_Play(audio_output_t * p_aout, block_t * p_block, vlc_tick_t date)
     if (!p_sys->b_played)
         p_sys->b_played = true;
     else if (i_underrun_size > 0)
+    {
         msg_Warn(p_aout, "underrun of %zu bytes", i_underrun_size);
+        aout_UnderrunReport(p_aout, 1);
+    }
 
     (void) date;
 }
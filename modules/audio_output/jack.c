@@ -37,7 +37,6 @@
 #include <vlc_aout.h>
 
 #include <jack/jack.h>
-#include <jack/ringbuffer.h>
 
 #include <stdio.h>
 #include <unistd.h>                                      /* write(), close() */
@@ -52,7 +51,7 @@ typedef jack_default_audio_sample_t jack_sample_t;
  *****************************************************************************/
 typedef struct
 {
-    jack_ringbuffer_t *p_jack_ringbuffer;
+    aout_ring_t    *ring;
     jack_client_t  *p_jack_client;
     jack_port_t   **p_jack_ports;
     jack_sample_t **p_jack_buffers;
@@ -125,6 +124,7 @@ static int Start( audio_output_t *p_aout, audio_sample_format_t *restrict fmt )
 
     p_sys->latency = 0;
     p_sys->paused = VLC_TICK_INVALID;
+    p_sys->ring = NULL;
 
     /* Connect to the JACK server */
     psz_name = var_InheritString( p_aout, "jack-name" );
@@ -179,21 +179,15 @@ static int Start( audio_output_t *p_aout, audio_sample_format_t *restrict fmt )
         goto error_out;
     }
 
-    const size_t buf_sz =
-        samples_from_vlc_tick(AOUT_MAX_ADVANCE_TIME, fmt->i_rate * fmt->i_bytes_per_frame);
-    p_sys->p_jack_ringbuffer = jack_ringbuffer_create( buf_sz );
-
-    if( p_sys->p_jack_ringbuffer == NULL )
+    p_sys->ring = aout_RingNew( fmt->i_bytes_per_frame,
+                                samples_from_vlc_tick(AOUT_MAX_ADVANCE_TIME,
+                                                      fmt->i_rate) );
+    if( p_sys->ring == NULL )
     {
         status = VLC_ENOMEM;
         goto error_out;
     }
 
-    if( jack_ringbuffer_mlock( p_sys->p_jack_ringbuffer ))
-    {
-        msg_Warn( p_aout, "failed to lock JACK ringbuffer in memory" );
-    }
-
     /* Create the output ports */
     for( i = 0; i < p_sys->i_channels; i++ )
     {
@@ -272,8 +266,8 @@ error_out:
             jack_deactivate( p_sys->p_jack_client );
             jack_client_close( p_sys->p_jack_client );
         }
-        if( p_sys->p_jack_ringbuffer )
-            jack_ringbuffer_free( p_sys->p_jack_ringbuffer );
+        if( p_sys->ring )
+            aout_RingDelete( p_sys->ring );
 
         free( p_sys->p_jack_ports );
         free( p_sys->p_jack_buffers );
@@ -285,28 +279,13 @@ error_out:
 static void Play(audio_output_t * p_aout, block_t * p_block, vlc_tick_t date)
 {
     aout_sys_t *p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
-    const size_t bytes_per_frame = p_sys->i_channels * sizeof(jack_sample_t);
-
-    while (p_block->i_buffer > 0) {
-
-        /* move data to buffer */
-        const size_t write_space = jack_ringbuffer_write_space(rb);
-        const size_t bytes = p_block->i_buffer < write_space ?
-            p_block->i_buffer : write_space;
-
-        /* If our audio thread is not reading fast enough */
-        if( unlikely( bytes == 0 ) ) {
-            msg_Warn( p_aout, "%"PRIuPTR " frames of audio dropped",
-                    p_block->i_buffer /  bytes_per_frame );
-            break;
-        }
+    const size_t frames = p_block->i_nb_samples;
+    const size_t written = aout_RingWrite( p_sys->ring, p_block->p_buffer,
+                                           frames );
 
-        jack_ringbuffer_write( rb, (const char *) p_block->p_buffer, bytes );
-
-        p_block->p_buffer += bytes;
-        p_block->i_buffer -= bytes;
-    }
+    /* If our audio thread is not reading fast enough */
+    if( unlikely( written < frames ) )
+        msg_Warn( p_aout, "%zu frames of audio dropped", frames - written );
 
     block_Release(p_block);
     (void) date;
@@ -331,21 +310,16 @@ static void Pause(audio_output_t *aout, bool paused, vlc_tick_t date)
 static void Flush(audio_output_t *p_aout)
 {
     aout_sys_t * p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
 
-    /* reset ringbuffer read and write pointers */
-    jack_ringbuffer_reset(rb);
+    aout_RingFlush( p_sys->ring );
 }
 
 static int TimeGet(audio_output_t *p_aout, vlc_tick_t *delay)
 {
     aout_sys_t * p_sys = p_aout->sys;
-    jack_ringbuffer_t *rb = p_sys->p_jack_ringbuffer;
-    const size_t bytes_per_frame = p_sys->i_channels * sizeof(jack_sample_t);
 
     *delay = p_sys->latency +
-            vlc_tick_from_samples(jack_ringbuffer_read_space(rb) / bytes_per_frame,
-                                  p_sys->i_rate);
+            vlc_tick_from_samples(aout_RingCount(p_sys->ring), p_sys->i_rate);
 
     return 0;
 }
@@ -356,8 +330,7 @@ static int TimeGet(audio_output_t *p_aout, vlc_tick_t *delay)
 int Process( jack_nframes_t i_frames, void *p_arg )
 {
     unsigned int i, j, frames_from_rb = 0;
-    size_t bytes_read = 0;
-    size_t frames_read;
+    size_t frames_read = 0;
     audio_output_t *p_aout = (audio_output_t*) p_arg;
     aout_sys_t *p_sys = p_aout->sys;
 
@@ -373,21 +346,31 @@ int Process( jack_nframes_t i_frames, void *p_arg )
                                                          i_frames );
     }
 
-    /* Copy in the audio data */
-    for( j = 0; j < frames_from_rb; j++ )
+    /* Deinterleave the audio data straight from the ring */
+    while( frames_read < frames_from_rb )
     {
-        for( i = 0; i < p_sys->i_channels; i++ )
-        {
-            jack_sample_t *p_dst = p_sys->p_jack_buffers[i] + j;
-            bytes_read += jack_ringbuffer_read( p_sys->p_jack_ringbuffer,
-                    (char *) p_dst, sizeof(jack_sample_t) );
-        }
+        const void *p_src;
+        size_t frames = aout_RingPeek( p_sys->ring, &p_src,
+                                       frames_from_rb - frames_read );
+        if( frames == 0 )
+            break;
+
+        const jack_sample_t *p_in = p_src;
+        for( j = 0; j < frames; j++ )
+            for( i = 0; i < p_sys->i_channels; i++ )
+                p_sys->p_jack_buffers[i][frames_read + j] = *p_in++;
+
+        if( aout_RingConsume( p_sys->ring, p_src, frames ) )
+            frames_read += frames;
+        else
+            frames_read = 0; /* flushed meanwhile */
     }
 
     /* Fill any remaining buffer with silence */
-    frames_read = (bytes_read / sizeof(jack_sample_t)) / p_sys->i_channels;
     if( frames_read < i_frames )
     {
+        if( frames_from_rb > 0 )
+            aout_UnderrunReport( p_aout, 1 );
         for( i = 0; i < p_sys->i_channels; i++ )
         {
             memset( p_sys->p_jack_buffers[i] + frames_read, 0,
@@ -446,7 +429,7 @@ static void Stop( audio_output_t *p_aout )
     }
     free( p_sys->p_jack_ports );
     free( p_sys->p_jack_buffers );
-    jack_ringbuffer_free( p_sys->p_jack_ringbuffer );
+    aout_RingDelete( p_sys->ring );
 }
 
 static int Open(vlc_object_t *obj)
@@ -354,6 +354,7 @@ static void stream_underflow_cb(pa_stream *s, void *userdata)
     audio_output_t *aout = userdata;
 
     msg_Dbg(aout, "underflow");
+    aout_UnderrunReport(aout, 1);
     (void) s;
 }
 
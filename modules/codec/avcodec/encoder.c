@@ -1136,7 +1136,8 @@ static void check_hurry_up( encoder_sys_t *p_sys, AVFrame *frame, encoder_t *p_e
         }
     }
 
-    if ( current_date + HURRY_UP_GUARD1 > FROM_AV_TS(frame->pts) )
+    if ( current_date + HURRY_UP_GUARD1 > FROM_AV_TS(frame->pts)
+      && frame->pict_type != AV_PICTURE_TYPE_I )
     {
         frame->pict_type = AV_PICTURE_TYPE_P;
         /* msg_Dbg( p_enc, "hurry up mode 1 %lld", current_date + HURRY_UP_GUARD1 - frame.pts ); */
@@ -1193,8 +1194,8 @@ static block_t *EncodeVideo( encoder_t *p_enc, picture_t *p_pict )
             p_sys->frame->linesize[i_plane] = p_pict->p[i_plane].i_pitch;
         }
 
-        /* Let libavcodec select the frame type */
-        frame->pict_type = 0;
+        /* Let libavcodec select the frame type, unless it is forced */
+        frame->pict_type = p_pict->b_keyframe ? AV_PICTURE_TYPE_I : 0;
 
         frame->repeat_pict = p_pict->i_nb_fields - 2;
         frame->interlaced_frame = !p_pict->b_progressive;
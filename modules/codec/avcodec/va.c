@@ -24,6 +24,7 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_codec.h>
 #include <vlc_modules.h>
 #include <vlc_fourcc.h>
 #include <libavutil/pixfmt.h>
@@ -103,16 +104,123 @@ static int vlc_va_Start(void *func, bool forced, va_list ap)
     return open(va, ctx, hwfmt, src_desc, fmt_in, device, fmt_out, vtcx_out);
 }
 
+/* What the hardware decoders could decode so far, per codec, profile and
+ * bit depth/chroma sampling. Probing may be slow (device creation, surface
+ * allocation), so a stream is not probed again if a smaller stream of the
+ * same kind already failed, for the lifetime of the process. */
+struct vlc_va_caps
+{
+    enum AVCodecID codec;
+    int profile;
+    enum PixelFormat hwfmt;
+    enum PixelFormat swfmt;
+    int ok_width, ok_height; /* largest decoded size, 0 if none */
+    int fail_width, fail_height; /* smallest failed size, 0 if none */
+};
+
+#define VA_CAPS_MAX 32
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct vlc_va_caps entries[VA_CAPS_MAX];
+    size_t count;
+    size_t next; /* oldest entry, overwritten when full */
+} va_caps = { VLC_STATIC_MUTEX, { { 0 } }, 0, 0 };
+
+/* Must be called with the lock held */
+static struct vlc_va_caps *vlc_va_FindCaps(const AVCodecContext *avctx,
+                                           enum PixelFormat hwfmt,
+                                           enum PixelFormat swfmt)
+{
+    for (size_t i = 0; i < va_caps.count; i++)
+    {
+        struct vlc_va_caps *caps = &va_caps.entries[i];
+
+        if (caps->codec == avctx->codec_id && caps->profile == avctx->profile
+         && caps->hwfmt == hwfmt && caps->swfmt == swfmt)
+            return caps;
+    }
+    return NULL;
+}
+
+bool vlc_va_MayDecodeStream(const AVCodecContext *avctx,
+                            enum PixelFormat hwfmt, enum PixelFormat swfmt)
+{
+    bool ok = true;
+
+    vlc_mutex_lock(&va_caps.lock);
+    const struct vlc_va_caps *caps = vlc_va_FindCaps(avctx, hwfmt, swfmt);
+    if (caps != NULL && caps->fail_width > 0)
+        ok = avctx->coded_width < caps->fail_width
+          || avctx->coded_height < caps->fail_height;
+    vlc_mutex_unlock(&va_caps.lock);
+    return ok;
+}
+
+static void vlc_va_AddCaps(const AVCodecContext *avctx, enum PixelFormat hwfmt,
+                           enum PixelFormat swfmt, bool ok)
+{
+    const int width = avctx->coded_width, height = avctx->coded_height;
+
+    vlc_mutex_lock(&va_caps.lock);
+    struct vlc_va_caps *caps = vlc_va_FindCaps(avctx, hwfmt, swfmt);
+    if (caps == NULL)
+    {
+        caps = &va_caps.entries[va_caps.next];
+        va_caps.next = (va_caps.next + 1) % VA_CAPS_MAX;
+        if (va_caps.count < VA_CAPS_MAX)
+            va_caps.count++;
+
+        *caps = (struct vlc_va_caps) {
+            .codec = avctx->codec_id,
+            .profile = avctx->profile,
+            .hwfmt = hwfmt,
+            .swfmt = swfmt,
+        };
+    }
+
+    if (ok)
+    {
+        if (width >= caps->ok_width && height >= caps->ok_height)
+        {
+            caps->ok_width = width;
+            caps->ok_height = height;
+        }
+        /* A larger stream was decoded: the failure was transient */
+        if (caps->fail_width > 0
+         && width >= caps->fail_width && height >= caps->fail_height)
+            caps->fail_width = caps->fail_height = 0;
+    }
+    else if (width > caps->ok_width || height > caps->ok_height)
+    {
+        if (caps->fail_width == 0
+         || (width <= caps->fail_width && height <= caps->fail_height))
+        {
+            caps->fail_width = width;
+            caps->fail_height = height;
+        }
+    }
+    vlc_mutex_unlock(&va_caps.lock);
+}
+
 vlc_va_t *vlc_va_New(vlc_object_t *obj, AVCodecContext *avctx,
                      enum PixelFormat hwfmt, const AVPixFmtDescriptor *src_desc,
                      const es_format_t *fmt_in, vlc_decoder_device *device,
                      video_format_t *fmt_out, vlc_video_context **vtcx_out)
 {
+    const enum PixelFormat swfmt = av_pix_fmt_desc_get_id(src_desc);
+
+    if (!vlc_va_MayDecodeStream(avctx, hwfmt, swfmt))
+    {
+        msg_Dbg(obj, "skipping hardware decoders, known to fail");
+        return NULL;
+    }
+
     struct vlc_va_t *va = vlc_object_create(obj, sizeof (*va));
     if (unlikely(va == NULL))
         return NULL;
 
-
     if (vlc_module_load(va, "hw decoder", NULL, true,
                         vlc_va_Start, va, avctx, hwfmt, src_desc, fmt_in, device,
                         fmt_out, vtcx_out) == NULL)
@@ -120,6 +228,7 @@ vlc_va_t *vlc_va_New(vlc_object_t *obj, AVCodecContext *avctx,
         vlc_object_delete(va);
         va = NULL;
     }
+    vlc_va_AddCaps(avctx, hwfmt, swfmt, va != NULL);
 
     return va;
 }
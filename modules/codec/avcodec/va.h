@@ -65,6 +65,18 @@ typedef int (*vlc_va_open)(vlc_va_t *, AVCodecContext *,
  */
 bool vlc_va_MightDecode(enum PixelFormat hwfmt, enum PixelFormat swfmt);
 
+/**
+ * Determines whether a hardware decoder may decode a stream, according to
+ * the previous attempts: a stream is known to fail if a stream with the same
+ * codec, profile and software format, and no larger dimensions, failed.
+ * This is cheap, and is meant to skip the decoder device creation.
+ * @param hwfmt the hardware acceleration pixel format
+ * @param swfmt the software pixel format
+ * @return false if hardware decoding is known to fail
+ */
+bool vlc_va_MayDecodeStream(const AVCodecContext *, enum PixelFormat hwfmt,
+                            enum PixelFormat swfmt);
+
 /**
  * Creates an accelerated video decoding back-end for libavcodec.
  * @param obj parent VLC object
@@ -55,6 +55,8 @@ struct vlc_va_sys_t
     vlc_video_context *vctx;
     va_pool_t *va_pool;
     VASurfaceID render_targets[MAX_SURFACE_COUNT];
+    video_format_t surface_fmt;
+    unsigned surface_count;
 };
 
 static int GetVaProfile(const AVCodecContext *ctx, const es_format_t *fmt_in,
@@ -198,6 +200,9 @@ static void VAAPIDestroyDevice(void *opaque)
         vlc_vaapi_DestroyContext(NULL, sys->hw_ctx.display, sys->hw_ctx.context_id);
     if (sys->hw_ctx.config_id != VA_INVALID_ID)
         vlc_vaapi_DestroyConfig(NULL, sys->hw_ctx.display, sys->hw_ctx.config_id);
+    if (sys->surface_count > 0)
+        vlc_vaapi_ReleaseSurfaces(sys->hw_ctx.display, &sys->surface_fmt,
+                                  sys->render_targets, sys->surface_count);
     free(sys);
 }
 
@@ -208,27 +213,13 @@ static int VAAPICreateDecoderSurfaces(vlc_va_t *va, int codec_id,
     VLC_UNUSED(codec_id);
     vlc_va_sys_t *sys = va->sys;
 
-    unsigned va_rt_format;
-    int va_fourcc;
-    vlc_chroma_to_vaapi(fmt->i_chroma, &va_rt_format, &va_fourcc);
-
-    VASurfaceAttrib fourcc_attribs[1] = {
-        {
-            .type = VASurfaceAttribPixelFormat,
-            .flags = VA_SURFACE_ATTRIB_SETTABLE,
-            .value.type    = VAGenericValueTypeInteger,
-            .value.value.i = va_fourcc,
-        }
-    };
-
-    VA_CALL(VLC_OBJECT(va), vaCreateSurfaces, sys->hw_ctx.display, va_rt_format,
-            fmt->i_visible_width, fmt->i_visible_height,
-            sys->render_targets, count,
-            fourcc_attribs, 1);
+    if (vlc_vaapi_AcquireSurfaces(VLC_OBJECT(va), sys->hw_ctx.display, fmt,
+                                  sys->render_targets, count))
+        return VLC_EGENERIC;
 
+    sys->surface_fmt = *fmt;
+    sys->surface_count = count;
     return VLC_SUCCESS;
-error:
-    return VLC_EGENERIC;
 }
 
 static void VAAPISetupAVCodecContext(void *opaque, AVCodecContext *avctx)
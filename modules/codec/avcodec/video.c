@@ -76,6 +76,7 @@ typedef struct
     bool b_show_corrupted;
     bool b_from_preroll;
     enum AVDiscard i_skip_frame;
+    enum AVDiscard i_skip_loop_filter;
 
     struct frame_info_s frame_info[FRAME_INFO_DEPTH];
 
@@ -107,6 +108,9 @@ typedef struct
     int profile;
     int level;
 
+    /* threads reserved from the shared budget, 0 if forced by the user */
+    unsigned threads;
+
     // decoder output seen by lavc, regardless of texture padding
     unsigned decoder_width;
     unsigned decoder_height;
@@ -572,6 +576,7 @@ int InitVideoDec( vlc_object_t *obj )
     else if( i_val == 2 ) p_context->skip_loop_filter = AVDISCARD_BIDIR;
     else if( i_val == 1 ) p_context->skip_loop_filter = AVDISCARD_NONREF;
     else p_context->skip_loop_filter = AVDISCARD_DEFAULT;
+    p_sys->i_skip_loop_filter = p_context->skip_loop_filter;
 
     if( var_CreateGetBool( p_dec, "avcodec-fast" ) )
         p_context->flags2 |= AV_CODEC_FLAG2_FAST;
@@ -632,6 +637,9 @@ int InitVideoDec( vlc_object_t *obj )
 #else
         i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 10 : 6 );
 #endif
+        /* Share the CPUs with the other decoders */
+        p_sys->threads = decoder_AcquireThreads( p_dec, i_thread_count );
+        i_thread_count = p_sys->threads;
     }
     i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 32 : 16 );
     msg_Dbg( p_dec, "allowing %d thread(s) for decoding", i_thread_count );
@@ -693,6 +701,8 @@ int InitVideoDec( vlc_object_t *obj )
     /* ***** Open the codec ***** */
     if( OpenVideoCodec( p_dec ) < 0 )
     {
+        if( p_sys->threads > 0 )
+            decoder_ReleaseThreads( p_dec, p_sys->threads );
         vlc_mutex_destroy( &p_sys->lock );
         free( p_sys );
         avcodec_free_context( &p_context );
@@ -1042,6 +1052,29 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
     if( p_sys->b_hurry_up )
     {
         p_context->skip_frame = p_sys->i_skip_frame;
+        p_context->skip_loop_filter = p_sys->i_skip_loop_filter;
+
+        /* Skip more and more of the decoding as the owner sees the
+         * pictures displayed late */
+        if( p_dec->b_frame_drop_allowed && b_need_output_picture )
+        {
+            switch( decoder_GetSkipLevel( p_dec ) )
+            {
+                case VLC_DECODER_SKIP_NONKEY:
+                    p_context->skip_frame =
+                        __MAX( p_context->skip_frame, AVDISCARD_NONKEY );
+                    /* fall through */
+                case VLC_DECODER_SKIP_LOOP_FILTER:
+                    p_context->skip_loop_filter = AVDISCARD_ALL;
+                    /* fall through */
+                case VLC_DECODER_SKIP_NONREF:
+                    p_context->skip_frame =
+                        __MAX( p_context->skip_frame, AVDISCARD_NONREF );
+                    break;
+                default:
+                    break;
+            }
+        }
 
         /* Check also if we should/can drop the block and move to next block
             as trying to catchup the speed*/
@@ -1403,6 +1436,9 @@ void EndVideoDec( vlc_object_t *obj )
     if( p_sys->p_va )
         vlc_va_Delete( p_sys->p_va );
 
+    if( p_sys->threads > 0 )
+        decoder_ReleaseThreads( p_dec, p_sys->threads );
+
     vlc_mutex_destroy( &p_sys->lock );
     free( p_sys );
 }
@@ -1754,6 +1790,12 @@ no_reuse:
             continue;
         }
         const AVPixFmtDescriptor *dsc = av_pix_fmt_desc_get(hwfmt);
+        if (!vlc_va_MayDecodeStream(p_context, hwfmt, swfmt))
+        {   /* do not even create the decoder device */
+            msg_Dbg(p_dec, "skipping format %s, known to fail",
+                    dsc ? dsc->name : "unknown");
+            continue;
+        }
         vlc_decoder_device *init_device = NULL;
         msg_Dbg(p_dec, "trying format %s", dsc ? dsc->name : "unknown");
         if (lavc_UpdateVideoFormat(p_dec, p_context, hwfmt, swfmt, &init_device) ||
@@ -53,6 +53,9 @@ static void CloseDecoder(vlc_object_t *);
 #define THREAD_FRAMES_LONGTEXT N_( "Max number of threads used for frame decoding, default 0=auto" )
 #define THREAD_TILES_TEXT N_("Tiles Threads")
 #define THREAD_TILES_LONGTEXT N_( "Max number of threads used for tile decoding, default 0=auto" )
+#define LOW_LATENCY_TEXT N_("Low latency")
+#define LOW_LATENCY_LONGTEXT N_( "Output each frame as soon as it is decoded, " \
+    "using only tile threads. This lowers the throughput." )
 
 
 vlc_module_begin ()
@@ -67,6 +70,8 @@ vlc_module_begin ()
                 THREAD_FRAMES_TEXT, THREAD_FRAMES_LONGTEXT, false)
     add_integer("dav1d-thread-tiles", 0,
                 THREAD_TILES_TEXT, THREAD_TILES_LONGTEXT, false)
+    add_bool("dav1d-low-latency", false,
+             LOW_LATENCY_TEXT, LOW_LATENCY_LONGTEXT, true)
 vlc_module_end ()
 
 /*****************************************************************************
@@ -76,6 +81,12 @@ typedef struct
 {
     Dav1dSettings s;
     Dav1dContext *c;
+    unsigned threads; /* reserved from the shared budget */
+
+    /* frame delay statistics */
+    uint64_t frames_in;
+    uint64_t frames_out;
+    uint64_t max_delay;
 } decoder_sys_t;
 
 static const struct
@@ -176,6 +187,7 @@ static void FlushDecoder(decoder_t *dec)
 {
     decoder_sys_t *p_sys = dec->p_sys;
     dav1d_flush(p_sys->c);
+    p_sys->frames_in = p_sys->frames_out; /* dropped */
 }
 
 static void release_block(const uint8_t *buf, void *b)
@@ -224,6 +236,7 @@ static int Decode(decoder_t *dec, block_t *block)
     do {
         if( p_data )
         {
+            size_t sz = p_data->sz;
             res = dav1d_send_data(p_sys->c, p_data);
             if (res < 0 && res != -EAGAIN)
             {
@@ -231,6 +244,8 @@ static int Decode(decoder_t *dec, block_t *block)
                 i_ret = VLC_EGENERIC;
                 break;
             }
+            if (sz != 0 && p_data->sz == 0)
+                p_sys->frames_in++;
         }
 
         res = dav1d_get_picture(p_sys->c, &img);
@@ -246,6 +261,12 @@ static int Decode(decoder_t *dec, block_t *block)
             }
             pic->b_progressive = true; /* codec does not support interlacing */
             pic->date = img.m.timestamp;
+
+            /* frames sent but not output yet, including this one */
+            if (p_sys->frames_in > p_sys->frames_out
+             && p_sys->frames_in - p_sys->frames_out > p_sys->max_delay)
+                p_sys->max_delay = p_sys->frames_in - p_sys->frames_out;
+            p_sys->frames_out++;
             /* TODO udpate the color primaries and such */
             decoder_QueueVideo(dec, pic);
             dav1d_picture_unref(&img);
@@ -284,12 +305,28 @@ static int OpenDecoder(vlc_object_t *p_this)
         return VLC_ENOMEM;
 
     dav1d_default_settings(&p_sys->s);
+    p_sys->threads = 0;
+    p_sys->frames_in = p_sys->frames_out = p_sys->max_delay = 0;
+
+    /* Each frame thread delays the output by one frame */
+    const bool low_latency = var_InheritBool(p_this, "dav1d-low-latency");
+    p_sys->s.n_frame_threads = low_latency ? 1 :
+        var_InheritInteger(p_this, "dav1d-thread-frames");
     p_sys->s.n_tile_threads = var_InheritInteger(p_this, "dav1d-thread-tiles");
-    if (p_sys->s.n_tile_threads == 0)
-        p_sys->s.n_tile_threads = VLC_CLIP(vlc_GetCPUCount(), 1, 4);
-    p_sys->s.n_frame_threads = var_InheritInteger(p_this, "dav1d-thread-frames");
     if (p_sys->s.n_frame_threads == 0)
-        p_sys->s.n_frame_threads = __MAX(1, vlc_GetCPUCount());
+    {
+        /* Share the CPUs with the other decoders */
+        p_sys->threads = decoder_AcquireThreads(dec,
+                                                __MAX(1, vlc_GetCPUCount()));
+        p_sys->s.n_frame_threads = p_sys->threads;
+    }
+    else if (low_latency && p_sys->s.n_tile_threads == 0)
+        /* Only the tile threads run in parallel: reserve those */
+        p_sys->threads = decoder_AcquireThreads(dec,
+                                                VLC_CLIP(vlc_GetCPUCount(), 1, 4));
+    if (p_sys->s.n_tile_threads == 0)
+        p_sys->s.n_tile_threads = VLC_CLIP(vlc_GetCPUCount(), 1,
+                                           p_sys->threads ? __MIN(p_sys->threads, 4) : 4);
     p_sys->s.allocator.cookie = dec;
     p_sys->s.allocator.alloc_picture_callback = NewPicture;
     p_sys->s.allocator.release_picture_callback = FreePicture;
@@ -297,11 +334,14 @@ static int OpenDecoder(vlc_object_t *p_this)
     if (dav1d_open(&p_sys->c, &p_sys->s) < 0)
     {
         msg_Err(p_this, "Could not open the Dav1d decoder");
+        if (p_sys->threads > 0)
+            decoder_ReleaseThreads(dec, p_sys->threads);
         return VLC_EGENERIC;
     }
 
-    msg_Dbg(p_this, "Using dav1d version %s with %d/%d frame/tile threads",
-            dav1d_version(), p_sys->s.n_frame_threads, p_sys->s.n_tile_threads);
+    msg_Dbg(p_this, "Using dav1d version %s with %d/%d frame/tile threads%s",
+            dav1d_version(), p_sys->s.n_frame_threads, p_sys->s.n_tile_threads,
+            low_latency ? " (low latency)" : "");
 
     dec->pf_decode = Decode;
     dec->pf_flush = FlushDecoder;
@@ -336,5 +376,12 @@ static void CloseDecoder(vlc_object_t *p_this)
     FlushDecoder(dec);
 
     dav1d_close(&p_sys->c);
+
+    msg_Dbg(p_this, "decoded %"PRIu64" frames, max frame delay %"PRIu64
+            " with %d frame threads", p_sys->frames_out, p_sys->max_delay,
+            p_sys->s.n_frame_threads);
+
+    if (p_sys->threads > 0)
+        decoder_ReleaseThreads(dec, p_sys->threads);
 }
 
@@ -495,6 +495,28 @@ jpeg_GetOrientation( j_decompress_ptr cinfo )
     return 0;     /* No EXIF Orientation tag found */
 }
 
+/*
+ * Picks the DCT scaling for the size hinted by the image handler, if any,
+ * so that the picture is still at least as large as asked.
+ */
+static unsigned GetScaleDenom(decoder_t *p_dec, unsigned i_width,
+                              unsigned i_height)
+{
+    unsigned i_hint_width  = var_GetInteger(p_dec, "image-width");
+    unsigned i_hint_height = var_GetInteger(p_dec, "image-height");
+    unsigned i_denom = 1;
+
+    if (i_hint_width == 0 && i_hint_height == 0)
+        return 1;
+
+    /* 1/2, 1/4 and 1/8 are supported by every libjpeg */
+    while (i_denom < 8
+        && i_width / (2 * i_denom) >= i_hint_width
+        && i_height / (2 * i_denom) >= i_hint_height)
+        i_denom *= 2;
+    return i_denom;
+}
+
 /*
  * This function must be fed with a complete compressed frame.
  */
@@ -526,6 +548,14 @@ static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
     jpeg_read_header(&p_sys->p_jpeg, TRUE);
 
     p_sys->p_jpeg.out_color_space = JCS_RGB;
+    p_sys->p_jpeg.scale_num = 1;
+    p_sys->p_jpeg.scale_denom = GetScaleDenom(p_dec, p_sys->p_jpeg.image_width,
+                                              p_sys->p_jpeg.image_height);
+    if (p_sys->p_jpeg.scale_denom > 1)
+    {   /* the converter finishes the scaling anyway */
+        p_sys->p_jpeg.dct_method = JDCT_IFAST;
+        p_sys->p_jpeg.do_fancy_upsampling = FALSE;
+    }
 
     jpeg_start_decompress(&p_sys->p_jpeg);
 
@@ -55,6 +55,16 @@
 static int  Create ( vlc_object_t * );
 static void Destroy( vlc_object_t * );
 
+#define PRERENDER_TEXT N_("Prerender subtitles")
+#define PRERENDER_LONGTEXT N_("Render the next subtitle frame in advance, " \
+    "on a separate thread, while the current video frame is displayed.")
+#define GLYPH_CACHE_TEXT N_("Glyph cache size")
+#define GLYPH_CACHE_LONGTEXT N_("Maximum number of cached glyphs " \
+    "(0 for the libass default).")
+#define BITMAP_CACHE_TEXT N_("Bitmap cache size (MiB)")
+#define BITMAP_CACHE_LONGTEXT N_("Maximum size of the cached glyph bitmaps " \
+    "(0 for the libass default). Large displays may need more.")
+
 vlc_module_begin ()
     set_shortname( N_("Subtitles (advanced)"))
     set_description( N_("Subtitle renderers using libass") )
@@ -62,6 +72,14 @@ vlc_module_begin ()
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_SCODEC )
     set_callbacks( Create, Destroy )
+
+    add_bool( "ass-prerender", true, PRERENDER_TEXT, PRERENDER_LONGTEXT, true )
+    add_integer( "ass-glyph-cache", 0, GLYPH_CACHE_TEXT, GLYPH_CACHE_LONGTEXT,
+                 true )
+        change_integer_range( 0, INT_MAX )
+    add_integer( "ass-bitmap-cache", 0, BITMAP_CACHE_TEXT,
+                 BITMAP_CACHE_LONGTEXT, true )
+        change_integer_range( 0, 4096 )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -86,6 +104,23 @@ typedef struct
 
     /* */
     ASS_Track      *p_track;
+
+    /* The next frame rendered in advance, protected by lock */
+    struct
+    {
+        bool                b_running;
+        bool                b_quit;
+        vlc_thread_t        thread;
+        vlc_cond_t          wait;
+        vlc_tick_t          i_step; /**< interval between the renders */
+        vlc_tick_t          i_last; /**< date of the last render */
+        vlc_tick_t          i_request; /**< date to render next */
+        vlc_tick_t          i_date; /**< date of the result */
+        bool                b_ready;
+        bool                b_changed;
+        bool                b_empty;
+        subpicture_region_t *p_region;
+    } prerender;
 } decoder_sys_t;
 static void DecSysRelease( decoder_sys_t *p_sys );
 static void DecSysHold( decoder_sys_t *p_sys );
@@ -109,6 +144,8 @@ typedef struct
     vlc_tick_t    i_pts;
 
     ASS_Image     *p_img;
+    bool          b_prerendered; /**< p_region replaces p_img */
+    subpicture_region_t *p_region;
 } libass_spu_updater_sys_t;
 
 typedef struct
@@ -121,6 +158,8 @@ typedef struct
 
 static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_img_list, int i_width, int i_height );
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img );
+static subpicture_region_t *RenderRegions( const video_format_t *p_fmt, ASS_Image *p_img );
+static void *PrerenderThread( void * );
 
 //#define DEBUG_REGION
 
@@ -150,6 +189,14 @@ static int Create( vlc_object_t *p_this )
     p_sys->p_library  = NULL;
     p_sys->p_renderer = NULL;
     p_sys->p_track    = NULL;
+    p_sys->prerender.b_running = false;
+    p_sys->prerender.b_quit    = false;
+    vlc_cond_init( &p_sys->prerender.wait );
+    p_sys->prerender.i_step    = 0;
+    p_sys->prerender.i_last    = VLC_TICK_INVALID;
+    p_sys->prerender.i_request = VLC_TICK_INVALID;
+    p_sys->prerender.b_ready   = false;
+    p_sys->prerender.p_region  = NULL;
 
     /* Create libass library */
     ASS_Library *p_library = p_sys->p_library = ass_library_init();
@@ -213,6 +260,9 @@ static int Create( vlc_object_t *p_this )
     //    ass_set_margins( p_renderer, int t, int b, int l, int r);
     ass_set_font_scale( p_renderer, 1.0 );
     ass_set_line_spacing( p_renderer, 0.0 );
+    ass_set_cache_limits( p_renderer,
+                          var_InheritInteger( p_dec, "ass-glyph-cache" ),
+                          var_InheritInteger( p_dec, "ass-bitmap-cache" ) );
 
 #if defined( __ANDROID__ )
     const char *psz_font, *psz_family;
@@ -273,6 +323,11 @@ static int Create( vlc_object_t *p_this )
 
     p_dec->fmt_out.i_codec = VLC_CODEC_RGBA;
 
+    if( var_InheritBool( p_dec, "ass-prerender" ) )
+        p_sys->prerender.b_running =
+            !vlc_clone( &p_sys->prerender.thread, PrerenderThread, p_sys,
+                        VLC_THREAD_PRIORITY_VIDEO );
+
     return VLC_SUCCESS;
 }
 
@@ -302,7 +357,14 @@ static void DecSysRelease( decoder_sys_t *p_sys )
         vlc_mutex_unlock( &p_sys->lock );
         return;
     }
+    p_sys->prerender.b_quit = true;
+    vlc_cond_signal( &p_sys->prerender.wait );
     vlc_mutex_unlock( &p_sys->lock );
+
+    if( p_sys->prerender.b_running )
+        vlc_join( p_sys->prerender.thread, NULL );
+    if( p_sys->prerender.p_region )
+        subpicture_region_ChainDelete( p_sys->prerender.p_region );
     vlc_mutex_destroy( &p_sys->lock );
 
     if( p_sys->p_track )
@@ -373,6 +435,8 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     }
 
     p_spu_sys->p_img = NULL;
+    p_spu_sys->b_prerendered = false;
+    p_spu_sys->p_region = NULL;
     p_spu_sys->p_dec_sys = p_sys;
     p_spu_sys->i_subs_len = p_block->i_buffer;
     p_spu_sys->p_subs_data = malloc( p_block->i_buffer );
@@ -409,6 +473,91 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     return VLCDEC_SUCCESS;
 }
 
+/****************************************************************************
+ * Prerendering: while the vout waits for the next picture, the worker thread
+ * renders the subtitles at the date of the next frame, guessed from the
+ * interval between the last two renders.
+ ****************************************************************************/
+
+/* Must be called with the lock held */
+static bool PrerenderTake( decoder_sys_t *p_sys, vlc_tick_t i_date,
+                           bool b_fmt_changed, subpicture_region_t **pp_region,
+                           int *pi_changed, bool *pb_empty )
+{
+    p_sys->prerender.i_request = VLC_TICK_INVALID;
+    if( !p_sys->prerender.b_ready )
+        return false;
+
+    p_sys->prerender.b_ready = false;
+    subpicture_region_t *p_region = p_sys->prerender.p_region;
+    p_sys->prerender.p_region = NULL;
+
+    /* Rendered for another date or size (seek, frame drop, resize) */
+    if( b_fmt_changed || p_sys->prerender.i_date != i_date )
+    {
+        if( p_region )
+            subpicture_region_ChainDelete( p_region );
+        return false;
+    }
+
+    *pp_region = p_region;
+    *pi_changed = p_sys->prerender.b_changed;
+    *pb_empty = p_sys->prerender.b_empty;
+    return true;
+}
+
+/* Must be called with the lock held */
+static void PrerenderSchedule( decoder_sys_t *p_sys, vlc_tick_t i_date )
+{
+    if( p_sys->prerender.i_last != VLC_TICK_INVALID )
+    {
+        vlc_tick_t i_step = i_date - p_sys->prerender.i_last;
+        if( i_step > 0 && i_step <= VLC_TICK_FROM_MS(200) )
+            p_sys->prerender.i_step = i_step;
+    }
+    p_sys->prerender.i_last = i_date;
+
+    if( p_sys->prerender.b_running && p_sys->prerender.i_step > 0 )
+    {
+        p_sys->prerender.i_request = i_date + p_sys->prerender.i_step;
+        vlc_cond_signal( &p_sys->prerender.wait );
+    }
+}
+
+static void *PrerenderThread( void *data )
+{
+    decoder_sys_t *p_sys = data;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( ;; )
+    {
+        while( !p_sys->prerender.b_quit &&
+               p_sys->prerender.i_request == VLC_TICK_INVALID )
+            vlc_cond_wait( &p_sys->prerender.wait, &p_sys->lock );
+        if( p_sys->prerender.b_quit )
+            break;
+
+        vlc_tick_t i_date = p_sys->prerender.i_request;
+        p_sys->prerender.i_request = VLC_TICK_INVALID;
+
+        int i_changed;
+        ASS_Image *p_img = ass_render_frame( p_sys->p_renderer, p_sys->p_track,
+                                             MS_FROM_VLC_TICK( i_date ), &i_changed );
+
+        if( p_sys->prerender.p_region )
+            subpicture_region_ChainDelete( p_sys->prerender.p_region );
+        /* Unchanged frames are not drawn, the current regions are kept */
+        p_sys->prerender.p_region = i_changed ? RenderRegions( &p_sys->fmt, p_img )
+                                              : NULL;
+        p_sys->prerender.i_date = i_date;
+        p_sys->prerender.b_changed = i_changed != 0;
+        p_sys->prerender.b_empty = p_img == NULL;
+        p_sys->prerender.b_ready = true;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
+}
+
 /****************************************************************************
  *
  ****************************************************************************/
@@ -439,16 +588,35 @@ static int SubpictureValidate( subpicture_t *p_subpic,
     /* */
     const vlc_tick_t i_stream_date = p_spusys->i_pts + (i_ts - p_subpic->i_start);
     int i_changed;
-    ASS_Image *p_img = ass_render_frame( p_sys->p_renderer, p_sys->p_track,
-                                         MS_FROM_VLC_TICK( i_stream_date ), &i_changed );
+    bool b_empty;
+    ASS_Image *p_img = NULL;
+    subpicture_region_t *p_pre = NULL;
+    bool b_prerendered = PrerenderTake( p_sys, i_stream_date,
+                                        b_fmt_src || b_fmt_dst,
+                                        &p_pre, &i_changed, &b_empty );
+    /* An undrawn prerendered frame needs the current regions to be reused */
+    if( b_prerendered && p_pre == NULL && !b_empty &&
+        p_subpic->p_region == NULL )
+        b_prerendered = false;
+    if( !b_prerendered )
+    {
+        p_img = ass_render_frame( p_sys->p_renderer, p_sys->p_track,
+                                  MS_FROM_VLC_TICK( i_stream_date ), &i_changed );
+        b_empty = p_img == NULL;
+    }
+    PrerenderSchedule( p_sys, i_stream_date );
 
     if( !i_changed && !b_fmt_src && !b_fmt_dst &&
-        (p_img != NULL) == (p_subpic->p_region != NULL) )
+        !b_empty == (p_subpic->p_region != NULL) )
     {
+        if( p_pre )
+            subpicture_region_ChainDelete( p_pre );
         vlc_mutex_unlock( &p_sys->lock );
         return VLC_SUCCESS;
     }
     p_spusys->p_img = p_img;
+    p_spusys->b_prerendered = b_prerendered;
+    p_spusys->p_region = p_pre;
 
     /* The lock is released by SubpictureUpdate */
     return VLC_EGENERIC;
@@ -465,12 +633,24 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
     decoder_sys_t *p_sys = p_spusys->p_dec_sys;
 
     video_format_t fmt = p_sys->fmt;
-    ASS_Image *p_img = p_spusys->p_img;
 
     /* */
     p_subpic->i_original_picture_height = fmt.i_visible_height;
     p_subpic->i_original_picture_width = fmt.i_visible_width;
 
+    if( p_spusys->b_prerendered )
+        p_subpic->p_region = p_spusys->p_region;
+    else
+        p_subpic->p_region = RenderRegions( &fmt, p_spusys->p_img );
+    p_spusys->p_region = NULL;
+    vlc_mutex_unlock( &p_sys->lock );
+}
+
+static subpicture_region_t *RenderRegions( const video_format_t *p_fmt, ASS_Image *p_img )
+{
+    video_format_t fmt = *p_fmt;
+    subpicture_region_t *p_region_list = NULL;
+
     /* XXX to improve efficiency we merge regions that are close minimizing
      * the lost surface.
      * libass tends to create a lot of small regions and thus spu engine
@@ -481,14 +661,8 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
     rectangle_t region[i_max_region];
     const int i_region = BuildRegions( region, i_max_region, p_img, fmt.i_width, fmt.i_height );
 
-    if( i_region <= 0 )
-    {
-        vlc_mutex_unlock( &p_sys->lock );
-        return;
-    }
-
     /* Allocate the regions and draw them */
-    subpicture_region_t **pp_region_last = &p_subpic->p_region;
+    subpicture_region_t **pp_region_last = &p_region_list;
 
     for( int i = 0; i < i_region; i++ )
     {
@@ -516,14 +690,15 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         *pp_region_last = r;
         pp_region_last = &r->p_next;
     }
-    vlc_mutex_unlock( &p_sys->lock );
-
+    return p_region_list;
 }
 static void SubpictureDestroy( subpicture_t *p_subpic )
 {
     libass_spu_updater_sys_t *p_spusys = p_subpic->updater.p_sys;
 
     DecSysRelease( p_spusys->p_dec_sys );
+    if( p_spusys->p_region )
+        subpicture_region_ChainDelete( p_spusys->p_region );
     free( p_spusys->p_subs_data );
     free( p_spusys );
 }
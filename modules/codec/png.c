@@ -184,6 +184,27 @@ static void user_warning( png_structp p_png, png_const_charp warning_msg )
     msg_Warn( p_sys->p_obj, "%s", warning_msg );
 }
 
+/*
+ * Picks the box downscaling for the size hinted by the image handler, if any,
+ * so that the picture is still at least as large as asked.
+ */
+static unsigned GetScaleFactor( decoder_t *p_dec, unsigned i_width,
+                                unsigned i_height )
+{
+    unsigned i_hint_width  = var_GetInteger( p_dec, "image-width" );
+    unsigned i_hint_height = var_GetInteger( p_dec, "image-height" );
+    unsigned i_factor = 1;
+
+    if( i_hint_width == 0 && i_hint_height == 0 )
+        return 1;
+
+    while( i_factor < 8
+        && i_width / (2 * i_factor) >= i_hint_width
+        && i_height / (2 * i_factor) >= i_hint_height )
+        i_factor *= 2;
+    return i_factor;
+}
+
 /****************************************************************************
  * DecodeBlock: the whole thing
  ****************************************************************************
@@ -201,6 +222,8 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     png_structp p_png;
     png_infop p_info, p_end_info;
     png_bytep *volatile p_row_pointers = NULL;
+    png_bytep volatile p_row = NULL;
+    uint32_t *volatile p_sums = NULL;
 
     if( !p_block ) /* No Drain */
         return VLCDEC_SUCCESS;
@@ -251,10 +274,17 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
                   &i_compression_type, &i_filter_type);
     if( p_sys->b_error ) goto error;
 
+    /* Interlaced pictures need all the passes before any row is complete */
+    unsigned i_scale = 1;
+    if( i_interlace_type == PNG_INTERLACE_NONE )
+        i_scale = GetScaleFactor( p_dec, i_width, i_height );
+
     /* Set output properties */
     p_dec->fmt_out.i_codec = VLC_CODEC_RGBA;
-    p_dec->fmt_out.video.i_visible_width = p_dec->fmt_out.video.i_width = i_width;
-    p_dec->fmt_out.video.i_visible_height = p_dec->fmt_out.video.i_height = i_height;
+    p_dec->fmt_out.video.i_visible_width = p_dec->fmt_out.video.i_width =
+        (i_width + i_scale - 1) / i_scale;
+    p_dec->fmt_out.video.i_visible_height = p_dec->fmt_out.video.i_height =
+        (i_height + i_scale - 1) / i_scale;
     p_dec->fmt_out.video.i_sar_num = 1;
     p_dec->fmt_out.video.i_sar_den = 1;
 
@@ -293,19 +323,65 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
     if( !p_pic ) goto error;
 
     /* Decode picture */
-    p_row_pointers = vlc_alloc( i_height, sizeof(png_bytep) );
-    if( !p_row_pointers )
-        goto error;
-    for( i = 0; i < (int)i_height; i++ )
-        p_row_pointers[i] = p_pic->p->p_pixels + p_pic->p->i_pitch * i;
+    if( i_scale > 1 )
+    {   /* Average the rows as they are decoded, one box height at a time */
+        const unsigned i_pixel =
+            p_dec->fmt_out.i_codec == VLC_CODEC_RGBA ? 4 : 3;
+        const unsigned i_out_width = p_dec->fmt_out.video.i_width;
+
+        png_read_update_info( p_png, p_info );
+        p_row = malloc( png_get_rowbytes( p_png, p_info ) );
+        p_sums = vlc_alloc( i_out_width * i_pixel, sizeof(*p_sums) );
+        if( !p_row || !p_sums )
+            goto error;
+
+        for( unsigned y = 0; y < i_height; y += i_scale )
+        {
+            const unsigned i_rows = __MIN( i_scale, i_height - y );
+
+            memset( p_sums, 0, i_out_width * i_pixel * sizeof(*p_sums) );
+            for( unsigned j = 0; j < i_rows; j++ )
+            {
+                png_read_row( p_png, p_row, NULL );
+                if( p_sys->b_error ) goto error;
+
+                for( unsigned x = 0; x < i_width; x++ )
+                    for( unsigned c = 0; c < i_pixel; c++ )
+                        p_sums[(x / i_scale) * i_pixel + c] +=
+                            p_row[x * i_pixel + c];
+            }
+
+            uint8_t *p_dst = p_pic->p->p_pixels
+                           + p_pic->p->i_pitch * (y / i_scale);
+            for( unsigned x = 0; x < i_out_width; x++ )
+            {
+                const unsigned i_count =
+                    i_rows * __MIN( i_scale, i_width - x * i_scale );
+
+                for( unsigned c = 0; c < i_pixel; c++ )
+                    p_dst[x * i_pixel + c] =
+                        (p_sums[x * i_pixel + c] + i_count / 2) / i_count;
+            }
+        }
+    }
+    else
+    {
+        p_row_pointers = vlc_alloc( i_height, sizeof(png_bytep) );
+        if( !p_row_pointers )
+            goto error;
+        for( i = 0; i < (int)i_height; i++ )
+            p_row_pointers[i] = p_pic->p->p_pixels + p_pic->p->i_pitch * i;
 
-    png_read_image( p_png, p_row_pointers );
-    if( p_sys->b_error ) goto error;
+        png_read_image( p_png, p_row_pointers );
+        if( p_sys->b_error ) goto error;
+    }
     png_read_end( p_png, p_end_info );
     if( p_sys->b_error ) goto error;
 
     png_destroy_read_struct( &p_png, &p_info, &p_end_info );
     free( p_row_pointers );
+    free( p_sums );
+    free( p_row );
 
     p_pic->date = p_block->i_pts != VLC_TICK_INVALID ? p_block->i_pts : p_block->i_dts;
 
@@ -316,6 +392,8 @@ static int DecodeBlock( decoder_t *p_dec, block_t *p_block )
  error:
 
     free( p_row_pointers );
+    free( p_sums );
+    free( p_row );
     png_destroy_read_struct( &p_png, &p_info, &p_end_info );
     block_Release( p_block );
     return VLCDEC_SUCCESS;
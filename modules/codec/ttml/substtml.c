@@ -89,6 +89,11 @@ typedef struct
     ttml_length_t    root_extent_h, root_extent_v;
     unsigned         i_cell_resolution_v;
     unsigned         i_cell_resolution_h;
+    /* lookups memoized for the document */
+    vlc_dictionary_t styles; /* by id, root node if missing */
+    vlc_dictionary_t regionnodes; /* by id, root node if missing */
+    const tt_node_t *p_inherit_node; /* last InheritTTMLStyles() node */
+    ttml_style_t    *p_inherit_style; /* and its result */
 } ttml_context_t;
 
 typedef struct
@@ -594,6 +599,25 @@ static void DictionaryMerge( const vlc_dictionary_t *p_src, vlc_dictionary_t *p_
     }
 }
 
+static const tt_node_t * FindNodeByID( ttml_context_t *p_ctx,
+                                       vlc_dictionary_t *p_cache,
+                                       const char *psz_nodename,
+                                       const char *psz_id )
+{
+    /* text nodes keep referencing the same few styles and regions, don't
+     * walk the whole document for each of them */
+    const tt_node_t *p_node = vlc_dictionary_value_for_key( p_cache, psz_id );
+    if( p_node == kVLCDictionaryNotFound )
+    {
+        p_node = FindNode( p_ctx->p_rootnode, psz_nodename, -1, psz_id );
+        vlc_dictionary_insert( p_cache, psz_id,
+                               (void *)( p_node ? p_node : p_ctx->p_rootnode ) );
+    }
+    else if( p_node == p_ctx->p_rootnode )
+        p_node = NULL;
+    return p_node;
+}
+
 static void DictMergeWithStyleID( ttml_context_t *p_ctx, const char *psz_styles,
                                   vlc_dictionary_t *p_dst )
 {
@@ -611,8 +635,8 @@ static void DictMergeWithStyleID( ttml_context_t *p_ctx, const char *psz_styles,
         while( psz_id )
         {
             /* Lookup referenced style ID */
-            const tt_node_t *p_node = FindNode( p_ctx->p_rootnode,
-                                                "style", -1, psz_id );
+            const tt_node_t *p_node = FindNodeByID( p_ctx, &p_ctx->styles,
+                                                    "style", psz_id );
             if( p_node )
                 DictionaryMerge( &p_node->attr_dict, &tempdict, true );
 
@@ -633,8 +657,9 @@ static void DictMergeWithRegionID( ttml_context_t *p_ctx, const char *psz_id,
     assert(p_ctx->p_rootnode);
     if( psz_id && p_ctx->p_rootnode )
     {
-        const tt_node_t *p_regionnode = FindNode( p_ctx->p_rootnode,
-                                                 "region", -1, psz_id );
+        const tt_node_t *p_regionnode = FindNodeByID( p_ctx,
+                                                      &p_ctx->regionnodes,
+                                                      "region", psz_id );
         if( !p_regionnode )
             return;
 
@@ -851,7 +876,16 @@ static void AppendTextToRegion( ttml_context_t *p_ctx, const tt_textnode_t *p_tt
     if( p_segment )
     {
         bool b_preserve_space = false;
-        ttml_style_t *s = InheritTTMLStyles( p_ctx, p_ttnode->p_parent );
+        /* sibling text nodes (split by <br/> or <set>) share the result */
+        if( p_ctx->p_inherit_node != p_ttnode->p_parent )
+        {
+            if( p_ctx->p_inherit_style )
+                ttml_style_Delete( p_ctx->p_inherit_style );
+            p_ctx->p_inherit_style = InheritTTMLStyles( p_ctx, p_ttnode->p_parent );
+            p_ctx->p_inherit_node = p_ttnode->p_parent;
+        }
+        ttml_style_t *s = p_ctx->p_inherit_style ?
+                          ttml_style_Duplicate( p_ctx->p_inherit_style ) : NULL;
         if( s )
         {
             if( p_set_styles )
@@ -1076,6 +1110,18 @@ static void InitTTMLContext( tt_node_t *p_rootnode, ttml_context_t *p_ctx )
             p_ctx->i_cell_resolution_v = h;
         }
     }
+    vlc_dictionary_init( &p_ctx->styles, 0 );
+    vlc_dictionary_init( &p_ctx->regionnodes, 0 );
+    p_ctx->p_inherit_node = NULL;
+    p_ctx->p_inherit_style = NULL;
+}
+
+static void CleanTTMLContext( ttml_context_t *p_ctx )
+{
+    if( p_ctx->p_inherit_style )
+        ttml_style_Delete( p_ctx->p_inherit_style );
+    vlc_dictionary_clear( &p_ctx->regionnodes, NULL, NULL );
+    vlc_dictionary_clear( &p_ctx->styles, NULL, NULL );
 }
 
 static ttml_region_t *GenerateRegions( tt_node_t *p_rootnode, tt_time_t playbacktime )
@@ -1106,6 +1152,7 @@ static ttml_region_t *GenerateRegions( tt_node_t *p_rootnode, tt_time_t playback
             }
 
             vlc_dictionary_clear( &context.regions, NULL, NULL );
+            CleanTTMLContext( &context );
         }
     }
     else if ( !tt_node_NameCompare( p_rootnode->psz_node_name, "div" ) ||
@@ -128,6 +128,8 @@ struct webvtt_dom_cue_t
     unsigned i_lines;
     text_style_t *p_cssstyle;
     webvtt_dom_node_t *p_child;
+    bool b_timed; /* has timed tags */
+    text_segment_t *p_segments; /* cached conversion */
 };
 
 typedef struct
@@ -157,6 +159,8 @@ typedef struct
 #ifdef HAVE_CSS
     /* CSS */
     vlc_css_rule_t *p_css_rules;
+    bool b_css_static; /* matches don't depend on time or siblings */
+    bool b_css_dirty; /* cues were added or styles cleared */
 #endif
 } decoder_sys_t;
 
@@ -858,6 +862,22 @@ static void webvtt_domnode_SelectNodesInTree( const webvtt_dom_node_t *p_node,
                                            i_playbacktime, p_results );
 }
 
+/* Whether the nodes matched by the selector only depend on themselves and
+ * their ancestors, so that the styles of a cue never change once applied */
+static bool IsStaticSelector( const vlc_css_selector_t *p_sel )
+{
+    for( ; p_sel; p_sel = p_sel->p_next )
+    {
+        if( p_sel->type == SELECTOR_PSEUDOCLASS || /* :past and :future */
+            p_sel->combinator == RELATION_DIRECTADJACENT ||
+            p_sel->combinator == RELATION_INDIRECTADJACENT )
+            return false;
+        if( !IsStaticSelector( p_sel->specifiers.p_first ) )
+            return false;
+    }
+    return true;
+}
+
 static void webvtt_domnode_SelectRuleNodes( const webvtt_dom_node_t *p_root, const vlc_css_rule_t *p_rule,
                                             vlc_tick_t i_playbacktime, vlc_array_t *p_results )
 {
@@ -940,13 +960,22 @@ static webvtt_dom_cue_t * webvtt_dom_cue_New( vlc_tick_t i_start, vlc_tick_t i_e
         p_cue->p_child = NULL;
         p_cue->i_lines = 0;
         p_cue->p_cssstyle = NULL;
+        p_cue->b_timed = false;
+        p_cue->p_segments = NULL;
         webvtt_cue_settings_Init( &p_cue->settings );
     }
     return p_cue;
 }
 
+static void webvtt_dom_cue_ClearSegments( webvtt_dom_cue_t *p_cue )
+{
+    text_segment_ChainDelete( p_cue->p_segments );
+    p_cue->p_segments = NULL;
+}
+
 static void webvtt_dom_cue_ClearText( webvtt_dom_cue_t *p_cue )
 {
+    webvtt_dom_cue_ClearSegments( p_cue );
     webvtt_domnode_ChainDelete( p_cue->p_child );
     p_cue->p_child = NULL;
     p_cue->i_lines = 0;
@@ -967,6 +996,7 @@ static unsigned webvtt_dom_cue_Reduced( webvtt_dom_cue_t *p_cue )
     if( p_cue->i_lines < 1 )
         return 0;
 
+    webvtt_dom_cue_ClearSegments( p_cue );
     for( webvtt_dom_node_t *p_node = p_cue->p_child;
                            p_node; p_node = p_node->p_next )
     {
@@ -1293,6 +1323,19 @@ static webvtt_dom_node_t * CreateDomNodes( const char *psz_text, unsigned *pi_li
     return p_head;
 }
 
+static bool HasTimedTags( const webvtt_dom_node_t *p_node )
+{
+    for( ; p_node; p_node = p_node->p_next )
+    {
+        if( p_node->type != NODE_TAG )
+            continue;
+        const webvtt_dom_tag_t *p_tag = (const webvtt_dom_tag_t *) p_node;
+        if( p_tag->i_start > -1 || HasTimedTags( p_tag->p_child ) )
+            return true;
+    }
+    return false;
+}
+
 static void ProcessCue( decoder_t *p_dec, const char *psz, webvtt_dom_cue_t *p_cue )
 {
     VLC_UNUSED(p_dec);
@@ -1302,6 +1345,7 @@ static void ProcessCue( decoder_t *p_dec, const char *psz, webvtt_dom_cue_t *p_c
     p_cue->p_child = CreateDomNodes( psz, &p_cue->i_lines );
     for( webvtt_dom_node_t *p_child = p_cue->p_child; p_child; p_child = p_child->p_next )
         p_child->p_parent = (webvtt_dom_node_t *)p_cue;
+    p_cue->b_timed = HasTimedTags( p_cue->p_child );
 #ifdef SUBSVTT_DEBUG
     webvtt_domnode_Debug( (webvtt_dom_node_t *) p_cue, 0 );
 #endif
@@ -1561,7 +1605,20 @@ static text_segment_t *ConvertCueToSegments( decoder_t *p_dec,
                                              struct render_variables_s *p_vars,
                                              const webvtt_dom_cue_t *p_cue )
 {
-    return ConvertNodesToSegments( p_dec, p_vars, p_cue, p_cue->p_child );
+    /* A cue stays on screen over several renders (scrolling regions, other
+     * overlapping cues): its segments only change with timed styling */
+    bool b_cacheable = !p_cue->b_timed;
+#ifdef HAVE_CSS
+    decoder_sys_t *p_sys = p_dec->p_sys;
+    b_cacheable = b_cacheable && p_sys->b_css_static;
+#endif
+    if( !b_cacheable )
+        return ConvertNodesToSegments( p_dec, p_vars, p_cue, p_cue->p_child );
+
+    if( p_cue->p_segments == NULL )
+        ((webvtt_dom_cue_t *) p_cue)->p_segments =
+            ConvertNodesToSegments( p_dec, p_vars, p_cue, p_cue->p_child );
+    return text_segment_Copy( p_cue->p_segments );
 }
 
 static void ChainCueSegments( const webvtt_dom_cue_t *p_cue, text_segment_t *p_new,
@@ -1728,7 +1785,10 @@ static void RenderRegions( decoder_t *p_dec, vlc_tick_t i_start, vlc_tick_t i_st
     decoder_sys_t *p_sys = p_dec->p_sys;
 
 #ifdef HAVE_CSS
-    ApplyCSSRules( p_dec, p_sys->p_css_rules, i_start );
+    /* static rules give the same results until the tree changes */
+    if( p_sys->b_css_dirty || !p_sys->b_css_static )
+        ApplyCSSRules( p_dec, p_sys->p_css_rules, i_start );
+    p_sys->b_css_dirty = false;
 #endif
 
     const webvtt_dom_cue_t *p_rlcue = NULL;
@@ -1846,6 +1906,16 @@ static void RenderRegions( decoder_t *p_dec, vlc_tick_t i_start, vlc_tick_t i_st
     }
 }
 
+static void ClearStyles( decoder_t *p_dec )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    ClearCSSStyles( (webvtt_dom_node_t *)p_sys->p_root );
+#ifdef HAVE_CSS
+    p_sys->b_css_dirty = true;
+#endif
+}
+
 static int timedtagsArrayCmp( const void *a, const void *b )
 {
     const webvtt_dom_tag_t *ta = *((const webvtt_dom_tag_t **) a);
@@ -1873,7 +1943,7 @@ static void Render( decoder_t *p_dec, vlc_tick_t i_start, vlc_tick_t i_stop )
          if( p_tag->i_start != i_substart ) /* might be duplicates */
          {
              if( i > 0 )
-                 ClearCSSStyles( (webvtt_dom_node_t *)p_sys->p_root );
+                 ClearStyles( p_dec );
              RenderRegions( p_dec, i_substart, p_tag->i_start );
              i_substart = p_tag->i_start;
          }
@@ -1881,7 +1951,7 @@ static void Render( decoder_t *p_dec, vlc_tick_t i_start, vlc_tick_t i_stop )
     if( i_substart != i_stop )
     {
         if( i_substart != i_start )
-            ClearCSSStyles( (webvtt_dom_node_t *)p_sys->p_root );
+            ClearStyles( p_dec );
         RenderRegions( p_dec, i_substart, i_stop );
     }
 
@@ -1942,6 +2012,9 @@ static int ProcessISOBMFF( decoder_t *p_dec,
                 webvtt_domnode_AppendLast( &p_sys->p_root->p_child, p_cue );
                 p_cue->p_parent = (webvtt_dom_node_t *) p_sys->p_root;
             }
+#ifdef HAVE_CSS
+            p_sys->b_css_dirty = true;
+#endif
         }
     }
     return 0;
@@ -2142,5 +2215,13 @@ int webvtt_OpenDecoder( vlc_object_t *p_this )
     if( p_dec->fmt_in.i_extra )
         LoadExtradata( p_dec );
 
+#ifdef HAVE_CSS
+    p_sys->b_css_static = true;
+    for( const vlc_css_rule_t *p_rule = p_sys->p_css_rules; p_rule;
+         p_rule = p_rule->p_next )
+        p_sys->b_css_static &= IsStaticSelector( p_rule->p_selectors );
+    p_sys->b_css_dirty = true;
+#endif
+
     return VLC_SUCCESS;
 }
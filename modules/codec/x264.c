@@ -408,6 +408,10 @@ static void x264_log( void *, int i_level, const char *psz, va_list );
     "Currently default can cause sync-issues on unmuxable output, like rtsp-output without ts-mux" )
 
 #define HRD_TEXT N_("HRD-timing information")
+#define LOW_LATENCY_TEXT N_("Low latency")
+#define LOW_LATENCY_LONGTEXT N_("Encode each picture as soon as it arrives, " \
+    "spread over sliced threads, with periodic intra refresh and a " \
+    "one-frame constant bitrate buffer, for live contribution links.")
 #define TUNE_TEXT N_("Default tune setting used" )
 #define PRESET_TEXT N_("Default preset setting used" )
 
@@ -531,6 +535,9 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "slice-max-size", 0, SLICE_MAX_SIZE, SLICE_MAX_SIZE_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "slice-max-mbs", 0, SLICE_MAX_MBS, SLICE_MAX_MBS_LONGTEXT, true )
 
+    add_bool( SOUT_CFG_PREFIX "low-latency", false, LOW_LATENCY_TEXT,
+              LOW_LATENCY_LONGTEXT, true )
+
     add_string( SOUT_CFG_PREFIX "hrd", "none", HRD_TEXT, HRD_TEXT, true )
         vlc_config_set (VLC_CONFIG_LIST,
             (sizeof(x264_nal_hrd_names) / sizeof (char*)) - 1,
@@ -750,7 +757,7 @@ static const char *const ppsz_sout_options[] = {
     "aq-mode", "aq-strength", "psy-rd", "psy", "profile", "lookahead", "slices",
     "slice-max-size", "slice-max-mbs", "intra-refresh", "mbtree", "hrd",
     "tune","preset", "opengop", "bluray-compat", "frame-packing", "options",
-    "fullrange",
+    "fullrange", "low-latency",
     NULL
 };
 
@@ -1373,6 +1380,36 @@ static int  Open ( vlc_object_t *p_this )
        p_sys->param.rc.i_lookahead = var_GetInteger( p_enc, SOUT_CFG_PREFIX "lookahead" );
     }
 
+    if( var_GetBool( p_enc, SOUT_CFG_PREFIX "low-latency" ) )
+    {
+        /* No frame is held back: every picture is cut into one slice per
+         * thread and comes out of the same Encode() call */
+        p_sys->param.b_sliced_threads = 1;
+        p_sys->param.i_sync_lookahead = 0;
+        p_sys->param.rc.i_lookahead = 0;
+        p_sys->param.rc.b_mb_tree = 0;
+        p_sys->param.i_bframe = 0;
+        /* Spread the intra macroblocks over the pictures, no IDR spikes */
+        p_sys->param.b_intra_refresh = 1;
+
+        if( p_sys->param.rc.i_rc_method == X264_RC_ABR )
+        {
+            /* Constant bitrate, each picture fitting in one frame period */
+            unsigned fps = p_sys->param.i_fps_den > 0
+                ? p_sys->param.i_fps_num / p_sys->param.i_fps_den : 0;
+
+            if( p_sys->param.rc.i_vbv_max_bitrate <= 0 )
+                p_sys->param.rc.i_vbv_max_bitrate = p_sys->param.rc.i_bitrate;
+            if( p_sys->param.rc.i_vbv_buffer_size <= 0 )
+                p_sys->param.rc.i_vbv_buffer_size =
+                    p_sys->param.rc.i_vbv_max_bitrate / __MAX(fps, 1);
+            p_sys->param.i_nal_hrd = X264_NAL_HRD_CBR;
+        }
+        else
+            msg_Warn( p_enc, "low latency mode without bitrate: "
+                      "the picture sizes are not constrained" );
+    }
+
     /* We don't want repeated headers, we repeat p_extra ourself if needed */
     p_sys->param.b_repeat_headers = 0;
 
@@ -1490,6 +1527,8 @@ static block_t *Encode( encoder_t *p_enc, picture_t *p_pict )
     x264_picture_init( &pic );
     if( likely(p_pict) ) {
        pic.i_pts = p_pict->date;
+       if( p_pict->b_keyframe )
+           pic.i_type = X264_TYPE_KEYFRAME;
        pic.img.i_csp = p_sys->i_colorspace;
        pic.img.i_plane = p_pict->i_planes;
        for( i = 0; i < p_pict->i_planes; i++ )
@@ -42,14 +42,28 @@
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define SOUT_CFG_PREFIX "sout-x265-"
+
+#define LOW_LATENCY_TEXT N_("Low latency")
+#define LOW_LATENCY_LONGTEXT N_("Encode each picture as soon as it arrives, " \
+    "with wavefront instead of frame threads, periodic intra refresh and a " \
+    "one-frame constant bitrate buffer, for live contribution links.")
+
 vlc_module_begin ()
     set_description(N_("H.265/HEVC encoder (x265)"))
     set_capability("encoder", 200)
     set_callbacks(Open, Close)
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_VCODEC)
+
+    add_bool(SOUT_CFG_PREFIX "low-latency", false, LOW_LATENCY_TEXT,
+             LOW_LATENCY_LONGTEXT, true)
 vlc_module_end ()
 
+static const char *const ppsz_sout_options[] = {
+    "low-latency", NULL
+};
+
 typedef struct
 {
     x265_encoder    *h;
@@ -71,6 +85,8 @@ static block_t *Encode(encoder_t *p_enc, picture_t *p_pict)
 
     if (likely(p_pict)) {
         pic.pts = p_pict->date;
+        if (p_pict->b_keyframe)
+            pic.sliceType = X265_TYPE_IDR;
         if (unlikely(p_sys->initial_date == VLC_TICK_INVALID)) {
             p_sys->initial_date = p_pict->date;
 #ifndef NDEBUG
@@ -150,6 +166,8 @@ static int  Open (vlc_object_t *p_this)
 
     p_enc->fmt_in.i_codec = VLC_CODEC_I420;
 
+    config_ChainParse(p_enc, SOUT_CFG_PREFIX, ppsz_sout_options, p_enc->p_cfg);
+
     x265_param *param = &p_sys->param;
     x265_param_default(param);
 
@@ -192,6 +210,32 @@ static int  Open (vlc_object_t *p_this)
         param->rc.rateControlMode = X265_RC_ABR;
     }
 
+    if (var_GetBool(p_enc, SOUT_CFG_PREFIX "low-latency")) {
+        /* No frame is held back: a single frame thread, the rows of the
+         * picture encoded in parallel instead */
+        param->frameNumThreads = 1;
+        param->bEnableWavefront = 1;
+        param->lookaheadDepth = 0;
+        param->bframes = 0;
+        param->rc.cuTree = 0;
+#if X265_BUILD >= 68
+        /* Spread the intra blocks over the pictures, no IDR spikes */
+        param->bIntraRefresh = 1;
+#endif
+        if (param->rc.rateControlMode == X265_RC_ABR) {
+            /* Constant bitrate, each picture fitting in one frame period */
+            unsigned fps = p_enc->fmt_in.video.i_frame_rate_base ?
+                p_enc->fmt_in.video.i_frame_rate /
+                p_enc->fmt_in.video.i_frame_rate_base : 0;
+
+            param->rc.vbvMaxBitrate = param->rc.bitrate;
+            param->rc.vbvBufferSize = param->rc.bitrate / (fps ? fps : 25);
+            param->bEmitHRDSEI = 1;
+        } else
+            msg_Warn(p_enc, "low latency mode without bitrate: "
+                     "the picture sizes are not constrained");
+    }
+
     p_sys->h = x265_encoder_open(param);
     if (p_sys->h == NULL) {
         msg_Err(p_enc, "cannot open x265 encoder");
@@ -36,6 +36,7 @@
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/DynamicAdaptationLogic.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_stream.h>
 #include <vlc_demux.h>
@@ -80,6 +81,8 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     cached.playlistEnd = 0;
     cached.playlistLength = 0;
     cached.lastupdate = 0;
+    latency.lastupdate = VLC_TICK_INVALID;
+    latency.rate = 1.0f;
 }
 
 PlaylistManager::~PlaylistManager   ()
@@ -162,6 +165,11 @@ bool PlaylistManager::start()
     if(b_thread)
         return false;
 
+    /* Have all streams request their first chunks in parallel */
+    std::vector<AbstractStream *>::iterator it;
+    for(it=streams.begin(); it!=streams.end(); ++it)
+        (*it)->prefetch();
+
     b_thread = !vlc_clone(&thread, managerThread,
                           static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT);
     if(!b_thread)
@@ -440,6 +448,7 @@ int PlaylistManager::doDemux(vlc_tick_t increment)
     AbstractStream::status status = dequeue(demux.i_nzpcr, &i_nzbarrier);
 
     updateControlsPosition();
+    updateLatency();
 
     switch(status)
     {
@@ -476,6 +485,7 @@ int PlaylistManager::doDemux(vlc_tick_t increment)
         demux.i_firstpcr = VLC_TICK_INVALID;
         es_out_Control(p_demux->out, ES_OUT_RESET_PCR);
         vlc_mutex_unlock(&demux.lock);
+        latency.lastupdate = VLC_TICK_INVALID;
         break;
     case AbstractStream::status_demuxed:
         vlc_mutex_lock(&demux.lock);
@@ -529,6 +539,11 @@ int PlaylistManager::doControl(int i_query, va_list args)
             break;
         }
 
+        case DEMUX_GET_NETWORK:
+            resources->getConnManager()->getNetworkStats(
+                        va_arg (args, struct vlc_stream_network *));
+            break;
+
         case DEMUX_GET_LENGTH:
         {
             vlc_mutex_locker locker(&cached.lock);
@@ -590,12 +605,14 @@ int PlaylistManager::doControl(int i_query, va_list args)
             vlc_mutex_locker locker(&cached.lock);
             demux.i_nzpcr = VLC_TICK_INVALID;
             cached.lastupdate = 0;
+            latency.lastupdate = VLC_TICK_INVALID;
             setBufferingRunState(true);
             break;
         }
 
         case DEMUX_GET_PTS_DELAY:
-            *va_arg (args, vlc_tick_t *) = VLC_TICK_FROM_SEC(1);
+            *va_arg (args, vlc_tick_t *) = playlist->isLowLatency() ? VLC_TICK_FROM_MS(500)
+                                                                    : VLC_TICK_FROM_SEC(1);
             break;
 
         default:
@@ -615,8 +632,6 @@ void PlaylistManager::setBufferingRunState(bool b)
 void PlaylistManager::Run()
 {
     vlc_mutex_lock(&lock);
-    const vlc_tick_t i_min_buffering = playlist->getMinBuffering();
-    const vlc_tick_t i_extra_buffering = playlist->getMaxBuffering() - i_min_buffering;
     while(1)
     {
         while(!b_buffering && !b_canceled)
@@ -624,6 +639,10 @@ void PlaylistManager::Run()
         if (b_canceled)
             break;
 
+        /* Can change once media playlists are loaded (low latency) */
+        const vlc_tick_t i_min_buffering = playlist->getMinBuffering();
+        const vlc_tick_t i_extra_buffering = playlist->getMaxBuffering() - i_min_buffering;
+
         if(needsUpdate())
         {
             int canc = vlc_savecancel();
@@ -770,6 +789,106 @@ void PlaylistManager::updateControlsPosition()
                cached.i_time, currentDemuxTime, rapPlaylistStart, rapDemuxStart));
 }
 
+/*
+ * Keeps low latency live playback at the playlist target distance from the
+ * live edge. The demuxer can't change the playback rate, so the rate change
+ * is applied by drifting the input clock system origin instead: brief
+ * deviations are caught up by speeding up or slowing down within the allowed
+ * rates, and playback jumps back to the target when beyond maximum latency.
+ */
+void PlaylistManager::updateLatency()
+{
+    if(!playlist->isLowLatency() || !playlist->isLive())
+        return;
+
+    const vlc_tick_t now = vlc_tick_now();
+    if(latency.lastupdate != VLC_TICK_INVALID &&
+       now - latency.lastupdate < VLC_TICK_FROM_MS(250))
+        return;
+
+    vlc_tick_t target = playlist->targetLatency.Get();
+    if(target == 0)
+        target = playlist->suggestedPresentationDelay.Get();
+
+    struct timespec ts;
+    vlc_tick_t system, delay;
+    if(target == 0 || timespec_get(&ts, TIME_UTC) == 0 ||
+       es_out_ControlGetPcrSystem(p_demux->out, &system, &delay) != VLC_SUCCESS)
+    {
+        latency.lastupdate = VLC_TICK_INVALID;
+        return;
+    }
+
+    vlc_tick_t edge, rapPlaylistStart, rapDemuxStart;
+    bool b_found = false;
+    std::vector<AbstractStream *>::const_iterator it;
+    for(it=streams.begin(); it!=streams.end() && !b_found; ++it)
+    {
+        AbstractStream *st = *it;
+        if(st->isValid() && !st->isDisabled() && st->isSelected())
+            b_found = st->getMediaLiveEdgeTimes(vlc_tick_from_timespec(&ts), &edge,
+                                                &rapPlaylistStart, &rapDemuxStart);
+    }
+
+    const vlc_tick_t currentDemuxTime = getCurrentDemuxTime();
+    if(!b_found || currentDemuxTime == VLC_TICK_INVALID)
+    {
+        latency.lastupdate = VLC_TICK_INVALID;
+        return;
+    }
+
+    /* output lags the demuxer by the pts delay */
+    const vlc_tick_t playbackTime = rapPlaylistStart + currentDemuxTime - rapDemuxStart - delay;
+    const vlc_tick_t current = edge - playbackTime;
+
+    if(playlist->maxLatency.Get() && current > playlist->maxLatency.Get())
+    {
+        msg_Dbg(p_demux, "latency %" PRId64 "ms over maximum, seeking to live edge",
+                MS_FROM_VLC_TICK(current));
+        setBufferingRunState(false);
+        if(setPosition(edge - target))
+        {
+            vlc_mutex_locker locker(&cached.lock);
+            demux.i_nzpcr = VLC_TICK_INVALID;
+            cached.lastupdate = 0;
+        }
+        setBufferingRunState(true);
+        latency.lastupdate = VLC_TICK_INVALID;
+        return;
+    }
+
+    float minrate = playlist->minPlaybackRate.Get();
+    float maxrate = playlist->maxPlaybackRate.Get();
+    if(minrate == 1.0f && maxrate == 1.0f)
+    {
+        minrate = 0.97f;
+        maxrate = 1.03f;
+    }
+
+    /* proportional correction, with a small dead zone */
+    float rate = 1.0f;
+    const vlc_tick_t diff = current - target;
+    if(diff > VLC_TICK_FROM_MS(100) || diff < -VLC_TICK_FROM_MS(100))
+        rate = 1.0f + 0.5f * secf_from_vlc_tick(diff);
+    if(playlist->minLatency.Get() && current < playlist->minLatency.Get())
+        rate = minrate;
+    rate = std::max(minrate, std::min(maxrate, rate));
+
+    if(rate != latency.rate)
+    {
+        msg_Dbg(p_demux, "latency %" PRId64 "ms target %" PRId64 "ms, rate %.3f",
+                MS_FROM_VLC_TICK(current), MS_FROM_VLC_TICK(target), rate);
+        latency.rate = rate;
+    }
+
+    if(latency.lastupdate != VLC_TICK_INVALID && rate != 1.0f)
+    {
+        const vlc_tick_t shift = (now - latency.lastupdate) * (rate - 1.0f);
+        es_out_ControlModifyPcrSystem(p_demux->out, true, system - shift);
+    }
+    latency.lastupdate = now;
+}
+
 AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::LogicType type, AbstractConnectionManager *conn)
 {
     vlc_object_t *obj = VLC_OBJECT(p_demux);
@@ -807,6 +926,15 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             logic = noplogic;
             break;
         }
+        case AbstractAdaptationLogic::Dynamic:
+        {
+            DynamicAdaptationLogic *dynlogic =
+                    new (std::nothrow) DynamicAdaptationLogic(obj);
+            if(dynlogic)
+                conn->setDownloadRateObserver(dynlogic);
+            logic = dynlogic;
+            break;
+        }
         case AbstractAdaptationLogic::Predictive:
         {
             AbstractAdaptationLogic *predictivelogic =
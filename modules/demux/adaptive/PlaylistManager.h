@@ -86,6 +86,7 @@ namespace adaptive
             void unsetPeriod();
 
             void updateControlsPosition();
+            void updateLatency();
 
             /* local factories */
             virtual AbstractAdaptationLogic *createLogic(AbstractAdaptationLogic::LogicType,
@@ -126,6 +127,13 @@ namespace adaptive
                 time_t      lastupdate;
             } cached;
 
+            /* Low latency playback rate control */
+            struct
+            {
+                vlc_tick_t  lastupdate;
+                float       rate;
+            } latency;
+
         private:
             void setBufferingRunState(bool);
             void Run();
@@ -76,6 +76,15 @@ SegmentTrackerEvent::SegmentTrackerEvent(const ID &id, vlc_tick_t duration)
     u.segment.id = &id;
 }
 
+SegmentTracker::PendingChunk::PendingChunk()
+{
+    chunk = NULL;
+    number = 0;
+    duration = 0;
+    gap = false;
+    media = false;
+}
+
 SegmentTracker::SegmentTracker(SharedResources *res,
         AbstractAdaptationLogic *logic_, BaseAdaptationSet *adaptSet)
 {
@@ -154,6 +163,7 @@ bool SegmentTracker::segmentsListReady() const
 
 void SegmentTracker::reset()
 {
+    flushPending();
     notify(SegmentTrackerEvent(curRepresentation, NULL));
     curRepresentation = NULL;
     init_sent = false;
@@ -166,11 +176,19 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
                                             AbstractConnectionManager *connManager)
 {
     BaseRepresentation *rep = NULL, *prevRep = NULL;
-    ISegment *segment;
+    ISegment *segment = NULL;
 
     if(!adaptationSet)
         return NULL;
 
+    /* Chunks requested ahead while initializing */
+    if(!pending.empty())
+    {
+        PendingChunk pc = pending.front();
+        pending.pop_front();
+        return deliver(pc);
+    }
+
     /* Ensure we don't keep chaining init/index without data */
     if( initializing )
     {
@@ -239,27 +257,65 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         return NULL; /* Can't return chunk because no demux will be created */
     }
 
-    if(!init_sent)
+    if(!init_sent || !index_sent)
     {
-        init_sent = true;
-        segment = rep->getSegment(BaseRepresentation::INFOTYPE_INIT);
-        if(segment)
-            return segment->toChunk(resources, connManager, next, rep);
-    }
+        SegmentChunk *chunk = NULL;
+        if(!init_sent)
+        {
+            init_sent = true;
+            segment = rep->getSegment(BaseRepresentation::INFOTYPE_INIT);
+            if(segment)
+                chunk = segment->toChunk(resources, connManager, next, rep);
+        }
+
+        if(!segment && !index_sent)
+        {
+            index_sent = true;
+            segment = rep->getSegment(BaseRepresentation::INFOTYPE_INDEX);
+            if(segment)
+                chunk = segment->toChunk(resources, connManager, next, rep);
+        }
 
-    if(!index_sent)
-    {
-        index_sent = true;
-        segment = rep->getSegment(BaseRepresentation::INFOTYPE_INDEX);
         if(segment)
-            return segment->toChunk(resources, connManager, next, rep);
+        {
+            /* Don't wait for each chunk to complete before requesting the
+             * next one: the index and first media segment are requested
+             * now, and their responses are buffered meanwhile. */
+            if(chunk && initializing)
+            {
+                if(!index_sent)
+                {
+                    index_sent = true;
+                    segment = rep->getSegment(BaseRepresentation::INFOTYPE_INDEX);
+                    PendingChunk pc;
+                    if(segment &&
+                       (pc.chunk = segment->toChunk(resources, connManager, next, rep)))
+                        pending.push_back(pc);
+                }
+                PendingChunk pc;
+                if(createMediaChunk(rep, connManager, &pc) && pc.chunk)
+                    pending.push_back(pc);
+            }
+            return chunk;
+        }
     }
 
+    PendingChunk pc;
+    if(!createMediaChunk(rep, connManager, &pc))
+        return NULL;
+
+    return deliver(pc);
+}
+
+bool SegmentTracker::createMediaChunk(BaseRepresentation *rep,
+                                      AbstractConnectionManager *connManager,
+                                      PendingChunk *pc)
+{
     bool b_gap = false;
-    segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA, next, &next, &b_gap);
+    ISegment *segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA, next, &next, &b_gap);
     if(!segment)
     {
-        return NULL;
+        return false;
     }
 
     if(initializing)
@@ -269,15 +325,27 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         initializing = false;
     }
 
-    SegmentChunk *chunk = segment->toChunk(resources, connManager, next, rep);
+    pc->chunk = segment->toChunk(resources, connManager, next, rep);
+    pc->number = next;
+    pc->gap = b_gap;
+    pc->media = true;
+    pc->duration = rep->inheritTimescale().ToTime(segment->duration.Get());
+
+    if(pc->chunk)
+        next++;
+
+    return true;
+}
+
+SegmentChunk * SegmentTracker::deliver(const PendingChunk &pc)
+{
+    SegmentChunk *chunk = pc.chunk;
+    if(!pc.media)
+        return chunk;
 
     /* Notify new segment length for stats / logic */
     if(chunk)
-    {
-        const Timescale timescale = rep->inheritTimescale();
-        notify(SegmentTrackerEvent(rep->getAdaptationSet()->getID(),
-                                   timescale.ToTime(segment->duration.Get())));
-    }
+        notify(SegmentTrackerEvent(adaptationSet->getID(), pc.duration));
 
     /* We need to check segment/chunk format changes, as we can't rely on representation's (HLS)*/
     if(chunk && format != chunk->getStreamFormat())
@@ -287,20 +355,26 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     }
 
     /* Handle both implicit and explicit discontinuities */
-    if( (b_gap && next) || (chunk && chunk->discontinuity) )
+    if( (pc.gap && pc.number) || (chunk && chunk->discontinuity) )
     {
         notify(SegmentTrackerEvent(chunk));
     }
 
     if(chunk)
-    {
-        curNumber = next;
-        next++;
-    }
+        curNumber = pc.number;
 
     return chunk;
 }
 
+void SegmentTracker::flushPending()
+{
+    while(!pending.empty())
+    {
+        delete pending.front().chunk;
+        pending.pop_front();
+    }
+}
+
 bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool tryonly)
 {
     uint64_t segnumber;
@@ -329,6 +403,7 @@ bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool try
 
 void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
 {
+    flushPending();
     if(restarted)
     {
         initializing = true;
@@ -362,6 +437,13 @@ bool SegmentTracker::getMediaPlaybackRange(vlc_tick_t *start, vlc_tick_t *end,
     return curRepresentation->getMediaPlaybackRange(start, end, length);
 }
 
+bool SegmentTracker::getLiveEdgeTime(vlc_tick_t now, vlc_tick_t *edge) const
+{
+    if(!curRepresentation)
+        return false;
+    return curRepresentation->getLiveEdgeTime(now, edge);
+}
+
 vlc_tick_t SegmentTracker::getMinAheadTime() const
 {
     BaseRepresentation *rep = curRepresentation;
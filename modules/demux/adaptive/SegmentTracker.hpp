@@ -45,6 +45,7 @@ namespace adaptive
     {
         class BaseAdaptationSet;
         class BaseRepresentation;
+        class ISegment;
         class SegmentChunk;
     }
 
@@ -131,6 +132,7 @@ namespace adaptive
             void setPositionByNumber(uint64_t, bool);
             vlc_tick_t getPlaybackTime() const; /* Current segment start time if selected */
             bool getMediaPlaybackRange(vlc_tick_t *, vlc_tick_t *, vlc_tick_t *) const;
+            bool getLiveEdgeTime(vlc_tick_t, vlc_tick_t *) const;
             vlc_tick_t getMinAheadTime() const;
             void notifyBufferingState(bool) const;
             void notifyBufferingLevel(vlc_tick_t, vlc_tick_t, vlc_tick_t) const;
@@ -138,8 +140,23 @@ namespace adaptive
             void updateSelected();
 
         private:
+            class PendingChunk
+            {
+                public:
+                    PendingChunk();
+                    SegmentChunk *chunk;
+                    uint64_t number;
+                    vlc_tick_t duration;
+                    bool gap;
+                    bool media;
+            };
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            bool createMediaChunk(BaseRepresentation *, AbstractConnectionManager *,
+                                  PendingChunk *);
+            SegmentChunk * deliver(const PendingChunk &);
+            void flushPending();
+            std::list<PendingChunk> pending;
             bool first;
             bool initializing;
             bool index_sent;
@@ -24,6 +24,7 @@
 #include "SharedResources.hpp"
 #include "http/AuthStorage.hpp"
 #include "http/HTTPConnectionManager.h"
+#include "http/SegmentCache.hpp"
 #include "encryption/Keyring.hpp"
 
 #include <vlc_common.h>
@@ -38,11 +39,24 @@ SharedResources::SharedResources(vlc_object_t *obj, bool local)
     if(m && local)
         m->setLocalConnectionsAllowed();
     connManager = m;
+
+    segmentCache = NULL;
+    int64_t cachesize = var_InheritInteger(obj, "adaptive-cache-size");
+    if(cachesize > 0)
+    {
+        char *psz_dir = var_InheritString(obj, "adaptive-cache-dir");
+        int64_t disksize = var_InheritInteger(obj, "adaptive-cache-disk-size");
+        segmentCache = new (std::nothrow) SegmentCache(obj, cachesize << 20,
+                                                       psz_dir ? psz_dir : "",
+                                                       disksize > 0 ? disksize << 20 : 0);
+        free(psz_dir);
+    }
 }
 
 SharedResources::~SharedResources()
 {
     delete connManager;
+    delete segmentCache;
     delete encryptionKeyring;
     delete authStorage;
 }
@@ -57,6 +71,11 @@ Keyring * SharedResources::getKeyring()
     return encryptionKeyring;
 }
 
+SegmentCache * SharedResources::getSegmentCache()
+{
+    return segmentCache;
+}
+
 AbstractConnectionManager * SharedResources::getConnManager()
 {
     return connManager;
@@ -28,6 +28,7 @@ namespace adaptive
     {
         class AuthStorage;
         class AbstractConnectionManager;
+        class SegmentCache;
     }
 
     namespace encryption
@@ -46,11 +47,13 @@ namespace adaptive
             AuthStorage *getAuthStorage();
             Keyring     *getKeyring();
             AbstractConnectionManager *getConnManager();
+            SegmentCache *getSegmentCache();
 
         private:
             AuthStorage *authStorage;
             Keyring *encryptionKeyring;
             AbstractConnectionManager *connManager;
+            SegmentCache *segmentCache;
     };
 }
 
@@ -578,12 +578,28 @@ bool AbstractStream::getMediaPlaybackTimes(vlc_tick_t *start, vlc_tick_t *end,
             fakeEsOut()->getStartTimestamps(mediaStart, demuxStart));
 }
 
+bool AbstractStream::getMediaLiveEdgeTimes(vlc_tick_t now, vlc_tick_t *edge,
+                                           vlc_tick_t *mediaStart,
+                                           vlc_tick_t *demuxStart) const
+{
+    return (segmentTracker->getLiveEdgeTime(now, edge) &&
+            fakeEsOut()->getStartTimestamps(mediaStart, demuxStart));
+}
+
 void AbstractStream::runUpdates()
 {
     if(valid && !disabled)
         segmentTracker->updateSelected();
 }
 
+void AbstractStream::prefetch()
+{
+    vlc_mutex_locker locker(&lock);
+    /* Issues the startup requests without waiting for the demuxer */
+    if(valid && !disabled && !eof && currentChunk == NULL)
+        currentChunk = segmentTracker->getNextChunk(true, connManager);
+}
+
 void AbstractStream::fillExtraFMTInfo( es_format_t *p_fmt ) const
 {
     if(!p_fmt->psz_language && !language.empty())
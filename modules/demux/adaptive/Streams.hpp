@@ -90,7 +90,10 @@ namespace adaptive
         virtual bool setPosition(vlc_tick_t, bool);
         bool getMediaPlaybackTimes(vlc_tick_t *, vlc_tick_t *, vlc_tick_t *,
                                    vlc_tick_t *, vlc_tick_t *) const;
+        bool getMediaLiveEdgeTimes(vlc_tick_t, vlc_tick_t *,
+                                   vlc_tick_t *, vlc_tick_t *) const;
         void runUpdates();
+        void prefetch();
 
         /* Used by demuxers fake streams */
         virtual std::string getContentType(); /* impl */
@@ -73,13 +73,39 @@ static void Close   (vlc_object_t *);
 
 #define ADAPT_LOGIC_TEXT N_("Adaptive Logic")
 
+#define ADAPT_DOWNLOADS_TEXT N_("Maximum parallel downloads")
+#define ADAPT_DOWNLOADS_LONGTEXT N_("Number of segments which can be downloaded " \
+                                    "at the same time, across all streams")
+
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_HTTP2_TEXT N_("Share HTTPS connections")
+#define ADAPT_HTTP2_LONGTEXT N_("Send HTTPS requests to a same server over a " \
+                                "single connection, multiplexed with HTTP/2 " \
+                                "when the server supports it")
+
+#define ADAPT_LOWLATENCY_TEXT N_("Low latency")
+#define ADAPT_LOWLATENCY_LONGTEXT N_("Play live streams close to the live edge, " \
+                                     "using partial segments and blocking playlist " \
+                                     "reloads when the server supports them")
+
+#define ADAPT_CACHE_TEXT N_("Segments cache size (MiB)")
+#define ADAPT_CACHE_LONGTEXT N_("Memory used to keep downloaded segments, so " \
+                                "that seeking back or switching quality again " \
+                                "does not download them another time")
+
+#define ADAPT_CACHEDIR_TEXT N_("Segments disk cache directory")
+#define ADAPT_CACHEDIR_LONGTEXT N_("Directory where segments evicted from memory " \
+                                   "are kept. Disabled when empty")
+
+#define ADAPT_CACHEDISK_TEXT N_("Segments disk cache size (MiB)")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
                                 AbstractAdaptationLogic::NearOptimal,
+                                AbstractAdaptationLogic::Dynamic,
                                 AbstractAdaptationLogic::RateBased,
                                 AbstractAdaptationLogic::FixedRate,
                                 AbstractAdaptationLogic::AlwaysLowest,
@@ -89,6 +115,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "dynamic",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -97,6 +124,7 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Dynamic (throughput and buffer based)"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
@@ -122,6 +150,13 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_bool   ( "adaptive-use-http2", true, ADAPT_HTTP2_TEXT, ADAPT_HTTP2_LONGTEXT, true )
+        add_bool   ( "adaptive-lowlatency", true, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT, true )
+        add_integer_with_range( "adaptive-maxdownloads", 2, 1, 8,
+                     ADAPT_DOWNLOADS_TEXT, ADAPT_DOWNLOADS_LONGTEXT, true )
+        add_integer( "adaptive-cache-size", 16, ADAPT_CACHE_TEXT, ADAPT_CACHE_LONGTEXT, true )
+        add_directory( "adaptive-cache-dir", NULL, ADAPT_CACHEDIR_TEXT, ADAPT_CACHEDIR_LONGTEXT )
+        add_integer( "adaptive-cache-disk-size", 256, ADAPT_CACHEDISK_TEXT, ADAPT_CACHEDISK_TEXT, true )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -29,6 +29,7 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -266,13 +267,10 @@ bool HTTPChunkSource::prepare()
         {
             if(requeststatus == RequestStatus::Redirection)
             {
-                HTTPConnection *httpconn = dynamic_cast<HTTPConnection *>(connection);
-                if(httpconn)
-                    connparams = httpconn->getRedirection();
+                connparams = connection->getRedirection();
                 connection->setUsed(false);
                 connection = NULL;
-                if(httpconn)
-                    continue;
+                continue;
             }
             break;
         }
@@ -303,7 +301,14 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     done = false;
     eof = false;
     held = false;
+    boxaligned = false;
+    boxremain = 0;
     downloadstart = 0;
+    requestlatency = 0;
+    cache = NULL;
+    cachepinned = false;
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -322,6 +327,8 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         p_head = NULL;
         pp_tail = &p_head;
     }
+    if(p_cachehead)
+        block_ChainRelease(p_cachehead);
     buffered = 0;
     vlc_mutex_unlock(&lock);
 
@@ -347,6 +354,85 @@ void HTTPChunkBufferedSource::release()
     vlc_cond_signal(&avail);
 }
 
+void HTTPChunkBufferedSource::setBoxAligned(bool b)
+{
+    boxaligned = b;
+}
+
+void HTTPChunkBufferedSource::setCache(SegmentCache *c, const std::string &url, bool pinned)
+{
+    cache = c;
+    cacheurl = url;
+    cachepinned = pinned;
+}
+
+/* Returns the whole download for the cache, if it did complete */
+block_t * HTTPChunkBufferedSource::finishCaching(bool b_ok, std::string *type)
+{
+    block_t *p_data = NULL;
+    if(!p_cachehead)
+        return NULL;
+
+    if(b_ok && requeststatus == RequestStatus::Success &&
+       (!contentLength || consumed + buffered == contentLength))
+    {
+        *type = connection->getContentType();
+        p_data = block_ChainGather(p_cachehead);
+    }
+    else block_ChainRelease(p_cachehead);
+
+    p_cachehead = NULL;
+    pp_cachetail = &p_cachehead;
+    return p_data;
+}
+
+/* Stops reading at the end of the current box, so that each moof/mdat pair of
+ * a chunked segment is handed out as soon as it is received */
+ssize_t HTTPChunkBufferedSource::readBoxAligned(uint8_t *p, size_t readsize, size_t *pi_wanted)
+{
+    size_t header = 0;
+    ssize_t ret;
+
+    if(boxremain == 0)
+    {
+        *pi_wanted = 8;
+        ret = connection->read(p, 8);
+        if(ret < 8)
+            return ret;
+        uint64_t boxsize = GetDWBE(p);
+        header = 8;
+        if(boxsize == 1)
+        {
+            *pi_wanted = 16;
+            ret = connection->read(&p[8], 8);
+            if(ret < 8)
+                return (ret < 0) ? 8 : 8 + ret;
+            boxsize = GetQWBE(&p[8]);
+            header = 16;
+        }
+
+        if(boxsize < header) /* box up to the end, or not a box */
+        {
+            boxaligned = false;
+            *pi_wanted = readsize;
+            ret = connection->read(&p[header], readsize - header);
+            return (ret < 0) ? header : header + ret;
+        }
+        boxremain = boxsize - header;
+    }
+
+    const size_t toread = std::min((uint64_t)(readsize - header), boxremain);
+    *pi_wanted = header + toread;
+    if(toread == 0)
+        return header;
+
+    ret = connection->read(&p[header], toread);
+    if(ret < 0)
+        return header ? (ssize_t) header : ret;
+    boxremain -= ret;
+    return header + ret;
+}
+
 void HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
     vlc_mutex_lock(&lock);
@@ -354,8 +440,13 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     {
         done = true;
         eof = true;
+        /* server or connection failure, unlike missing segments */
+        const bool b_hostfailure = (requeststatus != RequestStatus::NotFound &&
+                                    requeststatus != RequestStatus::Unauthorized);
         vlc_cond_signal(&avail);
         vlc_mutex_unlock(&lock);
+        if(b_hostfailure && connManager)
+            connManager->updateHostStats(params.getHostname(), 0, 0, true);
         return;
     }
 
@@ -378,9 +469,18 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     {
         size_t size;
         vlc_tick_t time;
-    } rate = {0,0};
+        vlc_tick_t latency;
+    } rate = {0,0,0};
 
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    block_t *p_cachedata = NULL;
+    std::string cachetype;
+
+    size_t wanted = readsize;
+    ssize_t ret;
+    if(boxaligned && readsize >= 16)
+        ret = readBoxAligned(p_block->p_buffer, readsize, &wanted);
+    else
+        ret = connection->read(p_block->p_buffer, readsize);
     if(ret <= 0)
     {
         block_Release(p_block);
@@ -389,26 +489,48 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         done = true;
         rate.size = buffered + consumed;
         rate.time = vlc_tick_now() - downloadstart;
+        rate.latency = requestlatency;
         downloadstart = 0;
+        p_cachedata = finishCaching(ret == 0, &cachetype);
     }
     else
     {
         p_block->i_buffer = (size_t) ret;
         vlc_mutex_locker locker( &lock );
         buffered += p_block->i_buffer;
+        if(cache)
+        {
+            block_t *p_copy = block_Duplicate(p_block);
+            if(p_copy)
+                block_ChainLastAppend(&pp_cachetail, p_copy);
+            else /* give up caching */
+            {
+                finishCaching(false, &cachetype);
+                cache = NULL;
+            }
+        }
         block_ChainLastAppend(&pp_tail, p_block);
-        if((size_t) ret < readsize)
+        if((size_t) ret < wanted)
         {
             done = true;
             rate.size = buffered + consumed;
             rate.time = vlc_tick_now() - downloadstart;
+            rate.latency = requestlatency;
             downloadstart = 0;
+            p_cachedata = finishCaching(true, &cachetype);
         }
     }
 
-    if(rate.size && rate.time)
+    if(p_cachedata)
+        cache->put(cacheurl, bytesRange, p_cachedata, cachetype, cachepinned);
+
+    if(ret < 0)
+        connManager->updateHostStats(params.getHostname(), 0, 0, true);
+    else if(rate.size && rate.time)
     {
+        connManager->updateRequestLatency(sourceid, rate.latency);
         connManager->updateDownloadRate(sourceid, rate.size, rate.time);
+        connManager->updateHostStats(params.getHostname(), rate.size, rate.time, false);
     }
 
     vlc_cond_signal(&avail);
@@ -419,7 +541,9 @@ bool HTTPChunkBufferedSource::prepare()
     if(!prepared)
     {
         downloadstart = vlc_tick_now();
-        return HTTPChunkSource::prepare();
+        if(!HTTPChunkSource::prepare())
+            return false;
+        requestlatency = vlc_tick_now() - downloadstart;
     }
     return true;
 }
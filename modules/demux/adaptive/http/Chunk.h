@@ -41,6 +41,7 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class SegmentCache;
 
         class AbstractChunkSource
         {
@@ -109,10 +110,10 @@ namespace adaptive
                 bool                prepared;
                 bool                eof;
                 ID                  sourceid;
+                ConnectionParams    params;
 
             private:
                 bool init(const std::string &);
-                ConnectionParams    params;
         };
 
         class HTTPChunkBufferedSource : public HTTPChunkSource
@@ -128,12 +129,18 @@ namespace adaptive
                 virtual bool       hasMoreData     () const; /* impl */
                 void               hold();
                 void               release();
+                void               setBoxAligned(bool);
+                void               setCache(SegmentCache *, const std::string &, bool);
 
             protected:
                 virtual bool       prepare(); /* reimpl */
                 void               bufferize(size_t);
                 bool               isDone() const;
 
+            private:
+                ssize_t            readBoxAligned(uint8_t *, size_t, size_t *);
+                block_t *          finishCaching(bool, std::string *);
+
             private:
                 block_t            *p_head; /* read cache buffer */
                 block_t           **pp_tail;
@@ -141,8 +148,16 @@ namespace adaptive
                 bool                done;
                 bool                eof;
                 vlc_tick_t          downloadstart;
+                vlc_tick_t          requestlatency;
                 vlc_cond_t          avail;
                 bool                held;
+                bool                boxaligned; /* never read across ISOBMFF boxes */
+                uint64_t            boxremain;
+                SegmentCache       *cache;
+                std::string         cacheurl;
+                bool                cachepinned;
+                block_t            *p_cachehead; /* copy of the whole download */
+                block_t           **pp_cachetail;
         };
 
         class HTTPChunk : public AbstractChunk
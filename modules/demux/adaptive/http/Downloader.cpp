@@ -26,40 +26,44 @@
 #include <vlc_threads.h>
 
 #include <atomic>
+#include <algorithm>
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Downloader(unsigned workers)
 {
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
+    vlc_cond_init(&donecond);
     killed = false;
-    thread_handle_valid = false;
+    thread_count = 0;
+    worker_count = VLC_CLIP(workers, 1, MAX_WORKERS);
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    while(thread_count < worker_count)
     {
-        return false;
+        if(vlc_clone(&thread_handles[thread_count], downloaderThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            break;
+        thread_count++;
     }
-    thread_handle_valid = true;
-    return true;
+    return thread_count > 0;
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, NULL);
+    for(unsigned i = 0; i < thread_count; i++)
+        vlc_join(thread_handles[i], NULL);
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
+    vlc_cond_destroy(&donecond);
 }
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
@@ -73,8 +77,11 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
-    source->release();
     chunks.remove(source);
+    /* Wait for the worker still reading it */
+    while(isProcessed(source))
+        vlc_cond_wait(&donecond, &lock);
+    source->release();
     vlc_mutex_unlock(&lock);
 }
 
@@ -93,27 +100,59 @@ void Downloader::DownloadSource(HTTPChunkBufferedSource *source)
         source->bufferize(HTTPChunkSource::CHUNK_SIZE);
 }
 
+bool Downloader::isProcessed(HTTPChunkBufferedSource *source) const
+{
+    std::list<HTTPChunkBufferedSource *>::const_iterator it;
+    for(it = processed.begin(); it != processed.end(); ++it)
+        if(*it == source)
+            return true;
+    return false;
+}
+
+HTTPChunkBufferedSource * Downloader::getNext()
+{
+    std::list<HTTPChunkBufferedSource *>::iterator it;
+    for(it = chunks.begin(); it != chunks.end(); ++it)
+    {
+        if(!isProcessed(*it))
+            return *it;
+    }
+    return NULL;
+}
+
 void Downloader::Run()
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        HTTPChunkBufferedSource *source;
+        while((source = getNext()) == NULL && !killed)
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        if(!chunks.empty())
+        processed.push_back(source);
+        vlc_mutex_unlock(&lock);
+
+        DownloadSource(source);
+
+        vlc_mutex_lock(&lock);
+        processed.remove(source);
+        /* Unless cancelled meanwhile, move it behind the other sources */
+        std::list<HTTPChunkBufferedSource *>::iterator it =
+                std::find(chunks.begin(), chunks.end(), source);
+        if(it != chunks.end())
         {
-            HTTPChunkBufferedSource *source = chunks.front();
-            DownloadSource(source);
+            chunks.erase(it);
             if(source->isDone())
-            {
-                chunks.pop_front();
                 source->release();
-            }
+            else
+                chunks.push_back(source);
         }
+        vlc_cond_broadcast(&donecond);
+        if(!chunks.empty())
+            vlc_cond_signal(&waitcond);
     }
     vlc_mutex_unlock(&lock);
 }
@@ -31,25 +31,35 @@ namespace adaptive
     namespace http
     {
 
+        /* Pool of download threads: sources are bufferized in turn, one
+         * chunk at a time, so that a slow segment does not delay the
+         * segments of the other streams. */
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
 
+                static const unsigned MAX_WORKERS = 8;
+
             private:
                 static void * downloaderThread(void *);
                 void Run();
                 void DownloadSource(HTTPChunkBufferedSource *);
-                vlc_thread_t thread_handle;
+                HTTPChunkBufferedSource * getNext();
+                bool isProcessed(HTTPChunkBufferedSource *) const;
+                vlc_thread_t thread_handles[MAX_WORKERS];
+                unsigned     thread_count;
+                unsigned     worker_count;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
-                bool         thread_handle_valid;
+                vlc_cond_t   donecond;
                 bool         killed;
                 std::list<HTTPChunkBufferedSource *> chunks;
+                std::list<HTTPChunkBufferedSource *> processed;
         };
 
     }
@@ -27,9 +27,21 @@
 #include "Transport.hpp"
 #include "../tools/Helper.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <vlc_stream.h>
+#include <vlc_block.h>
+#include <vlc_arrays.h>
+
+extern "C"
+{
+    #include "../../../access/http/message.h"
+    #include "../../../access/http/resource.h"
+    #include "../../../access/http/connmgr.h"
+}
 
 using namespace adaptive::http;
 
@@ -65,6 +77,11 @@ const std::string & AbstractConnection::getContentType() const
     return contentType;
 }
 
+const ConnectionParams & AbstractConnection::getRedirection() const
+{
+    return locationparams;
+}
+
 HTTPConnection::HTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
                                Transport *socket_, const ConnectionParams &proxy, bool persistent)
     : AbstractConnection( p_object_ )
@@ -463,11 +480,6 @@ std::string HTTPConnection::extraRequestHeaders() const
     return ss.str();
 }
 
-const ConnectionParams & HTTPConnection::getRedirection() const
-{
-    return locationparams;
-}
-
 StreamUrlConnection::StreamUrlConnection(vlc_object_t *p_object)
     : AbstractConnection(p_object)
 {
@@ -579,6 +591,278 @@ void StreamUrlConnection::setUsed( bool b )
        reset();
 }
 
+namespace adaptive
+{
+    namespace http
+    {
+        /* The libvlc HTTP manager only keeps a single connection, and is not
+         * thread-safe: there is one per origin, and requests to it, as well
+         * as closing its streams, are serialized. Reading is not. */
+        class LibVLCHTTPOrigin
+        {
+            public:
+                LibVLCHTTPOrigin(vlc_object_t *p_object, vlc_http_cookie_jar_t *jar,
+                                 const ConnectionParams &params)
+                {
+                    scheme = params.getScheme();
+                    hostname = params.getHostname();
+                    port = params.getPort();
+                    manager = vlc_http_mgr_create(p_object, jar);
+                    vlc_mutex_init(&lock);
+                }
+
+                ~LibVLCHTTPOrigin()
+                {
+                    if(manager)
+                        vlc_http_mgr_destroy(manager);
+                    vlc_mutex_destroy(&lock);
+                }
+
+                bool matches(const ConnectionParams &params) const
+                {
+                    return params.getScheme() == scheme &&
+                           params.getHostname() == hostname &&
+                           params.getPort() == port;
+                }
+
+                struct vlc_http_mgr *manager;
+                vlc_mutex_t lock;
+
+            private:
+                std::string scheme;
+                std::string hostname;
+                uint16_t port;
+        };
+    }
+}
+
+struct libvlc_http_range
+{
+    uintmax_t start;
+    uintmax_t end; /* 0 if open ended */
+};
+
+/* The range follows the resource, as its opaque callbacks data */
+struct libvlc_http_resource
+{
+    struct vlc_http_resource resource;
+    struct libvlc_http_range range;
+};
+
+static int LibVLCHTTPFormatRequest(const struct vlc_http_resource *,
+                                   struct vlc_http_msg *req, void *opaque)
+{
+    const struct libvlc_http_range *range =
+            static_cast<const struct libvlc_http_range *>(opaque);
+
+    vlc_http_msg_add_header(req, "Cache-Control", "no-cache");
+    if(range->end > 0)
+        return vlc_http_msg_add_header(req, "Range", "bytes=%ju-%ju",
+                                       range->start, range->end);
+    else if(range->start > 0)
+        return vlc_http_msg_add_header(req, "Range", "bytes=%ju-",
+                                       range->start);
+    return 0;
+}
+
+static int LibVLCHTTPValidateResponse(const struct vlc_http_resource *,
+                                      const struct vlc_http_msg *resp, void *opaque)
+{
+    const struct libvlc_http_range *range =
+            static_cast<const struct libvlc_http_range *>(opaque);
+
+    /* Server ignored the range, data would be at the wrong offset */
+    if(vlc_http_msg_get_status(resp) == 200 && range->start > 0)
+        return -1;
+    return 0;
+}
+
+static const struct vlc_http_resource_cbs libvlc_http_callbacks =
+{
+    LibVLCHTTPFormatRequest,
+    LibVLCHTTPValidateResponse,
+};
+
+LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_,
+                                           LibVLCHTTPOrigin *origin_)
+    : AbstractConnection(p_object_)
+{
+    origin = origin_;
+    resource = NULL;
+    pending = NULL;
+    char *psz_useragent = var_InheritString(p_object_, "http-user-agent");
+    if(psz_useragent)
+    {
+        useragent = std::string(psz_useragent);
+        free(psz_useragent);
+    }
+    char *psz_referer = var_InheritString(p_object_, "http-referrer");
+    if(psz_referer)
+    {
+        referer = std::string(psz_referer);
+        free(psz_referer);
+    }
+}
+
+LibVLCHTTPConnection::~LibVLCHTTPConnection()
+{
+    reset();
+}
+
+void LibVLCHTTPConnection::reset()
+{
+    if(pending)
+        block_Release(pending);
+    pending = NULL;
+    if(resource)
+    {
+        vlc_mutex_lock(&origin->lock);
+        vlc_http_res_destroy(resource);
+        vlc_mutex_unlock(&origin->lock);
+    }
+    resource = NULL;
+    bytesRead = 0;
+    contentLength = 0;
+    contentType = std::string();
+    bytesRange = BytesRange();
+}
+
+bool LibVLCHTTPConnection::canReuse(const ConnectionParams &params_) const
+{
+    return available && !params_.usesAccess() && origin->matches(params_);
+}
+
+enum RequestStatus
+    LibVLCHTTPConnection::request(const std::string &path, const BytesRange &range)
+{
+    reset();
+
+    /* Set new path for this query */
+    params.setPath(path);
+    locationparams = ConnectionParams();
+
+    msg_Dbg(p_object, "Retrieving %s @%zu", params.getUrl().c_str(),
+                      range.isValid() ? range.getStartByte() : 0);
+
+    struct libvlc_http_resource *res = static_cast<struct libvlc_http_resource *>
+            (std::malloc(sizeof(*res)));
+    if(!res)
+        return RequestStatus::GenericError;
+
+    res->range.start = range.isValid() ? range.getStartByte() : 0;
+    res->range.end = range.isValid() ? range.getEndByte() : 0;
+
+    if(vlc_http_res_init(&res->resource, &libvlc_http_callbacks, origin->manager,
+                         params.getUrl().c_str(),
+                         useragent.empty() ? NULL : useragent.c_str(),
+                         referer.empty() ? NULL : referer.c_str()))
+    {
+        std::free(res);
+        return RequestStatus::GenericError;
+    }
+    resource = &res->resource;
+
+    /* Reuses or establishes the origin connection */
+    vlc_mutex_lock(&origin->lock);
+    int status = vlc_http_res_get_status(resource);
+    vlc_mutex_unlock(&origin->lock);
+    if(status < 0)
+    {
+        reset();
+        return RequestStatus::GenericError;
+    }
+
+    char *psz_redirect = vlc_http_res_get_redirect(resource);
+    if(psz_redirect)
+    {
+        locationparams = ConnectionParams(psz_redirect);
+        free(psz_redirect);
+        reset();
+        msg_Info(p_object, "%d redirection to %s", status, locationparams.getUrl().c_str());
+        if(locationparams.isLocal() && !params.isLocal())
+        {
+            msg_Err(p_object, "redirection to local rejected");
+            return RequestStatus::GenericError;
+        }
+        return RequestStatus::Redirection;
+    }
+    else if(status != 200 && status != 206)
+    {
+        msg_Err(p_object, "Failed reading %s: %d", params.getUrl().c_str(), status);
+        reset();
+        return (status == 401) ? RequestStatus::Unauthorized : RequestStatus::NotFound;
+    }
+
+    char *psz_type = vlc_http_res_get_type(resource);
+    if(psz_type)
+    {
+        contentType = std::string(psz_type);
+        free(psz_type);
+    }
+
+    bytesRange = range;
+    uintmax_t size = vlc_http_msg_get_size(resource->response);
+    if(size != UINTMAX_MAX)
+        contentLength = size;
+    else if(range.isValid() && range.getEndByte() > 0)
+        contentLength = range.getEndByte() - range.getStartByte() + 1;
+
+    return RequestStatus::Success;
+}
+
+ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
+{
+    if(!resource)
+        return VLC_EGENERIC;
+
+    if(len == 0)
+        return VLC_SUCCESS;
+
+    const size_t toRead = (contentLength) ? contentLength - bytesRead : len;
+    if (toRead == 0)
+        return VLC_SUCCESS;
+
+    if(len > toRead)
+        len = toRead;
+
+    size_t copied = 0;
+    while(copied < len)
+    {
+        if(!pending)
+        {
+            block_t *p_block = vlc_http_res_read(resource);
+            if(p_block == NULL || p_block == vlc_http_error)
+                break;
+            pending = p_block;
+        }
+
+        size_t size = std::min(pending->i_buffer, len - copied);
+        memcpy(&((uint8_t*)p_buffer)[copied], pending->p_buffer, size);
+        pending->p_buffer += size;
+        pending->i_buffer -= size;
+        copied += size;
+        if(pending->i_buffer == 0)
+        {
+            block_Release(pending);
+            pending = NULL;
+        }
+    }
+
+    bytesRead += copied;
+    if(copied < len) /* set EOF */
+        contentLength = bytesRead;
+
+    return copied;
+}
+
+void LibVLCHTTPConnection::setUsed( bool b )
+{
+    available = !b;
+    /* Streams on a shared connection are closed, not kept around */
+    if(available)
+        reset();
+}
+
 NativeConnectionFactory::NativeConnectionFactory( AuthStorage *auth )
     : AbstractConnectionFactory()
 {
@@ -636,16 +920,70 @@ AbstractConnection * StreamUrlConnectionFactory::createConnection(vlc_object_t *
     return new (std::nothrow) StreamUrlConnection(p_object);
 }
 
+LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *auth )
+    : AbstractConnectionFactory()
+{
+    authStorage = auth;
+    vlc_mutex_init(&lock);
+}
+
+LibVLCHTTPConnectionFactory::~LibVLCHTTPConnectionFactory()
+{
+    vlc_delete_all(origins);
+    vlc_mutex_destroy(&lock);
+}
+
+AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t *p_object,
+                                                                   const ConnectionParams &params)
+{
+    /* There is no way to upgrade to HTTP/2 without TLS */
+    if(params.getScheme() != "https" || params.getHostname().empty())
+        return NULL;
+
+    LibVLCHTTPOrigin *origin = NULL;
+    vlc_mutex_lock(&lock);
+    std::list<LibVLCHTTPOrigin *>::const_iterator it;
+    for(it = origins.begin(); it != origins.end(); ++it)
+    {
+        if((*it)->matches(params))
+        {
+            origin = *it;
+            break;
+        }
+    }
+    if(!origin)
+    {
+        origin = new (std::nothrow) LibVLCHTTPOrigin(p_object,
+                                                     authStorage ? authStorage->getJar() : NULL,
+                                                     params);
+        if(origin && !origin->manager)
+        {
+            delete origin;
+            origin = NULL;
+        }
+        if(origin)
+            origins.push_back(origin);
+    }
+    vlc_mutex_unlock(&lock);
+
+    if(!origin)
+        return NULL;
+
+    return new (std::nothrow) LibVLCHTTPConnection(p_object, origin);
+}
+
 ConnectionFactory::ConnectionFactory( AuthStorage *authstorage )
 {
     native = new NativeConnectionFactory( authstorage );
     streamurl = new StreamUrlConnectionFactory();
+    libvlchttp = new LibVLCHTTPConnectionFactory( authstorage );
 }
 
 ConnectionFactory::~ConnectionFactory()
 {
     delete native;
     delete streamurl;
+    delete libvlchttp;
 }
 
 AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
@@ -654,6 +992,12 @@ AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
     bool b_streamurl = var_InheritBool(p_object, "adaptive-use-access");
     if(!b_streamurl && !params.usesAccess())
     {
+        if(var_InheritBool(p_object, "adaptive-use-http2"))
+        {
+            AbstractConnection *conn = libvlchttp->createConnection(p_object, params);
+            if(conn)
+                return conn;
+        }
         return native->createConnection(p_object, params);
     }
     else
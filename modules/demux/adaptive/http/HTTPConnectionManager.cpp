@@ -33,6 +33,8 @@
 #include <vlc_url.h>
 #include <vlc_http.h>
 
+#include <algorithm>
+
 using namespace adaptive::http;
 
 AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
@@ -40,19 +42,47 @@ AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
 {
     p_object = p_object_;
     rateObserver = NULL;
+    requests = 0;
+    bytes = 0;
+    busy = 0;
+    latency = VLC_TICK_INVALID;
+    vlc_mutex_init(&rate_lock);
 }
 
 AbstractConnectionManager::~AbstractConnectionManager()
 {
-
+    vlc_mutex_destroy(&rate_lock);
 }
 
 void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size, vlc_tick_t time)
 {
+    /* Downloads can complete in parallel */
+    vlc_mutex_locker locker(&rate_lock);
+    bytes += size;
+    busy += time;
     if(rateObserver)
         rateObserver->updateDownloadRate(sourceid, size, time);
 }
 
+void AbstractConnectionManager::updateRequestLatency(const adaptive::ID &sourceid, vlc_tick_t time)
+{
+    vlc_mutex_locker locker(&rate_lock);
+    /* reported once per completed request, unlike the download rate */
+    requests++;
+    latency = time;
+    if(rateObserver)
+        rateObserver->updateRequestLatency(sourceid, time);
+}
+
+void AbstractConnectionManager::getNetworkStats(struct vlc_stream_network *net)
+{
+    vlc_mutex_locker locker(&rate_lock);
+    net->requests = requests;
+    /* average over the transfers, idle time between segments excluded */
+    net->throughput = busy > 0 ? bytes * 8 * CLOCK_FREQ / busy : 0;
+    net->rtt = latency;
+}
+
 void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *obs)
 {
     rateObserver = obs;
@@ -64,16 +94,19 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    downloader = new (std::nothrow) Downloader(
+                        var_InheritInteger(p_object, "adaptive-maxdownloads"));
+    if(downloader)
+        downloader->start();
     factory = new ConnectionFactory(storage);
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
 {
     delete downloader;
-    delete factory;
+    /* connections can refer to the factory shared origins */
     this->closeAllConnections();
+    delete factory;
     vlc_mutex_destroy(&lock);
 }
 
@@ -160,3 +193,96 @@ void HTTPConnectionManager::setLocalConnectionsAllowed()
 {
     localAllowed = true;
 }
+
+/* Failing hosts are avoided for that long, per consecutive failure */
+#define PATHWAY_FAILURE_PENALTY VLC_TICK_FROM_SEC(10)
+
+HTTPConnectionManager::HostStats::HostStats()
+{
+    bps = 0;
+    failures = 0;
+    lastfailure = VLC_TICK_INVALID;
+}
+
+void HTTPConnectionManager::updateHostStats(const std::string &host, size_t size,
+                                            vlc_tick_t time, bool b_failed)
+{
+    vlc_mutex_locker locker(&lock);
+    HostStats &stats = hostStats[host];
+    if(b_failed)
+    {
+        stats.failures++;
+        stats.lastfailure = vlc_tick_now();
+    }
+    else if(time > 0)
+    {
+        const uint64_t bps = CLOCK_FREQ * size * 8 / time;
+        stats.bps = stats.bps ? (stats.bps * 3 + bps) / 4 : bps;
+        stats.failures = 0;
+    }
+}
+
+int64_t HTTPConnectionManager::pathwayScore(const std::string &host, vlc_tick_t now) const
+{
+    std::map<std::string, HostStats>::const_iterator it = hostStats.find(host);
+    if(it == hostStats.end())
+        return -1; /* unknown */
+    const HostStats &stats = (*it).second;
+    if(stats.failures &&
+       now - stats.lastfailure < PATHWAY_FAILURE_PENALTY * std::min(stats.failures, 4U))
+        return 0;
+    return stats.bps ? (int64_t) stats.bps : -1;
+}
+
+size_t HTTPConnectionManager::selectPathway(const std::vector<std::string> &bases,
+                                            size_t current)
+{
+    std::vector<std::string> hosts;
+    std::vector<std::string>::const_iterator it;
+    for(it = bases.begin(); it != bases.end(); ++it)
+        hosts.push_back(ConnectionParams(*it).getHostname());
+
+    vlc_mutex_locker locker(&lock);
+
+    /* Stick to the pathway we already moved to */
+    for(size_t i=0; i<hosts.size(); i++)
+    {
+        if(!steeredHost.empty() && hosts[i] == steeredHost)
+        {
+            current = i;
+            break;
+        }
+    }
+
+    const vlc_tick_t now = vlc_tick_now();
+    const int64_t currentScore = pathwayScore(hosts[current], now);
+    size_t best = current;
+    int64_t bestScore = currentScore;
+    for(size_t i=0; i<hosts.size(); i++)
+    {
+        if(i == current || hosts[i] == hosts[current])
+            continue;
+        const int64_t score = pathwayScore(hosts[i], now);
+        if(currentScore == 0)
+        {
+            /* failing: anything not failing, preferably measured faster */
+            if(score != 0 && (best == current || score > bestScore))
+            {
+                best = i;
+                bestScore = score;
+            }
+        }
+        else if(currentScore > 0 && score > currentScore * 3 / 2 && score > bestScore)
+        {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    if(hosts[best] != steeredHost && (best != current || !steeredHost.empty()))
+        msg_Info(p_object, "Steering requests to %s (score %" PRId64 ")",
+                 hosts[best].c_str(), bestScore);
+    steeredHost = hosts[best];
+
+    return best;
+}
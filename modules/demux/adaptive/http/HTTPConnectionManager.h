@@ -28,9 +28,11 @@
 #include "../logic/IDownloadRateObserver.h"
 
 #include <vlc_common.h>
+#include <vlc_stream.h>
 
 #include <vector>
 #include <string>
+#include <map>
 
 namespace adaptive
 {
@@ -54,13 +56,27 @@ namespace adaptive
                 virtual void cancel(AbstractChunkSource *) = 0;
 
                 virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t); /* impl */
+                virtual void updateRequestLatency(const ID &, vlc_tick_t); /* reimpl */
                 void setDownloadRateObserver(IDownloadRateObserver *);
+                void getNetworkStats(struct vlc_stream_network *);
+
+                /* Per host statistics for choosing between alternate base URLs */
+                virtual void updateHostStats(const std::string &, size_t, vlc_tick_t, bool) {}
+                virtual size_t selectPathway(const std::vector<std::string> &, size_t current)
+                {
+                    return current;
+                }
 
             protected:
                 vlc_object_t                                       *p_object;
 
             private:
                 IDownloadRateObserver                              *rateObserver;
+                vlc_mutex_t                                         rate_lock;
+                uint64_t                                            requests;
+                uint64_t                                            bytes;
+                vlc_tick_t                                          busy;
+                vlc_tick_t                                          latency;
         };
 
         class HTTPConnectionManager : public AbstractConnectionManager
@@ -76,7 +92,23 @@ namespace adaptive
                 virtual void cancel(AbstractChunkSource *) /* impl */;
                 void         setLocalConnectionsAllowed();
 
+                virtual void updateHostStats(const std::string &, size_t,
+                                             vlc_tick_t, bool) /* reimpl */;
+                virtual size_t selectPathway(const std::vector<std::string> &,
+                                             size_t) /* reimpl */;
+
             private:
+                class HostStats
+                {
+                    public:
+                        HostStats();
+                        uint64_t bps;
+                        unsigned failures;
+                        vlc_tick_t lastfailure;
+                };
+                int64_t pathwayScore(const std::string &, vlc_tick_t) const;
+                std::map<std::string, HostStats>                    hostStats;
+                std::string                                         steeredHost;
                 void    releaseAllConnections ();
                 Downloader                                         *downloader;
                 vlc_mutex_t                                         lock;
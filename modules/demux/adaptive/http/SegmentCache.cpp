@@ -0,0 +1,293 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2021 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+
+#include <cstdio>
+#include <sstream>
+
+using namespace adaptive::http;
+
+SegmentCache::Entry::Entry()
+{
+    p_block = NULL;
+    size = 0;
+    pinned = false;
+}
+
+SegmentCache::SegmentCache(vlc_object_t *obj_, size_t memorybudget_,
+                           const std::string &dir_, size_t diskbudget_)
+{
+    obj = obj_;
+    memorybudget = memorybudget_;
+    diskbudget = dir_.empty() ? 0 : diskbudget_;
+    dir = dir_;
+    memoryused = 0;
+    diskused = 0;
+    vlc_mutex_init(&lock);
+}
+
+SegmentCache::~SegmentCache()
+{
+    std::map<std::string, Entry>::iterator it;
+    for(it = entries.begin(); it != entries.end(); ++it)
+        drop((*it).second);
+    vlc_mutex_destroy(&lock);
+}
+
+std::string SegmentCache::makeKey(const std::string &url, const BytesRange &range)
+{
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << url;
+    if(range.isValid())
+        ss << "@" << range.getStartByte() << "-" << range.getEndByte();
+    return ss.str();
+}
+
+void SegmentCache::drop(Entry &entry)
+{
+    if(entry.p_block)
+    {
+        block_Release(entry.p_block);
+        entry.p_block = NULL;
+    }
+    else if(!entry.path.empty())
+    {
+        vlc_unlink(entry.path.c_str());
+        entry.path.clear();
+    }
+}
+
+bool SegmentCache::store(const std::string &key, Entry &entry)
+{
+    if(entry.size > diskbudget)
+        return false;
+
+    struct md5_s md5;
+    InitMD5(&md5);
+    AddMD5(&md5, key.c_str(), key.length());
+    EndMD5(&md5);
+    char *psz_hash = psz_md5_hash(&md5);
+    if(!psz_hash)
+        return false;
+    const std::string path = dir + DIR_SEP + psz_hash;
+    free(psz_hash);
+
+    FILE *f = vlc_fopen(path.c_str(), "wb");
+    if(!f)
+        return false;
+    bool b_ok = fwrite(entry.p_block->p_buffer, 1, entry.size, f) == entry.size;
+    if(fclose(f))
+        b_ok = false;
+    if(!b_ok)
+    {
+        vlc_unlink(path.c_str());
+        return false;
+    }
+
+    block_Release(entry.p_block);
+    entry.p_block = NULL;
+    entry.path = path;
+    return true;
+}
+
+block_t * SegmentCache::load(const Entry &entry) const
+{
+    FILE *f = vlc_fopen(entry.path.c_str(), "rb");
+    if(!f)
+        return NULL;
+    block_t *p_block = block_Alloc(entry.size);
+    if(p_block && fread(p_block->p_buffer, 1, entry.size, f) != entry.size)
+    {
+        block_Release(p_block);
+        p_block = NULL;
+    }
+    fclose(f);
+    return p_block;
+}
+
+void SegmentCache::evict()
+{
+    while(memoryused > memorybudget && !lru.empty())
+    {
+        const std::string key = lru.back();
+        lru.pop_back();
+        std::map<std::string, Entry>::iterator it = entries.find(key);
+        Entry &entry = (*it).second;
+        memoryused -= entry.size;
+        if(store(key, entry))
+        {
+            disklru.push_front(key);
+            entry.pos = disklru.begin();
+            diskused += entry.size;
+        }
+        else
+        {
+            drop(entry);
+            entries.erase(it);
+        }
+    }
+
+    while(diskused > diskbudget && !disklru.empty())
+    {
+        std::map<std::string, Entry>::iterator it = entries.find(disklru.back());
+        disklru.pop_back();
+        diskused -= (*it).second.size;
+        drop((*it).second);
+        entries.erase(it);
+    }
+}
+
+block_t * SegmentCache::get(const std::string &url, const BytesRange &range,
+                            std::string *contentType)
+{
+    block_t *p_block = NULL;
+
+    vlc_mutex_locker locker(&lock);
+
+    std::map<std::string, Entry>::iterator it = entries.find(makeKey(url, range));
+    if(it == entries.end())
+        return NULL;
+
+    Entry &entry = (*it).second;
+    if(entry.p_block == NULL) /* promote from disk */
+    {
+        block_t *p_loaded = load(entry);
+        disklru.erase(entry.pos);
+        diskused -= entry.size;
+        drop(entry);
+        if(!p_loaded)
+        {
+            entries.erase(it);
+            return NULL;
+        }
+        entry.p_block = p_loaded;
+        lru.push_front((*it).first);
+        entry.pos = lru.begin();
+        memoryused += entry.size;
+    }
+    else if(!entry.pinned)
+    {
+        lru.splice(lru.begin(), lru, entry.pos);
+    }
+
+    p_block = block_Duplicate(entry.p_block);
+    if(p_block)
+        *contentType = entry.contentType;
+
+    evict();
+
+    return p_block;
+}
+
+void SegmentCache::put(const std::string &url, const BytesRange &range, block_t *p_block,
+                       const std::string &contentType, bool pinned)
+{
+    vlc_mutex_locker locker(&lock);
+
+    const std::string key = makeKey(url, range);
+    if(entries.find(key) != entries.end() ||
+       (!pinned && p_block->i_buffer > memorybudget))
+    {
+        block_Release(p_block);
+        return;
+    }
+
+    Entry &entry = entries[key];
+    entry.p_block = p_block;
+    entry.size = p_block->i_buffer;
+    entry.contentType = contentType;
+    entry.pinned = pinned;
+    memoryused += entry.size;
+    if(!pinned)
+    {
+        lru.push_front(key);
+        entry.pos = lru.begin();
+    }
+
+    evict();
+}
+
+CachedChunkSource::CachedChunkSource(block_t *block, const std::string &type)
+{
+    data = block;
+    i_read = 0;
+    contentLength = data->i_buffer;
+    contentType = type;
+}
+
+CachedChunkSource::~CachedChunkSource()
+{
+    if(data)
+        block_Release(data);
+}
+
+bool CachedChunkSource::hasMoreData() const
+{
+    return data && i_read < contentLength;
+}
+
+std::string CachedChunkSource::getContentType() const
+{
+    return contentType;
+}
+
+block_t * CachedChunkSource::readBlock()
+{
+    if(!data)
+        return NULL;
+    if(i_read == 0)
+    {
+        block_t *p_block = data;
+        data = NULL;
+        i_read = contentLength;
+        return p_block;
+    }
+    return read(contentLength - i_read);
+}
+
+block_t * CachedChunkSource::read(size_t toread)
+{
+    if(!data)
+        return NULL;
+
+    block_t * p_block = NULL;
+
+    toread = __MIN(data->i_buffer - i_read, toread);
+    if(toread > 0)
+    {
+        if((p_block = block_Alloc(toread)))
+        {
+            memcpy(p_block->p_buffer, &data->p_buffer[i_read], toread);
+            p_block->i_buffer = toread;
+            i_read += toread;
+        }
+    }
+
+    return p_block;
+}
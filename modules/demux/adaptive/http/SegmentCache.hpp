@@ -0,0 +1,97 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2021 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include "Chunk.h"
+
+#include <vlc_common.h>
+
+#include <map>
+#include <list>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        /* LRU cache of downloaded segments, shared by all streams.
+         * Pinned entries (init segments) are never evicted. Entries evicted
+         * from memory go to the disk tier, if any, before being dropped. */
+        class SegmentCache
+        {
+            public:
+                SegmentCache(vlc_object_t *, size_t, const std::string &, size_t);
+                ~SegmentCache();
+                /* returns a copy of the cached data */
+                block_t * get(const std::string &, const BytesRange &, std::string *);
+                /* takes ownership of the block */
+                void      put(const std::string &, const BytesRange &, block_t *,
+                              const std::string &, bool);
+
+            private:
+                class Entry
+                {
+                    public:
+                        Entry();
+                        block_t *p_block; /* NULL when on disk */
+                        std::string contentType;
+                        std::string path;
+                        size_t size;
+                        bool pinned;
+                        std::list<std::string>::iterator pos;
+                };
+                static std::string makeKey(const std::string &, const BytesRange &);
+                void evict();
+                bool store(const std::string &, Entry &);
+                block_t * load(const Entry &) const;
+                void drop(Entry &);
+                std::map<std::string, Entry> entries;
+                std::list<std::string> lru; /* in memory, most recent first */
+                std::list<std::string> disklru;
+                size_t memoryused;
+                size_t memorybudget;
+                size_t diskused;
+                size_t diskbudget;
+                std::string dir;
+                vlc_object_t *obj;
+                vlc_mutex_t lock;
+        };
+
+        class CachedChunkSource : public AbstractChunkSource
+        {
+            public:
+                CachedChunkSource(block_t *, const std::string &);
+                virtual ~CachedChunkSource();
+
+                virtual block_t *   readBlock       (); /* impl */
+                virtual block_t *   read            (size_t); /* impl */
+                virtual bool        hasMoreData     () const; /* impl */
+                virtual std::string getContentType  () const; /* reimpl */
+
+            private:
+                block_t    *data;
+                size_t      i_read;
+                std::string contentType;
+        };
+    }
+}
+
+#endif // SEGMENTCACHE_HPP
@@ -0,0 +1,278 @@
+/*
+ * DynamicAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2021 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "DynamicAdaptationLogic.hpp"
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../tools/Debug.hpp"
+
+#include <cmath>
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Hybrid throughput / buffer occupancy logic, like the dash.js DYNAMIC rule:
+ * throughput and request latency based while starting or buffer is low,
+ * then BOLA (see NearOptimalAdaptationLogic) once the buffer is steady.
+ */
+
+#define minimumBufferS VLC_TICK_FROM_SEC(6)  /* Qmin */
+#define bufferTargetS  VLC_TICK_FROM_SEC(30) /* Qmax */
+#define steadyBufferS  VLC_TICK_FROM_SEC(10) /* switch to BOLA */
+
+DynamicContext::DynamicContext()
+    : buffering_min( minimumBufferS )
+    , buffering_level( 0 )
+    , buffering_target( bufferTargetS )
+    , last_duration( 0 )
+    , request_latency( 0 )
+    , last_download_rate( 0 )
+    , b_bola( false )
+{ }
+
+DynamicAdaptationLogic::DynamicAdaptationLogic(vlc_object_t *obj)
+    : AbstractAdaptationLogic(obj)
+    , currentBps( 0 )
+    , usedBps( 0 )
+{
+    vlc_mutex_init(&lock);
+}
+
+DynamicAdaptationLogic::~DynamicAdaptationLogic()
+{
+    vlc_mutex_destroy(&lock);
+}
+
+BaseRepresentation *
+DynamicAdaptationLogic::getThroughputRepresentation(BaseAdaptationSet *adaptSet,
+                                                    RepresentationSelector &selector,
+                                                    const DynamicContext &ctx, unsigned bps)
+{
+    /* The next segment has to be fetched within its own duration, with
+     * some safety margin, including the request round trip */
+    const vlc_tick_t duration = ctx.last_duration ? ctx.last_duration : VLC_TICK_FROM_SEC(2);
+    vlc_tick_t budget = duration * 9 / 10 - ctx.request_latency;
+    if(budget < duration / 4)
+        budget = duration / 4;
+    return selector.select(adaptSet, (uint64_t) bps * budget / duration);
+}
+
+BaseRepresentation *
+DynamicAdaptationLogic::getBolaRepresentation(BaseAdaptationSet *adaptSet,
+                                              RepresentationSelector &selector,
+                                              const DynamicContext &ctx,
+                                              BaseRepresentation *prevRep, unsigned bps)
+{
+    const float umin = std::log((float)selector.lowest(adaptSet)->getBandwidth());
+    const float umax = std::log((float)selector.highest(adaptSet)->getBandwidth());
+    const float gammaP = 1.0 + (umax - umin) / ((float)ctx.buffering_target / ctx.buffering_min - 1.0);
+    const float Vd = (secf_from_vlc_tick(ctx.buffering_min) - 1.0) / (umin + gammaP);
+    const float Q = secf_from_vlc_tick(ctx.buffering_level);
+
+    BaseRepresentation *m = NULL;
+    BaseRepresentation *prev = NULL;
+    float argmax = 0;
+    for(BaseRepresentation *rep = selector.lowest(adaptSet);
+                            rep && rep != prev; rep = selector.higher(adaptSet, rep))
+    {
+        const float utility = std::log((float)rep->getBandwidth()) - umin;
+        const float arg = ( Vd * (utility + gammaP) - Q ) / rep->getBandwidth();
+        if(m == NULL || argmax <= arg)
+        {
+            m = rep;
+            argmax = arg;
+        }
+        prev = rep;
+    }
+
+    /* Avoid oscillations on upswitch, bounded by throughput */
+    if(m && prevRep && m->getBandwidth() > prevRep->getBandwidth())
+    {
+        BaseRepresentation *mp = getThroughputRepresentation(adaptSet, selector, ctx, bps);
+        if(mp->getBandwidth() < prevRep->getBandwidth())
+            m = prevRep;
+        else if(mp->getBandwidth() < m->getBandwidth())
+            m = mp;
+    }
+
+    return m;
+}
+
+BaseRepresentation *DynamicAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+
+    vlc_mutex_lock(&lock);
+
+    std::map<ID, DynamicContext>::iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end() || currentBps == 0)
+    {
+        vlc_mutex_unlock(&lock);
+        return selector.lowest(adaptSet);
+    }
+
+    DynamicContext &ctx = (*it).second;
+    const vlc_tick_t steady = std::min(steadyBufferS, ctx.buffering_target / 2);
+    if(!ctx.b_bola && ctx.buffering_level >= steady)
+        ctx.b_bola = true;
+    else if(ctx.b_bola && ctx.buffering_level < steady / 2)
+        ctx.b_bola = false;
+
+    const DynamicContext ctxcopy = ctx;
+    const unsigned bps = getAvailableBw(currentBps, prevRep);
+
+    vlc_mutex_unlock(&lock);
+
+    BaseRepresentation *rep;
+    if(ctxcopy.b_bola && prevRep)
+        rep = getBolaRepresentation(adaptSet, selector, ctxcopy, prevRep, bps);
+    else
+        rep = getThroughputRepresentation(adaptSet, selector, ctxcopy, bps);
+
+    if(rep && rep != prevRep)
+        msg_Dbg(p_obj, "adaptation stream=%s rule=%s from=%" PRIu64 " to=%" PRIu64
+                       " buffer=%" PRId64 "ms throughput=%u latency=%" PRId64 "ms",
+                adaptSet->getID().str().c_str(), ctxcopy.b_bola ? "bola" : "throughput",
+                prevRep ? prevRep->getBandwidth() : 0, rep->getBandwidth(),
+                MS_FROM_VLC_TICK(ctxcopy.buffering_level), bps,
+                MS_FROM_VLC_TICK(ctxcopy.request_latency));
+
+    return rep;
+}
+
+unsigned DynamicAdaptationLogic::getAvailableBw(unsigned i_bw, const BaseRepresentation *curRep) const
+{
+    unsigned i_remain = i_bw;
+    if(i_remain > usedBps)
+        i_remain -= usedBps;
+    else
+        i_remain = 0;
+    if(curRep)
+        i_remain += curRep->getBandwidth();
+    return i_remain > i_bw ? i_remain : i_bw;
+}
+
+unsigned DynamicAdaptationLogic::getMaxCurrentBw() const
+{
+    unsigned i_max_bitrate = 0;
+    for(std::map<ID, DynamicContext>::const_iterator it = streams.begin();
+                                                     it != streams.end(); ++it)
+        i_max_bitrate = std::max(i_max_bitrate, ((*it).second).last_download_rate);
+    return i_max_bitrate;
+}
+
+void DynamicAdaptationLogic::updateRequestLatency(const ID &id, vlc_tick_t time)
+{
+    vlc_mutex_lock(&lock);
+    std::map<ID, DynamicContext>::iterator it = streams.find(id);
+    if(it != streams.end())
+    {
+        DynamicContext &ctx = (*it).second;
+        ctx.request_latency = ctx.latency_average.push(time);
+    }
+    vlc_mutex_unlock(&lock);
+}
+
+void DynamicAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, vlc_tick_t time)
+{
+    vlc_mutex_lock(&lock);
+    std::map<ID, DynamicContext>::iterator it = streams.find(id);
+    if(it != streams.end())
+    {
+        DynamicContext &ctx = (*it).second;
+        /* don't count the request round trip as transfer time */
+        if(time > 2 * ctx.request_latency)
+            time -= ctx.request_latency;
+        ctx.last_download_rate = ctx.average.push(CLOCK_FREQ * dlsize * 8 / time);
+    }
+    currentBps = getMaxCurrentBw();
+    vlc_mutex_unlock(&lock);
+}
+
+void DynamicAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
+{
+    switch(event.type)
+    {
+    case SegmentTrackerEvent::SWITCHING:
+        {
+            vlc_mutex_lock(&lock);
+            if(event.u.switching.prev)
+                usedBps -= event.u.switching.prev->getBandwidth();
+            if(event.u.switching.next)
+                usedBps += event.u.switching.next->getBandwidth();
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_STATE:
+        {
+            const ID &id = *event.u.buffering.id;
+            vlc_mutex_lock(&lock);
+            if(event.u.buffering.enabled)
+            {
+                if(streams.find(id) == streams.end())
+                {
+                    DynamicContext ctx;
+                    streams.insert(std::pair<ID, DynamicContext>(id, ctx));
+                }
+            }
+            else
+            {
+                std::map<ID, DynamicContext>::iterator it = streams.find(id);
+                if(it != streams.end())
+                    streams.erase(it);
+            }
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+        {
+            const ID &id = *event.u.buffering.id;
+            vlc_mutex_lock(&lock);
+            DynamicContext &ctx = streams[id];
+            if(event.u.buffering_level.minimum > 0)
+                ctx.buffering_min = event.u.buffering_level.minimum;
+            ctx.buffering_level = event.u.buffering_level.current;
+            if(event.u.buffering_level.target > ctx.buffering_min)
+                ctx.buffering_target = event.u.buffering_level.target;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::SEGMENT_CHANGE:
+        {
+            const ID &id = *event.u.segment.id;
+            vlc_mutex_lock(&lock);
+            DynamicContext &ctx = streams[id];
+            ctx.last_duration = event.u.segment.duration;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    default:
+            break;
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * DynamicAdaptationLogic.hpp
+ *****************************************************************************
+ * Copyright (C) 2021 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef DYNAMICADAPTATIONLOGIC_HPP
+#define DYNAMICADAPTATIONLOGIC_HPP
+
+#include "AbstractAdaptationLogic.h"
+#include "Representationselectors.hpp"
+#include "../tools/MovingAverage.hpp"
+#include <map>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        class DynamicContext
+        {
+            friend class DynamicAdaptationLogic;
+
+            public:
+                DynamicContext();
+
+            private:
+                vlc_tick_t buffering_min;
+                vlc_tick_t buffering_level;
+                vlc_tick_t buffering_target;
+                vlc_tick_t last_duration;
+                vlc_tick_t request_latency;
+                unsigned last_download_rate;
+                bool b_bola; /* steady state */
+                MovingAverage<unsigned> average;
+                MovingAverage<vlc_tick_t> latency_average;
+        };
+
+        class DynamicAdaptationLogic : public AbstractAdaptationLogic
+        {
+            public:
+                DynamicAdaptationLogic(vlc_object_t *);
+                virtual ~DynamicAdaptationLogic();
+
+                virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
+                virtual void                updateDownloadRate     (const ID &, size_t, vlc_tick_t); /* reimpl */
+                virtual void                updateRequestLatency   (const ID &, vlc_tick_t); /* reimpl */
+                virtual void                trackerEvent           (const SegmentTrackerEvent &); /* reimpl */
+
+            private:
+                BaseRepresentation *        getThroughputRepresentation(BaseAdaptationSet *,
+                                                                        RepresentationSelector &,
+                                                                        const DynamicContext &, unsigned);
+                BaseRepresentation *        getBolaRepresentation(BaseAdaptationSet *,
+                                                                  RepresentationSelector &,
+                                                                  const DynamicContext &,
+                                                                  BaseRepresentation *, unsigned);
+                unsigned                    getAvailableBw(unsigned, const BaseRepresentation *) const;
+                unsigned                    getMaxCurrentBw() const;
+                std::map<adaptive::ID, DynamicContext> streams;
+                unsigned                    currentBps;
+                unsigned                    usedBps;
+                vlc_mutex_t                 lock;
+        };
+    }
+}
+
+#endif // DYNAMICADAPTATIONLOGIC_HPP
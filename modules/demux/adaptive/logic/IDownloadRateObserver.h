@@ -35,6 +35,8 @@ namespace adaptive
     {
         public:
             virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t) = 0;
+            /* time from request to response, reported before the download rate */
+            virtual void updateRequestLatency(const ID &, vlc_tick_t) {}
             virtual ~IDownloadRateObserver(){}
     };
 }
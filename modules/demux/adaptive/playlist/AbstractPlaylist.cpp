@@ -46,7 +46,13 @@ AbstractPlaylist::AbstractPlaylist (vlc_object_t *p_object_) :
     minBufferTime = 0;
     timeShiftBufferDepth.Set( 0 );
     suggestedPresentationDelay.Set( 0 );
+    targetLatency.Set( 0 );
+    minLatency.Set( 0 );
+    maxLatency.Set( 0 );
+    minPlaybackRate.Set( 1.0f );
+    maxPlaybackRate.Set( 1.0f );
     b_needsUpdates = true;
+    b_lowLatency = false;
 }
 
 AbstractPlaylist::~AbstractPlaylist()
@@ -87,6 +93,9 @@ void AbstractPlaylist::setMinBuffering( vlc_tick_t min )
 
 vlc_tick_t AbstractPlaylist::getMinBuffering() const
 {
+    /* Low latency playback can't buffer more than the live edge distance */
+    if(b_lowLatency)
+        return std::max(minBufferTime, VLC_TICK_FROM_MS(500));
     return std::max(minBufferTime, VLC_TICK_FROM_SEC(6));
 }
 
@@ -96,6 +105,30 @@ vlc_tick_t AbstractPlaylist::getMaxBuffering() const
     return std::max(minbuf, VLC_TICK_FROM_SEC(60));
 }
 
+void AbstractPlaylist::setLowLatency( bool b )
+{
+    b_lowLatency = b;
+}
+
+bool AbstractPlaylist::isLowLatency() const
+{
+    return b_lowLatency;
+}
+
+std::vector<std::string> AbstractPlaylist::getBaseUrls() const
+{
+    std::vector<std::string> urls;
+    std::vector<std::string>::const_iterator it;
+    for(it = baseUrls.begin(); it != baseUrls.end(); ++it)
+    {
+        Url url(*it);
+        if( !url.hasScheme() && !playlistUrl.empty() )
+            url.prepend( Url(playlistUrl) );
+        urls.push_back(url.toString());
+    }
+    return urls;
+}
+
 Url AbstractPlaylist::getUrlSegment() const
 {
     Url ret;
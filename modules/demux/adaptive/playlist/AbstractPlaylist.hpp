@@ -45,6 +45,8 @@ namespace adaptive
                 void                            setMinBuffering( vlc_tick_t );
                 vlc_tick_t                      getMinBuffering() const;
                 vlc_tick_t                      getMaxBuffering() const;
+                void                            setLowLatency( bool );
+                bool                            isLowLatency() const;
                 virtual void                    debug() = 0;
 
                 void    addPeriod               (BasePeriod *period);
@@ -52,6 +54,7 @@ namespace adaptive
                 void    setPlaylistUrl          (const std::string &);
 
                 virtual Url         getUrlSegment() const; /* impl */
+                std::vector<std::string> getBaseUrls() const;
                 vlc_object_t *      getVLCObject()  const;
 
                 virtual const std::vector<BasePeriod *>& getPeriods();
@@ -69,6 +72,11 @@ namespace adaptive
                 Property<vlc_tick_t>                   maxSegmentDuration;
                 Property<vlc_tick_t>                   timeShiftBufferDepth;
                 Property<vlc_tick_t>                   suggestedPresentationDelay;
+                Property<vlc_tick_t>                   targetLatency;
+                Property<vlc_tick_t>                   minLatency;
+                Property<vlc_tick_t>                   maxLatency;
+                Property<float>                     minPlaybackRate;
+                Property<float>                     maxPlaybackRate;
 
             protected:
                 vlc_object_t                       *p_object;
@@ -78,6 +86,7 @@ namespace adaptive
                 std::string                         type;
                 vlc_tick_t                          minBufferTime;
                 bool                                b_needsUpdates;
+                bool                                b_lowLatency;
         };
     }
 }
@@ -34,6 +34,11 @@
 #include "../http/BytesRange.hpp"
 #include "../http/HTTPConnectionManager.h"
 #include "../http/Downloader.hpp"
+#include "../http/SegmentCache.hpp"
+#include "../SharedResources.hpp"
+
+#include <vlc_block.h>
+
 #include <cassert>
 
 using namespace adaptive::http;
@@ -82,12 +87,66 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, AbstractConnectionManager
                                 size_t index, BaseRepresentation *rep)
 {
     const std::string url = getUrlSegment().toString(index, rep);
-    HTTPChunkBufferedSource *source = new (std::nothrow) HTTPChunkBufferedSource(url, connManager,
+    const BytesRange range = (startByte != endByte) ? BytesRange(startByte, endByte)
+                                                     : BytesRange();
+
+    SegmentCache *cache = res ? res->getSegmentCache() : NULL;
+    if( cache )
+    {
+        std::string contentType;
+        block_t *p_data = cache->get(url, range, &contentType);
+        if( p_data )
+        {
+            CachedChunkSource *cached = new (std::nothrow) CachedChunkSource(p_data, contentType);
+            if( !cached )
+            {
+                block_Release(p_data);
+                return NULL;
+            }
+            cached->setBytesRange(range);
+            SegmentChunk *chunk = createChunk(cached, rep);
+            if(!chunk)
+            {
+                delete cached;
+                return NULL;
+            }
+            chunk->discontinuity = discontinuity;
+            if(!prepareChunk(res, chunk, rep))
+            {
+                delete chunk;
+                return NULL;
+            }
+            return chunk;
+        }
+    }
+
+    /* Alternate base URLs (CDNs): move the request to the best scoring one */
+    std::string requesturl = url;
+    const std::vector<std::string> pathways = rep->getPlaylist()->getBaseUrls();
+    for(size_t i=0; pathways.size() > 1 && i<pathways.size(); i++)
+    {
+        if(!pathways[i].empty() && url.compare(0, pathways[i].size(), pathways[i]) == 0)
+        {
+            size_t best = connManager->selectPathway(pathways, i);
+            if(best != i)
+                requesturl = pathways[best] + url.substr(pathways[i].size());
+            break;
+        }
+    }
+
+    HTTPChunkBufferedSource *source = new (std::nothrow) HTTPChunkBufferedSource(requesturl, connManager,
                                                                                  rep->getAdaptationSet()->getID());
     if( source )
     {
-        if(startByte != endByte)
-            source->setBytesRange(BytesRange(startByte, endByte));
+        if(range.isValid())
+            source->setBytesRange(range);
+        /* init segments are needed again on every representation switch */
+        if(cache)
+            source->setCache(cache, url, getClassId() == InitSegment::CLASSID_INITSEGMENT);
+        /* chunked CMAF: hand out fragments as they are received */
+        if(rep->getPlaylist()->isLowLatency() &&
+           rep->getStreamFormat() == StreamFormat(StreamFormat::MP4))
+            source->setBoxAligned(true);
 
         SegmentChunk *chunk = createChunk(source, rep);
         if(chunk)
@@ -195,10 +195,13 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
         const SegmentTimeline *timeline = mediaSegmentTemplate->inheritSegmentTimeline();
         if( timeline )
         {
+            const bool b_lowlatency = getPlaylist()->isLowLatency() &&
+                                      getPlaylist()->suggestedPresentationDelay.Get();
             start = timeline->minElementNumber();
             end = timeline->maxElementNumber();
             /* Try to never buffer up to really end */
-            end = end - std::min(end - start, OFFSET_FROM_END);
+            if( !b_lowlatency )
+                end = end - std::min(end - start, OFFSET_FROM_END);
             stime_t endtime, duration;
 
             bool b_ret = timeline->getScaledPlaybackTimeDurationBySegmentNumber( end, &endtime, &duration );
@@ -209,6 +212,9 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
             }
 
             vlc_tick_t fromend = std::max( i_max_buffering, getPlaylist()->suggestedPresentationDelay.Get() );
+            /* Low latency playlists provide the exact distance to the live edge */
+            if( b_lowlatency )
+                fromend = getPlaylist()->suggestedPresentationDelay.Get();
             if( endtime + duration <= timescale.ToScaled( fromend ) )
                 return start;
 
@@ -237,6 +243,14 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
             else
                 start = end - count;
 
+            /* Low latency playlists provide the exact distance to the live edge */
+            if( getPlaylist()->isLowLatency() && getPlaylist()->suggestedPresentationDelay.Get() )
+            {
+                const uint64_t llcount = timescale.ToScaled( getPlaylist()->suggestedPresentationDelay.Get() ) /
+                                         mediaSegmentTemplate->duration.Get();
+                return ( end - start > llcount ) ? end - llcount : start;
+            }
+
             uint64_t bufcount = ( OFFSET_FROM_END + timescale.ToScaled(i_max_buffering) /
                                   mediaSegmentTemplate->duration.Get() );
             /* Ensure we always pick > start # of availability window as this segment might no longer be avail */
@@ -253,11 +267,16 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
 
         const ISegment *back = list.back();
         vlc_tick_t fromend = std::max( i_max_buffering, getPlaylist()->suggestedPresentationDelay.Get() );
+        /* Low latency playlists provide the exact distance to the live edge */
+        if( getPlaylist()->isLowLatency() && getPlaylist()->suggestedPresentationDelay.Get() )
+            fromend = getPlaylist()->suggestedPresentationDelay.Get();
         stime_t bufferingstart = back->startTime.Get() + back->duration.Get() - timescale.ToScaled( fromend );
 
         uint64_t number;
         if( !segmentList->getSegmentNumberByScaledTime( bufferingstart, &number ) )
             return list.front()->getSequenceNumber();
+        if( getPlaylist()->isLowLatency() )
+            return number;
         if( number > list.front()->getSequenceNumber() + OFFSET_FROM_END )
             number -= OFFSET_FROM_END;
         else
@@ -287,6 +306,24 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
         return def;
 }
 
+/* Playlist time of the media being produced at wall clock time now */
+bool SegmentInformation::getLiveEdgeTime(vlc_tick_t now, vlc_tick_t *edge) const
+{
+    if( mediaSegmentTemplate && mediaSegmentTemplate->duration.Get() &&
+        !mediaSegmentTemplate->inheritSegmentTimeline() )
+    {
+        const Timescale timescale = mediaSegmentTemplate->inheritTimescale();
+        const vlc_tick_t streamstart =
+                vlc_tick_from_sec(getPlaylist()->availabilityStartTime.Get()) + getPeriodStart();
+        *edge = timescale.ToTime(mediaSegmentTemplate->inheritStartNumber() *
+                                 mediaSegmentTemplate->duration.Get()) + now - streamstart;
+        return true;
+    }
+
+    vlc_tick_t rangeBegin, rangeLength;
+    return getMediaPlaybackRange(&rangeBegin, edge, &rangeLength);
+}
+
 bool SegmentInformation::getMediaPlaybackRange(vlc_tick_t *rangeBegin,
                                                vlc_tick_t *rangeEnd,
                                                vlc_tick_t *rangeLength) const
@@ -85,6 +85,7 @@ namespace adaptive
                 uint64_t getLiveSegmentNumberByTime(uint64_t, vlc_tick_t) const;
                 uint64_t getLiveStartSegmentNumber(uint64_t) const;
                 bool     getMediaPlaybackRange(vlc_tick_t *, vlc_tick_t *, vlc_tick_t *) const;
+                bool     getLiveEdgeTime(vlc_tick_t, vlc_tick_t *) const;
                 virtual void updateWith(SegmentInformation *);
                 virtual void mergeWithTimeline(SegmentTimeline *); /* ! don't use with global merge */
                 virtual void pruneBySegmentNumber(uint64_t);
@@ -53,6 +53,7 @@ MediaSegmentTemplate::MediaSegmentTemplate( SegmentInformation *parent ) :
     debugName = "SegmentTemplate";
     classId = Segment::CLASSID_SEGMENT;
     startNumber = std::numeric_limits<uint64_t>::max();
+    availabilityTimeOffset = 0;
     segmentTimeline = NULL;
     initialisationSegment.Set( NULL );
     templated = true;
@@ -69,14 +70,20 @@ void MediaSegmentTemplate::updateWith(MediaSegmentTemplate *updated)
     SegmentTimeline *timeline = segmentTimeline;
     if(timeline && updated->segmentTimeline)
     {
+        const SegmentTimeline *updatedTimeline = updated->segmentTimeline;
+        const uint64_t windowstart = updatedTimeline->minElementNumber();
+        const stime_t windowstarttime = updatedTimeline->getScaledPlaybackTimeByElementNumber(windowstart);
+        const bool b_window = updatedTimeline->maxElementNumber() > windowstart;
+
         timeline->updateWith(*updated->segmentTimeline);
-        /*if(prunebarrier)
+
+        /* Prune in place what left the updated window,
+           so long running live timelines don't keep growing */
+        if(b_window)
         {
-            const Timescale timescale = timeline->inheritTimescale();
-            const uint64_t number =
-                    timeline->getElementNumberByScaledPlaybackTime(timescale.ToScaled(prunebarrier));
+            const uint64_t number = timeline->getElementNumberByScaledPlaybackTime(windowstarttime);
             timeline->pruneBySequenceNumber(number);
-        }*/
+        }
     }
 }
 
@@ -135,6 +142,19 @@ stime_t MediaSegmentTemplate::inheritDuration() const
     return 0;
 }
 
+vlc_tick_t MediaSegmentTemplate::inheritAvailabilityTimeOffset() const
+{
+    const SegmentInformation *ulevel = parentSegmentInformation ? parentSegmentInformation
+                                                                : NULL;
+    for( ; ulevel ; ulevel = ulevel->parent )
+    {
+        if( ulevel->mediaSegmentTemplate &&
+            ulevel->mediaSegmentTemplate->availabilityTimeOffset > 0 )
+            return ulevel->mediaSegmentTemplate->availabilityTimeOffset;
+    }
+    return 0;
+}
+
 SegmentTimeline * MediaSegmentTemplate::inheritSegmentTimeline() const
 {
     const SegmentInformation *ulevel = parentSegmentInformation ? parentSegmentInformation
@@ -160,7 +180,13 @@ uint64_t MediaSegmentTemplate::getLiveTemplateNumber(vlc_tick_t playbacktime) co
         time_t streamstart = parentSegmentInformation->getPlaylist()->availabilityStartTime.Get();
         streamstart += parentSegmentInformation->getPeriodStart();
         stime_t elapsed = timescale.ToScaled(playbacktime - vlc_tick_from_sec(streamstart));
-        number += elapsed / dur;
+        /* chunked segments are published availabilityTimeOffset before their end,
+           so return the last one which has started being available */
+        const vlc_tick_t ato = inheritAvailabilityTimeOffset();
+        if(ato > 0)
+            elapsed += timescale.ToScaled(ato) - dur;
+        if(elapsed > 0)
+            number += elapsed / dur;
     }
 
     return number;
@@ -191,6 +217,11 @@ void MediaSegmentTemplate::setSegmentTimeline( SegmentTimeline *v )
     segmentTimeline = v;
 }
 
+void MediaSegmentTemplate::setAvailabilityTimeOffset( vlc_tick_t v )
+{
+    availabilityTimeOffset = v;
+}
+
 void MediaSegmentTemplate::debug(vlc_object_t *obj, int indent) const
 {
     Segment::debug(obj, indent);
@@ -209,11 +209,9 @@ void SegmentTimeline::updateWith(SegmentTimeline &other)
 {
     if(elements.empty())
     {
-        while(other.elements.size())
-        {
-            elements.push_back(other.elements.front());
-            other.elements.pop_front();
-        }
+        elements.swap(other.elements);
+        totalLength = other.totalLength;
+        other.totalLength = 0;
         return;
     }
 
@@ -243,6 +241,7 @@ void SegmentTimeline::updateWith(SegmentTimeline &other)
             last = el;
         }
     }
+    other.totalLength = 0;
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
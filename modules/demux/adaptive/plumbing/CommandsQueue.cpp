@@ -41,9 +41,12 @@ enum
     ES_OUT_PRIVATE_COMMAND_DISCONTINUITY
 };
 
+#define SEND_POOL_MAX 512
+
 AbstractCommand::AbstractCommand( int type_ )
 {
     type = type_;
+    p_next = NULL;
 }
 
 AbstractCommand::~AbstractCommand()
@@ -181,12 +184,151 @@ void EsOutMetaCommand::Execute( es_out_t *out )
     es_out_Control( out, ES_OUT_SET_GROUP_META, group, p_meta );
 }
 
+/*
+ * Commands list
+ */
+
+CommandsList::CommandsList()
+{
+    p_head = p_tail = NULL;
+}
+
+bool CommandsList::empty() const
+{
+    return p_head == NULL;
+}
+
+AbstractCommand * CommandsList::front() const
+{
+    return p_head;
+}
+
+AbstractCommand * CommandsList::next( const AbstractCommand *command )
+{
+    return command->p_next;
+}
+
+void CommandsList::push_back( AbstractCommand *command )
+{
+    command->p_next = NULL;
+    if( p_tail )
+        p_tail->p_next = command;
+    else
+        p_head = command;
+    p_tail = command;
+}
+
+AbstractCommand * CommandsList::pop_front()
+{
+    AbstractCommand *command = p_head;
+    if( command )
+    {
+        p_head = command->p_next;
+        if( !p_head )
+            p_tail = NULL;
+        command->p_next = NULL;
+    }
+    return command;
+}
+
+void CommandsList::splice( CommandsList &other )
+{
+    if( !other.p_head )
+        return;
+    if( p_tail )
+        p_tail->p_next = other.p_head;
+    else
+        p_head = other.p_head;
+    p_tail = other.p_tail;
+    other.p_head = other.p_tail = NULL;
+}
+
+AbstractCommand * CommandsList::merge( AbstractCommand *a, AbstractCommand *b,
+                                       bool (*comp)( const AbstractCommand *,
+                                                     const AbstractCommand * ) )
+{
+    AbstractCommand *head = NULL;
+    AbstractCommand **pp_next = &head;
+    while( a && b )
+    {
+        /* same rule as std::list::merge: takes from b only if before a */
+        if( comp( b, a ) )
+        {
+            *pp_next = b;
+            b = b->p_next;
+        }
+        else
+        {
+            *pp_next = a;
+            a = a->p_next;
+        }
+        pp_next = &(*pp_next)->p_next;
+    }
+    *pp_next = a ? a : b;
+    return head;
+}
+
+void CommandsList::sort( bool (*comp)( const AbstractCommand *, const AbstractCommand * ) )
+{
+    if( p_head == p_tail )
+        return;
+
+    /* Bottom-up merge sort: runs[i] holds a sorted run of 2^i elements */
+    AbstractCommand *runs[64] = { NULL };
+    unsigned maxrun = 0;
+    while( p_head )
+    {
+        AbstractCommand *carry = p_head;
+        p_head = p_head->p_next;
+        carry->p_next = NULL;
+
+        unsigned i = 0;
+        for( ; i < 64 && runs[i]; i++ )
+        {
+            carry = merge( runs[i], carry, comp );
+            runs[i] = NULL;
+        }
+        if( i == 64 )
+            i = 63;
+        runs[i] = carry;
+        if( i >= maxrun )
+            maxrun = i + 1;
+    }
+
+    for( unsigned i = 0; i < maxrun; i++ )
+        if( runs[i] )
+            p_head = merge( runs[i], p_head, comp );
+
+    p_tail = p_head;
+    while( p_tail->p_next )
+        p_tail = p_tail->p_next;
+}
+
 /*
  * Commands Default Factory
  */
 
+CommandsFactory::CommandsFactory()
+{
+    sendpoolsize = 0;
+}
+
+CommandsFactory::~CommandsFactory()
+{
+    while( !sendpool.empty() )
+        delete sendpool.pop_front();
+}
+
 EsOutSendCommand * CommandsFactory::createEsOutSendCommand( FakeESOutID *id, block_t *p_block ) const
 {
+    if( !sendpool.empty() )
+    {
+        EsOutSendCommand *command = static_cast<EsOutSendCommand *>( sendpool.pop_front() );
+        sendpoolsize--;
+        command->p_fakeid = id;
+        command->p_block = p_block;
+        return command;
+    }
     return new (std::nothrow) EsOutSendCommand( id, p_block );
 }
 
@@ -226,14 +368,32 @@ EsOutMetaCommand * CommandsFactory::createEsOutMetaCommand( int group, const vlc
     return NULL;
 }
 
+void CommandsFactory::releaseCommand( AbstractCommand *command ) const
+{
+    /* Send commands are the bulk of the queue, recycle them */
+    if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND &&
+        sendpoolsize < SEND_POOL_MAX )
+    {
+        EsOutSendCommand *sendcommand = static_cast<EsOutSendCommand *>( command );
+        if( sendcommand->p_block )
+        {
+            block_Release( sendcommand->p_block );
+            sendcommand->p_block = NULL;
+        }
+        sendpool.push_back( command );
+        sendpoolsize++;
+    }
+    else delete command;
+}
+
 /*
  * Commands Queue management
  */
 #if 0
 /* For queue printing/debugging */
-std::ostream& operator<<(std::ostream& ostr, const std::list<AbstractCommand *>& list)
+std::ostream& operator<<(std::ostream& ostr, const CommandsList& list)
 {
-    for (auto &i : list) {
+    for (const AbstractCommand *i = list.front(); i; i = CommandsList::next(i)) {
         ostr << "[" << i->getType() << "]" << SEC_FROM_VLC_TICK(i->getTime()) << " ";
     }
     return ostr;
@@ -256,7 +416,7 @@ CommandsQueue::~CommandsQueue()
     delete commandsFactory;
 }
 
-static bool compareCommands( AbstractCommand *a, AbstractCommand *b )
+static bool compareCommands( const AbstractCommand *a, const AbstractCommand *b )
 {
     if(a->getTime() == b->getTime())
     {
@@ -274,7 +434,7 @@ void CommandsQueue::Schedule( AbstractCommand *command )
 {
     if( b_drop )
     {
-        delete command;
+        commandsFactory->releaseCommand( command );
     }
     else if( command->getType() == ES_OUT_SET_GROUP_PCR )
     {
@@ -306,11 +466,11 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
        ex: for a target time of 2, you must dequeue <= 2 until >= PCR2
        A0,A1,A2,B0,PCR0,B1,B2,PCR2,B3,A3,PCR3
     */
-    std::list<AbstractCommand *> output;
-    std::list<AbstractCommand *> in;
+    CommandsList output;
+    CommandsList in;
 
 
-    in.splice( in.end(), commands );
+    in.splice( commands );
 
     while( !in.empty() )
     {
@@ -358,7 +518,7 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
     }
 
     /* push remaining ones if broke above */
-    commands.splice( commands.end(), in );
+    commands.splice( in );
 
     if(commands.empty() && b_draining)
         b_draining = false;
@@ -366,8 +526,7 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
     /* Now execute our selected commands */
     while( !output.empty() )
     {
-        AbstractCommand *command = output.front();
-        output.pop_front();
+        AbstractCommand *command = output.pop_front();
 
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND )
         {
@@ -377,7 +536,7 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
         }
 
         command->Execute( out );
-        delete command;
+        commandsFactory->releaseCommand( command );
     }
     pcr = lastdts; /* Warn! no PCR update/lock release until execution */
 
@@ -389,7 +548,7 @@ void CommandsQueue::LockedCommit()
 {
     /* reorder all blocks by time between 2 PCR and merge with main list */
     incoming.sort( compareCommands );
-    commands.splice( commands.end(), incoming );
+    commands.splice( incoming );
 }
 
 void CommandsQueue::Commit()
@@ -399,12 +558,9 @@ void CommandsQueue::Commit()
 
 void CommandsQueue::Abort( bool b_reset )
 {
-    commands.splice( commands.end(), incoming );
+    commands.splice( incoming );
     while( !commands.empty() )
-    {
-        delete commands.front();
-        commands.pop_front();
-    }
+        commandsFactory->releaseCommand( commands.pop_front() );
 
     if( b_reset )
     {
@@ -466,11 +622,11 @@ vlc_tick_t CommandsQueue::getBufferingLevel() const
 
 vlc_tick_t CommandsQueue::getFirstDTS() const
 {
-    std::list<AbstractCommand *>::const_iterator it;
     vlc_tick_t i_firstdts = pcr;
-    for( it = commands.begin(); it != commands.end(); ++it )
+    for( const AbstractCommand *command = commands.front(); command;
+         command = CommandsList::next( command ) )
     {
-        const vlc_tick_t i_dts = (*it)->getTime();
+        const vlc_tick_t i_dts = command->getTime();
         if( i_dts != VLC_TICK_INVALID )
         {
             if( i_dts < i_firstdts || i_firstdts == VLC_TICK_INVALID )
@@ -24,7 +24,6 @@
 #include <vlc_es.h>
 
 #include <atomic>
-#include <list>
 
 namespace adaptive
 {
@@ -34,6 +33,7 @@ namespace adaptive
     class AbstractCommand
     {
         friend class CommandsFactory;
+        friend class CommandsList;
         public:
             virtual ~AbstractCommand();
             virtual void Execute( es_out_t * ) = 0;
@@ -43,6 +43,30 @@ namespace adaptive
         protected:
             AbstractCommand( int );
             int type;
+
+        private:
+            AbstractCommand *p_next;
+    };
+
+    /* Intrusive FIFO, so queuing and moving commands never allocates */
+    class CommandsList
+    {
+        public:
+            CommandsList();
+            bool empty() const;
+            AbstractCommand * front() const;
+            static AbstractCommand * next( const AbstractCommand * );
+            void push_back( AbstractCommand * );
+            AbstractCommand * pop_front();
+            void splice( CommandsList & ); /* appends and empties the other list */
+            void sort( bool (*)( const AbstractCommand *, const AbstractCommand * ) );
+
+        private:
+            static AbstractCommand * merge( AbstractCommand *, AbstractCommand *,
+                                            bool (*)( const AbstractCommand *,
+                                                      const AbstractCommand * ) );
+            AbstractCommand *p_head;
+            AbstractCommand *p_tail;
     };
 
     class AbstractFakeEsCommand : public AbstractCommand
@@ -137,7 +161,8 @@ namespace adaptive
     class CommandsFactory
     {
         public:
-            virtual ~CommandsFactory() {}
+            CommandsFactory();
+            virtual ~CommandsFactory();
             virtual EsOutSendCommand * createEsOutSendCommand( FakeESOutID *, block_t * ) const;
             virtual EsOutDelCommand * createEsOutDelCommand( FakeESOutID * ) const;
             virtual EsOutAddCommand * createEsOutAddCommand( FakeESOutID * ) const;
@@ -145,6 +170,13 @@ namespace adaptive
             virtual EsOutControlResetPCRCommand * creatEsOutControlResetPCRCommand() const;
             virtual EsOutDestroyCommand * createEsOutDestroyCommand() const;
             virtual EsOutMetaCommand * createEsOutMetaCommand( int, const vlc_meta_t * ) const;
+            virtual void releaseCommand( AbstractCommand * ) const;
+
+        private:
+            /* Recycled send commands, protected by the FakeESOut lock
+             * like the queue itself */
+            mutable CommandsList sendpool;
+            mutable unsigned sendpoolsize;
     };
 
     /* Queuing for doing all the stuff in order */
@@ -173,8 +205,8 @@ namespace adaptive
             CommandsFactory *commandsFactory;
             void LockedCommit();
             void LockedSetDraining();
-            std::list<AbstractCommand *> incoming;
-            std::list<AbstractCommand *> commands;
+            CommandsList incoming;
+            CommandsList commands;
             vlc_tick_t bufferinglevel;
             vlc_tick_t pcr;
             bool b_draining;
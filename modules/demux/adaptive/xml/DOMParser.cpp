@@ -49,7 +49,6 @@ DOMParser::DOMParser    (stream_t *stream) :
 
 DOMParser::~DOMParser   ()
 {
-    delete this->root;
     if(this->vlc_reader)
         xml_ReaderDelete(this->vlc_reader);
 }
@@ -82,7 +81,7 @@ bool DOMParser::reset(stream_t *s)
     stream = s;
     if(!vlc_reader)
         return true;
-    delete root;
+    nodes.clear();
     root = NULL;
 
     xml_ReaderDelete(vlc_reader);
@@ -103,7 +102,7 @@ Node* DOMParser::processNode(bool b_strict)
             case XML_READER_STARTELEM:
             {
                 bool empty = xml_ReaderIsEmptyElement(vlc_reader);
-                Node *node = new (std::nothrow) Node();
+                Node *node = nodes.create();
                 if(node)
                 {
                     if(!lifo.empty())
@@ -148,10 +147,7 @@ Node* DOMParser::processNode(bool b_strict)
     Node *node = (!lifo.empty()) ? lifo.top() : NULL;
 
     if(b_strict && node)
-    {
-        delete node;
-        return NULL;
-    }
+        return NULL; /* released with the arena */
 
     return node;
 }
@@ -163,9 +159,7 @@ void    DOMParser::addAttributesToNode      (Node *node)
 
     while((attrName = xml_ReaderNextAttr(this->vlc_reader, &attrValue)) != NULL)
     {
-        std::string key     = attrName;
-        std::string value   = attrValue;
-        node->addAttribute(key, value);
+        node->addAttribute(attrName, attrValue);
     }
 }
 void    DOMParser::print                    (Node *node, int offset)
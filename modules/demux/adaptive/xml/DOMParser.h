@@ -48,6 +48,7 @@ namespace adaptive
 
             private:
                 Node                *root;
+                NodeArena           nodes;
                 stream_t            *stream;
 
                 xml_reader_t        *vlc_reader;
@@ -28,6 +28,7 @@
 #include "Node.h"
 
 #include <cassert>
+#include <new>
 #include <vlc_common.h>
 #include <vlc_xml.h>
 
@@ -41,8 +42,6 @@ Node::Node() :
 }
 Node::~Node ()
 {
-    for(size_t i = 0; i < this->subNodes.size(); i++)
-        delete(this->subNodes.at(i));
 }
 
 const std::vector<Node*>&           Node::getSubNodes           () const
@@ -133,3 +132,50 @@ std::vector<std::string> Node::toString(int indent) const
     }
     return ret;
 }
+
+NodeArena::NodeArena() :
+    used( ChunkSize )
+{
+}
+
+NodeArena::~NodeArena()
+{
+    clear();
+}
+
+Node * NodeArena::create()
+{
+    if(used == ChunkSize)
+    {
+        void *chunk = ::operator new(ChunkSize * sizeof(Node), std::nothrow);
+        if(!chunk)
+            return NULL;
+        try
+        {
+            chunks.push_back(static_cast<Node *>(chunk));
+        }
+        catch(const std::bad_alloc &)
+        {
+            ::operator delete(chunk);
+            return NULL;
+        }
+        used = 0;
+    }
+    return new (&chunks.back()[used++]) Node();
+}
+
+void NodeArena::clear()
+{
+    for(size_t i = chunks.size(); i > 0; i--)
+    {
+        Node *chunk = chunks[i - 1];
+        size_t count = ChunkSize;
+        if(i == chunks.size())
+            count = used;
+        while(count > 0)
+            chunk[--count].~Node();
+        ::operator delete(chunk);
+    }
+    chunks.clear();
+    used = ChunkSize;
+}
@@ -63,6 +63,26 @@ namespace adaptive
                 int                                 type;
 
         };
+
+        /* Allocates the nodes of a tree in chunks, and releases them all at
+         * once: nodes do not own their sub nodes. */
+        class NodeArena
+        {
+            public:
+                NodeArena           ();
+                ~NodeArena          ();
+
+                Node *              create      ();
+                void                clear       ();
+
+            private:
+                NodeArena           (const NodeArena &) = delete;
+                NodeArena &         operator=   (const NodeArena &) = delete;
+
+                static const size_t                 ChunkSize = 64;
+                std::vector<Node *>                 chunks;
+                size_t                              used; /* in the last chunk */
+        };
     }
 }
 
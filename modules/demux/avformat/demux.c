@@ -79,9 +79,17 @@ typedef struct
     input_title_t *p_title;
     int i_seekpoint;
     unsigned i_update;
+
+    /* While opening, reads are served from the stream peek buffer, so that
+     * the next demux does not read the stream again if this one fails. */
+    bool     b_peeking;
+    uint64_t i_peek_pos;
 } demux_sys_t;
 
-#define AVFORMAT_IOBUFFER_SIZE 32768  /* FIXME */
+#define AVFORMAT_IOBUFFER_SIZE      32768
+/* Slow accesses (network...) deliver larger chunks per read */
+#define AVFORMAT_IOBUFFER_SIZE_SLOW 131072
+#define AVFORMAT_PEEK_MAX           (512 << 10)
 
 /*****************************************************************************
  * Local prototypes
@@ -91,6 +99,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args );
 
 static int IORead( void *opaque, uint8_t *buf, int buf_size );
 static int64_t IOSeek( void *opaque, int64_t offset, int whence );
+static int IOEndPeek( demux_t *p_demux );
 
 static block_t *BuildSsaFrame( const AVPacket *p_pkt, unsigned i_order );
 static void UpdateSeekPoint( demux_t *p_demux, vlc_tick_t i_time );
@@ -321,6 +330,7 @@ int avformat_OpenDemux( vlc_object_t *p_this )
     AVInputFormat *fmt = NULL;
     vlc_tick_t    i_start_time = VLC_TICK_INVALID;
     bool          b_can_seek;
+    bool          b_can_seek_fast;
     const char    *psz_url;
     int           error;
 
@@ -333,6 +343,7 @@ int avformat_OpenDemux( vlc_object_t *p_this )
         return VLC_EGENERIC;
 
     vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &b_can_seek );
+    vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_can_seek_fast );
 
     /* Fill p_demux fields */
     p_demux->pf_demux = Demux;
@@ -349,9 +360,13 @@ int avformat_OpenDemux( vlc_object_t *p_this )
     p_sys->p_title = NULL;
     p_sys->i_seekpoint = 0;
     p_sys->i_update = 0;
+    p_sys->b_peeking = true;
+    p_sys->i_peek_pos = 0;
 
     /* Create I/O wrapper */
-    unsigned char * p_io_buffer = av_malloc( AVFORMAT_IOBUFFER_SIZE );
+    const int i_io_buffer = b_can_seek_fast ? AVFORMAT_IOBUFFER_SIZE
+                                            : AVFORMAT_IOBUFFER_SIZE_SLOW;
+    unsigned char * p_io_buffer = av_malloc( i_io_buffer );
     if( !p_io_buffer )
     {
         avformat_CloseDemux( p_this );
@@ -367,7 +382,7 @@ int avformat_OpenDemux( vlc_object_t *p_this )
     }
 
     AVIOContext *pb = p_sys->ic->pb = avio_alloc_context( p_io_buffer,
-        AVFORMAT_IOBUFFER_SIZE, 0, p_demux, IORead, NULL, IOSeek );
+        i_io_buffer, 0, p_demux, IORead, NULL, IOSeek );
     if( !pb )
     {
         av_free( p_io_buffer );
@@ -757,6 +772,7 @@ int avformat_OpenDemux( vlc_object_t *p_this )
         TAB_APPEND( p_sys->p_title->i_seekpoint, p_sys->p_title->seekpoint, s );
     }
 
+    IOEndPeek( p_demux );
     ResetTime( p_demux, 0 );
     return VLC_SUCCESS;
 }
@@ -791,6 +807,38 @@ void avformat_CloseDemux( vlc_object_t *p_this )
     free( p_sys );
 }
 
+typedef struct
+{
+    block_t self;
+    AVBufferRef *buf;
+} avformat_packet_t;
+
+static void PacketRelease( block_t *p_block )
+{
+    avformat_packet_t *p = container_of( p_block, avformat_packet_t, self );
+
+    av_buffer_unref( &p->buf );
+    free( p );
+}
+
+static const struct vlc_block_callbacks packet_cbs =
+{
+    PacketRelease,
+};
+
+/* Takes over the data reference of the packet, its properties are kept */
+static block_t *PacketWrap( AVPacket *p_pkt )
+{
+    avformat_packet_t *p = malloc( sizeof( *p ) );
+    if( unlikely(p == NULL) )
+        return NULL;
+
+    block_Init( &p->self, &packet_cbs, p_pkt->data, p_pkt->size );
+    p->buf = p_pkt->buf;
+    p_pkt->buf = NULL;
+    return &p->self;
+}
+
 /*****************************************************************************
  * Demux:
  *****************************************************************************/
@@ -845,6 +893,15 @@ static int Demux( demux_t *p_demux )
         memcpy( &p_frame->p_buffer[2], pkt.data, pkt.size );
         p_frame->p_buffer[p_frame->i_buffer - 1] = 0x3f;
     }
+    else if( pkt.buf != NULL && av_buffer_is_writable( pkt.buf ) )
+    {
+        /* The packet data is ours alone: hand it over as is */
+        if( ( p_frame = PacketWrap( &pkt ) ) == NULL )
+        {
+            av_packet_unref( &pkt );
+            return 0;
+        }
+    }
     else
     {
         if( ( p_frame = block_Alloc( pkt.size ) ) == NULL )
@@ -1269,10 +1326,51 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 /*****************************************************************************
  * I/O wrappers for libavformat
  *****************************************************************************/
+/* Consumes what was peeked so far: reads go to the stream from now on */
+static int IOEndPeek( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_peeking )
+        return 0;
+
+    p_sys->b_peeking = false;
+    if( p_sys->i_peek_pos > 0 &&
+        vlc_stream_Read( p_demux->s, NULL, p_sys->i_peek_pos )
+            != (ssize_t)p_sys->i_peek_pos )
+        return -1;
+    return 0;
+}
+
 static int IORead( void *opaque, uint8_t *buf, int buf_size )
 {
     demux_t *p_demux = opaque;
+    demux_sys_t *p_sys = p_demux->p_sys;
     if( buf_size < 0 ) return -1;
+
+    if( p_sys->b_peeking )
+    {
+        if( p_sys->i_peek_pos + buf_size <= AVFORMAT_PEEK_MAX )
+        {
+            const uint8_t *p_peek;
+            ssize_t i_peek = vlc_stream_Peek( p_demux->s, &p_peek,
+                                              p_sys->i_peek_pos + buf_size );
+            if( i_peek < 0 )
+                return -1;
+            if( (uint64_t)i_peek <= p_sys->i_peek_pos )
+                return 0;
+
+            i_peek -= p_sys->i_peek_pos;
+            memcpy( buf, p_peek + p_sys->i_peek_pos, i_peek );
+            p_sys->i_peek_pos += i_peek;
+            return i_peek;
+        }
+
+        /* Too much to keep around: not probing the header anymore */
+        if( IOEndPeek( p_demux ) )
+            return -1;
+    }
+
     int i_ret = vlc_stream_Read( p_demux->s, buf, buf_size );
     return i_ret >= 0 ? i_ret : -1;
 }
@@ -1280,8 +1378,11 @@ static int IORead( void *opaque, uint8_t *buf, int buf_size )
 static int64_t IOSeek( void *opaque, int64_t offset, int whence )
 {
     demux_t *p_demux = opaque;
+    demux_sys_t *p_sys = p_demux->p_sys;
     int64_t i_absolute;
     int64_t i_size = stream_Size( p_demux->s );
+    uint64_t i_pos = p_sys->b_peeking ? p_sys->i_peek_pos
+                                      : vlc_stream_Tell( p_demux->s );
 
 #ifdef AVFORMAT_DEBUG
     msg_Warn( p_demux, "IOSeek offset: %"PRId64", whence: %i", offset, whence );
@@ -1297,7 +1398,7 @@ static int64_t IOSeek( void *opaque, int64_t offset, int whence )
             i_absolute = (int64_t)offset;
             break;
         case SEEK_CUR:
-            i_absolute = vlc_stream_Tell( p_demux->s ) + (int64_t)offset;
+            i_absolute = i_pos + (int64_t)offset;
             break;
         case SEEK_END:
             i_absolute = i_size + (int64_t)offset;
@@ -1319,6 +1420,17 @@ static int64_t IOSeek( void *opaque, int64_t offset, int whence )
         return -1;
     }
 
+    if( p_sys->b_peeking )
+    {   /* Moving within the peek buffer */
+        if( i_absolute <= AVFORMAT_PEEK_MAX )
+        {
+            p_sys->i_peek_pos = i_absolute;
+            return i_absolute;
+        }
+        if( IOEndPeek( p_demux ) )
+            return -1;
+    }
+
     if( vlc_stream_Seek( p_demux->s, i_absolute ) )
     {
         msg_Warn( p_demux, "we were not allowed to seek, or EOF " );
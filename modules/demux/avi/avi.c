@@ -99,6 +99,8 @@ static char *FromACP( const char *str )
 #define IGNORE_ES DATA_ES
 #define READ_LENGTH                VLC_TICK_FROM_MS(25)
 #define READ_LENGTH_NONINTERLEAVED VLC_TICK_FROM_MS(1500)
+/* chunks indexed per demux call while the index is built */
+#define INDEX_CREATE_STEP          1024
 
 //#define AVI_DEBUG
 
@@ -185,6 +187,11 @@ typedef struct
     uint64_t i_movi_begin;
     uint64_t i_movi_lastchunk_pos;   /* XXX position of last valid chunk */
 
+    /* index built while playing */
+    bool     b_index_creating;
+    uint64_t i_index_create_pos;     /* next chunk header to parse */
+    uint64_t i_index_create_end;
+
     /* number of streams and information */
     unsigned int i_track;
     avi_track_t  **track;
@@ -219,6 +226,7 @@ static int AVI_PacketSearch   ( demux_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static void AVI_IndexCreateStep( demux_t *, unsigned );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -232,6 +240,8 @@ static void AVI_MetaLoad( demux_t *, avi_chunk_list_t *p_riff, avi_chunk_avih_t
  * Stream management
  *****************************************************************************/
 static int        AVI_TrackSeek  ( demux_t *, int, vlc_tick_t );
+static int        AVI_TrackGetKeyframe( avi_track_t *, vlc_tick_t,
+                                        vlc_tick_t *, unsigned * );
 static int        AVI_TrackStopFinishedStreams( demux_t *);
 
 /* Remarks:
@@ -708,7 +718,11 @@ aviindex:
     }
 
     /* *** movie length in vlc_tick_t *** */
-    p_sys->i_length = AVI_MovieGetLength( p_demux );
+    if( p_sys->b_index_creating ) /* until the index is complete */
+        p_sys->i_length = VLC_TICK_FROM_US( p_avih->i_totalframes *
+                                            p_avih->i_microsecperframe );
+    else
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
 
     /* Check the index completeness */
     unsigned int i_idx_totalframes = 0;
@@ -718,7 +732,8 @@ aviindex:
         if( tk->fmt.i_cat == VIDEO_ES && tk->idx.p_entry )
             i_idx_totalframes = __MAX(i_idx_totalframes, tk->idx.i_size);
     }
-    if( i_idx_totalframes != p_avih->i_totalframes &&
+    if( !p_sys->b_index_creating &&
+        i_idx_totalframes != p_avih->i_totalframes &&
         p_sys->i_length < VLC_TICK_FROM_US( p_avih->i_totalframes *
                                             p_avih->i_microsecperframe ) )
     {
@@ -975,6 +990,9 @@ static int Demux_Seekable( demux_t *p_demux )
     avi_track_toread_t toread[100];
 
 
+    if( p_sys->b_index_creating )
+        AVI_IndexCreateStep( p_demux, INDEX_CREATE_STEP );
+
     /* detect new selected/unselected streams */
     for( i_track = 0; i_track < p_sys->i_track; i_track++ )
     {
@@ -1450,7 +1468,8 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, double f_ratio, bool b_acc
         uint64_t i_pos_backup = vlc_stream_Tell( p_demux->s );
 
         /* Check and lazy load indexes if it was not done (not fastseekable) */
-        if ( !p_sys->b_indexloaded && ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
+        if ( !p_sys->b_indexloaded && !p_sys->b_index_creating &&
+             ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
         {
             avi_chunk_t *p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
             if (unlikely( !p_riff ))
@@ -1669,6 +1688,20 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             *va_arg( args, vlc_tick_t * ) = p_sys->i_length;
             return VLC_SUCCESS;
 
+        case DEMUX_GET_KEYFRAME:
+        {
+            vlc_tick_t i_date = va_arg( args, vlc_tick_t );
+            vlc_tick_t *pi_keyframe = va_arg( args, vlc_tick_t * );
+            unsigned *pi_skip = va_arg( args, unsigned * );
+            for( unsigned i = 0; i < p_sys->i_track; i++ )
+            {
+                avi_track_t *tk = p_sys->track[i];
+                if( tk->b_activated && tk->fmt.i_cat == VIDEO_ES )
+                    return AVI_TrackGetKeyframe( tk, i_date, pi_keyframe, pi_skip );
+            }
+            return VLC_EGENERIC;
+        }
+
         case DEMUX_GET_FPS:
             pf = va_arg( args, double * );
             *pf = 0.0;
@@ -2057,6 +2090,23 @@ static int AVI_TrackSeek( demux_t *p_demux,
 /****************************************************************************
  * Return true if it's a key frame
  ****************************************************************************/
+/* Finds the keyframe AVI_TrackSeek() would go back to, in the index only */
+static int AVI_TrackGetKeyframe( avi_track_t *tk, vlc_tick_t i_date,
+                                 vlc_tick_t *pi_keyframe, unsigned *pi_skip )
+{
+    int64_t i_ck = AVI_PTSToChunk( tk, i_date );
+    if( i_ck < 0 || (uint64_t) i_ck >= tk->idx.i_size )
+        return VLC_EGENERIC; /* not indexed yet */
+
+    int64_t i_key = i_ck;
+    while( i_key > 0 && !( tk->idx.p_entry[i_key].i_flags & AVIIF_KEYFRAME ) )
+        i_key--;
+
+    *pi_keyframe = AVI_GetDPTS( tk, i_key );
+    *pi_skip = i_ck - i_key;
+    return VLC_SUCCESS;
+}
+
 static int AVI_GetKeyFlag( vlc_fourcc_t i_fourcc, uint8_t *p_byte )
 {
     switch( i_fourcc )
@@ -2581,6 +2631,9 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
+/* Starts indexing the LIST-movi, one step per demux call, so that playback
+ * doesn't wait for the whole file to be read. Seeking beyond the indexed
+ * part still works, by indexing up to the target chunk. */
 static void AVI_IndexCreate( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2588,12 +2641,6 @@ static void AVI_IndexCreate( demux_t *p_demux )
     avi_chunk_list_t *p_riff;
     avi_chunk_list_t *p_movi;
 
-    unsigned int i_stream;
-    uint32_t i_movi_end;
-
-    vlc_tick_t i_dialog_update;
-    vlc_dialog_id *p_dialog_id = NULL;
-
     p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
     p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
 
@@ -2603,113 +2650,121 @@ static void AVI_IndexCreate( demux_t *p_demux )
         return;
     }
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    for( unsigned i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        avi_index_Clean( &p_sys->track[i_stream]->idx );
         avi_index_Init( &p_sys->track[i_stream]->idx );
+    }
+    p_sys->i_movi_lastchunk_pos = 0;
 
-    i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
-                        stream_Size( p_demux->s ) );
+    p_sys->i_index_create_end =
+        __MIN( p_movi->i_chunk_pos + p_movi->i_chunk_size,
+               stream_Size( p_demux->s ) );
+    p_sys->i_index_create_pos = p_movi->i_chunk_pos + 12;
+    p_sys->b_index_creating = true;
 
-    vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 );
-    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
+    msg_Warn( p_demux, "creating index from LIST-movi while playing" );
+}
 
+/* Returns false once the whole LIST-movi is indexed */
+static bool AVI_IndexCreateNext( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_packet_t pk;
 
-    /* Only show dialog if AVI is > 10MB */
-    i_dialog_update = vlc_tick_now();
-    if( stream_Size( p_demux->s ) > 10000000 )
-    {
-        p_dialog_id =
-            vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
-                                         _("Broken or missing AVI Index"),
-                                         _("Fixing AVI Index...") );
-    }
+    if( AVI_PacketGetHeader( p_demux, &pk ) )
+        return false;
 
-    for( ;; )
+    if( pk.i_stream < p_sys->i_track &&
+        pk.i_cat == p_sys->track[pk.i_stream]->fmt.i_cat )
     {
-        avi_packet_t pk;
+        avi_track_t *tk = p_sys->track[pk.i_stream];
 
-        /* Don't update/check dialog too often */
-        if( p_dialog_id != NULL && vlc_tick_now() - i_dialog_update > VLC_TICK_FROM_MS(100) )
+        avi_entry_t index;
+        index.i_id      = pk.i_fourcc;
+        index.i_flags   = AVI_GetKeyFlag(tk->fmt.i_codec, pk.i_peek);
+        index.i_pos     = pk.i_pos;
+        index.i_length  = pk.i_size;
+        index.i_lengthtotal = pk.i_size;
+        avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+    }
+    else
+    {
+        switch( pk.i_fourcc )
         {
-            if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
+        case AVIFOURCC_idx1:
+            if( p_sys->b_odml )
+            {
+                avi_chunk_list_t *p_sysx;
+                p_sysx = AVI_ChunkFind( &p_sys->ck_root,
+                                        AVIFOURCC_RIFF, 1, true );
+
+                msg_Dbg( p_demux, "looking for new RIFF chunk" );
+                if( !p_sysx || vlc_stream_Seek( p_demux->s,
+                                     p_sysx->i_chunk_pos + 24 ) )
+                    return false;
+                break;
+            }
+            return false;
+
+        case AVIFOURCC_RIFF:
+                msg_Dbg( p_demux, "new RIFF chunk found" );
                 break;
 
-            double f_current = vlc_stream_Tell( p_demux->s );
-            double f_size    = stream_Size( p_demux->s );
-            double f_pos     = f_current / f_size;
-            vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
+        case AVIFOURCC_rec:
+        case AVIFOURCC_JUNK:
+            break;
 
-            i_dialog_update = vlc_tick_now();
+        default:
+            msg_Warn( p_demux, "need resync, probably broken avi" );
+            if( AVI_PacketSearch( p_demux ) )
+            {
+                msg_Warn( p_demux, "lost sync, abord index creation" );
+                return false;
+            }
         }
+    }
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
-            break;
+    if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= p_sys->i_index_create_end ) ||
+        AVI_PacketNext( p_demux ) )
+        return false;
 
-        if( pk.i_stream < p_sys->i_track &&
-            pk.i_cat == p_sys->track[pk.i_stream]->fmt.i_cat )
-        {
-            avi_track_t *tk = p_sys->track[pk.i_stream];
+    return true;
+}
 
-            avi_entry_t index;
-            index.i_id      = pk.i_fourcc;
-            index.i_flags   = AVI_GetKeyFlag(tk->fmt.i_codec, pk.i_peek);
-            index.i_pos     = pk.i_pos;
-            index.i_length  = pk.i_size;
-            index.i_lengthtotal = pk.i_size;
-            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
-        }
-        else
-        {
-            switch( pk.i_fourcc )
-            {
-            case AVIFOURCC_idx1:
-                if( p_sys->b_odml )
-                {
-                    avi_chunk_list_t *p_sysx;
-                    p_sysx = AVI_ChunkFind( &p_sys->ck_root,
-                                            AVIFOURCC_RIFF, 1, true );
-
-                    msg_Dbg( p_demux, "looking for new RIFF chunk" );
-                    if( !p_sysx || vlc_stream_Seek( p_demux->s,
-                                         p_sysx->i_chunk_pos + 24 ) )
-                        goto print_stat;
-                    break;
-                }
-                goto print_stat;
+static void AVI_IndexCreateStep( demux_t *p_demux, unsigned i_count )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint64_t i_pos_backup = vlc_stream_Tell( p_demux->s );
+    bool b_more;
 
-            case AVIFOURCC_RIFF:
-                    msg_Dbg( p_demux, "new RIFF chunk found" );
-                    break;
+    /* Chunks may have been indexed meanwhile by the demuxer or a seek */
+    if( p_sys->i_movi_lastchunk_pos >= p_sys->i_index_create_pos )
+        b_more = !vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos ) &&
+                 !AVI_PacketNext( p_demux );
+    else
+        b_more = !vlc_stream_Seek( p_demux->s, p_sys->i_index_create_pos );
 
-            case AVIFOURCC_rec:
-            case AVIFOURCC_JUNK:
-                break;
+    while( b_more && i_count-- > 0 )
+        b_more = AVI_IndexCreateNext( p_demux );
 
-            default:
-                msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
-                {
-                    msg_Warn( p_demux, "lost sync, abord index creation" );
-                    goto print_stat;
-                }
-            }
-        }
+    p_sys->i_index_create_pos = vlc_stream_Tell( p_demux->s );
 
-        if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+    if( !b_more )
+    {
+        p_sys->b_index_creating = false;
+        for( unsigned i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
         {
-            break;
+            msg_Dbg( p_demux, "stream[%d] created %d index entries",
+                    i_stream, p_sys->track[i_stream]->idx.i_size );
         }
+        vlc_tick_t i_length = AVI_MovieGetLength( p_demux );
+        if( i_length > 0 )
+            p_sys->i_length = i_length;
     }
 
-print_stat:
-    if( p_dialog_id != NULL )
-        vlc_dialog_release( p_demux, p_dialog_id );
-
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
-    {
-        msg_Dbg( p_demux, "stream[%d] creating %d index entries",
-                i_stream, p_sys->track[i_stream]->idx.i_size );
-    }
+    if( vlc_stream_Seek( p_demux->s, i_pos_backup ) )
+        msg_Err( p_demux, "cannot restore position after indexing" );
 }
 
 /* */
@@ -44,6 +44,8 @@
 #include "../../adaptive/tools/Debug.hpp"
 #include "../../adaptive/tools/Conversions.hpp"
 #include <vlc_stream.h>
+#include <vlc_charset.h>
+#include <cmath>
 #include <cstdio>
 #include <limits>
 
@@ -82,6 +84,8 @@ MPD * IsoffMainParser::parse()
         parseMPDAttributes(mpd, root);
         parseProgramInformation(DOMHelper::getFirstChildElementByName(root, "ProgramInformation"), mpd);
         parseMPDBaseUrl(mpd, root);
+        if(var_InheritBool(p_object, "adaptive-lowlatency"))
+            parseServiceDescription(DOMHelper::getFirstChildElementByName(root, "ServiceDescription"), mpd);
         parsePeriods(mpd, root);
         mpd->debug();
     }
@@ -182,6 +186,19 @@ size_t IsoffMainParser::parseSegmentTemplate(Node *templateNode, SegmentInformat
     if(templateNode->hasAttribute("duration"))
         mediaTemplate->duration.Set(Integer<stime_t>(templateNode->getAttributeValue("duration")));
 
+    if(templateNode->hasAttribute("availabilityTimeOffset") &&
+       var_InheritBool(p_object, "adaptive-lowlatency"))
+    {
+        double ato = us_strtod(templateNode->getAttributeValue("availabilityTimeOffset").c_str(), NULL);
+        if(std::isfinite(ato) && ato > 0)
+        {
+            mediaTemplate->setAvailabilityTimeOffset(vlc_tick_from_sec(ato));
+            /* Incomplete segments are chunked CMAF, to be read while produced */
+            if(templateNode->getAttributeValue("availabilityTimeComplete") == "false")
+                info->getPlaylist()->setLowLatency(true);
+        }
+    }
+
     InitSegmentTemplate *initTemplate = NULL;
 
     if(templateNode->hasAttribute("initialization"))
@@ -511,6 +528,42 @@ void IsoffMainParser::parseProgramInformation(Node * node, MPD *mpd)
     }
 }
 
+void IsoffMainParser::parseServiceDescription(Node *node, MPD *mpd)
+{
+    if(!node)
+        return;
+
+    Node *latency = DOMHelper::getFirstChildElementByName(node, "Latency");
+    if(latency)
+    {
+        /* values are in milliseconds */
+        if(latency->hasAttribute("target"))
+            mpd->targetLatency.Set(VLC_TICK_FROM_MS(Integer<int64_t>(latency->getAttributeValue("target"))));
+        if(latency->hasAttribute("min"))
+            mpd->minLatency.Set(VLC_TICK_FROM_MS(Integer<int64_t>(latency->getAttributeValue("min"))));
+        if(latency->hasAttribute("max"))
+            mpd->maxLatency.Set(VLC_TICK_FROM_MS(Integer<int64_t>(latency->getAttributeValue("max"))));
+    }
+
+    Node *rate = DOMHelper::getFirstChildElementByName(node, "PlaybackRate");
+    if(rate)
+    {
+        float f;
+        if(rate->hasAttribute("min") &&
+           (f = us_strtof(rate->getAttributeValue("min").c_str(), NULL)) > 0 && f <= 1)
+            mpd->minPlaybackRate.Set(f);
+        if(rate->hasAttribute("max") &&
+           (f = us_strtof(rate->getAttributeValue("max").c_str(), NULL)) >= 1 && f < 2)
+            mpd->maxPlaybackRate.Set(f);
+    }
+
+    if(mpd->targetLatency.Get() > 0)
+    {
+        mpd->setLowLatency(true);
+        mpd->suggestedPresentationDelay.Set(mpd->targetLatency.Get());
+    }
+}
+
 Profile IsoffMainParser::getProfile() const
 {
     Profile res(Profile::Unknown);
@@ -32,6 +32,7 @@ HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq ) :
 {
     setSequenceNumber(seq);
     utcTime = 0;
+    mediaSequence = seq;
 }
 
 HLSSegment::~HLSSegment()
@@ -44,7 +45,7 @@ bool HLSSegment::prepareChunk(SharedResources *res, SegmentChunk *chunk, BaseRep
     {
         if (encryption.iv.size() != 16)
         {
-            uint64_t sequence = getSequenceNumber() - Segment::SEQUENCE_FIRST;
+            uint64_t sequence = mediaSequence;
             encryption.iv.clear();
             encryption.iv.resize(16);
             encryption.iv[15] = (sequence >> 0) & 0xff;
@@ -62,6 +63,11 @@ vlc_tick_t HLSSegment::getUTCTime() const
     return utcTime;
 }
 
+uint64_t HLSSegment::getMediaSequenceNumber() const
+{
+    return mediaSequence;
+}
+
 int HLSSegment::compare(ISegment *segment) const
 {
     HLSSegment *hlssegment = dynamic_cast<HLSSegment *>(segment);
@@ -39,10 +39,12 @@ namespace hls
                 HLSSegment( ICanonicalUrl *parent, uint64_t sequence );
                 virtual ~HLSSegment();
                 vlc_tick_t getUTCTime() const;
+                uint64_t getMediaSequenceNumber() const;
                 virtual int compare(ISegment *) const; /* reimpl */
 
             protected:
                 vlc_tick_t utcTime;
+                uint64_t mediaSequence; /* != sequence number when using parts */
                 virtual bool prepareChunk(SharedResources *, SegmentChunk *,
                                           BaseRepresentation *); /* reimpl */
         };
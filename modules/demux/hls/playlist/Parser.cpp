@@ -56,7 +56,7 @@ M3U8Parser::~M3U8Parser   ()
 {
 }
 
-static std::list<Tag *> getTagsFromList(std::list<Tag *> &list, int tag)
+static std::list<Tag *> getTagsFromList(const std::list<Tag *> &list, int tag)
 {
     std::list<Tag *> ret;
     std::list<Tag *>::const_iterator it;
@@ -68,7 +68,7 @@ static std::list<Tag *> getTagsFromList(std::list<Tag *> &list, int tag)
     return ret;
 }
 
-static Tag * getTagFromList(std::list<Tag *> &list, int tag)
+static Tag * getTagFromList(const std::list<Tag *> &list, int tag)
 {
     std::list<Tag *>::const_iterator it;
     for(it = list.begin(); it != list.end(); ++it)
@@ -157,7 +157,7 @@ void M3U8Parser::createAndFillRepresentation(vlc_object_t *p_obj, BaseAdaptation
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, rep->getPlaylistUrl().toString());
+    block_t *p_block = Retrieve::HTTP(resources, rep->getPlaylistUpdateUrl());
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -211,13 +211,99 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
-void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::list<Tag *> &tagslist)
+namespace
+{
+    /* When using parts, each of them is a segment, and our segments numbers
+     * no longer are media sequence numbers. They need to stay the same
+     * across reloads and are derived from the ones already in the list. */
+    class PartsNumbering
+    {
+        public:
+            PartsNumbering()
+            {
+                b_next = false;
+                next = 0;
+                nextMediaSequence = 0;
+            }
+
+            uint64_t get(uint64_t mediaSequence) const
+            {
+                std::map<uint64_t, Range>::const_iterator it = known.find(mediaSequence);
+                if(it != known.end())
+                    return it->second.first;
+                if(!b_next)
+                    return mediaSequence;
+                if(mediaSequence >= nextMediaSequence)
+                    return next + (mediaSequence - nextMediaSequence);
+                return 0; /* before our list, will be dropped */
+            }
+
+            void set(uint64_t mediaSequence, uint64_t number, uint64_t count)
+            {
+                /* A segment can be listed again without its parts */
+                std::map<uint64_t, Range>::iterator it = known.find(mediaSequence);
+                if(it != known.end() && number >= it->second.first)
+                {
+                    count = std::max(it->second.second, number - it->second.first + count);
+                    number = it->second.first;
+                }
+                known[mediaSequence] = Range(number, count);
+                next = number + count;
+                nextMediaSequence = mediaSequence + 1;
+                b_next = true;
+            }
+
+        private:
+            typedef std::pair<uint64_t, uint64_t> Range; /* first number, count */
+            std::map<uint64_t, Range> known;
+            bool b_next;
+            uint64_t next;
+            uint64_t nextMediaSequence;
+    };
+}
+
+void M3U8Parser::fillSegment(HLSSegment *segment, Representation *rep,
+                             const std::string &uri, double duration,
+                             vlc_tick_t *nzStartTime, vlc_tick_t *absReferenceTime)
+{
+    segment->setSourceUrl(uri);
+
+    const vlc_tick_t nzDuration = vlc_tick_from_sec( duration );
+    segment->duration.Set(duration * (uint64_t) rep->getTimescale());
+    segment->startTime.Set(rep->getTimescale().ToScaled(*nzStartTime));
+    *nzStartTime += nzDuration;
+    if(*absReferenceTime != VLC_TICK_INVALID)
+    {
+        segment->utcTime = *absReferenceTime;
+        *absReferenceTime += nzDuration;
+    }
+}
+
+void M3U8Parser::parseSegments(vlc_object_t *p_obj, Representation *rep, const std::list<Tag *> &tagslist)
 {
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
 
     rep->setTimescale(100);
     rep->b_loaded = true;
 
+    /* Low latency: use the parts, when listed, instead of the segments */
+    const bool b_lowlatency = var_InheritBool(p_obj, "adaptive-lowlatency");
+    rep->b_parts = b_lowlatency && getTagFromList(tagslist, AttributesTag::EXTXPARTINF);
+    PartsNumbering partsNumbering;
+    if(rep->b_parts)
+    {
+        std::vector<ISegment *> list;
+        std::vector<ISegment *>::const_iterator it;
+        rep->getSegments(BaseRepresentation::INFOTYPE_MEDIA, list);
+        for(it = list.begin(); it != list.end(); ++it)
+        {
+            const HLSSegment *seg = dynamic_cast<const HLSSegment *>(*it);
+            if(seg)
+                partsNumbering.set(seg->getMediaSequenceNumber(),
+                                   seg->getSequenceNumber() - HLSSegment::SEQUENCE_FIRST, 1);
+        }
+    }
+
     vlc_tick_t totalduration = 0;
     vlc_tick_t nzStartTime = 0;
     vlc_tick_t absReferenceTime = VLC_TICK_INVALID;
@@ -228,6 +314,15 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = NULL;
 
+    double partTarget = 0;
+    vlc_tick_t partHoldBack = 0;
+    uint64_t partsNumber = 0; /* number of the first part of the segment */
+    uint64_t partIndex = 0;
+    vlc_tick_t nzPartsStartTime = 0;
+    vlc_tick_t absPartsReferenceTime = VLC_TICK_INVALID;
+    std::size_t prevpartoffset = 0;
+    const AttributesTag *ctx_preloadhint = NULL;
+
     std::list<Tag *>::const_iterator it;
     for(it = tagslist.begin(); it != tagslist.end(); ++it)
     {
@@ -257,11 +352,7 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                     break;
                 }
 
-                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
-                if(!segment)
-                    break;
-
-                segment->setSourceUrl(uritag->getValue().value);
+                const uint64_t mediaSequence = sequenceNumber++;
 
                 /* Need to use EXTXTARGETDURATION as default as some can't properly set segment one */
                 double duration = rep->targetDuration;
@@ -272,17 +363,36 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                         duration = durAttribute->floatingPoint();
                     ctx_extinf = NULL;
                 }
-                const vlc_tick_t nzDuration = vlc_tick_from_sec( duration );
-                segment->duration.Set(duration * (uint64_t) rep->getTimescale());
-                segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
-                nzStartTime += nzDuration;
-                totalduration += nzDuration;
-                if(absReferenceTime != VLC_TICK_INVALID)
+                totalduration += vlc_tick_from_sec( duration );
+
+                if(partIndex > 0)
+                {
+                    /* Already added as parts */
+                    partsNumbering.set(mediaSequence, partsNumber, partIndex);
+                    nzStartTime = nzPartsStartTime + vlc_tick_from_sec( duration );
+                    if(absPartsReferenceTime != VLC_TICK_INVALID)
+                        absReferenceTime = absPartsReferenceTime + vlc_tick_from_sec( duration );
+                    partIndex = 0;
+                    prevpartoffset = 0;
+                    ctx_byterange = NULL;
+                    break;
+                }
+
+                uint64_t number = mediaSequence;
+                if(rep->b_parts)
                 {
-                    segment->utcTime = absReferenceTime;
-                    absReferenceTime += nzDuration;
+                    number = partsNumbering.get(mediaSequence);
+                    partsNumbering.set(mediaSequence, number, 1);
                 }
 
+                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, number);
+                if(!segment)
+                    break;
+
+                segment->mediaSequence = mediaSequence;
+                fillSegment(segment, rep, uritag->getValue().value, duration,
+                            &nzStartTime, &absReferenceTime);
+
                 segmentList->addSegment(segment);
 
                 if(ctx_byterange)
@@ -306,6 +416,98 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
             }
             break;
 
+            case AttributesTag::EXTXPART:
+            {
+                const AttributesTag *parttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *uriAttr = parttag->getAttributeByName("URI");
+                const Attribute *durAttr = parttag->getAttributeByName("DURATION");
+                if(!rep->b_parts || !uriAttr || !durAttr)
+                    break;
+
+                if(partIndex == 0)
+                {
+                    partsNumber = partsNumbering.get(sequenceNumber);
+                    nzPartsStartTime = nzStartTime;
+                    absPartsReferenceTime = absReferenceTime;
+                }
+
+                const uint64_t number = partsNumber + partIndex++;
+                const Attribute *gapAttr = parttag->getAttributeByName("GAP");
+                if(gapAttr && gapAttr->value == "YES")
+                {
+                    nzStartTime += vlc_tick_from_sec( durAttr->floatingPoint() );
+                    if(absReferenceTime != VLC_TICK_INVALID)
+                        absReferenceTime += vlc_tick_from_sec( durAttr->floatingPoint() );
+                    break;
+                }
+
+                HLSSegment *part = new (std::nothrow) HLSSegment(rep, number);
+                if(!part)
+                    break;
+
+                part->mediaSequence = sequenceNumber;
+                fillSegment(part, rep, uriAttr->quotedString(), durAttr->floatingPoint(),
+                            &nzStartTime, &absReferenceTime);
+
+                segmentList->addSegment(part);
+
+                const Attribute *byterangeAttr = parttag->getAttributeByName("BYTERANGE");
+                if(byterangeAttr)
+                {
+                    std::pair<std::size_t,std::size_t> range = byterangeAttr->unescapeQuotes().getByteRange();
+                    if(range.first == 0) /* continues previous part */
+                        range.first = prevpartoffset;
+                    prevpartoffset = range.first + range.second;
+                    part->setByteRange(range.first, prevpartoffset - 1);
+                }
+
+                if(discontinuity)
+                {
+                    part->discontinuity = true;
+                    discontinuity = false;
+                }
+
+                if(encryption.method != CommonEncryption::Method::NONE)
+                    part->setEncryption(encryption);
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *attr = static_cast<const AttributesTag *>(tag)->getAttributeByName("PART-TARGET");
+                if(attr)
+                    partTarget = attr->floatingPoint();
+            }
+            break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+                ctx_preloadhint = static_cast<const AttributesTag *>(tag);
+                break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                if(!b_lowlatency)
+                    break;
+                const AttributesTag *ctrltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *attr = ctrltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_canBlockReload = (attr && attr->value == "YES");
+                attr = ctrltag->getAttributeByName("CAN-SKIP-UNTIL");
+                rep->canSkipUntil = attr ? vlc_tick_from_sec( attr->floatingPoint() ) : 0;
+                attr = ctrltag->getAttributeByName("PART-HOLD-BACK");
+                if(attr)
+                    partHoldBack = vlc_tick_from_sec( attr->floatingPoint() );
+            }
+            break;
+
+            case AttributesTag::EXTXSKIP:
+            {
+                /* Delta update, skipped segments are already in our list */
+                const Attribute *attr = static_cast<const AttributesTag *>(tag)->getAttributeByName("SKIPPED-SEGMENTS");
+                if(attr)
+                    sequenceNumber += attr->decimal();
+            }
+            break;
+
             case SingleValueTag::EXTXTARGETDURATION:
                 rep->targetDuration = static_cast<const SingleValueTag *>(tag)->getValue().decimal();
                 break;
@@ -362,6 +564,49 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
         }
     }
 
+    /* Parts and segment blocking reloads will wait for */
+    rep->nextMediaSequence = sequenceNumber;
+    rep->nextPart = partIndex;
+
+    if(rep->b_parts)
+    {
+        rep->partTargetDuration = vlc_tick_from_sec( partTarget );
+
+        /* The hinted part is requested ahead, and served as it is produced */
+        const Attribute *typeAttr, *uriAttr;
+        if(ctx_preloadhint && rep->isLive() &&
+           (typeAttr = ctx_preloadhint->getAttributeByName("TYPE")) && typeAttr->value == "PART" &&
+           (uriAttr = ctx_preloadhint->getAttributeByName("URI")))
+        {
+            if(partIndex == 0)
+                partsNumber = partsNumbering.get(sequenceNumber);
+            HLSSegment *part = new (std::nothrow) HLSSegment(rep, partsNumber + partIndex);
+            if(part)
+            {
+                part->mediaSequence = sequenceNumber;
+                fillSegment(part, rep, uriAttr->quotedString(), partTarget,
+                            &nzStartTime, &absReferenceTime);
+                const Attribute *startAttr = ctx_preloadhint->getAttributeByName("BYTERANGE-START");
+                if(startAttr)
+                {
+                    const Attribute *lengthAttr = ctx_preloadhint->getAttributeByName("BYTERANGE-LENGTH");
+                    part->setByteRange(startAttr->decimal(), lengthAttr ?
+                                       startAttr->decimal() + lengthAttr->decimal() - 1 : 0);
+                }
+                if(encryption.method != CommonEncryption::Method::NONE)
+                    part->setEncryption(encryption);
+                segmentList->addSegment(part);
+            }
+        }
+
+        AbstractPlaylist *playlist = rep->getPlaylist();
+        playlist->setLowLatency(true);
+        if(!partHoldBack)
+            partHoldBack = 3 * rep->partTargetDuration;
+        playlist->suggestedPresentationDelay.Set(partHoldBack);
+        playlist->setMinBuffering(partHoldBack / 2);
+    }
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
@@ -50,6 +50,7 @@ namespace hls
         class AttributesTag;
         class Tag;
         class Representation;
+        class HLSSegment;
 
         class M3U8Parser
         {
@@ -65,6 +66,8 @@ namespace hls
                 void createAndFillRepresentation(vlc_object_t *, BaseAdaptationSet *,
                                                  const AttributesTag *, const std::list<Tag *>&);
                 void parseSegments(vlc_object_t *, Representation *, const std::list<Tag *>&);
+                void fillSegment(HLSSegment *, Representation *, const std::string &,
+                                 double, vlc_tick_t *, vlc_tick_t *);
                 std::list<Tag *> parseEntries(stream_t *);
                 adaptive::SharedResources *resources;
         };
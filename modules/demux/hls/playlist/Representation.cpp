@@ -33,6 +33,7 @@
 #include "../../adaptive/playlist/SegmentList.h"
 
 #include <ctime>
+#include <sstream>
 
 using namespace hls;
 using namespace hls::playlist;
@@ -45,6 +46,12 @@ Representation::Representation  ( BaseAdaptationSet *set ) :
     nextUpdateTime = 0;
     targetDuration = 0;
     streamFormat = StreamFormat::UNKNOWN;
+    b_canBlockReload = false;
+    b_parts = false;
+    partTargetDuration = 0;
+    canSkipUntil = 0;
+    nextMediaSequence = 0;
+    nextPart = 0;
 }
 
 Representation::~Representation ()
@@ -86,6 +93,28 @@ Url Representation::getPlaylistUrl() const
     }
 }
 
+std::string Representation::getPlaylistUpdateUrl() const
+{
+    std::string url = getPlaylistUrl().toString();
+    if(!b_loaded || !isLive() || (!b_canBlockReload && !canSkipUntil))
+        return url;
+
+    std::ostringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << url << ((url.find('?') == std::string::npos) ? '?' : '&');
+    if(b_canBlockReload)
+    {
+        ss << "_HLS_msn=" << nextMediaSequence;
+        if(b_parts)
+            ss << "&_HLS_part=" << nextPart;
+        if(canSkipUntil)
+            ss << "&";
+    }
+    if(canSkipUntil)
+        ss << "_HLS_skip=YES";
+    return ss.str();
+}
+
 void Representation::debug(vlc_object_t *obj, int indent) const
 {
     BaseRepresentation::debug(obj, indent);
@@ -106,6 +135,19 @@ void Representation::scheduleNextUpdate(uint64_t number)
     /* Compute new update time */
     vlc_tick_t minbuffer = getMinAheadTime(number);
 
+    /* Blocking reloads are held by the server until the next part or
+     * segment is available, so we can request as soon as we run short */
+    if(b_canBlockReload)
+    {
+        const vlc_tick_t reloadTarget = b_parts ? partTargetDuration
+                                                : vlc_tick_from_sec( targetDuration );
+        if(minbuffer > 3 * reloadTarget)
+            nextUpdateTime = now + SEC_FROM_VLC_TICK(minbuffer - 3 * reloadTarget);
+        else
+            nextUpdateTime = 0;
+        return;
+    }
+
     /* Update frequency must always be at least targetDuration (if any)
      * but we need to update before reaching that last segment, thus -1 */
     if(targetDuration)
@@ -45,6 +45,7 @@ namespace hls
 
                 void setPlaylistUrl(const std::string &);
                 Url getPlaylistUrl() const;
+                std::string getPlaylistUpdateUrl() const;
                 bool isLive() const;
                 bool initialized() const;
                 virtual void scheduleNextUpdate(uint64_t); /* reimpl */
@@ -61,6 +62,14 @@ namespace hls
                 time_t nextUpdateTime;
                 time_t targetDuration;
                 Url playlistUrl;
+
+                /* Low latency server control */
+                bool b_canBlockReload;
+                bool b_parts;
+                vlc_tick_t partTargetDuration;
+                vlc_tick_t canSkipUntil;
+                uint64_t nextMediaSequence; /* next to appear, for blocking reloads */
+                uint64_t nextPart;
         };
     }
 }
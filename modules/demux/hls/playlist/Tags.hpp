@@ -98,6 +98,11 @@ namespace hls
                     EXTXMEDIA,
                     EXTXSTREAMINF,
                     EXTXSESSIONKEY,
+                    EXTXPART,
+                    EXTXPARTINF,
+                    EXTXPRELOADHINT,
+                    EXTXSERVERCONTROL,
+                    EXTXSKIP,
                 };
                 AttributesTag(int, const std::string &);
                 virtual ~AttributesTag();
@@ -789,6 +789,29 @@ bool matroska_segment_c::LoadSeekHeadItem( const EbmlCallbacks & ClassInfos, int
     return true;
 }
 
+/* Looks up the known keyframes of the main track, without reading the file.
+ * The frames to skip can only be told from a fixed frame duration */
+bool matroska_segment_c::GetKeyframe( vlc_tick_t i_mk_date, vlc_tick_t *pi_keyframe, unsigned *pi_skip )
+{
+    if( priority_tracks.empty() )
+        return false;
+
+    tracks_map_t::const_iterator trackit = tracks.find( priority_tracks[0] );
+    if( trackit == tracks.end() )
+        return false;
+    const mkv_track_t &track = *trackit->second;
+
+    SegmentSeeker::Seekpoint sp = _seeker.get_first_seekpoint_around( i_mk_date,
+                                    _seeker._tracks_seekpoints[ track.i_number ] );
+    if( sp.trust_level == SegmentSeeker::Seekpoint::DISABLED || sp.pts > i_mk_date )
+        return false;
+
+    *pi_keyframe = sp.pts;
+    *pi_skip = track.i_default_duration > 0
+             ? ( i_mk_date - sp.pts ) / track.i_default_duration : 0;
+    return true;
+}
+
 bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date, vlc_tick_t i_mk_time_offset, bool b_accurate )
 {
     SegmentSeeker::tracks_seekpoint_t seekpoints;
@@ -1248,8 +1271,10 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
                 return;
             }
 
+            /* Only read up to the frames, BlockDecode() reads them straight
+             * into their block_t */
             vars.simpleblock = &ksblock;
-            vars.simpleblock->ReadData( vars.obj->es.I_O() );
+            vars.simpleblock->ReadData( vars.obj->es.I_O(), SCOPE_PARTIAL_DATA );
             vars.simpleblock->SetParent( *vars.obj->cluster );
 
             if( ksblock.IsKeyframe() )
@@ -144,6 +144,7 @@ public:
     void InformationCreate();
 
     bool Seek( demux_t &, vlc_tick_t i_mk_date, vlc_tick_t i_mk_time_offset, bool b_accurate );
+    bool GetKeyframe( vlc_tick_t i_mk_date, vlc_tick_t *pi_keyframe, unsigned *pi_skip );
 
     int BlockGet( KaxBlock * &, KaxSimpleBlock * &, bool *, bool *, int64_t *);
 
@@ -46,6 +46,41 @@ namespace {
 
     template<class It> It prev_( It it ) { return --it; }
     template<class It> It next_( It it ) { return ++it; }
+
+    // reads an EBML variable size integer, the element IDs keep their
+    // length marker. Returns the length of the integer, or 0 if invalid.
+
+    size_t ebml_read_vint( uint8_t const* p, size_t size, uint64_t& value,
+                           bool keep_marker, bool* unknown = NULL )
+    {
+        if( size == 0 || p[0] == 0 )
+            return 0;
+
+        size_t len = 1;
+        while( !( p[0] & ( 0x80 >> ( len - 1 ) ) ) )
+            ++len;
+
+        if( len > size )
+            return 0;
+
+        uint64_t const marker = UINT64_C( 1 ) << ( 7 * len );
+
+        value = keep_marker ? p[0] : p[0] & ( ( 0x80 >> ( len - 1 ) ) - 1 );
+        for( size_t i = 1; i < len; ++i )
+            value = ( value << 8 ) | p[i];
+
+        if( unknown )
+            *unknown = !keep_marker && value == marker - 1;
+
+        return len;
+    }
+
+    enum {
+        EBML_ID_CLUSTER          = 0x1F43B675,
+        EBML_ID_CLUSTER_TIMECODE = 0xE7,
+        EBML_ID_CRC32            = 0xBF,
+        EBML_ID_VOID             = 0xEC,
+    };
 }
 
 namespace mkv {
@@ -64,14 +99,22 @@ SegmentSeeker::add_cluster_position( fptr_t fpos )
 
 SegmentSeeker::cluster_map_t::iterator
 SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
+{
+    return add_cluster( p_cluster->GetElementPosition(),
+                        vlc_tick_t( VLC_TICK_FROM_NS( p_cluster->GlobalTimecode() ) ),
+                        p_cluster->IsFiniteSize()
+                          ? p_cluster->GetEndPosition() - p_cluster->GetElementPosition()
+                          : UINT64_MAX );
+}
+
+SegmentSeeker::cluster_map_t::iterator
+SegmentSeeker::add_cluster( fptr_t fpos, vlc_tick_t pts, fptr_t size )
 {
     Cluster cinfo = {
-        /* fpos     */ p_cluster->GetElementPosition(),
-        /* pts      */ vlc_tick_t( VLC_TICK_FROM_NS( p_cluster->GlobalTimecode() ) ),
+        /* fpos     */ fpos,
+        /* pts      */ pts,
         /* duration */ vlc_tick_t( -1 ),
-        /* size     */ p_cluster->IsFiniteSize()
-            ? p_cluster->GetEndPosition() - p_cluster->GetElementPosition()
-            : UINT64_MAX
+        /* size     */ size
     };
 
     add_cluster_position( cinfo.fpos );
@@ -301,6 +344,11 @@ SegmentSeeker::get_seekpoints( matroska_segment_c& ms, vlc_tick_t target_pts,
         }
     };
 
+    if( !ms.b_cues )
+        // locate the clusters up to the target first, so that only the
+        // blocks of the clusters around it are read
+        index_clusters( ms, target_pts );
+
     for( vlc_tick_t needle_pts = target_pts; ; )
     {
         seekpoint_pair_t seekpoints = get_seekpoints_around( needle_pts, priority_tracks );
@@ -326,6 +374,98 @@ SegmentSeeker::get_seekpoints( matroska_segment_c& ms, vlc_tick_t target_pts,
     vlc_assert_unreachable();
 }
 
+void
+SegmentSeeker::index_clusters( matroska_segment_c& ms, vlc_tick_t max_pts )
+{
+    // walk the level 1 elements using only their headers, skipping the
+    // payloads, up to the first cluster starting after max_pts
+
+    fptr_t const segment_end = ms.segment->IsFiniteSize()
+        ? ms.segment->GetEndPosition()
+        : std::numeric_limits<fptr_t>::max();
+
+    fptr_t fpos = _cluster_scan_pos ? _cluster_scan_pos : ms.segment->GetDataStart();
+
+    if( fpos >= segment_end )
+        return;
+
+    fptr_t const backup_fpos = ms.es.I_O().getFilePointer();
+
+    while( fpos < segment_end )
+    {
+        uint8_t buf[48];
+
+        ms.es.I_O().setFilePointer( fpos );
+        size_t const len = ms.es.I_O().read( buf, sizeof( buf ) );
+
+        uint64_t id = 0, size = 0;
+        bool b_unknown_size = false;
+
+        size_t const id_len = ebml_read_vint( buf, len, id, true );
+        size_t const size_len = id_len
+            ? ebml_read_vint( buf + id_len, len - id_len, size, false, &b_unknown_size )
+            : 0;
+
+        // the payload of unknown size elements cannot be skipped
+        if( size_len == 0 || b_unknown_size ||
+            size > std::numeric_limits<fptr_t>::max() - fpos - id_len - size_len )
+            break;
+
+        fptr_t const next_fpos = fpos + id_len + size_len + size;
+        bool b_past_max = false;
+
+        if( id == EBML_ID_CLUSTER )
+        {
+            // find the timecode, usually the first child
+            for( size_t i = id_len + size_len; i < len; )
+            {
+                uint64_t child_id, child_size;
+                size_t const child_id_len = ebml_read_vint( buf + i, len - i, child_id, true );
+                size_t const child_size_len = child_id_len
+                    ? ebml_read_vint( buf + i + child_id_len, len - i - child_id_len, child_size, false )
+                    : 0;
+
+                if( child_size_len == 0 )
+                    break;
+
+                i += child_id_len + child_size_len;
+
+                if( child_id == EBML_ID_CLUSTER_TIMECODE )
+                {
+                    if( child_size > 8 || child_size > len - i )
+                        break;
+
+                    uint64_t timecode = 0;
+                    for( size_t j = 0; j < child_size; ++j )
+                        timecode = ( timecode << 8 ) | buf[i + j];
+
+                    vlc_tick_t const pts = VLC_TICK_FROM_NS( timecode * ms.i_timescale );
+
+                    if( !std::binary_search( _cluster_positions.begin(),
+                                             _cluster_positions.end(), fpos ) )
+                        add_cluster_position( fpos );
+                    add_cluster( fpos, pts, next_fpos - fpos );
+
+                    b_past_max = pts > max_pts;
+                    break;
+                }
+
+                if( child_id != EBML_ID_CRC32 && child_id != EBML_ID_VOID )
+                    break;
+
+                i += child_size;
+            }
+        }
+
+        _cluster_scan_pos = fpos = next_fpos;
+
+        if( b_past_max )
+            break;
+    }
+
+    ms.es.I_O().setFilePointer( backup_fpos );
+}
+
 void
 SegmentSeeker::index_range( matroska_segment_c& ms, Range search_area, vlc_tick_t max_pts )
 {
@@ -110,9 +110,11 @@ class SegmentSeeker
 
         cluster_positions_t::iterator add_cluster_position( fptr_t pos );
         cluster_map_t      ::iterator add_cluster( KaxCluster * const );
+        cluster_map_t      ::iterator add_cluster( fptr_t fpos, vlc_tick_t pts, fptr_t size );
 
         void mkv_jump_to( matroska_segment_c&, fptr_t );
 
+        void index_clusters( matroska_segment_c& matroska_segment, vlc_tick_t max_pts );
         void index_range( matroska_segment_c& matroska_segment, Range search_area, vlc_tick_t max_pts );
         void index_unsearched_range( matroska_segment_c& matroska_segment, Range search_area, vlc_tick_t max_pts );
 
@@ -120,10 +122,13 @@ class SegmentSeeker
         ranges_t get_search_areas( fptr_t start, fptr_t end ) const;
 
     public:
+        SegmentSeeker() : _cluster_scan_pos( 0 ) { }
+
         ranges_t            _ranges_searched;
         tracks_seekpoints_t _tracks_seekpoints;
         cluster_positions_t _cluster_positions;
         cluster_map_t       _clusters;
+        fptr_t              _cluster_scan_pos; /* where index_clusters stopped */
 };
 
 } // namespace
@@ -463,6 +463,17 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             msg_Dbg(p_demux,"SET_TIME to %" PRId64, i64 );
             return Seek( p_demux, i64, -1, NULL, b );
 
+        case DEMUX_GET_KEYFRAME:
+        {
+            i64 = va_arg( args, vlc_tick_t );
+            vlc_tick_t *pi_keyframe = va_arg( args, vlc_tick_t * );
+            unsigned *pi_skip = va_arg( args, unsigned * );
+            if( !p_sys->p_current_vsegment )
+                return VLC_EGENERIC;
+            return p_sys->p_current_vsegment->GetKeyframe( i64, pi_keyframe, pi_skip )
+                   ? VLC_SUCCESS : VLC_EGENERIC;
+        }
+
         case DEMUX_CAN_PAUSE:
         case DEMUX_SET_PAUSE_STATE:
         case DEMUX_CAN_CONTROL_PACE:
@@ -561,27 +572,75 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
     size_t block_size = internal_block.GetSize();
     const unsigned i_number_frames = internal_block.NumberFrames();
 
-    for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
+    /* the laced frames of a SimpleBlock end with it */
+    uint64 i_frame_pos = 0;
+    if( simpleblock != NULL )
     {
-        block_t *p_block;
-        DataBuffer *data = &internal_block.GetBuffer(i_frame);
-
-        frame_size += data->Size();
-        if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
+        uint64 i_frames_size = 0;
+        for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
+            i_frames_size += simpleblock->GetFrameSize( i_frame );
+        if( i_frames_size > block_size )
         {
             msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
-            break;
+            return;
         }
-        size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
+        i_frame_pos = simpleblock->GetEndPosition() - i_frames_size;
+    }
 
-        if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
+    for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
+    {
+        block_t *p_block;
+        size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
+        const bool b_header_compression =
+            track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
             track.p_compression_data != NULL &&
-            track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-            p_block = MemToBlock( data->Buffer(), data->Size(), track.p_compression_data->GetSize() + extra_data );
-        else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
-            p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
+            track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES;
+
+        if( b_header_compression )
+            extra_data += track.p_compression_data->GetSize();
+
+        if( simpleblock != NULL )
+        {
+            /* SimpleBlocks are only read up to their frames, which are read
+             * from the stream directly into their block_t */
+            const uint64 i_frame_size = simpleblock->GetFrameSize( i_frame );
+
+            frame_size += i_frame_size;
+            if( i_frame_size > frame_size || frame_size > block_size )
+            {
+                msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
+                break;
+            }
+
+            p_block = StreamToBlock( p_segment->es.I_O(), i_frame_pos,
+                                     i_frame_size, extra_data );
+            i_frame_pos += i_frame_size;
+
+            if( p_block != NULL && !b_header_compression &&
+                unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
+            {
+                block_t *p_frame = p_block;
+                p_block = packetize_wavpack( track, p_frame->p_buffer, p_frame->i_buffer );
+                block_Release( p_frame );
+            }
+        }
         else
-            p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
+        {
+            DataBuffer *data = &internal_block.GetBuffer(i_frame);
+
+            frame_size += data->Size();
+            if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
+            {
+                msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
+                break;
+            }
+
+            if( !b_header_compression &&
+                unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
+                p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
+            else
+                p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
+        }
 
         if( p_block == NULL )
         {
@@ -163,6 +163,25 @@ block_t *MemToBlock( uint8_t *p_mem, size_t i_mem, size_t offset)
     return p_block;
 }
 
+/* Same as MemToBlock, reading the data from the stream */
+block_t *StreamToBlock( IOCallback & io, uint64_t i_pos, size_t i_size, size_t offset )
+{
+    if( unlikely( i_size > SIZE_MAX - offset ) )
+        return NULL;
+
+    block_t *p_block = block_Alloc( i_size + offset );
+    if( likely(p_block != NULL) )
+    {
+        io.setFilePointer( i_pos );
+        if( io.read( p_block->p_buffer + offset, i_size ) != i_size )
+        {
+            block_Release( p_block );
+            return NULL;
+        }
+    }
+    return p_block;
+}
+
 
 void handle_real_audio(demux_t * p_demux, mkv_track_t * p_tk, block_t * p_blk, vlc_tick_t i_pts)
 {
@@ -560,6 +560,25 @@ bool virtual_segment_c::Seek( demux_t & demuxer, vlc_tick_t i_mk_date,
     return false;
 }
 
+bool virtual_segment_c::GetKeyframe( vlc_tick_t i_mk_date, vlc_tick_t *pi_keyframe,
+                                     unsigned *pi_skip )
+{
+    if ( !CurrentEdition() )
+        return false;
+
+    virtual_chapter_c *p_vchapter = CurrentEdition()->getChapterbyTimecode( i_mk_date );
+    if ( p_vchapter == NULL )
+        return false;
+
+    /* same time mapping as Seek() */
+    vlc_tick_t i_mk_time_offset = p_vchapter->i_mk_virtual_start_time - ( ( p_vchapter->p_chapter )? p_vchapter->p_chapter->i_start_time : 0 );
+    if ( !p_vchapter->segment.GetKeyframe( i_mk_date - i_mk_time_offset, pi_keyframe, pi_skip ) )
+        return false;
+
+    *pi_keyframe += i_mk_time_offset;
+    return true;
+}
+
 virtual_chapter_c * virtual_chapter_c::FindChapter( int64_t i_find_uid )
 {
     if( p_chapter && ( p_chapter->i_uid == i_find_uid ) )
@@ -162,6 +162,7 @@ public:
 
     bool UpdateCurrentToChapter( demux_t & demux );
     bool Seek( demux_t & demuxer, vlc_tick_t i_mk_date, virtual_chapter_c *p_vchapter, bool b_precise = true );
+    bool GetKeyframe( vlc_tick_t i_mk_date, vlc_tick_t *pi_keyframe, unsigned *pi_skip );
 private:
     void KeepTrackSelection( matroska_segment_c & old, matroska_segment_c & next );
 };
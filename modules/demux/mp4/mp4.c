@@ -53,6 +53,13 @@ static void Close( vlc_object_t * );
 #define MP4_M4A_TEXT     N_("M4A audio only")
 #define MP4_M4A_LONGTEXT N_("Ignore non audio tracks from iTunes audio files")
 
+#define MP4_PRELOAD_TEXT N_("Read-ahead memory for non interleaved files (MiB)")
+#define MP4_PRELOAD_LONGTEXT N_( \
+    "When the tracks are badly interleaved, read this much data ahead " \
+    "from each track in sequence, instead of seeking back and forth " \
+    "between the tracks. This avoids most of the seeks on network " \
+    "sources.")
+
 #define HEIF_DURATION_TEXT N_("Duration in seconds")
 #define HEIF_DURATION_LONGTEXT N_( \
     "Duration in seconds before simulating an end of file. " \
@@ -66,6 +73,9 @@ vlc_module_begin ()
     set_capability( "demux", 240 )
     set_callbacks( Open, Close )
 
+    add_integer_with_range( CFG_PREFIX"preload-budget", 64, 0, 1024,
+                            MP4_PRELOAD_TEXT, MP4_PRELOAD_LONGTEXT, true )
+
     add_category_hint("Hacks", NULL)
     add_bool( CFG_PREFIX"m4a-audioonly", false, MP4_M4A_TEXT, MP4_M4A_LONGTEXT, true )
 
@@ -101,6 +111,7 @@ typedef struct
     uint64_t     i_cumulated_duration; /* Same as above, but not from probing, (movie time scale) */
     uint32_t     i_timescale;          /* movie time scale */
     vlc_tick_t   i_nztime;             /* time position of the presentation (CLOCK_FREQ timescale) */
+    vlc_tick_t   i_max_preload;        /* how far a track can be read ahead of the others */
     unsigned int i_tracks;       /* number of tracks */
     mp4_track_t  *track;         /* array of track */
     float        f_fps;          /* number of frame per seconds */
@@ -140,6 +151,9 @@ typedef struct
     } hacks;
 
     mp4_fragments_index_t *p_fragsindex;
+    /* fragments read while playing, until the whole file is probed */
+    mp4_fragments_index_t *p_fragsplayed;
+    bool b_fragsplayed_contiguous; /* playback is at the end of that index */
 } demux_sys_t;
 
 #define DEMUX_INCREMENT VLC_TICK_FROM_MS(250) /* How far the pcr will go, each round */
@@ -156,11 +170,14 @@ typedef struct
 static void MP4_TrackSetup( demux_t *, mp4_track_t *, MP4_Box_t  *, bool, bool );
 static void MP4_TrackInit( mp4_track_t *, const MP4_Box_t * );
 static void MP4_TrackClean( es_out_t *, mp4_track_t * );
+static int  TrackChunkLoad( demux_t *, const mp4_track_t *, mp4_chunk_t * );
 
 static void MP4_Block_Send( demux_t *, mp4_track_t *, block_t * );
 
 static void MP4_TrackSelect  ( demux_t *, mp4_track_t *, bool );
 static int  MP4_TrackSeek   ( demux_t *, mp4_track_t *, vlc_tick_t );
+static int  MP4_TrackGetKeyframe( demux_t *, mp4_track_t *, vlc_tick_t,
+                                  vlc_tick_t *, unsigned * );
 
 static uint64_t MP4_TrackGetPos    ( mp4_track_t * );
 static uint32_t MP4_TrackGetReadSize( mp4_track_t *, uint32_t * );
@@ -176,6 +193,8 @@ static void MP4_GetDefaultSizeAndDuration( MP4_Box_t *p_moov,
                                            uint32_t *pi_default_duration );
 
 static stime_t GetMoovTrackDuration( demux_sys_t *p_sys, unsigned i_track_ID );
+static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
+                                  unsigned i_track_ID, stime_t *p_duration );
 
 static int  ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented );
 static int  ProbeFragmentsChecked( demux_t *p_demux );
@@ -334,14 +353,14 @@ static es_out_id_t * MP4_AddTrackES( es_out_t *out, mp4_track_t *p_track )
     return p_es;
 }
 
-/* Return time in microsecond of a track */
-static inline vlc_tick_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
+/* Return time in microsecond of a sample of a loaded chunk */
+static vlc_tick_t MP4_TrackGetSampleDTS( demux_t *p_demux, const mp4_track_t *p_track,
+                                         const mp4_chunk_t *p_chunk, uint32_t i_track_sample )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
 
     unsigned int i_index = 0;
-    unsigned int i_sample = p_track->i_sample - p_chunk->i_sample_first;
+    unsigned int i_sample = i_track_sample - p_chunk->i_sample_first;
     int64_t sdts = p_chunk->i_first_dts;
 
     while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
@@ -384,6 +403,14 @@ static inline vlc_tick_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track
     return i_dts;
 }
 
+/* Return time in microsecond of a track */
+static inline vlc_tick_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
+{
+    return MP4_TrackGetSampleDTS( p_demux, p_track,
+                                  &p_track->chunk[p_track->i_chunk],
+                                  p_track->i_sample );
+}
+
 static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
                                          vlc_tick_t *pi_delta )
 {
@@ -643,6 +670,32 @@ static void MP4_GetInterleaving( demux_t *p_demux, vlc_tick_t *pi_max_contiguous
         p_sys->track[i].i_chunk = 0;
 }
 
+/* Reads the tracks of badly interleaved files in longer runs, within the
+ * memory budget, so that the reads seek only once per run */
+static void SetMaxPreload( demux_t *p_demux, vlc_tick_t i_max_continuity )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint64_t i_budget = var_InheritInteger( p_demux, CFG_PREFIX"preload-budget" );
+    const vlc_tick_t i_duration = MP4_rescale_mtime( p_sys->i_duration, p_sys->i_timescale );
+    const uint64_t i_size = stream_Size( p_demux->s );
+
+    if( i_budget == 0 || i_duration <= 0 || i_size == 0 )
+        return;
+
+    /* average byte rate of all the tracks */
+    const double f_rate = (double) i_size / secf_from_vlc_tick( i_duration );
+    vlc_tick_t i_preload = vlc_tick_from_sec( (double)( i_budget << 20 ) / f_rate );
+
+    if( i_preload > i_max_continuity )
+        i_preload = i_max_continuity;
+    if( i_preload > p_sys->i_max_preload )
+    {
+        p_sys->i_max_preload = i_preload;
+        msg_Dbg( p_demux, "reading tracks up to %"PRId64"ms ahead",
+                 MS_FROM_VLC_TICK( i_preload ) );
+    }
+}
+
 static block_t * MP4_Block_Convert( demux_t *p_demux, const mp4_track_t *p_track, block_t *p_block )
 {
     /* might have some encap */
@@ -799,6 +852,8 @@ static int Open( vlc_object_t * p_this )
     p_sys->context.i_lastseqnumber = UINT32_MAX;
 
     p_demux->p_sys = p_sys;
+    p_sys->b_fragsplayed_contiguous = true;
+    p_sys->i_max_preload = DEMUX_TRACK_MAX_PRELOAD;
 
     if( LoadInitFrag( p_demux ) != VLC_SUCCESS )
         goto error;
@@ -1136,6 +1191,9 @@ static int Open( vlc_object_t * p_this )
             msg_Warn( p_demux, "that media doesn't look interleaved, will need to seek");
         else if( i_max_continuity > DEMUX_TRACK_MAX_PRELOAD )
             msg_Warn( p_demux, "that media doesn't look properly interleaved, will need to seek");
+
+        if( i_max_continuity > DEMUX_TRACK_MAX_PRELOAD )
+            SetMaxPreload( p_demux, i_max_continuity );
     }
 
     /* */
@@ -1470,7 +1528,7 @@ static int DemuxMoov( demux_t *p_demux )
             return VLC_DEMUXER_EOS;
     }
 
-    const vlc_tick_t i_max_preload = ( p_sys->b_fastseekable ) ? 0 : ( p_sys->b_seekable ) ? DEMUX_TRACK_MAX_PRELOAD : INVALID_PRELOAD;
+    const vlc_tick_t i_max_preload = ( p_sys->b_fastseekable ) ? 0 : ( p_sys->b_seekable ) ? p_sys->i_max_preload : INVALID_PRELOAD;
     int i_status;
     /* demux up to increment amount of data on every track, or just set pcr if empty data */
     for( ;; )
@@ -1512,7 +1570,7 @@ static int DemuxMoov( demux_t *p_demux )
                     continue;
 
                 vlc_tick_t i_nzdts = MP4_TrackGetDTS( p_demux, tk_tmp );
-                if ( i_nzdts <= i_nztime + DEMUX_TRACK_MAX_PRELOAD )
+                if ( i_nzdts <= i_nztime + p_sys->i_max_preload )
                 {
                     /* Found a better candidate to avoid seeking */
                     if( MP4_TrackGetPos( tk_tmp ) < MP4_TrackGetPos( tk ) )
@@ -1627,6 +1685,62 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, bool b_accurate )
     return VLC_SUCCESS;
 }
 
+/* Indexes the fragments as they are played, so that seeking back into them
+ * does not need to read the whole file when it has no sidx or tfra index.
+ * Only fragments played in sequence from the start are added. */
+static void FragIndexPlayedMoof( demux_t *p_demux, MP4_Box_t *p_moof )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    mp4_fragments_index_t *p_index = p_sys->p_fragsplayed;
+
+    if( !p_sys->b_seekable || p_sys->b_fragments_probed || !p_sys->i_tracks )
+        return;
+
+    if( p_index && MP4_Fragments_Index_Contains( p_index, p_moof->i_pos ) )
+    {
+        p_sys->b_fragsplayed_contiguous = true;
+        return;
+    }
+
+    if( !p_sys->b_fragsplayed_contiguous ||
+        ( p_index && p_index->i_entries &&
+          p_index->pi_pos[p_index->i_entries - 1] > p_moof->i_pos ) )
+    {
+        p_sys->b_fragsplayed_contiguous = false;
+        return;
+    }
+
+    if( !p_index )
+    {
+        p_index = MP4_Fragments_Index_New( p_sys->i_tracks, 16 );
+        if( !p_index )
+            return;
+        p_index->i_entries = 0;
+        p_sys->p_fragsplayed = p_index;
+    }
+
+    stime_t *p_times = MP4_Fragments_Index_Append( p_index, p_moof->i_pos );
+    if( !p_times )
+    {
+        p_sys->b_fragsplayed_contiguous = false;
+        return;
+    }
+
+    for( unsigned i=0; i<p_sys->i_tracks; i++ )
+    {
+        const mp4_track_t *p_track = &p_sys->track[i];
+        stime_t i_time = p_track->i_time;
+        p_times[i] = MP4_rescale( i_time, p_track->i_timescale, p_sys->i_timescale );
+
+        stime_t i_duration = 0;
+        if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_track->i_track_ID, &i_duration ) )
+            i_time += i_duration;
+        i_time = MP4_rescale( i_time, p_track->i_timescale, p_sys->i_timescale );
+        if( p_index->i_last_time < i_time )
+            p_index->i_last_time = i_time;
+    }
+}
+
 static int FragPrepareChunk( demux_t *p_demux, MP4_Box_t *p_moof,
                              MP4_Box_t *p_sidx, stime_t i_moof_time, bool b_discontinuity )
 {
@@ -1651,6 +1765,7 @@ static int FragPrepareChunk( demux_t *p_demux, MP4_Box_t *p_moof,
                 p_track->i_time = p_run->i_first_dts;
             }
         }
+        FragIndexPlayedMoof( p_demux, p_moof );
         return VLC_SUCCESS;
     }
 
@@ -1712,6 +1827,8 @@ static int FragSeekLoadFragment( demux_t *p_demux, uint32_t i_moox, stime_t i_mo
     /* map context */
     p_sys->context.p_fragment_atom = p_moox;
     p_sys->context.i_current_box_type = i_moox;
+    /* the played fragments index only continues from a fragment it has */
+    p_sys->b_fragsplayed_contiguous = ( i_moox == ATOM_moov );
 
     if( i_moox == ATOM_moof )
     {
@@ -1828,12 +1945,22 @@ static int FragSeekToTime( demux_t *p_demux, vlc_tick_t i_nztime, bool b_accurat
     }
     else
     {
+        stime_t i_basetime = MP4_rescale_qtime( i_sync_time, p_sys->i_timescale );
+
         if( FragGetMoofByTfraIndex( p_demux, i_nztime, i_seek_track_ID, &i64, &i_sync_time ) == VLC_SUCCESS )
         {
             /* Does only provide segment position and a sync sample time */
             msg_Dbg( p_demux, "seeking to sync point %" PRId64, i_sync_time );
             b_iframesync = true;
         }
+        else if( !p_sys->b_fragments_probed && p_sys->p_fragsplayed &&
+                 MP4_Fragments_Index_Lookup( p_sys->p_fragsplayed, &i_basetime, &i64,
+                                             i_seek_track_index ) )
+        {
+            /* Already played, no need to probe the whole file */
+            msg_Dbg( p_demux, "seeking to played fragment pos %" PRId64 " %" PRId64, i64,
+                     MP4_rescale_mtime( i_basetime, p_sys->i_timescale ) );
+        }
         else if( !p_sys->b_fragments_probed )
         {
             int i_ret = ProbeFragmentsChecked( p_demux );
@@ -1843,7 +1970,7 @@ static int FragSeekToTime( demux_t *p_demux, vlc_tick_t i_nztime, bool b_accurat
 
         if( p_sys->b_fragments_probed && p_sys->p_fragsindex )
         {
-            stime_t i_basetime = MP4_rescale_qtime( i_sync_time, p_sys->i_timescale );
+            i_basetime = MP4_rescale_qtime( i_sync_time, p_sys->i_timescale );
             if( !MP4_Fragments_Index_Lookup( p_sys->p_fragsindex, &i_basetime, &i64, i_seek_track_index ) )
             {
                 p_sys->b_error = (vlc_stream_Seek( p_demux->s, i_backup_pos ) != VLC_SUCCESS);
@@ -2001,6 +2128,23 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             else
                 return Seek( p_demux, i64, b );
 
+        case DEMUX_GET_KEYFRAME:
+        {
+            i64 = va_arg( args, vlc_tick_t );
+            vlc_tick_t *pi_keyframe = va_arg( args, vlc_tick_t * );
+            unsigned *pi_skip = va_arg( args, unsigned * );
+            if( p_demux->pf_demux == DemuxFrag )
+                return VLC_EGENERIC;
+            /* same track Seek() aligns on */
+            for( unsigned i = 0; i < p_sys->i_tracks; i++ )
+            {
+                mp4_track_t *tk = &p_sys->track[i];
+                if( tk->fmt.i_cat == VIDEO_ES && !MP4_isMetadata( tk ) && tk->b_ok )
+                    return MP4_TrackGetKeyframe( p_demux, tk, i64, pi_keyframe, pi_skip );
+            }
+            return VLC_EGENERIC;
+        }
+
         case DEMUX_GET_LENGTH:
             if( p_sys->i_timescale > 0 )
             {
@@ -2140,6 +2284,7 @@ static void Close ( vlc_object_t * p_this )
         vlc_meta_Delete( p_sys->p_meta );
 
     MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+    MP4_Fragments_Index_Delete( p_sys->p_fragsplayed );
 
     for( i_track = 0; i_track < p_sys->i_tracks; i_track++ )
         MP4_TrackClean( p_demux->out, &p_sys->track[i_track] );
@@ -2247,7 +2392,12 @@ static void LoadChapterApple( demux_t  *p_demux, mp4_track_t *tk )
         }
         if( tk->i_sample+1 >= tk->chunk[tk->i_chunk].i_sample_first +
                               tk->chunk[tk->i_chunk].i_sample_count )
+        {
             tk->i_chunk++;
+            if( tk->i_chunk < tk->i_chunk_count &&
+                TrackChunkLoad( p_demux, tk, &tk->chunk[tk->i_chunk] ) )
+                break;
+        }
     }
 }
 static void LoadChapter( demux_t  *p_demux )
@@ -2394,52 +2544,118 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
+/* Moves the position in a stts or ctts table by up to i_sample_count samples,
+ * but not past the current table entry. Returns the entry and the number of
+ * samples covered, or false at the end of the table. */
+static bool xTTS_Step( const uint32_t *pi_index_sample_count,
+                       const uint32_t i_table_count,
+                       uint32_t *pi_index, uint32_t *pi_index_samples_left,
+                       uint32_t i_sample_count,
+                       uint32_t *pi_entry, uint32_t *pi_count )
 {
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
+    if( *pi_index >= i_table_count )
+        return false;
+
+    const uint32_t i_left = *pi_index_samples_left ? *pi_index_samples_left
+                                                   : pi_index_sample_count[*pi_index];
+    *pi_entry = *pi_index;
+    *pi_count = __MIN( i_left, i_sample_count );
+
+    if( i_left > *pi_count )
     {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
+        /* keep building from same index */
+        *pi_index_samples_left = i_left - *pi_count;
+    }
+    else
+    {
+        *pi_index_samples_left = 0;
+        *pi_index += 1;
+    }
+    return true;
+}
 
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_EBADVAR;
-        }
+/* Releases the tables expanded by TrackChunkLoad */
+static void TrackChunkUnload( const mp4_track_t *p_track, mp4_chunk_t *ck )
+{
+    if( p_track->p_stts )
+    {
+        free( ck->p_sample_count_dts );
+        free( ck->p_sample_delta_dts );
+        ck->p_sample_count_dts = NULL;
+        ck->p_sample_delta_dts = NULL;
+    }
+    if( p_track->p_ctts )
+    {
+        free( ck->p_sample_count_pts );
+        free( ck->p_sample_offset_pts );
+        ck->p_sample_count_pts = NULL;
+        ck->p_sample_offset_pts = NULL;
+    }
+}
 
-        if ( i_index_samples_left )
+/* Expands the stts and ctts entries of a chunk, when it is about to be read.
+ * Doing this for all the chunks when opening would take a lot of time and
+ * memory on long files, that are mostly not played from start to end */
+static int TrackChunkLoad( demux_t *p_demux, const mp4_track_t *p_track,
+                           mp4_chunk_t *ck )
+{
+    uint32_t i_index, i_left, i_sample_count, i_entry, i_count;
+
+    if( p_track->p_stts && ck->i_entries_dts && !ck->p_sample_count_dts )
+    {
+        const MP4_Box_data_stts_t *stts = p_track->p_stts;
+
+        ck->p_sample_count_dts = vlc_alloc( ck->i_entries_dts, sizeof( uint32_t ) );
+        ck->p_sample_delta_dts = vlc_alloc( ck->i_entries_dts, sizeof( uint32_t ) );
+        if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+            goto error;
+
+        i_index = ck->i_dts_index;
+        i_left = ck->i_dts_index_samples_left;
+        i_sample_count = ck->i_sample_count;
+        for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
         {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
+            bool b_ok = xTTS_Step( stts->pi_sample_count, stts->i_entry_count,
+                                   &i_index, &i_left, i_sample_count,
+                                   &i_entry, &i_count );
+            assert( b_ok ); VLC_UNUSED( b_ok );
+            ck->p_sample_count_dts[i] = i_count;
+            ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_entry];
+            i_sample_count -= i_count;
         }
-        else
+    }
+
+    if( p_track->p_ctts && ck->i_entries_pts && !ck->p_sample_count_pts )
+    {
+        const MP4_Box_data_ctts_t *ctts = p_track->p_ctts;
+
+        ck->p_sample_count_pts = vlc_alloc( ck->i_entries_pts, sizeof( uint32_t ) );
+        ck->p_sample_offset_pts = vlc_alloc( ck->i_entries_pts, sizeof( int32_t ) );
+        if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
+            goto error;
+
+        i_index = ck->i_pts_index;
+        i_left = ck->i_pts_index_samples_left;
+        i_sample_count = ck->i_sample_count;
+        for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
         {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
+            bool b_ok = xTTS_Step( ctts->pi_sample_count, ctts->i_entry_count,
+                                   &i_index, &i_left, i_sample_count,
+                                   &i_entry, &i_count );
+            assert( b_ok ); VLC_UNUSED( b_ok );
+            ck->p_sample_count_pts[i] = i_count;
+            ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_entry] +
+                                         p_track->i_cts_shift;
+            i_sample_count -= i_count;
         }
     }
 
     return VLC_SUCCESS;
+
+error:
+    msg_Err( p_demux, "can't allocate memory for chunk tables" );
+    TrackChunkUnload( p_track, ck );
+    return VLC_ENOMEM;
 }
 
 static int TrackCreateSamplesIndex( demux_t *p_demux,
@@ -2481,16 +2697,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     {
         /* 2: each sample can have a different size */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -2507,118 +2714,63 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
      * XXX: if we don't want to waste too much memory, we can't expand
      *  the box! so each chunk will contain an "extract" of this table
      *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+     *  just channels*bits_per_sample/8. The extracts are only created by
+     *  TrackChunkLoad, here we only save where each chunk starts in the
+     *  table */
 
     int64_t i_next_dts = 0;
     /* Find stts
      *  Gives mapping between sample and decoding time
      */
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "stts" );
-    if( !p_box )
+    if( !p_box || !p_box->data.p_stts )
     {
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
     else
     {
-        MP4_Box_data_stts_t *stts = p_box->data.p_stts;
+        const MP4_Box_data_stts_t *stts = p_box->data.p_stts;
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
         uint32_t i_index = 0;
         uint32_t i_current_index_samples_left = 0;
+        bool b_truncated = false;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
+            uint32_t i_sample_count = ck->i_sample_count;
+            uint32_t i_entry, i_count;
 
             /* save first dts */
             ck->i_first_dts = i_next_dts;
+            ck->i_dts_index = i_index;
+            ck->i_dts_index_samples_left = i_current_index_samples_left;
 
             /* count how many entries are needed for this chunk
              * for p_sample_delta_dts and p_sample_count_dts */
             ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+            while( i_sample_count > 0 &&
+                   xTTS_Step( stts->pi_sample_count, stts->i_entry_count,
+                              &i_index, &i_current_index_samples_left,
+                              i_sample_count, &i_entry, &i_count ) )
             {
-                free( ck->p_sample_count_dts );
-                free( ck->p_sample_delta_dts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return VLC_ENOMEM;
+                i_next_dts += (int64_t) i_count * stts->pi_sample_delta[i_entry];
+                i_sample_count -= i_count;
+                ck->i_entries_dts++;
             }
+            ck->i_duration = i_next_dts - ck->i_first_dts;
+            if( i_sample_count > 0 )
+                b_truncated = true;
+        }
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
+        if( b_truncated )
+            msg_Err( p_demux, "invalid index counting total samples %"PRIu32,
+                     stts->i_entry_count );
 
-            }
-        }
+        p_demux_track->p_stts = stts;
     }
 
 
@@ -2628,95 +2780,40 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
     if( p_box && p_box->data.p_ctts )
     {
-        MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
+        const MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-        int64_t i_cts_shift = 0;
         const MP4_Box_t *p_cslg = MP4_BoxGet( p_demux_track->p_stbl, "cslg" );
         if( p_cslg && BOXDATA(p_cslg) )
-            i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
+            p_demux_track->i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
 
-        /* Create pts-dts table per chunk */
         uint32_t i_index = 0;
         uint32_t i_current_index_samples_left = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
+            uint32_t i_sample_count = ck->i_sample_count;
+            uint32_t i_entry, i_count;
+
+            ck->i_pts_index = i_index;
+            ck->i_pts_index_samples_left = i_current_index_samples_left;
 
             /* count how many entries are needed for this chunk
              * for p_sample_offset_pts and p_sample_count_pts */
             ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
+            while( i_sample_count > 0 &&
+                   xTTS_Step( ctts->pi_sample_count, ctts->i_entry_count,
+                              &i_index, &i_current_index_samples_left,
+                              i_sample_count, &i_entry, &i_count ) )
             {
-                free( ck->p_sample_count_pts );
-                free( ck->p_sample_offset_pts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return VLC_ENOMEM;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
-
+                i_sample_count -= i_count;
+                ck->i_entries_pts++;
             }
         }
+
+        p_demux_track->p_ctts = ctts;
     }
 
     msg_Dbg( p_demux, "track[Id 0x%x] read %"PRIu32" samples length:%"PRId64"s",
@@ -2870,6 +2967,24 @@ static int TrackCreateES( demux_t *p_demux, mp4_track_t *p_track,
                 p_arg->pf_peak[AUDIO_REPLAY_GAIN_TRACK] = f_gain;
                 p_arg->pb_peak[AUDIO_REPLAY_GAIN_TRACK] = f_gain > 0;
             }
+
+            /* iTunes gapless info: " 00000000 delay padding samples ...".
+             * With an edit list, the priming samples are skipped already */
+            psz_meta = vlc_meta_GetExtra( p_sys->p_meta, "iTunSMPB" );
+            if( psz_meta && !( p_track->p_elst &&
+                               p_track->BOXDATA(p_elst)->i_entry_count ) )
+            {
+                unsigned i_delay, i_padding;
+                uint64_t i_samples;
+                if( sscanf( psz_meta, "%*x %x %x %"SCNx64,
+                            &i_delay, &i_padding, &i_samples ) == 3 )
+                {
+                    p_track->fmt.audio_gapless.i_delay = i_delay;
+                    p_track->fmt.audio_gapless.i_samples = i_samples;
+                    msg_Dbg( p_demux, "gapless: %u priming samples, "
+                             "%"PRIu64" samples", i_delay, i_samples );
+                }
+            }
         }
         break;
 
@@ -2967,7 +3082,7 @@ static int TrackGetNearestSeekPoint( demux_t *p_demux, mp4_track_t *p_track,
  */
 static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
                                    vlc_tick_t start, uint32_t *pi_chunk,
-                                   uint32_t *pi_sample )
+                                   uint32_t *pi_sample, uint32_t *pi_target )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
     uint64_t     i_dts;
@@ -2992,6 +3107,8 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         {
             *pi_chunk = 0;
             *pi_sample= 0;
+            if( pi_target )
+                *pi_target = 0;
 
             return VLC_SUCCESS;
         }
@@ -3016,24 +3133,23 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = MP4_rescale_qtime( start, p_track->i_timescale );
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
-    /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
+    /* *** find good chunk ***
+     * the last one starting before i_start, chunks dts being increasing.
+     * If i_start is after the last chunk, it will be check while
+     * searching i_sample */
+    uint32_t i_low = 0, i_high = p_track->i_chunk_count;
+    while( i_high - i_low > 1 )
     {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
-        {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
-        }
+        const uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if( (uint64_t)i_start >= p_track->chunk[i_mid].i_first_dts )
+            i_low = i_mid;
+        else
+            i_high = i_mid;
     }
+    i_chunk = i_low;
+
+    if( TrackChunkLoad( p_demux, p_track, &p_track->chunk[i_chunk] ) )
+        return VLC_EGENERIC;
 
     /* *** find sample in the chunk *** */
     i_sample = p_track->chunk[i_chunk].i_sample_first;
@@ -3066,6 +3182,9 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         }
     }
 
+    if( i_chunk != p_track->i_chunk )
+        TrackChunkUnload( p_track, &p_track->chunk[i_chunk] );
+
     if( i_sample >= p_track->i_sample_count )
     {
         msg_Warn( p_demux, "track[Id 0x%x] will be disabled "
@@ -3074,6 +3193,8 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         return( VLC_EGENERIC );
     }
 
+    if( pi_target )
+        *pi_target = i_sample;
 
     /* *** Try to find nearest sync points *** */
     uint32_t i_sync_sample;
@@ -3140,6 +3261,15 @@ static int TrackGotoChunkSample( demux_t *p_demux, mp4_track_t *p_track,
         es_out_Control( p_demux->out, ES_OUT_SET_ES, p_track->p_es );
     }
 
+    if( TrackChunkLoad( p_demux, p_track, &p_track->chunk[i_chunk] ) )
+    {
+        p_track->b_ok       = false;
+        p_track->b_selected = false;
+        return VLC_EGENERIC;
+    }
+    if( p_track->i_chunk != i_chunk && p_track->i_chunk < p_track->i_chunk_count )
+        TrackChunkUnload( p_track, &p_track->chunk[p_track->i_chunk] );
+
     p_track->i_chunk    = i_chunk;
     p_track->chunk[i_chunk].i_sample = i_sample - p_track->chunk[i_chunk].i_sample_first;
     p_track->i_sample   = i_sample;
@@ -3407,6 +3537,10 @@ static void MP4_TrackSetup( demux_t *p_demux, mp4_track_t *p_track,
     p_track->i_chunk  = 0;
     p_track->i_sample = 0;
 
+    if( p_track->i_chunk_count &&
+        TrackChunkLoad( p_demux, p_track, &p_track->chunk[0] ) )
+        return;
+
     /* Disable chapter only track */
     if( p_track->fmt.i_cat == UNKNOWN_ES &&
        (p_track->i_use_flags & USEAS_CHAPTERS) )
@@ -3510,9 +3644,6 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
 
@@ -3559,7 +3690,7 @@ static int MP4_TrackSeek( demux_t *p_demux, mp4_track_t *p_track,
     p_track->b_selected = false;
 
     if( TrackTimeToSampleChunk( p_demux, p_track, i_start,
-                                &i_chunk, &i_sample ) )
+                                &i_chunk, &i_sample, NULL ) )
     {
         msg_Warn( p_demux, "cannot select track[Id 0x%x]",
                   p_track->i_track_ID );
@@ -3574,6 +3705,38 @@ static int MP4_TrackSeek( demux_t *p_demux, mp4_track_t *p_track,
 }
 
 
+/* Finds the sync sample a seek to i_time would start from, without
+ * moving the track */
+static int MP4_TrackGetKeyframe( demux_t *p_demux, mp4_track_t *p_track,
+                                 vlc_tick_t i_time, vlc_tick_t *pi_keyframe,
+                                 unsigned *pi_skip )
+{
+    uint32_t i_chunk, i_sample, i_target;
+
+    /* the lookup selects the edit list of the time */
+    const int i_elst = p_track->i_elst;
+    const int64_t i_elst_time = p_track->i_elst_time;
+
+    int i_ret = TrackTimeToSampleChunk( p_demux, p_track, i_time,
+                                        &i_chunk, &i_sample, &i_target );
+    if( i_ret == VLC_SUCCESS )
+    {
+        mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+        i_ret = TrackChunkLoad( p_demux, p_track, ck );
+        if( i_ret == VLC_SUCCESS )
+        {
+            *pi_keyframe = MP4_TrackGetSampleDTS( p_demux, p_track, ck, i_sample );
+            *pi_skip = i_target > i_sample ? i_target - i_sample : 0;
+            if( i_chunk != p_track->i_chunk )
+                TrackChunkUnload( p_track, ck );
+        }
+    }
+
+    p_track->i_elst = i_elst;
+    p_track->i_elst_time = i_elst_time;
+    return i_ret;
+}
+
 /*
  * 3 types: for audio
  *
@@ -4407,7 +4570,7 @@ static int DemuxMoof( demux_t *p_demux )
     demux_sys_t *p_sys = p_demux->p_sys;
     int i_status;
 
-    const vlc_tick_t i_max_preload = ( p_sys->b_fastseekable ) ? 0 : ( p_sys->b_seekable ) ? DEMUX_TRACK_MAX_PRELOAD : INVALID_PRELOAD;
+    const vlc_tick_t i_max_preload = ( p_sys->b_fastseekable ) ? 0 : ( p_sys->b_seekable ) ? p_sys->i_max_preload : INVALID_PRELOAD;
 
     const vlc_tick_t i_nztime = MP4_GetMoviePTS( p_sys );
 
@@ -4461,7 +4624,7 @@ static int DemuxMoof( demux_t *p_demux )
                     continue;
 
                 vlc_tick_t i_nzdts = MP4_rescale_mtime( tk_tmp->i_time, tk_tmp->i_timescale );
-                if ( i_nzdts <= i_nztime + DEMUX_TRACK_MAX_PRELOAD )
+                if ( i_nzdts <= i_nztime + p_sys->i_max_preload )
                 {
                     /* Found a better candidate to avoid seeking */
                     if( tk_tmp->context.i_trun_sample_pos < tk->context.i_trun_sample_pos )
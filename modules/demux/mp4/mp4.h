@@ -47,6 +47,13 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
 
+    /* position of the first sample in the stts and ctts tables, the tables
+     * below are only expanded while the chunk is being read */
+    uint32_t     i_dts_index;
+    uint32_t     i_dts_index_samples_left;
+    uint32_t     i_pts_index;
+    uint32_t     i_pts_index_samples_left;
+
     uint32_t     i_entries_dts;
     uint32_t     *p_sample_count_dts;
     uint32_t     *p_sample_delta_dts;   /* dts delta */
@@ -127,11 +134,17 @@ typedef struct
     mp4_chunk_t    *chunk; /* always defined  for each chunk */
 
     /* sample size, p_sample_size defined only if i_sample_size == 0
-        else i_sample_size is size for all sample */
+        else i_sample_size is size for all sample. It points to the stsz
+        table data and is not owned by the track */
     uint32_t         i_sample_size;
     uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
 //                                    too much time to do sumations each time*/
 
+    /* decoding and composition time tables, expanded per chunk on demand */
+    const MP4_Box_data_stts_t *p_stts;
+    const MP4_Box_data_ctts_t *p_ctts;
+    int64_t          i_cts_shift;
+
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
     uint64_t     i_first_dts;    /* i_first_dts value
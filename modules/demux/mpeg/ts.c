@@ -34,6 +34,7 @@
 #include <vlc_access.h>    /* DVB-specific things */
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_atomic.h>
 
 #include "ts_pid.h"
 #include "ts_streams.h"
@@ -46,12 +47,16 @@
 #include "ts_hotfixes.h"
 #include "ts_sl.h"
 #include "ts_metadata.h"
+#include "ts_index.h"
 #include "sections.h"
 #include "pes.h"
 #include "timestamps.h"
 
 #include "ts.h"
 
+/* Packets read ahead at once from fast seeking sources */
+#define TS_BATCH_MAX 128
+
 #include "../../codec/scte18.h"
 #include "../opus.h"
 #include "../../mux/mpeg/csa.h"
@@ -120,6 +125,16 @@ static void Close ( vlc_object_t * );
 #define TS_OFFSETFIX_TEXT   "Try to fix too early PCR (or late DTS)"
 #define TS_GENERATED_PCR_OFFSET_TEXT "Offset in ms for generated PCR"
 
+#define SEEK_INDEX_TEXT N_("Cache a seek index")
+#define SEEK_INDEX_LONGTEXT N_( \
+    "Remember the PCR positions of large local files, so that later seeks " \
+    "and duration lookups do not need to scan the file." )
+
+#define SI_THREAD_TEXT N_("Parse EPG on a separate thread")
+#define SI_THREAD_LONGTEXT N_( \
+    "Decode the Event Information Tables on a low priority thread, so that " \
+    "large EPG schedules do not delay the demuxing of live streams." )
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -157,6 +172,8 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
+    add_bool( "ts-seek-index", true, SEEK_INDEX_TEXT, SEEK_INDEX_LONGTEXT, true )
+    add_bool( "ts-si-thread", false, SI_THREAD_TEXT, SI_THREAD_LONGTEXT, true )
     add_bool( "ts-cc-check", true, CC_CHECK_TEXT, CC_CHECK_LONGTEXT, true )
     add_bool( "ts-pmtfix-waitdata", true, TS_SKIP_GHOST_PROGRAM_TEXT, NULL, true )
     add_bool( "ts-patfix", true, TS_PATFIX_TEXT, NULL, true )
@@ -196,9 +213,12 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static uint64_t TSTell( demux_sys_t * );
+static int TSSeek( demux_sys_t *, uint64_t );
+static void TSBatchDrop( demux_sys_t * );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
-static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
+static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t, bool );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 
 #define TS_PACKET_SIZE_188 188
@@ -404,6 +424,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->batch.p = NULL;
+    p_sys->batch.i_next = 0;
+    p_sys->batch.i_max = 1;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
 
@@ -532,6 +555,19 @@ static int Open( vlc_object_t *p_this )
     vlc_stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK,
                         &p_sys->b_canfastseek );
 
+    /* Live sources must not wait for more than one datagram worth of data */
+    if( p_sys->b_canfastseek )
+        p_sys->batch.i_max = TS_BATCH_MAX;
+    else if( !p_sys->b_lowdelay )
+        p_sys->batch.i_max = 7;
+
+    if( p_sys->b_canfastseek && !p_demux->b_preparsing &&
+        p_demux->psz_filepath && var_InheritBool( p_demux, "ts-seek-index" ) )
+        p_sys->p_index = ts_index_New( VLC_OBJECT(p_demux), p_demux->psz_filepath );
+
+    if( !p_demux->b_preparsing && var_InheritBool( p_demux, "ts-si-thread" ) )
+        p_sys->p_si_worker = ts_si_worker_New( p_demux );
+
     if( !p_sys->b_access_control && var_CreateGetBool( p_demux, "ts-pmtfix-waitdata" ) )
         p_sys->es_creation = DELAY_ES;
     else
@@ -562,8 +598,14 @@ static void Close( vlc_object_t *p_this )
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    TSBatchDrop( p_sys );
+    if( p_sys->p_si_worker )
+        ts_si_worker_Delete( p_sys->p_si_worker );
     PIDRelease( p_demux, GetPID(p_sys, 0) );
 
+    if( p_sys->p_index )
+        ts_index_Delete( p_this, p_sys->p_index );
+
     vlc_mutex_lock( &p_sys->csa_lock );
     if( p_sys->csa )
     {
@@ -635,6 +677,11 @@ static int Demux( demux_t *p_demux )
         GetPID(p_sys, 0)->u.p_pat->b_generated = true;
     }
 
+    if( p_sys->p_si_worker )
+        ts_si_worker_Drain( p_demux, p_sys->p_si_worker );
+
+    ts_stats_Tick( p_demux, vlc_tick_now() );
+
     /* We read at most 100 TS packet or until a frame is completed */
     for( unsigned i_pkt = 0; i_pkt < p_sys->i_ts_read; i_pkt++ )
     {
@@ -661,6 +708,13 @@ static int Demux( demux_t *p_demux )
             continue;
         }
 
+        /* Fast path for unselected streams, see UpdateDropFilter() */
+        if( ts_pid_bitmap_Get( p_sys->pids.drop, PIDGet( p_pkt ) ) )
+        {
+            block_Release( p_pkt );
+            continue;
+        }
+
         /* Reject any fully uncorrected packet. Even PID can be incorrect */
         if( p_pkt->p_buffer[1]&0x80 )
         {
@@ -672,6 +726,7 @@ static int Demux( demux_t *p_demux )
 
         /* Parse the TS packet */
         ts_pid_t *p_pid = GetPID( p_sys, PIDGet( p_pkt ) );
+        p_pid->stats.i_packets++;
         if( !SEEN(p_pid) )
         {
             if( p_pid->type == TYPE_FREE )
@@ -694,7 +749,8 @@ static int Demux( demux_t *p_demux )
         /* Adaptation field cannot be scrambled */
         stime_t i_pcr = GetPCR( p_pkt );
         if( i_pcr >= 0 )
-            PCRHandle( p_demux, p_pid, i_pcr );
+            PCRHandle( p_demux, p_pid, i_pcr,
+                       p_pkt->p_buffer[5] & 0x40 /* random access */ );
 
         /* Probe streams to build PAT/PMT after MIN_PAT_INTERVAL in case we don't see any PAT */
         if( !SEEN( GetPID( p_sys, 0 ) ) &&
@@ -812,6 +868,49 @@ static inline void HasSelectedES( es_out_t *out, const ts_es_t *p_es,
     }
 }
 
+/* Whether a PID carries PCR or belongs to any selected program */
+static bool PIDIsReferencedBySelection( const ts_pat_t *p_pat, uint16_t i_pid )
+{
+    for( int i=0; i< p_pat->programs.i_size; i++ )
+    {
+        const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+
+        if( p_pmt->i_pid_pcr == i_pid )
+            return true;
+        if( p_pmt->b_selected && PIDReferencedByProgram( p_pmt, i_pid ) )
+            return true;
+    }
+    return false;
+}
+
+/* Packets of streams from unselected programs can be dropped as soon as they
+ * are read, unless something else needs them: delayed ES creation, PCR, or
+ * the access doing the filtering already (then all its packets count) */
+static void UpdateDropFilter( demux_sys_t *p_sys, const ts_pat_t *p_pat )
+{
+    const bool b_can_drop = !p_sys->b_access_control &&
+                            p_sys->es_creation == CREATE_ES;
+
+    for( int i=0; i< p_pat->programs.i_size; i++ )
+    {
+        const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+
+        for( int j=0; j< p_pmt->e_streams.i_size; j++ )
+        {
+            ts_pid_t *espid = p_pmt->e_streams.p_elems[j];
+            const bool b_drop = b_can_drop && !p_pmt->b_selected &&
+                                espid->type == TYPE_STREAM &&
+                                !(espid->i_flags & FLAG_FILTERED) &&
+                                !PIDIsReferencedBySelection( p_pat, espid->i_pid );
+
+            /* Resume without a bogus discontinuity */
+            if( !b_drop && ts_pid_bitmap_Get( p_sys->pids.drop, espid->i_pid ) )
+                espid->i_cc = 0xff;
+            ts_pid_bitmap_Set( p_sys->pids.drop, espid->i_pid, b_drop );
+        }
+    }
+}
+
 void UpdatePESFilters( demux_t *p_demux, bool b_all )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -891,6 +990,8 @@ void UpdatePESFilters( demux_t *p_demux, bool b_all )
         }
         UpdateHWFilter( p_sys, GetPID(p_sys, p_pmt->i_pid_pcr) );
     }
+
+    UpdateDropFilter( p_sys, p_pat );
 }
 
 static int Control( demux_t *p_demux, int i_query, va_list args )
@@ -956,7 +1057,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TSTell( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -1003,7 +1104,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            TSSeek( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1089,6 +1190,9 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
     case DEMUX_SET_GROUP_ALL: // All ES Mode
     {
+        /* The whole MUX is parsed once and every ES carries its program
+         * number as group: per service outputs are built from a single
+         * instance with --sout-all and #duplicate{...,select="program=N"} */
         msg_Dbg( p_demux, "DEMUX_SET_GROUP_%s", "ALL" );
 
         ARRAY_RESET( p_sys->programs );
@@ -1149,9 +1253,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
+        TSBatchDrop( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
 
     case DEMUX_SET_SEEKPOINT:
+        TSBatchDrop( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
                                      args );
 
@@ -1183,6 +1289,9 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     case DEMUX_GET_SIGNAL:
         return vlc_stream_vaControl( p_sys->stream, STREAM_GET_SIGNAL, args );
 
+    case DEMUX_GET_TS_STATS:
+        return ts_stats_Get( p_demux, va_arg( args, vlc_ts_stats_t ** ) );
+
     case DEMUX_GET_ATTACHMENTS:
     {
         input_attachment_t ***ppp_attach = va_arg( args, input_attachment_t *** );
@@ -1545,6 +1654,7 @@ static void ParsePESDataChain( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes )
     const int i_max = block_ChainExtract( p_pes, header, 34 );
     if ( i_max < 4 )
     {
+        pid->stats.i_pes_errors++;
         block_ChainRelease( p_pes );
         return;
     }
@@ -1552,8 +1662,11 @@ static void ParsePESDataChain( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes )
     if( header[0] != 0 || header[1] != 0 || header[2] != 1 )
     {
         if ( !(p_pes->i_flags & BLOCK_FLAG_SCRAMBLED) )
+        {
             msg_Warn( p_demux, "invalid header [0x%02x:%02x:%02x:%02x] (pid: %d)",
                         header[0], header[1],header[2],header[3], pid->i_pid );
+            pid->stats.i_pes_errors++;
+        }
         block_ChainRelease( p_pes );
         return;
     }
@@ -1568,6 +1681,7 @@ static void ParsePESDataChain( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes )
     if( ParsePESHeader( VLC_OBJECT(p_demux), (uint8_t*)&header, i_max, &i_skip,
                         &i_dts, &i_pts, &i_stream_id, &b_pes_scrambling ) == VLC_EGENERIC )
     {
+        pid->stats.i_pes_errors++;
         block_ChainRelease( p_pes );
         return;
     }
@@ -1762,20 +1876,171 @@ static void PESDataChainHandle( vlc_object_t *p_obj, void *priv, block_t *p_data
     ParsePESDataChain( (demux_t *)p_obj, (ts_pid_t *) priv, p_data );
 }
 
+/*
+ * Packets are read ahead in batches, all in a single allocation. Each packet
+ * is handed out as a block slice keeping a reference to its batch, so that
+ * the usual chaining and release of packet blocks need no further change.
+ */
+struct ts_slice
+{
+    block_t     self;
+    ts_batch_t *p_batch;
+};
+
+struct ts_batch_t
+{
+    vlc_atomic_rc_t rc;
+    unsigned        i_count;
+    struct ts_slice slices[];
+    /* followed by the packets data */
+};
+
+static void TSBatchRelease( ts_batch_t *p_batch )
+{
+    if( vlc_atomic_rc_dec( &p_batch->rc ) )
+        free( p_batch );
+}
+
+static void TSSliceRelease( block_t *p_block )
+{
+    struct ts_slice *p_slice = container_of( p_block, struct ts_slice, self );
+
+    TSBatchRelease( p_slice->p_batch );
+}
+
+static const struct vlc_block_callbacks ts_slice_cbs =
+{
+    TSSliceRelease,
+};
+
+static void TSBatchDrop( demux_sys_t *p_sys )
+{
+    if( p_sys->batch.p )
+    {
+        TSBatchRelease( p_sys->batch.p );
+        p_sys->batch.p = NULL;
+    }
+}
+
+/* Stream position as seen by the demuxer, i.e. excluding read-ahead */
+static uint64_t TSTell( demux_sys_t *p_sys )
+{
+    uint64_t i_pos = vlc_stream_Tell( p_sys->stream );
+
+    if( p_sys->batch.p )
+        i_pos -= (uint64_t)( p_sys->batch.p->i_count - p_sys->batch.i_next )
+                 * p_sys->i_packet_size;
+    return i_pos;
+}
+
+static int TSSeek( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    TSBatchDrop( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+static bool TSBatchFill( demux_sys_t *p_sys )
+{
+    const size_t i_size = p_sys->i_packet_size;
+    const uint8_t *p_peek;
+
+    ssize_t i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
+                                      i_size * p_sys->batch.i_max );
+    if( i_peek < (ssize_t)i_size )
+        return false;
+
+    /* Only take packets in sync. The slow path deals with anything else. */
+    unsigned i_count = 0;
+    const uint8_t *p_sync = &p_peek[p_sys->i_packet_header_size];
+    const uint8_t *p_end = &p_peek[i_peek - i_size];
+
+    while( p_sync <= p_end && *p_sync == 0x47 )
+    {
+        p_sync += i_size;
+        i_count++;
+    }
+    if( i_count == 0 )
+        return false;
+
+    ts_batch_t *p_batch = malloc( sizeof(*p_batch) +
+                                  i_count * (sizeof(p_batch->slices[0]) + i_size) );
+    if( unlikely(p_batch == NULL) )
+        return false;
+
+    uint8_t *p_data = (uint8_t *) &p_batch->slices[i_count];
+    if( vlc_stream_Read( p_sys->stream, p_data, i_count * i_size )
+            != (ssize_t)(i_count * i_size) )
+    {
+        free( p_batch );
+        return false;
+    }
+
+    /* Descramble the whole batch at once. ProcessTSPacket() will see
+     * these packets as clear. */
+    if( p_sys->csa )
+    {
+        uint8_t *pp_scrambled[TS_BATCH_MAX];
+        unsigned i_scrambled = 0;
+
+        for( unsigned i = 0; i < i_count; i++ )
+        {
+            uint8_t *p = &p_data[i * i_size + p_sys->i_packet_header_size];
+            if( (p[3] & 0x80) && ((p[1] & 0x1f) << 8 | p[2]) != 0x1FFF )
+                pp_scrambled[i_scrambled++] = p;
+        }
+
+        if( i_scrambled > 0 )
+        {
+            vlc_mutex_lock( &p_sys->csa_lock );
+            csa_DecryptBatch( p_sys->csa, pp_scrambled, i_scrambled,
+                              p_sys->i_csa_pkt_size );
+            vlc_mutex_unlock( &p_sys->csa_lock );
+        }
+    }
+
+    vlc_atomic_rc_init( &p_batch->rc );
+    p_batch->i_count = i_count;
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        block_Init( &p_batch->slices[i].self, &ts_slice_cbs,
+                    &p_data[i * i_size], i_size );
+        p_batch->slices[i].p_batch = p_batch;
+    }
+
+    p_sys->batch.p = p_batch;
+    p_sys->batch.i_next = 0;
+    return true;
+}
+
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
     block_t     *p_pkt;
 
+    if( p_sys->batch.p && p_sys->batch.i_next == p_sys->batch.p->i_count )
+        TSBatchDrop( p_sys );
+
+    if( p_sys->batch.p || TSBatchFill( p_sys ) )
+    {
+        ts_batch_t *p_batch = p_sys->batch.p;
+
+        vlc_atomic_rc_inc( &p_batch->rc );
+        p_pkt = &p_batch->slices[p_sys->batch.i_next++].self;
+        /* Sync byte was checked when filling the batch */
+        p_pkt->p_buffer += p_sys->i_packet_header_size;
+        p_pkt->i_buffer -= p_sys->i_packet_header_size;
+        return p_pkt;
+    }
+
     /* Get a new TS packet */
     if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
     {
         int64_t size = stream_Size( p_sys->stream );
-        if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
-            msg_Dbg( p_demux, "EOF at %"PRIu64, vlc_stream_Tell( p_sys->stream ) );
+        if( size >= 0 && (uint64_t)size == TSTell( p_sys ) )
+            msg_Dbg( p_demux, "EOF at %"PRIu64, TSTell( p_sys ) );
         else
-            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, TSTell( p_sys ) );
         return NULL;
     }
 
@@ -1946,13 +2211,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return TSSeek( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSTell( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1960,6 +2225,25 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
     if( i_head_pos >= i_tail_pos )
         return VLC_EGENERIC;
 
+    /* Narrow down the search using the cached index */
+    uint64_t i_index_head, i_index_tail;
+    stime_t i_index_time;
+    bool b_rap;
+    if( p_sys->p_index &&
+        ts_index_Find( p_sys->p_index, p_pmt->i_number, i_scaledtime,
+                       &i_index_head, &i_index_time, &b_rap, &i_index_tail ) )
+    {
+        if( i_index_time >= 0 &&
+            i_scaledtime - i_index_time < TO_SCALE(VLC_TICK_0 + VLC_TICK_FROM_MS(500)) &&
+            i_index_head < i_tail_pos )
+            return TSSeek( p_sys, i_index_head );
+
+        if( i_index_head < i_tail_pos )
+            i_head_pos = i_index_head;
+        if( i_index_tail < i_tail_pos && i_index_tail > i_head_pos )
+            i_tail_pos = i_index_tail;
+    }
+
     bool b_found = false;
     while( (i_head_pos + p_sys->i_packet_size) <= i_tail_pos && !b_found )
     {
@@ -1968,7 +2252,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( TSSeek( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1982,7 +2266,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TSTell( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -2039,7 +2323,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
+        if( TSSeek( p_sys, i_initial_pos ) != VLC_SUCCESS )
             msg_Err( p_demux, "Can't seek back to %" PRIu64, i_initial_pos );
         return VLC_EGENERIC;
     }
@@ -2121,7 +2405,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_
                         if( b_end )
                         {
                             p_pmt->i_last_dts = *pi_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TSTell( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2149,7 +2433,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, stime_t *pi_
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2162,7 +2446,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TSSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, false, &i_pcr, &b_found );
@@ -2172,7 +2456,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TSSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2181,7 +2465,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TSTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2189,12 +2473,35 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     stime_t i_pcr = -1;
     bool b_found = false;
 
+    /* The index already reached the end of the file in a previous session */
+    if( p_sys->p_index && i_program != 0 &&
+        GetPID(p_sys, 0)->type == TYPE_PAT )
+    {
+        uint64_t i_last_pos;
+        ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
+        ts_pmt_t *p_pmt = NULL;
+        for( int i=0; i<p_pat->programs.i_size && !p_pmt; i++ )
+            if( p_pat->programs.p_elems[i]->u.p_pmt->i_number == i_program )
+                p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+
+        if( p_pmt &&
+            ts_index_GetLast( p_sys->p_index, i_program, &i_pcr, &i_last_pos ) &&
+            i_last_pos + (uint64_t)p_sys->i_packet_size * PROBE_CHUNK_COUNT >=
+            (uint64_t) i_stream_size )
+        {
+            p_pmt->i_last_dts = i_pcr;
+            p_pmt->i_last_dts_byte = i_last_pos + p_sys->i_packet_size;
+            return VLC_SUCCESS;
+        }
+        i_pcr = -1;
+    }
+
     do
     {
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TSSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, true, &i_pcr, &b_found );
@@ -2204,7 +2511,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TSSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2255,14 +2562,14 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TSTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TSTell( p_sys );
             }
         }
     }
@@ -2356,7 +2663,15 @@ static void PCRCheckDTS( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr)
     }
 }
 
-static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
+static void PCRIndex( demux_sys_t *p_sys, const ts_pmt_t *p_pmt,
+                      stime_t i_program_pcr, bool b_rap )
+{
+    if( p_sys->p_index && p_pmt->pcr.i_first != -1 )
+        ts_index_Add( p_sys->p_index, p_pmt->i_number, i_program_pcr,
+                      TSTell( p_sys ) - p_sys->i_packet_size, b_rap );
+}
+
+static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr, bool b_rap )
 {
     demux_sys_t   *p_sys = p_demux->p_sys;
 
@@ -2370,6 +2685,7 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
 
     /* Search program and set the PCR */
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
+    const vlc_tick_t i_now = vlc_tick_now();
     for( int i = 0; i < p_pat->programs.i_size; i++ )
     {
         ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
@@ -2383,6 +2699,8 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
             {
                 /* ? update PCR for the whole group program ? */
                 ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
+                PCRIndex( p_sys, p_pmt, i_program_pcr, b_rap );
+                ts_pcr_stats_Update( &p_pmt->pcr_stats, i_program_pcr, i_now );
             }
         }
         else /* set PCR provided by current pid to program(s) referencing it */
@@ -2393,6 +2711,8 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
                 /* We've found a target group for update */
                 PCRCheckDTS( p_demux, p_pmt, i_pcr );
                 ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
+                PCRIndex( p_sys, p_pmt, i_program_pcr, b_rap );
+                ts_pcr_stats_Update( &p_pmt->pcr_stats, i_program_pcr, i_now );
             }
         }
 
@@ -2590,6 +2910,7 @@ static block_t * ProcessTSPacket( demux_t *p_demux, ts_pid_t *pid, block_t *p_pk
                 msg_Warn( p_demux, "discontinuity received 0x%x instead of 0x%x (pid=%d)",
                           i_cc, ( pid->i_cc + 1 )&0x0f, pid->i_pid );
 
+                pid->stats.i_cc_errors++;
                 pid->i_cc = i_cc;
                 pid->i_dup = 0;
                 p_pkt->i_flags |= BLOCK_FLAG_DISCONTINUITY;
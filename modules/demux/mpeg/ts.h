@@ -51,6 +51,10 @@ typedef struct
     int i_service;
 } vdr_info_t;
 
+typedef struct ts_batch_t ts_batch_t;
+typedef struct ts_index_t ts_index_t;
+typedef struct ts_si_worker_t ts_si_worker_t;
+
 struct demux_sys_t
 {
     stream_t   *stream;
@@ -71,6 +75,26 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Packets read ahead in a single buffer, see ReadTSPacket() */
+    struct
+    {
+        ts_batch_t *p;
+        unsigned    i_next;
+        unsigned    i_max;
+    } batch;
+
+    /* Persistent PCR/offset index of local files, see ts_index.h */
+    ts_index_t *p_index;
+
+    /* EIT parsing thread, see ts_si.h */
+    ts_si_worker_t *p_si_worker;
+
+    /* Statistics, see ts_stats.h */
+    struct
+    {
+        vlc_tick_t i_window_start;
+    } stats;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -0,0 +1,467 @@
+/*****************************************************************************
+ * ts_index.c: TS demuxer persistent PCR index
+ *****************************************************************************
+ * Copyright (C) 2021 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_configuration.h>
+
+#include <sys/stat.h>
+#include <errno.h>
+
+#include "timestamps.h"
+#include "ts_index.h"
+
+/*
+ * The index is a sparse, position ordered, list of (program time, offset)
+ * pairs per program, built from the PCRs met while playing. It is stored in
+ * the user cache directory, keyed on the file path, size and modification
+ * time, so that later sessions can seek without bisecting the file.
+ *
+ * File layout, all big endian:
+ *  "VLCTSIX1", file size (64), mtime (64), programs count (32)
+ *  then for each program:
+ *   number (32), broken flag (32), entries count (64)
+ *   entries: time (64), offset (64, MSB set for random access points)
+ */
+#define TS_INDEX_MAGIC "VLCTSIX1"
+#define TS_INDEX_RAP   (UINT64_C(1) << 63)
+#define TS_INDEX_MIN_SIZE (INT64_C(256) << 20)
+
+typedef struct
+{
+    stime_t  i_time;
+    uint64_t i_pos;
+    bool     b_rap;
+} ts_index_entry_t;
+
+typedef struct
+{
+    int     i_number;
+    bool    b_broken; /* time is not monotonic within the file */
+    size_t  i_count;
+    size_t  i_alloc;
+    ts_index_entry_t *p_entries;
+} ts_index_program_t;
+
+struct ts_index_t
+{
+    char    *psz_cache;
+    uint64_t i_size;
+    int64_t  i_mtime;
+    bool     b_dirty;
+
+    size_t   i_programs;
+    ts_index_program_t *p_programs;
+};
+
+static ts_index_program_t * GetProgram( const ts_index_t *p_index,
+                                        int i_number )
+{
+    for( size_t i = 0; i < p_index->i_programs; i++ )
+        if( p_index->p_programs[i].i_number == i_number )
+            return &p_index->p_programs[i];
+    return NULL;
+}
+
+static ts_index_program_t * AddProgram( ts_index_t *p_index, int i_number )
+{
+    ts_index_program_t *p_programs =
+        realloc( p_index->p_programs,
+                 (p_index->i_programs + 1) * sizeof(*p_programs) );
+    if( unlikely(p_programs == NULL) )
+        return NULL;
+
+    p_index->p_programs = p_programs;
+
+    ts_index_program_t *p_prog = &p_programs[p_index->i_programs++];
+    p_prog->i_number = i_number;
+    p_prog->b_broken = false;
+    p_prog->i_count = 0;
+    p_prog->i_alloc = 0;
+    p_prog->p_entries = NULL;
+    return p_prog;
+}
+
+static bool ReadU32( FILE *p_file, uint32_t *pi )
+{
+    uint8_t buf[4];
+    if( fread( buf, sizeof(buf), 1, p_file ) != 1 )
+        return false;
+    *pi = GetDWBE( buf );
+    return true;
+}
+
+static bool ReadU64( FILE *p_file, uint64_t *pi )
+{
+    uint8_t buf[8];
+    if( fread( buf, sizeof(buf), 1, p_file ) != 1 )
+        return false;
+    *pi = GetQWBE( buf );
+    return true;
+}
+
+static bool WriteU32( FILE *p_file, uint32_t i )
+{
+    uint8_t buf[4];
+    SetDWBE( buf, i );
+    return fwrite( buf, sizeof(buf), 1, p_file ) == 1;
+}
+
+static bool WriteU64( FILE *p_file, uint64_t i )
+{
+    uint8_t buf[8];
+    SetQWBE( buf, i );
+    return fwrite( buf, sizeof(buf), 1, p_file ) == 1;
+}
+
+static void Load( ts_index_t *p_index )
+{
+    FILE *p_file = vlc_fopen( p_index->psz_cache, "rb" );
+    if( p_file == NULL )
+        return;
+
+    char magic[8];
+    uint64_t i_size, i_mtime;
+    uint32_t i_programs;
+
+    if( fread( magic, sizeof(magic), 1, p_file ) != 1 ||
+        memcmp( magic, TS_INDEX_MAGIC, sizeof(magic) ) ||
+        !ReadU64( p_file, &i_size ) || i_size != p_index->i_size ||
+        !ReadU64( p_file, &i_mtime ) || (int64_t)i_mtime != p_index->i_mtime ||
+        !ReadU32( p_file, &i_programs ) )
+        goto end;
+
+    for( uint32_t i = 0; i < i_programs; i++ )
+    {
+        uint32_t i_number, i_broken;
+        uint64_t i_count;
+
+        if( !ReadU32( p_file, &i_number ) || !ReadU32( p_file, &i_broken ) ||
+            !ReadU64( p_file, &i_count ) || i_count > i_size / 188 )
+            goto error;
+
+        ts_index_program_t *p_prog = AddProgram( p_index, (int) i_number );
+        if( p_prog == NULL )
+            goto error;
+        p_prog->b_broken = i_broken != 0;
+
+        if( i_count == 0 )
+            continue;
+
+        p_prog->p_entries = vlc_alloc( i_count, sizeof(*p_prog->p_entries) );
+        if( p_prog->p_entries == NULL )
+            goto error;
+        p_prog->i_alloc = i_count;
+
+        for( uint64_t j = 0; j < i_count; j++ )
+        {
+            uint64_t i_time, i_pos;
+
+            if( !ReadU64( p_file, &i_time ) || !ReadU64( p_file, &i_pos ) )
+                goto error;
+
+            ts_index_entry_t *p_entry = &p_prog->p_entries[p_prog->i_count++];
+            p_entry->i_time = (stime_t) i_time;
+            p_entry->i_pos = i_pos & ~TS_INDEX_RAP;
+            p_entry->b_rap = i_pos & TS_INDEX_RAP;
+        }
+    }
+    goto end;
+
+error:
+    /* Corrupted: start over */
+    for( size_t i = 0; i < p_index->i_programs; i++ )
+        free( p_index->p_programs[i].p_entries );
+    free( p_index->p_programs );
+    p_index->p_programs = NULL;
+    p_index->i_programs = 0;
+end:
+    fclose( p_file );
+}
+
+static void CreateDirs( const char *psz_path )
+{
+    char psz_dir[strlen( psz_path ) + 1];
+    strcpy( psz_dir, psz_path );
+
+    for( char *psz = psz_dir + 1; *psz; psz++ )
+    {
+        if( *psz != DIR_SEP_CHAR )
+            continue;
+        *psz = '\0';
+        vlc_mkdir( psz_dir, 0700 );
+        *psz = DIR_SEP_CHAR;
+    }
+}
+
+static bool Save( const ts_index_t *p_index, FILE *p_file )
+{
+    if( fwrite( TS_INDEX_MAGIC, 8, 1, p_file ) != 1 ||
+        !WriteU64( p_file, p_index->i_size ) ||
+        !WriteU64( p_file, p_index->i_mtime ) ||
+        !WriteU32( p_file, p_index->i_programs ) )
+        return false;
+
+    for( size_t i = 0; i < p_index->i_programs; i++ )
+    {
+        const ts_index_program_t *p_prog = &p_index->p_programs[i];
+
+        if( !WriteU32( p_file, p_prog->i_number ) ||
+            !WriteU32( p_file, p_prog->b_broken ) ||
+            !WriteU64( p_file, p_prog->i_count ) )
+            return false;
+
+        for( size_t j = 0; j < p_prog->i_count; j++ )
+        {
+            const ts_index_entry_t *p_entry = &p_prog->p_entries[j];
+
+            if( !WriteU64( p_file, p_entry->i_time ) ||
+                !WriteU64( p_file, p_entry->i_pos |
+                                   (p_entry->b_rap ? TS_INDEX_RAP : 0) ) )
+                return false;
+        }
+    }
+    return true;
+}
+
+ts_index_t * ts_index_New( vlc_object_t *p_obj, const char *psz_filepath )
+{
+    struct stat st;
+
+    /* Small files are bisected fast enough */
+    if( psz_filepath == NULL || vlc_stat( psz_filepath, &st ) ||
+        !S_ISREG( st.st_mode ) || st.st_size < TS_INDEX_MIN_SIZE )
+        return NULL;
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir == NULL )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_filepath, strlen( psz_filepath ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    ts_index_t *p_index = malloc( sizeof(*p_index) );
+    if( unlikely(psz_hash == NULL || p_index == NULL) ||
+        asprintf( &p_index->psz_cache, "%s" DIR_SEP "ts-index" DIR_SEP "%s",
+                  psz_cachedir, psz_hash ) == -1 )
+    {
+        free( p_index );
+        free( psz_hash );
+        free( psz_cachedir );
+        return NULL;
+    }
+    free( psz_hash );
+    free( psz_cachedir );
+
+    p_index->i_size = st.st_size;
+    p_index->i_mtime = st.st_mtime;
+    p_index->b_dirty = false;
+    p_index->i_programs = 0;
+    p_index->p_programs = NULL;
+
+    Load( p_index );
+    if( p_index->i_programs > 0 )
+        msg_Dbg( p_obj, "using seek index %s", p_index->psz_cache );
+    return p_index;
+}
+
+void ts_index_Delete( vlc_object_t *p_obj, ts_index_t *p_index )
+{
+    if( p_index->b_dirty )
+    {
+        char *psz_tmp;
+
+        CreateDirs( p_index->psz_cache );
+        if( asprintf( &psz_tmp, "%s.tmp", p_index->psz_cache ) != -1 )
+        {
+            FILE *p_file = vlc_fopen( psz_tmp, "wb" );
+            if( p_file != NULL )
+            {
+                bool b_ok = Save( p_index, p_file );
+
+                if( fclose( p_file ) == 0 && b_ok &&
+                    vlc_rename( psz_tmp, p_index->psz_cache ) == 0 )
+                    msg_Dbg( p_obj, "saved seek index %s",
+                             p_index->psz_cache );
+                else
+                    vlc_unlink( psz_tmp );
+            }
+            else
+                msg_Dbg( p_obj, "cannot save seek index: %s",
+                         vlc_strerror_c(errno) );
+            free( psz_tmp );
+        }
+    }
+
+    for( size_t i = 0; i < p_index->i_programs; i++ )
+        free( p_index->p_programs[i].p_entries );
+    free( p_index->p_programs );
+    free( p_index->psz_cache );
+    free( p_index );
+}
+
+/* Returns the index of the first entry located after i_pos */
+static size_t FindPos( const ts_index_program_t *p_prog, uint64_t i_pos )
+{
+    size_t lo = 0, hi = p_prog->i_count;
+
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if( p_prog->p_entries[mid].i_pos <= i_pos )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void ts_index_Add( ts_index_t *p_index, int i_program, stime_t i_time,
+                   uint64_t i_pos, bool b_rap )
+{
+    ts_index_program_t *p_prog = GetProgram( p_index, i_program );
+    if( p_prog == NULL )
+    {
+        p_prog = AddProgram( p_index, i_program );
+        if( p_prog == NULL )
+            return;
+    }
+
+    if( p_prog->b_broken )
+        return;
+
+    size_t k = FindPos( p_prog, i_pos );
+    const ts_index_entry_t *p_prev = k > 0 ? &p_prog->p_entries[k - 1] : NULL;
+    const ts_index_entry_t *p_next = k < p_prog->i_count ?
+                                     &p_prog->p_entries[k] : NULL;
+
+    if( p_prev && p_prev->i_pos == i_pos )
+        return;
+
+    /* Time discontinuities (concatenated files, PCR resets...) make the
+     * file unsuitable to time lookups. Keep this decision persistent. */
+    if( (p_prev && i_time < p_prev->i_time) ||
+        (p_next && i_time > p_next->i_time) )
+    {
+        p_prog->b_broken = true;
+        p_index->b_dirty = true;
+        return;
+    }
+
+    /* Keep the index sparse, but do not miss random access points */
+    if( p_prev && i_time - p_prev->i_time < TS_INDEX_INTERVAL &&
+        !(b_rap && !p_prev->b_rap) )
+        return;
+    if( p_next && p_next->i_time - i_time < TS_INDEX_INTERVAL &&
+        !(b_rap && !p_next->b_rap) )
+        return;
+
+    if( p_prog->i_count == p_prog->i_alloc )
+    {
+        size_t i_alloc = p_prog->i_alloc ? p_prog->i_alloc * 2 : 256;
+        ts_index_entry_t *p_entries =
+            vlc_reallocarray( p_prog->p_entries, i_alloc,
+                              sizeof(*p_entries) );
+        if( unlikely(p_entries == NULL) )
+            return;
+        p_prog->p_entries = p_entries;
+        p_prog->i_alloc = i_alloc;
+    }
+
+    memmove( &p_prog->p_entries[k + 1], &p_prog->p_entries[k],
+             (p_prog->i_count - k) * sizeof(*p_prog->p_entries) );
+    p_prog->p_entries[k].i_time = i_time;
+    p_prog->p_entries[k].i_pos = i_pos;
+    p_prog->p_entries[k].b_rap = b_rap;
+    p_prog->i_count++;
+    p_index->b_dirty = true;
+}
+
+bool ts_index_Find( const ts_index_t *p_index, int i_program, stime_t i_time,
+                    uint64_t *pi_head, stime_t *pi_head_time, bool *pb_rap,
+                    uint64_t *pi_tail )
+{
+    const ts_index_program_t *p_prog = GetProgram( p_index, i_program );
+    if( p_prog == NULL || p_prog->b_broken || p_prog->i_count == 0 )
+        return false;
+
+    /* Last entry at or before the requested time */
+    size_t lo = 0, hi = p_prog->i_count;
+    while( lo < hi )
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if( p_prog->p_entries[mid].i_time <= i_time )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    *pi_tail = lo < p_prog->i_count ? p_prog->p_entries[lo].i_pos
+                                    : UINT64_MAX;
+    if( lo == 0 )
+    {
+        *pi_head = 0;
+        *pi_head_time = -1;
+        *pb_rap = false;
+        return true;
+    }
+
+    size_t k = lo - 1;
+
+    /* Prefer a close enough random access point */
+    for( size_t j = k + 1; j-- > 0; )
+    {
+        const ts_index_entry_t *p_entry = &p_prog->p_entries[j];
+
+        if( i_time - p_entry->i_time >= 2 * TS_INDEX_INTERVAL )
+            break;
+        if( p_entry->b_rap )
+        {
+            *pi_head = p_entry->i_pos;
+            *pi_head_time = p_entry->i_time;
+            *pb_rap = true;
+            return true;
+        }
+    }
+
+    *pi_head = p_prog->p_entries[k].i_pos;
+    *pi_head_time = p_prog->p_entries[k].i_time;
+    *pb_rap = false;
+    return true;
+}
+
+bool ts_index_GetLast( const ts_index_t *p_index, int i_program,
+                       stime_t *pi_time, uint64_t *pi_pos )
+{
+    const ts_index_program_t *p_prog = GetProgram( p_index, i_program );
+    if( p_prog == NULL || p_prog->b_broken || p_prog->i_count == 0 )
+        return false;
+
+    const ts_index_entry_t *p_last = &p_prog->p_entries[p_prog->i_count - 1];
+    *pi_time = p_last->i_time;
+    *pi_pos = p_last->i_pos;
+    return true;
+}
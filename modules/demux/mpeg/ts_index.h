@@ -0,0 +1,47 @@
+/*****************************************************************************
+ * ts_index.h: TS demuxer persistent PCR index
+ *****************************************************************************
+ * Copyright (C) 2021 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+/* Minimum spacing between two entries of a program, in 90kHz units */
+#define TS_INDEX_INTERVAL (90000 / 2)
+
+typedef struct ts_index_t ts_index_t;
+
+/* Loads the index of a file from the cache, or returns an empty one.
+ * Returns NULL if the file cannot be indexed. */
+ts_index_t * ts_index_New( vlc_object_t *, const char *psz_filepath );
+/* Saves the index to the cache if it changed, then destroys it */
+void ts_index_Delete( vlc_object_t *, ts_index_t * );
+
+/* Times are program times, i.e. already wrapped around the first PCR */
+void ts_index_Add( ts_index_t *, int i_program, stime_t i_time,
+                   uint64_t i_pos, bool b_rap );
+
+/* Finds the byte range containing a time: *pi_head is the position of the
+ * closest entry before, *pi_tail the one after (or UINT64_MAX).
+ * *pb_rap tells whether *pi_head is a random access point. */
+bool ts_index_Find( const ts_index_t *, int i_program, stime_t i_time,
+                    uint64_t *pi_head, stime_t *pi_head_time, bool *pb_rap,
+                    uint64_t *pi_tail );
+
+bool ts_index_GetLast( const ts_index_t *, int i_program,
+                       stime_t *pi_time, uint64_t *pi_pos );
+
+#endif
@@ -44,6 +44,8 @@ void ts_pid_list_Init( ts_pid_list_t *p_list )
     p_list->i_all_alloc = 0;
     p_list->i_last_pid = 0;
     p_list->p_last = NULL;
+    memset( p_list->drop, 0, sizeof(p_list->drop) );
+    memset( p_list->hw, 0, sizeof(p_list->hw) );
 }
 
 void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
@@ -317,12 +319,25 @@ int UpdateHWFilter( demux_sys_t *p_sys, ts_pid_t *p_pid )
     if( !p_sys->b_access_control )
         return VLC_EGENERIC;
 
-    return vlc_stream_Control( p_sys->stream, STREAM_SET_PRIVATE_ID_STATE,
-                           p_pid->i_pid, !!(p_pid->i_flags & FLAG_FILTERED) );
+    const bool b_selected = p_pid->i_flags & FLAG_FILTERED;
+
+    /* Filters are committed for every PID of every program on each update:
+     * don't bother the access (and the device) if nothing changed. */
+    if( ts_pid_bitmap_Get( p_sys->pids.hw, p_pid->i_pid ) == b_selected )
+        return VLC_SUCCESS;
+
+    int i_ret = vlc_stream_Control( p_sys->stream, STREAM_SET_PRIVATE_ID_STATE,
+                                    p_pid->i_pid, b_selected );
+    if( i_ret == VLC_SUCCESS )
+        ts_pid_bitmap_Set( p_sys->pids.hw, p_pid->i_pid, b_selected );
+    return i_ret;
 }
 
 int SetPIDFilter( demux_sys_t *p_sys, ts_pid_t *p_pid, bool b_selected )
 {
+    /* Explicit change: never drop this PID until filters are recomputed */
+    ts_pid_bitmap_Set( p_sys->pids.drop, p_pid->i_pid, false );
+
     if( b_selected )
         p_pid->i_flags |= FLAG_FILTERED;
     else
@@ -25,6 +25,7 @@
 #define MAX_ES_PID 8190
 
 #include "ts_streams.h"
+#include "ts_stats.h"
 
 typedef struct demux_sys_t demux_sys_t;
 
@@ -82,6 +83,8 @@ struct ts_pid_t
         uint8_t i_stream_id;
     } probed;
 
+    ts_pid_stats_t stats;
+
 };
 
 struct ts_pid_list_t
@@ -97,8 +100,25 @@ struct ts_pid_list_t
     uint16_t   i_last_pid;
     ts_pid_t  *p_last;
 
+    /* PIDs ignored before any parsing, see UpdatePESFilters() */
+    uint32_t   drop[8192 / 32];
+    /* PIDs enabled in the access filter (when access controlled) */
+    uint32_t   hw[8192 / 32];
 };
 
+static inline bool ts_pid_bitmap_Get( const uint32_t *p_map, uint16_t i_pid )
+{
+    return p_map[i_pid >> 5] & (UINT32_C(1) << (i_pid & 31));
+}
+
+static inline void ts_pid_bitmap_Set( uint32_t *p_map, uint16_t i_pid, bool b )
+{
+    if( b )
+        p_map[i_pid >> 5] |= UINT32_C(1) << (i_pid & 31);
+    else
+        p_map[i_pid >> 5] &= ~(UINT32_C(1) << (i_pid & 31));
+}
+
 /* opacified pid list */
 void ts_pid_list_Init( ts_pid_list_t * );
 void ts_pid_list_Release( demux_t *, ts_pid_list_t * );
@@ -37,6 +37,7 @@
 #include <dvbpsi/tot.h> /* TDT support */
 #include <dvbpsi/dr.h>
 #include <dvbpsi/psi.h>
+#include "../../mux/mpeg/dvbpsi_compat.h" /* dvbpsi_messages */
 
 #include "ts_si.h"
 #include "ts_arib.h"
@@ -67,25 +68,51 @@
     } while(0);
 #endif
 
+/* Demuxer state the EIT parser depends on */
+typedef struct
+{
+    ts_standards_e standard;
+    bool           b_broken_charset;
+    time_t         i_network_time;
+} eit_context_t;
+
+static void SIGetContext( const demux_sys_t *p_sys, eit_context_t *ctx )
+{
+    ctx->standard = p_sys->standard;
+    ctx->b_broken_charset = p_sys->b_broken_charset;
+    ctx->i_network_time = p_sys->i_network_time;
+}
 
 static void SINewTableCallBack( dvbpsi_t *h, uint8_t i_table_id,
                                 uint16_t i_extension, void *p_pid_cbdata );
+static void ts_si_worker_Push( ts_si_worker_t *, const demux_sys_t *,
+                               const uint8_t * );
 
 void ts_si_Packet_Push( ts_pid_t *p_pid, const uint8_t *p_pktbuffer )
 {
     if( likely(p_pid->type == TYPE_SI) &&
         dvbpsi_decoder_present( p_pid->u.p_si->handle ) )
-        dvbpsi_packet_push( p_pid->u.p_si->handle, (uint8_t *) p_pktbuffer );
+    {
+        demux_t *p_demux = (demux_t *) p_pid->u.p_si->handle->p_sys;
+        demux_sys_t *p_sys = p_demux->p_sys;
+
+        /* ARIB strings decoding state belongs to the input thread */
+        if( p_sys->p_si_worker && p_pid->i_pid == TS_SI_EIT_PID &&
+            p_sys->standard != TS_STANDARD_ARIB )
+            ts_si_worker_Push( p_sys->p_si_worker, p_sys, p_pktbuffer );
+        else
+            dvbpsi_packet_push( p_pid->u.p_si->handle, (uint8_t *) p_pktbuffer );
+    }
 }
 
-static char *EITConvertToUTF8( demux_t *p_demux,
-                               const unsigned char *psz_instring,
-                               size_t i_length,
-                               bool b_broken )
+static char *SIConvertToUTF8( demux_t *p_demux, ts_standards_e standard,
+                              const unsigned char *psz_instring,
+                              size_t i_length,
+                              bool b_broken )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 #ifdef HAVE_ARIBB24
-    if( p_sys->standard == TS_STANDARD_ARIB )
+    if( standard == TS_STANDARD_ARIB )
     {
         if ( !p_sys->arib.p_instance )
             p_sys->arib.p_instance = arib_instance_new( p_demux );
@@ -112,6 +139,7 @@ static char *EITConvertToUTF8( demux_t *p_demux,
     }
 #else
     VLC_UNUSED(p_sys);
+    VLC_UNUSED(standard);
 #endif
     /* Deal with no longer broken providers (no switch byte
       but sending ISO_8859-1 instead of ISO_6937) without
@@ -125,6 +153,16 @@ static char *EITConvertToUTF8( demux_t *p_demux,
     return vlc_from_EIT( psz_instring, i_length );
 }
 
+static char *EITConvertToUTF8( demux_t *p_demux,
+                               const unsigned char *psz_instring,
+                               size_t i_length,
+                               bool b_broken )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    return SIConvertToUTF8( p_demux, p_sys->standard,
+                            psz_instring, i_length, b_broken );
+}
+
 #define attach_SI_decoders(i_pid, name, member) do {\
     ts_pid_t *pid = GetPID(p_sys, i_pid);\
     if ( PIDSetup( p_demux, TYPE_SI, pid, NULL ) )\
@@ -402,11 +440,10 @@ static void TDTCallBack( demux_t *p_demux, dvbpsi_tot_t *p_tdt )
     es_out_Control( p_demux->out, ES_OUT_SET_EPG_TIME, (int64_t) p_sys->i_network_time );
 }
 
-static void EITExtractDrDescItems( demux_t *p_demux, const dvbpsi_extended_event_dr_t *pE,
+static void EITExtractDrDescItems( demux_t *p_demux, const eit_context_t *ctx,
+                                   const dvbpsi_extended_event_dr_t *pE,
                                    vlc_epg_event_t *p_evt )
 {
-    demux_sys_t *p_sys = p_demux->p_sys;
-
     if( pE->i_entry_count )
     {
         char **ppsz_prev = NULL;
@@ -435,10 +472,10 @@ static void EITExtractDrDescItems( demux_t *p_demux, const dvbpsi_extended_event
                 }
                 p_evt->description_items = p_realloc;
 
-                psz_key = EITConvertToUTF8( p_demux,
+                psz_key = SIConvertToUTF8( p_demux, ctx->standard,
                                             pE->i_item_description[i],
                                             pE->i_item_description_length[i],
-                                            p_sys->b_broken_charset );
+                                            ctx->b_broken_charset );
                 if( !psz_key )
                 {
                     ppsz_prev = NULL;
@@ -448,9 +485,9 @@ static void EITExtractDrDescItems( demux_t *p_demux, const dvbpsi_extended_event
             else if( ppsz_prev == NULL )
                 continue;
 
-            char *psz_itm = EITConvertToUTF8( p_demux,
+            char *psz_itm = SIConvertToUTF8( p_demux, ctx->standard,
                                               pE->i_item[i], pE->i_item_length[i],
-                                              p_sys->b_broken_charset );
+                                              ctx->b_broken_charset );
             if( !psz_itm )
             {
                 free( psz_key );
@@ -483,21 +520,16 @@ static void EITExtractDrDescItems( demux_t *p_demux, const dvbpsi_extended_event
     }
 }
 
-static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
+/* Builds the EPG of a table. Thread-safe: only reads the demuxer state through
+ * the context. */
+static vlc_epg_t * EITParse( demux_t *p_demux, const eit_context_t *ctx,
+                             const dvbpsi_eit_t *p_eit )
 {
-    demux_sys_t        *p_sys = p_demux->p_sys;
     const dvbpsi_eit_event_t *p_evt;
     uint64_t i_runevt = 0;
     uint64_t i_fallbackevt = 0;
     vlc_epg_t *p_epg;
 
-    msg_Dbg( p_demux, "EITCallBack called" );
-    if( !p_eit->b_current_next )
-    {
-        dvbpsi_eit_delete( p_eit );
-        return;
-    }
-
     msg_Dbg( p_demux, "new EIT service_id=%"PRIu16" version=%"PRIu8" current_next=%d "
              "ts_id=%"PRIu16" network_id=%"PRIu16" segment_last_section_number=%"PRIu8" "
              "last_table_id=%"PRIu8,
@@ -512,10 +544,7 @@ static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
      * see TS 101 211, 4.1.4.2.1 */
     p_epg = vlc_epg_New( p_eit->i_table_id, p_eit->i_extension );
     if( !p_epg )
-    {
-        dvbpsi_eit_delete( p_eit );
-        return;
-    }
+        return NULL;
 
     for( p_evt = p_eit->p_first_event; p_evt; p_evt = p_evt->p_next )
     {
@@ -528,7 +557,7 @@ static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
         i_duration = EITConvertDuration( p_evt->i_duration );
 
         /* We have to fix ARIB-B10 as all timestamps are JST */
-        if( p_sys->standard == TS_STANDARD_ARIB )
+        if( ctx->standard == TS_STANDARD_ARIB )
         {
             /* See comments on TDT callback */
             i_start += 9 * 3600;
@@ -568,14 +597,14 @@ static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
                 {
                     char **ppsz = &p_epgevt->psz_name;
                     free( *ppsz );
-                    *ppsz = EITConvertToUTF8( p_demux,
+                    *ppsz = SIConvertToUTF8( p_demux, ctx->standard,
                                               pE->i_event_name, pE->i_event_name_length,
-                                              p_sys->b_broken_charset );
+                                              ctx->b_broken_charset );
                     ppsz = &p_epgevt->psz_short_description;
                     free( *ppsz );
-                    *ppsz = EITConvertToUTF8( p_demux,
+                    *ppsz = SIConvertToUTF8( p_demux, ctx->standard,
                                               pE->i_text, pE->i_text_length,
-                                              p_sys->b_broken_charset );
+                                              ctx->b_broken_charset );
                     msg_Dbg( p_demux, "    - short event lang=%3.3s '%s' : '%s'",
                              pE->i_iso_639_code, p_epgevt->psz_name, *ppsz );
                 }
@@ -593,9 +622,9 @@ static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
 
                     if( pE->i_text_length > 0 )
                     {
-                        char *psz_text = EITConvertToUTF8( p_demux,
+                        char *psz_text = SIConvertToUTF8( p_demux, ctx->standard,
                                                            pE->i_text, pE->i_text_length,
-                                                           p_sys->b_broken_charset );
+                                                           ctx->b_broken_charset );
                         if( psz_text )
                         {
                             msg_Dbg( p_demux, "       - text='%s'", psz_text );
@@ -618,7 +647,7 @@ static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
                         }
                     }
 
-                    EITExtractDrDescItems( p_demux, pE, p_epgevt );
+                    EITExtractDrDescItems( p_demux, ctx, pE, p_epgevt );
                 }
             }
                 break;
@@ -660,8 +689,8 @@ static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
             case TS_SI_RUNSTATUS_UNDEFINED:
             {
                 if( i_fallbackevt == 0 &&
-                    i_start <= p_sys->i_network_time &&
-                    p_sys->i_network_time < i_start + i_duration )
+                    i_start <= ctx->i_network_time &&
+                    ctx->i_network_time < i_start + i_duration )
                     i_fallbackevt = i_start;
                 break;
             }
@@ -674,26 +703,51 @@ static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
     if( i_runevt || i_fallbackevt )
         vlc_epg_SetCurrent( p_epg, (i_runevt) ? i_runevt : i_fallbackevt );
 
-    if( p_epg->i_event > 0 )
+    if( p_epg->i_event == 0 )
     {
-        if( p_epg->b_present && p_epg->p_current )
+        vlc_epg_Delete( p_epg );
+        return NULL;
+    }
+    return p_epg;
+}
+
+/* Hands a parsed EPG over to the program, from the input thread */
+static void EITPublish( demux_t *p_demux, uint16_t i_extension, uint8_t i_table_id,
+                        vlc_epg_t *p_epg )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_epg->b_present && p_epg->p_current )
+    {
+        ts_pat_t *p_pat = ts_pid_Get(&p_sys->pids, 0)->u.p_pat;
+        ts_pmt_t *p_pmt = ts_pat_Get_pmt(p_pat, i_extension);
+        if(p_pmt)
         {
-            ts_pat_t *p_pat = ts_pid_Get(&p_sys->pids, 0)->u.p_pat;
-            ts_pmt_t *p_pmt = ts_pat_Get_pmt(p_pat, p_eit->i_extension);
-            if(p_pmt)
-            {
-                p_pmt->eit.i_event_start = p_epg->p_current->i_start;
-                p_pmt->eit.i_event_length = p_epg->p_current->i_duration;
-            }
+            p_pmt->eit.i_event_start = p_epg->p_current->i_start;
+            p_pmt->eit.i_event_length = p_epg->p_current->i_duration;
         }
-        p_epg->b_present = (p_eit->i_table_id == 0x4e);
-        es_out_Control( p_demux->out, ES_OUT_SET_GROUP_EPG, p_eit->i_extension, p_epg );
     }
+    p_epg->b_present = (i_table_id == 0x4e);
+    es_out_Control( p_demux->out, ES_OUT_SET_GROUP_EPG, i_extension, p_epg );
     vlc_epg_Delete( p_epg );
+}
 
+static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
+{
+    msg_Dbg( p_demux, "EITCallBack called" );
+    if( p_eit->b_current_next )
+    {
+        eit_context_t ctx;
+        SIGetContext( p_demux->p_sys, &ctx );
+
+        vlc_epg_t *p_epg = EITParse( p_demux, &ctx, p_eit );
+        if( p_epg )
+            EITPublish( p_demux, p_eit->i_extension, p_eit->i_table_id, p_epg );
+    }
     dvbpsi_eit_delete( p_eit );
 }
 
+
 static void ARIB_CDT_RawCallback( dvbpsi_t *p_handle, const dvbpsi_psi_section_t* p_section,
                                   void *p_cdtpid )
 {
@@ -811,3 +865,216 @@ bool ts_attach_SI_Tables_Decoders( ts_pid_t *p_pid )
 
     return dvbpsi_AttachDemux( p_pid->u.p_si->handle, SINewTableCallBack, p_pid );
 }
+
+/*****************************************************************************
+ * EIT worker
+ *****************************************************************************
+ * EIT schedules carry the bulk of the SI bandwidth, and their charset
+ * conversions are by far the most expensive part of the SI processing.
+ * The worker owns a private section decoder for the EIT PID: the input thread
+ * only copies the packets, and gets back the complete EPG tables, which it
+ * publishes from ts_si_worker_Drain().
+ *****************************************************************************/
+#define TS_SI_WORKER_QUEUE 1024
+
+typedef struct ts_si_result_t ts_si_result_t;
+struct ts_si_result_t
+{
+    ts_si_result_t *p_next;
+    uint16_t        i_extension;
+    uint8_t         i_table_id;
+    vlc_epg_t      *p_epg;
+};
+
+struct ts_si_worker_t
+{
+    demux_t        *p_demux;
+    dvbpsi_t       *handle;
+    vlc_thread_t    thread;
+
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;
+    bool            b_stop;
+    unsigned        i_head;
+    unsigned        i_count;
+    unsigned        i_dropped;
+    eit_context_t   ctx; /* Input thread state as of the last packet */
+    ts_si_result_t *p_results;
+    ts_si_result_t **pp_results_last;
+
+    eit_context_t   local; /* Worker thread copy */
+    uint8_t         queue[TS_SI_WORKER_QUEUE][188];
+};
+
+static void EITWorkerCallBack( void *p_cbdata, dvbpsi_eit_t *p_eit )
+{
+    ts_si_worker_t *w = p_cbdata;
+
+    if( p_eit->b_current_next )
+    {
+        vlc_epg_t *p_epg = EITParse( w->p_demux, &w->local, p_eit );
+        ts_si_result_t *p_res = p_epg ? malloc( sizeof(*p_res) ) : NULL;
+        if( p_res )
+        {
+            p_res->p_next = NULL;
+            p_res->i_extension = p_eit->i_extension;
+            p_res->i_table_id = p_eit->i_table_id;
+            p_res->p_epg = p_epg;
+
+            vlc_mutex_lock( &w->lock );
+            *w->pp_results_last = p_res;
+            w->pp_results_last = &p_res->p_next;
+            vlc_mutex_unlock( &w->lock );
+        }
+        else if( p_epg )
+            vlc_epg_Delete( p_epg );
+    }
+    dvbpsi_eit_delete( p_eit );
+}
+
+static void SIWorkerNewTableCallBack( dvbpsi_t *h, uint8_t i_table_id,
+                                      uint16_t i_extension, void *p_cbdata )
+{
+    if( i_table_id == 0x4e || /* Current/Following */
+        (i_table_id >= 0x50 && i_table_id <= 0x5f) ) /* Schedule */
+    {
+        if( !dvbpsi_eit_attach( h, i_table_id, i_extension,
+                                (dvbpsi_eit_callback)EITWorkerCallBack, p_cbdata ) )
+            msg_Err( (demux_t *) h->p_sys,
+                     "SINewTableCallback: failed attaching EITCallback" );
+    }
+}
+
+static void *SIWorkerThread( void *data )
+{
+    ts_si_worker_t *w = data;
+    uint8_t pkt[188];
+
+    vlc_mutex_lock( &w->lock );
+    for( ;; )
+    {
+        while( !w->b_stop && w->i_count == 0 )
+            vlc_cond_wait( &w->wait, &w->lock );
+        if( w->b_stop )
+            break;
+
+        memcpy( pkt, w->queue[w->i_head], 188 );
+        w->i_head = (w->i_head + 1) % TS_SI_WORKER_QUEUE;
+        w->i_count--;
+        w->local = w->ctx;
+        vlc_mutex_unlock( &w->lock );
+
+        dvbpsi_packet_push( w->handle, pkt );
+
+        vlc_mutex_lock( &w->lock );
+    }
+    vlc_mutex_unlock( &w->lock );
+    return NULL;
+}
+
+static void ts_si_worker_Push( ts_si_worker_t *w, const demux_sys_t *p_sys,
+                               const uint8_t *p_pktbuffer )
+{
+    vlc_mutex_lock( &w->lock );
+    if( w->i_count < TS_SI_WORKER_QUEUE )
+    {
+        memcpy( w->queue[(w->i_head + w->i_count) % TS_SI_WORKER_QUEUE],
+                p_pktbuffer, 188 );
+        w->i_count++;
+        SIGetContext( p_sys, &w->ctx );
+        vlc_cond_signal( &w->wait );
+    }
+    else
+    {
+        /* The section decoder resynchronizes on the next table */
+        if( w->i_dropped++ == 0 )
+            msg_Warn( w->p_demux, "EIT worker is late, dropping packets" );
+    }
+    vlc_mutex_unlock( &w->lock );
+}
+
+ts_si_worker_t * ts_si_worker_New( demux_t *p_demux )
+{
+    ts_si_worker_t *w = malloc( sizeof(*w) );
+    if( !w )
+        return NULL;
+
+    w->handle = dvbpsi_new( &dvbpsi_messages, DVBPSI_MSG_DEBUG );
+    if( !w->handle )
+    {
+        free( w );
+        return NULL;
+    }
+    w->handle->p_sys = (void *) p_demux;
+
+    if( !dvbpsi_AttachDemux( w->handle, SIWorkerNewTableCallBack, w ) )
+    {
+        dvbpsi_delete( w->handle );
+        free( w );
+        return NULL;
+    }
+
+    w->p_demux = p_demux;
+    vlc_mutex_init( &w->lock );
+    vlc_cond_init( &w->wait );
+    w->b_stop = false;
+    w->i_head = 0;
+    w->i_count = 0;
+    w->i_dropped = 0;
+    SIGetContext( p_demux->p_sys, &w->ctx );
+    w->p_results = NULL;
+    w->pp_results_last = &w->p_results;
+
+    if( vlc_clone( &w->thread, SIWorkerThread, w, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        dvbpsi_DetachDemux( w->handle );
+        dvbpsi_delete( w->handle );
+        free( w );
+        return NULL;
+    }
+
+    return w;
+}
+
+void ts_si_worker_Delete( ts_si_worker_t *w )
+{
+    vlc_mutex_lock( &w->lock );
+    w->b_stop = true;
+    vlc_cond_signal( &w->wait );
+    vlc_mutex_unlock( &w->lock );
+    vlc_join( w->thread, NULL );
+
+    if( w->i_dropped )
+        msg_Dbg( w->p_demux, "EIT worker dropped %u packets", w->i_dropped );
+
+    for( ts_si_result_t *p_res = w->p_results; p_res; )
+    {
+        ts_si_result_t *p_next = p_res->p_next;
+        vlc_epg_Delete( p_res->p_epg );
+        free( p_res );
+        p_res = p_next;
+    }
+
+    dvbpsi_DetachDemux( w->handle );
+    dvbpsi_delete( w->handle );
+    free( w );
+}
+
+void ts_si_worker_Drain( demux_t *p_demux, ts_si_worker_t *w )
+{
+    ts_si_result_t *p_res;
+
+    vlc_mutex_lock( &w->lock );
+    p_res = w->p_results;
+    w->p_results = NULL;
+    w->pp_results_last = &w->p_results;
+    vlc_mutex_unlock( &w->lock );
+
+    while( p_res )
+    {
+        ts_si_result_t *p_next = p_res->p_next;
+        EITPublish( p_demux, p_res->i_extension, p_res->i_table_id, p_res->p_epg );
+        free( p_res );
+        p_res = p_next;
+    }
+}
@@ -41,4 +41,12 @@ void ts_si_Packet_Push( ts_pid_t *, const uint8_t * );
 
 bool ts_attach_SI_Tables_Decoders( ts_pid_t * );
 
+typedef struct ts_si_worker_t ts_si_worker_t;
+
+/* Parses the EIT on a low priority thread, see ts_si.c */
+ts_si_worker_t * ts_si_worker_New( demux_t * );
+void ts_si_worker_Delete( ts_si_worker_t * );
+/* Publishes the EPG tables parsed since the last call */
+void ts_si_worker_Drain( demux_t *, ts_si_worker_t * );
+
 #endif
@@ -0,0 +1,182 @@
+/*****************************************************************************
+ * ts_stats.c: TS demuxer statistics
+ *****************************************************************************
+ * Copyright (C) 2021 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+
+#include "ts_pid.h"
+#include "ts_streams_private.h"
+#include "ts.h"
+#include "timestamps.h"
+
+#include <stdlib.h>
+
+/*
+ * The counters are updated inline by the demuxer, and only copied out on
+ * DEMUX_GET_TS_STATS. The only periodic work is the bitrate window, which
+ * walks the PID list once per TS_STATS_WINDOW.
+ */
+
+/* Above this, a PCR step is a discontinuity or a seek, not jitter */
+#define TS_STATS_MAX_STEP VLC_TICK_FROM_SEC(1)
+
+static const vlc_tick_t jitter_bounds[VLC_TS_STATS_BUCKETS - 1] =
+{
+    VLC_TICK_FROM_MS(1), VLC_TICK_FROM_MS(2), VLC_TICK_FROM_MS(5),
+    VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(20), VLC_TICK_FROM_MS(50),
+    VLC_TICK_FROM_MS(100),
+};
+
+static const vlc_tick_t interval_bounds[VLC_TS_STATS_BUCKETS - 1] =
+{
+    VLC_TICK_FROM_MS(10), VLC_TICK_FROM_MS(20), VLC_TICK_FROM_MS(40),
+    VLC_TICK_FROM_MS(60), VLC_TICK_FROM_MS(100), VLC_TICK_FROM_MS(200),
+    VLC_TICK_FROM_MS(500),
+};
+
+static void HistogramAdd( uint32_t *p_histogram, const vlc_tick_t *p_bounds,
+                          vlc_tick_t i_value )
+{
+    unsigned i = 0;
+    while( i < VLC_TS_STATS_BUCKETS - 1 && i_value >= p_bounds[i] )
+        i++;
+    p_histogram[i]++;
+}
+
+void ts_pcr_stats_Init( ts_pcr_stats_t *p_stats )
+{
+    memset( p_stats, 0, sizeof(*p_stats) );
+    p_stats->i_last_arrival = VLC_TICK_INVALID;
+}
+
+void ts_pcr_stats_Update( ts_pcr_stats_t *p_stats, stime_t i_pcr, vlc_tick_t i_now )
+{
+    if( p_stats->i_last_arrival != VLC_TICK_INVALID )
+    {
+        vlc_tick_t i_step = FROM_SCALE_NZ( i_pcr - p_stats->i_last_pcr );
+        vlc_tick_t i_elapsed = i_now - p_stats->i_last_arrival;
+
+        if( i_step >= 0 && i_step < TS_STATS_MAX_STEP &&
+            i_elapsed < TS_STATS_MAX_STEP )
+        {
+            vlc_tick_t i_jitter = i_step - i_elapsed;
+
+            HistogramAdd( p_stats->interval, interval_bounds, i_step );
+            HistogramAdd( p_stats->jitter, jitter_bounds,
+                          i_jitter < 0 ? -i_jitter : i_jitter );
+            p_stats->i_drift += i_jitter;
+        }
+    }
+    p_stats->i_last_pcr = i_pcr;
+    p_stats->i_last_arrival = i_now;
+}
+
+static void PIDStatsTick( ts_pid_t *pid, vlc_tick_t i_elapsed )
+{
+    ts_pid_stats_t *p_stats = &pid->stats;
+    uint64_t i_delta = p_stats->i_packets - p_stats->i_window_packets;
+
+    p_stats->i_bitrate = i_delta * 188 * 8 * CLOCK_FREQ / i_elapsed;
+    p_stats->i_window_packets = p_stats->i_packets;
+}
+
+void ts_stats_Tick( demux_t *p_demux, vlc_tick_t i_now )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->stats.i_window_start == VLC_TICK_INVALID )
+    {
+        p_sys->stats.i_window_start = i_now;
+        return;
+    }
+
+    vlc_tick_t i_elapsed = i_now - p_sys->stats.i_window_start;
+    if( i_elapsed < TS_STATS_WINDOW )
+        return;
+
+    ts_pid_t *p_pid;
+    ts_pid_next_context_t pidnextctx = ts_pid_NextContextInitValue;
+    while( (p_pid = ts_pid_Next( &p_sys->pids, &pidnextctx )) )
+        PIDStatsTick( p_pid, i_elapsed );
+    PIDStatsTick( &p_sys->pids.pat, i_elapsed );
+    PIDStatsTick( &p_sys->pids.dummy, i_elapsed );
+
+    p_sys->stats.i_window_start = i_now;
+}
+
+static void PIDStatsCopy( vlc_ts_pid_stats_t *p_dst, const ts_pid_t *pid )
+{
+    p_dst->i_pid = pid->i_pid;
+    p_dst->i_packets = pid->stats.i_packets;
+    p_dst->i_bitrate = pid->stats.i_bitrate;
+    p_dst->i_cc_errors = pid->stats.i_cc_errors;
+    p_dst->i_pes_errors = pid->stats.i_pes_errors;
+}
+
+int ts_stats_Get( demux_t *p_demux, vlc_ts_stats_t **pp_stats )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_pid_t *p_patpid = GetPID(p_sys, 0);
+    size_t i_pids = 2 + p_sys->pids.i_all;
+    size_t i_programs = 0;
+
+    if( p_patpid->type == TYPE_PAT )
+        i_programs = p_patpid->u.p_pat->programs.i_size;
+
+    vlc_ts_stats_t *p_stats = malloc( sizeof(*p_stats) +
+                                      i_pids * sizeof(vlc_ts_pid_stats_t) +
+                                      i_programs * sizeof(vlc_ts_program_stats_t) );
+    if( !p_stats )
+        return VLC_ENOMEM;
+
+    p_stats->p_programs = (vlc_ts_program_stats_t *) &p_stats[1];
+    p_stats->p_pids = (vlc_ts_pid_stats_t *) &p_stats->p_programs[i_programs];
+
+    /* Only PIDs that were met, in PID order */
+    p_stats->i_pids = 0;
+    if( SEEN(p_patpid) )
+        PIDStatsCopy( &p_stats->p_pids[p_stats->i_pids++], p_patpid );
+    const ts_pid_t *p_pid;
+    ts_pid_next_context_t pidnextctx = ts_pid_NextContextInitValue;
+    while( (p_pid = ts_pid_Next( &p_sys->pids, &pidnextctx )) )
+    {
+        if( SEEN(p_pid) )
+            PIDStatsCopy( &p_stats->p_pids[p_stats->i_pids++], p_pid );
+    }
+    if( p_sys->pids.dummy.stats.i_packets )
+        PIDStatsCopy( &p_stats->p_pids[p_stats->i_pids++], &p_sys->pids.dummy );
+
+    p_stats->i_programs = i_programs;
+    for( size_t i = 0; i < i_programs; i++ )
+    {
+        const ts_pmt_t *p_pmt = p_patpid->u.p_pat->programs.p_elems[i]->u.p_pmt;
+        vlc_ts_program_stats_t *p_dst = &p_stats->p_programs[i];
+
+        p_dst->i_program = p_pmt->i_number;
+        memcpy( p_dst->jitter, p_pmt->pcr_stats.jitter, sizeof(p_dst->jitter) );
+        memcpy( p_dst->interval, p_pmt->pcr_stats.interval, sizeof(p_dst->interval) );
+        p_dst->i_drift = p_pmt->pcr_stats.i_drift;
+    }
+
+    *pp_stats = p_stats;
+    return VLC_SUCCESS;
+}
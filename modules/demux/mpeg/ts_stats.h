@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * ts_stats.h: TS demuxer statistics
+ *****************************************************************************
+ * Copyright (C) 2021 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef VLC_TS_STATS_H
+#define VLC_TS_STATS_H
+
+#include <vlc_demux.h>
+#include "timestamps.h"
+
+/* Bitrate measurement period */
+#define TS_STATS_WINDOW VLC_TICK_FROM_SEC(1)
+
+typedef struct
+{
+    uint64_t i_packets;
+    uint64_t i_window_packets; /* i_packets at the window start */
+    uint64_t i_bitrate;
+    uint32_t i_cc_errors;
+    uint32_t i_pes_errors;
+} ts_pid_stats_t;
+
+typedef struct
+{
+    stime_t    i_last_pcr;
+    vlc_tick_t i_last_arrival; /* VLC_TICK_INVALID until the first PCR */
+    vlc_tick_t i_drift;
+    uint32_t   jitter[VLC_TS_STATS_BUCKETS];
+    uint32_t   interval[VLC_TS_STATS_BUCKETS];
+} ts_pcr_stats_t;
+
+void ts_pcr_stats_Init( ts_pcr_stats_t * );
+/* i_pcr is the program PCR, in 90kHz units */
+void ts_pcr_stats_Update( ts_pcr_stats_t *, stime_t i_pcr, vlc_tick_t i_now );
+
+/* Closes the bitrate measurement window if it elapsed */
+void ts_stats_Tick( demux_t *, vlc_tick_t i_now );
+int  ts_stats_Get( demux_t *, vlc_ts_stats_t ** );
+
+#endif
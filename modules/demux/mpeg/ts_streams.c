@@ -134,6 +134,7 @@ ts_pmt_t *ts_pmt_New( demux_t *p_demux )
     pmt->pcr.i_pcroffset = -1;
 
     pmt->pcr.b_fix_done = false;
+    ts_pcr_stats_Init( &pmt->pcr_stats );
 
     pmt->eit.i_event_length = 0;
     pmt->eit.i_event_start = 0;
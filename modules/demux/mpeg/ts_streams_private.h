@@ -67,6 +67,8 @@ struct ts_pmt_t
         bool    b_fix_done;
     } pcr;
 
+    ts_pcr_stats_t pcr_stats;
+
     struct
     {
         time_t i_event_start;
@@ -0,0 +1,570 @@
+/*****************************************************************************
+ * tssplit.c : Pseudo demux module splitting a MPEG-TS into services
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Records each selected service of a multiplex to its own single program
+ * transport stream, like the dump demuxer does for the whole stream.
+ * Only the PAT and the PMTs are parsed: packets are forwarded untouched
+ * using a PID bitmap per service, and each output gets a PAT rewritten to
+ * only list its own program.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_demux.h>
+#include <vlc_sout.h>
+
+#include <assert.h>
+
+#define ACCESS_TEXT N_("Output module")
+#define PREFIX_TEXT N_("Output filename prefix")
+#define PREFIX_LONGTEXT N_( \
+    "Each service is written to <prefix>-<program number>.ts." )
+#define PROGRAMS_TEXT N_("Programs")
+#define PROGRAMS_LONGTEXT N_( \
+    "Comma separated list of the program numbers to record. " \
+    "All programs are recorded if empty." )
+
+static int  Open( vlc_object_t * );
+static void Close ( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname("TS split")
+    set_category( CAT_INPUT )
+    set_subcategory( SUBCAT_INPUT_DEMUX )
+    set_description( N_("MPEG-TS service splitter") )
+    set_capability( "demux", 0 )
+    add_module("tssplit-access", "sout access", "file",
+               ACCESS_TEXT, ACCESS_TEXT)
+    add_savefile("tssplit-prefix", "stream-service",
+                 PREFIX_TEXT, PREFIX_LONGTEXT)
+    add_string( "tssplit-programs", NULL, PROGRAMS_TEXT, PROGRAMS_LONGTEXT,
+                false )
+    set_callbacks( Open, Close )
+    add_shortcut( "tssplit" )
+vlc_module_end ()
+
+#define TS_PACKET_SIZE 188
+/* Packets read at once */
+#define TSSPLIT_READ_PACKETS 512
+/* Output buffering per service, in packets */
+#define TSSPLIT_WRITE_PACKETS 1024
+#define PSI_MAX_SIZE (3 + 1021)
+
+typedef struct
+{
+    uint8_t  data[PSI_MAX_SIZE];
+    size_t   i_data;
+    bool     b_active;
+} tssplit_section_t;
+
+typedef struct
+{
+    int       i_number;
+    uint16_t  i_pmt_pid;
+    int       i_pmt_version;
+    uint32_t  pids[8192 / 32]; /* PIDs forwarded to this service */
+
+    sout_access_out_t *out;
+    block_t  *p_buffer;
+
+    uint8_t   pat[TS_PACKET_SIZE]; /* PAT listing this program only */
+    uint8_t   i_pat_cc;
+
+    tssplit_section_t pmt;
+} tssplit_service_t;
+
+typedef struct
+{
+    char     *psz_access;
+    char     *psz_prefix;
+
+    /* Requested program numbers, none meaning all */
+    int      *pi_programs;
+    size_t    i_programs;
+
+    int       i_pat_version;
+    uint16_t  i_ts_id;
+    tssplit_section_t pat;
+
+    tssplit_service_t **pp_services;
+    size_t    i_services;
+
+    uint32_t  crc32_table[256];
+} demux_sys_t;
+
+static int Demux( demux_t * );
+static int Control( demux_t *, int,va_list );
+
+static inline bool PIDMapGet( const uint32_t *p_map, uint16_t i_pid )
+{
+    return p_map[i_pid >> 5] & (UINT32_C(1) << (i_pid & 31));
+}
+
+static inline void PIDMapSet( uint32_t *p_map, uint16_t i_pid )
+{
+    p_map[i_pid >> 5] |= UINT32_C(1) << (i_pid & 31);
+}
+
+static uint32_t CRC32( const demux_sys_t *p_sys, const uint8_t *p, size_t i )
+{
+    uint32_t i_crc = 0xffffffff;
+    while( i-- > 0 )
+        i_crc = (i_crc << 8) ^ p_sys->crc32_table[((i_crc >> 24) ^ *p++) & 0xff];
+    return i_crc;
+}
+
+/*****************************************************************************
+ * Output
+ *****************************************************************************/
+static int ServiceFlush( demux_t *p_demux, tssplit_service_t *p_srv )
+{
+    block_t *p_block = p_srv->p_buffer;
+    p_srv->p_buffer = NULL;
+
+    if( p_block == NULL )
+        return VLC_SUCCESS;
+
+    size_t i_size = p_block->i_buffer;
+    if( (size_t)sout_AccessOutWrite( p_srv->out, p_block ) != i_size )
+    {
+        msg_Err( p_demux, "cannot write data for program %d", p_srv->i_number );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int ServiceWrite( demux_t *p_demux, tssplit_service_t *p_srv,
+                         const uint8_t *p_pkt )
+{
+    if( p_srv->out == NULL )
+        return VLC_SUCCESS;
+
+    if( p_srv->p_buffer == NULL )
+    {
+        p_srv->p_buffer = block_Alloc( TSSPLIT_WRITE_PACKETS * TS_PACKET_SIZE );
+        if( unlikely(p_srv->p_buffer == NULL) )
+            return VLC_ENOMEM;
+        p_srv->p_buffer->i_buffer = 0;
+    }
+
+    block_t *p_block = p_srv->p_buffer;
+    memcpy( &p_block->p_buffer[p_block->i_buffer], p_pkt, TS_PACKET_SIZE );
+    p_block->i_buffer += TS_PACKET_SIZE;
+
+    if( p_block->i_buffer == TSSPLIT_WRITE_PACKETS * TS_PACKET_SIZE )
+        return ServiceFlush( p_demux, p_srv );
+    return VLC_SUCCESS;
+}
+
+static int ServiceWritePAT( demux_t *p_demux, tssplit_service_t *p_srv )
+{
+    p_srv->pat[3] = 0x10 | p_srv->i_pat_cc;
+    p_srv->i_pat_cc = (p_srv->i_pat_cc + 1) & 0x0f;
+    return ServiceWrite( p_demux, p_srv, p_srv->pat );
+}
+
+static int ServiceOpen( demux_t *p_demux, tssplit_service_t *p_srv )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    char *psz_path;
+
+    if( asprintf( &psz_path, "%s-%d.ts", p_sys->psz_prefix, p_srv->i_number ) < 0 )
+        return VLC_ENOMEM;
+
+    p_srv->out = sout_AccessOutNew( p_demux, p_sys->psz_access, psz_path );
+    if( p_srv->out == NULL )
+    {
+        msg_Err( p_demux, "cannot create output %s", psz_path );
+        free( psz_path );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_demux, "recording program %d to %s", p_srv->i_number, psz_path );
+    free( psz_path );
+    /* Start with a PAT, rather than waiting for the next one */
+    return ServiceWritePAT( p_demux, p_srv );
+}
+
+/*****************************************************************************
+ * PSI
+ *****************************************************************************/
+typedef void (*tssplit_section_cb)( demux_t *, void *, const uint8_t *, size_t );
+
+static void SectionAppend( demux_t *p_demux, tssplit_section_t *p_sec,
+                           const uint8_t *p, size_t i_size,
+                           tssplit_section_cb pf_cb, void *p_cbdata )
+{
+    while( p_sec->b_active && i_size > 0 )
+    {
+        size_t i_copy = __MIN( i_size, PSI_MAX_SIZE - p_sec->i_data );
+        memcpy( &p_sec->data[p_sec->i_data], p, i_copy );
+        p_sec->i_data += i_copy;
+
+        if( p_sec->i_data < 3 )
+            return;
+
+        size_t i_total = 3 + (((p_sec->data[1] & 0x0f) << 8) | p_sec->data[2]);
+        if( i_total > PSI_MAX_SIZE || i_total < 3 + 4 )
+        {
+            p_sec->b_active = false;
+            return;
+        }
+        if( p_sec->i_data < i_total )
+            return;
+
+        p_sec->b_active = false;
+        if( CRC32( p_demux->p_sys, p_sec->data, i_total ) == 0 )
+            pf_cb( p_demux, p_cbdata, p_sec->data, i_total );
+
+        /* Another section may follow in the same packet */
+        size_t i_used = i_copy - (p_sec->i_data - i_total);
+        p += i_used;
+        i_size -= i_used;
+        if( i_size == 0 || *p == 0xff )
+            return;
+        p_sec->i_data = 0;
+        p_sec->b_active = true;
+    }
+}
+
+static void SectionPush( demux_t *p_demux, tssplit_section_t *p_sec,
+                         const uint8_t *p_pkt,
+                         tssplit_section_cb pf_cb, void *p_cbdata )
+{
+    const uint8_t *p = &p_pkt[4];
+    const uint8_t *p_end = &p_pkt[TS_PACKET_SIZE];
+
+    if( !(p_pkt[3] & 0x10) ) /* no payload */
+        return;
+    if( p_pkt[3] & 0x20 ) /* adaptation field */
+        p += 1 + p[0];
+    if( p >= p_end )
+        return;
+
+    if( p_pkt[1] & 0x40 ) /* payload unit start */
+    {
+        const uint8_t *p_start = p + 1 + p[0];
+        if( p_start > p_end )
+            return;
+        /* End of the previous section */
+        SectionAppend( p_demux, p_sec, p + 1, p_start - p - 1, pf_cb, p_cbdata );
+        p_sec->i_data = 0;
+        p_sec->b_active = true;
+        p = p_start;
+    }
+
+    SectionAppend( p_demux, p_sec, p, p_end - p, pf_cb, p_cbdata );
+}
+
+static void PMTCallback( demux_t *p_demux, void *p_cbdata,
+                         const uint8_t *p, size_t i_size )
+{
+    tssplit_service_t *p_srv = p_cbdata;
+
+    if( p[0] != 0x02 || !(p[5] & 0x01) /* current_next */ ||
+        ((p[3] << 8) | p[4]) != p_srv->i_number || i_size < 12 + 4 )
+        return;
+
+    const int i_version = (p[5] >> 1) & 0x1f;
+    if( i_version == p_srv->i_pmt_version )
+        return;
+
+    /* Rebuild the PID map from scratch, the stream list may have changed */
+    memset( p_srv->pids, 0, sizeof(p_srv->pids) );
+    PIDMapSet( p_srv->pids, p_srv->i_pmt_pid );
+    PIDMapSet( p_srv->pids, ((p[8] & 0x1f) << 8) | p[9] ); /* PCR */
+
+    const uint8_t *p_end = &p[i_size - 4];
+    const uint8_t *p_es = &p[12 + (((p[10] & 0x0f) << 8) | p[11])];
+    while( p_es + 5 <= p_end )
+    {
+        uint16_t i_pid = ((p_es[1] & 0x1f) << 8) | p_es[2];
+        PIDMapSet( p_srv->pids, i_pid );
+        p_es += 5 + (((p_es[3] & 0x0f) << 8) | p_es[4]);
+    }
+
+    msg_Dbg( p_demux, "program %d PMT version %d", p_srv->i_number, i_version );
+    p_srv->i_pmt_version = i_version;
+
+    if( p_srv->out == NULL )
+        ServiceOpen( p_demux, p_srv );
+}
+
+static bool ProgramWanted( const demux_sys_t *p_sys, int i_number )
+{
+    if( p_sys->i_programs == 0 )
+        return true;
+    for( size_t i = 0; i < p_sys->i_programs; i++ )
+        if( p_sys->pi_programs[i] == i_number )
+            return true;
+    return false;
+}
+
+static void ServiceBuildPAT( demux_sys_t *p_sys, tssplit_service_t *p_srv )
+{
+    uint8_t *p = p_srv->pat;
+
+    p[0] = 0x47;
+    p[1] = 0x40; /* payload unit start, PID 0 */
+    p[2] = 0x00;
+    p[3] = 0x10; /* payload only, CC set on write */
+    p[4] = 0x00; /* pointer field */
+
+    uint8_t *s = &p[5];
+    s[0] = 0x00; /* table id */
+    s[1] = 0xb0;
+    s[2] = 13;   /* section length */
+    s[3] = p_sys->i_ts_id >> 8;
+    s[4] = p_sys->i_ts_id & 0xff;
+    s[5] = 0xc1 | (p_sys->i_pat_version << 1);
+    s[6] = 0x00;
+    s[7] = 0x00;
+    s[8] = p_srv->i_number >> 8;
+    s[9] = p_srv->i_number & 0xff;
+    s[10] = 0xe0 | (p_srv->i_pmt_pid >> 8);
+    s[11] = p_srv->i_pmt_pid & 0xff;
+
+    uint32_t i_crc = CRC32( p_sys, s, 12 );
+    s[12] = i_crc >> 24;
+    s[13] = i_crc >> 16;
+    s[14] = i_crc >> 8;
+    s[15] = i_crc;
+
+    memset( &s[16], 0xff, TS_PACKET_SIZE - 5 - 16 );
+}
+
+static void PATCallback( demux_t *p_demux, void *p_cbdata,
+                         const uint8_t *p, size_t i_size )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    VLC_UNUSED(p_cbdata);
+
+    if( p[0] != 0x00 || !(p[5] & 0x01) /* current_next */ || i_size < 8 + 4 )
+        return;
+
+    const int i_version = (p[5] >> 1) & 0x1f;
+    if( i_version == p_sys->i_pat_version )
+        return;
+
+    p_sys->i_pat_version = i_version;
+    p_sys->i_ts_id = (p[3] << 8) | p[4];
+
+    for( const uint8_t *p_prg = &p[8]; p_prg + 4 <= &p[i_size - 4]; p_prg += 4 )
+    {
+        const int i_number = (p_prg[0] << 8) | p_prg[1];
+        const uint16_t i_pmt_pid = ((p_prg[2] & 0x1f) << 8) | p_prg[3];
+
+        if( i_number == 0 /* network PID */ || !ProgramWanted( p_sys, i_number ) )
+            continue;
+
+        tssplit_service_t *p_srv = NULL;
+        for( size_t i = 0; i < p_sys->i_services; i++ )
+            if( p_sys->pp_services[i]->i_number == i_number )
+                p_srv = p_sys->pp_services[i];
+
+        if( p_srv == NULL )
+        {
+            tssplit_service_t **pp_realloc =
+                realloc( p_sys->pp_services,
+                         (p_sys->i_services + 1) * sizeof(*pp_realloc) );
+            if( unlikely(pp_realloc == NULL) )
+                return;
+            p_sys->pp_services = pp_realloc;
+
+            p_srv = calloc( 1, sizeof(*p_srv) );
+            if( unlikely(p_srv == NULL) )
+                return;
+            p_srv->i_number = i_number;
+            p_srv->i_pmt_version = -1;
+            p_sys->pp_services[p_sys->i_services++] = p_srv;
+        }
+
+        if( p_srv->i_pmt_pid != i_pmt_pid )
+        {
+            p_srv->i_pmt_pid = i_pmt_pid;
+            p_srv->i_pmt_version = -1;
+            p_srv->pmt.b_active = false;
+        }
+        ServiceBuildPAT( p_sys, p_srv );
+    }
+}
+
+/*****************************************************************************
+ * Open/Close
+ *****************************************************************************/
+static int Open( vlc_object_t * p_this )
+{
+    demux_t *p_demux = (demux_t*)p_this;
+
+    /* Accept only if forced */
+    if( !p_demux->obj.force )
+        return VLC_EGENERIC;
+
+    demux_sys_t *p_sys = calloc( 1, sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->psz_access = var_InheritString( p_demux, "tssplit-access" );
+    p_sys->psz_prefix = var_InheritString( p_demux, "tssplit-prefix" );
+    if( p_sys->psz_access == NULL || p_sys->psz_prefix == NULL )
+    {
+        msg_Err( p_demux, "no output given" );
+        free( p_sys->psz_access );
+        free( p_sys->psz_prefix );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    char *psz_programs = var_InheritString( p_demux, "tssplit-programs" );
+    if( psz_programs != NULL )
+    {
+        char *psz_state;
+        for( const char *psz = strtok_r( psz_programs, ",", &psz_state );
+             psz != NULL; psz = strtok_r( NULL, ",", &psz_state ) )
+        {
+            int *pi_realloc = realloc( p_sys->pi_programs,
+                                       (p_sys->i_programs + 1) * sizeof(int) );
+            if( unlikely(pi_realloc == NULL) )
+                break;
+            p_sys->pi_programs = pi_realloc;
+            p_sys->pi_programs[p_sys->i_programs++] = atoi( psz );
+        }
+        free( psz_programs );
+    }
+
+    /* --sout-file-append (always false) */
+    var_Create( p_demux, "sout-file-append", VLC_VAR_BOOL );
+    /* --sout-file-format (always false) */
+    var_Create( p_demux, "sout-file-format", VLC_VAR_BOOL );
+
+    p_sys->i_pat_version = -1;
+
+    /* Initialise CRC32 table */
+    for( uint32_t i = 0; i < 256; i++ )
+    {
+        uint32_t k = 0;
+        for( uint32_t j = (i << 24) | 0x800000; j != 0x80000000; j <<= 1 )
+            k = (k << 1) ^ (((k ^ j) & 0x80000000) ? 0x04c11db7 : 0);
+        p_sys->crc32_table[i] = k;
+    }
+
+    p_demux->p_sys = p_sys;
+    p_demux->pf_demux = Demux;
+    p_demux->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    demux_t *p_demux = (demux_t*)p_this;
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( size_t i = 0; i < p_sys->i_services; i++ )
+    {
+        tssplit_service_t *p_srv = p_sys->pp_services[i];
+        if( p_srv->out )
+        {
+            ServiceFlush( p_demux, p_srv );
+            sout_AccessOutDelete( p_srv->out );
+        }
+        free( p_srv );
+    }
+    free( p_sys->pp_services );
+    free( p_sys->pi_programs );
+    free( p_sys->psz_access );
+    free( p_sys->psz_prefix );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Demux
+ *****************************************************************************/
+static int Dispatch( demux_t *p_demux, const uint8_t *p_pkt )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint16_t i_pid = ((p_pkt[1] & 0x1f) << 8) | p_pkt[2];
+
+    if( i_pid == 0 )
+    {
+        SectionPush( p_demux, &p_sys->pat, p_pkt, PATCallback, NULL );
+
+        /* Replace the PAT of each output at the same pace */
+        if( p_pkt[1] & 0x40 )
+        {
+            for( size_t i = 0; i < p_sys->i_services; i++ )
+                if( ServiceWritePAT( p_demux, p_sys->pp_services[i] ) )
+                    return VLC_EGENERIC;
+        }
+        return VLC_SUCCESS;
+    }
+
+    for( size_t i = 0; i < p_sys->i_services; i++ )
+    {
+        tssplit_service_t *p_srv = p_sys->pp_services[i];
+
+        if( i_pid == p_srv->i_pmt_pid )
+            SectionPush( p_demux, &p_srv->pmt, p_pkt, PMTCallback, p_srv );
+
+        if( PIDMapGet( p_srv->pids, i_pid ) &&
+            ServiceWrite( p_demux, p_srv, p_pkt ) )
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int Demux( demux_t *p_demux )
+{
+    const uint8_t *p_peek;
+    ssize_t i_peek = vlc_stream_Peek( p_demux->s, &p_peek,
+                                      TSSPLIT_READ_PACKETS * TS_PACKET_SIZE );
+    if( i_peek < TS_PACKET_SIZE )
+        return VLC_DEMUXER_EOF;
+
+    size_t i_pos = 0;
+    while( i_pos + TS_PACKET_SIZE <= (size_t)i_peek )
+    {
+        if( p_peek[i_pos] != 0x47 )
+        {
+            /* Resync */
+            i_pos++;
+            continue;
+        }
+
+        /* Drop transport errors, as the PID itself is unreliable */
+        if( !(p_peek[i_pos + 1] & 0x80) &&
+            Dispatch( p_demux, &p_peek[i_pos] ) )
+            return VLC_DEMUXER_EGENERIC;
+        i_pos += TS_PACKET_SIZE;
+    }
+
+    if( vlc_stream_Read( p_demux->s, NULL, i_pos ) < (ssize_t)i_pos )
+        return VLC_DEMUXER_EOF;
+    return VLC_DEMUXER_SUCCESS;
+}
+
+static int Control( demux_t *p_demux, int i_query, va_list args )
+{
+    return demux_vaControlHelper( p_demux->s, 0, -1, 0, 1, i_query, args );
+}
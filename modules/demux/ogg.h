@@ -43,6 +43,7 @@
 #define OGGDS_RESOLUTION     10000000
 
 typedef struct oggseek_index_entry demux_index_entry_t;
+typedef struct oggseek_granule_entry oggseek_granule_entry_t;
 typedef struct ogg_skeleton_t ogg_skeleton_t;
 
 typedef struct backup_queue
@@ -95,6 +96,14 @@ typedef struct logical_stream_s
     /* keyframe index for seeking, created as we discover keyframes */
     demux_index_entry_t *idx;
 
+    /* pages granules met while bisecting, sorted by page position */
+    struct
+    {
+        oggseek_granule_entry_t *p_entries;
+        size_t i_count;
+        size_t i_alloc;
+    } granules;
+
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
 
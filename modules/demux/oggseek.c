@@ -171,6 +171,92 @@ static bool OggSeekIndexFind ( logical_stream_t *p_stream, vlc_tick_t i_timestam
     return false;
 }
 
+/************************************************************
+* pages granules met while bisecting, kept across seeks
+*************************************************************/
+
+#define OGGSEEK_GRANULES_MAX 8192
+
+void OggSeek_GranulesClean( logical_stream_t *p_stream )
+{
+    free( p_stream->granules.p_entries );
+    p_stream->granules.p_entries = NULL;
+    p_stream->granules.i_count = p_stream->granules.i_alloc = 0;
+}
+
+/* returns the index of the first entry at or after i_pagepos */
+static size_t OggSeekGranulesLookup( const logical_stream_t *p_stream,
+                                     int64_t i_pagepos )
+{
+    size_t i_low = 0, i_high = p_stream->granules.i_count;
+    while( i_low < i_high )
+    {
+        size_t i_mid = (i_low + i_high) / 2;
+        if( p_stream->granules.p_entries[i_mid].i_pagepos < i_pagepos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+static void OggSeekGranulesAdd( logical_stream_t *p_stream, int64_t i_pagepos,
+                                int64_t i_granule, vlc_tick_t i_time )
+{
+    size_t i = OggSeekGranulesLookup( p_stream, i_pagepos );
+    if( i < p_stream->granules.i_count &&
+        p_stream->granules.p_entries[i].i_pagepos == i_pagepos )
+        return;
+
+    if( p_stream->granules.i_count == p_stream->granules.i_alloc )
+    {
+        if( p_stream->granules.i_alloc >= OGGSEEK_GRANULES_MAX )
+            return;
+        size_t i_alloc = p_stream->granules.i_alloc ? p_stream->granules.i_alloc * 2 : 64;
+        oggseek_granule_entry_t *p_realloc =
+                realloc( p_stream->granules.p_entries, i_alloc * sizeof(*p_realloc) );
+        if( !p_realloc )
+            return;
+        p_stream->granules.p_entries = p_realloc;
+        p_stream->granules.i_alloc = i_alloc;
+    }
+
+    oggseek_granule_entry_t *p_entry = &p_stream->granules.p_entries[i];
+    memmove( &p_entry[1], p_entry,
+             (p_stream->granules.i_count - i) * sizeof(*p_entry) );
+    p_entry->i_pagepos = i_pagepos;
+    p_entry->i_granule = i_granule;
+    p_entry->i_time = i_time;
+    p_stream->granules.i_count++;
+}
+
+/* Narrows the bisection from the pages already met around the target.
+ * Returns the closest page known to end before it, if any */
+static const oggseek_granule_entry_t *
+    OggSeekGranulesBounds( const logical_stream_t *p_stream, vlc_tick_t i_time,
+                           int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+{
+    const oggseek_granule_entry_t *p_lower = NULL;
+
+    for( size_t i = OggSeekGranulesLookup( p_stream, *pi_pos_lower );
+         i < p_stream->granules.i_count; i++ )
+    {
+        const oggseek_granule_entry_t *p_entry = &p_stream->granules.p_entries[i];
+        if( p_entry->i_pagepos >= *pi_pos_upper )
+            break;
+        if( p_entry->i_time > i_time )
+        {
+            *pi_pos_upper = p_entry->i_pagepos;
+            break;
+        }
+        p_lower = p_entry;
+    }
+
+    if( p_lower )
+        *pi_pos_lower = p_lower->i_pagepos;
+    return p_lower;
+}
+
 /*********************************************************************
  * private functions
  **********************************************************************/
@@ -648,6 +734,16 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
     i_pos_upper = __MIN( i_pos_upper, p_sys->i_total_length );
     if ( i_pos_upper < 0 ) i_pos_upper = p_sys->i_total_length;
 
+    /* Reuse the pages met by the previous seeks */
+    const oggseek_granule_entry_t *p_known =
+        OggSeekGranulesBounds( p_stream, i_targettime, &i_pos_lower, &i_pos_upper );
+    if ( p_known )
+    {
+        bestlower.i_pos = p_known->i_pagepos;
+        bestlower.i_timestamp = p_known->i_time;
+        bestlower.i_granule = p_known->i_granule;
+    }
+
     i_start_pos = i_pos_lower;
     i_end_pos = i_pos_upper;
 
@@ -694,6 +790,8 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
         if ( current.i_pos != -1 && current.i_granule != -1 )
         {
             /* found a page */
+            OggSeekGranulesAdd( p_stream, current.i_pos, current.i_granule,
+                                current.i_timestamp );
 
             if ( current.i_timestamp <= i_targettime )
             {
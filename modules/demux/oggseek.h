@@ -58,6 +58,14 @@ struct oggseek_index_entry
     int64_t i_pagepos_end;
 };
 
+/* this is typedefed to oggseek_granule_entry_t in ogg.h */
+struct oggseek_granule_entry
+{
+    int64_t i_pagepos;
+    int64_t i_granule;
+    vlc_tick_t i_time;
+};
+
 int     Oggseek_BlindSeektoAbsoluteTime ( demux_t *, logical_stream_t *, vlc_tick_t, bool );
 int     Oggseek_BlindSeektoPosition ( demux_t *, logical_stream_t *, double f, bool );
 int     Oggseek_SeektoAbsolutetime ( demux_t *, logical_stream_t *, vlc_tick_t );
@@ -65,5 +73,6 @@ const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *, vlc_tick_t, in
 void    Oggseek_ProbeEnd( demux_t * );
 
 void oggseek_index_entries_free ( demux_index_entry_t * );
+void OggSeek_GranulesClean ( logical_stream_t * );
 
 int64_t oggseek_read_page ( demux_t * );
@@ -109,9 +109,15 @@ typedef struct
     size_t  i_line_count;
     size_t  i_line;
     char    **line;
+
+    /* Streamed mode: the lines are read on demand and not kept */
+    stream_t *s;
+    char    *psz_line;
+    bool    b_previous;
 } text_t;
 
 static int  TextLoad( text_t *, stream_t *s );
+static void TextStream( text_t *, stream_t *s );
 static void TextUnload( text_t * );
 
 typedef struct
@@ -167,6 +173,7 @@ typedef struct
         subtitle_t *p_array;
         size_t      i_count;
         size_t      i_current;
+        uint64_t   *pi_offset; /* indexed mode: text is read on demand */
     } subtitles;
 
     vlc_tick_t  i_length;
@@ -175,6 +182,8 @@ typedef struct
     subs_properties_t props;
 
     block_t * (*pf_convert)( const subtitle_t * );
+    int (*pf_read)( vlc_object_t *, subs_properties_t *, text_t *,
+                    subtitle_t *, size_t );
 } demux_sys_t;
 
 static int  ParseMicroDvd   ( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t *, size_t );
@@ -230,6 +239,27 @@ static const struct
  * to src/input/subtitles.c to enable auto-detection.
  */
 
+/* Files above this size are only indexed at load time (timings and offset
+ * of each entry), and the text is parsed again from the stream when the
+ * entry is sent. This is limited to the formats whose entries can be parsed
+ * independently of the previous ones. */
+#define SUB_INDEX_MIN_SIZE (4 << 20)
+
+static bool CanIndex( int i_type )
+{
+    switch( i_type )
+    {
+        case SUB_TYPE_MICRODVD:
+        case SUB_TYPE_SUBRIP:
+        case SUB_TYPE_SUBVIEWER:
+        case SUB_TYPE_MPL2:
+        case SUB_TYPE_SBV:
+            return true;
+        default:
+            return false;
+    }
+}
+
 static int Demux( demux_t * );
 static int Control( demux_t *, int, va_list );
 
@@ -316,6 +346,7 @@ static int Open ( vlc_object_t *p_this )
     p_sys->subtitles.i_current= 0;
     p_sys->subtitles.i_count  = 0;
     p_sys->subtitles.p_array  = NULL;
+    p_sys->subtitles.pi_offset = NULL;
 
     p_sys->props.psz_header         = NULL;
     p_sys->props.i_microsecperframe = VLC_TICK_FROM_MS(40);
@@ -633,9 +664,25 @@ static int Open ( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
-    /* Load the whole file */
+    p_sys->pf_read = pf_read;
+
+    uint64_t i_size;
+    bool b_index = false;
+    if( CanIndex( p_sys->props.i_type ) && e_bom != UTF16LE &&
+        e_bom != UTF16BE &&
+        vlc_stream_GetSize( p_demux->s, &i_size ) == VLC_SUCCESS &&
+        i_size >= SUB_INDEX_MIN_SIZE )
+        vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &b_index );
+
+    /* Load the whole file, or read it line by line to index it */
     text_t txtlines;
-    TextLoad( &txtlines, p_demux->s );
+    if( b_index )
+    {
+        msg_Dbg( p_demux, "indexing %"PRIu64" bytes of subtitles", i_size );
+        TextStream( &txtlines, p_demux->s );
+    }
+    else
+        TextLoad( &txtlines, p_demux->s );
 
     /* Parse it */
     for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
@@ -651,13 +698,35 @@ static int Open ( vlc_object_t *p_this )
                 return VLC_ENOMEM;
             }
             p_sys->subtitles.p_array = p_realloc;
+
+            if( b_index )
+            {
+                uint64_t *pi_realloc = realloc( p_sys->subtitles.pi_offset,
+                                                sizeof(uint64_t) * i_max );
+                if( pi_realloc == NULL )
+                {
+                    TextUnload( &txtlines );
+                    Close( p_this );
+                    return VLC_ENOMEM;
+                }
+                p_sys->subtitles.pi_offset = pi_realloc;
+            }
         }
 
+        subtitle_t *p_subtitle =
+            &p_sys->subtitles.p_array[p_sys->subtitles.i_count];
+        uint64_t i_offset = b_index ? vlc_stream_Tell( p_demux->s ) : 0;
+
         if( pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
-                     &p_sys->subtitles.p_array[p_sys->subtitles.i_count],
-                     p_sys->subtitles.i_count ) )
+                     p_subtitle, p_sys->subtitles.i_count ) )
             break;
 
+        if( b_index )
+        {   /* keep the timings only */
+            free( p_subtitle->psz_text );
+            p_subtitle->psz_text = NULL;
+            p_sys->subtitles.pi_offset[p_sys->subtitles.i_count] = i_offset;
+        }
         p_sys->subtitles.i_count++;
     }
     /* Unload */
@@ -729,6 +798,7 @@ static void Close( vlc_object_t *p_this )
     for( size_t i = 0; i < p_sys->subtitles.i_count; i++ )
         free( p_sys->subtitles.p_array[i].psz_text );
     free( p_sys->subtitles.p_array );
+    free( p_sys->subtitles.pi_offset );
     free( p_sys->props.psz_header );
 
     free( p_sys );
@@ -834,6 +904,26 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     return VLC_EGENERIC;
 }
 
+/*****************************************************************************
+ * LoadText: parse the text of an indexed subtitle again
+ *****************************************************************************/
+static char *LoadText( demux_t *p_demux, size_t i_idx )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    subtitle_t sub = { .psz_text = NULL };
+    text_t txt;
+
+    if( vlc_stream_Seek( p_demux->s, p_sys->subtitles.pi_offset[i_idx] ) )
+        return NULL;
+
+    TextStream( &txt, p_demux->s );
+    if( p_sys->pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txt, &sub,
+                        i_idx ) )
+        sub.psz_text = NULL;
+    TextUnload( &txt );
+    return sub.psz_text;
+}
+
 /*****************************************************************************
  * Demux: Send subtitle to decoder
  *****************************************************************************/
@@ -857,7 +947,19 @@ static int Demux( demux_t *p_demux )
 
         if( p_subtitle->i_start >= 0 )
         {
-            block_t *p_block = p_sys->pf_convert( p_subtitle );
+            subtitle_t sub = *p_subtitle;
+            if( p_sys->subtitles.pi_offset != NULL )
+            {
+                sub.psz_text = LoadText( p_demux, p_sys->subtitles.i_current );
+                if( sub.psz_text == NULL )
+                    msg_Warn( p_demux, "cannot read subtitle %zu",
+                              p_sys->subtitles.i_current );
+            }
+
+            block_t *p_block = sub.psz_text != NULL ?
+                               p_sys->pf_convert( &sub ) : NULL;
+            if( p_sys->subtitles.pi_offset != NULL )
+                free( sub.psz_text );
             if( p_block )
             {
                 p_block->i_dts =
@@ -911,6 +1013,8 @@ static int TextLoad( text_t *txt, stream_t *s )
     i_line_max          = 500;
     txt->i_line_count   = 0;
     txt->i_line         = 0;
+    txt->s              = NULL;
+    txt->psz_line       = NULL;
     txt->line           = calloc( i_line_max, sizeof( char * ) );
     if( !txt->line )
         return VLC_ENOMEM;
@@ -951,12 +1055,35 @@ static void TextUnload( text_t *txt )
             free( txt->line[i] );
         free( txt->line );
     }
+    free( txt->psz_line );
+    txt->psz_line     = NULL;
     txt->i_line       = 0;
     txt->i_line_count = 0;
 }
+static void TextStream( text_t *txt, stream_t *s )
+{
+    txt->i_line_count = 0;
+    txt->i_line       = 0;
+    txt->line         = NULL;
+    txt->s            = s;
+    txt->psz_line     = NULL;
+    txt->b_previous   = false;
+}
 
 static char *TextGetLine( text_t *txt )
 {
+    if( txt->s != NULL )
+    {
+        if( txt->b_previous )
+        {
+            txt->b_previous = false;
+            return txt->psz_line;
+        }
+        free( txt->psz_line );
+        txt->psz_line = vlc_stream_ReadLine( txt->s );
+        return txt->psz_line;
+    }
+
     if( txt->i_line >= txt->i_line_count )
         return( NULL );
 
@@ -964,7 +1091,9 @@ static char *TextGetLine( text_t *txt )
 }
 static void TextPreviousLine( text_t *txt )
 {
-    if( txt->i_line > 0 )
+    if( txt->s != NULL )
+        txt->b_previous = txt->psz_line != NULL;
+    else if( txt->i_line > 0 )
         txt->i_line--;
 }
 
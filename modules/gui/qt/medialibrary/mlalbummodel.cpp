@@ -28,7 +28,7 @@ QHash<QByteArray, vlc_ml_sorting_criteria_t> MLAlbumModel::M_names_to_criteria =
 };
 
 MLAlbumModel::MLAlbumModel(QObject *parent)
-    : MLSlidingWindowModel<MLAlbum>(parent)
+    : MLSlidingWindowModel<MLAlbum>(&MLAlbumModel::fetch, parent)
 {
 }
 
@@ -78,18 +78,19 @@ QHash<int, QByteArray> MLAlbumModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLAlbum>> MLAlbumModel::fetch( )
+std::vector<std::unique_ptr<MLAlbum>> MLAlbumModel::fetch( const MLQuery& query )
 {
+    vlc_ml_query_params_t params = query.params();
     ml_unique_ptr<vlc_ml_album_list_t> album_list;
-    if ( m_parent.id <= 0 )
-        album_list.reset( vlc_ml_list_albums(m_ml, &m_query_param ) );
+    if ( query.parent.id <= 0 )
+        album_list.reset( vlc_ml_list_albums(query.ml, &params ) );
     else
-        album_list.reset( vlc_ml_list_albums_of(m_ml, &m_query_param, m_parent.type, m_parent.id ) );
+        album_list.reset( vlc_ml_list_albums_of(query.ml, &params, query.parent.type, query.parent.id ) );
     if ( album_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLAlbum>> res;
     for( const vlc_ml_album_t& album: ml_range_iterate<vlc_ml_album_t>( album_list ) )
-        res.emplace_back( std::make_unique<MLAlbum>( m_ml, &album ) );
+        res.emplace_back( std::make_unique<MLAlbum>( query.ml, &album ) );
     return res;
 }
 
@@ -48,7 +48,7 @@ QHash<QByteArray, vlc_ml_sorting_criteria_t> MLAlbumTrackModel::M_names_to_crite
 };
 
 MLAlbumTrackModel::MLAlbumTrackModel(QObject *parent)
-    : MLSlidingWindowModel<MLAlbumTrack>(parent)
+    : MLSlidingWindowModel<MLAlbumTrack>(&MLAlbumTrackModel::fetch, parent)
 {
 }
 
@@ -118,19 +118,20 @@ size_t MLAlbumTrackModel::countTotalElements() const
     return vlc_ml_count_media_of(m_ml, &queryParams, m_parent.type, m_parent.id );
 }
 
-std::vector<std::unique_ptr<MLAlbumTrack>> MLAlbumTrackModel::fetch()
+std::vector<std::unique_ptr<MLAlbumTrack>> MLAlbumTrackModel::fetch( const MLQuery& query )
 {
+    vlc_ml_query_params_t params = query.params();
     ml_unique_ptr<vlc_ml_media_list_t> media_list;
 
-    if ( m_parent.id <= 0 )
-        media_list.reset( vlc_ml_list_audio_media(m_ml, &m_query_param) );
+    if ( query.parent.id <= 0 )
+        media_list.reset( vlc_ml_list_audio_media(query.ml, &params) );
     else
-        media_list.reset( vlc_ml_list_media_of(m_ml, &m_query_param, m_parent.type, m_parent.id ) );
+        media_list.reset( vlc_ml_list_media_of(query.ml, &params, query.parent.type, query.parent.id ) );
     if ( media_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLAlbumTrack>> res;
     for( const vlc_ml_media_t& media: ml_range_iterate<vlc_ml_media_t>( media_list ) )
-        res.emplace_back( std::make_unique<MLAlbumTrack>( m_ml, &media ) );
+        res.emplace_back( std::make_unique<MLAlbumTrack>( query.ml, &media ) );
     return res;
 }
 
@@ -34,7 +34,7 @@ QHash<QByteArray, vlc_ml_sorting_criteria_t> MLArtistModel::M_names_to_criteria
 };
 
 MLArtistModel::MLArtistModel(QObject *parent)
-    : MLSlidingWindowModel(parent)
+    : MLSlidingWindowModel<MLArtist>(&MLArtistModel::fetch, parent)
 {
 }
 
@@ -75,13 +75,14 @@ QHash<int, QByteArray> MLArtistModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLArtist>> MLArtistModel::fetch()
+std::vector<std::unique_ptr<MLArtist>> MLArtistModel::fetch( const MLQuery& query )
 {
+    vlc_ml_query_params_t params = query.params();
     ml_unique_ptr<vlc_ml_artist_list_t> artist_list;
-    if ( m_parent.id <= 0 )
-        artist_list.reset( vlc_ml_list_artists(m_ml, &m_query_param, false) );
+    if ( query.parent.id <= 0 )
+        artist_list.reset( vlc_ml_list_artists(query.ml, &params, false) );
     else
-        artist_list.reset( vlc_ml_list_artist_of(m_ml, &m_query_param, m_parent.type, m_parent.id) );
+        artist_list.reset( vlc_ml_list_artist_of(query.ml, &params, query.parent.type, query.parent.id) );
     if ( artist_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLArtist>> res;
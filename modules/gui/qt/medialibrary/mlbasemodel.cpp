@@ -89,6 +89,19 @@ void MLBaseModel::onVlcMlEvent(void* data, const vlc_ml_event_t* event)
     self->onVlcMlEvent(event);
 }
 
+MLQuery MLBaseModel::query( uint32_t offset, uint32_t count ) const
+{
+    MLQuery query;
+    query.ml = m_ml;
+    query.parent = m_parent;
+    query.m_params = m_query_param;
+    query.m_params.i_offset = offset;
+    query.m_params.i_nbResults = count;
+    if ( m_query_param.psz_pattern != nullptr )
+        query.m_pattern = QByteArray( m_query_param.psz_pattern );
+    return query;
+}
+
 MLParentId MLBaseModel::parentId() const
 {
     return m_parent;
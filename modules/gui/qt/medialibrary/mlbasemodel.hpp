@@ -24,9 +24,13 @@
 #endif
 #include "vlc_common.h"
 
+#include <algorithm>
 #include <memory>
 #include <QObject>
 #include <QAbstractListModel>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 #include "vlc_media_library.h"
 #include "mlqmltypes.hpp"
 #include "medialib.hpp"
@@ -34,6 +38,26 @@
 
 class MediaLib;
 
+/**
+ * Snapshot of the state of a model query, to run it out of the UI thread
+ */
+struct MLQuery
+{
+    vlc_medialibrary_t* ml;
+    MLParentId parent;
+
+    /* The pattern points to the snapshot own copy */
+    vlc_ml_query_params_t params() const
+    {
+        vlc_ml_query_params_t res = m_params;
+        res.psz_pattern = m_pattern.isNull() ? nullptr : m_pattern.constData();
+        return res;
+    }
+
+    vlc_ml_query_params_t m_params;
+    QByteArray m_pattern;
+};
+
 class MLBaseModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -93,6 +117,8 @@ protected:
 
     virtual void onVlcMlEvent( const vlc_ml_event_t* event );
 
+    MLQuery query( uint32_t offset, uint32_t count ) const;
+
     MLParentId m_parent;
 
     vlc_medialibrary_t* m_ml;
@@ -112,23 +138,50 @@ protected:
 };
 
 /**
- * Implements a basic sliding window.
- * const_cast & immutable are unavoidable, since all access member functions
- * are marked as const. fetchMore & canFetchMore don't allow for the full size
- * to be known (so the scrollbar would grow as we scroll, until we displayed all
- * elements), and implies having all elements loaded in RAM at all time.
+ * Implements a sliding window over the query results.
+ *
+ * The rows are fetched by batches of BatchSize, on a worker thread, when a
+ * view first asks for them; an empty row is reported until the batch is
+ * loaded, then dataChanged() is emitted. The batch next to the accessed half
+ * of the current one is prefetched, and only CacheSize batches are kept, the
+ * least recently used being dropped first (along with any cover or thumbnail
+ * request of their items).
+ *
+ * The fetch function is static: it runs on a snapshot of the query (see
+ * MLQuery), while the UI thread may change or destroy the model. The total
+ * count is still queried synchronously, as fetchMore & canFetchMore don't
+ * allow for the full size to be known (so the scrollbar would grow as we
+ * scroll).
+ *
+ * const_cast & mutable are unavoidable, since all access member functions
+ * are marked as const.
  */
 template <typename T>
 class MLSlidingWindowModel : public MLBaseModel
 {
 public:
     static constexpr size_t BatchSize = 100;
+    static constexpr size_t CacheSize = 8;
+
+    using FetchFunc = std::vector<std::unique_ptr<T>> (*)( const MLQuery& );
 
-    MLSlidingWindowModel(QObject* parent = nullptr)
+    MLSlidingWindowModel(FetchFunc fetch, QObject* parent = nullptr)
         : MLBaseModel(parent)
+        , m_fetch(fetch)
         , m_initialized(false)
+        , m_total_count(0)
+        , m_use_count(0)
+        , m_generation(0)
     {
         m_query_param.i_nbResults = BatchSize;
+        /* one query at a time, in the order of the requests */
+        m_pool.setMaxThreadCount(1);
+    }
+
+    ~MLSlidingWindowModel()
+    {
+        m_pool.clear();
+        m_pool.waitForDone();
     }
 
     int rowCount(const QModelIndex &parent) const override
@@ -136,19 +189,14 @@ public:
         if (parent.isValid())
             return 0;
         vlc_mutex_locker lock( &m_item_lock );
-        if ( m_initialized == false )
-        {
-            m_item_list = const_cast<MLSlidingWindowModel<T>*>(this)->fetch();
-            m_total_count = countTotalElements();
-            m_initialized = true;
-        }
+        initialize();
         return m_total_count;
     }
 
     virtual T* get(unsigned int idx) const
     {
         vlc_mutex_locker lock( &m_item_lock );
-        T* obj = item( idx );
+        T* obj = item( idx, true );
         if (!obj)
             return nullptr;
         return obj->clone();
@@ -157,52 +205,178 @@ public:
     void clear() override
     {
         vlc_mutex_locker lock( &m_item_lock );
-        m_query_param.i_offset = 0;
+        /* the batches being fetched are dropped when they arrive */
+        m_pool.clear();
+        m_generation++;
         m_initialized = false;
         m_total_count = 0;
-        m_item_list.clear();
+        m_batches.clear();
+        m_pending.clear();
     }
 
 protected:
-    T* item(unsigned int idx) const
+    /**
+     * Returns the item at the given row, or nullptr if it is not loaded yet
+     * (unless sync is set, then it is fetched on the calling thread).
+     */
+    T* item(unsigned int idx, bool sync = false) const
     {
         // Must be called in a locked context
-        if ( m_initialized == false )
-        {
-            m_total_count = countTotalElements();
-            if ( m_total_count > 0 )
-                m_item_list = const_cast<MLSlidingWindowModel<T>*>(this)->fetch();
-            m_initialized = true;
-        }
+        initialize();
 
-        if ( m_total_count == 0 || idx >= m_total_count || idx < 0 )
+        if ( idx >= m_total_count )
             return nullptr;
 
-        if ( idx < m_query_param.i_offset ||  idx >= m_query_param.i_offset + m_item_list.size() )
+        size_t offset = idx - idx % BatchSize;
+        Batch* batch = findBatch( offset );
+        if ( batch == nullptr )
         {
-            if (m_query_param.i_nbResults == 0)
-                m_query_param.i_offset = 0;
-            else
-                m_query_param.i_offset = idx - idx % m_query_param.i_nbResults;
-            m_item_list = const_cast<MLSlidingWindowModel<T>*>(this)->fetch();
+            if ( !sync )
+            {
+                request( offset );
+                return nullptr;
+            }
+            batch = insertBatch( offset, m_fetch( query( offset, BatchSize ) ) );
         }
+        batch->last_use = ++m_use_count;
+
+        /* prefetch the neighbour batch the view is scrolling to */
+        if ( idx - offset >= BatchSize / 2 )
+        {
+            if ( offset + BatchSize < m_total_count )
+                request( offset + BatchSize );
+        }
+        else if ( offset > 0 )
+            request( offset - BatchSize );
 
         //db has changed
-        if ( idx - m_query_param.i_offset >= m_item_list.size() || idx - m_query_param.i_offset < 0 )
+        if ( idx - offset >= batch->items.size() )
             return nullptr;
-        return m_item_list[idx - m_query_param.i_offset].get();
+        return batch->items[idx - offset].get();
     }
 
 private:
+    struct Batch
+    {
+        size_t offset;
+        uint64_t last_use;
+        std::vector<std::unique_ptr<T>> items;
+    };
+
+    using Items = std::shared_ptr<std::vector<std::unique_ptr<T>>>;
+
+    class FetchTask : public QRunnable
+    {
+    public:
+        FetchTask(MLSlidingWindowModel<T>* model, MLQuery query,
+                  size_t offset, unsigned generation)
+            : m_model(model)
+            , m_fetch(model->m_fetch)
+            , m_thread(model->thread())
+            , m_query(std::move(query))
+            , m_offset(offset)
+            , m_generation(generation)
+        {
+        }
+
+        void run() override
+        {
+            Items items = std::make_shared<std::vector<std::unique_ptr<T>>>(
+                        m_fetch( m_query ) );
+            for ( auto& item : *items )
+                item->moveToThread( m_thread );
+
+            /* dropped if the model is destroyed meanwhile */
+            auto model = m_model;
+            auto offset = m_offset;
+            auto generation = m_generation;
+            QMetaObject::invokeMethod( model, [model, offset, generation, items]() {
+                model->onBatchFetched( offset, generation, items );
+            }, Qt::QueuedConnection );
+        }
+
+    private:
+        MLSlidingWindowModel<T>* m_model;
+        FetchFunc m_fetch;
+        QThread* m_thread;
+        MLQuery m_query;
+        size_t m_offset;
+        unsigned m_generation;
+    };
+
     virtual size_t countTotalElements() const = 0;
-    virtual std::vector<std::unique_ptr<T>> fetch() = 0;
 
-protected:
-    mutable std::vector<std::unique_ptr<T>> m_item_list;
+    // Must be called in a locked context
+    void initialize() const
+    {
+        if ( m_initialized )
+            return;
+        m_total_count = countTotalElements();
+        m_initialized = true;
+        if ( m_total_count > 0 )
+            request( 0 );
+    }
 
-private:
+    Batch* findBatch(size_t offset) const
+    {
+        for ( auto& batch : m_batches )
+            if ( batch.offset == offset )
+                return &batch;
+        return nullptr;
+    }
+
+    Batch* insertBatch(size_t offset, std::vector<std::unique_ptr<T>> items) const
+    {
+        if ( m_batches.size() >= CacheSize )
+        {
+            auto lru = std::min_element( m_batches.begin(), m_batches.end(),
+                    [](const Batch& a, const Batch& b) {
+                        return a.last_use < b.last_use;
+                    });
+            m_batches.erase( lru );
+        }
+        m_batches.push_back( Batch{ offset, ++m_use_count, std::move(items) } );
+        return &m_batches.back();
+    }
+
+    void request(size_t offset) const
+    {
+        if ( findBatch( offset ) != nullptr
+          || std::find( m_pending.begin(), m_pending.end(), offset ) != m_pending.end() )
+            return;
+        m_pending.push_back( offset );
+
+        auto self = const_cast<MLSlidingWindowModel<T>*>(this);
+        m_pool.start( new FetchTask( self, query( offset, BatchSize ),
+                                     offset, m_generation ) );
+    }
+
+    void onBatchFetched(size_t offset, unsigned generation, Items items)
+    {
+        size_t count;
+        {
+            vlc_mutex_locker lock( &m_item_lock );
+            if ( generation != m_generation )
+                return;
+            m_pending.erase( std::remove( m_pending.begin(), m_pending.end(), offset ),
+                             m_pending.end() );
+            if ( offset >= m_total_count || findBatch( offset ) != nullptr )
+                return;
+            count = std::min( items->size(), m_total_count - offset );
+            insertBatch( offset, std::move( *items ) );
+        }
+        if ( count > 0 )
+            emit dataChanged( index( offset ), index( offset + count - 1 ) );
+    }
+
+    FetchFunc m_fetch;
+    mutable std::vector<Batch> m_batches;
+    mutable std::vector<size_t> m_pending;
     mutable bool m_initialized;
     mutable size_t m_total_count;
+    mutable uint64_t m_use_count;
+    unsigned m_generation;
+    mutable QThreadPool m_pool;
 };
 
 #endif // MLBASEMODEL_HPP
@@ -38,7 +38,7 @@ QHash<QByteArray, vlc_ml_sorting_criteria_t> MLGenreModel::M_names_to_criteria =
 };
 
 MLGenreModel::MLGenreModel(QObject *parent)
-    : MLSlidingWindowModel<MLGenre>(parent)
+    : MLSlidingWindowModel<MLGenre>(&MLGenreModel::fetch, parent)
 {
 }
 
@@ -80,16 +80,17 @@ QHash<int, QByteArray> MLGenreModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLGenre>> MLGenreModel::fetch()
+std::vector<std::unique_ptr<MLGenre>> MLGenreModel::fetch( const MLQuery& query )
 {
+    vlc_ml_query_params_t params = query.params();
     ml_unique_ptr<vlc_ml_genre_list_t> genre_list(
-        vlc_ml_list_genres(m_ml, &m_query_param)
+        vlc_ml_list_genres(query.ml, &params)
     );
     if ( genre_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLGenre>> res;
     for( const vlc_ml_genre_t& genre: ml_range_iterate<vlc_ml_genre_t>( genre_list ) )
-        res.emplace_back( std::make_unique<MLGenre>( m_ml, &genre ) );
+        res.emplace_back( std::make_unique<MLGenre>( query.ml, &genre ) );
     return res;
 }
 
@@ -40,7 +40,7 @@ public:
     QVariant data(const QModelIndex &index, int role) const override;
 
 private:
-    std::vector<std::unique_ptr<MLGenre>> fetch() override;
+    static std::vector<std::unique_ptr<MLGenre>> fetch( const MLQuery& query );
     size_t countTotalElements() const override;
     void onVlcMlEvent(const vlc_ml_event_t* event) override;
     vlc_ml_sorting_criteria_t roleToCriteria(int role) const override;
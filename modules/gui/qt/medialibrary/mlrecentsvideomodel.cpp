@@ -37,7 +37,7 @@ enum Role {
 }
 
 MLRecentsVideoModel::MLRecentsVideoModel( QObject* parent )
-    : MLSlidingWindowModel<MLVideo>( parent )
+    : MLSlidingWindowModel<MLVideo>( &MLRecentsVideoModel::fetch, parent )
 {
 }
 
@@ -92,30 +92,39 @@ QHash<int, QByteArray> MLRecentsVideoModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLVideo> > MLRecentsVideoModel::fetch()
+std::vector<std::unique_ptr<MLVideo>> MLRecentsVideoModel::fetch( const MLQuery& query )
 {
+    vlc_ml_query_params_t params = query.params();
     ml_unique_ptr<vlc_ml_media_list_t> media_list{ vlc_ml_list_history(
-                m_ml, &m_query_param ) };
+                query.ml, &params ) };
     if ( media_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLVideo>> res;
-    m_video_count = 0;
     for( vlc_ml_media_t &media: ml_range_iterate<vlc_ml_media_t>( media_list ) )
         if( media.i_type == VLC_ML_MEDIA_TYPE_VIDEO )
-        {
-            m_video_count++;
-            res.emplace_back( std::make_unique<MLVideo>( m_ml, &media ) );
-        }
+            res.emplace_back( std::make_unique<MLVideo>( query.ml, &media ) );
     return res;
 }
 
 size_t MLRecentsVideoModel::countTotalElements() const
 {
+    /* The history has no count of its videos, but it is short */
+    auto queryParams = m_query_param;
+    queryParams.i_offset = 0;
+    queryParams.i_nbResults = BatchSize;
+    ml_unique_ptr<vlc_ml_media_list_t> media_list{ vlc_ml_list_history(
+                m_ml, &queryParams ) };
+    if ( media_list == nullptr )
+        return 0;
+    int video_count = 0;
+    for( const vlc_ml_media_t &media: ml_range_iterate<vlc_ml_media_t>( media_list ) )
+        if( media.i_type == VLC_ML_MEDIA_TYPE_VIDEO )
+            video_count++;
 
     if(numberOfItemsToShow == -1){
-        return m_video_count;
+        return video_count;
     }
-    return std::min(m_video_count,numberOfItemsToShow);
+    return std::min(video_count,numberOfItemsToShow);
 }
 
 void MLRecentsVideoModel::onVlcMlEvent( const vlc_ml_event_t* event )
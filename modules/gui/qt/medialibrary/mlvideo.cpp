@@ -166,7 +166,8 @@ QString MLVideo::getTitle() const
 
 QString MLVideo::getThumbnail()
 {
-    if ( m_thumbnailGenerated == false )
+    /* Requested once, when first displayed */
+    if ( m_thumbnailGenerated == false && m_ml_event_handle == nullptr )
     {
         m_ml_event_handle.reset( vlc_ml_event_register_callback( m_ml, onMlEvent, this ) );
         vlc_ml_media_generate_thumbnail( m_ml, m_id.id, VLC_ML_THUMBNAIL_SMALL,
@@ -46,7 +46,7 @@ QHash<QByteArray, vlc_ml_sorting_criteria_t> MLVideoModel::M_names_to_criteria =
 };
 
 MLVideoModel::MLVideoModel(QObject* parent)
-    : MLSlidingWindowModel<MLVideo>(parent)
+    : MLSlidingWindowModel<MLVideo>(&MLVideoModel::fetch, parent)
 {
 }
 
@@ -105,15 +105,16 @@ QHash<int, QByteArray> MLVideoModel::roleNames() const
     };
 }
 
-std::vector<std::unique_ptr<MLVideo> > MLVideoModel::fetch()
+std::vector<std::unique_ptr<MLVideo>> MLVideoModel::fetch( const MLQuery& query )
 {
+    vlc_ml_query_params_t params = query.params();
     ml_unique_ptr<vlc_ml_media_list_t> media_list{ vlc_ml_list_video_media(
-                m_ml, &m_query_param ) };
+                query.ml, &params ) };
     if ( media_list == nullptr )
         return {};
     std::vector<std::unique_ptr<MLVideo>> res;
     for( vlc_ml_media_t &media: ml_range_iterate<vlc_ml_media_t>( media_list ) )
-        res.emplace_back( std::make_unique<MLVideo>(m_ml, &media) );
+        res.emplace_back( std::make_unique<MLVideo>(query.ml, &media) );
     return res;
 }
 
@@ -43,7 +43,7 @@ public:
     QHash<int, QByteArray> roleNames() const override;
 
 private:
-    std::vector<std::unique_ptr<MLVideo>> fetch() override;
+    static std::vector<std::unique_ptr<MLVideo>> fetch( const MLQuery& query );
     size_t countTotalElements() const override;
     vlc_ml_sorting_criteria_t roleToCriteria(int role) const override;
     vlc_ml_sorting_criteria_t nameToCriteria(QByteArray name) const override;
@@ -33,6 +33,8 @@ typedef struct cma_buf_s cma_buf_t;
 size_t cma_buf_size(const cma_buf_t * const cb);
 unsigned int cma_buf_vc_handle(const cma_buf_t *const cb);
 void * cma_buf_addr(const cma_buf_t *const cb);
+// DMA-BUF handle (owned by the buffer) or -1 if not CMA backed
+int cma_buf_fd(const cma_buf_t *const cb);
 
 void cma_buf_unref(cma_buf_t * const cb);
 cma_buf_t * cma_buf_ref(cma_buf_t * const cb);
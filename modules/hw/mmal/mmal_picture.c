@@ -333,6 +333,20 @@ MMAL_BUFFER_HEADER_T * hw_mmal_pic_sub_buf_get(picture_t * const pic, const unsi
     return sub_no + 1 > ctx->buf_count ? NULL : ctx->bufs[sub_no + 1];
 }
 
+cma_buf_t * hw_mmal_pic_cma_buf(const picture_t * const pic)
+{
+    const pic_ctx_mmal_t * const ctx = (pic_ctx_mmal_t *)pic->context;
+
+    return ctx == NULL ? NULL : ctx->cb;
+}
+
+int hw_mmal_pic_dmabuf_fd(const picture_t * const pic)
+{
+    const cma_buf_t * const cb = hw_mmal_pic_cma_buf(pic);
+
+    return cb == NULL ? -1 : cma_buf_fd(cb);
+}
+
 static void hw_mmal_pic_ctx_destroy(picture_context_t * pic_ctx_cmn)
 {
     pic_ctx_mmal_t * const ctx = (pic_ctx_mmal_t *)pic_ctx_cmn;
@@ -61,6 +61,12 @@ MMAL_STATUS_T hw_mmal_opaque_output(vlc_object_t * const obj,
 
 MMAL_BUFFER_HEADER_T * hw_mmal_pic_sub_buf_get(picture_t * const pic, const unsigned int n);
 
+// CMA buffer backing the picture (not referenced) or NULL if the picture
+// lives in GPU memory only
+cma_buf_t * hw_mmal_pic_cma_buf(const picture_t * const pic);
+// DMA-BUF handle of the picture, valid while the picture is held, or -1
+int hw_mmal_pic_dmabuf_fd(const picture_t * const pic);
+
 static inline bool hw_mmal_chroma_is_mmal(const vlc_fourcc_t chroma)
 {
     return
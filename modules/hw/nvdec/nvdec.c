@@ -82,6 +82,7 @@ typedef struct nvdec_ctx {
     CudaFunctions               *cudaFunctions;
     CUVIDDECODECAPS             selectedDecoder;
     CUcontext                   cuCtx;
+    CUstream                    cuStream; ///< copies of the decoded frames
     CUvideodecoder              cudecoder;
     CUvideoparser               cuparser;
     union {
@@ -357,6 +358,7 @@ static int CUDAAPI HandlePictureDisplay(void *p_opaque, CUVIDPARSERDISPINFO *p_d
         .top_field_first = p_dispinfo->top_field_first,
         .second_field = p_dispinfo->repeat_first_field + 1,
         .unpaired_field = p_dispinfo->repeat_first_field < 0,
+        .output_stream = p_sys->cuStream,
     };
     int result;
 
@@ -411,7 +413,7 @@ static int CUDAAPI HandlePictureDisplay(void *p_opaque, CUVIDPARSERDISPINFO *p_d
                     .WidthInBytes   = i_pitch,
                     .Height         = __MIN(picctx->bufferHeight, p_dec->fmt_out.video.i_y_offset + p_dec->fmt_out.video.i_visible_height),
                 };
-                result = CALL_CUDA_DEC(cuMemcpy2DAsync, &cu_cpy, 0);
+                result = CALL_CUDA_DEC(cuMemcpy2DAsync, &cu_cpy, p_sys->cuStream);
                 if (unlikely(result != VLC_SUCCESS))
                 {
                     free(picctx);
@@ -438,7 +440,7 @@ static int CUDAAPI HandlePictureDisplay(void *p_opaque, CUVIDPARSERDISPINFO *p_d
                 };
                 if (i_plane == 1)
                     cu_cpy.Height >>= 1;
-                result = CALL_CUDA_DEC(cuMemcpy2DAsync, &cu_cpy, 0);
+                result = CALL_CUDA_DEC(cuMemcpy2DAsync, &cu_cpy, p_sys->cuStream);
                 if (unlikely(result != VLC_SUCCESS))
                 {
                     free(picctx);
@@ -487,13 +489,18 @@ static int CUDAAPI HandlePictureDisplay(void *p_opaque, CUVIDPARSERDISPINFO *p_d
                 .WidthInBytes   = i_pitch,
                 .Height         = plane.i_visible_lines,
             };
-            result = CALL_CUDA_DEC(cuMemcpy2D, &cu_cpy);
+            result = CALL_CUDA_DEC(cuMemcpy2DAsync, &cu_cpy, p_sys->cuStream);
             if (result != VLC_SUCCESS)
                 goto error;
             srcY += p_sys->decoderHeight;
         }
     }
 
+    // The copies must be done before the surface is reused by the decoder
+    result = CALL_CUDA_DEC(cuStreamSynchronize, p_sys->cuStream);
+    if (unlikely(result != VLC_SUCCESS))
+        goto error;
+
     // Release surface on GPU
     result = CALL_CUVID(cuvidUnmapVideoFrame, p_sys->cudecoder, frameDevicePtr);
     if (unlikely(result != VLC_SUCCESS))
@@ -769,6 +776,11 @@ static int OpenDecoder(vlc_object_t *p_this)
     if (result != VLC_SUCCESS)
         goto error;
     result = CALL_CUDA_DEC(cuCtxCreate, &p_sys->cuCtx, 0, 0);
+    if (result != VLC_SUCCESS)
+        goto error;
+    // a stream of our own, so frame copies do not serialize with other work
+    // on the default stream of the context
+    result = CALL_CUDA_DEC(cuStreamCreate, &p_sys->cuStream, CU_STREAM_NON_BLOCKING);
     if (result != VLC_SUCCESS)
         goto error;
 
@@ -997,6 +1009,8 @@ static void CloseDecoder(vlc_object_t *p_this)
         CALL_CUVID(cuvidDestroyDecoder, p_sys->cudecoder);
     if (p_sys->cuparser)
         CALL_CUVID(cuvidDestroyVideoParser, p_sys->cuparser);
+    if (p_sys->cuStream)
+        CALL_CUDA_DEC(cuStreamDestroy, p_sys->cuStream);
     if (p_sys->cuCtx)
         CALL_CUDA_DEC(cuCtxDestroy, p_sys->cuCtx);
     if (p_sys->vctx_out)
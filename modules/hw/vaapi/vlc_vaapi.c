@@ -41,6 +41,7 @@
 #include <vlc_fourcc.h>
 #include <vlc_filter.h>
 #include <vlc_picture_pool.h>
+#include <vlc_fs.h>
 
 void
 vlc_chroma_to_vaapi(int i_vlc_chroma, unsigned *va_rt_format, int *va_fourcc)
@@ -176,6 +177,30 @@ vlc_vaapi_ReleaseBufferHandle(vlc_object_t *o, VADisplay dpy, VABufferID buf_id)
 error: return VLC_EGENERIC;
 }
 
+#ifdef VLC_VAAPI_HAS_EXPORT
+int
+vlc_vaapi_ExportSurfaceHandle(vlc_object_t *o, VADisplay dpy,
+                              VASurfaceID surface,
+                              VADRMPRIMESurfaceDescriptor *desc)
+{
+    VA_CALL(o, vaSyncSurface, dpy, surface);
+    VA_CALL(o, vaExportSurfaceHandle, dpy, surface,
+            VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+            VA_EXPORT_SURFACE_READ_ONLY | VA_EXPORT_SURFACE_COMPOSED_LAYERS,
+            desc);
+    return VLC_SUCCESS;
+error: return VLC_EGENERIC;
+}
+
+void
+vlc_vaapi_CloseSurfaceHandle(VADRMPRIMESurfaceDescriptor *desc)
+{
+    for (uint32_t i = 0; i < desc->num_objects; i++)
+        vlc_close(desc->objects[i].fd);
+    desc->num_objects = 0;
+}
+#endif
+
 /*****************
  * VAAPI queries *
  *****************/
@@ -401,6 +426,182 @@ error:
     return VA_INVALID_ID;
 }
 
+/*****************
+ * Surface cache *
+ *****************/
+
+/* Released surfaces are kept per display and format, and handed out again to
+ * the next pool (decoder, filter or interop) needing the same kind of
+ * surfaces. A display cannot be tracked after it is terminated, so the idle
+ * surfaces are only kept while some surfaces of the display are in use. */
+
+#define VAAPI_MAX_IDLE_SURFACES 64
+
+struct vaapi_idle_surface
+{
+    struct vaapi_idle_surface *next;
+    unsigned rt_format;
+    int fourcc;
+    unsigned width;
+    unsigned height;
+    VASurfaceID id;
+};
+
+struct vaapi_surface_cache
+{
+    struct vaapi_surface_cache *next;
+    VADisplay dpy;
+    unsigned users; /* sets of surfaces in use */
+    unsigned in_use;
+    unsigned idle_count;
+    struct vaapi_idle_surface *idle;
+    unsigned long created;
+    unsigned long reused;
+};
+
+static vlc_mutex_t surface_cache_lock = VLC_STATIC_MUTEX;
+static struct vaapi_surface_cache *surface_caches = NULL;
+
+static struct vaapi_surface_cache *
+vlc_vaapi_FindSurfaceCache(VADisplay dpy)
+{
+    for (struct vaapi_surface_cache *cache = surface_caches; cache != NULL;
+         cache = cache->next)
+        if (cache->dpy == dpy)
+            return cache;
+    return NULL;
+}
+
+int
+vlc_vaapi_AcquireSurfaces(vlc_object_t *o, VADisplay dpy,
+                          const video_format_t *restrict fmt,
+                          VASurfaceID *ids, unsigned count)
+{
+    unsigned va_rt_format;
+    int va_fourcc;
+    vlc_chroma_to_vaapi(fmt->i_chroma, &va_rt_format, &va_fourcc);
+
+    unsigned width = fmt->i_visible_width, height = fmt->i_visible_height;
+    unsigned n = 0;
+
+    vlc_mutex_lock(&surface_cache_lock);
+    struct vaapi_surface_cache *cache = vlc_vaapi_FindSurfaceCache(dpy);
+    if (cache == NULL)
+    {
+        cache = calloc(1, sizeof (*cache));
+        if (unlikely(cache == NULL))
+        {
+            vlc_mutex_unlock(&surface_cache_lock);
+            return VLC_ENOMEM;
+        }
+        cache->dpy = dpy;
+        cache->next = surface_caches;
+        surface_caches = cache;
+    }
+
+    for (struct vaapi_idle_surface **pp = &cache->idle, *s; n < count
+         && (s = *pp) != NULL;)
+    {
+        if (s->rt_format == va_rt_format && s->fourcc == va_fourcc
+         && s->width == width && s->height == height)
+        {
+            ids[n++] = s->id;
+            *pp = s->next;
+            free(s);
+            cache->idle_count--;
+        }
+        else
+            pp = &s->next;
+    }
+    cache->users++;
+    cache->in_use += n;
+    cache->reused += n;
+    vlc_mutex_unlock(&surface_cache_lock);
+
+    if (n < count)
+    {
+        VASurfaceAttrib fourcc_attribs[1] = {
+            {
+                .type = VASurfaceAttribPixelFormat,
+                .flags = VA_SURFACE_ATTRIB_SETTABLE,
+                .value.type    = VAGenericValueTypeInteger,
+                .value.value.i = va_fourcc,
+            }
+        };
+
+        VA_CALL(o, vaCreateSurfaces, dpy, va_rt_format, width, height,
+                ids + n, count - n, fourcc_attribs, 1);
+    }
+
+    vlc_mutex_lock(&surface_cache_lock);
+    cache->in_use += count - n;
+    cache->created += count - n;
+    msg_Dbg(o, "%u surfaces (%u reused), display totals: %u in use, %u idle, "
+            "%lu created, %lu reused", count, n, cache->in_use,
+            cache->idle_count, cache->created, cache->reused);
+    vlc_mutex_unlock(&surface_cache_lock);
+    return VLC_SUCCESS;
+
+error:
+    vlc_vaapi_ReleaseSurfaces(dpy, fmt, ids, n);
+    return VLC_EGENERIC;
+}
+
+void
+vlc_vaapi_ReleaseSurfaces(VADisplay dpy, const video_format_t *restrict fmt,
+                          const VASurfaceID *ids, unsigned count)
+{
+    unsigned va_rt_format;
+    int va_fourcc;
+    vlc_chroma_to_vaapi(fmt->i_chroma, &va_rt_format, &va_fourcc);
+
+    vlc_mutex_lock(&surface_cache_lock);
+    struct vaapi_surface_cache *cache = vlc_vaapi_FindSurfaceCache(dpy);
+    assert(cache != NULL && cache->users > 0 && cache->in_use >= count);
+
+    cache->users--;
+    cache->in_use -= count;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        struct vaapi_idle_surface *s = NULL;
+
+        if (cache->users > 0 && cache->idle_count < VAAPI_MAX_IDLE_SURFACES)
+            s = malloc(sizeof (*s));
+        if (s == NULL)
+        {
+            vaDestroySurfaces(dpy, (VASurfaceID *) &ids[i], 1);
+            continue;
+        }
+        s->rt_format = va_rt_format;
+        s->fourcc = va_fourcc;
+        s->width = fmt->i_visible_width;
+        s->height = fmt->i_visible_height;
+        s->id = ids[i];
+        s->next = cache->idle;
+        cache->idle = s;
+        cache->idle_count++;
+    }
+
+    if (cache->users == 0)
+    {   /* the display may be terminated from now on */
+        for (struct vaapi_idle_surface *s = cache->idle, *next; s != NULL;
+             s = next)
+        {
+            next = s->next;
+            vaDestroySurfaces(dpy, &s->id, 1);
+            free(s);
+        }
+
+        struct vaapi_surface_cache **pp = &surface_caches;
+        while (*pp != cache)
+            pp = &(*pp)->next;
+        *pp = cache->next;
+        free(cache);
+    }
+    vlc_mutex_unlock(&surface_cache_lock);
+}
+
 struct vaapi_pic_ctx
 {
     struct vaapi_pic_context ctx;
@@ -410,6 +611,7 @@ struct vaapi_pic_ctx
 struct pic_sys_vaapi_instance
 {
     atomic_int pic_refcount;
+    video_format_t fmt;
     unsigned num_render_targets;
     VASurfaceID render_targets[];
 };
@@ -428,8 +630,9 @@ pool_pic_destroy_cb(picture_t *pic)
 
     if (atomic_fetch_sub(&instance->pic_refcount, 1) == 1)
     {
-        vaDestroySurfaces(p_sys->ctx.ctx.va_dpy, instance->render_targets,
-                          instance->num_render_targets);
+        vlc_vaapi_ReleaseSurfaces(p_sys->ctx.ctx.va_dpy, &instance->fmt,
+                                  instance->render_targets,
+                                  instance->num_render_targets);
         free(instance);
     }
     free(pic->p_sys);
@@ -469,32 +672,19 @@ vlc_vaapi_PoolNew(vlc_object_t *o, vlc_video_context *vctx,
                   VADisplay dpy, unsigned count, VASurfaceID **render_targets,
                   const video_format_t *restrict fmt)
 {
-    unsigned va_rt_format;
-    int va_fourcc;
-    vlc_chroma_to_vaapi(fmt->i_chroma, &va_rt_format, &va_fourcc);
-
     struct pic_sys_vaapi_instance *instance =
         malloc(sizeof(*instance) + count * sizeof(VASurfaceID));
     if (!instance)
         return NULL;
+    instance->fmt = *fmt;
     instance->num_render_targets = count;
     atomic_init(&instance->pic_refcount, 0);
 
-    VASurfaceAttrib fourcc_attribs[1] = {
-        {
-            .type = VASurfaceAttribPixelFormat,
-            .flags = VA_SURFACE_ATTRIB_SETTABLE,
-            .value.type    = VAGenericValueTypeInteger,
-            .value.value.i = va_fourcc,
-        }
-    };
-
     picture_t *pics[count];
 
-    VA_CALL(o, vaCreateSurfaces, dpy, va_rt_format,
-            fmt->i_visible_width, fmt->i_visible_height,
-            instance->render_targets, instance->num_render_targets,
-            fourcc_attribs, 1);
+    if (vlc_vaapi_AcquireSurfaces(o, dpy, fmt, instance->render_targets,
+                                  instance->num_render_targets))
+        goto error;
 
     for (unsigned i = 0; i < count; i++)
     {
@@ -538,8 +728,8 @@ error_pic:
     while (count > 0)
         picture_Release(pics[--count]);
 
-    VA_CALL(o, vaDestroySurfaces, dpy, instance->render_targets,
-            instance->num_render_targets);
+    vlc_vaapi_ReleaseSurfaces(dpy, fmt, instance->render_targets,
+                              instance->num_render_targets);
 
 error:
     free(instance);
@@ -105,6 +105,23 @@ vlc_vaapi_AcquireBufferHandle(vlc_object_t *o, VADisplay dpy, VABufferID buf_id,
 int
 vlc_vaapi_ReleaseBufferHandle(vlc_object_t *o, VADisplay dpy, VABufferID buf_id);
 
+#if VA_CHECK_VERSION(1, 1, 0)
+# include <va/va_drmcommon.h>
+# define VLC_VAAPI_HAS_EXPORT 1
+
+/* Waits for the surface to be rendered, then exports it as DMA-BUFs, with
+ * all the planes in a single layer. The file descriptors belong to the
+ * caller, see vlc_vaapi_CloseSurfaceHandle(). */
+int
+vlc_vaapi_ExportSurfaceHandle(vlc_object_t *o, VADisplay dpy,
+                              VASurfaceID surface,
+                              VADRMPRIMESurfaceDescriptor *desc);
+
+/* Closes the file descriptors of an exported surface. */
+void
+vlc_vaapi_CloseSurfaceHandle(VADRMPRIMESurfaceDescriptor *desc);
+#endif
+
 /*****************
  * VAAPI queries *
  *****************/
@@ -166,8 +183,22 @@ vlc_vaapi_CreateConfigChecked(vlc_object_t *o, VADisplay dpy,
                               VAProfile i_profile, VAEntrypoint entrypoint,
                               int i_force_vlc_chroma);
 
-/* Create a pool backed by VASurfaceID. render_targets will destroyed once
- * the pool and every pictures are released. */
+/* Gets count surfaces of the given format, reusing the surfaces released on
+ * the same display if possible. */
+int
+vlc_vaapi_AcquireSurfaces(vlc_object_t *o, VADisplay dpy,
+                          const video_format_t *restrict fmt,
+                          VASurfaceID *ids, unsigned count);
+
+/* Gives back surfaces obtained with vlc_vaapi_AcquireSurfaces(), with the
+ * same format. They are destroyed once no surfaces of the display are in
+ * use anymore. */
+void
+vlc_vaapi_ReleaseSurfaces(VADisplay dpy, const video_format_t *restrict fmt,
+                          const VASurfaceID *ids, unsigned count);
+
+/* Create a pool backed by VASurfaceID. render_targets will be released to the
+ * surface cache once the pool and every pictures are released. */
 picture_pool_t *
 vlc_vaapi_PoolNew(vlc_object_t *o, vlc_video_context *vctx,
                   VADisplay dpy, unsigned count, VASurfaceID **render_targets,
@@ -0,0 +1,444 @@
+/*****************************************************************************
+ * binary.c: compact binary logger
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Writes the log messages as binary records, without formatting them: the
+ * format strings (and the object type and module names) are written once,
+ * then referred to by index, and the message arguments are written in
+ * binary. The text is formatted offline.
+ *
+ * The file starts with the 8 bytes "VLCBLOG" followed by the version (1).
+ * Integers are unsigned LEB128 (signed ones zigzag encoded first). Records:
+ *
+ *   'S' <index> <length> <bytes>   defines the string of the next index
+ *   'M' <date> <thread> <object> <type index> <module index> <level>
+ *       <format index> <argument count> <arguments>
+ *
+ * The date is in microseconds since the previous message (or the opening of
+ * the log). Each argument starts with a tag:
+ *   'i' signed integer, 'u' unsigned integer, 'p' pointer,
+ *   'f' IEEE 754 double (8 bytes, little endian),
+ *   's' <length> <bytes>, 'n' NULL string. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_fs.h>
+#include <vlc_memstream.h>
+
+#define BLOG_MAGIC "VLCBLOG\x01"
+#define BLOG_STRINGS_MIN 64 /* must be a power of two */
+
+struct blog_string
+{
+    char *str;
+    uint32_t hash;
+    uint64_t index;
+};
+
+typedef struct
+{
+    FILE *stream;
+    int verbosity;
+
+    vlc_mutex_t lock;
+    vlc_tick_t last_date;
+    /* Interned strings: open addressing hash table, at most half full */
+    struct blog_string *strings;
+    size_t strings_size;
+    uint64_t strings_count;
+} vlc_logger_sys_t;
+
+static void PutVarint(struct vlc_memstream *ms, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        vlc_memstream_putc(ms, 0x80 | (value & 0x7F));
+        value >>= 7;
+    }
+    vlc_memstream_putc(ms, value);
+}
+
+static void PutSigned(struct vlc_memstream *ms, int64_t value)
+{
+    PutVarint(ms, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+static void PutDouble(struct vlc_memstream *ms, double value)
+{
+    union { double d; uint64_t u; } v = { .d = value };
+    uint8_t buf[8];
+
+    SetQWLE(buf, v.u);
+    vlc_memstream_write(ms, buf, sizeof (buf));
+}
+
+static void PutString(struct vlc_memstream *ms, const char *str)
+{
+    size_t len = strlen(str);
+
+    PutVarint(ms, len);
+    vlc_memstream_write(ms, str, len);
+}
+
+static uint32_t Hash(const char *str)
+{
+    /* FNV-1a */
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++)
+        h = (h ^ *p) * 16777619u;
+    return h;
+}
+
+static int Grow(vlc_logger_sys_t *sys)
+{
+    size_t size = sys->strings_size ? 2 * sys->strings_size
+                                    : BLOG_STRINGS_MIN;
+    struct blog_string *strings = calloc(size, sizeof (*strings));
+    if (unlikely(strings == NULL))
+        return -1;
+
+    for (size_t i = 0; i < sys->strings_size; i++)
+    {
+        struct blog_string *s = &sys->strings[i];
+        if (s->str == NULL)
+            continue;
+
+        size_t j = s->hash & (size - 1);
+        while (strings[j].str != NULL)
+            j = (j + 1) & (size - 1);
+        strings[j] = *s;
+    }
+
+    free(sys->strings);
+    sys->strings = strings;
+    sys->strings_size = size;
+    return 0;
+}
+
+/**
+ * Returns the index of a string, defining it in the log first if needed.
+ */
+static uint64_t Intern(vlc_logger_sys_t *sys, struct vlc_memstream *ms,
+                       const char *str)
+{
+    uint32_t hash = Hash(str);
+
+    if (sys->strings_size > 0)
+    {
+        size_t mask = sys->strings_size - 1;
+
+        for (size_t i = hash & mask; sys->strings[i].str != NULL;
+             i = (i + 1) & mask)
+        {
+            const struct blog_string *s = &sys->strings[i];
+            if (s->hash == hash && !strcmp(s->str, str))
+                return s->index;
+        }
+    }
+
+    uint64_t index = sys->strings_count++;
+
+    vlc_memstream_putc(ms, 'S');
+    PutVarint(ms, index);
+    PutString(ms, str);
+
+    /* If memory is short, the string is defined again next time */
+    if (2 * (sys->strings_count + 1) > sys->strings_size && Grow(sys))
+        return index;
+
+    char *dup = strdup(str);
+    if (unlikely(dup == NULL))
+        return index;
+
+    size_t mask = sys->strings_size - 1;
+    size_t i = hash & mask;
+    while (sys->strings[i].str != NULL)
+        i = (i + 1) & mask;
+    sys->strings[i] = (struct blog_string){ dup, hash, index };
+    return index;
+}
+
+/**
+ * Writes the arguments of a printf-like format.
+ *
+ * @return the number of arguments
+ */
+static unsigned PutArgs(struct vlc_memstream *ms, const char *fmt, va_list ap)
+{
+    unsigned count = 0;
+
+    while ((fmt = strchr(fmt, '%')) != NULL)
+    {
+        enum { LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_J, LEN_Z, LEN_T,
+               LEN_BIG_L } len = LEN_NONE;
+
+        fmt++;
+        if (*fmt == '%')
+        {
+            fmt++;
+            continue;
+        }
+
+        fmt += strspn(fmt, "-+ #0'");
+        /* width and precision */
+        for (int i = 0; i < 2; i++)
+        {
+            if (*fmt == '*')
+            {
+                vlc_memstream_putc(ms, 'i');
+                PutSigned(ms, va_arg(ap, int));
+                count++;
+                fmt++;
+            }
+            else
+                fmt += strspn(fmt, "0123456789");
+
+            if (i == 0 && *fmt == '.')
+                fmt++;
+            else
+                break;
+        }
+
+        switch (*fmt)
+        {
+            case 'h':
+                len = (fmt[1] == 'h') ? LEN_HH : LEN_H;
+                fmt += (fmt[1] == 'h') ? 2 : 1;
+                break;
+            case 'l':
+                len = (fmt[1] == 'l') ? LEN_LL : LEN_L;
+                fmt += (fmt[1] == 'l') ? 2 : 1;
+                break;
+            case 'q': len = LEN_LL; fmt++; break;
+            case 'j': len = LEN_J; fmt++; break;
+            case 'z': len = LEN_Z; fmt++; break;
+            case 't': len = LEN_T; fmt++; break;
+            case 'L': len = LEN_BIG_L; fmt++; break;
+        }
+
+        switch (*fmt)
+        {
+            case 'd':
+            case 'i':
+            {
+                int64_t v;
+
+                switch (len)
+                {
+                    case LEN_L: v = va_arg(ap, long); break;
+                    case LEN_LL: v = va_arg(ap, long long); break;
+                    case LEN_J: v = va_arg(ap, intmax_t); break;
+                    case LEN_Z: v = va_arg(ap, ssize_t); break;
+                    case LEN_T: v = va_arg(ap, ptrdiff_t); break;
+                    default: v = va_arg(ap, int); break;
+                }
+                vlc_memstream_putc(ms, 'i');
+                PutSigned(ms, v);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'c':
+            {
+                uint64_t v;
+
+                switch (len)
+                {
+                    case LEN_L: v = va_arg(ap, unsigned long); break;
+                    case LEN_LL: v = va_arg(ap, unsigned long long); break;
+                    case LEN_J: v = va_arg(ap, uintmax_t); break;
+                    case LEN_Z: v = va_arg(ap, size_t); break;
+                    case LEN_T: v = va_arg(ap, ptrdiff_t); break;
+                    default: v = va_arg(ap, unsigned); break;
+                }
+                vlc_memstream_putc(ms, 'u');
+                PutVarint(ms, v);
+                break;
+            }
+            case 'e': case 'E':
+            case 'f': case 'F':
+            case 'g': case 'G':
+            case 'a': case 'A':
+                vlc_memstream_putc(ms, 'f');
+                PutDouble(ms, (len == LEN_BIG_L) ? va_arg(ap, long double)
+                                                 : va_arg(ap, double));
+                break;
+            case 's':
+            {
+                const char *str = va_arg(ap, const char *);
+
+                if (str != NULL)
+                {
+                    vlc_memstream_putc(ms, 's');
+                    PutString(ms, str);
+                }
+                else
+                    vlc_memstream_putc(ms, 'n');
+                break;
+            }
+            case 'p':
+                vlc_memstream_putc(ms, 'p');
+                PutVarint(ms, (uintptr_t)va_arg(ap, void *));
+                break;
+            case 'n':
+                (void) va_arg(ap, void *);
+                continue; /* not an output */
+            default: /* invalid or unknown conversion, stop there */
+                return count;
+        }
+        fmt++;
+        count++;
+    }
+    return count;
+}
+
+static void Log(void *opaque, int type, const vlc_log_t *meta,
+                const char *format, va_list ap)
+{
+    vlc_logger_sys_t *sys = opaque;
+    struct vlc_memstream ms, args;
+
+    if (sys->verbosity < type)
+        return;
+
+    /* Encode the arguments before locking */
+    vlc_memstream_open(&args);
+    unsigned count = PutArgs(&args, format, ap);
+    if (vlc_memstream_close(&args))
+        return;
+
+    vlc_memstream_open(&ms);
+    vlc_mutex_lock(&sys->lock);
+
+    uint64_t object_type = Intern(sys, &ms, meta->psz_object_type);
+    uint64_t module = Intern(sys, &ms, meta->psz_module);
+    uint64_t fmt = Intern(sys, &ms, format);
+    vlc_tick_t now = vlc_tick_now();
+
+    vlc_memstream_putc(&ms, 'M');
+    PutVarint(&ms, US_FROM_VLC_TICK(now - sys->last_date));
+    PutVarint(&ms, meta->tid);
+    PutVarint(&ms, meta->i_object_id);
+    PutVarint(&ms, object_type);
+    PutVarint(&ms, module);
+    vlc_memstream_putc(&ms, type);
+    PutVarint(&ms, fmt);
+    PutVarint(&ms, count);
+    vlc_memstream_write(&ms, args.ptr, args.length);
+    sys->last_date = now;
+
+    if (vlc_memstream_close(&ms) == 0)
+    {
+        fwrite(ms.ptr, 1, ms.length, sys->stream);
+        free(ms.ptr);
+    }
+    vlc_mutex_unlock(&sys->lock);
+    free(args.ptr);
+}
+
+static void Close(void *opaque)
+{
+    vlc_logger_sys_t *sys = opaque;
+
+    fclose(sys->stream);
+    for (size_t i = 0; i < sys->strings_size; i++)
+        free(sys->strings[i].str);
+    free(sys->strings);
+    vlc_mutex_destroy(&sys->lock);
+    free(sys);
+}
+
+static const struct vlc_logger_operations ops =
+{
+    Log,
+    Close
+};
+
+static const struct vlc_logger_operations *Open(vlc_object_t *obj,
+                                                void **restrict sysp)
+{
+    char *path = var_InheritString(obj, "binary-logfile");
+    if (path == NULL)
+        return NULL; /* disabled */
+
+    int verbosity = var_InheritInteger(obj, "verbose");
+    if (verbosity < 0)
+    {
+        free(path);
+        return NULL; /* nothing to log */
+    }
+
+    vlc_logger_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+    {
+        free(path);
+        return NULL;
+    }
+
+    msg_Dbg(obj, "opening binary log file `%s'", path);
+    sys->stream = vlc_fopen(path, "wb");
+    if (sys->stream == NULL)
+    {
+        msg_Err(obj, "error opening log file `%s': %s", path,
+                vlc_strerror_c(errno));
+        free(path);
+        free(sys);
+        return NULL;
+    }
+    free(path);
+
+    sys->verbosity = VLC_MSG_ERR + verbosity;
+    vlc_mutex_init(&sys->lock);
+    sys->last_date = vlc_tick_now();
+    sys->strings = NULL;
+    sys->strings_size = 0;
+    sys->strings_count = 0;
+
+    fwrite(BLOG_MAGIC, 1, 8, sys->stream);
+
+    *sysp = sys;
+    return &ops;
+}
+
+#define FILE_TEXT N_("Binary log filename")
+#define FILE_LONGTEXT N_("Write the log messages to this file, " \
+    "as compact binary records to be formatted offline.")
+
+vlc_module_begin()
+    set_shortname(N_("Binary logger"))
+    set_description(N_("Binary logger"))
+    set_category(CAT_ADVANCED)
+    set_subcategory(SUBCAT_ADVANCED_MISC)
+    set_capability("logger", 20)
+    set_callback(Open)
+
+    add_savefile("binary-logfile", NULL, FILE_TEXT, FILE_LONGTEXT)
+vlc_module_end ()
@@ -0,0 +1,303 @@
+/*****************************************************************************
+ * chrome_trace.c: Chrome trace-event format tracer
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Writes the trace events as a JSON trace-event file, as loaded by
+ * chrome://tracing and the Perfetto UI.
+ *
+ * Each traced thread writes its events to its own ring, without locking.
+ * A background thread periodically moves the events from the rings to the
+ * file. Events are dropped, and counted, when a ring is full. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_fs.h>
+#include <vlc_tracer.h>
+
+#define TRACE_RING_SIZE 4096 /* must be a power of two */
+#define TRACE_FLUSH_PERIOD VLC_TICK_FROM_MS(100)
+
+struct trace_ring
+{
+    struct vlc_tracer_event events[TRACE_RING_SIZE];
+    atomic_size_t head; /**< written by the traced thread */
+    atomic_size_t tail; /**< written by the writer thread */
+    atomic_uint dropped;
+    atomic_bool dead; /**< the traced thread has exited */
+    struct trace_ring *next;
+};
+
+typedef struct
+{
+    vlc_object_t *obj;
+    FILE *stream;
+    vlc_threadvar_t ring_key;
+    unsigned long pid;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    struct trace_ring *rings;
+    uint64_t written;
+    uint64_t dropped;
+    bool stop;
+    vlc_thread_t thread;
+} vlc_tracer_sys_t;
+
+static void RingExit(void *data)
+{
+    struct trace_ring *ring = data;
+
+    /* The writer thread frees the ring once drained */
+    atomic_store_explicit(&ring->dead, true, memory_order_release);
+}
+
+static struct trace_ring *RingGet(vlc_tracer_sys_t *sys)
+{
+    struct trace_ring *ring = vlc_threadvar_get(sys->ring_key);
+    if (likely(ring != NULL))
+        return ring;
+
+    /* First event of this thread */
+    ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->dead, false);
+
+    if (vlc_threadvar_set(sys->ring_key, ring))
+    {
+        free(ring);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&sys->lock);
+    ring->next = sys->rings;
+    sys->rings = ring;
+    vlc_mutex_unlock(&sys->lock);
+    return ring;
+}
+
+static void Trace(void *opaque, const struct vlc_tracer_event *event)
+{
+    vlc_tracer_sys_t *sys = opaque;
+    struct trace_ring *ring = RingGet(sys);
+    if (unlikely(ring == NULL))
+        return;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= TRACE_RING_SIZE)
+    {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    ring->events[head & (TRACE_RING_SIZE - 1)] = *event;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static void WriteEvent(vlc_tracer_sys_t *sys,
+                       const struct vlc_tracer_event *event)
+{
+    static const char phases[] = {
+        [VLC_TRACER_BEGIN] = 'B',
+        [VLC_TRACER_END] = 'E',
+        [VLC_TRACER_INSTANT] = 'i',
+    };
+    FILE *stream = sys->stream;
+
+    fprintf(stream, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+            "\"ts\":%"PRId64",\"pid\":%lu,\"tid\":%lu",
+            sys->written > 0 ? ",\n" : "", event->name, event->category,
+            phases[event->phase], US_FROM_VLC_TICK(event->date), sys->pid,
+            event->thread);
+    if (event->phase == VLC_TRACER_INSTANT)
+        fputs(",\"s\":\"t\"", stream);
+    fprintf(stream, ",\"args\":{\"object\":\"%p\"", event->object);
+    if (event->pts != VLC_TICK_INVALID)
+        fprintf(stream, ",\"pts\":%"PRId64, US_FROM_VLC_TICK(event->pts));
+    fputs("}}", stream);
+    sys->written++;
+}
+
+/* Must be called with the lock held */
+static void Drain(vlc_tracer_sys_t *sys)
+{
+    for (struct trace_ring **pp = &sys->rings, *ring; (ring = *pp) != NULL;)
+    {
+        /* Check before draining, so that no events are lost */
+        bool dead = atomic_load_explicit(&ring->dead, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        for (; tail != head; tail++)
+            WriteEvent(sys, &ring->events[tail & (TRACE_RING_SIZE - 1)]);
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        sys->dropped += atomic_exchange_explicit(&ring->dropped, 0,
+                                                 memory_order_relaxed);
+        if (dead)
+        {
+            *pp = ring->next;
+            free(ring);
+        }
+        else
+            pp = &ring->next;
+    }
+}
+
+static void *Thread(void *data)
+{
+    vlc_tracer_sys_t *sys = data;
+    vlc_tick_t deadline = vlc_tick_now();
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;)
+    {
+        bool stop = sys->stop;
+
+        Drain(sys);
+        if (stop)
+            break;
+
+        deadline += TRACE_FLUSH_PERIOD;
+        while (!sys->stop
+            && vlc_cond_timedwait(&sys->wait, &sys->lock, deadline) == 0);
+    }
+    vlc_mutex_unlock(&sys->lock);
+    return NULL;
+}
+
+static void Close(void *opaque)
+{
+    vlc_tracer_sys_t *sys = opaque;
+
+    vlc_mutex_lock(&sys->lock);
+    sys->stop = true;
+    vlc_cond_signal(&sys->wait);
+    vlc_mutex_unlock(&sys->lock);
+    vlc_join(sys->thread, NULL);
+    vlc_cond_destroy(&sys->wait);
+    vlc_mutex_destroy(&sys->lock);
+
+    /* The traced threads have all exited or stopped tracing */
+    vlc_threadvar_delete(&sys->ring_key);
+    for (struct trace_ring *ring = sys->rings, *next; ring != NULL;
+         ring = next)
+    {
+        next = ring->next;
+        free(ring);
+    }
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", sys->stream);
+    fclose(sys->stream);
+
+    if (sys->dropped > 0)
+        msg_Warn(sys->obj, "%"PRIu64" trace events dropped", sys->dropped);
+    msg_Dbg(sys->obj, "%"PRIu64" trace events written", sys->written);
+    free(sys);
+}
+
+static const struct vlc_tracer_operations ops =
+{
+    Trace,
+    Close,
+};
+
+static const struct vlc_tracer_operations *Open(vlc_object_t *obj,
+                                                void **restrict sysp)
+{
+    vlc_tracer_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return NULL;
+
+    char *path = var_InheritString(obj, "chrome-trace-file");
+    const char *filename = (path != NULL) ? path : "vlc-trace.json";
+
+    msg_Dbg(obj, "opening trace file `%s'", filename);
+    sys->stream = vlc_fopen(filename, "wt");
+    if (sys->stream == NULL)
+    {
+        msg_Err(obj, "error opening trace file `%s': %s", filename,
+                vlc_strerror_c(errno));
+        free(path);
+        free(sys);
+        return NULL;
+    }
+    free(path);
+
+    if (vlc_threadvar_create(&sys->ring_key, RingExit))
+        goto error;
+
+    sys->obj = obj;
+    sys->pid = getpid();
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait);
+    sys->rings = NULL;
+    sys->written = 0;
+    sys->dropped = 0;
+    sys->stop = false;
+
+    fputs("{\"traceEvents\":[\n", sys->stream);
+
+    if (vlc_clone(&sys->thread, Thread, sys, VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_cond_destroy(&sys->wait);
+        vlc_mutex_destroy(&sys->lock);
+        vlc_threadvar_delete(&sys->ring_key);
+        goto error;
+    }
+
+    *sysp = sys;
+    return &ops;
+
+error:
+    fclose(sys->stream);
+    free(sys);
+    return NULL;
+}
+
+#define FILE_TEXT N_("Trace filename")
+#define FILE_LONGTEXT N_("File to write the trace events to, " \
+    "in the Chrome trace-event format.")
+
+vlc_module_begin()
+    set_shortname(N_("Chrome trace"))
+    set_description(N_("Chrome trace-event format tracer"))
+    set_category(CAT_ADVANCED)
+    set_subcategory(SUBCAT_ADVANCED_MISC)
+    set_capability("tracer", 0)
+    set_callback(Open)
+
+    add_savefile("chrome-trace-file", NULL, FILE_TEXT, FILE_LONGTEXT)
+vlc_module_end ()
@@ -150,7 +150,7 @@ void Close_Extension( vlc_object_t *p_this )
         else
         {
             if ( p_ext->p_sys->L != NULL )
-                vlclua_fd_interrupt( &p_ext->p_sys->dtable );
+                vlclua_fd_abort( &p_ext->p_sys->dtable );
             // however here we need to manually signal the wait cond, since no command is queued.
             p_ext->p_sys->b_exiting = true;
             vlc_cond_signal( &p_ext->p_sys->wait );
@@ -166,7 +166,7 @@ int Deactivate( extensions_manager_t *p_mgr, extension_t *p_ext )
 void KillExtension( extensions_manager_t *p_mgr, extension_t *p_ext )
 {
     msg_Dbg( p_mgr, "Killing extension now" );
-    vlclua_fd_interrupt( &p_ext->p_sys->dtable );
+    vlclua_fd_abort( &p_ext->p_sys->dtable );
     p_ext->p_sys->b_activated = false;
     p_ext->p_sys->b_exiting = true;
     vlc_cond_signal( &p_ext->p_sys->wait );
@@ -498,6 +498,18 @@ static void luaopen_net_intf( lua_State *L )
     lua_setfield( L, -2, "net" );
 }
 
+/* Number of VM instructions between checks for interruption */
+#define VLCLUA_HOOK_COUNT 10000
+
+static void vlclua_fd_hook( lua_State *L, lua_Debug *ar )
+{
+    vlclua_dtable_t *dt = vlclua_get_dtable( L );
+
+    (void) ar;
+    if( atomic_load_explicit( &dt->killed, memory_order_relaxed ) )
+        luaL_error( L, "interrupted" );
+}
+
 int vlclua_fd_init( lua_State *L, vlclua_dtable_t *dt )
 {
     dt->interrupt = vlc_interrupt_create();
@@ -505,8 +517,12 @@ int vlclua_fd_init( lua_State *L, vlclua_dtable_t *dt )
         return -1;
     dt->fdv = NULL;
     dt->fdc = 0;
+    atomic_init( &dt->killed, false );
     vlclua_set_object( L, vlclua_get_dtable, dt );
     luaopen_net_intf( L );
+    /* Scripts stuck in pure Lua code (no blocking call to interrupt) are
+     * aborted from the VM itself by vlclua_fd_abort(). */
+    lua_sethook( L, vlclua_fd_hook, LUA_MASKCOUNT, VLCLUA_HOOK_COUNT );
     return 0;
 }
 
@@ -515,6 +531,12 @@ void vlclua_fd_interrupt( vlclua_dtable_t *dt )
     vlc_interrupt_kill( dt->interrupt );
 }
 
+void vlclua_fd_abort( vlclua_dtable_t *dt )
+{
+    atomic_store_explicit( &dt->killed, true, memory_order_relaxed );
+    vlc_interrupt_kill( dt->interrupt );
+}
+
 /** Releases all (leaked) VLC Lua file descriptors. */
 void vlclua_fd_cleanup( vlclua_dtable_t *dt )
 {
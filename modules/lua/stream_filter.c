@@ -30,9 +30,11 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include <vlc_common.h>
 #include <vlc_access.h>
+#include <vlc_fs.h>
 
 #include "vlc.h"
 #include "libs.h"
@@ -117,6 +119,143 @@ static const luaL_Reg p_reg_parse[] =
     { NULL, NULL }
 };
 
+/*****************************************************************************
+ * Probe index
+ *
+ * Scripts can restrict the URLs they handle with a global probe_hosts table
+ * of host names (matching the host itself and its subdomains). The declared
+ * hosts are remembered per script file, checked against its modification
+ * time and size, so that the scripts which cannot handle the URL host are
+ * skipped without even being loaded.
+ *****************************************************************************/
+struct probe_index
+{
+    struct probe_index *next;
+    time_t mtime;
+    off_t size;
+    char **hosts; /* NULL if the script probes any URL */
+    char path[];
+};
+
+static vlc_mutex_t probe_lock = VLC_STATIC_MUTEX;
+static struct probe_index *probe_list = NULL;
+
+static bool probe_HostMatch(char *const *hosts, const char *path)
+{
+    if (path == NULL)
+        return false;
+
+    size_t len = strcspn(path, "/:?#");
+
+    for (char *const *h = hosts; *h != NULL; h++)
+    {
+        size_t hlen = strlen(*h);
+
+        if (len == hlen && !strncasecmp(path, *h, len))
+            return true;
+        if (len > hlen && path[len - hlen - 1] == '.'
+         && !strncasecmp(path + len - hlen, *h, hlen))
+            return true;
+    }
+    return false;
+}
+
+static void probe_IndexFree(struct probe_index *entry)
+{
+    if (entry->hosts != NULL)
+        for (char **h = entry->hosts; *h != NULL; h++)
+            free(*h);
+    free(entry->hosts);
+    free(entry);
+}
+
+/* Returns false if the script is known not to handle the URL */
+static bool probe_IndexCheck(const char *filename, const struct stat *st,
+                             const char *path)
+{
+    bool ret = true;
+
+    vlc_mutex_lock(&probe_lock);
+    for (const struct probe_index *entry = probe_list; entry != NULL;
+         entry = entry->next)
+        if (!strcmp(entry->path, filename))
+        {
+            if (entry->mtime == st->st_mtime && entry->size == st->st_size
+             && entry->hosts != NULL)
+                ret = probe_HostMatch(entry->hosts, path);
+            break;
+        }
+    vlc_mutex_unlock(&probe_lock);
+    return ret;
+}
+
+/* Reads the probe_hosts table of the loaded script */
+static char **probe_GetHosts(lua_State *L)
+{
+    char **hosts = NULL;
+
+    lua_getglobal(L, "probe_hosts");
+    if (lua_istable(L, -1))
+    {
+        size_t count = lua_objlen(L, -1), n = 0;
+
+        hosts = malloc((count + 1) * sizeof (*hosts));
+        if (likely(hosts != NULL))
+        {
+            for (size_t i = 1; i <= count; i++)
+            {
+                lua_rawgeti(L, -1, i);
+                if (lua_isstring(L, -1)
+                 && (hosts[n] = strdup(lua_tostring(L, -1))) != NULL)
+                    n++;
+                lua_pop(L, 1);
+            }
+            hosts[n] = NULL;
+        }
+    }
+    lua_pop(L, 1);
+    return hosts;
+}
+
+/* Indexes the loaded script, returns false if it does not handle the URL */
+static bool probe_IndexAdd(lua_State *L, const char *filename,
+                           const struct stat *st, const char *path)
+{
+    size_t len = strlen(filename) + 1;
+    char **hosts = probe_GetHosts(L);
+    bool ret = hosts == NULL || probe_HostMatch(hosts, path);
+
+    struct probe_index *entry = malloc(sizeof (*entry) + len);
+    if (unlikely(entry == NULL))
+    {
+        if (hosts != NULL)
+            for (char **h = hosts; *h != NULL; h++)
+                free(*h);
+        free(hosts);
+        return ret;
+    }
+
+    entry->mtime = st->st_mtime;
+    entry->size = st->st_size;
+    entry->hosts = hosts;
+    memcpy(entry->path, filename, len);
+
+    vlc_mutex_lock(&probe_lock);
+    for (struct probe_index **pp = &probe_list; *pp != NULL; pp = &(*pp)->next)
+        if (!strcmp((*pp)->path, filename))
+        {   /* outdated, or indexed concurrently */
+            struct probe_index *old = *pp;
+
+            *pp = old->next;
+            probe_IndexFree(old);
+            break;
+        }
+    entry->next = probe_list;
+    probe_list = entry;
+    vlc_mutex_unlock(&probe_lock);
+    return ret;
+}
+
 /*****************************************************************************
  * Called through lua_scripts_batch_execute to call 'probe' on
  * the script pointed by psz_filename.
@@ -126,6 +265,11 @@ static int probe_luascript(vlc_object_t *obj, const char *filename,
 {
     stream_t *s = (stream_t *)obj;
     struct vlclua_playlist *sys = s->p_sys;
+    struct stat st;
+    bool indexed = vlc_stat(filename, &st) == 0;
+
+    if (indexed && !probe_IndexCheck(filename, &st, sys->path))
+        return VLC_EGENERIC;
 
     /* Initialise Lua state structure */
     lua_State *L = luaL_newstate();
@@ -174,6 +318,12 @@ static int probe_luascript(vlc_object_t *obj, const char *filename,
         goto error;
     }
 
+    if (indexed && !probe_IndexAdd(L, filename, &st, sys->path))
+    {
+        lua_close(sys->L);
+        return VLC_EGENERIC;
+    }
+
     lua_getglobal( L, "probe" );
     if( !lua_isfunction( L, -1 ) )
     {
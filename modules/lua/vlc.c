@@ -39,6 +39,7 @@
 #include <vlc_arrays.h>
 #include <vlc_charset.h>
 #include <vlc_fs.h>
+#include <vlc_memstream.h>
 #include <vlc_services_discovery.h>
 #include <vlc_stream.h>
 
@@ -652,17 +653,158 @@ int vlclua_add_modules_path( lua_State *L, const char *psz_filename )
     return 0;
 }
 
+/*
+ * Compiled chunks cache
+ *
+ * The same scripts are loaded over and over (e.g. all the playlist scripts
+ * are probed for every input). Since a function cannot be shared between Lua
+ * states, the cache keeps the compiled byte code of local files, which is
+ * loaded without parsing the source again. Entries are checked against the
+ * file modification time and size.
+ */
+struct vlclua_chunk
+{
+    struct vlclua_chunk *next;
+    time_t mtime;
+    off_t size;
+    size_t length;
+    char *code;
+    char path[];
+};
+
+#define VLCLUA_CHUNKS_MAX 128
+
+static vlc_mutex_t chunks_lock = VLC_STATIC_MUTEX;
+static struct vlclua_chunk *chunks = NULL;
+static unsigned chunks_count = 0;
+
+static void vlclua_chunk_free( struct vlclua_chunk *chunk )
+{
+    free( chunk->code );
+    free( chunk );
+}
+
+/* Must be called with chunks_lock held */
+static struct vlclua_chunk *vlclua_chunk_unlink( const char *path )
+{
+    for( struct vlclua_chunk **pp = &chunks, *chunk; (chunk = *pp) != NULL;
+         pp = &chunk->next )
+        if( !strcmp( chunk->path, path ) )
+        {
+            *pp = chunk->next;
+            chunks_count--;
+            return chunk;
+        }
+    return NULL;
+}
+
+static void vlclua_chunk_add( struct vlclua_chunk *chunk )
+{
+    vlc_mutex_lock( &chunks_lock );
+    struct vlclua_chunk *old = vlclua_chunk_unlink( chunk->path );
+    if( old != NULL ) /* loaded concurrently */
+        vlclua_chunk_free( old );
+
+    chunk->next = chunks;
+    chunks = chunk;
+    if( ++chunks_count > VLCLUA_CHUNKS_MAX )
+    {   /* drop the least recently used chunk */
+        struct vlclua_chunk **pp = &chunks;
+        while( (*pp)->next != NULL )
+            pp = &(*pp)->next;
+        vlclua_chunk_free( *pp );
+        *pp = NULL;
+        chunks_count--;
+    }
+    vlc_mutex_unlock( &chunks_lock );
+}
+
+static int vlclua_chunk_write( lua_State *L, const void *p, size_t size,
+                               void *opaque )
+{
+    (void) L;
+    vlc_memstream_write( opaque, p, size );
+    return 0;
+}
+
+/** Replacement for luaL_loadfile, caching the compiled chunks */
+int vlclua_loadfile( lua_State *L, const char *path )
+{
+    struct stat st;
+
+    if( stat( path, &st ) )
+        return luaL_loadfile( L, path ); /* let Lua report the error */
+
+    vlc_mutex_lock( &chunks_lock );
+    struct vlclua_chunk *chunk = vlclua_chunk_unlink( path );
+    if( chunk != NULL )
+    {
+        if( chunk->mtime == st.st_mtime && chunk->size == st.st_size )
+        {
+            int ret = luaL_loadbuffer( L, chunk->code, chunk->length, path );
+
+            /* move to the front */
+            chunk->next = chunks;
+            chunks = chunk;
+            chunks_count++;
+            vlc_mutex_unlock( &chunks_lock );
+            return ret;
+        }
+        vlclua_chunk_free( chunk ); /* the file changed */
+    }
+    vlc_mutex_unlock( &chunks_lock );
+
+    int ret = luaL_loadfile( L, path );
+    if( ret )
+        return ret;
+
+    size_t pathlen = strlen( path ) + 1;
+    chunk = malloc( sizeof (*chunk) + pathlen );
+    if( unlikely(chunk == NULL) )
+        return 0;
+
+    struct vlc_memstream stream;
+
+    vlc_memstream_open( &stream );
+#if LUA_VERSION_NUM >= 503
+    lua_dump( L, vlclua_chunk_write, &stream, 0 );
+#else
+    lua_dump( L, vlclua_chunk_write, &stream );
+#endif
+    if( vlc_memstream_close( &stream ) )
+    {
+        free( chunk );
+        return 0;
+    }
+
+    chunk->mtime = st.st_mtime;
+    chunk->size = st.st_size;
+    chunk->length = stream.length;
+    chunk->code = stream.ptr;
+    memcpy( chunk->path, path, pathlen );
+    vlclua_chunk_add( chunk );
+    return 0;
+}
+
+static int vlclua_dolocalfile( lua_State *L, const char *path )
+{
+    int ret = vlclua_loadfile( L, path );
+    if( !ret )
+        ret = lua_pcall( L, 0, LUA_MULTRET, 0 );
+    return ret;
+}
+
 /** Replacement for luaL_dofile, using VLC's input capabilities */
 int vlclua_dofile( vlc_object_t *p_this, lua_State *L, const char *curi )
 {
     char *uri = ToLocaleDup( curi );
     if( !strstr( uri, "://" ) ) {
-        int ret = luaL_dofile( L, uri );
+        int ret = vlclua_dolocalfile( L, uri );
         free( uri );
         return ret;
     }
     if( !strncasecmp( uri, "file://", 7 ) ) {
-        int ret = luaL_dofile( L, uri + 7 );
+        int ret = vlclua_dolocalfile( L, uri + 7 );
         free( uri );
         return ret;
     }
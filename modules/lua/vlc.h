@@ -27,6 +27,8 @@
  * Preamble
  *****************************************************************************/
 
+#include <stdatomic.h>
+
 #include <vlc_common.h>
 #include <vlc_input.h>
 #include <vlc_playlist.h>
@@ -174,6 +176,7 @@ char *vlclua_find_file( const char *psz_luadirname, const char *psz_name );
  * Replace Lua file reader by VLC input. Allows loadings scripts in Zip pkg.
  *****************************************************************************/
 int vlclua_dofile( vlc_object_t *p_this, lua_State *L, const char *url );
+int vlclua_loadfile( lua_State *L, const char *path );
 
 /*****************************************************************************
  * Playlist and meta data internal utilities.
@@ -200,10 +203,12 @@ typedef struct
     struct vlc_interrupt *interrupt;
     int *fdv;
     unsigned fdc;
+    atomic_bool killed; /**< set by vlclua_fd_abort() */
 } vlclua_dtable_t;
 
 int vlclua_fd_init( lua_State *, vlclua_dtable_t * );
 void vlclua_fd_interrupt( vlclua_dtable_t * );
+void vlclua_fd_abort( vlclua_dtable_t * );
 void vlclua_fd_cleanup( vlclua_dtable_t * );
 struct vlc_interrupt *vlclua_set_interrupt( lua_State *L );
 
@@ -56,6 +56,7 @@
                                    TAGLIB_PATCH_VERSION)
 
 #include <fileref.h>
+#include <audioproperties.h>
 #include <tag.h>
 #include <tbytevector.h>
 
@@ -858,6 +859,18 @@ static int ReadMeta( vlc_object_t* p_this)
     if( !p_meta )
         return VLC_ENOMEM;
 
+    // The audio properties are parsed from the headers along with the tags
+    if( AudioProperties* p_props = f.audioProperties() )
+    {
+#if TAGLIB_VERSION >= VERSION_INT(1,10,0)
+        int i_length_ms = p_props->lengthInMilliseconds();
+#else
+        int i_length_ms = p_props->length() * 1000;
+#endif
+        if( i_length_ms > 0 )
+            p_demux_meta->i_duration = VLC_TICK_FROM_MS( i_length_ms );
+    }
+
 
     // Read the tags from the file
     Tag* p_tag = f.tag();
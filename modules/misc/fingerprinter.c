@@ -22,6 +22,7 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -29,45 +30,70 @@
 #include <vlc_modules.h>
 #include <vlc_meta.h>
 #include <vlc_url.h>
+#include <vlc_charset.h>
 
 #include <vlc_player.h>
 #include <vlc_fingerprinter.h>
 #include "webservices/acoustid.h"
 #include "../stream_out/chromaprint_data.h"
+#include "../stream_out/loudness_data.h"
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 
-struct fingerprinter_sys_t
+/* Each worker decodes one track at a time, as fast as it can */
+struct fingerprinter_worker
 {
+    fingerprinter_thread_t *p_fingerprinter;
+    vlc_object_t *p_obj; /* holds the per-worker measurement data */
     vlc_thread_t thread;
     vlc_player_t *player;
     vlc_player_listener_id *listener_id;
+    vlc_cond_t cond;
+    bool b_working;
+};
+
+struct fingerprinter_sys_t
+{
+    struct fingerprinter_worker *p_workers;
+    unsigned i_workers;
+    bool b_lookup;
+    bool b_loudness;
+    atomic_bool b_closing;
 
     struct
     {
         vlc_array_t         queue;
         vlc_mutex_t         lock;
-    } incoming, results;
+    } results;
 
     struct
     {
         vlc_array_t         queue;
         vlc_mutex_t         lock;
         vlc_cond_t          cond;
-        bool                b_working;
     } processing;
 };
 
 static int  Open            (vlc_object_t *);
 static void Close           (vlc_object_t *);
-static void CleanSys        (fingerprinter_sys_t *);
 static void *Run(void *);
 
 /*****************************************************************************
  * Module descriptor
  ****************************************************************************/
+#define THREADS_TEXT N_("Fingerprinting threads")
+#define THREADS_LONGTEXT N_("Number of tracks analysed in parallel " \
+    "(0 for one per CPU).")
+#define LOOKUP_TEXT N_("Look up the fingerprints")
+#define LOOKUP_LONGTEXT N_("Query the AcoustID service with the computed " \
+    "fingerprints. Disable this to only analyse the tracks.")
+#define LOUDNESS_TEXT N_("Measure the loudness")
+#define LOUDNESS_LONGTEXT N_("Measure the EBU R128 loudness of the tracks " \
+    "in the same decoding pass, and store it with the ReplayGain of the " \
+    "tracks in their meta-data.")
+
 vlc_module_begin ()
     set_category(CAT_ADVANCED)
     set_subcategory(SUBCAT_ADVANCED_MISC)
@@ -75,6 +101,12 @@ vlc_module_begin ()
     set_description(N_("Track fingerprinter (based on Acoustid)"))
     set_capability("fingerprinter", 10)
     set_callbacks(Open, Close)
+    add_integer("fingerprinter-threads", 0, THREADS_TEXT, THREADS_LONGTEXT,
+                true)
+        change_integer_range(0, 64)
+    add_bool("fingerprinter-lookup", true, LOOKUP_TEXT, LOOKUP_LONGTEXT, true)
+    add_bool("fingerprinter-loudness", true, LOUDNESS_TEXT, LOUDNESS_LONGTEXT,
+             true)
 vlc_module_end ()
 
 /*****************************************************************************
@@ -84,26 +116,14 @@ vlc_module_end ()
 static int EnqueueRequest( fingerprinter_thread_t *f, fingerprint_request_t *r )
 {
     fingerprinter_sys_t *p_sys = f->p_sys;
-    vlc_mutex_lock( &p_sys->incoming.lock );
-    int i_ret = vlc_array_append( &p_sys->incoming.queue, r );
-    vlc_mutex_unlock( &p_sys->incoming.lock );
+    vlc_mutex_lock( &p_sys->processing.lock );
+    int i_ret = vlc_array_append( &p_sys->processing.queue, r );
+    if( i_ret == 0 )
+        vlc_cond_signal( &p_sys->processing.cond );
+    vlc_mutex_unlock( &p_sys->processing.lock );
     return i_ret;
 }
 
-static void QueueIncomingRequests( fingerprinter_sys_t *p_sys )
-{
-    vlc_mutex_lock( &p_sys->incoming.lock );
-
-    for( size_t i = vlc_array_count( &p_sys->incoming.queue ); i > 0 ; i-- )
-    {
-        fingerprint_request_t *r = vlc_array_item_at_index( &p_sys->incoming.queue, i - 1 );
-        if( vlc_array_append( &p_sys->processing.queue, r ) )
-            fingerprint_request_Delete( r );
-    }
-    vlc_array_clear( &p_sys->incoming.queue );
-    vlc_mutex_unlock(&p_sys->incoming.lock);
-}
-
 static fingerprint_request_t * GetResult( fingerprinter_thread_t *f )
 {
     fingerprint_request_t *r = NULL;
@@ -135,18 +155,20 @@ static void player_on_state_changed(vlc_player_t *player,
                                     void *p_user_data)
 {
     VLC_UNUSED(player);
-    fingerprinter_sys_t *p_sys = p_user_data;
+    struct fingerprinter_worker *p_worker = p_user_data;
     if (new_state == VLC_PLAYER_STATE_STOPPED)
     {
-        p_sys->processing.b_working = false;
-        vlc_cond_signal( &p_sys->processing.cond );
+        p_worker->b_working = false;
+        vlc_cond_signal( &p_worker->cond );
     }
 }
 
-static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
+static void DoFingerprint( struct fingerprinter_worker *p_worker,
                            acoustid_fingerprint_t *fp,
+                           loudness_data_t *p_loudness,
                            const char *psz_uri )
 {
+    fingerprinter_sys_t *p_sys = p_worker->p_fingerprinter->p_sys;
     input_item_t *p_item = input_item_New( NULL, NULL );
     if ( unlikely(p_item == NULL) )
          return;
@@ -155,8 +177,9 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
     /* Note: need at -max- 2 channels, but we can't guess it before playing */
     /* the stereo upmix could make the mono tracks fingerprint to differ :/ */
     if ( asprintf( &psz_sout_option,
-                   "sout=#transcode{acodec=%s,channels=2}:chromaprint",
-                   ( VLC_CODEC_S16L == VLC_CODEC_S16N ) ? "s16l" : "s16b" )
+                   "sout=#transcode{acodec=%s,channels=2}:%schromaprint",
+                   ( VLC_CODEC_S16L == VLC_CODEC_S16N ) ? "s16l" : "s16b",
+                   p_sys->b_loudness ? "loudness:" : "" )
          == -1 )
     {
         input_item_Release( p_item );
@@ -181,25 +204,28 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
 
     chroma_fingerprint.psz_fingerprint = NULL;
     chroma_fingerprint.i_duration = fp->i_duration;
+    p_loudness->b_valid = false;
 
-    var_Create( p_fingerprinter, "fingerprint-data", VLC_VAR_ADDRESS );
-    var_SetAddress( p_fingerprinter, "fingerprint-data", &chroma_fingerprint );
+    var_SetAddress( p_worker->p_obj, "fingerprint-data", &chroma_fingerprint );
+    var_SetAddress( p_worker->p_obj, "loudness-data", p_loudness );
 
-    vlc_player_t *player = p_fingerprinter->p_sys->player;
+    vlc_player_t *player = p_worker->player;
     vlc_player_Lock(player);
 
-    p_fingerprinter->p_sys->processing.b_working = true;
+    p_worker->b_working = true;
 
-    int ret = vlc_player_SetCurrentMedia(player, p_item);
+    /* Close() stops the players after setting the flag */
+    int ret = VLC_EGENERIC;
+    if (!atomic_load(&p_sys->b_closing))
+        ret = vlc_player_SetCurrentMedia(player, p_item);
     if (ret == VLC_SUCCESS)
         ret = vlc_player_Start(player);
     input_item_Release(p_item);
 
     if (ret == VLC_SUCCESS)
     {
-        while( p_fingerprinter->p_sys->processing.b_working )
-            vlc_player_CondWait(player,
-                                &p_fingerprinter->p_sys->processing.cond);
+        while( p_worker->b_working )
+            vlc_player_CondWait(player, &p_worker->cond);
 
         fp->psz_fingerprint = chroma_fingerprint.psz_fingerprint;
         if( !fp->i_duration ) /* had not given hint */
@@ -209,6 +235,125 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
     vlc_player_Unlock(player);
 }
 
+static void AddExtraDouble( vlc_meta_t *p_meta, const char *psz_name,
+                            const char *psz_format, double f_value )
+{
+    char *psz_value;
+    if( us_asprintf( &psz_value, psz_format, f_value ) == -1 )
+        return;
+    vlc_meta_AddExtra( p_meta, psz_name, psz_value );
+    free( psz_value );
+}
+
+static void StoreLoudness( input_item_t *p_item, const loudness_data_t *p_data )
+{
+    vlc_mutex_lock( &p_item->lock );
+    if( p_item->p_meta == NULL )
+        p_item->p_meta = vlc_meta_New();
+    if( p_item->p_meta != NULL )
+    {
+        vlc_meta_t *p_meta = p_item->p_meta;
+
+        AddExtraDouble( p_meta, "REPLAYGAIN_TRACK_GAIN", "%.2f dB",
+                        LOUDNESS_REPLAYGAIN_REFERENCE - p_data->f_integrated );
+        AddExtraDouble( p_meta, "REPLAYGAIN_TRACK_PEAK", "%.6f",
+                        p_data->f_peak );
+        AddExtraDouble( p_meta, "EBUR128_INTEGRATED_LOUDNESS", "%.1f LUFS",
+                        p_data->f_integrated );
+        AddExtraDouble( p_meta, "EBUR128_LOUDNESS_RANGE", "%.1f LU",
+                        p_data->f_range );
+    }
+    vlc_mutex_unlock( &p_item->lock );
+}
+
+/*****************************************************************************
+ * Workers
+ *****************************************************************************/
+static int StartWorker( fingerprinter_thread_t *p_fingerprinter,
+                        struct fingerprinter_worker *p_worker )
+{
+    p_worker->p_fingerprinter = p_fingerprinter;
+    p_worker->b_working = false;
+    p_worker->p_obj = vlc_object_create( p_fingerprinter,
+                                         sizeof (*p_worker->p_obj) );
+    if( unlikely(p_worker->p_obj == NULL) )
+        return VLC_ENOMEM;
+
+    var_Create( p_worker->p_obj, "fingerprint-data", VLC_VAR_ADDRESS );
+    var_Create( p_worker->p_obj, "loudness-data", VLC_VAR_ADDRESS );
+    vlc_cond_init( &p_worker->cond );
+
+    p_worker->player = vlc_player_New( p_worker->p_obj,
+                                       VLC_PLAYER_LOCK_NORMAL, NULL, NULL );
+    if( !p_worker->player )
+        goto error;
+
+    static const struct vlc_player_cbs cbs = {
+        .on_state_changed = player_on_state_changed,
+    };
+
+    vlc_player_Lock(p_worker->player);
+    p_worker->listener_id =
+        vlc_player_AddListener(p_worker->player, &cbs, p_worker);
+    vlc_player_Unlock(p_worker->player);
+    if( !p_worker->listener_id )
+        goto error;
+
+    if( vlc_clone( &p_worker->thread, Run, p_worker,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        msg_Err( p_fingerprinter, "cannot spawn fingerprinter thread" );
+        vlc_player_Lock(p_worker->player);
+        vlc_player_RemoveListener(p_worker->player, p_worker->listener_id);
+        vlc_player_Unlock(p_worker->player);
+        goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    if( p_worker->player )
+        vlc_player_Delete( p_worker->player );
+    vlc_cond_destroy( &p_worker->cond );
+    vlc_object_delete( p_worker->p_obj );
+    return VLC_EGENERIC;
+}
+
+static void StopWorker( struct fingerprinter_worker *p_worker )
+{
+    /* Interrupt the current track, if any */
+    vlc_player_Lock(p_worker->player);
+    vlc_player_Stop(p_worker->player);
+    vlc_player_Unlock(p_worker->player);
+}
+
+static void JoinWorker( struct fingerprinter_worker *p_worker )
+{
+    vlc_join( p_worker->thread, NULL );
+
+    vlc_player_Lock(p_worker->player);
+    vlc_player_RemoveListener(p_worker->player, p_worker->listener_id);
+    vlc_player_Unlock(p_worker->player);
+    vlc_player_Delete(p_worker->player);
+    vlc_cond_destroy( &p_worker->cond );
+    vlc_object_delete( p_worker->p_obj );
+}
+
+static void CleanSys( fingerprinter_sys_t *p_sys )
+{
+    for ( size_t i = 0; i < vlc_array_count( &p_sys->processing.queue ); i++ )
+        fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->processing.queue, i ) );
+    vlc_array_clear( &p_sys->processing.queue );
+    vlc_cond_destroy( &p_sys->processing.cond );
+    vlc_mutex_destroy( &p_sys->processing.lock );
+
+    for ( size_t i = 0; i < vlc_array_count( &p_sys->results.queue ); i++ )
+        fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->results.queue, i ) );
+    vlc_array_clear( &p_sys->results.queue );
+    vlc_mutex_destroy( &p_sys->results.lock );
+
+    free( p_sys->p_workers );
+}
+
 /*****************************************************************************
  * Open:
  *****************************************************************************/
@@ -222,37 +367,28 @@ static int Open(vlc_object_t *p_this)
 
     p_fingerprinter->p_sys = p_sys;
 
-    var_Create(p_fingerprinter, "vout", VLC_VAR_STRING);
-    var_SetString(p_fingerprinter, "vout", "dummy");
-    var_Create(p_fingerprinter, "aout", VLC_VAR_STRING);
-    var_SetString(p_fingerprinter, "aout", "dummy");
-    p_sys->player = vlc_player_New(VLC_OBJECT(p_fingerprinter),
-                                   VLC_PLAYER_LOCK_NORMAL, NULL, NULL );
-    if (!p_sys->player)
-    {
-        free(p_sys);
-        return VLC_ENOMEM;
-    }
-
-    static const struct vlc_player_cbs cbs = {
-        .on_state_changed = player_on_state_changed,
-    };
-
-    vlc_player_Lock(p_sys->player);
-    p_sys->listener_id =
-        vlc_player_AddListener(p_sys->player, &cbs, p_fingerprinter->p_sys);
-    vlc_player_Unlock(p_sys->player);
-    if (!p_sys->listener_id)
+    unsigned i_workers = var_InheritInteger(p_fingerprinter,
+                                            "fingerprinter-threads");
+    if (i_workers == 0)
+        i_workers = vlc_GetCPUCount();
+    p_sys->p_workers = vlc_alloc(i_workers, sizeof (*p_sys->p_workers));
+    if (!p_sys->p_workers)
     {
-        vlc_player_Delete(p_sys->player);
         free(p_sys);
         return VLC_ENOMEM;
     }
+    p_sys->b_lookup = var_InheritBool(p_fingerprinter, "fingerprinter-lookup");
+    p_sys->b_loudness = var_InheritBool(p_fingerprinter,
+                                        "fingerprinter-loudness");
+    atomic_init(&p_sys->b_closing, false);
 
-    vlc_array_init( &p_sys->incoming.queue );
-    vlc_mutex_init( &p_sys->incoming.lock );
+    var_Create(p_fingerprinter, "vout", VLC_VAR_STRING);
+    var_SetString(p_fingerprinter, "vout", "dummy");
+    var_Create(p_fingerprinter, "aout", VLC_VAR_STRING);
+    var_SetString(p_fingerprinter, "aout", "dummy");
 
     vlc_array_init( &p_sys->processing.queue );
+    vlc_mutex_init( &p_sys->processing.lock );
     vlc_cond_init( &p_sys->processing.cond );
 
     vlc_array_init( &p_sys->results.queue );
@@ -263,13 +399,16 @@ static int Open(vlc_object_t *p_this)
     p_fingerprinter->pf_apply = ApplyResult;
 
     var_Create( p_fingerprinter, "results-available", VLC_VAR_BOOL );
-    if( vlc_clone( &p_sys->thread, Run, p_fingerprinter,
-                   VLC_THREAD_PRIORITY_LOW ) )
-    {
-        msg_Err( p_fingerprinter, "cannot spawn fingerprinter thread" );
+
+    while( p_sys->i_workers < i_workers
+        && StartWorker( p_fingerprinter,
+                        &p_sys->p_workers[p_sys->i_workers] ) == VLC_SUCCESS )
+        p_sys->i_workers++;
+
+    if( p_sys->i_workers == 0 )
         goto error;
-    }
 
+    msg_Dbg( p_fingerprinter, "using %u worker(s)", p_sys->i_workers );
     return VLC_SUCCESS;
 
 error:
@@ -286,36 +425,20 @@ static void Close(vlc_object_t *p_this)
     fingerprinter_thread_t   *p_fingerprinter = (fingerprinter_thread_t*) p_this;
     fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
 
-    vlc_cancel( p_sys->thread );
-    vlc_join( p_sys->thread, NULL );
+    vlc_mutex_lock( &p_sys->processing.lock );
+    atomic_store( &p_sys->b_closing, true );
+    vlc_cond_broadcast( &p_sys->processing.cond );
+    vlc_mutex_unlock( &p_sys->processing.lock );
+
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
+        StopWorker( &p_sys->p_workers[i] );
+    for( unsigned i = 0; i < p_sys->i_workers; i++ )
+        JoinWorker( &p_sys->p_workers[i] );
 
     CleanSys( p_sys );
     free( p_sys );
 }
 
-static void CleanSys( fingerprinter_sys_t *p_sys )
-{
-    for ( size_t i = 0; i < vlc_array_count( &p_sys->incoming.queue ); i++ )
-        fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->incoming.queue, i ) );
-    vlc_array_clear( &p_sys->incoming.queue );
-    vlc_mutex_destroy( &p_sys->incoming.lock );
-
-    for ( size_t i = 0; i < vlc_array_count( &p_sys->processing.queue ); i++ )
-        fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->processing.queue, i ) );
-    vlc_array_clear( &p_sys->processing.queue );
-    vlc_cond_destroy( &p_sys->processing.cond );
-
-    for ( size_t i = 0; i < vlc_array_count( &p_sys->results.queue ); i++ )
-        fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->results.queue, i ) );
-    vlc_array_clear( &p_sys->results.queue );
-    vlc_mutex_destroy( &p_sys->results.lock );
-
-    vlc_player_Lock(p_sys->player);
-    vlc_player_RemoveListener(p_sys->player, p_sys->listener_id);
-    vlc_player_Unlock(p_sys->player);
-    vlc_player_Delete(p_sys->player);
-}
-
 static void fill_metas_with_results( fingerprint_request_t *p_r, acoustid_fingerprint_t *p_f )
 {
     for( unsigned int i=0 ; i < p_f->results.count; i++ )
@@ -342,71 +465,78 @@ static void fill_metas_with_results( fingerprint_request_t *p_r, acoustid_finger
  *****************************************************************************/
 static void *Run( void *opaque )
 {
-    fingerprinter_thread_t *p_fingerprinter = opaque;
+    struct fingerprinter_worker *p_worker = opaque;
+    fingerprinter_thread_t *p_fingerprinter = p_worker->p_fingerprinter;
     fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
 
-    /* main loop */
     for (;;)
     {
-        vlc_tick_sleep( VLC_TICK_FROM_SEC(1) );
+        fingerprint_request_t *p_data;
+
+        vlc_mutex_lock( &p_sys->processing.lock );
+        while( !atomic_load( &p_sys->b_closing )
+            && vlc_array_count( &p_sys->processing.queue ) == 0 )
+            vlc_cond_wait( &p_sys->processing.cond, &p_sys->processing.lock );
 
-        QueueIncomingRequests( p_sys );
+        if( atomic_load( &p_sys->b_closing ) )
+        {
+            vlc_mutex_unlock( &p_sys->processing.lock );
+            break;
+        }
 
-        vlc_testcancel();
+        // the fingerprint request must not exist both in the
+        // processing and results queue, so remove it immediately
+        p_data = vlc_array_item_at_index( &p_sys->processing.queue, 0 );
+        vlc_array_remove( &p_sys->processing.queue, 0 );
+        vlc_mutex_unlock( &p_sys->processing.lock );
 
-        bool results_available = false;
-        while( vlc_array_count( &p_sys->processing.queue ) )
+        char *psz_uri = input_item_GetURI( p_data->p_item );
+        if ( psz_uri != NULL )
         {
-            int canc = vlc_savecancel();
-            fingerprint_request_t *p_data = vlc_array_item_at_index( &p_sys->processing.queue, 0 );
+             acoustid_fingerprint_t acoustid_print;
+             loudness_data_t loudness;
 
-            char *psz_uri = input_item_GetURI( p_data->p_item );
-            if ( psz_uri != NULL )
-            {
-                 acoustid_fingerprint_t acoustid_print;
+             memset( &acoustid_print , 0, sizeof (acoustid_print) );
+            /* overwrite with hint, as in this case, fingerprint's session will be truncated */
+            if ( p_data->i_duration )
+                 acoustid_print.i_duration = p_data->i_duration;
 
-                 memset( &acoustid_print , 0, sizeof (acoustid_print) );
-                /* overwrite with hint, as in this case, fingerprint's session will be truncated */
-                if ( p_data->i_duration )
-                     acoustid_print.i_duration = p_data->i_duration;
+            DoFingerprint( p_worker, &acoustid_print, &loudness, psz_uri );
+            free( psz_uri );
 
-                DoFingerprint( p_fingerprinter, &acoustid_print, psz_uri );
-                free( psz_uri );
+            /* An interrupted track would yield a partial measurement */
+            if ( p_sys->b_loudness && loudness.b_valid
+              && !atomic_load( &p_sys->b_closing ) )
+                StoreLoudness( p_data->p_item, &loudness );
 
+            if ( p_sys->b_lookup && acoustid_print.psz_fingerprint != NULL
+              && !atomic_load( &p_sys->b_closing ) )
+            {
                 acoustid_config_t cfg = { .p_obj = VLC_OBJECT(p_fingerprinter),
                                           .psz_server = NULL, .psz_apikey = NULL };
                 acoustid_lookup_fingerprint( &cfg, &acoustid_print );
                 fill_metas_with_results( p_data, &acoustid_print );
-
-                for( unsigned j = 0; j < acoustid_print.results.count; j++ )
-                     acoustid_result_release( &acoustid_print.results.p_results[j] );
-                if( acoustid_print.results.count )
-                    free( acoustid_print.results.p_results );
-                free( acoustid_print.psz_fingerprint );
             }
-            vlc_restorecancel(canc);
-
-            /* copy results */
-            vlc_mutex_lock( &p_sys->results.lock );
-            if( vlc_array_append( &p_sys->results.queue, p_data ) )
-                fingerprint_request_Delete( p_data );
-            else
-                results_available = true;
-            vlc_mutex_unlock( &p_sys->results.lock );
-
-            // the fingerprint request must not exist both in the
-            // processing and results queue, even in case of thread
-            // cancellation, so remove it immediately
-            vlc_array_remove( &p_sys->processing.queue, 0 );
-
-            vlc_testcancel();
+
+            for( unsigned j = 0; j < acoustid_print.results.count; j++ )
+                 acoustid_result_release( &acoustid_print.results.p_results[j] );
+            if( acoustid_print.results.count )
+                free( acoustid_print.results.p_results );
+            free( acoustid_print.psz_fingerprint );
         }
 
+        /* copy results */
+        bool results_available = false;
+        vlc_mutex_lock( &p_sys->results.lock );
+        if( vlc_array_append( &p_sys->results.queue, p_data ) )
+            fingerprint_request_Delete( p_data );
+        else
+            results_available = true;
+        vlc_mutex_unlock( &p_sys->results.lock );
+
         if ( results_available )
-        {
             var_TriggerCallback( p_fingerprinter, "results-available" );
-        }
     }
 
-    vlc_assert_unreachable();
+    return NULL;
 }
@@ -42,13 +42,106 @@
 #include <gnutls/gnutls.h>
 #include <gnutls/x509.h>
 
+#if defined(__linux__) && (GNUTLS_VERSION_NUMBER >= 0x030703)
+# define HAVE_KTLS 1
+# include <sys/socket.h>
+# include <gnutls/socket.h>
+#endif
+
 typedef struct vlc_tls_gnutls
 {
     vlc_tls_t tls;
     gnutls_session_t session;
+    vlc_tls_t *sock;
+    int ktls_fd; /* socket used as transport for kernel TLS, or -1 */
     vlc_object_t *obj;
+    char *host; /* client side, for session resumption */
+    bool verified;
 } vlc_tls_gnutls_t;
 
+/* Client sessions kept for resumption, across all credentials */
+#define SESSION_CACHE_SIZE 16
+
+static struct
+{
+    char *host;
+    gnutls_datum_t data;
+    time_t stamp;
+} gnutls_sessions[SESSION_CACHE_SIZE];
+static vlc_mutex_t gnutls_sessions_lock = VLC_STATIC_MUTEX;
+
+/**
+ * Resumes the last session with the host, if any.
+ *
+ * Session data are used once, as servers can reject reused TLS 1.3 tickets.
+ */
+static void gnutls_SessionResume(gnutls_session_t session, const char *host)
+{
+    vlc_mutex_lock(&gnutls_sessions_lock);
+    for (size_t i = 0; i < SESSION_CACHE_SIZE; i++)
+        if (gnutls_sessions[i].host != NULL
+         && !strcmp(gnutls_sessions[i].host, host))
+        {
+            gnutls_session_set_data(session, gnutls_sessions[i].data.data,
+                                    gnutls_sessions[i].data.size);
+            gnutls_free(gnutls_sessions[i].data.data);
+            free(gnutls_sessions[i].host);
+            gnutls_sessions[i].host = NULL;
+            break;
+        }
+    vlc_mutex_unlock(&gnutls_sessions_lock);
+}
+
+static void gnutls_SessionSave(gnutls_session_t session, const char *host)
+{
+#if (GNUTLS_VERSION_NUMBER >= 0x030603)
+    if (gnutls_protocol_get_version(session) == GNUTLS_TLS1_3
+     && !(gnutls_session_get_flags(session) & GNUTLS_SFLAGS_SESSION_TICKET))
+        return; /* no tickets received (yet) */
+#endif
+
+    gnutls_datum_t data;
+    char *name = strdup(host);
+
+    if (unlikely(name == NULL))
+        return;
+    if (gnutls_session_get_data2(session, &data))
+    {
+        free(name);
+        return;
+    }
+
+    vlc_mutex_lock(&gnutls_sessions_lock);
+    size_t slot = 0;
+
+    for (size_t i = 0; i < SESSION_CACHE_SIZE; i++)
+    {
+        if (gnutls_sessions[i].host == NULL)
+        {
+            slot = i;
+            continue;
+        }
+        if (!strcmp(gnutls_sessions[i].host, host))
+        {   /* Replace the older session with the host */
+            slot = i;
+            break;
+        }
+        if (gnutls_sessions[slot].host != NULL
+         && gnutls_sessions[i].stamp < gnutls_sessions[slot].stamp)
+            slot = i; /* least recently saved */
+    }
+
+    if (gnutls_sessions[slot].host != NULL)
+    {
+        gnutls_free(gnutls_sessions[slot].data.data);
+        free(gnutls_sessions[slot].host);
+    }
+    gnutls_sessions[slot].host = name;
+    gnutls_sessions[slot].data = data;
+    gnutls_sessions[slot].stamp = time(NULL);
+    vlc_mutex_unlock(&gnutls_sessions_lock);
+}
+
 static void gnutls_Banner(vlc_object_t *obj)
 {
     msg_Dbg(obj, "using GnuTLS v%s (built with v"GNUTLS_VERSION")",
@@ -127,12 +220,46 @@ static ssize_t vlc_gnutls_writev(gnutls_transport_ptr_t ptr,
     return sock->ops->writev(sock, iov, iovcnt);
 }
 
+#ifdef HAVE_KTLS
+/* Kernel TLS needs the socket itself as transport, not the VLC stream */
+static ssize_t vlc_gnutls_fd_read(gnutls_transport_ptr_t ptr, void *buf,
+                                  size_t length)
+{
+    return recv((intptr_t)ptr, buf, length, 0);
+}
+
+static ssize_t vlc_gnutls_fd_writev(gnutls_transport_ptr_t ptr,
+                                    const giovec_t *giov, int iovcnt)
+{
+    const struct msghdr msg =
+    {
+        .msg_iov = (struct iovec *)giov,
+        .msg_iovlen = iovcnt,
+    };
+
+    return sendmsg((intptr_t)ptr, &msg, MSG_NOSIGNAL);
+}
+#endif
+
 static int gnutls_GetFD(vlc_tls_t *tls, short *restrict events)
 {
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
-    vlc_tls_t *sock = gnutls_transport_get_ptr(priv->session);
 
-    return vlc_tls_GetPollFD(sock, events);
+    return vlc_tls_GetPollFD(priv->sock, events);
+}
+
+static int gnutls_GetSendFD(vlc_tls_t *tls)
+{
+    vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
+
+#ifdef HAVE_KTLS
+    if (priv->ktls_fd != -1
+     && (gnutls_transport_is_ktls_enabled(priv->session) & GNUTLS_KTLS_SEND))
+        return priv->ktls_fd;
+#else
+    (void) priv;
+#endif
+    return -1;
 }
 
 static ssize_t gnutls_Recv(vlc_tls_t *tls, struct iovec *iov, unsigned count)
@@ -207,6 +334,12 @@ static void gnutls_Close (vlc_tls_t *tls)
 {
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
 
+    if (priv->host != NULL)
+    {
+        if (priv->verified)
+            gnutls_SessionSave(priv->session, priv->host);
+        free(priv->host);
+    }
     gnutls_deinit(priv->session);
     free(priv);
 }
@@ -218,6 +351,7 @@ static const struct vlc_tls_operations gnutls_ops =
     gnutls_Send,
     gnutls_Shutdown,
     gnutls_Close,
+    gnutls_GetSendFD,
 };
 
 static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_object_t *obj, int type,
@@ -235,6 +369,14 @@ static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_object_t *obj, int type,
 
     type |= GNUTLS_NONBLOCK | GNUTLS_ENABLE_FALSE_START;
 
+    int ktls_fd = -1;
+#ifdef HAVE_KTLS
+    /* GnuTLS offloads to the kernel (if the system configuration allows it)
+     * only with a socket as transport, so the records must go as is. */
+    if (sock->p == NULL && var_InheritBool(obj, "gnutls-ktls"))
+        ktls_fd = vlc_tls_GetSendFD(sock);
+#endif
+
     val = gnutls_init(&session, type);
     if (val != 0)
     {
@@ -289,12 +431,27 @@ static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_object_t *obj, int type,
         free (protv);
     }
 
-    gnutls_transport_set_ptr(session, sock);
-    gnutls_transport_set_vec_push_function(session, vlc_gnutls_writev);
-    gnutls_transport_set_pull_function(session, vlc_gnutls_read);
+#ifdef HAVE_KTLS
+    if (ktls_fd != -1)
+    {
+        gnutls_transport_set_int(session, ktls_fd);
+        gnutls_transport_set_vec_push_function(session, vlc_gnutls_fd_writev);
+        gnutls_transport_set_pull_function(session, vlc_gnutls_fd_read);
+    }
+    else
+#endif
+    {
+        gnutls_transport_set_ptr(session, sock);
+        gnutls_transport_set_vec_push_function(session, vlc_gnutls_writev);
+        gnutls_transport_set_pull_function(session, vlc_gnutls_read);
+    }
 
     priv->session = session;
+    priv->sock = sock;
+    priv->ktls_fd = ktls_fd;
     priv->obj = obj;
+    priv->host = NULL;
+    priv->verified = false;
 
     vlc_tls_t *tls = &priv->tls;
 
@@ -344,6 +501,9 @@ static int gnutls_Handshake(vlc_tls_t *tls, char **restrict alp)
 
     unsigned flags = gnutls_session_get_flags(session);
 
+    if (gnutls_session_is_resumed(session))
+        msg_Dbg(obj, " - session resumed");
+
     if (flags & GNUTLS_SFLAGS_SAFE_RENEGOTIATION)
         msg_Dbg(obj, " - safe renegotiation (RFC5746) enabled");
     if (flags & GNUTLS_SFLAGS_EXT_MASTER_SECRET)
@@ -352,6 +512,24 @@ static int gnutls_Handshake(vlc_tls_t *tls, char **restrict alp)
         msg_Dbg(obj, " - encrypt then MAC (RFC7366) enabled");
     if (flags & GNUTLS_SFLAGS_FALSE_START)
         msg_Dbg(obj, " - false start (RFC7918) enabled");
+#ifdef HAVE_KTLS
+    if (priv->ktls_fd != -1)
+    {
+        static const char *const ktls_modes[] = {
+            [GNUTLS_KTLS_RECV] = "receive",
+            [GNUTLS_KTLS_SEND] = "send",
+            [GNUTLS_KTLS_DUPLEX] = "send and receive",
+        };
+        gnutls_transport_ktls_enable_flags_t ktls =
+            gnutls_transport_is_ktls_enabled(session);
+
+        if (ktls != 0)
+            msg_Dbg(obj, " - kernel TLS offload for %s enabled",
+                    ktls_modes[ktls]);
+        else
+            msg_Dbg(obj, " - kernel TLS offload not available");
+    }
+#endif
 
     if (alp != NULL)
     {
@@ -388,10 +566,16 @@ static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_client_t *crd,
     gnutls_dh_set_prime_bits (session, 1024);
 
     if (likely(hostname != NULL))
+    {
         /* fill Server Name Indication */
         gnutls_server_name_set (session, GNUTLS_NAME_DNS,
                                 hostname, strlen (hostname));
 
+        priv->host = strdup(hostname);
+        if (likely(priv->host != NULL))
+            gnutls_SessionResume(session, hostname);
+    }
+
     return &priv->tls;
 }
 
@@ -419,7 +603,10 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
     }
 
     if (status == 0) /* Good certificate */
+    {
+        priv->verified = true;
         return 0;
+    }
 
     /* Bad certificate */
     gnutls_datum_t desc;
@@ -457,6 +644,7 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
     {
         case 0:
             msg_Dbg(obj, "certificate key match for %s", host);
+            priv->verified = true;
             return 0;
         case GNUTLS_E_NO_CERTIFICATE_FOUND:
             msg_Dbg(obj, "no known certificates for %s", host);
@@ -732,6 +920,11 @@ error:
     "Trust the root certificates of Certificate Authorities stored in " \
     "the specified directory to authenticate TLS sessions.")
 
+#define KTLS_TEXT N_("Kernel TLS offload")
+#define KTLS_LONGTEXT N_("Let the operating system encrypt and decrypt " \
+    "the TLS records if it supports it, possibly in the network card. " \
+    "This saves copies and allows zero-copy sending of files.")
+
 #define PRIORITIES_TEXT N_("TLS cipher priorities")
 #define PRIORITIES_LONGTEXT N_("Ciphers, key exchange methods, " \
     "hash functions and compression methods can be selected. " \
@@ -765,6 +958,9 @@ vlc_module_begin ()
     add_string ("gnutls-priorities", "NORMAL", PRIORITIES_TEXT,
                 PRIORITIES_LONGTEXT, false)
         change_string_list (priorities_values, priorities_text)
+#ifdef HAVE_KTLS
+    add_bool("gnutls-ktls", true, KTLS_TEXT, KTLS_LONGTEXT, true)
+#endif
 #ifdef ENABLE_SOUT
     add_submodule ()
         set_description( N_("GNU TLS server") )
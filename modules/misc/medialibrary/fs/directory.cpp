@@ -61,6 +61,7 @@ SDDirectory::mrl() const
 const std::vector<std::shared_ptr<IFile>> &
 SDDirectory::files() const
 {
+    vlc::threads::mutex_locker lock(m_mutex);
     if (!m_read_done)
         read();
     return m_files;
@@ -69,6 +70,7 @@ SDDirectory::files() const
 const std::vector<std::shared_ptr<IDirectory>> &
 SDDirectory::dirs() const
 {
+    vlc::threads::mutex_locker lock(m_mutex);
     if (!m_read_done)
         read();
     return m_dirs;
@@ -197,7 +199,7 @@ SDDirectory::read() const
         const char *mrl = m.get()->psz_uri;
         enum input_item_type_e type = m->i_type;
         if (type == ITEM_TYPE_DIRECTORY)
-            m_dirs.push_back(std::make_shared<SDDirectory>(mrl, m_fs));
+            m_dirs.push_back(m_fs.createDirectory(mrl));
         else if (type == ITEM_TYPE_FILE)
             m_files.push_back(std::make_shared<SDFile>(mrl));
     }
@@ -47,6 +47,8 @@ private:
     std::string m_mrl;
     SDFileSystemFactory &m_fs;
 
+    /* the directory may be shared through the factory cache */
+    mutable vlc::threads::mutex m_mutex;
     mutable bool m_read_done = false;
     mutable std::vector<std::shared_ptr<IFile>> m_files;
     mutable std::vector<std::shared_ptr<IDirectory>> m_dirs;
@@ -67,6 +67,11 @@ namespace vlc {
 
 using namespace ::medialibrary;
 
+/* A listing is reused during this delay, then the directory is read again so
+ * that changes are eventually noticed by the next reload */
+#define DIRECTORY_CACHE_DELAY VLC_TICK_FROM_SEC(30)
+#define DIRECTORY_CACHE_MAX 4096
+
 SDFileSystemFactory::SDFileSystemFactory(vlc_object_t *parent,
                                          const std::string &scheme)
     : m_parent(parent)
@@ -77,13 +82,45 @@ SDFileSystemFactory::SDFileSystemFactory(vlc_object_t *parent,
 std::shared_ptr<IDirectory>
 SDFileSystemFactory::createDirectory(const std::string &mrl)
 {
-    return std::make_shared<SDDirectory>(mrl, *this);
+    std::string key = mrl;
+    if ( key.empty() || *key.crbegin() != '/' )
+        key += '/';
+
+    vlc_tick_t now = vlc_tick_now();
+    vlc::threads::mutex_locker locker(m_cacheMutex);
+
+    auto it = m_dirCache.find(key);
+    if ( it != m_dirCache.end() )
+    {
+        if ( now - it->second.date < DIRECTORY_CACHE_DELAY )
+            return it->second.dir;
+        m_dirCache.erase(it);
+    }
+
+    if ( m_dirCache.size() >= DIRECTORY_CACHE_MAX )
+    {
+        /* drop the expired listings, or everything if none expired */
+        for ( auto i = m_dirCache.begin(); i != m_dirCache.end(); )
+        {
+            if ( now - i->second.date >= DIRECTORY_CACHE_DELAY )
+                i = m_dirCache.erase(i);
+            else
+                ++i;
+        }
+        if ( m_dirCache.size() >= DIRECTORY_CACHE_MAX )
+            m_dirCache.clear();
+    }
+
+    auto dir = std::make_shared<SDDirectory>(key, *this);
+    m_dirCache.emplace(key, CachedDirectory{ now, dir });
+    return dir;
 }
 
 std::shared_ptr<IFile>
 SDFileSystemFactory::createFile(const std::string& mrl)
 {
-    auto dir = createDirectory(mrl);
+    /* list the parent directory, shared by all the files it contains */
+    auto dir = createDirectory(utils::directory(mrl));
     assert(dir != nullptr);
     return dir->file(mrl);
 }
@@ -187,6 +224,9 @@ SDFileSystemFactory::stop()
 {
     m_sds.clear();
     m_callbacks = nullptr;
+
+    vlc::threads::mutex_locker locker(m_cacheMutex);
+    m_dirCache.clear();
 }
 
 libvlc_int_t *
@@ -254,6 +294,16 @@ SDFileSystemFactory::onDeviceRemoved(input_item_t *media)
             m_callbacks->onDeviceUnmounted( *(*it), mrl );
         }
     }
+
+    /* the listings of an unmounted share are stale */
+    vlc::threads::mutex_locker locker(m_cacheMutex);
+    for ( auto i = m_dirCache.begin(); i != m_dirCache.end(); )
+    {
+        if ( i->first.compare( 0, mrl.length(), mrl ) == 0 )
+            i = m_dirCache.erase(i);
+        else
+            ++i;
+    }
 }
 
   } /* namespace medialibrary */
@@ -22,6 +22,8 @@
 #define SD_FS_H
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <vlc_common.h>
 #include <vlc_threads.h>
@@ -97,6 +99,16 @@ private:
     std::vector<std::shared_ptr<IDevice>> m_devices;
     using SdPtr = std::unique_ptr<services_discovery_t, decltype(&vlc_sd_Destroy)>;
     std::vector<SdPtr> m_sds;
+
+    /* Recently listed directories, by mrl: browsing a network share is
+     * slow, so that the files of a directory (or the directory itself) can
+     * be requested again without listing it each time. */
+    struct CachedDirectory {
+        vlc_tick_t date;
+        std::shared_ptr<IDirectory> dir;
+    };
+    vlc::threads::mutex m_cacheMutex;
+    std::unordered_map<std::string, CachedDirectory> m_dirCache;
 };
 
   } /* namespace medialibrary */
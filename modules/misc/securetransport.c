@@ -660,6 +660,7 @@ static const struct vlc_tls_operations st_ops =
     st_Send,
     st_SessionShutdown,
     st_SessionClose,
+    NULL,
 };
 
 /**
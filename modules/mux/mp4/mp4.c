@@ -53,6 +53,20 @@
     "Create \"Fast Start\" files. " \
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
+#define MOOVRESERVE_TEXT N_("Reserve space for the index (seconds)")
+#define MOOVRESERVE_LONGTEXT N_(\
+    "Reserve space at the start of the file for the index of a recording " \
+    "of up to this duration, so that it can be written there at the end " \
+    "instead of being appended, or of moving all the data for a " \
+    "\"Fast Start\" file. 0 disables the reservation.")
+#define FRAGMENTED_TEXT N_("Create fragmented files")
+#define FRAGMENTED_LONGTEXT N_(\
+    "Write the samples as movie fragments, starting on key frames, with a " \
+    "final random access index. The memory use does not grow with the " \
+    "duration, as the sample tables are written with each fragment.")
+#define FRAGDURATION_TEXT N_("Fragment duration (ms)")
+#define FRAGDURATION_LONGTEXT N_(\
+    "Target duration of the fragments, which are cut on key frames.")
 
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
@@ -69,6 +83,14 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "faststart", false,
               FASTSTART_TEXT, FASTSTART_LONGTEXT,
               true)
+    add_integer(SOUT_CFG_PREFIX "moov-reserve", 0,
+                MOOVRESERVE_TEXT, MOOVRESERVE_LONGTEXT, true)
+        change_integer_range(0, 7 * 24 * 3600)
+    add_bool(SOUT_CFG_PREFIX "fragmented", false,
+             FRAGMENTED_TEXT, FRAGMENTED_LONGTEXT, true)
+    add_integer(SOUT_CFG_PREFIX "fragment-duration", 1500,
+                FRAGDURATION_TEXT, FRAGDURATION_LONGTEXT, true)
+        change_integer_range(100, 60000)
     set_capability("sout mux", 5)
     add_shortcut("mp4", "mov", "3gp")
     set_callbacks(Open, Close)
@@ -88,7 +110,7 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "moov-reserve", "fragmented", "fragment-duration", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -164,6 +186,8 @@ typedef struct
 
     uint64_t i_mdat_pos;
     uint64_t i_pos;
+    uint64_t i_moov_reserve_pos;
+    uint32_t i_moov_reserve; /* free box size, 0 if none */
     vlc_tick_t  i_read_duration;
     vlc_tick_t  i_start_dts;
 
@@ -172,6 +196,7 @@ typedef struct
 
 
     /* mp4frag */
+    vlc_tick_t     i_fragment_length;
     vlc_tick_t     i_written_duration;
     uint32_t       i_mfhd_sequence;
 } sout_mux_sys_t;
@@ -224,6 +249,47 @@ static block_t *ConvertSUBT(block_t *);
 static bool CreateCurrentEdit(mp4_stream_t *, vlc_tick_t, bool);
 static int MuxStream(sout_mux_t *p_mux, sout_input_t *p_input, mp4_stream_t *p_stream);
 
+/* Upper bound of the index size of a sample: stsz, stts, ctts, co64 and
+ * stsc entries, as if each sample were in its own chunk, plus stss */
+#define MOOV_BYTES_PER_SAMPLE 44
+#define MOOV_BYTES_PER_TRACK  4096
+
+static uint64_t EstimateMoovSize(sout_mux_t *p_mux, vlc_tick_t i_duration)
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    uint64_t i_size = MOOV_BYTES_PER_TRACK; /* mvhd, udta */
+
+    for (unsigned i = 0; i < p_sys->i_nb_streams; i++)
+    {
+        const es_format_t *fmt =
+            mp4mux_track_GetFmt(p_sys->pp_streams[i]->tinfo);
+        double f_rate; /* samples per second */
+
+        switch (fmt->i_cat)
+        {
+            case VIDEO_ES:
+                f_rate = 60.;
+                if (fmt->video.i_frame_rate && fmt->video.i_frame_rate_base)
+                    f_rate = (double) fmt->video.i_frame_rate /
+                             fmt->video.i_frame_rate_base;
+                break;
+            case AUDIO_ES:
+                f_rate = 50.;
+                if (fmt->audio.i_rate)
+                    f_rate = (double) fmt->audio.i_rate /
+                             (fmt->audio.i_frame_length ?
+                              fmt->audio.i_frame_length : 1024);
+                break;
+            default:
+                f_rate = 10.;
+                break;
+        }
+        i_size += MOOV_BYTES_PER_TRACK + MOOV_BYTES_PER_SAMPLE *
+                  (uint64_t) (f_rate * secf_from_vlc_tick(i_duration));
+    }
+    return i_size;
+}
+
 static int WriteSlowStartHeader(sout_mux_t *p_mux)
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
@@ -241,6 +307,27 @@ static int WriteSlowStartHeader(sout_mux_t *p_mux)
         box_send(p_mux, box);
     }
 
+    /* Reserve the index space with a free box, before the data */
+    int64_t i_reserve = var_GetInteger(p_mux, SOUT_CFG_PREFIX "moov-reserve");
+    if (i_reserve > 0)
+    {
+        uint64_t i_size = EstimateMoovSize(p_mux, vlc_tick_from_sec(i_reserve));
+        block_t *p_free = block_Alloc(__MIN(i_size, UINT32_C(1) << 30));
+        if (p_free != NULL)
+        {
+            memset(p_free->p_buffer, 0, p_free->i_buffer);
+            SetDWBE(p_free->p_buffer, p_free->i_buffer);
+            memcpy(&p_free->p_buffer[4], "free", 4);
+            msg_Dbg(p_mux, "reserving %zu bytes for the moov", p_free->i_buffer);
+
+            p_sys->i_moov_reserve_pos = p_sys->i_pos;
+            p_sys->i_moov_reserve = p_free->i_buffer;
+            p_sys->i_pos += p_free->i_buffer;
+            p_sys->i_mdat_pos = p_sys->i_pos;
+            sout_AccessOutWrite(p_mux->p_access, p_free);
+        }
+    }
+
     /* Now add mdat header */
     box = box_new("mdat");
     if(!box)
@@ -277,6 +364,8 @@ static int Open(vlc_object_t *p_this)
         if(!strcmp(p_mux->psz_mux, "mp4frag") || !strcmp(p_mux->psz_mux, "mp4stream"))
             options |= FRAGMENTED;
     }
+    if (var_GetBool(p_mux, SOUT_CFG_PREFIX "fragmented"))
+        options |= FRAGMENTED;
 
     p_sys->b_3gp = p_mux->psz_mux && !strcmp(p_mux->psz_mux, "3gp");
 
@@ -286,12 +375,16 @@ static int Open(vlc_object_t *p_this)
     p_sys->i_nb_streams = 0;
     p_sys->pp_streams   = NULL;
     p_sys->i_mdat_pos   = 0;
+    p_sys->i_moov_reserve_pos = 0;
+    p_sys->i_moov_reserve = 0;
     p_sys->b_header_sent = false;
 
     p_sys->i_read_duration   = 0;
     p_sys->i_written_duration= 0;
     p_sys->i_start_dts = VLC_TICK_INVALID;
     p_sys->i_mfhd_sequence = 1;
+    p_sys->i_fragment_length = VLC_TICK_FROM_MS(
+            var_GetInteger(p_mux, SOUT_CFG_PREFIX "fragment-duration"));
 
     p_mux->p_sys        = p_sys;
     p_mux->pf_control   = Control;
@@ -320,6 +413,12 @@ static void Close(vlc_object_t *p_this)
     sout_mux_t      *p_mux = (sout_mux_t*)p_this;
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
 
+    if (mp4mux_Is(p_sys->muxh, FRAGMENTED))
+    {
+        CloseFrag(p_this);
+        return;
+    }
+
     msg_Dbg(p_mux, "Close");
 
     /* Update mdat size */
@@ -351,6 +450,35 @@ static void Close(vlc_object_t *p_this)
 
     /* Check we need to create "fast start" files */
     p_sys->b_fast_start = var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
+
+    /* Write the moov in the reserved space if it fits, the remainder
+     * staying a (smaller) free box. The samples do not move. */
+    if (p_sys->i_moov_reserve > 0 && moov && moov->b)
+    {
+        uint64_t i_left = p_sys->i_moov_reserve - (uint64_t) bo_size(moov);
+        if (bo_size(moov) == p_sys->i_moov_reserve ||
+            (bo_size(moov) < p_sys->i_moov_reserve && i_left >= 8))
+        {
+            i_moov_pos = p_sys->i_moov_reserve_pos;
+            p_sys->b_fast_start = false;
+
+            if (i_left > 0)
+            {
+                block_t *p_free = block_Alloc(8);
+                if (p_free != NULL)
+                {
+                    SetDWBE(p_free->p_buffer, i_left);
+                    memcpy(&p_free->p_buffer[4], "free", 4);
+                    sout_AccessOutSeek(p_mux->p_access,
+                                       i_moov_pos + bo_size(moov));
+                    sout_AccessOutWrite(p_mux->p_access, p_free);
+                }
+            }
+        }
+        else
+            msg_Warn(p_mux, "moov of %zu bytes exceeds the %"PRIu32
+                     " reserved bytes", bo_size(moov), p_sys->i_moov_reserve);
+    }
     while (p_sys->b_fast_start && moov && moov->b)
     {
         /* Move data to the end of the file so we can fit the moov header
@@ -906,8 +1034,6 @@ static void box_send(sout_mux_t *p_mux,  bo_t *box)
 /***************************************************************************
     MP4 Live submodule
 ****************************************************************************/
-#define FRAGMENT_LENGTH  VLC_TICK_FROM_MS(1500)
-
 #define ENQUEUE_ENTRY(object, entry) \
     do {\
         if (object.p_last)\
@@ -1293,7 +1419,7 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 {
     sout_mux_sys_t *p_sys = (sout_mux_sys_t*) p_mux->p_sys;
     bo_t *moof = NULL;
-    vlc_tick_t i_barrier_time = p_sys->i_written_duration + FRAGMENT_LENGTH;
+    vlc_tick_t i_barrier_time = p_sys->i_written_duration + p_sys->i_fragment_length;
     size_t i_mdat_size = 0;
     bool b_has_samples = false;
 
@@ -1411,7 +1537,7 @@ static void CloseFrag(vlc_object_t *p_this)
 
     /* Write indexes, but only for non streamed content
        as they refer to moof by absolute position */
-    if (!strcmp(p_mux->psz_mux, "mp4frag"))
+    if (!p_mux->psz_mux || strcmp(p_mux->psz_mux, "mp4stream"))
     {
         bo_t *mfra = GetMfraBox(p_mux);
         if (mfra)
@@ -1481,7 +1607,7 @@ static int MuxFrag(sout_mux_t *p_mux)
         p_stream->p_held_entry = NULL;
 
         if (p_stream->b_hasiframes && (p_heldblock->i_flags & BLOCK_FLAG_TYPE_I) &&
-            mp4mux_track_GetDuration(p_stream->tinfo) - p_sys->i_written_duration < FRAGMENT_LENGTH)
+            mp4mux_track_GetDuration(p_stream->tinfo) - p_sys->i_written_duration < p_sys->i_fragment_length)
         {
             /* Flag the last iframe time, we'll use it as boundary so it will start
                next fragment */
@@ -1534,7 +1660,7 @@ static int MuxFrag(sout_mux_t *p_mux)
     p_sys->i_written_duration = i_min_written_duration;
 
     /* we have prerolled enough to know all streams, and have enough date to create a fragment */
-    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= FRAGMENT_LENGTH)
+    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= p_sys->i_fragment_length)
         WriteFragments(p_mux, false);
 
     return VLC_SUCCESS;
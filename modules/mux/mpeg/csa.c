@@ -610,3 +610,355 @@ static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
     }
 }
 
+
+/*****************************************************************************
+ * Batch processing
+ *****************************************************************************
+ * The stream cypher is by far the most expensive part, as it works two bits
+ * at a time. In batch mode, it is run bitsliced: each bit of the cypher state
+ * is stored as one word, where bit l is the state of packet l. All packets of
+ * a batch share the same key, and the keystream only depends on the first 8
+ * bytes of each payload, so all the keystreams are computed at once.
+ * The block cypher stays per packet.
+ *****************************************************************************/
+#define CSA_BATCH_MIN 8 /* below, scalar is faster */
+
+typedef uint64_t csa_bs_t;
+
+struct csa_bs_state
+{
+    csa_bs_t A[11][4];
+    csa_bs_t B[11][4];
+    csa_bs_t X[4], Y[4], Z[4];
+    csa_bs_t D[4], E[4], F[4];
+    csa_bs_t p, q, r;
+};
+
+static inline csa_bs_t csa_BsMux( csa_bs_t sel, csa_bs_t lo, csa_bs_t hi )
+{
+    return lo ^ ( ( lo ^ hi ) & sel );
+}
+
+/* Evaluates a 5 to 2 bits s-box as a multiplexer tree */
+static inline void csa_BsSbox( const int sbox[0x20],
+                               csa_bs_t x4, csa_bs_t x3, csa_bs_t x2,
+                               csa_bs_t x1, csa_bs_t x0,
+                               csa_bs_t *po1, csa_bs_t *po0 )
+{
+    csa_bs_t o1[16], o0[16];
+
+    for( int i = 0; i < 16; i++ )
+    {
+        const int lo = sbox[2*i], hi = sbox[2*i+1];
+
+        o1[i] = csa_BsMux( x0, -(csa_bs_t)((lo >> 1)&1), -(csa_bs_t)((hi >> 1)&1) );
+        o0[i] = csa_BsMux( x0, -(csa_bs_t)(lo&1), -(csa_bs_t)(hi&1) );
+    }
+    for( int i = 0; i < 8; i++ )
+    {
+        o1[i] = csa_BsMux( x1, o1[2*i], o1[2*i+1] );
+        o0[i] = csa_BsMux( x1, o0[2*i], o0[2*i+1] );
+    }
+    for( int i = 0; i < 4; i++ )
+    {
+        o1[i] = csa_BsMux( x2, o1[2*i], o1[2*i+1] );
+        o0[i] = csa_BsMux( x2, o0[2*i], o0[2*i+1] );
+    }
+    for( int i = 0; i < 2; i++ )
+    {
+        o1[i] = csa_BsMux( x3, o1[2*i], o1[2*i+1] );
+        o0[i] = csa_BsMux( x3, o0[2*i], o0[2*i+1] );
+    }
+    *po1 = csa_BsMux( x4, o1[0], o1[1] );
+    *po0 = csa_BsMux( x4, o0[0], o0[1] );
+}
+
+/* One iteration of csa_StreamCypher() inner loop, see there.
+ * in_a and in_b are only given during initialisation. */
+static void csa_BsStreamStep( struct csa_bs_state *s,
+                              const csa_bs_t *in_a, const csa_bs_t *in_b,
+                              csa_bs_t *p_hi, csa_bs_t *p_lo )
+{
+    csa_bs_t (*A)[4] = s->A;
+    csa_bs_t (*B)[4] = s->B;
+    csa_bs_t s1[2], s2[2], s3[2], s4[2], s5[2], s6[2], s7[2];
+    csa_bs_t extra_B[4], next_A1[4], next_B1[4], next_F[4];
+
+    csa_BsSbox( sbox1, A[4][0], A[1][2], A[6][1], A[7][3], A[9][0], &s1[1], &s1[0] );
+    csa_BsSbox( sbox2, A[2][1], A[3][2], A[6][3], A[7][0], A[9][1], &s2[1], &s2[0] );
+    csa_BsSbox( sbox3, A[1][3], A[2][0], A[5][1], A[5][3], A[6][2], &s3[1], &s3[0] );
+    csa_BsSbox( sbox4, A[3][3], A[1][1], A[2][3], A[4][2], A[8][0], &s4[1], &s4[0] );
+    csa_BsSbox( sbox5, A[5][2], A[4][3], A[6][0], A[8][1], A[9][2], &s5[1], &s5[0] );
+    csa_BsSbox( sbox6, A[3][1], A[4][1], A[5][0], A[7][2], A[9][3], &s6[1], &s6[0] );
+    csa_BsSbox( sbox7, A[2][2], A[3][0], A[7][1], A[8][2], A[8][3], &s7[1], &s7[0] );
+
+    extra_B[3] = B[3][0] ^ B[6][1] ^ B[7][2] ^ B[9][3];
+    extra_B[2] = B[6][0] ^ B[8][1] ^ B[3][3] ^ B[4][2];
+    extra_B[1] = B[5][3] ^ B[8][2] ^ B[4][0] ^ B[5][1];
+    extra_B[0] = B[9][2] ^ B[6][3] ^ B[3][1] ^ B[8][0];
+
+    for( int b = 0; b < 4; b++ )
+    {
+        next_A1[b] = A[10][b] ^ s->X[b];
+        next_B1[b] = B[7][b] ^ B[10][b] ^ s->Y[b];
+        if( in_a )
+        {
+            next_A1[b] ^= s->D[b] ^ in_a[b];
+            next_B1[b] ^= in_b[b];
+        }
+    }
+
+    /* if p=1, rotate left */
+    const csa_bs_t b3 = next_B1[3];
+    next_B1[3] = csa_BsMux( s->p, next_B1[3], next_B1[2] );
+    next_B1[2] = csa_BsMux( s->p, next_B1[2], next_B1[1] );
+    next_B1[1] = csa_BsMux( s->p, next_B1[1], next_B1[0] );
+    next_B1[0] = csa_BsMux( s->p, next_B1[0], b3 );
+
+    /* if q=1, F = Z + E + r, r is the carry, else F = E */
+    csa_bs_t carry = s->r;
+    for( int b = 0; b < 4; b++ )
+    {
+        const csa_bs_t ze = s->Z[b] ^ s->E[b];
+
+        next_F[b] = csa_BsMux( s->q, s->E[b], ze ^ carry );
+        carry = ( s->Z[b] & s->E[b] ) | ( carry & ze );
+    }
+    s->r = csa_BsMux( s->q, s->r, carry );
+
+    for( int b = 0; b < 4; b++ )
+    {
+        s->D[b] = s->E[b] ^ s->Z[b] ^ extra_B[b];
+        s->E[b] = s->F[b];
+        s->F[b] = next_F[b];
+    }
+
+    memmove( &A[2], &A[1], 9 * sizeof(A[1]) );
+    memmove( &B[2], &B[1], 9 * sizeof(B[1]) );
+    memcpy( A[1], next_A1, sizeof(next_A1) );
+    memcpy( B[1], next_B1, sizeof(next_B1) );
+
+    s->X[3] = s4[0]; s->X[2] = s3[0]; s->X[1] = s2[1]; s->X[0] = s1[1];
+    s->Y[3] = s6[0]; s->Y[2] = s5[0]; s->Y[1] = s4[1]; s->Y[0] = s3[1];
+    s->Z[3] = s2[0]; s->Z[2] = s1[0]; s->Z[1] = s6[1]; s->Z[0] = s5[1];
+    s->p = s7[1];
+    s->q = s7[0];
+
+    *p_hi = s->D[2] ^ s->D[3];
+    *p_lo = s->D[0] ^ s->D[1];
+}
+
+/* Initialises the cypher of each packet with its first 8 bytes, then
+ * xors the keystream into the following bytes, up to pi_len[l]. */
+static void csa_BsStreamCypher( const uint8_t ck[8], uint8_t *const *pp_data,
+                                const int *pi_len, int i_count )
+{
+    struct csa_bs_state s;
+    csa_bs_t out[8][8];
+    int i_max = 0;
+
+    memset( &s, 0, sizeof(s) );
+    for( int i = 0; i < 4; i++ )
+    {
+        for( int b = 0; b < 4; b++ )
+        {
+            s.A[1+2*i+0][b] = -(csa_bs_t)(( ck[i] >> (4+b) )&1);
+            s.A[1+2*i+1][b] = -(csa_bs_t)(( ck[i] >> b )&1);
+            s.B[1+2*i+0][b] = -(csa_bs_t)(( ck[4+i] >> (4+b) )&1);
+            s.B[1+2*i+1][b] = -(csa_bs_t)(( ck[4+i] >> b )&1);
+        }
+    }
+
+    for( int l = 0; l < i_count; l++ )
+        i_max = __MAX( i_max, pi_len[l] );
+
+    for( int i = 0; i < 8; i++ )
+    {
+        csa_bs_t in[8] = { 0 };
+        csa_bs_t hi, lo;
+
+        for( int l = 0; l < i_count; l++ )
+            for( int b = 0; b < 8; b++ )
+                in[b] |= (csa_bs_t)(( pp_data[l][i] >> b )&1) << l;
+
+        for( int j = 0; j < 4; j++ )
+        {
+            if( j % 2 )
+                csa_BsStreamStep( &s, &in[0], &in[4], &hi, &lo );
+            else
+                csa_BsStreamStep( &s, &in[4], &in[0], &hi, &lo );
+        }
+    }
+
+    for( int i_pos = 8; i_pos < i_max; i_pos += 8 )
+    {
+        for( int i = 0; i < 8; i++ )
+            for( int j = 0; j < 4; j++ )
+                csa_BsStreamStep( &s, NULL, NULL,
+                                  &out[i][7-2*j], &out[i][6-2*j] );
+
+        for( int l = 0; l < i_count; l++ )
+        {
+            const int i_end = __MIN( pi_len[l] - i_pos, 8 );
+
+            for( int i = 0; i < i_end; i++ )
+            {
+                uint8_t op = 0;
+                for( int b = 0; b < 8; b++ )
+                    op |= (( out[i][b] >> l )&1) << b;
+                pp_data[l][i_pos + i] ^= op;
+            }
+        }
+    }
+}
+
+static int csa_PayloadOffset( const uint8_t *pkt )
+{
+    /* skip adaption field */
+    return ( pkt[3]&0x20 ) ? 4 + pkt[4] + 1 : 4;
+}
+
+static void csa_DecryptLanes( csa_t *c, uint8_t **pp_pkts, int i_count,
+                              int i_pkt_size, bool odd )
+{
+    uint8_t *ck = odd ? c->o_ck : c->e_ck;
+    uint8_t *kk = odd ? c->o_kk : c->e_kk;
+    uint8_t *pp_data[CSA_BATCH_MAX];
+    int      pi_len[CSA_BATCH_MAX];
+
+    for( int l = 0; l < i_count; l++ )
+    {
+        const int i_hdr = csa_PayloadOffset( pp_pkts[l] );
+
+        /* clear transport scrambling control */
+        pp_pkts[l][3] &= 0x3f;
+        pp_data[l] = &pp_pkts[l][i_hdr];
+        pi_len[l] = i_pkt_size - i_hdr;
+    }
+
+    csa_BsStreamCypher( ck, pp_data, pi_len, i_count );
+
+    for( int l = 0; l < i_count; l++ )
+    {
+        uint8_t *p = pp_data[l];
+        const int n = pi_len[l] / 8;
+        uint8_t ib[8], block[8];
+
+        memcpy( ib, p, 8 );
+        for( int i = 1; i < n + 1; i++ )
+        {
+            csa_BlockDecypher( kk, ib, block );
+            if( i != n )
+                memcpy( ib, &p[8*i], 8 );
+            else
+                memset( ib, 0, 8 );
+            for( int j = 0; j < 8; j++ )
+                p[8*(i-1)+j] = ib[j] ^ block[j];
+        }
+    }
+}
+
+/*****************************************************************************
+ * csa_DecryptBatch:
+ *****************************************************************************/
+void csa_DecryptBatch( csa_t *c, uint8_t *const *pp_pkts, int i_count,
+                       int i_pkt_size )
+{
+    uint8_t *pp_lanes[2][CSA_BATCH_MAX];
+    int      pi_lanes[2] = { 0, 0 };
+
+    for( int i = 0; i < i_count; i++ )
+    {
+        uint8_t *pkt = pp_pkts[i];
+
+        /* not scrambled */
+        if( (pkt[3]&0x80) == 0 )
+            continue;
+
+        const int i_hdr = csa_PayloadOffset( pkt );
+        if( i_count < CSA_BATCH_MIN || i_pkt_size - i_hdr < 8 ||
+            188 - i_hdr < 8 )
+        {
+            /* Corner cases are left to the reference code */
+            csa_Decrypt( c, pkt, i_pkt_size );
+            continue;
+        }
+
+        const bool odd = pkt[3]&0x40;
+        pp_lanes[odd][pi_lanes[odd]++] = pkt;
+        if( pi_lanes[odd] == CSA_BATCH_MAX )
+        {
+            csa_DecryptLanes( c, pp_lanes[odd], CSA_BATCH_MAX, i_pkt_size, odd );
+            pi_lanes[odd] = 0;
+        }
+    }
+
+    for( int odd = 0; odd < 2; odd++ )
+    {
+        if( pi_lanes[odd] >= CSA_BATCH_MIN )
+            csa_DecryptLanes( c, pp_lanes[odd], pi_lanes[odd], i_pkt_size, odd );
+        else
+            for( int l = 0; l < pi_lanes[odd]; l++ )
+                csa_Decrypt( c, pp_lanes[odd][l], i_pkt_size );
+    }
+}
+
+/*****************************************************************************
+ * csa_EncryptBatch:
+ *****************************************************************************/
+void csa_EncryptBatch( csa_t *c, uint8_t *const *pp_pkts, int i_count,
+                       int i_pkt_size )
+{
+    uint8_t *ck = c->use_odd ? c->o_ck : c->e_ck;
+    uint8_t *kk = c->use_odd ? c->o_kk : c->e_kk;
+
+    if( i_count < CSA_BATCH_MIN )
+    {
+        for( int i = 0; i < i_count; i++ )
+            csa_Encrypt( c, pp_pkts[i], i_pkt_size );
+        return;
+    }
+
+    while( i_count > 0 )
+    {
+        uint8_t *pp_data[CSA_BATCH_MAX];
+        int      pi_len[CSA_BATCH_MAX];
+        int      i_lanes = 0;
+        const int i_batch = __MIN( i_count, CSA_BATCH_MAX );
+
+        for( int i = 0; i < i_batch; i++ )
+        {
+            uint8_t *pkt = pp_pkts[i];
+            const int i_hdr = csa_PayloadOffset( pkt );
+            const int n = (i_pkt_size - i_hdr) / 8;
+
+            if( n <= 0 )
+            {
+                pkt[3] &= 0x3f; /* left clear */
+                continue;
+            }
+
+            /* set transport scrambling control */
+            pkt[3] |= c->use_odd ? 0xc0 : 0x80;
+
+            /* block cypher, last block first, in place */
+            uint8_t *p = &pkt[i_hdr];
+            for( int j = n; j > 0; j-- )
+            {
+                uint8_t block[8];
+                for( int k = 0; k < 8; k++ )
+                    block[k] = p[8*(j-1)+k] ^ ( j < n ? p[8*j+k] : 0 );
+                csa_BlockCypher( kk, block, &p[8*(j-1)] );
+            }
+
+            pp_data[i_lanes] = p;
+            pi_len[i_lanes] = i_pkt_size - i_hdr;
+            i_lanes++;
+        }
+
+        csa_BsStreamCypher( ck, pp_data, pi_len, i_lanes );
+
+        pp_pkts += i_batch;
+        i_count -= i_batch;
+    }
+}
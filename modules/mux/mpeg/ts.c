@@ -38,6 +38,7 @@
 #include <vlc_sout.h>
 #include <vlc_block.h>
 #include <vlc_rand.h>
+#include <vlc_atomic.h>
 #include <vlc_charset.h>
 
 #include <vlc_iso_lang.h>
@@ -159,6 +160,11 @@ static const char *const ts_standards_list_text[] =
 #define BMAX_TEXT N_( "Maximum B (deprecated)")
 #define BMAX_LONGTEXT N_( "This setting is deprecated and not used anymore")
 
+#define MUXRATE_TEXT N_("Constant mux rate (bits/s)")
+#define MUXRATE_LONGTEXT N_("Stuff the stream with null packets up to this " \
+  "constant bitrate, as required by most modulators and IPTV headends. " \
+  "Each shaping period must fit in it. Set to 0 for variable bitrate.")
+
 #define DTS_TEXT N_("DTS delay (ms)")
 #define DTS_LONGTEXT N_("Delay the DTS (decoding time " \
   "stamps) and PTS (presentation timestamps) of the data in the " \
@@ -196,6 +202,9 @@ static const char *const ts_standards_list_text[] =
 
 #define BLOCK_FLAG_NO_KEYFRAME (1 << BLOCK_FLAG_PRIVATE_SHIFT) /* This is not a key frame for bitrate shaping */
 
+#define TS_SLAB_PACKETS 64 /* TS packets allocated at once */
+#define TS_WRITE_PACKETS 7 /* TS packets per output block, fits UDP MTUs */
+
 vlc_module_begin ()
     set_description( N_("TS muxer (libdvbpsi)") )
     set_shortname( "MPEG-TS")
@@ -228,6 +237,7 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "pcr", 70, PCR_TEXT, PCR_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "bmin", 0, BMIN_TEXT, BMIN_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "bmax", 0, BMAX_TEXT, BMAX_LONGTEXT, true)
+    add_integer( SOUT_CFG_PREFIX "muxrate", 0, MUXRATE_TEXT, MUXRATE_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "dts-delay", 400, DTS_TEXT, DTS_LONGTEXT, true)
 
     add_bool( SOUT_CFG_PREFIX "crypt-audio", true, ACRYPT_TEXT, ACRYPT_LONGTEXT, true)
@@ -247,7 +257,7 @@ static const char *const ppsz_sout_options[] = {
     "standard",
     "pid-video", "pid-audio", "pid-spu", "pid-pmt", "tsid",
     "netid", "sdtdesc",
-    "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
+    "es-id-pid", "shaping", "pcr", "bmin", "bmax", "muxrate", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
     "muxpmt", "program-pmt", "alignment",
     NULL
@@ -340,10 +350,30 @@ typedef struct
     pes_state_t  state;
 } sout_input_sys_t;
 
+/* TS packets are carved out of slabs, so that consecutive packets lie
+ * contiguously in memory and can be written out as a single block. */
+typedef struct ts_slab_t ts_slab_t;
+
+struct ts_packet
+{
+    block_t     self;
+    ts_slab_t  *p_slab;
+};
+
+struct ts_slab_t
+{
+    vlc_atomic_rc_t  rc;
+    unsigned         i_next;
+    struct ts_packet packets[TS_SLAB_PACKETS];
+    uint8_t          data[TS_SLAB_PACKETS][188];
+};
+
 typedef struct
 {
     sout_input_t    *p_pcr_input;
 
+    ts_slab_t       *p_slab; /* current packets allocator */
+
     vlc_mutex_t     csa_lock;
 
     dvbpsi_t        *p_dvbpsi;
@@ -381,6 +411,16 @@ typedef struct
 
     vlc_tick_t      i_pcr;  /* last PCR emited */
 
+    /* constant bitrate mode */
+    struct
+    {
+        int64_t     i_rate; /* bits/s, 0 if disabled */
+        int64_t     i_credit; /* packets owed, in 1/(188*8*CLOCK_FREQ) units */
+        uint64_t    i_stuffed;
+        unsigned    i_overflows; /* shaping periods over the mux rate */
+        unsigned    i_late; /* packets received after their DTS */
+    } cbr;
+
     csa_t           *csa;
     int             i_csa_pkt_size;
     bool            b_crypt_audio;
@@ -483,6 +523,67 @@ static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream, bool b_pcr );
 static void TSSetPCR( block_t *p_ts, vlc_tick_t i_dts );
 
+static void TSSlabRelease( ts_slab_t *p_slab )
+{
+    if( vlc_atomic_rc_dec( &p_slab->rc ) )
+        free( p_slab );
+}
+
+static void TSPacketRelease( block_t *p_block )
+{
+    struct ts_packet *p_pkt = container_of( p_block, struct ts_packet, self );
+    TSSlabRelease( p_pkt->p_slab );
+}
+
+static const struct vlc_block_callbacks ts_packet_cbs =
+{
+    TSPacketRelease,
+};
+
+static block_t *TSPacketAlloc( sout_mux_sys_t *p_sys )
+{
+    ts_slab_t *p_slab = p_sys->p_slab;
+
+    if( p_slab == NULL || p_slab->i_next == TS_SLAB_PACKETS )
+    {
+        if( p_slab )
+            TSSlabRelease( p_slab );
+        p_slab = p_sys->p_slab = malloc( sizeof(*p_slab) );
+        if( unlikely(p_slab == NULL) )
+            return NULL;
+        vlc_atomic_rc_init( &p_slab->rc );
+        p_slab->i_next = 0;
+    }
+
+    struct ts_packet *p_pkt = &p_slab->packets[p_slab->i_next];
+    block_Init( &p_pkt->self, &ts_packet_cbs,
+                p_slab->data[p_slab->i_next], 188 );
+    p_pkt->p_slab = p_slab;
+    p_slab->i_next++;
+    vlc_atomic_rc_inc( &p_slab->rc );
+    return &p_pkt->self;
+}
+
+/* Merges p_next into p_ts if they are adjacent packets of the same slab.
+ * Headers must start a block, and a block carries at most one PCR. */
+static bool TSPacketMerge( block_t *p_ts, block_t *p_next )
+{
+    if( p_ts->cbs != &ts_packet_cbs || p_next->cbs != &ts_packet_cbs ||
+        p_ts->i_buffer >= TS_WRITE_PACKETS * 188 ||
+        (p_next->i_flags & BLOCK_FLAG_HEADER) ||
+        (p_ts->i_flags & p_next->i_flags & BLOCK_FLAG_CLOCK) ||
+        p_ts->p_buffer + p_ts->i_buffer != p_next->p_buffer ||
+        container_of( p_ts, struct ts_packet, self )->p_slab !=
+        container_of( p_next, struct ts_packet, self )->p_slab )
+        return false;
+
+    p_ts->i_buffer += p_next->i_buffer;
+    p_ts->i_length += p_next->i_length;
+    p_ts->i_flags |= p_next->i_flags & (BLOCK_FLAG_CLOCK | BLOCK_FLAG_TYPE_I);
+    block_Release( p_next );
+    return true;
+}
+
 static csa_t *csaSetup( vlc_object_t *p_this )
 {
     sout_mux_t *p_mux = (sout_mux_t*)p_this;
@@ -735,6 +836,10 @@ static int Open( vlc_object_t *p_this )
     var_Get( p_mux, SOUT_CFG_PREFIX "dts-delay", &val );
     p_sys->i_dts_delay = VLC_TICK_FROM_MS(val.i_int);
 
+    p_sys->cbr.i_rate = var_GetInteger( p_mux, SOUT_CFG_PREFIX "muxrate" );
+    if( p_sys->cbr.i_rate > 0 )
+        msg_Dbg( p_mux, "constant mux rate %"PRId64" bits/s", p_sys->cbr.i_rate );
+
     msg_Dbg( p_mux, "shaping=%"PRId64" pcr=%"PRId64" dts_delay=%"PRId64,
              p_sys->i_shaping_delay, p_sys->i_pcr_delay, p_sys->i_dts_delay );
 
@@ -763,6 +868,18 @@ static void Close( vlc_object_t * p_this )
     if( p_sys->p_dvbpsi )
         dvbpsi_delete( p_sys->p_dvbpsi );
 
+    if( p_sys->p_slab )
+        TSSlabRelease( p_sys->p_slab );
+
+    if( p_sys->cbr.i_rate > 0 )
+    {
+        msg_Dbg( p_mux, "%"PRIu64" null packets stuffed", p_sys->cbr.i_stuffed );
+        if( p_sys->cbr.i_overflows || p_sys->cbr.i_late )
+            msg_Warn( p_mux, "mux rate exceeded %u times, %u packets "
+                      "delivered after their DTS", p_sys->cbr.i_overflows,
+                      p_sys->cbr.i_late );
+    }
+
     if( p_sys->csa )
     {
         var_DelCallback( p_mux, SOUT_CFG_PREFIX "csa-ck", ChangeKeyCallback, p_mux );
@@ -1543,6 +1660,8 @@ static bool MuxStreams(sout_mux_t *p_mux )
 
         /* Build the TS packet */
         block_t *p_ts = TSNew( p_mux, p_stream, b_pcr );
+        if( unlikely(p_ts == NULL) )
+            break;
         if( p_sys->csa != NULL &&
              (p_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio) &&
              (p_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video) )
@@ -1711,6 +1830,72 @@ static block_t *Add_ADTS( block_t *p_data, const es_format_t *p_fmt )
     return p_new_block;
 }
 
+static block_t *TSNull( sout_mux_sys_t *p_sys )
+{
+    block_t *p_ts = TSPacketAlloc( p_sys );
+    if( likely(p_ts) )
+    {
+        p_ts->p_buffer[0] = 0x47;
+        p_ts->p_buffer[1] = 0x1f;
+        p_ts->p_buffer[2] = 0xff;
+        p_ts->p_buffer[3] = 0x10;
+        memset( &p_ts->p_buffer[4], 0xff, 184 );
+        p_ts->i_dts = 0;
+    }
+    return p_ts;
+}
+
+/* Interleaves null packets evenly, so that the shaping period carries
+ * exactly its share of the mux rate. Excess data is paid back by the
+ * following periods. */
+static void TSStuff( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+                     vlc_tick_t i_pcr_length )
+{
+    sout_mux_sys_t  *p_sys = p_mux->p_sys;
+    const int64_t i_unit = INT64_C(188) * 8 * CLOCK_FREQ;
+    const int i_data = p_chain_ts->i_depth;
+
+    p_sys->cbr.i_credit += p_sys->cbr.i_rate * i_pcr_length;
+
+    int64_t i_due = p_sys->cbr.i_credit / i_unit;
+    if( i_due < i_data )
+    {
+        p_sys->cbr.i_overflows++;
+        msg_Warn( p_mux, "mux rate exceeded by %"PRId64" packets",
+                  i_data - i_due );
+        i_due = i_data;
+    }
+    p_sys->cbr.i_credit -= i_due * i_unit;
+
+    if( i_due == i_data )
+        return;
+
+    sout_buffer_chain_t new_chain;
+    BufferChainInit( &new_chain );
+
+    /* Bresenham: the k-th slot carries data whenever k * data / due
+     * reaches the next integer */
+    int i_sent = 0;
+    for( int64_t k = 1; k <= i_due; k++ )
+    {
+        block_t *p_ts;
+        if( i_sent < k * i_data / i_due )
+        {
+            p_ts = BufferChainGet( p_chain_ts );
+            i_sent++;
+        }
+        else
+        {
+            p_ts = TSNull( p_sys );
+            if( unlikely(p_ts == NULL) )
+                continue;
+            p_sys->cbr.i_stuffed++;
+        }
+        BufferChainAppend( &new_chain, p_ts );
+    }
+    *p_chain_ts = new_chain;
+}
+
 static void TSSchedule( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                         vlc_tick_t i_pcr_length, vlc_tick_t i_pcr_dts )
 {
@@ -1718,6 +1903,15 @@ static void TSSchedule( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     sout_buffer_chain_t new_chain;
     int i_packet_count = p_chain_ts->i_depth;
 
+    /* The rate is fixed: late packets are accounted, not rescheduled */
+    if( p_sys->cbr.i_rate > 0 )
+    {
+        TSStuff( p_mux, p_chain_ts, i_pcr_length );
+        if( p_chain_ts->i_depth )
+            TSDate( p_mux, p_chain_ts, i_pcr_length, i_pcr_dts );
+        return;
+    }
+
     BufferChainInit( &new_chain );
 
     if ( unlikely(i_pcr_length <= 0) )
@@ -1793,37 +1987,64 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     }
 
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
-    for (int i = 0; i < i_packet_count; i++ )
+    for (int i = 0; i < i_packet_count; )
     {
-        block_t *p_ts = BufferChainGet( p_chain_ts );
-        vlc_tick_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
-
-        p_ts->i_dts    = i_new_dts;
-        p_ts->i_length = i_pcr_length / i_packet_count;
+        /* Packets are scrambled by batches */
+        block_t *pp_ts[CSA_BATCH_MAX];
+        uint8_t *pp_scrambled[CSA_BATCH_MAX];
+        int i_batch = __MIN( i_packet_count - i, CSA_BATCH_MAX );
+        int i_scrambled = 0;
 
-        if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
+        for( int j = 0; j < i_batch; j++, i++ )
         {
-            /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
-            TSSetPCR( p_ts, p_ts->i_dts - p_sys->first_dts );
+            block_t *p_ts = BufferChainGet( p_chain_ts );
+            vlc_tick_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
+
+            /* Decoding starts at DTS + dts-delay on the PCR clock */
+            if( p_sys->cbr.i_rate > 0 && p_ts->i_dts &&
+                i_new_dts > p_ts->i_dts + p_sys->i_dts_delay )
+                p_sys->cbr.i_late++;
+
+            p_ts->i_dts    = i_new_dts;
+            p_ts->i_length = i_pcr_length / i_packet_count;
+
+            if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
+            {
+                /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
+                TSSetPCR( p_ts, p_ts->i_dts - p_sys->first_dts );
+            }
+            if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+                pp_scrambled[i_scrambled++] = p_ts->p_buffer;
+
+            /* latency */
+            p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+
+            pp_ts[j] = p_ts;
         }
-        if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+
+        if( i_scrambled > 0 )
         {
             vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
+            csa_EncryptBatch( p_sys->csa, pp_scrambled, i_scrambled,
+                              p_sys->i_csa_pkt_size );
             vlc_mutex_unlock( &p_sys->csa_lock );
         }
 
-        /* latency */
-        p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+        for( int j = 0; j < i_batch; j++ )
+        {
+            block_t *p_ts = pp_ts[j];
 
-        sout_AccessOutWrite( p_mux->p_access, p_ts );
+            while( j + 1 < i_batch && TSPacketMerge( p_ts, pp_ts[j + 1] ) )
+                j++;
+            sout_AccessOutWrite( p_mux->p_access, p_ts );
+        }
     }
 }
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
                        bool b_pcr )
 {
-    VLC_UNUSED(p_mux);
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
     block_t *p_pes = p_stream->state.chain_pes.p_first;
 
     bool b_new_pes = false;
@@ -1843,7 +2064,9 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         b_adaptation_field = true;
     }
 
-    block_t *p_ts = block_Alloc( 188 );
+    block_t *p_ts = TSPacketAlloc( p_sys );
+    if( unlikely(p_ts == NULL) )
+        return NULL;
 
     if (b_new_pes && !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) && p_pes->i_flags & BLOCK_FLAG_TYPE_I)
     {
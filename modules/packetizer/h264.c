@@ -896,7 +896,7 @@ static block_t *OutputPicture( decoder_t *p_dec )
     p_sys->leading.p_head = NULL;
     p_sys->leading.pp_append = &p_sys->leading.p_head;
 
-    p_pic = block_ChainGather( p_pic );
+    p_pic = block_ChainGatherPadded( p_pic, PACKETIZER_GATHER_PADDING );
 
     if( !p_pic )
     {
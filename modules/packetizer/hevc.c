@@ -868,7 +868,8 @@ static block_t *GatherAndValidateChain(block_t *p_outputchain)
         if(p_outputchain->i_flags & BLOCK_FLAG_DROP)
             p_output = p_outputchain; /* Avoid useless gather */
         else
-            p_output = block_ChainGather(p_outputchain);
+            p_output = block_ChainGatherPadded(p_outputchain,
+                                               PACKETIZER_GATHER_PADDING);
     }
 
     if(p_output && (p_output->i_flags & BLOCK_FLAG_DROP))
@@ -20,10 +20,38 @@
  *****************************************************************************/
 #include <vlc_bits.h>
 
+/* Returns how many of the i_max bytes at p can't be part of an emulation
+ * prevention sequence, looking for zero bytes 8 at once */
+static inline size_t hxxx_ep3b_skip( const uint8_t *p, size_t i_max )
+{
+    size_t i = 0;
+    for( ; i + 8 <= i_max; i += 8 )
+    {
+        uint64_t x;
+        memcpy( &x, &p[i], 8 );
+        if( (x - UINT64_C(0x0101010101010101)) & ~x & UINT64_C(0x8080808080808080) )
+            break;
+    }
+    return i;
+}
+
 static inline uint8_t *hxxx_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev, size_t i_count )
 {
     for( size_t i=0; i<i_count; i++ )
     {
+        /* No pending zero, forward over the bytes without any */
+        if( !(*pi_prev & 1) && end - p > 1 )
+        {
+            size_t n = hxxx_ep3b_skip( p + 1, __MIN(i_count - i, (size_t)(end - p) - 1) );
+            if( n > 0 )
+            {
+                p += n;
+                i += n - 1;
+                *pi_prev = 0;
+                continue;
+            }
+        }
+
         if( ++p >= end )
             return p;
 
@@ -88,6 +116,17 @@ static size_t hxxx_ep3b_total_size( const uint8_t *p, const uint8_t *p_end )
     size_t i = 0;
     while( p < p_end )
     {
+        if( !(i_prev & 1) && p_end - p > 1 )
+        {
+            size_t i_skip = hxxx_ep3b_skip( p + 1, p_end - p - 1 );
+            if( i_skip > 0 )
+            {
+                p += i_skip;
+                i += i_skip;
+                i_prev = 0;
+                continue;
+            }
+        }
         uint8_t *n = hxxx_ep3b_to_rbsp( (uint8_t *)p, (uint8_t *)p_end, &i_prev, 1 );
         if( n > p )
             ++i;
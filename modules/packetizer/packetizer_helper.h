@@ -25,6 +25,10 @@
 
 #include <vlc_block.h>
 
+/* Room left after the gathered access units, so that decoders needing
+ * input padding (libavcodec) use them in place instead of copying again */
+#define PACKETIZER_GATHER_PADDING 64
+
 enum
 {
     STATE_NOSYNC,
@@ -403,6 +403,13 @@ static void DestroyFilter( vlc_object_t *p_this )
 
     if( !p_sys->b_keep )
     {
+        vlc_global_lock( VLC_MOSAIC_MUTEX );
+        bridge_t *p_bridge = GetBridge( p_filter );
+        if( p_bridge != NULL )
+            for( int i = 0; i < p_bridge->i_es_num; i++ )
+                ReleaseScaled( p_bridge->pp_es[i] );
+        vlc_global_unlock( VLC_MOSAIC_MUTEX );
+
         image_HandlerDelete( p_sys->p_image );
     }
 
@@ -618,15 +625,36 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             fmt_out.i_visible_width = fmt_out.i_width;
             fmt_out.i_visible_height = fmt_out.i_height;
 
-            p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
-                                         &fmt_in, &fmt_out );
-            if( !p_converted )
+            picture_t *p_scaled = p_es->p_scaled;
+            if( p_scaled != NULL && p_es->p_scaled_src == p_es->p_picture
+             && p_scaled->format.i_chroma == fmt_out.i_chroma
+             && p_scaled->format.i_width == fmt_out.i_width
+             && p_scaled->format.i_height == fmt_out.i_height )
+            {   /* same picture as at the previous date: already scaled */
+                p_converted = picture_Hold( p_scaled );
+            }
+            else if( fmt_in.i_chroma == fmt_out.i_chroma
+                  && fmt_in.i_width == fmt_out.i_width
+                  && fmt_in.i_height == fmt_out.i_height )
+            {   /* already scaled to the tile size by the bridge */
+                p_converted = picture_Hold( p_es->p_picture );
+            }
+            else
             {
-                msg_Warn( p_filter,
-                           "image resizing and chroma conversion failed" );
-                video_format_Clean( &fmt_in );
-                video_format_Clean( &fmt_out );
-                continue;
+                p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
+                                             &fmt_in, &fmt_out );
+                if( !p_converted )
+                {
+                    msg_Warn( p_filter,
+                               "image resizing and chroma conversion failed" );
+                    video_format_Clean( &fmt_in );
+                    video_format_Clean( &fmt_out );
+                    continue;
+                }
+
+                ReleaseScaled( p_es );
+                p_es->p_scaled = picture_Hold( p_converted );
+                p_es->p_scaled_src = picture_Hold( p_es->p_picture );
             }
         }
         else
@@ -32,6 +32,10 @@ typedef struct bridged_es_t
     int i_alpha;
     int i_x;
     int i_y;
+
+    /* Last picture scaled by the mosaic filter, and its source picture */
+    picture_t *p_scaled;
+    picture_t *p_scaled_src;
 } bridged_es_t;
 
 typedef struct bridge_t
@@ -46,3 +50,14 @@ static bridge_t *GetBridge( vlc_object_t *p_object )
                           "mosaic-struct");
 }
 #define GetBridge(a) GetBridge( VLC_OBJECT(a) )
+
+/* Must be called with VLC_MOSAIC_MUTEX held */
+static inline void ReleaseScaled( bridged_es_t *p_es )
+{
+    if( p_es->p_scaled != NULL )
+    {
+        picture_Release( p_es->p_scaled );
+        picture_Release( p_es->p_scaled_src );
+        p_es->p_scaled = p_es->p_scaled_src = NULL;
+    }
+}
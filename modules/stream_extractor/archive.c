@@ -61,47 +61,93 @@ vlc_module_begin()
 vlc_module_end()
 
 typedef struct libarchive_callback_t libarchive_callback_t;
+typedef struct archive_handle_t archive_handle_t;
 typedef struct private_sys_t private_sys_t;
 typedef struct archive libarchive_t;
 
-struct private_sys_t
+/* Number of libarchive handles kept open on the entry. As libarchive cannot
+ * save nor restore the decompressor state, the handles parked at their last
+ * position act as checkpoints: a seek only decompresses from the closest
+ * handle before the target, instead of from the start of the archive. */
+#define ARCHIVE_MAX_HANDLES 3
+
+struct archive_handle_t
 {
+    private_sys_t* p_sys;
     libarchive_t* p_archive;
-    vlc_object_t* p_obj;
-    stream_t* source;
 
-    struct archive_entry* p_entry;
     bool b_dead;
     bool b_eof;
 
     uint64_t i_offset;
+    uint64_t i_source_pos; /* position of this handle in the mother stream */
+    uint64_t i_last_use;
 
     uint8_t buffer[ 8192 ];
-    bool b_seekable_source;
-    bool b_seekable_archive;
 
     libarchive_callback_t** pp_callback_data;
     size_t i_callback_data;
 };
 
+struct private_sys_t
+{
+    vlc_object_t* p_obj;
+    stream_t* source;
+
+    struct archive_entry* p_entry;
+    bool b_seekable_source;
+    bool b_seekable_archive;
+
+    char** ppsz_volumes;
+    size_t i_volumes;
+
+    archive_handle_t* pp_handles[ ARCHIVE_MAX_HANDLES ];
+    size_t i_handles;
+    archive_handle_t* p_handle; /* the one being read */
+    uint64_t i_use_count;
+};
+
 struct libarchive_callback_t {
-    private_sys_t* p_sys;
+    archive_handle_t* p_handle;
     stream_t* p_source;
     char* psz_url;
 };
 
 /* ------------------------------------------------------------------------- */
 
+/* The mother stream is shared by the handles: each one resumes from its own
+ * position (which is always the current one with a single handle). */
+static int libarchive_source_sync( libarchive_callback_t* p_cb )
+{
+    archive_handle_t* p_handle = p_cb->p_handle;
+
+    if( p_cb->p_source != p_handle->p_sys->source
+     || vlc_stream_Tell( p_cb->p_source ) == p_handle->i_source_pos )
+        return VLC_SUCCESS;
+
+    return vlc_stream_Seek( p_cb->p_source, p_handle->i_source_pos );
+}
+
+static void libarchive_source_save( libarchive_callback_t* p_cb )
+{
+    archive_handle_t* p_handle = p_cb->p_handle;
+
+    if( p_cb->p_source == p_handle->p_sys->source )
+        p_handle->i_source_pos = vlc_stream_Tell( p_cb->p_source );
+}
+
 static int libarchive_exit_cb( libarchive_t* p_arc, void* p_obj )
 {
     VLC_UNUSED( p_arc );
 
     libarchive_callback_t* p_cb = (libarchive_callback_t*)p_obj;
+    archive_handle_t* p_handle = p_cb->p_handle;
 
-    if( p_cb->p_sys->source == p_cb->p_source )
+    if( p_handle->p_sys->source == p_cb->p_source )
     {  /* DO NOT CLOSE OUR MOTHER STREAM */
-        if( !p_cb->p_sys->b_dead && vlc_stream_Seek( p_cb->p_source, 0 ) )
+        if( !p_handle->b_dead && vlc_stream_Seek( p_cb->p_source, 0 ) )
             return ARCHIVE_FATAL;
+        p_handle->i_source_pos = 0;
     }
     else if( p_cb->p_source )
     {
@@ -122,7 +168,7 @@ static int libarchive_jump_cb( libarchive_t* p_arc, void* p_obj_current,
         return ARCHIVE_FATAL;
 
     if( p_next->p_source == NULL )
-        p_next->p_source = vlc_stream_NewURL( p_next->p_sys->p_obj,
+        p_next->p_source = vlc_stream_NewURL( p_next->p_handle->p_sys->p_obj,
                                               p_next->psz_url );
 
     return p_next->p_source ? ARCHIVE_OK : ARCHIVE_FATAL;
@@ -137,19 +183,24 @@ static la_int64_t libarchive_skip_cb( libarchive_t* p_arc, void* p_obj,
     libarchive_callback_t* p_cb = (libarchive_callback_t*)p_obj;
 
     stream_t*  p_source = p_cb->p_source;
-    private_sys_t* p_sys = p_cb->p_sys;
+    private_sys_t* p_sys = p_cb->p_handle->p_sys;
 
     /* TODO: fix b_seekable_source on libarchive_callback_t */
 
+    if( libarchive_source_sync( p_cb ) )
+        return ARCHIVE_FATAL;
+
     if( p_sys->b_seekable_source )
     {
         if( vlc_stream_Seek( p_source, vlc_stream_Tell( p_source ) + i_request ) )
             return ARCHIVE_FATAL;
 
+        libarchive_source_save( p_cb );
         return i_request;
     }
 
     ssize_t i_read = vlc_stream_Read( p_source, NULL, i_request );
+    libarchive_source_save( p_cb );
     return  i_read >= 0 ? i_read : ARCHIVE_FATAL;
 }
 
@@ -163,6 +214,9 @@ static la_int64_t libarchive_seek_cb( libarchive_t* p_arc, void* p_obj,
 
     ssize_t whence_pos;
 
+    if( libarchive_source_sync( p_cb ) )
+        return ARCHIVE_FATAL;
+
     switch( whence )
     {
         case SEEK_SET: whence_pos = 0;                           break;
@@ -175,6 +229,7 @@ static la_int64_t libarchive_seek_cb( libarchive_t* p_arc, void* p_obj,
     if( whence_pos < 0 || vlc_stream_Seek( p_source, whence_pos + offset ) )
         return ARCHIVE_FATAL;
 
+    libarchive_source_save( p_cb );
     return vlc_stream_Tell( p_source );
 }
 
@@ -186,26 +241,36 @@ static la_ssize_t libarchive_read_cb( libarchive_t* p_arc, void* p_obj,
     libarchive_callback_t* p_cb = (libarchive_callback_t*)p_obj;
 
     stream_t*  p_source = p_cb->p_source;
-    private_sys_t* p_sys = p_cb->p_sys;
+    archive_handle_t* p_handle = p_cb->p_handle;
+
+    if( libarchive_source_sync( p_cb ) )
+    {
+        archive_set_error( p_handle->p_archive, ARCHIVE_FATAL,
+          "libarchive_read_cb failed to resume from %"PRIu64,
+          p_handle->i_source_pos );
 
-    ssize_t i_ret = vlc_stream_Read( p_source, &p_sys->buffer,
-      sizeof( p_sys->buffer ) );
+        return ARCHIVE_FATAL;
+    }
+
+    ssize_t i_ret = vlc_stream_Read( p_source, &p_handle->buffer,
+      sizeof( p_handle->buffer ) );
 
     if( i_ret < 0 )
     {
-        archive_set_error( p_sys->p_archive, ARCHIVE_FATAL,
+        archive_set_error( p_handle->p_archive, ARCHIVE_FATAL,
           "libarchive_read_cb failed = %zd", i_ret );
 
         return ARCHIVE_FATAL;
     }
 
-    *pp_dst = &p_sys->buffer;
+    libarchive_source_save( p_cb );
+    *pp_dst = &p_handle->buffer;
     return i_ret;
 }
 
 /* ------------------------------------------------------------------------- */
 
-static int archive_push_resource( private_sys_t* p_sys,
+static int archive_push_resource( archive_handle_t* p_handle,
   stream_t* p_source, char const* psz_url )
 {
     libarchive_callback_t** pp_callback_data;
@@ -213,12 +278,14 @@ static int archive_push_resource( private_sys_t* p_sys,
 
     /* INCREASE BUFFER SIZE */
 
-    pp_callback_data = realloc( p_sys->pp_callback_data,
-      sizeof( *p_sys->pp_callback_data ) * ( p_sys->i_callback_data + 1 ) );
+    pp_callback_data = realloc( p_handle->pp_callback_data,
+      sizeof( *p_handle->pp_callback_data ) * ( p_handle->i_callback_data + 1 ) );
 
     if( unlikely( !pp_callback_data ) )
         goto error;
 
+    p_handle->pp_callback_data = pp_callback_data;
+
     /* CREATE NEW NODE */
 
     p_callback_data = malloc( sizeof( *p_callback_data ) );
@@ -230,7 +297,7 @@ static int archive_push_resource( private_sys_t* p_sys,
 
     p_callback_data->psz_url  = psz_url ? strdup( psz_url ) : NULL;
     p_callback_data->p_source = p_source;
-    p_callback_data->p_sys    = p_sys;
+    p_callback_data->p_handle = p_handle;
 
     if( unlikely( !p_callback_data->psz_url && psz_url ) )
     {
@@ -238,23 +305,23 @@ static int archive_push_resource( private_sys_t* p_sys,
         goto error;
     }
 
-    pp_callback_data[ p_sys->i_callback_data++ ] = p_callback_data;
-    p_sys->pp_callback_data = pp_callback_data;
+    pp_callback_data[ p_handle->i_callback_data++ ] = p_callback_data;
 
     return VLC_SUCCESS;
 
 error:
-    free( pp_callback_data );
     return VLC_ENOMEM;
 }
 
-static int archive_init( private_sys_t* p_sys, stream_t* source )
+static int archive_init( archive_handle_t* p_handle )
 {
+    private_sys_t* p_sys = p_handle->p_sys;
+
     /* CREATE ARCHIVE HANDLE */
 
-    p_sys->p_archive = archive_read_new();
+    p_handle->p_archive = archive_read_new();
 
-    if( unlikely( !p_sys->p_archive ) )
+    if( unlikely( !p_handle->p_archive ) )
     {
         msg_Dbg( p_sys->p_obj, "unable to create libarchive handle" );
         return VLC_EGENERIC;
@@ -262,18 +329,9 @@ static int archive_init( private_sys_t* p_sys, stream_t* source )
 
     /* SETUP SEEKING */
 
-    p_sys->b_seekable_archive = false;
-
-    if( vlc_stream_Control( source, STREAM_CAN_SEEK,
-        &p_sys->b_seekable_source ) )
-    {
-        msg_Warn( p_sys->p_obj, "unable to query whether source stream can seek" );
-        p_sys->b_seekable_source = false;
-    }
-
     if( p_sys->b_seekable_source )
     {
-        if( archive_read_set_seek_callback( p_sys->p_archive,
+        if( archive_read_set_seek_callback( p_handle->p_archive,
             libarchive_seek_cb ) )
         {
             msg_Err( p_sys->p_obj, "archive_read_set_callback failed, aborting." );
@@ -283,22 +341,22 @@ static int archive_init( private_sys_t* p_sys, stream_t* source )
 
     /* ENABLE ALL FORMATS/FILTERS */
 
-    archive_read_support_filter_all( p_sys->p_archive );
-    archive_read_support_format_all( p_sys->p_archive );
+    archive_read_support_filter_all( p_handle->p_archive );
+    archive_read_support_format_all( p_handle->p_archive );
 
     /* REGISTER CALLBACK DATA */
 
-    if( archive_read_set_switch_callback( p_sys->p_archive,
+    if( archive_read_set_switch_callback( p_handle->p_archive,
         libarchive_jump_cb ) )
     {
         msg_Err( p_sys->p_obj, "archive_read_set_switch_callback failed, aborting." );
         return VLC_EGENERIC;
     }
 
-    for( size_t i = 0; i < p_sys->i_callback_data; ++i )
+    for( size_t i = 0; i < p_handle->i_callback_data; ++i )
     {
-        if( archive_read_append_callback_data( p_sys->p_archive,
-            p_sys->pp_callback_data[i] ) )
+        if( archive_read_append_callback_data( p_handle->p_archive,
+            p_handle->pp_callback_data[i] ) )
         {
             return VLC_EGENERIC;
         }
@@ -306,11 +364,11 @@ static int archive_init( private_sys_t* p_sys, stream_t* source )
 
     /* OPEN THE ARCHIVE */
 
-    if( archive_read_open2( p_sys->p_archive, p_sys->pp_callback_data[0], NULL,
-        libarchive_read_cb, libarchive_skip_cb, libarchive_exit_cb ) )
+    if( archive_read_open2( p_handle->p_archive, p_handle->pp_callback_data[0],
+        NULL, libarchive_read_cb, libarchive_skip_cb, libarchive_exit_cb ) )
     {
         msg_Dbg( p_sys->p_obj, "libarchive: %s",
-          archive_error_string( p_sys->p_archive ) );
+          archive_error_string( p_handle->p_archive ) );
 
         return VLC_EGENERIC;
     }
@@ -318,25 +376,56 @@ static int archive_init( private_sys_t* p_sys, stream_t* source )
     return VLC_SUCCESS;
 }
 
-static int archive_clean( private_sys_t* p_sys )
+static void archive_handle_Delete( archive_handle_t* p_handle )
 {
-    libarchive_t* p_arc = p_sys->p_archive;
+    p_handle->b_dead = true;
 
-    if( p_sys->p_entry )
-        archive_entry_free( p_sys->p_entry );
+    if( p_handle->p_archive )
+        archive_read_free( p_handle->p_archive );
+
+    for( size_t i = 0; i < p_handle->i_callback_data; ++i )
+    {
+        free( p_handle->pp_callback_data[i]->psz_url );
+        free( p_handle->pp_callback_data[i] );
+    }
 
-    if( p_arc )
-        archive_read_free( p_arc );
+    free( p_handle->pp_callback_data );
+    free( p_handle );
+}
 
-    p_sys->p_entry   = NULL;
-    p_sys->p_archive = NULL;
+static archive_handle_t* archive_handle_New( private_sys_t* p_sys )
+{
+    archive_handle_t* p_handle = calloc( 1, sizeof( *p_handle ) );
 
-    return VLC_SUCCESS;
+    if( unlikely( !p_handle ) )
+        return NULL;
+
+    p_handle->p_sys = p_sys;
+    p_handle->i_source_pos = vlc_stream_Tell( p_sys->source );
+
+    if( archive_push_resource( p_handle, p_sys->source, NULL ) )
+        goto error;
+
+    for( size_t i = 0; i < p_sys->i_volumes; ++i )
+    {
+        if( archive_push_resource( p_handle, NULL, p_sys->ppsz_volumes[i] ) )
+            goto error;
+    }
+
+    if( archive_init( p_handle ) )
+        goto error;
+
+    return p_handle;
+
+error:
+    archive_handle_Delete( p_handle );
+    return NULL;
 }
 
-static int archive_seek_subentry( private_sys_t* p_sys, char const* psz_subentry )
+static int archive_seek_subentry( archive_handle_t* p_handle, char const* psz_subentry )
 {
-    libarchive_t* p_arc = p_sys->p_archive;
+    private_sys_t* p_sys = p_handle->p_sys;
+    libarchive_t* p_arc = p_handle->p_archive;
 
     struct archive_entry* entry;
     int archive_status;
@@ -347,10 +436,13 @@ static int archive_seek_subentry( private_sys_t* p_sys, char const* psz_subentry
 
         if( strcmp( entry_path, psz_subentry ) == 0 )
         {
-            p_sys->p_entry = archive_entry_clone( entry );
+            if( p_sys->p_entry == NULL )
+            {
+                p_sys->p_entry = archive_entry_clone( entry );
 
-            if( unlikely( !p_sys->p_entry ) )
-                return VLC_ENOMEM;
+                if( unlikely( !p_sys->p_entry ) )
+                    return VLC_ENOMEM;
+            }
 
             break;
         }
@@ -377,30 +469,52 @@ static int archive_seek_subentry( private_sys_t* p_sys, char const* psz_subentry
 
     if( p_sys->b_seekable_source )
     {
-        if( archive_seek_data( p_sys->p_archive, 0, SEEK_CUR ) >= 0 )
+        if( archive_seek_data( p_arc, 0, SEEK_CUR ) >= 0 )
             p_sys->b_seekable_archive = true;
     }
 
     return VLC_SUCCESS;
 }
 
-static int archive_extractor_reset( stream_extractor_t* p_extractor )
+/* Opens one more handle at the start of the entry, in place of the least
+ * recently used one if there are too many. */
+static archive_handle_t* archive_extractor_reset( stream_extractor_t* p_extractor )
 {
     private_sys_t* p_sys = p_extractor->p_sys;
+    archive_handle_t* p_handle;
 
-    if( vlc_stream_Seek( p_extractor->source, 0 )
-        || archive_clean( p_sys )
-        || archive_init( p_sys, p_extractor->source )
-        || archive_seek_subentry( p_sys, p_extractor->identifier ) )
+    if( vlc_stream_Seek( p_extractor->source, 0 ) )
+        return NULL;
+
+    if( p_sys->i_handles == ARCHIVE_MAX_HANDLES )
     {
-        p_sys->b_dead = true;
-        return VLC_EGENERIC;
+        size_t i_lru = 0;
+
+        for( size_t i = 1; i < p_sys->i_handles; ++i )
+            if( p_sys->pp_handles[i]->i_last_use <
+                p_sys->pp_handles[i_lru]->i_last_use )
+                i_lru = i;
+
+        if( p_sys->pp_handles[i_lru] == p_sys->p_handle )
+            p_sys->p_handle = NULL;
+
+        archive_handle_Delete( p_sys->pp_handles[i_lru] );
+        p_sys->pp_handles[i_lru] = p_sys->pp_handles[--p_sys->i_handles];
     }
 
-    p_sys->i_offset = 0;
-    p_sys->b_eof = false;
-    p_sys->b_dead = false;
-    return VLC_SUCCESS;
+    p_handle = archive_handle_New( p_sys );
+
+    if( p_handle == NULL )
+        return NULL;
+
+    if( archive_seek_subentry( p_handle, p_extractor->identifier ) )
+    {
+        archive_handle_Delete( p_handle );
+        return NULL;
+    }
+
+    p_sys->pp_handles[ p_sys->i_handles++ ] = p_handle;
+    return p_handle;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -413,9 +527,6 @@ static private_sys_t* setup( vlc_object_t* obj, stream_t* source )
     if( unlikely( !p_sys ) )
         goto error;
 
-    if( archive_push_resource( p_sys, source, NULL ) )
-        goto error;
-
     if( psz_files )
     {
         for( char* state,
@@ -425,8 +536,19 @@ static private_sys_t* setup( vlc_object_t* obj, stream_t* source )
             if( path == psz_files )
                 continue;
 
-            if( archive_push_resource( p_sys, NULL, path ) )
+            char** ppsz_volumes = realloc( p_sys->ppsz_volumes,
+              sizeof( *ppsz_volumes ) * ( p_sys->i_volumes + 1 ) );
+
+            if( unlikely( !ppsz_volumes ) )
+                goto error;
+
+            p_sys->ppsz_volumes = ppsz_volumes;
+            p_sys->ppsz_volumes[ p_sys->i_volumes ] = strdup( path );
+
+            if( unlikely( !p_sys->ppsz_volumes[ p_sys->i_volumes ] ) )
                 goto error;
+
+            p_sys->i_volumes++;
         }
 
         free( psz_files );
@@ -435,10 +557,23 @@ static private_sys_t* setup( vlc_object_t* obj, stream_t* source )
     p_sys->source = source;
     p_sys->p_obj = obj;
 
+    if( vlc_stream_Control( source, STREAM_CAN_SEEK,
+        &p_sys->b_seekable_source ) )
+    {
+        msg_Warn( obj, "unable to query whether source stream can seek" );
+        p_sys->b_seekable_source = false;
+    }
+
     return p_sys;
 
 error:
     free( psz_files );
+    if( p_sys )
+    {
+        for( size_t i = 0; i < p_sys->i_volumes; ++i )
+            free( p_sys->ppsz_volumes[i] );
+        free( p_sys->ppsz_volumes );
+    }
     free( p_sys );
     return NULL;
 }
@@ -525,7 +660,7 @@ static int Control( stream_extractor_t* p_extractor, int i_query, va_list args )
 static int ReadDir( stream_directory_t* p_directory, input_item_node_t* p_node )
 {
     private_sys_t* p_sys = p_directory->p_sys;
-    libarchive_t* p_arc = p_sys->p_archive;
+    libarchive_t* p_arc = p_sys->p_handle->p_archive;
 
     struct vlc_readdir_helper rdh;
     vlc_readdir_helper_init( &rdh, p_directory, p_node);
@@ -568,13 +703,15 @@ static ssize_t Read( stream_extractor_t *p_extractor, void* p_data, size_t i_siz
     char dummy_buffer[ 8192 ];
 
     private_sys_t* p_sys = p_extractor->p_sys;
-    libarchive_t* p_arc = p_sys->p_archive;
+    archive_handle_t* p_handle = p_sys->p_handle;
     ssize_t       i_ret;
 
-    if( p_sys->b_dead || p_sys->p_entry == NULL )
+    if( p_handle == NULL || p_sys->p_entry == NULL )
         return 0;
 
-    if( p_sys->b_eof )
+    libarchive_t* p_arc = p_handle->p_archive;
+
+    if( p_handle->b_dead || p_handle->b_eof )
         return 0;
 
     i_ret = archive_read_data( p_arc,
@@ -597,14 +734,14 @@ static ssize_t Read( stream_extractor_t *p_extractor, void* p_data, size_t i_siz
             goto fatal_error;
     }
 
-    p_sys->i_offset += i_ret;
+    p_handle->i_offset += i_ret;
     return i_ret;
 
 fatal_error:
-    p_sys->b_dead = true;
+    p_handle->b_dead = true;
 
 eof:
-    p_sys->b_eof = true;
+    p_handle->b_eof = true;
     return 0;
 }
 
@@ -626,6 +763,7 @@ static int archive_skip_decompressed( stream_extractor_t* p_extractor, uint64_t
 static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
 {
     private_sys_t* p_sys = p_extractor->p_sys;
+    archive_handle_t* p_handle = p_sys->p_handle;
 
     if( !p_sys->p_entry || !p_sys->b_seekable_source )
         return VLC_EGENERIC;
@@ -633,55 +771,78 @@ static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
     if( archive_entry_size_is_set( p_sys->p_entry ) &&
         (uint64_t)archive_entry_size( p_sys->p_entry ) <= i_req )
     {
-        p_sys->b_eof = true;
+        if( p_handle != NULL )
+            p_handle->b_eof = true;
         return VLC_SUCCESS;
     }
 
-    p_sys->b_eof = false;
-
-    if( !p_sys->b_seekable_archive || p_sys->b_dead
-      || archive_seek_data( p_sys->p_archive, i_req, SEEK_SET ) < 0 )
+    if( p_handle != NULL && p_sys->b_seekable_archive && !p_handle->b_dead
+      && archive_seek_data( p_handle->p_archive, i_req, SEEK_SET ) >= 0 )
     {
+        p_handle->b_eof = false;
+        p_handle->i_offset = i_req;
+        return VLC_SUCCESS;
+    }
+
+    if( p_handle != NULL )
         msg_Dbg( p_extractor,
             "intrinsic seek failed: '%s' (falling back to dumb seek)",
-            archive_error_string( p_sys->p_archive ) );
+            archive_error_string( p_handle->p_archive ) );
 
-        uint64_t i_skip = i_req - p_sys->i_offset;
+    /* RESUME FROM THE CLOSEST HANDLE BEFORE THE TARGET */
 
-        /* RECREATE LIBARCHIVE HANDLE IF WE ARE SEEKING BACKWARDS */
+    p_handle = NULL;
 
-        if( i_req < p_sys->i_offset )
-        {
-            if( archive_extractor_reset( p_extractor ) )
-            {
-                msg_Err( p_extractor, "unable to reset libarchive handle" );
-                return VLC_EGENERIC;
-            }
+    for( size_t i = 0; i < p_sys->i_handles; ++i )
+    {
+        archive_handle_t* p_cur = p_sys->pp_handles[i];
 
-            i_skip = i_req;
-        }
+        if( !p_cur->b_dead && p_cur->i_offset <= i_req &&
+            ( p_handle == NULL || p_cur->i_offset > p_handle->i_offset ) )
+            p_handle = p_cur;
+    }
+
+    /* OR OPEN A NEW ONE, THE OTHERS ARE KEPT AS CHECKPOINTS */
+
+    if( p_handle == NULL )
+    {
+        p_handle = archive_extractor_reset( p_extractor );
 
-        if( archive_skip_decompressed( p_extractor, i_skip ) )
-            msg_Dbg( p_extractor, "failed to skip to seek position" );
+        if( p_handle == NULL )
+        {
+            msg_Err( p_extractor, "unable to reset libarchive handle" );
+            p_sys->p_handle = NULL;
+            return VLC_EGENERIC;
+        }
     }
 
-    p_sys->i_offset = i_req;
+    p_sys->p_handle = p_handle;
+    p_handle->i_last_use = ++p_sys->i_use_count;
+    p_handle->b_eof = false;
+
+    if( archive_skip_decompressed( p_extractor, i_req - p_handle->i_offset ) )
+        msg_Dbg( p_extractor, "failed to skip to seek position" );
+
+    p_handle->i_offset = i_req;
     return VLC_SUCCESS;
 }
 
 
 static void CommonClose( private_sys_t* p_sys )
 {
-    p_sys->b_dead = true;
-    archive_clean( p_sys );
+    for( size_t i = 0; i < p_sys->i_handles; ++i )
+        p_sys->pp_handles[i]->b_dead = true;
 
-    for( size_t i = 0; i < p_sys->i_callback_data; ++i )
-    {
-        free( p_sys->pp_callback_data[i]->psz_url );
-        free( p_sys->pp_callback_data[i] );
-    }
+    for( size_t i = 0; i < p_sys->i_handles; ++i )
+        archive_handle_Delete( p_sys->pp_handles[i] );
+
+    if( p_sys->p_entry )
+        archive_entry_free( p_sys->p_entry );
 
-    free( p_sys->pp_callback_data );
+    for( size_t i = 0; i < p_sys->i_volumes; ++i )
+        free( p_sys->ppsz_volumes[i] );
+
+    free( p_sys->ppsz_volumes );
     free( p_sys );
 }
 
@@ -707,12 +868,15 @@ static private_sys_t* CommonOpen( vlc_object_t* p_obj, stream_t* source  )
     if( p_sys == NULL )
         return NULL;
 
-    if( archive_init( p_sys, source ) )
+    p_sys->p_handle = archive_handle_New( p_sys );
+
+    if( p_sys->p_handle == NULL )
     {
         CommonClose( p_sys );
         return NULL;
     }
 
+    p_sys->pp_handles[ p_sys->i_handles++ ] = p_sys->p_handle;
     return p_sys;
 }
 
@@ -738,7 +902,7 @@ static int ExtractorOpen( vlc_object_t* p_obj )
     if( p_sys == NULL )
         return VLC_EGENERIC;
 
-    if( archive_seek_subentry( p_sys, p_extractor->identifier ) )
+    if( archive_seek_subentry( p_sys->p_handle, p_extractor->identifier ) )
     {
         CommonClose( p_sys );
         return VLC_EGENERIC;
@@ -0,0 +1,578 @@
+/*****************************************************************************
+ * diskcache.c: persistent disk cache for remote files
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_stream.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+
+/*
+ * Each cached file is stored as a sparse data file, written at the same
+ * offsets as the remote file, and a map file listing the byte ranges present
+ * in the data file, along with the remote file size and validator (entity
+ * tag or modification time). If either changed, the cached data is dropped.
+ *
+ * The map file modification time is used to evict the least recently used
+ * files when the cache exceeds its size limit.
+ */
+
+#define MAP_MAGIC "VLC disk cache 1"
+
+struct diskcache_range
+{
+    uint64_t start;
+    uint64_t end;
+};
+
+typedef struct
+{
+    int       fd;
+    char     *path;
+    char     *validator;
+    uint64_t  size;
+    uint64_t  offset;
+    uint64_t  source_offset;
+    bool      dirty;
+
+    struct diskcache_range *ranges;
+    size_t    count;
+    size_t    alloc;
+} stream_sys_t;
+
+/**
+ * Finds the first range ending after the given offset.
+ */
+static size_t RangeFind(const stream_sys_t *sys, uint64_t offset)
+{
+    size_t lo = 0, hi = sys->count;
+
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+
+        if (sys->ranges[mid].end <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int RangeAdd(stream_sys_t *sys, uint64_t start, uint64_t end)
+{
+    size_t i = RangeFind(sys, start);
+
+    if (i > 0 && sys->ranges[i - 1].end == start)
+        i--; /* append to the previous range */
+
+    if (i == sys->count || sys->ranges[i].start > end)
+    {   /* Disjoint range */
+        if (sys->count == sys->alloc)
+        {
+            size_t alloc = sys->alloc ? sys->alloc * 2 : 16;
+            struct diskcache_range *tab =
+                vlc_reallocarray(sys->ranges, alloc, sizeof (*tab));
+            if (unlikely(tab == NULL))
+                return -1;
+            sys->ranges = tab;
+            sys->alloc = alloc;
+        }
+        memmove(sys->ranges + i + 1, sys->ranges + i,
+                (sys->count - i) * sizeof (*sys->ranges));
+        sys->ranges[i].start = start;
+        sys->ranges[i].end = end;
+        sys->count++;
+        return 0;
+    }
+
+    /* Merge with all overlapping or adjacent ranges */
+    size_t j = i;
+
+    while (j + 1 < sys->count && sys->ranges[j + 1].start <= end)
+        j++;
+
+    if (sys->ranges[i].start > start)
+        sys->ranges[i].start = start;
+    sys->ranges[i].end = __MAX(end, sys->ranges[j].end);
+    memmove(sys->ranges + i + 1, sys->ranges + j + 1,
+            (sys->count - j - 1) * sizeof (*sys->ranges));
+    sys->count -= j - i;
+    return 0;
+}
+
+static char *CachePath(const stream_sys_t *sys, const char *ext)
+{
+    char *path;
+
+    if (asprintf(&path, "%s.%s", sys->path, ext) < 0)
+        path = NULL;
+    return path;
+}
+
+static int MapLoad(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    char *path = CachePath(sys, "map");
+    if (unlikely(path == NULL))
+        return -1;
+
+    FILE *file = vlc_fopen(path, "rt");
+    free(path);
+    if (file == NULL)
+        return -1;
+
+    char *line = NULL;
+    size_t linelen = 0;
+    uint64_t size;
+    int ret = -1;
+
+    if (getline(&line, &linelen, file) < 0 || strcmp(line, MAP_MAGIC "\n"))
+        goto out;
+    if (fscanf(file, "%" SCNu64 "\n", &size) != 1 || size != sys->size)
+        goto out;
+
+    ssize_t len = getline(&line, &linelen, file);
+    if (len <= 0 || line[len - 1] != '\n')
+        goto out;
+    line[len - 1] = '\0';
+    if (strcmp(line, sys->validator))
+    {
+        msg_Dbg(stream, "remote file changed");
+        goto out;
+    }
+
+    uint64_t start, end;
+
+    while (fscanf(file, "%" SCNu64 " %" SCNu64 "\n", &start, &end) == 2)
+        if (start < end && end <= sys->size
+         && RangeAdd(sys, start, end))
+            goto out;
+    ret = 0;
+out:
+    free(line);
+    fclose(file);
+    return ret;
+}
+
+static void MapSave(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    char *path = CachePath(sys, "map");
+    char *tmp = CachePath(sys, "map.tmp");
+    if (unlikely(path == NULL || tmp == NULL))
+        goto out;
+
+    FILE *file = vlc_fopen(tmp, "wt");
+    if (file == NULL)
+    {
+        msg_Err(stream, "cannot create %s: %s", tmp, vlc_strerror_c(errno));
+        goto out;
+    }
+
+    fprintf(file, MAP_MAGIC "\n%" PRIu64 "\n%s\n", sys->size, sys->validator);
+    for (size_t i = 0; i < sys->count; i++)
+        fprintf(file, "%" PRIu64 " %" PRIu64 "\n",
+                sys->ranges[i].start, sys->ranges[i].end);
+
+    if (ferror(file) | fclose(file) || vlc_rename(tmp, path))
+    {
+        msg_Err(stream, "cannot write %s", path);
+        vlc_unlink(tmp);
+    }
+out:
+    free(tmp);
+    free(path);
+}
+
+struct diskcache_entry
+{
+    char    *name;
+    time_t   mtime;
+    uint64_t used;
+};
+
+static int EntryCmp(const void *a, const void *b)
+{
+    const struct diskcache_entry *ea = a, *eb = b;
+
+    return (ea->mtime > eb->mtime) - (ea->mtime < eb->mtime);
+}
+
+/**
+ * Evicts the least recently used files until the cache fits the given size,
+ * not counting the file being opened.
+ */
+static void CacheTrim(stream_t *stream, const char *dir, const char *self,
+                      uint64_t max)
+{
+    DIR *dh = vlc_opendir(dir);
+    if (dh == NULL)
+        return;
+
+    struct diskcache_entry *tab = NULL;
+    size_t count = 0, alloc = 0;
+    uint64_t total = 0;
+    const char *name;
+
+    while ((name = vlc_readdir(dh)) != NULL)
+    {
+        size_t len = strlen(name);
+
+        if (len <= 5 || strcmp(name + len - 5, ".data")
+         || (len - 5 == strlen(self) && !strncmp(name, self, len - 5)))
+            continue;
+
+        char *path;
+        struct stat st;
+        time_t mtime = 0;
+
+        if (asprintf(&path, "%s" DIR_SEP "%s", dir, name) < 0)
+            break;
+        if (vlc_stat(path, &st))
+        {
+            free(path);
+            continue;
+        }
+
+        strcpy(path + strlen(path) - 4, "map");
+        {
+            struct stat mst;
+
+            if (vlc_stat(path, &mst) == 0)
+                mtime = mst.st_mtime;
+        }
+        strcpy(path + strlen(path) - 3, "data");
+
+        if (count == alloc)
+        {
+            size_t n = alloc ? alloc * 2 : 16;
+            struct diskcache_entry *t = vlc_reallocarray(tab, n, sizeof (*t));
+            if (unlikely(t == NULL))
+            {
+                free(path);
+                break;
+            }
+            tab = t;
+            alloc = n;
+        }
+
+        tab[count].name = path;
+        tab[count].mtime = mtime;
+#ifndef _WIN32
+        tab[count].used = (uint64_t)st.st_blocks * 512;
+#else
+        tab[count].used = st.st_size;
+#endif
+        total += tab[count].used;
+        count++;
+    }
+    closedir(dh);
+
+    qsort(tab, count, sizeof (*tab), EntryCmp);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        char *path = tab[i].name;
+
+        if (total > max)
+        {
+            msg_Dbg(stream, "evicting %s", path);
+            vlc_unlink(path);
+            strcpy(path + strlen(path) - 4, "map");
+            vlc_unlink(path);
+            total -= tab[i].used;
+        }
+        free(path);
+    }
+    free(tab);
+}
+
+static ssize_t CacheRead(stream_sys_t *sys, void *buf, size_t len)
+{
+    if (lseek(sys->fd, sys->offset, SEEK_SET) == (off_t)-1)
+        return -1;
+    return read(sys->fd, buf, len);
+}
+
+static void CacheWrite(stream_t *stream, const void *buf, size_t len)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (lseek(sys->fd, sys->offset, SEEK_SET) == (off_t)-1
+     || write(sys->fd, buf, len) != (ssize_t)len)
+    {
+        msg_Warn(stream, "cannot write cache: %s", vlc_strerror_c(errno));
+        return;
+    }
+
+    if (RangeAdd(sys, sys->offset, sys->offset + len) == 0)
+        sys->dirty = true;
+}
+
+static ssize_t Read(stream_t *stream, void *buf, size_t len)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (sys->offset >= sys->size)
+        return 0;
+    if (len > sys->size - sys->offset)
+        len = sys->size - sys->offset;
+
+    size_t i = RangeFind(sys, sys->offset);
+
+    if (i < sys->count && sys->ranges[i].start <= sys->offset)
+    {   /* Cached */
+        if (len > sys->ranges[i].end - sys->offset)
+            len = sys->ranges[i].end - sys->offset;
+
+        ssize_t val = CacheRead(sys, buf, len);
+        if (val > 0)
+        {
+            sys->offset += val;
+            return val;
+        }
+        msg_Warn(stream, "cannot read cache: %s", vlc_strerror_c(errno));
+    }
+    else if (i < sys->count && len > sys->ranges[i].start - sys->offset)
+        /* Do not download what is already cached */
+        len = sys->ranges[i].start - sys->offset;
+
+    if (sys->source_offset != sys->offset)
+    {
+        if (vlc_stream_Seek(stream->s, sys->offset))
+            return -1;
+        sys->source_offset = sys->offset;
+    }
+
+    ssize_t val = vlc_stream_ReadPartial(stream->s, buf, len);
+    if (val <= 0)
+        return val;
+
+    CacheWrite(stream, buf, val);
+    sys->source_offset += val;
+    sys->offset += val;
+    return val;
+}
+
+static int Seek(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    sys->offset = offset;
+    return VLC_SUCCESS;
+}
+
+static int Control(stream_t *stream, int query, va_list args)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    switch (query)
+    {
+        case STREAM_GET_SIZE:
+            *va_arg(args, uint64_t *) = sys->size;
+            return VLC_SUCCESS;
+    }
+
+    return vlc_stream_vaControl(stream->s, query, args);
+}
+
+static char *CacheDir(vlc_object_t *obj)
+{
+    char *dir = var_InheritString(obj, "diskcache-dir");
+    if (dir != NULL)
+        return dir;
+
+    char *base = config_GetUserDir(VLC_CACHE_DIR);
+    if (base == NULL)
+        return NULL;
+
+    vlc_mkdir(base, 0700);
+    if (asprintf(&dir, "%s" DIR_SEP "http", base) < 0)
+        dir = NULL;
+    free(base);
+    return dir;
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    uint64_t max = (uint64_t)var_InheritInteger(obj, "diskcache-size") << 20;
+
+    if (max == 0 || stream->psz_url == NULL
+     || (strncasecmp(stream->psz_url, "http://", 7)
+      && strncasecmp(stream->psz_url, "https://", 8)))
+        return VLC_EGENERIC;
+
+    bool can_seek;
+    uint64_t size;
+
+    if (vlc_stream_Control(stream->s, STREAM_CAN_SEEK, &can_seek)
+     || !can_seek || vlc_stream_GetSize(stream->s, &size) || size == 0)
+        return VLC_EGENERIC;
+    if (size > max)
+    {
+        msg_Dbg(stream, "file too large for the cache");
+        return VLC_EGENERIC;
+    }
+
+    char *validator;
+    if (vlc_stream_Control(stream->s, STREAM_GET_VALIDATOR, &validator))
+    {
+        msg_Dbg(stream, "no validator, cannot cache");
+        return VLC_EGENERIC;
+    }
+    if (strchr(validator, '\n') != NULL)
+    {
+        free(validator);
+        return VLC_EGENERIC;
+    }
+
+    stream_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+    {
+        free(validator);
+        return VLC_ENOMEM;
+    }
+
+    sys->path = NULL;
+    sys->validator = validator;
+    sys->size = size;
+    sys->offset = sys->source_offset = vlc_stream_Tell(stream->s);
+    sys->dirty = false;
+    sys->ranges = NULL;
+    sys->count = sys->alloc = 0;
+    stream->p_sys = sys;
+
+    char *dir = CacheDir(obj);
+    if (dir == NULL)
+        goto error;
+    if (vlc_mkdir(dir, 0700) && errno != EEXIST)
+    {
+        msg_Err(stream, "cannot create %s: %s", dir, vlc_strerror_c(errno));
+        free(dir);
+        goto error;
+    }
+
+    struct md5_s md5;
+    InitMD5(&md5);
+    AddMD5(&md5, stream->psz_url, strlen(stream->psz_url));
+    EndMD5(&md5);
+
+    char *hash = psz_md5_hash(&md5);
+    if (unlikely(hash == NULL))
+    {
+        free(dir);
+        goto error;
+    }
+
+    CacheTrim(stream, dir, hash, max - size);
+
+    if (asprintf(&sys->path, "%s" DIR_SEP "%s", dir, hash) < 0)
+        sys->path = NULL;
+    free(hash);
+    free(dir);
+    if (unlikely(sys->path == NULL))
+        goto error;
+
+    char *path = CachePath(sys, "data");
+    if (unlikely(path == NULL))
+        goto error;
+
+    sys->fd = vlc_open(path, O_RDWR | O_CREAT, 0600);
+    if (sys->fd == -1)
+    {
+        msg_Err(stream, "cannot open %s: %s", path, vlc_strerror_c(errno));
+        free(path);
+        goto error;
+    }
+    free(path);
+
+    if (MapLoad(stream))
+    {   /* Missing, corrupt or stale: start over */
+        sys->count = 0;
+        if (ftruncate(sys->fd, 0))
+        {
+            vlc_close(sys->fd);
+            goto error;
+        }
+        sys->dirty = true;
+    }
+
+    msg_Dbg(stream, "%zu cached range(s) for %s", sys->count,
+            stream->psz_url);
+    stream->pf_read = Read;
+    stream->pf_seek = Seek;
+    stream->pf_control = Control;
+    return VLC_SUCCESS;
+
+error:
+    free(sys->ranges);
+    free(sys->path);
+    free(sys->validator);
+    free(sys);
+    return VLC_EGENERIC;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    stream_sys_t *sys = stream->p_sys;
+
+    vlc_close(sys->fd);
+    /* Always rewritten, as the map time tells the last use */
+    MapSave(stream);
+    free(sys->ranges);
+    free(sys->path);
+    free(sys->validator);
+    free(sys);
+}
+
+vlc_module_begin()
+    set_shortname(N_("Disk cache"))
+    set_description(N_("Persistent disk cache for remote files"))
+    set_category(CAT_INPUT)
+    set_subcategory(SUBCAT_INPUT_STREAM_FILTER)
+    set_capability("stream_filter", 0)
+    add_shortcut("diskcache")
+    add_integer("diskcache-size", 0, N_("Disk cache size (MiB)"),
+                N_("Maximum disk space used to keep remote HTTP files "
+                   "across sessions. 0 disables the cache."), true)
+        change_integer_range(0, INT64_C(1) << 40)
+    add_directory("diskcache-dir", NULL, N_("Disk cache directory"),
+                  N_("Directory where the remote files are kept. "
+                     "By default, a subdirectory of the user cache "
+                     "directory."))
+    set_callbacks(Open, Close)
+vlc_module_end()
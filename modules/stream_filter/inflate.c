@@ -114,6 +114,7 @@ static int Control(stream_t *stream, int query, va_list args)
         case STREAM_GET_META:
         case STREAM_GET_CONTENT_TYPE:
         case STREAM_GET_SIGNAL:
+        case STREAM_GET_NETWORK:
         case STREAM_SET_PAUSE_STATE:
             return vlc_stream_vaControl(stream->s, query, args);
         case STREAM_GET_SIZE:
@@ -49,6 +49,17 @@ struct stream_ctrl
     };
 };
 
+/* Data kept aside when the buffer is reset by a seek */
+struct prefetch_range
+{
+    uint64_t offset;
+    size_t   length;
+    uint64_t last_use;
+    char    *data;
+};
+
+#define RANGE_MAX_SIZE (2 << 20)
+
 typedef struct
 {
     vlc_mutex_t  lock;
@@ -75,9 +86,99 @@ typedef struct
     char        *buffer;
     size_t       seek_threshold;
 
+    struct prefetch_range *ranges;
+    unsigned     range_count;
+    size_t       range_size;
+    uint64_t     range_clock;
+
     struct stream_ctrl *controls;
 } stream_sys_t;
 
+static struct prefetch_range *RangeFind(stream_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->range_count; i++)
+    {
+        struct prefetch_range *r = &sys->ranges[i];
+
+        if (r->length > 0 && offset >= r->offset
+         && offset - r->offset < r->length)
+            return r;
+    }
+    return NULL;
+}
+
+/* Header and index regions, which demuxers come back to, stay cached */
+static bool RangeIsPinned(const stream_sys_t *sys,
+                          const struct prefetch_range *r)
+{
+    return r->offset == 0
+        || (sys->size != (uint64_t)-1 && r->offset + r->length >= sys->size);
+}
+
+/**
+ * Returns the offset the buffer has to be filled from, past the ranges
+ * already covering the read offset.
+ */
+static uint64_t RangeSkip(stream_sys_t *sys, uint64_t offset)
+{
+    const struct prefetch_range *r;
+
+    while ((r = RangeFind(sys, offset)) != NULL)
+        offset = r->offset + r->length;
+    return offset;
+}
+
+/**
+ * Saves the start of the buffer before it is discarded.
+ */
+static void RangeSave(stream_sys_t *sys)
+{
+    size_t length = sys->buffer_length;
+    struct prefetch_range *slot = NULL;
+
+    if (length > sys->range_size)
+        length = sys->range_size;
+    if (length == 0 || RangeFind(sys, sys->buffer_offset) != NULL)
+        return;
+
+    for (unsigned i = 0; i < sys->range_count; i++)
+    {
+        struct prefetch_range *r = &sys->ranges[i];
+
+        if (r->length == 0)
+        {
+            slot = r;
+            break;
+        }
+        /* Least recently used, unpinned ones first */
+        if (slot == NULL
+         || RangeIsPinned(sys, slot) > RangeIsPinned(sys, r)
+         || (RangeIsPinned(sys, slot) == RangeIsPinned(sys, r)
+          && r->last_use < slot->last_use))
+            slot = r;
+    }
+    if (slot == NULL)
+        return;
+
+    if (slot->data == NULL)
+    {
+        slot->data = malloc(sys->range_size);
+        if (unlikely(slot->data == NULL))
+            return;
+    }
+
+    size_t offset = sys->buffer_offset % sys->buffer_size;
+    size_t first = sys->buffer_size - offset;
+
+    if (first > length)
+        first = length;
+    memcpy(slot->data, sys->buffer + offset, first);
+    memcpy(slot->data + first, sys->buffer, length - first);
+    slot->offset = sys->buffer_offset;
+    slot->length = length;
+    slot->last_use = ++sys->range_clock;
+}
+
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -166,10 +267,11 @@ static void *Thread(void *data)
             continue;
         }
 
-        uint_fast64_t stream_offset = sys->stream_offset;
+        uint_fast64_t stream_offset = RangeSkip(sys, sys->stream_offset);
 
         if (stream_offset < sys->buffer_offset)
         {   /* Need to seek backward */
+            RangeSave(sys);
             if (ThreadSeek(stream, stream_offset) == 0)
             {
                 sys->buffer_offset = stream_offset;
@@ -206,6 +308,7 @@ static void *Thread(void *data)
         if (sys->can_seek
          && history >= (sys->buffer_length + sys->seek_threshold))
         {
+            RangeSave(sys);
             if (ThreadSeek(stream, stream_offset) == 0)
             {
                 sys->buffer_offset = stream_offset;
@@ -237,6 +340,8 @@ static void *Thread(void *data)
             }
 
             /* Discard some historical data to make room. */
+            if (sys->buffer_offset == 0)
+                RangeSave(sys); /* but keep the header */
             len = history > sys->buffer_length ? sys->buffer_length : history;
 
             sys->buffer_offset += len;
@@ -316,6 +421,21 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
         vlc_cond_signal(&sys->wait_space);
     }
 
+    struct prefetch_range *r = RangeFind(sys, sys->stream_offset);
+    if (r != NULL)
+    {
+        copy = r->offset + r->length - sys->stream_offset;
+        if (copy > buflen)
+            copy = buflen;
+
+        memcpy(buf, r->data + (sys->stream_offset - r->offset), copy);
+        r->last_use = ++sys->range_clock;
+        sys->stream_offset += copy;
+        vlc_cond_signal(&sys->wait_space);
+        vlc_mutex_unlock(&sys->lock);
+        return copy;
+    }
+
     while ((copy = BufferLevel(stream, &eof)) == 0 && !eof)
     {
         void *data[2];
@@ -478,6 +598,18 @@ static int Open(vlc_object_t *obj)
             sys->buffer_size = size;
     }
 
+    sys->range_count = sys->can_seek ? var_InheritInteger(obj, "prefetch-ranges")
+                                     : 0;
+    sys->range_size = __MIN(sys->buffer_size, RANGE_MAX_SIZE);
+    sys->range_clock = 0;
+    sys->ranges = NULL;
+    if (sys->range_count > 0)
+    {
+        sys->ranges = calloc(sys->range_count, sizeof (*sys->ranges));
+        if (unlikely(sys->ranges == NULL))
+            sys->range_count = 0;
+    }
+
     sys->buffer = malloc(sys->buffer_size);
     if (sys->buffer == NULL)
         goto error;
@@ -508,6 +640,7 @@ static int Open(vlc_object_t *obj)
     return VLC_SUCCESS;
 
 error:
+    free(sys->ranges);
     free(sys->buffer);
     free(sys->content_type);
     free(sys);
@@ -537,6 +670,9 @@ static void Close (vlc_object_t *obj)
         sys->controls = ctrl->next;
         free(ctrl);
     }
+    for (unsigned i = 0; i < sys->range_count; i++)
+        free(sys->ranges[i].data);
+    free(sys->ranges);
     free(sys->buffer);
     free(sys->content_type);
     free(sys);
@@ -557,4 +693,8 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"), true)
         change_integer_range(0, UINT64_C(1) << 60)
+    add_integer("prefetch-ranges", 4, N_("Cached ranges"),
+                N_("Number of ranges kept in memory when seeking, such as "
+                   "headers and indexes (2 MiB each at most)"), true)
+        change_integer_range(0, 64)
 vlc_module_end()
@@ -0,0 +1,630 @@
+/*****************************************************************************
+ * zstd.c: Zstandard decompression stream filter
+ *****************************************************************************
+ * Copyright © 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zstd.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_stream.h>
+
+/* Seekable format, see contrib/seekable_format in the zstd sources */
+#define SEEKABLE_MAGIC   0x8F92EAB1
+#define SKIPPABLE_MAGIC  0x184D2A5E
+#define SEEKABLE_FOOTER  9
+#define SKIPPABLE_HEADER 8
+#define SEEKABLE_MAX_FRAMES (1u << 24)
+
+/* Frames larger than this are not decoded in parallel */
+#define PARALLEL_FRAME_MAX (64u << 20)
+#define PARALLEL_THREADS_MAX 8
+
+struct zstd_frame
+{
+    uint64_t c_offset; /**< Offset in the compressed stream */
+    uint64_t d_offset; /**< Offset in the decompressed stream */
+    uint32_t c_size;
+    uint32_t d_size;
+};
+
+struct zstd_job
+{
+    uint8_t *src;
+    size_t src_size;
+    uint8_t *dst;
+    size_t dst_size;
+    size_t result;
+};
+
+typedef struct
+{
+    ZSTD_DStream *dstream;
+    ZSTD_inBuffer in;
+    uint8_t *inbuf;
+    size_t inbuf_size;
+    uint64_t offset; /**< Decompressed offset */
+    bool frame_done;
+    bool eof;
+
+    /* Seek table */
+    struct zstd_frame *frames;
+    unsigned frame_count;
+    uint64_t size;
+
+    /* Parallel decoding of whole frames */
+    unsigned thread_count;
+    vlc_thread_t *threads;
+    struct zstd_job *jobs;
+    unsigned job_count;
+    unsigned job_next; /**< Next job to pick by a worker */
+    unsigned job_pending; /**< Jobs being decoded */
+    unsigned job_avail; /**< Decoded jobs */
+    unsigned job_cur; /**< Job being read from */
+    size_t job_pos;
+    unsigned next_frame;
+    bool quit;
+    vlc_mutex_t lock;
+    vlc_cond_t work_wait;
+    vlc_cond_t done_wait;
+} stream_sys_t;
+
+static void *Worker(void *data)
+{
+    stream_sys_t *sys = data;
+    ZSTD_DCtx *dctx = ZSTD_createDCtx();
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;)
+    {
+        while (!sys->quit && sys->job_next >= sys->job_count)
+            vlc_cond_wait(&sys->work_wait, &sys->lock);
+        if (sys->quit)
+            break;
+
+        struct zstd_job *job = &sys->jobs[sys->job_next++];
+        vlc_mutex_unlock(&sys->lock);
+
+        if (likely(dctx != NULL))
+            job->result = ZSTD_decompressDCtx(dctx, job->dst, job->dst_size,
+                                              job->src, job->src_size);
+        else
+            job->result = (size_t)-1;
+
+        vlc_mutex_lock(&sys->lock);
+        assert(sys->job_pending > 0);
+        if (--sys->job_pending == 0)
+            vlc_cond_signal(&sys->done_wait);
+    }
+    vlc_mutex_unlock(&sys->lock);
+
+    ZSTD_freeDCtx(dctx);
+    return NULL;
+}
+
+static int SeekTableLoad(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    uint8_t buf[SKIPPABLE_HEADER];
+    uint64_t size;
+    bool can_seek;
+
+    if (vlc_stream_Control(stream->s, STREAM_CAN_SEEK, &can_seek) || !can_seek
+     || vlc_stream_GetSize(stream->s, &size)
+     || size < SEEKABLE_FOOTER + SKIPPABLE_HEADER)
+        return -1;
+
+    if (vlc_stream_Seek(stream->s, size - SEEKABLE_FOOTER)
+     || vlc_stream_Read(stream->s, buf, SEEKABLE_FOOTER) < SEEKABLE_FOOTER
+     || GetDWLE(buf + 5) != SEEKABLE_MAGIC || (buf[4] & 0x7C))
+        return -1;
+
+    unsigned count = GetDWLE(buf);
+    size_t entry_size = (buf[4] & 0x80) ? 12 : 8;
+
+    if (count == 0 || count > SEEKABLE_MAX_FRAMES)
+        return -1;
+
+    uint64_t table_size = (uint64_t)count * entry_size;
+    uint64_t skippable_size = SKIPPABLE_HEADER + table_size + SEEKABLE_FOOTER;
+
+    if (skippable_size > size
+     || vlc_stream_Seek(stream->s, size - skippable_size)
+     || vlc_stream_Read(stream->s, buf, SKIPPABLE_HEADER) < SKIPPABLE_HEADER
+     || GetDWLE(buf) != SKIPPABLE_MAGIC
+     || GetDWLE(buf + 4) != table_size + SEEKABLE_FOOTER)
+        return -1;
+
+    uint8_t *table = malloc(table_size);
+    struct zstd_frame *frames = vlc_alloc(count, sizeof (*frames));
+    if (unlikely(table == NULL || frames == NULL))
+        goto error;
+
+    if (vlc_stream_Read(stream->s, table, table_size) < (ssize_t)table_size)
+        goto error;
+
+    uint64_t c_offset = 0, d_offset = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        const uint8_t *entry = table + i * entry_size;
+
+        frames[i].c_offset = c_offset;
+        frames[i].d_offset = d_offset;
+        frames[i].c_size = GetDWLE(entry);
+        frames[i].d_size = GetDWLE(entry + 4);
+        c_offset += frames[i].c_size;
+        d_offset += frames[i].d_size;
+    }
+
+    if (c_offset != size - skippable_size)
+    {
+        msg_Warn(stream, "inconsistent seek table");
+        goto error;
+    }
+
+    free(table);
+    sys->frames = frames;
+    sys->frame_count = count;
+    sys->size = d_offset;
+    msg_Dbg(stream, "seek table: %u frames, %"PRIu64" bytes", count,
+            d_offset);
+    return 0;
+
+error:
+    free(frames);
+    free(table);
+    return -1;
+}
+
+static void StreamReset(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    ZSTD_initDStream(sys->dstream);
+    sys->in.src = sys->inbuf;
+    sys->in.size = 0;
+    sys->in.pos = 0;
+    sys->frame_done = true;
+    sys->eof = false;
+}
+
+static ssize_t ReadStream(stream_t *stream, void *buf, size_t buflen)
+{
+    stream_sys_t *sys = stream->p_sys;
+    ZSTD_outBuffer out = { buf, buflen, 0 };
+
+    if (sys->eof || unlikely(buflen == 0))
+        return 0;
+
+    while (out.pos == 0)
+    {
+        if (sys->in.pos == sys->in.size)
+        {
+            ssize_t val = vlc_stream_Read(stream->s, sys->inbuf,
+                                          sys->inbuf_size);
+            if (val <= 0)
+            {
+                if (!sys->frame_done)
+                    msg_Err(stream, "unexpected end of stream");
+                sys->eof = true;
+                break;
+            }
+            sys->in.src = sys->inbuf;
+            sys->in.size = val;
+            sys->in.pos = 0;
+        }
+
+        size_t ret = ZSTD_decompressStream(sys->dstream, &out, &sys->in);
+        if (ZSTD_isError(ret))
+        {
+            msg_Err(stream, "decompression error: %s",
+                    ZSTD_getErrorName(ret));
+            sys->eof = true;
+            return -1;
+        }
+        sys->frame_done = ret == 0;
+    }
+
+    sys->offset += out.pos;
+    return out.pos;
+}
+
+/* Reads and decodes the next frames, one per worker thread */
+static int ParallelFill(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    unsigned count = sys->frame_count - sys->next_frame;
+
+    if (count > sys->thread_count)
+        count = sys->thread_count;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        const struct zstd_frame *f = &sys->frames[sys->next_frame + i];
+        struct zstd_job *job = &sys->jobs[i];
+
+        if (job->src_size < f->c_size)
+        {
+            uint8_t *src = realloc(job->src, f->c_size);
+            if (unlikely(src == NULL))
+                return -1;
+            job->src = src;
+        }
+        if (job->dst_size < f->d_size)
+        {
+            uint8_t *dst = realloc(job->dst, f->d_size);
+            if (unlikely(dst == NULL))
+                return -1;
+            job->dst = dst;
+        }
+        job->src_size = f->c_size;
+        job->dst_size = f->d_size;
+
+        if (vlc_stream_Read(stream->s, job->src, f->c_size)
+                                                     < (ssize_t)f->c_size)
+        {
+            msg_Err(stream, "unexpected end of stream");
+            return -1;
+        }
+    }
+
+    vlc_mutex_lock(&sys->lock);
+    sys->job_count = count;
+    sys->job_next = 0;
+    sys->job_pending = count;
+    vlc_cond_broadcast(&sys->work_wait);
+    while (sys->job_pending > 0)
+        vlc_cond_wait(&sys->done_wait, &sys->lock);
+    sys->job_count = 0;
+    vlc_mutex_unlock(&sys->lock);
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        struct zstd_job *job = &sys->jobs[i];
+
+        if (ZSTD_isError(job->result))
+        {
+            msg_Err(stream, "decompression error: %s",
+                    ZSTD_getErrorName(job->result));
+            return -1;
+        }
+        if (job->result != job->dst_size)
+        {
+            msg_Err(stream, "frame size mismatch");
+            return -1;
+        }
+    }
+
+    sys->next_frame += count;
+    sys->job_cur = 0;
+    sys->job_avail = count;
+    return 0;
+}
+
+static ssize_t ReadParallel(stream_t *stream, void *buf, size_t buflen)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (sys->eof || unlikely(buflen == 0))
+        return 0;
+
+    while (sys->job_cur >= sys->job_avail
+        || sys->job_pos >= sys->jobs[sys->job_cur].dst_size)
+    {
+        if (sys->job_cur < sys->job_avail)
+        {   /* Next decoded frame */
+            sys->job_pos -= sys->jobs[sys->job_cur].dst_size;
+            sys->job_cur++;
+            continue;
+        }
+
+        if (sys->next_frame >= sys->frame_count)
+        {
+            sys->eof = true;
+            return 0;
+        }
+
+        if (ParallelFill(stream))
+        {
+            sys->eof = true;
+            return -1;
+        }
+    }
+
+    const struct zstd_job *job = &sys->jobs[sys->job_cur];
+
+    if (buflen > job->dst_size - sys->job_pos)
+        buflen = job->dst_size - sys->job_pos;
+    memcpy(buf, job->dst + sys->job_pos, buflen);
+    sys->job_pos += buflen;
+    sys->offset += buflen;
+    return buflen;
+}
+
+static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (sys->threads != NULL)
+        return ReadParallel(stream, buf, buflen);
+    return ReadStream(stream, buf, buflen);
+}
+
+static int Seek(stream_t *stream, uint64_t offset)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    if (sys->frames != NULL)
+    {   /* Find the frame: binary search */
+        unsigned lo = 0, hi = sys->frame_count;
+
+        while (hi - lo > 1)
+        {
+            unsigned mid = (lo + hi) / 2;
+
+            if (sys->frames[mid].d_offset <= offset)
+                lo = mid;
+            else
+                hi = mid;
+        }
+
+        const struct zstd_frame *f = &sys->frames[lo];
+
+        if (vlc_stream_Seek(stream->s, f->c_offset))
+            return -1;
+
+        StreamReset(stream);
+        sys->offset = f->d_offset;
+
+        if (sys->threads != NULL)
+        {
+            sys->next_frame = lo;
+            sys->job_cur = sys->job_avail = 0;
+            /* Skipped within the next decoded frames */
+            sys->job_pos = offset - f->d_offset;
+            sys->offset = offset;
+            return 0;
+        }
+    }
+    else if (offset < sys->offset)
+    {   /* Restart from the beginning */
+        if (vlc_stream_Seek(stream->s, 0))
+            return -1;
+
+        StreamReset(stream);
+        sys->offset = 0;
+    }
+
+    /* Decode and discard up to the target */
+    while (sys->offset < offset)
+    {
+        uint8_t dummy[16384];
+        size_t len = sizeof (dummy);
+
+        if (len > offset - sys->offset)
+            len = offset - sys->offset;
+
+        ssize_t val = ReadStream(stream, dummy, len);
+        if (val <= 0)
+            return val < 0 ? -1 : 0;
+    }
+    return 0;
+}
+
+static int Control(stream_t *stream, int query, va_list args)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+            if (sys->frames != NULL)
+                *va_arg(args, bool *) = true;
+            else
+                return vlc_stream_vaControl(stream->s, query, args);
+            break;
+        case STREAM_CAN_FASTSEEK:
+            *va_arg(args, bool *) = sys->frames != NULL;
+            break;
+        case STREAM_GET_SIZE:
+            if (sys->frames == NULL)
+                return VLC_EGENERIC;
+            *va_arg(args, uint64_t *) = sys->size;
+            break;
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+        case STREAM_GET_PTS_DELAY:
+        case STREAM_GET_META:
+        case STREAM_GET_SIGNAL:
+        case STREAM_GET_NETWORK:
+        case STREAM_SET_PAUSE_STATE:
+            return vlc_stream_vaControl(stream->s, query, args);
+        case STREAM_GET_CONTENT_TYPE:
+        case STREAM_GET_TITLE_INFO:
+        case STREAM_GET_TITLE:
+        case STREAM_GET_SEEKPOINT:
+        case STREAM_SET_TITLE:
+        case STREAM_SET_SEEKPOINT:
+        case STREAM_SET_PRIVATE_ID_STATE:
+        case STREAM_SET_PRIVATE_ID_CA:
+        case STREAM_GET_PRIVATE_ID_STATE:
+            return VLC_EGENERIC;
+        default:
+            msg_Err(stream, "unimplemented query (%d) in control", query);
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void ParallelStop(stream_sys_t *sys, unsigned count)
+{
+    vlc_mutex_lock(&sys->lock);
+    sys->quit = true;
+    vlc_cond_broadcast(&sys->work_wait);
+    vlc_mutex_unlock(&sys->lock);
+
+    for (unsigned i = 0; i < count; i++)
+        vlc_join(sys->threads[i], NULL);
+
+    for (unsigned i = 0; i < sys->thread_count; i++)
+    {
+        free(sys->jobs[i].src);
+        free(sys->jobs[i].dst);
+    }
+    free(sys->jobs);
+    free(sys->threads);
+    sys->threads = NULL;
+}
+
+static void ParallelStart(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    unsigned count = var_InheritInteger(stream, "zstd-threads");
+
+    if (count == 0)
+        count = __MIN(vlc_GetCPUCount(), PARALLEL_THREADS_MAX);
+    if (count <= 1)
+        return;
+
+    for (unsigned i = 0; i < sys->frame_count; i++)
+        if (sys->frames[i].d_size > PARALLEL_FRAME_MAX)
+            return;
+
+    sys->thread_count = count;
+    sys->threads = vlc_alloc(count, sizeof (*sys->threads));
+    sys->jobs = calloc(count, sizeof (*sys->jobs));
+    if (unlikely(sys->threads == NULL || sys->jobs == NULL))
+    {
+        free(sys->jobs);
+        free(sys->threads);
+        sys->threads = NULL;
+        return;
+    }
+
+    sys->job_count = sys->job_next = sys->job_pending = 0;
+    sys->job_avail = sys->job_cur = 0;
+    sys->job_pos = 0;
+    sys->next_frame = 0;
+    sys->quit = false;
+
+    for (unsigned i = 0; i < count; i++)
+        if (vlc_clone(&sys->threads[i], Worker, sys,
+                      VLC_THREAD_PRIORITY_INPUT))
+        {
+            ParallelStop(sys, i);
+            return;
+        }
+
+    msg_Dbg(stream, "decoding with %u threads", count);
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    const uint8_t *peek;
+
+    if (vlc_stream_Peek(stream->s, &peek, 4) < 4)
+        return VLC_EGENERIC;
+
+    uint32_t magic = GetDWLE(peek);
+
+    if (magic != ZSTD_MAGICNUMBER
+     && (magic & 0xFFFFFFF0) != (SKIPPABLE_MAGIC & 0xFFFFFFF0))
+        return VLC_EGENERIC;
+
+    stream_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    sys->inbuf_size = ZSTD_DStreamInSize();
+    sys->inbuf = malloc(sys->inbuf_size);
+    sys->dstream = ZSTD_createDStream();
+    if (unlikely(sys->inbuf == NULL || sys->dstream == NULL))
+    {
+        ZSTD_freeDStream(sys->dstream);
+        free(sys->inbuf);
+        free(sys);
+        return VLC_ENOMEM;
+    }
+
+    stream->p_sys = sys;
+    sys->offset = 0;
+    sys->frames = NULL;
+    sys->frame_count = 0;
+    sys->threads = NULL;
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->work_wait);
+    vlc_cond_init(&sys->done_wait);
+    StreamReset(stream);
+
+    if (SeekTableLoad(stream) == 0)
+        ParallelStart(stream);
+
+    if (vlc_stream_Tell(stream->s) != 0 && vlc_stream_Seek(stream->s, 0))
+    {
+        if (sys->threads != NULL)
+            ParallelStop(sys, sys->thread_count);
+        free(sys->frames);
+        ZSTD_freeDStream(sys->dstream);
+        free(sys->inbuf);
+        free(sys);
+        return VLC_EGENERIC;
+    }
+
+    stream->pf_read = Read;
+    stream->pf_seek = Seek;
+    stream->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    stream_sys_t *sys = stream->p_sys;
+
+    if (sys->threads != NULL)
+        ParallelStop(sys, sys->thread_count);
+    free(sys->frames);
+    ZSTD_freeDStream(sys->dstream);
+    free(sys->inbuf);
+    free(sys);
+}
+
+#define THREADS_TEXT N_("Decoding threads")
+#define THREADS_LONGTEXT N_( \
+    "Number of threads decoding frames in parallel, for files in the " \
+    "seekable format (0 = automatic).")
+
+vlc_module_begin()
+    set_category(CAT_INPUT)
+    set_subcategory(SUBCAT_INPUT_STREAM_FILTER)
+    set_capability("stream_filter", 330)
+
+    set_description(N_("Zstandard decompression filter"))
+    add_integer_with_range("zstd-threads", 0, 0, 32, THREADS_TEXT,
+                           THREADS_LONGTEXT, true)
+    set_callbacks(Open, Close)
+vlc_module_end()
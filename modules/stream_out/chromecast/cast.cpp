@@ -40,6 +40,7 @@
 #include <vlc_httpd.h>
 
 #include <cassert>
+#include <map>
 
 #define TRANSCODING_NONE 0x0
 #define TRANSCODING_VIDEO 0x1
@@ -88,12 +89,14 @@ typedef struct sout_stream_id_sys_t sout_stream_id_sys_t;
 
 struct sout_stream_sys_t
 {
-    sout_stream_sys_t(httpd_host_t *httpd_host, intf_sys_t * const intf, bool has_video, int port)
+    sout_stream_sys_t(httpd_host_t *httpd_host, intf_sys_t * const intf,
+                      const char *device, bool has_video, int port)
         : httpd_host(httpd_host)
         , access_out_live(httpd_host, intf)
         , p_out(NULL)
         , p_intf(intf)
         , b_supports_video(has_video)
+        , device(device)
         , i_port(port)
         , first_video_keyframe_pts( -1 )
         , es_changed( true )
@@ -101,6 +104,7 @@ struct sout_stream_sys_t
         , cc_flushing( false )
         , cc_eof( false )
         , has_video( false )
+        , has_audio( false )
         , out_force_reload( false )
         , perf_warning_shown( false )
         , transcoding_state( TRANSCODING_NONE )
@@ -138,6 +142,7 @@ struct sout_stream_sys_t
 
     intf_sys_t * const p_intf;
     const bool b_supports_video;
+    const std::string device;
     const int i_port;
 
     sout_stream_id_sys_t *             video_proxy_id;
@@ -148,9 +153,11 @@ struct sout_stream_sys_t
     bool                               cc_flushing;
     bool                               cc_eof;
     bool                               has_video;
+    bool                               has_audio;
     bool                               out_force_reload;
     bool                               perf_warning_shown;
     int                                transcoding_state;
+    std::string                        caps_key;
     int                                venc_opt_idx;
     std::vector<sout_stream_id_sys_t*> streams;
     std::vector<sout_stream_id_sys_t*> out_streams;
@@ -162,6 +169,13 @@ private:
     bool UpdateOutput( sout_stream_t * );
 };
 
+/* The Cast protocol cannot tell which codecs a receiver decodes: the
+ * conversions that were needed to load a given pair of codecs are kept for
+ * each device while the process runs, so that the next sessions do not try
+ * the configurations it rejected again. */
+static vlc_mutex_t device_caps_lock = VLC_STATIC_MUTEX;
+static std::map<std::string, int> device_caps;
+
 struct sout_stream_id_sys_t
 {
     es_format_t           fmt;
@@ -742,11 +756,14 @@ static void Del(sout_stream_t *p_stream, void *_id)
 }
 
 /**
- * Transcode steps:
+ * Transcode steps, each one is tried when the device fails to load the previous:
  * 0: Accept HEVC/VP9 & all supported audio formats
- * 1: Transcode to h264 & accept all supported audio formats if the video codec
- *    was HEVC/VP9
- * 2: Transcode to H264 & MP3
+ * 1: Transcode the audio only & pass the video through
+ * 2: Transcode to h264 & accept all supported audio formats
+ * 3: Transcode to H264 & MP3
+ *
+ * The step reached is remembered for the device and the input codecs, until
+ * the process exits: the next sessions start from there.
  *
  * Additionally:
  * - Allow (E)AC3 passthrough depending on the audio-passthrough
@@ -817,6 +834,7 @@ bool sout_stream_sys_t::startSoutChain(sout_stream_t *p_stream,
     first_video_keyframe_pts = -1;
     video_proxy_id = NULL;
     has_video = false;
+    has_audio = false;
     out_streams = new_streams;
     spu_streams_count = 0;
     transcoding_state = new_transcoding_state;
@@ -847,6 +865,8 @@ bool sout_stream_sys_t::startSoutChain(sout_stream_t *p_stream,
         {
             if( p_sys_id->fmt.i_cat == VIDEO_ES )
                 has_video = true;
+            else if( p_sys_id->fmt.i_cat == AUDIO_ES )
+                has_audio = true;
             else if( p_sys_id->fmt.i_cat == SPU_ES )
                 spu_streams_count++;
             ++it;
@@ -869,10 +889,17 @@ bool sout_stream_sys_t::startSoutChain(sout_stream_t *p_stream,
 
 void sout_stream_sys_t::setNextTranscodingState()
 {
-    if (!(transcoding_state & TRANSCODING_VIDEO))
-        transcoding_state |= TRANSCODING_VIDEO;
-    else if (!(transcoding_state & TRANSCODING_AUDIO))
+    /* Try the cheapest conversion first: audio only, then video only */
+    if (!(transcoding_state & (TRANSCODING_AUDIO|TRANSCODING_VIDEO)) && has_audio)
         transcoding_state = TRANSCODING_AUDIO;
+    else if (!(transcoding_state & TRANSCODING_VIDEO) && has_video)
+        transcoding_state = TRANSCODING_VIDEO;
+    else
+        transcoding_state = TRANSCODING_VIDEO|TRANSCODING_AUDIO;
+
+    vlc_mutex_lock(&device_caps_lock);
+    device_caps[caps_key] = transcoding_state;
+    vlc_mutex_unlock(&device_caps_lock);
 }
 
 bool sout_stream_sys_t::transcodingCanFallback() const
@@ -946,6 +973,31 @@ bool sout_stream_sys_t::UpdateOutput( sout_stream_t *p_stream )
     bool b_out_streams_changed = false;
     std::vector<sout_stream_id_sys_t*> new_streams;
 
+    /* Skip the configurations this device already rejected for these codecs */
+    vlc_fourcc_t i_key_video = 0, i_key_audio = 0;
+    for (std::vector<sout_stream_id_sys_t*>::iterator it = streams.begin(); it != streams.end(); ++it)
+    {
+        const es_format_t *p_es = &(*it)->fmt;
+        if (p_es->i_cat == AUDIO_ES && i_key_audio == 0)
+            i_key_audio = p_es->i_codec;
+        else if (p_es->i_cat == VIDEO_ES && i_key_video == 0 && b_supports_video)
+            i_key_video = p_es->i_codec;
+    }
+    std::stringstream sskey;
+    sskey << device << "/" << std::string((const char *)&i_key_video, 4)
+          << "/" << std::string((const char *)&i_key_audio, 4);
+    caps_key = sskey.str();
+
+    vlc_mutex_lock(&device_caps_lock);
+    std::map<std::string, int>::const_iterator caps = device_caps.find(caps_key);
+    if (caps != device_caps.end() && (transcoding_state | caps->second) != transcoding_state)
+    {
+        msg_Dbg( p_stream, "%s needed conversions before, skipping to state %d",
+                 device.c_str(), caps->second );
+        transcoding_state |= caps->second;
+    }
+    vlc_mutex_unlock(&device_caps_lock);
+
     for (std::vector<sout_stream_id_sys_t*>::iterator it = streams.begin(); it != streams.end(); ++it)
     {
         const es_format_t *p_es = &(*it)->fmt;
@@ -1216,8 +1268,10 @@ static void on_input_event_cb(void *data, enum cc_input_event event, union cc_in
             {
                 p_sys->setNextTranscodingState();
                 msg_Warn(p_stream, "Load failed detected. Switching to next "
-                         "configuration. Transcoding video%s",
-                         p_sys->transcoding_state & TRANSCODING_AUDIO ? "/audio" : "");
+                         "configuration. Transcoding %s",
+                         p_sys->transcoding_state == TRANSCODING_AUDIO ? "audio" :
+                         p_sys->transcoding_state == TRANSCODING_VIDEO ? "video" :
+                         "video/audio");
                 p_sys->out_force_reload = p_sys->es_changed = true;
             }
             break;
@@ -1279,8 +1333,8 @@ static int Open(vlc_object_t *p_this)
 
     try
     {
-        p_sys = new sout_stream_sys_t( httpd_host, p_intf, b_supports_video,
-                                                    i_local_server_port );
+        p_sys = new sout_stream_sys_t( httpd_host, p_intf, psz_ip,
+                                       b_supports_video, i_local_server_port );
     }
     catch ( std::exception& ex )
     {
@@ -0,0 +1,490 @@
+/*****************************************************************************
+ * loudness.c: EBU R128 loudness measurement stream output
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_sout.h>
+
+#include "loudness_data.h"
+
+/*****************************************************************************
+ * Exported prototypes
+ *****************************************************************************/
+static int      Open    ( vlc_object_t * );
+static void     Close   ( vlc_object_t * );
+
+static void *Add( sout_stream_t *, const es_format_t * );
+static void  Del( sout_stream_t *, void * );
+static int   Send( sout_stream_t *, void *, block_t * );
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+vlc_module_begin ()
+    set_description( N_("Loudness measurement stream output") )
+    set_capability( "sout stream", 0 )
+    add_shortcut( "loudness" )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+/*
+ * The loudness is measured as specified by ITU-R BS.1770-4 and EBU Tech 3342:
+ * the K-weighted signal energy is summed over 100 ms sub-blocks. The gated
+ * integrated loudness uses 400 ms blocks (overlapping by 75%), and the
+ * loudness range uses 3 s blocks every second. The blocks are accounted in
+ * histograms of 0.1 LU wide bins, so that memory use does not depend on the
+ * track length.
+ */
+#define LOUDNESS_MIN      (-70.) /* absolute gate (LUFS) */
+#define LOUDNESS_BINS     1000 /* up to +30 LUFS */
+#define SUBBLOCKS_MOMENTARY 4
+#define SUBBLOCKS_SHORTTERM 30
+#define SUBBLOCKS_HOP       10
+
+typedef struct
+{
+    double energy[LOUDNESS_BINS];
+    uint64_t count[LOUDNESS_BINS];
+} loudness_histogram_t;
+
+typedef struct
+{
+    double b[3], a[3];
+} biquad_t;
+
+typedef struct
+{
+    unsigned i_channels;
+    bool b_float;
+    biquad_t shelf, highpass;
+    double (*state)[4]; /* per channel: shelf then high-pass states */
+    double weights[AOUT_CHAN_MAX];
+
+    unsigned i_subblock_frames; /* frames per 100 ms */
+    unsigned i_frames; /* frames in the current sub-block */
+    double f_sum; /* current sub-block weighted energy */
+    double subblocks[SUBBLOCKS_SHORTTERM]; /* recent sub-blocks mean energy */
+    uint64_t i_subblocks;
+    double f_peak;
+} sout_stream_id_sys_t;
+
+typedef struct
+{
+    loudness_data_t *p_data;
+    sout_stream_id_sys_t *id;
+    void *token; /* ES identifier of the measured stream */
+    loudness_histogram_t momentary, shortterm;
+} sout_stream_sys_t;
+
+static double EnergyToLoudness( double f_energy )
+{
+    return -0.691 + 10. * log10( f_energy );
+}
+
+static void HistogramAdd( loudness_histogram_t *p_hist, double f_energy )
+{
+    double f_loudness = EnergyToLoudness( f_energy );
+    if( !(f_loudness >= LOUDNESS_MIN) ) /* also excludes silence and NaN */
+        return;
+
+    int i_bin = (f_loudness - LOUDNESS_MIN) * 10.;
+    if( i_bin >= LOUDNESS_BINS )
+        i_bin = LOUDNESS_BINS - 1;
+    p_hist->energy[i_bin] += f_energy;
+    p_hist->count[i_bin]++;
+}
+
+/* Returns the first histogram bin above the relative gate */
+static unsigned HistogramGate( const loudness_histogram_t *p_hist,
+                               double f_relative, uint64_t *pi_count )
+{
+    double f_energy = 0.;
+    uint64_t i_count = 0;
+
+    for( unsigned i = 0; i < LOUDNESS_BINS; i++ )
+    {
+        f_energy += p_hist->energy[i];
+        i_count += p_hist->count[i];
+    }
+    if( i_count == 0 )
+        return LOUDNESS_BINS;
+
+    double f_gate = EnergyToLoudness( f_energy / i_count ) + f_relative;
+    unsigned i_start = 0;
+    while( i_start < LOUDNESS_BINS
+        && LOUDNESS_MIN + (i_start + .5) / 10. < f_gate )
+        i_count -= p_hist->count[i_start++];
+
+    *pi_count = i_count;
+    return i_start;
+}
+
+static bool IntegratedLoudness( const loudness_histogram_t *p_hist,
+                                double *pf_loudness )
+{
+    uint64_t i_count;
+    unsigned i_start = HistogramGate( p_hist, -10., &i_count );
+    if( i_start >= LOUDNESS_BINS || i_count == 0 )
+        return false;
+
+    double f_energy = 0.;
+    for( unsigned i = i_start; i < LOUDNESS_BINS; i++ )
+        f_energy += p_hist->energy[i];
+    *pf_loudness = EnergyToLoudness( f_energy / i_count );
+    return true;
+}
+
+static double LoudnessRange( const loudness_histogram_t *p_hist )
+{
+    uint64_t i_count;
+    unsigned i_start = HistogramGate( p_hist, -20., &i_count );
+    if( i_start >= LOUDNESS_BINS || i_count == 0 )
+        return 0.;
+
+    /* Distance between the 10th and the 95th percentiles */
+    uint64_t i_low = (i_count - 1) * 10 / 100;
+    uint64_t i_high = (i_count - 1) * 95 / 100;
+    unsigned i_low_bin = i_start, i_high_bin = i_start;
+    uint64_t i_sum = 0;
+
+    for( unsigned i = i_start; i < LOUDNESS_BINS; i++ )
+    {
+        if( i_sum <= i_low )
+            i_low_bin = i;
+        if( i_sum <= i_high )
+            i_high_bin = i;
+        i_sum += p_hist->count[i];
+        if( i_sum > i_high )
+            break;
+    }
+    return (i_high_bin - i_low_bin) / 10.;
+}
+
+/*****************************************************************************
+ * K-weighting filter (ITU-R BS.1770 annex 1), adapted to the sample rate
+ *****************************************************************************/
+static void KWeightingInit( sout_stream_id_sys_t *id, unsigned i_rate )
+{
+    /* High-frequency shelving filter */
+    double f0 = 1681.974450955533;
+    double G = 3.999843853973347;
+    double Q = 0.7071752369554196;
+    double K = tan( M_PI * f0 / i_rate );
+    double Vh = pow( 10., G / 20. );
+    double Vb = pow( Vh, 0.4996667741545416 );
+    double a0 = 1. + K / Q + K * K;
+
+    id->shelf.b[0] = (Vh + Vb * K / Q + K * K) / a0;
+    id->shelf.b[1] = 2. * (K * K - Vh) / a0;
+    id->shelf.b[2] = (Vh - Vb * K / Q + K * K) / a0;
+    id->shelf.a[0] = 1.;
+    id->shelf.a[1] = 2. * (K * K - 1.) / a0;
+    id->shelf.a[2] = (1. - K / Q + K * K) / a0;
+
+    /* High-pass filter */
+    f0 = 38.13547087602444;
+    Q = 0.5003270373238773;
+    K = tan( M_PI * f0 / i_rate );
+    a0 = 1. + K / Q + K * K;
+
+    id->highpass.b[0] = 1.;
+    id->highpass.b[1] = -2.;
+    id->highpass.b[2] = 1.;
+    id->highpass.a[0] = 1.;
+    id->highpass.a[1] = 2. * (K * K - 1.) / a0;
+    id->highpass.a[2] = (1. - K / Q + K * K) / a0;
+}
+
+/* Transposed direct form II */
+static inline double Biquad( const biquad_t *f, double *s, double x )
+{
+    double y = f->b[0] * x + s[0];
+
+    s[0] = f->b[1] * x - f->a[1] * y + s[1];
+    s[1] = f->b[2] * x - f->a[2] * y;
+    return y;
+}
+
+static void ChannelWeightsInit( sout_stream_id_sys_t *id,
+                                const audio_format_t *p_fmt )
+{
+    unsigned i_chan = 0;
+
+    for( unsigned i = 0; i < id->i_channels; i++ )
+        id->weights[i] = 1.;
+
+    /* VLC channel order; surround channels are boosted, LFE is ignored */
+    for( const uint32_t *p = pi_vlc_chan_order_wg4;
+         *p && i_chan < id->i_channels; p++ )
+    {
+        if( !(p_fmt->i_physical_channels & *p) )
+            continue;
+
+        switch( *p )
+        {
+            case AOUT_CHAN_MIDDLELEFT:
+            case AOUT_CHAN_MIDDLERIGHT:
+            case AOUT_CHAN_REARLEFT:
+            case AOUT_CHAN_REARRIGHT:
+                id->weights[i_chan] = 1.41;
+                break;
+            case AOUT_CHAN_LFE:
+                id->weights[i_chan] = 0.;
+                break;
+        }
+        i_chan++;
+    }
+}
+
+/*****************************************************************************
+ * Open:
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    sout_stream_t *p_stream = (sout_stream_t*)p_this;
+    sout_stream_sys_t *p_sys;
+
+    p_stream->p_sys = p_sys = calloc( 1, sizeof(sout_stream_sys_t) );
+    if ( unlikely( ! p_sys ) ) return VLC_ENOMEM;
+    p_sys->p_data = var_InheritAddress( p_stream, "loudness-data" );
+    if ( !p_sys->p_data )
+    {
+        msg_Err( p_stream, "Loudness data holder not set" );
+        free( p_sys );
+        return VLC_ENOVAR;
+    }
+    p_sys->p_data->b_valid = false;
+
+    p_stream->pf_add  = Add;
+    p_stream->pf_del  = Del;
+    p_stream->pf_send = Send;
+    return VLC_SUCCESS;
+}
+
+static void Finish( sout_stream_t *p_stream )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    loudness_data_t *p_data = p_sys->p_data;
+
+    if( IntegratedLoudness( &p_sys->momentary, &p_data->f_integrated ) )
+    {
+        p_data->f_range = LoudnessRange( &p_sys->shortterm );
+        p_data->f_peak = p_sys->id->f_peak;
+        p_data->b_valid = true;
+        msg_Dbg( p_stream, "integrated loudness %.1f LUFS, range %.1f LU, "
+                 "peak %f", p_data->f_integrated, p_data->f_range,
+                 p_data->f_peak );
+    }
+    else
+        msg_Dbg( p_stream, "Cannot measure loudness (silence?)" );
+}
+
+/*****************************************************************************
+ * Close:
+ *****************************************************************************/
+static void Close( vlc_object_t * p_this )
+{
+    sout_stream_t *p_stream = (sout_stream_t *)p_this;
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    assert( p_sys->id == NULL );
+    free( p_sys );
+}
+
+static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    sout_stream_id_sys_t *id = NULL;
+    void *token = NULL;
+
+    if ( p_fmt->i_cat == AUDIO_ES && !p_sys->id )
+    {
+        if( (p_fmt->i_codec != VLC_CODEC_S16N
+          && p_fmt->i_codec != VLC_CODEC_FL32)
+         || p_fmt->audio.i_channels == 0
+         || p_fmt->audio.i_channels > AOUT_CHAN_MAX
+         || p_fmt->audio.i_rate == 0 )
+            msg_Warn( p_stream, "bad input format: need s16n or fl32" );
+        else
+        {
+            id = malloc( sizeof( sout_stream_id_sys_t ) );
+            if ( !id ) return NULL;
+
+            id->i_channels = p_fmt->audio.i_channels;
+            id->b_float = p_fmt->i_codec == VLC_CODEC_FL32;
+            id->state = calloc( id->i_channels, sizeof (*id->state) );
+            if( !id->state )
+            {
+                free( id );
+                return NULL;
+            }
+
+            KWeightingInit( id, p_fmt->audio.i_rate );
+            ChannelWeightsInit( id, &p_fmt->audio );
+            id->i_subblock_frames = (p_fmt->audio.i_rate + 5) / 10;
+            id->i_frames = 0;
+            id->f_sum = 0.;
+            id->i_subblocks = 0;
+            id->f_peak = 0.;
+        }
+    }
+
+    /* Pass the stream through if chained (e.g. to chromaprint) */
+    if( p_stream->p_next != NULL )
+        token = sout_StreamIdAdd( p_stream->p_next, p_fmt );
+    else
+        token = id;
+
+    if( id != NULL )
+    {
+        if( token == NULL )
+        {
+            free( id->state );
+            free( id );
+            return NULL;
+        }
+        p_sys->id = id;
+        p_sys->token = token;
+        msg_Dbg( p_stream, "Measuring loudness of %uHz %uch samples",
+                 p_fmt->audio.i_rate, id->i_channels );
+    }
+    return token;
+}
+
+static void Del( sout_stream_t *p_stream, void *token )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    sout_stream_id_sys_t *id = p_sys->id;
+
+    if( id != NULL && token == p_sys->token )
+    {
+        Finish( p_stream );
+        p_sys->id = NULL;
+        p_sys->token = NULL;
+        free( id->state );
+        free( id );
+    }
+
+    if( p_stream->p_next != NULL )
+        sout_StreamIdDel( p_stream->p_next, token );
+}
+
+/* Accounts for one complete 100 ms sub-block */
+static void SubBlockEnd( sout_stream_sys_t *p_sys, sout_stream_id_sys_t *id )
+{
+    id->subblocks[id->i_subblocks % SUBBLOCKS_SHORTTERM] =
+        id->f_sum / id->i_frames;
+    id->i_subblocks++;
+    id->i_frames = 0;
+    id->f_sum = 0.;
+
+    if( id->i_subblocks >= SUBBLOCKS_MOMENTARY )
+    {
+        double f_energy = 0.;
+        for( unsigned i = 1; i <= SUBBLOCKS_MOMENTARY; i++ )
+            f_energy += id->subblocks[(id->i_subblocks - i)
+                                      % SUBBLOCKS_SHORTTERM];
+        HistogramAdd( &p_sys->momentary, f_energy / SUBBLOCKS_MOMENTARY );
+    }
+
+    if( id->i_subblocks >= SUBBLOCKS_SHORTTERM
+     && (id->i_subblocks % SUBBLOCKS_HOP) == 0 )
+    {
+        double f_energy = 0.;
+        for( unsigned i = 0; i < SUBBLOCKS_SHORTTERM; i++ )
+            f_energy += id->subblocks[i];
+        HistogramAdd( &p_sys->shortterm, f_energy / SUBBLOCKS_SHORTTERM );
+    }
+}
+
+static void Measure( sout_stream_sys_t *p_sys, sout_stream_id_sys_t *id,
+                     const block_t *p_buf )
+{
+    const unsigned i_channels = id->i_channels;
+    const size_t i_samplesize = id->b_float ? sizeof (float)
+                                            : sizeof (int16_t);
+    size_t i_frames = p_buf->i_buffer / (i_samplesize * i_channels);
+    const float *p_fl32 = (const float *)p_buf->p_buffer;
+    const int16_t *p_s16 = (const int16_t *)p_buf->p_buffer;
+    double f_peak = id->f_peak;
+
+    while( i_frames > 0 )
+    {
+        size_t i_count = __MIN( i_frames,
+                                id->i_subblock_frames - id->i_frames );
+        double f_sum = 0.;
+
+        for( unsigned c = 0; c < i_channels; c++ )
+        {
+            double *s = id->state[c];
+            double f_chan = 0.;
+
+            for( size_t i = 0; i < i_count; i++ )
+            {
+                double x = id->b_float ? p_fl32[i * i_channels + c]
+                                : p_s16[i * i_channels + c] * (1. / 32768.);
+                if( fabs( x ) > f_peak )
+                    f_peak = fabs( x );
+
+                double y = Biquad( &id->shelf, s, x );
+                y = Biquad( &id->highpass, s + 2, y );
+                f_chan += y * y;
+            }
+            f_sum += id->weights[c] * f_chan;
+        }
+
+        p_fl32 += i_count * i_channels;
+        p_s16 += i_count * i_channels;
+        i_frames -= i_count;
+        id->f_sum += f_sum;
+        id->i_frames += i_count;
+        if( id->i_frames == id->i_subblock_frames )
+            SubBlockEnd( p_sys, id );
+    }
+    id->f_peak = f_peak;
+}
+
+static int Send( sout_stream_t *p_stream, void *token, block_t *p_buf )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    if( p_sys->id != NULL && token == p_sys->token )
+        for( const block_t *p = p_buf; p != NULL; p = p->p_next )
+            Measure( p_sys, p_sys->id, p );
+
+    if( p_stream->p_next != NULL )
+        return sout_StreamIdSend( p_stream->p_next, token, p_buf );
+
+    block_ChainRelease( p_buf );
+    return VLC_SUCCESS;
+}
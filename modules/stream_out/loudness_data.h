@@ -0,0 +1,32 @@
+/*****************************************************************************
+ * loudness_data.h: loudness stream output measurement data header
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* ReplayGain 2.0 reference level (LUFS) */
+#define LOUDNESS_REPLAYGAIN_REFERENCE (-18.)
+
+struct loudness_data_t
+{
+    bool b_valid;
+    double f_integrated; /* EBU R128 integrated loudness (LUFS) */
+    double f_range; /* EBU R128 loudness range (LU) */
+    double f_peak; /* sample peak (1.0 is full scale) */
+};
+
+typedef struct loudness_data_t loudness_data_t;
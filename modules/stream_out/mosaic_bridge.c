@@ -418,6 +418,7 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     p_es->psz_id = p_sys->psz_id;
     p_es->p_picture = NULL;
     p_es->pp_last = &p_es->p_picture;
+    p_es->p_scaled = p_es->p_scaled_src = NULL;
     p_es->b_empty = false;
 
     vlc_global_unlock( VLC_MOSAIC_MUTEX );
@@ -466,6 +467,7 @@ static void Del( sout_stream_t *p_stream, void *id )
         picture_Release( p_es->p_picture );
         p_es->p_picture = p_next;
     }
+    ReleaseScaled( p_es );
 
     for ( i = 0; i < p_bridge->i_es_num; i++ )
     {
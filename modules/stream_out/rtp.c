@@ -137,6 +137,11 @@
     "Default caching value for outbound RTP streams. This " \
     "value should be set in milliseconds." )
 
+#define WINDOW_TEXT N_("Batching window (ms)")
+#define WINDOW_LONGTEXT N_("Packets due within this interval after a " \
+    "pacing point are sent together to each destination. This reduces " \
+    "the system call overhead at the expense of pacing accuracy.")
+
 #define PROTO_TEXT N_("Transport protocol")
 #define PROTO_LONGTEXT N_( \
     "This selects which transport protocol to use for RTP." )
@@ -169,6 +174,12 @@ static const char *const ppsz_protocols[] = {
     "not receiving any RTSP request for this long. Setting it to a " \
     "negative value or zero disables timeouts. The default is 60 (one " \
     "minute)." )
+#define RTSP_SHARE_TEXT N_( "VoD sharing window (s)" )
+#define RTSP_SHARE_LONGTEXT N_( "A VoD session starting playback is " \
+    "attached to the instance of another session of the same media, if " \
+    "that instance is no further than this after the requested start. " \
+    "This saves demuxing and packetizing the media once per client. " \
+    "Zero disables sharing." )
 
 #define RTSP_USER_TEXT N_("Username")
 #define RTSP_USER_LONGTEXT N_("Username that will be " \
@@ -227,6 +238,9 @@ vlc_module_begin ()
               RTCP_MUX_TEXT, RTCP_MUX_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "caching", MS_FROM_VLC_TICK(DEFAULT_PTS_DELAY),
                  CACHING_TEXT, CACHING_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "window", 0, WINDOW_TEXT, WINDOW_LONGTEXT,
+                 true )
+        change_integer_range( 0, 1000 )
 
 #ifdef HAVE_SRTP
     add_string( SOUT_CFG_PREFIX "key", "",
@@ -250,6 +264,9 @@ vlc_module_begin ()
     add_shortcut( "rtsp" )
     add_integer( "rtsp-timeout", 60, RTSP_TIMEOUT_TEXT,
                  RTSP_TIMEOUT_LONGTEXT, true )
+    add_integer( "rtsp-share", 0, RTSP_SHARE_TEXT,
+                 RTSP_SHARE_LONGTEXT, true )
+        change_integer_range( 0, 3600 )
     add_string( "sout-rtsp-user", "",
                 RTSP_USER_TEXT, RTSP_USER_LONGTEXT, true )
     add_password("sout-rtsp-pwd", "", RTSP_PASS_TEXT, RTSP_PASS_LONGTEXT)
@@ -262,7 +279,7 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "dst", "name", "cat", "port", "port-audio", "port-video", "*sdp", "ttl",
     "mux", "sap", "description", "url", "email",
-    "proto", "rtcp-mux", "caching",
+    "proto", "rtcp-mux", "caching", "window",
 #ifdef HAVE_SRTP
     "key", "salt",
 #endif
@@ -383,6 +400,7 @@ struct sout_stream_id_sys_t
 
     block_fifo_t     *p_fifo;
     vlc_tick_t        i_caching;
+    vlc_tick_t        i_window;
 };
 
 /*****************************************************************************
@@ -979,6 +997,8 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     id->b_first_packet = true;
     id->i_caching =
         VLC_TICK_FROM_MS(var_GetInteger( p_stream, SOUT_CFG_PREFIX "caching"));
+    id->i_window =
+        VLC_TICK_FROM_MS(var_GetInteger( p_stream, SOUT_CFG_PREFIX "window"));
 
     vlc_rand_bytes (&id->i_sequence, sizeof (id->i_sequence));
     vlc_rand_bytes (id->ssrc, sizeof (id->ssrc));
@@ -1389,83 +1409,194 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/* Maximum number of packets sent at once to each destination */
+#define RTP_BATCH_MAX 64
+
+struct rtp_batch
+{
+    block_t *pending;
+    unsigned count;
+    block_t *blocks[RTP_BATCH_MAX];
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[RTP_BATCH_MAX];
+    struct iovec iovecs[RTP_BATCH_MAX];
+#endif
+};
+
+static void BatchCleanup( void *data )
+{
+    struct rtp_batch *batch = data;
+
+    for( unsigned i = 0; i < batch->count; i++ )
+        block_Release( batch->blocks[i] );
+    batch->count = 0;
+    if( batch->pending != NULL )
+        block_Release( batch->pending );
+    batch->pending = NULL;
+}
+
+static block_t *FifoTryGet( block_fifo_t *p_fifo )
+{
+    vlc_fifo_Lock( p_fifo );
+    block_t *block = vlc_fifo_DequeueUnlocked( p_fifo );
+    vlc_fifo_Unlock( p_fifo );
+    return block;
+}
+
+#ifdef HAVE_SRTP
+static block_t *ProtectPacket( sout_stream_id_sys_t *id, block_t *out )
+{   /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + 10 );
+    if( unlikely(out == NULL) )
+        return NULL;
+    out->i_buffer = len;
+
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+/* Sends packets from the batch, from the given index, to one destination.
+ * Returns the number of packets sent, or -1 on error. */
+static int SendPackets( int fd, struct rtp_batch *batch, unsigned i )
+{
+#ifdef HAVE_SENDMMSG
+    return sendmmsg( fd, batch->msgs + i, batch->count - i, 0 );
+#else
+    const block_t *out = batch->blocks[i];
+
+    return send( fd, out->p_buffer, out->i_buffer, 0 ) == -1 ? -1 : 1;
+#endif
+}
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     vlc_tick_t i_caching = id->i_caching;
+    vlc_tick_t i_window = id->i_window;
+    struct rtp_batch batch = { .pending = NULL, .count = 0 };
 
+    vlc_cleanup_push( BatchCleanup, &batch );
     for (;;)
     {
-        block_t *out = block_FifoGet( id->p_fifo );
-        block_cleanup_push (out);
+        block_t *out = batch.pending;
+
+        batch.pending = NULL;
+        if( out == NULL )
+            out = block_FifoGet( id->p_fifo );
+        batch.blocks[batch.count++] = out;
+
+        /* A single pacing decision for the batch and all destinations */
+        vlc_tick_t i_deadline = out->i_dts + i_caching;
+        vlc_tick_wait( i_deadline );
+        i_deadline += i_window;
+
+        while( batch.count < RTP_BATCH_MAX )
+        {
+            out = FifoTryGet( id->p_fifo );
+            if( out == NULL )
+                break;
+            if( out->i_dts + i_caching > i_deadline )
+            {
+                batch.pending = out;
+                break;
+            }
+            batch.blocks[batch.count++] = out;
+        }
+
+        int canc = vlc_savecancel ();
 
 #ifdef HAVE_SRTP
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
+        {
+            unsigned n = 0;
+
+            for( unsigned i = 0; i < batch.count; i++ )
             {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
+                out = ProtectPacket( id, batch.blocks[i] );
+                if( out != NULL )
+                    batch.blocks[n++] = out;
             }
-            else
-                out->i_buffer = len;
+            batch.count = n;
+        }
+#endif
+#ifdef HAVE_SENDMMSG
+        for( unsigned i = 0; i < batch.count; i++ )
+        {
+            batch.iovecs[i].iov_base = batch.blocks[i]->p_buffer;
+            batch.iovecs[i].iov_len = batch.blocks[i]->i_buffer;
+            memset( &batch.msgs[i], 0, sizeof (batch.msgs[i]) );
+            batch.msgs[i].msg_hdr.msg_iov = &batch.iovecs[i];
+            batch.msgs[i].msg_hdr.msg_iovlen = 1;
         }
-        if (out)
-            vlc_tick_wait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
-        if (out == NULL)
-            continue;
-#else
-        vlc_tick_wait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
 #endif
-
-        ssize_t len = out->i_buffer;
-        int canc = vlc_savecancel ();
 
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
         int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
 
-        for( int i = 0; i < id->sinkc; i++ )
+        for( int i = 0; i < id->sinkc && batch.count > 0; i++ )
         {
+            int fd = id->sinkv[i].rtp_fd;
+
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = 0; j < batch.count; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, batch.blocks[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
+            for( unsigned j = 0; j < batch.count; )
             {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
+                int val = SendPackets( fd, &batch, j );
+                if( val == -1 )
+                {
+                    val = 1; /* skip the failed packet */
+                    if( net_errno != EAGAIN && net_errno != EWOULDBLOCK
+                     && net_errno != ENOBUFS && net_errno != ENOMEM )
+                    {
+                        int type;
+                        getsockopt( fd, SOL_SOCKET, SO_TYPE,
+                                    &type, &(socklen_t){ sizeof(type) });
+                        if( type == SOCK_DGRAM )
+                        {   /* ICMP soft error: ignore and retry */
+                            out = batch.blocks[j];
+                            send( fd, out->p_buffer, out->i_buffer, 0 );
+                        }
+                        else
+                        {   /* Broken connection */
+                            deadv[deadc++] = fd;
+                            break;
+                        }
+                    }
+                }
+                j += val;
             }
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        if( batch.count > 0 )
+        {
+            out = batch.blocks[batch.count - 1];
+            id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        }
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+
+        for( unsigned i = 0; i < batch.count; i++ )
+            block_Release( batch.blocks[i] );
+        batch.count = 0;
 
         for( unsigned i = 0; i < deadc; i++ )
         {
@@ -1474,6 +1605,7 @@ static void* ThreadSend( void *data )
         }
         vlc_restorecancel (canc);
     }
+    vlc_cleanup_pop();
     return NULL;
 }
 
@@ -70,6 +70,8 @@ struct rtsp_stream_t
 
     vlc_tick_t      timeout;
     vlc_timer_t     timer;
+
+    vlc_tick_t      share; /* VoD instance sharing window */
 };
 
 
@@ -82,6 +84,7 @@ static int  RtspCallbackId( httpd_callback_sys_t *p_args,
 static void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session );
 
 static void RtspTimeOut( void *data );
+static void RtspInstanceStop( rtsp_stream_t *rtsp, uint64_t instance );
 
 rtsp_stream_t *RtspSetup( vlc_object_t *owner, vod_media_t *media,
                           const char *path )
@@ -102,6 +105,9 @@ rtsp_stream_t *RtspSetup( vlc_object_t *owner, vod_media_t *media,
             goto error;
     }
 
+    if (media != NULL)
+        rtsp->share = vlc_tick_from_sec(__MAX(0,var_InheritInteger(owner, "rtsp-share")));
+
     rtsp->psz_path = strdup( (path != NULL) ? path : "/" );
     if( rtsp->psz_path == NULL )
         goto error;
@@ -178,6 +184,12 @@ struct rtsp_session_t
     uint64_t       id;
     vlc_tick_t     last_seen; /* for timeouts */
 
+    /* VoD instance feeding the session, possibly started by another one */
+    uint64_t       instance;
+    bool           reader; /* attached to the instance of another session */
+    bool           paused;
+    vlc_tick_t     resume; /* NPT to resume from after leaving an instance */
+
     /* output (id-access) */
     int            trackc;
     rtsp_strack_t *trackv;
@@ -330,14 +342,11 @@ static void RtspTimeOut( void *data )
     {
         if (rtsp->sessionv[i]->last_seen + rtsp->timeout < now)
         {
-            if (rtsp->vod_media != NULL)
-            {
-                char psz_sesbuf[17];
-                snprintf( psz_sesbuf, sizeof( psz_sesbuf ), "%"PRIx64,
-                          rtsp->sessionv[i]->id );
-                vod_stop(rtsp->vod_media, psz_sesbuf);
-            }
+            uint64_t instance = rtsp->sessionv[i]->instance;
+
             RtspClientDel(rtsp, rtsp->sessionv[i]);
+            if (rtsp->vod_media != NULL)
+                RtspInstanceStop(rtsp, instance);
         }
     }
     RtspUpdateTimer(rtsp);
@@ -355,6 +364,10 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
 
     s->stream = rtsp;
     vlc_rand_bytes (&s->id, sizeof (s->id));
+    s->instance = s->id;
+    s->reader = false;
+    s->paused = false;
+    s->resume = -1;
     s->trackc = 0;
     s->trackv = NULL;
 
@@ -364,20 +377,29 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
 }
 
 
-/** rtsp must be locked */
-static
-rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
+static int RtspParseName( const char *name, uint64_t *id )
 {
     char *end;
-    uint64_t id;
-    int i;
 
     if( name == NULL )
-        return NULL;
+        return VLC_EGENERIC;
 
     errno = 0;
-    id = strtoull( name, &end, 0x10 );
+    *id = strtoull( name, &end, 0x10 );
     if( errno || *end )
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+
+/** rtsp must be locked */
+static
+rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
+{
+    uint64_t id;
+    int i;
+
+    if( RtspParseName( name, &id ) )
         return NULL;
 
     /* FIXME: use a hash/dictionary */
@@ -429,6 +451,128 @@ static int dup_socket(int oldfd)
     return newfd;
 }
 
+/** rtsp must be locked */
+static int RtspInstanceUsers( rtsp_stream_t *rtsp, uint64_t instance )
+{
+    int n = 0;
+
+    for (int i = 0; i < rtsp->sessionc; i++)
+        if (rtsp->sessionv[i]->instance == instance)
+            n++;
+    return n;
+}
+
+
+/** Stops a VoD instance once no session uses it anymore
+ * rtsp must be locked */
+static void RtspInstanceStop( rtsp_stream_t *rtsp, uint64_t instance )
+{
+    if (RtspInstanceUsers(rtsp, instance) > 0)
+        return;
+
+    char psz_instance[17];
+    snprintf( psz_instance, sizeof( psz_instance ), "%"PRIx64, instance );
+    vod_stop(rtsp->vod_media, psz_instance);
+}
+
+
+/** rtsp must be locked */
+static rtsp_strack_t *RtspSessionTrack( rtsp_session_t *session,
+                                        const rtsp_stream_id_t *id )
+{
+    for (int i = 0; i < session->trackc; i++)
+        if (session->trackv[i].id == id)
+            return session->trackv + i;
+    return NULL;
+}
+
+
+/** Attaches a VoD session that is not playing to the running instance of
+ * another session, if the instance position is within the sharing window
+ * after the requested start. The session then only gets its own sinks.
+ * rtsp must be locked */
+static bool RtspSessionJoin( rtsp_stream_t *rtsp, rtsp_session_t *ses,
+                             vlc_tick_t start, vlc_tick_t *npt )
+{
+    if (rtsp->share == 0)
+        return false;
+
+    for (int i = 0; i < ses->trackc; i++)
+        if (ses->trackv[i].sout_id != NULL)
+            return false; /* already running */
+
+    for (int i = 0; i < rtsp->sessionc; i++)
+    {
+        rtsp_session_t *host = rtsp->sessionv[i];
+        sout_stream_id_sys_t *sout_id = NULL;
+
+        if (host == ses || host->paused)
+            continue;
+
+        /* Every track set up by the session must be running */
+        for (int j = 0; j < ses->trackc; j++)
+        {
+            if (ses->trackv[j].setup_fd == -1)
+                continue;
+
+            rtsp_strack_t *tr = RtspSessionTrack(host, ses->trackv[j].id);
+            sout_id = (tr != NULL) ? tr->sout_id : NULL;
+            if (sout_id == NULL)
+                break;
+        }
+        if (sout_id == NULL)
+            continue;
+
+        vlc_tick_t pos;
+        rtp_get_ts(NULL, sout_id, NULL, NULL, &pos);
+        if (pos < start || pos > start + rtsp->share)
+            continue;
+
+        for (int j = 0; j < ses->trackc; j++)
+        {
+            rtsp_strack_t *tr = ses->trackv + j;
+            if (tr->setup_fd != -1)
+                tr->sout_id = RtspSessionTrack(host, tr->id)->sout_id;
+        }
+        ses->instance = host->instance;
+        ses->reader = true;
+        *npt = pos;
+        return true;
+    }
+    return false;
+}
+
+
+/** Detaches a VoD session from an instance that it shares with other
+ * sessions, and returns the position it left the instance at.
+ * rtsp must be locked */
+static vlc_tick_t RtspSessionLeave( rtsp_session_t *ses )
+{
+    vlc_tick_t npt = 0;
+
+    for (int i = ses->trackc - 1; i >= 0; i--)
+    {
+        rtsp_strack_t *tr = ses->trackv + i;
+        if (tr->sout_id == NULL)
+            continue;
+
+        rtp_get_ts(NULL, tr->sout_id, NULL, NULL, &npt);
+        if (tr->rtp_fd != -1)
+        {
+            rtp_del_sink(tr->sout_id, tr->rtp_fd);
+            tr->rtp_fd = -1;
+        }
+        tr->sout_id = NULL;
+        if (tr->setup_fd == -1)
+            TAB_ERASE(ses->trackc, ses->trackv, i);
+    }
+    /* The next PLAY starts a new instance */
+    vlc_rand_bytes (&ses->instance, sizeof (ses->instance));
+    ses->reader = false;
+    return npt;
+}
+
+
 /* Attach a starting VoD RTP id to its RTSP track, and let it
  * initialize with the parameters of the SETUP request */
 int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
@@ -436,24 +580,29 @@ int RtspTrackAttach( rtsp_stream_t *rtsp, const char *name,
                      uint32_t *ssrc, uint16_t *seq_init )
 {
     int val = VLC_EGENERIC;
-    rtsp_session_t *session;
+    rtsp_session_t *session = NULL;
+    uint64_t instance;
 
     vlc_mutex_lock(&rtsp->lock);
-    session = RtspClientGet(rtsp, name);
-
-    if (session == NULL)
-        goto out;
-
-    rtsp_strack_t *tr = NULL;
-    for (int i = 0; i < session->trackc; i++)
+    if (RtspParseName(name, &instance) == VLC_SUCCESS)
     {
-        if (session->trackv[i].id == id)
+        /* Only the session that started the instance has no sinks yet */
+        for (int i = 0; i < rtsp->sessionc; i++)
         {
-            tr = session->trackv + i;
-            break;
+            if (rtsp->sessionv[i]->instance == instance
+             && !rtsp->sessionv[i]->reader)
+            {
+                session = rtsp->sessionv[i];
+                break;
+            }
         }
     }
 
+    if (session == NULL)
+        goto out;
+
+    rtsp_strack_t *tr = RtspSessionTrack(session, id);
+
     if (tr != NULL)
     {
         tr->sout_id = sout_id;
@@ -492,39 +641,56 @@ out:
 }
 
 
-/* Remove references to the RTP id when it is stopped */
+/* Remove references to the RTP id when it is stopped, from every session
+ * using the instance */
 void RtspTrackDetach( rtsp_stream_t *rtsp, const char *name,
                       sout_stream_id_sys_t *sout_id )
 {
-    rtsp_session_t *session;
+    uint64_t instance;
 
     vlc_mutex_lock(&rtsp->lock);
-    session = RtspClientGet(rtsp, name);
-
-    if (session == NULL)
+    if (RtspParseName(name, &instance))
         goto out;
 
-    for (int i = 0; i < session->trackc; i++)
+    for (int s = 0; s < rtsp->sessionc; s++)
     {
-        rtsp_strack_t *tr = session->trackv + i;
-        if (tr->sout_id == sout_id)
+        rtsp_session_t *session = rtsp->sessionv[s];
+        bool running = false;
+
+        if (session->instance != instance)
+            continue;
+
+        for (int i = 0; i < session->trackc; i++)
         {
-            if (tr->setup_fd == -1)
+            rtsp_strack_t *tr = session->trackv + i;
+            if (tr->sout_id == sout_id)
             {
-                /* No (more) SETUP information: better get rid of the
-                 * track so that we can have new random ssrc and
-                 * seq_init next time. */
-                TAB_ERASE(session->trackc, session->trackv, i);
-                break;
-            }
-            /* We keep the SETUP information of the track, but stop it */
-            if (tr->rtp_fd != -1)
-            {
-                rtp_del_sink(tr->sout_id, tr->rtp_fd);
-                tr->rtp_fd = -1;
+                if (tr->setup_fd == -1)
+                {
+                    /* No (more) SETUP information: better get rid of the
+                     * track so that we can have new random ssrc and
+                     * seq_init next time. */
+                    TAB_ERASE(session->trackc, session->trackv, i);
+                    i--;
+                    continue;
+                }
+                /* We keep the SETUP information of the track, but stop it */
+                if (tr->rtp_fd != -1)
+                {
+                    rtp_del_sink(tr->sout_id, tr->rtp_fd);
+                    tr->rtp_fd = -1;
+                }
+                tr->sout_id = NULL;
             }
-            tr->sout_id = NULL;
-            break;
+            else if (tr->sout_id != NULL)
+                running = true;
+        }
+
+        /* The instance is gone: the next PLAY starts a new one */
+        if (session->reader && !running)
+        {
+            vlc_rand_bytes (&session->instance, sizeof (session->instance));
+            session->reader = false;
         }
     }
 
@@ -989,6 +1155,9 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                     break;
                 }
             }
+            char psz_instance[17];
+            bool joined = false;
+
             vlc_mutex_lock( &rtsp->lock );
             ses = RtspClientGet( rtsp, psz_session );
             if( ses != NULL )
@@ -1002,6 +1171,19 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                 sout_stream_id_sys_t *sout_id = NULL;
                 if (vod)
                 {
+                    if (id == NULL)
+                    {
+                        if (start < 0)
+                            start = ses->resume;
+                        ses->resume = -1;
+                        ses->paused = false;
+                        if (end < 0)
+                            joined = RtspSessionJoin(rtsp, ses,
+                                                     __MAX(start, 0), &npt);
+                    }
+                    snprintf( psz_instance, sizeof( psz_instance ),
+                              "%"PRIx64, ses->instance );
+
                     /* We don't keep a reference to the sout_stream_t,
                      * so we check if a sout_id is available instead. */
                     for (int i = 0; i < ses->trackc; i++)
@@ -1012,7 +1194,8 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
                     }
                 }
                 vlc_tick_t ts = rtp_get_ts(vod ? NULL : (sout_stream_t *)owner,
-                                        sout_id, rtsp->vod_media, psz_session,
+                                        sout_id, rtsp->vod_media,
+                                        vod ? psz_instance : psz_session,
                                         vod ? NULL : &npt);
 
                 for( int i = 0; i < ses->trackc; i++ )
@@ -1066,9 +1249,9 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
 
             if (ses != NULL)
             {
-                if (vod)
+                if (vod && !joined)
                 {
-                    vod_play(rtsp->vod_media, psz_session, &start, end);
+                    vod_play(rtsp->vod_media, psz_instance, &start, end);
                     npt = start;
                 }
 
@@ -1092,12 +1275,30 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             }
 
             rtsp_session_t *ses;
+            char psz_instance[17];
+            vlc_tick_t npt = -1;
+
             answer->i_status = 200;
             psz_session = httpd_MsgGet( query, "Session" );
             vlc_mutex_lock( &rtsp->lock );
             ses = RtspClientGet( rtsp, psz_session );
             if (ses != NULL)
             {
+                if (id == NULL && vod)
+                {
+                    if (RtspInstanceUsers(rtsp, ses->instance) > 1)
+                    {
+                        /* Leave the shared instance, and resume on our
+                         * own instance later */
+                        npt = RtspSessionLeave(ses);
+                        ses->resume = npt;
+                    }
+                    else
+                        ses->paused = true;
+                    snprintf( psz_instance, sizeof( psz_instance ),
+                              "%"PRIx64, ses->instance );
+                }
+
                 if (id != NULL) /* "Mute" the selected track */
                 {
                     bool found = false;
@@ -1128,8 +1329,11 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             if (ses != NULL && id == NULL)
             {
                 assert(vod);
-                vlc_tick_t npt = 0;
-                vod_pause(rtsp->vod_media, psz_session, &npt);
+                if (npt < 0)
+                {
+                    npt = 0;
+                    vod_pause(rtsp->vod_media, psz_instance, &npt);
+                }
                 double f_npt = secf_from_vlc_tick(npt);
                 httpd_MsgAdd( answer, "Range", "npt=%f-", f_npt );
             }
@@ -1168,9 +1372,11 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             {
                 if( id == NULL ) /* Delete the entire session */
                 {
+                    uint64_t instance = ses->instance;
+
                     RtspClientDel( rtsp, ses );
                     if (vod)
-                        vod_stop(rtsp->vod_media, psz_session);
+                        RtspInstanceStop(rtsp, instance);
                     RtspUpdateTimer(rtsp);
                 }
                 else /* Delete one track from the session */
@@ -36,6 +36,12 @@
  *
  * the video-data and audio-data pointers will be passed to lock/unlock function
  *
+ * Alternatively, the lend callbacks receive the buffers of the stream output
+ * themselves, without copy. The application must give each buffer back with
+ * the release function passed along, once done with it. At most max-lent
+ * buffers per elementary stream are held by the application, further buffers
+ * are dropped until some are released.
+ *
  ******************************************************************************/
 
 /*****************************************************************************
@@ -46,6 +52,8 @@
 # include "config.h"
 #endif
 
+#include <stdatomic.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
@@ -79,6 +87,18 @@
 #define T_AUDIO_DATA N_( "Audio callback data" )
 #define LT_AUDIO_DATA N_( "Data for the audio callback function." )
 
+#define T_VIDEO_LEND_CALLBACK N_( "Video lend callback" )
+#define LT_VIDEO_LEND_CALLBACK N_( "Address of the video lend callback function. " \
+                                   "This function will be given the buffers without copy." )
+
+#define T_AUDIO_LEND_CALLBACK N_( "Audio lend callback" )
+#define LT_AUDIO_LEND_CALLBACK N_( "Address of the audio lend callback function. " \
+                                   "This function will be given the buffers without copy." )
+
+#define T_MAX_LENT N_( "Maximum lent buffers" )
+#define LT_MAX_LENT N_( "Maximum number of buffers held by the application " \
+                        "at once, per elementary stream, with the lend callbacks." )
+
 #define T_TIME_SYNC N_( "Time Synchronized output" )
 #define LT_TIME_SYNC N_( "Time Synchronisation option for output. " \
                         "If true, stream will render as usual, else " \
@@ -110,6 +130,11 @@ vlc_module_begin ()
         change_volatile()
     add_string( SOUT_PREFIX_AUDIO "data", "0", T_AUDIO_DATA, LT_VIDEO_DATA, true )
         change_volatile()
+    add_string( SOUT_PREFIX_VIDEO "lend-callback", "0", T_VIDEO_LEND_CALLBACK, LT_VIDEO_LEND_CALLBACK, true )
+        change_volatile()
+    add_string( SOUT_PREFIX_AUDIO "lend-callback", "0", T_AUDIO_LEND_CALLBACK, LT_AUDIO_LEND_CALLBACK, true )
+        change_volatile()
+    add_integer_with_range( SOUT_CFG_PREFIX "max-lent", 4, 1, 256, T_MAX_LENT, LT_MAX_LENT, true )
     add_bool( SOUT_CFG_PREFIX "time-sync", true, T_TIME_SYNC, LT_TIME_SYNC, true )
         change_private()
     set_callbacks( Open, Close )
@@ -121,7 +146,8 @@ vlc_module_end ()
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
     "video-prerender-callback", "audio-prerender-callback",
-    "video-postrender-callback", "audio-postrender-callback", "video-data", "audio-data", "time-sync", NULL
+    "video-postrender-callback", "audio-postrender-callback", "video-data", "audio-data",
+    "video-lend-callback", "audio-lend-callback", "max-lent", "time-sync", NULL
 };
 
 static void *Add( sout_stream_t *, const es_format_t * );
@@ -134,10 +160,24 @@ static void *AddAudio( sout_stream_t *p_stream, const es_format_t *p_fmt );
 static int SendVideo( sout_stream_t *p_stream, void *id, block_t *p_buffer );
 static int SendAudio( sout_stream_t *p_stream, void *id, block_t *p_buffer );
 
+/* One reference for the elementary stream, plus one per lent buffer */
+typedef struct
+{
+    atomic_uint refs;
+} smem_lender_t;
+
+typedef struct
+{
+    block_t *p_block;
+    smem_lender_t *p_lender;
+} smem_lent_t;
+
 typedef struct
 {
     es_format_t format;
     void *p_data;
+    smem_lender_t *p_lender;
+    bool b_dropping;
 } sout_stream_id_sys_t;
 
 typedef struct
@@ -147,6 +187,9 @@ typedef struct
     void ( *pf_audio_prerender_callback ) ( void* p_audio_data, uint8_t** pp_pcm_buffer, size_t size );
     void ( *pf_video_postrender_callback ) ( void* p_video_data, uint8_t* p_pixel_buffer, int width, int height, int pixel_pitch, size_t size, vlc_tick_t pts );
     void ( *pf_audio_postrender_callback ) ( void* p_audio_data, uint8_t* p_pcm_buffer, unsigned int channels, unsigned int rate, unsigned int nb_samples, unsigned int bits_per_sample, size_t size, vlc_tick_t pts );
+    void ( *pf_video_lend_callback ) ( void* p_video_data, void* p_handle, void ( *pf_release ) ( void* ), uint8_t* p_pixel_buffer, int width, int height, int pixel_pitch, size_t size, vlc_tick_t pts );
+    void ( *pf_audio_lend_callback ) ( void* p_audio_data, void* p_handle, void ( *pf_release ) ( void* ), uint8_t* p_pcm_buffer, unsigned int channels, unsigned int rate, unsigned int nb_samples, unsigned int bits_per_sample, size_t size, vlc_tick_t pts );
+    unsigned i_max_lent;
     bool time_sync;
 } sout_stream_sys_t;
 
@@ -232,6 +275,19 @@ static int Open( vlc_object_t *p_this )
     if (p_sys->pf_audio_postrender_callback == NULL)
         p_sys->pf_audio_postrender_callback = AudioPostrenderDefaultCallback;
 
+    /* The lend callbacks are optional, and replace the render ones */
+    psz_tmp = var_GetString( p_stream, SOUT_PREFIX_VIDEO "lend-callback" );
+    p_sys->pf_video_lend_callback = (void (*) (void*, void*, void (*) (void*), uint8_t*, int, int, int, size_t, vlc_tick_t))(intptr_t)atoll( psz_tmp );
+    free( psz_tmp );
+
+    psz_tmp = var_GetString( p_stream, SOUT_PREFIX_AUDIO "lend-callback" );
+    p_sys->pf_audio_lend_callback = (void (*) (void*, void*, void (*) (void*), uint8_t*, unsigned int, unsigned int, unsigned int, unsigned int, size_t, vlc_tick_t))(intptr_t)atoll( psz_tmp );
+    free( psz_tmp );
+
+    p_sys->i_max_lent = var_GetInteger( p_stream, SOUT_CFG_PREFIX "max-lent" );
+    if( p_sys->i_max_lent == 0 )
+        p_sys->i_max_lent = 1;
+
     /* Setting stream out module callbacks */
     p_stream->pf_add    = Add;
     p_stream->pf_del    = Del;
@@ -261,6 +317,74 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     return id;
 }
 
+/*****************************************************************************
+ * Lent buffers
+ *****************************************************************************/
+static int NewLender( sout_stream_id_sys_t *id )
+{
+    id->p_lender = malloc( sizeof( *id->p_lender ) );
+    if( !id->p_lender )
+        return VLC_ENOMEM;
+    atomic_init( &id->p_lender->refs, 1 );
+    id->b_dropping = false;
+    return VLC_SUCCESS;
+}
+
+static void ReleaseLender( smem_lender_t *p_lender )
+{
+    if( atomic_fetch_sub_explicit( &p_lender->refs, 1,
+                                   memory_order_acq_rel ) == 1 )
+        free( p_lender );
+}
+
+/* Called by the application, from any thread */
+static void ReleaseLent( void *p_handle )
+{
+    smem_lent_t *p_lent = p_handle;
+
+    block_Release( p_lent->p_block );
+    ReleaseLender( p_lent->p_lender );
+    free( p_lent );
+}
+
+static smem_lent_t *Lend( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                          block_t *p_buffer )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    unsigned i_lent = atomic_load_explicit( &id->p_lender->refs,
+                                            memory_order_relaxed ) - 1;
+
+    if( i_lent >= p_sys->i_max_lent )
+    {
+        if( !id->b_dropping )
+            msg_Warn( p_stream, "%u buffers held by the application, "
+                      "dropping", i_lent );
+        id->b_dropping = true;
+        block_ChainRelease( p_buffer );
+        return NULL;
+    }
+    id->b_dropping = false;
+
+    smem_lent_t *p_lent = malloc( sizeof( *p_lent ) );
+    if( !p_lent )
+    {
+        block_ChainRelease( p_buffer );
+        return NULL;
+    }
+
+    /* The callbacks are given a single contiguous buffer */
+    p_lent->p_block = block_ChainGather( p_buffer );
+    if( !p_lent->p_block )
+    {
+        block_ChainRelease( p_buffer );
+        free( p_lent );
+        return NULL;
+    }
+    p_lent->p_lender = id->p_lender;
+    atomic_fetch_add_explicit( &id->p_lender->refs, 1, memory_order_relaxed );
+    return p_lent;
+}
+
 static void *AddVideo( sout_stream_t *p_stream, const es_format_t *p_fmt )
 {
     char* psz_tmp;
@@ -305,6 +429,13 @@ static void *AddVideo( sout_stream_t *p_stream, const es_format_t *p_fmt )
     id->p_data = (void *)( intptr_t )atoll( psz_tmp );
     free( psz_tmp );
 
+    if( ((sout_stream_sys_t *)p_stream->p_sys)->pf_video_lend_callback != NULL
+     && NewLender( id ) )
+    {
+        free( id );
+        return NULL;
+    }
+
     es_format_Copy( &id->format, p_fmt );
     id->format.video.i_bits_per_pixel = i_bits_per_pixel;
     return id;
@@ -330,6 +461,13 @@ static void *AddAudio( sout_stream_t *p_stream, const es_format_t *p_fmt )
     id->p_data = (void *)( intptr_t )atoll( psz_tmp );
     free( psz_tmp );
 
+    if( ((sout_stream_sys_t *)p_stream->p_sys)->pf_audio_lend_callback != NULL
+     && NewLender( id ) )
+    {
+        free( id );
+        return NULL;
+    }
+
     es_format_Copy( &id->format, p_fmt );
     id->format.audio.i_bitspersample = i_bits_per_sample;
     return id;
@@ -339,6 +477,8 @@ static void Del( sout_stream_t *p_stream, void *_id )
 {
     VLC_UNUSED( p_stream );
     sout_stream_id_sys_t *id = (sout_stream_id_sys_t *)_id;
+    if( id->p_lender )
+        ReleaseLender( id->p_lender );
     es_format_Clean( &id->format );
     free( id );
 }
@@ -360,6 +500,21 @@ static int SendVideo( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
     size_t i_size = p_buffer->i_buffer;
     uint8_t* p_pixels = NULL;
 
+    if( id->p_lender )
+    {
+        smem_lent_t *p_lent = Lend( p_stream, id, p_buffer );
+        if( !p_lent )
+            return VLC_SUCCESS;
+
+        block_t *p_block = p_lent->p_block;
+        p_sys->pf_video_lend_callback( id->p_data, p_lent, ReleaseLent,
+                                       p_block->p_buffer,
+                                       id->format.video.i_width, id->format.video.i_height,
+                                       id->format.video.i_bits_per_pixel,
+                                       p_block->i_buffer, p_block->i_pts );
+        return VLC_SUCCESS;
+    }
+
     /* Calling the prerender callback to get user buffer */
     p_sys->pf_video_prerender_callback( id->p_data, &p_pixels, i_size );
 
@@ -396,6 +551,22 @@ static int SendAudio( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
         return VLC_EGENERIC;
     }
 
+    if( id->p_lender )
+    {
+        smem_lent_t *p_lent = Lend( p_stream, id, p_buffer );
+        if( !p_lent )
+            return VLC_SUCCESS;
+
+        block_t *p_block = p_lent->p_block;
+        i_samples = p_block->i_buffer / ( ( id->format.audio.i_bitspersample / 8 ) * id->format.audio.i_channels );
+        p_sys->pf_audio_lend_callback( id->p_data, p_lent, ReleaseLent,
+                                       p_block->p_buffer,
+                                       id->format.audio.i_channels, id->format.audio.i_rate, i_samples,
+                                       id->format.audio.i_bitspersample,
+                                       p_block->i_buffer, p_block->i_pts );
+        return VLC_SUCCESS;
+    }
+
     i_samples = i_size / ( ( id->format.audio.i_bitspersample / 8 ) * id->format.audio.i_channels );
     /* Calling the prerender callback to get user buffer */
     p_sys->pf_audio_prerender_callback( id->p_data, &p_pcm_buffer, i_size );
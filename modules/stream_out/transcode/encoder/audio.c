@@ -56,12 +56,472 @@ static const int pi_channels_maps[9] =
      | AOUT_CHAN_LFE,
 };
 
+/*
+ * Parallel encoding of the audio chunks
+ *
+ * The input is cut into chunks of BATCH_CHUNK_SAMPLES, each encoded from
+ * scratch by its own encoder instance on a worker thread. A chunk is encoded
+ * with BATCH_LEAD_SAMPLES of the previous chunk before it, so that the
+ * encoder state has converged at the chunk start, and of the next chunk
+ * after it, so that its last frames are complete. Only the output blocks
+ * starting within the chunk itself are kept; the encoders frame the samples
+ * on the grid of the pts of their first input, which is aligned to the
+ * frame size for all chunks. The chunks are output in order.
+ *
+ * The main encoder instance is only used to provide the stream headers
+ * (extra data, pre-skip) to the muxer.
+ */
+
+#define BATCH_LEAD_SAMPLES  46080 /* multiple of 960, 1024, 1152 and 1536 */
+#define BATCH_CHUNK_SAMPLES (12 * BATCH_LEAD_SAMPLES)
+#define BATCH_SLICE_SAMPLES 4608
+
+typedef struct audio_chunk_t audio_chunk_t;
+
+struct audio_chunk_t
+{
+    block_t     *p_pcm;      /* lead-in, body and lead-out samples */
+    size_t      i_samples;   /* samples in p_pcm */
+    size_t      i_lead_in;
+    size_t      i_lead_out;
+    vlc_tick_t  i_start;     /* range of the kept output blocks pts */
+    vlc_tick_t  i_end;
+
+    block_t     *p_out;
+    block_t     **pp_out_last;
+    bool        b_done;
+    audio_chunk_t *p_next;
+};
+
+typedef struct
+{
+    transcode_audio_batch_t *p_batch;
+    encoder_t   *p_encoder;
+    vlc_thread_t thread;
+} audio_worker_t;
+
+struct transcode_audio_batch_t
+{
+    const transcode_encoder_config_t *p_cfg;
+    es_format_t fmt_in;    /* formats to open the chunks encoders */
+    es_format_t fmt_out;
+    size_t      i_bytes_per_frame;
+
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;      /* chunk to encode, or quit */
+    vlc_cond_t  done;      /* chunk encoded */
+    audio_chunk_t *p_first; /* submitted chunks, in output order */
+    audio_chunk_t **pp_last;
+    audio_chunk_t *p_todo; /* first chunk not taken by a worker */
+    unsigned    i_pending; /* submitted chunks, not output yet */
+    bool        b_quit;
+
+    /* transcode thread only */
+    audio_chunk_t *p_filling; /* chunk body being filled */
+    audio_chunk_t *p_leadout; /* full chunk, waiting for its lead-out */
+    vlc_tick_t  i_first_pts;
+    uint64_t    i_samples;     /* samples since i_first_pts */
+
+    unsigned    i_threads;
+    audio_worker_t workers[];
+};
+
+static bool encoder_audio_batch_allowed( vlc_fourcc_t i_codec )
+{
+    /* The chunks are stitched at frame boundaries: their frames must not
+     * refer to the previous ones nor count them (FLAC frame numbers and
+     * STREAMINFO, Vorbis block sizes, MPEG audio bit reservoir) */
+    switch( i_codec )
+    {
+        case VLC_CODEC_OPUS:
+        case VLC_CODEC_MP4A:
+        case VLC_CODEC_A52:
+        case VLC_CODEC_EAC3:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void batch_slice_free( block_t *p_block )
+{
+    /* the slices point into the chunk samples */
+    VLC_UNUSED( p_block );
+}
+
+static const struct vlc_block_callbacks batch_slice_cbs =
+{
+    batch_slice_free,
+};
+
+static void batch_chunk_output( audio_chunk_t *p_chunk, block_t *p_blocks )
+{
+    while( p_blocks )
+    {
+        block_t *p_next = p_blocks->p_next;
+        p_blocks->p_next = NULL;
+
+        /* drop the frames belonging to the neighbour chunks */
+        if( p_blocks->i_pts != VLC_TICK_INVALID &&
+            ( p_blocks->i_pts < p_chunk->i_start ||
+              p_blocks->i_pts >= p_chunk->i_end ) )
+            block_Release( p_blocks );
+        else
+            block_ChainLastAppend( &p_chunk->pp_out_last, p_blocks );
+        p_blocks = p_next;
+    }
+}
+
+static void batch_chunk_encode( audio_worker_t *p_worker,
+                                audio_chunk_t *p_chunk )
+{
+    transcode_audio_batch_t *p_batch = p_worker->p_batch;
+    encoder_t *p_encoder = p_worker->p_encoder;
+
+    es_format_Copy( &p_encoder->fmt_in, &p_batch->fmt_in );
+    es_format_Copy( &p_encoder->fmt_out, &p_batch->fmt_out );
+    p_encoder->p_cfg = p_batch->p_cfg->p_config_chain;
+
+    p_encoder->p_module = module_need( p_encoder, "encoder",
+                                       p_batch->p_cfg->psz_name, true );
+    if( !p_encoder->p_module )
+    {
+        msg_Err( p_encoder, "cannot open the chunk audio encoder, "
+                            "dropping %zu samples",
+                 p_chunk->i_samples - p_chunk->i_lead_in - p_chunk->i_lead_out );
+        goto end;
+    }
+
+    const unsigned i_rate = p_batch->fmt_in.audio.i_rate;
+    for( size_t i = 0; i < p_chunk->i_samples; i += BATCH_SLICE_SAMPLES )
+    {
+        size_t i_count = __MIN( p_chunk->i_samples - i, BATCH_SLICE_SAMPLES );
+        block_t slice;
+
+        block_Init( &slice, &batch_slice_cbs,
+                    &p_chunk->p_pcm->p_buffer[i * p_batch->i_bytes_per_frame],
+                    i_count * p_batch->i_bytes_per_frame );
+        slice.i_nb_samples = i_count;
+        slice.i_pts = slice.i_dts = p_chunk->p_pcm->i_pts +
+                                    vlc_tick_from_samples( i, i_rate );
+        slice.i_length = vlc_tick_from_samples( i_count, i_rate );
+
+        batch_chunk_output( p_chunk,
+                            p_encoder->pf_encode_audio( p_encoder, &slice ) );
+    }
+
+    block_t *p_block;
+    while( ( p_block = p_encoder->pf_encode_audio( p_encoder, NULL ) ) )
+        batch_chunk_output( p_chunk, p_block );
+
+    module_unneed( p_encoder, p_encoder->p_module );
+    p_encoder->p_module = NULL;
+
+end:
+    es_format_Clean( &p_encoder->fmt_in );
+    es_format_Clean( &p_encoder->fmt_out );
+    block_Release( p_chunk->p_pcm );
+    p_chunk->p_pcm = NULL;
+}
+
+static void *batch_worker_thread( void *data )
+{
+    audio_worker_t *p_worker = data;
+    transcode_audio_batch_t *p_batch = p_worker->p_batch;
+
+    vlc_mutex_lock( &p_batch->lock );
+    for( ;; )
+    {
+        while( !p_batch->p_todo && !p_batch->b_quit )
+            vlc_cond_wait( &p_batch->wait, &p_batch->lock );
+        if( !p_batch->p_todo )
+            break;
+
+        audio_chunk_t *p_chunk = p_batch->p_todo;
+        p_batch->p_todo = p_chunk->p_next;
+        vlc_mutex_unlock( &p_batch->lock );
+
+        batch_chunk_encode( p_worker, p_chunk );
+
+        vlc_mutex_lock( &p_batch->lock );
+        p_chunk->b_done = true;
+        vlc_cond_broadcast( &p_batch->done );
+    }
+    vlc_mutex_unlock( &p_batch->lock );
+    return NULL;
+}
+
+static audio_chunk_t *batch_chunk_new( transcode_audio_batch_t *p_batch,
+                                       const audio_chunk_t *p_prev )
+{
+    audio_chunk_t *p_chunk = malloc( sizeof(*p_chunk) );
+    if( !p_chunk )
+        return NULL;
+
+    size_t i_lead_in = p_prev ? BATCH_LEAD_SAMPLES : 0;
+    p_chunk->p_pcm = block_Alloc( ( i_lead_in + BATCH_CHUNK_SAMPLES +
+                                    BATCH_LEAD_SAMPLES ) *
+                                  p_batch->i_bytes_per_frame );
+    if( !p_chunk->p_pcm )
+    {
+        free( p_chunk );
+        return NULL;
+    }
+
+    const unsigned i_rate = p_batch->fmt_in.audio.i_rate;
+    /* Half a sample before the boundary, as the encoders round the frames
+     * pts on their own */
+    const vlc_tick_t i_margin = vlc_tick_from_samples( 1, 2 * i_rate );
+    p_chunk->i_samples = i_lead_in;
+    p_chunk->i_lead_in = i_lead_in;
+    p_chunk->i_lead_out = 0;
+    p_chunk->i_start = p_batch->i_first_pts - i_margin +
+                       vlc_tick_from_samples( p_batch->i_samples, i_rate );
+    p_chunk->i_end = p_batch->i_first_pts - i_margin +
+        vlc_tick_from_samples( p_batch->i_samples + BATCH_CHUNK_SAMPLES, i_rate );
+    p_chunk->p_pcm->i_pts = p_batch->i_first_pts +
+        vlc_tick_from_samples( p_batch->i_samples - i_lead_in, i_rate );
+    if( !p_prev )
+        p_chunk->i_start = INT64_MIN; /* keep the encoder delay */
+    else
+        memcpy( p_chunk->p_pcm->p_buffer,
+                &p_prev->p_pcm->p_buffer[( p_prev->i_samples - i_lead_in ) *
+                                         p_batch->i_bytes_per_frame],
+                i_lead_in * p_batch->i_bytes_per_frame );
+
+    p_chunk->p_out = NULL;
+    p_chunk->pp_out_last = &p_chunk->p_out;
+    p_chunk->b_done = false;
+    p_chunk->p_next = NULL;
+    return p_chunk;
+}
+
+static void batch_chunk_submit( transcode_audio_batch_t *p_batch,
+                                audio_chunk_t *p_chunk )
+{
+    vlc_mutex_lock( &p_batch->lock );
+    *p_batch->pp_last = p_chunk;
+    p_batch->pp_last = &p_chunk->p_next;
+    if( !p_batch->p_todo )
+        p_batch->p_todo = p_chunk;
+    p_batch->i_pending++;
+    vlc_cond_signal( &p_batch->wait );
+    vlc_mutex_unlock( &p_batch->lock );
+}
+
+/* Outputs the encoded chunks in order, waiting until at most i_max chunks
+ * are pending */
+static block_t *batch_collect( transcode_audio_batch_t *p_batch,
+                               unsigned i_max )
+{
+    block_t *p_out = NULL, **pp_out_last = &p_out;
+
+    vlc_mutex_lock( &p_batch->lock );
+    while( p_batch->p_first &&
+           ( p_batch->p_first->b_done || p_batch->i_pending > i_max ) )
+    {
+        audio_chunk_t *p_chunk = p_batch->p_first;
+        if( !p_chunk->b_done )
+        {
+            vlc_cond_wait( &p_batch->done, &p_batch->lock );
+            continue;
+        }
+
+        p_batch->p_first = p_chunk->p_next;
+        if( !p_batch->p_first )
+            p_batch->pp_last = &p_batch->p_first;
+        p_batch->i_pending--;
+
+        if( p_chunk->p_out )
+        {
+            *pp_out_last = p_chunk->p_out;
+            pp_out_last = p_chunk->pp_out_last;
+        }
+        free( p_chunk );
+    }
+    vlc_mutex_unlock( &p_batch->lock );
+    return p_out;
+}
+
+static block_t *batch_encode( transcode_audio_batch_t *p_batch,
+                              const block_t *p_in )
+{
+    const size_t i_bpf = p_batch->i_bytes_per_frame;
+    const uint8_t *p_data = p_in->p_buffer;
+    size_t i_left = __MIN( p_in->i_nb_samples, p_in->i_buffer / i_bpf );
+
+    if( !p_batch->p_filling )
+    {
+        if( p_in->i_pts == VLC_TICK_INVALID )
+            return NULL;
+        p_batch->i_first_pts = p_in->i_pts;
+        p_batch->i_samples = 0;
+        p_batch->p_filling = batch_chunk_new( p_batch, NULL );
+        if( !p_batch->p_filling )
+            return NULL;
+    }
+
+    while( i_left > 0 )
+    {
+        audio_chunk_t *p_chunk = p_batch->p_filling;
+        audio_chunk_t *p_leadout = p_batch->p_leadout;
+        size_t i_body = p_chunk->i_samples - p_chunk->i_lead_in;
+        size_t i_count = __MIN( i_left, BATCH_CHUNK_SAMPLES - i_body );
+
+        if( p_leadout )
+        {
+            i_count = __MIN( i_count, BATCH_LEAD_SAMPLES - p_leadout->i_lead_out );
+            memcpy( &p_leadout->p_pcm->p_buffer[p_leadout->i_samples * i_bpf],
+                    p_data, i_count * i_bpf );
+            p_leadout->i_samples += i_count;
+            p_leadout->i_lead_out += i_count;
+            if( p_leadout->i_lead_out == BATCH_LEAD_SAMPLES )
+            {
+                batch_chunk_submit( p_batch, p_leadout );
+                p_batch->p_leadout = NULL;
+            }
+        }
+
+        memcpy( &p_chunk->p_pcm->p_buffer[p_chunk->i_samples * i_bpf],
+                p_data, i_count * i_bpf );
+        p_chunk->i_samples += i_count;
+        p_batch->i_samples += i_count;
+        p_data += i_count * i_bpf;
+        i_left -= i_count;
+
+        if( p_chunk->i_samples - p_chunk->i_lead_in == BATCH_CHUNK_SAMPLES )
+        {
+            audio_chunk_t *p_next = batch_chunk_new( p_batch, p_chunk );
+            if( !p_next )
+                break;
+            p_batch->p_leadout = p_chunk;
+            p_batch->p_filling = p_next;
+        }
+    }
+
+    return batch_collect( p_batch, 2 * p_batch->i_threads );
+}
+
+static block_t *batch_drain( transcode_audio_batch_t *p_batch )
+{
+    audio_chunk_t *p_chunk = p_batch->p_filling;
+    audio_chunk_t *p_leadout = p_batch->p_leadout;
+
+    if( p_chunk && p_chunk->i_samples == p_chunk->i_lead_in )
+    {
+        /* nothing after the previous chunk */
+        block_Release( p_chunk->p_pcm );
+        free( p_chunk );
+        p_chunk = NULL;
+    }
+
+    if( p_leadout )
+    {
+        if( !p_chunk )
+            p_leadout->i_end = INT64_MAX;
+        batch_chunk_submit( p_batch, p_leadout );
+    }
+    if( p_chunk )
+    {
+        p_chunk->i_end = INT64_MAX;
+        batch_chunk_submit( p_batch, p_chunk );
+    }
+
+    p_batch->p_filling = NULL;
+    p_batch->p_leadout = NULL;
+    return batch_collect( p_batch, 0 );
+}
+
+static void batch_delete( transcode_audio_batch_t *p_batch, unsigned i_threads )
+{
+    vlc_mutex_lock( &p_batch->lock );
+    p_batch->b_quit = true;
+    vlc_cond_broadcast( &p_batch->wait );
+    vlc_mutex_unlock( &p_batch->lock );
+
+    for( unsigned i = 0; i < i_threads; i++ )
+        vlc_join( p_batch->workers[i].thread, NULL );
+    for( unsigned i = 0; i < p_batch->i_threads; i++ )
+        vlc_object_delete( p_batch->workers[i].p_encoder );
+
+    /* the workers encoded all the submitted chunks before quitting */
+    block_ChainRelease( batch_collect( p_batch, 0 ) );
+    if( p_batch->p_leadout )
+    {
+        block_Release( p_batch->p_leadout->p_pcm );
+        free( p_batch->p_leadout );
+    }
+    if( p_batch->p_filling )
+    {
+        block_Release( p_batch->p_filling->p_pcm );
+        free( p_batch->p_filling );
+    }
+
+    es_format_Clean( &p_batch->fmt_in );
+    es_format_Clean( &p_batch->fmt_out );
+    free( p_batch );
+}
+
+static transcode_audio_batch_t *batch_new( encoder_t *p_main,
+                                           const transcode_encoder_config_t *p_cfg,
+                                           const es_format_t *p_fmt_out )
+{
+    unsigned i_threads = p_cfg->audio.i_threads;
+    transcode_audio_batch_t *p_batch =
+        calloc( 1, sizeof(*p_batch) + i_threads * sizeof(audio_worker_t) );
+    if( !p_batch )
+        return NULL;
+
+    p_batch->p_cfg = p_cfg;
+    es_format_Copy( &p_batch->fmt_in, &p_main->fmt_in );
+    es_format_Copy( &p_batch->fmt_out, p_fmt_out );
+    p_batch->i_bytes_per_frame = p_main->fmt_in.audio.i_bytes_per_frame;
+    vlc_mutex_init( &p_batch->lock );
+    vlc_cond_init( &p_batch->wait );
+    vlc_cond_init( &p_batch->done );
+    p_batch->pp_last = &p_batch->p_first;
+
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        audio_worker_t *p_worker = &p_batch->workers[i];
+
+        p_worker->p_batch = p_batch;
+        p_worker->p_encoder = sout_EncoderCreate( p_main, sizeof(encoder_t) );
+        if( !p_worker->p_encoder )
+        {
+            batch_delete( p_batch, 0 );
+            return NULL;
+        }
+        p_worker->p_encoder->p_module = NULL;
+        p_batch->i_threads++;
+    }
+
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        audio_worker_t *p_worker = &p_batch->workers[i];
+        if( vlc_clone( &p_worker->thread, batch_worker_thread, p_worker,
+                       VLC_THREAD_PRIORITY_LOW ) )
+        {
+            batch_delete( p_batch, i );
+            return NULL;
+        }
+    }
+
+    msg_Dbg( p_main, "encoding the audio in chunks of %u samples on %u threads",
+             BATCH_CHUNK_SAMPLES, i_threads );
+    return p_batch;
+}
+
 int transcode_encoder_audio_open( transcode_encoder_t *p_enc,
                                   const transcode_encoder_config_t *p_cfg )
 {
     p_enc->p_encoder->p_cfg = p_cfg->p_config_chain;
     p_enc->p_encoder->fmt_out.i_codec = p_cfg->i_codec;
 
+    /* format requested from the chunks encoders */
+    es_format_t fmt_out;
+    es_format_Copy( &fmt_out, &p_enc->p_encoder->fmt_out );
+
     p_enc->p_encoder->p_module = module_need( p_enc->p_encoder, "encoder",
                                               p_cfg->psz_name, true );
 
@@ -69,11 +529,36 @@ int transcode_encoder_audio_open( transcode_encoder_t *p_enc,
     {
         p_enc->p_encoder->fmt_out.i_codec =
                 vlc_fourcc_GetCodec( AUDIO_ES, p_enc->p_encoder->fmt_out.i_codec );
+
+        if( p_cfg->audio.i_threads > 0 )
+        {
+            if( !encoder_audio_batch_allowed( p_enc->p_encoder->fmt_out.i_codec ) ||
+                p_enc->p_encoder->fmt_in.audio.i_bytes_per_frame == 0 )
+                msg_Warn( p_enc->p_encoder, "cannot encode %4.4s in parallel "
+                          "chunks, encoding sequentially",
+                          (const char *)&p_enc->p_encoder->fmt_out.i_codec );
+            else
+                p_enc->p_audio_batch = batch_new( p_enc->p_encoder, p_cfg,
+                                                  &fmt_out );
+        }
     }
 
+    es_format_Clean( &fmt_out );
+
     return ( p_enc->p_encoder->p_module ) ? VLC_SUCCESS: VLC_EGENERIC;
 }
 
+void transcode_encoder_audio_close( transcode_encoder_t *p_enc )
+{
+    if( p_enc->p_audio_batch )
+    {
+        batch_delete( p_enc->p_audio_batch, p_enc->p_audio_batch->i_threads );
+        p_enc->p_audio_batch = NULL;
+    }
+
+    module_unneed( p_enc->p_encoder, p_enc->p_encoder->p_module );
+}
+
 static int encoder_audio_configure( const transcode_encoder_config_t *p_cfg,
                                     const audio_format_t *p_dec_out,
                                     encoder_t *p_enc, bool b_keep_fmtin )
@@ -199,11 +684,21 @@ int transcode_encoder_audio_test( encoder_t *p_encoder,
 
 block_t * transcode_encoder_audio_encode( transcode_encoder_t *p_enc, block_t *p_block )
 {
+    if( p_enc->p_audio_batch )
+        return p_block ? batch_encode( p_enc->p_audio_batch, p_block )
+                       : batch_drain( p_enc->p_audio_batch );
+
     return p_enc->p_encoder->pf_encode_audio( p_enc->p_encoder, p_block );
 }
 
 int transcode_encoder_audio_drain( transcode_encoder_t *p_enc, block_t **out )
 {
+    if( p_enc->p_audio_batch )
+    {
+        block_ChainAppend( out, batch_drain( p_enc->p_audio_batch ) );
+        return VLC_SUCCESS;
+    }
+
     block_t *p_block;
     do {
         p_block = transcode_encoder_audio_encode( p_enc, NULL );
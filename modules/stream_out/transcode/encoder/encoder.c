@@ -131,6 +131,12 @@ void transcode_encoder_update_format_in( transcode_encoder_t *p_enc, const es_fo
     es_format_Copy( &p_enc->p_encoder->fmt_in, fmt );
 }
 
+void transcode_encoder_update_video_context( transcode_encoder_t *p_enc,
+                                             vlc_video_context *vctx )
+{
+    p_enc->p_encoder->vctx_in = vctx;
+}
+
 void transcode_encoder_update_format_out( transcode_encoder_t *p_enc, const es_format_t *fmt )
 {
     es_format_Clean( &p_enc->p_encoder->fmt_out );
@@ -177,6 +183,9 @@ void transcode_encoder_close( transcode_encoder_t *p_enc )
         case VIDEO_ES:
             transcode_encoder_video_close( p_enc );
             break;
+        case AUDIO_ES:
+            transcode_encoder_audio_close( p_enc );
+            break;
         default:
             module_unneed( p_enc->p_encoder, p_enc->p_encoder->p_module );
             break;
@@ -51,6 +51,7 @@ typedef struct
             unsigned int    i_bitrate;
             uint32_t        i_sample_rate;
             uint32_t        i_channels;
+            unsigned int    i_threads; /* chunks encoded in parallel */
         } audio;
         struct
         {
@@ -67,6 +68,7 @@ const es_format_t *transcode_encoder_format_in( const transcode_encoder_t * );
 const es_format_t *transcode_encoder_format_out( const transcode_encoder_t * );
 void transcode_encoder_update_format_in( transcode_encoder_t *, const es_format_t * );
 void transcode_encoder_update_format_out( transcode_encoder_t *, const es_format_t * );
+void transcode_encoder_update_video_context( transcode_encoder_t *, vlc_video_context * );
 
 block_t * transcode_encoder_encode( transcode_encoder_t *, void * );
 block_t * transcode_encoder_get_output_async( transcode_encoder_t * );
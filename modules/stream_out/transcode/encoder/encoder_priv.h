@@ -18,6 +18,8 @@
  *****************************************************************************/
 #include <vlc_picture_fifo.h>
 
+typedef struct transcode_audio_batch_t transcode_audio_batch_t;
+
 struct transcode_encoder_t
 {
     encoder_t       *p_encoder;
@@ -31,6 +33,9 @@ struct transcode_encoder_t
     /* output buffers */
     block_t         *p_buffers;
     bool b_threaded;
+
+    /* audio chunks encoded in parallel */
+    transcode_audio_batch_t *p_audio_batch;
 };
 
 int transcode_encoder_audio_open( transcode_encoder_t *p_enc,
@@ -41,6 +46,7 @@ int transcode_encoder_spu_open( transcode_encoder_t *p_enc,
                                 const transcode_encoder_config_t *p_cfg );
 
 void transcode_encoder_video_close( transcode_encoder_t *p_enc );
+void transcode_encoder_audio_close( transcode_encoder_t *p_enc );
 
 block_t * transcode_encoder_video_encode( transcode_encoder_t *p_enc, picture_t *p_pic );
 block_t * transcode_encoder_audio_encode( transcode_encoder_t *p_enc, block_t *p_block );
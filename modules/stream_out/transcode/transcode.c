@@ -75,6 +75,13 @@
 #define MAXHEIGHT_TEXT N_("Maximum video height")
 #define MAXHEIGHT_LONGTEXT N_( \
     "Maximum output video height." )
+#define RENDITIONS_TEXT N_("Extra video renditions")
+#define RENDITIONS_LONGTEXT N_( \
+    "Comma-separated list of additional renditions of the video, as " \
+    "WIDTHxHEIGHT@BITRATE (e.g. \"1280x720@3000,640x360@800\"). The video " \
+    "is decoded once, and each rendition is scaled and encoded on its own " \
+    "thread with the same encoder and options. With a fixed GOP in the " \
+    "encoder options, the keyframes of all renditions are aligned." )
 #define VFILTER_TEXT N_("Video filter")
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
@@ -122,10 +129,32 @@
 #define THREADS_TEXT N_("Number of threads")
 #define THREADS_LONGTEXT N_( \
     "Number of threads used for the transcoding." )
+#define ATHREADS_TEXT N_("Number of audio encoding threads")
+#define ATHREADS_LONGTEXT N_( \
+    "Encodes the audio in chunks of about ten seconds on this number of " \
+    "threads, for the codecs with independent frames (Opus, AAC, A/52). " \
+    "This delays the audio output by some chunks, and is meant for file " \
+    "conversions. 0 encodes on the transcoding thread." )
 #define HP_TEXT N_("High priority")
 #define HP_LONGTEXT N_( \
     "Runs the optional encoder thread at the OUTPUT priority instead of " \
     "VIDEO." )
+#define PIPELINE_TEXT N_("Pipelined video transcoding")
+#define PIPELINE_LONGTEXT N_( \
+    "Runs the video filters on their own thread, between the decoder and " \
+    "the encoder threads. The queues between them hold up to pool-size " \
+    "pictures." )
+#define SCENECUT_TEXT N_("Scene change threshold")
+#define SCENECUT_LONGTEXT N_( \
+    "Forces a keyframe on all the video encoders when the mean luma " \
+    "difference with the previous picture exceeds this percentage. " \
+    "Disable the scene detection of the encoders, and give them a longer " \
+    "keyframe interval, for the renditions to stay aligned. 0 disables." )
+#define KEYINT_TEXT N_("Maximum keyframe interval")
+#define KEYINT_LONGTEXT N_( \
+    "Forces a keyframe on all the video encoders after this many " \
+    "pictures without one, so that segments stay aligned across the " \
+    "renditions. 0 leaves the keyframe placement to the encoders." )
 #define POOL_TEXT N_("Picture pool size")
 #define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
     "between decoder/encoder threads when threads > 0" )
@@ -175,6 +204,8 @@ vlc_module_begin ()
                  MAXWIDTH_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "maxheight", 0, MAXHEIGHT_TEXT,
                  MAXHEIGHT_LONGTEXT, true )
+    add_string( SOUT_CFG_PREFIX "renditions", NULL, RENDITIONS_TEXT,
+                RENDITIONS_LONGTEXT, true )
     add_module_list(SOUT_CFG_PREFIX "vfilter", "video filter", NULL,
                     VFILTER_TEXT, VFILTER_LONGTEXT)
 
@@ -211,10 +242,21 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "threads", 0, THREADS_TEXT,
                  THREADS_LONGTEXT, true )
         change_integer_range( 0, 32 )
+    add_integer( SOUT_CFG_PREFIX "athreads", 0, ATHREADS_TEXT,
+                 ATHREADS_LONGTEXT, true )
+        change_integer_range( 0, 32 )
     add_integer( SOUT_CFG_PREFIX "pool-size", 10, POOL_TEXT, POOL_LONGTEXT, true )
         change_integer_range( 1, 1000 )
     add_bool( SOUT_CFG_PREFIX "high-priority", false, HP_TEXT, HP_LONGTEXT,
               true )
+    add_bool( SOUT_CFG_PREFIX "pipeline", false, PIPELINE_TEXT,
+              PIPELINE_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "scenecut", 0, SCENECUT_TEXT,
+                 SCENECUT_LONGTEXT, true )
+        change_integer_range( 0, 100 )
+    add_integer( SOUT_CFG_PREFIX "keyint", 0, KEYINT_TEXT, KEYINT_LONGTEXT,
+                 true )
+        change_integer_range( 0, 10000 )
 
 vlc_module_end ()
 
@@ -224,7 +266,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "renditions", "pipeline", "scenecut", "keyint", "athreads", NULL
 };
 
 /*****************************************************************************
@@ -264,6 +306,7 @@ static void SetAudioEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
 
     p_cfg->audio.i_sample_rate = var_GetInteger( p_stream, SOUT_CFG_PREFIX "samplerate" );
     p_cfg->audio.i_channels = var_GetInteger( p_stream, SOUT_CFG_PREFIX "channels" );
+    p_cfg->audio.i_threads = var_GetInteger( p_stream, SOUT_CFG_PREFIX "athreads" );
 
     if( p_cfg->i_codec )
     {
@@ -332,6 +375,63 @@ static void SetVideoEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_VIDEO;
 }
 
+static void SetVideoRenditionsConfig( sout_stream_t *p_stream,
+                                      sout_stream_sys_t *p_sys )
+{
+    char *psz_string = var_GetNonEmptyString( p_stream,
+                                              SOUT_CFG_PREFIX "renditions" );
+    if( !psz_string )
+        return;
+
+    size_t i_count = 1;
+    for( const char *psz = psz_string; (psz = strchr( psz, ',' )); psz++ )
+        i_count++;
+
+    p_sys->p_renditions_cfg = vlc_alloc( i_count,
+                                         sizeof(*p_sys->p_renditions_cfg) );
+    if( unlikely(!p_sys->p_renditions_cfg) )
+    {
+        free( psz_string );
+        return;
+    }
+
+    char *psz_save;
+    for( char *psz = strtok_r( psz_string, ",", &psz_save ); psz;
+         psz = strtok_r( NULL, ",", &psz_save ) )
+    {
+        unsigned i_width, i_height, i_bitrate = 0;
+        if( sscanf( psz, "%ux%u@%u", &i_width, &i_height, &i_bitrate ) < 2 ||
+            i_width < 2 || i_height < 2 )
+        {
+            msg_Warn( p_stream, "invalid rendition `%s'", psz );
+            continue;
+        }
+
+        /* Same encoder and options as the main rendition */
+        transcode_encoder_config_t *p_cfg =
+            &p_sys->p_renditions_cfg[p_sys->i_renditions++];
+        *p_cfg = p_sys->venc_cfg;
+        p_cfg->video.i_width = i_width;
+        p_cfg->video.i_height = i_height;
+        p_cfg->video.f_scale = 0;
+        p_cfg->video.i_maxwidth = p_cfg->video.i_maxheight = 0;
+        if( i_bitrate > 0 )
+            p_cfg->video.i_bitrate = i_bitrate < 16000 ? i_bitrate * 1000
+                                                       : i_bitrate;
+        /* Encode each rendition on its own thread */
+        if( p_cfg->video.threads.i_count == 0 )
+            p_cfg->video.threads.i_count = 1;
+
+        msg_Dbg( p_stream, "video rendition %ux%u %ukb/s", i_width, i_height,
+                 p_cfg->video.i_bitrate / 1000 );
+    }
+    free( psz_string );
+
+    /* Do not encode the main rendition on the decoding thread either */
+    if( p_sys->i_renditions > 0 && p_sys->venc_cfg.video.threads.i_count == 0 )
+        p_sys->venc_cfg.video.threads.i_count = 1;
+}
+
 static void SetSPUEncoderConfig( sout_stream_t *p_stream, transcode_encoder_config_t *p_cfg )
 {
     char *psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "senc" );
@@ -416,6 +516,12 @@ static int Open( vlc_object_t *p_this )
 
     SetVideoEncoderConfig( p_stream, &p_sys->venc_cfg );
     p_sys->b_master_sync = (p_sys->venc_cfg.video.fps.num > 0);
+    p_sys->b_pipeline = var_GetBool( p_stream, SOUT_CFG_PREFIX "pipeline" );
+    /* The encoders get their own thread too */
+    if( p_sys->b_pipeline && p_sys->venc_cfg.video.threads.i_count == 0 )
+        p_sys->venc_cfg.video.threads.i_count = 1;
+    p_sys->i_scenecut = var_GetInteger( p_stream, SOUT_CFG_PREFIX "scenecut" );
+    p_sys->i_keyint = var_GetInteger( p_stream, SOUT_CFG_PREFIX "keyint" );
     if( p_sys->venc_cfg.i_codec )
     {
         msg_Dbg( p_stream, "codec video=%4.4s %dx%d scaling: %f %dkb/s",
@@ -424,6 +530,7 @@ static int Open( vlc_object_t *p_this )
                  p_sys->venc_cfg.video.i_height,
                  p_sys->venc_cfg.video.f_scale,
                  p_sys->venc_cfg.video.i_bitrate / 1000 );
+        SetVideoRenditionsConfig( p_stream, p_sys );
     }
 
     /* Video Filter Parameters */
@@ -486,6 +593,7 @@ static void Close( vlc_object_t * p_this )
     sout_stream_t       *p_stream = (sout_stream_t*)p_this;
     sout_stream_sys_t   *p_sys = p_stream->p_sys;
 
+    free( p_sys->p_renditions_cfg );
     transcode_encoder_config_clean( &p_sys->venc_cfg );
     sout_filters_config_clean( &p_sys->vfilters_cfg );
 
@@ -705,6 +813,10 @@ static void Del( sout_stream_t *p_stream, void *_id )
             if( id == p_sys->id_video )
                 p_sys->id_video = NULL;
             vlc_mutex_unlock( &p_sys->lock );
+            for( size_t i = 0; i < id->i_renditions; i++ )
+                if( id->renditions[i].downstream_id )
+                    sout_StreamIdDel( p_stream->p_next,
+                                      id->renditions[i].downstream_id );
             transcode_video_clean( id );
             break;
         case SPU_ES:
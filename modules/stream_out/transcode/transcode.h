@@ -6,6 +6,11 @@
 /*100ms is around the limit where people are noticing lipsync issues*/
 #define MASTER_SYNC_MAX_DRIFT VLC_TICK_FROM_MS(100)
 
+/* Grid of the thumbnails compared by the scene change detection */
+#define TRANSCODE_SCENE_COLS 32
+#define TRANSCODE_SCENE_ROWS 18
+#define TRANSCODE_SCENE_CELLS (TRANSCODE_SCENE_COLS * TRANSCODE_SCENE_ROWS)
+
 typedef struct
 {
     char *psz_filters;
@@ -52,10 +57,20 @@ typedef struct
     /* Video */
     transcode_encoder_config_t venc_cfg;
     sout_filters_config_t vfilters_cfg;
+    /* Extra renditions, sharing the strings of venc_cfg */
+    transcode_encoder_config_t *p_renditions_cfg;
+    size_t i_renditions;
 
     /* SPU */
     transcode_encoder_config_t senc_cfg;
 
+    /* Filter the video on its own thread */
+    bool            b_pipeline;
+
+    /* Keyframes forced on all the video encoders alike */
+    unsigned        i_scenecut; /**< scene change threshold, 0 if disabled */
+    unsigned        i_keyint; /**< maximum keyframe interval, 0 if none */
+
     /* Shared betweeen streams */
     vlc_mutex_t     lock;
     /* Sync */
@@ -68,6 +83,16 @@ typedef struct
 
 struct aout_filters;
 
+/* Extra video rendition, encoded from the same decoded pictures */
+struct transcode_rendition
+{
+    const transcode_encoder_config_t *p_enccfg;
+    transcode_encoder_t *encoder;
+    filter_chain_t *p_conv; /**< Scaling and chroma conversion */
+    void *downstream_id;
+    bool b_error;
+};
+
 struct sout_stream_id_sys_t
 {
     bool            b_transcode;
@@ -148,6 +173,34 @@ struct sout_stream_id_sys_t
     const transcode_encoder_config_t *p_enccfg;
     transcode_encoder_t *encoder;
 
+    /* Extra video renditions */
+    struct transcode_rendition *renditions;
+    size_t i_renditions;
+
+    /* Video filtering thread, between the decoder and the encoders */
+    struct
+    {
+        sout_stream_t   *p_stream;
+        vlc_thread_t    thread;
+        vlc_mutex_t     lock;
+        vlc_cond_t      wait; /**< picture queued or stop requested */
+        vlc_cond_t      idle; /**< all queued pictures processed */
+        vlc_sem_t       room; /**< bounds the queue */
+        picture_fifo_t  *pics;
+        unsigned        i_pending; /**< queued or being processed */
+        block_t         *out;
+        bool            b_stop;
+        bool            b_running;
+    } pipeline;
+
+    /* Scene change detection, ahead of all the video encoders */
+    struct
+    {
+        uint8_t         thumb[TRANSCODE_SCENE_CELLS]; /**< luma averages */
+        bool            b_thumb;
+        unsigned        i_since; /**< pictures since the last keyframe */
+    } scene;
+
     /* Sync */
     date_t          next_input_pts; /**< Incoming calculated PTS */
     vlc_tick_t      i_drift; /** how much buffer is ahead of calculated PTS */
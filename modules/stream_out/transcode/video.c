@@ -188,6 +188,64 @@ static picture_t *transcode_dequeue_all_pics( sout_stream_id_sys_t *id )
     return p_pics;
 }
 
+static void transcode_video_renditions_clean( sout_stream_id_sys_t *id )
+{
+    for( size_t i = 0; i < id->i_renditions; i++ )
+    {
+        struct transcode_rendition *r = &id->renditions[i];
+
+        transcode_encoder_close( r->encoder );
+        transcode_encoder_delete( r->encoder );
+        transcode_remove_filters( &r->p_conv );
+    }
+    free( id->renditions );
+    id->renditions = NULL;
+    id->i_renditions = 0;
+}
+
+static int transcode_video_renditions_init( sout_stream_t *p_stream,
+                                            sout_stream_id_sys_t *id,
+                                            const es_format_t *p_fmt_in )
+{
+    const sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    if( p_sys->i_renditions == 0 )
+        return VLC_SUCCESS;
+
+    id->renditions = vlc_alloc( p_sys->i_renditions, sizeof(*id->renditions) );
+    if( unlikely(!id->renditions) )
+        return VLC_ENOMEM;
+
+    /* The encoders accept the same input as the tested main one */
+    for( size_t i = 0; i < p_sys->i_renditions; i++ )
+    {
+        struct transcode_rendition *r = &id->renditions[id->i_renditions];
+
+        struct encoder_owner *p_enc_owner = (struct encoder_owner *)
+            sout_EncoderCreate( p_stream, sizeof(struct encoder_owner) );
+        if( unlikely(p_enc_owner == NULL) )
+            break;
+        p_enc_owner->id = id;
+        p_enc_owner->enc.cbs = &encoder_video_transcode_cbs;
+
+        r->encoder = transcode_encoder_new( &p_enc_owner->enc, p_fmt_in );
+        if( !r->encoder )
+            break;
+        r->p_enccfg = &p_sys->p_renditions_cfg[i];
+        r->p_conv = NULL;
+        r->downstream_id = NULL;
+        r->b_error = false;
+        id->i_renditions++;
+    }
+
+    if( id->i_renditions < p_sys->i_renditions )
+    {
+        transcode_video_renditions_clean( id );
+        return VLC_ENOMEM;
+    }
+    return VLC_SUCCESS;
+}
+
 int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
                           sout_stream_id_sys_t *id )
 {
@@ -200,6 +258,8 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
     id->b_transcode = true;
     es_format_Init( &id->decoder_out, VIDEO_ES, 0 );
     id->decoder_vctx_out = NULL;
+    id->scene.b_thumb = false;
+    id->scene.i_since = 0;
 
     /* Open decoder
      */
@@ -295,6 +355,17 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
     /* Will use this format as encoder input for now */
     transcode_encoder_update_format_in( id->encoder, &encoder_tested_fmt_in );
 
+    if( transcode_video_renditions_init( p_stream, id,
+                                         &encoder_tested_fmt_in ) )
+    {
+        transcode_encoder_delete( id->encoder );
+        module_unneed( id->p_decoder, id->p_decoder->p_module );
+        id->p_decoder->p_module = NULL;
+        es_format_Clean( &encoder_tested_fmt_in );
+        es_format_Clean( &id->decoder_out );
+        return VLC_EGENERIC;
+    }
+
     es_format_Clean( &encoder_tested_fmt_in );
 
     return VLC_SUCCESS;
@@ -410,6 +481,22 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
         src_ctx = filter_chain_GetVideoCtxOut( id->p_f_chain );
     }
 
+    /* Hardware surfaces the encoder cannot take are downloaded once, at the
+     * source size, rather than once per rendition scaler */
+    if( src_ctx != NULL && id->i_renditions > 0 &&
+        p_src->video.i_chroma != p_dst->video.i_chroma )
+    {
+        es_format_t download;
+        es_format_Copy( &download, p_src );
+        download.i_codec = download.video.i_chroma = p_dst->video.i_chroma;
+        if( filter_chain_AppendConverter( id->p_f_chain, &download ) == VLC_SUCCESS )
+        {
+            p_src = filter_chain_GetFmtOut( id->p_f_chain );
+            src_ctx = filter_chain_GetVideoCtxOut( id->p_f_chain );
+        }
+        es_format_Clean( &download );
+    }
+
     /* Chroma and other conversions */
     if( transcode_video_set_conversions( p_stream, id, &p_src, &src_ctx, p_dst,
                                          p_cfg->video.b_reorient ) != VLC_SUCCESS )
@@ -425,11 +512,14 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
         filter_chain_Reset( id->p_uf_chain, p_src, src_ctx, p_dst );
         filter_chain_AppendFromString( id->p_uf_chain, p_cfg->psz_filters );
         p_src = filter_chain_GetFmtOut( id->p_uf_chain );
+        src_ctx = filter_chain_GetVideoCtxOut( id->p_uf_chain );
         debug_format( p_stream, p_src );
    }
 
-    /* Update encoder so it matches filters output */
+    /* Update encoder so it matches filters output, hardware surfaces
+     * included when the encoder takes them */
     transcode_encoder_update_format_in( id->encoder, p_src );
+    transcode_encoder_update_video_context( id->encoder, src_ctx );
 
     /* SPU Sources */
     if( p_cfg->video.psz_spu_sources )
@@ -441,28 +531,6 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
-void transcode_video_clean( sout_stream_id_sys_t *id )
-{
-    /* Close encoder */
-    transcode_encoder_close( id->encoder );
-    transcode_encoder_delete( id->encoder );
-
-    es_format_Clean( &id->decoder_out );
-
-    /* Close filters */
-    transcode_remove_filters( &id->p_f_chain );
-    transcode_remove_filters( &id->p_conv_nonstatic );
-    transcode_remove_filters( &id->p_conv_static );
-    transcode_remove_filters( &id->p_uf_chain );
-    transcode_remove_filters( &id->p_final_conv_static );
-    if( id->p_spu_blender )
-        filter_DeleteBlend( id->p_spu_blender );
-    if( id->p_spu )
-        spu_Destroy( id->p_spu );
-    if ( id->dec_dev )
-        vlc_decoder_device_Release( id->dec_dev );
-}
-
 void transcode_video_push_spu( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                subpicture_t *p_subpicture )
 {
@@ -545,6 +613,414 @@ static void tag_last_block_with_flag( block_t **out, int i_flag )
     }
 }
 
+static void transcode_video_rendition_send( sout_stream_t *p_stream,
+                                            struct transcode_rendition *r,
+                                            block_t *p_out )
+{
+    if( p_out &&
+        sout_StreamIdSend( p_stream->p_next, r->downstream_id, p_out ) )
+        r->b_error = true;
+}
+
+/* Opens the encoders of the renditions and builds their scalers, from the
+ * output of the deinterlacing and frame rate filters */
+static void transcode_video_renditions_configure( sout_stream_t *p_stream,
+                                                  sout_stream_id_sys_t *id,
+                                                  picture_t *p_pic )
+{
+    filter_owner_t owner = {
+        .video = &transcode_filter_video_cbs,
+        .sys = id,
+    };
+    const es_format_t *p_src = filter_chain_GetFmtOut( id->p_f_chain );
+    vlc_video_context *src_vctx = filter_chain_GetVideoCtxOut( id->p_f_chain );
+
+    for( size_t i = 0; i < id->i_renditions; i++ )
+    {
+        struct transcode_rendition *r = &id->renditions[i];
+        const bool b_open = !transcode_encoder_opened( r->encoder );
+
+        if( r->b_error )
+            continue;
+
+        if( b_open )
+            transcode_encoder_video_configure( VLC_OBJECT(p_stream),
+                                               &id->p_decoder->fmt_out.video,
+                                               r->p_enccfg, &p_pic->format,
+                                               picture_GetVideoContext(p_pic),
+                                               r->encoder );
+
+        transcode_remove_filters( &r->p_conv );
+        const es_format_t *p_dst = transcode_encoder_format_in( r->encoder );
+        if( p_src->video.i_width != p_dst->video.i_width ||
+            p_src->video.i_height != p_dst->video.i_height ||
+            p_src->video.i_chroma != p_dst->video.i_chroma )
+        {
+            r->p_conv = filter_chain_NewVideo( p_stream, false, &owner );
+            if( !r->p_conv )
+                goto error;
+            filter_chain_Reset( r->p_conv, p_src, src_vctx, p_dst );
+            if( filter_chain_AppendConverter( r->p_conv, p_dst ) != VLC_SUCCESS )
+                goto error;
+            transcode_encoder_update_video_context( r->encoder,
+                                    filter_chain_GetVideoCtxOut( r->p_conv ) );
+        }
+        else
+            transcode_encoder_update_video_context( r->encoder, src_vctx );
+
+        if( b_open )
+        {
+            if( transcode_encoder_open( r->encoder, r->p_enccfg ) != VLC_SUCCESS )
+                goto error;
+
+            msg_Dbg( p_stream, "rendition %zu: destination %ux%u", i,
+                     p_dst->video.i_width, p_dst->video.i_height );
+        }
+
+        if( !r->downstream_id )
+            r->downstream_id =
+                id->pf_transcode_downstream_add( p_stream,
+                                                 &id->p_decoder->fmt_in,
+                                                 transcode_encoder_format_out( r->encoder ) );
+        if( !r->downstream_id )
+            goto error;
+        continue;
+error:
+        msg_Err( p_stream, "cannot set up video rendition %zu (%ux%u)", i,
+                 r->p_enccfg->video.i_width, r->p_enccfg->video.i_height );
+        r->b_error = true;
+    }
+}
+
+static void transcode_video_renditions_encode( sout_stream_t *p_stream,
+                                               sout_stream_id_sys_t *id,
+                                               picture_t *p_pic )
+{
+    for( size_t i = 0; i < id->i_renditions; i++ )
+    {
+        struct transcode_rendition *r = &id->renditions[i];
+        if( r->b_error || !transcode_encoder_opened( r->encoder ) )
+            continue;
+
+        /* The scalers and encoders do not modify their input */
+        picture_t *p_in = picture_Hold( p_pic );
+        if( r->p_conv )
+            p_in = filter_chain_VideoFilter( r->p_conv, p_in );
+        if( !p_in )
+            continue;
+
+        block_t *p_encoded = transcode_encoder_encode( r->encoder, p_in );
+        picture_Release( p_in );
+        transcode_video_rendition_send( p_stream, r, p_encoded );
+    }
+}
+
+static void transcode_video_renditions_output( sout_stream_t *p_stream,
+                                               sout_stream_id_sys_t *id,
+                                               bool b_drain, bool b_eos )
+{
+    for( size_t i = 0; i < id->i_renditions; i++ )
+    {
+        struct transcode_rendition *r = &id->renditions[i];
+        if( r->b_error || !transcode_encoder_opened( r->encoder ) )
+            continue;
+
+        block_t *p_out = NULL;
+        if( b_drain )
+            transcode_encoder_drain( r->encoder, &p_out );
+        else
+            p_out = transcode_encoder_get_output_async( r->encoder );
+
+        if( b_eos )
+        {
+            tag_last_block_with_flag( &p_out, BLOCK_FLAG_END_OF_SEQUENCE );
+            transcode_encoder_close( r->encoder );
+            transcode_remove_filters( &r->p_conv );
+        }
+        transcode_video_rendition_send( p_stream, r, p_out );
+    }
+}
+
+/* Averages the luma over a coarse grid, one pixel in four */
+static bool transcode_video_scene_thumbnail( const picture_t *p_pic,
+                                             uint8_t *p_thumb )
+{
+    const vlc_chroma_description_t *p_desc =
+        vlc_fourcc_GetChromaDescription( p_pic->format.i_chroma );
+
+    /* 8-bit luma plane only, not hardware surfaces */
+    if( p_pic->context != NULL || p_desc == NULL ||
+        p_desc->plane_count < 2 || p_desc->pixel_size != 1 ||
+        !vlc_fourcc_IsYUV( p_pic->format.i_chroma ) )
+        return false;
+
+    const plane_t *p = &p_pic->p[Y_PLANE];
+    const unsigned i_width = p->i_visible_pitch;
+    const unsigned i_height = p->i_visible_lines;
+    if( i_width < 2 * TRANSCODE_SCENE_COLS || i_height < 2 * TRANSCODE_SCENE_ROWS )
+        return false;
+
+    for( unsigned y = 0; y < TRANSCODE_SCENE_ROWS; y++ )
+    {
+        const unsigned y0 = y * i_height / TRANSCODE_SCENE_ROWS;
+        const unsigned y1 = (y + 1) * i_height / TRANSCODE_SCENE_ROWS;
+
+        for( unsigned x = 0; x < TRANSCODE_SCENE_COLS; x++ )
+        {
+            const unsigned x0 = x * i_width / TRANSCODE_SCENE_COLS;
+            const unsigned x1 = (x + 1) * i_width / TRANSCODE_SCENE_COLS;
+            unsigned i_sum = 0, i_count = 0;
+
+            for( unsigned j = y0; j < y1; j += 2 )
+            {
+                const uint8_t *p_line = &p->p_pixels[j * p->i_pitch];
+                for( unsigned i = x0; i < x1; i += 2 )
+                    i_sum += p_line[i];
+                i_count += (x1 - x0 + 1) / 2;
+            }
+            p_thumb[y * TRANSCODE_SCENE_COLS + x] = i_sum / i_count;
+        }
+    }
+    return true;
+}
+
+/* Flags the scene changes and the keyframe interval expiries, before the
+ * pictures are fanned out, so that every encoder cuts at the same place */
+static void transcode_video_scene_detect( sout_stream_t *p_stream,
+                                          sout_stream_id_sys_t *id,
+                                          picture_t *p_pic )
+{
+    const sout_stream_sys_t *p_sys = p_stream->p_sys;
+    bool b_cut = false;
+
+    if( p_sys->i_scenecut > 0 )
+    {
+        uint8_t thumb[TRANSCODE_SCENE_CELLS];
+
+        if( transcode_video_scene_thumbnail( p_pic, thumb ) )
+        {
+            if( id->scene.b_thumb )
+            {
+                unsigned i_sad = 0;
+                for( size_t i = 0; i < TRANSCODE_SCENE_CELLS; i++ )
+                    i_sad += abs( thumb[i] - id->scene.thumb[i] );
+                /* Mean difference, in percent of the luma range */
+                b_cut = i_sad * 100 > p_sys->i_scenecut * 255 * TRANSCODE_SCENE_CELLS;
+            }
+            memcpy( id->scene.thumb, thumb, sizeof (thumb) );
+            id->scene.b_thumb = true;
+        }
+    }
+
+    id->scene.i_since++;
+    if( p_sys->i_keyint > 0 && id->scene.i_since >= p_sys->i_keyint )
+        b_cut = true;
+
+    if( b_cut )
+    {
+        p_pic->b_keyframe = true;
+        id->scene.i_since = 0;
+    }
+}
+
+/* Filters a decoded picture and passes it to the encoders */
+static void transcode_video_filter_encode( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id,
+                                           picture_t *p_pic, block_t **out )
+{
+    const sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    /* Run the filter and output chains; first with the picture,
+     * and then with NULL as many times as we need until they
+     * stop outputting frames.
+     */
+    for ( picture_t *p_in = p_pic; ; p_in = NULL /* drain second time */ )
+    {
+        /* Run filter chain */
+        if( p_in && id->p_f_chain )
+            p_in = filter_chain_VideoFilter( id->p_f_chain, p_in );
+
+        if( p_in && (p_sys->i_scenecut > 0 || p_sys->i_keyint > 0) )
+            transcode_video_scene_detect( p_stream, id, p_in );
+
+        /* Fan the deinterlaced pictures out to the renditions */
+        if( p_in && id->i_renditions > 0 )
+            transcode_video_renditions_encode( p_stream, id, p_in );
+
+        filter_chain_t * primary_chains[] = { id->p_conv_nonstatic,
+                                              id->p_conv_static };
+        for( size_t i=0; p_in && i<ARRAY_SIZE(primary_chains); i++ )
+        {
+            if( !primary_chains[i] )
+                continue;
+            p_in = filter_chain_VideoFilter( primary_chains[i], p_in );
+        }
+
+        if( !p_in )
+            break;
+
+        for ( ;; p_in = NULL /* drain second time */ )
+        {
+            /* Run user specified filter chain */
+            filter_chain_t * secondary_chains[] = { id->p_uf_chain,
+                                                    id->p_final_conv_static };
+            for( size_t i=0; p_in && i<ARRAY_SIZE(secondary_chains); i++ )
+            {
+                if( !secondary_chains[i] )
+                    continue;
+                p_in = filter_chain_VideoFilter( secondary_chains[i], p_in );
+            }
+
+            if( !p_in )
+                break;
+
+            /* Blend subpictures */
+            p_in = RenderSubpictures( id, p_in );
+
+            if( p_in )
+            {
+                block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
+                if( p_encoded )
+                    block_ChainAppend( out, p_encoded );
+                picture_Release( p_in );
+            }
+        }
+    }
+}
+
+static void *transcode_video_pipeline_thread( void *data )
+{
+    sout_stream_id_sys_t *id = data;
+
+    vlc_mutex_lock( &id->pipeline.lock );
+    for( ;; )
+    {
+        picture_t *p_pic;
+        while( (p_pic = picture_fifo_Pop( id->pipeline.pics )) == NULL &&
+               !id->pipeline.b_stop )
+            vlc_cond_wait( &id->pipeline.wait, &id->pipeline.lock );
+        if( p_pic == NULL )
+            break;
+        vlc_mutex_unlock( &id->pipeline.lock );
+        vlc_sem_post( &id->pipeline.room );
+
+        block_t *p_out = NULL;
+        transcode_video_filter_encode( id->pipeline.p_stream, id, p_pic,
+                                       &p_out );
+
+        vlc_mutex_lock( &id->pipeline.lock );
+        block_ChainAppend( &id->pipeline.out, p_out );
+        if( --id->pipeline.i_pending == 0 )
+            vlc_cond_signal( &id->pipeline.idle );
+    }
+    vlc_mutex_unlock( &id->pipeline.lock );
+    return NULL;
+}
+
+static int transcode_video_pipeline_start( sout_stream_t *p_stream,
+                                           sout_stream_id_sys_t *id )
+{
+    id->pipeline.pics = picture_fifo_New();
+    if( unlikely(!id->pipeline.pics) )
+        return VLC_ENOMEM;
+
+    id->pipeline.p_stream = p_stream;
+    vlc_mutex_init( &id->pipeline.lock );
+    vlc_cond_init( &id->pipeline.wait );
+    vlc_cond_init( &id->pipeline.idle );
+    vlc_sem_init( &id->pipeline.room, id->p_enccfg->video.threads.pool_size );
+    id->pipeline.i_pending = 0;
+    id->pipeline.out = NULL;
+    id->pipeline.b_stop = false;
+
+    if( vlc_clone( &id->pipeline.thread, transcode_video_pipeline_thread, id,
+                   id->p_enccfg->video.threads.i_priority ) )
+    {
+        vlc_sem_destroy( &id->pipeline.room );
+        vlc_cond_destroy( &id->pipeline.idle );
+        vlc_cond_destroy( &id->pipeline.wait );
+        vlc_mutex_destroy( &id->pipeline.lock );
+        picture_fifo_Delete( id->pipeline.pics );
+        return VLC_EGENERIC;
+    }
+    id->pipeline.b_running = true;
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_pipeline_stop( sout_stream_id_sys_t *id )
+{
+    if( !id->pipeline.b_running )
+        return;
+
+    vlc_mutex_lock( &id->pipeline.lock );
+    id->pipeline.b_stop = true;
+    vlc_cond_signal( &id->pipeline.wait );
+    vlc_mutex_unlock( &id->pipeline.lock );
+    vlc_join( id->pipeline.thread, NULL );
+    id->pipeline.b_running = false;
+
+    block_ChainRelease( id->pipeline.out );
+    vlc_sem_destroy( &id->pipeline.room );
+    vlc_cond_destroy( &id->pipeline.idle );
+    vlc_cond_destroy( &id->pipeline.wait );
+    vlc_mutex_destroy( &id->pipeline.lock );
+    picture_fifo_Delete( id->pipeline.pics );
+}
+
+/* Queues a decoded picture, waiting for room in the queue so that the
+ * input is slowed down to the pace of the filters */
+static void transcode_video_pipeline_push( sout_stream_id_sys_t *id,
+                                           picture_t *p_pic )
+{
+    vlc_sem_wait( &id->pipeline.room );
+    vlc_mutex_lock( &id->pipeline.lock );
+    id->pipeline.i_pending++;
+    picture_fifo_Push( id->pipeline.pics, p_pic );
+    vlc_cond_signal( &id->pipeline.wait );
+    vlc_mutex_unlock( &id->pipeline.lock );
+}
+
+/* Waits for the queued pictures to be filtered, so that the filters and
+ * encoders can be reconfigured, and picks up the filtering thread output */
+static void transcode_video_pipeline_sync( sout_stream_id_sys_t *id,
+                                           block_t **out, bool b_wait )
+{
+    if( !id->pipeline.b_running )
+        return;
+
+    vlc_mutex_lock( &id->pipeline.lock );
+    while( b_wait && id->pipeline.i_pending > 0 )
+        vlc_cond_wait( &id->pipeline.idle, &id->pipeline.lock );
+    block_ChainAppend( out, id->pipeline.out );
+    id->pipeline.out = NULL;
+    vlc_mutex_unlock( &id->pipeline.lock );
+}
+
+void transcode_video_clean( sout_stream_id_sys_t *id )
+{
+    transcode_video_pipeline_stop( id );
+
+    /* Close encoder */
+    transcode_encoder_close( id->encoder );
+    transcode_encoder_delete( id->encoder );
+    transcode_video_renditions_clean( id );
+
+    es_format_Clean( &id->decoder_out );
+
+    /* Close filters */
+    transcode_remove_filters( &id->p_f_chain );
+    transcode_remove_filters( &id->p_conv_nonstatic );
+    transcode_remove_filters( &id->p_conv_static );
+    transcode_remove_filters( &id->p_uf_chain );
+    transcode_remove_filters( &id->p_final_conv_static );
+    if( id->p_spu_blender )
+        filter_DeleteBlend( id->p_spu_blender );
+    if( id->p_spu )
+        spu_Destroy( id->p_spu );
+    if ( id->dec_dev )
+        vlc_decoder_device_Release( id->dec_dev );
+}
+
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
 {
@@ -576,6 +1052,9 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
         if( p_pic && ( unlikely(!transcode_encoder_opened(id->encoder)) ||
               !video_format_IsSimilar( &id->decoder_out.video, &p_pic->format ) ) )
         {
+            /* The filters and encoders are not in use while reconfiguring */
+            transcode_video_pipeline_sync( id, out, true );
+
             if( !transcode_encoder_opened(id->encoder) ) /* Configure Encoder input/output */
             {
                 assert( !id->p_f_chain && !id->p_uf_chain );
@@ -649,59 +1128,27 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                    (char *) &id->p_enccfg->i_codec );
                 goto error;
             }
-        }
 
-        /* Run the filter and output chains; first with the picture,
-         * and then with NULL as many times as we need until they
-         * stop outputting frames.
-         */
-        for ( picture_t *p_in = p_pic; ; p_in = NULL /* drain second time */ )
-        {
-            /* Run filter chain */
-            filter_chain_t * primary_chains[] = { id->p_f_chain,
-                                                  id->p_conv_nonstatic,
-                                                  id->p_conv_static };
-            for( size_t i=0; p_in && i<ARRAY_SIZE(primary_chains); i++ )
-            {
-                if( !primary_chains[i] )
-                    continue;
-                p_in = filter_chain_VideoFilter( primary_chains[i], p_in );
-            }
+            transcode_video_renditions_configure( p_stream, id, p_pic );
 
-            if( !p_in )
-                break;
+            const sout_stream_sys_t *p_sys = p_stream->p_sys;
+            if( p_sys->b_pipeline && !id->pipeline.b_running &&
+                transcode_video_pipeline_start( p_stream, id ) != VLC_SUCCESS )
+                msg_Warn( p_stream, "cannot start the video filtering thread" );
+        }
 
-            for ( ;; p_in = NULL /* drain second time */ )
-            {
-                /* Run user specified filter chain */
-                filter_chain_t * secondary_chains[] = { id->p_uf_chain,
-                                                        id->p_final_conv_static };
-                for( size_t i=0; p_in && i<ARRAY_SIZE(secondary_chains); i++ )
-                {
-                    if( !secondary_chains[i] )
-                        continue;
-                    p_in = filter_chain_VideoFilter( secondary_chains[i], p_in );
-                }
-
-                if( !p_in )
-                    break;
-
-                /* Blend subpictures */
-                p_in = RenderSubpictures( id, p_in );
-
-                if( p_in )
-                {
-                    block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
-                    if( p_encoded )
-                        block_ChainAppend( out, p_encoded );
-                    picture_Release( p_in );
-                }
-            }
+        if( p_pic )
+        {
+            if( id->pipeline.b_running )
+                transcode_video_pipeline_push( id, p_pic );
+            else
+                transcode_video_filter_encode( p_stream, id, p_pic, out );
         }
 
         if( b_eos )
         {
             msg_Info( p_stream, "Drain/restart on EOS" );
+            transcode_video_pipeline_sync( id, out, true );
             if( transcode_encoder_drain( id->encoder, out ) != VLC_SUCCESS )
                 goto error;
             transcode_encoder_close( id->encoder );
@@ -712,6 +1159,7 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             transcode_remove_filters( &id->p_uf_chain );
             transcode_remove_filters( &id->p_final_conv_static );
             tag_last_block_with_flag( out, BLOCK_FLAG_END_OF_SEQUENCE );
+            transcode_video_renditions_output( p_stream, id, true, true );
             b_eos = false;
         }
 
@@ -722,20 +1170,25 @@ error:
         id->b_error = true;
     } while( p_pics );
 
+    transcode_video_pipeline_sync( id, out, false );
+
     if( id->p_enccfg->video.threads.i_count >= 1 )
     {
         /* Pick up any return data the encoder thread wants to output. */
         block_ChainAppend( out, transcode_encoder_get_output_async( id->encoder ) );
     }
+    transcode_video_renditions_output( p_stream, id, false, false );
 
     /* Drain encoder */
     if( unlikely( !id->b_error && in == NULL ) && transcode_encoder_opened( id->encoder ) )
     {
         msg_Dbg( p_stream, "Flushing thread and waiting that");
+        transcode_video_pipeline_sync( id, out, true );
         if( transcode_encoder_drain( id->encoder, out ) == VLC_SUCCESS )
             msg_Dbg( p_stream, "Flushing done");
         else
             msg_Warn( p_stream, "Flushing failed");
+        transcode_video_renditions_output( p_stream, id, true, false );
     }
 
     if( b_eos )
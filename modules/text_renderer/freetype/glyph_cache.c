@@ -0,0 +1,346 @@
+/*****************************************************************************
+ * glyph_cache.c : Cache of loaded and rasterized glyphs
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph cache
+ */
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+
+#include "glyph_cache.h"
+
+#define GLYPH_CACHE_BUCKETS 1024
+
+enum
+{
+    ENTRY_OUTLINES,         /* styled glyph and outline, before rasterizing */
+    ENTRY_GLYPH_BITMAP,
+    ENTRY_OUTLINE_BITMAP,
+};
+
+typedef struct glyph_cache_entry_t glyph_cache_entry_t;
+struct glyph_cache_entry_t
+{
+    glyph_cache_entry_t *p_next;    /* next in hash bucket */
+    struct vlc_list      node;      /* most recently used first */
+
+    glyph_cache_key_t    key;
+    int                  i_type;
+    FT_Vector            origin;    /* subpixel origin of bitmaps */
+
+    FT_Glyph             p_glyph;
+    FT_Glyph             p_outline;
+    FT_Vector            advance;
+    size_t               i_size;
+};
+
+struct glyph_cache_t
+{
+    glyph_cache_entry_t *pp_buckets[GLYPH_CACHE_BUCKETS];
+    struct vlc_list      lru;
+    size_t               i_size;
+    size_t               i_max_size;
+};
+
+static bool KeyEquals( const glyph_cache_key_t *p_a, const glyph_cache_key_t *p_b )
+{
+    return p_a->p_face == p_b->p_face &&
+           p_a->i_glyph_index == p_b->i_glyph_index &&
+           p_a->i_style_flags == p_b->i_style_flags &&
+           p_a->i_outline_radius == p_b->i_outline_radius;
+}
+
+static unsigned Hash( const glyph_cache_key_t *p_key, int i_type,
+                      const FT_Vector *p_origin )
+{
+    uint64_t i_hash = (uintptr_t) p_key->p_face;
+
+    i_hash = i_hash * 31 + p_key->i_glyph_index;
+    i_hash = i_hash * 31 + p_key->i_style_flags;
+    i_hash = i_hash * 31 + p_key->i_outline_radius;
+    i_hash = i_hash * 31 + i_type;
+    i_hash = i_hash * 31 + ( p_origin->x << 6 | p_origin->y );
+    i_hash ^= i_hash >> 29;
+    return ( i_hash * UINT64_C(0x9E3779B97F4A7C15) >> 32 ) % GLYPH_CACHE_BUCKETS;
+}
+
+static size_t GlyphSize( FT_Glyph p_glyph )
+{
+    if( !p_glyph )
+        return 0;
+
+    size_t i_size = sizeof( FT_GlyphRec );
+    if( p_glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &( (FT_BitmapGlyph) p_glyph )->bitmap;
+        i_size = sizeof( FT_BitmapGlyphRec ) +
+                 (size_t) p_bitmap->rows * abs( p_bitmap->pitch );
+    }
+    else if( p_glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &( (FT_OutlineGlyph) p_glyph )->outline;
+        i_size = sizeof( FT_OutlineGlyphRec ) +
+                 p_outline->n_points * ( sizeof( FT_Vector ) + 1 ) +
+                 p_outline->n_contours * sizeof( short );
+    }
+    return i_size;
+}
+
+static void DeleteEntry( glyph_cache_t *p_cache, glyph_cache_entry_t *p_entry )
+{
+    glyph_cache_entry_t **pp = &p_cache->pp_buckets[
+        Hash( &p_entry->key, p_entry->i_type, &p_entry->origin )];
+    while( *pp != p_entry )
+        pp = &(*pp)->p_next;
+    *pp = p_entry->p_next;
+
+    vlc_list_remove( &p_entry->node );
+    p_cache->i_size -= p_entry->i_size;
+
+    if( p_entry->p_glyph )
+        FT_Done_Glyph( p_entry->p_glyph );
+    if( p_entry->p_outline )
+        FT_Done_Glyph( p_entry->p_outline );
+    free( p_entry );
+}
+
+static glyph_cache_entry_t *Find( glyph_cache_t *p_cache,
+                                  const glyph_cache_key_t *p_key, int i_type,
+                                  const FT_Vector *p_origin )
+{
+    glyph_cache_entry_t *p_entry =
+        p_cache->pp_buckets[ Hash( p_key, i_type, p_origin ) ];
+
+    for( ; p_entry; p_entry = p_entry->p_next )
+    {
+        if( p_entry->i_type == i_type &&
+            p_entry->origin.x == p_origin->x &&
+            p_entry->origin.y == p_origin->y &&
+            KeyEquals( &p_entry->key, p_key ) )
+        {
+            /* Most recently used */
+            vlc_list_remove( &p_entry->node );
+            vlc_list_prepend( &p_entry->node, &p_cache->lru );
+            return p_entry;
+        }
+    }
+    return NULL;
+}
+
+/* Takes ownership of the glyphs */
+static void Insert( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                    int i_type, const FT_Vector *p_origin,
+                    FT_Glyph p_glyph, FT_Glyph p_outline,
+                    const FT_Vector *p_advance )
+{
+    glyph_cache_entry_t *p_entry = malloc( sizeof( *p_entry ) );
+    if( unlikely( !p_entry ) )
+    {
+        if( p_glyph )
+            FT_Done_Glyph( p_glyph );
+        if( p_outline )
+            FT_Done_Glyph( p_outline );
+        return;
+    }
+
+    p_entry->key = *p_key;
+    p_entry->i_type = i_type;
+    p_entry->origin = *p_origin;
+    p_entry->p_glyph = p_glyph;
+    p_entry->p_outline = p_outline;
+    p_entry->advance = *p_advance;
+    p_entry->i_size = sizeof( *p_entry ) + GlyphSize( p_glyph ) +
+                      GlyphSize( p_outline );
+
+    glyph_cache_entry_t **pp_bucket =
+        &p_cache->pp_buckets[ Hash( p_key, i_type, p_origin ) ];
+    p_entry->p_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    vlc_list_prepend( &p_entry->node, &p_cache->lru );
+    p_cache->i_size += p_entry->i_size;
+
+    /* Evict the least recently used glyphs, but never the new one */
+    while( p_cache->i_size > p_cache->i_max_size )
+    {
+        glyph_cache_entry_t *p_last =
+            vlc_list_last_entry_or_null( &p_cache->lru,
+                                         glyph_cache_entry_t, node );
+        if( p_last == p_entry )
+            break;
+        DeleteEntry( p_cache, p_last );
+    }
+}
+
+glyph_cache_t *GlyphCacheNew( size_t i_max_size )
+{
+    glyph_cache_t *p_cache = malloc( sizeof( *p_cache ) );
+    if( unlikely( !p_cache ) )
+        return NULL;
+
+    for( unsigned i = 0; i < GLYPH_CACHE_BUCKETS; i++ )
+        p_cache->pp_buckets[i] = NULL;
+    vlc_list_init( &p_cache->lru );
+    p_cache->i_size = 0;
+    p_cache->i_max_size = i_max_size;
+    return p_cache;
+}
+
+void GlyphCacheDelete( glyph_cache_t *p_cache )
+{
+    if( !p_cache )
+        return;
+
+    glyph_cache_entry_t *p_entry;
+    while( ( p_entry = vlc_list_first_entry_or_null( &p_cache->lru,
+                                                     glyph_cache_entry_t,
+                                                     node ) ) )
+        DeleteEntry( p_cache, p_entry );
+    free( p_cache );
+}
+
+int GlyphCacheGetOutlines( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                           FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                           FT_Vector *p_advance )
+{
+    static const FT_Vector zero = { 0, 0 };
+
+    if( !p_cache )
+        return VLC_EGENERIC;
+
+    glyph_cache_entry_t *p_entry = Find( p_cache, p_key, ENTRY_OUTLINES, &zero );
+    if( !p_entry )
+        return VLC_EGENERIC;
+
+    if( FT_Glyph_Copy( p_entry->p_glyph, pp_glyph ) )
+        return VLC_EGENERIC;
+
+    *pp_outline = NULL;
+    if( p_entry->p_outline && FT_Glyph_Copy( p_entry->p_outline, pp_outline ) )
+    {
+        FT_Done_Glyph( *pp_glyph );
+        return VLC_EGENERIC;
+    }
+
+    *p_advance = p_entry->advance;
+    return VLC_SUCCESS;
+}
+
+void GlyphCachePutOutlines( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                            FT_Glyph p_glyph, FT_Glyph p_outline,
+                            const FT_Vector *p_advance )
+{
+    static const FT_Vector zero = { 0, 0 };
+    FT_Glyph p_glyph_copy, p_outline_copy = NULL;
+
+    if( !p_cache || Find( p_cache, p_key, ENTRY_OUTLINES, &zero ) )
+        return;
+
+    if( FT_Glyph_Copy( p_glyph, &p_glyph_copy ) )
+        return;
+    if( p_outline && FT_Glyph_Copy( p_outline, &p_outline_copy ) )
+    {
+        FT_Done_Glyph( p_glyph_copy );
+        return;
+    }
+
+    Insert( p_cache, p_key, ENTRY_OUTLINES, &zero,
+            p_glyph_copy, p_outline_copy, p_advance );
+}
+
+/* Same as FT_Glyph_Copy(), then moves the bitmap by whole pixels */
+static FT_Error CopyBitmap( FT_Glyph p_src, FT_Glyph *pp_dst, int i_x, int i_y )
+{
+    FT_Error err = FT_Glyph_Copy( p_src, pp_dst );
+    if( !err )
+    {
+        FT_BitmapGlyph p_bitmap = (FT_BitmapGlyph) *pp_dst;
+        p_bitmap->left += i_x;
+        p_bitmap->top += i_y;
+    }
+    return err;
+}
+
+FT_Error GlyphCacheToBitmap( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                             bool b_outline, FT_Glyph *pp_glyph,
+                             const FT_Vector *p_origin, bool b_destroy )
+{
+    /* Bitmaps from the font are used as is, whatever the origin */
+    if( !p_cache || (*pp_glyph)->format != FT_GLYPH_FORMAT_OUTLINE )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   (FT_Vector *) p_origin, b_destroy );
+
+    /* Moving the outline by whole pixels moves the bitmap the same way:
+     * only the subpixel part of the origin changes the rasterization. */
+    const int i_type = b_outline ? ENTRY_OUTLINE_BITMAP : ENTRY_GLYPH_BITMAP;
+    FT_Vector subpixel = { .x = p_origin->x & 63, .y = p_origin->y & 63 };
+    const int i_x = ( p_origin->x - subpixel.x ) / 64;
+    const int i_y = ( p_origin->y - subpixel.y ) / 64;
+    FT_Glyph p_bitmap;
+    FT_Error err;
+
+    glyph_cache_entry_t *p_entry = Find( p_cache, p_key, i_type, &subpixel );
+    if( p_entry )
+    {
+        err = CopyBitmap( p_entry->p_glyph, &p_bitmap, i_x, i_y );
+        if( err )
+            return err;
+    }
+    else
+    {
+        FT_Glyph p_cached = *pp_glyph;
+        err = FT_Glyph_To_Bitmap( &p_cached, FT_RENDER_MODE_NORMAL,
+                                  &subpixel, false );
+        if( err )
+            return err;
+
+        err = CopyBitmap( p_cached, &p_bitmap, i_x, i_y );
+        if( err )
+        {
+            FT_Done_Glyph( p_cached );
+            return err;
+        }
+
+        static const FT_Vector zero = { 0, 0 };
+        Insert( p_cache, p_key, i_type, &subpixel, p_cached, NULL, &zero );
+    }
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_bitmap;
+    return 0;
+}
+
+/** @} */
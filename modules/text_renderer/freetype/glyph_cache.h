@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * glyph_cache.h : Cache of loaded and rasterized glyphs
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FREETYPE_GLYPH_CACHE_H
+#define VLC_FREETYPE_GLYPH_CACHE_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph cache
+ *
+ * Keeps the styled outlines and the bitmaps of the recently used glyphs, so
+ * that the same text is neither loaded, stroked nor rasterized again. The
+ * least recently used glyphs are evicted once the cache exceeds its budget.
+ */
+
+/** Memory budget of the glyph cache, in bytes */
+#define GLYPH_CACHE_MAX_SIZE (4 * 1024 * 1024)
+
+typedef struct glyph_cache_t glyph_cache_t;
+
+/**
+ * Identifies a glyph as loaded by LoadGlyphs(). Faces are never resized once
+ * loaded, so the face also identifies the size.
+ */
+typedef struct
+{
+    FT_Face  p_face;
+    FT_UInt  i_glyph_index;
+    int      i_style_flags;     /**< synthesized STYLE_BOLD/STYLE_ITALIC */
+    FT_Fixed i_outline_radius;  /**< stroker radius, -1 without outline */
+} glyph_cache_key_t;
+
+glyph_cache_t *GlyphCacheNew( size_t i_max_size );
+void GlyphCacheDelete( glyph_cache_t *p_cache );
+
+/**
+ * Gets copies of the cached glyph and outline (which can be NULL), and the
+ * glyph advance.
+ *
+ * \return VLC_SUCCESS, or VLC_EGENERIC if the glyph is not cached
+ */
+int GlyphCacheGetOutlines( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                           FT_Glyph *pp_glyph, FT_Glyph *pp_outline,
+                           FT_Vector *p_advance );
+
+/**
+ * Stores copies of a freshly loaded glyph and outline (which can be NULL).
+ */
+void GlyphCachePutOutlines( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                            FT_Glyph p_glyph, FT_Glyph p_outline,
+                            const FT_Vector *p_advance );
+
+/**
+ * Same as FT_Glyph_To_Bitmap() with FT_RENDER_MODE_NORMAL, using the cached
+ * bitmap when the same glyph (or outline if b_outline) has already been
+ * rasterized at the same subpixel position.
+ *
+ * \param p_cache the glyph cache, or NULL to disable caching
+ */
+FT_Error GlyphCacheToBitmap( glyph_cache_t *p_cache, const glyph_cache_key_t *p_key,
+                             bool b_outline, FT_Glyph *pp_glyph,
+                             const FT_Vector *p_origin, bool b_destroy );
+
+/** @} */
+
+#endif
@@ -131,6 +131,253 @@ void CopyCleanCache(copy_cache_t *cache)
 # undef vlc_CPU_SSE2
 # define vlc_CPU_SSE2() (0)
 #endif
+#if defined(COPY_TEST_NOOPTIM) || defined(COPY_TEST_NOAVX2)
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+/* Same as above, with 256-bit registers: copy 32/128 bytes
+ * Upper halves are cleared (vzeroupper) on return to the SSE code. */
+
+#define COPY32_SHIFTR(x) \
+    "vpsrlw "x", %%ymm1, %%ymm1\n"
+#define COPY32_SHIFTL(x) \
+    "vpsllw "x", %%ymm1, %%ymm1\n"
+
+#define COPY32_S(dstp, srcp, load, store, shiftstr) \
+    asm volatile (                      \
+        load "  0(%[src]), %%ymm1\n"    \
+        shiftstr                        \
+        store " %%ymm1,    0(%[dst])\n" \
+        : : [dst]"r"(dstp), [src]"r"(srcp) : "memory", "xmm1")
+
+#define COPY128_SHIFTR(x) \
+    "vpsrlw "x", %%ymm1, %%ymm1\n" \
+    "vpsrlw "x", %%ymm2, %%ymm2\n" \
+    "vpsrlw "x", %%ymm3, %%ymm3\n" \
+    "vpsrlw "x", %%ymm4, %%ymm4\n"
+#define COPY128_SHIFTL(x) \
+    "vpsllw "x", %%ymm1, %%ymm1\n" \
+    "vpsllw "x", %%ymm2, %%ymm2\n" \
+    "vpsllw "x", %%ymm3, %%ymm3\n" \
+    "vpsllw "x", %%ymm4, %%ymm4\n"
+
+#define COPY128_S(dstp, srcp, load, store, shiftstr) \
+    asm volatile (                      \
+        load "  0(%[src]), %%ymm1\n"    \
+        load " 32(%[src]), %%ymm2\n"    \
+        load " 64(%[src]), %%ymm3\n"    \
+        load " 96(%[src]), %%ymm4\n"    \
+        shiftstr                        \
+        store " %%ymm1,    0(%[dst])\n" \
+        store " %%ymm2,   32(%[dst])\n" \
+        store " %%ymm3,   64(%[dst])\n" \
+        store " %%ymm4,   96(%[dst])\n" \
+        : : [dst]"r"(dstp), [src]"r"(srcp) : "memory", "xmm1", "xmm2", "xmm3", "xmm4")
+
+#define COPY128(dstp, srcp, load, store) \
+    COPY128_S(dstp, srcp, load, store, "")
+
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height, int bitshift)
+{
+    asm volatile ("mfence");
+
+#define AVX2_USWC_COPY(shiftstr32, shiftstr128) \
+    for (unsigned y = 0; y < height; y++) { \
+        const unsigned unaligned = (-(uintptr_t)src) & 0x1f; \
+        unsigned x = 0; \
+        if (unaligned && width >= 32) { \
+            COPY32_S(dst, src, "vmovdqu", "vmovdqu", shiftstr32); \
+            x = unaligned; \
+        } \
+        /* streaming loads need 32 bytes aligned sources */ \
+        if (!unaligned || x) \
+            for (; x+127 < width; x += 128) \
+                COPY128_S(&dst[x], &src[x], "vmovntdqa", "vmovdqu", shiftstr128); \
+        if (x < width) \
+            CopyPlane(&dst[x], dst_pitch - x, &src[x], src_pitch - x, 1, bitshift); \
+        src += src_pitch; \
+        dst += dst_pitch; \
+    }
+
+    switch (bitshift)
+    {
+        case 0:
+            AVX2_USWC_COPY("", "")
+            break;
+        case -6:
+            AVX2_USWC_COPY(COPY32_SHIFTL("$6"), COPY128_SHIFTL("$6"))
+            break;
+        case 6:
+            AVX2_USWC_COPY(COPY32_SHIFTR("$6"), COPY128_SHIFTR("$6"))
+            break;
+        case 2:
+            AVX2_USWC_COPY(COPY32_SHIFTR("$2"), COPY128_SHIFTR("$2"))
+            break;
+        case -2:
+            AVX2_USWC_COPY(COPY32_SHIFTL("$2"), COPY128_SHIFTL("$2"))
+            break;
+        case 4:
+            AVX2_USWC_COPY(COPY32_SHIFTR("$4"), COPY128_SHIFTR("$4"))
+            break;
+        case -4:
+            AVX2_USWC_COPY(COPY32_SHIFTL("$4"), COPY128_SHIFTL("$4"))
+            break;
+        default:
+            vlc_assert_unreachable();
+    }
+#undef AVX2_USWC_COPY
+
+    asm volatile ("vzeroupper");
+    asm volatile ("mfence");
+}
+
+static void AVX2_Copy2d(uint8_t *dst, size_t dst_pitch,
+                        const uint8_t *src, size_t src_pitch,
+                        unsigned width, unsigned height)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        bool unaligned = ((intptr_t)dst & 0x1f) != 0;
+        if (!unaligned) {
+            for (; x+127 < width; x += 128)
+                COPY128(&dst[x], &src[x], "vmovdqu", "vmovntdq");
+        } else {
+            for (; x+127 < width; x += 128)
+                COPY128(&dst[x], &src[x], "vmovdqu", "vmovdqu");
+        }
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+
+    asm volatile ("vzeroupper");
+}
+
+static void
+AVX2_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                  uint8_t *srcu, size_t srcu_pitch,
+                  uint8_t *srcv, size_t srcv_pitch,
+                  unsigned int width, unsigned int height, uint8_t pixel_size)
+{
+    /* Reorder the quadwords so that in-lane unpacking gives the output
+     * order: lanes hold bytes 0-7,16-23 and 8-15,24-31 */
+#define INTERLEAVE64(unpackl, unpackh) \
+    asm volatile (                              \
+        "vmovdqu (%[src1]), %%ymm0\n"           \
+        "vmovdqu (%[src2]), %%ymm1\n"           \
+        "vpermq  $0xd8, %%ymm0, %%ymm0\n"       \
+        "vpermq  $0xd8, %%ymm1, %%ymm1\n"       \
+        unpackh " %%ymm1, %%ymm0, %%ymm2\n"     \
+        unpackl " %%ymm1, %%ymm0, %%ymm0\n"     \
+        "vmovdqu %%ymm0, 0x00(%[dst])\n"        \
+        "vmovdqu %%ymm2, 0x20(%[dst])\n"        \
+        : : [dst]"r"(dst+2*x),                  \
+            [src1]"r"(srcu+x), [src2]"r"(srcv+x) \
+        : "memory", "xmm0", "xmm1", "xmm2")
+
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        unsigned int x = 0;
+
+        if (pixel_size == 1)
+        {
+            for (; x < (width & ~31); x += 32)
+                INTERLEAVE64("vpunpcklbw", "vpunpckhbw");
+            for (; x < width; x++) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcv[x];
+            }
+        }
+        else
+        {
+            for (; x < (width & ~31); x += 32)
+                INTERLEAVE64("vpunpcklwd", "vpunpckhwd");
+            for (; x < width; x+= 2) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcu[x + 1];
+                dst[2*x+2] = srcv[x];
+                dst[2*x+3] = srcv[x + 1];
+            }
+        }
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst += dst_pitch;
+    }
+#undef INTERLEAVE64
+
+    asm volatile ("vzeroupper");
+}
+
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height, uint8_t pixel_size)
+{
+    /* Same in-lane shuffle as SSSE3, then gather the U then V quadwords */
+    static const uint8_t shuffle_8[] = { 0, 2, 4, 6, 8, 10, 12, 14,
+                                         1, 3, 5, 7, 9, 11, 13, 15 };
+    static const uint8_t shuffle_16[] = {  0,  1,  4,  5,  8,  9, 12, 13,
+                                           2,  3,  6,  7, 10, 11, 14, 15 };
+    const uint8_t *shuffle = pixel_size == 1 ? shuffle_8 : shuffle_16;
+
+#define STORE2X16(reg, offset) \
+    "vpermq       $0xd8, %%ymm"reg", %%ymm"reg"\n" \
+    "vmovdqu      %%xmm"reg", "offset"(%[dst1])\n" \
+    "vextracti128 $1, %%ymm"reg", "offset"(%[dst2])\n"
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+        for (; x < (width & ~63); x += 64) {
+            asm volatile (
+                "vbroadcasti128 (%[shuffle]), %%ymm7\n"
+                "vmovdqu   0(%[src]), %%ymm0\n"
+                "vmovdqu  32(%[src]), %%ymm1\n"
+                "vmovdqu  64(%[src]), %%ymm2\n"
+                "vmovdqu  96(%[src]), %%ymm3\n"
+                "vpshufb  %%ymm7, %%ymm0, %%ymm0\n"
+                "vpshufb  %%ymm7, %%ymm1, %%ymm1\n"
+                "vpshufb  %%ymm7, %%ymm2, %%ymm2\n"
+                "vpshufb  %%ymm7, %%ymm3, %%ymm3\n"
+                STORE2X16("0", "0")
+                STORE2X16("1", "16")
+                STORE2X16("2", "32")
+                STORE2X16("3", "48")
+                : : [dst1]"r"(&dstu[x]), [dst2]"r"(&dstv[x]), [src]"r"(&src[2*x]), [shuffle]"r"(shuffle) : "memory", "xmm0", "xmm1", "xmm2", "xmm3", "xmm7");
+        }
+        if (pixel_size == 1)
+        {
+            for (; x < width; x++) {
+                dstu[x] = src[2*x+0];
+                dstv[x] = src[2*x+1];
+            }
+        }
+        else
+        {
+            for (; x < width; x+= 2) {
+                dstu[x] = src[2*x+0];
+                dstu[x+1] = src[2*x+1];
+                dstv[x] = src[2*x+2];
+                dstv[x+1] = src[2*x+3];
+            }
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+#undef STORE2X16
+
+    asm volatile ("vzeroupper");
+}
+#undef COPY128
+#endif /* CAN_COMPILE_AVX2 */
 
 /* Optimized copy from "Uncacheable Speculative Write Combining" memory
  * as used by some video surface.
@@ -143,6 +390,12 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)dst & 0x0f) == 0 && (dst_pitch & 0x0f) == 0);
 
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_CopyFromUswc(dst, dst_pitch, src, src_pitch,
+                                 width, height, bitshift);
+#endif
+
     asm volatile ("mfence");
 
 #define SSE_USWC_COPY(shiftstr16, shiftstr64) \
@@ -196,7 +449,7 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
             SSE_USWC_COPY(COPY16_SHIFTR("$4"), COPY64_SHIFTR("$4"))
             break;
         case -4:
-            SSE_USWC_COPY(COPY16_SHIFTL("$2"), COPY64_SHIFTL("$2"))
+            SSE_USWC_COPY(COPY16_SHIFTL("$4"), COPY64_SHIFTL("$4"))
             break;
         default:
             vlc_assert_unreachable();
@@ -213,6 +466,11 @@ static void Copy2d(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)src & 0x0f) == 0 && (src_pitch & 0x0f) == 0);
 
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy2d(dst, dst_pitch, src, src_pitch, width, height);
+#endif
+
     for (unsigned y = 0; y < height; y++) {
         unsigned x = 0;
 
@@ -243,6 +501,12 @@ SSE_InterleaveUV(uint8_t *dst, size_t dst_pitch,
     assert(!((intptr_t)srcu & 0xf) && !(srcu_pitch & 0x0f) &&
            !((intptr_t)srcv & 0xf) && !(srcv_pitch & 0x0f));
 
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_InterleaveUV(dst, dst_pitch, srcu, srcu_pitch,
+                                 srcv, srcv_pitch, width, height, pixel_size);
+#endif
+
     static const uint8_t shuffle_8[] = { 0, 8,
                                          1, 9,
                                          2, 10,
@@ -358,6 +622,12 @@ static void SSE_SplitUV(uint8_t *dstu, size_t dstu_pitch,
     assert(pixel_size == 1 || pixel_size == 2);
     assert(((intptr_t)src & 0xf) == 0 && (src_pitch & 0x0f) == 0);
 
+#ifdef CAN_COMPILE_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
+                            src, src_pitch, width, height, pixel_size);
+#endif
+
 #define LOAD64 \
     "movdqa  0(%[src]), %%xmm0\n" \
     "movdqa 16(%[src]), %%xmm1\n" \
@@ -1083,6 +1353,32 @@ static void piccheck(picture_t *pic, const vlc_chroma_description_t *dsc,
     }
 }
 
+static void conv_run(const struct test_dst *test_dst, picture_t *dst,
+                     const uint8_t *src_planes[static 3],
+                     const size_t src_pitches[static 3], unsigned height,
+                     const copy_cache_t *cache)
+{
+    if (test_dst->bitshift == 0)
+        test_dst->conv(dst, src_planes, src_pitches, height, cache);
+    else
+        test_dst->conv16(dst, src_planes, src_pitches, height,
+                         test_dst->bitshift, cache);
+}
+
+/* Set COPY_TEST_BENCH to time the conversions of the big sizes */
+#define BENCH_RUNS 50
+static void conv_bench(const struct test_dst *test_dst, picture_t *dst,
+                       const uint8_t *src_planes[static 3],
+                       const size_t src_pitches[static 3], unsigned height,
+                       const copy_cache_t *cache)
+{
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < BENCH_RUNS; i++)
+        conv_run(test_dst, dst, src_planes, src_pitches, height, cache);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    fprintf(stderr, "  %"PRId64" us/frame\n", elapsed / BENCH_RUNS);
+}
+
 static void pic_rsc_destroy(picture_t *pic)
 {
     for (unsigned i = 0; i < 3; i++)
@@ -1108,7 +1404,9 @@ static picture_t *pic_new_unaligned(const video_format_t *fmt)
 
 int main(void)
 {
-    alarm(10);
+    const bool bench = getenv("COPY_TEST_BENCH") != NULL;
+    if (!bench)
+        alarm(10);
 
 #ifndef COPY_TEST_NOOPTIM
     if (!vlc_CPU_SSE2())
@@ -1117,6 +1415,13 @@ int main(void)
         return 77;
     }
 #endif
+#ifdef COPY_TEST_AVX2
+    if (!vlc_CPU_AVX2())
+    {
+        fprintf(stderr, "WARNING: could not test AVX2\n");
+        return 77;
+    }
+#endif
 
     for (size_t i = 0; i < NB_CONVS; ++i)
     {
@@ -1168,14 +1473,12 @@ int main(void)
                         size->i_visible_width, size->i_visible_height,
                         (const char *) &src->format.i_chroma,
                         (const char *) &dst->format.i_chroma);
-                if (test_dst->bitshift == 0)
-                    test_dst->conv(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, &cache);
-                else
-                    test_dst->conv16(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, test_dst->bitshift,
-                                   &cache);
+                conv_run(test_dst, dst, src_planes, src_pitches,
+                         src->format.i_visible_height, &cache);
                 piccheck(dst, dst_dsc, false);
+                if (bench && size->i_width >= 1920)
+                    conv_bench(test_dst, dst, src_planes, src_pitches,
+                               src->format.i_visible_height, &cache);
                 picture_Release(dst);
             }
             picture_Release(src);
@@ -0,0 +1,292 @@
+/*****************************************************************************
+ * placebo.c: libplacebo GPU tone mapping and scaling converter
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include <libplacebo/renderer.h>
+#include <libplacebo/vulkan.h>
+
+#include "../video_output/placebo_utils.h"
+
+/*
+ * Converts HDR pictures to SDR RGBA with a headless Vulkan device: the planes
+ * are uploaded, tone mapped and scaled by the libplacebo renderer, and the
+ * result is downloaded into the output picture. This is meant for the
+ * non-display paths (transcoding, snapshots) which would otherwise go
+ * through swscale, which only converts the matrix and clips the highlights.
+ */
+
+static int  Open(vlc_object_t *);
+static void Close(vlc_object_t *);
+
+vlc_module_begin()
+    set_shortname("libplacebo")
+    set_description(N_("libplacebo GPU tone mapping"))
+    set_capability("video converter", 200)
+    set_category(CAT_VIDEO)
+    set_subcategory(SUBCAT_VIDEO_VFILTER)
+    set_callbacks(Open, Close)
+
+    add_integer("placebo-intent", pl_color_map_default_params.intent,
+            RENDER_INTENT_TEXT, RENDER_INTENT_LONGTEXT, false)
+            change_integer_list(intent_values, intent_text)
+    add_integer("placebo-tone-mapping", pl_color_map_default_params.tone_mapping_algo,
+            TONEMAPPING_TEXT, TONEMAPPING_LONGTEXT, false)
+            change_integer_list(tone_values, tone_text)
+    add_float("placebo-tone-mapping-param", pl_color_map_default_params.tone_mapping_param,
+            TONEMAP_PARAM_TEXT, TONEMAP_PARAM_LONGTEXT, true)
+vlc_module_end()
+
+typedef struct
+{
+    struct pl_context *ctx;
+    const struct pl_vk_inst *instance;
+    const struct pl_vulkan *vulkan;
+    struct pl_renderer *renderer;
+    const struct pl_tex *plane_tex[4];
+    const struct pl_tex *target;
+    const struct pl_fmt *target_fmt;
+
+    struct pl_color_map_params color_map;
+    struct pl_render_params params;
+    uint64_t counter;
+} filter_sys_t;
+
+static bool IsHDR(video_transfer_func_t transfer)
+{
+    return transfer == TRANSFER_FUNC_SMPTE_ST2084 ||
+           transfer == TRANSFER_FUNC_HLG;
+}
+
+static picture_t *Filter(filter_t *filter, picture_t *src)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const struct pl_gpu *gpu = sys->vulkan->gpu;
+    const video_format_t *fmt_in = &filter->fmt_in.video;
+    const video_format_t *fmt_out = &filter->fmt_out.video;
+
+    picture_t *dst = filter_NewPicture(filter);
+    if (dst == NULL)
+        goto error;
+
+    struct pl_image img = {
+        .signature  = sys->counter++,
+        .num_planes = src->i_planes,
+        .width      = src->format.i_visible_width,
+        .height     = src->format.i_visible_height,
+        .color      = vlc_placebo_ColorSpace(fmt_in),
+        .repr       = vlc_placebo_ColorRepr(fmt_in),
+        .src_rect = {
+            .x0 = src->format.i_x_offset,
+            .y0 = src->format.i_y_offset,
+            .x1 = src->format.i_x_offset + src->format.i_visible_width,
+            .y1 = src->format.i_y_offset + src->format.i_visible_height,
+        },
+    };
+
+    struct pl_plane_data data[4];
+    if (!vlc_placebo_PlaneData(src, data, NULL))
+        vlc_assert_unreachable(); /* checked by Open() */
+
+    enum pl_chroma_location chroma_loc = vlc_placebo_ChromaLoc(fmt_in);
+    for (int i = 0; i < src->i_planes; i++)
+    {
+        struct pl_plane *plane = &img.planes[i];
+        if (!pl_upload_plane(gpu, plane, &sys->plane_tex[i], &data[i]))
+        {
+            msg_Err(filter, "Failed uploading image data");
+            goto error;
+        }
+
+        /* Matches only the chroma planes, never luma or alpha */
+        if (chroma_loc != PL_CHROMA_UNKNOWN && i != 0 && i != 3)
+            pl_chroma_location_offset(chroma_loc, &plane->shift_x,
+                                      &plane->shift_y);
+    }
+
+    struct pl_render_target target = {
+        .fbo      = sys->target,
+        .dst_rect = {
+            .x0 = 0,
+            .y0 = 0,
+            .x1 = fmt_out->i_visible_width,
+            .y1 = fmt_out->i_visible_height,
+        },
+        .repr     = pl_color_repr_rgb,
+        .color    = vlc_placebo_ColorSpace(fmt_out),
+    };
+    if (target.color.transfer == PL_COLOR_TRC_UNKNOWN)
+        target.color = pl_color_space_monitor;
+
+    if (!pl_render_image(sys->renderer, &img, &target, &sys->params))
+    {
+        msg_Err(filter, "Failed rendering frame");
+        goto error;
+    }
+
+    const plane_t *p = &dst->p[0];
+    if (!pl_tex_download(gpu, &(struct pl_tex_transfer_params) {
+            .tex      = sys->target,
+            .stride_w = p->i_pitch / p->i_pixel_pitch,
+            .ptr      = p->p_pixels,
+        }))
+    {
+        msg_Err(filter, "Failed downloading frame");
+        goto error;
+    }
+
+    picture_CopyProperties(dst, src);
+    picture_Release(src);
+    return dst;
+
+error:
+    if (dst != NULL)
+        picture_Release(dst);
+    picture_Release(src);
+    return NULL;
+}
+
+static void DestroyGPU(filter_sys_t *sys)
+{
+    if (sys->vulkan != NULL)
+    {
+        const struct pl_gpu *gpu = sys->vulkan->gpu;
+
+        for (int i = 0; i < 4; i++)
+            pl_tex_destroy(gpu, &sys->plane_tex[i]);
+        pl_tex_destroy(gpu, &sys->target);
+    }
+    pl_renderer_destroy(&sys->renderer);
+    pl_vulkan_destroy(&sys->vulkan);
+    pl_vk_inst_destroy(&sys->instance);
+    pl_context_destroy(&sys->ctx);
+}
+
+static int Open(vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    const video_format_t *fmt_in = &filter->fmt_in.video;
+    const video_format_t *fmt_out = &filter->fmt_out.video;
+
+    /* Only take over the conversions that lose the highlights otherwise */
+    if (!IsHDR(fmt_in->transfer) || IsHDR(fmt_out->transfer))
+        return VLC_EGENERIC;
+    if (fmt_out->i_chroma != VLC_CODEC_RGBA
+     || fmt_in->orientation != fmt_out->orientation)
+        return VLC_EGENERIC;
+
+    struct pl_plane_data data[4];
+    if (!vlc_placebo_PlaneFormat(fmt_in, data))
+        return VLC_EGENERIC;
+
+    filter_sys_t *sys = calloc(1, sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    sys->ctx = vlc_placebo_Create(obj);
+    if (sys->ctx == NULL)
+        goto error;
+
+    sys->instance = pl_vk_inst_create(sys->ctx, &(struct pl_vk_inst_params) {
+        .debug = false,
+    });
+    if (sys->instance == NULL)
+        goto error;
+
+    sys->vulkan = pl_vulkan_create(sys->ctx, &(struct pl_vulkan_params) {
+        .instance = sys->instance->instance,
+        .async_transfer = true,
+        .queue_count = 1,
+    });
+    if (sys->vulkan == NULL)
+        goto error;
+
+    const struct pl_gpu *gpu = sys->vulkan->gpu;
+    if (!vlc_placebo_FormatSupported(gpu, fmt_in->i_chroma))
+    {
+        msg_Dbg(filter, "unsupported input chroma %4.4s",
+                (const char *)&fmt_in->i_chroma);
+        goto error;
+    }
+
+    sys->target_fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8,
+                                  PL_FMT_CAP_RENDERABLE |
+                                  PL_FMT_CAP_HOST_READABLE);
+    if (sys->target_fmt == NULL)
+        goto error;
+
+    sys->target = pl_tex_create(gpu, &(struct pl_tex_params) {
+        .w = fmt_out->i_visible_width,
+        .h = fmt_out->i_visible_height,
+        .format = sys->target_fmt,
+        .renderable = true,
+        .host_readable = true,
+    });
+    if (sys->target == NULL)
+        goto error;
+
+    sys->renderer = pl_renderer_create(sys->ctx, gpu);
+    if (sys->renderer == NULL)
+        goto error;
+
+    sys->color_map = pl_color_map_default_params;
+    sys->color_map.intent = var_InheritInteger(filter, "placebo-intent");
+    sys->color_map.tone_mapping_algo =
+        var_InheritInteger(filter, "placebo-tone-mapping");
+    sys->color_map.tone_mapping_param =
+        var_InheritFloat(filter, "placebo-tone-mapping-param");
+
+    sys->params = pl_render_default_params;
+    sys->params.color_map_params = &sys->color_map;
+    sys->params.deband_params = NULL; /* favour throughput */
+
+    filter->p_sys = sys;
+    filter->pf_video_filter = Filter;
+
+    msg_Dbg(filter, "tone mapping %4.4s %ux%u to %4.4s %ux%u on the GPU",
+            (const char *)&fmt_in->i_chroma, fmt_in->i_visible_width,
+            fmt_in->i_visible_height, (const char *)&fmt_out->i_chroma,
+            fmt_out->i_visible_width, fmt_out->i_visible_height);
+    return VLC_SUCCESS;
+
+error:
+    DestroyGPU(sys);
+    free(sys);
+    return VLC_EGENERIC;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    filter_sys_t *sys = filter->p_sys;
+
+    DestroyGPU(sys);
+    free(sys);
+}
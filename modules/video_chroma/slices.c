@@ -0,0 +1,236 @@
+/*****************************************************************************
+ * slices.c: Slice-parallel picture processing
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+
+#include "slices.h"
+
+struct slice_pool
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait; /* signaled when a picture is posted or on exit */
+    vlc_cond_t  done; /* signaled when the last slice is processed */
+    unsigned    refs;
+    bool        busy;
+    bool        quit;
+
+    /* Current picture */
+    slice_cb_t  cb;
+    void       *opaque;
+    unsigned    lines;
+    unsigned    height;
+    unsigned    count;
+    unsigned    next;
+    unsigned    pending;
+
+    unsigned     threads;
+    vlc_thread_t thread[SLICE_MAX_COUNT - 1];
+};
+
+static vlc_mutex_t pool_lock = VLC_STATIC_MUTEX;
+static slice_pool_t *pool_instance = NULL;
+
+static void ProcessSlice(slice_pool_t *pool, unsigned index)
+{
+    const unsigned y = index * pool->height;
+
+    pool->cb(pool->opaque, index, y, __MIN(pool->height, pool->lines - y));
+}
+
+static void *Worker(void *data)
+{
+    slice_pool_t *pool = data;
+
+    vlc_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->quit && pool->next >= pool->count)
+            vlc_cond_wait(&pool->wait, &pool->lock);
+        if (pool->quit)
+            break;
+
+        const unsigned index = pool->next++;
+
+        vlc_mutex_unlock(&pool->lock);
+        ProcessSlice(pool, index);
+        vlc_mutex_lock(&pool->lock);
+
+        assert(pool->pending > 0);
+        if (--pool->pending == 0)
+            vlc_cond_signal(&pool->done);
+    }
+    vlc_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void Stop(slice_pool_t *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    pool->quit = true;
+    vlc_cond_broadcast(&pool->wait);
+    vlc_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < pool->threads; i++)
+        vlc_join(pool->thread[i], NULL);
+
+    vlc_cond_destroy(&pool->done);
+    vlc_cond_destroy(&pool->wait);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+static slice_pool_t *Start(void)
+{
+    unsigned cpus = vlc_GetCPUCount();
+    if (cpus <= 1)
+        return NULL;
+
+    slice_pool_t *pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait);
+    vlc_cond_init(&pool->done);
+    pool->refs = 1;
+    pool->busy = false;
+    pool->quit = false;
+    pool->count = 0;
+    pool->next = 0;
+    pool->pending = 0;
+    pool->threads = 0;
+
+    /* The calling thread processes one slice too */
+    for (unsigned i = 0; i < __MIN(cpus, SLICE_MAX_COUNT) - 1; i++)
+    {
+        if (vlc_clone(&pool->thread[i], Worker, pool,
+                      VLC_THREAD_PRIORITY_VIDEO))
+            break;
+        pool->threads++;
+    }
+
+    if (pool->threads == 0)
+    {
+        Stop(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+slice_pool_t *SlicePoolHold(void)
+{
+    vlc_mutex_lock(&pool_lock);
+    slice_pool_t *pool = pool_instance;
+    if (pool != NULL)
+        pool->refs++;
+    else
+        pool = pool_instance = Start();
+    vlc_mutex_unlock(&pool_lock);
+    return pool;
+}
+
+void SlicePoolRelease(slice_pool_t *pool)
+{
+    if (pool == NULL)
+        return;
+
+    vlc_mutex_lock(&pool_lock);
+    assert(pool == pool_instance);
+    if (--pool->refs == 0)
+        pool_instance = NULL;
+    else
+        pool = NULL;
+    vlc_mutex_unlock(&pool_lock);
+
+    if (pool != NULL)
+        Stop(pool);
+}
+
+unsigned SlicePoolSplit(const slice_pool_t *pool, unsigned lines,
+                        unsigned align, unsigned *pi_height)
+{
+    unsigned count = pool != NULL ? pool->threads + 1 : 1;
+
+    assert(align > 0);
+    count = __MIN(count, lines / SLICE_MIN_LINES);
+    if (count <= 1)
+    {
+        *pi_height = lines;
+        return 1;
+    }
+
+    unsigned height = (lines + count - 1) / count;
+    height = (height + align - 1) / align * align;
+
+    *pi_height = height;
+    return (lines + height - 1) / height;
+}
+
+void SlicePoolRun(slice_pool_t *pool, unsigned lines, unsigned align,
+                  slice_cb_t cb, void *opaque)
+{
+    unsigned height;
+    const unsigned count = SlicePoolSplit(pool, lines, align, &height);
+
+    if (count > 1)
+    {
+        vlc_mutex_lock(&pool->lock);
+        if (!pool->busy)
+        {
+            pool->busy = true;
+            pool->cb = cb;
+            pool->opaque = opaque;
+            pool->lines = lines;
+            pool->height = height;
+            pool->count = count;
+            pool->next = 0;
+            pool->pending = count;
+            vlc_cond_broadcast(&pool->wait);
+
+            while (pool->next < pool->count)
+            {
+                const unsigned index = pool->next++;
+
+                vlc_mutex_unlock(&pool->lock);
+                ProcessSlice(pool, index);
+                vlc_mutex_lock(&pool->lock);
+                pool->pending--;
+            }
+
+            while (pool->pending > 0)
+                vlc_cond_wait(&pool->done, &pool->lock);
+            pool->busy = false;
+            vlc_mutex_unlock(&pool->lock);
+            return;
+        }
+        vlc_mutex_unlock(&pool->lock);
+    }
+
+    /* Single slice, or the workers are busy with another picture */
+    for (unsigned i = 0, y = 0; i < count; i++, y += height)
+        cb(opaque, i, y, __MIN(height, lines - y));
+}
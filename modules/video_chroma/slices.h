@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * slices.h: Slice-parallel picture processing
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VIDEOCHROMA_SLICES_H_
+#define VLC_VIDEOCHROMA_SLICES_H_
+
+/* Maximum number of slices a picture is split into */
+#define SLICE_MAX_COUNT (16)
+/* Slices are never smaller than this, so that small pictures stay on a
+ * single thread */
+#define SLICE_MIN_LINES (64)
+
+typedef struct slice_pool slice_pool_t;
+
+/* Processes lines [y, y + height) of slice index */
+typedef void (*slice_cb_t)(void *opaque, unsigned index,
+                           unsigned y, unsigned height);
+
+/* Returns the worker pool shared by all the filters of the module, or NULL
+ * if there is a single CPU (or on error). A NULL pool is valid for all the
+ * functions below, slices are then processed by the calling thread. */
+slice_pool_t *SlicePoolHold(void);
+void SlicePoolRelease(slice_pool_t *pool);
+
+/* Returns the number of slices [0, lines) is split into; all slices are
+ * *pi_height lines (a multiple of align) except the last one. */
+unsigned SlicePoolSplit(const slice_pool_t *pool, unsigned lines,
+                        unsigned align, unsigned *pi_height);
+
+/* Calls cb for each slice as given by SlicePoolSplit(), and waits for all
+ * of them. If the pool is busy with another picture, the calling thread
+ * processes all the slices itself. */
+void SlicePoolRun(slice_pool_t *pool, unsigned lines, unsigned align,
+                  slice_cb_t cb, void *opaque);
+
+#endif
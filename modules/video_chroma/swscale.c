@@ -43,6 +43,7 @@
 #endif
 
 #include "../codec/avcodec/chroma.h" // Chroma Avutil <-> VLC conversion
+#include "slices.h"
 
 /* Gruikkkkkkkkkk!!!!! */
 #undef AVPALETTE_SIZE
@@ -96,6 +97,11 @@ typedef struct
 
     struct SwsContext *ctx;
     struct SwsContext *ctxA;
+    /* One context per slice, when lines can be converted independently */
+    slice_pool_t *pool;
+    struct SwsContext *slice_ctx[SLICE_MAX_COUNT];
+    unsigned i_slices;
+    unsigned i_slice_align;
     picture_t *p_src_a;
     picture_t *p_dst_a;
     int i_extend_factor;
@@ -110,6 +116,7 @@ typedef struct
 static picture_t *Filter( filter_t *, picture_t * );
 static int  Init( filter_t * );
 static void Clean( filter_t * );
+static void CleanSlices( filter_sys_t * );
 
 typedef struct
 {
@@ -182,9 +189,11 @@ static int OpenScaler( vlc_object_t *p_this )
     /* Misc init */
     memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
     memset( &p_sys->fmt_out, 0, sizeof(p_sys->fmt_out) );
+    p_sys->pool = SlicePoolHold();
 
     if( Init( p_filter ) )
     {
+        SlicePoolRelease( p_sys->pool );
         if( p_sys->p_filter )
             sws_freeFilter( p_sys->p_filter );
         free( p_sys );
@@ -215,6 +224,7 @@ static void CloseScaler( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     Clean( p_filter );
+    SlicePoolRelease( p_sys->pool );
     if( p_sys->p_filter )
         sws_freeFilter( p_sys->p_filter );
     free( p_sys );
@@ -349,6 +359,29 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+/* Returns the line alignment of the slices, or 0 if the conversion cannot be
+ * split: swscale then needs the neighbouring lines of a slice (vertical
+ * scaling or chroma resampling) and would leave seams at their borders. */
+static unsigned GetSliceAlignment( const filter_sys_t *p_sys,
+                                   const ScalerConfiguration *p_cfg,
+                                   const video_format_t *p_fmti,
+                                   const video_format_t *p_fmto )
+{
+    if( p_cfg->b_copy || p_cfg->b_has_a || p_sys->i_extend_factor != 1 ||
+        p_fmti->i_visible_height != p_fmto->i_visible_height )
+        return 0;
+
+    const vlc_chroma_description_t *in = p_sys->desc_in;
+    const vlc_chroma_description_t *out = p_sys->desc_out;
+    const unsigned i_den_in  = in->plane_count > 1 ? in->p[1].h.den / in->p[1].h.num : 1;
+    const unsigned i_den_out = out->plane_count > 1 ? out->p[1].h.den / out->p[1].h.num : 1;
+    if( i_den_in != i_den_out )
+        return 0;
+
+    /* Keep the slices aligned on the chroma lines */
+    return i_den_in;
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -437,6 +470,35 @@ static int Init( filter_t *p_filter )
         return VLC_EGENERIC;
     }
 
+    p_sys->i_slice_align = GetSliceAlignment( p_sys, &cfg, p_fmti, p_fmto );
+    if( p_sys->i_slice_align > 0 )
+    {
+        unsigned i_slice_height;
+        const unsigned i_slices = SlicePoolSplit( p_sys->pool, p_fmti->i_visible_height,
+                                                  p_sys->i_slice_align, &i_slice_height );
+
+        for( unsigned i = 0; i < i_slices && i_slices > 1; i++ )
+        {
+            const unsigned i_height = __MIN( i_slice_height,
+                                             p_fmti->i_visible_height - i * i_slice_height );
+
+            p_sys->slice_ctx[i] = sws_getContext( i_fmti_visible_width, i_height, cfg.i_fmti,
+                                                  i_fmto_visible_width, i_height, cfg.i_fmto,
+                                                  cfg.i_sws_flags | p_sys->i_cpu_mask,
+                                                  p_sys->p_filter, NULL, 0 );
+            p_sys->i_slices = i + 1;
+            if( p_sys->slice_ctx[i] == NULL )
+            {   /* Not fatal, convert the whole picture at once */
+                msg_Warn( p_filter, "could not init sliced SwScaler" );
+                CleanSlices( p_sys );
+                break;
+            }
+        }
+        if( p_sys->i_slices > 1 )
+            msg_Dbg( p_filter, "converting in %u slices of %u lines",
+                     p_sys->i_slices, i_slice_height );
+    }
+
     if (p_filter->b_allow_fmt_out_change)
     {
         /*
@@ -467,10 +529,20 @@ static int Init( filter_t *p_filter )
     return VLC_SUCCESS;
 }
 
+static void CleanSlices( filter_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < p_sys->i_slices; i++ )
+        if( p_sys->slice_ctx[i] )
+            sws_freeContext( p_sys->slice_ctx[i] );
+    p_sys->i_slices = 0;
+}
+
 static void Clean( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    CleanSlices( p_sys );
+
     if( p_sys->p_src_e )
         picture_Release( p_sys->p_src_e );
     if( p_sys->p_dst_e )
@@ -583,8 +655,15 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
     picture_CopyPixels( p_dst, &tmp );
 }
 
+static void OffsetPixels( uint8_t *pp_pixel[4], const int pi_pitch[4],
+                          const vlc_chroma_description_t *desc, int i_y )
+{
+    for( unsigned i = 0; i < desc->plane_count && pp_pixel[i]; i++ )
+        pp_pixel[i] += ((i_y * desc->p[i].h.num) / desc->p[i].h.den) * pi_pitch[i];
+}
+
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
-                     picture_t *p_dst, picture_t *p_src, int i_height,
+                     picture_t *p_dst, picture_t *p_src, int i_y, int i_height,
                      int i_plane_count, bool b_swap_uvi, bool b_swap_uvo )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -595,6 +674,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 
     GetPixels( src, src_stride, p_sys->desc_in, &p_filter->fmt_in.video,
                p_src, i_plane_count, b_swap_uvi );
+    OffsetPixels( src, src_stride, p_sys->desc_in, i_y );
     if( p_filter->fmt_in.video.i_chroma == VLC_CODEC_RGBP )
     {
         memset( palette, 0, sizeof(palette) );
@@ -607,6 +687,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 
     GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
                p_dst, i_plane_count, b_swap_uvo );
+    OffsetPixels( dst, dst_stride, p_sys->desc_out, i_y );
 
     for (size_t i = 0; i < ARRAY_SIZE(src); i++)
         csrc[i] = src[i];
@@ -620,6 +701,25 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 #endif
 }
 
+typedef struct
+{
+    filter_t  *p_filter;
+    picture_t *p_dst;
+    picture_t *p_src;
+    int        i_plane_count;
+} slice_job_t;
+
+static void ConvertSlice( void *opaque, unsigned i_index,
+                          unsigned i_y, unsigned i_height )
+{
+    const slice_job_t *p_job = opaque;
+    filter_sys_t *p_sys = p_job->p_filter->p_sys;
+
+    assert( i_index < p_sys->i_slices );
+    Convert( p_job->p_filter, p_sys->slice_ctx[i_index], p_job->p_dst, p_job->p_src,
+             i_y, i_height, p_job->i_plane_count, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************
@@ -667,8 +767,15 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         /* Even if alpha is unused, swscale expects the pointer to be set */
         const int n_planes = !p_sys->ctxA && (p_src->i_planes == 4 ||
                              p_dst->i_planes == 4) ? 4 : 3;
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_visible_height,
-                 n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        if( p_sys->i_slices > 1 )
+        {
+            slice_job_t job = { p_filter, p_dst, p_src, n_planes };
+            SlicePoolRun( p_sys->pool, p_fmti->i_visible_height,
+                          p_sys->i_slice_align, ConvertSlice, &job );
+        }
+        else
+            Convert( p_filter, p_sys->ctx, p_dst, p_src, 0, p_fmti->i_visible_height,
+                     n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
     }
     if( p_sys->ctxA )
     {
@@ -681,7 +788,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
 
         Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a,
-                 p_fmti->i_visible_height, 1, false, false );
+                 0, p_fmti->i_visible_height, 1, false, false );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
             InjectA( p_dst, p_sys->p_dst_a, OFFSET_A );
         else if( p_fmto->i_chroma == VLC_CODEC_ARGB )
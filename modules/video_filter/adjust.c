@@ -49,6 +49,7 @@ static int  Create    ( vlc_object_t * );
 static void Destroy   ( vlc_object_t * );
 
 static picture_t *FilterPlanar( filter_t *, picture_t * );
+static void AdjustPlanar( filter_t *, picture_t *, picture_t * );
 static picture_t *FilterPacked( filter_t *, picture_t * );
 static int AdjustCallback( vlc_object_t *p_this, char const *psz_var,
                            vlc_value_t oldval, vlc_value_t newval,
@@ -123,6 +124,18 @@ typedef struct
                                int, int );
     int (*pf_process_sat_hue_clip)( picture_t *, picture_t *, int, int,
                                     int, int, int );
+
+    /* Luma lookup table of the planar filter, and the parameters it was
+     * computed for: it is used for each band of the in-place filter */
+    struct
+    {
+        bool    b_valid;
+        bool    b_threshold;
+        int32_t i_cont;
+        int32_t i_lum;
+        float   f_gamma;
+        int     pi_luma[1024];
+    } lut;
 } filter_sys_t;
 
 /*****************************************************************************
@@ -144,6 +157,7 @@ static int Create( vlc_object_t *p_this )
     if( p_filter->p_sys == NULL )
         return VLC_ENOMEM;
     p_sys = p_filter->p_sys;
+    p_sys->lut.b_valid = false;
 
     /* Choose Planar/Packed function and pointer to a Hue/Saturation processing
      * function*/
@@ -152,6 +166,7 @@ static int Create( vlc_object_t *p_this )
         CASE_PLANAR_YUV
             /* Planar YUV */
             p_filter->pf_video_filter = FilterPlanar;
+            p_filter->pf_video_filter_inplace = AdjustPlanar;
             p_sys->pf_process_sat_hue_clip = planar_sat_hue_clip_C;
             p_sys->pf_process_sat_hue = planar_sat_hue_C;
             break;
@@ -160,6 +175,7 @@ static int Create( vlc_object_t *p_this )
         CASE_PLANAR_YUV9
             /* Planar YUV 9-bit or 10-bit */
             p_filter->pf_video_filter = FilterPlanar;
+            p_filter->pf_video_filter_inplace = AdjustPlanar;
             p_sys->pf_process_sat_hue_clip = planar_sat_hue_clip_C_16;
             p_sys->pf_process_sat_hue = planar_sat_hue_C_16;
             break;
@@ -230,14 +246,8 @@ static void Destroy( vlc_object_t *p_this )
  *****************************************************************************/
 static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
 {
-    /* The full range will only be used for 10-bit */
-    int pi_luma[1024];
-    int pi_gamma[1024];
-
     picture_t *p_outpic;
 
-    filter_sys_t *p_sys = p_filter->p_sys;
-
     if( !p_pic ) return NULL;
 
     p_outpic = filter_NewPicture( p_filter );
@@ -247,6 +257,23 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
+    AdjustPlanar( p_filter, p_outpic, p_pic );
+
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
+
+/*****************************************************************************
+ * Adjust a Planar YUV picture into p_outpic, which can be the same
+ *****************************************************************************/
+static void AdjustPlanar( filter_t *p_filter, picture_t *p_outpic,
+                          picture_t *p_pic )
+{
+    /* The full range will only be used for 10-bit */
+    int pi_gamma[1024];
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+    int *pi_luma = p_sys->lut.pi_luma;
+
     bool b_16bit;
     float f_range;
     switch( p_filter->fmt_in.video.i_chroma )
@@ -276,12 +303,26 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     float f_hue = vlc_atomic_load_float( &p_sys->f_hue ) * (float)(M_PI / 180.);
     int i_sat = (int)( vlc_atomic_load_float( &p_sys->f_saturation ) * f_range );
     float f_gamma = 1.f / vlc_atomic_load_float( &p_sys->f_gamma );
+    bool b_threshold = atomic_load( &p_sys->b_brightness_threshold );
 
+    if( p_sys->lut.b_valid && p_sys->lut.b_threshold == b_threshold
+     && p_sys->lut.i_cont == i_cont && p_sys->lut.i_lum == i_lum
+     && p_sys->lut.f_gamma == f_gamma )
+    {
+        /* The lookup table is up to date */
+        if( b_threshold )
+            i_sat = 0;
+    }
     /*
      * Threshold mode drops out everything about luma, contrast and gamma.
      */
-    if( !atomic_load( &p_sys->b_brightness_threshold ) )
+    else if( !b_threshold )
     {
+        p_sys->lut.b_valid = true;
+        p_sys->lut.b_threshold = b_threshold;
+        p_sys->lut.i_cont = i_cont;
+        p_sys->lut.i_lum = i_lum;
+        p_sys->lut.f_gamma = f_gamma;
 
         /* Contrast is a fast but kludged function, so I put this gap to be
          * cleaner :) */
@@ -301,6 +342,12 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     }
     else
     {
+        p_sys->lut.b_valid = true;
+        p_sys->lut.b_threshold = b_threshold;
+        p_sys->lut.i_cont = i_cont;
+        p_sys->lut.i_lum = i_lum;
+        p_sys->lut.f_gamma = f_gamma;
+
         /*
          * We get luma as threshold value: the higher it is, the darker is
          * the image. Should I reverse this?
@@ -417,8 +464,6 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
         p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
                                         i_x, i_y );
     }
-
-    return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
 /*****************************************************************************
@@ -31,8 +31,13 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(HAVE_SSE2_INTRINSICS) || defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -84,6 +89,28 @@ public:
     {
         return true;
     }
+    CPicture shifted(unsigned dx) const
+    {
+        return CPicture(picture, fmt, x + dx, y);
+    }
+    uint8_t *getPixels(unsigned plane, unsigned rx = 1, unsigned ry = 1,
+                       unsigned bytes = 1) const
+    {
+        return &picture->p[plane].p_pixels[(y / ry) * picture->p[plane].i_pitch +
+                                           (x / rx) * bytes];
+    }
+    int getPitch(unsigned plane) const
+    {
+        return picture->p[plane].i_pitch;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
 
 protected:
     template <unsigned ry>
@@ -527,6 +554,106 @@ private:
     G g;
 };
 
+/* Raw planes for the vectorized kernels */
+struct CPlanes {
+    uint8_t       *dst[3];
+    int            dst_pitch[3];
+    const uint8_t *src[4];
+    int            src_pitch[4];
+    unsigned       width; /* multiple of the kernel block */
+    unsigned       height;
+    unsigned       alpha;
+    unsigned       offset[3]; /* byte offsets of R, G and B for RGB32 */
+    bool           odd;       /* the first destination line has no chroma */
+    bool           swap_uv;
+};
+
+typedef void (*blend_kernel_t)(const CPlanes &);
+
+#ifdef HAVE_SSE2_INTRINSICS
+# pragma GCC push_options
+# pragma GCC target("sse2")
+namespace sse2 {
+typedef __m128i V;
+static const unsigned W = 8;
+
+static inline V vset16(int v)       { return _mm_set1_epi16(v); }
+static inline V vset32(int v)       { return _mm_set1_epi32(v); }
+static inline V vadd16(V a, V b)    { return _mm_add_epi16(a, b); }
+static inline V vsub16(V a, V b)    { return _mm_sub_epi16(a, b); }
+static inline V vmul16(V a, V b)    { return _mm_mullo_epi16(a, b); }
+static inline V vsrl16(V a, int n)  { return _mm_srli_epi16(a, n); }
+static inline V vsra16(V a, int n)  { return _mm_srai_epi16(a, n); }
+static inline V vsll16(V a, int n)  { return _mm_slli_epi16(a, n); }
+static inline V vsrl32(V a, int n)  { return _mm_srli_epi32(a, n); }
+static inline V vsll32(V a, int n)  { return _mm_slli_epi32(a, n); }
+static inline V vsll32v(V a, int n) { return _mm_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+static inline V vand(V a, V b)      { return _mm_and_si128(a, b); }
+static inline V vor(V a, V b)       { return _mm_or_si128(a, b); }
+static inline V vpack32(V a, V b)   { return _mm_packs_epi32(a, b); }
+static inline V vwidenlo(V a)       { return _mm_unpacklo_epi8(a, _mm_setzero_si128()); }
+static inline V vwidenhi(V a)       { return _mm_unpackhi_epi8(a, _mm_setzero_si128()); }
+static inline V vnarrow(V a, V b)   { return _mm_packus_epi16(a, b); }
+static inline V vload(const uint8_t *p) { return _mm_loadu_si128((const V *)p); }
+static inline void vstore(uint8_t *p, V v) { _mm_storeu_si128((V *)p, v); }
+static inline V vload8(const uint8_t *p)
+{
+    return vwidenlo(_mm_loadl_epi64((const V *)p));
+}
+static inline void vstore8(uint8_t *p, V v)
+{
+    _mm_storel_epi64((V *)p, vnarrow(v, v));
+}
+
+# include "blend_simd.h"
+} // namespace sse2
+# pragma GCC pop_options
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+# pragma GCC push_options
+# pragma GCC target("avx2")
+namespace avx2 {
+typedef __m256i V;
+static const unsigned W = 16;
+
+/* Packing instructions work on 128-bits lanes, their results are put back
+ * in order so that V always holds consecutive pixels */
+static inline V vorder(V a)         { return _mm256_permute4x64_epi64(a, 0xd8); }
+
+static inline V vset16(int v)       { return _mm256_set1_epi16(v); }
+static inline V vset32(int v)       { return _mm256_set1_epi32(v); }
+static inline V vadd16(V a, V b)    { return _mm256_add_epi16(a, b); }
+static inline V vsub16(V a, V b)    { return _mm256_sub_epi16(a, b); }
+static inline V vmul16(V a, V b)    { return _mm256_mullo_epi16(a, b); }
+static inline V vsrl16(V a, int n)  { return _mm256_srli_epi16(a, n); }
+static inline V vsra16(V a, int n)  { return _mm256_srai_epi16(a, n); }
+static inline V vsll16(V a, int n)  { return _mm256_slli_epi16(a, n); }
+static inline V vsrl32(V a, int n)  { return _mm256_srli_epi32(a, n); }
+static inline V vsll32(V a, int n)  { return _mm256_slli_epi32(a, n); }
+static inline V vsll32v(V a, int n) { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+static inline V vand(V a, V b)      { return _mm256_and_si256(a, b); }
+static inline V vor(V a, V b)       { return _mm256_or_si256(a, b); }
+static inline V vpack32(V a, V b)   { return vorder(_mm256_packs_epi32(a, b)); }
+static inline V vwidenlo(V a)       { return _mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)); }
+static inline V vwidenhi(V a)       { return _mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)); }
+static inline V vnarrow(V a, V b)   { return vorder(_mm256_packus_epi16(a, b)); }
+static inline V vload(const uint8_t *p) { return _mm256_loadu_si256((const V *)p); }
+static inline void vstore(uint8_t *p, V v) { _mm256_storeu_si256((V *)p, v); }
+static inline V vload8(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+static inline void vstore8(uint8_t *p, V v)
+{
+    _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(vnarrow(v, v)));
+}
+
+# include "blend_simd.h"
+} // namespace avx2
+# pragma GCC pop_options
+#endif
+
 } // namespace
 
 template <class TDst, class TSrc, class TConvert>
@@ -558,16 +685,100 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+/* Fills the planes for the vectorized kernels, returns false if the
+ * destination position is not supported */
+static bool GetPlanes(CPlanes *planes, const CPicture &dst, const CPicture &src)
+{
+    const video_format_t *fmt = dst.getFormat();
+
+    memset(planes, 0, sizeof(*planes));
+    switch (fmt->i_chroma) {
+    case VLC_CODEC_I420:
+    case VLC_CODEC_J420:
+    case VLC_CODEC_YV12:
+    case VLC_CODEC_NV12:
+    case VLC_CODEC_NV21: {
+        /* Chroma must start on a full pixel */
+        if (dst.getX() % 2)
+            return false;
+        const bool semiplanar = fmt->i_chroma == VLC_CODEC_NV12 ||
+                                fmt->i_chroma == VLC_CODEC_NV21;
+        const int planes_count = semiplanar ? 2 : 3;
+        const bool swap = fmt->i_chroma == VLC_CODEC_YV12;
+
+        for (int i = 0; i < planes_count; i++) {
+            const int plane = swap && i > 0 ? 3 - i : i;
+            planes->dst[i] = i == 0 ? dst.getPixels(0)
+                                    : dst.getPixels(plane, 2, 2, semiplanar ? 2 : 1);
+            planes->dst_pitch[i] = dst.getPitch(plane);
+        }
+        planes->odd = dst.getY() % 2;
+        planes->swap_uv = fmt->i_chroma == VLC_CODEC_NV21;
+        break;
+    }
+    case VLC_CODEC_RGB32: {
+        int offset_r, offset_g, offset_b;
+        if (GetPackedRgbIndexes(fmt, &offset_r, &offset_g, &offset_b) != VLC_SUCCESS ||
+            offset_r == offset_g || offset_g == offset_b || offset_b == offset_r)
+            return false;
+        planes->dst[0] = dst.getPixels(0, 1, 1, 4);
+        planes->dst_pitch[0] = dst.getPitch(0);
+        planes->offset[0] = offset_r;
+        planes->offset[1] = offset_g;
+        planes->offset[2] = offset_b;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if (src.getFormat()->i_chroma == VLC_CODEC_RGBA) {
+        planes->src[0] = src.getPixels(0, 1, 1, 4);
+        planes->src_pitch[0] = src.getPitch(0);
+    } else {
+        for (int i = 0; i < 4; i++) {
+            planes->src[i] = src.getPixels(i);
+            planes->src_pitch[i] = src.getPitch(i);
+        }
+    }
+    return true;
+}
+
+/* Blends the largest multiple of the kernel block, and the remaining
+ * columns with the generic code */
+template <class TDst, class TSrc, class TConvert,
+          unsigned block, blend_kernel_t kernel>
+void BlendVector(const CPicture &dst_data, const CPicture &src_data,
+                 unsigned width, unsigned height, int alpha)
+{
+    CPlanes planes;
+    unsigned done = 0;
+
+    if (width >= block && GetPlanes(&planes, dst_data, src_data)) {
+        planes.width  = width / block * block;
+        planes.height = height;
+        planes.alpha  = alpha;
+        kernel(planes);
+        done = planes.width;
+    }
+
+    if (done < width)
+        Blend<TDst, TSrc, TConvert>(dst_data.shifted(done), src_data.shifted(done),
+                                    width - done, height, alpha);
+}
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
 namespace {
 
-static const struct {
+struct blend_entry {
     vlc_fourcc_t     dst;
     vlc_fourcc_t     src;
     blend_function_t blend;
-} blends[] = {
+};
+
+static const blend_entry blends[] = {
 #undef RGB
 #undef YUV
 #define RGB(csp, picture, cvt) \
@@ -637,6 +848,42 @@ static const struct {
 #undef YUV
 };
 
+#define VECTOR(isa) \
+    { VLC_CODEC_I420,  VLC_CODEC_RGBA, BlendVector<CPictureI420_8, CPictureRGBA, compose<convertNone, convertRgbToYuv8>, isa::block, isa::BlendRgbaToI420> }, \
+    { VLC_CODEC_J420,  VLC_CODEC_RGBA, BlendVector<CPictureI420_8, CPictureRGBA, compose<convertNone, convertRgbToYuv8>, isa::block, isa::BlendRgbaToI420> }, \
+    { VLC_CODEC_YV12,  VLC_CODEC_RGBA, BlendVector<CPictureYV12,   CPictureRGBA, compose<convertNone, convertRgbToYuv8>, isa::block, isa::BlendRgbaToI420> }, \
+    { VLC_CODEC_NV12,  VLC_CODEC_RGBA, BlendVector<CPictureNV12,   CPictureRGBA, compose<convertNone, convertRgbToYuv8>, isa::block, isa::BlendRgbaToNV12> }, \
+    { VLC_CODEC_NV21,  VLC_CODEC_RGBA, BlendVector<CPictureNV21,   CPictureRGBA, compose<convertNone, convertRgbToYuv8>, isa::block, isa::BlendRgbaToNV12> }, \
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendVector<CPictureRGB32,  CPictureRGBA, compose<convertNone, convertNone>,      isa::block, isa::BlendRgbaToRgb32> }, \
+    { VLC_CODEC_I420,  VLC_CODEC_YUVA, BlendVector<CPictureI420_8, CPictureYUVA, compose<convertNone, convertNone>,      isa::block, isa::BlendYuvaToI420> }, \
+    { VLC_CODEC_J420,  VLC_CODEC_YUVA, BlendVector<CPictureI420_8, CPictureYUVA, compose<convertNone, convertNone>,      isa::block, isa::BlendYuvaToI420> }, \
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVA, BlendVector<CPictureYV12,   CPictureYUVA, compose<convertNone, convertNone>,      isa::block, isa::BlendYuvaToI420> }, \
+    { VLC_CODEC_NV12,  VLC_CODEC_YUVA, BlendVector<CPictureNV12,   CPictureYUVA, compose<convertNone, convertNone>,      isa::block, isa::BlendYuvaToNV12> }, \
+    { VLC_CODEC_NV21,  VLC_CODEC_YUVA, BlendVector<CPictureNV21,   CPictureYUVA, compose<convertNone, convertNone>,      isa::block, isa::BlendYuvaToNV12> }
+
+#ifdef HAVE_SSE2_INTRINSICS
+static const blend_entry blends_sse2[] = {
+    VECTOR(sse2),
+};
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+static const blend_entry blends_avx2[] = {
+    VECTOR(avx2),
+};
+#endif
+#undef VECTOR
+
+static blend_function_t FindBlend(const blend_entry *table, size_t count,
+                                  vlc_fourcc_t dst, vlc_fourcc_t src,
+                                  blend_function_t fallback)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (table[i].src == src && table[i].dst == dst)
+            return table[i].blend;
+    }
+    return fallback;
+}
+
 struct filter_sys_t {
     filter_sys_t() : blend(NULL)
     {
@@ -687,10 +934,15 @@ static int Open(vlc_object_t *object)
     const vlc_fourcc_t dst = filter->fmt_out.video.i_chroma;
 
     filter_sys_t *sys = new filter_sys_t();
-    for (size_t i = 0; i < sizeof(blends) / sizeof(*blends); i++) {
-        if (blends[i].src == src && blends[i].dst == dst)
-            sys->blend = blends[i].blend;
-    }
+    sys->blend = FindBlend(blends, ARRAY_SIZE(blends), dst, src, NULL);
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE2())
+        sys->blend = FindBlend(blends_sse2, ARRAY_SIZE(blends_sse2), dst, src, sys->blend);
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        sys->blend = FindBlend(blends_avx2, ARRAY_SIZE(blends_avx2), dst, src, sys->blend);
+#endif
 
     if (!sys->blend) {
        msg_Err(filter, "no matching alpha blending routine (chroma: %4.4s -> %4.4s)",
@@ -711,3 +963,128 @@ static void Close(vlc_object_t *object)
     delete p_sys;
 }
 
+
+#ifdef BLEND_TEST
+/* Checks the vectorized blending against the generic code.
+ * Set BLEND_TEST_BENCH to time them on a full 4K overlay. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BENCH_RUNS 20
+
+static picture_t *NewPicture(vlc_fourcc_t chroma, unsigned width, unsigned height)
+{
+    video_format_t fmt;
+
+    video_format_Init(&fmt, chroma);
+    fmt.i_width  = fmt.i_visible_width  = width;
+    fmt.i_height = fmt.i_visible_height = height;
+    video_format_FixRgb(&fmt);
+
+    picture_t *pic = picture_NewFromFormat(&fmt);
+    if (pic == NULL)
+        abort();
+    for (int i = 0; i < pic->i_planes; i++)
+        for (int n = 0; n < pic->p[i].i_pitch * pic->p[i].i_lines; n++)
+            pic->p[i].p_pixels[n] = rand();
+    return pic;
+}
+
+static bool SamePixels(const picture_t *a, const picture_t *b)
+{
+    for (int i = 0; i < a->i_planes; i++)
+        if (memcmp(a->p[i].p_pixels, b->p[i].p_pixels,
+                   a->p[i].i_pitch * a->p[i].i_lines))
+            return false;
+    return true;
+}
+
+static void Run(blend_function_t blend, picture_t *dst, const picture_t *src,
+                unsigned x, unsigned y, unsigned width, unsigned height,
+                int alpha)
+{
+    blend(CPicture(dst, &dst->format, x, y), CPicture(src, &src->format, 0, 0),
+          width, height, alpha);
+}
+
+static vlc_tick_t Bench(blend_function_t blend, picture_t *dst, const picture_t *src)
+{
+    vlc_tick_t start = vlc_tick_now();
+    for (int i = 0; i < BENCH_RUNS; i++)
+        Run(blend, dst, src, 0, 0, src->format.i_width, src->format.i_height, 255);
+    return (vlc_tick_now() - start) / BENCH_RUNS;
+}
+
+static int Check(const char *name, const blend_entry *table, size_t count,
+                 bool bench)
+{
+    static const unsigned sizes[][2] = {
+        { 1, 1 }, { 7, 3 }, { 16, 2 }, { 31, 5 }, { 32, 32 }, { 97, 33 },
+    };
+    static const int alphas[] = { 255, 128, 1 };
+
+    for (size_t i = 0; i < count; i++) {
+        const blend_entry *e = &table[i];
+        blend_function_t generic =
+            FindBlend(blends, ARRAY_SIZE(blends), e->dst, e->src, NULL);
+
+        for (size_t s = 0; s < ARRAY_SIZE(sizes); s++)
+            for (unsigned off = 0; off < 4; off++) {
+                const unsigned w = sizes[s][0], h = sizes[s][1];
+                const unsigned x = off, y = (off * 3) % 4;
+                picture_t *src = NewPicture(e->src, w, h);
+                picture_t *ref = NewPicture(e->dst, w + 8, h + 8);
+                picture_t *dst = NewPicture(e->dst, w + 8, h + 8);
+
+                picture_CopyPixels(dst, ref);
+                for (size_t a = 0; a < ARRAY_SIZE(alphas); a++) {
+                    Run(generic, ref, src, x, y, w, h, alphas[a]);
+                    Run(e->blend, dst, src, x, y, w, h, alphas[a]);
+                }
+                if (!SamePixels(ref, dst)) {
+                    fprintf(stderr, "%s: %4.4s -> %4.4s %ux%u at %u,%u mismatch\n",
+                            name, (const char *)&e->src, (const char *)&e->dst,
+                            w, h, x, y);
+                    return 1;
+                }
+                picture_Release(dst);
+                picture_Release(ref);
+                picture_Release(src);
+            }
+
+        if (bench) {
+            picture_t *src = NewPicture(e->src, 3840, 2160);
+            picture_t *dst = NewPicture(e->dst, 3840, 2160);
+
+            vlc_tick_t t_generic = Bench(generic, dst, src);
+            vlc_tick_t t_vector = Bench(e->blend, dst, src);
+            printf("%s: %4.4s -> %4.4s: generic %" PRId64 " us, vector %" PRId64 " us\n",
+                   name, (const char *)&e->src, (const char *)&e->dst,
+                   US_FROM_VLC_TICK(t_generic), US_FROM_VLC_TICK(t_vector));
+            picture_Release(dst);
+            picture_Release(src);
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    const bool bench = getenv("BLEND_TEST_BENCH") != NULL;
+    int ret = 77;
+
+    if (!bench)
+        alarm(10);
+
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE2())
+        ret = Check("SSE2", blends_sse2, ARRAY_SIZE(blends_sse2), bench);
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if (ret != 1 && vlc_CPU_AVX2())
+        ret = Check("AVX2", blends_avx2, ARRAY_SIZE(blends_avx2), bench);
+#endif
+    return ret;
+}
+#endif
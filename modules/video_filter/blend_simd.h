@@ -0,0 +1,257 @@
+/*****************************************************************************
+ * blend_simd.h: Vectorized blending of the most common chroma pairs
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included by blend.cpp once per instruction set, inside a
+ * namespace defining the V vector type holding W 16-bits values, and the
+ * v*() primitives. It has no include guard on purpose.
+ *
+ * The kernels give exactly the same results as the generic templates:
+ * all the computations fit in 16-bits lanes for 8-bits samples, and merging
+ * with a null alpha leaves the destination untouched, so transparent
+ * pixels need no special case. */
+
+/* Number of pixels processed at once */
+static const unsigned block = 2 * W;
+
+static inline V Div255(V v)
+{
+    return vsrl16(vadd16(vadd16(v, vsrl16(v, 8)), vset16(1)), 8);
+}
+
+static inline V Merge(V dst, V src, V a)
+{
+    return Div255(vadd16(vmul16(vsub16(vset16(255), a), dst), vmul16(src, a)));
+}
+
+/* Keeps the even pixels of two consecutive vectors */
+static inline V Even(V lo, V hi)
+{
+    const V mask = vset32(0xffff);
+    return vpack32(vand(lo, mask), vand(hi, mask));
+}
+
+/* Fetches one component of W RGBA pixels */
+static inline V RgbaComponent(const uint8_t *p, int shift)
+{
+    const V mask = vset32(0xff);
+    return vpack32(vand(vsrl32(vload(p), shift), mask),
+                   vand(vsrl32(vload(p + sizeof(V)), shift), mask));
+}
+
+/* Same as rgb_to_yuv(), the U and V intermediates fit in signed 16-bits */
+static inline V RgbToY(V r, V g, V b)
+{
+    V y = vadd16(vadd16(vmul16(r, vset16(66)), vmul16(g, vset16(129))),
+                 vadd16(vmul16(b, vset16(25)), vset16(128)));
+    return vadd16(vsrl16(y, 8), vset16(16));
+}
+
+static inline V RgbToU(V r, V g, V b)
+{
+    V u = vsub16(vadd16(vmul16(b, vset16(112)), vset16(128)),
+                 vadd16(vmul16(r, vset16(38)), vmul16(g, vset16(74))));
+    return vadd16(vsra16(u, 8), vset16(128));
+}
+
+static inline V RgbToV(V r, V g, V b)
+{
+    V v = vsub16(vadd16(vmul16(r, vset16(112)), vset16(128)),
+                 vadd16(vmul16(g, vset16(94)), vmul16(b, vset16(18))));
+    return vadd16(vsra16(v, 8), vset16(128));
+}
+
+struct CVector {
+    V y, u, v, a;
+};
+
+/* Fetches W source pixels as YUV, with the global alpha applied */
+template <bool rgba>
+static inline void Fetch(CVector *px, const uint8_t *const src[4],
+                         unsigned x, bool chroma, V alpha)
+{
+    V a;
+    if (rgba) {
+        const uint8_t *p = &src[0][4 * x];
+        const V r = RgbaComponent(p, 0);
+        const V g = RgbaComponent(p, 8);
+        const V b = RgbaComponent(p, 16);
+
+        a = RgbaComponent(p, 24);
+        px->y = RgbToY(r, g, b);
+        if (chroma) {
+            px->u = RgbToU(r, g, b);
+            px->v = RgbToV(r, g, b);
+        }
+    } else {
+        a = vload8(&src[3][x]);
+        px->y = vload8(&src[0][x]);
+        if (chroma) {
+            px->u = vload8(&src[1][x]);
+            px->v = vload8(&src[2][x]);
+        }
+    }
+    px->a = Div255(vmul16(alpha, a));
+}
+
+static inline void MergeLuma(uint8_t *dst, const CVector &px)
+{
+    vstore8(dst, Merge(vload8(dst), px.y, px.a));
+}
+
+static inline void NextLines(const CPlanes &p, const uint8_t *src[4],
+                             uint8_t *dst[3], unsigned line)
+{
+    for (unsigned i = 0; i < 4; i++)
+        src[i] += p.src_pitch[i];
+    dst[0] += p.dst_pitch[0];
+    /* The next line is even */
+    if ((line + p.odd) % 2) {
+        dst[1] += p.dst_pitch[1];
+        dst[2] += p.dst_pitch[2];
+    }
+}
+
+/* To planar 4:2:0, chroma is taken from the top left pixel of each 2x2
+ * block as in CPictureYUVPlanar */
+template <bool rgba>
+static void BlendToPlanar420(const CPlanes &p)
+{
+    const V alpha = vset16(p.alpha);
+    const uint8_t *src[4] = { p.src[0], p.src[1], p.src[2], p.src[3] };
+    uint8_t *dst[3] = { p.dst[0], p.dst[1], p.dst[2] };
+
+    for (unsigned line = 0; line < p.height; line++) {
+        const bool chroma = ((line + p.odd) % 2) == 0;
+
+        for (unsigned x = 0; x < p.width; x += block) {
+            CVector lo, hi;
+
+            Fetch<rgba>(&lo, src, x, chroma, alpha);
+            Fetch<rgba>(&hi, src, x + W, chroma, alpha);
+            MergeLuma(&dst[0][x], lo);
+            MergeLuma(&dst[0][x + W], hi);
+            if (chroma) {
+                const V a = Even(lo.a, hi.a);
+                uint8_t *u = &dst[1][x / 2];
+                uint8_t *v = &dst[2][x / 2];
+
+                vstore8(u, Merge(vload8(u), Even(lo.u, hi.u), a));
+                vstore8(v, Merge(vload8(v), Even(lo.v, hi.v), a));
+            }
+        }
+        NextLines(p, src, dst, line);
+    }
+}
+
+template <bool rgba>
+static void BlendToSemiPlanar420(const CPlanes &p)
+{
+    const V alpha = vset16(p.alpha);
+    const uint8_t *src[4] = { p.src[0], p.src[1], p.src[2], p.src[3] };
+    uint8_t *dst[3] = { p.dst[0], p.dst[1], NULL };
+
+    for (unsigned line = 0; line < p.height; line++) {
+        const bool chroma = ((line + p.odd) % 2) == 0;
+
+        for (unsigned x = 0; x < p.width; x += block) {
+            CVector lo, hi;
+
+            Fetch<rgba>(&lo, src, x, chroma, alpha);
+            Fetch<rgba>(&hi, src, x + W, chroma, alpha);
+            MergeLuma(&dst[0][x], lo);
+            MergeLuma(&dst[0][x + W], hi);
+            if (chroma) {
+                const V a = Even(lo.a, hi.a);
+                V u = Even(lo.u, hi.u);
+                V v = Even(lo.v, hi.v);
+                if (p.swap_uv) {
+                    const V t = u;
+                    u = v;
+                    v = t;
+                }
+                /* Interleave as 8-bits pairs, then widen each half again */
+                const V uv = vor(u, vsll16(v, 8));
+                const V aa = vor(a, vsll16(a, 8));
+                uint8_t *c = &dst[1][x];
+
+                vstore8(c, Merge(vload8(c), vwidenlo(uv), vwidenlo(aa)));
+                vstore8(c + W, Merge(vload8(c + W), vwidenhi(uv), vwidenhi(aa)));
+            }
+        }
+        NextLines(p, src, dst, line);
+    }
+}
+
+/* To packed 32-bits RGB, the bytes are merged in place: the padding byte is
+ * merged with itself, which leaves it untouched. */
+static void BlendRgbaToRgb32(const CPlanes &p)
+{
+    const V alpha = vset32(p.alpha);
+    const V mask = vset32(0xff);
+    const V padding = vset32(~((0xffu << (8 * p.offset[0])) |
+                               (0xffu << (8 * p.offset[1])) |
+                               (0xffu << (8 * p.offset[2]))));
+    const uint8_t *src = p.src[0];
+    uint8_t *dst = p.dst[0];
+
+    for (unsigned line = 0; line < p.height; line++) {
+        for (unsigned x = 0; x < 4 * p.width; x += sizeof(V)) {
+            const V s = vload(&src[x]);
+            const V d = vload(&dst[x]);
+            const V r = vand(s, mask);
+            const V g = vand(vsrl32(s, 8), mask);
+            const V b = vand(vsrl32(s, 16), mask);
+
+            /* 32-bits lanes have null upper halves: 16-bits maths apply */
+            V a = Div255(vmul16(alpha, vsrl32(s, 24)));
+            a = vor(vor(a, vsll32(a, 8)), vor(vsll32(a, 16), vsll32(a, 24)));
+
+            const V c = vor(vor(vsll32v(r, 8 * p.offset[0]),
+                                vsll32v(g, 8 * p.offset[1])),
+                            vor(vsll32v(b, 8 * p.offset[2]),
+                                vand(d, padding)));
+
+            vstore(&dst[x], vnarrow(Merge(vwidenlo(d), vwidenlo(c), vwidenlo(a)),
+                                    Merge(vwidenhi(d), vwidenhi(c), vwidenhi(a))));
+        }
+        src += p.src_pitch[0];
+        dst += p.dst_pitch[0];
+    }
+}
+
+static void BlendRgbaToI420(const CPlanes &p)
+{
+    BlendToPlanar420<true>(p);
+}
+
+static void BlendYuvaToI420(const CPlanes &p)
+{
+    BlendToPlanar420<false>(p);
+}
+
+static void BlendRgbaToNV12(const CPlanes &p)
+{
+    BlendToSemiPlanar420<true>(p);
+}
+
+static void BlendYuvaToNV12(const CPlanes &p)
+{
+    BlendToSemiPlanar420<false>(p);
+}
@@ -1,5 +1,5 @@
 /*****************************************************************************
- * algo_yadif.c : Wrapper for FFmpeg's Yadif algorithm
+ * algo_yadif.c : Wrapper for FFmpeg's Yadif and Bwdif algorithms
  *****************************************************************************
  * Copyright (C) 2000-2011 VLC authors and VideoLAN
  *
@@ -45,17 +45,198 @@
 /* yadif.h comes from yadif.c of FFmpeg project.
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
+#include "bwdif.h"
 
-int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
+typedef void (*yadif_line_t)( uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                              uint8_t *next, int w, int prefs, int mrefs,
+                              int parity, int mode );
+typedef void (*bwdif_line_t)( uint8_t *dst, const uint8_t *prev,
+                              const uint8_t *cur, const uint8_t *next,
+                              int w, int prefs, int mrefs, int parity );
+
+/* State shared by the slices of one plane */
+typedef struct
 {
-    return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
+    const plane_t *prev, *cur, *next;
+    plane_t *dst;
+
+    int i_field;
+    int i_parity;
+    unsigned i_pixel_size;
+    int i_max;
+
+    bool b_bwdif;
+    /* Filters all the samples of a line */
+    yadif_line_t pf_yadif;
+    /* Filters the first multiple of i_block samples, or NULL */
+    yadif_line_t pf_yadif_simd;
+    bwdif_line_t pf_bwdif_simd;
+    int i_block;
+} yadif_plane_t;
+
+static void YadifSelect( yadif_plane_t *ctx )
+{
+    ctx->pf_yadif = yadif_filter_line_c;
+    ctx->pf_yadif_simd = NULL;
+    ctx->pf_bwdif_simd = NULL;
+    ctx->i_block = 1;
+
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+    {
+        ctx->pf_yadif_simd = vlcpriv_yadif_line_avx2;
+        ctx->pf_bwdif_simd = vlcpriv_bwdif_line_avx2;
+        ctx->i_block = 16;
+        return;
+    }
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+    {
+        ctx->pf_yadif_simd = vlcpriv_yadif_line_sse2;
+        ctx->pf_bwdif_simd = vlcpriv_bwdif_line_sse2;
+        ctx->i_block = 8;
+    }
+#endif
+#if defined(HAVE_X86ASM)
+    /* Prefer the assembly versions, they filter the whole line */
+    if( vlc_CPU_SSSE3() )
+        ctx->pf_yadif = vlcpriv_yadif_filter_line_ssse3;
+    else
+    if( vlc_CPU_SSE2() )
+        ctx->pf_yadif = vlcpriv_yadif_filter_line_sse2;
+#if defined(__i386__)
+    else
+    if( vlc_CPU_MMXEXT() )
+        ctx->pf_yadif = vlcpriv_yadif_filter_line_mmxext;
+#endif
+    if( ctx->pf_yadif != yadif_filter_line_c )
+        ctx->pf_yadif_simd = NULL;
+#endif
+#ifdef __ARM_NEON
+    if( vlc_CPU_ARM_NEON() )
+    {
+        ctx->pf_yadif_simd = vlcpriv_yadif_line_neon;
+        ctx->pf_bwdif_simd = vlcpriv_bwdif_line_neon;
+        ctx->i_block = 8;
+    }
+#endif
 }
 
-int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
-                 int i_order, int i_field )
+static void YadifLine( const yadif_plane_t *ctx, uint8_t *dst,
+                       uint8_t *prev, uint8_t *cur, uint8_t *next,
+                       int w, int y, int lines, int pitch )
 {
-    VLC_UNUSED(p_src);
+    /* Spatial checks only when enough data */
+    int mode = (y >= 2 && y < lines - 2) ? 0 : 2;
+    int prefs = y < lines - 2 ? pitch : -pitch;
+    int mrefs = y - 1 ? -pitch : pitch;
+
+    if( ctx->i_pixel_size == 2 )
+    {
+        /* The 16-bits filter takes the width in samples */
+        yadif_filter_line_c_16bit( dst, prev, cur, next, w / 2,
+                                   prefs, mrefs, ctx->i_parity, mode );
+        return;
+    }
+
+    int x = 0;
+    if( ctx->pf_yadif_simd != NULL )
+    {
+        ctx->pf_yadif_simd( dst, prev, cur, next, w, prefs, mrefs,
+                            ctx->i_parity, mode );
+        x = w / ctx->i_block * ctx->i_block;
+    }
+    if( x < w )
+        ctx->pf_yadif( &dst[x], &prev[x], &cur[x], &next[x], w - x,
+                       prefs, mrefs, ctx->i_parity, mode );
+}
 
+static void BwdifLine( const yadif_plane_t *ctx, uint8_t *dst,
+                       const uint8_t *prev, const uint8_t *cur,
+                       const uint8_t *next, int w, int y, int lines, int pitch )
+{
+    const unsigned size = ctx->i_pixel_size;
+    const int refs = pitch / (int)size;
+    const int samples = w / (int)size;
+
+    if( y < 4 || y + 5 > lines )
+    {
+        int prefs = y + 1 < lines ? refs : -refs;
+        int mrefs = y ? -refs : refs;
+        bool spatial = y >= 2 && y + 2 < lines;
+
+        if( size == 2 )
+            bwdif_filter_edge_cuint16_t( dst, prev, cur, next, samples,
+                                         prefs, mrefs, ctx->i_parity,
+                                         spatial, ctx->i_max );
+        else
+            bwdif_filter_edge_cuint8_t( dst, prev, cur, next, samples,
+                                        prefs, mrefs, ctx->i_parity,
+                                        spatial, ctx->i_max );
+        return;
+    }
+
+    if( size == 2 )
+    {
+        bwdif_filter_line_cuint16_t( dst, prev, cur, next, samples,
+                                     refs, -refs, ctx->i_parity, ctx->i_max );
+        return;
+    }
+
+    int x = 0;
+    if( ctx->pf_bwdif_simd != NULL )
+    {
+        ctx->pf_bwdif_simd( dst, prev, cur, next, samples, refs, -refs,
+                            ctx->i_parity );
+        x = samples / ctx->i_block * ctx->i_block;
+    }
+    if( x < samples )
+        bwdif_filter_line_cuint8_t( &dst[x], &prev[x], &cur[x], &next[x],
+                                    samples - x, refs, -refs, ctx->i_parity,
+                                    ctx->i_max );
+}
+
+/* Renders line y of the destination plane */
+static void RenderLine( const yadif_plane_t *ctx, int y )
+{
+    const int lines = ctx->dst->i_visible_lines;
+    const int pitch = ctx->cur->i_pitch;
+    const int w = ctx->dst->i_visible_pitch;
+    int src_y = y;
+
+    /* Yadif does not filter the first and last lines, but duplicates the
+     * lines next to them. They are rendered again rather than copied, so
+     * that slices never depend on each other. */
+    if( !ctx->b_bwdif )
+        src_y = VLC_CLIP( y, 1, lines - 2 );
+
+    uint8_t *dst = &ctx->dst->p_pixels[y * ctx->dst->i_pitch];
+    uint8_t *prev = &ctx->prev->p_pixels[src_y * pitch];
+    uint8_t *cur = &ctx->cur->p_pixels[src_y * pitch];
+    uint8_t *next = &ctx->next->p_pixels[src_y * pitch];
+
+    if( (src_y % 2) == ctx->i_field  ||  ctx->i_parity == 2 )
+        memcpy( dst, cur, w );
+    else if( ctx->b_bwdif )
+        BwdifLine( ctx, dst, prev, cur, next, w, src_y, lines, pitch );
+    else
+        YadifLine( ctx, dst, prev, cur, next, w, src_y, lines, pitch );
+}
+
+static void RenderSlice( void *opaque, unsigned index,
+                         unsigned y, unsigned height )
+{
+    const yadif_plane_t *ctx = opaque;
+    VLC_UNUSED(index);
+
+    for( unsigned i = y; i < y + height; i++ )
+        RenderLine( ctx, i );
+}
+
+static int RenderYadifCommon( filter_t *p_filter, picture_t *p_dst,
+                              int i_order, int i_field, bool b_bwdif )
+{
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* */
@@ -108,70 +289,31 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     /* Filter if we have all the pictures we need */
     if( p_prev && p_cur && p_next )
     {
-        /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
-
-#if defined(HAVE_X86ASM)
-        if( vlc_CPU_SSSE3() )
-            filter = vlcpriv_yadif_filter_line_ssse3;
-        else
-        if( vlc_CPU_SSE2() )
-            filter = vlcpriv_yadif_filter_line_sse2;
-        else
-#if defined(__i386__)
-        if( vlc_CPU_MMXEXT() )
-            filter = vlcpriv_yadif_filter_line_mmxext;
-        else
-#endif
-#endif
-            filter = yadif_filter_line_c;
-
-        if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
+        yadif_plane_t ctx = {
+            .i_field = i_field,
+            .i_parity = yadif_parity,
+            .i_pixel_size = p_sys->chroma->pixel_size,
+            .i_max = (1 << p_sys->chroma->pixel_bits) - 1,
+            .b_bwdif = b_bwdif,
+        };
+        YadifSelect( &ctx );
 
         for( int n = 0; n < p_dst->i_planes; n++ )
         {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
+            ctx.prev = &p_prev->p[n];
+            ctx.cur  = &p_cur->p[n];
+            ctx.next = &p_next->p[n];
+            ctx.dst  = &p_dst->p[n];
 
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
+            assert( ctx.prev->i_pitch == ctx.cur->i_pitch &&
+                    ctx.cur->i_pitch == ctx.next->i_pitch );
+            if( ctx.dst->i_visible_lines < 3 )
             {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
+                plane_CopyPixels( ctx.dst, ctx.cur );
+                continue;
             }
+            SlicePoolRun( p_sys->slices, ctx.dst->i_visible_lines, 1,
+                          RenderSlice, &ctx );
         }
 
         p_sys->context.i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
@@ -194,3 +336,27 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
         return VLC_EGENERIC;
     }
 }
+
+int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
+                 int i_order, int i_field )
+{
+    VLC_UNUSED(p_src);
+    return RenderYadifCommon( p_filter, p_dst, i_order, i_field, false );
+}
+
+int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
+{
+    return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
+}
+
+int RenderBwdif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
+                 int i_order, int i_field )
+{
+    VLC_UNUSED(p_src);
+    return RenderYadifCommon( p_filter, p_dst, i_order, i_field, true );
+}
+
+int RenderBwdifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
+{
+    return RenderBwdif( p_filter, p_dst, p_src, 0, 0 );
+}
@@ -90,4 +90,43 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
  */
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src );
 
+/**
+ * Bwdif (Bob Weaver DeInterlacing Filter) from FFmpeg.
+ *
+ * Same as RenderYadif(), but the missing lines are interpolated with
+ * multi-tap filters (from w3fdif) instead of yadif's edge-directed
+ * interpolation. It is sharper, at the expense of more computations.
+ */
+int RenderBwdif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
+                 int i_order, int i_field );
+
+/**
+ * Same as RenderBwdif() but with no temporal references
+ */
+int RenderBwdifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src );
+
+/*****************************************************************************
+ * Intrinsics line filters
+ *****************************************************************************/
+
+/* They filter the first multiple of 8 (16 for AVX2) samples of the line;
+ * the caller filters the remaining ones in C. */
+#define YADIF_SIMD_LINE(name) \
+void vlcpriv_yadif_line_##name( uint8_t *dst, uint8_t *prev, uint8_t *cur, \
+                                uint8_t *next, int w, int prefs, int mrefs, \
+                                int parity, int mode ); \
+void vlcpriv_bwdif_line_##name( uint8_t *dst, const uint8_t *prev, \
+                                const uint8_t *cur, const uint8_t *next, \
+                                int w, int prefs, int mrefs, int parity );
+
+#ifdef HAVE_SSE2_INTRINSICS
+YADIF_SIMD_LINE(sse2)
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+YADIF_SIMD_LINE(avx2)
+#endif
+#ifdef __ARM_NEON
+YADIF_SIMD_LINE(neon)
+#endif
+
 #endif
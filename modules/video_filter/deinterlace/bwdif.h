@@ -0,0 +1,120 @@
+/*****************************************************************************
+ * bwdif.h : Bob Weaver deinterlacing filter, C implementation
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Bwdif uses the same temporal and spatial checks as Yadif, but interpolates
+ * the missing lines with the w3fdif filter coefficients: the low frequencies
+ * from the current field, the high frequencies from the fields around it.
+ * It is included once, by algo_yadif.c. The line functions follow the yadif
+ * ones: prefs and mrefs are the offsets, in samples, of the lines below and
+ * above, and parity selects the (prev2, next2) fields. */
+
+/* Coefficients, scaled by 1 << 13 */
+#define BWDIF_LF0 4309
+#define BWDIF_LF1 213
+#define BWDIF_HF0 5570
+#define BWDIF_HF1 3801
+#define BWDIF_HF2 1016
+#define BWDIF_SP0 5077
+#define BWDIF_SP1 981
+
+/* Restricts the interpolated value around the temporal prediction d */
+#define BWDIF_CLIP(interpol, d, diff, max) \
+    __MIN(__MAX(__MIN(__MAX(interpol, (d) - (diff)), (d) + (diff)), 0), max)
+
+#define BWDIF_TEMPORAL \
+        int c = cur[mrefs]; \
+        int d = (prev2[0] + next2[0]) >> 1; \
+        int e = cur[prefs]; \
+        int temporal_diff0 = abs(prev2[0] - next2[0]); \
+        int temporal_diff1 = (abs(prev[mrefs] - c) + abs(prev[prefs] - e)) >> 1; \
+        int temporal_diff2 = (abs(next[mrefs] - c) + abs(next[prefs] - e)) >> 1; \
+        int diff = FFMAX3(temporal_diff0 >> 1, temporal_diff1, temporal_diff2);
+
+#define BWDIF_SPATIAL \
+        { \
+            int b = ((prev2[2 * mrefs] + next2[2 * mrefs]) >> 1) - c; \
+            int f = ((prev2[2 * prefs] + next2[2 * prefs]) >> 1) - e; \
+            int max = FFMAX3(d - e, d - c, FFMIN(b, f)); \
+            int min = FFMIN3(d - e, d - c, FFMAX(b, f)); \
+            diff = FFMAX3(diff, min, -max); \
+        }
+
+#define BWDIF_NEXT \
+        dst++; cur++; prev++; next++; prev2++; next2++;
+
+/* Lines with 4 known lines above and below, prefs and mrefs are the line
+ * pitch and its opposite */
+#define BWDIF_FILTER_LINE(type) \
+static void bwdif_filter_line_c##type(void *dst8, const void *prev8, \
+                                      const void *cur8, const void *next8, \
+                                      int w, int prefs, int mrefs, int parity, \
+                                      int max) \
+{ \
+    type *dst = dst8; \
+    const type *prev = prev8, *cur = cur8, *next = next8; \
+    const type *prev2 = parity ? prev : cur; \
+    const type *next2 = parity ? cur : next; \
+    \
+    for (int x = 0; x < w; x++) { \
+        BWDIF_TEMPORAL \
+        BWDIF_SPATIAL \
+        int interpol; \
+        if (abs(c - e) > temporal_diff0) \
+            interpol = (((BWDIF_HF0 * (prev2[0] + next2[0]) \
+                          - BWDIF_HF1 * (prev2[2 * mrefs] + next2[2 * mrefs] \
+                                       + prev2[2 * prefs] + next2[2 * prefs]) \
+                          + BWDIF_HF2 * (prev2[4 * mrefs] + next2[4 * mrefs] \
+                                       + prev2[4 * prefs] + next2[4 * prefs])) >> 2) \
+                        + BWDIF_LF0 * (c + e) \
+                        - BWDIF_LF1 * (cur[3 * mrefs] + cur[3 * prefs])) >> 13; \
+        else \
+            interpol = (BWDIF_SP0 * (c + e) \
+                        - BWDIF_SP1 * (cur[3 * mrefs] + cur[3 * prefs])) >> 13; \
+        dst[0] = BWDIF_CLIP(interpol, d, diff, max); \
+        BWDIF_NEXT \
+    } \
+}
+
+/* Lines near the picture edges, interpolated from the lines above and below
+ * only; the spatial check needs 2 known lines above and below. */
+#define BWDIF_FILTER_EDGE(type) \
+static void bwdif_filter_edge_c##type(void *dst8, const void *prev8, \
+                                      const void *cur8, const void *next8, \
+                                      int w, int prefs, int mrefs, int parity, \
+                                      bool spatial, int max) \
+{ \
+    type *dst = dst8; \
+    const type *prev = prev8, *cur = cur8, *next = next8; \
+    const type *prev2 = parity ? prev : cur; \
+    const type *next2 = parity ? cur : next; \
+    \
+    for (int x = 0; x < w; x++) { \
+        BWDIF_TEMPORAL \
+        if (spatial) \
+            BWDIF_SPATIAL \
+        dst[0] = BWDIF_CLIP((c + e) >> 1, d, diff, max); \
+        BWDIF_NEXT \
+    } \
+}
+
+BWDIF_FILTER_LINE(uint8_t)
+BWDIF_FILTER_LINE(uint16_t)
+BWDIF_FILTER_EDGE(uint8_t)
+BWDIF_FILTER_EDGE(uint16_t)
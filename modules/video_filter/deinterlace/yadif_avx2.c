@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * yadif_avx2.c: AVX2 Yadif and Bwdif line filters
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "algo_yadif.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+# pragma GCC target("avx2")
+# include <immintrin.h>
+
+typedef __m256i V;
+#define W 16
+#define SIMD(name) vlcpriv_##name##_avx2
+
+static inline V vset(int v)        { return _mm256_set1_epi16(v); }
+static inline V vadd(V a, V b)     { return _mm256_add_epi16(a, b); }
+static inline V vsub(V a, V b)     { return _mm256_sub_epi16(a, b); }
+static inline V vsra1(V a)         { return _mm256_srai_epi16(a, 1); }
+static inline V vmin(V a, V b)     { return _mm256_min_epi16(a, b); }
+static inline V vmax(V a, V b)     { return _mm256_max_epi16(a, b); }
+static inline V vabs(V a)          { return vmax(a, vsub(_mm256_setzero_si256(), a)); }
+static inline V vgt(V a, V b)      { return _mm256_cmpgt_epi16(a, b); }
+static inline V vand(V a, V b)     { return _mm256_and_si256(a, b); }
+static inline V vsel(V m, V a, V b)
+{
+    return _mm256_or_si256(_mm256_and_si256(m, a), _mm256_andnot_si256(m, b));
+}
+static inline V vload8(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+static inline void vstore8(uint8_t *p, V v)
+{
+    /* Packing works on 128-bits lanes, put the two halves back in order */
+    V packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xd8);
+    _mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(packed));
+}
+
+/* a * ka + b * kb for each pair of 16-bits lanes, in 32-bits; unpacking
+ * and packing back both work per 128-bits lanes, so the order is kept */
+static inline void vmadd(V a, V b, int ka, int kb, __m256i *lo, __m256i *hi)
+{
+    const V k = _mm256_set1_epi32((ka & 0xffff) | (kb << 16));
+    *lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), k);
+    *hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), k);
+}
+
+/* Same coefficients as bwdif.h */
+static inline V vbwdif_hf(V t0, V s2, V s4, V ce, V ce3)
+{
+    __m256i hlo, hhi, h4lo, h4hi, llo, lhi;
+
+    vmadd(t0, s2, 5570, -3801, &hlo, &hhi);
+    vmadd(s4, _mm256_setzero_si256(), 1016, 0, &h4lo, &h4hi);
+    vmadd(ce, ce3, 4309, -213, &llo, &lhi);
+    hlo = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(hlo, h4lo), 2), llo);
+    hhi = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(hhi, h4hi), 2), lhi);
+    return _mm256_packs_epi32(_mm256_srai_epi32(hlo, 13), _mm256_srai_epi32(hhi, 13));
+}
+
+static inline V vbwdif_sp(V ce, V ce3)
+{
+    __m256i lo, hi;
+
+    vmadd(ce, ce3, 5077, -981, &lo, &hi);
+    return _mm256_packs_epi32(_mm256_srai_epi32(lo, 13), _mm256_srai_epi32(hi, 13));
+}
+
+# include "yadif_simd.h"
+#endif
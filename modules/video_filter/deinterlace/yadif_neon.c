@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * yadif_neon.c: NEON Yadif and Bwdif line filters
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "algo_yadif.h"
+
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+
+typedef int16x8_t V;
+#define W 8
+#define SIMD(name) vlcpriv_##name##_neon
+
+static inline V vset(int v)        { return vdupq_n_s16(v); }
+static inline V vadd(V a, V b)     { return vaddq_s16(a, b); }
+static inline V vsub(V a, V b)     { return vsubq_s16(a, b); }
+static inline V vsra1(V a)         { return vshrq_n_s16(a, 1); }
+static inline V vmin(V a, V b)     { return vminq_s16(a, b); }
+static inline V vmax(V a, V b)     { return vmaxq_s16(a, b); }
+static inline V vabs(V a)          { return vabsq_s16(a); }
+static inline V vgt(V a, V b)      { return vreinterpretq_s16_u16(vcgtq_s16(a, b)); }
+static inline V vand(V a, V b)     { return vandq_s16(a, b); }
+static inline V vsel(V m, V a, V b)
+{
+    return vbslq_s16(vreinterpretq_u16_s16(m), a, b);
+}
+static inline V vload8(const uint8_t *p)
+{
+    return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+}
+static inline void vstore8(uint8_t *p, V v)
+{
+    vst1_u8(p, vqmovun_s16(v));
+}
+
+/* Same coefficients as bwdif.h */
+static inline V vbwdif_hf(V t0, V s2, V s4, V ce, V ce3)
+{
+    int32x4_t lo = vmull_n_s16(vget_low_s16(t0), 5570);
+    int32x4_t hi = vmull_n_s16(vget_high_s16(t0), 5570);
+
+    lo = vmlsl_n_s16(lo, vget_low_s16(s2), 3801);
+    hi = vmlsl_n_s16(hi, vget_high_s16(s2), 3801);
+    lo = vmlal_n_s16(lo, vget_low_s16(s4), 1016);
+    hi = vmlal_n_s16(hi, vget_high_s16(s4), 1016);
+    lo = vshrq_n_s32(lo, 2);
+    hi = vshrq_n_s32(hi, 2);
+    lo = vmlal_n_s16(lo, vget_low_s16(ce), 4309);
+    hi = vmlal_n_s16(hi, vget_high_s16(ce), 4309);
+    lo = vmlsl_n_s16(lo, vget_low_s16(ce3), 213);
+    hi = vmlsl_n_s16(hi, vget_high_s16(ce3), 213);
+    return vcombine_s16(vshrn_n_s32(lo, 13), vshrn_n_s32(hi, 13));
+}
+
+static inline V vbwdif_sp(V ce, V ce3)
+{
+    int32x4_t lo = vmull_n_s16(vget_low_s16(ce), 5077);
+    int32x4_t hi = vmull_n_s16(vget_high_s16(ce), 5077);
+
+    lo = vmlsl_n_s16(lo, vget_low_s16(ce3), 981);
+    hi = vmlsl_n_s16(hi, vget_high_s16(ce3), 981);
+    return vcombine_s16(vshrn_n_s32(lo, 13), vshrn_n_s32(hi, 13));
+}
+
+# include "yadif_simd.h"
+#endif
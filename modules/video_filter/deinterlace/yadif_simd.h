@@ -0,0 +1,162 @@
+/*****************************************************************************
+ * yadif_simd.h: Vectorized Yadif and Bwdif line filters
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included once per instruction set, after the definitions of
+ * the V vector type holding W 16-bits values, of the v*() primitives and of
+ * the SIMD() name decorator. It has no include guard on purpose.
+ *
+ * The kernels give exactly the same results as the C line filters of yadif.h
+ * and bwdif.h: 8-bits samples, their sums and their differences all fit in
+ * 16-bits lanes. They only filter the first (w / W) * W samples. */
+
+static inline V vabsdiff(V a, V b)
+{
+    return vabs(vsub(a, b));
+}
+
+/* Differences around the j direction, as Yadif CHECK() */
+static inline V Score(const uint8_t *cur, int prefs, int mrefs, int j)
+{
+    return vadd(vadd(vabsdiff(vload8(&cur[mrefs - 1 + j]),
+                              vload8(&cur[prefs - 1 - j])),
+                     vabsdiff(vload8(&cur[mrefs + j]),
+                              vload8(&cur[prefs - j]))),
+                vabsdiff(vload8(&cur[mrefs + 1 + j]),
+                         vload8(&cur[prefs + 1 - j])));
+}
+
+/* Takes the j direction where it scores better than the current one.
+ * Returns where it did. */
+static inline V Check(const uint8_t *cur, int prefs, int mrefs, int j, V mask,
+                      V *score, V *pred)
+{
+    V s = Score(cur, prefs, mrefs, j);
+    V better = vand(mask, vgt(*score, s));
+    V p = vsra1(vadd(vload8(&cur[mrefs + j]), vload8(&cur[prefs - j])));
+
+    *score = vsel(better, s, *score);
+    *pred = vsel(better, p, *pred);
+    return better;
+}
+
+/* Largest difference allowed to the temporal prediction d */
+static inline V TemporalDiff(const uint8_t *prev, const uint8_t *prev2,
+                             const uint8_t *next, const uint8_t *next2,
+                             int prefs, int mrefs, V c, V e, V *t0)
+{
+    *t0 = vabsdiff(vload8(prev2), vload8(next2));
+    V t1 = vsra1(vadd(vabsdiff(vload8(&prev[mrefs]), c),
+                      vabsdiff(vload8(&prev[prefs]), e)));
+    V t2 = vsra1(vadd(vabsdiff(vload8(&next[mrefs]), c),
+                      vabsdiff(vload8(&next[prefs]), e)));
+    return vmax(vmax(vsra1(*t0), t1), t2);
+}
+
+static inline V SpatialDiff(const uint8_t *prev2, const uint8_t *next2,
+                            int prefs, int mrefs, V c, V d, V e, V diff)
+{
+    V b = vsub(vsra1(vadd(vload8(&prev2[2 * mrefs]),
+                          vload8(&next2[2 * mrefs]))), c);
+    V f = vsub(vsra1(vadd(vload8(&prev2[2 * prefs]),
+                          vload8(&next2[2 * prefs]))), e);
+    V de = vsub(d, e);
+    V dc = vsub(d, c);
+    V max = vmax(vmax(de, dc), vmin(b, f));
+    V min = vmin(vmin(de, dc), vmax(b, f));
+
+    return vmax(vmax(diff, min), vsub(vset(0), max));
+}
+
+static inline V Clip(V v, V d, V diff)
+{
+    return vmin(vmax(v, vsub(d, diff)), vadd(d, diff));
+}
+
+void SIMD(yadif_line)(uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                             uint8_t *next, int w, int prefs, int mrefs,
+                             int parity, int mode)
+{
+    const uint8_t *prev2 = parity ? prev : cur;
+    const uint8_t *next2 = parity ? cur : next;
+    const V one = vset(1);
+    const V all = vgt(one, vset(0));
+
+    for (int x = 0; x + (int)W <= w; x += W)
+    {
+        V c = vload8(&cur[x + mrefs]);
+        V e = vload8(&cur[x + prefs]);
+        V d = vsra1(vadd(vload8(&prev2[x]), vload8(&next2[x])));
+        V t0;
+        V diff = TemporalDiff(&prev[x], &prev2[x], &next[x], &next2[x],
+                              prefs, mrefs, c, e, &t0);
+
+        V pred = vsra1(vadd(c, e));
+        V score = vsub(Score(&cur[x], prefs, mrefs, 0), one);
+        V mask;
+
+        mask = Check(&cur[x], prefs, mrefs, -1, all, &score, &pred);
+        Check(&cur[x], prefs, mrefs, -2, mask, &score, &pred);
+        mask = Check(&cur[x], prefs, mrefs, 1, all, &score, &pred);
+        Check(&cur[x], prefs, mrefs, 2, mask, &score, &pred);
+
+        if (mode < 2)
+            diff = SpatialDiff(&prev2[x], &next2[x], prefs, mrefs, c, d, e,
+                               diff);
+
+        vstore8(&dst[x], Clip(pred, d, diff));
+    }
+}
+
+void SIMD(bwdif_line)(uint8_t *dst, const uint8_t *prev,
+                             const uint8_t *cur, const uint8_t *next, int w,
+                             int prefs, int mrefs, int parity)
+{
+    const uint8_t *prev2 = parity ? prev : cur;
+    const uint8_t *next2 = parity ? cur : next;
+
+    for (int x = 0; x + (int)W <= w; x += W)
+    {
+        V c = vload8(&cur[x + mrefs]);
+        V e = vload8(&cur[x + prefs]);
+        V t0 = vadd(vload8(&prev2[x]), vload8(&next2[x]));
+        V d = vsra1(t0);
+        V tdiff0;
+        V diff = TemporalDiff(&prev[x], &prev2[x], &next[x], &next2[x],
+                              prefs, mrefs, c, e, &tdiff0);
+
+        diff = SpatialDiff(&prev2[x], &next2[x], prefs, mrefs, c, d, e, diff);
+
+        V s2 = vadd(vadd(vload8(&prev2[x + 2 * mrefs]),
+                         vload8(&next2[x + 2 * mrefs])),
+                    vadd(vload8(&prev2[x + 2 * prefs]),
+                         vload8(&next2[x + 2 * prefs])));
+        V s4 = vadd(vadd(vload8(&prev2[x + 4 * mrefs]),
+                         vload8(&next2[x + 4 * mrefs])),
+                    vadd(vload8(&prev2[x + 4 * prefs]),
+                         vload8(&next2[x + 4 * prefs])));
+        V ce = vadd(c, e);
+        V ce3 = vadd(vload8(&cur[x + 3 * mrefs]), vload8(&cur[x + 3 * prefs]));
+
+        V pred = vsel(vgt(vabsdiff(c, e), tdiff0),
+                      vbwdif_hf(t0, s2, s4, ce, ce3), vbwdif_sp(ce, ce3));
+
+        vstore8(&dst[x], Clip(pred, d, diff));
+    }
+}
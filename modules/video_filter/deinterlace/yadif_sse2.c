@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * yadif_sse2.c: SSE2 Yadif and Bwdif line filters
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "algo_yadif.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+# pragma GCC target("sse2")
+# include <emmintrin.h>
+
+typedef __m128i V;
+#define W 8
+#define SIMD(name) vlcpriv_##name##_sse2
+
+static inline V vset(int v)        { return _mm_set1_epi16(v); }
+static inline V vadd(V a, V b)     { return _mm_add_epi16(a, b); }
+static inline V vsub(V a, V b)     { return _mm_sub_epi16(a, b); }
+static inline V vsra1(V a)         { return _mm_srai_epi16(a, 1); }
+static inline V vmin(V a, V b)     { return _mm_min_epi16(a, b); }
+static inline V vmax(V a, V b)     { return _mm_max_epi16(a, b); }
+static inline V vabs(V a)          { return vmax(a, vsub(_mm_setzero_si128(), a)); }
+static inline V vgt(V a, V b)      { return _mm_cmpgt_epi16(a, b); }
+static inline V vand(V a, V b)     { return _mm_and_si128(a, b); }
+static inline V vsel(V m, V a, V b)
+{
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+static inline V vload8(const uint8_t *p)
+{
+    return _mm_unpacklo_epi8(_mm_loadl_epi64((const V *)p),
+                             _mm_setzero_si128());
+}
+static inline void vstore8(uint8_t *p, V v)
+{
+    _mm_storel_epi64((V *)p, _mm_packus_epi16(v, v));
+}
+
+/* a * ka + b * kb for each pair of 16-bits lanes, in 32-bits */
+static inline void vmadd(V a, V b, int ka, int kb, __m128i *lo, __m128i *hi)
+{
+    const V k = _mm_set1_epi32((ka & 0xffff) | (kb << 16));
+    *lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), k);
+    *hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, b), k);
+}
+
+/* Same coefficients as bwdif.h */
+static inline V vbwdif_hf(V t0, V s2, V s4, V ce, V ce3)
+{
+    __m128i hlo, hhi, h4lo, h4hi, llo, lhi;
+
+    vmadd(t0, s2, 5570, -3801, &hlo, &hhi);
+    vmadd(s4, _mm_setzero_si128(), 1016, 0, &h4lo, &h4hi);
+    vmadd(ce, ce3, 4309, -213, &llo, &lhi);
+    hlo = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(hlo, h4lo), 2), llo);
+    hhi = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(hhi, h4hi), 2), lhi);
+    return _mm_packs_epi32(_mm_srai_epi32(hlo, 13), _mm_srai_epi32(hhi, 13));
+}
+
+static inline V vbwdif_sp(V ce, V ce3)
+{
+    __m128i lo, hi;
+
+    vmadd(ce, ce3, 5077, -981, &lo, &hi);
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 13), _mm_srai_epi32(hi, 13));
+}
+
+# include "yadif_simd.h"
+#endif
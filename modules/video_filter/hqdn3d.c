@@ -32,7 +32,9 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
+#include "../video_chroma/slices.h"
 
 
 #include "hqdn3d.h"
@@ -90,8 +92,13 @@ typedef struct
 {
     const vlc_chroma_description_t *chroma;
     int w[3], h[3];
+    int wmax;
 
     struct vf_priv_s cfg;
+    slice_pool_t *slices;
+    void (*vertical)(unsigned int *, const unsigned int *, int, const int *);
+    void (*temporal)(unsigned char *, unsigned short *,
+                     const unsigned int *, int, const int *);
     bool   b_recalc_coefs;
     vlc_mutex_t coefs_mutex;
     float  luma_spat, luma_temp, chroma_spat, chroma_temp;
@@ -137,12 +144,24 @@ static int Open(vlc_object_t *this)
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
+    sys->wmax = wmax;
+    /* Current and previous line for each slice */
+    cfg->Line = vlc_alloc(2 * SLICE_MAX_COUNT * wmax, sizeof(unsigned int));
     if (!cfg->Line) {
         free(sys);
         return VLC_ENOMEM;
     }
 
+    sys->slices = SlicePoolHold();
+    sys->vertical = NULL;
+    sys->temporal = NULL;
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2()) {
+        sys->vertical = vlcpriv_hqdn3d_vertical_avx2;
+        sys->temporal = vlcpriv_hqdn3d_temporal_avx2;
+    }
+#endif
+
     config_ChainParse(filter, FILTER_PREFIX, filter_options,
                       filter->p_cfg);
 
@@ -180,6 +199,7 @@ static void Close(vlc_object_t *this)
     var_DelCallback( filter, FILTER_PREFIX "chroma-temp", DenoiseCallback, sys );
 
     vlc_mutex_destroy( &sys->coefs_mutex );
+    SlicePoolRelease( sys->slices );
 
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
@@ -191,6 +211,98 @@ static void Close(vlc_object_t *this)
 /*****************************************************************************
  * Filter
  *****************************************************************************/
+
+/* The vertical filter is recursive: a stripe starts it this many lines above
+ * its first line, so that it has settled by the time it outputs a line. */
+#define STRIPE_OVERLAP 16
+
+typedef struct
+{
+    filter_sys_t *sys;
+    const picture_t *src;
+    picture_t *dst;
+    unsigned first[3]; /* first line of each plane in the slices */
+} filter_ctx_t;
+
+static void Vertical(const filter_sys_t *sys, unsigned int *LineAnt,
+                     const unsigned int *LineCur, int w, const int *coefs)
+{
+    int x = 0;
+    if (sys->vertical != NULL) {
+        sys->vertical(LineAnt, LineCur, w, coefs);
+        x = w & ~7;
+    }
+    deNoiseVertical(&LineAnt[x], &LineCur[x], w - x, coefs);
+}
+
+static void Temporal(const filter_sys_t *sys, uint8_t *dst,
+                     unsigned short *FrameAnt, const unsigned int *LineCur,
+                     int w, const int *coefs)
+{
+    int x = 0;
+    if (sys->temporal != NULL) {
+        sys->temporal(dst, FrameAnt, LineCur, w, coefs);
+        x = w & ~7;
+    }
+    deNoiseTemporal(&dst[x], &FrameAnt[x], &LineCur[x], w - x, coefs);
+}
+
+/* Filters lines [y0, y1) of a plane */
+static void FilterStripe(filter_sys_t *sys, const plane_t *src, plane_t *dst,
+                         int plane, unsigned index, int y0, int y1)
+{
+    struct vf_priv_s *cfg = &sys->cfg;
+    const int w = sys->w[plane];
+    const int *spat = cfg->Coefs[plane ? 2 : 0];
+    const int *temp = cfg->Coefs[plane ? 3 : 1];
+    unsigned int *LineAnt = &cfg->Line[2 * index * sys->wmax];
+    unsigned int *LineCur = LineAnt + sys->wmax;
+    unsigned short *FrameAnt = cfg->Frame[plane];
+    const bool spatial = spat[0] != 0;
+    /* Without spatial filter, the temporal one always runs, as in MPlayer */
+    const bool temporal = temp[0] != 0 || !spatial;
+    const int ystart = spatial ? __MAX(y0 - STRIPE_OVERLAP, 0) : y0;
+
+    for (int y = ystart; y < y1; y++) {
+        const uint8_t *in = &src->p_pixels[y * src->i_pitch];
+        uint8_t *out = &dst->p_pixels[y * dst->i_pitch];
+
+        if (spatial) {
+            /* The first line has no top neighbor */
+            deNoiseHorizontal(in, y == ystart ? LineAnt : LineCur, w, spat);
+            if (y > ystart)
+                Vertical(sys, LineAnt, LineCur, w, spat);
+            if (y < y0)
+                continue;
+        } else
+            deNoiseLoad(in, LineAnt, w);
+
+        if (temporal)
+            Temporal(sys, out, &FrameAnt[y * w], LineAnt, w, temp);
+        else
+            deNoiseStore(out, LineAnt, w);
+    }
+}
+
+/* The slices are cut from the planes put one after the other, so that the
+ * planes are filtered in parallel too. */
+static void FilterSlice(void *opaque, unsigned index, unsigned y,
+                        unsigned height)
+{
+    filter_ctx_t *ctx = opaque;
+    filter_sys_t *sys = ctx->sys;
+
+    for (int i = 0; i < 3; i++) {
+        const unsigned first = ctx->first[i];
+        const unsigned last = first + sys->h[i];
+        const unsigned y0 = __MAX(y, first), y1 = __MIN(y + height, last);
+
+        if (y0 < y1)
+            FilterStripe(sys, &ctx->src->p[i], &ctx->dst->p[i], i, index,
+                         y0 - first, y1 - first);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     picture_t *dst;
@@ -220,32 +332,29 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-
-    if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
-    {
-        picture_Release( src );
-        picture_Release( dst );
-        return NULL;
+    filter_ctx_t ctx = { .sys = sys, .src = src, .dst = dst };
+    unsigned lines = 0;
+
+    for (int i = 0; i < 3; i++) {
+        /* The previous frame starts as the first one */
+        if (unlikely(!cfg->Frame[i])) {
+            cfg->Frame[i] = vlc_alloc(sys->w[i] * sys->h[i],
+                                      sizeof(unsigned short));
+            if (unlikely(!cfg->Frame[i]))
+            {
+                picture_Release( src );
+                picture_Release( dst );
+                return NULL;
+            }
+            deNoiseInit(src->p[i].p_pixels, cfg->Frame[i],
+                        sys->w[i], sys->h[i], src->p[i].i_pitch);
+        }
+        ctx.first[i] = lines;
+        lines += sys->h[i];
     }
 
+    SlicePoolRun(sys->slices, lines, 1, FilterSlice, &ctx);
+
     return CopyInfoAndRelease(dst, src);
 }
 
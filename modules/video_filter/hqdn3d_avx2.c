@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * hqdn3d_avx2.c: AVX2 vertical and temporal passes of hqdn3d
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include "hqdn3d.h"
+
+#ifdef HAVE_AVX2_INTRINSICS
+# pragma GCC target("avx2")
+# include <immintrin.h>
+
+/* Same as LowPassMul(), with the coefficients fetched by a gather */
+static inline __m256i LowPassMul8(__m256i prev, __m256i cur, const int *coef)
+{
+    const __m256i d = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_sub_epi32(prev, cur),
+                         _mm256_set1_epi32(0x10007FF)), 12);
+
+    return _mm256_add_epi32(cur, _mm256_i32gather_epi32(coef, d, 4));
+}
+
+/* Keeps the low 16 bits of each lane, like the conversions in C */
+static inline __m128i Narrow16(__m256i v)
+{
+    v = _mm256_and_si256(v, _mm256_set1_epi32(0xFFFF));
+    /* Packing works on 128-bits lanes, put the two halves back in order */
+    v = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0xd8);
+    return _mm256_castsi256_si128(v);
+}
+
+void vlcpriv_hqdn3d_vertical_avx2(unsigned int *LineAnt,
+                                  const unsigned int *LineCur, int W,
+                                  const int *Vertical)
+{
+    for (int x = 0; x + 8 <= W; x += 8)
+    {
+        __m256i ant = _mm256_loadu_si256((const __m256i *)&LineAnt[x]);
+        __m256i cur = _mm256_loadu_si256((const __m256i *)&LineCur[x]);
+
+        _mm256_storeu_si256((__m256i *)&LineAnt[x],
+                            LowPassMul8(ant, cur, Vertical));
+    }
+}
+
+void vlcpriv_hqdn3d_temporal_avx2(unsigned char *FrameDest,
+                                  unsigned short *FrameAnt,
+                                  const unsigned int *LineCur, int W,
+                                  const int *Temporal)
+{
+    for (int x = 0; x + 8 <= W; x += 8)
+    {
+        __m256i ant = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128((const __m128i *)&FrameAnt[x]));
+        __m256i cur = _mm256_loadu_si256((const __m256i *)&LineCur[x]);
+        __m256i dst = LowPassMul8(_mm256_slli_epi32(ant, 8), cur, Temporal);
+
+        ant = _mm256_srli_epi32(
+            _mm256_add_epi32(dst, _mm256_set1_epi32(0x1000007F)), 8);
+        _mm_storeu_si128((__m128i *)&FrameAnt[x], Narrow16(ant));
+
+        dst = _mm256_srli_epi32(
+            _mm256_add_epi32(dst, _mm256_set1_epi32(0x10007FFF)), 16);
+        __m128i out = _mm_and_si128(Narrow16(dst), _mm_set1_epi16(0xFF));
+        _mm_storel_epi64((__m128i *)&FrameDest[x], _mm_packus_epi16(out, out));
+    }
+}
+#endif
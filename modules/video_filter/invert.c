@@ -41,6 +41,7 @@ static int  Create      ( vlc_object_t * );
 static void Destroy     ( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
+static void Invert( filter_t *, picture_t *, picture_t * );
 
 /*****************************************************************************
  * Module descriptor
@@ -77,6 +78,7 @@ static int Create( vlc_object_t *p_this )
         return VLC_EGENERIC;
 
     p_filter->pf_video_filter = Filter;
+    p_filter->pf_video_filter_inplace = Invert;
     return VLC_SUCCESS;
 }
 
@@ -100,7 +102,6 @@ static void Destroy( vlc_object_t *p_this )
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
-    int i_planes;
 
     if( !p_pic ) return NULL;
 
@@ -112,13 +113,28 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
+    Invert( p_filter, p_outpic, p_pic );
+
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
+
+/*****************************************************************************
+ * Invert: inverts the pixels of p_pic into p_outpic, which can be the same
+ *****************************************************************************/
+static void Invert( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+{
+    int i_planes;
+
+    VLC_UNUSED(p_filter);
+
     if( p_pic->format.i_chroma == VLC_CODEC_YUVA )
     {
         /* We don't want to invert the alpha plane */
         i_planes = p_pic->i_planes - 1;
-        memcpy(
-            p_outpic->p[A_PLANE].p_pixels, p_pic->p[A_PLANE].p_pixels,
-            p_pic->p[A_PLANE].i_pitch *  p_pic->p[A_PLANE].i_lines );
+        if( p_outpic->p[A_PLANE].p_pixels != p_pic->p[A_PLANE].p_pixels )
+            memcpy(
+                p_outpic->p[A_PLANE].p_pixels, p_pic->p[A_PLANE].p_pixels,
+                p_pic->p[A_PLANE].i_pitch *  p_pic->p[A_PLANE].i_lines );
     }
     else
     {
@@ -168,6 +184,4 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                      - p_outpic->p[i_index].i_visible_pitch;
         }
     }
-
-    return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -0,0 +1,153 @@
+/*****************************************************************************
+ * motion_proxy.h: block differences of pictures at a reduced resolution
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_MOTION_PROXY_H
+#define VLC_MOTION_PROXY_H 1
+
+/* Motion and scene change detection compare pictures on a proxy map of the
+ * sums of absolute differences of 8x8 bytes blocks, computed in a single
+ * pass over the two planes. The map is 64 times smaller than the picture,
+ * and the block sums are a low-pass filter of their own. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+#endif
+
+#define PROXY_SHIFT 3
+#define PROXY_BLOCK (1 << PROXY_SHIFT)
+
+/* Sums the absolute differences of a row of blocks of 8x8 bytes */
+typedef void (*proxy_sad_t)(uint32_t *sad, const uint8_t *a, ptrdiff_t a_pitch,
+                            const uint8_t *b, ptrdiff_t b_pitch,
+                            unsigned blocks);
+
+static inline void ProxySad_c(uint32_t *sad, const uint8_t *a,
+                              ptrdiff_t a_pitch, const uint8_t *b,
+                              ptrdiff_t b_pitch, unsigned blocks)
+{
+    for (unsigned i = 0; i < blocks; i++)
+    {
+        uint32_t sum = 0;
+
+        for (unsigned y = 0; y < PROXY_BLOCK; y++)
+            for (unsigned x = 0; x < PROXY_BLOCK; x++)
+                sum += abs(a[y * a_pitch + PROXY_BLOCK * i + x]
+                         - b[y * b_pitch + PROXY_BLOCK * i + x]);
+        sad[i] = sum;
+    }
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+/* PSADBW sums each half of a vector: two blocks per row load */
+__attribute__((__target__("sse2")))
+static inline void ProxySad_sse2(uint32_t *sad, const uint8_t *a,
+                                 ptrdiff_t a_pitch, const uint8_t *b,
+                                 ptrdiff_t b_pitch, unsigned blocks)
+{
+    unsigned i = 0;
+
+    for (; i + 2 <= blocks; i += 2)
+    {
+        __m128i sum = _mm_setzero_si128();
+
+        for (unsigned y = 0; y < PROXY_BLOCK; y++)
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(
+                _mm_loadu_si128((const __m128i *)&a[y * a_pitch]),
+                _mm_loadu_si128((const __m128i *)&b[y * b_pitch])));
+        sad[i] = _mm_cvtsi128_si32(sum);
+        sad[i + 1] = _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+        a += 2 * PROXY_BLOCK;
+        b += 2 * PROXY_BLOCK;
+    }
+    if (i < blocks)
+        ProxySad_c(&sad[i], a, a_pitch, b, b_pitch, blocks - i);
+}
+#endif
+
+#ifdef __ARM_NEON
+static inline void ProxySad_neon(uint32_t *sad, const uint8_t *a,
+                                 ptrdiff_t a_pitch, const uint8_t *b,
+                                 ptrdiff_t b_pitch, unsigned blocks)
+{
+    unsigned i = 0;
+
+    for (; i + 2 <= blocks; i += 2)
+    {
+        /* At most 8 x 2 x 255 in each 16-bits lane */
+        uint16x8_t sum = vdupq_n_u16(0);
+
+        for (unsigned y = 0; y < PROXY_BLOCK; y++)
+            sum = vpadalq_u8(sum, vabdq_u8(vld1q_u8(&a[y * a_pitch]),
+                                           vld1q_u8(&b[y * b_pitch])));
+
+        uint64x2_t halves = vpaddlq_u32(vpaddlq_u16(sum));
+        sad[i] = vgetq_lane_u64(halves, 0);
+        sad[i + 1] = vgetq_lane_u64(halves, 1);
+        a += 2 * PROXY_BLOCK;
+        b += 2 * PROXY_BLOCK;
+    }
+    if (i < blocks)
+        ProxySad_c(&sad[i], a, a_pitch, b, b_pitch, blocks - i);
+}
+#endif
+
+static inline proxy_sad_t ProxySadSelect(void)
+{
+#ifdef HAVE_SSE2_INTRINSICS
+    if (vlc_CPU_SSE2())
+        return ProxySad_sse2;
+#endif
+#ifdef __ARM_NEON
+    if (vlc_CPU_ARM_NEON())
+        return ProxySad_neon;
+#endif
+    return ProxySad_c;
+}
+
+/**
+ * Computes the proxy map of two planes of the same size, of (width / 8) x
+ * (height / 8) sums, where width is in bytes. The remaining right columns
+ * and bottom lines are not compared.
+ */
+static inline void ProxySadPlane(proxy_sad_t sad_row, uint32_t *map,
+                                 const uint8_t *a, ptrdiff_t a_pitch,
+                                 const uint8_t *b, ptrdiff_t b_pitch,
+                                 unsigned width, unsigned height)
+{
+    const unsigned blocks = width >> PROXY_SHIFT;
+
+    for (unsigned y = 0; y + PROXY_BLOCK <= height; y += PROXY_BLOCK)
+    {
+        sad_row(map, &a[y * a_pitch], a_pitch, &b[y * b_pitch], b_pitch,
+                blocks);
+        map += blocks;
+    }
+}
+
+#endif
@@ -34,6 +34,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include "filter_picture.h"
+#include "motion_proxy.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -59,8 +60,7 @@ vlc_module_end ()
  * Local prototypes
  *****************************************************************************/
 static picture_t *Filter( filter_t *, picture_t * );
-static void GaussianConvolution( uint32_t *, uint32_t *, int, int, int );
-static int FindShapes( uint32_t *, uint32_t *, int, int, int,
+static int FindShapes( uint32_t *, int, int,
                        int *, int *, int *, int *, int *);
 static void Draw( filter_t *p_filter, uint8_t *p_pix, int i_pix_pitch, int i_pix_size );
 #define NUM_COLORS (5000)
@@ -69,8 +69,13 @@ typedef struct
 {
     bool is_yuv_planar;
     picture_t *p_old;
-    uint32_t *p_buf;
-    uint32_t *p_buf2;
+    proxy_sad_t sad;
+
+    /* Differences of the 8x8 blocks, then labels of the moving shapes */
+    unsigned i_map_width;
+    unsigned i_map_height;
+    uint32_t *p_map;
+    uint32_t *p_sad; /* sums of the 8x8 bytes blocks of packed pictures */
 
     /* */
     int i_colors;
@@ -106,7 +111,16 @@ static int Create( vlc_object_t *p_this )
                      (char*)&(p_fmt->i_chroma) );
             return VLC_EGENERIC;
     }
-    p_filter->pf_video_filter = Filter;
+
+    /* The shapes are found on a map of the blocks, with empty borders */
+    const unsigned i_map_width = p_fmt->i_width >> PROXY_SHIFT;
+    const unsigned i_map_height = p_fmt->i_height >> PROXY_SHIFT;
+    if( i_map_width < 3 || i_map_height < 3 )
+    {
+        msg_Err( p_filter, "Video too small (%ux%u)",
+                 p_fmt->i_width, p_fmt->i_height );
+        return VLC_EGENERIC;
+    }
 
     /* Allocate structure */
     p_filter->p_sys = p_sys = malloc( sizeof( filter_sys_t ) );
@@ -115,16 +129,24 @@ static int Create( vlc_object_t *p_this )
 
     p_sys->is_yuv_planar = is_yuv_planar;
     p_sys->p_old = NULL;
-    p_sys->p_buf  = calloc( p_fmt->i_width * p_fmt->i_height, sizeof(*p_sys->p_buf) );
-    p_sys->p_buf2 = calloc( p_fmt->i_width * p_fmt->i_height, sizeof(*p_sys->p_buf) );
-
-    if( !p_sys->p_buf || !p_sys->p_buf2 )
+    p_sys->sad = ProxySadSelect();
+    p_sys->i_map_width = i_map_width;
+    p_sys->i_map_height = i_map_height;
+    p_sys->p_map = calloc( i_map_width * i_map_height, sizeof(*p_sys->p_map) );
+    p_sys->p_sad = NULL;
+    if( !is_yuv_planar )
+        p_sys->p_sad = calloc( ( ( 2 * p_fmt->i_width ) >> PROXY_SHIFT )
+                               * i_map_height, sizeof(*p_sys->p_sad) );
+
+    if( !p_sys->p_map || ( !is_yuv_planar && !p_sys->p_sad ) )
     {
-        free( p_sys->p_buf2 );
-        free( p_sys->p_buf );
+        free( p_sys->p_sad );
+        free( p_sys->p_map );
+        free( p_sys );
         return VLC_ENOMEM;
     }
 
+    p_filter->pf_video_filter = Filter;
     return VLC_SUCCESS;
 }
 
@@ -136,8 +158,8 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    free( p_sys->p_buf2 );
-    free( p_sys->p_buf );
+    free( p_sys->p_sad );
+    free( p_sys->p_map );
     if( p_sys->p_old )
         picture_Release( p_sys->p_old );
     free( p_sys );
@@ -152,67 +174,20 @@ static void PreparePlanar( filter_t *p_filter, picture_t *p_inpic )
     filter_sys_t *p_sys = p_filter->p_sys;
     const video_format_t *p_fmt = &p_filter->fmt_in.video;
 
-    uint8_t *p_oldpix   = p_sys->p_old->p[Y_PLANE].p_pixels;
-    const int i_old_pitch = p_sys->p_old->p[Y_PLANE].i_pitch;
-
-    const uint8_t *p_inpix = p_inpic->p[Y_PLANE].p_pixels;
-    const int i_src_pitch = p_inpic->p[Y_PLANE].i_pitch;
-
     /**
-     * Substract Y planes
+     * Substract Y planes, block by block
      */
-    for( unsigned y = 0; y < p_fmt->i_height; y++ )
-    {
-        for( unsigned x = 0; x < p_fmt->i_width; x++ )
-            p_sys->p_buf2[y*p_fmt->i_width+x] = abs( p_inpix[y*i_src_pitch+x] - p_oldpix[y*i_old_pitch+x] );
-    }
+    const unsigned i_count = p_sys->i_map_width * p_sys->i_map_height;
 
-    int i_chroma_dx;
-    int i_chroma_dy;
-    switch( p_inpic->format.i_chroma )
-    {
-        case VLC_CODEC_I420:
-        case VLC_CODEC_J420:
-        case VLC_CODEC_YV12:
-            i_chroma_dx = 2;
-            i_chroma_dy = 2;
-            break;
-
-        case VLC_CODEC_I422:
-        case VLC_CODEC_J422:
-            i_chroma_dx = 2;
-            i_chroma_dy = 1;
-            break;
-
-        default:
-            msg_Warn( p_filter, "Not taking chroma into account" );
-            return;
-    }
+    ProxySadPlane( p_sys->sad, p_sys->p_map,
+                   p_inpic->p[Y_PLANE].p_pixels, p_inpic->p[Y_PLANE].i_pitch,
+                   p_sys->p_old->p[Y_PLANE].p_pixels,
+                   p_sys->p_old->p[Y_PLANE].i_pitch,
+                   p_fmt->i_width, p_fmt->i_height );
 
-    const uint8_t *p_inpix_u = p_inpic->p[U_PLANE].p_pixels;
-    const uint8_t *p_inpix_v = p_inpic->p[V_PLANE].p_pixels;
-    const int i_src_pitch_u = p_inpic->p[U_PLANE].i_pitch;
-    const int i_src_pitch_v = p_inpic->p[V_PLANE].i_pitch;
-
-    const uint8_t *p_oldpix_u = p_sys->p_old->p[U_PLANE].p_pixels;
-    const uint8_t *p_oldpix_v = p_sys->p_old->p[V_PLANE].p_pixels;
-    const int i_old_pitch_u = p_sys->p_old->p[U_PLANE].i_pitch;
-    const int i_old_pitch_v = p_sys->p_old->p[V_PLANE].i_pitch;
-
-    for( unsigned y = 0; y < p_fmt->i_height/i_chroma_dy; y++ )
-    {
-        for( unsigned x = 0; x < p_fmt->i_width/i_chroma_dx; x ++ )
-        {
-            const int d = abs( p_inpix_u[y*i_src_pitch_u+x] - p_oldpix_u[y*i_old_pitch_u+x] ) +
-                          abs( p_inpix_v[y*i_src_pitch_v+x] - p_oldpix_v[y*i_old_pitch_v+x] );
-
-            for( int j = 0; j < i_chroma_dy; j++ )
-            {
-                for( int i = 0; i < i_chroma_dx; i++ )
-                    p_sys->p_buf2[i_chroma_dy*p_fmt->i_width*j + i_chroma_dx*i] = d;
-            }
-        }
-    }
+    /* Mean difference of the pixels in each block */
+    for( unsigned i = 0; i < i_count; i++ )
+        p_sys->p_map[i] >>= 2 * PROXY_SHIFT;
 }
 
 static int PreparePacked( filter_t *p_filter, picture_t *p_inpic, int *pi_pix_offset )
@@ -230,25 +205,22 @@ static int PreparePacked( filter_t *p_filter, picture_t *p_inpic, int *pi_pix_of
     }
     *pi_pix_offset = i_y_offset;
 
-    /* Substract all planes at once */
-    uint8_t *p_oldpix   = p_sys->p_old->p[Y_PLANE].p_pixels;
-    const int i_old_pitch = p_sys->p_old->p[Y_PLANE].i_pitch;
+    /* Substract all planes at once: a block of 8 pixels is 16 bytes wide */
+    const unsigned i_blocks = ( 2 * p_fmt->i_width ) >> PROXY_SHIFT;
 
-    const uint8_t *p_inpix = p_inpic->p[Y_PLANE].p_pixels;
-    const int i_src_pitch = p_inpic->p[Y_PLANE].i_pitch;
+    ProxySadPlane( p_sys->sad, p_sys->p_sad,
+                   p_inpic->p[Y_PLANE].p_pixels, p_inpic->p[Y_PLANE].i_pitch,
+                   p_sys->p_old->p[Y_PLANE].p_pixels,
+                   p_sys->p_old->p[Y_PLANE].i_pitch,
+                   2 * p_fmt->i_width, p_fmt->i_height );
 
-    for( unsigned y = 0; y < p_fmt->i_height; y++ )
+    for( unsigned y = 0; y < p_sys->i_map_height; y++ )
     {
-        for( unsigned x = 0; x < p_fmt->i_width; x+=2 )
-        {
-            int d;
-            d = abs( p_inpix[y*i_src_pitch+2*x+i_u_offset] - p_oldpix[y*i_old_pitch+2*x+i_u_offset] ) +
-                abs( p_inpix[y*i_src_pitch+2*x+i_v_offset] - p_oldpix[y*i_old_pitch+2*x+i_v_offset] );
+        const uint32_t *p_sad = &p_sys->p_sad[y * i_blocks];
 
-            for( int i = 0; i < 2; i++ )
-                p_sys->p_buf2[y*p_fmt->i_width+x+i] =
-                    abs( p_inpix[y*i_src_pitch+2*(x+i)+i_y_offset] - p_oldpix[y*i_old_pitch+2*(x+i)+i_y_offset] ) + d;
-        }
+        for( unsigned x = 0; x < p_sys->i_map_width; x++ )
+            p_sys->p_map[y * p_sys->i_map_width + x] =
+                ( p_sad[2 * x] + p_sad[2 * x + 1] ) >> ( 2 * PROXY_SHIFT );
     }
     return VLC_SUCCESS;
 }
@@ -292,8 +264,8 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_inpic )
     /**
      * Get the areas where movement was detected
      */
-    const video_format_t *p_fmt = &p_filter->fmt_in.video;
-    p_sys->i_colors = FindShapes( p_sys->p_buf2, p_sys->p_buf, p_fmt->i_width, p_fmt->i_width, p_fmt->i_height,
+    p_sys->i_colors = FindShapes( p_sys->p_map, p_sys->i_map_width,
+                                  p_sys->i_map_height,
                                   p_sys->colors, p_sys->color_x_min, p_sys->color_x_max, p_sys->color_y_min, p_sys->color_y_max );
 
     /**
@@ -312,69 +284,11 @@ exit:
 }
 
 
-/*****************************************************************************
- * Gaussian Convolution
- *****************************************************************************
- *    Gaussian convolution ( sigma == 1.4 )
- *
- *    |  2  4  5  4  2  |   |  2  4  4  4  2 |
- *    |  4  9 12  9  4  |   |  4  8 12  8  4 |
- *    |  5 12 15 12  5  | ~ |  4 12 16 12  4 |
- *    |  4  9 12  9  4  |   |  4  8 12  8  4 |
- *    |  2  4  5  4  2  |   |  2  4  4  4  2 |
- *****************************************************************************/
-static void GaussianConvolution( uint32_t *p_inpix, uint32_t *p_smooth,
-                                 int i_src_pitch, int i_num_lines,
-                                 int i_src_visible )
-{
-    /* A bit overkill but ... simpler */
-    memset( p_smooth, 0, sizeof(*p_smooth) * i_src_pitch * i_num_lines );
-
-    for( int y = 2; y < i_num_lines - 2; y++ )
-    {
-        for( int x = 2; x < i_src_visible - 2; x++ )
-        {
-            p_smooth[y*i_src_visible+x] = (uint32_t)(
-              /* 2 rows up */
-                ( p_inpix[(y-2)*i_src_pitch+x-2] )
-              + ((p_inpix[(y-2)*i_src_pitch+x-1]
-              +   p_inpix[(y-2)*i_src_pitch+x]
-              +   p_inpix[(y-2)*i_src_pitch+x+1])<<1 )
-              + ( p_inpix[(y-2)*i_src_pitch+x+2] )
-              /* 1 row up */
-              + ((p_inpix[(y-1)*i_src_pitch+x-2]
-              + ( p_inpix[(y-1)*i_src_pitch+x-1]<<1 )
-              + ( p_inpix[(y-1)*i_src_pitch+x]*3 )
-              + ( p_inpix[(y-1)*i_src_pitch+x+1]<<1 )
-              +   p_inpix[(y-1)*i_src_pitch+x+2]
-              /* */
-              +   p_inpix[y*i_src_pitch+x-2]
-              + ( p_inpix[y*i_src_pitch+x-1]*3 )
-              + ( p_inpix[y*i_src_pitch+x]<<2 )
-              + ( p_inpix[y*i_src_pitch+x+1]*3 )
-              +   p_inpix[y*i_src_pitch+x+2]
-              /* 1 row down */
-              +   p_inpix[(y+1)*i_src_pitch+x-2]
-              + ( p_inpix[(y+1)*i_src_pitch+x-1]<<1 )
-              + ( p_inpix[(y+1)*i_src_pitch+x]*3 )
-              + ( p_inpix[(y+1)*i_src_pitch+x+1]<<1 )
-              +   p_inpix[(y+1)*i_src_pitch+x+2] )<<1 )
-              /* 2 rows down */
-              + ( p_inpix[(y+2)*i_src_pitch+x-2] )
-              + ((p_inpix[(y+2)*i_src_pitch+x-1]
-              +   p_inpix[(y+2)*i_src_pitch+x]
-              +   p_inpix[(y+2)*i_src_pitch+x+1])<<1 )
-              + ( p_inpix[(y+2)*i_src_pitch+x+2] )
-              ) >> 6 /* 115 */;
-        }
-    }
-}
-
 /*****************************************************************************
  *
  *****************************************************************************/
-static int FindShapes( uint32_t *p_diff, uint32_t *p_smooth,
-                       int i_pitch, int i_visible, int i_lines,
+static int FindShapes( uint32_t *p_smooth,
+                       int i_pitch, int i_lines,
                        int *colors,
                        int *color_x_min, int *color_x_max,
                        int *color_y_min, int *color_y_max )
@@ -382,12 +296,8 @@ static int FindShapes( uint32_t *p_diff, uint32_t *p_smooth,
     int last = 1;
 
     /**
-     * Apply some smoothing to remove noise
-     */
-    GaussianConvolution( p_diff, p_smooth, i_pitch, i_lines, i_visible );
-
-    /**
-     * Label the shapes and build the labels dependencies list
+     * Label the shapes in place and build the labels dependencies list.
+     * The block differences are already smooth enough.
      */
     for( int j = 0; j < i_pitch; j++ )
     {
@@ -523,13 +433,15 @@ static void Draw( filter_t *p_filter, uint8_t *p_pix, int i_pix_pitch, int i_pix
         if( p_sys->colors[i] != i )
             continue;
 
-        const int color_x_min = p_sys->color_x_min[i];
-        const int color_x_max = p_sys->color_x_max[i];
-        const int color_y_min = p_sys->color_y_min[i];
-        const int color_y_max = p_sys->color_y_max[i];
-
-        if( color_x_min == -1 )
+        if( p_sys->color_x_min[i] == -1 )
             continue;
+
+        /* Back from the map to the pixels of the blocks */
+        const int color_x_min = p_sys->color_x_min[i] << PROXY_SHIFT;
+        const int color_x_max = ( ( p_sys->color_x_max[i] + 1 ) << PROXY_SHIFT ) - 1;
+        const int color_y_min = p_sys->color_y_min[i] << PROXY_SHIFT;
+        const int color_y_max = ( ( p_sys->color_y_max[i] + 1 ) << PROXY_SHIFT ) - 1;
+
         if( ( color_y_max - color_y_min ) * ( color_x_max - color_x_min ) < 16 )
             continue;
 
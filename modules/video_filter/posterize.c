@@ -44,6 +44,7 @@ static int  Create      ( vlc_object_t * );
 static void Destroy     ( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
+static void Posterize( filter_t *, picture_t *, picture_t * );
 static void PlanarYUVPosterize( picture_t *, picture_t *, int);
 static void PackedYUVPosterize( picture_t *, picture_t *, int);
 static void RVPosterize( picture_t *, picture_t *, bool, int );
@@ -135,6 +136,7 @@ static int Create( vlc_object_t *p_this )
     var_AddCallback( p_filter, CFG_PREFIX "level", FilterCallback, p_sys );
 
     p_filter->pf_video_filter = Filter;
+    p_filter->pf_video_filter_inplace = Posterize;
 
     return VLC_SUCCESS;
 }
@@ -166,9 +168,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     if( !p_pic ) return NULL;
 
-    filter_sys_t *p_sys = p_filter->p_sys;
-    int level = atomic_load( &p_sys->i_level );
-
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
@@ -177,6 +176,20 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
+    Posterize( p_filter, p_outpic, p_pic );
+
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
+
+/*****************************************************************************
+ * Posterize: posterizes p_pic into p_outpic, which can be the same
+ *****************************************************************************/
+static void Posterize( filter_t *p_filter, picture_t *p_outpic,
+                       picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    int level = atomic_load( &p_sys->i_level );
+
     switch( p_pic->format.i_chroma )
     {
         case VLC_CODEC_RGB24:
@@ -194,8 +207,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         default:
             vlc_assert_unreachable();
     }
-
-    return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
 /*****************************************************************************
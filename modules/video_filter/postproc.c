@@ -41,6 +41,7 @@
 #include <vlc_cpu.h>
 
 #include "filter_picture.h"
+#include "../video_chroma/slices.h"
 
 #ifdef HAVE_POSTPROC_POSTPROCESS_H
 #   include <postproc/postprocess.h>
@@ -105,10 +106,25 @@ static const char *const ppsz_filter_options[] = {
 /*****************************************************************************
  * filter_sys_t : libpostproc video postprocessing descriptor
  *****************************************************************************/
+/* Stripes are cut on the macroblock grid, and filtered with this many lines
+ * of their neighbours above and below as context for the deblocking and
+ * deinterlacing filters. */
+#define STRIPE_ALIGN 16
+#define STRIPE_OVERLAP 16
+
+typedef struct
+{
+    pp_context *pp_context;
+    picture_t *scratch; /* the stripe with its overlaps */
+} filter_slice_t;
+
 typedef struct
 {
     /* Never changes after init */
     pp_context *pp_context;
+    slice_pool_t *slices;
+    unsigned i_slices;
+    filter_slice_t slice[SLICE_MAX_COUNT];
 
     /* Set to NULL if post processing is disabled */
     pp_mode *pp_mode;
@@ -118,6 +134,16 @@ typedef struct
 } filter_sys_t;
 
 
+static void FreeSlices( filter_sys_t *p_sys )
+{
+    for( unsigned i = 0; p_sys->i_slices > 1 && i < p_sys->i_slices; i++ )
+    {
+        picture_Release( p_sys->slice[i].scratch );
+        pp_free_context( p_sys->slice[i].pp_context );
+    }
+    SlicePoolRelease( p_sys->slices );
+}
+
 /*****************************************************************************
  * OpenPostproc: probe and open the postproc
  *****************************************************************************/
@@ -192,6 +218,38 @@ static int OpenPostproc( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    /* Each stripe has its own context, as it keeps the previous pictures
+     * for the temporal filters */
+    p_sys->slices = SlicePoolHold();
+    unsigned i_height;
+    p_sys->i_slices = SlicePoolSplit( p_sys->slices,
+                                      p_filter->fmt_in.video.i_height,
+                                      STRIPE_ALIGN, &i_height );
+    for( unsigned i = 0; p_sys->i_slices > 1 && i < p_sys->i_slices; i++ )
+    {
+        filter_slice_t *p_slice = &p_sys->slice[i];
+        video_format_t fmt = p_filter->fmt_in.video;
+
+        fmt.i_height = fmt.i_visible_height = i_height + 2 * STRIPE_OVERLAP;
+        fmt.i_x_offset = fmt.i_y_offset = 0;
+        fmt.i_visible_width = fmt.i_width;
+        p_slice->scratch = picture_NewFromFormat( &fmt );
+        p_slice->pp_context = pp_get_context( fmt.i_width, fmt.i_height,
+                                              i_flags );
+        if( !p_slice->scratch || !p_slice->pp_context )
+        {
+            /* Fall back to a single thread */
+            for( unsigned j = 0; j <= i; j++ )
+            {
+                if( p_sys->slice[j].scratch )
+                    picture_Release( p_sys->slice[j].scratch );
+                if( p_sys->slice[j].pp_context )
+                    pp_free_context( p_sys->slice[j].pp_context );
+            }
+            p_sys->i_slices = 1;
+        }
+    }
+
     config_ChainParse( p_filter, FILTER_PREFIX, ppsz_filter_options,
                        p_filter->p_cfg );
 
@@ -215,6 +273,7 @@ static int OpenPostproc( vlc_object_t *p_this )
         {
             msg_Err( p_filter, "Error while creating post processing mode." );
             free( val.psz_string );
+            FreeSlices( p_sys );
             pp_free_context( p_sys->pp_context );
             free( p_sys );
             return VLC_EGENERIC;
@@ -273,6 +332,7 @@ static void ClosePostproc( vlc_object_t *p_this )
 
     /* Destroy the resources */
     vlc_mutex_destroy( &p_sys->lock );
+    FreeSlices( p_sys );
     pp_free_context( p_sys->pp_context );
     pp_free_mode( p_sys->pp_mode );
     free( p_sys );
@@ -281,6 +341,65 @@ static void ClosePostproc( vlc_object_t *p_this )
 /*****************************************************************************
  * PostprocPict
  *****************************************************************************/
+typedef struct
+{
+    filter_t *p_filter;
+    const picture_t *p_pic;
+    picture_t *p_outpic;
+} postproc_ctx_t;
+
+/* Filters the stripe with its overlaps into the scratch picture, then
+ * copies the stripe itself to the output */
+static void PostprocSlice( void *opaque, unsigned index, unsigned y,
+                           unsigned height )
+{
+    const postproc_ctx_t *ctx = opaque;
+    filter_t *p_filter = ctx->p_filter;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription( p_filter->fmt_in.video.i_chroma );
+    picture_t *p_scratch = p_sys->slice[index].scratch;
+    const unsigned i_lines = p_filter->fmt_in.video.i_height;
+    const unsigned i_top = __MIN( y, STRIPE_OVERLAP );
+    const unsigned i_bottom = __MIN( i_lines - y - height, STRIPE_OVERLAP );
+    const uint8_t *src[3];
+    uint8_t *dst[3];
+    int i_src_stride[3], i_dst_stride[3];
+
+    for( int i_plane = 0; i_plane < 3; i_plane++ )
+    {
+        const plane_t *p_src = &ctx->p_pic->p[i_plane];
+        const unsigned den = dsc->p[i_plane].h.den;
+        const unsigned num = dsc->p[i_plane].h.num;
+
+        src[i_plane] = p_src->p_pixels
+                     + (y - i_top) * num / den * p_src->i_pitch;
+        dst[i_plane] = p_scratch->p[i_plane].p_pixels;
+        i_src_stride[i_plane] = p_src->i_pitch;
+        i_dst_stride[i_plane] = p_scratch->p[i_plane].i_pitch;
+    }
+
+    pp_postprocess( src, i_src_stride, dst, i_dst_stride,
+                    p_filter->fmt_in.video.i_width,
+                    i_top + height + i_bottom, NULL, 0,
+                    p_sys->pp_mode, p_sys->slice[index].pp_context, 0 );
+
+    for( int i_plane = 0; i_plane < 3; i_plane++ )
+    {
+        const plane_t *p_src = &p_scratch->p[i_plane];
+        plane_t *p_dst = &ctx->p_outpic->p[i_plane];
+        const unsigned den = dsc->p[i_plane].h.den;
+        const unsigned num = dsc->p[i_plane].h.num;
+        const unsigned i_first = i_top * num / den;
+        const unsigned i_end = (i_top + height) * num / den;
+
+        for( unsigned l = i_first; l < i_end; l++ )
+            memcpy( &p_dst->p_pixels[(y * num / den + l - i_first) * p_dst->i_pitch],
+                    &p_src->p_pixels[l * p_src->i_pitch],
+                    __MIN( p_src->i_visible_pitch, p_dst->i_visible_pitch ) );
+    }
+}
+
 static picture_t *PostprocPict( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -294,7 +413,14 @@ static picture_t *PostprocPict( filter_t *p_filter, picture_t *p_pic )
 
     /* Lock to prevent issues if pp_mode is changed */
     vlc_mutex_lock( &p_sys->lock );
-    if( p_sys->pp_mode != NULL )
+    if( p_sys->pp_mode != NULL && p_sys->i_slices > 1 )
+    {
+        postproc_ctx_t ctx = { p_filter, p_pic, p_outpic };
+
+        SlicePoolRun( p_sys->slices, p_filter->fmt_in.video.i_height,
+                      STRIPE_ALIGN, PostprocSlice, &ctx );
+    }
+    else if( p_sys->pp_mode != NULL )
     {
         const uint8_t *src[3];
         uint8_t *dst[3];
@@ -37,6 +37,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include "filter_picture.h"
+#include "motion_proxy.h"
 #include <vlc_image.h>
 #include <vlc_strings.h>
 #include <vlc_fs.h>
@@ -50,7 +51,9 @@ static void Destroy     ( vlc_object_t * );
 static picture_t *Filter( filter_t *, picture_t * );
 
 static void SnapshotRatio( filter_t *p_filter, picture_t *p_pic );
-static void SavePicture( filter_t *, picture_t * );
+static bool SceneChanged( filter_t *p_filter, picture_t *p_pic );
+static void Snapshot( filter_t *p_filter, picture_t *p_pic );
+static void *Thread( void * );
 
 /*****************************************************************************
  * Module descriptor
@@ -72,6 +75,12 @@ static void SavePicture( filter_t *, picture_t * );
 #define RATIO_LONGTEXT N_( "Ratio of images to record. "\
                            "3 means that one image out of three is recorded." )
 
+#define THRESHOLD_TEXT N_( "Scene change threshold" )
+#define THRESHOLD_LONGTEXT N_( "Record the images at the scene changes " \
+    "instead of using the ratio: when the mean difference of the luma " \
+    "samples with the previous image exceeds this value. " \
+    "0 disables the detection." )
+
 #define PREFIX_TEXT N_( "Filename prefix" )
 #define PREFIX_LONGTEXT N_( "Prefix of the output images filenames. Output " \
                             "filenames will have the \"prefixNUMBER.format\" "\
@@ -115,17 +124,25 @@ vlc_module_begin ()
     /* Snapshot method */
     add_integer_with_range( CFG_PREFIX "ratio", 50, 1, INT_MAX,
                             RATIO_TEXT, RATIO_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "threshold", 0, 0, 255,
+                            THRESHOLD_TEXT, THRESHOLD_LONGTEXT, false )
 
     set_callbacks( Create, Destroy )
 vlc_module_end ()
 
 static const char *const ppsz_vfilter_options[] = {
-    "format", "width", "height", "ratio", "prefix", "path", "replace", NULL
+    "format", "width", "height", "ratio", "threshold", "prefix", "path",
+    "replace", NULL
 };
 
+/* Snapshots waiting to be encoded, beyond which they are dropped */
+#define SCENE_QUEUE_MAX 4
+
 typedef struct scene_t {
     picture_t       *p_pic;
-    video_format_t  format;
+    int32_t         i_frame;
+    int32_t         i_width;
+    int32_t         i_height;
 } scene_t;
 
 /*****************************************************************************
@@ -134,7 +151,22 @@ typedef struct scene_t {
 typedef struct
 {
     image_handler_t *p_image;
-    scene_t scene;
+
+    /* The snapshots are encoded and written out of the video thread */
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    scene_t queue[SCENE_QUEUE_MAX];
+    unsigned i_queue_first;
+    unsigned i_queue_count;
+    bool b_quit;
+
+    /* Scene change detection */
+    int32_t i_threshold;
+    picture_t *p_prev;
+    proxy_sad_t sad;
+    uint32_t *p_map;
+    size_t i_map_size;
 
     char *psz_path;
     char *psz_prefix;
@@ -191,12 +223,26 @@ static int Create( vlc_object_t *p_this )
     p_sys->i_ratio = var_CreateGetInteger( p_this, CFG_PREFIX "ratio" );
     if( p_sys->i_ratio <= 0)
         p_sys->i_ratio = 1;
+    p_sys->i_threshold = var_CreateGetInteger( p_this, CFG_PREFIX "threshold" );
+    p_sys->sad = ProxySadSelect();
     p_sys->b_replace = var_CreateGetBool( p_this, CFG_PREFIX "replace" );
     p_sys->psz_prefix = var_CreateGetString( p_this, CFG_PREFIX "prefix" );
     p_sys->psz_path = var_GetNonEmptyString( p_this, CFG_PREFIX "path" );
     if( p_sys->psz_path == NULL )
         p_sys->psz_path = config_GetUserDir( VLC_PICTURES_DIR );
 
+    vlc_mutex_init( &p_sys->lock );
+    vlc_cond_init( &p_sys->wait );
+    if( vlc_clone( &p_sys->thread, Thread, p_filter, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        image_HandlerDelete( p_sys->p_image );
+        free( p_sys->psz_format );
+        free( p_sys->psz_prefix );
+        free( p_sys->psz_path );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     p_filter->pf_video_filter = Filter;
 
     return VLC_SUCCESS;
@@ -210,10 +256,18 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    /* The pending snapshots are still written */
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_quit = true;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
+    vlc_join( p_sys->thread, NULL );
+
     image_HandlerDelete( p_sys->p_image );
 
-    if( p_sys->scene.p_pic )
-        picture_Release( p_sys->scene.p_pic );
+    if( p_sys->p_prev )
+        picture_Release( p_sys->p_prev );
+    free( p_sys->p_map );
     free( p_sys->psz_format );
     free( p_sys->psz_prefix );
     free( p_sys->psz_path );
@@ -225,8 +279,18 @@ static void Destroy( vlc_object_t *p_this )
  *****************************************************************************/
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
-    /* TODO: think of some funky algorithm to detect scene changes. */
-    SnapshotRatio( p_filter, p_pic );
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+
+    if( !p_pic ) return NULL;
+
+    if( p_sys->i_threshold > 0 )
+    {
+        p_sys->i_frames++;
+        if( SceneChanged( p_filter, p_pic ) )
+            Snapshot( p_filter, p_pic );
+    }
+    else
+        SnapshotRatio( p_filter, p_pic );
     return p_pic;
 }
 
@@ -234,8 +298,6 @@ static void SnapshotRatio( filter_t *p_filter, picture_t *p_pic )
 {
     filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
 
-    if( !p_pic ) return;
-
     if( p_sys->i_frames % p_sys->i_ratio != 0 )
     {
         p_sys->i_frames++;
@@ -243,8 +305,61 @@ static void SnapshotRatio( filter_t *p_filter, picture_t *p_pic )
     }
     p_sys->i_frames++;
 
-    if( p_sys->scene.p_pic )
-        picture_Release( p_sys->scene.p_pic );
+    Snapshot( p_filter, p_pic );
+}
+
+/*****************************************************************************
+ * SceneChanged: compare the luma with the previous picture
+ *****************************************************************************
+ * The mean of the absolute differences is computed on the 8x8 blocks proxy,
+ * so that the detection costs a small fraction of the decoding. The packed
+ * formats are compared with their chroma samples.
+ *****************************************************************************/
+static bool SceneChanged( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    const plane_t *p_plane = &p_pic->p[0];
+    const unsigned i_blocks = ( p_plane->i_visible_pitch >> PROXY_SHIFT )
+                            * ( p_plane->i_visible_lines >> PROXY_SHIFT );
+    bool b_changed = true; /* the first picture starts a scene */
+
+    if( p_sys->p_prev != NULL && i_blocks > 0 )
+    {
+        if( p_sys->i_map_size < i_blocks )
+        {
+            free( p_sys->p_map );
+            p_sys->p_map = malloc( i_blocks * sizeof(*p_sys->p_map) );
+            p_sys->i_map_size = p_sys->p_map != NULL ? i_blocks : 0;
+            if( p_sys->p_map == NULL )
+                goto out;
+        }
+
+        const plane_t *p_prev = &p_sys->p_prev->p[0];
+        ProxySadPlane( p_sys->sad, p_sys->p_map,
+                       p_plane->p_pixels, p_plane->i_pitch,
+                       p_prev->p_pixels, p_prev->i_pitch,
+                       p_plane->i_visible_pitch, p_plane->i_visible_lines );
+
+        uint64_t i_sum = 0;
+        for( unsigned i = 0; i < i_blocks; i++ )
+            i_sum += p_sys->p_map[i];
+        b_changed = i_sum > (uint64_t)p_sys->i_threshold * i_blocks
+                            * PROXY_BLOCK * PROXY_BLOCK;
+    }
+
+out:
+    if( p_sys->p_prev )
+        picture_Release( p_sys->p_prev );
+    p_sys->p_prev = picture_Hold( p_pic );
+    return b_changed;
+}
+
+/*****************************************************************************
+ * Snapshot: queue a copy of the picture for the worker thread
+ *****************************************************************************/
+static void Snapshot( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
 
     if( (p_sys->i_width <= 0) && (p_sys->i_height > 0) )
     {
@@ -260,20 +375,41 @@ static void SnapshotRatio( filter_t *p_filter, picture_t *p_pic )
         p_sys->i_height = p_pic->format.i_height;
     }
 
-    p_sys->scene.p_pic = picture_NewFromFormat( &p_pic->format );
-    if( p_sys->scene.p_pic )
+    vlc_mutex_lock( &p_sys->lock );
+    bool b_full = p_sys->i_queue_count == SCENE_QUEUE_MAX;
+    vlc_mutex_unlock( &p_sys->lock );
+    if( b_full )
     {
-        picture_Copy( p_sys->scene.p_pic, p_pic );
-        SavePicture( p_filter, p_sys->scene.p_pic );
+        msg_Warn( p_filter, "image encoding too slow, dropping snapshot %d",
+                  p_sys->i_frames );
+        return;
     }
+
+    /* The picture would be held for too long by the encoding */
+    picture_t *p_copy = picture_NewFromFormat( &p_pic->format );
+    if( !p_copy )
+        return;
+    picture_Copy( p_copy, p_pic );
+
+    vlc_mutex_lock( &p_sys->lock );
+    scene_t *p_scene = &p_sys->queue[( p_sys->i_queue_first
+                                       + p_sys->i_queue_count++ )
+                                     % SCENE_QUEUE_MAX];
+    p_scene->p_pic = p_copy;
+    p_scene->i_frame = p_sys->i_frames;
+    p_scene->i_width = p_sys->i_width;
+    p_scene->i_height = p_sys->i_height;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
 }
 
 /*****************************************************************************
  * Save Picture to disk
  *****************************************************************************/
-static void SavePicture( filter_t *p_filter, picture_t *p_pic )
+static void SavePicture( filter_t *p_filter, const scene_t *p_scene )
 {
     filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+    picture_t *p_pic = p_scene->p_pic;
     video_format_t fmt_in, fmt_out;
     char *psz_filename = NULL;
     char *psz_temp = NULL;
@@ -284,8 +420,8 @@ static void SavePicture( filter_t *p_filter, picture_t *p_pic )
     /* Save snapshot psz_format to a memory zone */
     fmt_in = p_pic->format;
     fmt_out.i_sar_num = fmt_out.i_sar_den = 1;
-    fmt_out.i_width = p_sys->i_width;
-    fmt_out.i_height = p_sys->i_height;
+    fmt_out.i_width = p_scene->i_width;
+    fmt_out.i_height = p_scene->i_height;
 
     /*
      * Save the snapshot to a temporary file and
@@ -298,7 +434,7 @@ static void SavePicture( filter_t *p_filter, picture_t *p_pic )
     else
         i_ret = asprintf( &psz_filename, "%s" DIR_SEP "%s%05d.%s",
                           p_sys->psz_path, p_sys->psz_prefix,
-                          p_sys->i_frames, p_sys->psz_format );
+                          p_scene->i_frame, p_sys->psz_format );
 
     if( i_ret == -1 )
     {
@@ -339,3 +475,31 @@ error:
     free( psz_temp );
     free( psz_filename );
 }
+
+static void *Thread( void *data )
+{
+    filter_t *p_filter = data;
+    filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock );
+    for( ;; )
+    {
+        while( p_sys->i_queue_count == 0 && !p_sys->b_quit )
+            vlc_cond_wait( &p_sys->wait, &p_sys->lock );
+        if( p_sys->i_queue_count == 0 )
+            break;
+
+        scene_t scene = p_sys->queue[p_sys->i_queue_first];
+        vlc_mutex_unlock( &p_sys->lock );
+
+        SavePicture( p_filter, &scene );
+        picture_Release( scene.p_pic );
+
+        /* Keep the slot until written, so that the queue bounds the memory */
+        vlc_mutex_lock( &p_sys->lock );
+        p_sys->i_queue_first = ( p_sys->i_queue_first + 1 ) % SCENE_QUEUE_MAX;
+        p_sys->i_queue_count--;
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
+}
@@ -48,6 +48,7 @@ static void RVSepia( picture_t *, picture_t *, int );
 static void PlanarI420Sepia( picture_t *, picture_t *, int);
 static void PackedYUVSepia( picture_t *, picture_t *, int);
 static picture_t *Filter( filter_t *, picture_t * );
+static void Sepia( filter_t *, picture_t *, picture_t * );
 static const char *const ppsz_filter_options[] = {
     "intensity", NULL
 };
@@ -144,6 +145,7 @@ static int Create( vlc_object_t *p_this )
     var_AddCallback( p_filter, CFG_PREFIX "intensity", FilterCallback, NULL );
 
     p_filter->pf_video_filter = Filter;
+    p_filter->pf_video_filter_inplace = Sepia;
 
     return VLC_SUCCESS;
 }
@@ -175,9 +177,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     if( !p_pic ) return NULL;
 
-    filter_sys_t *p_sys = p_filter->p_sys;
-    int intensity = atomic_load( &p_sys->i_intensity );
-
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
@@ -186,11 +185,22 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
-    p_sys->pf_sepia( p_pic, p_outpic, intensity );
+    Sepia( p_filter, p_outpic, p_pic );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
+/*****************************************************************************
+ * Sepia: applies sepia from p_pic to p_outpic, which can be the same
+ *****************************************************************************/
+static void Sepia( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    int intensity = atomic_load( &p_sys->i_intensity );
+
+    p_sys->pf_sepia( p_pic, p_outpic, intensity );
+}
+
 #if defined(CAN_COMPILE_SSE2)
 /*****************************************************************************
  * Sepia8ySSE2
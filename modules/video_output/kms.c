@@ -31,6 +31,7 @@
 # include "config.h"
 #endif
 
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 
@@ -44,6 +45,18 @@
 #include <vlc_picture_pool.h>
 #include <vlc_fs.h>
 
+#ifdef HAVE_KMS_VAAPI
+# include "../hw/vaapi/vlc_vaapi.h"
+#endif
+#ifdef VLC_VAAPI_HAS_EXPORT
+/* VAAPI surfaces are exported as DMA-BUFs and scanned out directly */
+# define KMS_DMABUF 1
+#endif
+
+#ifndef DRM_FORMAT_MOD_INVALID
+# define DRM_FORMAT_MOD_INVALID ((1ULL << 56) - 1)
+#endif
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -67,6 +80,16 @@
 
 typedef enum { drvSuccess, drvTryNext, drvFail } deviceRval;
 
+#ifdef KMS_DMABUF
+/* Framebuffer wrapping an imported picture */
+struct scanout_fb {
+    picture_t       *picture;
+    uint32_t        fb;
+    uint32_t        handles[4];
+    unsigned        handle_count;
+};
+#endif
+
 struct vout_display_sys_t {
 /*
  * buffer information
@@ -89,6 +112,16 @@ struct vout_display_sys_t {
     uint32_t        drm_fourcc;
     vlc_fourcc_t    vlc_fourcc;
 
+#ifdef KMS_DMABUF
+/*
+ * zero-copy: the pictures are imported rather than copied to dumb buffers
+ */
+    bool                 dmabuf;
+    struct scanout_fb    prepared;
+    struct scanout_fb    displayed;
+    vout_display_place_t place;
+#endif
+
 /*
  * modeset information
  */
@@ -288,6 +321,11 @@ static deviceRval SetupDevice(vout_display_t *vd, drmModeRes const *res,
         return ret;
     }
 
+#ifdef KMS_DMABUF
+    if (sys->dmabuf)
+        return drvSuccess;
+#endif
+
     for (c = 0; c < MAXHWBUF; c++) {
         ret = CreateFB(vd, c);
         if (ret != drvSuccess) {
@@ -464,6 +502,12 @@ static bool ChromaNegotiation(vout_display_t *vd)
         }
     }
 
+#ifdef KMS_DMABUF
+    /* Imported pictures cannot be converted */
+    if (sys->dmabuf)
+        return false;
+#endif
+
     YUVFormat = vlc_fourcc_IsYUV(sys->vlc_fourcc);
     for (c = i = 0; c < ARRAY_SIZE(fourccmatching); c++) {
         if (fourccmatching[c].isYUV == YUVFormat
@@ -587,6 +631,11 @@ static int OpenDisplay(vout_display_t *vd)
     if (!found_connector)
         goto err_out;
 
+#ifdef KMS_DMABUF
+    if (sys->dmabuf)
+        return VLC_SUCCESS;
+#endif
+
     picture_sys_t *psys = calloc(1, sizeof(*psys));
     if (psys == NULL)
         goto err_out;
@@ -621,6 +670,137 @@ err_out:
 }
 
 
+#ifdef KMS_DMABUF
+static void PlacePicture(vout_display_t *vd, const vout_display_cfg_t *cfg)
+{
+    vout_display_sys_t *sys = vd->sys;
+    vout_display_cfg_t place_cfg = *cfg;
+
+    /* The plane covers the whole mode, whatever the window says */
+    place_cfg.display.width = sys->width;
+    place_cfg.display.height = sys->height;
+    vout_display_PlacePicture(&sys->place, &vd->source, &place_cfg);
+}
+
+static void ReleaseScanout(vout_display_sys_t *sys, struct scanout_fb *sfb)
+{
+    if (sfb->picture == NULL)
+        return;
+
+    drmModeRmFB(sys->drm_fd, sfb->fb);
+    for (unsigned i = 0; i < sfb->handle_count; i++) {
+        struct drm_gem_close close_req = { .handle = sfb->handles[i] };
+        drmIoctl(sys->drm_fd, DRM_IOCTL_GEM_CLOSE, &close_req);
+    }
+    picture_Release(sfb->picture);
+    sfb->picture = NULL;
+    sfb->handle_count = 0;
+}
+
+static int ImportPicture(vout_display_t *vd, struct scanout_fb *sfb,
+                         picture_t *pic)
+{
+    vout_display_sys_t *sys = vd->sys;
+    VADRMPRIMESurfaceDescriptor desc;
+    uint32_t handles[4] = { 0 }, pitches[4] = { 0 }, offsets[4] = { 0 };
+    uint64_t modifiers[4] = { 0 };
+    uint32_t flags = 0;
+
+    if (vlc_vaapi_ExportSurfaceHandle(VLC_OBJECT(vd),
+                                      vlc_vaapi_PicGetDisplay(pic),
+                                      vlc_vaapi_PicGetSurface(pic),
+                                      &desc))
+        return VLC_EGENERIC;
+
+    sfb->handle_count = 0;
+    for (uint32_t i = 0; i < desc.num_objects; i++) {
+        if (drmPrimeFDToHandle(sys->drm_fd, desc.objects[i].fd,
+                               &sfb->handles[i])) {
+            msg_Err(vd, "Cannot import DMA-BUF: %s", vlc_strerror_c(errno));
+            goto error;
+        }
+        sfb->handle_count++;
+    }
+
+    /* Composed layers: all the planes are in the first layer */
+    const uint32_t format = desc.layers[0].drm_format;
+    for (uint32_t i = 0; i < desc.layers[0].num_planes; i++) {
+        const uint32_t obj = desc.layers[0].object_index[i];
+
+        handles[i] = sfb->handles[obj];
+        pitches[i] = desc.layers[0].pitch[i];
+        offsets[i] = desc.layers[0].offset[i];
+        modifiers[i] = desc.objects[obj].drm_format_modifier;
+        if (modifiers[i] != DRM_FORMAT_MOD_INVALID)
+            flags = DRM_MODE_FB_MODIFIERS;
+    }
+
+    if (drmModeAddFB2WithModifiers(sys->drm_fd, desc.width, desc.height,
+                                   format, handles, pitches, offsets,
+                                   flags ? modifiers : NULL, &sfb->fb,
+                                   flags)) {
+        msg_Err(vd, "Cannot create frame buffer for DMA-BUF (%.4s): %s",
+                (const char *)&format, vlc_strerror_c(errno));
+        goto error;
+    }
+    vlc_vaapi_CloseSurfaceHandle(&desc);
+
+    sfb->picture = picture_Hold(pic);
+    return VLC_SUCCESS;
+
+error:
+    for (unsigned i = 0; i < sfb->handle_count; i++) {
+        struct drm_gem_close close_req = { .handle = sfb->handles[i] };
+        drmIoctl(sys->drm_fd, DRM_IOCTL_GEM_CLOSE, &close_req);
+    }
+    sfb->handle_count = 0;
+    vlc_vaapi_CloseSurfaceHandle(&desc);
+    return VLC_EGENERIC;
+}
+
+static void PrepareDmabuf(vout_display_t *vd, picture_t *pic)
+{
+    vout_display_sys_t *sys = vd->sys;
+
+    ReleaseScanout(sys, &sys->prepared);
+
+    /* The same buffer would give the same GEM handles: keep the current
+     * framebuffer rather than importing it again */
+    if (pic == sys->displayed.picture)
+        return;
+
+    ImportPicture(vd, &sys->prepared, pic);
+}
+
+static void DisplayDmabuf(vout_display_t *vd)
+{
+    vout_display_sys_t *sys = vd->sys;
+    const video_format_t *src = &vd->source;
+
+    if (sys->prepared.picture == NULL)
+        return;
+
+    if (drmModeSetPlane(sys->drm_fd, sys->plane_id, sys->crtc,
+                        sys->prepared.fb, 0,
+                        sys->place.x, sys->place.y,
+                        sys->place.width, sys->place.height,
+                        src->i_x_offset << 16, src->i_y_offset << 16,
+                        src->i_visible_width << 16,
+                        src->i_visible_height << 16)) {
+        msg_Err(vd, "Cannot do set plane for plane id %u, fb %x",
+                sys->plane_id, sys->prepared.fb);
+        ReleaseScanout(sys, &sys->prepared);
+        return;
+    }
+
+    /* The previous framebuffer is no longer scanned out */
+    ReleaseScanout(sys, &sys->displayed);
+    sys->displayed = sys->prepared;
+    sys->prepared.picture = NULL;
+    sys->prepared.handle_count = 0;
+}
+#endif
+
 static int Control(vout_display_t *vd, int query, va_list args)
 {
     (void) vd; (void) args;
@@ -631,6 +811,10 @@ static int Control(vout_display_t *vd, int query, va_list args)
         case VOUT_DISPLAY_CHANGE_ZOOM:
         case VOUT_DISPLAY_CHANGE_SOURCE_ASPECT:
         case VOUT_DISPLAY_CHANGE_SOURCE_CROP:
+#ifdef KMS_DMABUF
+            if (vd->sys->dmabuf)
+                PlacePicture(vd, va_arg(args, const vout_display_cfg_t *));
+#endif
             return VLC_SUCCESS;
     }
     return VLC_EGENERIC;
@@ -642,6 +826,12 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
 {
     VLC_UNUSED(subpic); VLC_UNUSED(date);
     vout_display_sys_t *sys = vd->sys;
+#ifdef KMS_DMABUF
+    if (sys->dmabuf) {
+        PrepareDmabuf(vd, pic);
+        return;
+    }
+#endif
     picture_Copy( sys->picture, pic );
 }
 
@@ -652,6 +842,13 @@ static void Display(vout_display_t *vd, picture_t *picture)
     vout_display_sys_t *sys = vd->sys;
     int i;
 
+#ifdef KMS_DMABUF
+    if (sys->dmabuf) {
+        DisplayDmabuf(vd);
+        return;
+    }
+#endif
+
     if (drmModeSetPlane(sys->drm_fd, sys->plane_id, sys->crtc,
                          sys->fb[sys->front_buf], 0,
                          0, 0, sys->width, sys->height,
@@ -680,6 +877,20 @@ static void Close(vout_display_t *vd)
     if (sys->picture)
         picture_Release(sys->picture);
 
+#ifdef KMS_DMABUF
+    if (sys->dmabuf && sys->drm_fd) {
+        /* Stop scanning out the pictures before releasing them */
+        drmModeSetPlane(sys->drm_fd, sys->plane_id, sys->crtc, 0, 0,
+                        0, 0, 0, 0, 0, 0, 0, 0);
+        ReleaseScanout(sys, &sys->prepared);
+        ReleaseScanout(sys, &sys->displayed);
+        drmSetClientCap(sys->drm_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 0);
+        drmDropMaster(sys->drm_fd);
+        vlc_close(sys->drm_fd);
+        sys->drm_fd = 0;
+    }
+#endif
+
     if (sys->drm_fd)
         drmDropMaster(sys->drm_fd);
 }
@@ -742,6 +953,35 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
         chroma = NULL;
     }
 
+#ifdef KMS_DMABUF
+    /* Decoded surfaces go straight to a plane, unless a chroma is forced */
+    if (!sys->forced_drm_fourcc && sys->vlc_fourcc == fmtp->i_chroma
+     && context != NULL
+     && vlc_video_context_GetType(context) == VLC_VIDEO_CONTEXT_VAAPI
+     && vlc_vaapi_IsChromaOpaque(fmtp->i_chroma)) {
+        sys->dmabuf = true;
+        sys->vlc_fourcc = fmtp->i_chroma == VLC_CODEC_VAAPI_420_10BPP ?
+                          VLC_CODEC_P010 : VLC_CODEC_NV12;
+
+        if (OpenDisplay(vd) == VLC_SUCCESS) {
+            msg_Dbg(vd, "Scanning out VAAPI surfaces directly");
+            PlacePicture(vd, cfg);
+
+            vd->prepare = Prepare;
+            vd->display = Display;
+            vd->control = Control;
+            vd->close = Close;
+            return VLC_SUCCESS;
+        }
+
+        msg_Dbg(vd, "Cannot scan out VAAPI surfaces, copying them");
+        sys->dmabuf = false;
+        sys->vlc_fourcc = fmtp->i_chroma;
+        sys->drm_fourcc = 0;
+        sys->crtc = 0;
+    }
+#endif
+
     if (OpenDisplay(vd) != VLC_SUCCESS) {
         Close(vd);
         return VLC_EGENERIC;
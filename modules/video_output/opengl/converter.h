@@ -33,6 +33,14 @@ struct pl_context;
 struct pl_shader;
 struct pl_shader_res;
 
+/* Deinterlacing algorithms of the fragment shader */
+enum opengl_deinterlace
+{
+    OPENGL_DEINTERLACE_OFF,
+    OPENGL_DEINTERLACE_YADIF,
+    OPENGL_DEINTERLACE_BWDIF,
+};
+
 /*
  * Structure that is filled by "glhw converter" module probe function
  * The implementation should initialize every members of the struct that are
@@ -59,6 +67,15 @@ struct opengl_tex_converter_t
      * has no default precision qualifier for floating point types. */
     const char *glsl_precision_header;
 
+    /* Deinterlacing algorithm, set by the caller. It is reset to
+     * OPENGL_DEINTERLACE_OFF by opengl_fragment_shader_init() if the pictures
+     * can't be deinterlaced. Otherwise, the previous picture textures must be
+     * bound after the current ones. */
+    enum opengl_deinterlace deinterlace;
+    /* Parity of the lines to keep in the current picture, or -1 if it is
+     * progressive, set by the caller before drawing */
+    int field_parity;
+
     /* Fragment shader, must be set from the module open function. It will be
      * deleted by the caller. */
     GLuint fshader;
@@ -68,6 +85,9 @@ struct opengl_tex_converter_t
     struct {
         GLint Texture[PICTURE_PLANE_MAX];
         GLint TexSize[PICTURE_PLANE_MAX]; /* for GL_TEXTURE_RECTANGLE */
+        GLint PrevTexture[PICTURE_PLANE_MAX]; /* for deinterlacing */
+        GLint TexelSize[PICTURE_PLANE_MAX]; /* for deinterlacing */
+        GLint FieldParity; /* for deinterlacing */
         GLint ConvMatrix;
         GLint FillColor;
         GLint *pl_vars; /* for pl_sh_res */
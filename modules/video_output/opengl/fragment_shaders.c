@@ -230,6 +230,26 @@ tc_base_fetch_locations(opengl_tex_converter_t *tc, GLuint program)
         }
     }
 
+    if (tc->deinterlace != OPENGL_DEINTERLACE_OFF)
+    {
+        for (unsigned int i = 0; i < interop->tex_count; ++i)
+        {
+            char name[sizeof("PrevTextureX")];
+            snprintf(name, sizeof(name), "PrevTexture%1u", i);
+            tc->uloc.PrevTexture[i] = tc->vt->GetUniformLocation(program, name);
+            if (tc->uloc.PrevTexture[i] == -1)
+                return VLC_EGENERIC;
+            snprintf(name, sizeof(name), "TexelSize%1u", i);
+            tc->uloc.TexelSize[i] = tc->vt->GetUniformLocation(program, name);
+            if (tc->uloc.TexelSize[i] == -1)
+                return VLC_EGENERIC;
+        }
+        tc->uloc.FieldParity = tc->vt->GetUniformLocation(program,
+                                                          "FieldParity");
+        if (tc->uloc.FieldParity == -1)
+            return VLC_EGENERIC;
+    }
+
     tc->uloc.FillColor = tc->vt->GetUniformLocation(program, "FillColor");
     if (tc->uloc.FillColor == -1)
         return VLC_EGENERIC;
@@ -262,6 +282,17 @@ tc_base_prepare_shader(const opengl_tex_converter_t *tc,
 
     tc->vt->Uniform4f(tc->uloc.FillColor, 1.0f, 1.0f, 1.0f, alpha);
 
+    if (tc->deinterlace != OPENGL_DEINTERLACE_OFF)
+    {
+        for (unsigned i = 0; i < interop->tex_count; ++i)
+        {
+            tc->vt->Uniform1i(tc->uloc.PrevTexture[i], interop->tex_count + i);
+            tc->vt->Uniform2f(tc->uloc.TexelSize[i], 1.f / tex_width[i],
+                              1.f / tex_height[i]);
+        }
+        tc->vt->Uniform1f(tc->uloc.FieldParity, tc->field_parity);
+    }
+
     if (interop->tex_target == GL_TEXTURE_RECTANGLE)
     {
         for (unsigned i = 0; i < interop->tex_count; ++i)
@@ -368,6 +399,114 @@ xyz12_shader_init(opengl_tex_converter_t *tc)
     return fragment_shader;
 }
 
+/* Deinterlacing, as the yadif and bwdif video filters, with a single output
+ * picture per input picture. The next picture is not known when the current
+ * one is drawn, so the temporal checks only use the previous and current
+ * pictures.
+ *
+ * The missing lines of the current picture are interpolated from:
+ *  - cur:  the current picture, its kept lines are above and below,
+ *  - prev: the previous picture, whose missing field precedes the current
+ *          picture one. */
+static const char deint_common[] =
+    "uniform float FieldParity;\n"
+    /* Maximum difference with the temporal prediction */
+    "vec4 TemporalDiff(sampler2D prev, sampler2D cur, vec2 c, vec2 dy,\n"
+    "                  vec4 above, vec4 below) {\n"
+    " vec4 diff0 = abs(texture2D(prev, c) - texture2D(cur, c));\n"
+    " vec4 diff1 = (abs(texture2D(prev, c - dy) - above) +\n"
+    "               abs(texture2D(prev, c + dy) - below)) * 0.5;\n"
+    " return max(diff0 * 0.5, diff1);\n"
+    "}\n"
+    /* Spatial check of the temporal prediction d, b and f are the temporal
+     * predictions two lines above and below */
+    "vec4 SpatialDiff(vec4 diff, vec4 d, vec4 above, vec4 below,\n"
+    "                 vec4 b, vec4 f) {\n"
+    " vec4 hi = max(max(d - below, d - above), min(b - above, f - below));\n"
+    " vec4 lo = min(min(d - below, d - above), max(b - above, f - below));\n"
+    " return max(max(diff, lo), -hi);\n"
+    "}\n";
+
+static const char deint_yadif[] =
+    /* Difference of the pixels around the j direction */
+    "vec4 YadifScore(sampler2D cur, vec2 c, vec2 dx, vec2 dy, float j) {\n"
+    " vec2 top = c - dy + j * dx;\n"
+    " vec2 bot = c + dy - j * dx;\n"
+    " return abs(texture2D(cur, top - dx) - texture2D(cur, bot - dx)) +\n"
+    "        abs(texture2D(cur, top) - texture2D(cur, bot)) +\n"
+    "        abs(texture2D(cur, top + dx) - texture2D(cur, bot + dx));\n"
+    "}\n"
+    /* Takes the j direction where it is better, returns where it was */
+    "vec4 YadifCheck(sampler2D cur, vec2 c, vec2 dx, vec2 dy, float j,\n"
+    "                vec4 mask, inout vec4 score, inout vec4 pred) {\n"
+    " vec4 s = YadifScore(cur, c, dx, dy, j);\n"
+    " vec4 better = mask * vec4(lessThan(s, score));\n"
+    " vec4 p = (texture2D(cur, c - dy + j * dx) + texture2D(cur, c + dy - j * dx)) * 0.5;\n"
+    " score = mix(score, s, better);\n"
+    " pred = mix(pred, p, better);\n"
+    " return better;\n"
+    "}\n"
+    "vec4 Interpolate(sampler2D prev, sampler2D cur, vec2 c, vec2 texel) {\n"
+    " vec2 dx = vec2(texel.x, 0.0);\n"
+    " vec2 dy = vec2(0.0, texel.y);\n"
+    " vec4 above = texture2D(cur, c - dy);\n"
+    " vec4 below = texture2D(cur, c + dy);\n"
+    " vec4 d = (texture2D(prev, c) + texture2D(cur, c)) * 0.5;\n"
+    " vec4 diff = TemporalDiff(prev, cur, c, dy, above, below);\n"
+    " vec4 score = YadifScore(cur, c, dx, dy, 0.0) - vec4(1.0 / 255.0);\n"
+    " vec4 pred = (above + below) * 0.5;\n"
+    /* The farthest directions are only checked after the nearest ones */
+    " vec4 better = YadifCheck(cur, c, dx, dy, -1.0, vec4(1.0), score, pred);\n"
+    " YadifCheck(cur, c, dx, dy, -2.0, better, score, pred);\n"
+    " better = YadifCheck(cur, c, dx, dy, 1.0, vec4(1.0), score, pred);\n"
+    " YadifCheck(cur, c, dx, dy, 2.0, better, score, pred);\n"
+    " vec4 b = (texture2D(prev, c - 2.0 * dy) + texture2D(cur, c - 2.0 * dy)) * 0.5;\n"
+    " vec4 f = (texture2D(prev, c + 2.0 * dy) + texture2D(cur, c + 2.0 * dy)) * 0.5;\n"
+    " diff = SpatialDiff(diff, d, above, below, b, f);\n"
+    " return clamp(pred, d - diff, d + diff);\n"
+    "}\n";
+
+static const char deint_bwdif[] =
+    "vec4 Interpolate(sampler2D prev, sampler2D cur, vec2 c, vec2 texel) {\n"
+    " vec2 dy = vec2(0.0, texel.y);\n"
+    " vec4 above = texture2D(cur, c - dy);\n"
+    " vec4 below = texture2D(cur, c + dy);\n"
+    " vec4 above3 = texture2D(cur, c - 3.0 * dy);\n"
+    " vec4 below3 = texture2D(cur, c + 3.0 * dy);\n"
+    " vec4 t0 = texture2D(prev, c) + texture2D(cur, c);\n"
+    " vec4 t2 = texture2D(prev, c - 2.0 * dy) + texture2D(cur, c - 2.0 * dy);\n"
+    " vec4 b2 = texture2D(prev, c + 2.0 * dy) + texture2D(cur, c + 2.0 * dy);\n"
+    " vec4 t4 = texture2D(prev, c - 4.0 * dy) + texture2D(cur, c - 4.0 * dy);\n"
+    " vec4 b4 = texture2D(prev, c + 4.0 * dy) + texture2D(cur, c + 4.0 * dy);\n"
+    " vec4 d = t0 * 0.5;\n"
+    " vec4 diff = TemporalDiff(prev, cur, c, dy, above, below);\n"
+    " diff = SpatialDiff(diff, d, above, below, t2 * 0.5, b2 * 0.5);\n"
+    /* Blends the spatial and temporal high frequencies where the lines
+     * around the pixel differ more than the temporal prediction */
+    " vec4 hf = ((5570.0 * t0 - 3801.0 * (t2 + b2) + 1016.0 * (t4 + b4)) * 0.25\n"
+    "            + 4309.0 * (above + below) - 213.0 * (above3 + below3))\n"
+    "           / 8192.0;\n"
+    " vec4 sp = (5077.0 * (above + below) - 981.0 * (above3 + below3)) / 8192.0;\n"
+    " vec4 tdiff0 = abs(texture2D(prev, c) - texture2D(cur, c));\n"
+    " vec4 pred = mix(sp, hf, vec4(greaterThan(abs(above - below), tdiff0)));\n"
+    " return clamp(clamp(pred, d - diff, d + diff), 0.0, 1.0);\n"
+    "}\n";
+
+/* Samples the deinterlaced picture: the two lines around the sampled
+ * position are fetched, one of them interpolated, and blended together. */
+static const char deint_sample[] =
+    "vec4 Deinterlace(sampler2D prev, sampler2D cur, vec2 coord, vec2 texel) {\n"
+    " if (FieldParity < 0.0)\n"
+    "  return texture2D(cur, coord);\n"
+    " float y = coord.y / texel.y - 0.5;\n"
+    " float line = floor(y);\n"
+    " vec2 c0 = vec2(coord.x, (line + 0.5) * texel.y);\n"
+    " vec2 c1 = c0 + vec2(0.0, texel.y);\n"
+    " if (abs(mod(line, 2.0) - FieldParity) < 0.5)\n"
+    "  return mix(texture2D(cur, c0), Interpolate(prev, cur, c1, texel), fract(y));\n"
+    " return mix(Interpolate(prev, cur, c0, texel), texture2D(cur, c1), fract(y));\n"
+    "}\n";
+
 static int
 opengl_init_swizzle(const struct vlc_gl_interop *interop,
                     const char *swizzle_per_tex[],
@@ -441,6 +580,17 @@ opengl_fragment_shader_init(opengl_tex_converter_t *tc, GLenum tex_target,
     if (desc == NULL)
         return 0;
 
+    /* Only planar software pictures can be deinterlaced: two fields are
+     * packed in the lines of the textures and the previous picture is kept */
+    if (tc->deinterlace != OPENGL_DEINTERLACE_OFF
+     && (!is_yuv || desc->plane_count < 2 || tex_target != GL_TEXTURE_2D
+      || interop->module != NULL))
+    {
+        msg_Warn(tc->gl, "cannot deinterlace %4.4s pictures",
+                 (const char *)&chroma);
+        tc->deinterlace = OPENGL_DEINTERLACE_OFF;
+    }
+
     if (chroma == VLC_CODEC_XYZ12)
         return xyz12_shader_init(tc);
 
@@ -580,6 +730,18 @@ opengl_fragment_shader_init(opengl_tex_converter_t *tc, GLenum tex_target,
             ADDF("uniform vec2 TexSize%u;\n", i);
     }
 
+    if (tc->deinterlace != OPENGL_DEINTERLACE_OFF)
+    {
+        for (unsigned i = 0; i < interop->tex_count; ++i)
+            ADDF("uniform %s PrevTexture%u;\n"
+                 "uniform vec2 TexelSize%u;\n", sampler, i, i);
+
+        ADD(deint_common);
+        ADD(tc->deinterlace == OPENGL_DEINTERLACE_BWDIF ? deint_bwdif
+                                                        : deint_yadif);
+        ADD(deint_sample);
+    }
+
     if (is_yuv)
         ADD("uniform mat4 ConvMatrix;\n");
 
@@ -603,7 +765,12 @@ opengl_fragment_shader_init(opengl_tex_converter_t *tc, GLenum tex_target,
             const char *swizzle = swizzle_per_tex[i];
             assert(swizzle);
             size_t swizzle_count = strlen(swizzle);
-            ADDF(" texel = %s(Texture%u, %s%u);\n", lookup, i, coord_name, i);
+            if (tc->deinterlace != OPENGL_DEINTERLACE_OFF)
+                ADDF(" texel = Deinterlace(PrevTexture%u, Texture%u, "
+                     "TexCoord%u, TexelSize%u);\n", i, i, i, i);
+            else
+                ADDF(" texel = %s(Texture%u, %s%u);\n", lookup, i,
+                     coord_name, i);
             for (unsigned j = 0; j < swizzle_count; ++j)
             {
                 ADDF(" pixel[%u] = texel.%c;\n", color_idx, swizzle[j]);
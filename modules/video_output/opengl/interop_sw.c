@@ -40,7 +40,27 @@
 # define GL_DYNAMIC_DRAW 0x88E8
 #endif
 
+#ifndef GL_MAP_WRITE_BIT
+# define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+# define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+# define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+# define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+# define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_WAIT_FAILED
+# define GL_WAIT_FAILED 0x911D
+#endif
+
 #define PBO_DISPLAY_COUNT 2 /* Double buffering */
+#define PBO_RING_COUNT 3 /* Persistent buffers in flight */
 typedef struct
 {
     PFNGLDELETEBUFFERSPROC DeleteBuffers;
@@ -57,6 +77,17 @@ struct priv
         picture_t *display_pics[PBO_DISPLAY_COUNT];
         size_t display_idx;
     } pbo;
+    /* Persistently mapped buffers (GL_ARB_buffer_storage): the pictures are
+     * copied straight into the mapping, and a fence tells when the GPU is
+     * done with a buffer, instead of letting glBufferSubData() synchronize. */
+    struct {
+        GLuint buffers[PBO_RING_COUNT][PICTURE_PLANE_MAX];
+        void *maps[PBO_RING_COUNT][PICTURE_PLANE_MAX];
+        size_t bytes[PICTURE_PLANE_MAX];
+        GLsync fences[PBO_RING_COUNT];
+        unsigned planes;
+        size_t idx;
+    } ring;
 };
 
 static void
@@ -200,6 +231,122 @@ tc_pbo_update(const struct vlc_gl_interop *interop, GLuint *textures,
     return VLC_SUCCESS;
 }
 
+static void
+ring_free(const struct vlc_gl_interop *interop)
+{
+    struct priv *priv = interop->priv;
+
+    for (size_t i = 0; i < PBO_RING_COUNT; ++i)
+    {
+        if (priv->ring.fences[i] != NULL)
+            interop->vt->DeleteSync(priv->ring.fences[i]);
+        if (priv->ring.buffers[i][0] != 0)
+            interop->vt->DeleteBuffers(priv->ring.planes,
+                                       priv->ring.buffers[i]);
+    }
+    priv->ring.planes = 0;
+}
+
+static int
+ring_alloc(const struct vlc_gl_interop *interop)
+{
+    struct priv *priv = interop->priv;
+    picture_t *pic = picture_NewFromFormat(&interop->fmt);
+    if (pic == NULL)
+        return VLC_EGENERIC;
+
+    /* Same layout as the pictures allocated for this format */
+    priv->ring.planes = pic->i_planes;
+    for (int i = 0; i < pic->i_planes; ++i)
+        priv->ring.bytes[i] = pic->p[i].i_pitch * pic->p[i].i_lines;
+    picture_Release(pic);
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT
+                           | GL_MAP_COHERENT_BIT;
+    interop->vt->GetError();
+
+    for (size_t i = 0; i < PBO_RING_COUNT; ++i)
+    {
+        interop->vt->GenBuffers(priv->ring.planes, priv->ring.buffers[i]);
+        for (unsigned j = 0; j < priv->ring.planes; ++j)
+        {
+            interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER,
+                                    priv->ring.buffers[i][j]);
+            interop->vt->BufferStorage(GL_PIXEL_UNPACK_BUFFER,
+                                       priv->ring.bytes[j], NULL, flags);
+            priv->ring.maps[i][j] =
+                interop->vt->MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                            priv->ring.bytes[j], flags);
+            if (priv->ring.maps[i][j] == NULL
+             || interop->vt->GetError() != GL_NO_ERROR)
+                goto error;
+        }
+    }
+
+    /* turn off pbo */
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return VLC_SUCCESS;
+
+error:
+    msg_Err(interop->gl, "could not map persistent PBO buffers");
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    ring_free(interop);
+    return VLC_EGENERIC;
+}
+
+static int
+tc_ring_update(const struct vlc_gl_interop *interop, GLuint *textures,
+               const GLsizei *tex_width, const GLsizei *tex_height,
+               picture_t *pic, const size_t *plane_offset)
+{
+    (void) plane_offset; assert(plane_offset == NULL);
+    struct priv *priv = interop->priv;
+    const size_t idx = priv->ring.idx;
+    priv->ring.idx = (priv->ring.idx + 1) % PBO_RING_COUNT;
+
+    /* Wait for the GPU to be done with the oldest buffer, which is normally
+     * the case, as it was used PBO_RING_COUNT frames ago */
+    GLsync fence = priv->ring.fences[idx];
+    if (fence != NULL)
+    {
+        GLenum ret = interop->vt->ClientWaitSync(fence,
+                                                 GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                 UINT64_MAX);
+        interop->vt->DeleteSync(fence);
+        priv->ring.fences[idx] = NULL;
+        if (ret == GL_WAIT_FAILED)
+            return VLC_EGENERIC;
+    }
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        size_t size = pic->p[i].i_lines * pic->p[i].i_pitch;
+        if (size > priv->ring.bytes[i])
+            size = priv->ring.bytes[i];
+        memcpy(priv->ring.maps[idx][i], pic->p[i].p_pixels, size);
+
+        interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER,
+                                priv->ring.buffers[idx][i]);
+
+        interop->vt->ActiveTexture(GL_TEXTURE0 + i);
+        interop->vt->BindTexture(interop->tex_target, textures[i]);
+
+        interop->vt->PixelStorei(GL_UNPACK_ROW_LENGTH, pic->p[i].i_pitch
+            * tex_width[i] / (pic->p[i].i_visible_pitch ? pic->p[i].i_visible_pitch : 1));
+
+        interop->vt->TexSubImage2D(interop->tex_target, 0, 0, 0, tex_width[i], tex_height[i],
+                                   interop->texs[i].format, interop->texs[i].type, NULL);
+        interop->vt->PixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    /* turn off pbo */
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    priv->ring.fences[idx] =
+        interop->vt->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    return VLC_SUCCESS;
+}
+
 static int
 tc_common_allocate_textures(const struct vlc_gl_interop *interop, GLuint *textures,
                             const GLsizei *tex_width, const GLsizei *tex_height)
@@ -375,9 +522,25 @@ opengl_interop_generic_init(struct vlc_gl_interop *interop, bool allow_dr)
             (vlc_gl_StrHasToken(interop->glexts, "GL_ARB_pixel_buffer_object") ||
              vlc_gl_StrHasToken(interop->glexts, "GL_EXT_pixel_buffer_object"));
 
+        const bool has_storage = has_pbo && !interop->is_gles
+            && (strverscmp((const char *)ogl_version, "4.4") >= 0 ||
+                vlc_gl_StrHasToken(interop->glexts, "GL_ARB_buffer_storage"));
+
         const bool supports_pbo = has_pbo && interop->vt->BufferData
             && interop->vt->BufferSubData;
-        if (supports_pbo && pbo_pics_alloc(interop) == VLC_SUCCESS)
+        const bool supports_ring = has_storage && interop->vt->BufferStorage
+            && interop->vt->MapBufferRange && interop->vt->FenceSync
+            && interop->vt->ClientWaitSync && interop->vt->DeleteSync;
+        if (supports_ring && ring_alloc(interop) == VLC_SUCCESS)
+        {
+            static const struct vlc_gl_interop_ops ring_ops = {
+                .allocate_textures = tc_common_allocate_textures,
+                .update_textures = tc_ring_update,
+            };
+            interop->ops = &ring_ops;
+            msg_Dbg(interop->gl, "persistent PBO support enabled");
+        }
+        else if (supports_pbo && pbo_pics_alloc(interop) == VLC_SUCCESS)
         {
             static const struct vlc_gl_interop_ops pbo_ops = {
                 .allocate_textures = tc_common_allocate_textures,
@@ -397,6 +560,8 @@ opengl_interop_generic_deinit(struct vlc_gl_interop *interop)
     struct priv *priv = interop->priv;
     for (size_t i = 0; i < PBO_DISPLAY_COUNT && priv->pbo.display_pics[i]; ++i)
         picture_Release(priv->pbo.display_pics[i]);
+    if (priv->ring.planes > 0)
+        ring_free(interop);
     free(priv->texture_temp_buf);
     free(priv);
 }
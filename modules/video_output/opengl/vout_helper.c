@@ -128,6 +128,14 @@ struct vout_display_opengl_t {
 
     GLuint     texture[PICTURE_PLANE_MAX];
 
+    /* Previous picture, for deinterlacing */
+    struct {
+        GLuint     texture[PICTURE_PLANE_MAX];
+        bool       valid;
+        const picture_t *source; /* current picture, to detect redisplays */
+        vlc_tick_t date;
+    } prev;
+
     int         region_count;
     gl_region_t *region;
 
@@ -542,6 +550,9 @@ opengl_init_program(vout_display_opengl_t *vgl, vlc_video_context *context,
     tc->gl = vgl->gl;
     tc->vt = &vgl->vt;
     tc->b_dump_shaders = b_dump_shaders;
+    tc->deinterlace = subpics ? OPENGL_DEINTERLACE_OFF
+                              : var_InheritInteger(vgl->gl, "gl-deinterlace");
+    tc->field_parity = -1;
 #if defined(USE_OPENGL_ES2)
     interop->is_gles = true;
     tc->glsl_version = 100;
@@ -905,6 +916,18 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
         }
     }
 
+    if (vgl->prgm->tc->deinterlace != OPENGL_DEINTERLACE_OFF)
+    {
+        assert(!interop->handle_texs_gen);
+        ret = GenTextures(vgl->prgm->tc->interop, vgl->tex_width, vgl->tex_height,
+                          vgl->prev.texture);
+        if (ret != VLC_SUCCESS)
+        {
+            vout_display_opengl_Delete(vgl);
+            return NULL;
+        }
+    }
+
     /* */
     vgl->vt.Disable(GL_BLEND);
     vgl->vt.Disable(GL_DEPTH_TEST);
@@ -958,6 +981,8 @@ void vout_display_opengl_Delete(vout_display_opengl_t *vgl)
     const struct vlc_gl_interop *interop = vgl->prgm->tc->interop;
     const size_t main_tex_count = interop->tex_count;
     const bool main_del_texs = !interop->handle_texs_gen;
+    const bool prev_del_texs =
+        vgl->prgm->tc->deinterlace != OPENGL_DEINTERLACE_OFF;
 
     opengl_deinit_program(vgl, vgl->prgm);
     opengl_deinit_program(vgl, vgl->sub_prgm);
@@ -973,6 +998,8 @@ void vout_display_opengl_Delete(vout_display_opengl_t *vgl)
 
     if (main_del_texs)
         vgl->vt.DeleteTextures(main_tex_count, vgl->texture);
+    if (prev_del_texs)
+        vgl->vt.DeleteTextures(main_tex_count, vgl->prev.texture);
 
     for (int i = 0; i < vgl->region_count; i++)
     {
@@ -1066,6 +1093,25 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
     opengl_tex_converter_t *tc = vgl->prgm->tc;
     const struct vlc_gl_interop *interop = tc->interop;
 
+    if (tc->deinterlace != OPENGL_DEINTERLACE_OFF)
+    {
+        /* Keep the textures of the previous picture, unless the same picture
+         * is displayed again */
+        if (picture != vgl->prev.source || picture->date != vgl->prev.date)
+        {
+            GLuint textures[PICTURE_PLANE_MAX];
+
+            memcpy(textures, vgl->prev.texture, sizeof (textures));
+            memcpy(vgl->prev.texture, vgl->texture, sizeof (textures));
+            memcpy(vgl->texture, textures, sizeof (textures));
+            vgl->prev.valid = vgl->prev.source != NULL;
+            vgl->prev.source = picture;
+            vgl->prev.date = picture->date;
+        }
+        tc->field_parity = picture->b_progressive ? -1
+                         : !picture->b_top_field_first;
+    }
+
     /* Update the texture */
     int ret = interop->ops->update_textures(interop, vgl->texture, vgl->tex_width, vgl->tex_height,
                                             picture, NULL);
@@ -1498,6 +1544,13 @@ static void DrawWithShaders(vout_display_opengl_t *vgl, struct prgm *prgm)
         vgl->vt.ActiveTexture(GL_TEXTURE0+j);
         vgl->vt.BindTexture(interop->tex_target, vgl->texture[j]);
 
+        if (tc->deinterlace != OPENGL_DEINTERLACE_OFF) {
+            /* Without previous picture, the current one is used instead */
+            vgl->vt.ActiveTexture(GL_TEXTURE0 + interop->tex_count + j);
+            vgl->vt.BindTexture(interop->tex_target, vgl->prev.valid ?
+                                vgl->prev.texture[j] : vgl->texture[j]);
+        }
+
         vgl->vt.BindBuffer(GL_ARRAY_BUFFER, vgl->texture_buffer_object[j]);
 
         assert(prgm->aloc.MultiTexCoord[j] != -1);
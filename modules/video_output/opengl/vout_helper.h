@@ -80,8 +80,24 @@
 #define GLINTEROP_LONGTEXT N_( \
     "Force a \"glinterop\" module.")
 
+#define GLDEINTERLACE_TEXT N_("Deinterlacing")
+#define GLDEINTERLACE_LONGTEXT N_( \
+    "Deinterlace the software decoded pictures while drawing them, instead " \
+    "of with the deinterlace video filter. The next picture is not known " \
+    "at that time, so only the previous one is used.")
+
+static const int gl_deinterlace_values[] = {
+    OPENGL_DEINTERLACE_OFF, OPENGL_DEINTERLACE_YADIF, OPENGL_DEINTERLACE_BWDIF,
+};
+static const char *const gl_deinterlace_text[] = {
+    N_("Off"), "Yadif", "Bwdif",
+};
+
 #define add_glopts() \
     add_module("glinterop", "glinterop", NULL, GLINTEROP_TEXT, GLINTEROP_LONGTEXT) \
+    add_integer("gl-deinterlace", OPENGL_DEINTERLACE_OFF, \
+                GLDEINTERLACE_TEXT, GLDEINTERLACE_LONGTEXT, false) \
+        change_integer_list(gl_deinterlace_values, gl_deinterlace_text) \
     add_glopts_placebo ()
 
 typedef struct vout_display_opengl_t vout_display_opengl_t;
@@ -35,12 +35,27 @@
 #include <vlc_vout_display.h>
 #include <vlc_video_splitter.h>
 
+enum {
+    VIDSPLIT_PREPARE,
+    VIDSPLIT_DISPLAY,
+    VIDSPLIT_QUIT,
+};
+
 struct vlc_vidsplit_part {
     vout_window_t *window;
     vout_display_t *display;
     vlc_sem_t lock;
     unsigned width;
     unsigned height;
+
+    /* Each display is driven by its own thread, so that the outputs are
+     * prepared, then shown, all at the same time. */
+    vlc_thread_t thread;
+    vlc_sem_t work; /**< a request is pending */
+    vlc_sem_t done; /**< the request was handled */
+    int request;
+    picture_t *picture;
+    vlc_tick_t date;
 };
 
 struct vout_display_sys_t {
@@ -51,6 +66,52 @@ struct vout_display_sys_t {
     struct vlc_vidsplit_part *parts;
 };
 
+static void *vlc_vidsplit_Thread(void *data)
+{
+    struct vlc_vidsplit_part *part = data;
+
+    for (;;) {
+        vlc_sem_wait(&part->work);
+
+        switch (part->request) {
+            case VIDSPLIT_PREPARE:
+                if (part->picture == NULL)
+                    break;
+                if (part->display == NULL) { /* the window was closed */
+                    picture_Release(part->picture);
+                    part->picture = NULL;
+                    break;
+                }
+                part->picture = vout_display_Prepare(part->display,
+                                                     part->picture, NULL,
+                                                     part->date);
+                break;
+            case VIDSPLIT_DISPLAY:
+                if (part->picture != NULL)
+                    vout_display_Display(part->display, part->picture);
+                part->picture = NULL;
+                break;
+            case VIDSPLIT_QUIT:
+                return NULL;
+        }
+        vlc_sem_post(&part->done);
+    }
+}
+
+/* Runs a request on all the outputs at once, and waits for all of them */
+static void vlc_vidsplit_Request(vout_display_sys_t *sys, int request)
+{
+    for (int i = 0; i < sys->splitter.i_output; i++) {
+        struct vlc_vidsplit_part *part = &sys->parts[i];
+
+        part->request = request;
+        vlc_sem_post(&part->work);
+    }
+
+    for (int i = 0; i < sys->splitter.i_output; i++)
+        vlc_sem_wait(&sys->parts[i].done);
+}
+
 static void vlc_vidsplit_Prepare(vout_display_t *vd, picture_t *pic,
                                  subpicture_t *subpic, vlc_tick_t date)
 {
@@ -60,35 +121,30 @@ static void vlc_vidsplit_Prepare(vout_display_t *vd, picture_t *pic,
     (void) subpic;
 
     vlc_mutex_lock(&sys->lock);
-    if (video_splitter_Filter(&sys->splitter, sys->pictures, pic)) {
-        vlc_mutex_unlock(&sys->lock);
-
+    if (video_splitter_Filter(&sys->splitter, sys->pictures, pic))
         for (int i = 0; i < sys->splitter.i_output; i++)
             sys->pictures[i] = NULL;
-        return;
-    }
     vlc_mutex_unlock(&sys->lock);
 
     for (int i = 0; i < sys->splitter.i_output; i++) {
         struct vlc_vidsplit_part *part = &sys->parts[i];
 
         vlc_sem_wait(&part->lock);
-        sys->pictures[i] = vout_display_Prepare(part->display,
-                                                sys->pictures[i], NULL, date);
+        part->picture = sys->pictures[i];
+        part->date = date;
     }
+
+    vlc_vidsplit_Request(sys, VIDSPLIT_PREPARE);
 }
 
 static void vlc_vidsplit_Display(vout_display_t *vd, picture_t *picture)
 {
     vout_display_sys_t *sys = vd->sys;
 
-    for (int i = 0; i < sys->splitter.i_output; i++) {
-        struct vlc_vidsplit_part *part = &sys->parts[i];
+    vlc_vidsplit_Request(sys, VIDSPLIT_DISPLAY);
 
-        if (sys->pictures[i] != NULL)
-            vout_display_Display(part->display, sys->pictures[i]);
-        vlc_sem_post(&part->lock);
-    }
+    for (int i = 0; i < sys->splitter.i_output; i++)
+        vlc_sem_post(&sys->parts[i].lock);
 
     (void) picture;
 }
@@ -117,6 +173,10 @@ static void vlc_vidsplit_Close(vout_display_t *vd)
         struct vlc_vidsplit_part *part = &sys->parts[i];
         vout_display_t *display;
 
+        part->request = VIDSPLIT_QUIT;
+        vlc_sem_post(&part->work);
+        vlc_join(part->thread, NULL);
+
         vlc_sem_wait(&part->lock);
         display = part->display;
         part->display = NULL;
@@ -127,6 +187,8 @@ static void vlc_vidsplit_Close(vout_display_t *vd)
 
         vout_window_Disable(part->window);
         vout_window_Delete(part->window);
+        vlc_sem_destroy(&part->done);
+        vlc_sem_destroy(&part->work);
         vlc_sem_destroy(&part->lock);
     }
 
@@ -277,9 +339,12 @@ static int vlc_vidsplit_Open(vout_display_t *vd,
         struct vlc_vidsplit_part *part = &sys->parts[i];
 
         vlc_sem_init(&part->lock, 1);
+        vlc_sem_init(&part->work, 0);
+        vlc_sem_init(&part->done, 0);
         part->display = NULL;
         part->width = 1;
         part->height = 1;
+        part->picture = NULL;
 
         part->window = video_splitter_CreateWindow(obj, &vdcfg, &output->fmt,
                                                    part);
@@ -292,9 +357,15 @@ static int vlc_vidsplit_Open(vout_display_t *vd,
         vdcfg.window = part->window;
         vout_display_t *display = vout_display_New(obj, &output->fmt, ctx, &vdcfg,
                                                    modname, NULL);
-        if (display == NULL) {
+        if (display == NULL
+         || vlc_clone(&part->thread, vlc_vidsplit_Thread, part,
+                      VLC_THREAD_PRIORITY_OUTPUT)) {
+            if (display != NULL)
+                vout_display_Delete(display);
             vout_window_Disable(part->window);
             vout_window_Delete(part->window);
+            vlc_sem_destroy(&part->done);
+            vlc_sem_destroy(&part->work);
             vlc_sem_destroy(&part->lock);
             splitter->i_output = i;
             vlc_vidsplit_Close(vd);
@@ -30,10 +30,12 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_vout_display.h>
+#include <vlc_picture.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -51,6 +53,13 @@
 #define LT_CHROMA N_("Output chroma for the memory image as a 4-character " \
                       "string, eg. \"RV32\".")
 
+#define T_FRAMES N_("Lent frames")
+#define LT_FRAMES N_("Maximum number of decoded frames held by the " \
+                     "application at once, when the frames are lent rather " \
+                     "than copied. Further frames are dropped until some " \
+                     "are released. The decoder may stall if the " \
+                     "application holds too many of its buffers.")
+
 static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
                 video_format_t *fmtp, vlc_video_context *context);
 static void Close(vout_display_t *vd);
@@ -70,6 +79,8 @@ vlc_module_begin()
         change_private()
     add_string("vmem-chroma", "RV16", T_CHROMA, LT_CHROMA, true)
         change_private()
+    add_integer_with_range("vmem-frames", 2, 1, 64, T_FRAMES, LT_FRAMES, true)
+        change_private()
     add_obsolete_string("vmem-lock") /* obsoleted since 1.1.1 */
     add_obsolete_string("vmem-unlock") /* obsoleted since 1.1.1 */
     add_obsolete_string("vmem-data") /* obsoleted since 1.1.1 */
@@ -85,6 +96,20 @@ typedef struct
     void *id;
 } picture_sys_t;
 
+/* Shared between the display and the lent frames, which may outlive it:
+ * one reference for the display, plus one per frame held by the application.
+ */
+typedef struct
+{
+    atomic_uint refs;
+} vmem_lender_t;
+
+typedef struct
+{
+    picture_t *picture;
+    vmem_lender_t *lender;
+} vmem_frame_t;
+
 /* NOTE: the callback prototypes must match those of LibVLC */
 struct vout_display_sys_t {
     void *opaque;
@@ -93,6 +118,13 @@ struct vout_display_sys_t {
     void (*unlock)(void *sys, void *id, void *const *plane);
     void (*display)(void *sys, void *id);
     void (*cleanup)(void *sys);
+    void (*frame)(void *sys, void *frame, void *const *planes,
+                  const unsigned *pitches, const unsigned *lines,
+                  int64_t pts);
+
+    vmem_lender_t *lender;
+    unsigned max_frames;
+    bool dropping;
 
     unsigned pitches[PICTURE_PLANE_MAX];
     unsigned lines[PICTURE_PLANE_MAX];
@@ -121,11 +153,25 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
     vlc_format_cb setup = var_InheritAddress(vd, "vmem-setup");
 
     sys->lock = var_InheritAddress(vd, "vmem-lock");
-    if (sys->lock == NULL) {
+    sys->frame = var_InheritAddress(vd, "vmem-frame");
+    if (sys->lock == NULL && sys->frame == NULL) {
         msg_Err(vd, "missing lock callback");
         free(sys);
         return VLC_EGENERIC;
     }
+    sys->lender = NULL;
+    if (sys->frame != NULL) {
+        sys->lender = malloc(sizeof (*sys->lender));
+        if (unlikely(sys->lender == NULL)) {
+            free(sys);
+            return VLC_ENOMEM;
+        }
+        atomic_init(&sys->lender->refs, 1);
+        sys->max_frames = var_InheritInteger(vd, "vmem-frames");
+        if (sys->max_frames == 0)
+            sys->max_frames = 1;
+        sys->dropping = false;
+    }
     sys->unlock = var_InheritAddress(vd, "vmem-unlock");
     sys->display = var_InheritAddress(vd, "vmem-display");
     sys->cleanup = var_InheritAddress(vd, "vmem-cleanup");
@@ -153,6 +199,7 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
         if (setup(&sys->opaque, chroma, widths, heights,
                            sys->pitches, sys->lines) == 0) {
             msg_Err(vd, "video format setup failure (no pictures)");
+            free(sys->lender);
             free(sys);
             return VLC_EGENERIC;
         }
@@ -182,6 +229,7 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
 
     if (!fmt.i_chroma) {
         msg_Err(vd, "vmem-chroma should be 4 characters long");
+        free(sys->lender);
         free(sys);
         return VLC_EGENERIC;
     }
@@ -231,9 +279,78 @@ static void Close(vout_display_t *vd)
 
     if (sys->cleanup)
         sys->cleanup(sys->opaque);
+    if (sys->lender != NULL
+     && atomic_fetch_sub_explicit(&sys->lender->refs, 1,
+                                  memory_order_acq_rel) == 1)
+        free(sys->lender);
     free(sys);
 }
 
+static void ReleaseFrame(picture_t *clone)
+{
+    vmem_frame_t *frame = clone->p_sys;
+    vmem_lender_t *lender = frame->lender;
+
+    picture_Release(frame->picture);
+    if (atomic_fetch_sub_explicit(&lender->refs, 1,
+                                  memory_order_acq_rel) == 1)
+        free(lender);
+    free(frame);
+}
+
+/* Hands the decoded picture itself to the application, which releases it
+ * with libvlc_video_frame_release() (i.e. picture_Release() on the clone). */
+static void LendFrame(vout_display_t *vd, picture_t *pic)
+{
+    vout_display_sys_t *sys = vd->sys;
+    vmem_lender_t *lender = sys->lender;
+
+    unsigned lent = atomic_load_explicit(&lender->refs,
+                                         memory_order_relaxed) - 1;
+    if (lent >= sys->max_frames) {
+        if (!sys->dropping)
+            msg_Warn(vd, "%u frames held by the application, dropping", lent);
+        sys->dropping = true;
+        return;
+    }
+    sys->dropping = false;
+
+    vmem_frame_t *frame = malloc(sizeof (*frame));
+    if (unlikely(frame == NULL))
+        return;
+
+    picture_resource_t rsc = {
+        .p_sys = frame,
+        .pf_destroy = ReleaseFrame,
+    };
+    void *planes[PICTURE_PLANE_MAX] = { NULL };
+    unsigned pitches[PICTURE_PLANE_MAX] = { 0 };
+    unsigned lines[PICTURE_PLANE_MAX] = { 0 };
+
+    for (int i = 0; i < pic->i_planes; i++) {
+        rsc.p[i].p_pixels = pic->p[i].p_pixels;
+        rsc.p[i].i_lines = pic->p[i].i_lines;
+        rsc.p[i].i_pitch = pic->p[i].i_pitch;
+        planes[i] = pic->p[i].p_pixels;
+        pitches[i] = pic->p[i].i_pitch;
+        lines[i] = pic->p[i].i_lines;
+    }
+
+    picture_t *clone = picture_NewFromResource(&pic->format, &rsc);
+    if (unlikely(clone == NULL)) {
+        free(frame);
+        return;
+    }
+    picture_CopyProperties(clone, pic);
+
+    frame->picture = picture_Hold(pic);
+    frame->lender = lender;
+    atomic_fetch_add_explicit(&lender->refs, 1, memory_order_relaxed);
+
+    sys->frame(sys->opaque, clone, planes, pitches, lines,
+               US_FROM_VLC_TICK(pic->date));
+}
+
 static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
                     vlc_tick_t date)
 {
@@ -242,6 +359,10 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
     picture_resource_t rsc = { .p_sys = NULL };
     void *planes[PICTURE_PLANE_MAX];
 
+    (void) subpic;
+    if (sys->frame != NULL)
+        return; /* lent as is on display, nothing to copy */
+
     sys->pic_opaque = sys->lock(sys->opaque, planes);
 
     for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
@@ -258,14 +379,16 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
 
     if (sys->unlock != NULL)
         sys->unlock(sys->opaque, sys->pic_opaque, planes);
-
-    (void) subpic;
 }
 
 static void Display(vout_display_t *vd, picture_t *pic)
 {
     vout_display_sys_t *sys = vd->sys;
-    VLC_UNUSED(pic);
+
+    if (sys->frame != NULL) {
+        LendFrame(vd, pic);
+        return;
+    }
 
     if (sys->display != NULL)
         sys->display(sys->opaque, sys->pic_opaque);
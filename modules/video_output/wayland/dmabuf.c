@@ -0,0 +1,402 @@
+/**
+ * @file dmabuf.c
+ * @brief Wayland DMA-BUF video output module for VLC media player
+ */
+/*****************************************************************************
+ * Copyright © 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The decoded VAAPI surfaces are exported as DMA-BUFs and handed over to the
+ * compositor as is: there are no copies, and the compositor can scan them out
+ * directly on an overlay plane. Scaling and cropping are left to the
+ * compositor through the viewporter.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <wayland-client.h>
+#include "linux-dmabuf-client-protocol.h"
+#include "viewporter-client-protocol.h"
+#include "registry.h"
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_vout_display.h>
+#include <vlc_vector.h>
+
+#include "../../hw/vaapi/vlc_vaapi.h"
+
+#ifndef DRM_FORMAT_MOD_INVALID
+# define DRM_FORMAT_MOD_INVALID ((UINT64_C(1) << 56) - 1)
+#endif
+
+struct dmabuf_format
+{
+    uint32_t format;
+    uint64_t modifier;
+};
+
+struct vout_display_sys_t
+{
+    vout_window_t *embed; /* VLC window */
+    struct wl_event_queue *eventq;
+    struct zwp_linux_dmabuf_v1 *dmabuf;
+    struct wp_viewporter *viewporter;
+    struct wp_viewport *viewport;
+
+    /* Formats and modifiers supported by the compositor */
+    struct VLC_VECTOR(struct dmabuf_format) formats;
+    bool has_modifiers;
+    bool warned;
+
+    size_t active_buffers;
+
+    unsigned display_width;
+    unsigned display_height;
+};
+
+struct buffer_data
+{
+    picture_t *picture;
+    size_t *counter;
+};
+
+static void buffer_release_cb(void *data, struct wl_buffer *buffer)
+{
+    struct buffer_data *d = data;
+
+    picture_Release(d->picture);
+    (*(d->counter))--;
+    free(d);
+    wl_buffer_destroy(buffer);
+}
+
+static const struct wl_buffer_listener buffer_cbs =
+{
+    buffer_release_cb,
+};
+
+static bool IsFormatSupported(vout_display_sys_t *sys, uint32_t format,
+                              uint64_t modifier)
+{
+    struct dmabuf_format f;
+
+    vlc_vector_foreach(f, &sys->formats)
+        if (f.format == format
+         && (!sys->has_modifiers || f.modifier == modifier))
+            return true;
+    return false;
+}
+
+static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
+                    vlc_tick_t date)
+{
+    VLC_UNUSED(date);
+    vout_display_sys_t *sys = vd->sys;
+    struct wl_display *display = sys->embed->display.wl;
+    struct wl_surface *surface = sys->embed->handle.wl;
+    VADRMPRIMESurfaceDescriptor desc;
+
+    if (vlc_vaapi_ExportSurfaceHandle(VLC_OBJECT(vd),
+                                      vlc_vaapi_PicGetDisplay(pic),
+                                      vlc_vaapi_PicGetSurface(pic), &desc))
+        return;
+
+    /* Composed layers: all the planes are in the first layer */
+    const uint32_t format = desc.layers[0].drm_format;
+    const uint64_t modifier =
+        desc.objects[desc.layers[0].object_index[0]].drm_format_modifier;
+
+    if (!IsFormatSupported(sys, format, modifier))
+    {
+        if (!sys->warned)
+            msg_Err(vd, "format %.4s (modifier 0x%"PRIx64") not supported "
+                    "by the compositor", (const char *)&format, modifier);
+        sys->warned = true;
+        goto out;
+    }
+
+    struct buffer_data *d = malloc(sizeof (*d));
+    if (unlikely(d == NULL))
+        goto out;
+
+    struct zwp_linux_buffer_params_v1 *params =
+        zwp_linux_dmabuf_v1_create_params(sys->dmabuf);
+    if (params == NULL)
+    {
+        free(d);
+        goto out;
+    }
+
+    for (uint32_t i = 0; i < desc.layers[0].num_planes; i++)
+    {
+        const uint32_t obj = desc.layers[0].object_index[i];
+        const uint64_t mod = sys->has_modifiers ?
+            desc.objects[obj].drm_format_modifier : DRM_FORMAT_MOD_INVALID;
+
+        /* The file descriptor is duplicated when the request is queued */
+        zwp_linux_buffer_params_v1_add(params, desc.objects[obj].fd, i,
+                                       desc.layers[0].offset[i],
+                                       desc.layers[0].pitch[i],
+                                       mod >> 32, mod & UINT32_MAX);
+    }
+
+    struct wl_buffer *buf =
+        zwp_linux_buffer_params_v1_create_immed(params, desc.width,
+                                                desc.height, format, 0);
+    zwp_linux_buffer_params_v1_destroy(params);
+    if (buf == NULL)
+    {
+        free(d);
+        goto out;
+    }
+
+    d->picture = picture_Hold(pic);
+    d->counter = &sys->active_buffers;
+
+    wl_buffer_add_listener(buf, &buffer_cbs, d);
+    wl_surface_attach(surface, buf, 0, 0);
+    wl_surface_damage(surface, 0, 0, sys->display_width, sys->display_height);
+    wl_display_flush(display);
+
+    sys->active_buffers++;
+out:
+    vlc_vaapi_CloseSurfaceHandle(&desc);
+    (void) subpic;
+}
+
+static void Display(vout_display_t *vd, picture_t *pic)
+{
+    vout_display_sys_t *sys = vd->sys;
+    struct wl_display *display = sys->embed->display.wl;
+    struct wl_surface *surface = sys->embed->handle.wl;
+
+    wl_surface_commit(surface);
+    wl_display_roundtrip_queue(display, sys->eventq);
+
+    (void) pic;
+}
+
+static void ResizeViewport(vout_display_t *vd, const vout_display_cfg_t *cfg)
+{
+    vout_display_sys_t *sys = vd->sys;
+    const video_format_t *fmt = &vd->source;
+    vout_display_place_t place;
+
+    sys->display_width = cfg->display.width;
+    sys->display_height = cfg->display.height;
+
+    vout_display_PlacePicture(&place, fmt, cfg);
+
+    wp_viewport_set_source(sys->viewport,
+                           wl_fixed_from_int(fmt->i_x_offset),
+                           wl_fixed_from_int(fmt->i_y_offset),
+                           wl_fixed_from_int(fmt->i_visible_width),
+                           wl_fixed_from_int(fmt->i_visible_height));
+    wp_viewport_set_destination(sys->viewport, place.width, place.height);
+}
+
+static int Control(vout_display_t *vd, int query, va_list ap)
+{
+    switch (query)
+    {
+        case VOUT_DISPLAY_CHANGE_DISPLAY_SIZE:
+        case VOUT_DISPLAY_CHANGE_DISPLAY_FILLED:
+        case VOUT_DISPLAY_CHANGE_ZOOM:
+        case VOUT_DISPLAY_CHANGE_SOURCE_ASPECT:
+        case VOUT_DISPLAY_CHANGE_SOURCE_CROP:
+            ResizeViewport(vd, va_arg(ap, const vout_display_cfg_t *));
+            break;
+        default:
+             msg_Err(vd, "unknown request %d", query);
+             return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void AddFormat(vout_display_t *vd, uint32_t format, uint64_t modifier)
+{
+    vout_display_sys_t *sys = vd->sys;
+    struct dmabuf_format f = { format, modifier };
+
+    msg_Dbg(vd, "format %.4s modifier 0x%016"PRIx64, (const char *)&format,
+            modifier);
+    if (!vlc_vector_push(&sys->formats, f))
+        msg_Err(vd, "cannot store format %.4s", (const char *)&format);
+}
+
+static void dmabuf_format_cb(void *data, struct zwp_linux_dmabuf_v1 *dmabuf,
+                             uint32_t format)
+{
+    vout_display_t *vd = data;
+
+    /* Only sent by old compositors, without any modifier */
+    if (!vd->sys->has_modifiers)
+        AddFormat(vd, format, DRM_FORMAT_MOD_INVALID);
+    (void) dmabuf;
+}
+
+static void dmabuf_modifier_cb(void *data, struct zwp_linux_dmabuf_v1 *dmabuf,
+                               uint32_t format, uint32_t modifier_hi,
+                               uint32_t modifier_lo)
+{
+    vout_display_t *vd = data;
+
+    AddFormat(vd, format, ((uint64_t)modifier_hi << 32) | modifier_lo);
+    (void) dmabuf;
+}
+
+static const struct zwp_linux_dmabuf_v1_listener dmabuf_cbs =
+{
+    dmabuf_format_cb,
+    dmabuf_modifier_cb,
+};
+
+static void Close(vout_display_t *vd)
+{
+    vout_display_sys_t *sys = vd->sys;
+    struct wl_display *display = sys->embed->display.wl;
+    struct wl_surface *surface = sys->embed->handle.wl;
+
+    wl_surface_attach(surface, NULL, 0, 0);
+    wl_surface_commit(surface);
+
+    /* Wait until all picture buffers are released by the server */
+    while (sys->active_buffers > 0) {
+        msg_Dbg(vd, "%zu buffer(s) still active", sys->active_buffers);
+        wl_display_roundtrip_queue(display, sys->eventq);
+    }
+    msg_Dbg(vd, "no active buffers left");
+
+    wp_viewport_destroy(sys->viewport);
+    wp_viewporter_destroy(sys->viewporter);
+    zwp_linux_dmabuf_v1_destroy(sys->dmabuf);
+    wl_display_flush(display);
+    wl_event_queue_destroy(sys->eventq);
+    vlc_vector_destroy(&sys->formats);
+    free(sys);
+}
+
+static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
+                video_format_t *fmtp, vlc_video_context *context)
+{
+    if (cfg->window->type != VOUT_WINDOW_TYPE_WAYLAND)
+        return VLC_EGENERIC;
+    if (context == NULL
+     || vlc_video_context_GetType(context) != VLC_VIDEO_CONTEXT_VAAPI
+     || !vlc_vaapi_IsChromaOpaque(fmtp->i_chroma))
+        return VLC_EGENERIC;
+
+    vout_display_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    vd->sys = sys;
+    sys->embed = cfg->window;
+    sys->eventq = NULL;
+    sys->dmabuf = NULL;
+    sys->viewporter = NULL;
+    sys->viewport = NULL;
+    vlc_vector_init(&sys->formats);
+    sys->warned = false;
+    sys->active_buffers = 0;
+    sys->display_width = cfg->display.width;
+    sys->display_height = cfg->display.height;
+
+    struct wl_display *display = sys->embed->display.wl;
+    struct wl_surface *surface = sys->embed->handle.wl;
+    struct vlc_wl_registry *registry = NULL;
+
+    sys->eventq = wl_display_create_queue(display);
+    if (sys->eventq == NULL)
+        goto error;
+
+    registry = vlc_wl_registry_get(display, sys->eventq);
+    if (registry == NULL)
+        goto error;
+
+    /* Version 3 lists the modifiers, version 4 replaces the list with
+     * feedback objects */
+    uint32_t version = 3;
+    sys->dmabuf = (struct zwp_linux_dmabuf_v1 *)
+                  vlc_wl_interface_bind(registry, "zwp_linux_dmabuf_v1",
+                                        &zwp_linux_dmabuf_v1_interface,
+                                        &version);
+    if (sys->dmabuf == NULL)
+        goto error;
+    sys->has_modifiers = version >= 3;
+
+    /* The pictures cannot be scaled on our side */
+    sys->viewporter = (struct wp_viewporter *)
+                      vlc_wl_interface_bind(registry, "wp_viewporter",
+                                            &wp_viewporter_interface, NULL);
+    if (sys->viewporter == NULL)
+        goto error;
+
+    zwp_linux_dmabuf_v1_add_listener(sys->dmabuf, &dmabuf_cbs, vd);
+    wl_display_roundtrip_queue(display, sys->eventq);
+
+    if (sys->formats.size == 0)
+    {
+        msg_Dbg(vd, "no DMA-BUF formats supported");
+        goto error;
+    }
+
+    sys->viewport = wp_viewporter_get_viewport(sys->viewporter, surface);
+    if (sys->viewport == NULL)
+        goto error;
+
+    ResizeViewport(vd, cfg);
+
+    vd->prepare = Prepare;
+    vd->display = Display;
+    vd->control = Control;
+    vd->close = Close;
+
+    vlc_wl_registry_destroy(registry);
+    return VLC_SUCCESS;
+
+error:
+    if (sys->viewporter != NULL)
+        wp_viewporter_destroy(sys->viewporter);
+    if (sys->dmabuf != NULL)
+        zwp_linux_dmabuf_v1_destroy(sys->dmabuf);
+
+    if (registry != NULL)
+        vlc_wl_registry_destroy(registry);
+
+    if (sys->eventq != NULL)
+        wl_event_queue_destroy(sys->eventq);
+    vlc_vector_destroy(&sys->formats);
+    free(sys);
+    return VLC_EGENERIC;
+}
+
+vlc_module_begin()
+    set_shortname(N_("WL DMA-BUF"))
+    set_description(N_("Wayland DMA-BUF video output"))
+    set_category(CAT_VIDEO)
+    set_subcategory(SUBCAT_VIDEO_VOUT)
+    set_callback_display(Open, 280)
+    add_shortcut("wl")
+vlc_module_end()
@@ -84,6 +84,7 @@ struct d3d11_local_swapchain
     ID3D11RenderTargetView *swapchainTargetView[D3D11_MAX_RENDER_TARGET];
 
     bool                   logged_capabilities;
+    bool                   use_overlay;      /* prefer YUV overlay planes */
 };
 
 DEFINE_GUID(GUID_SWAPCHAIN_WIDTH,  0xf1b59347, 0x1643, 0x411a, 0xad, 0x6b, 0xc7, 0x80, 0x17, 0x7a, 0x06, 0xb6);
@@ -248,7 +249,6 @@ static void FillSwapChainDesc(struct d3d11_local_swapchain *display, UINT width,
     out->Width = width;
     out->Height = height;
     out->Format = display->pixelFormat->formatTexture;
-    //out->Flags = 512; // DXGI_SWAP_CHAIN_FLAG_YUV_VIDEO;
 
     bool isWin10OrGreater = false;
     HMODULE hKernel32 = GetModuleHandle(TEXT("kernel32.dll"));
@@ -269,6 +269,40 @@ static void FillSwapChainDesc(struct d3d11_local_swapchain *display, UINT width,
             out->BufferCount = 1;
         }
     }
+
+    /* YUV swapchains can only be scanned out by the flip model */
+    if (display->use_overlay && out->SwapEffect != DXGI_SWAP_EFFECT_DISCARD &&
+        vlc_fourcc_IsYUV(display->pixelFormat->fourcc))
+        out->Flags = DXGI_SWAP_CHAIN_FLAG_YUV_VIDEO;
+}
+
+/* Checks if the output can show the format on a hardware (multi-plane)
+ * overlay, without going through the desktop composition. */
+static bool SupportsOverlay(struct d3d11_local_swapchain *display, DXGI_FORMAT format)
+{
+    bool supported = false;
+    IDXGIAdapter *dxgiadapter = D3D11DeviceAdapter(display->d3d_dev->d3ddevice);
+    if (unlikely(dxgiadapter==NULL))
+        return false;
+
+    IDXGIOutput *dxgiOutput = NULL;
+    if (SUCCEEDED(IDXGIAdapter_EnumOutputs(dxgiadapter, 0, &dxgiOutput)))
+    {
+        IDXGIOutput3 *dxgiOutput3 = NULL;
+        if (SUCCEEDED(IDXGIOutput_QueryInterface( dxgiOutput, &IID_IDXGIOutput3, (void **)&dxgiOutput3 )))
+        {
+            UINT flags = 0;
+            if (SUCCEEDED(IDXGIOutput3_CheckOverlaySupport( dxgiOutput3, format,
+                                                             (IUnknown *)display->d3d_dev->d3ddevice,
+                                                             &flags )))
+                supported = (flags & (DXGI_OVERLAY_SUPPORT_FLAG_DIRECT |
+                                      DXGI_OVERLAY_SUPPORT_FLAG_SCALING)) != 0;
+            IDXGIOutput3_Release( dxgiOutput3 );
+        }
+        IDXGIOutput_Release( dxgiOutput );
+    }
+    IDXGIAdapter_Release(dxgiadapter);
+    return supported;
 }
 
 static void CreateSwapchain(struct d3d11_local_swapchain *display, UINT width, UINT height)
@@ -367,11 +401,26 @@ static bool UpdateSwapchain( struct d3d11_local_swapchain *display, const libvlc
         }
     }
 #else /* !VLC_WINSTORE_APP */
+    if (display->use_overlay)
+    {
+        /* a YUV swapchain on an overlay plane is scanned out as is */
+        newPixelFormat = FindD3D11Format( display->obj, display->d3d_dev, 0, D3D11_YUV_FORMAT,
+                                          cfg->bitdepth > 8 ? 10 : 8,
+                                          2, 2,
+                                          D3D11_CHROMA_CPU, D3D11_FORMAT_SUPPORT_DISPLAY );
+        if (newPixelFormat != NULL && !SupportsOverlay(display, newPixelFormat->formatTexture))
+        {
+            msg_Dbg(display->obj, "no overlay support for %s", newPixelFormat->name);
+            newPixelFormat = NULL;
+        }
+    }
+
     /* favor RGB formats first */
-    newPixelFormat = FindD3D11Format( display->obj, display->d3d_dev, 0, D3D11_RGB_FORMAT,
-                                      cfg->bitdepth > 8 ? 10 : 8,
-                                      0, 0,
-                                      D3D11_CHROMA_CPU, D3D11_FORMAT_SUPPORT_DISPLAY );
+    if (newPixelFormat == NULL)
+        newPixelFormat = FindD3D11Format( display->obj, display->d3d_dev, 0, D3D11_RGB_FORMAT,
+                                          cfg->bitdepth > 8 ? 10 : 8,
+                                          0, 0,
+                                          D3D11_CHROMA_CPU, D3D11_FORMAT_SUPPORT_DISPLAY );
     if (unlikely(newPixelFormat == NULL))
         newPixelFormat = FindD3D11Format( display->obj, display->d3d_dev, 0, D3D11_YUV_FORMAT,
                                           cfg->bitdepth > 8 ? 10 : 8,
@@ -404,8 +453,10 @@ static bool UpdateSwapchain( struct d3d11_local_swapchain *display, const libvlc
 #endif /* !VLC_WINSTORE_APP */
     {
         /* TODO detect is the size is the same as the output and switch to fullscreen mode */
+        DXGI_SWAP_CHAIN_DESC1 scd = { 0 };
+        IDXGISwapChain1_GetDesc1( display->dxgiswapChain, &scd );
         hr = IDXGISwapChain_ResizeBuffers( display->dxgiswapChain, 0, cfg->width, cfg->height,
-                                           DXGI_FORMAT_UNKNOWN, 0 );
+                                           DXGI_FORMAT_UNKNOWN, scd.Flags );
         if ( FAILED( hr ) ) {
             msg_Err( display->obj, "Failed to resize the backbuffer. (hr=0x%lX)", hr );
             return false;
@@ -558,6 +609,7 @@ void *CreateLocalSwapchainHandle(vlc_object_t *o, HWND hwnd, d3d11_device_t *d3d
     display->swapchainHwnd = hwnd;
 #endif /* !VLC_WINSTORE_APP */
     display->d3d_dev = d3d_dev;
+    display->use_overlay = var_InheritBool(o, "direct3d11-overlay");
 
     return display;
 }
@@ -67,6 +67,10 @@ static void Close(vout_display_t *);
 #define HW_BLENDING_TEXT N_("Use hardware blending support")
 #define HW_BLENDING_LONGTEXT N_(\
     "Try to use hardware acceleration for subtitle/OSD blending.")
+#define OVERLAY_TEXT N_("Use hardware overlay planes")
+#define OVERLAY_LONGTEXT N_(\
+    "Use a YUV swapchain that the display can scan out on an overlay plane " \
+    "(multi-plane overlay), instead of composing it with the desktop.")
 
 vlc_module_begin ()
     set_shortname("Direct3D11")
@@ -76,6 +80,7 @@ vlc_module_begin ()
     set_subcategory(SUBCAT_VIDEO_VOUT)
 
     add_bool("direct3d11-hw-blending", true, HW_BLENDING_TEXT, HW_BLENDING_LONGTEXT, true)
+    add_bool("direct3d11-overlay", false, OVERLAY_TEXT, OVERLAY_LONGTEXT, true)
 
 #if VLC_WINSTORE_APP
     add_integer("winrt-swapchain",     0x0, NULL, NULL, true) /* IDXGISwapChain1*     */
@@ -248,16 +248,48 @@ static void Close( vlc_object_t *p_this )
     free( p_sys );
 }
 
-static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t *p_src )
+static void ViewDestroy( picture_t *p_view )
 {
-    video_splitter_sys_t *p_sys = p_splitter->p_sys;
+    picture_Release( p_view->p_sys );
+}
+
+/* Returns a picture showing the tile of the source picture, without copy */
+static picture_t *NewView( const video_format_t *p_fmt, picture_t *p_src,
+                           const wall_output_t *p_output )
+{
+    picture_resource_t rsc = {
+        .p_sys = p_src,
+        .pf_destroy = ViewDestroy,
+    };
 
-    if( video_splitter_NewPicture( p_splitter, pp_dst ) )
+    for( int i = 0; i < p_src->i_planes; i++ )
     {
-        picture_Release( p_src );
-        return VLC_EGENERIC;
+        const plane_t *p0 = &p_src->p[0];
+        const plane_t *p = &p_src->p[i];
+        const int i_y = p_output->i_top  * p->i_visible_pitch / p0->i_visible_pitch;
+        const int i_x = p_output->i_left * p->i_visible_lines / p0->i_visible_lines;
+
+        rsc.p[i].p_pixels = p->p_pixels + i_y * p->i_pitch
+                          + ( i_x - (i_x % p->i_pixel_pitch));
+        rsc.p[i].i_lines = p->i_lines - i_y;
+        rsc.p[i].i_pitch = p->i_pitch;
     }
 
+    picture_t *p_view = picture_NewFromResource( p_fmt, &rsc );
+    if( p_view != NULL )
+        picture_Hold( p_src );
+    return p_view;
+}
+
+static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t *p_src )
+{
+    video_splitter_sys_t *p_sys = p_splitter->p_sys;
+
+    /* The tiles are views into the source picture: the displays copy them
+     * into their own buffers anyway. */
+    for( int i = 0; i < p_splitter->i_output; i++ )
+        pp_dst[i] = NULL;
+
     for( int y = 0; y < p_sys->i_row; y++ )
     {
         for( int x = 0; x < p_sys->i_col; x++ )
@@ -266,20 +298,19 @@ static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t
             if( !p_output->b_active )
                 continue;
 
-            picture_t *p_dst = pp_dst[p_output->i_output];
-
-            /* */
-            picture_t tmp = *p_src;
-            for( int i = 0; i < tmp.i_planes; i++ )
+            const int i_index = p_output->i_output;
+            picture_t *p_view = NewView( &p_splitter->p_output[i_index].fmt,
+                                         p_src, p_output );
+            if( p_view == NULL )
             {
-                plane_t *p0 = &tmp.p[0];
-                plane_t *p = &tmp.p[i];
-                const int i_y = p_output->i_top  * p->i_visible_pitch / p0->i_visible_pitch;
-                const int i_x = p_output->i_left * p->i_visible_lines / p0->i_visible_lines;
-
-                p->p_pixels += i_y * p->i_pitch + ( i_x - (i_x % p->i_pixel_pitch));
+                for( int i = 0; i < p_splitter->i_output; i++ )
+                    if( pp_dst[i] != NULL )
+                        picture_Release( pp_dst[i] );
+                msg_Warn( p_splitter, "can't get output pictures" );
+                picture_Release( p_src );
+                return VLC_EGENERIC;
             }
-            picture_Copy( p_dst, &tmp );
+            pp_dst[i_index] = p_view;
         }
     }
 
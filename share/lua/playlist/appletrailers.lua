@@ -20,6 +20,9 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
 --]]
 
+-- Hosts handled by this script, see README.txt
+probe_hosts = { "trailers.apple.com" }
+
 -- Probe function
 function probe()
     return (vlc.access == "http" or vlc.access == "https")
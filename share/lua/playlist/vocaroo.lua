@@ -23,6 +23,9 @@
 -- Set to "mp3", "ogg", "flac" or "wav"
 local fmt = "mp3"
 
+-- Hosts handled by this script, see README.txt
+probe_hosts = { "vocaroo.com" }
+
 -- Probe function.
 function probe()
     return ( vlc.access == "http" or vlc.access == "https" )
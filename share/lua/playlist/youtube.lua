@@ -284,6 +284,9 @@ function pick_stream( stream_map, js_url )
     return string.match( pick, '"url":"(.-)"' )
 end
 
+-- Hosts handled by this script, see README.txt
+probe_hosts = { "youtube.com" }
+
 -- Probe function.
 function probe()
     return ( ( vlc.access == "http" or vlc.access == "https" )
@@ -26,11 +26,15 @@
 # include <stdatomic.h>
 
 # include <vlc_viewpoint.h>
+# include <vlc_input_item.h>
 # include "../clock/clock.h"
 
 /* Max input rate factor (1/4 -> 4) */
 # define AOUT_MAX_INPUT_RATE (4)
 
+/* Max number of extra outputs fed by an audio output */
+# define AOUT_MAX_SINKS (4)
+
 enum {
     AOUT_RESAMPLING_NONE=0,
     AOUT_RESAMPLING_UP,
@@ -95,8 +99,25 @@ typedef struct
 
     atomic_uint buffers_lost;
     atomic_uint buffers_played;
+
+    /* Timing statistics, see input_aout_stats_t */
+    struct
+    {
+        atomic_uint latency[INPUT_STATS_AOUT_BUCKETS];
+        atomic_uint drift[INPUT_STATS_AOUT_BUCKETS];
+        atomic_uint underruns;
+        atomic_uint resamplings;
+        atomic_uint resampling_hz;
+    } stats;
     atomic_uchar restart;
 
+    bool sink; /**< Extra output fed by another audio output */
+    struct
+    {
+        audio_output_t *tab[AOUT_MAX_SINKS];
+        unsigned count;
+    } sinks;
+
     atomic_uintptr_t refs;
 } aout_owner_t;
 
@@ -127,6 +148,7 @@ void aout_volume_Delete(aout_volume_t *);
 /* From output.c : */
 audio_output_t *aout_New (vlc_object_t *);
 #define aout_New(a) aout_New(VLC_OBJECT(a))
+audio_output_t *aout_NewSink(audio_output_t *, const char *);
 void aout_Destroy (audio_output_t *);
 
 int aout_OutputNew(audio_output_t *);
@@ -149,7 +171,8 @@ int aout_DecNew(audio_output_t *, const audio_sample_format_t *, int profile,
                 struct vlc_clock_t *clock, const audio_replay_gain_t *);
 void aout_DecDelete(audio_output_t *);
 int aout_DecPlay(audio_output_t *aout, block_t *block);
-void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *);
+void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *,
+                           input_aout_stats_t *);
 void aout_DecChangePause(audio_output_t *, bool b_paused, vlc_tick_t i_date);
 void aout_DecChangeRate(audio_output_t *aout, float rate);
 void aout_DecChangeDelay(audio_output_t *aout, vlc_tick_t delay);
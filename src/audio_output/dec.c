@@ -30,9 +30,11 @@
 #include <assert.h>
 
 #include <math.h>
+#include <string.h>
 
 #include <vlc_common.h>
 #include <vlc_aout.h>
+#include <vlc_tracer.h>
 
 #include "aout_internal.h"
 #include "clock/clock.h"
@@ -50,6 +52,9 @@ static void aout_Drain(audio_output_t *aout)
     }
 }
 
+static void aout_SinksStart(audio_output_t *aout);
+static void aout_SinksStop(audio_output_t *aout);
+
 /**
  * Creates an audio output
  */
@@ -129,7 +134,17 @@ error:
 
     atomic_init (&owner->buffers_lost, 0);
     atomic_init (&owner->buffers_played, 0);
+    for (unsigned i = 0; i < INPUT_STATS_AOUT_BUCKETS; i++)
+    {
+        atomic_init (&owner->stats.latency[i], 0);
+        atomic_init (&owner->stats.drift[i], 0);
+    }
+    atomic_init (&owner->stats.underruns, 0);
+    atomic_init (&owner->stats.resamplings, 0);
+    atomic_init (&owner->stats.resampling_hz, 0);
     atomic_store_explicit(&owner->vp.update, true, memory_order_relaxed);
+
+    aout_SinksStart(p_aout);
     return 0;
 }
 
@@ -140,6 +155,7 @@ void aout_DecDelete (audio_output_t *aout)
 {
     aout_owner_t *owner = aout_owner (aout);
 
+    aout_SinksStop(aout);
     if (owner->mixer_format.i_format)
     {
         aout_DecFlush(aout);
@@ -169,6 +185,8 @@ static int aout_CheckReady (audio_output_t *aout)
         if (restart & AOUT_RESTART_OUTPUT)
         {   /* Reinitializes the output */
             msg_Dbg (aout, "restarting output...");
+            /* The sinks are fed with the output format: restart them too */
+            aout_SinksStop(aout);
             if (owner->mixer_format.i_format)
                 aout_OutputDelete (aout);
             owner->filter_format = owner->mixer_format = owner->input_format;
@@ -184,6 +202,8 @@ static int aout_CheckReady (audio_output_t *aout)
              * change from the user. */
             if (restart == AOUT_RESTART_OUTPUT)
                 status = AOUT_DEC_CHANGED;
+            if (owner->mixer_format.i_format)
+                aout_SinksStart(aout);
         }
 
         msg_Dbg (aout, "restarting filters...");
@@ -234,6 +254,7 @@ static void aout_StopResampling (audio_output_t *aout)
     aout_FiltersAdjustResampling (owner->filters, 0);
 }
 
+static void aout_Flush(audio_output_t *aout);
 static void aout_DecSynchronize(audio_output_t *aout, vlc_tick_t system_now,
                                 vlc_tick_t dec_pts);
 static void aout_DecSilence (audio_output_t *aout, vlc_tick_t length, vlc_tick_t pts)
@@ -261,6 +282,20 @@ static void aout_DecSilence (audio_output_t *aout, vlc_tick_t length, vlc_tick_t
     aout->play(aout, block, system_pts);
 }
 
+/* Counts a duration (absolute value) in its histogram bucket */
+static void aout_StatsAdd(atomic_uint *histogram, vlc_tick_t duration)
+{
+    unsigned bucket = 0;
+    int64_t ms = MS_FROM_VLC_TICK(llabs(duration));
+
+    while (ms > 0 && bucket < INPUT_STATS_AOUT_BUCKETS - 1)
+    {
+        ms >>= 1;
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&histogram[bucket], 1, memory_order_relaxed);
+}
+
 static void aout_DecSynchronize(audio_output_t *aout, vlc_tick_t system_now,
                                 vlc_tick_t dec_pts)
 {
@@ -285,6 +320,7 @@ static void aout_DecSynchronize(audio_output_t *aout, vlc_tick_t system_now,
 
     if (aout->time_get(aout, &delay) != 0)
         return; /* nothing can be done if timing is unknown */
+    aout_StatsAdd(owner->stats.latency, delay);
 
     if (owner->sync.discontinuity)
     {
@@ -322,6 +358,7 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
 
     if (unlikely(drift == INT64_MAX) || owner->bitexact)
         return; /* cf. INT64_MAX comment in aout_DecPlay() */
+    aout_StatsAdd(owner->stats.drift, drift);
 
     /* Late audio output.
      * This can happen due to insufficient caching, scheduling jitter
@@ -338,7 +375,7 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
         else
             msg_Dbg (aout, "playback too late (%"PRId64"): "
                      "flushing buffers", drift);
-        aout_DecFlush(aout);
+        aout_Flush(aout);
         aout_StopResampling (aout);
 
         return; /* nothing can be done if timing is unknown */
@@ -402,6 +439,10 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
          * value, then it is time to switch back the resampling direction. */
         adj *= -1;
 
+    atomic_fetch_add_explicit(&owner->stats.resamplings, 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&owner->stats.resampling_hz, abs(adj),
+                              memory_order_relaxed);
     if (!aout_FiltersAdjustResampling (owner->filters, adj))
     {   /* Everything is back to normal: stop resampling. */
         owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
@@ -409,6 +450,135 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
     }
 }
 
+static void aout_UpdateDelay(audio_output_t *aout, vlc_tick_t pts)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    if (owner->sync.request_delay != owner->sync.delay)
+    {
+        owner->sync.delay = owner->sync.request_delay;
+        vlc_tick_t delta = vlc_clock_SetDelay(owner->sync.clock, owner->sync.delay);
+        if (owner->filters)
+            aout_FiltersSetClockDelay(owner->filters, owner->sync.delay);
+        if (delta > 0)
+            aout_DecSilence (aout, delta, pts);
+    }
+}
+
+/*
+ * Sinks
+ *
+ * A sink is an extra audio output playing the samples of another one, once
+ * filtered and amplified. It converts and resamples them to its own format,
+ * and follows its own slave of the decoder clock, so that its latency is
+ * compensated and its drift corrected independently.
+ */
+
+static void aout_SinksStart(audio_output_t *aout)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    assert(owner->sinks.count == 0);
+    if (owner->sink || !AOUT_FMT_LINEAR(&owner->mixer_format))
+        return;
+
+    char *list = var_InheritString(aout, "aout-sinks");
+    if (list == NULL)
+        return;
+
+    char *p = list, *name;
+    while ((name = strsep(&p, " ,:")) != NULL)
+    {
+        if (*name == '\0')
+            continue;
+        if (owner->sinks.count >= AOUT_MAX_SINKS)
+        {
+            msg_Err(aout, "maximum of %u sinks reached", AOUT_MAX_SINKS);
+            break;
+        }
+
+        audio_output_t *sink = aout_NewSink(aout, name);
+        if (sink == NULL)
+        {
+            msg_Err(aout, "cannot add sink \"%s\" (skipped)", name);
+            continue;
+        }
+
+        vlc_clock_t *clock = vlc_clock_CreateSlave(owner->sync.clock,
+                                                   AUDIO_ES);
+        if (clock == NULL
+         || aout_DecNew(sink, &owner->mixer_format, 0, clock, NULL))
+        {
+            msg_Err(aout, "cannot start sink \"%s\" (skipped)", name);
+            if (clock != NULL)
+                vlc_clock_Delete(clock);
+            aout_Destroy(sink);
+            continue;
+        }
+
+        aout_DecChangeDelay(sink, owner->sync.request_delay);
+        owner->sinks.tab[owner->sinks.count++] = sink;
+    }
+    free(list);
+}
+
+static void aout_SinksStop(audio_output_t *aout)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    for (unsigned i = 0; i < owner->sinks.count; i++)
+    {
+        audio_output_t *sink = owner->sinks.tab[i];
+        vlc_clock_t *clock = aout_owner(sink)->sync.clock;
+
+        aout_DecDelete(sink);
+        vlc_clock_Delete(clock);
+        aout_Destroy(sink);
+    }
+    owner->sinks.count = 0;
+}
+
+static void aout_SinkPlay(audio_output_t *sink, block_t *block,
+                          vlc_tick_t pts, float rate)
+{
+    aout_owner_t *owner = aout_owner (sink);
+
+    /* The samples are already played at the rate: only the clock uses it */
+    owner->sync.rate = rate;
+
+    if (unlikely(aout_CheckReady(sink) == AOUT_DEC_FAILED))
+    {
+        block_Release(block);
+        atomic_fetch_add_explicit(&owner->buffers_lost, 1,
+                                  memory_order_relaxed);
+        return;
+    }
+
+    if (block->i_flags & BLOCK_FLAG_DISCONTINUITY)
+        owner->sync.discontinuity = true;
+
+    if (owner->filters)
+    {
+        block = aout_FiltersPlay(owner->filters, block, 1.f);
+        if (block == NULL)
+            return;
+    }
+
+    aout_UpdateDelay(sink, pts);
+
+    vlc_tick_t system_now = vlc_tick_now();
+    aout_DecSynchronize(sink, system_now, pts);
+
+    vlc_tick_t play_date =
+        vlc_clock_ConvertToSystem(owner->sync.clock, system_now, pts, rate);
+    if (unlikely(play_date == INT64_MAX))
+        play_date = system_now;
+
+    owner->sync.discontinuity = false;
+    sink->play(sink, block, play_date);
+    atomic_fetch_add_explicit(&owner->buffers_played, 1, memory_order_relaxed);
+}
+
 /*****************************************************************************
  * aout_DecPlay : filter & mix the decoded buffer
  *****************************************************************************/
@@ -461,16 +631,12 @@ int aout_DecPlay(audio_output_t *aout, block_t *block)
     /* Software volume */
     aout_volume_Amplify (owner->volume, block);
 
-    /* Update delay */
-    if (owner->sync.request_delay != owner->sync.delay)
-    {
-        owner->sync.delay = owner->sync.request_delay;
-        vlc_tick_t delta = vlc_clock_SetDelay(owner->sync.clock, owner->sync.delay);
-        if (owner->filters)
-            aout_FiltersSetClockDelay(owner->filters, owner->sync.delay);
-        if (delta > 0)
-            aout_DecSilence (aout, delta, block->i_pts);
-    }
+    /* Fan-out to the sinks */
+    block_t *copies[AOUT_MAX_SINKS];
+    for (unsigned i = 0; i < owner->sinks.count; i++)
+        copies[i] = block_Duplicate(block);
+
+    aout_UpdateDelay(aout, block->i_pts);
 
     /* Drift correction */
     vlc_tick_t system_now = vlc_tick_now();
@@ -487,8 +653,17 @@ int aout_DecPlay(audio_output_t *aout, block_t *block)
 
     }
     /* Output */
+    struct vlc_tracer *tracer = vlc_object_get_tracer(aout);
+
     owner->sync.discontinuity = false;
+    vlc_tracer_Begin(tracer, "aout", "play", aout, original_pts);
     aout->play(aout, block, play_date);
+    vlc_tracer_End(tracer, "aout", "play", aout, original_pts);
+
+    for (unsigned i = 0; i < owner->sinks.count; i++)
+        if (likely(copies[i] != NULL))
+            aout_SinkPlay(owner->sinks.tab[i], copies[i], original_pts,
+                          owner->sync.rate);
 
     atomic_fetch_add_explicit(&owner->buffers_played, 1, memory_order_relaxed);
     return ret;
@@ -501,7 +676,8 @@ drop:
 }
 
 void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
-                           unsigned *restrict played)
+                           unsigned *restrict played,
+                           input_aout_stats_t *restrict stats)
 {
     aout_owner_t *owner = aout_owner (aout);
 
@@ -509,6 +685,24 @@ void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
                                      memory_order_relaxed);
     *played = atomic_exchange_explicit(&owner->buffers_played, 0,
                                        memory_order_relaxed);
+
+    for (unsigned i = 0; i < INPUT_STATS_AOUT_BUCKETS; i++)
+    {
+        stats->i_latency[i] =
+            atomic_exchange_explicit(&owner->stats.latency[i], 0,
+                                     memory_order_relaxed);
+        stats->i_drift[i] =
+            atomic_exchange_explicit(&owner->stats.drift[i], 0,
+                                     memory_order_relaxed);
+    }
+    stats->i_underruns = atomic_exchange_explicit(&owner->stats.underruns, 0,
+                                                  memory_order_relaxed);
+    stats->i_resamplings =
+        atomic_exchange_explicit(&owner->stats.resamplings, 0,
+                                 memory_order_relaxed);
+    stats->i_resampling_hz =
+        atomic_exchange_explicit(&owner->stats.resampling_hz, 0,
+                                 memory_order_relaxed);
 }
 
 void aout_DecChangePause (audio_output_t *aout, bool paused, vlc_tick_t date)
@@ -522,6 +716,9 @@ void aout_DecChangePause (audio_output_t *aout, bool paused, vlc_tick_t date)
         else if (paused)
             aout->flush(aout);
     }
+
+    for (unsigned i = 0; i < owner->sinks.count; i++)
+        aout_DecChangePause(owner->sinks.tab[i], paused, date);
 }
 
 void aout_DecChangeRate(audio_output_t *aout, float rate)
@@ -536,12 +733,23 @@ void aout_DecChangeDelay(audio_output_t *aout, vlc_tick_t delay)
     aout_owner_t *owner = aout_owner(aout);
 
     owner->sync.request_delay = delay;
+    for (unsigned i = 0; i < owner->sinks.count; i++)
+        aout_DecChangeDelay(owner->sinks.tab[i], delay);
 }
 
 void aout_DecFlush(audio_output_t *aout)
 {
     aout_owner_t *owner = aout_owner (aout);
 
+    aout_Flush(aout);
+    for (unsigned i = 0; i < owner->sinks.count; i++)
+        aout_Flush(owner->sinks.tab[i]);
+}
+
+static void aout_Flush(audio_output_t *aout)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
     if (owner->mixer_format.i_format)
     {
         if (owner->filters)
@@ -593,4 +801,7 @@ void aout_DecDrain(audio_output_t *aout)
 
     owner->sync.discontinuity = true;
     owner->original_pts = VLC_TICK_INVALID;
+
+    for (unsigned i = 0; i < owner->sinks.count; i++)
+        aout_DecDrain(owner->sinks.tab[i]);
 }
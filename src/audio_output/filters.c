@@ -28,6 +28,9 @@
 #endif
 
 #include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
@@ -341,6 +344,131 @@ static void aout_FiltersPipelineChangeViewpoint(filter_t *const *filters,
 }
 
 #define AOUT_MAX_FILTERS 10
+#define AOUT_BUFFERS_MAX 8 /* recycled output buffers per chain */
+
+/*
+ * Output buffers of the filters are recycled rather than freed, so that
+ * steady-state playback does not allocate memory. Buffers can outlive the
+ * chain (the audio output may still queue them): the pool is reference
+ * counted by the chain and by each buffer in use.
+ */
+struct aout_buffer
+{
+    block_t self;
+    struct aout_buffers *pool;
+    struct aout_buffer *next;
+    size_t capacity;
+    max_align_t data[];
+};
+
+struct aout_buffers
+{
+    struct filter_audio_callbacks cbs;
+    vlc_mutex_t lock;
+    struct aout_buffer *free; /**< Recycled buffers */
+    unsigned count; /**< Number of recycled buffers */
+    bool closed;
+    atomic_uint refs;
+};
+
+static void aout_BuffersRelease(struct aout_buffers *pool)
+{
+    if (atomic_fetch_sub_explicit(&pool->refs, 1, memory_order_acq_rel) != 1)
+        return;
+
+    assert(pool->free == NULL);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+static void aout_BufferRecycle(block_t *block)
+{
+    struct aout_buffer *buf = container_of(block, struct aout_buffer, self);
+    struct aout_buffers *pool = buf->pool;
+
+    vlc_mutex_lock(&pool->lock);
+    if (!pool->closed && pool->count < AOUT_BUFFERS_MAX)
+    {
+        buf->next = pool->free;
+        pool->free = buf;
+        pool->count++;
+        buf = NULL;
+    }
+    vlc_mutex_unlock(&pool->lock);
+    free(buf);
+    aout_BuffersRelease(pool);
+}
+
+static const struct vlc_block_callbacks aout_buffer_cbs =
+{
+    aout_BufferRecycle,
+};
+
+static block_t *aout_BufferNew(filter_t *filter, size_t size)
+{
+    struct aout_buffers *pool = container_of(filter->owner.audio,
+                                             struct aout_buffers, cbs);
+    struct aout_buffer *buf;
+
+    vlc_mutex_lock(&pool->lock);
+    for (struct aout_buffer **pp = &pool->free; (buf = *pp) != NULL;
+         pp = &buf->next)
+        if (buf->capacity >= size)
+        {
+            *pp = buf->next;
+            pool->count--;
+            break;
+        }
+    vlc_mutex_unlock(&pool->lock);
+
+    if (buf == NULL)
+    {
+        size_t capacity = 4096;
+        while (capacity < size)
+            capacity <<= 1;
+
+        buf = malloc(sizeof (*buf) + capacity);
+        if (unlikely(buf == NULL))
+            return NULL;
+        buf->pool = pool;
+        buf->capacity = capacity;
+    }
+
+    atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    block_Init(&buf->self, &aout_buffer_cbs, buf->data, buf->capacity);
+    buf->self.i_buffer = size;
+    return &buf->self;
+}
+
+static struct aout_buffers *aout_BuffersNew(void)
+{
+    struct aout_buffers *pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    pool->cbs.buffer_new = aout_BufferNew;
+    vlc_mutex_init(&pool->lock);
+    pool->free = NULL;
+    pool->count = 0;
+    pool->closed = false;
+    atomic_init(&pool->refs, 1);
+    return pool;
+}
+
+static void aout_BuffersDelete(struct aout_buffers *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    pool->closed = true;
+    for (struct aout_buffer *buf = pool->free, *next; buf != NULL; buf = next)
+    {
+        next = buf->next;
+        free(buf);
+    }
+    pool->free = NULL;
+    pool->count = 0;
+    vlc_mutex_unlock(&pool->lock);
+    aout_BuffersRelease(pool);
+}
 
 struct aout_filters
 {
@@ -349,6 +477,7 @@ struct aout_filters
     filter_t *resampler; /**< The resampler */
     int resampling; /**< Current resampling (Hz) */
     vlc_clock_t *clock;
+    struct aout_buffers *buffers; /**< Recycled output buffers */
 
     unsigned count; /**< Number of filters */
     filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
@@ -486,6 +615,15 @@ static int AppendRemapFilter(vlc_object_t *obj, aout_filters_t *restrict filters
     return ret;
 }
 
+/** Makes the filters of a chain allocate from its buffer pool */
+static void aout_FiltersSetBuffers(aout_filters_t *filters)
+{
+    for (unsigned i = 0; i < filters->count; i++)
+        filters->tab[i]->owner.audio = &filters->buffers->cbs;
+    if (filters->resampler != NULL)
+        filters->resampler->owner.audio = &filters->buffers->cbs;
+}
+
 aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *clock,
                                          const audio_sample_format_t *restrict infmt,
                                          const audio_sample_format_t *restrict outfmt,
@@ -499,6 +637,12 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
     filters->resampler = NULL;
     filters->resampling = 0;
     filters->count = 0;
+    filters->buffers = aout_BuffersNew();
+    if (unlikely(filters->buffers == NULL))
+    {
+        free(filters);
+        return NULL;
+    }
     if (clock)
     {
         filters->clock = vlc_clock_CreateSlave(clock, AUDIO_ES);
@@ -529,6 +673,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
             }
             filters->count++;
         }
+        aout_FiltersSetBuffers(filters);
         return filters;
     }
     if (aout_FormatNbChannels(outfmt) == 0)
@@ -642,6 +787,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
     if (filters->rate_filter == NULL)
         filters->rate_filter = filters->resampler;
 
+    aout_FiltersSetBuffers(filters);
     return filters;
 
 error:
@@ -649,6 +795,7 @@ error:
     var_DelCallback(obj, "visual", VisualizationCallback, NULL);
     if (filters->clock)
         vlc_clock_Delete(filters->clock);
+    aout_BuffersDelete(filters->buffers);
     free (filters);
     return NULL;
 }
@@ -696,6 +843,7 @@ void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
     var_DelCallback(obj, "visual", VisualizationCallback, NULL);
     if (filters->clock)
         vlc_clock_Delete(filters->clock);
+    aout_BuffersDelete(filters->buffers);
     free (filters);
 }
 
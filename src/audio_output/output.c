@@ -156,6 +156,14 @@ static int aout_GainNotify (audio_output_t *aout, float gain)
     return 0;
 }
 
+static void aout_UnderrunNotify(audio_output_t *aout, unsigned count)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    atomic_fetch_add_explicit(&owner->stats.underruns, count,
+                              memory_order_relaxed);
+}
+
 static const struct vlc_audio_output_events aout_events = {
     aout_TimingNotify,
     aout_VolumeNotify,
@@ -165,6 +173,7 @@ static const struct vlc_audio_output_events aout_events = {
     aout_HotplugNotify,
     aout_RestartNotify,
     aout_GainNotify,
+    aout_UnderrunNotify,
 };
 
 static int FilterCallback (vlc_object_t *obj, const char *var,
@@ -202,11 +211,7 @@ static int ViewpointCallback (vlc_object_t *obj, const char *var,
     return VLC_SUCCESS;
 }
 
-#undef aout_New
-/**
- * Creates an audio output object and initializes an output module.
- */
-audio_output_t *aout_New (vlc_object_t *parent)
+static audio_output_t *aout_Create(vlc_object_t *parent, const char *sink)
 {
     vlc_value_t val;
 
@@ -223,14 +228,19 @@ audio_output_t *aout_New (vlc_object_t *parent)
     vlc_viewpoint_init (&owner->vp.value);
     atomic_init (&owner->vp.update, false);
     atomic_init(&owner->refs, 0);
+    owner->sink = sink != NULL;
+    owner->sinks.count = 0;
 
     /* Audio output module callbacks */
     var_Create (aout, "volume", VLC_VAR_FLOAT);
-    var_AddCallback (aout, "volume", var_Copy, parent);
     var_Create (aout, "mute", VLC_VAR_BOOL | VLC_VAR_DOINHERIT);
-    var_AddCallback (aout, "mute", var_Copy, parent);
     var_Create (aout, "device", VLC_VAR_STRING);
-    var_AddCallback (aout, "device", var_CopyDevice, parent);
+    if (!owner->sink)
+    {   /* The volume, mute and device of a sink stay its own */
+        var_AddCallback (aout, "volume", var_Copy, parent);
+        var_AddCallback (aout, "mute", var_Copy, parent);
+        var_AddCallback (aout, "device", var_CopyDevice, parent);
+    }
     /* TODO: 3.0 HACK: only way to signal DTS_HD to aout modules. */
     var_Create (aout, "dtshd", VLC_VAR_BOOL);
 
@@ -242,7 +252,10 @@ audio_output_t *aout_New (vlc_object_t *parent)
     aout->volume_set = NULL;
     aout->mute_set = NULL;
     aout->device_select = NULL;
-    owner->module = module_need_var(aout, "audio output", "aout");
+    if (owner->sink)
+        owner->module = module_need(aout, "audio output", sink, true);
+    else
+        owner->module = module_need_var(aout, "audio output", "aout");
     if (owner->module == NULL)
     {
         msg_Err (aout, "no suitable audio output module");
@@ -251,6 +264,20 @@ audio_output_t *aout_New (vlc_object_t *parent)
     }
     assert(aout->start && aout->stop);
 
+    if (owner->sink)
+    {   /* The parent output already filtered, amplified and visualized
+         * the samples: only convert and resample them. */
+        var_Create (aout, "audio-filter", VLC_VAR_STRING);
+        var_AddCallback (aout, "audio-filter", FilterCallback, NULL);
+        var_Create (aout, "audio-visual", VLC_VAR_STRING);
+        var_Create (aout, "audio-time-stretch", VLC_VAR_BOOL);
+        var_Create (aout, "audio-replay-gain-mode", VLC_VAR_STRING);
+        var_SetString (aout, "audio-replay-gain-mode", "none");
+        var_Create (aout, "viewpoint", VLC_VAR_ADDRESS);
+        var_AddCallback (aout, "viewpoint", ViewpointCallback, NULL);
+        goto stereo;
+    }
+
     /*
      * Persistent audio output variables
      */
@@ -326,6 +353,7 @@ audio_output_t *aout_New (vlc_object_t *parent)
                        val, vlc_gettext(cfg->list_text[i]));
         }
 
+stereo:
     /* Stereo mode */
     var_Create (aout, "stereo-mode", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     owner->requested_stereo_mode = var_GetInteger (aout, "stereo-mode");
@@ -343,6 +371,26 @@ audio_output_t *aout_New (vlc_object_t *parent)
     return aout;
 }
 
+#undef aout_New
+/**
+ * Creates an audio output object and initializes an output module.
+ */
+audio_output_t *aout_New (vlc_object_t *parent)
+{
+    return aout_Create(parent, NULL);
+}
+
+/**
+ * Creates an extra audio output, fed with the samples played by another one.
+ *
+ * \param aout the audio output playing the samples
+ * \param module name of the audio output module of the sink
+ */
+audio_output_t *aout_NewSink(audio_output_t *aout, const char *module)
+{
+    return aout_Create(VLC_OBJECT(aout), module);
+}
+
 audio_output_t *aout_Hold(audio_output_t *aout)
 {
     aout_owner_t *owner = aout_owner(aout);
@@ -368,10 +416,14 @@ void aout_Destroy (audio_output_t *aout)
 
     var_DelCallback (aout, "viewpoint", ViewpointCallback, NULL);
     var_DelCallback (aout, "audio-filter", FilterCallback, NULL);
-    var_DelCallback(aout, "device", var_CopyDevice, vlc_object_parent(aout));
-    var_DelCallback(aout, "mute", var_Copy, vlc_object_parent(aout));
-    var_SetFloat (aout, "volume", -1.f);
-    var_DelCallback(aout, "volume", var_Copy, vlc_object_parent(aout));
+    if (!owner->sink)
+    {
+        var_DelCallback(aout, "device", var_CopyDevice,
+                        vlc_object_parent(aout));
+        var_DelCallback(aout, "mute", var_Copy, vlc_object_parent(aout));
+        var_SetFloat (aout, "volume", -1.f);
+        var_DelCallback(aout, "volume", var_Copy, vlc_object_parent(aout));
+    }
     var_DelCallback (aout, "stereo-mode", StereoModeCallback, NULL);
     aout_Release(aout);
 }
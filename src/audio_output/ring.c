@@ -0,0 +1,198 @@
+/*****************************************************************************
+ * ring.c : lock-free audio output ring buffer
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+
+/*
+ * The producer (the audio output play() callback) only moves the head, and
+ * the consumer (the audio server callback) only moves the tail forward.
+ * Flushing moves the tail from the producer side: the consumer advances the
+ * tail with a compare-and-swap, and drops what it read if a flush happened
+ * meanwhile. Positions are counted in frames and never wrap in practice.
+ */
+struct aout_ring
+{
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_uint underruns;
+    size_t peek; /* tail seen by the last aout_RingPeek() */
+    size_t frame_size;
+    size_t frames; /* power of two */
+    bool locked;
+    uint8_t *buf;
+};
+
+aout_ring_t *aout_RingNew(size_t frame_size, size_t frames)
+{
+    assert(frame_size > 0 && frames > 0);
+
+    aout_ring_t *ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    size_t n = 1;
+    while (n < frames)
+        n <<= 1;
+
+    ring->buf = malloc(n * frame_size);
+    if (unlikely(ring->buf == NULL))
+    {
+        free(ring);
+        return NULL;
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->underruns, 0);
+    ring->peek = 0;
+    ring->frame_size = frame_size;
+    ring->frames = n;
+    ring->locked = false;
+#ifdef HAVE_MMAP
+    /* Avoid page faults in the real-time thread, if allowed */
+    ring->locked = mlock(ring->buf, n * frame_size) == 0;
+#endif
+    return ring;
+}
+
+void aout_RingDelete(aout_ring_t *ring)
+{
+#ifdef HAVE_MMAP
+    if (ring->locked)
+        munlock(ring->buf, ring->frames * ring->frame_size);
+#endif
+    free(ring->buf);
+    free(ring);
+}
+
+size_t aout_RingWrite(aout_ring_t *ring, const void *buf, size_t frames)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t space = ring->frames - (head - tail);
+
+    if (frames > space)
+        frames = space;
+
+    size_t offset = head & (ring->frames - 1);
+    size_t first = __MIN(frames, ring->frames - offset);
+
+    memcpy(ring->buf + offset * ring->frame_size, buf,
+           first * ring->frame_size);
+    memcpy(ring->buf, (const uint8_t *)buf + first * ring->frame_size,
+           (frames - first) * ring->frame_size);
+
+    atomic_store_explicit(&ring->head, head + frames, memory_order_release);
+    return frames;
+}
+
+void aout_RingFlush(aout_ring_t *ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+}
+
+size_t aout_RingPeek(aout_ring_t *ring, const void **bufp, size_t frames)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t offset = tail & (ring->frames - 1);
+
+    if (frames > head - tail)
+        frames = head - tail;
+    if (frames > ring->frames - offset)
+        frames = ring->frames - offset;
+
+    ring->peek = tail;
+    *bufp = ring->buf + offset * ring->frame_size;
+    return frames;
+}
+
+bool aout_RingConsume(aout_ring_t *ring, const void *buf, size_t frames)
+{
+    size_t tail = ring->peek;
+
+    assert(buf == ring->buf + (tail & (ring->frames - 1)) * ring->frame_size);
+    (void) buf;
+    /* The tail moved since aout_RingPeek() if the ring was flushed */
+    return atomic_compare_exchange_strong_explicit(&ring->tail, &tail,
+                                                   tail + frames,
+                                                   memory_order_release,
+                                                   memory_order_relaxed);
+}
+
+size_t aout_RingRead(aout_ring_t *ring, void *buf, size_t frames)
+{
+    uint8_t *dst = buf;
+    size_t done = 0;
+
+    while (done < frames)
+    {
+        const void *src;
+        size_t n = aout_RingPeek(ring, &src, frames - done);
+
+        if (n == 0)
+            break;
+
+        memcpy(dst + done * ring->frame_size, src, n * ring->frame_size);
+        if (!aout_RingConsume(ring, src, n))
+        {   /* Flushed while copying: drop the stale samples */
+            done = 0;
+            continue;
+        }
+        done += n;
+    }
+
+    if (done < frames)
+    {
+        memset(dst + done * ring->frame_size, 0,
+               (frames - done) * ring->frame_size);
+        atomic_fetch_add_explicit(&ring->underruns, 1, memory_order_relaxed);
+    }
+    return done;
+}
+
+size_t aout_RingCount(aout_ring_t *ring)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return head - tail;
+}
+
+unsigned aout_RingGetUnderruns(aout_ring_t *ring)
+{
+    return atomic_exchange_explicit(&ring->underruns, 0,
+                                    memory_order_relaxed);
+}
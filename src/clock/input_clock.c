@@ -101,6 +101,10 @@
 /* */
 #define INPUT_CLOCK_LATE_COUNT (3)
 
+/* Number of clock references over which the peak lateness of the clock
+ * references decays (about 10s at 25 references per second). */
+#define INPUT_CLOCK_JITTER_DECAY (256)
+
 /* */
 struct input_clock_t
 {
@@ -128,6 +132,14 @@ struct input_clock_t
         unsigned i_index;
     } late;
 
+    /* Arrival jitter statistics */
+    struct
+    {
+        vlc_tick_t i_last_transit;
+        vlc_tick_t i_mean;
+        vlc_tick_t i_peak;
+    } jitter;
+
     /* Reference point */
     clock_point_t ref;
     bool          b_has_reference;
@@ -175,6 +187,10 @@ input_clock_t *input_clock_New( float rate )
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
         cl->late.pi_value[i] = 0;
 
+    cl->jitter.i_last_transit = 0;
+    cl->jitter.i_mean = 0;
+    cl->jitter.i_peak = 0;
+
     cl->rate = rate;
     cl->i_pts_delay = 0;
     cl->b_paused = false;
@@ -234,6 +250,8 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     {
         cl->i_next_drift_update = VLC_TICK_INVALID;
         AvgReset( &cl->drift );
+        cl->jitter.i_mean = 0;
+        cl->jitter.i_peak = 0;
 
         /* Feed synchro with a new reference point. */
         cl->b_has_reference = true;
@@ -253,6 +271,22 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
         cl->i_next_drift_update = i_ck_system + VLC_TICK_FROM_MS(200); /* FIXME why that */
     }
 
+    /* Measure the arrival jitter of the clock references when we don't
+     * control the source pace: the mean deviation of their transit time
+     * (as the interarrival jitter of RFC 3550) */
+    if( !b_can_pace_control )
+    {
+        const vlc_tick_t i_transit = i_ck_system - ClockStreamToSystem( cl, i_ck_stream );
+
+        if( !b_reset_reference )
+        {
+            const vlc_tick_t i_deviation = i_transit - cl->jitter.i_last_transit;
+
+            cl->jitter.i_mean += ( llabs( i_deviation ) - cl->jitter.i_mean ) / 16;
+        }
+        cl->jitter.i_last_transit = i_transit;
+    }
+
     /* Update the extra buffering value */
     if( !b_can_pace_control || b_reset_reference )
     {
@@ -284,6 +318,18 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
         cl->late.i_index = ( cl->late.i_index + 1 ) % INPUT_CLOCK_LATE_COUNT;
     }
 
+    /* Keep the peak lateness of the clock references against the filtered
+     * clock, decaying slowly toward the current one */
+    if( !b_can_pace_control )
+    {
+        const vlc_tick_t i_lateness = __MAX( i_ck_system - i_system_expected, 0 );
+
+        if( i_lateness > cl->jitter.i_peak )
+            cl->jitter.i_peak = i_lateness;
+        else
+            cl->jitter.i_peak -= ( cl->jitter.i_peak - i_lateness ) / INPUT_CLOCK_JITTER_DECAY;
+    }
+
     vlc_mutex_unlock( &cl->lock );
 
     return i_late > 0 ? i_late : 0;
@@ -497,13 +543,9 @@ void input_clock_GetSystemOrigin( input_clock_t *cl, vlc_tick_t *pi_system, vlc_
     vlc_mutex_unlock( &cl->lock );
 }
 
-#warning "input_clock_SetJitter needs more work"
-void input_clock_SetJitter( input_clock_t *cl,
-                            vlc_tick_t i_pts_delay, int i_cr_average )
+/* Updates the late observations after a change of pts_delay */
+static void ClockShiftLate( input_clock_t *cl, vlc_tick_t i_pts_delay )
 {
-    vlc_mutex_lock( &cl->lock );
-
-    /* Update late observations */
     const vlc_tick_t i_delay_delta = i_pts_delay - cl->i_pts_delay;
     vlc_tick_t pi_late[INPUT_CLOCK_LATE_COUNT];
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
@@ -520,6 +562,15 @@ void input_clock_SetJitter( input_clock_t *cl,
         cl->late.pi_value[cl->late.i_index] = pi_late[i];
         cl->late.i_index = ( cl->late.i_index + 1 ) % INPUT_CLOCK_LATE_COUNT;
     }
+}
+
+#warning "input_clock_SetJitter needs more work"
+void input_clock_SetJitter( input_clock_t *cl,
+                            vlc_tick_t i_pts_delay, int i_cr_average )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    ClockShiftLate( cl, i_pts_delay );
 
     /* TODO always save the value, and when rebuffering use the new one if smaller
      * TODO when increasing -> force rebuffering
@@ -559,6 +610,38 @@ vlc_tick_t input_clock_GetJitter( input_clock_t *cl )
     return i_pts_delay + i_late_median;
 }
 
+void input_clock_ReduceJitter( input_clock_t *cl, vlc_tick_t i_pts_delay )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    if( i_pts_delay < cl->i_pts_delay )
+    {
+        ClockShiftLate( cl, i_pts_delay );
+        cl->i_pts_delay = i_pts_delay;
+    }
+
+    vlc_mutex_unlock( &cl->lock );
+}
+
+int input_clock_GetStats( input_clock_t *cl, struct input_clock_stats *stats )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    if( !cl->b_has_reference )
+    {
+        vlc_mutex_unlock( &cl->lock );
+        return VLC_EGENERIC;
+    }
+
+    stats->drift = AvgGet( &cl->drift );
+    stats->jitter = cl->jitter.i_mean;
+    stats->jitter_peak = cl->jitter.i_peak;
+
+    vlc_mutex_unlock( &cl->lock );
+
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * ClockStreamToSystem: converts a movie clock to system date
  *****************************************************************************/
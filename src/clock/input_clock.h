@@ -135,4 +135,28 @@ void input_clock_SetJitter( input_clock_t *,
  */
 vlc_tick_t input_clock_GetJitter( input_clock_t * );
 
+/**
+ * This function decreases the pts_delay, unlike input_clock_SetJitter().
+ *
+ * The rendering dates move earlier by the difference: it should be changed
+ * in small steps to avoid late frames.
+ */
+void input_clock_ReduceJitter( input_clock_t *, vlc_tick_t i_pts_delay );
+
+/**
+ * Clock statistics, measured when the source pace is not controlled.
+ */
+struct input_clock_stats
+{
+    vlc_tick_t drift; /**< filtered offset of the stream clock */
+    vlc_tick_t jitter; /**< mean arrival jitter of the clock references */
+    vlc_tick_t jitter_peak; /**< decaying peak lateness of the references */
+};
+
+/**
+ * This function returns the clock statistics or VLC_EGENERIC if there is not
+ * a reference point.
+ */
+int input_clock_GetStats( input_clock_t *, struct input_clock_stats * );
+
 #endif
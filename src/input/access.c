@@ -329,7 +329,17 @@ stream_t *stream_AccessNew(vlc_object_t *parent, input_thread_t *input,
         s->pf_control = AStreamControl;
         s->p_sys = access;
 
-        s = stream_FilterChainNew(s, "prefetch,cache");
+        /* Keep remote files on disk across sessions, if enabled */
+        stream_t *cache = vlc_stream_FilterNew(s, "diskcache");
+        if (cache != NULL)
+            s = cache;
+
+        bool mapped = false;
+
+        /* Mapped blocks can be peeked directly: caching would copy them. */
+        if (vlc_stream_Control(access, STREAM_IS_MAPPED, &mapped)
+         || !mapped)
+            s = stream_FilterChainNew(s, "prefetch,cache");
     }
     else
         s = access;
@@ -42,6 +42,7 @@
 #include <vlc_dialog.h>
 #include <vlc_modules.h>
 #include <vlc_decoder.h>
+#include <vlc_tracer.h>
 #include <vlc_picture_pool.h>
 
 #include "audio_output/aout_internal.h"
@@ -67,6 +68,7 @@ struct decoder_owner
     decoder_t        dec;
     input_resource_t*p_resource;
     vlc_clock_t     *p_clock;
+    struct vlc_tracer *tracer;
 
     const struct input_decoder_callbacks *cbs;
     void *cbs_userdata;
@@ -92,6 +94,9 @@ struct decoder_owner
     vlc_meta_t     *p_description;
     atomic_int     reload;
 
+    /* Decode call durations, see INPUT_STATS_PACING_BUCKETS */
+    atomic_uint    decode[INPUT_STATS_PACING_BUCKETS];
+
     /* fifo */
     block_fifo_t *p_fifo;
 
@@ -130,6 +135,14 @@ struct decoder_owner
     enum vlc_vout_order vout_order;
     bool            vout_thread_started;
 
+    /* Gapless trimming (ModuleThread and DecoderThread only) */
+    struct
+    {
+        audio_gapless_t info;
+        uint64_t i_position; /* decoded samples since the stream start */
+        bool b_active; /* false once the position is lost (seek) */
+    } gapless;
+
     /* -- Theses variables need locking on read *and* write -- */
     /* Preroll */
     vlc_tick_t i_preroll_end;
@@ -137,6 +150,14 @@ struct decoder_owner
 #define PREROLL_NONE    INT64_MIN // vlc_tick_t
 #define PREROLL_FORCED  INT64_MAX // vlc_tick_t
 
+    /* Frame skipping, driven by the lateness of the displayed pictures */
+    struct
+    {
+        vlc_tick_t lateness;   /* smoothed, negative when in advance */
+        unsigned   stable;     /* pictures since the last level change */
+        atomic_int level;      /* enum vlc_decoder_skip */
+    } skip;
+
     /* Pause & Rate */
     bool reset_out_state;
     vlc_tick_t pause_date;
@@ -785,6 +806,13 @@ static vlc_tick_t ModuleThread_GetDisplayDate( decoder_t *p_dec,
     return vlc_clock_ConvertToSystem( p_owner->p_clock, system_now, i_ts, rate );
 }
 
+static int ModuleThread_GetSkipLevel( decoder_t *p_dec )
+{
+    struct decoder_owner *p_owner = dec_get_owner( p_dec );
+
+    return atomic_load_explicit( &p_owner->skip.level, memory_order_relaxed );
+}
+
 static float ModuleThread_GetDisplayRate( decoder_t *p_dec )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
@@ -1048,6 +1076,54 @@ static void ModuleThread_QueueCc( decoder_t *p_videodec, block_t *p_cc,
     }
 }
 
+/* Lateness above which, and below which, the skip level is raised and
+ * lowered; the gap avoids oscillating between two levels */
+#define DECODER_SKIP_RAISE_LATENESS VLC_TICK_FROM_MS(40)
+#define DECODER_SKIP_LOWER_LATENESS VLC_TICK_FROM_MS(-20)
+/* Pictures to wait for after a change, so that it has an effect on the
+ * lateness before the next one; lowering is slower than raising */
+#define DECODER_SKIP_RAISE_DELAY 8
+#define DECODER_SKIP_LOWER_DELAY 64
+
+static void ModuleThread_ResetSkip( struct decoder_owner *p_owner )
+{
+    p_owner->skip.lateness = 0;
+    p_owner->skip.stable = 0;
+    atomic_store_explicit( &p_owner->skip.level, VLC_DECODER_SKIP_NONE,
+                           memory_order_relaxed );
+}
+
+static void ModuleThread_UpdateSkip( struct decoder_owner *p_owner,
+                                     vlc_tick_t system_now,
+                                     vlc_tick_t display_date )
+{
+    const int old = atomic_load_explicit( &p_owner->skip.level,
+                                          memory_order_relaxed );
+    int level = old;
+
+    /* Exponential moving average over about 8 pictures */
+    p_owner->skip.lateness += (system_now - display_date
+                               - p_owner->skip.lateness) / 8;
+    p_owner->skip.stable++;
+
+    if( p_owner->skip.lateness > DECODER_SKIP_RAISE_LATENESS
+     && p_owner->skip.stable >= DECODER_SKIP_RAISE_DELAY
+     && level < VLC_DECODER_SKIP_NONKEY )
+        level++;
+    else if( p_owner->skip.lateness < DECODER_SKIP_LOWER_LATENESS
+          && p_owner->skip.stable >= DECODER_SKIP_LOWER_DELAY
+          && level > VLC_DECODER_SKIP_NONE )
+        level--;
+    else
+        return;
+
+    msg_Dbg( &p_owner->dec, "%s frame skipping to level %d (%"PRId64" us late)",
+             level > old ? "raising" : "lowering", level,
+             p_owner->skip.lateness );
+    p_owner->skip.stable = 0;
+    atomic_store_explicit( &p_owner->skip.level, level, memory_order_relaxed );
+}
+
 static int ModuleThread_PlayVideo( struct decoder_owner *p_owner, picture_t *p_picture )
 {
     decoder_t *p_dec = &p_owner->dec;
@@ -1072,9 +1148,21 @@ static int ModuleThread_PlayVideo( struct decoder_owner *p_owner, picture_t *p_p
 
     p_owner->i_preroll_end = PREROLL_NONE;
 
+    if( p_dec->b_frame_drop_allowed && p_owner->p_clock != NULL
+     && !p_owner->b_waiting && !p_owner->paused && !prerolled )
+    {
+        vlc_tick_t now = vlc_tick_now();
+        ModuleThread_UpdateSkip( p_owner, now,
+                                 vlc_clock_ConvertToSystem( p_owner->p_clock,
+                                                            now,
+                                                            p_picture->date,
+                                                            p_owner->output_rate ) );
+    }
+
     if( unlikely(prerolled) )
     {
         msg_Dbg( p_dec, "end of video preroll" );
+        ModuleThread_ResetSkip( p_owner );
 
         if( p_vout )
             vout_FlushAll( p_vout );
@@ -1122,18 +1210,31 @@ static int ModuleThread_PlayVideo( struct decoder_owner *p_owner, picture_t *p_p
     return VLC_SUCCESS;
 }
 
+static void DecoderGetResetDecodeStats( struct decoder_owner *p_owner,
+                                        input_decoder_stats_t *stats )
+{
+    for( unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++ )
+        stats->i_decode[i] = atomic_exchange_explicit( &p_owner->decode[i], 0,
+                                                       memory_order_relaxed );
+}
+
 static void ModuleThread_UpdateStatVideo( struct decoder_owner *p_owner,
                                           bool lost )
 {
     unsigned displayed = 0;
     unsigned vout_lost = 0;
+    input_pacing_stats_t pacing = { 0 };
+    input_decoder_stats_t dec_stats = { 0 };
     if( p_owner->p_vout != NULL )
     {
-        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost );
+        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost,
+                                &pacing );
     }
     if (lost) vout_lost++;
+    DecoderGetResetDecodeStats( p_owner, &dec_stats );
 
-    decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed);
+    decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed,
+                   &pacing, &dec_stats);
 }
 
 static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
@@ -1141,6 +1242,8 @@ static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
     assert( p_pic );
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+    vlc_tracer_Instant( p_owner->tracer, "decoder", "picture", p_dec,
+                        p_pic->date );
     int success = ModuleThread_PlayVideo( p_owner, p_pic );
 
     ModuleThread_UpdateStatVideo( p_owner, success != VLC_SUCCESS );
@@ -1262,19 +1365,78 @@ static void ModuleThread_UpdateStatAudio( struct decoder_owner *p_owner,
 {
     unsigned played = 0;
     unsigned aout_lost = 0;
+    input_aout_stats_t aout_stats = { 0 };
+    input_decoder_stats_t dec_stats = { 0 };
     if( p_owner->p_aout != NULL )
     {
-        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played );
+        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played,
+                               &aout_stats );
     }
     if (lost) aout_lost++;
+    DecoderGetResetDecodeStats( p_owner, &dec_stats );
 
-    decoder_Notify(p_owner, on_new_audio_stats, 1, aout_lost, played);
+    decoder_Notify(p_owner, on_new_audio_stats, 1, aout_lost, played,
+                   &aout_stats, &dec_stats);
+}
+
+/**
+ * Trims the encoder priming and padding samples off a decoded block.
+ * \return the trimmed block, or NULL if nothing is left
+ */
+static block_t *ModuleThread_TrimGapless( struct decoder_owner *p_owner,
+                                          block_t *p_audio )
+{
+    const audio_format_t *p_fmt = &p_owner->fmt.audio;
+
+    if( p_fmt->i_frame_length != 1 || p_fmt->i_bytes_per_frame == 0 )
+    {   /* Not linear PCM: samples cannot be trimmed */
+        p_owner->gapless.b_active = false;
+        return p_audio;
+    }
+
+    const uint64_t i_start = p_owner->gapless.i_position;
+    const uint64_t i_count = p_audio->i_nb_samples;
+    const uint64_t i_begin = p_owner->gapless.info.i_delay;
+    const uint64_t i_end = p_owner->gapless.info.i_samples > 0
+                         ? i_begin + p_owner->gapless.info.i_samples
+                         : UINT64_MAX;
+
+    p_owner->gapless.i_position += i_count;
+
+    uint64_t i_head = i_begin > i_start ? __MIN(i_begin - i_start, i_count)
+                                        : 0;
+    uint64_t i_tail = i_end > i_start ? __MIN(i_end - i_start, i_count) : 0;
+    if( i_tail <= i_head )
+    {
+        block_Release( p_audio );
+        return NULL;
+    }
+    if( i_head == 0 && i_tail == i_count )
+        return p_audio;
+
+    p_audio->p_buffer += i_head * p_fmt->i_bytes_per_frame;
+    p_audio->i_buffer = (i_tail - i_head) * p_fmt->i_bytes_per_frame;
+    p_audio->i_pts += vlc_tick_from_samples( i_head, p_fmt->i_rate );
+    p_audio->i_dts = p_audio->i_pts;
+    p_audio->i_nb_samples = i_tail - i_head;
+    p_audio->i_length = vlc_tick_from_samples( p_audio->i_nb_samples,
+                                               p_fmt->i_rate );
+    return p_audio;
 }
 
 static void ModuleThread_QueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+    if( p_owner->gapless.b_active )
+    {
+        p_aout_buf = ModuleThread_TrimGapless( p_owner, p_aout_buf );
+        if( p_aout_buf == NULL )
+            return;
+    }
+
+    vlc_tracer_Instant( p_owner->tracer, "decoder", "audio", p_dec,
+                        p_aout_buf->i_pts );
     int success = ModuleThread_PlayAudio( p_owner, p_aout_buf );
 
     ModuleThread_UpdateStatAudio( p_owner, success != VLC_SUCCESS );
@@ -1342,8 +1504,19 @@ static void DecoderThread_ProcessInput( struct decoder_owner *p_owner, block_t *
 static void DecoderThread_DecodeBlock( struct decoder_owner *p_owner, block_t *p_block )
 {
     decoder_t *p_dec = &p_owner->dec;
+    vlc_tick_t pts = VLC_TICK_INVALID;
+
+    if( p_block != NULL )
+        pts = p_block->i_pts != VLC_TICK_INVALID ? p_block->i_pts
+                                                 : p_block->i_dts;
 
+    vlc_tracer_Begin( p_owner->tracer, "decoder", "decode", p_dec, pts );
+    vlc_tick_t start = vlc_tick_now();
     int ret = p_dec->pf_decode( p_dec, p_block );
+    /* draining is not a per frame cost */
+    if( p_block != NULL )
+        vout_statistic_AddPacing( p_owner->decode, vlc_tick_now() - start );
+    vlc_tracer_End( p_owner->tracer, "decoder", "decode", p_dec, pts );
     switch( ret )
     {
         case VLCDEC_SUCCESS:
@@ -1487,6 +1660,11 @@ static void DecoderThread_Flush( struct decoder_owner *p_owner )
     if ( p_dec->pf_flush != NULL )
         p_dec->pf_flush( p_dec );
 
+    if( p_dec->fmt_out.i_cat == VIDEO_ES )
+        ModuleThread_ResetSkip( p_owner );
+    /* The position in the stream is not known anymore */
+    p_owner->gapless.b_active = false;
+
     /* flush CC sub decoders */
     if( p_owner->cc.b_supported )
     {
@@ -1765,6 +1943,7 @@ static const struct decoder_owner_callbacks dec_video_cbs =
         .queue_cc = ModuleThread_QueueCc,
         .get_display_date = ModuleThread_GetDisplayDate,
         .get_display_rate = ModuleThread_GetDisplayRate,
+        .get_skip_level = ModuleThread_GetSkipLevel,
     },
     .get_attachments = InputThread_GetInputAttachments,
 };
@@ -1821,7 +2000,11 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
 
     p_owner->p_clock = p_clock;
     p_owner->i_preroll_end = PREROLL_NONE;
+    p_owner->skip.lateness = 0;
+    p_owner->skip.stable = 0;
+    atomic_init( &p_owner->skip.level, VLC_DECODER_SKIP_NONE );
     p_owner->p_resource = p_resource;
+    p_owner->tracer = vlc_object_get_tracer( p_parent );
     p_owner->cbs = cbs;
     p_owner->cbs_userdata = cbs_userdata;
     p_owner->p_aout = NULL;
@@ -1853,11 +2036,21 @@ static struct decoder_owner * CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_draining = false;
     p_owner->drained = false;
     atomic_init( &p_owner->reload, RELOAD_NO_REQUEST );
+    for( unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++ )
+        atomic_init( &p_owner->decode[i], 0 );
     p_owner->b_idle = false;
 
     p_owner->mouse_event = NULL;
     p_owner->mouse_opaque = NULL;
 
+    if( fmt->i_cat == AUDIO_ES )
+        p_owner->gapless.info = fmt->audio_gapless;
+    else
+        p_owner->gapless.info = (audio_gapless_t) { 0, 0 };
+    p_owner->gapless.i_position = 0;
+    p_owner->gapless.b_active = p_owner->gapless.info.i_delay > 0
+                             || p_owner->gapless.info.i_samples > 0;
+
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
     /* decoder fifo */
@@ -2219,6 +2412,9 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
 {
     struct decoder_owner *p_owner = dec_get_owner( p_dec );
 
+    vlc_tracer_Instant( p_owner->tracer, "decoder", "queue", p_dec,
+                        p_block->i_pts != VLC_TICK_INVALID ? p_block->i_pts
+                                                           : p_block->i_dts );
     vlc_fifo_Lock( p_owner->p_fifo );
     if( !b_do_pace )
     {
@@ -2588,6 +2784,17 @@ size_t input_DecoderGetFifoSize( decoder_t *p_dec )
     return block_FifoSize( p_owner->p_fifo );
 }
 
+void input_DecoderGetFifoLevel( decoder_t *p_dec, size_t *count,
+                                size_t *bytes )
+{
+    struct decoder_owner *p_owner = dec_get_owner( p_dec );
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    *count = vlc_fifo_GetCount( p_owner->p_fifo );
+    *bytes = vlc_fifo_GetBytes( p_owner->p_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+}
+
 void input_DecoderSetVoutMouseEvent( decoder_t *dec, vlc_mouse_event mouse_event,
                                     void *user_data )
 {
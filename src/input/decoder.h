@@ -26,6 +26,7 @@
 
 #include <vlc_common.h>
 #include <vlc_codec.h>
+#include <vlc_input_item.h>
 #include <vlc_mouse.h>
 
 struct input_decoder_callbacks {
@@ -40,9 +41,14 @@ struct input_decoder_callbacks {
 
     void (*on_new_video_stats)(decoder_t *decoder, unsigned decoded,
                                unsigned lost, unsigned displayed,
+                               const input_pacing_stats_t *pacing,
+                               const input_decoder_stats_t *dec_stats,
                                void *userdata);
     void (*on_new_audio_stats)(decoder_t *decoder, unsigned decoded,
-                               unsigned lost, unsigned played, void *userdata);
+                               unsigned lost, unsigned played,
+                               const input_aout_stats_t *aout_stats,
+                               const input_decoder_stats_t *dec_stats,
+                               void *userdata);
 
     /* requests */
     int (*get_attachments)(decoder_t *decoder,
@@ -134,6 +140,13 @@ bool input_DecoderHasFormatChanged( decoder_t *p_dec, es_format_t *p_fmt, vlc_me
  */
 size_t input_DecoderGetFifoSize( decoder_t *p_dec );
 
+/**
+ * This function returns the current number of blocks and bytes waiting in
+ * the decoder fifo
+ */
+void input_DecoderGetFifoLevel( decoder_t *p_dec, size_t *count,
+                                size_t *bytes );
+
 void input_DecoderSetVoutMouseEvent( decoder_t *, vlc_mouse_event, void * );
 int  input_DecoderAddVoutOverlay( decoder_t *, subpicture_t *, size_t * );
 int  input_DecoderDelVoutOverlay( decoder_t *, size_t );
@@ -26,8 +26,11 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
 #include <vlc_codec.h>
+#include <vlc_cpu.h>
 #include <vlc_atomic.h>
 #include <vlc_meta.h>
 #include <vlc_modules.h>
@@ -76,6 +79,62 @@ void decoder_Destroy( decoder_t *p_dec )
     }
 }
 
+/* Threads budget shared by all the decoders of the process */
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned used;     /* threads reserved by the running decoders */
+    unsigned weights;  /* sum of the priorities of the running decoders */
+} dec_threads = { VLC_STATIC_MUTEX, 0, 0 };
+
+static unsigned decoder_GetThreadsBudget( decoder_t *dec )
+{
+    int budget = var_InheritInteger( dec, "dec-threads" );
+    if( budget <= 0 )
+        budget = vlc_GetCPUCount() + 1;
+    return budget;
+}
+
+static unsigned decoder_GetThreadsPriority( decoder_t *dec )
+{
+    return VLC_CLIP( var_InheritInteger( dec, "dec-threads-priority" ), 1, 16 );
+}
+
+unsigned decoder_AcquireThreads( decoder_t *dec, unsigned wanted )
+{
+    const unsigned budget = decoder_GetThreadsBudget( dec );
+    const unsigned priority = decoder_GetThreadsPriority( dec );
+
+    vlc_mutex_lock( &dec_threads.lock );
+    /* Fair share of the budget, and what is left of it */
+    unsigned count = budget * priority / (dec_threads.weights + priority);
+    if( dec_threads.used < budget )
+        count = __MIN( count, budget - dec_threads.used );
+    else
+        count = 0;
+    count = VLC_CLIP( count, 1, __MAX( wanted, 1 ) );
+
+    dec_threads.used += count;
+    dec_threads.weights += priority;
+    vlc_mutex_unlock( &dec_threads.lock );
+
+    msg_Dbg( dec, "reserved %u of %u wanted thread(s), %u/%u in use",
+             count, wanted, dec_threads.used, budget );
+    return count;
+}
+
+void decoder_ReleaseThreads( decoder_t *dec, unsigned count )
+{
+    const unsigned priority = decoder_GetThreadsPriority( dec );
+
+    vlc_mutex_lock( &dec_threads.lock );
+    assert( dec_threads.used >= count );
+    dec_threads.used -= count;
+    /* The priority of the input may have changed meanwhile */
+    dec_threads.weights -= __MIN( dec_threads.weights, priority );
+    vlc_mutex_unlock( &dec_threads.lock );
+}
+
 int decoder_UpdateVideoFormat( decoder_t *dec )
 {
     return decoder_UpdateVideoOutput( dec, NULL );
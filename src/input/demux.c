@@ -291,6 +291,7 @@ int demux_vaControlHelper( stream_t *s,
     static_control_match(GET_PTS_DELAY);
     static_control_match(GET_META);
     static_control_match(GET_SIGNAL);
+    static_control_match(GET_NETWORK);
     static_control_match(SET_PAUSE_STATE);
 
     switch( i_query )
@@ -310,6 +311,7 @@ int demux_vaControlHelper( stream_t *s,
         case DEMUX_GET_PTS_DELAY:
         case DEMUX_GET_META:
         case DEMUX_GET_SIGNAL:
+        case DEMUX_GET_NETWORK:
         case DEMUX_SET_PAUSE_STATE:
             return vlc_stream_vaControl( s, i_query, args );
 
@@ -395,6 +397,8 @@ int demux_vaControlHelper( stream_t *s,
         case DEMUX_NAV_MENU:
         case DEMUX_FILTER_ENABLE:
         case DEMUX_FILTER_DISABLE:
+        case DEMUX_GET_TS_STATS:
+        case DEMUX_GET_KEYFRAME:
             return VLC_EGENERIC;
 
         case DEMUX_SET_TITLE:
@@ -56,6 +56,13 @@
 /* FIXME we should find a better way than including that */
 #include "../text/iso-639_def.h"
 
+/* Period of the adaptive dejitter updates */
+#define JITTER_UPDATE_PERIOD VLC_TICK_FROM_SEC(1)
+/* Margin over the target before the dejitter delay is decreased */
+#define JITTER_HYSTERESIS VLC_TICK_FROM_MS(10)
+/* Largest decrease of the dejitter delay per update */
+#define JITTER_DECREASE_STEP VLC_TICK_FROM_MS(10)
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -122,6 +129,16 @@ struct es_out_id_t
     decoder_t   *p_dec_record;
     vlc_clock_t *p_clock;
 
+    /* Last demuxed blocks while not recording, to start the record with */
+    block_t     *p_record_preroll;
+    block_t    **pp_record_preroll_last;
+    size_t      i_record_preroll_size;
+
+    /* Last demuxed blocks while not decoding, to switch to this track with */
+    block_t     *p_standby;
+    block_t    **pp_standby_last;
+    size_t      i_standby_size;
+
     /* Used by vlc_clock_cbs, need to be const during the lifetime of the clock */
     bool master;
 
@@ -199,6 +216,11 @@ typedef struct
     int         i_cr_average;
     float       rate;
 
+    /* Adaptive dejitter of the live sources */
+    bool        b_jitter_adaptive;
+    vlc_tick_t  i_jitter_min;
+    vlc_tick_t  i_jitter_next_update;
+
     /* */
     bool        b_paused;
     vlc_tick_t  i_pause_date;
@@ -214,6 +236,10 @@ typedef struct
 
     /* Record */
     sout_instance_t *p_sout_record;
+    vlc_tick_t      i_record_preroll;
+
+    /* Keep the unselected tracks ready to be switched to */
+    bool        b_track_standby;
 
     /* Used only to limit debugging output */
     int         i_prev_stream_level;
@@ -244,6 +270,7 @@ static void EsOutGlobalMeta( es_out_t *p_out, const vlc_meta_t *p_meta );
 static void EsOutMeta( es_out_t *p_out, const vlc_meta_t *p_meta, const vlc_meta_t *p_progmeta );
 static int EsOutEsUpdateFmt(es_out_t *out, es_out_id_t *es, const es_format_t *fmt);
 static int EsOutControlLocked( es_out_t *out, int i_query, ... );
+static void EsOutUpdateJitter( es_out_t *out, es_out_pgrm_t *p_pgrm );
 
 static char *LanguageGetName( const char *psz_code );
 static char *LanguageGetCode( const char *psz_lang );
@@ -336,7 +363,10 @@ decoder_on_thumbnail_ready(decoder_t *decoder, picture_t *pic, void *userdata)
 
 static void
 decoder_on_new_video_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
-                           unsigned displayed, void *userdata)
+                           unsigned displayed,
+                           const input_pacing_stats_t *pacing,
+                           const input_decoder_stats_t *dec_stats,
+                           void *userdata)
 {
     (void) decoder;
 
@@ -357,11 +387,27 @@ decoder_on_new_video_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
                               memory_order_relaxed);
     atomic_fetch_add_explicit(&stats->displayed_pictures, displayed,
                               memory_order_relaxed);
+
+    for (unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++)
+    {
+        atomic_fetch_add_explicit(&stats->pacing.late[i], pacing->i_late[i],
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->pacing.prepare[i],
+                                  pacing->i_prepare[i], memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->pacing.display[i],
+                                  pacing->i_display[i], memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->decode.video[i],
+                                  dec_stats->i_decode[i],
+                                  memory_order_relaxed);
+    }
 }
 
 static void
 decoder_on_new_audio_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
-                           unsigned played, void *userdata)
+                           unsigned played,
+                           const input_aout_stats_t *aout_stats,
+                           const input_decoder_stats_t *dec_stats,
+                           void *userdata)
 {
     (void) decoder;
 
@@ -382,6 +428,27 @@ decoder_on_new_audio_stats(decoder_t *decoder, unsigned decoded, unsigned lost,
                               memory_order_relaxed);
     atomic_fetch_add_explicit(&stats->played_abuffers, played,
                               memory_order_relaxed);
+
+    for (unsigned i = 0; i < INPUT_STATS_AOUT_BUCKETS; i++)
+    {
+        atomic_fetch_add_explicit(&stats->aout.latency[i],
+                                  aout_stats->i_latency[i],
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&stats->aout.drift[i],
+                                  aout_stats->i_drift[i],
+                                  memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&stats->aout.underruns, aout_stats->i_underruns,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->aout.resamplings,
+                              aout_stats->i_resamplings, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->aout.resampling_hz,
+                              aout_stats->i_resampling_hz,
+                              memory_order_relaxed);
+    for (unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++)
+        atomic_fetch_add_explicit(&stats->decode.audio[i],
+                                  dec_stats->i_decode[i],
+                                  memory_order_relaxed);
 }
 
 static int
@@ -516,11 +583,19 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, float rate )
 
     p_sys->i_pause_date = -1;
 
+    p_sys->b_jitter_adaptive = var_InheritBool( p_input, "clock-jitter-adaptive" );
+    p_sys->i_jitter_min =
+        VLC_TICK_FROM_MS( var_InheritInteger( p_input, "clock-jitter-min" ) );
+    p_sys->i_jitter_next_update = VLC_TICK_INVALID;
+
     p_sys->rate = rate;
 
     p_sys->b_buffering = true;
     p_sys->i_preroll_end = -1;
     p_sys->i_prev_stream_level = -1;
+    p_sys->i_record_preroll =
+        vlc_tick_from_sec( var_InheritInteger( p_input, "input-record-preroll" ) );
+    p_sys->b_track_standby = var_InheritBool( p_input, "input-track-standby" );
 
     return &p_sys->out;
 }
@@ -714,6 +789,31 @@ static bool EsOutDecodersIsEmpty( es_out_t *out )
     return true;
 }
 
+static void EsOutDecodersGetFifoLevels( es_out_t *out, input_stats_t *stats )
+{
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+    es_out_id_t *es;
+
+    foreach_es_then_es_slaves(es)
+    {
+        input_decoder_stats_t *dec_stats;
+        size_t count, bytes;
+
+        if( es->p_dec == NULL )
+            continue;
+        if( es->fmt.i_cat == VIDEO_ES )
+            dec_stats = &stats->video_decoder;
+        else if( es->fmt.i_cat == AUDIO_ES )
+            dec_stats = &stats->audio_decoder;
+        else
+            continue;
+
+        input_DecoderGetFifoLevel( es->p_dec, &count, &bytes );
+        dec_stats->i_fifo_blocks += count;
+        dec_stats->i_fifo_bytes += bytes;
+    }
+}
+
 static void EsOutSetEsDelay(es_out_t *out, es_out_id_t *es, vlc_tick_t delay)
 {
     es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
@@ -747,6 +847,147 @@ static void EsOutSetDelay( es_out_t *out, int i_cat, vlc_tick_t i_delay )
                        p_sys->i_pts_jitter, p_sys->i_cr_average);
 }
 
+/* Bounds the memory of a pre-roll, whatever its duration */
+#define RECORD_PREROLL_MAX_SIZE (64 * 1024 * 1024)
+
+static void EsOutRecordPrerollClear( es_out_id_t *es )
+{
+    if( es->p_record_preroll != NULL )
+        block_ChainRelease( es->p_record_preroll );
+    es->p_record_preroll = NULL;
+    es->pp_record_preroll_last = &es->p_record_preroll;
+    es->i_record_preroll_size = 0;
+}
+
+static vlc_tick_t EsOutRecordPrerollTick( const block_t *p_block )
+{
+    return p_block->i_dts != VLC_TICK_INVALID ? p_block->i_dts
+                                              : p_block->i_pts;
+}
+
+/* Drops the head blocks of a chain older than the duration, or over the
+ * size, from its last block */
+static void EsOutBlockChainTrim( block_t **pp_first, size_t *pi_size,
+                                 const block_t *p_last, vlc_tick_t i_duration,
+                                 size_t i_max_size )
+{
+    vlc_tick_t i_last = EsOutRecordPrerollTick( p_last );
+    while( *pp_first != p_last )
+    {
+        block_t *p_head = *pp_first;
+        vlc_tick_t i_head = EsOutRecordPrerollTick( p_head );
+
+        if( *pi_size <= i_max_size &&
+            ( i_head == VLC_TICK_INVALID || i_last == VLC_TICK_INVALID ||
+              i_last - i_head <= i_duration ) )
+            break;
+
+        *pp_first = p_head->p_next;
+        *pi_size -= p_head->i_buffer;
+        block_Release( p_head );
+    }
+}
+
+static void EsOutRecordPrerollAppend( es_out_sys_t *p_sys, es_out_id_t *es,
+                                      const block_t *p_block )
+{
+    block_t *p_dup = block_Duplicate( p_block );
+    if( unlikely(p_dup == NULL) )
+        return;
+
+    block_ChainLastAppend( &es->pp_record_preroll_last, p_dup );
+    es->i_record_preroll_size += p_dup->i_buffer;
+
+    /* Drop the blocks older than the pre-roll duration. The record stream
+     * output starts the files on a key frame anyway. */
+    EsOutBlockChainTrim( &es->p_record_preroll, &es->i_record_preroll_size,
+                         p_dup, p_sys->i_record_preroll,
+                         RECORD_PREROLL_MAX_SIZE );
+}
+
+/* Bounds the memory of the standby blocks of a track */
+#define TRACK_STANDBY_MAX_SIZE (4 * 1024 * 1024)
+
+static void EsOutStandbyClear( es_out_id_t *es )
+{
+    if( es->p_standby != NULL )
+        block_ChainRelease( es->p_standby );
+    es->p_standby = NULL;
+    es->pp_standby_last = &es->p_standby;
+    es->i_standby_size = 0;
+}
+
+static bool EsOutStandbyIsEnabled( es_out_sys_t *p_sys, const es_out_id_t *es )
+{
+    /* Video would need the blocks since the last key frame */
+    return p_sys->b_track_standby && p_sys->b_active && es->p_master == NULL
+        && es->p_pgrm == p_sys->p_pgrm
+        && ( es->fmt.i_cat == AUDIO_ES || es->fmt.i_cat == SPU_ES )
+        && es->fmt.i_priority >= ES_PRIORITY_SELECTABLE_MIN;
+}
+
+static void EsOutStandbyAppend( es_out_sys_t *p_sys, es_out_id_t *es,
+                                block_t *p_block )
+{
+    block_ChainLastAppend( &es->pp_standby_last, p_block );
+    es->i_standby_size += p_block->i_buffer;
+
+    /* What is buffered downstream of the demuxer is all that a new decoder
+     * would miss */
+    EsOutBlockChainTrim( &es->p_standby, &es->i_standby_size, p_block,
+                         p_sys->i_pts_delay + p_sys->i_pts_jitter,
+                         TRACK_STANDBY_MAX_SIZE );
+}
+
+/* Feeds the standby blocks to the new decoder of the track. The audio blocks
+ * already played by the previous track are only decoded (pre-rolled), so that
+ * the output resumes at the first sample not played yet. The subtitles are
+ * all sent, the ones still on screen get displayed right away. */
+static void EsOutStandbyResume( es_out_t *out, es_out_id_t *es )
+{
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+    input_thread_t *p_input = p_sys->p_input;
+    block_t *p_block = es->p_standby;
+
+    if( p_block == NULL )
+        return;
+    es->p_standby = NULL;
+    EsOutStandbyClear( es );
+
+    const vlc_tick_t i_now = vlc_tick_now();
+    bool b_late = es->fmt.i_cat == AUDIO_ES && !p_sys->b_buffering;
+    unsigned i_count = 0, i_late = 0;
+
+    while( p_block != NULL )
+    {
+        block_t *p_next = p_block->p_next;
+        p_block->p_next = NULL;
+
+        if( b_late )
+        {
+            vlc_tick_t i_ts = p_block->i_pts != VLC_TICK_INVALID
+                            ? p_block->i_pts : p_block->i_dts;
+            if( i_ts != VLC_TICK_INVALID &&
+                vlc_clock_ConvertToSystem( es->p_clock, i_now, i_ts,
+                                           p_sys->rate ) >= i_now )
+                b_late = false;
+            else
+            {
+                p_block->i_flags |= BLOCK_FLAG_PREROLL;
+                i_late++;
+            }
+        }
+
+        input_DecoderDecode( es->p_dec, p_block,
+                             input_priv(p_input)->b_out_pace_control );
+        i_count++;
+        p_block = p_next;
+    }
+
+    msg_Dbg( p_input, "ES 0x%x resumed from standby with %u blocks "
+             "(%u pre-rolled)", es->fmt.i_id, i_count, i_late );
+}
+
 static int EsOutSetRecord(  es_out_t *out, bool b_record )
 {
     es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
@@ -813,6 +1054,18 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
 
             if( p_es->p_dec_record && p_sys->b_buffering )
                 input_DecoderStartWait( p_es->p_dec_record );
+
+            /* Start with the pre-roll blocks, older than the queued ones */
+            for( block_t *p_block = p_es->p_record_preroll, *p_next;
+                 p_es->p_dec_record != NULL && p_block != NULL;
+                 p_block = p_next )
+            {
+                p_next = p_block->p_next;
+                p_block->p_next = NULL;
+                input_DecoderDecode( p_es->p_dec_record, p_block, false );
+                p_es->p_record_preroll = p_next;
+            }
+            EsOutRecordPrerollClear( p_es );
         }
     }
     else
@@ -895,10 +1148,16 @@ static void EsOutChangePosition( es_out_t *out, bool b_flush )
     input_SendEventCache( p_sys->p_input, 0.0 );
 
     foreach_es_then_es_slaves(p_es)
+    {
+        if( b_flush )
+            EsOutStandbyClear( p_es );
         if( p_es->p_dec != NULL )
         {
             if( b_flush )
+            {
                 input_DecoderFlush( p_es->p_dec );
+                EsOutRecordPrerollClear( p_es );
+            }
             if( !p_sys->b_buffering )
             {
                 input_DecoderStartWait( p_es->p_dec );
@@ -906,6 +1165,7 @@ static void EsOutChangePosition( es_out_t *out, bool b_flush )
                     input_DecoderStartWait( p_es->p_dec_record );
             }
         }
+    }
 
     es_out_pgrm_t *pgrm;
     vlc_list_foreach(pgrm, &p_sys->programs, node)
@@ -1269,7 +1529,10 @@ static void EsOutProgramSelect( es_out_t *out, es_out_pgrm_t *p_pgrm )
              && p_sys->i_mode != ES_OUT_MODE_ALL)
                 EsOutUnselectEs(out, es, true);
             if (es->p_pgrm == old)
+            {
+                EsOutStandbyClear( es );
                 EsOutSendEsEvent( out, es, VLC_INPUT_ES_DELETED );
+            }
         }
 
         p_sys->audio.p_main_es = NULL;
@@ -1954,6 +2217,12 @@ static es_out_id_t *EsOutAddSlaveLocked( es_out_t *out, const es_format_t *fmt,
     es->psz_title = EsGetTitle(es);
     es->p_dec = NULL;
     es->p_dec_record = NULL;
+    es->p_record_preroll = NULL;
+    es->pp_record_preroll_last = &es->p_record_preroll;
+    es->i_record_preroll_size = 0;
+    es->p_standby = NULL;
+    es->pp_standby_last = &es->p_standby;
+    es->i_standby_size = 0;
     es->p_clock = NULL;
     es->master = false;
     es->cc.type = 0;
@@ -2087,6 +2356,11 @@ static void EsOutCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     p_es->p_dec = dec;
 
     EsOutDecoderChangeDelay( out, p_es );
+
+    if( dec != NULL )
+        EsOutStandbyResume( out, p_es );
+    else
+        EsOutStandbyClear( p_es );
 }
 static void EsOutDestroyDecoder( es_out_t *out, es_out_id_t *p_es )
 {
@@ -2107,6 +2381,7 @@ static void EsOutDestroyDecoder( es_out_t *out, es_out_id_t *p_es )
         input_DecoderDelete( p_es->p_dec_record );
         p_es->p_dec_record = NULL;
     }
+    EsOutRecordPrerollClear( p_es );
 
     es_format_Clean( &p_es->fmt_out );
 }
@@ -2535,7 +2810,10 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
 
     if( !es->p_dec )
     {
-        block_Release( p_block );
+        if( EsOutStandbyIsEnabled( p_sys, es ) )
+            EsOutStandbyAppend( p_sys, es, p_block );
+        else
+            block_Release( p_block );
         vlc_mutex_unlock( &p_sys->lock );
         return VLC_SUCCESS;
     }
@@ -2566,6 +2844,8 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
             input_DecoderDecode( es->p_dec_record, p_dup,
                                  input_priv(p_input)->b_out_pace_control );
     }
+    else if( p_sys->i_record_preroll > 0 && es->p_master == NULL )
+        EsOutRecordPrerollAppend( p_sys, es, p_block );
     input_DecoderDecode( es->p_dec, p_block,
                          input_priv(p_input)->b_out_pace_control );
 
@@ -2638,6 +2918,7 @@ static void EsOutDelLocked( es_out_t *out, es_out_id_t *es )
     }
 
     EsTerminate(es);
+    EsOutStandbyClear( es );
 
     if( es->p_pgrm == p_sys->p_pgrm )
         EsOutSendEsEvent( out, es, VLC_INPUT_ES_DELETED );
@@ -2734,6 +3015,73 @@ static vlc_tick_t EsOutGetTracksDelay(es_out_t *out)
     return tracks_delay < 0 ? -tracks_delay : 0;
 }
 
+/**
+ * Updates the clock statistics and, if enabled, adapts the dejitter delay of
+ * a live source to the measured arrival jitter of its clock references.
+ *
+ * The delay grows at once to the target, but decreases by small steps, so
+ * that the rendering dates never jump backward.
+ */
+static void EsOutUpdateJitter( es_out_t *out, es_out_pgrm_t *p_pgrm )
+{
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+    const vlc_tick_t i_now = vlc_tick_now();
+
+    if( p_sys->i_jitter_next_update != VLC_TICK_INVALID &&
+        i_now < p_sys->i_jitter_next_update )
+        return;
+    p_sys->i_jitter_next_update = i_now + JITTER_UPDATE_PERIOD;
+
+    struct input_clock_stats clock_stats;
+    if( input_clock_GetStats( p_pgrm->p_input_clock, &clock_stats ) )
+        return;
+
+    struct input_stats *stats = input_priv(p_sys->p_input)->stats;
+    if( stats )
+    {
+        atomic_store_explicit( &stats->clock.drift, clock_stats.drift,
+                               memory_order_relaxed );
+        atomic_store_explicit( &stats->clock.jitter, clock_stats.jitter,
+                               memory_order_relaxed );
+        atomic_store_explicit( &stats->clock.dejitter, p_sys->i_pts_jitter,
+                               memory_order_relaxed );
+    }
+
+    if( !p_sys->b_jitter_adaptive )
+        return;
+
+    /* Cover the peak lateness, with a margin for the current jitter */
+    const vlc_tick_t i_jitter_max =
+            VLC_TICK_FROM_MS(var_InheritInteger( p_sys->p_input, "clock-jitter" ));
+    vlc_tick_t i_target = clock_stats.jitter_peak + 2 * clock_stats.jitter;
+    i_target = __MIN( __MAX( i_target, p_sys->i_jitter_min ), i_jitter_max );
+
+    if( i_target > p_sys->i_pts_jitter )
+    {
+        msg_Dbg( p_sys->p_input, "dejitter increased to %"PRId64" ms "
+                 "(jitter %"PRId64" ms, peak %"PRId64" ms)",
+                 MS_FROM_VLC_TICK(i_target),
+                 MS_FROM_VLC_TICK(clock_stats.jitter),
+                 MS_FROM_VLC_TICK(clock_stats.jitter_peak) );
+        EsOutControlLocked( out, ES_OUT_SET_JITTER, p_sys->i_pts_delay,
+                            i_target, p_sys->i_cr_average );
+    }
+    else if( i_target + JITTER_HYSTERESIS < p_sys->i_pts_jitter )
+    {
+        p_sys->i_pts_jitter = __MAX( i_target,
+                                     p_sys->i_pts_jitter - JITTER_DECREASE_STEP );
+
+        const vlc_tick_t i_pts_delay = p_sys->i_pts_delay + p_sys->i_pts_jitter
+                                     + p_sys->i_tracks_pts_delay;
+        es_out_pgrm_t *pgrm;
+        vlc_list_foreach(pgrm, &p_sys->programs, node)
+        {
+            input_clock_ReduceJitter( pgrm->p_input_clock, i_pts_delay );
+            vlc_clock_main_SetInputDejitter( pgrm->p_main_clock, i_pts_delay );
+        }
+    }
+}
+
 /**
  * Control query handler
  *
@@ -3113,6 +3461,9 @@ static int EsOutVaControlLocked( es_out_t *out, int i_query, va_list args )
                                     i_new_jitter,
                                     p_sys->i_cr_average );
             }
+            else if( !input_priv(p_sys->p_input)->b_can_pace_control &&
+                     !b_low_delay )
+                EsOutUpdateJitter( out, p_pgrm );
         }
         return VLC_SUCCESS;
     }
@@ -3283,6 +3634,10 @@ static int EsOutVaControlLocked( es_out_t *out, int i_query, va_list args )
         return VLC_SUCCESS;
     }
 
+    case ES_OUT_GET_DECODER_STATS:
+        EsOutDecodersGetFifoLevels( out, va_arg( args, input_stats_t * ) );
+        return VLC_SUCCESS;
+
     case ES_OUT_SET_ES_DELAY:
     {
         es_out_id_t *es = va_arg(args, es_out_id_t *);
@@ -91,7 +91,13 @@ enum es_out_query_private_e
     ES_OUT_SET_VBI_PAGE,                            /* arg1=unsigned res=can fail */
 
     /* Set VBI/Teletext menu transparent */
-    ES_OUT_SET_VBI_TRANSPARENCY                     /* arg1=bool res=can fail */
+    ES_OUT_SET_VBI_TRANSPARENCY,                    /* arg1=bool res=can fail */
+
+    /* Jump back within the timeshift window */
+    ES_OUT_JUMP_TIMESHIFT,                          /* arg1=vlc_tick_t i_offset (< 0) res=can fail */
+
+    /* Get the current fifo levels of the video and audio decoders */
+    ES_OUT_GET_DECODER_STATS,                       /* arg1=input_stats_t * res=cannot fail */
 };
 
 static inline void es_out_SetMode( es_out_t *p_out, int i_mode )
@@ -176,6 +182,10 @@ static inline void es_out_Eos( es_out_t *p_out )
     int i_ret = es_out_Control( p_out, ES_OUT_SET_EOS );
     assert( !i_ret );
 }
+static inline int es_out_JumpTimeshift( es_out_t *p_out, vlc_tick_t i_offset )
+{
+    return es_out_Control( p_out, ES_OUT_JUMP_TIMESHIFT, i_offset );
+}
 
 es_out_t  *input_EsOutNew( input_thread_t *, float rate );
 es_out_t  *input_EsOutTimeshiftNew( input_thread_t *, es_out_t *, float i_rate );
@@ -36,6 +36,10 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -82,7 +86,7 @@ typedef struct attribute_packed
 {
     es_out_id_t *p_es;
     block_t *p_block;
-    int     i_offset;  /* We do not use file > INT_MAX */
+    int64_t i_offset;  /* Offset in the file, or in the ring */
 } ts_cmd_send_t;
 
 typedef struct attribute_packed
@@ -160,11 +164,33 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+/* Circular backing store, shared by all the storages of a thread */
+typedef struct
+{
+    uint8_t  *p_base;   /* Mapped file */
+    size_t   i_size;    /* Size in bytes */
+    uint64_t i_write;   /* Total bytes written so far */
+} ts_ring_t;
+
+/* Block header as stored in the ring */
+typedef struct
+{
+    size_t     i_buffer;
+    uint32_t   i_flags;
+    unsigned   i_nb_samples;
+    vlc_tick_t i_pts;
+    vlc_tick_t i_dts;
+    vlc_tick_t i_length;
+} ts_ring_block_t;
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
     ts_storage_t *p_next;
 
+    /* Block data are written to the ring if any, to the files otherwise */
+    ts_ring_t *p_ring;
+
     /* */
 #ifdef _WIN32
     char    *psz_file;  /* Filename */
@@ -188,6 +214,7 @@ typedef struct
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
     const char     *psz_tmp_path;
+    ts_ring_t      *p_ring;
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -212,6 +239,13 @@ typedef struct
 
     vlc_tick_t     i_cmd_delay;
 
+    /* Index of the played commands whose data are still in the ring,
+     * sorted by date */
+    ts_cmd_t       *p_index;
+    size_t         i_index_start;
+    size_t         i_index_count;
+    size_t         i_index_max;
+
 } ts_thread_t;
 
 struct es_out_id_t
@@ -227,6 +261,7 @@ typedef struct
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
+    size_t         i_ring_size;       /* Timeshift window size in byte (or 0) */
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -263,7 +298,16 @@ static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
 
 static void         *TsRun( void * );
 
-static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static int          TsJump( ts_thread_t *, vlc_tick_t i_offset );
+static void         TsIndexAdd( ts_thread_t *, const ts_cmd_t * );
+static void         TsCompact( ts_thread_t * );
+
+static ts_ring_t    *TsRingNew( const char *psz_path, size_t i_size );
+static void         TsRingDelete( ts_ring_t * );
+static bool         TsRingIsValid( const ts_ring_t *, int64_t i_offset );
+
+static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max,
+                                   ts_ring_t *p_ring );
 static void         TsStorageDelete( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
@@ -330,6 +374,18 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    const int i_ring_size = var_InheritInteger( p_input, "input-timeshift-size" );
+#ifdef HAVE_MMAP
+    p_sys->i_ring_size = i_ring_size > 0 ?
+        __MIN( (uint64_t)i_ring_size*1024*1024, SIZE_MAX / 2 ) : 0;
+    if( p_sys->i_ring_size > 0 )
+        msg_Dbg( p_input, "using timeshift window of %d MiB", i_ring_size );
+#else
+    if( i_ring_size > 0 )
+        msg_Warn( p_input, "timeshift window not supported" );
+    p_sys->i_ring_size = 0;
+#endif
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
     if( p_sys->psz_tmp_path == NULL )
@@ -422,6 +478,11 @@ static es_out_id_t *Add( es_out_t *p_out, const es_format_t *p_fmt )
 
     TsAutoStop( p_out );
 
+    /* Record continuously to be able to jump back within the window */
+    if( !p_sys->b_delayed && p_sys->i_ring_size > 0 &&
+        !input_priv(p_sys->p_input)->b_can_pace_control )
+        TsStart( p_out );
+
     if( CmdInitAdd( &cmd, p_es, p_fmt, p_sys->b_delayed ) )
     {
         vlc_mutex_unlock( &p_sys->lock );
@@ -697,6 +758,14 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
         bool *pb_buffering = va_arg( args, bool* );
         return ControlLockedGetBuffering( p_out, pb_buffering );
     }
+    case ES_OUT_JUMP_TIMESHIFT:
+    {
+        const vlc_tick_t i_offset = va_arg( args, vlc_tick_t );
+
+        if( !p_sys->b_delayed )
+            return VLC_EGENERIC;
+        return TsJump( p_sys->p_ts, i_offset );
+    }
     case ES_OUT_SET_PAUSE_STATE:
     {
         const bool b_source_paused = (bool)va_arg( args, int );
@@ -783,6 +852,9 @@ static const struct es_out_callbacks es_out_timeshift_cbs =
  *****************************************************************************/
 static void TsDestroy( ts_thread_t *p_ts )
 {
+    if( p_ts->p_ring )
+        TsRingDelete( p_ts->p_ring );
+    free( p_ts->p_index );
     vlc_cond_destroy( &p_ts->wait );
     vlc_mutex_destroy( &p_ts->lock );
     free( p_ts );
@@ -814,6 +886,22 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_cmd_delay = 0;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->p_index = NULL;
+    p_ts->i_index_start = 0;
+    p_ts->i_index_count = 0;
+    p_ts->i_index_max = 0;
+
+    p_ts->p_ring = NULL;
+    if( p_sys->i_ring_size > 0 )
+    {
+        p_ts->p_ring = TsRingNew( p_sys->psz_tmp_path, p_sys->i_ring_size );
+        if( !p_ts->p_ring )
+        {
+            msg_Warn( p_sys->p_input,
+                      "cannot create the timeshift window, using temporary files" );
+            p_sys->i_ring_size = 0;
+        }
+    }
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -868,7 +956,11 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        if( p_ts->p_ring && p_ts->p_storage_w )
+            TsCompact( p_ts );
+
+        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max,
+                                                p_ts->p_ring );
 
         if( !p_storage )
         {
@@ -901,22 +993,28 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 {
     vlc_mutex_assert( &p_ts->lock );
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
-        return VLC_EGENERIC;
+    for( ;; )
+    {
+        if( TsStorageIsEmpty( p_ts->p_storage_r ) )
+            return VLC_EGENERIC;
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+        TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
 
-    while( TsStorageIsEmpty( p_ts->p_storage_r ) )
-    {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
-        if( !p_next )
-            break;
+        while( TsStorageIsEmpty( p_ts->p_storage_r ) )
+        {
+            ts_storage_t *p_next = p_ts->p_storage_r->p_next;
+            if( !p_next )
+                break;
 
-        TsStorageDelete( p_ts->p_storage_r );
-        p_ts->p_storage_r = p_next;
-    }
+            TsStorageDelete( p_ts->p_storage_r );
+            p_ts->p_storage_r = p_next;
+        }
 
-    return VLC_SUCCESS;
+        /* Skip the blocks overwritten in the ring before being played */
+        if( b_flush || p_cmd->i_type != C_SEND || !p_ts->p_ring ||
+            p_cmd->u.send.p_block )
+            return VLC_SUCCESS;
+    }
 }
 static bool TsHasCmd( ts_thread_t *p_ts )
 {
@@ -935,7 +1033,8 @@ static bool TsIsUnused( ts_thread_t *p_ts )
     vlc_mutex_lock( &p_ts->lock );
     b_unused = !p_ts->b_paused &&
                p_ts->rate == p_ts->rate_source &&
-               TsStorageIsEmpty( p_ts->p_storage_r );
+               TsStorageIsEmpty( p_ts->p_storage_r ) &&
+               !p_ts->p_ring; /* The window is kept to jump back */
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_unused;
@@ -989,6 +1088,188 @@ static int TsChangeRate( ts_thread_t *p_ts, float src_rate, float rate )
 
     return i_ret;
 }
+static int TsJump( ts_thread_t *p_ts, vlc_tick_t i_offset )
+{
+    if( i_offset >= 0 )
+        return VLC_EGENERIC; /* Only jumping back is supported */
+
+    vlc_mutex_lock( &p_ts->lock );
+
+    if( !p_ts->p_ring || p_ts->i_index_count == 0 )
+    {
+        vlc_mutex_unlock( &p_ts->lock );
+        return VLC_EGENERIC;
+    }
+
+    const ts_cmd_t *p_index = &p_ts->p_index[p_ts->i_index_start];
+    const size_t i_count = p_ts->i_index_count;
+
+    /* Look up the first played command at or after the target date */
+    const vlc_tick_t i_last = p_index[i_count - 1].i_date;
+    const vlc_tick_t i_target = i_last + i_offset;
+    size_t i_low = 0, i_high = i_count - 1;
+
+    while( i_low < i_high )
+    {
+        const size_t i_mid = i_low + (i_high - i_low) / 2;
+
+        if( p_index[i_mid].i_date < i_target )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+
+    /* Queue the commands again, before the ones not played yet */
+    const size_t i_replay = i_count - i_low;
+    ts_storage_t *p_storage = TsStorageNew( NULL, 0, p_ts->p_ring );
+
+    if( p_storage && (size_t)p_storage->i_cmd_max < i_replay + 1 )
+    {
+        ts_cmd_t *p_cmd = realloc( p_storage->p_cmd,
+                                   (i_replay + 1) * sizeof(*p_cmd) );
+        if( p_cmd )
+        {
+            p_storage->p_cmd = p_cmd;
+            p_storage->i_cmd_max = i_replay + 1;
+        }
+        else
+        {
+            TsStorageDelete( p_storage );
+            p_storage = NULL;
+        }
+    }
+    if( !p_storage )
+    {
+        vlc_mutex_unlock( &p_ts->lock );
+        return VLC_ENOMEM;
+    }
+
+    ts_cmd_t *p_reset = &p_storage->p_cmd[p_storage->i_cmd_w++];
+    p_reset->i_type = C_CONTROL;
+    p_reset->i_date = p_index[i_low].i_date;
+    p_reset->u.control.i_query = ES_OUT_RESET_PCR;
+
+    memcpy( &p_storage->p_cmd[p_storage->i_cmd_w], &p_index[i_low],
+            i_replay * sizeof(*p_index) );
+    p_storage->i_cmd_w += i_replay;
+
+    p_storage->p_next = p_ts->p_storage_r;
+    p_ts->p_storage_r = p_storage;
+    if( !p_ts->p_storage_w )
+        p_ts->p_storage_w = p_storage;
+
+    /* Shift the command schedule by the jumped duration */
+    p_ts->i_cmd_delay += p_ts->i_rate_delay;
+    p_ts->i_rate_date = -1;
+    p_ts->i_rate_delay = 0;
+    p_ts->i_cmd_delay += i_last - p_index[i_low].i_date;
+
+    /* The replayed commands are indexed again when popped */
+    p_ts->i_index_count = i_low;
+
+    msg_Dbg( p_ts->p_input, "es out timeshift: jumping back %"PRId64" ms",
+             MS_FROM_VLC_TICK(i_last - p_index[i_low].i_date) );
+
+    vlc_cond_signal( &p_ts->wait );
+    vlc_mutex_unlock( &p_ts->lock );
+    return VLC_SUCCESS;
+}
+static void TsIndexAdd( ts_thread_t *p_ts, const ts_cmd_t *p_cmd )
+{
+    vlc_mutex_assert( &p_ts->lock );
+
+    if( !p_ts->p_ring )
+        return;
+
+    switch( p_cmd->i_type )
+    {
+    case C_SEND:
+        break;
+    case C_CONTROL:
+        if( p_cmd->u.control.i_query == ES_OUT_SET_PCR ||
+            p_cmd->u.control.i_query == ES_OUT_SET_GROUP_PCR )
+            break;
+        if( p_cmd->u.control.i_query == ES_OUT_RESET_PCR )
+            p_ts->i_index_count = 0; /* Discontinuity */
+        return;
+    case C_DEL:
+        p_ts->i_index_count = 0; /* The ES will not exist anymore */
+        return;
+    default:
+        return;
+    }
+
+    /* Forget the oldest commands, whose data were overwritten */
+    while( p_ts->i_index_count > 0 )
+    {
+        const ts_cmd_t *p_old = &p_ts->p_index[p_ts->i_index_start];
+
+        if( p_old->i_type == C_SEND &&
+            TsRingIsValid( p_ts->p_ring, p_old->u.send.i_offset ) )
+            break;
+        p_ts->i_index_start++;
+        p_ts->i_index_count--;
+    }
+    if( p_ts->i_index_count == 0 )
+        p_ts->i_index_start = 0;
+
+    if( p_ts->i_index_start + p_ts->i_index_count >= p_ts->i_index_max )
+    {
+        if( p_ts->i_index_start >= p_ts->i_index_max / 2 )
+        {
+            memmove( p_ts->p_index, &p_ts->p_index[p_ts->i_index_start],
+                     p_ts->i_index_count * sizeof(*p_ts->p_index) );
+            p_ts->i_index_start = 0;
+        }
+        else
+        {
+            const size_t i_max = __MAX( p_ts->i_index_max * 2, 1024 );
+            ts_cmd_t *p_index = realloc( p_ts->p_index,
+                                         i_max * sizeof(*p_index) );
+            if( !p_index )
+                return;
+            p_ts->p_index = p_index;
+            p_ts->i_index_max = i_max;
+        }
+    }
+
+    ts_cmd_t *p_new = &p_ts->p_index[p_ts->i_index_start + p_ts->i_index_count++];
+    *p_new = *p_cmd;
+    if( p_new->i_type == C_SEND )
+        p_new->u.send.p_block = NULL; /* Read again from the ring */
+}
+static void TsCompact( ts_thread_t *p_ts )
+{
+    vlc_mutex_assert( &p_ts->lock );
+
+    /* Drop the commands of the blocks overwritten before being played */
+    ts_storage_t **pp_storage = &p_ts->p_storage_r;
+    while( *pp_storage )
+    {
+        ts_storage_t *p_storage = *pp_storage;
+        int i_cmd_w = 0;
+
+        for( int i = p_storage->i_cmd_r; i < p_storage->i_cmd_w; i++ )
+        {
+            const ts_cmd_t *p_cmd = &p_storage->p_cmd[i];
+
+            if( p_cmd->i_type == C_SEND &&
+                !TsRingIsValid( p_ts->p_ring, p_cmd->u.send.i_offset ) )
+                continue;
+            p_storage->p_cmd[i_cmd_w++] = *p_cmd;
+        }
+        p_storage->i_cmd_r = 0;
+        p_storage->i_cmd_w = i_cmd_w;
+
+        if( i_cmd_w == 0 && p_storage != p_ts->p_storage_w )
+        {
+            *pp_storage = p_storage->p_next;
+            TsStorageDelete( p_storage );
+        }
+        else
+            pp_storage = &p_storage->p_next;
+    }
+}
 
 static void *TsRun( void *p_data )
 {
@@ -1012,6 +1293,7 @@ static void *TsRun( void *p_data )
 
             if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, false ) )
             {
+                TsIndexAdd( p_ts, &cmd );
                 vlc_restorecancel( canc );
                 break;
             }
@@ -1112,19 +1394,95 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+static ts_ring_t *TsRingNew( const char *psz_tmp_path, size_t i_size )
 {
-    ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
-    if( unlikely(p_storage == NULL) )
+#ifdef HAVE_MMAP
+    ts_ring_t *p_ring = malloc( sizeof (*p_ring) );
+    if( unlikely(p_ring == NULL) )
         return NULL;
 
     char *psz_file;
     int fd = GetTmpFile( &psz_file, psz_tmp_path );
     if( fd == -1 )
     {
-        free( p_storage );
+        free( p_ring );
+        return NULL;
+    }
+    vlc_unlink( psz_file );
+    free( psz_file );
+
+    int i_err;
+#ifdef HAVE_POSIX_FALLOCATE
+    /* Reserve the disk space now, so that writing to the mapping cannot
+     * fault later on */
+    i_err = posix_fallocate( fd, 0, i_size );
+    if( i_err == EINVAL || i_err == EOPNOTSUPP ) /* not supported by the FS */
+#endif
+        i_err = ftruncate( fd, i_size ) ? errno : 0;
+
+    if( i_err == 0 )
+    {
+        p_ring->p_base = mmap( NULL, i_size, PROT_READ|PROT_WRITE, MAP_SHARED,
+                               fd, 0 );
+        if( p_ring->p_base == MAP_FAILED )
+            i_err = errno;
+    }
+    vlc_close( fd );
+
+    if( i_err )
+    {
+        free( p_ring );
         return NULL;
     }
+    p_ring->i_size = i_size;
+    p_ring->i_write = 0;
+    return p_ring;
+#else
+    VLC_UNUSED(psz_tmp_path); VLC_UNUSED(i_size);
+    return NULL;
+#endif
+}
+
+static void TsRingDelete( ts_ring_t *p_ring )
+{
+#ifdef HAVE_MMAP
+    munmap( p_ring->p_base, p_ring->i_size );
+#endif
+    free( p_ring );
+}
+
+static bool TsRingIsValid( const ts_ring_t *p_ring, int64_t i_offset )
+{
+    return p_ring->i_write <= p_ring->i_size ||
+           (uint64_t)i_offset >= p_ring->i_write - p_ring->i_size;
+}
+
+static void TsRingWrite( ts_ring_t *p_ring, const void *p_data, size_t i_data )
+{
+    const size_t i_pos = p_ring->i_write % p_ring->i_size;
+    const size_t i_first = __MIN( i_data, p_ring->i_size - i_pos );
+
+    memcpy( &p_ring->p_base[i_pos], p_data, i_first );
+    memcpy( p_ring->p_base, (const uint8_t *)p_data + i_first, i_data - i_first );
+    p_ring->i_write += i_data;
+}
+
+static void TsRingRead( const ts_ring_t *p_ring, uint64_t i_offset,
+                        void *p_data, size_t i_data )
+{
+    const size_t i_pos = i_offset % p_ring->i_size;
+    const size_t i_first = __MIN( i_data, p_ring->i_size - i_pos );
+
+    memcpy( p_data, &p_ring->p_base[i_pos], i_first );
+    memcpy( (uint8_t *)p_data + i_first, p_ring->p_base, i_data - i_first );
+}
+
+static int TsStorageOpenFiles( ts_storage_t *p_storage, const char *psz_tmp_path )
+{
+    char *psz_file;
+    int fd = GetTmpFile( &psz_file, psz_tmp_path );
+    if( fd == -1 )
+        return VLC_EGENERIC;
 
     p_storage->p_filew = fdopen( fd, "w+b" );
     if( p_storage->p_filew == NULL )
@@ -1148,6 +1506,25 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
 #else
     p_storage->psz_file = psz_file;
 #endif
+    return VLC_SUCCESS;
+error:
+    free( psz_file );
+    return VLC_EGENERIC;
+}
+
+static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max,
+                                   ts_ring_t *p_ring )
+{
+    ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
+    if( unlikely(p_storage == NULL) )
+        return NULL;
+
+    p_storage->p_ring = p_ring;
+    if( !p_ring && TsStorageOpenFiles( p_storage, psz_tmp_path ) )
+    {
+        free( p_storage );
+        return NULL;
+    }
     p_storage->p_next = NULL;
 
     /* */
@@ -1167,10 +1544,6 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         return NULL;
     }
     return p_storage;
-error:
-    free( psz_file );
-    free( p_storage );
-    return NULL;
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
@@ -1185,12 +1558,15 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
+    if( !p_storage->p_ring )
+    {
+        fclose( p_storage->p_filer );
+        fclose( p_storage->p_filew );
 #ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
-    free( p_storage->psz_file );
+        vlc_unlink( p_storage->psz_file );
+        free( p_storage->psz_file );
 #endif
+    }
     free( p_storage );
 }
 
@@ -1208,7 +1584,8 @@ static void TsStoragePack( ts_storage_t *p_storage )
 }
 static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
-    if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
+    if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 &&
+        !p_storage->p_ring )
     {
         size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
 
@@ -1232,6 +1609,31 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
         block_t *p_block = cmd.u.send.p_block;
 
         cmd.u.send.p_block = NULL;
+
+        if( p_storage->p_ring )
+        {
+            ts_ring_t *p_ring = p_storage->p_ring;
+            const ts_ring_block_t block = {
+                .i_buffer = p_block->i_buffer,
+                .i_flags = p_block->i_flags,
+                .i_nb_samples = p_block->i_nb_samples,
+                .i_pts = p_block->i_pts,
+                .i_dts = p_block->i_dts,
+                .i_length = p_block->i_length,
+            };
+
+            if( sizeof(block) + p_block->i_buffer > p_ring->i_size )
+            {   /* Larger than the whole window */
+                block_Release( p_block );
+                return;
+            }
+            cmd.u.send.i_offset = p_ring->i_write;
+            TsRingWrite( p_ring, &block, sizeof(block) );
+            TsRingWrite( p_ring, p_block->p_buffer, p_block->i_buffer );
+            block_Release( p_block );
+            goto push;
+        }
+
         cmd.u.send.i_offset = ftell( p_storage->p_filew );
 
         if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
@@ -1254,6 +1656,7 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
         if( b_flush )
             fflush( p_storage->p_filew );
     }
+push:
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
 }
 static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
@@ -1261,7 +1664,32 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
     assert( !TsStorageIsEmpty( p_storage ) );
 
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
-    if( p_cmd->i_type == C_SEND )
+    if( p_cmd->i_type == C_SEND && p_storage->p_ring )
+    {
+        const ts_ring_t *p_ring = p_storage->p_ring;
+        const uint64_t i_offset = p_cmd->u.send.i_offset;
+        ts_ring_block_t block;
+        block_t *p_block = NULL;
+
+        /* The block may have been overwritten since (see TsPopCmdLocked) */
+        if( !b_flush && TsRingIsValid( p_ring, i_offset ) )
+        {
+            TsRingRead( p_ring, i_offset, &block, sizeof(block) );
+            p_block = block_Alloc( block.i_buffer );
+            if( p_block )
+            {
+                p_block->i_dts      = block.i_dts;
+                p_block->i_pts      = block.i_pts;
+                p_block->i_flags    = block.i_flags;
+                p_block->i_length   = block.i_length;
+                p_block->i_nb_samples = block.i_nb_samples;
+                TsRingRead( p_ring, i_offset + sizeof(block),
+                            p_block->p_buffer, block.i_buffer );
+            }
+        }
+        p_cmd->u.send.p_block = p_block;
+    }
+    else if( p_cmd->i_type == C_SEND )
     {
         block_t block;
 
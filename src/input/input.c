@@ -34,6 +34,7 @@
 #include <limits.h>
 #include <assert.h>
 #include <sys/stat.h>
+#include <time.h>
 
 #include "input_internal.h"
 #include "event.h"
@@ -54,6 +55,7 @@
 #include <vlc_stream.h>
 #include <vlc_stream_extractor.h>
 #include <vlc_renderer_discovery.h>
+#include <vlc_tracer.h>
 
 /*****************************************************************************
  * Local prototypes
@@ -183,6 +185,19 @@ int input_Start( input_thread_t *p_input )
     return VLC_SUCCESS;
 }
 
+void input_SetStandby( input_thread_t *p_input, bool standby )
+{
+    input_thread_private_t *priv = input_priv(p_input);
+
+    if( !priv->is_running )
+    {
+        priv->b_standby = standby;
+        return;
+    }
+    input_ControlPushHelper( p_input, INPUT_CONTROL_SET_STANDBY,
+                             &(vlc_value_t) { .b_bool = standby } );
+}
+
 /**
  * Request a running input thread to stop and die
  *
@@ -296,6 +311,8 @@ static input_thread_t *Create( vlc_object_t *p_parent,
     priv->events_data = events_data;
     priv->b_preparsing = option == INPUT_CREATE_OPTION_PREPARSING;
     priv->b_thumbnailing = option == INPUT_CREATE_OPTION_THUMBNAILING;
+    priv->b_standby = false;
+    priv->i_es_out_mode = ES_OUT_MODE_AUTO;
     priv->b_can_pace_control = true;
     priv->i_start = 0;
     priv->i_stop  = 0;
@@ -537,7 +554,14 @@ static void MainLoopDemux( input_thread_t *p_input, bool *pb_changed )
     }
 
     if( i_ret == VLC_DEMUXER_SUCCESS )
+    {
+        struct vlc_tracer *tracer = vlc_object_get_tracer( p_input );
+
+        vlc_tracer_Begin( tracer, "demux", "demux", p_demux,
+                          VLC_TICK_INVALID );
         i_ret = demux_Demux( p_demux );
+        vlc_tracer_End( tracer, "demux", "demux", p_demux, VLC_TICK_INVALID );
+    }
 
     i_ret = i_ret > 0 ? VLC_DEMUXER_SUCCESS : ( i_ret < 0 ? VLC_DEMUXER_EGENERIC : VLC_DEMUXER_EOF);
 
@@ -637,14 +661,41 @@ static void MainLoopStatistics( input_thread_t *p_input )
 
     struct input_stats_t new_stats;
     if( priv->stats != NULL )
+    {
+        demux_t *p_demux = priv->master->p_demux;
+        struct vlc_stream_network net;
+
         input_stats_Compute( priv->stats, &new_stats );
+        es_out_Control( priv->p_es_out_display, ES_OUT_GET_DECODER_STATS,
+                        &new_stats );
+
+        /* Not all the demuxers forward the query to their source */
+        if( demux_Control( p_demux, DEMUX_GET_NETWORK, &net ) == VLC_SUCCESS
+         || ( p_demux->s != NULL
+           && vlc_stream_Control( p_demux->s, STREAM_GET_NETWORK,
+                                  &net ) == VLC_SUCCESS ) )
+        {
+            new_stats.i_net_requests = net.requests;
+            new_stats.i_net_throughput = net.throughput;
+            new_stats.i_net_rtt = net.rtt;
+        }
+
+#ifdef CLOCK_THREAD_CPUTIME_ID
+        /* This is the demux (and non-transcoding stream output) cost */
+        struct timespec ts;
+        if( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) == 0 )
+            new_stats.i_cpu_time = vlc_tick_from_timespec( &ts );
+#endif
+    }
 
     vlc_mutex_lock( &priv->p_item->lock );
     if( priv->stats != NULL )
         *priv->p_item->p_stats = new_stats;
     vlc_mutex_unlock( &priv->p_item->lock );
 
-    input_SendEventStatistics( p_input, &new_stats );
+    /* new_stats is only computed with the "stats" option */
+    if( priv->stats != NULL )
+        input_SendEventStatistics( p_input, &new_stats );
 }
 
 /**
@@ -1207,7 +1258,10 @@ static void InitPrograms( input_thread_t * p_input )
             i_es_out_mode = ES_OUT_MODE_ALL;
         }
     }
-    es_out_SetMode( input_priv(p_input)->p_es_out, i_es_out_mode );
+    input_priv(p_input)->i_es_out_mode = i_es_out_mode;
+    es_out_SetMode( input_priv(p_input)->p_es_out,
+                    input_priv(p_input)->b_standby ? ES_OUT_MODE_NONE
+                                                   : i_es_out_mode );
 
     /* Inform the demuxer about waited group (needed only for DVB) */
     if( i_es_out_mode == ES_OUT_MODE_ALL )
@@ -1858,6 +1912,14 @@ static bool Control( input_thread_t *p_input,
                 break;
             }
 
+            /* Jump back within the timeshift window, if any */
+            if( !absolute && param.time.i_val < 0 &&
+                !es_out_JumpTimeshift( priv->p_es_out, param.time.i_val ) )
+            {
+                b_force_update = true;
+                break;
+            }
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_Control( priv->p_es_out, ES_OUT_RESET_PCR );
 
@@ -2289,6 +2351,20 @@ static bool Control( input_thread_t *p_input,
                             param.es_autoselect.cat, param.es_autoselect.enabled );
             break;
 
+        case INPUT_CONTROL_SET_STANDBY:
+            if( priv->b_standby == param.val.b_bool )
+                break;
+            priv->b_standby = param.val.b_bool;
+            msg_Dbg( p_input, "%s standby", priv->b_standby ? "entering"
+                                                           : "leaving" );
+            es_out_SetMode( priv->p_es_out, priv->b_standby ? ES_OUT_MODE_NONE
+                                                            : priv->i_es_out_mode );
+            /* The tracks start decoding now: buffer again from the next
+             * clock reference */
+            if( !priv->b_standby )
+                es_out_Control( priv->p_es_out, ES_OUT_RESET_PCR );
+            break;
+
         case INPUT_CONTROL_NAV_ACTIVATE:
         case INPUT_CONTROL_NAV_UP:
         case INPUT_CONTROL_NAV_DOWN:
@@ -335,6 +335,15 @@ VLC_USED;
 
 int input_Start( input_thread_t * );
 
+/**
+ * Puts the input in standby, or takes it out of standby.
+ *
+ * An input in standby keeps its access and demuxer running but selects no
+ * track, so that it can be played back without opening the media again.
+ * It can be called before input_Start().
+ */
+void input_SetStandby( input_thread_t *, bool standby );
+
 void input_Stop( input_thread_t * );
 
 void input_Close( input_thread_t * );
@@ -467,6 +476,8 @@ typedef struct input_thread_private_t
     bool        is_stopped;
     bool        b_recording;
     bool        b_thumbnailing;
+    bool        b_standby;
+    int         i_es_out_mode; /* mode to restore when leaving standby */
     float       rate;
     vlc_tick_t  normal_time;
 
@@ -595,6 +606,8 @@ enum input_control_e
     INPUT_CONTROL_SET_VBI_TRANSPARENCY,
 
     INPUT_CONTROL_SET_ES_AUTOSELECT,
+
+    INPUT_CONTROL_SET_STANDBY,
 };
 
 /* Internal helpers */
@@ -648,6 +661,12 @@ input_attachment_t *input_GetAttachment(input_thread_t *input, const char *name)
  *  Be careful: p_item lock will be taken! */
 void input_ExtractAttachmentAndCacheArt( input_thread_t *, const char *name );
 
+/* input_item_ReadMeta:
+ *  Read the meta data and the duration of a local file with a "meta reader"
+ *  module only, without opening any demuxer nor decoder.
+ *  Return VLC_SUCCESS if both were found. */
+int input_item_ReadMeta( vlc_object_t *, input_item_t * );
+
 /***************************************************************************
  * Internal prototypes
  ***************************************************************************/
@@ -688,6 +707,31 @@ struct input_stats {
     atomic_uintmax_t lost_abuffers;
     atomic_uintmax_t displayed_pictures;
     atomic_uintmax_t lost_pictures;
+    struct
+    {
+        atomic_uintmax_t late[INPUT_STATS_PACING_BUCKETS];
+        atomic_uintmax_t prepare[INPUT_STATS_PACING_BUCKETS];
+        atomic_uintmax_t display[INPUT_STATS_PACING_BUCKETS];
+    } pacing;
+    struct
+    {
+        atomic_uintmax_t video[INPUT_STATS_PACING_BUCKETS];
+        atomic_uintmax_t audio[INPUT_STATS_PACING_BUCKETS];
+    } decode;
+    struct
+    {
+        atomic_uintmax_t latency[INPUT_STATS_AOUT_BUCKETS];
+        atomic_uintmax_t drift[INPUT_STATS_AOUT_BUCKETS];
+        atomic_uintmax_t underruns;
+        atomic_uintmax_t resamplings;
+        atomic_uintmax_t resampling_hz;
+    } aout;
+    struct
+    {
+        atomic_llong drift;
+        atomic_llong jitter;
+        atomic_llong dejitter;
+    } clock;
 };
 
 struct input_stats *input_stats_Create(void);
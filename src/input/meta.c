@@ -201,6 +201,17 @@ void vlc_meta_Merge( vlc_meta_t *dst, const vlc_meta_t *src )
 }
 
 
+static const char *ArtExtension( const char *psz_mime )
+{
+    if( !strcmp( psz_mime, "image/jpeg" ) )
+        return ".jpg";
+    if( !strcmp( psz_mime, "image/png" ) )
+        return ".png";
+    if( !strcmp( psz_mime, "image/x-pict" ) )
+        return ".pct";
+    return NULL;
+}
+
 void input_ExtractAttachmentAndCacheArt( input_thread_t *p_input,
                                          const char *name )
 {
@@ -222,21 +233,76 @@ void input_ExtractAttachmentAndCacheArt( input_thread_t *p_input,
         return;
     }
 
-    /* */
-    const char *psz_type = NULL;
-
-    if( !strcmp( p_attachment->psz_mime, "image/jpeg" ) )
-        psz_type = ".jpg";
-    else if( !strcmp( p_attachment->psz_mime, "image/png" ) )
-        psz_type = ".png";
-    else if( !strcmp( p_attachment->psz_mime, "image/x-pict" ) )
-        psz_type = ".pct";
-
     input_SaveArt( VLC_OBJECT(p_input), p_item,
-                   p_attachment->p_data, p_attachment->i_data, psz_type );
+                   p_attachment->p_data, p_attachment->i_data,
+                   ArtExtension( p_attachment->psz_mime ) );
     vlc_input_attachment_Delete( p_attachment );
 }
 
+int input_item_ReadMeta( vlc_object_t *obj, input_item_t *p_item )
+{
+    vlc_mutex_lock( &p_item->lock );
+    bool local = p_item->i_type == ITEM_TYPE_FILE && !p_item->b_net;
+    vlc_mutex_unlock( &p_item->lock );
+    if( !local )
+        return VLC_EGENERIC;
+
+    demux_meta_t *p_demux_meta =
+        vlc_custom_create( obj, sizeof( *p_demux_meta ), "demux meta" );
+    if( unlikely(p_demux_meta == NULL) )
+        return VLC_ENOMEM;
+    p_demux_meta->p_item = p_item;
+
+    int ret = VLC_EGENERIC;
+    module_t *p_reader = module_need( p_demux_meta, "meta reader", NULL,
+                                      false );
+    if( p_reader == NULL )
+        goto end;
+
+    vlc_meta_t *p_meta = p_demux_meta->p_meta;
+    /* without a duration, a full preparsing is needed anyway */
+    if( p_meta == NULL || p_demux_meta->i_duration == VLC_TICK_INVALID )
+        goto end;
+
+    vlc_mutex_lock( &p_item->lock );
+    vlc_meta_Merge( p_item->p_meta, p_meta );
+    vlc_mutex_unlock( &p_item->lock );
+
+    const char *psz_title = vlc_meta_Get( p_meta, vlc_meta_Title );
+    if( psz_title != NULL )
+        input_item_SetName( p_item, psz_title );
+    input_item_SetDuration( p_item, p_demux_meta->i_duration );
+
+    /* There is no input to extract the art from later: cache it now */
+    const char *psz_arturl = vlc_meta_Get( p_meta, vlc_meta_ArtworkURL );
+    if( psz_arturl != NULL && !strncmp( psz_arturl, "attachment://", 13 ) )
+    {
+        input_attachment_t *p_attachment = NULL;
+        for( int i = 0; i < p_demux_meta->i_attachments; i++ )
+            if( !strcmp( p_demux_meta->attachments[i]->psz_name,
+                         psz_arturl + 13 ) )
+                p_attachment = p_demux_meta->attachments[i];
+
+        input_item_SetArtURL( p_item, NULL );
+        if( p_attachment != NULL )
+            input_SaveArt( obj, p_item, p_attachment->p_data,
+                           p_attachment->i_data,
+                           ArtExtension( p_attachment->psz_mime ) );
+    }
+
+    ret = VLC_SUCCESS;
+end:
+    if( p_reader != NULL )
+        module_unneed( p_demux_meta, p_reader );
+    if( p_demux_meta->p_meta != NULL )
+        vlc_meta_Delete( p_demux_meta->p_meta );
+    for( int i = 0; i < p_demux_meta->i_attachments; i++ )
+        vlc_input_attachment_Delete( p_demux_meta->attachments[i] );
+    free( p_demux_meta->attachments );
+    vlc_object_delete( p_demux_meta );
+    return ret;
+}
+
 int input_item_WriteMeta( vlc_object_t *obj, input_item_t *p_item )
 {
     meta_export_t *p_export =
@@ -67,6 +67,25 @@ struct input_stats *input_stats_Create(void)
     atomic_init(&stats->lost_abuffers, 0);
     atomic_init(&stats->displayed_pictures, 0);
     atomic_init(&stats->lost_pictures, 0);
+    for (unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++)
+    {
+        atomic_init(&stats->pacing.late[i], 0);
+        atomic_init(&stats->pacing.prepare[i], 0);
+        atomic_init(&stats->pacing.display[i], 0);
+        atomic_init(&stats->decode.video[i], 0);
+        atomic_init(&stats->decode.audio[i], 0);
+    }
+    for (unsigned i = 0; i < INPUT_STATS_AOUT_BUCKETS; i++)
+    {
+        atomic_init(&stats->aout.latency[i], 0);
+        atomic_init(&stats->aout.drift[i], 0);
+    }
+    atomic_init(&stats->aout.underruns, 0);
+    atomic_init(&stats->aout.resamplings, 0);
+    atomic_init(&stats->aout.resampling_hz, 0);
+    atomic_init(&stats->clock.drift, 0);
+    atomic_init(&stats->clock.jitter, 0);
+    atomic_init(&stats->clock.dejitter, 0);
     return stats;
 }
 
@@ -102,6 +121,20 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                  memory_order_relaxed);
     st->i_lost_abuffers = atomic_load_explicit(&stats->lost_abuffers,
                                                memory_order_relaxed);
+    for (unsigned i = 0; i < INPUT_STATS_AOUT_BUCKETS; i++)
+    {
+        st->aout.i_latency[i] = atomic_load_explicit(&stats->aout.latency[i],
+                                                     memory_order_relaxed);
+        st->aout.i_drift[i] = atomic_load_explicit(&stats->aout.drift[i],
+                                                   memory_order_relaxed);
+    }
+    st->aout.i_underruns = atomic_load_explicit(&stats->aout.underruns,
+                                                memory_order_relaxed);
+    st->aout.i_resamplings = atomic_load_explicit(&stats->aout.resamplings,
+                                                  memory_order_relaxed);
+    st->aout.i_resampling_hz =
+        atomic_load_explicit(&stats->aout.resampling_hz,
+                             memory_order_relaxed);
 
     /* Vouts */
     st->i_decoded_video = atomic_load_explicit(&stats->decoded_video,
@@ -110,6 +143,44 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+    for (unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++)
+    {
+        st->pacing.i_late[i] = atomic_load_explicit(&stats->pacing.late[i],
+                                                    memory_order_relaxed);
+        st->pacing.i_prepare[i] =
+            atomic_load_explicit(&stats->pacing.prepare[i],
+                                 memory_order_relaxed);
+        st->pacing.i_display[i] =
+            atomic_load_explicit(&stats->pacing.display[i],
+                                 memory_order_relaxed);
+    }
+
+    /* Decoders, the fifo levels are filled by the ES output */
+    for (unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++)
+    {
+        st->video_decoder.i_decode[i] =
+            atomic_load_explicit(&stats->decode.video[i],
+                                 memory_order_relaxed);
+        st->audio_decoder.i_decode[i] =
+            atomic_load_explicit(&stats->decode.audio[i],
+                                 memory_order_relaxed);
+    }
+    st->video_decoder.i_fifo_blocks = st->video_decoder.i_fifo_bytes = 0;
+    st->audio_decoder.i_fifo_blocks = st->audio_decoder.i_fifo_bytes = 0;
+
+    /* Network, filled by the input from the master source */
+    st->i_net_requests = 0;
+    st->i_net_throughput = 0;
+    st->i_net_rtt = VLC_TICK_INVALID;
+    st->i_cpu_time = VLC_TICK_INVALID; /* filled by the input thread */
+
+    /* Input clock */
+    st->i_clock_drift = atomic_load_explicit(&stats->clock.drift,
+                                             memory_order_relaxed);
+    st->i_clock_jitter = atomic_load_explicit(&stats->clock.jitter,
+                                              memory_order_relaxed);
+    st->i_dejitter = atomic_load_explicit(&stats->clock.dejitter,
+                                          memory_order_relaxed);
 }
 
 /** Update a counter element with new values
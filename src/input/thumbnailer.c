@@ -54,6 +54,10 @@ typedef struct vlc_thumbnailer_params_t
      */
     vlc_tick_t timeout;
     vlc_thumbnailer_cb cb;
+    /* batch requests: one callback per time, times[0] is the first seek */
+    vlc_thumbnailer_batch_cb batch_cb;
+    vlc_tick_t *times;
+    size_t count;
     void* user_data;
 } vlc_thumbnailer_params_t;
 
@@ -65,9 +69,30 @@ struct vlc_thumbnailer_request_t
     vlc_thumbnailer_params_t params;
 
     vlc_mutex_t lock;
+    size_t index; /* number of thumbnails already reported */
     bool done;
 };
 
+/* Return whether the user still expects a thumbnail (not cancelled) */
+static bool thumbnailer_request_PendingLocked( vlc_thumbnailer_request_t *request )
+{
+    if ( request->params.cb == NULL && request->params.batch_cb == NULL )
+        return false;
+    return request->index < request->params.count;
+}
+
+static void thumbnailer_request_NotifyLocked( vlc_thumbnailer_request_t *request,
+                                              picture_t *pic )
+{
+    assert( thumbnailer_request_PendingLocked( request ) );
+    if ( request->params.batch_cb )
+        request->params.batch_cb( request->params.user_data, request->index,
+                                  pic );
+    else
+        request->params.cb( request->params.user_data, pic );
+    request->index++;
+}
+
 static void
 on_thumbnailer_input_event( input_thread_t *input,
                             const struct vlc_input_event *event, void *userdata )
@@ -79,28 +104,40 @@ on_thumbnailer_input_event( input_thread_t *input,
          return;
 
     vlc_thumbnailer_request_t* request = userdata;
-    picture_t *pic = NULL;
 
+    vlc_mutex_lock( &request->lock );
     if ( event->type == INPUT_EVENT_THUMBNAIL_READY )
     {
+        /*
+         * If the request has not been cancelled, we can invoke the completion
+         * callback.
+         */
+        if ( thumbnailer_request_PendingLocked( request ) )
+            thumbnailer_request_NotifyLocked( request, event->thumbnail );
+
+        if ( thumbnailer_request_PendingLocked( request ) )
+        {
+            /* Reuse the same input and decoder for the next thumbnail of the
+             * batch: the seek restarts the decoder, which outputs the next
+             * thumbnail after the target time */
+            input_SetTime( request->input_thread,
+                           request->params.times[request->index],
+                           request->params.fast_seek );
+            vlc_mutex_unlock( &request->lock );
+            return;
+        }
+
         /*
          * Stop the input thread ASAP, delegate its release to
          * thumbnailer_request_Release
          */
         input_Stop( request->input_thread );
-        pic = event->thumbnail;
     }
-    vlc_mutex_lock( &request->lock );
+
+    /* On error or end of stream, the remaining thumbnails failed */
+    while ( thumbnailer_request_PendingLocked( request ) )
+        thumbnailer_request_NotifyLocked( request, NULL );
     request->done = true;
-    /*
-     * If the request has not been cancelled, we can invoke the completion
-     * callback.
-     */
-    if ( request->params.cb )
-    {
-        request->params.cb( request->params.user_data, pic );
-        request->params.cb = NULL;
-    }
     vlc_mutex_unlock( &request->lock );
     background_worker_RequestProbe( request->thumbnailer->worker );
 }
@@ -118,6 +155,7 @@ static void thumbnailer_request_Release( void* data )
 
     input_item_Release( request->params.input_item );
     vlc_mutex_destroy( &request->lock );
+    free( request->params.times );
     free( request );
 }
 
@@ -130,10 +168,7 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
                                      on_thumbnailer_input_event, request,
                                      request->params.input_item );
     if ( unlikely( input == NULL ) )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        return VLC_EGENERIC;
-    }
+        goto error;
     if ( request->params.type == VLC_THUMBNAILER_SEEK_TIME )
     {
         input_SetTime( input, request->params.time,
@@ -146,12 +181,16 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
                        request->params.fast_seek );
     }
     if ( input_Start( input ) != VLC_SUCCESS )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        return VLC_EGENERIC;
-    }
+        goto error;
     *out = request;
     return VLC_SUCCESS;
+
+error:
+    vlc_mutex_lock( &request->lock );
+    while ( thumbnailer_request_PendingLocked( request ) )
+        thumbnailer_request_NotifyLocked( request, NULL );
+    vlc_mutex_unlock( &request->lock );
+    return VLC_EGENERIC;
 }
 
 static void thumbnailer_request_Stop( void* owner, void* handle )
@@ -164,11 +203,8 @@ static void thumbnailer_request_Stop( void* owner, void* handle )
      * If the callback hasn't been invoked yet, we assume a timeout and
      * signal it back to the user
      */
-    if ( request->params.cb != NULL )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        request->params.cb = NULL;
-    }
+    while ( thumbnailer_request_PendingLocked( request ) )
+        thumbnailer_request_NotifyLocked( request, NULL );
     vlc_mutex_unlock( &request->lock );
     assert( request->input_thread != NULL );
     input_Stop( request->input_thread );
@@ -190,10 +226,16 @@ thumbnailer_RequestCommon( vlc_thumbnailer_t* thumbnailer,
 {
     vlc_thumbnailer_request_t *request = malloc( sizeof( *request ) );
     if ( unlikely( request == NULL ) )
+    {
+        free( params->times );
         return NULL;
+    }
     request->thumbnailer = thumbnailer;
     request->input_thread = NULL;
     request->params = *(vlc_thumbnailer_params_t*)params;
+    if ( request->params.count == 0 )
+        request->params.count = 1; /* single thumbnail */
+    request->index = 0;
     request->done = false;
     input_item_Hold( request->params.input_item );
     vlc_mutex_init( &request->lock );
@@ -246,12 +288,45 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
         });
 }
 
+vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatchByTime( vlc_thumbnailer_t *thumbnailer,
+                                    const vlc_tick_t *times, size_t count,
+                                    enum vlc_thumbnailer_seek_speed speed,
+                                    input_item_t *input_item,
+                                    vlc_tick_t timeout,
+                                    vlc_thumbnailer_batch_cb cb,
+                                    void* user_data )
+{
+    assert( count > 0 );
+
+    vlc_tick_t *copy = vlc_alloc( count, sizeof( *copy ) );
+    if ( unlikely( copy == NULL ) )
+        return NULL;
+    memcpy( copy, times, count * sizeof( *copy ) );
+
+    vlc_thumbnailer_request_t *request = thumbnailer_RequestCommon( thumbnailer,
+            &(const vlc_thumbnailer_params_t){
+                .time = times[0],
+                .type = VLC_THUMBNAILER_SEEK_TIME,
+                .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
+                .input_item = input_item,
+                .timeout = timeout,
+                .batch_cb = cb,
+                .times = copy,
+                .count = count,
+                .user_data = user_data,
+        });
+    /* on failure, the copy has been released */
+    return request;
+}
+
 void vlc_thumbnailer_Cancel( vlc_thumbnailer_t* thumbnailer,
                              vlc_thumbnailer_request_t* req )
 {
     vlc_mutex_lock( &req->lock );
     /* Ensure we won't invoke the callback if the input was running. */
     req->params.cb = NULL;
+    req->params.batch_cb = NULL;
     vlc_mutex_unlock( &req->lock );
     background_worker_Cancel( thumbnailer->worker, req );
 }
@@ -35,6 +35,7 @@
 #include <ctype.h>                                              /* tolower() */
 #include <time.h>                                                 /* ctime() */
 #include <limits.h>
+#include <math.h>
 #include <assert.h>
 
 #include <vlc_vlm.h>
@@ -47,6 +48,7 @@
 #include <vlc_vod.h>
 #include <vlc_sout.h>
 #include <vlc_url.h>
+#include <vlc_memstream.h>
 #include "../stream_output/stream_output.h"
 #include "../libvlc.h"
 #include "input_internal.h"
@@ -57,6 +59,7 @@
 
 static void* Manage( void * );
 static int vlm_MediaVodControl( void *, vod_media_t *, const char *, int, va_list );
+static void vlm_SharedInputsLaunch( vlm_t * );
 
 typedef struct preparse_data_t
 {
@@ -85,52 +88,148 @@ static void preparse_on_media_meta_changed(vlc_player_t *player,
 }
 
 
-static void player_on_state_changed(vlc_player_t *player,
-                                    enum vlc_player_state new_state, void *data)
+static enum vlm_state_e vlm_StateFromPlayer(vlc_player_t *player,
+                                            enum vlc_player_state state)
 {
-    vlm_media_sys_t *p_media = data;
-    vlm_t *p_vlm = libvlc_priv( vlc_object_instance(p_media) )->p_vlm;
-    assert( p_vlm );
-    const char *psz_instance_name = NULL;
-
-    for( int i = 0; i < p_media->i_instance; i++ )
-    {
-        if( p_media->instance[i]->player == player )
-        {
-            psz_instance_name = p_media->instance[i]->psz_name;
-            break;
-        }
-    }
-    assert(psz_instance_name);
-    enum vlm_state_e vlm_state;
-    switch (new_state)
+    switch (state)
     {
         case VLC_PLAYER_STATE_STOPPED:
-            vlm_state = vlc_player_GetError(player) ? VLM_ERROR_S : VLM_INIT_S;
-            break;
+            return vlc_player_GetError(player) ? VLM_ERROR_S : VLM_INIT_S;
         case VLC_PLAYER_STATE_STARTED:
-            vlm_state = VLM_OPENING_S;
-            break;
+            return VLM_OPENING_S;
         case VLC_PLAYER_STATE_PLAYING:
-            vlm_state = VLM_PLAYING_S;
-            break;
+            return VLM_PLAYING_S;
         case VLC_PLAYER_STATE_PAUSED:
-            vlm_state = VLM_PAUSE_S;
-            break;
+            return VLM_PAUSE_S;
         case VLC_PLAYER_STATE_STOPPING:
-            vlm_state = vlc_player_GetError(player) ? VLM_ERROR_S : VLM_END_S;
-            break;
+            return vlc_player_GetError(player) ? VLM_ERROR_S : VLM_END_S;
         default:
             vlc_assert_unreachable();
     }
-    vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name, psz_instance_name, vlm_state );
+}
 
+/* Wakes the manage thread up to restart or stop the ended instances */
+static void vlm_SignalManage( vlm_t *p_vlm )
+{
     vlc_mutex_lock( &p_vlm->lock_manage );
     p_vlm->input_state_changed = true;
     vlc_cond_signal( &p_vlm->wait_manage );
     vlc_mutex_unlock( &p_vlm->lock_manage );
 }
 
+/* Updates the resource usage, returns true if an event is due */
+static bool vlm_StatsUpdate( vlm_instance_stats_t *st,
+                             const struct input_stats_t *stats )
+{
+    vlc_tick_t now = vlc_tick_now();
+
+    if( stats->i_cpu_time != VLC_TICK_INVALID )
+    {
+        /* A new input thread starts from zero again */
+        if( st->i_date != VLC_TICK_INVALID && now > st->i_date
+         && stats->i_cpu_time >= st->i_cpu_time )
+            st->f_cpu = 100.f * ( stats->i_cpu_time - st->i_cpu_time )
+                      / (float)( now - st->i_date );
+        st->i_cpu_time = stats->i_cpu_time;
+        st->i_date = now;
+    }
+    st->i_bitrate = lroundf( stats->f_input_bitrate * 8.f * CLOCK_FREQ );
+
+    if( now < st->i_event + VLC_TICK_FROM_SEC(1) )
+        return false;
+    st->i_event = now;
+    return true;
+}
+
+static vlm_media_instance_sys_t *
+vlm_MediaInstanceGetByPlayer( vlm_media_sys_t *p_media, vlc_player_t *player )
+{
+    for( int i = 0; i < p_media->i_instance; i++ )
+        if( p_media->instance[i]->player == player )
+            return p_media->instance[i];
+    return NULL;
+}
+
+static void player_on_state_changed(vlc_player_t *player,
+                                    enum vlc_player_state new_state, void *data)
+{
+    vlm_media_sys_t *p_media = data;
+    vlm_t *p_vlm = libvlc_priv( vlc_object_instance(p_media) )->p_vlm;
+    assert( p_vlm );
+
+    vlm_media_instance_sys_t *p_instance =
+        vlm_MediaInstanceGetByPlayer( p_media, player );
+    assert( p_instance );
+
+    vlm_SendEventMediaInstanceState( p_vlm, p_media->cfg.id, p_media->cfg.psz_name,
+                                     p_instance->psz_name,
+                                     vlm_StateFromPlayer( player, new_state ) );
+    vlm_SignalManage( p_vlm );
+}
+
+static void player_on_statistics_changed(vlc_player_t *player,
+                                         const struct input_stats_t *stats,
+                                         void *data)
+{
+    vlm_media_sys_t *p_media = data;
+    vlm_t *p_vlm = libvlc_priv( vlc_object_instance(p_media) )->p_vlm;
+
+    vlm_media_instance_sys_t *p_instance =
+        vlm_MediaInstanceGetByPlayer( p_media, player );
+    if( p_instance == NULL || !vlm_StatsUpdate( &p_instance->stats, stats ) )
+        return;
+
+    vlm_SendEventMediaInstanceStatistics( p_vlm, p_media->cfg.id,
+                                          p_media->cfg.psz_name,
+                                          p_instance->psz_name,
+                                          p_instance->stats.f_cpu,
+                                          p_instance->stats.i_bitrate );
+}
+
+/* The members of a shared input are not changed while its player is locked,
+ * which is the case in the player callbacks */
+static void shared_on_state_changed(vlc_player_t *player,
+                                    enum vlc_player_state new_state, void *data)
+{
+    vlm_shared_input_t *p_shared = data;
+    vlm_t *p_vlm = libvlc_priv( vlc_object_instance(p_shared->p_parent) )->p_vlm;
+    enum vlm_state_e state = vlm_StateFromPlayer( player, new_state );
+
+    for( int i = 0; i < p_shared->i_member; i++ )
+    {
+        const vlm_media_instance_sys_t *p_instance = p_shared->member[i];
+        const vlm_media_t *p_cfg = &p_instance->p_media->cfg;
+
+        vlm_SendEventMediaInstanceState( p_vlm, p_cfg->id, p_cfg->psz_name,
+                                         p_instance->psz_name, state );
+    }
+    vlm_SignalManage( p_vlm );
+}
+
+static void shared_on_statistics_changed(vlc_player_t *player,
+                                         const struct input_stats_t *stats,
+                                         void *data)
+{
+    vlm_shared_input_t *p_shared = data;
+    vlm_t *p_vlm = libvlc_priv( vlc_object_instance(p_shared->p_parent) )->p_vlm;
+    VLC_UNUSED(player);
+
+    if( !vlm_StatsUpdate( &p_shared->stats, stats ) )
+        return;
+
+    for( int i = 0; i < p_shared->i_member; i++ )
+    {
+        const vlm_media_instance_sys_t *p_instance = p_shared->member[i];
+        const vlm_media_t *p_cfg = &p_instance->p_media->cfg;
+
+        vlm_SendEventMediaInstanceStatistics( p_vlm, p_cfg->id,
+                                              p_cfg->psz_name,
+                                              p_instance->psz_name,
+                                              p_shared->stats.f_cpu,
+                                              p_shared->stats.i_bitrate );
+    }
+}
+
 static vlc_mutex_t vlm_mutex = VLC_STATIC_MUTEX;
 
 /*****************************************************************************
@@ -173,6 +272,7 @@ vlm_t *vlm_New( libvlc_int_t *libvlc, const char *psz_vlmconf )
     p_vlm->i_id = 1;
     TAB_INIT( p_vlm->i_media, p_vlm->media );
     TAB_INIT( p_vlm->i_schedule, p_vlm->schedule );
+    TAB_INIT( p_vlm->i_shared, p_vlm->shared );
     p_vlm->p_vod = NULL;
     var_Create( p_vlm, "intf-event", VLC_VAR_ADDRESS );
 
@@ -238,6 +338,9 @@ void vlm_Delete( vlm_t *p_vlm )
 
     vlm_ControlInternal( p_vlm, VLM_CLEAR_SCHEDULES );
     TAB_CLEAN( p_vlm->i_schedule, p_vlm->schedule );
+    /* the shared inputs are deleted with their last member */
+    assert( p_vlm->i_shared == 0 );
+    TAB_CLEAN( p_vlm->i_shared, p_vlm->shared );
     vlc_mutex_unlock( &p_vlm->lock );
 
     vlc_mutex_lock( &p_vlm->lock_manage );
@@ -272,6 +375,7 @@ int vlm_ExecuteCommand( vlm_t *p_vlm, const char *psz_command,
 
     vlc_mutex_lock( &p_vlm->lock );
     i_result = ExecuteCommand( p_vlm, psz_command, pp_message );
+    vlm_SharedInputsLaunch( p_vlm );
     vlc_mutex_unlock( &p_vlm->lock );
 
     return i_result;
@@ -394,6 +498,22 @@ static int vlm_MediaVodControl( void *p_private, vod_media_t *p_vod_media,
 }
 
 
+/* Returns the first execution date of a schedule after the given date,
+ * or 0 if there is none left */
+static time_t vlm_ScheduleNextDate( const vlm_schedule_sys_t *sched,
+                                    time_t after )
+{
+    if( sched->date > after )
+        return sched->date;
+    if( sched->period <= 0 )
+        return 0;
+
+    time_t n = ( after - sched->date ) / sched->period + 1;
+    if( sched->i_repeat >= 0 && n > sched->i_repeat )
+        return 0;
+    return sched->date + n * sched->period;
+}
+
 /*****************************************************************************
  * Manage:
  *****************************************************************************/
@@ -416,7 +536,10 @@ static void* Manage( void* p_object )
         {
             vlm_media_sys_t *p_media = vlm->media[i];
 
-            for( int j = 0; j < p_media->i_instance; )
+            /* Backward, so that each instance is checked once even if a stop
+             * removes it: the instances that are started again are only
+             * launched at the end if they share their input. */
+            for( int j = p_media->i_instance - 1; j >= 0; j-- )
             {
                 vlm_media_instance_sys_t *p_instance = p_media->instance[j];
 
@@ -436,14 +559,9 @@ static void* Manage( void* p_object )
                         vlm_ControlInternal( vlm, VLM_STOP_MEDIA_INSTANCE, p_media->cfg.id, p_instance->psz_name );
                     else
                         vlm_ControlInternal( vlm, VLM_START_MEDIA_BROADCAST_INSTANCE, p_media->cfg.id, p_instance->psz_name, i_new_input_index );
-
-                    j = 0;
                 }
                 else
-                {
                     vlc_player_Unlock(p_instance->player);
-                    j++;
-                }
             }
         }
 
@@ -454,49 +572,31 @@ static void* Manage( void* p_object )
 
         for( int i = 0; i < vlm->i_schedule; i++ )
         {
-            time_t real_date = vlm->schedule[i]->date;
+            vlm_schedule_sys_t *p_schedule = vlm->schedule[i];
+            time_t real_date;
 
-            if( vlm->schedule[i]->b_enabled )
-            {
-                bool b_now = false;
-                if( vlm->schedule[i]->date == 0 ) // now !
-                {
-                    vlm->schedule[i]->date = now;
-                    real_date = now;
-                    b_now = true;
-                }
-                else if( vlm->schedule[i]->period != 0 )
-                {
-                    int j = 0;
-                    while( ((vlm->schedule[i]->date + j *
-                             vlm->schedule[i]->period) <= lastcheck) &&
-                           ( vlm->schedule[i]->i_repeat > j ||
-                             vlm->schedule[i]->i_repeat < 0 ) )
-                    {
-                        j++;
-                    }
+            if( !p_schedule->b_enabled )
+                continue;
 
-                    real_date = vlm->schedule[i]->date + j *
-                        vlm->schedule[i]->period;
-                }
+            if( p_schedule->date == 0 ) // now !
+                p_schedule->date = real_date = now;
+            else
+                real_date = vlm_ScheduleNextDate( p_schedule, lastcheck );
 
-                if( real_date <= now )
-                {
-                    if( real_date > lastcheck || b_now )
-                    {
-                        for( int j = 0; j < vlm->schedule[i]->i_command; j++ )
-                        {
-                            TAB_APPEND( i_scheduled_commands,
-                                        ppsz_scheduled_commands,
-                                        strdup(vlm->schedule[i]->command[j] ) );
-                        }
-                    }
-                }
-                else if( nextschedule == 0 || real_date < nextschedule )
+            if( real_date != 0 && real_date <= now )
+            {
+                for( int j = 0; j < p_schedule->i_command; j++ )
                 {
-                    nextschedule = real_date;
+                    TAB_APPEND( i_scheduled_commands,
+                                ppsz_scheduled_commands,
+                                strdup( p_schedule->command[j] ) );
                 }
+                real_date = vlm_ScheduleNextDate( p_schedule, now );
             }
+
+            if( real_date != 0
+             && ( nextschedule == 0 || real_date < nextschedule ) )
+                nextschedule = real_date;
         }
 
         while( i_scheduled_commands )
@@ -513,6 +613,8 @@ static void* Manage( void* p_object )
             free( psz_command );
         }
 
+        vlm_SharedInputsLaunch( vlm );
+
         lastcheck = now;
         vlc_mutex_unlock( &vlm->lock );
 
@@ -915,7 +1017,7 @@ static vlm_media_instance_sys_t *vlm_ControlMediaInstanceGetByName( vlm_media_sy
     return NULL;
 }
 
-static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_media_sys_t *p_media, const char *psz_name )
+static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_media_sys_t *p_media, const char *psz_name, bool b_shared )
 {
     vlm_media_instance_sys_t *p_instance = calloc( 1, sizeof(vlm_media_instance_sys_t) );
     if( !p_instance )
@@ -930,6 +1032,13 @@ static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_media_sys_t *p_media,
         goto error;
 
     p_instance->i_index = 0;
+    p_instance->p_media = p_media;
+
+    /* The player comes with the shared input */
+    p_instance->b_shared = b_shared;
+    if( b_shared )
+        return p_instance;
+
     p_instance->p_parent = vlc_object_create( p_media, sizeof (vlc_object_t) );
     if (!p_instance->p_parent)
         goto error;
@@ -941,6 +1050,7 @@ static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_media_sys_t *p_media,
 
     static struct vlc_player_cbs cbs = {
         .on_state_changed = player_on_state_changed,
+        .on_statistics_changed = player_on_statistics_changed,
     };
     vlc_player_Lock(p_instance->player);
     p_instance->listener =
@@ -962,20 +1072,272 @@ error:
     free(p_instance);
     return NULL;
 }
-static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instance_sys_t *p_instance, vlm_media_sys_t *p_media )
+/* Input URI of a media, from a file path or an MRL */
+static char *vlm_MediaInputURI( const vlm_media_t *p_cfg, int i_index )
 {
-    vlc_player_t *player = p_instance->player;
+    const char *psz_input = p_cfg->ppsz_input[i_index];
 
+    if( strstr( psz_input, "://" ) == NULL )
+        return vlc_path2uri( psz_input, NULL );
+    return strdup( psz_input );
+}
+
+/* Instances can share an input if they have the same URI and options */
+static char *vlm_SharedInputKey( const vlm_media_t *p_cfg, const char *psz_uri )
+{
+    struct vlc_memstream stream;
+
+    vlc_memstream_open( &stream );
+    vlc_memstream_puts( &stream, psz_uri );
+    for( int i = 0; i < p_cfg->i_option; i++ )
+        vlc_memstream_printf( &stream, "\n%s", p_cfg->ppsz_option[i] );
+    return vlc_memstream_close( &stream ) ? NULL : stream.ptr;
+}
+
+/* Takes the ownership of the URI and key on success */
+static vlm_shared_input_t *vlm_SharedInputNew( vlm_t *p_vlm, char *psz_uri,
+                                               char *psz_key )
+{
+    vlm_shared_input_t *p_shared = calloc( 1, sizeof( *p_shared ) );
+    if( !p_shared )
+        return NULL;
+
+    p_shared->p_parent = vlc_object_create( p_vlm, sizeof (vlc_object_t) );
+    if( !p_shared->p_parent )
+        goto error;
+
+    p_shared->player = vlc_player_New( p_shared->p_parent,
+                                       VLC_PLAYER_LOCK_NORMAL, NULL, NULL );
+    if( !p_shared->player )
+        goto error;
+
+    static const struct vlc_player_cbs cbs = {
+        .on_state_changed = shared_on_state_changed,
+        .on_statistics_changed = shared_on_statistics_changed,
+    };
+    vlc_player_Lock(p_shared->player);
+    p_shared->listener =
+        vlc_player_AddListener(p_shared->player, &cbs, p_shared);
+    vlc_player_Unlock(p_shared->player);
+    if( !p_shared->listener )
+        goto error;
+
+    p_shared->psz_uri = psz_uri;
+    p_shared->psz_key = psz_key;
+    TAB_INIT( p_shared->i_member, p_shared->member );
+    TAB_APPEND( p_vlm->i_shared, p_vlm->shared, p_shared );
+    return p_shared;
+
+error:
+    if( p_shared->player )
+        vlc_player_Delete( p_shared->player );
+    if( p_shared->p_parent )
+        vlc_object_delete( p_shared->p_parent );
+    free( p_shared );
+    return NULL;
+}
+
+static void vlm_SharedInputDelete( vlm_t *p_vlm, vlm_shared_input_t *p_shared )
+{
+    vlc_player_t *player = p_shared->player;
+
+    assert( p_shared->i_member == 0 );
     vlc_player_Lock(player);
-    vlc_player_RemoveListener(player, p_instance->listener);
+    vlc_player_RemoveListener(player, p_shared->listener);
     vlc_player_Stop(player);
-    bool had_media = vlc_player_GetCurrentMedia(player);
     vlc_player_Unlock(player);
     vlc_player_Delete(player);
+    vlc_object_delete(p_shared->p_parent);
+
+    TAB_REMOVE( p_vlm->i_shared, p_vlm->shared, p_shared );
+    TAB_CLEAN( p_shared->i_member, p_shared->member );
+    if( p_shared->p_item )
+        input_item_Release( p_shared->p_item );
+    free( p_shared->psz_key );
+    free( p_shared->psz_uri );
+    free( p_shared );
+}
 
-    if (had_media)
-        vlm_SendEventMediaInstanceStopped( p_vlm, id, p_media->cfg.psz_name );
-    vlc_object_delete(p_instance->p_parent);
+static int vlm_SharedInputJoin( vlm_t *p_vlm,
+                                vlm_media_instance_sys_t *p_instance,
+                                int i_input_index )
+{
+    const vlm_media_t *p_cfg = &p_instance->p_media->cfg;
+    vlm_shared_input_t *p_shared = NULL;
+
+    char *psz_uri = vlm_MediaInputURI( p_cfg, i_input_index );
+    char *psz_key = psz_uri ? vlm_SharedInputKey( p_cfg, psz_uri ) : NULL;
+    if( psz_key == NULL )
+    {
+        free( psz_uri );
+        return VLC_ENOMEM;
+    }
+
+    /* Outputs can only be added before the input is started */
+    for( int i = 0; i < p_vlm->i_shared; i++ )
+        if( !p_vlm->shared[i]->b_launched
+         && !strcmp( p_vlm->shared[i]->psz_key, psz_key ) )
+        {
+            p_shared = p_vlm->shared[i];
+            break;
+        }
+
+    if( p_shared != NULL )
+    {
+        free( psz_key );
+        free( psz_uri );
+    }
+    else
+    {
+        p_shared = vlm_SharedInputNew( p_vlm, psz_uri, psz_key );
+        if( p_shared == NULL )
+        {
+            free( psz_key );
+            free( psz_uri );
+            return VLC_ENOMEM;
+        }
+    }
+
+    vlc_player_Lock(p_shared->player);
+    TAB_APPEND( p_shared->i_member, p_shared->member, p_instance );
+    vlc_player_Unlock(p_shared->player);
+
+    p_instance->p_shared = p_shared;
+    p_instance->player = p_shared->player;
+    p_instance->i_index = i_input_index;
+    return VLC_SUCCESS;
+}
+
+static void vlm_SharedInputLeave( vlm_t *p_vlm,
+                                  vlm_media_instance_sys_t *p_instance )
+{
+    vlm_shared_input_t *p_shared = p_instance->p_shared;
+    vlc_player_t *player = p_shared->player;
+    const vlm_media_t *p_cfg = &p_instance->p_media->cfg;
+
+    vlc_player_Lock(player);
+    TAB_REMOVE( p_shared->i_member, p_shared->member, p_instance );
+    bool b_launched = p_shared->b_launched;
+    if( b_launched && p_shared->i_member > 0 && vlc_player_IsStarted(player) )
+    {
+        /* An output cannot be removed from a running stream output: the
+         * other members are restarted with the next batch launch. */
+        vlc_player_Stop(player);
+        p_shared->b_launched = false;
+    }
+    vlc_player_Unlock(player);
+
+    p_instance->p_shared = NULL;
+    p_instance->player = NULL;
+
+    if( b_launched )
+        vlm_SendEventMediaInstanceStopped( p_vlm, p_cfg->id, p_cfg->psz_name );
+    if( p_shared->i_member == 0 )
+        vlm_SharedInputDelete( p_vlm, p_shared );
+}
+
+static void vlm_SharedInputLaunch( vlm_t *p_vlm, vlm_shared_input_t *p_shared )
+{
+    const vlm_media_t *p_cfg = &p_shared->member[0]->p_media->cfg;
+    vlc_player_t *player = p_shared->player;
+    input_item_t *p_item = NULL;
+    struct vlc_memstream stream;
+
+    /* On error, the members are stopped as if the input had ended */
+    p_shared->b_launched = true;
+
+    vlc_memstream_open( &stream );
+    if( p_shared->i_member == 1 )
+        vlc_memstream_printf( &stream, "sout=%s",
+                              p_cfg->psz_output ? p_cfg->psz_output : "" );
+    else
+    {
+        vlc_memstream_puts( &stream, "sout=#duplicate{" );
+        for( int i = 0; i < p_shared->i_member; i++ )
+        {
+            const char *psz_output = p_shared->member[i]->p_media->cfg.psz_output;
+
+            if( psz_output == NULL )
+                psz_output = "display";
+            else if( *psz_output == '#' )
+                psz_output++;
+            vlc_memstream_printf( &stream, "%sdst=%s", i ? "," : "",
+                                  psz_output );
+        }
+        vlc_memstream_putc( &stream, '}' );
+    }
+
+    if( vlc_memstream_close( &stream ) == 0 )
+    {
+        p_item = input_item_New( p_shared->psz_uri, NULL );
+        if( p_item )
+        {
+            input_item_AddOption( p_item, stream.ptr, VLC_INPUT_OPTION_TRUSTED );
+            for( int i = 0; i < p_cfg->i_option; i++ )
+                input_item_AddOption( p_item, p_cfg->ppsz_option[i],
+                                      VLC_INPUT_OPTION_TRUSTED );
+        }
+        free( stream.ptr );
+    }
+
+    if( p_item )
+    {
+        vlc_player_Lock(player);
+        vlc_player_SetCurrentMedia(player, p_item);
+        vlc_player_Start(player);
+        vlc_player_Unlock(player);
+    }
+
+    if( p_shared->p_item )
+        input_item_Release( p_shared->p_item );
+    p_shared->p_item = p_item;
+
+    if( p_item == NULL )
+    {
+        vlm_SignalManage( p_vlm );
+        return;
+    }
+
+    msg_Dbg( p_vlm, "input %s shared by %d outputs", p_shared->psz_uri,
+             p_shared->i_member );
+    for( int i = 0; i < p_shared->i_member; i++ )
+    {
+        const vlm_media_t *p_mcfg = &p_shared->member[i]->p_media->cfg;
+        vlm_SendEventMediaInstanceStarted( p_vlm, p_mcfg->id, p_mcfg->psz_name );
+    }
+}
+
+/* Starts the shared inputs, once all the commands of a batch have added
+ * their outputs. Must be called before releasing the VLM lock. */
+static void vlm_SharedInputsLaunch( vlm_t *p_vlm )
+{
+    for( int i = 0; i < p_vlm->i_shared; i++ )
+        if( !p_vlm->shared[i]->b_launched )
+            vlm_SharedInputLaunch( p_vlm, p_vlm->shared[i] );
+}
+
+static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instance_sys_t *p_instance, vlm_media_sys_t *p_media )
+{
+    if( p_instance->b_shared )
+    {
+        if( p_instance->p_shared != NULL )
+            vlm_SharedInputLeave( p_vlm, p_instance );
+    }
+    else
+    {
+        vlc_player_t *player = p_instance->player;
+
+        vlc_player_Lock(player);
+        vlc_player_RemoveListener(player, p_instance->listener);
+        vlc_player_Stop(player);
+        bool had_media = vlc_player_GetCurrentMedia(player);
+        vlc_player_Unlock(player);
+        vlc_player_Delete(player);
+
+        if (had_media)
+            vlm_SendEventMediaInstanceStopped( p_vlm, id, p_media->cfg.psz_name );
+        vlc_object_delete(p_instance->p_parent);
+    }
 
     TAB_REMOVE( p_media->i_instance, p_media->instance, p_instance );
     input_item_Release( p_instance->p_item );
@@ -984,6 +1346,37 @@ static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instanc
 }
 
 
+static int vlm_MediaInstanceStartShared( vlm_t *p_vlm, vlm_media_sys_t *p_media,
+                                         vlm_media_instance_sys_t *p_instance,
+                                         int i_input_index )
+{
+    vlm_shared_input_t *p_shared = p_instance->p_shared;
+
+    if( p_shared != NULL )
+    {
+        vlc_player_t *player = p_shared->player;
+
+        vlc_player_Lock(player);
+        if( p_instance->i_index == i_input_index
+         && ( !p_shared->b_launched || vlc_player_IsStarted(player) ) )
+        {
+            if (vlc_player_IsPaused(player))
+                vlc_player_Resume(player);
+            vlc_player_Unlock(player);
+            return VLC_SUCCESS;
+        }
+        vlc_player_Unlock(player);
+
+        vlm_SharedInputLeave( p_vlm, p_instance );
+    }
+
+    /* The input is started by the end of the current batch of commands */
+    int i_ret = vlm_SharedInputJoin( p_vlm, p_instance, i_input_index );
+    if( i_ret != VLC_SUCCESS )
+        vlm_MediaInstanceDelete( p_vlm, p_media->cfg.id, p_instance, p_media );
+    return i_ret;
+}
+
 static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *psz_id, int i_input_index, const char *psz_vod_output )
 {
     vlm_media_sys_t *p_media = vlm_ControlMediaGetById( p_vlm, id );
@@ -1004,38 +1397,49 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
     if( !p_instance )
     {
         vlm_media_t *p_cfg = &p_media->cfg;
+        bool b_shared = !p_cfg->b_vod && p_cfg->broadcast.b_share
+                     && p_cfg->psz_output != NULL;
 
-        p_instance = vlm_MediaInstanceNew( p_media, psz_id );
+        p_instance = vlm_MediaInstanceNew( p_media, psz_id, b_shared );
         if( !p_instance )
             return VLC_ENOMEM;
 
-        if ( p_cfg->b_vod )
+        if( b_shared )
+            TAB_APPEND( p_media->i_instance, p_media->instance, p_instance );
+        else
         {
-            var_Create( p_instance->p_parent, "vod-media", VLC_VAR_ADDRESS );
-            var_SetAddress( p_instance->p_parent, "vod-media",
-                            p_media->vod.p_media );
-            var_Create( p_instance->p_parent, "vod-session", VLC_VAR_STRING );
-            var_SetString( p_instance->p_parent, "vod-session", psz_id );
-        }
+            if ( p_cfg->b_vod )
+            {
+                var_Create( p_instance->p_parent, "vod-media", VLC_VAR_ADDRESS );
+                var_SetAddress( p_instance->p_parent, "vod-media",
+                                p_media->vod.p_media );
+                var_Create( p_instance->p_parent, "vod-session", VLC_VAR_STRING );
+                var_SetString( p_instance->p_parent, "vod-session", psz_id );
+            }
 
-        if( p_cfg->psz_output != NULL || psz_vod_output != NULL )
-        {
-            char *psz_buffer;
-            if( asprintf( &psz_buffer, "sout=%s%s%s",
-                      p_cfg->psz_output ? p_cfg->psz_output : "",
-                      (p_cfg->psz_output && psz_vod_output) ? ":" : psz_vod_output ? "#" : "",
-                      psz_vod_output ? psz_vod_output : "" ) != -1 )
+            if( p_cfg->psz_output != NULL || psz_vod_output != NULL )
             {
-                input_item_AddOption( p_instance->p_item, psz_buffer, VLC_INPUT_OPTION_TRUSTED );
-                free( psz_buffer );
+                char *psz_buffer;
+                if( asprintf( &psz_buffer, "sout=%s%s%s",
+                          p_cfg->psz_output ? p_cfg->psz_output : "",
+                          (p_cfg->psz_output && psz_vod_output) ? ":" : psz_vod_output ? "#" : "",
+                          psz_vod_output ? psz_vod_output : "" ) != -1 )
+                {
+                    input_item_AddOption( p_instance->p_item, psz_buffer, VLC_INPUT_OPTION_TRUSTED );
+                    free( psz_buffer );
+                }
             }
-        }
 
-        for( int i = 0; i < p_cfg->i_option; i++ )
-            input_item_AddOption( p_instance->p_item, p_cfg->ppsz_option[i], VLC_INPUT_OPTION_TRUSTED );
-        TAB_APPEND( p_media->i_instance, p_media->instance, p_instance );
+            for( int i = 0; i < p_cfg->i_option; i++ )
+                input_item_AddOption( p_instance->p_item, p_cfg->ppsz_option[i], VLC_INPUT_OPTION_TRUSTED );
+            TAB_APPEND( p_media->i_instance, p_media->instance, p_instance );
+        }
     }
 
+    if( p_instance->b_shared )
+        return vlm_MediaInstanceStartShared( p_vlm, p_media, p_instance,
+                                             i_input_index );
+
     /* Stop old instance */
     vlc_player_t *player = p_instance->player;
     vlc_player_Lock(player);
@@ -1045,6 +1449,7 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
         {
             if (vlc_player_IsPaused(player))
                 vlc_player_Resume(player);
+            vlc_player_Unlock(player);
             return VLC_SUCCESS;
         }
 
@@ -1056,15 +1461,14 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
 
     /* Start new one */
     p_instance->i_index = i_input_index;
-    if( strstr( p_media->cfg.ppsz_input[p_instance->i_index], "://" ) == NULL )
+    char *psz_uri = vlm_MediaInputURI( &p_media->cfg, p_instance->i_index );
+    if( psz_uri == NULL )
     {
-        char *psz_uri = vlc_path2uri(
-                          p_media->cfg.ppsz_input[p_instance->i_index], NULL );
-        input_item_SetURI( p_instance->p_item, psz_uri ) ;
-        free( psz_uri );
+        vlc_player_Unlock(player);
+        return VLC_ENOMEM;
     }
-    else
-        input_item_SetURI( p_instance->p_item, p_media->cfg.ppsz_input[p_instance->i_index] ) ;
+    input_item_SetURI( p_instance->p_item, psz_uri );
+    free( psz_uri );
 
     vlc_player_SetCurrentMedia(player, p_instance->p_item);
     vlc_player_Start(player);
@@ -1171,6 +1575,10 @@ static int vlm_ControlMediaInstanceGets( vlm_t *p_vlm, int64_t id, vlm_media_ins
         p_idsc->d_position = vlc_player_GetPosition(p_instance->player);
         p_idsc->b_paused = vlc_player_IsPaused(p_instance->player);
         p_idsc->f_rate = vlc_player_GetRate(p_instance->player);
+        p_idsc->f_cpu = vlm_InstanceStats(p_instance)->f_cpu;
+        p_idsc->i_bitrate = vlm_InstanceStats(p_instance)->i_bitrate;
+        p_idsc->b_shared = p_instance->p_shared != NULL
+                        && p_instance->p_shared->i_member > 1;
         vlc_player_Unlock(p_instance->player);
 
         TAB_APPEND( i_idsc, pp_idsc, p_idsc );
@@ -1343,6 +1751,7 @@ int vlm_Control( vlm_t *p_vlm, int i_query, ... )
 
     vlc_mutex_lock( &p_vlm->lock );
     i_result = vlm_vaControlInternal( p_vlm, i_query, args );
+    vlm_SharedInputsLaunch( p_vlm );
     vlc_mutex_unlock( &p_vlm->lock );
 
     va_end( args );
@@ -67,6 +67,20 @@ void vlm_SendEventMediaInstanceState( vlm_t *p_vlm, int64_t id, const char *psz_
     TriggerInstanceState( p_vlm, VLM_EVENT_MEDIA_INSTANCE_STATE, id, psz_name, psz_instance_name, state );
 }
 
+void vlm_SendEventMediaInstanceStatistics( vlm_t *p_vlm, int64_t id, const char *psz_name, const char *psz_instance_name, float f_cpu, int64_t i_bitrate )
+{
+    vlm_event_t event;
+
+    event.i_type = VLM_EVENT_MEDIA_INSTANCE_STATISTICS;
+    event.id = id;
+    event.psz_name = psz_name;
+    event.input_state = 0;
+    event.psz_instance_name = psz_instance_name;
+    event.f_cpu = f_cpu;
+    event.i_bitrate = i_bitrate;
+    var_SetAddress( p_vlm, "intf-event", &event );
+}
+
 /*****************************************************************************
  *
  *****************************************************************************/
@@ -79,6 +93,8 @@ static void Trigger( vlm_t *p_vlm, int i_type, int64_t id, const char *psz_name
     event.psz_name = psz_name;
     event.input_state = 0;
     event.psz_instance_name = NULL;
+    event.f_cpu = 0.f;
+    event.i_bitrate = 0;
     var_SetAddress( p_vlm, "intf-event", &event );
 }
 
@@ -91,5 +107,7 @@ static void TriggerInstanceState( vlm_t *p_vlm, int i_type, int64_t id, const ch
     event.psz_name = psz_name;
     event.input_state = input_state;
     event.psz_instance_name = psz_instance_name;
+    event.f_cpu = 0.f;
+    event.i_bitrate = 0;
     var_SetAddress( p_vlm, "intf-event", &event );
 }
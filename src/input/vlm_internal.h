@@ -28,6 +28,19 @@
 #include "input_interface.h"
 
 /* Private */
+typedef struct vlm_media_sys_t vlm_media_sys_t;
+typedef struct vlm_shared_input_t vlm_shared_input_t;
+
+/* Resource usage of a running input, updated from the player statistics */
+typedef struct
+{
+    float      f_cpu;       /* CPU usage of the input thread, in percent */
+    int64_t    i_bitrate;   /* input bitrate, in bits/s */
+    vlc_tick_t i_cpu_time;  /* last input thread CPU time */
+    vlc_tick_t i_date;      /* date of the last statistics */
+    vlc_tick_t i_event;     /* date of the last statistics event */
+} vlm_instance_stats_t;
+
 typedef struct
 {
     /* instance name */
@@ -36,15 +49,42 @@ typedef struct
     /* "playlist" index */
     int i_index;
 
+    vlm_media_sys_t *p_media;
     vlc_object_t *p_parent;
     input_item_t      *p_item;
-    vlc_player_t *player;
+    vlc_player_t *player; /* owned by the shared input if b_shared */
     vlc_player_listener_id *listener;
+    vlm_instance_stats_t stats;
+
+    /* broadcast instance adding its output to a shared input */
+    bool b_shared;
+    vlm_shared_input_t *p_shared;
 
 } vlm_media_instance_sys_t;
 
+/* Broadcast input demuxed once for all the instances with the same input
+ * and options: the outputs of the members are duplicated from one player.
+ * The member list is protected by the player lock. */
+struct vlm_shared_input_t
+{
+    char *psz_uri;
+    char *psz_key;          /* URI and options */
 
-typedef struct
+    vlc_object_t *p_parent;
+    input_item_t *p_item;
+    vlc_player_t *player;
+    vlc_player_listener_id *listener;
+    vlm_instance_stats_t stats;
+
+    /* false until the outputs of the members are known */
+    bool b_launched;
+
+    int i_member;
+    vlm_media_instance_sys_t **member;
+};
+
+
+struct vlm_media_sys_t
 {
     struct vlc_object_t obj;
     vlm_media_t cfg;
@@ -58,7 +98,7 @@ typedef struct
     /* actual input instances */
     int                      i_instance;
     vlm_media_instance_sys_t **instance;
-} vlm_media_sys_t;
+};
 
 typedef struct
 {
@@ -106,8 +146,19 @@ struct vlm_t
     /* Schedule list */
     int            i_schedule;
     vlm_schedule_sys_t **schedule;
+
+    /* Shared broadcast inputs */
+    int                i_shared;
+    vlm_shared_input_t **shared;
 };
 
+static inline const vlm_instance_stats_t *
+vlm_InstanceStats( const vlm_media_instance_sys_t *p_instance )
+{
+    return p_instance->p_shared != NULL ? &p_instance->p_shared->stats
+                                        : &p_instance->stats;
+}
+
 int vlm_ControlInternal( vlm_t *p_vlm, int i_query, ... );
 int ExecuteCommand( vlm_t *, const char *, vlm_message_t ** );
 void vlm_ScheduleDelete( vlm_t *vlm, vlm_schedule_sys_t *sched );
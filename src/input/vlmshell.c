@@ -323,6 +323,7 @@ static int ExecuteHelp( vlm_message_t **pp_status )
     MessageAddChild( "option (option_name)[=value]" );
     MessageAddChild( "enabled|disabled" );
     MessageAddChild( "loop|unloop (broadcast only)" );
+    MessageAddChild( "share|unshare (broadcast only)" );
     MessageAddChild( "mux (mux_name)" );
 
     message_child = MessageAdd( "Schedule Proprieties Syntax:" );
@@ -740,6 +741,18 @@ static int ExecuteMediaProperty( vlm_t *p_vlm, int64_t id, bool b_new,
                 ERROR( "invalid unloop option for vod" );
             p_cfg->broadcast.b_loop = false;
         }
+        else if( !strcmp( psz_option, "share" ) )
+        {
+            if( p_cfg->b_vod )
+                ERROR( "invalid share option for vod" );
+            p_cfg->broadcast.b_share = true;
+        }
+        else if( !strcmp( psz_option, "unshare" ) )
+        {
+            if( p_cfg->b_vod )
+                ERROR( "invalid unshare option for vod" );
+            p_cfg->broadcast.b_share = false;
+        }
         else if( !strcmp( psz_option, "mux" ) )
         {
             MISSING( "mux" );
@@ -1297,8 +1310,12 @@ static vlm_message_t *vlm_ShowMedia( vlm_media_sys_t *p_media )
         vlm_MessageAdd( p_msg,
                         vlm_MessageNew( "mux", "%s", p_cfg->vod.psz_mux ) );
     else
+    {
         vlm_MessageAdd( p_msg,
                         vlm_MessageNew( "loop", p_cfg->broadcast.b_loop ? "yes" : "no" ) );
+        vlm_MessageAdd( p_msg,
+                        vlm_MessageNew( "share", p_cfg->broadcast.b_share ? "yes" : "no" ) );
+    }
 
     p_msg_sub = vlm_MessageAdd( p_msg, vlm_MessageSimpleNew( "inputs" ) );
     for( i = 0; i < p_cfg->i_input; i++ )
@@ -1334,6 +1351,8 @@ static vlm_message_t *vlm_ShowMedia( vlm_media_sys_t *p_media )
         ssize_t title = vlc_player_GetSelectedTitleIdx(p_instance->player);
         ssize_t chapter = vlc_player_GetSelectedChapterIdx(p_instance->player);
         bool can_seek = vlc_player_CanSeek(p_instance->player);
+        vlm_instance_stats_t stats = *vlm_InstanceStats(p_instance);
+        int outputs = p_instance->p_shared ? p_instance->p_shared->i_member : 1;
         vlc_player_Unlock(p_instance->player);
 
         p_msg_instance = vlm_MessageAdd( p_msg_sub, vlm_MessageSimpleNew( "instance" ) );
@@ -1356,6 +1375,9 @@ static vlm_message_t *vlm_ShowMedia( vlm_media_sys_t *p_media )
         APPEND_INPUT_INFO( "title", "%zd", title );
         APPEND_INPUT_INFO( "chapter", "%zd", chapter );
         APPEND_INPUT_INFO( "can-seek", "%d", can_seek );
+        APPEND_INPUT_INFO( "cpu", "%.1f", stats.f_cpu );
+        APPEND_INPUT_INFO( "bitrate", "%"PRId64, stats.i_bitrate );
+        APPEND_INPUT_INFO( "outputs", "%d", outputs );
 #undef APPEND_INPUT_INFO
         vlm_MessageAdd( p_msg_instance, vlm_MessageNew( "playlistindex",
                         "%d", p_instance->i_index + 1 ) );
@@ -1615,6 +1637,8 @@ static char *Save( vlm_t *vlm )
 
         if( !p_cfg->b_vod && p_cfg->broadcast.b_loop )
             vlc_memstream_puts( &stream, " loop" );
+        if( !p_cfg->b_vod && p_cfg->broadcast.b_share )
+            vlc_memstream_puts( &stream, " share" );
         vlc_memstream_putc( &stream, '\n' );
 
         for( int j = 0; j < p_cfg->i_input; j++ )
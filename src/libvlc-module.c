@@ -89,6 +89,12 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Write log messages from a dedicated thread, so that logging does not " \
+    "block the decoding and output threads. Messages are dropped if the " \
+    "logger cannot keep up.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -122,6 +128,11 @@ static const char *const ppsz_snap_formats[] =
     "The default behavior is to automatically select the best method " \
     "available.")
 
+#define AOUT_SINKS_TEXT N_("Extra audio outputs")
+#define AOUT_SINKS_LONGTEXT N_( \
+    "Additional audio output modules playing the same audio as the main " \
+    "one, once filtered. Each of them is synchronized separately.")
+
 #define ROLE_TEXT N_("Media role")
 #define ROLE_LONGTEXT N_("Media (player) role for operating system policy.")
 
@@ -363,13 +374,13 @@ static const char * const  ppsz_deinterlace_text[] = {
     "Deinterlace method to use for video processing.")
 static const char * const ppsz_deinterlace_mode[] = {
     "auto", "discard", "blend", "mean", "bob",
-    "linear", "x", "yadif", "yadif2x", "phosphor",
+    "linear", "x", "yadif", "yadif2x", "bwdif", "bwdif2x", "phosphor",
     "ivtc"
 };
 static const char * const ppsz_deinterlace_mode_text[] = {
     N_("Auto"), N_("Discard"), N_("Blend"), N_("Mean"), N_("Bob"),
-    N_("Linear"), "X", "Yadif", "Yadif (2x)", N_("Phosphor"),
-    N_("Film NTSC (IVTC)")
+    N_("Linear"), "X", "Yadif", "Yadif (2x)", "Bwdif", "Bwdif (2x)",
+    N_("Phosphor"), N_("Film NTSC (IVTC)")
 };
 
 static const int pi_pos_values[] = { 0, 1, 2, 4, 8, 5, 6, 9, 10 };
@@ -490,6 +501,12 @@ static const char *const screensaver_texts[] = {
     "This drops frames that are late (arrive to the video output after " \
     "their intended display date)." )
 
+#define PREPARE_AHEAD_TEXT N_("Prepare pictures ahead of time")
+#define PREPARE_AHEAD_LONGTEXT N_( \
+    "This renders, blends and converts the next picture as soon as the " \
+    "current one is displayed, so that only the display work is left when " \
+    "it is due. This uses more picture buffers." )
+
 #define QUIET_SYNCHRO_TEXT N_("Quiet synchro")
 #define QUIET_SYNCHRO_LONGTEXT N_( \
     "This avoids flooding the message log with debug output from the " \
@@ -545,6 +562,18 @@ static const char *const screensaver_texts[] = {
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define CLOCK_JITTER_ADAPTIVE_TEXT N_("Adaptive clock jitter")
+#define CLOCK_JITTER_ADAPTIVE_LONGTEXT N_( \
+    "Adapt the delay compensating the input jitter of live sources to the " \
+    "jitter measured on their clock references, within the minimum clock " \
+    "jitter and the clock jitter. This allows lower caching values on " \
+    "steady network paths." )
+
+#define CLOCK_JITTER_MIN_TEXT N_("Minimum clock jitter")
+#define CLOCK_JITTER_MIN_LONGTEXT N_( \
+    "This defines the smallest input delay jitter compensation of the " \
+    "adaptive clock jitter (in milliseconds)." )
+
 #define CLOCK_MASTER_TEXT N_("Clock master source")
 
 static const int pi_clock_master_values[] = {
@@ -561,6 +590,12 @@ static const char *const ppsz_clock_master_descriptions[] = {
         "synchronise clocks for server and client. The detailed settings " \
         "are available in Advanced / Network Sync." )
 
+#define INPUT_TRACK_STANDBY_TEXT N_("Fast track switching")
+#define INPUT_TRACK_STANDBY_LONGTEXT N_( \
+    "Keep the recent data of the audio and subtitle tracks not being " \
+    "played, as much as the input caching, so that switching to one of " \
+    "them resumes immediately at the current position." )
+
 static const int pi_clock_values[] = { -1, 0, 1 };
 static const char *const ppsz_clock_descriptions[] =
 { N_("Default"), N_("Disable"), N_("Enable") };
@@ -723,6 +758,12 @@ static const char *const ppsz_prefres[] = {
     "When possible, the input stream will be recorded instead of using " \
     "the stream output module" )
 
+#define INPUT_RECORD_PREROLL_TEXT N_("Record pre-roll (seconds)")
+#define INPUT_RECORD_PREROLL_LONGTEXT N_( \
+    "Keep the last seconds of the streams in memory while not recording, " \
+    "and start the records with them. This does not apply to the native " \
+    "stream recording." )
+
 #define INPUT_TIMESHIFT_PATH_TEXT N_("Timeshift directory")
 #define INPUT_TIMESHIFT_PATH_LONGTEXT N_( \
     "Directory used to store the timeshift temporary files." )
@@ -732,6 +773,12 @@ static const char *const ppsz_prefres[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_SIZE_TEXT N_("Timeshift window (MiB)")
+#define INPUT_TIMESHIFT_SIZE_LONGTEXT N_( \
+    "If non-zero, live streams are continuously kept in a circular file " \
+    "of this size, so that playback can be paused and jump back within " \
+    "it. The oldest data are overwritten." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -980,6 +1027,17 @@ static const char *const ppsz_prefres[] = {
     "VLC will fallback automatically to software decoders in case of " \
     "hardware decoder failure." )
 
+#define DEC_THREADS_TEXT N_("Decoding threads budget")
+#define DEC_THREADS_LONGTEXT N_( \
+    "Maximum number of threads shared by all the software decoders of " \
+    "the process. Additional decoders get a single thread once it is " \
+    "exhausted. 0 means one more than the number of CPUs." )
+
+#define DEC_THREADS_PRIORITY_TEXT N_("Decoding threads priority")
+#define DEC_THREADS_PRIORITY_LONGTEXT N_( \
+    "Share of the decoding threads budget given to the decoders of an " \
+    "input, relative to the other inputs." )
+
 #define ENCODER_TEXT N_("Preferred encoders list")
 #define ENCODER_LONGTEXT N_( \
     "This allows you to select a list of encoders that VLC will use in " \
@@ -1109,6 +1167,16 @@ static const char *const ppsz_prefres[] = {
     "priorities. You can use it to tune VLC priority against other " \
     "programs, or against other VLC instances.")
 
+#define HUGEPAGES_TEXT N_("Huge pages for pictures")
+#define HUGEPAGES_LONGTEXT N_( \
+    "Back the large picture buffers with huge pages, to reduce the TLB " \
+    "misses of the filters processing large videos. Transparent huge " \
+    "pages depend on the kernel configuration, explicit huge pages must " \
+    "be reserved by the system administrator.")
+static const int pi_hugepages_values[] = { 0, 1, 2 };
+static const char *const ppsz_hugepages_descriptions[] = {
+    N_("Disable"), N_("Transparent"), N_("Explicit") };
+
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
      "reading a stream")
@@ -1130,6 +1198,11 @@ static const char *const ppsz_prefres[] = {
 #define KEYSTORE_LONGTEXT N_( \
     "List of keystores that VLC will use in priority." )
 
+#define TRACER_TEXT N_("Tracer module")
+#define TRACER_LONGTEXT N_( \
+    "Module recording a timeline of the processing stages, to analyze " \
+    "the latency of the pipeline. Tracing is disabled by default." )
+
 #define STATS_TEXT N_("Locally collect statistics")
 #define STATS_LONGTEXT N_( \
      "Collect miscellaneous local statistics about the playing media.")
@@ -1217,6 +1290,11 @@ static const char *const clock_sources_text[] = {
 #define PREPARSE_THREADS_LONGTEXT N_( \
     "Maximum number of threads used to preparse items" )
 
+#define PREPARSE_HOST_THREADS_TEXT N_( "Preparsing threads per host" )
+#define PREPARSE_HOST_THREADS_LONGTEXT N_( \
+    "Maximum number of threads used to preparse items from the same " \
+    "network host (0 for no limit)" )
+
 #define FETCH_ART_THREADS_TEXT N_( "Fetch-art threads" )
 #define FETCH_ART_THREADS_LONGTEXT N_( \
     "Maximum number of threads used to fetch art" )
@@ -1279,6 +1357,11 @@ static const char *const psz_recursive_list_text[] = {
 #define SP_LONGTEXT N_( \
     "Pause each item in the playlist on the first frame." )
 
+#define GAPLESS_PREOPEN_TEXT N_("Next item pre-opening delay")
+#define GAPLESS_PREOPEN_LONGTEXT N_( \
+    "Open the next item of the playlist this many seconds before the end " \
+    "of the current one, so that they play without a gap (0 to disable)." )
+
 #define AUTOSTART_TEXT N_( "Auto start" )
 #define AUTOSTART_LONGTEXT N_( "Automatically start playing the playlist " \
                 "content once it's loaded." )
@@ -1633,6 +1716,8 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_AUDIO_AOUT )
     add_module("aout", "audio output", NULL, AOUT_TEXT, AOUT_LONGTEXT)
         change_short('A')
+    add_module_list("aout-sinks", "audio output", NULL,
+                    AOUT_SINKS_TEXT, AOUT_SINKS_LONGTEXT)
     add_string( "role", "video", ROLE_TEXT, ROLE_LONGTEXT, true )
         change_string_list( ppsz_roles, ppsz_roles_text )
 
@@ -1668,6 +1753,8 @@ vlc_module_begin ()
         change_private ()
     add_bool( "drop-late-frames", 1, DROP_LATE_FRAMES_TEXT,
               DROP_LATE_FRAMES_LONGTEXT, true )
+    add_bool( "video-prepare-ahead", false, PREPARE_AHEAD_TEXT,
+              PREPARE_AHEAD_LONGTEXT, true )
     /* Used in vout_synchro */
     add_bool( "skip-frames", 1, SKIP_FRAMES_TEXT,
               SKIP_FRAMES_LONGTEXT, true )
@@ -2035,22 +2122,37 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_bool( "clock-jitter-adaptive", false, CLOCK_JITTER_ADAPTIVE_TEXT,
+              CLOCK_JITTER_ADAPTIVE_LONGTEXT, true )
+        change_safe()
+    add_integer( "clock-jitter-min", 0, CLOCK_JITTER_MIN_TEXT,
+                 CLOCK_JITTER_MIN_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
+        change_safe()
     add_integer( "clock-master", VLC_CLOCK_MASTER_DEFAULT,
                  CLOCK_MASTER_TEXT, NULL, true )
         change_integer_list( pi_clock_master_values, ppsz_clock_master_descriptions )
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
+    add_bool( "input-track-standby", false, INPUT_TRACK_STANDBY_TEXT,
+              INPUT_TRACK_STANDBY_LONGTEXT, true )
 
     add_directory("input-record-path", NULL,
                   INPUT_RECORD_PATH_TEXT, INPUT_RECORD_PATH_LONGTEXT)
     add_bool( "input-record-native", true, INPUT_RECORD_NATIVE_TEXT,
               INPUT_RECORD_NATIVE_LONGTEXT, true )
+    add_integer( "input-record-preroll", 0, INPUT_RECORD_PREROLL_TEXT,
+                 INPUT_RECORD_PREROLL_LONGTEXT, true )
+        change_integer_range( 0, 600 )
 
     add_directory("input-timeshift-path", NULL,
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-size", 0, INPUT_TIMESHIFT_SIZE_TEXT,
+                 INPUT_TIMESHIFT_SIZE_LONGTEXT, true )
+        change_integer_range( 0, 65536 )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -2062,6 +2164,13 @@ vlc_module_begin ()
     add_string( "codec", NULL, CODEC_TEXT,
                 CODEC_LONGTEXT, true )
     add_bool( "hw-dec", true, HW_DEC_TEXT, HW_DEC_LONGTEXT, true )
+    add_integer( "dec-threads", 0, DEC_THREADS_TEXT,
+                 DEC_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 256 )
+    add_integer( "dec-threads-priority", 1, DEC_THREADS_PRIORITY_TEXT,
+                 DEC_THREADS_PRIORITY_LONGTEXT, true )
+        change_integer_range( 1, 16 )
+        change_safe()
     add_string( "encoder",  NULL, ENCODER_TEXT,
                 ENCODER_LONGTEXT, true )
     add_module("dec-dev", "decoder device", "any", DEC_DEV_TEXT, DEC_DEV_LONGTEXT)
@@ -2175,6 +2284,11 @@ vlc_module_begin ()
                  RT_OFFSET_LONGTEXT, true )
 #endif
 
+    add_integer( "picture-hugepages", 1, HUGEPAGES_TEXT,
+                 HUGEPAGES_LONGTEXT, true )
+        change_integer_list( pi_hugepages_values,
+                             ppsz_hugepages_descriptions )
+
 #if defined(HAVE_DBUS)
     add_obsolete_bool( "inhibit" ) /* since 3.0.0 */
 #endif
@@ -2208,6 +2322,9 @@ vlc_module_begin ()
     add_bool( "play-and-pause", 0, PAP_TEXT, PAP_LONGTEXT, true )
         change_safe()
     add_bool( "start-paused", 0, SP_TEXT, SP_LONGTEXT, false )
+    add_integer( "gapless-preopen", 5, GAPLESS_PREOPEN_TEXT,
+                 GAPLESS_PREOPEN_LONGTEXT, true )
+        change_integer_range( 0, 60 )
     add_bool( "playlist-autostart", true,
               AUTOSTART_TEXT, AUTOSTART_LONGTEXT, false )
     add_bool( "playlist-cork", true, CORK_TEXT, CORK_LONGTEXT, false )
@@ -2240,6 +2357,9 @@ vlc_module_begin ()
     add_integer( "preparse-threads", 1, PREPARSE_THREADS_TEXT,
                  PREPARSE_THREADS_LONGTEXT, false )
 
+    add_integer( "preparse-host-threads", 1, PREPARSE_HOST_THREADS_TEXT,
+                 PREPARSE_HOST_THREADS_LONGTEXT, false )
+
     add_integer( "fetch-art-threads", 1, FETCH_ART_THREADS_TEXT,
                  FETCH_ART_THREADS_LONGTEXT, false )
 
@@ -2271,6 +2391,7 @@ vlc_module_begin ()
                  false )
         change_short('v')
         change_volatile ()
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT, true )
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
 #if !defined(_WIN32) && !defined(__OS2__)
     add_bool( "daemon", 0, DAEMON_TEXT, DAEMON_LONGTEXT, true )
@@ -2291,6 +2412,7 @@ vlc_module_begin ()
               INTERACTION_LONGTEXT, false )
 
     add_bool ( "stats", true, STATS_TEXT, STATS_LONGTEXT, true )
+    add_module("tracer", "tracer", NULL, TRACER_TEXT, TRACER_LONGTEXT)
 
     set_subcategory( SUBCAT_INTERFACE_MAIN )
     add_module_cat("intf", SUBCAT_INTERFACE_MAIN, NULL,
@@ -42,6 +42,7 @@
 #include "config/configuration.h"
 #include "preparser/preparser.h"
 #include "media_source/media_source.h"
+#include "misc/picture.h"
 
 #include <stdio.h>                                              /* sprintf() */
 #include <string.h>
@@ -95,6 +96,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv->main_playlist = NULL;
     priv->p_vlm = NULL;
     priv->media_source_provider = NULL;
+    priv->tracer = NULL;
 
     vlc_ExitInit( &priv->exit );
 
@@ -165,6 +167,8 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
         goto error;
 
     vlc_LogInit(p_libvlc);
+    vlc_TracerInit(p_libvlc);
+    picture_SetHugePages(var_InheritInteger(p_libvlc, "picture-hugepages"));
 
     /*
      * Support for gettext
@@ -435,10 +439,21 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
 
     libvlc_InternalActionsClean( p_libvlc );
 
+    vlc_mutex_profile_Dump( VLC_OBJECT(p_libvlc) );
+
     /* Save the configuration */
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
 
+    /* The video outputs are gone, do not keep their buffers */
+    picture_CacheFlush();
+
+    unsigned long thp, hugetlb;
+    picture_GetHugePagesStats(&thp, &hugetlb);
+    msg_Dbg(p_libvlc, "%lu picture buffers advised as transparent huge pages, "
+            "%lu backed by explicit huge pages", thp, hugetlb);
+
+    vlc_TracerDestroy( p_libvlc );
     vlc_LogDestroy(p_libvlc->obj.logger);
     /* Free module bank. It is refcounted, so we call this each time  */
     module_EndBank (true);
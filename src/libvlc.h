@@ -69,14 +69,90 @@ void vlc_mutex_unmark(const vlc_mutex_t *);
 # define vlc_mutex_unmark(m) ((void)(m))
 #endif
 
+#ifdef ENABLE_LOCK_PROFILING
+/**
+ * Records the creation of a mutex from the given code address.
+ */
+void vlc_mutex_profile_init(const vlc_mutex_t *, const void *site);
+
+/**
+ * Forgets a destroyed mutex.
+ */
+void vlc_mutex_profile_destroy(const vlc_mutex_t *);
+
+/**
+ * Records a mutex being locked, and how long it was waited for if another
+ * thread held it.
+ */
+void vlc_mutex_profile_lock(const vlc_mutex_t *, const void *site,
+                            bool contended, vlc_tick_t wait);
+
+/**
+ * Records a mutex being unlocked.
+ */
+void vlc_mutex_profile_unlock(const vlc_mutex_t *);
+
+/**
+ * Logs the most contended mutexes, and writes the statistics of all of them
+ * as JSON to the file named by the VLC_LOCK_PROFILE environment variable.
+ */
+void vlc_mutex_profile_Dump(vlc_object_t *);
+#else
+# define vlc_mutex_profile_init(m, s) ((void)(m), (void)(s))
+# define vlc_mutex_profile_destroy(m) ((void)(m))
+# define vlc_mutex_profile_unlock(m) ((void)(m))
+# define vlc_mutex_profile_Dump(o) ((void)(o))
+#endif
+
 /*
  * Logging
  */
 typedef struct vlc_logger vlc_logger_t;
 
+/*
+ * Name resolution
+ */
+struct addrinfo;
+
+/**
+ * Resolves a host name with a process-wide cache.
+ *
+ * This works like vlc_getaddrinfo_i11e(), but successful results are kept for
+ * a short while and shared between callers.
+ *
+ * @return 0 on success, a getaddrinfo() error otherwise. On success, the
+ * result must be released with vlc_freeaddrinfo_cached().
+ */
+int vlc_getaddrinfo_cached(const char *node, unsigned port,
+                           const struct addrinfo *hints,
+                           struct addrinfo **res);
+
+/**
+ * Releases a result from vlc_getaddrinfo_cached().
+ */
+void vlc_freeaddrinfo_cached(struct addrinfo *res);
+
+struct vlc_tls;
+
+/**
+ * Connects a TCP socket to the first responding address of a list.
+ *
+ * Attempts are staggered as per RFC 8305 ("Happy Eyeballs").
+ *
+ * @return a connected transport layer socket, or NULL on error
+ */
+struct vlc_tls *vlc_tls_SocketOpenHappy(vlc_object_t *obj,
+                                        const struct addrinfo *res);
+
 int vlc_LogPreinit(libvlc_int_t *) VLC_USED;
 void vlc_LogInit(libvlc_int_t *);
 
+/*
+ * Tracing
+ */
+void vlc_TracerInit(libvlc_int_t *);
+void vlc_TracerDestroy(libvlc_int_t *);
+
 /*
  * LibVLC exit event handling
  */
@@ -210,6 +286,7 @@ typedef struct libvlc_priv_t
     vlc_actions_t *actions; ///< Hotkeys handler
     struct vlc_medialibrary_t *p_media_library; ///< Media library instance
     struct vlc_thumbnailer_t *p_thumbnailer; ///< Lazily instantiated media thumbnailer
+    struct vlc_tracer *tracer; ///< Pipeline events tracer (or NULL)
 
     /* Exit callback */
     vlc_exit_t       exit;
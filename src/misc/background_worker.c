@@ -21,6 +21,7 @@
 #endif
 
 #include <assert.h>
+#include <string.h>
 #include <vlc_common.h>
 #include <vlc_atomic.h>
 #include <vlc_list.h>
@@ -34,6 +35,8 @@ struct task {
     void* id; /**< id associated with entity */
     void* entity; /**< the entity to process */
     vlc_tick_t timeout; /**< timeout duration in vlc_tick_t */
+    enum background_worker_priority priority;
+    char *group; /**< group limited by max_threads_per_group, or NULL */
 };
 
 struct background_worker;
@@ -57,23 +60,39 @@ struct background_worker {
     int nthreads; /**< number of threads in the threads list */
     struct vlc_list threads; /**< list of active background_thread instances */
 
-    struct vlc_list queue; /**< queue of tasks */
-    vlc_cond_t queue_wait; /**< wait for the queue to be non-empty */
+    /** queues of tasks, by priority */
+    struct vlc_list queues[BACKGROUND_WORKER_PRIORITY_COUNT];
+    vlc_cond_t queue_wait; /**< wait for a task to be available */
 
     vlc_cond_t nothreads_wait; /**< wait for nthreads == 0 */
     bool closing; /**< true if background worker deletion is requested */
 };
 
 static struct task *task_Create(struct background_worker *worker, void *id,
-                                void *entity, int timeout)
+                                void *entity, int timeout,
+                                enum background_worker_priority priority,
+                                const char *group)
 {
     struct task *task = malloc(sizeof(*task));
     if (unlikely(!task))
         return NULL;
 
+    if (group)
+    {
+        task->group = strdup(group);
+        if (unlikely(!task->group))
+        {
+            free(task);
+            return NULL;
+        }
+    }
+    else
+        task->group = NULL;
+
     task->id = id;
     task->entity = entity;
     task->timeout = timeout < 0 ? worker->conf.default_timeout : VLC_TICK_FROM_MS(timeout);
+    task->priority = priority;
     worker->conf.pf_hold(task->entity);
     return task;
 }
@@ -81,24 +100,56 @@ static struct task *task_Create(struct background_worker *worker, void *id,
 static void task_Destroy(struct background_worker *worker, struct task *task)
 {
     worker->conf.pf_release(task->entity);
+    free(task->group);
     free(task);
 }
 
+static bool GroupIsFull(struct background_worker *worker, const char *group)
+{
+    vlc_mutex_assert(&worker->lock);
+
+    if (!group || worker->conf.max_threads_per_group <= 0)
+        return false;
+
+    int running = 0;
+    struct background_thread *thread;
+    vlc_list_foreach(thread, &worker->threads, node)
+        if (thread->task && thread->task->group
+         && !strcmp(thread->task->group, group))
+            running++;
+
+    return running >= worker->conf.max_threads_per_group;
+}
+
+/* return the first task which can be started, by order of priority */
+static struct task *QueueFirst(struct background_worker *worker)
+{
+    vlc_mutex_assert(&worker->lock);
+
+    for (int i = BACKGROUND_WORKER_PRIORITY_COUNT - 1; i >= 0; --i)
+    {
+        struct task *task;
+        vlc_list_foreach(task, &worker->queues[i], node)
+            if (!GroupIsFull(worker, task->group))
+                return task;
+    }
+    return NULL;
+}
+
 static struct task *QueueTake(struct background_worker *worker, int timeout_ms)
 {
     vlc_mutex_assert(&worker->lock);
 
     vlc_tick_t deadline = vlc_tick_now() + VLC_TICK_FROM_MS(timeout_ms);
     bool timeout = false;
-    while (!timeout && !worker->closing && vlc_list_is_empty(&worker->queue))
+    struct task *task;
+    while (!timeout && !worker->closing && !(task = QueueFirst(worker)))
         timeout = vlc_cond_timedwait(&worker->queue_wait,
                                      &worker->lock, deadline) != 0;
 
     if (worker->closing || timeout)
         return NULL;
 
-    struct task *task = vlc_list_first_entry_or_null(&worker->queue,
-                                                     struct task, node);
     assert(task);
     vlc_list_remove(&task->node);
 
@@ -108,20 +159,59 @@ static struct task *QueueTake(struct background_worker *worker, int timeout_ms)
 static void QueuePush(struct background_worker *worker, struct task *task)
 {
     vlc_mutex_assert(&worker->lock);
-    vlc_list_append(&task->node, &worker->queue);
+
+    struct vlc_list *queue = &worker->queues[task->priority];
+    struct vlc_list moved;
+    vlc_list_init(&moved);
+
+    if (worker->conf.pf_equals)
+    {
+        /* a request for an entity already queued: move it to the front */
+        for (int i = 0; i <= (int) task->priority; ++i)
+        {
+            struct task *queued;
+            vlc_list_foreach(queued, &worker->queues[i], node)
+            {
+                if (worker->conf.pf_equals(queued->entity, task->entity))
+                {
+                    vlc_list_remove(&queued->node);
+                    queued->priority = task->priority;
+                    vlc_list_append(&queued->node, &moved);
+                }
+            }
+        }
+    }
+
+    if (vlc_list_is_empty(&moved))
+        vlc_list_append(&task->node, queue);
+    else
+    {
+        /* the new task follows the moved ones, in the same order */
+        vlc_list_append(&task->node, &moved);
+        struct task *last;
+        while ((last = vlc_list_last_entry_or_null(&moved, struct task, node)))
+        {
+            vlc_list_remove(&last->node);
+            vlc_list_prepend(&last->node, queue);
+        }
+    }
+
     vlc_cond_signal(&worker->queue_wait);
 }
 
 static void QueueRemoveAll(struct background_worker *worker, void *id)
 {
     vlc_mutex_assert(&worker->lock);
-    struct task *task;
-    vlc_list_foreach(task, &worker->queue, node)
+    for (int i = 0; i < BACKGROUND_WORKER_PRIORITY_COUNT; ++i)
     {
-        if (!id || task->id == id)
+        struct task *task;
+        vlc_list_foreach(task, &worker->queues[i], node)
         {
-            vlc_list_remove(&task->node);
-            task_Destroy(worker, task);
+            if (!id || task->id == id)
+            {
+                vlc_list_remove(&task->node);
+                task_Destroy(worker, task);
+            }
         }
     }
 }
@@ -161,7 +251,8 @@ static struct background_worker *background_worker_Create(void *owner,
     worker->uncompleted = 0;
     worker->nthreads = 0;
     vlc_list_init(&worker->threads);
-    vlc_list_init(&worker->queue);
+    for (int i = 0; i < BACKGROUND_WORKER_PRIORITY_COUNT; ++i)
+        vlc_list_init(&worker->queues[i]);
     vlc_cond_init(&worker->queue_wait);
     vlc_cond_init(&worker->nothreads_wait);
     worker->closing = false;
@@ -183,6 +274,9 @@ static void TerminateTask(struct background_thread *thread, struct task *task)
     thread->task = NULL;
     worker->uncompleted--;
     assert(worker->uncompleted >= 0);
+    if (task->group && worker->conf.max_threads_per_group > 0)
+        /* a task of this group may be started now */
+        vlc_cond_broadcast(&worker->queue_wait);
     vlc_mutex_unlock(&worker->lock);
 
     task_Destroy(worker, task);
@@ -295,7 +389,19 @@ struct background_worker* background_worker_New( void* owner,
 int background_worker_Push( struct background_worker* worker, void* entity,
                         void* id, int timeout )
 {
-    struct task *task = task_Create(worker, id, entity, timeout);
+    return background_worker_PushPriority(worker, entity, id, timeout,
+                                          BACKGROUND_WORKER_PRIORITY_NORMAL,
+                                          NULL);
+}
+
+int background_worker_PushPriority( struct background_worker* worker,
+    void* entity, void* id, int timeout,
+    enum background_worker_priority priority, const char* group )
+{
+    assert(priority < BACKGROUND_WORKER_PRIORITY_COUNT);
+
+    struct task *task = task_Create(worker, id, entity, timeout, priority,
+                                    group);
     if (unlikely(!task))
         return VLC_ENOMEM;
 
@@ -19,6 +19,19 @@
 #ifndef BACKGROUND_WORKER_H__
 #define BACKGROUND_WORKER_H__
 
+/**
+ * Priority of a queued entity
+ *
+ * Entities of a higher priority are always started first. Within the same
+ * priority, entities are started in the order in which they were pushed.
+ */
+enum background_worker_priority {
+    BACKGROUND_WORKER_PRIORITY_LOW,
+    BACKGROUND_WORKER_PRIORITY_NORMAL,
+    BACKGROUND_WORKER_PRIORITY_HIGH,
+#define BACKGROUND_WORKER_PRIORITY_COUNT (BACKGROUND_WORKER_PRIORITY_HIGH + 1)
+};
+
 struct background_worker_config {
     /**
      * Default timeout for completing a task
@@ -34,6 +47,27 @@ struct background_worker_config {
      */
     int max_threads;
 
+    /**
+     * Maximum number of threads executing tasks of the same group
+     *
+     * Entities pushed with a group (see \ref background_worker_PushPriority)
+     * are not started while that many tasks of their group are running, so
+     * that a slow source cannot monopolize all the threads. Zero or less
+     * means no limit.
+     */
+    int max_threads_per_group;
+
+    /**
+     * Compare two entities (optional)
+     *
+     * If not NULL, this callback is used when an entity is pushed to find the
+     * queued entities which are requests for the same thing: these are moved
+     * to the front of the queue of the new priority.
+     *
+     * \return true if both entities are equivalent
+     **/
+    bool( *pf_equals )( void* a, void* b );
+
     /**
      * Release an entity
      *
@@ -171,6 +205,30 @@ void background_worker_RequestProbe( struct background_worker* worker );
 int background_worker_Push( struct background_worker* worker, void* entity,
     void* id, int timeout );
 
+/**
+ * Push an entity into the background-worker with a given priority
+ *
+ * This function behaves like \ref background_worker_Push, except that the
+ * entity is queued with the given priority, and possibly in a group.
+ *
+ * If \ref pf_equals is set, the queued entities equivalent to the new one are
+ * moved to the front of the queue of the given priority (if it is not lower
+ * than their own).
+ *
+ * \param worker the background-worker
+ * \param entity the entity which is to be queued
+ * \param id a value suitable for identifying the entity, or `NULL`
+ * \param timeout see \ref background_worker_Push
+ * \param priority the priority of the entity
+ * \param group the group the entity belongs to (e.g. its source), limited by
+ *              \ref max_threads_per_group, or `NULL`
+ * \return VLC_SUCCESS if the entity was successfully queued, an error-code on
+ *         failure.
+ **/
+int background_worker_PushPriority( struct background_worker* worker,
+    void* entity, void* id, int timeout,
+    enum background_worker_priority priority, const char* group );
+
 /**
  * Remove entities from the background-worker
  *
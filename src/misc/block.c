@@ -105,6 +105,337 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+#ifndef OPTIMIZE_MEMORY
+/*
+ * Per-thread block cache
+ *
+ * Small and medium blocks are recycled through a per-thread cache, split in
+ * size classes, so that the steady-state demux/packetize/decode flow does not
+ * hit the heap allocator for every packet. Cached blocks remember the cache
+ * (i.e. the thread) that allocated them. When a block is released by another
+ * thread, it is pushed onto a lock-free list of its owner, which the owner
+ * then drains on its next cache miss.
+ */
+#include <stdatomic.h>
+#include <vlc_list.h>
+
+/** Payload capacity of each size class, including alignment and padding. */
+static const size_t block_cache_sizes[] = {
+    512, 2048, 8192, 32768, 131072,
+};
+
+#define BLOCK_CACHE_CLASSES ARRAY_SIZE(block_cache_sizes)
+
+/** Maximum number of bytes cached per size class and per thread. */
+#define BLOCK_CACHE_BYTES  (2 << 20)
+/** Maximum number of blocks cached per size class and per thread. */
+#define BLOCK_CACHE_DEPTH  256
+
+struct block_cache;
+
+struct block_cached
+{
+    struct block_cache *owner;
+    struct block_cached *next;
+    unsigned klass;
+    block_t self;
+};
+
+struct block_cache
+{
+    struct block_cached *local[BLOCK_CACHE_CLASSES];
+    unsigned count[BLOCK_CACHE_CLASSES];
+    _Atomic(struct block_cached *) remote[BLOCK_CACHE_CLASSES];
+    /* One reference for the owner thread, plus one per allocated block */
+    atomic_uintptr_t refs;
+
+    atomic_uint_least64_t hits;
+    atomic_uint_least64_t misses;
+    atomic_uint_least64_t remote_frees;
+    struct vlc_list node;
+};
+
+/** Marks the remote list of a cache whose thread has exited. */
+static struct block_cached block_cache_dead;
+
+static thread_local struct block_cache *block_cache_current;
+static vlc_threadvar_t block_cache_key;
+static vlc_once_t block_cache_once = VLC_STATIC_ONCE;
+static bool block_cache_usable;
+
+static vlc_mutex_t block_cache_lock = VLC_STATIC_MUTEX;
+static struct vlc_list block_cache_list =
+    VLC_LIST_INITIALIZER(&block_cache_list);
+static struct block_cache_stats block_cache_totals;
+static atomic_uint_least64_t block_cache_uncached;
+
+static unsigned block_cache_depth(unsigned klass)
+{
+    size_t depth = BLOCK_CACHE_BYTES / block_cache_sizes[klass];
+    return (depth < BLOCK_CACHE_DEPTH) ? depth : BLOCK_CACHE_DEPTH;
+}
+
+/** Bumps a counter only ever written by the cache owner thread. */
+static void block_cache_count(atomic_uint_least64_t *counter)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter,
+                                                        memory_order_relaxed)
+                                   + 1, memory_order_relaxed);
+}
+
+static void block_cache_unref(struct block_cache *cache, uintptr_t n)
+{
+    if (n > 0 && atomic_fetch_sub_explicit(&cache->refs, n,
+                                           memory_order_acq_rel) == n)
+        free(cache);
+}
+
+/** Frees a list of cached blocks, and returns how many there were. */
+static uintptr_t block_cache_FreeList(struct block_cached *c)
+{
+    uintptr_t n = 0;
+
+    while (c != NULL)
+    {
+        struct block_cached *next = c->next;
+
+        free(c);
+        c = next;
+        n++;
+    }
+    return n;
+}
+
+static void block_cache_Destroy(void *data)
+{
+    struct block_cache *cache = data;
+    uintptr_t freed = 0;
+
+    for (unsigned i = 0; i < BLOCK_CACHE_CLASSES; i++)
+    {
+        struct block_cached *c = atomic_exchange_explicit(&cache->remote[i],
+                                                          &block_cache_dead,
+                                                          memory_order_acquire);
+        freed += block_cache_FreeList(c);
+        freed += block_cache_FreeList(cache->local[i]);
+        cache->local[i] = NULL;
+    }
+
+    vlc_mutex_lock(&block_cache_lock);
+    vlc_list_remove(&cache->node);
+    block_cache_totals.hits += atomic_load_explicit(&cache->hits,
+                                                    memory_order_relaxed);
+    block_cache_totals.misses += atomic_load_explicit(&cache->misses,
+                                                      memory_order_relaxed);
+    block_cache_totals.remote_frees +=
+        atomic_load_explicit(&cache->remote_frees, memory_order_relaxed);
+    vlc_mutex_unlock(&block_cache_lock);
+
+    if (block_cache_current == cache)
+        block_cache_current = NULL;
+    /* Blocks still in use by other threads keep the cache alive. */
+    block_cache_unref(cache, freed + 1);
+}
+
+static void block_cache_Init(void)
+{
+    block_cache_usable = vlc_threadvar_create(&block_cache_key,
+                                              block_cache_Destroy) == 0;
+}
+
+static struct block_cache *block_cache_Get(void)
+{
+    struct block_cache *cache = block_cache_current;
+
+    if (likely(cache != NULL))
+        return cache;
+
+    vlc_once(&block_cache_once, block_cache_Init);
+    if (!block_cache_usable)
+        return NULL;
+
+    cache = malloc(sizeof (*cache));
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    for (unsigned i = 0; i < BLOCK_CACHE_CLASSES; i++)
+    {
+        cache->local[i] = NULL;
+        cache->count[i] = 0;
+        atomic_init(&cache->remote[i], NULL);
+    }
+    atomic_init(&cache->refs, 1);
+    atomic_init(&cache->hits, 0);
+    atomic_init(&cache->misses, 0);
+    atomic_init(&cache->remote_frees, 0);
+
+    if (vlc_threadvar_set(block_cache_key, cache))
+    {
+        free(cache);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&block_cache_lock);
+    vlc_list_append(&cache->node, &block_cache_list);
+    vlc_mutex_unlock(&block_cache_lock);
+    block_cache_current = cache;
+    return cache;
+}
+
+static void block_cached_Release(block_t *block)
+{
+    struct block_cached *c = container_of(block, struct block_cached, self);
+    struct block_cache *cache = c->owner;
+    unsigned klass = c->klass;
+
+    if (cache == block_cache_current)
+    {   /* Fast path: released by the allocating thread */
+        if (cache->count[klass] < block_cache_depth(klass))
+        {
+            c->next = cache->local[klass];
+            cache->local[klass] = c;
+            cache->count[klass]++;
+            return;
+        }
+        free(c);
+        block_cache_unref(cache, 1);
+        return;
+    }
+
+    /* Slow path: return the block to its owner thread.
+     * The cache may be freed as soon as the block is pushed, so count first. */
+    struct block_cached *head = atomic_load_explicit(&cache->remote[klass],
+                                                     memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&cache->remote_frees, 1, memory_order_relaxed);
+    do
+    {
+        if (head == &block_cache_dead)
+        {   /* Owner thread has exited */
+            atomic_fetch_sub_explicit(&cache->remote_frees, 1,
+                                      memory_order_relaxed);
+            free(c);
+            block_cache_unref(cache, 1);
+            return;
+        }
+        c->next = head;
+    }
+    while (!atomic_compare_exchange_weak_explicit(&cache->remote[klass],
+                                                  &head, c,
+                                                  memory_order_release,
+                                                  memory_order_relaxed));
+}
+
+static const struct vlc_block_callbacks block_cached_cbs =
+{
+    block_cached_Release,
+};
+
+static struct block_cached *block_cache_Pop(struct block_cache *cache,
+                                            unsigned klass)
+{
+    struct block_cached *c = cache->local[klass];
+
+    if (c != NULL)
+    {
+        cache->local[klass] = c->next;
+        cache->count[klass]--;
+        return c;
+    }
+
+    /* Reclaim the blocks released by other threads, if any. */
+    c = atomic_exchange_explicit(&cache->remote[klass], NULL,
+                                 memory_order_acquire);
+    if (c == NULL)
+        return NULL;
+
+    struct block_cached *list = c->next;
+    uintptr_t freed = 0;
+
+    while (list != NULL)
+    {
+        struct block_cached *next = list->next;
+
+        if (cache->count[klass] < block_cache_depth(klass))
+        {
+            list->next = cache->local[klass];
+            cache->local[klass] = list;
+            cache->count[klass]++;
+        }
+        else
+        {
+            free(list);
+            freed++;
+        }
+        list = next;
+    }
+    block_cache_unref(cache, freed);
+    return c;
+}
+
+static block_t *block_cache_Alloc(size_t alloc)
+{
+    unsigned klass = 0;
+
+    while (block_cache_sizes[klass] < alloc)
+        if (++klass >= BLOCK_CACHE_CLASSES)
+            goto uncached;
+
+    struct block_cache *cache = block_cache_Get();
+    if (unlikely(cache == NULL))
+        goto uncached;
+
+    struct block_cached *c = block_cache_Pop(cache, klass);
+    if (c != NULL)
+        block_cache_count(&cache->hits);
+    else
+    {
+        c = malloc(sizeof (*c) + block_cache_sizes[klass]);
+        if (unlikely(c == NULL))
+            return NULL;
+
+        c->owner = cache;
+        c->klass = klass;
+        atomic_fetch_add_explicit(&cache->refs, 1, memory_order_relaxed);
+        block_cache_count(&cache->misses);
+    }
+
+    return block_Init(&c->self, &block_cached_cbs, c + 1,
+                      block_cache_sizes[klass]);
+
+uncached:
+    atomic_fetch_add_explicit(&block_cache_uncached, 1, memory_order_relaxed);
+    return NULL;
+}
+
+void block_CacheGetStats(struct block_cache_stats *restrict stats)
+{
+    struct block_cache *cache;
+
+    vlc_mutex_lock(&block_cache_lock);
+    *stats = block_cache_totals;
+    vlc_list_foreach(cache, &block_cache_list, node)
+    {
+        stats->hits += atomic_load_explicit(&cache->hits,
+                                            memory_order_relaxed);
+        stats->misses += atomic_load_explicit(&cache->misses,
+                                              memory_order_relaxed);
+        stats->remote_frees += atomic_load_explicit(&cache->remote_frees,
+                                                    memory_order_relaxed);
+    }
+    vlc_mutex_unlock(&block_cache_lock);
+    stats->uncached = atomic_load_explicit(&block_cache_uncached,
+                                           memory_order_relaxed);
+}
+#else
+# define block_cache_Alloc(alloc) ((void)(alloc), (block_t *)NULL)
+
+void block_CacheGetStats(struct block_cache_stats *restrict stats)
+{
+    memset(stats, 0, sizeof (*stats));
+}
+#endif
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -119,11 +450,16 @@ block_t *block_Alloc (size_t size)
     if (unlikely(alloc <= size))
         return NULL;
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
-        return NULL;
+    block_t *b = block_cache_Alloc(alloc - sizeof (*b));
+    if (b == NULL)
+    {
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
+
+        block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+    }
 
-    block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
@@ -26,6 +26,8 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -235,3 +237,170 @@ size_t block_FifoCount (block_fifo_t *fifo)
     vlc_mutex_unlock (&fifo->lock);
     return depth;
 }
+
+/**
+ * Internal state for single producer single consumer block queues
+ *
+ * The producer pushes blocks onto a lock-free LIFO stack. The consumer grabs
+ * the whole stack at once, and reverses it into its private list. Neither
+ * side ever waits for the other, and there is no ABA problem since only the
+ * consumer ever removes entries (all of them).
+ *
+ * The mutex and condition variable are only used by the consumer to sleep
+ * when the queue is empty, and by the producer to wake it up, if and only if
+ * the sleeping flag is set.
+ */
+struct vlc_spsc_fifo
+{
+    _Atomic(block_t *)  top;    /**< Producer stack (most recent first) */
+    atomic_size_t       i_depth;
+    atomic_size_t       i_size;
+    atomic_bool         b_sleeping;
+
+    block_t            *p_first; /**< Consumer list (oldest first) */
+
+    vlc_mutex_t         lock;
+    vlc_cond_t          wait;
+};
+
+vlc_spsc_fifo_t *vlc_spsc_fifo_New(void)
+{
+    vlc_spsc_fifo_t *fifo = malloc(sizeof (*fifo));
+    if (unlikely(fifo == NULL))
+        return NULL;
+
+    atomic_init(&fifo->top, NULL);
+    atomic_init(&fifo->i_depth, 0);
+    atomic_init(&fifo->i_size, 0);
+    atomic_init(&fifo->b_sleeping, false);
+    fifo->p_first = NULL;
+    vlc_mutex_init(&fifo->lock);
+    vlc_cond_init(&fifo->wait);
+    return fifo;
+}
+
+void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *fifo)
+{
+    block_ChainRelease(fifo->p_first);
+    block_ChainRelease(atomic_load_explicit(&fifo->top,
+                                            memory_order_acquire));
+    vlc_cond_destroy(&fifo->wait);
+    vlc_mutex_destroy(&fifo->lock);
+    free(fifo);
+}
+
+void vlc_spsc_fifo_Queue(vlc_spsc_fifo_t *fifo, block_t *block)
+{
+    if (block == NULL)
+        return;
+
+    /* Reverse the chain, so that the stack still pops out in order. */
+    block_t *first = block, *last = NULL;
+    size_t depth = 0, size = 0;
+
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = last;
+        last = block;
+        depth++;
+        size += block->i_buffer;
+        block = next;
+    }
+
+    /* Account before publishing, so the consumer never underflows. */
+    atomic_fetch_add_explicit(&fifo->i_depth, depth, memory_order_relaxed);
+    atomic_fetch_add_explicit(&fifo->i_size, size, memory_order_relaxed);
+
+    block_t *top = atomic_load_explicit(&fifo->top, memory_order_relaxed);
+    do
+        first->p_next = top;
+    while (!atomic_compare_exchange_weak_explicit(&fifo->top, &top, last,
+                                                  memory_order_seq_cst,
+                                                  memory_order_relaxed));
+
+    /* Pairs with the sleeping flag store then stack exchange in the
+     * consumer: either it sees the new blocks, or we see it sleeping. */
+    if (atomic_load_explicit(&fifo->b_sleeping, memory_order_seq_cst))
+    {
+        vlc_mutex_lock(&fifo->lock);
+        vlc_cond_signal(&fifo->wait);
+        vlc_mutex_unlock(&fifo->lock);
+    }
+}
+
+block_t *vlc_spsc_fifo_Dequeue(vlc_spsc_fifo_t *fifo)
+{
+    block_t *block = fifo->p_first;
+
+    if (block == NULL)
+    {
+        block_t *top = atomic_exchange_explicit(&fifo->top, NULL,
+                                                memory_order_seq_cst);
+
+        /* Reverse the stack into the consumer list */
+        while (top != NULL)
+        {
+            block_t *next = top->p_next;
+
+            top->p_next = block;
+            block = top;
+            top = next;
+        }
+
+        if (block == NULL)
+            return NULL;
+    }
+
+    fifo->p_first = block->p_next;
+    block->p_next = NULL;
+
+    atomic_fetch_sub_explicit(&fifo->i_depth, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&fifo->i_size, block->i_buffer,
+                              memory_order_relaxed);
+    return block;
+}
+
+static void vlc_spsc_fifo_Cleanup(void *data)
+{
+    vlc_spsc_fifo_t *fifo = data;
+
+    atomic_store_explicit(&fifo->b_sleeping, false, memory_order_relaxed);
+    vlc_mutex_unlock(&fifo->lock);
+}
+
+block_t *vlc_spsc_fifo_Get(vlc_spsc_fifo_t *fifo)
+{
+    block_t *block;
+
+    vlc_testcancel();
+
+    block = vlc_spsc_fifo_Dequeue(fifo);
+    if (block != NULL)
+        return block;
+
+    vlc_mutex_lock(&fifo->lock);
+    atomic_store_explicit(&fifo->b_sleeping, true, memory_order_seq_cst);
+
+    while ((block = vlc_spsc_fifo_Dequeue(fifo)) == NULL)
+    {
+        vlc_cleanup_push(vlc_spsc_fifo_Cleanup, fifo);
+        vlc_cond_wait(&fifo->wait, &fifo->lock);
+        vlc_cleanup_pop();
+    }
+
+    atomic_store_explicit(&fifo->b_sleeping, false, memory_order_relaxed);
+    vlc_mutex_unlock(&fifo->lock);
+    return block;
+}
+
+size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *fifo)
+{
+    return atomic_load_explicit(&fifo->i_depth, memory_order_relaxed);
+}
+
+size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *fifo)
+{
+    return atomic_load_explicit(&fifo->i_size, memory_order_relaxed);
+}
@@ -29,6 +29,7 @@
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
 #include <vlc_spu.h>
+#include <vlc_tracer.h>
 #include <libvlc.h>
 #include <assert.h>
 
@@ -422,12 +423,101 @@ vlc_video_context *filter_chain_GetVideoCtxOut(const filter_chain_t *p_chain)
     return p_chain->vctx_in;
 }
 
-static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic )
+/* Lines of the first plane processed by each pass of the fused filters, small
+ * enough for the band to stay in the cache between the filters */
+#define FUSED_BAND_LINES 16
+
+/* Makes a picture of the lines [start, end) of the first plane, and the
+ * matching lines of the other planes */
+static void PictureBand( picture_t *p_band, const picture_t *p_pic,
+                         int start, int end )
+{
+    const int lines = p_pic->p[0].i_visible_lines;
+
+    *p_band = *p_pic;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_band->p[i];
+        const int first = start * p->i_visible_lines / lines;
+        const int last = end * p->i_visible_lines / lines;
+
+        p->p_pixels += first * p->i_pitch;
+        p->i_lines = p->i_visible_lines = last - first;
+    }
+}
+
+/* Runs the in-place filters from first to last, a band at a time */
+static picture_t *FilterChainFuse( struct vlc_tracer *tracer,
+                                   chained_filter_t *first,
+                                   chained_filter_t *last, picture_t *p_src )
+{
+    picture_t *p_dst = filter_NewPicture( &last->filter );
+    if( unlikely(p_dst == NULL) )
+    {
+        picture_Release( p_src );
+        return NULL;
+    }
+
+    vlc_tracer_Begin( tracer, "filter", "fused", &first->filter,
+                      p_src->date );
+
+    const int lines = p_src->p[0].i_visible_lines;
+    assert( p_dst->i_planes == p_src->i_planes );
+    for( int y = 0; y < lines; y += FUSED_BAND_LINES )
+    {
+        const int end = __MIN( y + FUSED_BAND_LINES, lines );
+        picture_t src, dst;
+
+        PictureBand( &src, p_src, y, end );
+        PictureBand( &dst, p_dst, y, end );
+
+        picture_t *p_in = &src;
+        for( chained_filter_t *f = first; ; f = f->next )
+        {
+            f->filter.pf_video_filter_inplace( &f->filter, &dst, p_in );
+            p_in = &dst;
+            if( f == last )
+                break;
+        }
+    }
+
+    vlc_tracer_End( tracer, "filter", "fused", &first->filter,
+                    p_src->date );
+
+    picture_CopyProperties( p_dst, p_src );
+    picture_Release( p_src );
+    return p_dst;
+}
+
+static picture_t *FilterChainVideoFilter( struct vlc_tracer *tracer,
+                                          chained_filter_t *f, picture_t *p_pic )
 {
     for( ; f != NULL; f = f->next )
     {
         filter_t *p_filter = &f->filter;
+        vlc_tick_t date = p_pic->date;
+
+        if( p_filter->pf_video_filter_inplace != NULL )
+        {
+            /* Fuse the following in-place filters, if any */
+            chained_filter_t *last = f;
+            while( last->next != NULL
+                && last->next->filter.pf_video_filter_inplace != NULL )
+                last = last->next;
+
+            if( last != f )
+            {
+                p_pic = FilterChainFuse( tracer, f, last, p_pic );
+                if( !p_pic )
+                    break;
+                f = last;
+                continue;
+            }
+        }
+
+        vlc_tracer_Begin( tracer, "filter", "filter", p_filter, date );
         p_pic = p_filter->pf_video_filter( p_filter, p_pic );
+        vlc_tracer_End( tracer, "filter", "filter", p_filter, date );
         if( !p_pic )
             break;
         if( f->pending )
@@ -443,9 +533,11 @@ static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic
 
 picture_t *filter_chain_VideoFilter( filter_chain_t *p_chain, picture_t *p_pic )
 {
+    struct vlc_tracer *tracer = vlc_object_get_tracer( p_chain->obj );
+
     if( p_pic )
     {
-        p_pic = FilterChainVideoFilter( p_chain->first, p_pic );
+        p_pic = FilterChainVideoFilter( tracer, p_chain->first, p_pic );
         if( p_pic )
             return p_pic;
     }
@@ -457,7 +549,7 @@ picture_t *filter_chain_VideoFilter( filter_chain_t *p_chain, picture_t *p_pic )
         b->pending = p_pic->p_next;
         p_pic->p_next = NULL;
 
-        p_pic = FilterChainVideoFilter( b->next, p_pic );
+        p_pic = FilterChainVideoFilter( tracer, b->next, p_pic );
         if( p_pic )
             return p_pic;
     }
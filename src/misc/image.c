@@ -35,6 +35,7 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <sys/stat.h>
 
 #include <vlc_common.h>
 #include <vlc_codec.h>
@@ -44,6 +45,7 @@
 #include <vlc_image.h>
 #include <vlc_stream.h>
 #include <vlc_fs.h>
+#include <vlc_url.h>
 #include <vlc_sout.h>
 #include <libvlc.h>
 #include <vlc_modules.h>
@@ -175,6 +177,11 @@ static picture_t *ImageRead( image_handler_t *p_image, block_t *p_block,
         }
     }
 
+    /* Let the decoder downscale already, if it can: the converter only has
+     * to finish the job then. The hints are ignored by most decoders. */
+    var_SetInteger( p_image->p_dec, "image-width", p_fmt_out->i_width );
+    var_SetInteger( p_image->p_dec, "image-height", p_fmt_out->i_height );
+
     p_block->i_pts = p_block->i_dts = vlc_tick_now();
     int ret = p_image->p_dec->pf_decode( p_image->p_dec, p_block );
     if( ret == VLCDEC_SUCCESS )
@@ -280,8 +287,8 @@ static picture_t *ImageRead( image_handler_t *p_image, block_t *p_block,
     return p_pic;
 }
 
-static picture_t *ImageReadUrl( image_handler_t *p_image, const char *psz_url,
-                                video_format_t *p_fmt_out )
+static picture_t *ImageReadFile( image_handler_t *p_image, const char *psz_url,
+                                 video_format_t *p_fmt_out )
 {
     block_t *p_block;
     picture_t *p_pic;
@@ -334,6 +341,104 @@ error:
     return NULL;
 }
 
+/*
+ * Downscaled art is kept next to the original in the art cache, so that
+ * large covers are not decoded in full every time they are shown small.
+ */
+static char *ImageThumbnailPath( const char *psz_url,
+                                 const video_format_t *p_fmt,
+                                 struct stat *p_st )
+{
+    if( !p_fmt->i_width && !p_fmt->i_height )
+        return NULL;
+
+    char *psz_path = vlc_uri2path( psz_url );
+    if( psz_path == NULL )
+        return NULL;
+
+    char *psz_artdir = config_GetUserDir( VLC_CACHE_DIR );
+    char *psz_thumb = NULL;
+
+    if( psz_artdir != NULL )
+    {
+        size_t len = strlen( psz_artdir );
+
+        if( !strncmp( psz_path, psz_artdir, len )
+         && !strncmp( psz_path + len, DIR_SEP "art" DIR_SEP,
+                      strlen( DIR_SEP "art" DIR_SEP ) )
+         && vlc_stat( psz_path, p_st ) == 0 )
+        {   /* not named art*, that is what the art cache looks for */
+            *strrchr( psz_path, DIR_SEP_CHAR ) = '\0';
+            if( asprintf( &psz_thumb, "%s" DIR_SEP "thumb-%ux%u.png",
+                          psz_path, p_fmt->i_width, p_fmt->i_height ) < 0 )
+                psz_thumb = NULL;
+        }
+        free( psz_artdir );
+    }
+    free( psz_path );
+    return psz_thumb;
+}
+
+static picture_t *ImageReadUrl( image_handler_t *p_image, const char *psz_url,
+                                video_format_t *p_fmt_out )
+{
+    struct stat st, thumb_st;
+    char *psz_thumb = ImageThumbnailPath( psz_url, p_fmt_out, &st );
+    picture_t *p_pic;
+
+    if( psz_thumb == NULL )
+        return ImageReadFile( p_image, psz_url, p_fmt_out );
+
+    /* Use the thumbnail unless the art was replaced since */
+    if( vlc_stat( psz_thumb, &thumb_st ) == 0
+     && thumb_st.st_mtime >= st.st_mtime )
+    {
+        char *psz_thumb_url = vlc_path2uri( psz_thumb, "file" );
+        if( psz_thumb_url != NULL )
+        {
+            video_format_t fmt = *p_fmt_out;
+
+            p_pic = ImageReadFile( p_image, psz_thumb_url, &fmt );
+            free( psz_thumb_url );
+            if( p_pic != NULL )
+            {
+                *p_fmt_out = fmt;
+                free( psz_thumb );
+                return p_pic;
+            }
+        }
+    }
+
+    p_pic = ImageReadFile( p_image, psz_url, p_fmt_out );
+
+    /* Only worth it if the decoder output had to be scaled down */
+    if( p_pic != NULL && p_image->p_dec != NULL
+     && p_image->p_dec->fmt_out.video.i_width > p_fmt_out->i_width
+     && p_image->p_dec->fmt_out.video.i_height > p_fmt_out->i_height )
+    {
+        char *psz_tmp;
+
+        if( asprintf( &psz_tmp, "%s.part", psz_thumb ) >= 0 )
+        {
+            video_format_t fmt_png = *p_fmt_out;
+
+            fmt_png.i_chroma = VLC_CODEC_PNG;
+            if( ImageWriteUrl( p_image, p_pic, p_fmt_out, &fmt_png,
+                               psz_tmp ) == VLC_SUCCESS )
+            {
+                if( vlc_rename( psz_tmp, psz_thumb ) )
+                    vlc_unlink( psz_tmp );
+            }
+            else
+                vlc_unlink( psz_tmp );
+            free( psz_tmp );
+        }
+    }
+
+    free( psz_thumb );
+    return p_pic;
+}
+
 /* FIXME: refactor by splitting video_format_IsSimilar() API */
 static bool BitMapFormatIsSimilar( const video_format_t *f1,
                                    const video_format_t *f2 )
@@ -675,6 +780,10 @@ static decoder_t *CreateDecoder( image_handler_t *p_image, const es_format_t *fm
 
     decoder_Init( p_dec, fmt );
 
+    /* Size hints for the decoders that can downscale while decoding */
+    var_Create( p_dec, "image-width", VLC_VAR_INTEGER );
+    var_Create( p_dec, "image-height", VLC_VAR_INTEGER );
+
     static const struct decoder_owner_callbacks dec_cbs =
     {
         .video = {
@@ -40,7 +40,9 @@
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
+#include "../config/configuration.h"
 
 static void vlc_LogSpam(vlc_object_t *obj)
 {
@@ -440,6 +442,191 @@ static struct vlc_logger *vlc_LogModuleCreate(vlc_object_t *parent)
     return &module->frontend;
 }
 
+/**
+ * Asynchronous message log.
+ *
+ * A message log that formats messages in the calling thread, and passes them
+ * to another log from a dedicated thread. Messages are dropped, rather than
+ * blocking the caller, if the queue is full.
+ */
+#define LOG_ASYNC_QUEUE 4096 /* must be a power of two */
+
+typedef struct vlc_log_async_t
+{
+    int type;
+    vlc_log_t meta;
+    char *msg;
+    char module[]; /* copy of meta.psz_module */
+} vlc_log_async_t;
+
+struct vlc_logger_async {
+    struct vlc_logger logger;
+    struct vlc_logger *sink;
+    int verbosity;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    vlc_log_async_t *queue[LOG_ASYNC_QUEUE];
+    size_t head; /* next record to write */
+    size_t count;
+    bool dead;
+    atomic_uint dropped;
+    vlc_thread_t thread;
+};
+
+static void vlc_vaLogAsync(void *d, int type, const vlc_log_t *item,
+                           const char *format, va_list ap)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+
+    /* Do not even format messages which no loggers would print */
+    if (type > async->verbosity)
+        return;
+
+    size_t modlen = strlen(item->psz_module) + 1;
+    vlc_log_async_t *log = malloc(sizeof (*log) + modlen);
+    if (unlikely(log == NULL))
+        goto drop;
+
+    log->type = type;
+    log->meta = *item;
+    /* The module name may be on the caller stack */
+    memcpy(log->module, item->psz_module, modlen);
+    log->meta.psz_module = log->module;
+    log->meta.psz_header = item->psz_header ? strdup(item->psz_header) : NULL;
+
+    if (vasprintf(&log->msg, format, ap) == -1)
+        log->msg = NULL;
+
+    vlc_mutex_lock(&async->lock);
+    if (async->count < LOG_ASYNC_QUEUE)
+    {
+        async->queue[(async->head++) % LOG_ASYNC_QUEUE] = log;
+        if (async->count++ == 0)
+            vlc_cond_signal(&async->wait);
+        log = NULL;
+    }
+    vlc_mutex_unlock(&async->lock);
+
+    if (log == NULL)
+        return;
+
+    free((char *)log->meta.psz_header);
+    free(log->msg);
+    free(log);
+drop:
+    atomic_fetch_add_explicit(&async->dropped, 1, memory_order_relaxed);
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    struct vlc_logger_async *async = data;
+    vlc_log_async_t *batch[64];
+
+    vlc_mutex_lock(&async->lock);
+    for (;;)
+    {
+        while (async->count == 0 && !async->dead)
+            vlc_cond_wait(&async->wait, &async->lock);
+
+        if (async->count == 0)
+            break; /* dead and drained */
+
+        /* Take a batch of records, so that the callers are not blocked
+         * while the sink processes them */
+        size_t n = __MIN(async->count, ARRAY_SIZE(batch));
+        size_t tail = async->head - async->count;
+
+        for (size_t i = 0; i < n; i++)
+            batch[i] = async->queue[(tail + i) % LOG_ASYNC_QUEUE];
+        async->count -= n;
+        vlc_mutex_unlock(&async->lock);
+
+        unsigned dropped = atomic_exchange_explicit(&async->dropped, 0,
+                                                    memory_order_relaxed);
+        if (dropped > 0)
+        {
+            vlc_log_t meta = batch[0]->meta;
+
+            vlc_LogCallback(async->sink, VLC_MSG_WARN, &meta,
+                            "%u log message(s) dropped", dropped);
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            vlc_log_async_t *log = batch[i];
+
+            vlc_LogCallback(async->sink, log->type, &log->meta, "%s",
+                            (log->msg != NULL) ? log->msg : "message lost");
+            free((char *)log->meta.psz_header);
+            free(log->msg);
+            free(log);
+        }
+        vlc_mutex_lock(&async->lock);
+    }
+    vlc_mutex_unlock(&async->lock);
+    return NULL;
+}
+
+static void vlc_LogAsyncClose(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+
+    vlc_mutex_lock(&async->lock);
+    async->dead = true;
+    vlc_cond_signal(&async->wait);
+    vlc_mutex_unlock(&async->lock);
+    vlc_join(async->thread, NULL);
+
+    vlc_LogDestroy(async->sink);
+    vlc_cond_destroy(&async->wait);
+    vlc_mutex_destroy(&async->lock);
+    free(async);
+}
+
+static const struct vlc_logger_operations async_ops = {
+    vlc_vaLogAsync,
+    vlc_LogAsyncClose,
+};
+
+static struct vlc_logger *vlc_LogAsyncCreate(vlc_object_t *parent,
+                                             struct vlc_logger *sink)
+{
+    struct vlc_logger_async *async = malloc(sizeof (*async));
+    if (unlikely(async == NULL))
+        return NULL;
+
+    /* The highest verbosity of the loggers */
+    int verbosity = var_InheritInteger(parent, "verbose");
+    if (config_FindConfig("log-verbose") != NULL)
+        verbosity = __MAX(verbosity,
+                          var_InheritInteger(parent, "log-verbose"));
+
+    async->logger.ops = &async_ops;
+    async->sink = sink;
+    async->verbosity = VLC_MSG_ERR + verbosity;
+    vlc_mutex_init(&async->lock);
+    vlc_cond_init(&async->wait);
+    async->head = 0;
+    async->count = 0;
+    async->dead = false;
+    atomic_init(&async->dropped, 0);
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_cond_destroy(&async->wait);
+        vlc_mutex_destroy(&async->lock);
+        free(async);
+        return NULL;
+    }
+    return &async->logger;
+}
+
 /**
  * Initializes the messages logging subsystem and drain the early messages to
  * the configured log.
@@ -449,6 +636,12 @@ void vlc_LogInit(libvlc_int_t *vlc)
     struct vlc_logger *logger = vlc_LogModuleCreate(VLC_OBJECT(vlc));
     if (logger == NULL)
         logger = &discard_log;
+    else if (var_InheritBool(vlc, "log-async"))
+    {
+        struct vlc_logger *async = vlc_LogAsyncCreate(VLC_OBJECT(vlc), logger);
+        if (async != NULL)
+            logger = async;
+    }
 
     vlc_LogSwitch(vlc->obj.logger, logger);
 }
@@ -58,19 +58,19 @@
 #define vlc_children_foreach(pos, priv) \
     while (((void)(pos), (void)(priv), 0))
 
-int vlc_object_init(vlc_object_t *restrict obj, vlc_object_t *parent,
-                    const char *typename)
+static void vlc_object_setup(vlc_object_t *restrict obj,
+                             vlc_object_internals_t *priv,
+                             vlc_object_t *parent, const char *typename)
 {
-    vlc_object_internals_t *priv = malloc(sizeof (*priv));
-    if (unlikely(priv == NULL))
-        return -1;
-
     priv->parent = parent;
     priv->typename = typename;
-    priv->var_root = NULL;
+    priv->var_table = NULL;
+    priv->var_size = 0;
+    priv->var_count = 0;
     vlc_mutex_init (&priv->var_lock);
     vlc_cond_init (&priv->var_wait);
     priv->resources = NULL;
+    priv->embedded = false;
 
     obj->priv = priv;
     obj->force = false;
@@ -85,7 +85,16 @@ int vlc_object_init(vlc_object_t *restrict obj, vlc_object_t *parent,
         obj->logger = NULL;
         obj->no_interact = false;
     }
+}
+
+int vlc_object_init(vlc_object_t *restrict obj, vlc_object_t *parent,
+                    const char *typename)
+{
+    vlc_object_internals_t *priv = malloc(sizeof (*priv));
+    if (unlikely(priv == NULL))
+        return -1;
 
+    vlc_object_setup(obj, priv, parent, typename);
     return 0;
 }
 
@@ -94,11 +103,21 @@ void *(vlc_custom_create)(vlc_object_t *parent, size_t length,
 {
     assert(length >= sizeof (vlc_object_t));
 
-    vlc_object_t *obj = calloc(length, 1);
-    if (unlikely(obj == NULL || vlc_object_init(obj, parent, typename))) {
-        free(obj);
-        obj = NULL;
-    }
+    /* Allocate the internals right after the object, in a single block */
+    size_t offset = (length + sizeof (max_align_t) - 1)
+                    / sizeof (max_align_t) * sizeof (max_align_t);
+    if (unlikely(offset < length
+              || offset > SIZE_MAX - sizeof (vlc_object_internals_t)))
+        return NULL;
+
+    vlc_object_t *obj = calloc(1, offset + sizeof (vlc_object_internals_t));
+    if (unlikely(obj == NULL))
+        return NULL;
+
+    vlc_object_internals_t *priv = (void *)(((char *)obj) + offset);
+
+    vlc_object_setup(obj, priv, parent, typename);
+    priv->embedded = true;
     return obj;
 }
 
@@ -130,7 +149,8 @@ void vlc_object_deinit(vlc_object_t *obj)
 
     vlc_cond_destroy(&priv->var_wait);
     vlc_mutex_destroy(&priv->var_lock);
-    free(priv);
+    if (!priv->embedded)
+        free(priv);
 }
 
 void (vlc_object_delete)(vlc_object_t *obj)
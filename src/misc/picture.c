@@ -60,6 +60,176 @@ static void picture_DestroyDummy( picture_t *p_picture )
     (void) p_picture;
 }
 
+/*****************************************************************************
+ * Picture buffers recycler
+ *****************************************************************************
+ * Pools are destroyed and created again on format changes, and picture
+ * buffers are expensive to allocate (a shared memory file and a mapping on
+ * POSIX). The buffers freed recently are kept by size class, for the next
+ * pictures of the same or a slightly smaller size.
+ *****************************************************************************/
+
+/** Smallest buffer recycled, smaller ones are cheap enough to allocate */
+#define PICTURE_CACHE_MIN_SIZE (64 << 10)
+/** Maximum number of bytes and buffers kept */
+#define PICTURE_CACHE_BYTES (128 << 20)
+#define PICTURE_CACHE_DEPTH 64
+/** Unused buffers are freed after this delay */
+#define PICTURE_CACHE_EXPIRY VLC_TICK_FROM_SEC(10)
+
+struct picture_cached
+{
+    int fd;
+    void *base;
+    size_t size;
+    vlc_tick_t date; /**< when it was freed */
+};
+
+static vlc_mutex_t picture_cache_lock = VLC_STATIC_MUTEX;
+static struct picture_cached picture_cache[PICTURE_CACHE_DEPTH];
+static unsigned picture_cache_count;
+static size_t picture_cache_bytes;
+
+/**
+ * Rounds a buffer size up to its size class: eight classes per power of
+ * two, so that at most an eighth of the buffer is wasted.
+ */
+static size_t picture_cache_Class(size_t size)
+{
+    if (size < PICTURE_CACHE_MIN_SIZE)
+        return size;
+
+    unsigned bits = 8 * sizeof (unsigned long long) - 1 - vlc_clzll(size);
+    size_t step = ((size_t)1 << bits) >> 3;
+    return (size + step - 1) & ~(step - 1);
+}
+
+/* Must be called with the lock */
+static void picture_cache_Remove(unsigned i, struct picture_cached *entry)
+{
+    *entry = picture_cache[i];
+    picture_cache_bytes -= entry->size;
+    picture_cache[i] = picture_cache[--picture_cache_count];
+}
+
+static void *picture_AllocateCached(int *restrict fdp, size_t size)
+{
+    struct picture_cached entry = { .base = NULL };
+
+    if (size >= PICTURE_CACHE_MIN_SIZE)
+    {
+        vlc_mutex_lock(&picture_cache_lock);
+        /* Most recently freed buffer of the class, still in the CPU cache */
+        for (unsigned i = picture_cache_count; i-- > 0;)
+            if (picture_cache[i].size == size)
+            {
+                picture_cache_Remove(i, &entry);
+                break;
+            }
+        vlc_mutex_unlock(&picture_cache_lock);
+    }
+
+    if (entry.base != NULL)
+    {
+        *fdp = entry.fd;
+        return entry.base;
+    }
+    return picture_Allocate(fdp, size);
+}
+
+static void picture_DeallocateCached(int fd, void *base, size_t size)
+{
+    struct picture_cached expired[PICTURE_CACHE_DEPTH];
+    unsigned n = 0;
+
+    if (size < PICTURE_CACHE_MIN_SIZE || size > PICTURE_CACHE_BYTES)
+    {
+        picture_Deallocate(fd, base, size);
+        return;
+    }
+
+    vlc_tick_t now = vlc_tick_now();
+
+    vlc_mutex_lock(&picture_cache_lock);
+    for (unsigned i = 0; i < picture_cache_count;)
+    {
+        if (now - picture_cache[i].date > PICTURE_CACHE_EXPIRY)
+            picture_cache_Remove(i, &expired[n++]);
+        else
+            i++;
+    }
+
+    /* Make room by evicting the oldest buffers */
+    while (picture_cache_count >= PICTURE_CACHE_DEPTH
+        || picture_cache_bytes + size > PICTURE_CACHE_BYTES)
+    {
+        unsigned oldest = 0;
+
+        for (unsigned i = 1; i < picture_cache_count; i++)
+            if (picture_cache[i].date < picture_cache[oldest].date)
+                oldest = i;
+        picture_cache_Remove(oldest, &expired[n++]);
+    }
+
+    picture_cache[picture_cache_count++] = (struct picture_cached) {
+        .fd = fd, .base = base, .size = size, .date = now,
+    };
+    picture_cache_bytes += size;
+    vlc_mutex_unlock(&picture_cache_lock);
+
+    /* Unmapping can be slow, do not hold the lock */
+    while (n > 0)
+    {
+        n--;
+        picture_Deallocate(expired[n].fd, expired[n].base, expired[n].size);
+    }
+}
+
+static atomic_int picture_hugepages = PICTURE_HUGEPAGES_TRANSPARENT;
+static atomic_ulong picture_hugepages_transparent;
+static atomic_ulong picture_hugepages_explicit;
+
+void picture_SetHugePages(enum picture_hugepages mode)
+{
+    atomic_store_explicit(&picture_hugepages, mode, memory_order_relaxed);
+}
+
+enum picture_hugepages picture_GetHugePages(void)
+{
+    return atomic_load_explicit(&picture_hugepages, memory_order_relaxed);
+}
+
+void picture_CountHugePages(enum picture_hugepages mode)
+{
+    atomic_ulong *counter = (mode == PICTURE_HUGEPAGES_EXPLICIT)
+                          ? &picture_hugepages_explicit
+                          : &picture_hugepages_transparent;
+
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+}
+
+void picture_GetHugePagesStats(unsigned long *transparent,
+                               unsigned long *explicit_pages)
+{
+    *transparent = atomic_load_explicit(&picture_hugepages_transparent,
+                                        memory_order_relaxed);
+    *explicit_pages = atomic_load_explicit(&picture_hugepages_explicit,
+                                           memory_order_relaxed);
+}
+
+void picture_CacheFlush(void)
+{
+    vlc_mutex_lock(&picture_cache_lock);
+    while (picture_cache_count > 0)
+    {
+        struct picture_cached *entry = &picture_cache[--picture_cache_count];
+
+        picture_Deallocate(entry->fd, entry->base, entry->size);
+    }
+    picture_cache_bytes = 0;
+    vlc_mutex_unlock(&picture_cache_lock);
+}
+
 /**
  * Destroys a picture allocated with picture_NewFromFormat().
  */
@@ -68,7 +238,7 @@ static void picture_DestroyFromFormat(picture_t *pic)
     picture_buffer_t *res = pic->p_sys;
 
     if (res != NULL)
-        picture_Deallocate(res->fd, res->base, res->size);
+        picture_DeallocateCached(res->fd, res->base, res->size);
 }
 
 VLC_WEAK void *picture_Allocate(int *restrict fdp, size_t size)
@@ -97,6 +267,7 @@ void picture_Reset( picture_t *p_picture )
     p_picture->b_progressive = false;
     p_picture->i_nb_fields = 2;
     p_picture->b_top_field_first = false;
+    p_picture->b_keyframe = false;
     PictureDestroyContext( p_picture );
 }
 
@@ -299,7 +470,14 @@ picture_t *picture_NewFromFormat(const video_format_t *restrict fmt)
     if (unlikely(pic_size >= PICTURE_SW_SIZE_MAX))
         goto error;
 
-    unsigned char *buf = picture_Allocate(&res->fd, pic_size);
+    pic_size = picture_cache_Class(pic_size);
+    /* Explicit huge pages are only mapped whole */
+    if (pic_size >= PICTURE_HUGEPAGE_SIZE
+     && picture_GetHugePages() == PICTURE_HUGEPAGES_EXPLICIT)
+        pic_size = (pic_size + PICTURE_HUGEPAGE_SIZE - 1)
+                   & ~(size_t)(PICTURE_HUGEPAGE_SIZE - 1);
+
+    unsigned char *buf = picture_AllocateCached(&res->fd, pic_size);
     if (unlikely(buf == NULL))
         goto error;
 
@@ -397,6 +575,7 @@ void picture_CopyProperties( picture_t *p_dst, const picture_t *p_src )
     p_dst->b_progressive = p_src->b_progressive;
     p_dst->i_nb_fields = p_src->i_nb_fields;
     p_dst->b_top_field_first = p_src->b_top_field_first;
+    p_dst->b_keyframe = p_src->b_keyframe;
 }
 
 void picture_CopyPixels( picture_t *p_dst, const picture_t *p_src )
@@ -36,4 +36,38 @@ typedef struct
 void *picture_Allocate(int *, size_t);
 void picture_Deallocate(int, void *, size_t);
 
+/**
+ * Frees the recycled picture buffers.
+ */
+void picture_CacheFlush(void);
+
+/** Huge page size, and smallest picture buffer backed by huge pages */
+#define PICTURE_HUGEPAGE_SIZE (2 << 20)
+
+enum picture_hugepages
+{
+    PICTURE_HUGEPAGES_NONE,
+    PICTURE_HUGEPAGES_TRANSPARENT, /**< madvise(MADV_HUGEPAGE) */
+    PICTURE_HUGEPAGES_EXPLICIT, /**< MFD_HUGETLB, or transparent */
+};
+
+/**
+ * Selects how the picture buffers are backed with huge pages, as the
+ * "picture-hugepages" option.
+ */
+void picture_SetHugePages(enum picture_hugepages);
+enum picture_hugepages picture_GetHugePages(void);
+
+/**
+ * Counts a picture buffer allocation with huge pages.
+ */
+void picture_CountHugePages(enum picture_hugepages);
+
+/**
+ * Gets the number of picture buffers allocated with transparent huge pages
+ * (advised, the kernel may not use them) and with explicit huge pages.
+ */
+void picture_GetHugePagesStats(unsigned long *transparent,
+                               unsigned long *explicit_pages);
+
 picture_t * picture_InternalClone(picture_t *, void (*pf_destroy)(picture_t *), void *);
@@ -146,23 +146,23 @@ subpicture_t *subpicture_NewFromPicture( vlc_object_t *p_obj,
     return p_subpic;
 }
 
-void subpicture_Update( subpicture_t *p_subpicture,
-                        const video_format_t *p_fmt_src,
-                        const video_format_t *p_fmt_dst,
-                        vlc_tick_t i_ts )
+bool subpicture_UpdateInternal( subpicture_t *p_subpicture,
+                                const video_format_t *p_fmt_src,
+                                const video_format_t *p_fmt_dst,
+                                vlc_tick_t i_ts )
 {
     subpicture_updater_t *p_upd = &p_subpicture->updater;
     subpicture_private_t *p_private = p_subpicture->p_private;
 
     if( !p_upd->pf_validate )
-        return;
+        return false;
     if( !p_upd->pf_validate( p_subpicture,
                           !video_format_IsSimilar( p_fmt_src,
                                                    &p_private->src ), p_fmt_src,
                           !video_format_IsSimilar( p_fmt_dst,
                                                    &p_private->dst ), p_fmt_dst,
                           i_ts ) )
-        return;
+        return false;
 
     subpicture_region_ChainDelete( p_subpicture->p_region );
     p_subpicture->p_region = NULL;
@@ -174,6 +174,15 @@ void subpicture_Update( subpicture_t *p_subpicture,
 
     video_format_Copy( &p_private->src, p_fmt_src );
     video_format_Copy( &p_private->dst, p_fmt_dst );
+    return true;
+}
+
+void subpicture_Update( subpicture_t *p_subpicture,
+                        const video_format_t *p_fmt_src,
+                        const video_format_t *p_fmt_dst,
+                        vlc_tick_t i_ts )
+{
+    subpicture_UpdateInternal( p_subpicture, p_fmt_src, p_fmt_dst, i_ts );
 }
 
 
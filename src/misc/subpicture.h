@@ -27,6 +27,10 @@ struct subpicture_region_private_t {
 
 subpicture_region_t * subpicture_region_NewInternal( const video_format_t *p_fmt );
 
+/* Same as subpicture_Update(), returns true if the regions were regenerated */
+bool subpicture_UpdateInternal( subpicture_t *, const video_format_t *src,
+                                const video_format_t *dst, vlc_tick_t );
+
 subpicture_region_private_t *subpicture_region_private_New(video_format_t *);
 void subpicture_region_private_Delete(subpicture_region_private_t *);
 
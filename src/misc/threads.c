@@ -26,6 +26,9 @@
 #include <errno.h>
 
 #include <vlc_common.h>
+#ifdef ENABLE_LOCK_PROFILING
+# include <vlc_fs.h>
+#endif
 #include "libvlc.h"
 
 /*** Global locks ***/
@@ -140,6 +143,292 @@ bool vlc_mutex_marked(const vlc_mutex_t *mutex)
 }
 #endif
 
+#ifdef ENABLE_LOCK_PROFILING
+# include <stdatomic.h>
+# include <stdlib.h>
+# ifdef HAVE_SEARCH_H
+#  include <search.h>
+# endif
+# ifdef HAVE_DLADDR
+#  include <dlfcn.h>
+# endif
+
+/* Statistics of the mutexes created (or first locked, for the static ones)
+ * from the same code address */
+struct vlc_mutex_site
+{
+    const void *site;
+    uint64_t locks;
+    uint64_t contentions;
+    vlc_tick_t wait, wait_max;
+    vlc_tick_t hold, hold_max;
+};
+
+struct vlc_mutex_prof
+{
+    const vlc_mutex_t *mutex;
+    struct vlc_mutex_site *site;
+    vlc_tick_t locked_at;
+    unsigned depth; /* recursive locking */
+};
+
+/* The profiler cannot use the mutexes it profiles */
+static atomic_flag vlc_mutex_prof_lock = ATOMIC_FLAG_INIT;
+static void *vlc_mutex_prof_mutexes = NULL;
+static void *vlc_mutex_prof_sites = NULL;
+
+static void vlc_mutex_prof_acquire(void)
+{
+    while (atomic_flag_test_and_set_explicit(&vlc_mutex_prof_lock,
+                                             memory_order_acquire));
+}
+
+static void vlc_mutex_prof_release(void)
+{
+    atomic_flag_clear_explicit(&vlc_mutex_prof_lock, memory_order_release);
+}
+
+static int vlc_mutex_prof_cmp(const void *a, const void *b)
+{
+    const struct vlc_mutex_prof *pa = a, *pb = b;
+
+    if (pa->mutex == pb->mutex)
+        return 0;
+    return ((uintptr_t)pa->mutex > (uintptr_t)pb->mutex) ? +1 : -1;
+}
+
+static int vlc_mutex_site_cmp(const void *a, const void *b)
+{
+    const struct vlc_mutex_site *sa = a, *sb = b;
+
+    if (sa->site == sb->site)
+        return 0;
+    return ((uintptr_t)sa->site > (uintptr_t)sb->site) ? +1 : -1;
+}
+
+static struct vlc_mutex_site *vlc_mutex_prof_GetSite(const void *site)
+{
+    struct vlc_mutex_site *entry = malloc(sizeof (*entry));
+    if (unlikely(entry == NULL))
+        abort();
+
+    memset(entry, 0, sizeof (*entry));
+    entry->site = site;
+
+    void **node = tsearch(entry, &vlc_mutex_prof_sites, vlc_mutex_site_cmp);
+    if (unlikely(node == NULL))
+        abort();
+    if (*node != entry)
+        free(entry);
+    return *node;
+}
+
+/* Must be called with the profiler lock */
+static struct vlc_mutex_prof *vlc_mutex_prof_Get(const vlc_mutex_t *mutex,
+                                                 const void *site)
+{
+    struct vlc_mutex_prof *prof = malloc(sizeof (*prof));
+    if (unlikely(prof == NULL))
+        abort();
+
+    prof->mutex = mutex;
+    prof->site = NULL;
+    prof->depth = 0;
+
+    void **node = tsearch(prof, &vlc_mutex_prof_mutexes, vlc_mutex_prof_cmp);
+    if (unlikely(node == NULL))
+        abort();
+    if (*node != prof)
+        free(prof);
+    else
+        prof->site = vlc_mutex_prof_GetSite(site);
+    return *node;
+}
+
+void vlc_mutex_profile_init(const vlc_mutex_t *mutex, const void *site)
+{
+    vlc_mutex_prof_acquire();
+    struct vlc_mutex_prof *prof = vlc_mutex_prof_Get(mutex, site);
+    /* The address may be reused from a mutex not destroyed */
+    prof->site = vlc_mutex_prof_GetSite(site);
+    prof->depth = 0;
+    vlc_mutex_prof_release();
+}
+
+void vlc_mutex_profile_destroy(const vlc_mutex_t *mutex)
+{
+    struct vlc_mutex_prof key = { .mutex = mutex };
+
+    vlc_mutex_prof_acquire();
+    void **node = tfind(&key, &vlc_mutex_prof_mutexes, vlc_mutex_prof_cmp);
+    if (node != NULL)
+    {
+        struct vlc_mutex_prof *prof = *node;
+        tdelete(prof, &vlc_mutex_prof_mutexes, vlc_mutex_prof_cmp);
+        free(prof);
+    }
+    vlc_mutex_prof_release();
+}
+
+void vlc_mutex_profile_lock(const vlc_mutex_t *mutex, const void *site,
+                            bool contended, vlc_tick_t wait)
+{
+    vlc_tick_t now = vlc_tick_now();
+
+    vlc_mutex_prof_acquire();
+    struct vlc_mutex_prof *prof = vlc_mutex_prof_Get(mutex, site);
+    struct vlc_mutex_site *stats = prof->site;
+
+    if (prof->depth++ == 0)
+        prof->locked_at = now;
+    stats->locks++;
+    if (contended)
+    {
+        stats->contentions++;
+        stats->wait += wait;
+        if (wait > stats->wait_max)
+            stats->wait_max = wait;
+    }
+    vlc_mutex_prof_release();
+}
+
+void vlc_mutex_profile_unlock(const vlc_mutex_t *mutex)
+{
+    struct vlc_mutex_prof key = { .mutex = mutex };
+    vlc_tick_t now = vlc_tick_now();
+
+    vlc_mutex_prof_acquire();
+    void **node = tfind(&key, &vlc_mutex_prof_mutexes, vlc_mutex_prof_cmp);
+    if (node != NULL)
+    {
+        struct vlc_mutex_prof *prof = *node;
+
+        if (prof->depth > 0 && --prof->depth == 0)
+        {
+            struct vlc_mutex_site *stats = prof->site;
+            vlc_tick_t hold = now - prof->locked_at;
+
+            stats->hold += hold;
+            if (hold > stats->hold_max)
+                stats->hold_max = hold;
+        }
+    }
+    vlc_mutex_prof_release();
+}
+
+/* twalk() has no opaque pointer */
+static struct vlc_mutex_site *vlc_mutex_prof_report;
+static size_t vlc_mutex_prof_count;
+
+static void vlc_mutex_prof_Collect(const void *node, const VISIT which,
+                                   const int depth)
+{
+    (void) depth;
+    if (which != postorder && which != leaf)
+        return;
+
+    const struct vlc_mutex_site *stats = *(const void **)node;
+    if (vlc_mutex_prof_report != NULL)
+        vlc_mutex_prof_report[vlc_mutex_prof_count] = *stats;
+    vlc_mutex_prof_count++;
+}
+
+static int vlc_mutex_prof_CmpWait(const void *a, const void *b)
+{
+    const struct vlc_mutex_site *sa = a, *sb = b;
+
+    if (sa->wait != sb->wait)
+        return sa->wait < sb->wait ? +1 : -1;
+    return sa->contentions < sb->contentions ? +1
+         : sa->contentions > sb->contentions ? -1 : 0;
+}
+
+static const char *vlc_mutex_prof_Symbol(const void *site, uintptr_t *offset)
+{
+# ifdef HAVE_DLADDR
+    Dl_info info;
+
+    if (dladdr(site, &info) && info.dli_sname != NULL)
+    {
+        *offset = (uintptr_t)site - (uintptr_t)info.dli_saddr;
+        return info.dli_sname;
+    }
+# endif
+    *offset = (uintptr_t)site;
+    return "?";
+}
+
+void vlc_mutex_profile_Dump(vlc_object_t *obj)
+{
+    /* Copy the statistics, so that the report is not written with the
+     * profiler lock held */
+    vlc_mutex_prof_acquire();
+    vlc_mutex_prof_report = NULL;
+    vlc_mutex_prof_count = 0;
+    twalk(vlc_mutex_prof_sites, vlc_mutex_prof_Collect);
+
+    struct vlc_mutex_site *report =
+        vlc_alloc(vlc_mutex_prof_count, sizeof (*report));
+    vlc_mutex_prof_report = report;
+    if (report != NULL)
+    {
+        vlc_mutex_prof_count = 0;
+        twalk(vlc_mutex_prof_sites, vlc_mutex_prof_Collect);
+    }
+    size_t count = vlc_mutex_prof_count;
+    vlc_mutex_prof_report = NULL;
+    vlc_mutex_prof_release();
+
+    if (report == NULL)
+        return;
+
+    qsort(report, count, sizeof (*report), vlc_mutex_prof_CmpWait);
+
+    /* The most contended locks in the log */
+    for (size_t i = 0; i < count && i < 16 && report[i].contentions > 0; i++)
+    {
+        const struct vlc_mutex_site *stats = &report[i];
+        uintptr_t offset;
+        const char *sym = vlc_mutex_prof_Symbol(stats->site, &offset);
+
+        msg_Info(obj, "mutex %s+0x%"PRIxPTR": %"PRIu64"/%"PRIu64" contended, "
+                 "wait %"PRId64"/%"PRId64" us, hold %"PRId64"/%"PRId64" us "
+                 "(total/max)", sym, offset, stats->contentions, stats->locks,
+                 stats->wait, stats->wait_max, stats->hold, stats->hold_max);
+    }
+
+    /* Everything in the JSON report */
+    const char *path = getenv("VLC_LOCK_PROFILE");
+    FILE *stream = path != NULL ? vlc_fopen(path, "wt") : NULL;
+    if (stream != NULL)
+    {
+        fputs("[\n", stream);
+        for (size_t i = 0; i < count; i++)
+        {
+            const struct vlc_mutex_site *stats = &report[i];
+            uintptr_t offset;
+            const char *sym = vlc_mutex_prof_Symbol(stats->site, &offset);
+
+            fprintf(stream, "  { \"site\": \"%p\", \"symbol\": \"%s\", "
+                    "\"offset\": %"PRIuPTR", \"locks\": %"PRIu64", "
+                    "\"contentions\": %"PRIu64", \"wait_us\": %"PRId64", "
+                    "\"wait_max_us\": %"PRId64", \"hold_us\": %"PRId64", "
+                    "\"hold_max_us\": %"PRId64" }%s\n", stats->site, sym,
+                    offset, stats->locks, stats->contentions, stats->wait,
+                    stats->wait_max, stats->hold, stats->hold_max,
+                    i + 1 < count ? "," : "");
+        }
+        fputs("]\n", stream);
+        fclose(stream);
+        msg_Info(obj, "mutex profile written to %s", path);
+    }
+    else if (path != NULL)
+        msg_Err(obj, "cannot write the mutex profile to %s: %s", path,
+                vlc_strerror_c(errno));
+    free(report);
+}
+#endif
+
 #if defined (_WIN32) && (_WIN32_WINNT < _WIN32_WINNT_WIN8)
 /* Cannot define OS version-dependent stuff in public headers */
 # undef LIBVLC_NEED_SLEEP
@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * tracer.c: tracing interface
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_tracer.h>
+#include "../libvlc.h"
+
+struct vlc_tracer
+{
+    struct vlc_object_t obj;
+    const struct vlc_tracer_operations *ops;
+    void *opaque;
+};
+
+void vlc_tracer_Trace(struct vlc_tracer *tracer, const char *category,
+                      const char *name, enum vlc_tracer_phase phase,
+                      const void *object, vlc_tick_t pts)
+{
+    struct vlc_tracer_event event = {
+        .category = category,
+        .name = name,
+        .phase = phase,
+        .date = vlc_tick_now(),
+        .thread = vlc_thread_id(),
+        .object = object,
+        .pts = pts,
+    };
+
+    assert(tracer != NULL);
+    tracer->ops->trace(tracer->opaque, &event);
+}
+
+#undef vlc_object_get_tracer
+struct vlc_tracer *vlc_object_get_tracer(vlc_object_t *obj)
+{
+    return libvlc_priv(vlc_object_instance(obj))->tracer;
+}
+
+static int vlc_tracer_load(void *func, bool forced, va_list ap)
+{
+    const struct vlc_tracer_operations *(*activate)(vlc_object_t *,
+                                                    void **) = func;
+    struct vlc_tracer *tracer = va_arg(ap, struct vlc_tracer *);
+
+    (void) forced;
+    tracer->ops = activate(VLC_OBJECT(tracer), &tracer->opaque);
+    return (tracer->ops != NULL) ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+/**
+ * Loads the tracer module selected by the "tracer" option, if any.
+ */
+void vlc_TracerInit(libvlc_int_t *vlc)
+{
+    libvlc_priv_t *priv = libvlc_priv(vlc);
+
+    assert(priv->tracer == NULL);
+
+    char *name = var_InheritString(vlc, "tracer");
+    if (name == NULL)
+        return; /* Tracing disabled */
+
+    struct vlc_tracer *tracer = vlc_custom_create(VLC_OBJECT(vlc),
+                                                  sizeof (*tracer), "tracer");
+    if (likely(tracer != NULL))
+    {
+        if (vlc_module_load(VLC_OBJECT(tracer), "tracer", name, true,
+                            vlc_tracer_load, tracer) != NULL)
+            priv->tracer = tracer;
+        else
+            vlc_object_delete(VLC_OBJECT(tracer));
+    }
+    free(name);
+}
+
+/**
+ * Unloads the tracer module, once the pipeline is destroyed.
+ */
+void vlc_TracerDestroy(libvlc_int_t *vlc)
+{
+    libvlc_priv_t *priv = libvlc_priv(vlc);
+    struct vlc_tracer *tracer = priv->tracer;
+
+    if (tracer == NULL)
+        return;
+
+    priv->tracer = NULL;
+    if (tracer->ops->destroy != NULL)
+        tracer->ops->destroy(tracer->opaque);
+    vlc_object_delete(VLC_OBJECT(tracer));
+}
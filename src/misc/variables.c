@@ -27,9 +27,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -67,7 +64,8 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     hash;     /**< Hash of the name */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -136,23 +134,94 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/*
+ * The variables of an object are stored in an open addressing hash table
+ * with linear probing, kept at most half full. Each variable caches the hash
+ * of its name, so that only matching hashes are compared as strings, and the
+ * table can grow without hashing the names again.
+ */
+#define VAR_TABLE_MIN_SIZE 16
+
+static uint32_t VarHash( const char *name )
+{
+    /* FNV-1a */
+    uint32_t h = 2166136261u;
+    for( const unsigned char *p = (const unsigned char *)name; *p; p++ )
+        h = (h ^ *p) * 16777619u;
+    return h;
+}
+
+static size_t VarFind( const vlc_object_internals_t *priv, const char *name,
+                       uint32_t hash )
+{
+    size_t mask = priv->var_size - 1;
+    size_t i;
+
+    for( i = hash & mask; priv->var_table[i] != NULL; i = (i + 1) & mask )
+    {
+        const variable_t *var = priv->var_table[i];
+        if( var->hash == hash && !strcmp( var->psz_name, name ) )
+            break;
+    }
+    return i; /* the slot of the variable, or an empty slot */
+}
+
+static int VarReserve( vlc_object_internals_t *priv )
 {
-    const variable_t *va = a, *vb = b;
+    if( 2 * (priv->var_count + 1) <= priv->var_size )
+        return VLC_SUCCESS;
+
+    size_t size = priv->var_size ? 2 * priv->var_size : VAR_TABLE_MIN_SIZE;
+    variable_t **table = calloc( size, sizeof( *table ) );
+    if( unlikely(table == NULL) )
+        return VLC_ENOMEM;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    for( size_t i = 0; i < priv->var_size; i++ )
+    {
+        variable_t *var = priv->var_table[i];
+        if( var == NULL )
+            continue;
+
+        size_t j = var->hash & (size - 1);
+        while( table[j] != NULL )
+            j = (j + 1) & (size - 1);
+        table[j] = var;
+    }
+
+    free( priv->var_table );
+    priv->var_table = table;
+    priv->var_size = size;
+    return VLC_SUCCESS;
+}
+
+static void VarRemove( vlc_object_internals_t *priv, size_t i )
+{
+    size_t mask = priv->var_size - 1;
+
+    /* shift back the entries which would not be reachable anymore */
+    for( size_t j = (i + 1) & mask; priv->var_table[j]; j = (j + 1) & mask )
+    {
+        size_t k = priv->var_table[j]->hash & mask;
+        /* move the entry to i unless its home slot k lies in (i, j] */
+        bool reachable = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+        if( !reachable )
+        {
+            priv->var_table[i] = priv->var_table[j];
+            i = j;
+        }
+    }
+    priv->var_table[i] = NULL;
+    priv->var_count--;
 }
 
 static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    void **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    if( priv->var_size == 0 )
+        return NULL;
+    return priv->var_table[VarFind( priv, psz_name, VarHash( psz_name ) )];
 }
 
 static void Destroy( variable_t *p_var )
@@ -295,6 +364,7 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->hash = VarHash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -352,17 +422,24 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    void **pp_var;
     variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
+    variable_t **pp_var = NULL;
+
+    if( likely(VarReserve( p_priv ) == VLC_SUCCESS) )
+        pp_var = &p_priv->var_table[VarFind( p_priv, psz_name, p_var->hash )];
+
     if( unlikely(pp_var == NULL) )
         ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
+    else if( (p_oldvar = *pp_var) == NULL ) /* Variable create */
+    {
+        *pp_var = p_var;
+        p_priv->var_count++;
         p_var = NULL; /* Variable created */
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -392,7 +469,7 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        VarRemove( p_priv, VarFind( p_priv, psz_name, p_var->hash ) );
     }
     else
     {
@@ -405,17 +482,18 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    for( size_t i = 0; i < priv->var_size; i++ )
+        if( priv->var_table[i] != NULL )
+            Destroy( priv->var_table[i] );
+
+    free( priv->var_table );
+    priv->var_table = NULL;
+    priv->var_size = 0;
+    priv->var_count = 0;
 }
 
 int (var_Change)(vlc_object_t *p_this, const char *psz_name, int i_action, ...)
@@ -1135,19 +1213,9 @@ error:
     return VLC_EGENERIC;
 }
 
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
+static int NameCmp(const void *a, const void *b)
 {
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
+    return strcmp(*(char *const *)a, *(char *const *)b);
 }
 
 char **var_GetAllNames(vlc_object_t *obj)
@@ -1157,11 +1225,23 @@ char **var_GetAllNames(vlc_object_t *obj)
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    for (size_t i = 0; i < priv->var_size; i++)
+    {
+        const variable_t *var = priv->var_table[i];
+        if (var == NULL)
+            continue;
+
+        char *dup = strdup(var->psz_name);
+        if (dup != NULL)
+            ARRAY_APPEND(names, dup);
+    }
     vlc_mutex_unlock(&priv->var_lock);
 
+    /* keep the same (sorted) order as the former tree walk */
+    if (names.i_size > 0)
+        qsort(names.p_elems, names.i_size, sizeof (char *), NameCmp);
+
     if (names.i_size == 0)
         return NULL;
     ARRAY_APPEND(names, NULL);
@@ -37,13 +37,17 @@ struct vlc_object_internals
     vlc_object_t *parent; /**< Parent object (or NULL) */
     const char *typename; /**< Object type human-readable name */
 
-    /* Object variables */
-    void           *var_root;
+    /* Object variables (hash table, see variables.c) */
+    struct variable_t **var_table;
+    size_t          var_size;
+    size_t          var_count;
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
     /* Object resources */
     struct vlc_res *resources;
+
+    bool embedded; /**< allocated along with the object */
 };
 
 # define vlc_internals(o) ((o)->priv)
@@ -36,9 +36,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -51,108 +48,119 @@
 
 typedef struct vlc_modcap
 {
-    char *name;
+    const char *name;
     module_t **modv;
     size_t modc;
 } vlc_modcap_t;
 
 static int vlc_modcap_cmp(const void *a, const void *b)
 {
-    const vlc_modcap_t *capa = a, *capb = b;
-    return strcmp(capa->name, capb->name);
-}
-
-static void vlc_modcap_free(void *data)
-{
-    vlc_modcap_t *cap = data;
-
-    free(cap->modv);
-    free(cap->name);
-    free(cap);
+    const char *const *name = a;
+    const vlc_modcap_t *cap = b;
+    return strcmp(*name, cap->name);
 }
 
 static int vlc_module_cmp (const void *a, const void *b)
 {
     const module_t *const *ma = a, *const *mb = b;
+    int ret = strcmp(module_get_capability(*ma), module_get_capability(*mb));
+    if (ret != 0)
+        return ret;
     /* Note that qsort() uses _ascending_ order,
      * so the smallest module is the one with the biggest score. */
     return (*mb)->i_score - (*ma)->i_score;
 }
 
-static void vlc_modcap_sort(const void *node, const VISIT which,
-                            const int depth)
-{
-    vlc_modcap_t *const *cp = node, *cap = *cp;
-
-    if (which != postorder && which != leaf)
-        return;
-
-    qsort(cap->modv, cap->modc, sizeof (*cap->modv), vlc_module_cmp);
-    (void) depth;
-}
-
 static struct
 {
     vlc_mutex_t lock;
     block_t *caches;
-    void *caps_tree;
+    module_t **modv; /**< All modules, sorted by capability then score */
+    vlc_modcap_t *capv; /**< Capabilities, sorted by name */
+    size_t capc;
     unsigned usage;
-} modules = { VLC_STATIC_MUTEX, NULL, NULL, 0 };
+} modules = { VLC_STATIC_MUTEX, NULL, NULL, NULL, 0, 0 };
 
 vlc_plugin_t *vlc_plugins = NULL;
 
 /**
- * Adds a module to the bank
+ * Adds a plugin (and all its modules) to the bank
+ *
+ * \note The capability index must be rebuilt with vlc_modcap_index() once
+ * all plugins are stored.
  */
-static int vlc_module_store(module_t *mod)
+static void vlc_plugin_store(vlc_plugin_t *lib)
 {
-    const char *name = module_get_capability(mod);
-    vlc_modcap_t *cap = malloc(sizeof (*cap));
-    if (unlikely(cap == NULL))
-        return -1;
-
-    cap->name = strdup(name);
-    cap->modv = NULL;
-    cap->modc = 0;
-
-    if (unlikely(cap->name == NULL))
-        goto error;
-
-    void **cp = tsearch(cap, &modules.caps_tree, vlc_modcap_cmp);
-    if (unlikely(cp == NULL))
-        goto error;
-
-    if (*cp != cap)
-    {
-        vlc_modcap_free(cap);
-        cap = *cp;
-    }
-
-    module_t **modv = realloc(cap->modv, sizeof (*modv) * (cap->modc + 1));
-    if (unlikely(modv == NULL))
-        return -1;
+    vlc_mutex_assert(&modules.lock);
 
-    cap->modv = modv;
-    cap->modv[cap->modc] = mod;
-    cap->modc++;
-    return 0;
-error:
-    vlc_modcap_free(cap);
-    return -1;
+    lib->next = vlc_plugins;
+    vlc_plugins = lib;
 }
 
 /**
- * Adds a plugin (and all its modules) to the bank
+ * (Re)builds the capability index of the bank
+ *
+ * All modules are sorted in a single pass into one flat table, and each
+ * capability refers to a slice of it. This avoids one allocation per module
+ * and the search tree.
  */
-static void vlc_plugin_store(vlc_plugin_t *lib)
+static void vlc_modcap_index(void)
 {
     vlc_mutex_assert(&modules.lock);
 
-    lib->next = vlc_plugins;
-    vlc_plugins = lib;
+    module_ResetLoadCache();
+
+    size_t n = 0;
+
+    for (vlc_plugin_t *lib = vlc_plugins; lib != NULL; lib = lib->next)
+        n += lib->modules_count;
+
+    free(modules.capv);
+    free(modules.modv);
+    modules.capv = NULL;
+    modules.capc = 0;
+
+    modules.modv = vlc_alloc(n, sizeof (*modules.modv));
+    if (unlikely(modules.modv == NULL))
+        return;
+
+    size_t i = 0;
+
+    for (vlc_plugin_t *lib = vlc_plugins; lib != NULL; lib = lib->next)
+        for (module_t *m = lib->module; m != NULL; m = m->next)
+            modules.modv[i++] = m;
+    assert(i == n);
+
+    qsort(modules.modv, n, sizeof (*modules.modv), vlc_module_cmp);
+
+    /* Count distinct capabilities, then slice the table */
+    size_t capc = 0;
+
+    for (i = 0; i < n; i++)
+        if (i == 0 || strcmp(module_get_capability(modules.modv[i - 1]),
+                             module_get_capability(modules.modv[i])))
+            capc++;
 
-    for (module_t *m = lib->module; m != NULL; m = m->next)
-        vlc_module_store(m);
+    modules.capv = vlc_alloc(capc, sizeof (*modules.capv));
+    if (unlikely(modules.capv == NULL))
+        return;
+
+    vlc_modcap_t *cap = NULL;
+
+    for (i = 0; i < n; i++)
+    {
+        const char *name = module_get_capability(modules.modv[i]);
+
+        if (cap == NULL || strcmp(cap->name, name))
+        {
+            cap = &modules.capv[modules.capc++];
+            cap->name = name;
+            cap->modv = &modules.modv[i];
+            cap->modc = 0;
+        }
+        cap->modc++;
+    }
+    assert(modules.capc == capc);
 }
 
 /**
@@ -284,6 +292,15 @@ typedef enum
     CACHE_WRITE_FILE = 0x4,
 } cache_mode_t;
 
+typedef struct module_scan
+{
+    char         *abspath;
+    char         *relpath;
+    int64_t       mtime;
+    uint64_t      size;
+    vlc_plugin_t *plugin;
+} module_scan_t;
+
 typedef struct module_bank
 {
     vlc_object_t *obj;
@@ -293,64 +310,160 @@ typedef struct module_bank
     size_t        size;
     vlc_plugin_t **plugins;
     vlc_plugin_t *cache;
+
+    /* Plug-in files found, in directory browsing order */
+    size_t        scan_count;
+    module_scan_t *scans;
+    atomic_size_t scan_next;
 } module_bank_t;
 
 /**
- * Scans a plug-in from a file.
+ * Queues a plug-in file for scanning.
+ *
+ * \note This takes ownership of the path strings.
+ */
+static int AllocatePluginFile (module_bank_t *bank, char *abspath,
+                               char *relpath, const struct stat *st)
+{
+    module_scan_t *scans = realloc(bank->scans,
+                                   (bank->scan_count + 1) * sizeof (*scans));
+    if (unlikely(scans == NULL))
+    {
+        free(abspath);
+        free(relpath);
+        return -1;
+    }
+
+    bank->scans = scans;
+    scans += bank->scan_count++;
+    scans->abspath = abspath;
+    scans->relpath = relpath;
+    scans->mtime = st->st_mtime;
+    scans->size = st->st_size;
+    scans->plugin = NULL;
+    return 0;
+}
+
+/**
+ * Loads the queued plug-ins that are not in the cache (thread).
+ */
+static void *AllocatePluginThread(void *data)
+{
+    module_bank_t *bank = data;
+
+    for (;;)
+    {
+        size_t i = atomic_fetch_add_explicit(&bank->scan_next, 1,
+                                             memory_order_relaxed);
+        if (i >= bank->scan_count)
+            break;
+
+        module_scan_t *scan = &bank->scans[i];
+        if (scan->plugin == NULL)
+            scan->plugin = module_InitDynamic(bank->obj, scan->abspath, true);
+    }
+    return NULL;
+}
+
+/**
+ * Scans the queued plug-in files.
+ *
+ * Plug-ins that are not in the cache (or whose cache entry is stale) must be
+ * loaded to run their descriptor. This is done concurrently by a pool of
+ * threads. The results are then stored in the bank in the directory browsing
+ * order, regardless of thread scheduling.
  */
-static int AllocatePluginFile (module_bank_t *bank, const char *abspath,
-                               const char *relpath, const struct stat *st)
+static void AllocatePluginFiles(module_bank_t *bank)
 {
-    vlc_plugin_t *plugin = NULL;
+    size_t missing = 0;
 
     /* Check our plugins cache first then load plugin if needed */
-    if (bank->mode & CACHE_READ_FILE)
+    for (size_t i = 0; i < bank->scan_count; i++)
     {
-        plugin = vlc_cache_lookup(&bank->cache, relpath);
+        module_scan_t *scan = &bank->scans[i];
 
-        if (plugin != NULL
-         && (plugin->mtime != (int64_t)st->st_mtime
-          || plugin->size != (uint64_t)st->st_size))
+        if (bank->mode & CACHE_READ_FILE)
         {
-            msg_Err(bank->obj, "stale plugins cache: modified %s",
-                    plugin->abspath);
-            vlc_plugin_destroy(plugin);
-            plugin = NULL;
+            vlc_plugin_t *plugin = vlc_cache_lookup(&bank->cache,
+                                                    scan->relpath);
+
+            if (plugin != NULL
+             && (plugin->mtime != scan->mtime || plugin->size != scan->size))
+            {
+                msg_Err(bank->obj, "stale plugins cache: modified %s",
+                        plugin->abspath);
+                vlc_plugin_destroy(plugin);
+                plugin = NULL;
+            }
+            scan->plugin = plugin;
         }
+
+        if (scan->plugin == NULL)
+            missing++;
     }
 
-    if (plugin == NULL)
+    if (missing > 0)
     {
-        char *path = strdup(relpath);
-        if (path == NULL)
-            return -1;
+        unsigned threads = __MIN(vlc_GetCPUCount(), 16);
+        vlc_thread_t *tids = NULL;
+
+        if (threads > missing)
+            threads = missing;
+        if (threads > 1)
+            tids = vlc_alloc(threads - 1, sizeof (*tids));
+        if (tids == NULL)
+            threads = 1;
+        else
+            msg_Dbg(bank->obj, "loading %zu plug-ins with %u threads",
+                    missing, threads);
 
-        plugin = module_InitDynamic(bank->obj, abspath, true);
+        atomic_init(&bank->scan_next, 0);
 
-        if (plugin != NULL)
-        {
-            plugin->path = path;
-            plugin->mtime = st->st_mtime;
-            plugin->size = st->st_size;
-        }
-        else free(path);
-    }
+        unsigned started = 0;
+        while (started < threads - 1
+            && vlc_clone(&tids[started], AllocatePluginThread, bank,
+                         VLC_THREAD_PRIORITY_LOW) == 0)
+            started++;
 
-    if (plugin == NULL)
-        return -1;
+        AllocatePluginThread(bank);
 
-    vlc_plugin_store(plugin);
+        for (unsigned i = 0; i < started; i++)
+            vlc_join(tids[i], NULL);
+        free(tids);
+    }
 
-    if (bank->mode & CACHE_WRITE_FILE) /* Add entry to to-be-saved cache */
+    for (size_t i = 0; i < bank->scan_count; i++)
     {
-        bank->plugins = xrealloc(bank->plugins,
-                                 (bank->size + 1) * sizeof (vlc_plugin_t *));
-        bank->plugins[bank->size] = plugin;
-        bank->size++;
+        module_scan_t *scan = &bank->scans[i];
+        vlc_plugin_t *plugin = scan->plugin;
+
+        if (plugin != NULL && plugin->path == NULL)
+        {   /* Freshly loaded plug-in */
+            plugin->path = scan->relpath;
+            plugin->mtime = scan->mtime;
+            plugin->size = scan->size;
+            scan->relpath = NULL;
+        }
+        free(scan->relpath);
+        free(scan->abspath);
+
+        if (plugin == NULL)
+            continue;
+
+        vlc_plugin_store(plugin);
+
+        if (bank->mode & CACHE_WRITE_FILE) /* Add entry to to-be-saved cache */
+        {
+            bank->plugins = xrealloc(bank->plugins,
+                                     (bank->size + 1) * sizeof (vlc_plugin_t *));
+            bank->plugins[bank->size] = plugin;
+            bank->size++;
+        }
     }
 
-    /* TODO: deal with errors */
-    return  0;
+    free(bank->scans);
+    bank->scans = NULL;
+    bank->scan_count = 0;
 }
 
 /**
@@ -418,7 +531,10 @@ static void AllocatePluginDir (module_bank_t *bank, unsigned maxdepth,
             if (len > strlen (LIBEXT)
              && !strcasecmp (file + len - strlen (LIBEXT), LIBEXT))
 #endif
+            {
                 AllocatePluginFile (bank, abspath, relpath, &st);
+                abspath = relpath = NULL;
+            }
         }
         else if (S_ISDIR (st.st_mode))
             /* Recurse into another directory */
@@ -455,6 +571,7 @@ static void AllocatePluginPath(vlc_object_t *obj, const char *path,
 
         /* Don't go deeper than 5 subdirectories */
         AllocatePluginDir(&bank, 5, path, NULL);
+        AllocatePluginFiles(&bank);
     }
 
     /* Deal with unmatched cache entries from cache file */
@@ -651,6 +768,7 @@ void module_InitBank (void)
         vlc_plugin_t *plugin = module_InitStatic(vlc_entry__core);
         if (likely(plugin != NULL))
             vlc_plugin_store(plugin);
+        vlc_modcap_index();
         config_SortConfig ();
     }
     modules.usage++;
@@ -673,7 +791,8 @@ void module_EndBank (bool b_plugins)
 {
     vlc_plugin_t *libs = NULL;
     block_t *caches = NULL;
-    void *caps_tree = NULL;
+    module_t **modv = NULL;
+    vlc_modcap_t *capv = NULL;
 
     /* If plugins were _not_ loaded, then the caller still has the bank lock
      * from module_InitBank(). */
@@ -688,14 +807,20 @@ void module_EndBank (bool b_plugins)
         config_UnsortConfig ();
         libs = vlc_plugins;
         caches = modules.caches;
-        caps_tree = modules.caps_tree;
+        modv = modules.modv;
+        capv = modules.capv;
         vlc_plugins = NULL;
         modules.caches = NULL;
-        modules.caps_tree = NULL;
+        modules.modv = NULL;
+        modules.capv = NULL;
+        modules.capc = 0;
     }
     vlc_mutex_unlock (&modules.lock);
 
-    tdestroy(caps_tree, vlc_modcap_free);
+    if (modv != NULL)
+        module_ResetLoadCache();
+    free(capv);
+    free(modv);
 
     while (libs != NULL)
     {
@@ -730,7 +855,7 @@ void module_LoadPlugins(vlc_object_t *obj)
         config_UnsortConfig ();
         config_SortConfig ();
 
-        twalk(modules.caps_tree, vlc_modcap_sort);
+        vlc_modcap_index();
     }
     vlc_mutex_unlock (&modules.lock);
 
@@ -792,14 +917,14 @@ module_t **module_list_get (size_t *n)
  */
 ssize_t module_list_cap (module_t ***restrict list, const char *name)
 {
-    const void **cp = tfind(&name, &modules.caps_tree, vlc_modcap_cmp);
-    if (cp == NULL)
+    const vlc_modcap_t *cap = bsearch(&name, modules.capv, modules.capc,
+                                      sizeof (*modules.capv), vlc_modcap_cmp);
+    if (cap == NULL)
     {
         *list = NULL;
         return 0;
     }
 
-    const vlc_modcap_t *cap = *cp;
     size_t n = cap->modc;
     module_t **tab = vlc_alloc (n, sizeof (*tab));
     *list = tab;
@@ -204,9 +204,8 @@ static int vlc_cache_load_config(module_config_t *cfg, block_t *file)
         for (unsigned i = 0; i < cfg->list_count; i++)
         {
             LOAD_STRING (cfg->list.psz[i]);
-            if (cfg->list.psz[i] == NULL /* NULL -> empty string */
-             && (cfg->list.psz[i] = calloc (1, 1)) == NULL)
-                goto error;
+            if (cfg->list.psz[i] == NULL) /* NULL -> empty string */
+                cfg->list.psz[i] = "";
         }
     }
     else
@@ -224,13 +223,15 @@ static int vlc_cache_load_config(module_config_t *cfg, block_t *file)
         LOAD_ARRAY(cfg->list.i, cfg->list_count);
     }
 
-    cfg->list_text = xmalloc (cfg->list_count * sizeof (char *));
+    /* Most items have no choices list: do not allocate anything then */
+    cfg->list_text = NULL;
+    if (cfg->list_count)
+        cfg->list_text = xmalloc (cfg->list_count * sizeof (char *));
     for (unsigned i = 0; i < cfg->list_count; i++)
     {
         LOAD_STRING (cfg->list_text[i]);
-        if (cfg->list_text[i] == NULL /* NULL -> empty string */
-         && (cfg->list_text[i] = calloc (1, 1)) == NULL)
-            goto error;
+        if (cfg->list_text[i] == NULL) /* NULL -> empty string */
+            cfg->list_text[i] = "";
     }
 
     return 0;
@@ -674,6 +675,10 @@ void CacheSave(vlc_object_t *p_this, const char *dir,
     }
 
 #if !defined( _WIN32 ) && !defined( __OS2__ )
+    /* Make sure the new cache is complete on disk before it replaces the old
+     * one, so that a crash cannot leave a truncated cache behind. */
+    if (fflush (file) == 0)
+        fsync (fileno (file));
     vlc_rename (tmpname, filename); /* atomically replace old cache */
     fclose (file);
 #else
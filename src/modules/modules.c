@@ -34,6 +34,7 @@
 # include <libintl.h>
 #endif
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_modules.h>
@@ -126,6 +127,188 @@ static int module_load(vlc_logger_t *log, module_t *m,
     return ret;
 }
 
+/*
+ * Module resolution cache
+ *
+ * Resolving a capability and a module names list into the ordered list of
+ * candidates to probe does not depend on the probed object, and the module
+ * bank is read-only once loaded. The resolved plans are cached in a small
+ * direct-mapped table, and flushed whenever the bank changes.
+ */
+struct vlc_module_candidate
+{
+    module_t *module;
+    bool force;
+};
+
+struct vlc_module_plan
+{
+    atomic_uint refs;
+    bool strict;
+    char *capability;
+    char *name;
+    ssize_t total; /**< modules having the capability */
+    size_t count; /**< candidates to probe */
+    struct vlc_module_candidate candv[];
+};
+
+#define VLC_MODULE_PLANS 64
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct vlc_module_plan *table[VLC_MODULE_PLANS];
+} plans = { VLC_STATIC_MUTEX, { NULL } };
+
+static void vlc_module_plan_release(struct vlc_module_plan *plan)
+{
+    if (plan == NULL
+     || atomic_fetch_sub_explicit(&plan->refs, 1, memory_order_acq_rel) != 1)
+        return;
+
+    free(plan->name);
+    free(plan->capability);
+    free(plan);
+}
+
+static size_t vlc_module_plan_slot(const char *capability, const char *name,
+                                   bool strict)
+{
+    uint32_t h = 2166136261u + strict;
+
+    for (const char *p = capability; *p; p++)
+        h = (h ^ (unsigned char)*p) * 16777619u;
+    h = (h ^ ',') * 16777619u;
+    for (const char *p = name; *p; p++)
+        h = (h ^ (unsigned char)*p) * 16777619u;
+    return h % VLC_MODULE_PLANS;
+}
+
+static struct vlc_module_plan *vlc_module_plan_create(const char *capability,
+                                                      const char *name,
+                                                      bool strict)
+{
+    module_t **mods;
+    ssize_t total = module_list_cap(&mods, capability);
+    size_t n = (total > 0) ? total : 0;
+
+    struct vlc_module_plan *plan = malloc(sizeof (*plan)
+                                          + n * sizeof (plan->candv[0]));
+    if (unlikely(plan == NULL))
+        goto error;
+
+    plan->strict = strict;
+    plan->capability = strdup(capability);
+    plan->name = strdup(name);
+    if (unlikely(plan->capability == NULL || plan->name == NULL))
+        goto error;
+
+    atomic_init(&plan->refs, 1);
+    plan->total = total;
+    plan->count = 0;
+
+    while (*name)
+    {
+        const char *shortcut = name;
+        size_t slen = strcspn (name, ",");
+
+        name += slen;
+        name += strspn (name, ",");
+
+        if (!strcasecmp ("none", shortcut))
+            goto done;
+
+        bool force = strict && strcasecmp ("any", shortcut);
+        for (size_t i = 0; i < n; i++)
+        {
+            module_t *cand = mods[i];
+            if (cand == NULL)
+                continue; // module already listed
+            if (!module_match_name(cand, shortcut, slen))
+                continue;
+            mods[i] = NULL; // only try each module once at most...
+
+            plan->candv[plan->count].module = cand;
+            plan->candv[plan->count].force = force;
+            plan->count++;
+        }
+    }
+
+    /* None of the shortcuts matched, fall back to any module */
+    if (!strict)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            module_t *cand = mods[i];
+            if (cand == NULL || module_get_score (cand) <= 0)
+                continue;
+
+            plan->candv[plan->count].module = cand;
+            plan->candv[plan->count].force = false;
+            plan->count++;
+        }
+    }
+done:
+    module_list_free (mods);
+    return plan;
+
+error:
+    if (plan != NULL)
+    {
+        free(plan->name);
+        free(plan->capability);
+        free(plan);
+    }
+    module_list_free (mods);
+    return NULL;
+}
+
+static struct vlc_module_plan *vlc_module_plan_get(const char *capability,
+                                                   const char *name,
+                                                   bool strict)
+{
+    size_t slot = vlc_module_plan_slot(capability, name, strict);
+    struct vlc_module_plan *plan;
+
+    vlc_mutex_lock(&plans.lock);
+    plan = plans.table[slot];
+    if (plan != NULL && plan->strict == strict
+     && !strcmp(plan->capability, capability) && !strcmp(plan->name, name))
+    {
+        atomic_fetch_add_explicit(&plan->refs, 1, memory_order_relaxed);
+        vlc_mutex_unlock(&plans.lock);
+        return plan;
+    }
+    vlc_mutex_unlock(&plans.lock);
+
+    plan = vlc_module_plan_create(capability, name, strict);
+    if (unlikely(plan == NULL))
+        return NULL;
+
+    /* One reference for the table, one for the caller */
+    atomic_fetch_add_explicit(&plan->refs, 1, memory_order_relaxed);
+    vlc_mutex_lock(&plans.lock);
+    struct vlc_module_plan *old = plans.table[slot];
+    plans.table[slot] = plan;
+    vlc_mutex_unlock(&plans.lock);
+
+    vlc_module_plan_release(old);
+    return plan;
+}
+
+void module_ResetLoadCache(void)
+{
+    struct vlc_module_plan *table[VLC_MODULE_PLANS];
+
+    vlc_mutex_lock(&plans.lock);
+    memcpy(table, plans.table, sizeof (table));
+    memset(plans.table, 0, sizeof (plans.table));
+    vlc_mutex_unlock(&plans.lock);
+
+    for (size_t i = 0; i < VLC_MODULE_PLANS; i++)
+        vlc_module_plan_release(table[i]);
+}
+
 /**
  * Finds and instantiates the best module of a certain type.
  * All candidates modules having the specified capability and name will be
@@ -154,14 +337,15 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
         name = "any";
 
     /* Find matching modules */
-    module_t **mods;
-    ssize_t total = module_list_cap (&mods, capability);
+    struct vlc_module_plan *plan = vlc_module_plan_get(capability, name,
+                                                       strict);
+    ssize_t total = (plan != NULL) ? plan->total : -1;
 
     vlc_debug(log, "looking for %s module matching \"%s\": %zd candidates",
               capability, name, total);
     if (total <= 0)
     {
-        module_list_free (mods);
+        vlc_module_plan_release(plan);
         vlc_debug(log, "no %s modules", capability);
         return NULL;
     }
@@ -170,62 +354,18 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
     va_list args;
 
     va_start(args, probe);
-    while (*name)
-    {
-        const char *shortcut = name;
-        size_t slen = strcspn (name, ",");
-
-        name += slen;
-        name += strspn (name, ",");
-
-        if (!strcasecmp ("none", shortcut))
-            goto done;
-
-        bool force = strict && strcasecmp ("any", shortcut);
-        for (ssize_t i = 0; i < total; i++)
-        {
-            module_t *cand = mods[i];
-            if (cand == NULL)
-                continue; // module failed in previous iteration
-            if (!module_match_name(cand, shortcut, slen))
-                continue;
-            mods[i] = NULL; // only try each module once at most...
-
-            int ret = module_load(log, cand, probe, force, args);
-            switch (ret)
-            {
-                case VLC_SUCCESS:
-                    module = cand;
-                    /* fall through */
-                case VLC_ETIMEOUT:
-                    goto done;
-            }
-        }
-    }
-
-    /* None of the shortcuts matched, fall back to any module */
-    if (!strict)
+    for (size_t i = 0; i < plan->count; i++)
     {
-        for (ssize_t i = 0; i < total; i++)
-        {
-            module_t *cand = mods[i];
-            if (cand == NULL || module_get_score (cand) <= 0)
-                continue;
+        const struct vlc_module_candidate *cand = &plan->candv[i];
+        int ret = module_load(log, cand->module, probe, cand->force, args);
 
-            int ret = module_load(log, cand, probe, false, args);
-            switch (ret)
-            {
-                case VLC_SUCCESS:
-                    module = cand;
-                    /* fall through */
-                case VLC_ETIMEOUT:
-                    goto done;
-            }
-        }
+        if (ret == VLC_SUCCESS)
+            module = cand->module;
+        if (ret == VLC_SUCCESS || ret == VLC_ETIMEOUT)
+            break;
     }
-done:
     va_end (args);
-    module_list_free (mods);
+    vlc_module_plan_release(plan);
 
     if (module != NULL)
         vlc_debug(log, "using %s module \"%s\"", capability,
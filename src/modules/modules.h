@@ -115,6 +115,13 @@ void *module_Symbol(struct vlc_logger *, vlc_plugin_t *, const char *name);
 
 ssize_t module_list_cap (module_t ***, const char *);
 
+/**
+ * Flushes the modules resolved by vlc_module_load().
+ *
+ * This must be called whenever the module bank changes.
+ */
+void module_ResetLoadCache(void);
+
 int vlc_bindtextdomain (const char *);
 
 /* Low-level OS-dependent handler */
@@ -35,6 +35,10 @@
 
 #include <sys/types.h>
 #include <vlc_network.h>
+#include <vlc_threads.h>
+#include <vlc_tick.h>
+#include <vlc_list.h>
+#include "libvlc.h"
 
 int vlc_getnameinfo( const struct sockaddr *sa, int salen,
                      char *host, int hostlen, int *portnum, int flags )
@@ -119,6 +123,165 @@ int vlc_getaddrinfo (const char *node, unsigned port,
     return getaddrinfo (node, servname, hints, res);
 }
 
+/* The system resolver does not report record TTLs: keep results for a
+ * fixed time, short enough not to defeat DNS-based load balancing. */
+#define GAI_CACHE_TTL  VLC_TICK_FROM_SEC(60)
+#define GAI_CACHE_SIZE 16
+
+struct vlc_gai_entry
+{
+    struct vlc_list node;
+    char *name;
+    unsigned port;
+    int family;
+    int socktype;
+    int protocol;
+    int flags;
+    struct addrinfo *res;
+    vlc_tick_t expiry;
+    unsigned refs;
+    bool stale; /**< Evicted, but still in use */
+};
+
+static struct vlc_list gai_cache = VLC_LIST_INITIALIZER(&gai_cache);
+static vlc_mutex_t gai_cache_lock = VLC_STATIC_MUTEX;
+static unsigned gai_cache_count = 0;
+
+static void vlc_gai_entry_delete(struct vlc_gai_entry *e)
+{
+    vlc_list_remove(&e->node);
+    freeaddrinfo(e->res);
+    free(e->name);
+    free(e);
+}
+
+/* Removes an entry from the cache. Called with the lock held. */
+static void vlc_gai_entry_evict(struct vlc_gai_entry *e)
+{
+    assert(!e->stale);
+    gai_cache_count--;
+
+    if (e->refs == 0)
+        vlc_gai_entry_delete(e);
+    else
+        e->stale = true;
+}
+
+static bool vlc_gai_entry_match(const struct vlc_gai_entry *e,
+                                const char *name, unsigned port,
+                                const struct addrinfo *hints)
+{
+    return !e->stale && e->port == port && !strcmp(e->name, name)
+        && e->family == hints->ai_family && e->socktype == hints->ai_socktype
+        && e->protocol == hints->ai_protocol && e->flags == hints->ai_flags;
+}
+
+int vlc_getaddrinfo_cached(const char *node, unsigned port,
+                           const struct addrinfo *hints,
+                           struct addrinfo **res)
+{
+    static const struct addrinfo nohints;
+    struct vlc_gai_entry *e;
+    const char *name = (node != NULL) ? node : "";
+    vlc_tick_t now = vlc_tick_now();
+
+    if (hints == NULL)
+        hints = &nohints;
+
+    vlc_mutex_lock(&gai_cache_lock);
+    vlc_list_foreach(e, &gai_cache, node)
+    {
+        if (!vlc_gai_entry_match(e, name, port, hints))
+            continue;
+
+        if (e->expiry <= now)
+        {
+            vlc_gai_entry_evict(e);
+            break;
+        }
+
+        e->refs++;
+        *res = e->res;
+        vlc_mutex_unlock(&gai_cache_lock);
+        return 0;
+    }
+    vlc_mutex_unlock(&gai_cache_lock);
+
+    e = malloc(sizeof (*e));
+    if (unlikely(e == NULL))
+        return EAI_MEMORY;
+
+    e->name = strdup(name);
+    if (unlikely(e->name == NULL))
+    {
+        free(e);
+        return EAI_MEMORY;
+    }
+
+    int val = vlc_getaddrinfo_i11e(node, port, hints, &e->res);
+    if (val)
+    {
+        free(e->name);
+        free(e);
+        return val;
+    }
+
+    e->port = port;
+    e->family = hints->ai_family;
+    e->socktype = hints->ai_socktype;
+    e->protocol = hints->ai_protocol;
+    e->flags = hints->ai_flags;
+    e->expiry = vlc_tick_now() + GAI_CACHE_TTL;
+    e->refs = 1;
+    e->stale = false;
+
+    vlc_mutex_lock(&gai_cache_lock);
+    /* Replace any concurrent result for the same query */
+    struct vlc_gai_entry *oldest = NULL, *f;
+
+    vlc_list_foreach(f, &gai_cache, node)
+    {
+        if (f->stale)
+            continue;
+        if (vlc_gai_entry_match(f, name, port, hints))
+        {
+            vlc_gai_entry_evict(f);
+            oldest = NULL;
+            break;
+        }
+        if (oldest == NULL || f->expiry < oldest->expiry)
+            oldest = f;
+    }
+
+    if (gai_cache_count >= GAI_CACHE_SIZE && oldest != NULL)
+        vlc_gai_entry_evict(oldest);
+
+    vlc_list_append(&e->node, &gai_cache);
+    gai_cache_count++;
+    vlc_mutex_unlock(&gai_cache_lock);
+
+    *res = e->res;
+    return 0;
+}
+
+void vlc_freeaddrinfo_cached(struct addrinfo *res)
+{
+    struct vlc_gai_entry *e;
+
+    vlc_mutex_lock(&gai_cache_lock);
+    vlc_list_foreach(e, &gai_cache, node)
+        if (e->res == res)
+        {
+            assert(e->refs > 0);
+            if (--e->refs == 0 && e->stale)
+                vlc_gai_entry_delete(e);
+            vlc_mutex_unlock(&gai_cache_lock);
+            return;
+        }
+    vlc_mutex_unlock(&gai_cache_lock);
+    vlc_assert_unreachable();
+}
+
 #if defined (_WIN32) || defined (__OS2__) \
  || defined (__ANDROID__) || defined (__APPLE__) \
  || defined (__native_client__)
@@ -47,13 +47,25 @@
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef __linux__
+# include <sys/sendfile.h>
+#endif
+#include <vlc_fs.h>
 
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#ifdef __linux__
+# include <sys/epoll.h>
+# define HTTPD_EPOLL 1
+/* Maximum readiness events handled per host loop iteration */
+# define HTTPD_EPOLL_EVENTS 256
+#endif
 
 #if defined(_WIN32)
 #   include <winsock2.h>
@@ -68,8 +80,22 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* Maximum bytes sent from a file per sendfile() call */
+#define HTTPD_SENDFILE_SIZE (1 << 20)
+
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+
+/* shared chunk of stream data */
+typedef struct httpd_chunk_t
+{
+    atomic_uint refs;
+    struct vlc_list node;
+    int64_t i_pos; /* absolute position of the first byte */
+    bool    b_keyframe;
+    block_t *p_block;
+} httpd_chunk_t;
+
+static void httpd_ChunkRelease(httpd_chunk_t *chunk);
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -97,6 +123,11 @@ struct httpd_host_t
 
     size_t client_count;
     struct vlc_list clients;
+#ifdef HTTPD_EPOLL
+    int  epfd;
+    /* clients were destroyed outside of the host thread */
+    bool b_clients_removed;
+#endif
 
     /* TLS data */
     vlc_tls_server_t *p_tls;
@@ -155,6 +186,20 @@ struct httpd_client_t
     int     i_buffer;
     uint8_t *p_buffer;
 
+    /* stream chunk that p_buffer points into, instead of owning it */
+    httpd_chunk_t *p_chunk;
+    /* stream chunk that answer.p_body points into */
+    httpd_chunk_t *p_body_chunk;
+
+    /* file body, sent after the headers (and answer body, if any) */
+    int      i_file_fd;
+    uint64_t i_file_offset;
+    uint64_t i_file_end;
+
+#ifdef HTTPD_EPOLL
+    short    i_poll_events; /* events registered with epoll */
+#endif
+
     /*
      * If waiting for a keyframe, this is the position (in bytes) of the
      * last keyframe the stream saw before this client connected.
@@ -296,9 +341,36 @@ struct httpd_file_t
     httpd_url_t *url;
     httpd_file_callback_t pf_fill;
     httpd_file_sys_t      *p_sys;
+    char *psz_path; /* served from the file system if not NULL */
     char mime[1];
 };
 
+static int httpd_FileOpenBody(httpd_file_t *file, httpd_client_t *cl,
+                              httpd_message_t *answer, bool b_head)
+{
+    int fd = vlc_open(file->psz_path, O_RDONLY);
+    struct stat st;
+
+    if (fd == -1)
+        return VLC_EGENERIC;
+
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+        vlc_close(fd);
+        return VLC_EGENERIC;
+    }
+
+    httpd_MsgAdd(answer, "Content-Length", "%"PRIu64, (uint64_t)st.st_size);
+    if (b_head) {
+        vlc_close(fd);
+        return VLC_SUCCESS;
+    }
+
+    cl->i_file_fd = fd;
+    cl->i_file_offset = 0;
+    cl->i_file_end = st.st_size;
+    return VLC_SUCCESS;
+}
+
 static int
 httpd_FileCallBack(httpd_callback_sys_t *p_sys, httpd_client_t *cl,
                     httpd_message_t *answer, const httpd_message_t *query)
@@ -319,6 +391,22 @@ httpd_FileCallBack(httpd_callback_sys_t *p_sys, httpd_client_t *cl,
     httpd_MsgAdd(answer, "Content-type",  "%s", file->mime);
     httpd_MsgAdd(answer, "Cache-Control", "%s", "no-cache");
 
+    if (file->psz_path != NULL) {
+        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+            httpd_MsgAdd(answer, "Connection", "close");
+
+        if (httpd_FileOpenBody(file, cl, answer,
+                               query->i_type == HTTPD_MSG_HEAD)) {
+            char *p;
+
+            answer->i_status = 404;
+            answer->i_body = httpd_HtmlError(&p, 404, query->psz_url);
+            answer->p_body = (uint8_t *)p;
+            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+        }
+        return VLC_SUCCESS;
+    }
+
     if (query->i_type != HTTPD_MSG_HEAD) {
         pp_body = &answer->p_body;
         pi_body = &answer->i_body;
@@ -372,6 +460,7 @@ httpd_file_t *httpd_FileNew(httpd_host_t *host,
 
     file->pf_fill = pf_fill;
     file->p_sys   = p_sys;
+    file->psz_path = NULL;
     memcpy(file->mime, mime, mimelen + 1);
 
     httpd_UrlCatch(file->url, HTTPD_MSG_HEAD, httpd_FileCallBack,
@@ -384,11 +473,34 @@ httpd_file_t *httpd_FileNew(httpd_host_t *host,
     return file;
 }
 
+httpd_file_t *httpd_FilePathNew(httpd_host_t *host, const char *psz_url,
+                                const char *psz_mime, const char *psz_user,
+                                const char *psz_password, const char *psz_path)
+{
+    char *path = strdup(psz_path);
+    if (unlikely(path == NULL))
+        return NULL;
+
+    if (psz_mime == NULL || psz_mime[0] == '\0')
+        psz_mime = vlc_mime_Ext2Mime(psz_path);
+
+    httpd_file_t *file = httpd_FileNew(host, psz_url, psz_mime, psz_user,
+                                       psz_password, NULL, NULL);
+    if (file == NULL) {
+        free(path);
+        return NULL;
+    }
+
+    file->psz_path = path;
+    return file;
+}
+
 httpd_file_sys_t *httpd_FileDelete(httpd_file_t *file)
 {
     httpd_file_sys_t *p_sys = file->p_sys;
 
     httpd_UrlDelete(file->url);
+    free(file->psz_path);
     free(file);
     return p_sys;
 }
@@ -607,12 +719,17 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* ring of shared chunks, oldest first; clients only hold an offset */
+    struct vlc_list chunks;
+    size_t      i_buffer_size;      /* maximum bytes kept in the ring */
+    size_t      i_buffer;           /* bytes currently kept in the ring */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
+    /* keyframe-aligned ring: keep that many GOPs (0 to disable) */
+    unsigned    i_gop_max;
+    unsigned    i_gops;             /* keyframe chunks in the ring */
+
     /* custom headers */
     size_t        i_http_headers;
     httpd_header * p_http_headers;
@@ -628,47 +745,66 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
+        httpd_chunk_t *chunk;
 
+        vlc_mutex_lock(&stream->lock);
         if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
+            goto wait;  /* wait, no data available */
 
         if (cl->i_keyframe_wait_to_pass >= 0) {
             if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
                 /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
+                goto wait;
 
             /* seek to the new keyframe */
             answer->i_body_offset = stream->i_last_keyframe_seen_pos;
             cl->i_keyframe_wait_to_pass = -1;
         }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
+        chunk = vlc_list_first_entry_or_null(&stream->chunks, httpd_chunk_t,
+                                             node);
+        if (chunk == NULL)
+            goto wait;
+        if (answer->i_body_offset < chunk->i_pos) {
+            /* this client isn't fast enough */
+            if (stream->i_gops > 0)
+                /* skip whole GOPs */
+                answer->i_body_offset = stream->i_last_keyframe_seen_pos;
+            else
+                answer->i_body_offset = stream->i_buffer_last_pos;
+        }
 
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
+        /* Clients are normally close to the live edge: search backward */
+        chunk = vlc_list_last_entry_or_null(&stream->chunks, httpd_chunk_t,
+                                            node);
+        while (chunk->i_pos > answer->i_body_offset)
+            chunk = vlc_list_prev_entry_or_null(&stream->chunks, chunk,
+                                                httpd_chunk_t, node);
 
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
+        size_t i_skip = answer->i_body_offset - chunk->i_pos;
+        if (i_skip >= chunk->p_block->i_buffer)
+            goto wait;
 
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
+        atomic_fetch_add_explicit(&chunk->refs, 1, memory_order_relaxed);
+        vlc_mutex_unlock(&stream->lock);
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
         answer->i_type   = HTTPD_MSG_ANSWER;
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
+        /* The body points into the shared chunk, no copy */
+        assert(cl->p_body_chunk == NULL);
+        cl->p_body_chunk = chunk;
+        answer->i_body = chunk->p_block->i_buffer - i_skip;
+        answer->p_body = chunk->p_block->p_buffer + i_skip;
 
-        answer->i_body_offset += i_write;
+        answer->i_body_offset += answer->i_body;
 
         return VLC_SUCCESS;
+wait:
+        vlc_mutex_unlock(&stream->lock);
+        return VLC_EGENERIC;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -702,7 +838,11 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                 memcpy(answer->p_body, stream->p_header, stream->i_header);
             }
             answer->i_body_offset = stream->i_buffer_last_pos;
-            if (stream->b_has_keyframes)
+            if (stream->i_gops > 0) {
+                /* start right away from the last cached keyframe */
+                answer->i_body_offset = stream->i_last_keyframe_seen_pos;
+                cl->i_keyframe_wait_to_pass = -1;
+            } else if (stream->b_has_keyframes)
                 cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
             else
                 cl->i_keyframe_wait_to_pass = -1;
@@ -752,7 +892,7 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
         return NULL;
 
     stream->psz_mime = NULL;
-    stream->p_buffer = NULL;
+    vlc_list_init(&stream->chunks);
 
     stream->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
     if (!stream->url)
@@ -769,10 +909,9 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_header = 0;
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-
-    stream->p_buffer = malloc(stream->i_buffer_size);
-    if (stream->p_buffer == NULL)
-        goto error;
+    stream->i_buffer = 0;
+    stream->i_gop_max = 0;
+    stream->i_gops = 0;
 
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
@@ -819,22 +958,85 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
+static void httpd_ChunkRelease(httpd_chunk_t *chunk)
+{
+    if (atomic_fetch_sub_explicit(&chunk->refs, 1, memory_order_acq_rel) == 1)
+    {
+        block_Release(chunk->p_block);
+        free(chunk);
+    }
+}
+
+static void httpd_StreamDropChunk(httpd_stream_t *stream,
+                                  httpd_chunk_t *chunk)
+{
+    if (chunk->b_keyframe && stream->i_gops > 0)
+        stream->i_gops--;
+    stream->i_buffer -= chunk->p_block->i_buffer;
+    vlc_list_remove(&chunk->node);
+    httpd_ChunkRelease(chunk);
+}
+
+/* Drops the oldest GOP, and any data before the first keyframe */
+static void httpd_StreamDropGOP(httpd_stream_t *stream)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
+    httpd_chunk_t *chunk = vlc_list_first_entry_or_null(&stream->chunks,
+                                                        httpd_chunk_t, node);
+    bool b_first = true;
+
+    while (chunk != NULL && (b_first || !chunk->b_keyframe)) {
+        if (chunk->b_keyframe)
+            b_first = false;
+        httpd_StreamDropChunk(stream, chunk);
+        chunk = vlc_list_first_entry_or_null(&stream->chunks,
+                                             httpd_chunk_t, node);
+    }
+}
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
+static void httpd_AppendData(httpd_stream_t *stream, const block_t *p_block)
+{
+    httpd_chunk_t *chunk = malloc(sizeof (*chunk));
+    if (unlikely(chunk == NULL))
+        return;
 
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+    chunk->p_block = block_Alloc(p_block->i_buffer);
+    if (unlikely(chunk->p_block == NULL)) {
+        free(chunk);
+        return;
+    }
+    memcpy(chunk->p_block->p_buffer, p_block->p_buffer, p_block->i_buffer);
+    atomic_init(&chunk->refs, 1);
+    chunk->i_pos = stream->i_buffer_pos;
+    chunk->b_keyframe = (p_block->i_flags & BLOCK_FLAG_TYPE_I) != 0;
+    vlc_list_append(&chunk->node, &stream->chunks);
+
+    stream->i_buffer_pos += p_block->i_buffer;
+    stream->i_buffer += p_block->i_buffer;
+    if (chunk->b_keyframe && stream->i_gop_max > 0)
+        stream->i_gops++;
+
+    if (stream->i_gops > 0) {
+        /* Drop whole GOPs: keep at most i_gop_max of them, and no more than
+         * the byte budget unless only the current GOP is left. */
+        while (stream->i_gops > stream->i_gop_max
+            || (stream->i_gops > 1
+             && stream->i_buffer > stream->i_buffer_size))
+            httpd_StreamDropGOP(stream);
+
+        /* Safety net if the stream stopped signaling keyframes */
+        if (stream->i_buffer <= 4 * stream->i_buffer_size)
+            return;
     }
 
-    stream->i_buffer_pos += i_data;
+    /* Drop the oldest data, clients still sending them keep a reference */
+    while (stream->i_buffer > stream->i_buffer_size) {
+        httpd_chunk_t *old = vlc_list_first_entry_or_null(&stream->chunks,
+                                                          httpd_chunk_t, node);
+        if (old == chunk)
+            break;
+
+        httpd_StreamDropChunk(stream, old);
+    }
 }
 
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
@@ -852,12 +1054,27 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
         stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+    httpd_AppendData(stream, p_block);
 
     vlc_mutex_unlock(&stream->lock);
     return VLC_SUCCESS;
 }
 
+int httpd_StreamSetGOPCount(httpd_stream_t *stream, unsigned count)
+{
+    httpd_chunk_t *chunk;
+
+    vlc_mutex_lock(&stream->lock);
+    stream->i_gop_max = count;
+    stream->i_gops = 0;
+    if (count > 0)
+        vlc_list_foreach(chunk, &stream->chunks, node)
+            if (chunk->b_keyframe)
+                stream->i_gops++;
+    vlc_mutex_unlock(&stream->lock);
+    return VLC_SUCCESS;
+}
+
 void httpd_StreamDelete(httpd_stream_t *stream)
 {
     httpd_UrlDelete(stream->url);
@@ -869,7 +1086,10 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     vlc_mutex_destroy(&stream->lock);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+
+    httpd_chunk_t *chunk;
+    vlc_list_foreach(chunk, &stream->chunks, node)
+        httpd_ChunkRelease(chunk);
     free(stream);
 }
 
@@ -974,6 +1194,29 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     vlc_list_init(&host->clients);
     host->p_tls    = p_tls;
 
+#ifdef HTTPD_EPOLL
+    host->b_clients_removed = false;
+    host->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (host->epfd == -1) {
+        msg_Err(p_this, "cannot create epoll instance: %s",
+                vlc_strerror_c(errno));
+        goto error;
+    }
+
+    for (unsigned i = 0; i < host->nfd; i++) {
+        struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data = { .ptr = &host->fds[i] },
+        };
+
+        if (epoll_ctl(host->epfd, EPOLL_CTL_ADD, host->fds[i], &ev)) {
+            msg_Err(p_this, "cannot poll socket: %s", vlc_strerror_c(errno));
+            vlc_close(host->epfd);
+            goto error;
+        }
+    }
+#endif
+
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host,
                    VLC_THREAD_PRIORITY_LOW)) {
@@ -1028,6 +1271,9 @@ void httpd_HostDelete(httpd_host_t *host)
 
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
+#ifdef HTTPD_EPOLL
+    vlc_close(host->epfd);
+#endif
     net_ListenClose(host->fds);
     vlc_cond_destroy(&host->wait);
     vlc_mutex_destroy(&host->lock);
@@ -1130,6 +1376,10 @@ void httpd_UrlDelete(httpd_url_t *url)
         msg_Warn(host, "force closing connections");
         host->client_count--;
         httpd_ClientDestroy(client);
+#ifdef HTTPD_EPOLL
+        /* pending readiness events may refer to this client */
+        host->b_clients_removed = true;
+#endif
     }
     free(url);
     vlc_mutex_unlock(&host->lock);
@@ -1214,11 +1464,46 @@ static void httpd_ClientInit(httpd_client_t *cl, vlc_tick_t now)
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->p_chunk = NULL;
+    cl->p_body_chunk = NULL;
+    cl->i_file_fd = -1;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
 }
 
+static void httpd_ClientFreeBuffer(httpd_client_t *cl)
+{
+    if (cl->p_chunk != NULL) {
+        httpd_ChunkRelease(cl->p_chunk);
+        cl->p_chunk = NULL;
+    } else
+        free(cl->p_buffer);
+    cl->p_buffer = NULL;
+}
+
+/* Moves the answer body to the send buffer */
+static void httpd_ClientTakeBody(httpd_client_t *cl)
+{
+    httpd_ClientFreeBuffer(cl);
+    cl->p_buffer = cl->answer.p_body;
+    cl->p_chunk = cl->p_body_chunk;
+    cl->i_buffer_size = cl->answer.i_body;
+    cl->i_buffer = 0;
+
+    cl->answer.i_body = 0;
+    cl->answer.p_body = NULL;
+    cl->p_body_chunk = NULL;
+}
+
+static void httpd_ClientCloseFile(httpd_client_t *cl)
+{
+    if (cl->i_file_fd != -1) {
+        vlc_close(cl->i_file_fd);
+        cl->i_file_fd = -1;
+    }
+}
+
 char* httpd_ClientIP(const httpd_client_t *cl, char *ip, int *port)
 {
     return net_GetPeerAddress(vlc_tls_GetFD(cl->sock), ip, port) ? NULL : ip;
@@ -1233,10 +1518,15 @@ static void httpd_ClientDestroy(httpd_client_t *cl)
 {
     vlc_list_remove(&cl->node);
     vlc_tls_Close(cl->sock);
+    if (cl->p_body_chunk != NULL) {
+        cl->answer.p_body = NULL;
+        httpd_ChunkRelease(cl->p_body_chunk);
+    }
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
 
-    free(cl->p_buffer);
+    httpd_ClientCloseFile(cl);
+    httpd_ClientFreeBuffer(cl);
     free(cl);
 }
 
@@ -1576,6 +1866,59 @@ static void httpd_ClientRecv(httpd_client_t *cl)
         cl->i_activity_timeout = 0;
 }
 
+static void httpd_ClientSendFile(httpd_client_t *cl)
+{
+    uint64_t i_left = cl->i_file_end - cl->i_file_offset;
+    ssize_t i_len;
+
+    if (i_left == 0) {
+        httpd_ClientCloseFile(cl);
+        cl->i_state = HTTPD_CLIENT_SEND_DONE;
+        return;
+    }
+
+#ifdef __linux__
+    /* Plain socket, or TLS records encrypted by the kernel */
+    int fd = vlc_tls_GetSendFD(cl->sock);
+
+    if (fd != -1) {
+        /* Zero-copy from the page cache to the socket */
+        off_t offset = cl->i_file_offset;
+
+        i_len = sendfile(fd, cl->i_file_fd, &offset,
+                         __MIN(i_left, HTTPD_SENDFILE_SIZE));
+        if (i_len > 0)
+            cl->i_file_offset += i_len;
+        else if (i_len == 0 || errno != EAGAIN) {
+            httpd_ClientCloseFile(cl);
+            cl->i_state = HTTPD_CLIENT_DEAD;
+        }
+        return;
+    }
+#endif
+
+    /* Fallback (e.g. userspace TLS): read the next piece and send it from
+     * memory */
+    size_t i_size = __MIN(i_left, HTTPD_CL_BUFSIZE);
+
+    if (cl->p_chunk != NULL || cl->p_buffer == NULL
+     || (size_t)cl->i_buffer_size < i_size) {
+        httpd_ClientFreeBuffer(cl);
+        cl->p_buffer = xmalloc(i_size);
+    }
+
+    i_len = pread(cl->i_file_fd, cl->p_buffer, i_size, cl->i_file_offset);
+    if (i_len <= 0) {
+        httpd_ClientCloseFile(cl);
+        cl->i_state = HTTPD_CLIENT_DEAD;
+        return;
+    }
+
+    cl->i_file_offset += i_len;
+    cl->i_buffer = 0;
+    cl->i_buffer_size = i_len;
+}
+
 static void httpd_ClientSend(httpd_client_t *cl)
 {
     int i_len;
@@ -1591,9 +1934,9 @@ static void httpd_ClientSend(httpd_client_t *cl)
             i_size += strlen(cl->answer.p_headers[i].name) + 2 +
                       strlen(cl->answer.p_headers[i].value) + 2;
 
-        if (cl->i_buffer_size < i_size) {
+        if (cl->i_buffer_size < i_size || cl->p_chunk != NULL) {
             cl->i_buffer_size = i_size;
-            free(cl->p_buffer);
+            httpd_ClientFreeBuffer(cl);
             cl->p_buffer = xmalloc(i_size);
         }
         p = (char *)cl->p_buffer;
@@ -1631,13 +1974,10 @@ static void httpd_ClientSend(httpd_client_t *cl)
 
             if (cl->answer.i_body > 0) {
                 /* send the body data */
-                free(cl->p_buffer);
-                cl->p_buffer = cl->answer.p_body;
-                cl->i_buffer_size = cl->answer.i_body;
-                cl->i_buffer = 0;
-
-                cl->answer.i_body = 0;
-                cl->answer.p_body = NULL;
+                httpd_ClientTakeBody(cl);
+            } else if (cl->i_file_fd != -1) {
+                /* send the file data */
+                httpd_ClientSendFile(cl);
             } else /* send finished */
                 cl->i_state = HTTPD_CLIENT_SEND_DONE;
         }
@@ -1705,8 +2045,85 @@ auth_failed:
     return false;
 }
 
+static void httpd_ClientHandleEvent(httpd_host_t *host, httpd_client_t *cl,
+                                    vlc_tick_t now)
+{
+    cl->i_activity_date = now;
+
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
+        case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
+        case HTTPD_CLIENT_TLS_HS_IN:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            httpd_ClientTlsHandshake(host, cl);
+            break;
+    }
+}
+
+/* accept a new connection */
+static void httpd_HostAccept(httpd_host_t *host, int fd, vlc_tick_t now)
+{
+    httpd_client_t *cl;
+
+    fd = vlc_accept (fd, NULL, NULL, true);
+    if (fd == -1)
+        return;
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
+            &(int){ 1 }, sizeof(int));
+
+    vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
+    if (unlikely(sk == NULL))
+    {
+        vlc_close(fd);
+        return;
+    }
+
+    if (host->p_tls != NULL)
+    {
+        const char *alpn[] = { "http/1.1", NULL };
+        vlc_tls_t *tls;
+
+        tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
+        if (tls == NULL)
+        {
+            vlc_tls_SessionDelete(sk);
+            return;
+        }
+        sk = tls;
+    }
+
+    cl = httpd_ClientNew(sk, now);
+    if (unlikely(cl == NULL))
+    {
+        vlc_tls_Close(sk);
+        return;
+    }
+
+    if (host->p_tls != NULL)
+        cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+
+#ifdef HTTPD_EPOLL
+    struct epoll_event ev = { .events = 0, .data = { .ptr = cl } };
+
+    if (epoll_ctl(host->epfd, EPOLL_CTL_ADD, fd, &ev))
+    {
+        msg_Err(host, "cannot poll socket: %s", vlc_strerror_c(errno));
+        vlc_list_init(&cl->node);
+        httpd_ClientDestroy(cl);
+        return;
+    }
+    cl->i_poll_events = 0;
+#endif
+
+    host->client_count++;
+    vlc_list_append(&cl->node, &host->clients);
+}
+
 static void httpdLoop(httpd_host_t *host)
 {
+#ifdef HTTPD_EPOLL
+    struct epoll_event evs[HTTPD_EPOLL_EVENTS];
+#else
     struct pollfd ufd[host->nfd + host->client_count];
     unsigned nfd;
     for (nfd = 0; nfd < host->nfd; nfd++) {
@@ -1714,6 +2131,7 @@ static void httpdLoop(httpd_host_t *host)
         ufd[nfd].events = POLLIN;
         ufd[nfd].revents = 0;
     }
+#endif
 
     vlc_mutex_lock(&host->lock);
     /* add all socket that should be read/write and close dead connection */
@@ -1739,8 +2157,12 @@ static void httpdLoop(httpd_host_t *host)
             continue;
         }
 
+#ifdef HTTPD_EPOLL
+        struct pollfd pfd, *pufd = &pfd;
+#else
         struct pollfd *pufd = ufd + nfd;
         assert (pufd < ufd + (sizeof (ufd) / sizeof (ufd[0])));
+#endif
 
         pufd->events = pufd->revents = 0;
 
@@ -1922,7 +2344,8 @@ static void httpdLoop(httpd_host_t *host)
 
                         cl->i_buffer = 0;
                         cl->i_buffer_size = 1000;
-                        free(cl->p_buffer);
+                        httpd_ClientCloseFile(cl);
+                        httpd_ClientFreeBuffer(cl);
                         // Allocate an extra byte for the null terminating byte
                         cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
                         cl->i_state = HTTPD_CLIENT_RECEIVING;
@@ -1934,8 +2357,7 @@ static void httpdLoop(httpd_host_t *host)
                     httpd_MsgClean(&cl->answer);
 
                     cl->answer.i_body_offset = i_offset;
-                    free(cl->p_buffer);
-                    cl->p_buffer = NULL;
+                    httpd_ClientFreeBuffer(cl);
                     cl->i_buffer = 0;
                     cl->i_buffer_size = 0;
 
@@ -1954,25 +2376,85 @@ static void httpdLoop(httpd_host_t *host)
                         &cl->answer, &cl->query);
                 if (cl->answer.i_type != HTTPD_MSG_NONE) {
                     /* we have new data, so re-enter send mode */
-                    cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
+                    httpd_ClientTakeBody(cl);
                     cl->i_state = HTTPD_CLIENT_SENDING;
                 }
         }
 
         pufd->fd = vlc_tls_GetPollFD(cl->sock, &pufd->events);
 
+#ifdef HTTPD_EPOLL
+        /* Only tell the kernel about changes of interest */
+        if (pufd->events != cl->i_poll_events) {
+            struct epoll_event ev = {
+                .events = ((pufd->events & POLLIN) ? EPOLLIN : 0)
+                        | ((pufd->events & POLLOUT) ? EPOLLOUT : 0),
+                .data = { .ptr = cl },
+            };
+
+            if (epoll_ctl(host->epfd, EPOLL_CTL_MOD, pufd->fd, &ev) == 0)
+                cl->i_poll_events = pufd->events;
+            else
+                cl->i_state = HTTPD_CLIENT_DEAD;
+        }
+
+        if (pufd->events == 0)
+            b_low_delay = true;
+#else
         if (pufd->events != 0)
             nfd++;
         else
             b_low_delay = true;
+#endif
     }
+#ifdef HTTPD_EPOLL
+    host->b_clients_removed = false;
+#endif
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
 
+#ifdef HTTPD_EPOLL
+    int n;
+
+    /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
+    while ((n = epoll_wait(host->epfd, evs, ARRAY_SIZE(evs),
+                           b_low_delay ? 20 : -1)) < 0)
+    {
+        if (errno != EINTR)
+            msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+    }
+
+    canc = vlc_savecancel();
+    vlc_mutex_lock(&host->lock);
+
+    now = vlc_tick_now();
+
+    for (int i = 0; i < n; i++) {
+        void *ptr = evs[i].data.ptr;
+
+        if ((int *)ptr >= host->fds && (int *)ptr < host->fds + host->nfd) {
+            /* Handle server sockets (accept new connections) */
+            httpd_HostAccept(host, *(int *)ptr, now);
+            continue;
+        }
+
+        /* Level-triggered: skipped events will be reported again */
+        if (host->b_clients_removed)
+            continue;
+
+        cl = ptr;
+        if (evs[i].events & (EPOLLERR | EPOLLHUP)
+         && cl->i_poll_events == 0) {
+            /* hung up while not waiting for I/O */
+            cl->i_state = HTTPD_CLIENT_DEAD;
+            continue;
+        }
+        if (cl->i_state == HTTPD_CLIENT_DEAD)
+            continue;
+
+        httpd_ClientHandleEvent(host, cl, now);
+    }
+#else
     /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
     while (poll(ufd, nfd, b_low_delay ? 20 : -1) < 0)
     {
@@ -1998,16 +2480,7 @@ static void httpdLoop(httpd_host_t *host)
         if (pufd->revents == 0)
             continue; // no event received
 
-        cl->i_activity_date = now;
-
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
-            case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
-            case HTTPD_CLIENT_TLS_HS_IN:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                httpd_ClientTlsHandshake(host, cl);
-                break;
-        }
+        httpd_ClientHandleEvent(host, cl, now);
     }
 
     /* Handle server sockets (accept new connections) */
@@ -2019,42 +2492,9 @@ static void httpdLoop(httpd_host_t *host)
         if (ufd[nfd].revents == 0)
             continue;
 
-        /* */
-        fd = vlc_accept (fd, NULL, NULL, true);
-        if (fd == -1)
-            continue;
-        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
-                &(int){ 1 }, sizeof(int));
-
-        vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
-        if (unlikely(sk == NULL))
-        {
-            vlc_close(fd);
-            continue;
-        }
-
-        if (host->p_tls != NULL)
-        {
-            const char *alpn[] = { "http/1.1", NULL };
-            vlc_tls_t *tls;
-
-            tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
-            if (tls == NULL)
-            {
-                vlc_tls_SessionDelete(sk);
-                continue;
-            }
-            sk = tls;
-        }
-
-        cl = httpd_ClientNew(sk, now);
-
-        if (host->p_tls != NULL)
-            cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
-
-        host->client_count++;
-        vlc_list_append(&cl->node, &host->clients);
+        httpd_HostAccept(host, fd, now);
     }
+#endif
 
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
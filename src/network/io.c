@@ -50,6 +50,7 @@
 #include <vlc_common.h>
 #include <vlc_network.h>
 #include <vlc_interrupt.h>
+#include "libvlc.h"
 #if defined (_WIN32)
 #   undef EINPROGRESS
 #   define EINPROGRESS WSAEWOULDBLOCK
@@ -122,7 +123,7 @@ int (net_Connect)(vlc_object_t *obj, const char *host, int serv,
     }, *res;
     int ret = -1;
 
-    int val = vlc_getaddrinfo_i11e(host, serv, &hints, &res);
+    int val = vlc_getaddrinfo_cached(host, serv, &hints, &res);
     if (val)
     {
         msg_Err(obj, "cannot resolve %s port %d : %s", host, serv,
@@ -203,7 +204,7 @@ next_ai: /* failure */
         net_Close(fd);
     }
 
-    freeaddrinfo(res);
+    vlc_freeaddrinfo_cached(res);
     return ret;
 }
 
@@ -0,0 +1,326 @@
+/*****************************************************************************
+ * reactor.c: shared socket reactor
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#ifdef HAVE_POLL
+# include <poll.h>
+#endif
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_network.h>
+#include "libvlc.h"
+
+/*
+ * A single thread waits for all the registered sockets with poll(), plus a
+ * pipe to be woken up when the registrations change. The thread is started
+ * by the first registration, and exits once there are none left.
+ *
+ * Registrations are only freed by the reactor thread (or when it is not
+ * running), so that the thread can safely look up the results of the last
+ * poll() after re-acquiring the lock.
+ */
+
+struct vlc_reactor_fd
+{
+    int fd;
+    short events; /**< armed events, 0 if disarmed */
+    bool removed;
+    void (*cb)(void *, int, short);
+    void *opaque;
+    struct vlc_reactor_fd *next_dead;
+};
+
+#ifndef _WIN32
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t done; /**< a callback returned */
+    struct vlc_reactor_fd **fds;
+    size_t count;
+    size_t size;
+    struct vlc_reactor_fd *dead; /**< removed, to be freed */
+    const struct vlc_reactor_fd *running; /**< callback being invoked */
+    bool alive;
+    int wake[2];
+} reactor = {
+    VLC_STATIC_MUTEX, VLC_STATIC_COND, NULL, 0, 0, NULL, NULL, false,
+    { -1, -1 },
+};
+
+static thread_local bool reactor_thread = false;
+
+/* Must be called with the lock held */
+static void vlc_reactor_Wake(void)
+{
+    if (reactor.alive)
+    {
+        ssize_t val = write(reactor.wake[1], &(char){ 0 }, 1);
+        (void) val; /* the pipe may be full, the thread is woken anyway */
+    }
+}
+
+/* Must be called with the lock held */
+static void vlc_reactor_FreeDead(void)
+{
+    for (struct vlc_reactor_fd *rfd = reactor.dead, *next; rfd != NULL;
+         rfd = next)
+    {
+        next = rfd->next_dead;
+        free(rfd);
+    }
+    reactor.dead = NULL;
+}
+
+static void *vlc_reactor_Thread(void *data)
+{
+    struct pollfd *ufd = NULL;
+    struct vlc_reactor_fd **map = NULL;
+    size_t size = 0;
+
+    (void) data;
+    reactor_thread = true;
+    vlc_mutex_lock(&reactor.lock);
+
+    while (reactor.count > 0)
+    {
+        /* The previous poll() results are not used anymore */
+        vlc_reactor_FreeDead();
+
+        if (size < reactor.count + 1)
+        {
+            size_t n = reactor.size + 1;
+            struct pollfd *nufd = realloc(ufd, n * sizeof (*ufd));
+            if (nufd != NULL)
+                ufd = nufd;
+            struct vlc_reactor_fd **nmap = realloc(map, n * sizeof (*map));
+            if (nmap != NULL)
+                map = nmap;
+            if (likely(nufd != NULL && nmap != NULL))
+                size = n;
+            /* otherwise, poll as many sockets as possible */
+            if (unlikely(size == 0))
+            {   /* not even the wake pipe: retry later rather than spin */
+                vlc_cond_timedwait(&reactor.done, &reactor.lock,
+                                   vlc_tick_now() + VLC_TICK_FROM_MS(100));
+                continue;
+            }
+        }
+
+        unsigned nfds = 1;
+
+        ufd[0].fd = reactor.wake[0];
+        ufd[0].events = POLLIN;
+        for (size_t i = 0; i < reactor.count && nfds < size; i++)
+        {
+            struct vlc_reactor_fd *rfd = reactor.fds[i];
+
+            if (rfd->events == 0)
+                continue;
+
+            ufd[nfds].fd = rfd->fd;
+            ufd[nfds].events = rfd->events;
+            map[nfds] = rfd;
+            nfds++;
+        }
+        vlc_mutex_unlock(&reactor.lock);
+
+        while (poll(ufd, nfds, -1) < 0)
+            assert(errno == EINTR || errno == ENOMEM);
+
+        if (ufd[0].revents)
+        {
+            char buf[64];
+
+            while (read(reactor.wake[0], buf, sizeof (buf)) > 0);
+        }
+
+        vlc_mutex_lock(&reactor.lock);
+        for (unsigned i = 1; i < nfds; i++)
+        {
+            struct vlc_reactor_fd *rfd = map[i];
+
+            if (ufd[i].revents == 0 || rfd->removed || rfd->events == 0)
+                continue;
+
+            rfd->events = 0; /* one-shot */
+            reactor.running = rfd;
+            vlc_mutex_unlock(&reactor.lock);
+
+            rfd->cb(rfd->opaque, rfd->fd, ufd[i].revents);
+
+            vlc_mutex_lock(&reactor.lock);
+            reactor.running = NULL;
+            vlc_cond_broadcast(&reactor.done);
+        }
+    }
+
+    /* No more sockets: stop (a new registration starts a new thread) */
+    vlc_reactor_FreeDead();
+    free(reactor.fds);
+    reactor.fds = NULL;
+    reactor.size = 0;
+    vlc_close(reactor.wake[1]);
+    vlc_close(reactor.wake[0]);
+    reactor.alive = false;
+    vlc_mutex_unlock(&reactor.lock);
+
+    free(map);
+    free(ufd);
+    return NULL;
+}
+
+/* Must be called with the lock held */
+static int vlc_reactor_Start(void)
+{
+    if (reactor.alive)
+        return 0;
+
+    if (vlc_pipe(reactor.wake))
+        return -1;
+
+    fcntl(reactor.wake[0], F_SETFL,
+          fcntl(reactor.wake[0], F_GETFL) | O_NONBLOCK);
+    fcntl(reactor.wake[1], F_SETFL,
+          fcntl(reactor.wake[1], F_GETFL) | O_NONBLOCK);
+
+    if (vlc_clone_detach(NULL, vlc_reactor_Thread, NULL,
+                         VLC_THREAD_PRIORITY_INPUT))
+    {
+        vlc_close(reactor.wake[1]);
+        vlc_close(reactor.wake[0]);
+        return -1;
+    }
+    reactor.alive = true;
+    return 0;
+}
+
+vlc_reactor_fd_t *vlc_reactor_Add(int fd, short events,
+                                  void (*cb)(void *, int, short),
+                                  void *opaque)
+{
+    struct vlc_reactor_fd *rfd = malloc(sizeof (*rfd));
+    if (unlikely(rfd == NULL))
+        return NULL;
+
+    rfd->fd = fd;
+    rfd->events = events;
+    rfd->removed = false;
+    rfd->cb = cb;
+    rfd->opaque = opaque;
+
+    vlc_mutex_lock(&reactor.lock);
+    if (reactor.count == reactor.size)
+    {
+        size_t size = reactor.size ? 2 * reactor.size : 16;
+        struct vlc_reactor_fd **fds = realloc(reactor.fds,
+                                              size * sizeof (*fds));
+        if (unlikely(fds == NULL))
+            goto error;
+        reactor.fds = fds;
+        reactor.size = size;
+    }
+
+    if (vlc_reactor_Start())
+        goto error;
+
+    reactor.fds[reactor.count++] = rfd;
+    vlc_reactor_Wake();
+    vlc_mutex_unlock(&reactor.lock);
+    return rfd;
+
+error:
+    vlc_mutex_unlock(&reactor.lock);
+    free(rfd);
+    return NULL;
+}
+
+void vlc_reactor_Arm(vlc_reactor_fd_t *rfd, short events)
+{
+    vlc_mutex_lock(&reactor.lock);
+    assert(!rfd->removed);
+    if (rfd->events != events)
+    {
+        rfd->events = events;
+        /* the callback re-arming its own socket is polled anyway */
+        if (reactor.running != rfd)
+            vlc_reactor_Wake();
+    }
+    vlc_mutex_unlock(&reactor.lock);
+}
+
+void vlc_reactor_Remove(vlc_reactor_fd_t *rfd)
+{
+    vlc_mutex_lock(&reactor.lock);
+    rfd->removed = true;
+    rfd->events = 0;
+
+    for (size_t i = 0; i < reactor.count; i++)
+        if (reactor.fds[i] == rfd)
+        {
+            reactor.fds[i] = reactor.fds[--reactor.count];
+            break;
+        }
+
+    /* Wait for the ongoing callback, unless this is the callback */
+    if (!reactor_thread)
+        while (reactor.running == rfd)
+            vlc_cond_wait(&reactor.done, &reactor.lock);
+
+    /* Let the reactor thread free it, if it may use it after poll() */
+    rfd->next_dead = reactor.dead;
+    reactor.dead = rfd;
+    vlc_reactor_Wake();
+    vlc_mutex_unlock(&reactor.lock);
+}
+
+#else /* _WIN32 */
+/* Windows cannot poll() a pipe to wake the reactor: not supported yet */
+vlc_reactor_fd_t *vlc_reactor_Add(int fd, short events,
+                                  void (*cb)(void *, int, short),
+                                  void *opaque)
+{
+    (void) fd; (void) events; (void) cb; (void) opaque;
+    errno = ENOSYS;
+    return NULL;
+}
+
+void vlc_reactor_Arm(vlc_reactor_fd_t *rfd, short events)
+{
+    (void) rfd; (void) events;
+    vlc_assert_unreachable();
+}
+
+void vlc_reactor_Remove(vlc_reactor_fd_t *rfd)
+{
+    (void) rfd;
+    vlc_assert_unreachable();
+}
+#endif
@@ -49,6 +49,7 @@
 #include <vlc_common.h>
 #include <vlc_tls.h>
 #include <vlc_interrupt.h>
+#include "libvlc.h"
 
 ssize_t vlc_tls_Read(vlc_tls_t *session, void *buf, size_t len, bool waitall)
 {
@@ -218,6 +219,13 @@ static void vlc_tls_SocketClose(vlc_tls_t *tls)
     free(tls);
 }
 
+static int vlc_tls_SocketGetSendFD(vlc_tls_t *tls)
+{
+    vlc_tls_socket_t *sock = (struct vlc_tls_socket *)tls;
+
+    return sock->fd;
+}
+
 static const struct vlc_tls_operations vlc_tls_socket_ops =
 {
     vlc_tls_SocketGetFD,
@@ -225,6 +233,7 @@ static const struct vlc_tls_operations vlc_tls_socket_ops =
     vlc_tls_SocketWrite,
     vlc_tls_SocketShutdown,
     vlc_tls_SocketClose,
+    vlc_tls_SocketGetSendFD,
 };
 
 static vlc_tls_t *vlc_tls_SocketAlloc(int fd,
@@ -401,6 +410,7 @@ static const struct vlc_tls_operations vlc_tls_socket_fastopen_ops =
     vlc_tls_ConnectWrite,
     vlc_tls_SocketShutdown,
     vlc_tls_SocketClose,
+    NULL, /* not connected yet */
 };
 
 vlc_tls_t *vlc_tls_SocketOpenAddrInfo(const struct addrinfo *restrict info,
@@ -426,6 +436,138 @@ vlc_tls_t *vlc_tls_SocketOpenAddrInfo(const struct addrinfo *restrict info,
     return sock;
 }
 
+/* RFC 8305 connection attempt delay */
+#define HE_ATTEMPT_DELAY VLC_TICK_FROM_MS(250)
+/* Maximum number of addresses tried per address family */
+#define HE_MAX_ADDRS 8
+
+/* Addresses are tried in the resolver order, alternating address families.
+ * A new attempt starts whenever the previous one fails or takes more than
+ * the connection attempt delay, without aborting the attempts in progress. */
+vlc_tls_t *vlc_tls_SocketOpenHappy(vlc_object_t *obj,
+                                   const struct addrinfo *res)
+{
+    const struct addrinfo *pref[HE_MAX_ADDRS], *other[HE_MAX_ADDRS];
+    const struct addrinfo *addrs[2 * HE_MAX_ADDRS];
+    unsigned npref = 0, nother = 0, count = 0;
+
+    for (const struct addrinfo *p = res; p != NULL; p = p->ai_next)
+    {
+        if (p->ai_family == res->ai_family)
+        {
+            if (npref < HE_MAX_ADDRS)
+                pref[npref++] = p;
+        }
+        else if (nother < HE_MAX_ADDRS)
+            other[nother++] = p;
+    }
+
+    for (unsigned i = 0; i < npref || i < nother; i++)
+    {
+        if (i < npref)
+            addrs[count++] = pref[i];
+        if (i < nother)
+            addrs[count++] = other[i];
+    }
+
+    vlc_tls_t *socks[2 * HE_MAX_ADDRS], *tls = NULL;
+    struct pollfd ufd[2 * HE_MAX_ADDRS];
+    unsigned next = 0, pending = 0;
+    vlc_tick_t deadline = VLC_TICK_INVALID;
+    int err = ENOENT;
+
+    while (tls == NULL)
+    {
+        vlc_tick_t now = vlc_tick_now();
+
+        if (next < count && (pending == 0 || now >= deadline))
+        {   /* Start the next attempt */
+            vlc_tls_t *sk = vlc_tls_SocketAddrInfo(addrs[next++]);
+            if (sk == NULL)
+            {
+                err = errno;
+                continue;
+            }
+
+            vlc_tls_socket_t *sock = (vlc_tls_socket_t *)sk;
+
+            if (connect(sock->fd, sock->peer, sock->peerlen) == 0)
+            {
+                tls = sk;
+                break;
+            }
+#ifndef _WIN32
+            if (errno != EINPROGRESS)
+#else
+            if (WSAGetLastError() != WSAEWOULDBLOCK)
+#endif
+            {
+                err = errno;
+                msg_Dbg(obj, "connection error: %s", vlc_strerror_c(err));
+                vlc_tls_SessionDelete(sk);
+                continue;
+            }
+
+            socks[pending] = sk;
+            ufd[pending].fd = sock->fd;
+            ufd[pending].events = POLLOUT;
+            pending++;
+            deadline = now + HE_ATTEMPT_DELAY;
+            continue;
+        }
+
+        if (pending == 0)
+            break; /* all attempts failed */
+
+        int timeout = -1;
+        if (next < count)
+            timeout = (deadline > now) ? MS_FROM_VLC_TICK(deadline - now) : 0;
+
+        if (vlc_poll_i11e(ufd, pending, timeout) < 0)
+        {
+            err = errno;
+            break;
+        }
+
+        for (unsigned i = 0; i < pending;)
+        {
+            if (ufd[i].revents == 0)
+            {
+                i++;
+                continue;
+            }
+
+            int val;
+            socklen_t len = sizeof (val);
+
+            if (getsockopt(ufd[i].fd, SOL_SOCKET, SO_ERROR, &val, &len))
+                val = errno;
+
+            if (val == 0)
+            {
+                tls = socks[i];
+                socks[i] = socks[--pending];
+                break;
+            }
+
+            err = val;
+            msg_Dbg(obj, "connection error: %s", vlc_strerror_c(err));
+            vlc_tls_SessionDelete(socks[i]);
+            pending--;
+            socks[i] = socks[pending];
+            ufd[i] = ufd[pending];
+            deadline = now; /* start the next attempt right away */
+        }
+    }
+
+    while (pending > 0)
+        vlc_tls_SessionDelete(socks[--pending]);
+
+    if (tls == NULL)
+        errno = err;
+    return tls;
+}
+
 vlc_tls_t *vlc_tls_SocketOpenTCP(vlc_object_t *obj, const char *name,
                                  unsigned port)
 {
@@ -438,7 +580,7 @@ vlc_tls_t *vlc_tls_SocketOpenTCP(vlc_object_t *obj, const char *name,
     assert(name != NULL);
     msg_Dbg(obj, "resolving %s ...", name);
 
-    int val = vlc_getaddrinfo_i11e(name, port, &hints, &res);
+    int val = vlc_getaddrinfo_cached(name, port, &hints, &res);
     if (val != 0)
     {   /* TODO: C locale for gai_strerror() */
         msg_Err(obj, "cannot resolve %s port %u: %s", name, port,
@@ -448,20 +590,10 @@ vlc_tls_t *vlc_tls_SocketOpenTCP(vlc_object_t *obj, const char *name,
 
     msg_Dbg(obj, "connecting to %s port %u ...", name, port);
 
-    /* TODO: implement RFC8305 */
-    for (const struct addrinfo *p = res; p != NULL; p = p->ai_next)
-    {
-        vlc_tls_t *tls = vlc_tls_SocketOpenAddrInfo(p, false);
-        if (tls == NULL)
-        {
-            msg_Err(obj, "connection error: %s", vlc_strerror_c(errno));
-            continue;
-        }
-
-        freeaddrinfo(res);
-        return tls;
-    }
+    vlc_tls_t *tls = vlc_tls_SocketOpenHappy(obj, res);
+    if (tls == NULL)
+        msg_Err(obj, "connection error: %s", vlc_strerror_c(errno));
 
-    freeaddrinfo(res);
-    return NULL;
+    vlc_freeaddrinfo_cached(res);
+    return tls;
 }
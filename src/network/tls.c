@@ -230,7 +230,7 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
 
     msg_Dbg(creds, "resolving %s ...", name);
 
-    int val = vlc_getaddrinfo_i11e(name, port, &hints, &res);
+    int val = vlc_getaddrinfo_cached(name, port, &hints, &res);
     if (val != 0)
     {   /* TODO: C locale for gai_strerror() */
         msg_Err(creds, "cannot resolve %s port %u: %s", name, port,
@@ -238,6 +238,28 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
         return NULL;
     }
 
+    if (res->ai_next != NULL)
+    {   /* Several addresses: race the TCP connections, without fast open */
+        vlc_tls_t *tcp = vlc_tls_SocketOpenHappy(VLC_OBJECT(creds), res);
+
+        vlc_freeaddrinfo_cached(res);
+
+        if (tcp == NULL)
+        {
+            msg_Err(creds, "connection error: %s", vlc_strerror_c(errno));
+            return NULL;
+        }
+
+        vlc_tls_t *tls = vlc_tls_ClientSessionCreate(creds, tcp, name, service,
+                                                     alpn, alp);
+        if (tls == NULL)
+        {
+            msg_Err(creds, "connection error: %s", vlc_strerror_c(errno));
+            vlc_tls_SessionDelete(tcp);
+        }
+        return tls;
+    }
+
     for (const struct addrinfo *p = res; p != NULL; p = p->ai_next)
     {
         vlc_tls_t *tcp = vlc_tls_SocketOpenAddrInfo(p, true);
@@ -251,7 +273,7 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
                                                      alpn, alp);
         if (tls != NULL)
         {   /* Success! */
-            freeaddrinfo(res);
+            vlc_freeaddrinfo_cached(res);
             return tls;
         }
 
@@ -260,6 +282,6 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
     }
 
     /* Failure! */
-    freeaddrinfo(res);
+    vlc_freeaddrinfo_cached(res);
     return NULL;
 }
@@ -92,6 +92,13 @@ vlc_player_input_UpdateTime(struct vlc_player_input *input)
 int
 vlc_player_input_Start(struct vlc_player_input *input)
 {
+    if (input->standby && input->started)
+    {
+        /* Already running, only its tracks need to be selected */
+        vlc_player_input_LeaveStandby(input);
+        return VLC_SUCCESS;
+    }
+
     int ret = input_Start(input->thread);
     if (ret != VLC_SUCCESS)
         return ret;
@@ -99,6 +106,53 @@ vlc_player_input_Start(struct vlc_player_input *input)
     return ret;
 }
 
+void
+vlc_player_input_LeaveStandby(struct vlc_player_input *input)
+{
+    vlc_player_t *player = input->player;
+
+    assert(input->standby);
+    input->standby = false;
+    input->preopened = false;
+    input_SetStandby(input->thread, false);
+
+    /* Send the events that were not sent while in standby */
+    vlc_player_SendEvent(player, on_capabilities_changed, 0,
+                         input->capabilities);
+    if (input->length != VLC_TICK_INVALID)
+        vlc_player_SendEvent(player, on_length_changed, input->length);
+    if (input->titles)
+        vlc_player_SendEvent(player, on_titles_changed, input->titles);
+
+    struct vlc_player_program *prgm;
+    vlc_vector_foreach(prgm, &input->program_vector)
+    {
+        vlc_player_SendEvent(player, on_program_list_changed,
+                             VLC_PLAYER_LIST_ADDED, prgm);
+        if (prgm->selected)
+            vlc_player_SendEvent(player, on_program_selection_changed,
+                                 -1, prgm->group_id);
+    }
+
+    static const enum es_format_category_e cats[] =
+        { VIDEO_ES, AUDIO_ES, SPU_ES };
+    for (size_t i = 0; i < ARRAY_SIZE(cats); ++i)
+    {
+        vlc_player_track_vector *vec =
+            vlc_player_input_GetTrackVector(input, cats[i]);
+        struct vlc_player_track_priv *trackpriv;
+        vlc_vector_foreach(trackpriv, vec)
+            vlc_player_SendEvent(player, on_track_list_changed,
+                                 VLC_PLAYER_LIST_ADDED, &trackpriv->t);
+    }
+    if (input->teletext_menu)
+        vlc_player_SendEvent(player, on_teletext_menu_changed, true);
+
+    if (input->state == VLC_PLAYER_STATE_STARTED
+     || input->state == VLC_PLAYER_STATE_PLAYING)
+        vlc_player_input_HandleState(input, input->state, VLC_TICK_INVALID);
+}
+
 static bool
 vlc_player_WaitRetryDelay(vlc_player_t *player)
 {
@@ -136,6 +190,29 @@ vlc_player_input_HandleState(struct vlc_player_input *input,
 
     input->state = state;
 
+    if (input->standby)
+    {
+        /* This is not the current input: the player state is unchanged */
+        switch (state)
+        {
+            case VLC_PLAYER_STATE_STOPPED:
+                if (input->titles)
+                {
+                    vlc_player_title_list_Release(input->titles);
+                    input->titles = NULL;
+                }
+                break;
+            case VLC_PLAYER_STATE_STOPPING:
+                input->started = false;
+                if (input == player->input)
+                    player->input = NULL;
+                break;
+            default:
+                break;
+        }
+        return;
+    }
+
     /* Override the global state if the player is still playing and has a next
      * media to play */
     bool send_event = player->global_state != state;
@@ -699,9 +776,15 @@ input_thread_Events(input_thread_t *input_thread,
 
     vlc_mutex_lock(&player->lock);
 
+    /* An input in standby is not the current one: keep track of its media,
+     * but do not notify the listeners until it becomes the current one */
+    player->events_muted = input->standby;
+
     switch (event->type)
     {
         case INPUT_EVENT_STATE:
+            if (input->standby && event->state.value == END_S)
+                vlc_player_RemoveStandbyInput(player, input);
             vlc_player_input_HandleStateEvent(input, event->state.value,
                                               event->state.date);
             break;
@@ -719,6 +802,13 @@ input_thread_Events(input_thread_t *input_thread,
         }
         case INPUT_EVENT_TIMES:
         {
+            if (input->standby)
+            {
+                /* Not played yet: no time nor timer to update */
+                input->length = event->times.length;
+                break;
+            }
+
             bool changed = false;
             vlc_tick_t system_date = VLC_TICK_INVALID;
 
@@ -743,6 +833,11 @@ input_thread_Events(input_thread_t *input_thread,
                 changed = true;
             }
 
+            if (player->preopen_delay > 0 && input == player->input
+             && input->length > 0 && input->time != VLC_TICK_INVALID
+             && input->length - input->time <= player->preopen_delay)
+                vlc_player_PreopenNextMedia(player);
+
             if (input->normal_time != event->times.normal_time)
             {
                 assert(event->times.normal_time != VLC_TICK_INVALID);
@@ -810,6 +905,8 @@ input_thread_Events(input_thread_t *input_thread,
                                  input_GetItem(input->thread), event->subitems);
             break;
         case INPUT_EVENT_DEAD:
+            if (input->standby)
+                vlc_player_RemoveStandbyInput(player, input);
             if (input->started) /* Can happen with early input_thread fails */
                 vlc_player_input_HandleState(input, VLC_PLAYER_STATE_STOPPING,
                                              VLC_TICK_INVALID);
@@ -829,6 +926,7 @@ input_thread_Events(input_thread_t *input_thread,
             break;
     }
 
+    player->events_muted = false;
     vlc_mutex_unlock(&player->lock);
 }
 
@@ -841,6 +939,8 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
 
     input->player = player;
     input->started = false;
+    input->standby = false;
+    input->preopened = false;
 
     input->state = VLC_PLAYER_STATE_STOPPED;
     input->error = VLC_PLAYER_ERROR_NONE;
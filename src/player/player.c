@@ -65,6 +65,30 @@ vlc_player_PrepareNextMedia(vlc_player_t *player)
     player->next_media_requested = true;
 }
 
+static struct vlc_player_input *
+vlc_player_FindStandbyInput(vlc_player_t *player, input_item_t *media)
+{
+    struct vlc_player_input *input;
+    vlc_list_foreach(input, &player->standby_inputs, node)
+    {
+        if (input_GetItem(input->thread) == media)
+            return input;
+    }
+    return NULL;
+}
+
+static struct vlc_player_input *
+vlc_player_TakeStandbyInput(vlc_player_t *player, input_item_t *media)
+{
+    struct vlc_player_input *input = vlc_player_FindStandbyInput(player, media);
+    if (input == NULL)
+        return NULL;
+
+    vlc_list_remove(&input->node);
+    msg_Dbg(player, "switching to the standby input");
+    return input;
+}
+
 int
 vlc_player_OpenNextMedia(vlc_player_t *player)
 {
@@ -90,8 +114,13 @@ vlc_player_OpenNextMedia(vlc_player_t *player)
         player->media = player->next_media;
         player->next_media = NULL;
 
-        struct vlc_player_input *input = player->input =
-            vlc_player_input_New(player, player->media);
+        /* Switch to the standby input of this media if any: it is started
+         * already, vlc_player_input_Start() only selects its tracks */
+        struct vlc_player_input *input =
+            vlc_player_TakeStandbyInput(player, player->media);
+        if (!input)
+            input = vlc_player_input_New(player, player->media);
+        player->input = input;
         if (!input)
         {
             input_item_Release(player->media);
@@ -130,6 +159,14 @@ vlc_list_HasInput(struct vlc_list *list, struct vlc_player_input *input)
     return false;
 }
 
+void
+vlc_player_RemoveStandbyInput(vlc_player_t *player,
+                              struct vlc_player_input *input)
+{
+    if (vlc_list_HasInput(&player->standby_inputs, input))
+        vlc_list_remove(&input->node);
+}
+
 static void
 vlc_player_destructor_AddInput(vlc_player_t *player,
                                struct vlc_player_input *input)
@@ -180,6 +217,78 @@ vlc_player_destructor_AddJoinableInput(vlc_player_t *player,
     vlc_player_destructor_AddInput(player, input);
 }
 
+static struct vlc_player_input *
+vlc_player_StartStandbyInput(vlc_player_t *player, input_item_t *media)
+{
+    struct vlc_player_input *input = vlc_player_input_New(player, media);
+    if (!input)
+        return NULL;
+    input->standby = true;
+    input->ml.restore_states = false;
+    input_SetStandby(input->thread, true);
+
+    if (vlc_player_input_Start(input) != VLC_SUCCESS)
+    {
+        vlc_player_destructor_AddInput(player, input);
+        return NULL;
+    }
+    vlc_list_append(&input->node, &player->standby_inputs);
+    return input;
+}
+
+void
+vlc_player_PreopenNextMedia(vlc_player_t *player)
+{
+    vlc_player_assert_locked(player);
+
+    vlc_player_PrepareNextMedia(player);
+    if (!player->next_media || player->next_media == player->media
+     || vlc_player_FindStandbyInput(player, player->next_media) != NULL)
+        return;
+
+    /* Open the access and demux of the next media while the current one is
+     * ending, so that switching to it does not leave a gap */
+    struct vlc_player_input *input =
+        vlc_player_StartStandbyInput(player, player->next_media);
+    if (input)
+    {
+        input->preopened = true;
+        msg_Dbg(player, "next media opened in standby");
+    }
+}
+
+void
+vlc_player_SetStandbyMedias(vlc_player_t *player, input_item_t *const *medias,
+                            size_t count)
+{
+    vlc_player_assert_locked(player);
+
+    /* Close the medias not requested anymore */
+    struct vlc_player_input *input;
+    vlc_list_foreach(input, &player->standby_inputs, node)
+    {
+        input_item_t *media = input_GetItem(input->thread);
+        bool keep = false;
+        for (size_t i = 0; i < count && !keep; ++i)
+            keep = medias[i] == media;
+
+        if (!keep && !input->preopened)
+        {
+            vlc_list_remove(&input->node);
+            vlc_player_destructor_AddInput(player, input);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (medias[i] == player->media
+         || vlc_player_FindStandbyInput(player, medias[i]) != NULL)
+            continue;
+
+        vlc_player_StartStandbyInput(player, medias[i]);
+    }
+}
+
 static bool vlc_player_destructor_IsEmpty(vlc_player_t *player)
 {
     return vlc_list_is_empty(&player->destructor.inputs)
@@ -187,6 +296,27 @@ static bool vlc_player_destructor_IsEmpty(vlc_player_t *player)
         && vlc_list_is_empty(&player->destructor.joinable_inputs);
 }
 
+/* Whether a played input is still being stopped; the inputs that were only
+ * opened in standby do not delay the next media */
+static bool vlc_player_destructor_IsStopping(vlc_player_t *player)
+{
+    struct vlc_list *lists[] = {
+        &player->destructor.inputs,
+        &player->destructor.stopping_inputs,
+        &player->destructor.joinable_inputs,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(lists); ++i)
+    {
+        struct vlc_player_input *input;
+        vlc_list_foreach(input, lists[i], node)
+        {
+            if (!input->standby)
+                return true;
+        }
+    }
+    return false;
+}
+
 static void *
 vlc_player_destructor_Thread(void *data)
 {
@@ -212,7 +342,8 @@ vlc_player_destructor_Thread(void *data)
                                          VLC_TICK_INVALID);
             vlc_player_destructor_AddStoppingInput(player, input);
 
-            vlc_player_UpdateMLStates(player, input);
+            if (!input->standby)
+                vlc_player_UpdateMLStates(player, input);
             input_Stop(input->thread);
         }
 
@@ -999,7 +1130,7 @@ vlc_player_SetCurrentMedia(vlc_player_t *player, input_item_t *media)
     }
 
     assert(media == player->next_media);
-    if (!vlc_player_destructor_IsEmpty(player))
+    if (vlc_player_destructor_IsStopping(player))
     {
         /* This media will be opened when the input is finally stopped */
         return VLC_SUCCESS;
@@ -1102,6 +1233,16 @@ vlc_player_InvalidateNextMedia(vlc_player_t *player)
     }
     player->next_media_requested = false;
 
+    /* The pre-opened next media is not the next one anymore */
+    struct vlc_player_input *input;
+    vlc_list_foreach(input, &player->standby_inputs, node)
+    {
+        if (input->preopened)
+        {
+            vlc_list_remove(&input->node);
+            vlc_player_destructor_AddInput(player, input);
+        }
+    }
 }
 
 int
@@ -1114,7 +1255,7 @@ vlc_player_Start(vlc_player_t *player)
     if (player->started)
         return VLC_SUCCESS;
 
-    if (!vlc_player_destructor_IsEmpty(player))
+    if (vlc_player_destructor_IsStopping(player))
     {
         if (player->next_media)
         {
@@ -1136,7 +1277,7 @@ vlc_player_Start(vlc_player_t *player)
         if (!player->input)
             return VLC_ENOMEM;
     }
-    assert(!player->input->started);
+    assert(!player->input->started || player->input->standby);
 
     if (player->start_paused)
     {
@@ -1857,6 +1998,7 @@ vlc_player_Delete(vlc_player_t *player)
 
     if (player->input)
         vlc_player_destructor_AddInput(player, player->input);
+    vlc_player_SetStandbyMedias(player, NULL, 0);
 
     player->deleting = true;
     vlc_cond_signal(&player->destructor.wait);
@@ -1924,6 +2066,11 @@ vlc_player_New(vlc_object_t *parent, enum vlc_player_lock_type lock_type,
     player->next_media_requested = false;
     player->next_media = NULL;
 
+    vlc_list_init(&player->standby_inputs);
+    player->events_muted = false;
+    player->preopen_delay =
+        vlc_tick_from_sec(var_InheritInteger(player, "gapless-preopen"));
+
 #define VAR_CREATE(var, flag) do { \
     if (var_Create(player, var, flag) != VLC_SUCCESS) \
         goto error; \
@@ -56,6 +56,10 @@ struct vlc_player_input
     input_thread_t *thread;
     vlc_player_t *player;
     bool started;
+    /* Opened ahead of time, cf. vlc_player_SetStandbyMedias() */
+    bool standby;
+    /* Opened in standby as the next media, cf. vlc_player_PreopenNextMedia() */
+    bool preopened;
 
     enum vlc_player_state state;
     enum vlc_player_error error;
@@ -237,6 +241,14 @@ struct vlc_player_t
     bool next_media_requested;
     input_item_t *next_media;
 
+    /* Inputs kept opened in standby, and whether the events being handled
+     * come from one of them */
+    struct vlc_list standby_inputs;
+    bool events_muted;
+    /* Remaining time of the current media below which the next one is opened
+     * in standby, or 0 */
+    vlc_tick_t preopen_delay;
+
     enum vlc_player_state global_state;
     bool started;
 
@@ -282,6 +294,8 @@ vlc_player_get_input_locked(vlc_player_t *player)
 
 #define vlc_player_SendEvent(player, event, ...) do { \
     vlc_player_listener_id *listener; \
+    if (player->events_muted) \
+        break; \
     vlc_list_foreach(listener, &player->listeners, node) \
     { \
         if (listener->cbs->event) \
@@ -314,6 +328,9 @@ vlc_player_OpenNextMedia(vlc_player_t *player);
 void
 vlc_player_PrepareNextMedia(vlc_player_t *player);
 
+void
+vlc_player_PreopenNextMedia(vlc_player_t *player);
+
 void
 vlc_player_destructor_AddStoppingInput(vlc_player_t *player,
                                        struct vlc_player_input *input);
@@ -322,6 +339,10 @@ void
 vlc_player_destructor_AddJoinableInput(vlc_player_t *player,
                                        struct vlc_player_input *input);
 
+void
+vlc_player_RemoveStandbyInput(vlc_player_t *player,
+                              struct vlc_player_input *input);
+
 /*
  * player_track.c
  */
@@ -402,6 +423,9 @@ vlc_player_input_GetPos(struct vlc_player_input *input);
 int
 vlc_player_input_Start(struct vlc_player_input *input);
 
+void
+vlc_player_input_LeaveStandby(struct vlc_player_input *input);
+
 void
 vlc_player_input_HandleState(struct vlc_player_input *, enum vlc_player_state,
                              vlc_tick_t state_date);
@@ -37,6 +37,7 @@ vlc_playlist_ClearItems(vlc_playlist_t *playlist)
     vlc_vector_foreach(item, &playlist->items)
         vlc_playlist_item_Release(item);
     vlc_vector_clear(&playlist->items);
+    vlc_playlist_index_Clear(&playlist->index);
 }
 
 static void
@@ -60,6 +61,11 @@ vlc_playlist_ItemsReset(vlc_playlist_t *playlist)
 static void
 vlc_playlist_ItemsInserted(vlc_playlist_t *playlist, size_t index, size_t count)
 {
+    /* the room has been reserved before inserting */
+    vlc_playlist_index_Add(&playlist->index, index,
+                           &playlist->items.data[index], count);
+    vlc_playlist_index_Invalidate(&playlist->index, index + count);
+
     if (playlist->order == VLC_PLAYLIST_PLAYBACK_ORDER_RANDOM)
         randomizer_Add(&playlist->randomizer,
                        &playlist->items.data[index], count);
@@ -87,6 +93,9 @@ static void
 vlc_playlist_ItemsMoved(vlc_playlist_t *playlist, size_t index, size_t count,
                         size_t target)
 {
+    /* the positions are recomputed lazily from the first moved item */
+    vlc_playlist_index_Invalidate(&playlist->index, __MIN(index, target));
+
     struct vlc_playlist_state state;
     vlc_playlist_state_Save(playlist, &state);
 
@@ -124,6 +133,10 @@ vlc_playlist_ItemsMoved(vlc_playlist_t *playlist, size_t index, size_t count,
 static void
 vlc_playlist_ItemsRemoving(vlc_playlist_t *playlist, size_t index, size_t count)
 {
+    vlc_playlist_index_Remove(&playlist->index, &playlist->items.data[index],
+                              count);
+    vlc_playlist_index_Invalidate(&playlist->index, index);
+
     if (playlist->order == VLC_PLAYLIST_PLAYBACK_ORDER_RANDOM)
         randomizer_Remove(&playlist->randomizer,
                           &playlist->items.data[index], count);
@@ -197,9 +210,8 @@ vlc_playlist_IndexOf(vlc_playlist_t *playlist, const vlc_playlist_item_t *item)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    ssize_t index;
-    vlc_vector_index_of(&playlist->items, item, &index);
-    return index;
+    return vlc_playlist_index_Find(&playlist->index, playlist->items.data,
+                                   playlist->items.size, item);
 }
 
 ssize_t
@@ -207,11 +219,8 @@ vlc_playlist_IndexOfMedia(vlc_playlist_t *playlist, const input_item_t *media)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->media == media)
-            return i;
-    return -1;
+    return vlc_playlist_index_FindMedia(&playlist->index, playlist->items.data,
+                                        playlist->items.size, media);
 }
 
 ssize_t
@@ -219,11 +228,8 @@ vlc_playlist_IndexOfId(vlc_playlist_t *playlist, uint64_t id)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->id == id)
-            return i;
-    return -1;
+    return vlc_playlist_index_FindId(&playlist->index, playlist->items.data,
+                                     playlist->items.size, id);
 }
 
 void
@@ -268,6 +274,9 @@ vlc_playlist_Insert(vlc_playlist_t *playlist, size_t index,
     vlc_playlist_AssertLocked(playlist);
     assert(index <= playlist->items.size);
 
+    if (!vlc_playlist_index_Reserve(&playlist->index, count))
+        return VLC_ENOMEM;
+
     /* make space in the vector */
     if (!vlc_vector_insert_hole(&playlist->items, index, count))
         return VLC_ENOMEM;
@@ -342,6 +351,9 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
         randomizer_Add(&playlist->randomizer, &item, 1);
     }
 
+    vlc_playlist_index_Remove(&playlist->index, &playlist->items.data[index], 1);
+    vlc_playlist_index_Add(&playlist->index, index, &item, 1);
+
     vlc_playlist_item_Release(playlist->items.data[index]);
     playlist->items.data[index] = item;
 
@@ -366,6 +378,9 @@ vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
 
         if (count > 1)
         {
+            if (!vlc_playlist_index_Reserve(&playlist->index, count - 1))
+                return VLC_ENOMEM;
+
             /* make space in the vector */
             if (!vlc_vector_insert_hole(&playlist->items, index + 1, count - 1))
                 return VLC_ENOMEM;
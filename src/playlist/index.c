@@ -0,0 +1,291 @@
+/*****************************************************************************
+ * playlist/index.c
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "index.h"
+#include "item.h"
+
+/**
+ * The tables use open addressing with linear probing. They are kept at most
+ * half full, and removal shifts the following entries backwards (instead of
+ * leaving tombstones), so that lookups always stop on the first empty slot.
+ *
+ * Each item stores its last known position (item->index). For all positions
+ * below index->valid, items[pos]->index == pos. A change in the middle of the
+ * playlist only lowers index->valid; the positions above are renumbered by
+ * the next lookup which needs them. Since a cached position is always checked
+ * against the items array, a stale one is never returned.
+ */
+
+#define INDEX_MIN_SIZE 16
+
+static inline size_t
+HashId(uint64_t id)
+{
+    /* Fibonacci hashing */
+    uint64_t h = id * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t) (h ^ (h >> 32));
+}
+
+static inline size_t
+HashMedia(const input_item_t *media)
+{
+    return HashId((uintptr_t) media);
+}
+
+static inline size_t
+SlotId(const struct vlc_playlist_index *index, const vlc_playlist_item_t *item)
+{
+    return HashId(item->id) & (index->size - 1);
+}
+
+static inline size_t
+SlotMedia(const struct vlc_playlist_index *index,
+          const vlc_playlist_item_t *item)
+{
+    return HashMedia(item->media) & (index->size - 1);
+}
+
+typedef size_t (*slot_fn)(const struct vlc_playlist_index *,
+                          const vlc_playlist_item_t *);
+
+static void
+TableAdd(const struct vlc_playlist_index *index, vlc_playlist_item_t **table,
+         slot_fn slot, vlc_playlist_item_t *item)
+{
+    size_t mask = index->size - 1;
+    size_t i = slot(index, item);
+    while (table[i])
+        i = (i + 1) & mask;
+    table[i] = item;
+}
+
+static void
+TableRemove(const struct vlc_playlist_index *index,
+            vlc_playlist_item_t **table, slot_fn slot,
+            const vlc_playlist_item_t *item)
+{
+    size_t mask = index->size - 1;
+    size_t i = slot(index, item);
+    while (table[i] != item)
+    {
+        assert(table[i]); /* the item must be in the table */
+        i = (i + 1) & mask;
+    }
+
+    /* shift back the entries which would not be reachable anymore */
+    for (size_t j = (i + 1) & mask; table[j]; j = (j + 1) & mask)
+    {
+        size_t k = slot(index, table[j]);
+        /* move table[j] to i unless its home slot k lies in (i, j] */
+        bool reachable = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+        if (!reachable)
+        {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i] = NULL;
+}
+
+void
+vlc_playlist_index_Init(struct vlc_playlist_index *index)
+{
+    index->by_id = NULL;
+    index->by_media = NULL;
+    index->size = 0;
+    index->count = 0;
+    index->valid = 0;
+}
+
+void
+vlc_playlist_index_Destroy(struct vlc_playlist_index *index)
+{
+    free(index->by_id);
+    free(index->by_media);
+}
+
+bool
+vlc_playlist_index_Reserve(struct vlc_playlist_index *index, size_t count)
+{
+    if (count > SIZE_MAX / 2 / sizeof(vlc_playlist_item_t *) - index->count)
+        return false;
+
+    size_t needed = 2 * (index->count + count);
+    if (needed <= index->size)
+        return true;
+
+    size_t size = index->size ? index->size : INDEX_MIN_SIZE;
+    while (size < needed)
+        size *= 2;
+
+    vlc_playlist_item_t **by_id = calloc(size, sizeof(*by_id));
+    vlc_playlist_item_t **by_media = calloc(size, sizeof(*by_media));
+    if (unlikely(!by_id || !by_media))
+    {
+        free(by_id);
+        free(by_media);
+        return false;
+    }
+
+    vlc_playlist_item_t **old = index->by_id;
+    size_t old_size = index->size;
+
+    free(index->by_media);
+    index->by_id = by_id;
+    index->by_media = by_media;
+    index->size = size;
+
+    for (size_t i = 0; i < old_size; ++i)
+    {
+        if (old[i])
+        {
+            TableAdd(index, by_id, SlotId, old[i]);
+            TableAdd(index, by_media, SlotMedia, old[i]);
+        }
+    }
+    free(old);
+
+    return true;
+}
+
+void
+vlc_playlist_index_Add(struct vlc_playlist_index *index, size_t pos,
+                       vlc_playlist_item_t *const items[], size_t count)
+{
+    assert(2 * (index->count + count) <= index->size);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vlc_playlist_item_t *item = items[i];
+        item->index = pos + i;
+        TableAdd(index, index->by_id, SlotId, item);
+        TableAdd(index, index->by_media, SlotMedia, item);
+    }
+    index->count += count;
+}
+
+void
+vlc_playlist_index_Remove(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *const items[], size_t count)
+{
+    assert(count <= index->count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        TableRemove(index, index->by_id, SlotId, items[i]);
+        TableRemove(index, index->by_media, SlotMedia, items[i]);
+    }
+    index->count -= count;
+}
+
+void
+vlc_playlist_index_Clear(struct vlc_playlist_index *index)
+{
+    /* keep the tables, the playlist is likely to be filled again */
+    for (size_t i = 0; i < index->size; ++i)
+    {
+        index->by_id[i] = NULL;
+        index->by_media[i] = NULL;
+    }
+    index->count = 0;
+    index->valid = 0;
+}
+
+static void
+Renumber(struct vlc_playlist_index *index, vlc_playlist_item_t *const items[],
+         size_t size)
+{
+    for (size_t i = index->valid; i < size; ++i)
+        items[i]->index = i;
+    index->valid = size;
+}
+
+ssize_t
+vlc_playlist_index_Find(struct vlc_playlist_index *index,
+                        vlc_playlist_item_t *const items[], size_t size,
+                        const vlc_playlist_item_t *item)
+{
+    assert(index->valid <= size);
+
+    size_t pos = item->index;
+    if (pos < size && items[pos] == item)
+        return pos;
+
+    if (index->valid == size)
+        /* all positions are up-to-date, the item is not in the playlist */
+        return -1;
+
+    Renumber(index, items, size);
+    pos = item->index;
+    if (pos < size && items[pos] == item)
+        return pos;
+    return -1;
+}
+
+ssize_t
+vlc_playlist_index_FindMedia(struct vlc_playlist_index *index,
+                             vlc_playlist_item_t *const items[], size_t size,
+                             const input_item_t *media)
+{
+    if (!index->size)
+        return -1;
+
+    /* the same media may be inserted several times, return the first one */
+    ssize_t ret = -1;
+    size_t mask = index->size - 1;
+    for (size_t i = HashMedia(media) & mask; index->by_media[i];
+         i = (i + 1) & mask)
+    {
+        vlc_playlist_item_t *item = index->by_media[i];
+        if (item->media != media)
+            continue;
+
+        ssize_t pos = vlc_playlist_index_Find(index, items, size, item);
+        assert(pos != -1); /* indexed items are in the playlist */
+        if (ret == -1 || pos < ret)
+            ret = pos;
+    }
+    return ret;
+}
+
+ssize_t
+vlc_playlist_index_FindId(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *const items[], size_t size,
+                          uint64_t id)
+{
+    if (!index->size)
+        return -1;
+
+    size_t mask = index->size - 1;
+    for (size_t i = HashId(id) & mask; index->by_id[i]; i = (i + 1) & mask)
+    {
+        vlc_playlist_item_t *item = index->by_id[i];
+        if (item->id == id)
+            return vlc_playlist_index_Find(index, items, size, item);
+    }
+    return -1;
+}
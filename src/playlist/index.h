@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * playlist/index.h
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_PLAYLIST_INDEX_H
+#define VLC_PLAYLIST_INDEX_H
+
+#include <vlc_common.h>
+
+typedef struct vlc_playlist_item vlc_playlist_item_t;
+typedef struct input_item_t input_item_t;
+
+/**
+ * Playlist helper to find the position of an item without scanning the
+ * whole list.
+ *
+ * Items are hashed by id and by media. Each item caches its position; the
+ * cached positions are valid below `valid`, and are recomputed lazily from
+ * there on the next lookup, so that a batch of changes costs a single pass.
+ *
+ * See index.c for implementation details.
+ */
+struct vlc_playlist_index {
+    vlc_playlist_item_t **by_id;
+    vlc_playlist_item_t **by_media;
+    size_t size; /* number of slots in each table, a power of 2 (or 0) */
+    size_t count;
+    size_t valid;
+};
+
+/**
+ * Initialize an empty index.
+ */
+void
+vlc_playlist_index_Init(struct vlc_playlist_index *index);
+
+/**
+ * Destroy an index.
+ */
+void
+vlc_playlist_index_Destroy(struct vlc_playlist_index *index);
+
+/**
+ * Make room for count more items.
+ *
+ * This is the only operation which may fail: once it succeeded, adding up
+ * to count items cannot fail.
+ */
+bool
+vlc_playlist_index_Reserve(struct vlc_playlist_index *index, size_t count);
+
+/**
+ * Add items inserted at the given position.
+ *
+ * The room for the items must have been reserved.
+ */
+void
+vlc_playlist_index_Add(struct vlc_playlist_index *index, size_t pos,
+                       vlc_playlist_item_t *const items[], size_t count);
+
+/**
+ * Remove items (before they are released).
+ */
+void
+vlc_playlist_index_Remove(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *const items[], size_t count);
+
+/**
+ * Remove all items.
+ */
+void
+vlc_playlist_index_Clear(struct vlc_playlist_index *index);
+
+/**
+ * Notify that the items positions changed from pos.
+ *
+ * This is O(1): the positions are recomputed on the next lookup.
+ */
+static inline void
+vlc_playlist_index_Invalidate(struct vlc_playlist_index *index, size_t pos)
+{
+    if (pos < index->valid)
+        index->valid = pos;
+}
+
+/**
+ * Return the position of an item in the items array, or -1 if not found.
+ */
+ssize_t
+vlc_playlist_index_Find(struct vlc_playlist_index *index,
+                        vlc_playlist_item_t *const items[], size_t size,
+                        const vlc_playlist_item_t *item);
+
+/**
+ * Return the position of the first item having the given media, or -1.
+ */
+ssize_t
+vlc_playlist_index_FindMedia(struct vlc_playlist_index *index,
+                             vlc_playlist_item_t *const items[], size_t size,
+                             const input_item_t *media);
+
+/**
+ * Return the position of the item having the given id, or -1.
+ */
+ssize_t
+vlc_playlist_index_FindId(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *const items[], size_t size,
+                          uint64_t id);
+
+#endif
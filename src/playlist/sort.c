@@ -25,6 +25,7 @@
 #include <vlc_common.h>
 #include <vlc_rand.h>
 #include <vlc_sort.h>
+#include <vlc_strings.h>
 #include "control.h"
 #include "item.h"
 #include "notify.h"
@@ -33,9 +34,13 @@
 /**
  * Struct containing a copy of (parsed) media metadata, used for sorting
  * without locking all the items.
+ *
+ * Strings are stored as precomputed comparison keys (folded to lowercase),
+ * so that comparing two items does not fold them again.
  */
 struct vlc_playlist_item_meta {
     vlc_playlist_item_t *item;
+    size_t position; /* initial position, to make the sort stable */
     const char *title_or_name;
     vlc_tick_t duration;
     const char *artist;
@@ -58,9 +63,12 @@ vlc_playlist_item_meta_CopyString(const char **to, const char *from)
 {
     if (from)
     {
-        *to = strdup(from);
-        if (unlikely(!*to))
+        char *key = strdup(from);
+        if (unlikely(!key))
             return VLC_ENOMEM;
+        for (char *c = key; *c; ++c)
+            *c = vlc_ascii_tolower(*c);
+        *to = key;
     }
     else
         *to = NULL;
@@ -187,43 +195,30 @@ vlc_playlist_item_meta_InitFields(struct vlc_playlist_item_meta *meta,
     return VLC_SUCCESS;
 }
 
-static struct vlc_playlist_item_meta *
-vlc_playlist_item_meta_New(vlc_playlist_item_t *item,
-                           const struct vlc_playlist_sort_criterion criteria[],
-                           size_t count)
+static int
+vlc_playlist_item_meta_Init(struct vlc_playlist_item_meta *meta,
+                            vlc_playlist_item_t *item, size_t position,
+                            const struct vlc_playlist_sort_criterion criteria[],
+                            size_t count)
 {
     /* assume that NULL representation is all-zeros */
-    struct vlc_playlist_item_meta *meta = calloc(1, sizeof(*meta));
-    if (unlikely(!meta))
-        return NULL;
-
+    memset(meta, 0, sizeof(*meta));
     meta->item = item;
+    meta->position = position;
 
     vlc_mutex_lock(&item->media->lock);
     int ret = vlc_playlist_item_meta_InitFields(meta, criteria, count);
     vlc_mutex_unlock(&item->media->lock);
 
-    if (unlikely(ret != VLC_SUCCESS))
-    {
-        free(meta);
-        return NULL;
-    }
-
-    return meta;
-}
-
-static void
-vlc_playlist_item_meta_Delete(struct vlc_playlist_item_meta *meta)
-{
-    vlc_playlist_item_meta_DestroyFields(meta);
-    free(meta);
+    return ret;
 }
 
 static inline int
 CompareStrings(const char *a, const char *b)
 {
     if (a && b)
-        return strcasecmp(a, b);
+        /* the keys are already folded */
+        return strcmp(a, b);
     if (!a && !b)
         return 0;
     return a ? 1 : -1;
@@ -318,45 +313,49 @@ compare_meta(const void *lhs, const void *rhs, void *userdata)
             return ret;
         }
     }
-    return 0;
+
+    /* keep equivalent items in their current order */
+    return CompareIntegers(a->position, b->position);
 }
 
 static void
-vlc_playlist_DeleteMetaArray(struct vlc_playlist_item_meta *array[],
+vlc_playlist_DeleteMetaArray(struct vlc_playlist_item_meta *metas,
                              size_t count)
 {
     for (size_t i = 0; i < count; ++i)
-        vlc_playlist_item_meta_Delete(array[i]);
-    free(array);
+        vlc_playlist_item_meta_DestroyFields(&metas[i]);
+    free(metas);
 }
 
-static struct vlc_playlist_item_meta **
+/* all the metadata are stored in a single allocation */
+static struct vlc_playlist_item_meta *
 vlc_playlist_NewMetaArray(vlc_playlist_t *playlist,
         const struct vlc_playlist_sort_criterion criteria[], size_t count)
 {
-    struct vlc_playlist_item_meta **array =
-            vlc_alloc(playlist->items.size, sizeof(*array));
+    struct vlc_playlist_item_meta *metas =
+            vlc_alloc(playlist->items.size, sizeof(*metas));
 
-    if (unlikely(!array))
+    if (unlikely(!metas))
         return NULL;
 
     size_t i;
     for (i = 0; i < playlist->items.size; ++i)
     {
-        array[i] = vlc_playlist_item_meta_New(playlist->items.data[i],
+        int ret = vlc_playlist_item_meta_Init(&metas[i],
+                                              playlist->items.data[i], i,
                                               criteria, count);
-        if (unlikely(!array[i]))
+        if (unlikely(ret != VLC_SUCCESS))
             break;
     }
 
     if (i < playlist->items.size)
     {
         /* allocation failure */
-        vlc_playlist_DeleteMetaArray(array, i);
+        vlc_playlist_DeleteMetaArray(metas, i);
         return NULL;
     }
 
-    return array;
+    return metas;
 }
 
 int
@@ -371,10 +370,22 @@ vlc_playlist_Sort(vlc_playlist_t *playlist,
                                  ? playlist->items.data[playlist->current]
                                  : NULL;
 
-    struct vlc_playlist_item_meta **array =
+    struct vlc_playlist_item_meta *metas =
         vlc_playlist_NewMetaArray(playlist, criteria, count);
+    if (unlikely(!metas))
+        return VLC_ENOMEM;
+
+    /* sort pointers, the metadata are too large to be swapped */
+    struct vlc_playlist_item_meta **array =
+            vlc_alloc(playlist->items.size, sizeof(*array));
     if (unlikely(!array))
+    {
+        vlc_playlist_DeleteMetaArray(metas, playlist->items.size);
         return VLC_ENOMEM;
+    }
+
+    for (size_t i = 0; i < playlist->items.size; ++i)
+        array[i] = &metas[i];
 
     struct sort_request req = { criteria, count };
 
@@ -383,8 +394,10 @@ vlc_playlist_Sort(vlc_playlist_t *playlist,
     /* apply the sorting result to the playlist */
     for (size_t i = 0; i < playlist->items.size; ++i)
         playlist->items.data[i] = array[i]->item;
+    vlc_playlist_index_Invalidate(&playlist->index, 0);
 
-    vlc_playlist_DeleteMetaArray(array, playlist->items.size);
+    free(array);
+    vlc_playlist_DeleteMetaArray(metas, playlist->items.size);
 
     struct vlc_playlist_state state;
     if (current)
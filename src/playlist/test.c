@@ -25,6 +25,7 @@
 #endif
 
 #include <stdio.h>
+#include "content.h"
 #include "item.h"
 #include "playlist.h"
 #include "preparse.h"
@@ -1065,6 +1066,83 @@ test_index_of(void)
     vlc_playlist_Delete(playlist);
 }
 
+static void
+CheckIndex(vlc_playlist_t *playlist)
+{
+    size_t count = vlc_playlist_Count(playlist);
+    for (size_t i = 0; i < count; ++i)
+    {
+        vlc_playlist_item_t *item = vlc_playlist_Get(playlist, i);
+        assert(vlc_playlist_IndexOf(playlist, item) == (ssize_t) i);
+        assert(vlc_playlist_IndexOfId(playlist, item->id) == (ssize_t) i);
+
+        /* the same media may be present several times */
+        ssize_t first = vlc_playlist_IndexOfMedia(playlist, item->media);
+        assert(first != -1 && first <= (ssize_t) i);
+        assert(vlc_playlist_Get(playlist, first)->media == item->media);
+        for (ssize_t j = 0; j < first; ++j)
+            assert(vlc_playlist_Get(playlist, j)->media != item->media);
+    }
+}
+
+static void
+test_index_of_after_changes(void)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL);
+    assert(playlist);
+
+    input_item_t *media[100];
+    CreateDummyMediaArray(media, 100);
+
+    /* enough items to grow the tables several times */
+    for (int i = 0; i < 10; ++i)
+    {
+        int ret = vlc_playlist_Append(playlist, media, 100);
+        assert(ret == VLC_SUCCESS);
+    }
+    CheckIndex(playlist);
+
+    int ret = vlc_playlist_Insert(playlist, 500, media, 50);
+    assert(ret == VLC_SUCCESS);
+    CheckIndex(playlist);
+
+    vlc_playlist_Move(playlist, 10, 200, 600);
+    vlc_playlist_Move(playlist, 800, 100, 5);
+    CheckIndex(playlist);
+
+    vlc_playlist_item_t *item = vlc_playlist_Get(playlist, 300);
+    uint64_t id = item->id;
+    vlc_playlist_item_Hold(item);
+    vlc_playlist_Remove(playlist, 250, 400);
+    assert(vlc_playlist_IndexOf(playlist, item) == -1);
+    assert(vlc_playlist_IndexOfId(playlist, id) == -1);
+    vlc_playlist_item_Release(item);
+    CheckIndex(playlist);
+
+    ret = vlc_playlist_Expand(playlist, 100, media, 10);
+    assert(ret == VLC_SUCCESS);
+    CheckIndex(playlist);
+
+    vlc_playlist_Shuffle(playlist);
+    CheckIndex(playlist);
+
+    /* remove all occurrences of the first media */
+    ssize_t index;
+    while ((index = vlc_playlist_IndexOfMedia(playlist, media[0])) != -1)
+        vlc_playlist_RemoveOne(playlist, index);
+    CheckIndex(playlist);
+
+    vlc_playlist_Clear(playlist);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[1]) == -1);
+
+    ret = vlc_playlist_Append(playlist, media, 10);
+    assert(ret == VLC_SUCCESS);
+    CheckIndex(playlist);
+
+    DestroyMediaArray(media, 100);
+    vlc_playlist_Delete(playlist);
+}
+
 static void
 test_prev(void)
 {
@@ -2367,6 +2445,7 @@ int main(void)
     test_playback_order_changed_callbacks();
     test_callbacks_on_add_listener();
     test_index_of();
+    test_index_of_after_changes();
     test_prev();
     test_next();
     test_goto();
@@ -30,8 +30,51 @@
 #include <vlc_fs.h>
 #include "misc/picture.h"
 
+#if defined (HAVE_MEMFD_CREATE) && defined (MFD_HUGETLB)
+static void *picture_AllocateHugeTLB(int *restrict fdp, size_t size)
+{
+    if ((size % PICTURE_HUGEPAGE_SIZE) != 0)
+        return NULL;
+
+    int fd = memfd_create(PACKAGE_NAME"-hugetlb", MFD_CLOEXEC | MFD_HUGETLB);
+    if (fd == -1)
+        return NULL;
+
+    /* This fails if not enough huge pages are reserved */
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, size) == 0)
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        vlc_close(fd);
+        return NULL;
+    }
+
+    *fdp = fd;
+    return base;
+}
+#endif
+
 void *picture_Allocate(int *restrict fdp, size_t size)
 {
+    enum picture_hugepages hugepages = PICTURE_HUGEPAGES_NONE;
+
+    if (size >= PICTURE_HUGEPAGE_SIZE)
+        hugepages = picture_GetHugePages();
+
+#if defined (HAVE_MEMFD_CREATE) && defined (MFD_HUGETLB)
+    if (hugepages == PICTURE_HUGEPAGES_EXPLICIT)
+    {
+        void *base = picture_AllocateHugeTLB(fdp, size);
+        if (base != NULL)
+        {
+            picture_CountHugePages(PICTURE_HUGEPAGES_EXPLICIT);
+            return base;
+        }
+        /* Fallback to transparent huge pages */
+    }
+#endif
+
     int fd = vlc_memfd();
     if (fd == -1)
         return NULL;
@@ -46,6 +89,16 @@ error:
     if (base == MAP_FAILED)
         goto error;
 
+#ifdef MADV_HUGEPAGE
+    /* Fewer TLB misses when accessing large pictures, if the kernel is
+     * configured to back shared memory with huge pages on request */
+    if (hugepages != PICTURE_HUGEPAGES_NONE
+     && madvise(base, size, MADV_HUGEPAGE) == 0)
+        picture_CountHugePages(PICTURE_HUGEPAGES_TRANSPARENT);
+#else
+    (void) hugepages;
+#endif
+
     *fdp = fd;
     return base;
 }
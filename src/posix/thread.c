@@ -117,6 +117,7 @@ void vlc_mutex_init( vlc_mutex_t *p_mutex )
     if (unlikely(pthread_mutex_init (p_mutex, &attr)))
         abort();
     pthread_mutexattr_destroy( &attr );
+    vlc_mutex_profile_init(p_mutex, __builtin_return_address(0));
 }
 
 void vlc_mutex_init_recursive( vlc_mutex_t *p_mutex )
@@ -129,20 +130,40 @@ void vlc_mutex_init_recursive( vlc_mutex_t *p_mutex )
     if (unlikely(pthread_mutex_init (p_mutex, &attr)))
         abort();
     pthread_mutexattr_destroy( &attr );
+    vlc_mutex_profile_init(p_mutex, __builtin_return_address(0));
 }
 
 void vlc_mutex_destroy (vlc_mutex_t *p_mutex)
 {
     int val = pthread_mutex_destroy( p_mutex );
     VLC_THREAD_ASSERT ("destroying mutex");
+    vlc_mutex_profile_destroy(p_mutex);
 }
 
 void vlc_mutex_lock(vlc_mutex_t *mutex)
 {
+#ifdef ENABLE_LOCK_PROFILING
+    /* Only measure the waits of the contended locks */
+    int val = pthread_mutex_trylock(mutex);
+    bool contended = val == EBUSY;
+    vlc_tick_t wait = 0;
+
+    if (contended)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        val = pthread_mutex_lock(mutex);
+        wait = vlc_tick_now() - start;
+    }
+#else
     int val = pthread_mutex_lock(mutex);
+#endif
 
     VLC_THREAD_ASSERT("locking mutex");
     vlc_mutex_mark(mutex);
+#ifdef ENABLE_LOCK_PROFILING
+    vlc_mutex_profile_lock(mutex, __builtin_return_address(0), contended,
+                           wait);
+#endif
 }
 
 int vlc_mutex_trylock(vlc_mutex_t *mutex)
@@ -152,6 +173,9 @@ int vlc_mutex_trylock(vlc_mutex_t *mutex)
     if (val != EBUSY) {
         VLC_THREAD_ASSERT("locking mutex");
         vlc_mutex_mark(mutex);
+#ifdef ENABLE_LOCK_PROFILING
+        vlc_mutex_profile_lock(mutex, __builtin_return_address(0), false, 0);
+#endif
     }
 
     return val;
@@ -159,6 +183,7 @@ int vlc_mutex_trylock(vlc_mutex_t *mutex)
 
 void vlc_mutex_unlock(vlc_mutex_t *mutex)
 {
+    vlc_mutex_profile_unlock(mutex);
     int val = pthread_mutex_unlock(mutex);
 
     VLC_THREAD_ASSERT("unlocking mutex");
@@ -202,17 +227,26 @@ void vlc_cond_broadcast (vlc_cond_t *p_condvar)
 
 void vlc_cond_wait (vlc_cond_t *p_condvar, vlc_mutex_t *p_mutex)
 {
+    /* The mutex is not held while waiting */
+    vlc_mutex_profile_unlock(p_mutex);
     int val = pthread_cond_wait( p_condvar, p_mutex );
     VLC_THREAD_ASSERT ("waiting on condition");
+#ifdef ENABLE_LOCK_PROFILING
+    vlc_mutex_profile_lock(p_mutex, __builtin_return_address(0), false, 0);
+#endif
 }
 
 int vlc_cond_timedwait (vlc_cond_t *p_condvar, vlc_mutex_t *p_mutex,
                         vlc_tick_t deadline)
 {
     struct timespec ts = timespec_from_vlc_tick (deadline);
+    vlc_mutex_profile_unlock(p_mutex);
     int val = pthread_cond_timedwait (p_condvar, p_mutex, &ts);
     if (val != ETIMEDOUT)
         VLC_THREAD_ASSERT ("timed-waiting on condition");
+#ifdef ENABLE_LOCK_PROFILING
+    vlc_mutex_profile_lock(p_mutex, __builtin_return_address(0), false, 0);
+#endif
     return val;
 }
 
@@ -220,9 +254,13 @@ int vlc_cond_timedwait_daytime (vlc_cond_t *p_condvar, vlc_mutex_t *p_mutex,
                                 time_t deadline)
 {
     struct timespec ts = { deadline, 0 };
+    vlc_mutex_profile_unlock(p_mutex);
     int val = pthread_cond_timedwait (p_condvar, p_mutex, &ts);
     if (val != ETIMEDOUT)
         VLC_THREAD_ASSERT ("timed-waiting on condition");
+#ifdef ENABLE_LOCK_PROFILING
+    vlc_mutex_profile_lock(p_mutex, __builtin_return_address(0), false, 0);
+#endif
     return val;
 }
 
@@ -1,5 +1,5 @@
 /*****************************************************************************
- * timer.c: simple threaded timer
+ * timer.c: timers serviced by a shared thread pool
  *****************************************************************************
  * Copyright (C) 2009-2012 Rémi Denis-Courmont
  *
@@ -23,11 +23,13 @@
 #endif
 
 #include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <assert.h>
 
 #include <vlc_common.h>
+#include "libvlc.h"
 
 /*
  * POSIX timers are essentially unusable from a library: there provide no safe
@@ -35,40 +37,182 @@
  * they typically require one thread per timer plus one thread per iteration,
  * which is inefficient and overkill (unless you need multiple iteration
  * of the same timer concurrently).
- * Thus, this is a generic manual implementation of timers using a thread.
+ * Thus, this is a generic manual implementation of timers.
+ *
+ * All timers are serviced by a shared pool of threads: the armed timers are
+ * kept in a binary heap ordered by deadline, and an idle thread waits for the
+ * earliest one. The thread firing a timer makes sure that another thread is
+ * available, so that a slow callback does not delay the other timers. Idle
+ * threads exit after a while, so that there are none if no timers are armed.
+ *
+ * A timer is in the heap if and only if it is armed and its callback is not
+ * running: a timer never fires concurrently with itself.
  */
 
+#define TIMER_IDLE_DELAY VLC_TICK_FROM_SEC(5)
+#define TIMER_NOT_QUEUED SIZE_MAX
+
 struct vlc_timer
 {
-    vlc_thread_t thread;
-    vlc_cond_t   reschedule;
-    vlc_mutex_t  lock;
     void       (*func) (void *);
     void        *data;
     vlc_tick_t   value, interval;
-    bool         live;
+    size_t       index; /**< position in the heap */
+    bool         running;
     atomic_uint  overruns;
 };
 
-static void *vlc_timer_thread (void *data)
+static struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /**< the heap changed */
+    vlc_cond_t done; /**< a callback returned */
+    struct vlc_timer **heap;
+    size_t count;
+    size_t size;
+    unsigned threads;
+    unsigned idle;
+} timers = {
+    VLC_STATIC_MUTEX, VLC_STATIC_COND, VLC_STATIC_COND, NULL, 0, 0, 0, 0,
+};
+
+static void vlc_timer_heap_set(size_t i, struct vlc_timer *timer)
+{
+    timers.heap[i] = timer;
+    timer->index = i;
+}
+
+static void vlc_timer_heap_up(size_t i)
 {
-    struct vlc_timer *timer = data;
+    struct vlc_timer *timer = timers.heap[i];
+
+    while (i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+
+        if (timers.heap[parent]->value <= timer->value)
+            break;
+        vlc_timer_heap_set(i, timers.heap[parent]);
+        i = parent;
+    }
+    vlc_timer_heap_set(i, timer);
+}
+
+static void vlc_timer_heap_down(size_t i)
+{
+    struct vlc_timer *timer = timers.heap[i];
+
+    for (;;)
+    {
+        size_t child = 2 * i + 1;
 
-    vlc_mutex_lock (&timer->lock);
+        if (child >= timers.count)
+            break;
+        if (child + 1 < timers.count
+         && timers.heap[child + 1]->value < timers.heap[child]->value)
+            child++;
+        if (timer->value <= timers.heap[child]->value)
+            break;
+        vlc_timer_heap_set(i, timers.heap[child]);
+        i = child;
+    }
+    vlc_timer_heap_set(i, timer);
+}
+
+static void vlc_timer_remove(struct vlc_timer *timer)
+{
+    size_t i = timer->index;
+
+    assert(i < timers.count && timers.heap[i] == timer);
+    timer->index = TIMER_NOT_QUEUED;
+
+    struct vlc_timer *last = timers.heap[--timers.count];
+    if (last == timer)
+        return;
+
+    vlc_timer_heap_set(i, last);
+    vlc_timer_heap_up(i);
+    vlc_timer_heap_down(last->index);
+}
+
+static void *vlc_timer_thread(void *data);
+
+/* Makes sure that a thread is waiting for the next timer */
+static void vlc_timer_spawn(void)
+{
+    if (timers.idle > 0)
+        return;
+
+    if (vlc_clone_detach(NULL, vlc_timer_thread, NULL,
+                         VLC_THREAD_PRIORITY_INPUT) == 0)
+    {
+        timers.threads++;
+        timers.idle++; /* it will be idle as soon as it starts */
+    }
+}
+
+static int vlc_timer_insert(struct vlc_timer *timer)
+{
+    assert(timer->index == TIMER_NOT_QUEUED);
 
-    while (timer->live)
+    if (timers.count == timers.size)
     {
-        if (timer->value == 0)
+        size_t size = timers.size ? 2 * timers.size : 16;
+        struct vlc_timer **heap = realloc(timers.heap, size * sizeof (*heap));
+
+        if (unlikely(heap == NULL))
+            return ENOMEM;
+        timers.heap = heap;
+        timers.size = size;
+    }
+
+    vlc_timer_heap_set(timers.count++, timer);
+    vlc_timer_heap_up(timer->index);
+
+    if (timers.heap[0] == timer)
+    {   /* the earliest deadline changed */
+        vlc_timer_spawn();
+        vlc_cond_signal(&timers.wait);
+    }
+    return 0;
+}
+
+static void *vlc_timer_thread(void *data)
+{
+    vlc_tick_t idle_deadline = vlc_tick_now() + TIMER_IDLE_DELAY;
+
+    (void) data;
+    vlc_mutex_lock(&timers.lock);
+    /* counted as idle by vlc_timer_spawn() */
+
+    for (;;)
+    {
+        vlc_tick_t now = vlc_tick_now();
+
+        if (timers.count == 0 || timers.heap[0]->value > now)
         {
-            assert(timer->interval == 0);
-            vlc_cond_wait (&timer->reschedule, &timer->lock);
+            if (now >= idle_deadline)
+            {
+                if (timers.count == 0 || timers.idle > 1)
+                    break; /* not needed anymore */
+                idle_deadline = now + TIMER_IDLE_DELAY;
+            }
+
+            vlc_tick_t deadline = idle_deadline;
+
+            if (timers.count > 0 && timers.heap[0]->value < deadline)
+                deadline = timers.heap[0]->value;
+            vlc_cond_timedwait(&timers.wait, &timers.lock, deadline);
             continue;
         }
 
+        /* Fire the earliest timer */
+        struct vlc_timer *timer = timers.heap[0];
+
+        vlc_timer_remove(timer);
+
         if (timer->interval != 0)
         {
-            vlc_tick_t now = vlc_tick_now();
-
             if (now > timer->value)
             {   /* Update overrun counter */
                 unsigned misses = (now - timer->value) / timer->interval;
@@ -78,27 +222,36 @@ static void *vlc_timer_thread (void *data)
                 atomic_fetch_add_explicit(&timer->overruns, misses,
                                           memory_order_relaxed);
             }
+            timer->value += timer->interval; /* rearm */
         }
+        else
+            timer->value = 0; /* disarm */
 
-        vlc_tick_t value = timer->value;
-
-        if (vlc_cond_timedwait(&timer->reschedule, &timer->lock, value) == 0)
-            continue;
+        timer->running = true;
+        timers.idle--;
+        vlc_timer_spawn(); /* for the other timers */
+        vlc_mutex_unlock(&timers.lock);
 
-        if (likely(timer->value <= value))
-        {
-            timer->value += timer->interval; /* rearm */
-
-            if (timer->interval == 0)
-                timer->value = 0; /* disarm */
-        }
+        timer->func(timer->data);
 
-        vlc_mutex_unlock (&timer->lock);
-        timer->func (timer->data);
-        vlc_mutex_lock (&timer->lock);
+        vlc_mutex_lock(&timers.lock);
+        timers.idle++;
+        timer->running = false;
+        if (timer->value != 0)
+            vlc_timer_insert(timer);
+        vlc_cond_broadcast(&timers.done);
+        idle_deadline = vlc_tick_now() + TIMER_IDLE_DELAY;
     }
 
-    vlc_mutex_unlock (&timer->lock);
+    timers.idle--;
+    timers.threads--;
+    if (timers.threads == 0)
+    {
+        free(timers.heap);
+        timers.heap = NULL;
+        timers.size = 0;
+    }
+    vlc_mutex_unlock(&timers.lock);
     return NULL;
 }
 
@@ -108,39 +261,30 @@ int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
 
     if (unlikely(timer == NULL))
         return ENOMEM;
-    vlc_mutex_init (&timer->lock);
-    vlc_cond_init (&timer->reschedule);
     assert (func);
     timer->func = func;
     timer->data = data;
     timer->value = 0;
     timer->interval = 0;
-    timer->live = true;
+    timer->index = TIMER_NOT_QUEUED;
+    timer->running = false;
     atomic_init(&timer->overruns, 0);
 
-    if (vlc_clone (&timer->thread, vlc_timer_thread, timer,
-                   VLC_THREAD_PRIORITY_INPUT))
-    {
-        vlc_cond_destroy (&timer->reschedule);
-        vlc_mutex_destroy (&timer->lock);
-        free (timer);
-        return ENOMEM;
-    }
-
     *id = timer;
     return 0;
 }
 
 void vlc_timer_destroy (vlc_timer_t timer)
 {
-    vlc_mutex_lock(&timer->lock);
-    timer->live = false;
-    vlc_cond_signal(&timer->reschedule);
-    vlc_mutex_unlock(&timer->lock);
-
-    vlc_join (timer->thread, NULL);
-    vlc_cond_destroy (&timer->reschedule);
-    vlc_mutex_destroy (&timer->lock);
+    vlc_mutex_lock(&timers.lock);
+    if (timer->index != TIMER_NOT_QUEUED)
+        vlc_timer_remove(timer);
+    timer->value = 0;
+    /* wait for the ongoing iteration, if any */
+    while (timer->running)
+        vlc_cond_wait(&timers.done, &timers.lock);
+    vlc_mutex_unlock(&timers.lock);
+
     free (timer);
 }
 
@@ -153,11 +297,16 @@ void vlc_timer_schedule (vlc_timer_t timer, bool absolute,
     if (!absolute)
         value += vlc_tick_now();
 
-    vlc_mutex_lock (&timer->lock);
+    vlc_mutex_lock (&timers.lock);
+    if (timer->index != TIMER_NOT_QUEUED)
+        vlc_timer_remove(timer);
     timer->value = value;
     timer->interval = interval;
-    vlc_cond_signal (&timer->reschedule);
-    vlc_mutex_unlock (&timer->lock);
+    /* if the callback is running, the timer is queued once it returns */
+    if (value != 0 && !timer->running
+     && unlikely(vlc_timer_insert(timer)))
+        timer->value = 0; /* cannot be armed */
+    vlc_mutex_unlock (&timers.lock);
 }
 
 unsigned vlc_timer_getoverrun (vlc_timer_t timer)
@@ -45,10 +45,16 @@ struct input_fetcher_t {
     struct background_worker* downloader;
 
     vlc_dictionary_t album_cache;
+    vlc_dictionary_t album_missing; /* albums without art, by expiry date */
+    vlc_dictionary_t album_pending; /* albums being searched on the network */
+    vlc_cond_t album_wait;
     vlc_object_t* owner;
     vlc_mutex_t lock;
 };
 
+/* Delay before searching art on the network again for an album without any */
+#define FETCHER_MISSING_ART_DELAY VLC_TICK_FROM_SEC(3600)
+
 struct fetcher_request {
     input_item_t* item;
     vlc_atomic_rc_t rc;
@@ -191,6 +197,67 @@ static int SearchArt( input_fetcher_t* fetcher, input_item_t* item, int scope)
     return CheckArt( item );
 }
 
+/**
+ * Search art on the network once for all the tracks of an album.
+ *
+ * Concurrent requests for the same album wait for the first one, then read
+ * its result from the album cache. Albums without art are not searched again
+ * before FETCHER_MISSING_ART_DELAY.
+ */
+static int SearchNetworkArt( input_fetcher_t* fetcher, input_item_t* item )
+{
+    char* key = CreateCacheKey( item );
+    if( key == NULL )
+        return SearchArt( fetcher, item, FETCHER_SCOPE_NETWORK );
+
+    int ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &fetcher->lock );
+    while( vlc_dictionary_has_key( &fetcher->album_pending, key ) )
+        vlc_cond_wait( &fetcher->album_wait, &fetcher->lock );
+
+    vlc_tick_t* expiry = vlc_dictionary_value_for_key( &fetcher->album_missing,
+                                                       key );
+    if( expiry != NULL && *expiry > vlc_tick_now() )
+        goto out; /* recently searched in vain */
+
+    char const* art = vlc_dictionary_value_for_key( &fetcher->album_cache,
+                                                    key );
+    if( art )
+    {
+        input_item_SetArtURL( item, art );
+        ret = VLC_SUCCESS;
+        goto out;
+    }
+
+    vlc_dictionary_insert( &fetcher->album_pending, key, fetcher );
+    vlc_mutex_unlock( &fetcher->lock );
+
+    ret = SearchArt( fetcher, item, FETCHER_SCOPE_NETWORK );
+    if( ret == VLC_SUCCESS )
+        AddAlbumCache( fetcher, item, false );
+
+    vlc_mutex_lock( &fetcher->lock );
+    vlc_dictionary_remove_value_for_key( &fetcher->album_pending, key,
+                                         NULL, NULL );
+    vlc_dictionary_remove_value_for_key( &fetcher->album_missing, key,
+                                         FreeCacheEntry, NULL );
+    if( ret != VLC_SUCCESS && !vlc_killed() )
+    {
+        expiry = malloc( sizeof( *expiry ) );
+        if( likely( expiry != NULL ) )
+        {
+            *expiry = vlc_tick_now() + FETCHER_MISSING_ART_DELAY;
+            vlc_dictionary_insert( &fetcher->album_missing, key, expiry );
+        }
+    }
+    vlc_cond_broadcast( &fetcher->album_wait );
+out:
+    vlc_mutex_unlock( &fetcher->lock );
+    free( key );
+    return ret;
+}
+
 static int SearchByScope( input_fetcher_t* fetcher,
     struct fetcher_request* req, int scope )
 {
@@ -206,7 +273,9 @@ static int SearchByScope( input_fetcher_t* fetcher,
         ! ReadAlbumCache( fetcher, item )          ||
         ! input_FindArtInCacheUsingItemUID( item ) ||
         ! input_FindArtInCache( item )             ||
-        ! SearchArt( fetcher, item, scope ) )
+        ! ( scope == FETCHER_SCOPE_NETWORK
+            ? SearchNetworkArt( fetcher, item )
+            : SearchArt( fetcher, item, scope ) ) )
     {
         AddAlbumCache( fetcher, req->item, false );
         if( !background_worker_Push( fetcher->downloader, req, NULL, 0 ) )
@@ -443,6 +512,9 @@ input_fetcher_t* input_fetcher_New( vlc_object_t* owner )
 
     vlc_mutex_init( &fetcher->lock );
     vlc_dictionary_init( &fetcher->album_cache, 0 );
+    vlc_dictionary_init( &fetcher->album_missing, 0 );
+    vlc_dictionary_init( &fetcher->album_pending, 0 );
+    vlc_cond_init( &fetcher->album_wait );
 
     return fetcher;
 }
@@ -481,6 +553,9 @@ void input_fetcher_Delete( input_fetcher_t* fetcher )
     background_worker_Delete( fetcher->downloader );
 
     vlc_dictionary_clear( &fetcher->album_cache, FreeCacheEntry, NULL );
+    vlc_dictionary_clear( &fetcher->album_missing, FreeCacheEntry, NULL );
+    vlc_dictionary_clear( &fetcher->album_pending, NULL, NULL );
+    vlc_cond_destroy( &fetcher->album_wait );
     vlc_mutex_destroy( &fetcher->lock );
 
     free( fetcher );
@@ -24,6 +24,7 @@
 
 #include <vlc_common.h>
 #include <vlc_atomic.h>
+#include <vlc_url.h>
 
 #include "misc/background_worker.h"
 #include "input/input_interface.h"
@@ -133,6 +134,19 @@ static int PreparserOpenInput( void* preparser_, void* req_, void** out )
     task->preparser = preparser_;
     task->req = req;
     task->preparse_status = -1;
+
+    if( (req->options & META_REQUEST_OPTION_META_ONLY)
+     && input_item_ReadMeta( preparser->owner, req->item ) == VLC_SUCCESS )
+    {
+        /* done already, without creating any input */
+        task->parser = NULL;
+        atomic_store( &task->state, VLC_SUCCESS );
+        atomic_store( &task->done, true );
+        *out = task;
+        background_worker_RequestProbe( preparser->worker );
+        return VLC_SUCCESS;
+    }
+
     task->parser = input_item_Parse( req->item, preparser->owner, &cbs,
                                      task );
     if( !task->parser )
@@ -198,7 +212,8 @@ static void PreparserCloseInput( void* preparser_, void* task_ )
             break;
     }
 
-    input_item_parser_id_Release( task->parser );
+    if( task->parser != NULL )
+        input_item_parser_id_Release( task->parser );
 
     if( preparser->fetcher && (req->options & META_REQUEST_OPTION_FETCH_ANY) )
     {
@@ -223,6 +238,12 @@ static void PreparserCloseInput( void* preparser_, void* task_ )
 static void ReqHoldVoid(void *item) { ReqHold(item); }
 static void ReqReleaseVoid(void *item) { ReqRelease(item); }
 
+static bool ReqEquals(void *a, void *b)
+{
+    input_preparser_req_t *req_a = a, *req_b = b;
+    return req_a->item == req_b->item;
+}
+
 input_preparser_t* input_preparser_New( vlc_object_t *parent )
 {
     input_preparser_t* preparser = malloc( sizeof *preparser );
@@ -230,6 +251,9 @@ input_preparser_t* input_preparser_New( vlc_object_t *parent )
     struct background_worker_config conf = {
         .default_timeout = VLC_TICK_FROM_MS(var_InheritInteger( parent, "preparse-timeout" )),
         .max_threads = var_InheritInteger( parent, "preparse-threads" ),
+        .max_threads_per_group =
+            var_InheritInteger( parent, "preparse-host-threads" ),
+        .pf_equals = ReqEquals,
         .pf_start = PreparserOpenInput,
         .pf_probe = PreparserProbeInput,
         .pf_stop = PreparserCloseInput,
@@ -270,6 +294,18 @@ void input_preparser_Push( input_preparser_t *preparser,
     int b_net = item->b_net;
     if( i_options & META_REQUEST_OPTION_DO_INTERACT )
         item->b_preparse_interact = true;
+
+    /* network items are grouped by host, so that a slow server can only
+     * hold up to "preparse-host-threads" threads */
+    char *host = NULL;
+    if( b_net && item->psz_uri != NULL )
+    {
+        vlc_url_t url;
+        if( vlc_UrlParse( &url, item->psz_uri ) == VLC_SUCCESS
+         && url.psz_host != NULL )
+            host = strdup( url.psz_host );
+        vlc_UrlClean( &url );
+    }
     vlc_mutex_unlock( &item->lock );
 
     switch( i_type )
@@ -282,19 +318,30 @@ void input_preparser_Push( input_preparser_t *preparser,
                 break;
             /* fallthrough */
         default:
+            free( host );
             if (cbs && cbs->on_preparse_ended)
                 cbs->on_preparse_ended(item, ITEM_PREPARSE_SKIPPED, cbs_userdata);
             return;
     }
 
+    enum background_worker_priority priority;
+    if( i_options & META_REQUEST_OPTION_PRIORITY_VISIBLE )
+        priority = BACKGROUND_WORKER_PRIORITY_HIGH;
+    else if( i_options & META_REQUEST_OPTION_PRIORITY_PREFETCH )
+        priority = BACKGROUND_WORKER_PRIORITY_LOW;
+    else
+        priority = BACKGROUND_WORKER_PRIORITY_NORMAL;
+
     struct input_preparser_req_t *req = ReqCreate(item, i_options,
                                                   cbs, cbs_userdata);
 
-    if (background_worker_Push(preparser->worker, req, id, timeout))
+    if (background_worker_PushPriority(preparser->worker, req, id, timeout,
+                                       priority, host))
         if (req->cbs && cbs->on_preparse_ended)
             cbs->on_preparse_ended(item, ITEM_PREPARSE_FAILED, cbs_userdata);
 
     ReqRelease(req);
+    free( host );
 }
 
 void input_preparser_fetcher_Push( input_preparser_t *preparser,
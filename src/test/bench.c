@@ -0,0 +1,565 @@
+/*****************************************************************************
+ * bench.c: micro-benchmarks of the core primitives
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_arrays.h>
+#include <vlc_block.h>
+#include <vlc_cpu.h>
+#include <vlc_es.h>
+#include <vlc_picture_pool.h>
+#include <vlc_variables.h>
+
+#include "../clock/clock.h"
+#include "../../modules/video_chroma/copy.h"
+#include "../../modules/packetizer/startcode_helper.h"
+#include "../../modules/packetizer/hxxx_ep3b.h"
+
+/*
+ * Each benchmark runs the same number of operations on 1, 2, 4... threads
+ * (up to BENCH_THREADS, the CPU count by default), and prints the wall time
+ * per operation and per thread: a constant value means that the primitive
+ * scales linearly. BENCH_ITERATIONS scales the number of operations.
+ *
+ * This is not part of the test suite: run it with "make bench".
+ */
+
+const char vlc_module_name[] = "bench_core";
+
+#define MAX_THREADS 16
+
+struct bench
+{
+    const char *name;
+    unsigned long iterations; /* per thread, before scaling */
+    void *(*setup)(unsigned threads);
+    void (*run)(void *data, unsigned index, unsigned long iterations);
+    void (*teardown)(void *data, unsigned threads);
+};
+
+/*** Blocks ***/
+
+static void *setup_none(unsigned threads)
+{
+    (void) threads;
+    return NULL;
+}
+
+static void teardown_none(void *data, unsigned threads)
+{
+    (void) data; (void) threads;
+}
+
+static void run_block_gather(void *data, unsigned index, unsigned long n)
+{
+    (void) data; (void) index;
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        block_t *chain = NULL, **pp = &chain;
+
+        /* a PES of TS packets */
+        for (unsigned j = 0; j < 8; j++)
+        {
+            block_t *b = block_Alloc(184);
+            assert(b != NULL);
+            block_ChainLastAppend(&pp, b);
+        }
+
+        block_t *b = block_ChainGather(chain);
+        assert(b != NULL && b->i_buffer == 8 * 184);
+        block_Release(b);
+    }
+}
+
+struct fifo_data
+{
+    block_fifo_t *fifo;
+    block_t *blocks[MAX_THREADS];
+};
+
+static void *setup_fifo(unsigned threads)
+{
+    struct fifo_data *d = malloc(sizeof (*d));
+    assert(d != NULL);
+    d->fifo = block_FifoNew();
+    assert(d->fifo != NULL);
+    for (unsigned i = 0; i < threads; i++)
+    {
+        d->blocks[i] = block_Alloc(188);
+        assert(d->blocks[i] != NULL);
+    }
+    return d;
+}
+
+/* Every thread puts before getting: the FIFO is never empty on get, but the
+ * threads contend for its lock */
+static void run_fifo(void *data, unsigned index, unsigned long n)
+{
+    struct fifo_data *d = data;
+    block_t *b = d->blocks[index];
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        block_FifoPut(d->fifo, b);
+        b = block_FifoGet(d->fifo);
+    }
+    d->blocks[index] = b;
+}
+
+static void teardown_fifo(void *data, unsigned threads)
+{
+    struct fifo_data *d = data;
+
+    for (unsigned i = 0; i < threads; i++)
+        block_Release(d->blocks[i]);
+    block_FifoRelease(d->fifo);
+    free(d);
+}
+
+/*** Pictures ***/
+
+static void *setup_pool(unsigned threads)
+{
+    video_format_t fmt;
+
+    video_format_Init(&fmt, VLC_CODEC_I420);
+    video_format_Setup(&fmt, VLC_CODEC_I420, 320, 240, 320, 240, 1, 1);
+
+    picture_pool_t *pool = picture_pool_NewFromFormat(&fmt, threads);
+    assert(pool != NULL);
+    return pool;
+}
+
+static void run_pool(void *data, unsigned index, unsigned long n)
+{
+    picture_pool_t *pool = data;
+    (void) index;
+
+    /* as many pictures as threads: there is always one left */
+    for (unsigned long i = 0; i < n; i++)
+    {
+        picture_t *pic = picture_pool_Get(pool);
+        assert(pic != NULL);
+        picture_Release(pic);
+    }
+}
+
+static void teardown_pool(void *data, unsigned threads)
+{
+    (void) threads;
+    picture_pool_Release(data);
+}
+
+struct copy_data
+{
+    picture_t *src, *dst;
+    copy_cache_t cache;
+};
+
+static void *setup_copy(unsigned threads)
+{
+    struct copy_data *d = malloc(threads * sizeof (*d));
+    assert(d != NULL);
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        video_format_t fmt;
+
+        video_format_Init(&fmt, VLC_CODEC_NV12);
+        video_format_Setup(&fmt, VLC_CODEC_NV12, 1920, 1088, 1920, 1080,
+                           1, 1);
+        d[i].src = picture_NewFromFormat(&fmt);
+        fmt.i_chroma = VLC_CODEC_I420;
+        d[i].dst = picture_NewFromFormat(&fmt);
+        assert(d[i].src != NULL && d[i].dst != NULL);
+        for (int p = 0; p < d[i].src->i_planes; p++)
+            memset(d[i].src->p[p].p_pixels, 0x80,
+                   d[i].src->p[p].i_pitch * d[i].src->p[p].i_lines);
+        int ret = CopyInitCache(&d[i].cache, 1920);
+        assert(ret == VLC_SUCCESS);
+    }
+    return d;
+}
+
+static void run_copy(void *data, unsigned index, unsigned long n)
+{
+    struct copy_data *d = (struct copy_data *)data + index;
+    const uint8_t *planes[2] = { d->src->p[0].p_pixels, d->src->p[1].p_pixels };
+    const size_t pitches[2] = { d->src->p[0].i_pitch, d->src->p[1].i_pitch };
+
+    /* the copy of a hardware decoded frame to system memory */
+    for (unsigned long i = 0; i < n; i++)
+        Copy420_SP_to_P(d->dst, planes, pitches, 1080, &d->cache);
+}
+
+static void teardown_copy(void *data, unsigned threads)
+{
+    struct copy_data *d = data;
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        CopyCleanCache(&d[i].cache);
+        picture_Release(d[i].src);
+        picture_Release(d[i].dst);
+    }
+    free(d);
+}
+
+/*** Dictionary ***/
+
+#define DICT_KEYS 1000
+
+static void *setup_dictionary(unsigned threads)
+{
+    vlc_dictionary_t *dicts = malloc(threads * sizeof (*dicts));
+    assert(dicts != NULL);
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        vlc_dictionary_init(&dicts[i], 0);
+        for (uintptr_t k = 0; k < DICT_KEYS; k++)
+        {
+            char key[16];
+            snprintf(key, sizeof (key), "key-%03u", (unsigned)k);
+            vlc_dictionary_insert(&dicts[i], key, (void *)(k + 1));
+        }
+    }
+    return dicts;
+}
+
+static void run_dictionary(void *data, unsigned index, unsigned long n)
+{
+    const vlc_dictionary_t *dict = (vlc_dictionary_t *)data + index;
+    char key[16];
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        unsigned k = i % DICT_KEYS;
+        snprintf(key, sizeof (key), "key-%03u", k);
+        void *value = vlc_dictionary_value_for_key(dict, key);
+        assert(value == (void *)(uintptr_t)(k + 1));
+        (void) value;
+    }
+}
+
+static void teardown_dictionary(void *data, unsigned threads)
+{
+    vlc_dictionary_t *dicts = data;
+
+    for (unsigned i = 0; i < threads; i++)
+        vlc_dictionary_clear(&dicts[i], NULL, NULL);
+    free(dicts);
+}
+
+/*** Variables ***/
+
+struct var_data
+{
+    vlc_object_t *root;
+    vlc_object_t *children[MAX_THREADS];
+};
+
+static void *setup_var(unsigned threads)
+{
+    struct var_data *d = malloc(sizeof (*d));
+    assert(d != NULL);
+
+    d->root = (vlc_object_create)(NULL, sizeof (*d->root));
+    assert(d->root != NULL);
+    var_Create(d->root, "bench-int", VLC_VAR_INTEGER);
+    var_SetInteger(d->root, "bench-int", 42);
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        /* the depth of a decoder below its input */
+        vlc_object_t *parent = d->root;
+        for (unsigned j = 0; j < 3; j++)
+        {
+            parent = vlc_object_create(parent, sizeof (*parent));
+            assert(parent != NULL);
+        }
+        d->children[i] = parent;
+    }
+    return d;
+}
+
+static void run_var_get(void *data, unsigned index, unsigned long n)
+{
+    struct var_data *d = data;
+    (void) index;
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        int64_t val = var_GetInteger(d->root, "bench-int");
+        assert(val == 42);
+        (void) val;
+    }
+}
+
+static void run_var_inherit(void *data, unsigned index, unsigned long n)
+{
+    struct var_data *d = data;
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        int64_t val = var_InheritInteger(d->children[index], "bench-int");
+        assert(val == 42);
+        (void) val;
+    }
+}
+
+static void teardown_var(void *data, unsigned threads)
+{
+    struct var_data *d = data;
+
+    for (unsigned i = 0; i < threads; i++)
+        for (vlc_object_t *obj = d->children[i], *parent; obj != d->root;
+             obj = parent)
+        {
+            parent = vlc_object_parent(obj);
+            vlc_object_delete(obj);
+        }
+    vlc_object_delete(d->root);
+    free(d);
+}
+
+/*** Clock ***/
+
+struct clock_data
+{
+    vlc_clock_main_t *main;
+    vlc_clock_t *master;
+    vlc_clock_t *slaves[MAX_THREADS];
+};
+
+static void *setup_clock(unsigned threads)
+{
+    struct clock_data *d = malloc(sizeof (*d));
+    assert(d != NULL);
+
+    d->main = vlc_clock_main_New();
+    assert(d->main != NULL);
+    d->master = vlc_clock_main_CreateMaster(d->main, NULL, NULL);
+    assert(d->master != NULL);
+
+    /* audio and video outputs sharing the clock of an input */
+    for (unsigned i = 0; i < threads; i++)
+    {
+        d->slaves[i] = vlc_clock_main_CreateSlave(d->main, VIDEO_ES,
+                                                  NULL, NULL);
+        assert(d->slaves[i] != NULL);
+    }
+
+    vlc_tick_t now = vlc_tick_now();
+    vlc_clock_Update(d->master, now, VLC_TICK_0, 1.f);
+    vlc_clock_Update(d->master, now + VLC_TICK_FROM_MS(20),
+                     VLC_TICK_0 + VLC_TICK_FROM_MS(20), 1.f);
+    return d;
+}
+
+static void run_clock(void *data, unsigned index, unsigned long n)
+{
+    struct clock_data *d = data;
+    vlc_clock_t *clock = d->slaves[index];
+    vlc_tick_t now = vlc_tick_now();
+
+    for (unsigned long i = 0; i < n; i++)
+    {
+        vlc_tick_t ts = VLC_TICK_0 + VLC_TICK_FROM_MS(i % 1000);
+        vlc_tick_t date = vlc_clock_ConvertToSystem(clock, now, ts, 1.f);
+        assert(date != VLC_TICK_INVALID);
+        (void) date;
+    }
+}
+
+static void teardown_clock(void *data, unsigned threads)
+{
+    struct clock_data *d = data;
+
+    for (unsigned i = 0; i < threads; i++)
+        vlc_clock_Delete(d->slaves[i]);
+    vlc_clock_Delete(d->master);
+    vlc_clock_main_Delete(d->main);
+    free(d);
+}
+
+/*** Bitstream helpers ***/
+
+#define ES_SIZE (1 << 16)
+
+static void *setup_es(unsigned threads)
+{
+    (void) threads;
+
+    /* some NAL units, with emulation prevention bytes every 256 bytes */
+    uint8_t *es = malloc(ES_SIZE);
+    assert(es != NULL);
+    for (size_t i = 0; i < ES_SIZE; i++)
+        es[i] = (i * 7) | 0x10;
+    for (size_t i = 0; i + 3 < ES_SIZE; i += 256)
+        memcpy(&es[i], (i % 4096) ? "\x00\x00\x03" : "\x00\x00\x01", 3);
+    return es;
+}
+
+static void run_startcode(void *data, unsigned index, unsigned long n)
+{
+    const uint8_t *es = data, *end = es + ES_SIZE;
+    (void) index;
+
+    /* one operation per start code found */
+    for (unsigned long i = 0; i < n; i += ES_SIZE / 4096)
+        for (const uint8_t *p = es; (p = startcode_FindAnnexB(p, end)) != NULL;
+             p += 3);
+}
+
+static void run_ep3b(void *data, unsigned index, unsigned long n)
+{
+    uint8_t *es = data, *end = es + ES_SIZE;
+    (void) index;
+
+    /* one operation per 256 bytes of RBSP walked through, as read by bs_t */
+    for (unsigned long i = 0; i < n; i += ES_SIZE / 256)
+    {
+        unsigned prev = 0;
+        for (uint8_t *p = es; p < end; )
+            p = hxxx_ep3b_to_rbsp(p, end, &prev, 256);
+    }
+}
+
+static void teardown_es(void *data, unsigned threads)
+{
+    (void) threads;
+    free(data);
+}
+
+static const struct bench benches[] =
+{
+    { "block_Alloc+ChainGather", 1 << 18,
+      setup_none, run_block_gather, teardown_none },
+    { "block_FifoPut+Get", 1 << 20,
+      setup_fifo, run_fifo, teardown_fifo },
+    { "picture_pool_Get", 1 << 20,
+      setup_pool, run_pool, teardown_pool },
+    { "Copy420_SP_to_P 1080p", 1 << 8,
+      setup_copy, run_copy, teardown_copy },
+    { "vlc_dictionary_value_for_key", 1 << 20,
+      setup_dictionary, run_dictionary, teardown_dictionary },
+    { "var_GetInteger", 1 << 20,
+      setup_var, run_var_get, teardown_var },
+    { "var_InheritInteger", 1 << 19,
+      setup_var, run_var_inherit, teardown_var },
+    { "vlc_clock_ConvertToSystem", 1 << 20,
+      setup_clock, run_clock, teardown_clock },
+    { "startcode_FindAnnexB", 1 << 20,
+      setup_es, run_startcode, teardown_es },
+    { "hxxx_ep3b_to_rbsp", 1 << 19,
+      setup_es, run_ep3b, teardown_es },
+};
+
+struct worker
+{
+    const struct bench *bench;
+    void *data;
+    unsigned index;
+    unsigned long iterations;
+    vlc_sem_t *start;
+};
+
+static void *Worker(void *opaque)
+{
+    struct worker *w = opaque;
+
+    vlc_sem_wait(w->start);
+    w->bench->run(w->data, w->index, w->iterations);
+    return NULL;
+}
+
+static void run_bench(const struct bench *bench, unsigned threads,
+                      double scale)
+{
+    struct worker workers[MAX_THREADS];
+    vlc_thread_t ths[MAX_THREADS];
+    vlc_sem_t start;
+    unsigned long iterations = bench->iterations * scale;
+
+    if (iterations == 0)
+        iterations = 1;
+
+    vlc_sem_init(&start, 0);
+    void *data = bench->setup(threads);
+
+    for (unsigned i = 0; i < threads; i++)
+    {
+        workers[i] = (struct worker) {
+            .bench = bench, .data = data, .index = i,
+            .iterations = iterations, .start = &start,
+        };
+        int ret = vlc_clone(&ths[i], Worker, &workers[i],
+                            VLC_THREAD_PRIORITY_LOW);
+        assert(ret == 0);
+        (void) ret;
+    }
+
+    vlc_tick_t begin = vlc_tick_now();
+    for (unsigned i = 0; i < threads; i++)
+        vlc_sem_post(&start);
+    for (unsigned i = 0; i < threads; i++)
+        vlc_join(ths[i], NULL);
+    vlc_tick_t elapsed = vlc_tick_now() - begin;
+
+    bench->teardown(data, threads);
+
+    printf("%-32s %2u %12.1f\n", bench->name, threads,
+           (double)NS_FROM_VLC_TICK(elapsed) / iterations);
+    fflush(stdout);
+}
+
+int main(void)
+{
+    const char *env = getenv("BENCH_THREADS");
+    unsigned max_threads = env != NULL ? strtoul(env, NULL, 10)
+                                       : vlc_GetCPUCount();
+    max_threads = VLC_CLIP(max_threads, 1, MAX_THREADS);
+
+    env = getenv("BENCH_ITERATIONS");
+    double scale = env != NULL ? strtod(env, NULL) : 1.;
+    if (!(scale > 0.))
+        scale = 1.;
+
+    printf("%-32s %2s %12s\n", "# benchmark", "th", "ns/op");
+    for (size_t i = 0; i < ARRAY_SIZE(benches); i++)
+    {
+        const struct bench *bench = &benches[i];
+
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+            run_bench(bench, threads, scale);
+    }
+    return 0;
+}
@@ -29,6 +29,7 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_threads.h>
 
 static const char text[] =
     "This is a test!\n"
@@ -86,11 +87,154 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void *test_block_cache_release(void *data)
+{
+    block_ChainRelease(data);
+    return NULL;
+}
+
+static void test_block_cache(void)
+{
+    struct block_cache_stats before, after;
+    block_t *block;
+
+    block_CacheGetStats(&before);
+
+    /* Same thread allocation and release */
+    for (unsigned i = 0; i < 100; i++)
+    {
+        block = block_Alloc(1316);
+        assert(block != NULL);
+        assert(block->i_buffer == 1316);
+        memset(block->p_buffer, i, block->i_buffer);
+        block_Release(block);
+    }
+
+    block_CacheGetStats(&after);
+#ifndef OPTIMIZE_MEMORY
+    assert(after.hits + after.misses >= before.hits + before.misses + 100);
+    assert(after.hits >= before.hits + 99);
+#endif
+
+    /* Blocks released by another thread */
+    block_t *chain = NULL;
+    block_t **pp = &chain;
+
+    for (unsigned i = 0; i < 32; i++)
+    {
+        block = block_Alloc(188 * (i + 1));
+        assert(block != NULL);
+        block_ChainLastAppend(&pp, block);
+    }
+
+    vlc_thread_t th;
+    int val = vlc_clone(&th, test_block_cache_release, chain,
+                        VLC_THREAD_PRIORITY_LOW);
+    assert(val == 0);
+    vlc_join(th, NULL);
+
+    block_CacheGetStats(&before);
+#ifndef OPTIMIZE_MEMORY
+    assert(before.remote_frees >= after.remote_frees + 32);
+#endif
+
+    /* Reclaim remotely released blocks */
+    for (unsigned i = 0; i < 32; i++)
+    {
+        block = block_Alloc(188 * (i + 1));
+        assert(block != NULL);
+        block_Release(block);
+    }
+
+    /* Too large to be cached */
+    block = block_Alloc(1 << 20);
+    assert(block != NULL);
+    block_Release(block);
+
+    block_CacheGetStats(&after);
+#ifndef OPTIMIZE_MEMORY
+    assert(after.uncached > before.uncached);
+#endif
+}
+
+#define SPSC_COUNT 10000
+
+static void *test_spsc_fifo_produce(void *data)
+{
+    vlc_spsc_fifo_t *fifo = data;
+
+    for (unsigned i = 0; i < SPSC_COUNT; i += 2)
+    {
+        block_t *chain = NULL;
+        block_t **pp = &chain;
+
+        /* Alternate single blocks and chains of two */
+        for (unsigned j = i; j < i + 2; j++)
+        {
+            block_t *block = block_Alloc(1 + (j % 1500));
+            assert(block != NULL);
+            block->i_dts = j;
+            block_ChainLastAppend(&pp, block);
+            if ((i / 2) % 2)
+            {
+                vlc_spsc_fifo_Queue(fifo, chain);
+                chain = NULL;
+                pp = &chain;
+            }
+        }
+        vlc_spsc_fifo_Queue(fifo, chain);
+    }
+    return NULL;
+}
+
+static void test_spsc_fifo(void)
+{
+    vlc_spsc_fifo_t *fifo = vlc_spsc_fifo_New();
+    block_t *block;
+
+    assert(fifo != NULL);
+    assert(vlc_spsc_fifo_Dequeue(fifo) == NULL);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 0);
+
+    block = block_Alloc(42);
+    assert(block != NULL);
+    vlc_spsc_fifo_Queue(fifo, block);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 1);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 42);
+    assert(vlc_spsc_fifo_Get(fifo) == block);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 0);
+    block_Release(block);
+
+    vlc_thread_t th;
+    int val = vlc_clone(&th, test_spsc_fifo_produce, fifo,
+                        VLC_THREAD_PRIORITY_LOW);
+    assert(val == 0);
+
+    for (unsigned i = 0; i < SPSC_COUNT; i++)
+    {
+        block = vlc_spsc_fifo_Get(fifo);
+        assert(block->p_next == NULL);
+        assert(block->i_dts == (vlc_tick_t)i);
+        assert(block->i_buffer == 1 + (i % 1500));
+        block_Release(block);
+    }
+
+    vlc_join(th, NULL);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 0);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 0);
+
+    /* Left-over blocks are released with the queue */
+    vlc_spsc_fifo_Queue(fifo, block_Alloc(16));
+    vlc_spsc_fifo_Delete(fifo);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_cache();
+    test_spsc_fifo();
     return 0;
 }
 
@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * objects.c: Test and benchmark for object creation
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_variables.h>
+
+const char vlc_module_name[] = "test_objects";
+
+#define ITERATIONS 100000
+
+struct test_object
+{
+    struct vlc_object_t obj;
+    char payload[17]; /* not a multiple of the alignment */
+};
+
+/* Object churn, e.g. filters restarted or decoders switched */
+static void test_churn(vlc_object_t *root, bool with_vars)
+{
+    vlc_tick_t start = vlc_tick_now();
+
+    for (unsigned i = 0; i < ITERATIONS; i++)
+    {
+        struct test_object *o = vlc_object_create(root, sizeof (*o));
+        assert(o != NULL);
+        assert(vlc_object_parent(VLC_OBJECT(o)) == root);
+        assert(!strcmp(vlc_object_typename(VLC_OBJECT(o)), "generic"));
+        memset(o->payload, 0xA5, sizeof (o->payload));
+
+        if (with_vars)
+        {
+            var_Create(o, "test-int", VLC_VAR_INTEGER);
+            var_SetInteger(o, "test-int", i);
+            assert(var_GetInteger(o, "test-int") == i);
+        }
+        vlc_object_delete(o);
+    }
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    printf("%u objects %s variables in %"PRId64" us (%.1f ns each)\n",
+           ITERATIONS, with_vars ? "with" : "without", elapsed,
+           1000. * elapsed / ITERATIONS);
+}
+
+int main(void)
+{
+    vlc_object_t *root = (vlc_object_create)(NULL, sizeof (*root));
+    assert(root != NULL);
+
+    test_churn(root, false);
+    test_churn(root, true);
+
+    vlc_object_delete(root);
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * reactor.c: Test for the shared socket reactor
+ *****************************************************************************
+ * Copyright (C) 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+#ifndef _WIN32
+# include <poll.h>
+# include <unistd.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_network.h>
+#undef vlc_tick_sleep
+
+const char vlc_module_name[] = "test_reactor";
+
+#ifndef _WIN32
+struct reactor_data
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;
+    unsigned count;
+    int fd;
+};
+
+static void callback(void *opaque, int fd, short revents)
+{
+    struct reactor_data *data = opaque;
+    char c;
+
+    assert(fd == data->fd);
+    assert(revents & POLLIN);
+    assert(read(fd, &c, 1) == 1);
+
+    vlc_mutex_lock(&data->lock);
+    data->count++;
+    vlc_cond_signal(&data->wait);
+    vlc_mutex_unlock(&data->lock);
+}
+
+static void wait_count(struct reactor_data *data, unsigned count)
+{
+    vlc_mutex_lock(&data->lock);
+    while (data->count < count)
+        vlc_cond_wait(&data->wait, &data->lock);
+    assert(data->count == count);
+    vlc_mutex_unlock(&data->lock);
+}
+
+int main(void)
+{
+    struct reactor_data data[2];
+    int fds[2][2];
+    vlc_reactor_fd_t *rfd[2];
+
+    for (unsigned i = 0; i < 2; i++)
+    {
+        assert(vlc_pipe(fds[i]) == 0);
+        vlc_mutex_init(&data[i].lock);
+        vlc_cond_init(&data[i].wait);
+        data[i].count = 0;
+        data[i].fd = fds[i][0];
+        rfd[i] = vlc_reactor_Add(fds[i][0], POLLIN, callback, &data[i]);
+        assert(rfd[i] != NULL);
+    }
+
+    /* Each socket triggers its own callback */
+    assert(write(fds[1][1], "a", 1) == 1);
+    wait_count(&data[1], 1);
+    assert(write(fds[0][1], "b", 1) == 1);
+    wait_count(&data[0], 1);
+
+    /* One-shot: no callback until re-armed */
+    assert(write(fds[0][1], "c", 1) == 1);
+    vlc_tick_sleep(VLC_TICK_FROM_MS(50));
+    vlc_mutex_lock(&data[0].lock);
+    assert(data[0].count == 1);
+    vlc_mutex_unlock(&data[0].lock);
+    vlc_reactor_Arm(rfd[0], POLLIN);
+    wait_count(&data[0], 2);
+
+    /* Removed sockets are not polled anymore */
+    vlc_reactor_Remove(rfd[1]);
+    assert(write(fds[1][1], "d", 1) == 1);
+    vlc_reactor_Arm(rfd[0], POLLIN);
+    assert(write(fds[0][1], "e", 1) == 1);
+    wait_count(&data[0], 3);
+    vlc_mutex_lock(&data[1].lock);
+    assert(data[1].count == 1);
+    vlc_mutex_unlock(&data[1].lock);
+    vlc_reactor_Remove(rfd[0]);
+
+    /* The reactor restarts after all sockets were removed */
+    rfd[1] = vlc_reactor_Add(fds[1][0], POLLIN, callback, &data[1]);
+    assert(rfd[1] != NULL);
+    wait_count(&data[1], 2);
+    vlc_reactor_Remove(rfd[1]);
+
+    for (unsigned i = 0; i < 2; i++)
+    {
+        vlc_close(fds[i][1]);
+        vlc_close(fds[i][0]);
+    }
+    return 0;
+}
+#else
+int main(void)
+{
+    return 77;
+}
+#endif
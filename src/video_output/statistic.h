@@ -23,19 +23,31 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <stdatomic.h>
+# include <vlc_input_item.h>
 
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
- * is a non-issue. */
+ * is a non-issue. The pacing histograms are not synchronized with the
+ * counters either, they are only meant to be sampled over time. */
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+
+    /* Frame pacing histograms, see INPUT_STATS_PACING_BUCKETS */
+    atomic_uint late[INPUT_STATS_PACING_BUCKETS];
+    atomic_uint prepare[INPUT_STATS_PACING_BUCKETS];
+    atomic_uint display[INPUT_STATS_PACING_BUCKETS];
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    for (unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++) {
+        atomic_init(&stat->late[i], 0);
+        atomic_init(&stat->prepare[i], 0);
+        atomic_init(&stat->display[i], 0);
+    }
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -45,11 +57,21 @@ static inline void vout_statistic_Clean(vout_statistic_t *stat)
 
 static inline void vout_statistic_GetReset(vout_statistic_t *stat,
                                            unsigned *restrict displayed,
-                                           unsigned *restrict lost)
+                                           unsigned *restrict lost,
+                                           input_pacing_stats_t *restrict pacing)
 {
     *displayed = atomic_exchange_explicit(&stat->displayed, 0,
                                           memory_order_relaxed);
     *lost = atomic_exchange_explicit(&stat->lost, 0, memory_order_relaxed);
+
+    for (unsigned i = 0; i < INPUT_STATS_PACING_BUCKETS; i++) {
+        pacing->i_late[i] = atomic_exchange_explicit(&stat->late[i], 0,
+                                                     memory_order_relaxed);
+        pacing->i_prepare[i] = atomic_exchange_explicit(&stat->prepare[i], 0,
+                                                        memory_order_relaxed);
+        pacing->i_display[i] = atomic_exchange_explicit(&stat->display[i], 0,
+                                                        memory_order_relaxed);
+    }
 }
 
 static inline void vout_statistic_AddDisplayed(vout_statistic_t *stat,
@@ -64,4 +86,18 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add_explicit(&stat->lost, lost, memory_order_relaxed);
 }
 
+/* Counts a duration (clipped to zero) in its histogram bucket */
+static inline void vout_statistic_AddPacing(atomic_uint *histogram,
+                                            vlc_tick_t duration)
+{
+    unsigned bucket = 0;
+    int64_t ms = duration > 0 ? MS_FROM_VLC_TICK(duration) : 0;
+
+    while (ms > 0 && bucket < INPUT_STATS_PACING_BUCKETS - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&histogram[bucket], 1, memory_order_relaxed);
+}
+
 #endif
@@ -50,6 +50,7 @@
 #include <vlc_image.h>
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
+#include <vlc_tracer.h>
 
 #include <libvlc.h>
 #include "vout_internal.h"
@@ -217,10 +218,11 @@ static void vout_UpdateWindowSizeLocked(vout_thread_t *vout)
 
 /* */
 void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
-                            unsigned *restrict lost)
+                            unsigned *restrict lost,
+                            input_pacing_stats_t *restrict pacing)
 {
     assert(!vout->p->dummy);
-    vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
+    vout_statistic_GetReset( &vout->p->statistic, displayed, lost, pacing );
 }
 
 bool vout_IsEmpty(vout_thread_t *vout)
@@ -416,6 +418,23 @@ void vout_ChangeWindowState(vout_thread_t *vout, unsigned st)
     vlc_mutex_unlock(&vout->p->window_lock);
 }
 
+/* Releases the picture rendered ahead, the display lock must be held */
+static void vout_ReleasePrepared(vout_thread_sys_t *sys)
+{
+    vlc_mutex_assert(&sys->display_lock);
+
+    if (sys->prepared.source == NULL)
+        return;
+
+    picture_Release(sys->prepared.source);
+    picture_Release(sys->prepared.picture);
+    if (sys->prepared.subpic != NULL)
+        subpicture_Delete(sys->prepared.subpic);
+    sys->prepared.source  = NULL;
+    sys->prepared.picture = NULL;
+    sys->prepared.subpic  = NULL;
+}
+
 void vout_ChangeDisplaySize(vout_thread_t *vout,
                             unsigned width, unsigned height)
 {
@@ -425,6 +444,7 @@ void vout_ChangeDisplaySize(vout_thread_t *vout,
 
     /* DO NOT call this outside the vout window callbacks */
     vlc_mutex_lock(&sys->display_lock);
+    vout_ReleasePrepared(sys);
     if (sys->display != NULL)
         vout_display_SetSize(sys->display, width, height);
     vlc_mutex_unlock(&sys->display_lock);
@@ -442,6 +462,7 @@ void vout_ChangeDisplayFilled(vout_thread_t *vout, bool is_filled)
     vlc_mutex_lock(&sys->display_lock);
     vlc_mutex_unlock(&sys->window_lock);
 
+    vout_ReleasePrepared(sys);
     if (sys->display != NULL)
         vout_SetDisplayFilled(sys->display, is_filled);
     vlc_mutex_unlock(&sys->display_lock);
@@ -476,6 +497,7 @@ void vout_ChangeZoom(vout_thread_t *vout, unsigned num, unsigned den)
     vlc_mutex_lock(&sys->display_lock);
     vlc_mutex_unlock(&sys->window_lock);
 
+    vout_ReleasePrepared(sys);
     if (sys->display != NULL)
         vout_SetDisplayZoom(sys->display, num, den);
     vlc_mutex_unlock(&sys->display_lock);
@@ -496,6 +518,7 @@ void vout_ChangeDisplayAspectRatio(vout_thread_t *vout,
     vlc_mutex_lock(&sys->display_lock);
     vlc_mutex_unlock(&sys->window_lock);
 
+    vout_ReleasePrepared(sys);
     if (sys->display != NULL)
         vout_SetDisplayAspect(sys->display, dar_num, dar_den);
     vlc_mutex_unlock(&sys->display_lock);
@@ -519,6 +542,7 @@ void vout_ChangeCropRatio(vout_thread_t *vout, unsigned num, unsigned den)
     vlc_mutex_lock(&sys->display_lock);
     vlc_mutex_unlock(&sys->window_lock);
 
+    vout_ReleasePrepared(sys);
     if (sys->display != NULL)
         vout_SetDisplayCrop(sys->display, num, den, 0, 0, 0, 0);
     vlc_mutex_unlock(&sys->display_lock);
@@ -551,6 +575,7 @@ void vout_ChangeCropWindow(vout_thread_t *vout,
     vlc_mutex_lock(&sys->display_lock);
     vlc_mutex_unlock(&sys->window_lock);
 
+    vout_ReleasePrepared(sys);
     if (sys->display != NULL)
         vout_SetDisplayCrop(sys->display, 0, 0, x, y, width, height);
     vlc_mutex_unlock(&sys->display_lock);
@@ -583,6 +608,7 @@ void vout_ChangeCropBorder(vout_thread_t *vout,
     vlc_mutex_lock(&sys->display_lock);
     vlc_mutex_unlock(&sys->window_lock);
 
+    vout_ReleasePrepared(sys);
     if (sys->display != NULL)
         vout_SetDisplayCrop(sys->display, 0, 0,
                             left, top, -right, -bottom);
@@ -1030,13 +1056,29 @@ static picture_t *ConvertRGB32AndBlend(vout_thread_t *vout, picture_t *pic,
     return NULL;
 }
 
-static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
+/* The filters changed, the picture rendered ahead is obsolete */
+static void ThreadReleasePrepared(vout_thread_t *vout)
 {
-    vout_thread_sys_t *sys = vout->p;
+    vlc_mutex_lock(&vout->p->display_lock);
+    vout_ReleasePrepared(vout->p);
+    vlc_mutex_unlock(&vout->p->display_lock);
+}
 
-    picture_t *torender = picture_Hold(sys->displayed.current);
+/**
+ * Renders a picture for the display: runs the interactive filters, renders
+ * and blends the subpictures, and converts it to the display format.
+ *
+ * On success, returns with the display lock held.
+ * \param ahead the picture is rendered before its turn: no snapshot is taken
+ */
+static int ThreadRenderPicture(vout_thread_t *vout, picture_t *source,
+                               bool ahead, bool *is_forced,
+                               picture_t **todisplay_ptr,
+                               subpicture_t **subpic_ptr)
+{
+    vout_thread_sys_t *sys = vout->p;
 
-    vout_chrono_Start(&sys->render);
+    picture_t *torender = picture_Hold(source);
 
     vlc_mutex_lock(&sys->filter.lock);
     picture_t *filtered = filter_chain_VideoFilter(sys->filter.chain_interactive, torender);
@@ -1045,7 +1087,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     if (!filtered)
         return VLC_EGENERIC;
 
-    if (filtered->date != sys->displayed.current->date)
+    if (filtered->date != source->date)
         msg_Warn(vout, "Unsupported timestamp modifications done by chain_interactive");
 
     vout_display_t *vd = sys->display;
@@ -1055,7 +1097,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     /*
      * Get the subpicture to be displayed
      */
-    const bool do_snapshot = vout_snapshot_IsRequested(sys->snapshot);
+    const bool do_snapshot = !ahead && vout_snapshot_IsRequested(sys->snapshot);
     vlc_tick_t system_now = vlc_tick_now();
     vlc_tick_t render_subtitle_date;
     if (sys->pause.is_on)
@@ -1072,7 +1114,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         if (unlikely(render_subtitle_date == INT64_MAX))
         {
             render_subtitle_date = system_now;
-            is_forced = true;
+            *is_forced = true;
         }
     }
 
@@ -1198,10 +1240,31 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         return VLC_EGENERIC;
     }
 
-    if (!do_dr_spu && sys->spu_blend != NULL && subpic != NULL)
-        picture_BlendSubpicture(todisplay, sys->spu_blend, subpic);
+    if (!do_dr_spu && subpic != NULL)
+    {
+        if (sys->spu_blend != NULL)
+            picture_BlendSubpicture(todisplay, sys->spu_blend, subpic);
+        subpicture_Delete(subpic);
+        subpic = NULL;
+    }
 
-    system_now = vlc_tick_now();
+    *todisplay_ptr = todisplay;
+    *subpic_ptr = subpic;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Prepares the display, waits for the picture date and displays it.
+ *
+ * The display lock must be held, it is released on return.
+ */
+static void ThreadPresentPicture(vout_thread_t *vout, picture_t *todisplay,
+                                 subpicture_t *subpic, bool is_forced)
+{
+    vout_thread_sys_t *sys = vout->p;
+    vout_display_t *vd = sys->display;
+
+    vlc_tick_t system_now = vlc_tick_now();
     const vlc_tick_t pts = todisplay->date;
     vlc_tick_t system_pts = is_forced ? system_now :
         vlc_clock_ConvertToSystem(sys->clock, system_now, pts, sys->rate);
@@ -1217,8 +1280,16 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     const unsigned frame_rate = todisplay->format.i_frame_rate;
     const unsigned frame_rate_base = todisplay->format.i_frame_rate_base;
 
+    struct vlc_tracer *tracer = vlc_object_get_tracer(vout);
+
     if (vd->prepare != NULL)
-        vd->prepare(vd, todisplay, do_dr_spu ? subpic : NULL, system_pts);
+    {
+        vlc_tracer_Begin(tracer, "vout", "prepare", vout, pts);
+        vd->prepare(vd, todisplay, subpic, system_pts);
+        vlc_tracer_End(tracer, "vout", "prepare", vout, pts);
+        vout_statistic_AddPacing(sys->statistic.prepare,
+                                 vlc_tick_now() - system_now);
+    }
 
     vout_chrono_Stop(&sys->render);
 #if 0
@@ -1233,6 +1304,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     system_now = vlc_tick_now();
     if (!is_forced)
     {
+        vout_statistic_AddPacing(sys->statistic.late, system_now - system_pts);
         if (unlikely(system_now > system_pts))
         {
             /* vd->prepare took too much time. Tell the clock that the pts was
@@ -1260,17 +1332,86 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
                           frame_rate, frame_rate_base);
 
     /* Display the direct buffer returned by vout_RenderPicture */
+    system_now = vlc_tick_now();
+    vlc_tracer_Begin(tracer, "vout", "display", vout, pts);
     vout_display_Display(vd, todisplay);
+    vlc_tracer_End(tracer, "vout", "display", vout, pts);
+    vout_statistic_AddPacing(sys->statistic.display,
+                             vlc_tick_now() - system_now);
     vlc_mutex_unlock(&sys->display_lock);
 
     if (subpic)
         subpicture_Delete(subpic);
 
     vout_statistic_AddDisplayed(&sys->statistic, 1);
+}
+
+static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *todisplay;
+    subpicture_t *subpic;
+
+    vout_chrono_Start(&sys->render);
 
+    vlc_mutex_lock(&sys->display_lock);
+    if (sys->prepared.source == sys->displayed.current &&
+        !vout_snapshot_IsRequested(sys->snapshot))
+    {
+        /* The picture was rendered ahead, only the display work is left */
+        todisplay = sys->prepared.picture;
+        subpic = sys->prepared.subpic;
+        is_forced |= sys->prepared.is_forced;
+
+        picture_Release(sys->prepared.source);
+        sys->prepared.source  = NULL;
+        sys->prepared.picture = NULL;
+        sys->prepared.subpic  = NULL;
+    }
+    else
+    {
+        vout_ReleasePrepared(sys);
+        vlc_mutex_unlock(&sys->display_lock);
+
+        if (ThreadRenderPicture(vout, sys->displayed.current, false,
+                                &is_forced, &todisplay, &subpic))
+            return VLC_EGENERIC;
+    }
+
+    ThreadPresentPicture(vout, todisplay, subpic, is_forced);
     return VLC_SUCCESS;
 }
 
+/**
+ * Renders the next picture while the current one is on screen, so that only
+ * the display work is left when the next one is due.
+ */
+static void ThreadRenderAhead(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *next = sys->displayed.next;
+
+    vlc_mutex_lock(&sys->display_lock);
+    const bool done = sys->prepared.source == next;
+    vlc_mutex_unlock(&sys->display_lock);
+    if (done)
+        return;
+
+    picture_t *todisplay;
+    subpicture_t *subpic;
+    bool is_forced = false;
+
+    if (ThreadRenderPicture(vout, next, true, &is_forced, &todisplay, &subpic))
+        return;
+
+    vout_ReleasePrepared(sys);
+    sys->prepared.source    = picture_Hold(next);
+    sys->prepared.picture   = todisplay;
+    sys->prepared.subpic    = subpic;
+    sys->prepared.is_forced = is_forced;
+    vlc_mutex_unlock(&sys->display_lock);
+}
+
 static int ThreadDisplayPicture(vout_thread_t *vout, vlc_tick_t *deadline)
 {
     vout_thread_sys_t *sys = vout->p;
@@ -1338,6 +1479,8 @@ static int ThreadDisplayPicture(vout_thread_t *vout, vlc_tick_t *deadline)
     }
 
     if (!first && !refresh && !drop_next_frame) {
+        if (sys->prepared.enabled && !paused && sys->displayed.next != NULL)
+            ThreadRenderAhead(vout);
         return VLC_EGENERIC;
     }
 
@@ -1372,6 +1515,7 @@ void vout_ChangePause(vout_thread_t *vout, bool is_paused, vlc_tick_t date)
     }
     vout->p->pause.is_on = is_paused;
     vout->p->pause.date  = date;
+    ThreadReleasePrepared(vout);
     vout_control_Release(&vout->p->control);
 
     vlc_mutex_lock(&vout->p->window_lock);
@@ -1406,6 +1550,7 @@ static void vout_FlushUnlocked(vout_thread_t *vout, bool below,
 
     assert(sys->display != NULL);
     vlc_mutex_lock(&sys->display_lock);
+    vout_ReleasePrepared(sys);
     vout_FilterFlush(sys->display);
     vlc_mutex_unlock(&sys->display_lock);
 
@@ -1636,6 +1781,10 @@ static int vout_Start(vout_thread_t *vout, vlc_video_context *vctx, const vout_c
     sys->spu_blend_chroma        = 0;
     sys->spu_blend               = NULL;
 
+    sys->prepared.source         = NULL;
+    sys->prepared.picture        = NULL;
+    sys->prepared.subpic         = NULL;
+
     video_format_Print(VLC_OBJECT(vout), "original format", &sys->original);
     return VLC_SUCCESS;
 error:
@@ -1665,15 +1814,18 @@ static void ThreadControl(vout_thread_t *vout, vout_control_cmd_t cmd)
     switch(cmd.type) {
     case VOUT_CONTROL_CHANGE_FILTERS:
         ThreadChangeFilters(vout, cmd.string, NULL, false);
+        ThreadReleasePrepared(vout);
         break;
     case VOUT_CONTROL_CHANGE_INTERLACE:
         ThreadChangeFilters(vout, NULL, &cmd.boolean, false);
+        ThreadReleasePrepared(vout);
         break;
     case VOUT_CONTROL_MOUSE_STATE:
         ThreadProcessMouseState(vout, &cmd.mouse);
         break;
     case VOUT_CONTROL_VIEWPOINT:
         vlc_mutex_lock(&vout->p->display_lock);
+        vout_ReleasePrepared(vout->p);
         vout_SetDisplayViewpoint(vout->p->display, &cmd.viewpoint);
         vlc_mutex_unlock(&vout->p->display_lock);
         break;
@@ -1940,6 +2092,7 @@ vout_thread_t *vout_Create(vlc_object_t *object)
     vout_InitInterlacingSupport(vout);
 
     sys->is_late_dropped = var_InheritBool(vout, "drop-late-frames");
+    sys->prepared.enabled = var_InheritBool(vout, "video-prepare-ahead");
 
     vlc_mutex_init(&sys->filter.lock);
 
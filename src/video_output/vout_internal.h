@@ -153,6 +153,15 @@ struct vout_thread_sys_t
     /* */
     bool            is_late_dropped;
 
+    /* Next picture, rendered ahead of its display date */
+    struct {
+        bool            enabled;
+        picture_t       *source;   /**< displayed picture it was rendered from */
+        picture_t       *picture;  /**< picture to display */
+        subpicture_t    *subpic;   /**< subpicture blended by the display */
+        bool            is_forced;
+    } prepared;
+
     /* Video filter2 chain */
     struct {
         vlc_mutex_t     lock;
@@ -327,7 +336,7 @@ void vout_MouseState(vout_thread_t *, const vlc_mouse_t *);
  * This function will return and reset internal statistics.
  */
 void vout_GetResetStatistic( vout_thread_t *p_vout, unsigned *pi_displayed,
-                             unsigned *pi_lost );
+                             unsigned *pi_lost, input_pacing_stats_t *p_pacing );
 
 /**
  * This function will force to display the next picture while paused
@@ -58,6 +58,7 @@ typedef struct {
     vlc_tick_t stop;  /* set to subpicture at rendering time */
     bool is_late;
     enum vlc_vout_order channel_order;
+    uint64_t serial; /* unique per subpicture, for the render cache */
 } spu_render_entry_t;
 
 typedef struct VLC_VECTOR(spu_render_entry_t) spu_render_vector;
@@ -73,6 +74,7 @@ struct spu_channel {
 
 typedef struct VLC_VECTOR(struct spu_channel) spu_channel_vector;
 typedef struct VLC_VECTOR(subpicture_t *) spu_prerender_vector;
+typedef struct VLC_VECTOR(uint64_t) spu_serial_vector;
 #define SPU_CHROMALIST_COUNT 8
 
 struct spu_private_t {
@@ -126,6 +128,20 @@ struct spu_private_t {
         vlc_fourcc_t    chroma_list[SPU_CHROMALIST_COUNT+1];
     } prerender;
 
+    /* Last rendered output, reused as long as nothing is damaged */
+    struct
+    {
+        subpicture_t      *output;
+        spu_serial_vector serials;        /**< rendered subpictures, in order */
+        video_format_t    fmtsrc;
+        video_format_t    fmtdst;
+        vlc_fourcc_t      chroma_list[SPU_CHROMALIST_COUNT+1];
+        bool              external_scale;
+        vlc_tick_t        subtitle_expiry;  /**< a subtitle fade starts */
+        vlc_tick_t        system_expiry;    /**< an OSD fade starts */
+    } cache;
+    uint64_t            next_serial;
+
     /* */
     vlc_tick_t          last_sort_date;
     vout_thread_t       *vout;
@@ -147,7 +163,8 @@ static void spu_channel_Init(struct spu_channel *channel, size_t id,
 }
 
 static int spu_channel_Push(struct spu_channel *channel, subpicture_t *subpic,
-                            vlc_tick_t orgstart, vlc_tick_t orgstop)
+                            vlc_tick_t orgstart, vlc_tick_t orgstop,
+                            uint64_t serial)
 {
     const spu_render_entry_t entry = {
         .subpic = subpic,
@@ -155,6 +172,7 @@ static int spu_channel_Push(struct spu_channel *channel, subpicture_t *subpic,
         .orgstop = orgstop,
         .start = subpic->i_start,
         .stop = subpic->i_stop,
+        .serial = serial,
     };
     return vlc_vector_push(&channel->entries, entry) ? VLC_SUCCESS : VLC_EGENERIC;
 }
@@ -1273,6 +1291,148 @@ static subpicture_t *SpuRenderSubpictures(spu_t *spu,
     return output;
 }
 
+/*****************************************************************************
+ * Render cache
+ *****************************************************************************
+ * The output of SpuRenderSubpictures() only depends on the subpictures, the
+ * formats and the spu settings, except while a subpicture fades out. It is
+ * kept until one of them changes, so that idle subtitles are neither placed
+ * nor converted again for every displayed picture.
+ *****************************************************************************/
+static subpicture_t *SpuDuplicateSubpicture(const subpicture_t *src)
+{
+    subpicture_t *dst = subpicture_New(NULL);
+    if (!dst)
+        return NULL;
+    dst->i_order = src->i_order;
+    dst->i_original_picture_width  = src->i_original_picture_width;
+    dst->i_original_picture_height = src->i_original_picture_height;
+
+    subpicture_region_t **last_ptr = &dst->p_region;
+    for (const subpicture_region_t *r = src->p_region; r != NULL; r = r->p_next) {
+        subpicture_region_t *region = subpicture_region_NewInternal(&r->fmt);
+        if (!region) {
+            subpicture_Delete(dst);
+            return NULL;
+        }
+        region->i_x       = r->i_x;
+        region->i_y       = r->i_y;
+        region->i_align   = r->i_align;
+        region->i_alpha   = r->i_alpha;
+        region->zoom_h    = r->zoom_h;
+        region->zoom_v    = r->zoom_v;
+        region->p_picture = picture_Hold(r->p_picture);
+
+        *last_ptr = region;
+        last_ptr = &region->p_next;
+    }
+    return dst;
+}
+
+static void spu_CacheInvalidate(spu_private_t *sys)
+{
+    if (sys->cache.output)
+        subpicture_Delete(sys->cache.output);
+    sys->cache.output = NULL;
+    vlc_vector_clear(&sys->cache.serials);
+}
+
+static bool spu_CacheMatch(const spu_private_t *sys,
+                           size_t count, const spu_render_entry_t *entries,
+                           const vlc_fourcc_t *chroma_list,
+                           const video_format_t *fmt_dst,
+                           const video_format_t *fmt_src,
+                           vlc_tick_t system_now,
+                           vlc_tick_t render_subtitle_date,
+                           bool external_scale)
+{
+    if (!sys->cache.output || sys->cache.serials.size != count)
+        return false;
+
+    if (system_now >= sys->cache.system_expiry ||
+        render_subtitle_date >= sys->cache.subtitle_expiry)
+        return false;
+
+    if (external_scale != sys->cache.external_scale ||
+        !video_format_IsSimilar(fmt_dst, &sys->cache.fmtdst) ||
+        !video_format_IsSimilar(fmt_src, &sys->cache.fmtsrc))
+        return false;
+
+    for (size_t i = 0; i <= SPU_CHROMALIST_COUNT; i++) {
+        if (chroma_list[i] != sys->cache.chroma_list[i])
+            return false;
+        if (!chroma_list[i])
+            break;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        if (entries[i].serial != sys->cache.serials.data[i])
+            return false;
+    return true;
+}
+
+static void spu_CacheStore(spu_private_t *sys, const subpicture_t *output,
+                           size_t count, const spu_render_entry_t *entries,
+                           const vlc_fourcc_t *chroma_list,
+                           const video_format_t *fmt_dst,
+                           const video_format_t *fmt_src,
+                           vlc_tick_t system_now,
+                           vlc_tick_t render_subtitle_date,
+                           bool external_scale)
+{
+    spu_CacheInvalidate(sys);
+
+    sys->cache.subtitle_expiry = INT64_MAX;
+    sys->cache.system_expiry = INT64_MAX;
+    for (size_t i = 0; i < count; i++) {
+        const subpicture_t *subpic = entries[i].subpic;
+        if (!subpic->b_fade)
+            continue;
+
+        /* Same as SpuRenderRegion(), the alpha changes until the end */
+        vlc_tick_t fade_start = subpic->i_start + 3 * (subpic->i_stop - subpic->i_start) / 4;
+        if (fade_start >= subpic->i_stop)
+            continue;
+
+        vlc_tick_t *expiry = subpic->b_subtitle ? &sys->cache.subtitle_expiry
+                                                : &sys->cache.system_expiry;
+        vlc_tick_t date = subpic->b_subtitle ? render_subtitle_date : system_now;
+        if (fade_start <= date)
+            return; /* Fading right now */
+        if (fade_start < *expiry)
+            *expiry = fade_start;
+    }
+
+    if (!vlc_vector_reserve(&sys->cache.serials, count))
+        return;
+    for (size_t i = 0; i < count; i++)
+        vlc_vector_push(&sys->cache.serials, entries[i].serial);
+
+    sys->cache.output = SpuDuplicateSubpicture(output);
+    if (!sys->cache.output) {
+        vlc_vector_clear(&sys->cache.serials);
+        return;
+    }
+
+    if (!video_format_IsSimilar(fmt_dst, &sys->cache.fmtdst))
+    {
+        video_format_Clean(&sys->cache.fmtdst);
+        video_format_Copy(&sys->cache.fmtdst, fmt_dst);
+    }
+    if (!video_format_IsSimilar(fmt_src, &sys->cache.fmtsrc))
+    {
+        video_format_Clean(&sys->cache.fmtsrc);
+        video_format_Copy(&sys->cache.fmtsrc, fmt_src);
+    }
+
+    for (size_t i = 0; i <= SPU_CHROMALIST_COUNT; i++) {
+        sys->cache.chroma_list[i] = i < SPU_CHROMALIST_COUNT ? chroma_list[i] : 0;
+        if (!chroma_list[i])
+            break;
+    }
+    sys->cache.external_scale = external_scale;
+}
+
 /*****************************************************************************
  * Object variables callbacks
  *****************************************************************************/
@@ -1286,6 +1446,8 @@ static void UpdateSPU(spu_t *spu, const vlc_spu_highlight_t *hl)
 
     vlc_mutex_assert(&sys->lock);
 
+    spu_CacheInvalidate(sys);
+
     sys->palette.i_entries = 0;
     sys->force_crop = false;
 
@@ -1619,6 +1781,11 @@ static void spu_Cleanup(spu_t *spu)
     vlc_vector_clear(&sys->prerender.vector);
     video_format_Clean(&sys->prerender.fmtdst);
     video_format_Clean(&sys->prerender.fmtsrc);
+
+    spu_CacheInvalidate(sys);
+    vlc_vector_destroy(&sys->cache.serials);
+    video_format_Clean(&sys->cache.fmtdst);
+    video_format_Clean(&sys->cache.fmtsrc);
 }
 
 /**
@@ -1692,6 +1859,12 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     sys->prerender.chroma_list[0] = 0;
     sys->prerender.chroma_list[SPU_CHROMALIST_COUNT] = 0;
 
+    sys->cache.output = NULL;
+    vlc_vector_init(&sys->cache.serials);
+    video_format_Init(&sys->cache.fmtdst, 0);
+    video_format_Init(&sys->cache.fmtsrc, 0);
+    sys->next_serial = 0;
+
     /* Load text and scale module */
     sys->text = SpuRenderCreateAndLoadText(spu);
     vlc_mutex_init(&sys->textlock);
@@ -1883,7 +2056,8 @@ void spu_PutSubpicture(spu_t *spu, subpicture_t *subpic)
         subpic->i_stop = times[1];
     }
 
-    if (spu_channel_Push(channel, subpic, orgstart, orgstop))
+    if (spu_channel_Push(channel, subpic, orgstart, orgstop,
+                         sys->next_serial++))
     {
         vlc_mutex_unlock(&sys->lock);
         msg_Err(spu, "subpicture heap full");
@@ -1964,11 +2138,13 @@ subpicture_t *spu_Render(spu_t *spu,
                              ignore_osd, &subpicture_count);
     if (!subpicture_array)
     {
+        spu_CacheInvalidate(sys);
         vlc_mutex_unlock(&sys->lock);
         return NULL;
     }
 
     /* Updates the subpictures */
+    bool is_damaged = false;
     for (size_t i = 0; i < subpicture_count; i++) {
         spu_render_entry_t *entry = &subpicture_array[i];
         subpicture_t *subpic = entry->subpic;
@@ -1982,24 +2158,53 @@ subpicture_t *spu_Render(spu_t *spu,
         if (!subpic->updater.pf_validate)
             continue;
 
-        subpicture_Update(subpic,
-                          fmt_src, fmt_dst,
-                          subpic->b_subtitle ? render_subtitle_date : system_now);
+        if (subpicture_UpdateInternal(subpic, fmt_src, fmt_dst,
+                                      subpic->b_subtitle ? render_subtitle_date
+                                                         : system_now))
+            is_damaged = true;
     }
 
     /* Now order the subpicture array
      * XXX The order is *really* important for overlap subtitles positionning */
     qsort(subpicture_array, subpicture_count, sizeof(*subpicture_array), SpuRenderCmp);
 
+    /* Reuse the previous output if nothing changed since */
+    subpicture_t *render;
+    if (!is_damaged &&
+        spu_CacheMatch(sys, subpicture_count, subpicture_array, chroma_list,
+                       fmt_dst, fmt_src, system_now, render_subtitle_date,
+                       external_scale))
+    {
+        render = SpuDuplicateSubpicture(sys->cache.output);
+        free(subpicture_array);
+        vlc_mutex_unlock(&sys->lock);
+        return render;
+    }
+
+    /* Subtitles are moved to absolute positions on their first rendering,
+     * the next one may place them differently */
+    bool is_cacheable = true;
+    for (size_t i = 0; i < subpicture_count; i++) {
+        const subpicture_t *subpic = subpicture_array[i].subpic;
+        if (subpic->b_subtitle && !subpic->b_absolute)
+            is_cacheable = false;
+    }
+
     /* Render the subpictures */
-    subpicture_t *render = SpuRenderSubpictures(spu,
-                                                subpicture_count, subpicture_array,
-                                                chroma_list,
-                                                fmt_dst,
-                                                fmt_src,
-                                                system_now,
-                                                render_subtitle_date,
-                                                external_scale);
+    render = SpuRenderSubpictures(spu,
+                                  subpicture_count, subpicture_array,
+                                  chroma_list,
+                                  fmt_dst,
+                                  fmt_src,
+                                  system_now,
+                                  render_subtitle_date,
+                                  external_scale);
+    if (render && is_cacheable)
+        spu_CacheStore(sys, render, subpicture_count, subpicture_array,
+                       chroma_list, fmt_dst, fmt_src, system_now,
+                       render_subtitle_date, external_scale);
+    else
+        spu_CacheInvalidate(sys);
     free(subpicture_array);
     vlc_mutex_unlock(&sys->lock);
 
@@ -2117,6 +2322,7 @@ void spu_ChangeChannelOrderMargin(spu_t *spu, enum vlc_vout_order order,
     spu_private_t *sys = spu->p;
 
     vlc_mutex_lock(&sys->lock);
+    spu_CacheInvalidate(sys);
     switch (order)
     {
         case VLC_VOUT_ORDER_PRIMARY:
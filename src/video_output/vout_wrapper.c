@@ -82,8 +82,10 @@ vout_display_t *vout_OpenWrapper(vout_thread_t *vout,
 
     sys->display_pool = NULL;
 
-    const unsigned private_picture  = 4; /* XXX 3 for filter, 1 for SPU */
-    const unsigned kept_picture     = 1; /* last displayed picture */
+    /* XXX 3 for filter, 1 for SPU, and 1 more to render ahead */
+    const unsigned private_picture  = 4 + sys->prepared.enabled;
+    /* last displayed picture, and the one rendered ahead */
+    const unsigned kept_picture     = 1 + sys->prepared.enabled;
     const unsigned reserved_picture = DISPLAY_PICTURE_COUNT +
                                       private_picture +
                                       kept_picture;
@@ -31,6 +31,16 @@
 
 #include "../modules/packetizer/startcode_helper.h"
 
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+static bool cpu_sse2( void ) { return vlc_CPU_SSE2(); }
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+static bool cpu_avx2( void ) { return vlc_CPU_AVX2(); }
+#endif
+#ifdef __ARM_NEON
+static bool cpu_neon( void ) { return vlc_CPU_ARM_NEON(); }
+#endif
+
 struct results_s
 {
     size_t offset;
@@ -64,32 +74,74 @@ static int check_set( const uint8_t *p_set, const uint8_t *p_end,
     return 0;
 }
 
+static const struct
+{
+    const char *psz_name;
+    const uint8_t *(*pf_find)(const uint8_t *, const uint8_t *);
+    bool (*pf_usable)(void);
+} annexb_finders[] = {
+    { "bits", startcode_FindAnnexB_Bits, NULL },
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    { "sse2", startcode_FindAnnexB_SSE2, cpu_sse2 },
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    { "avx2", startcode_FindAnnexB_AVX2, cpu_avx2 },
+#endif
+#ifdef __ARM_NEON
+    { "neon", startcode_FindAnnexB_NEON, cpu_neon },
+#endif
+};
+
 static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
                             const struct results_s *p_results, size_t i_results,
                             ssize_t i_results_offset )
 {
-    int i_ret;
-
-    printf("checking bits code:\n");
-    i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                       startcode_FindAnnexB_Bits );
-    if( i_ret != 0 )
-        return i_ret;
-
-    /* Perform same tests on simd optimized code */
-    if( startcode_FindAnnexB_Bits != startcode_FindAnnexB )
+    for( size_t i = 0; i < ARRAY_SIZE(annexb_finders); i++ )
     {
-        printf("checking asm:\n");
-        i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                           startcode_FindAnnexB );
+        if( annexb_finders[i].pf_usable && !annexb_finders[i].pf_usable() )
+        {
+            printf("%s not supported, skipping test:\n",
+                   annexb_finders[i].psz_name);
+            continue;
+        }
+        printf("checking %s code:\n", annexb_finders[i].psz_name);
+        int i_ret = check_set( p_set, p_end, p_results, i_results,
+                               i_results_offset, annexb_finders[i].pf_find );
         if( i_ret != 0 )
             return i_ret;
     }
-    else printf("asm not built in, skipping test:\n");
 
     return 0;
 }
 
+/* Scans a large buffer with a sparse set of startcodes */
+static void bench_annexb( void )
+{
+    const size_t i_data = 8 << 20;
+    uint8_t *p_data = malloc( i_data );
+    if( p_data == NULL )
+        return;
+    for( size_t i = 0; i < i_data; i++ )
+        p_data[i] = (i % 7) ? 0x42 : 0x00;
+    for( size_t i = 0; i + 3 < i_data; i += 65536 )
+        memcpy( &p_data[i], "\x00\x00\x01", 3 );
+
+    for( size_t i = 0; i < ARRAY_SIZE(annexb_finders); i++ )
+    {
+        if( annexb_finders[i].pf_usable && !annexb_finders[i].pf_usable() )
+            continue;
+        size_t i_found = 0;
+        vlc_tick_t start = vlc_tick_now();
+        for( const uint8_t *p = p_data;
+             (p = annexb_finders[i].pf_find( p, &p_data[i_data] )) != NULL; p++ )
+            i_found++;
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+        printf("%s: %zu startcodes in %"PRId64" us\n",
+               annexb_finders[i].psz_name, i_found, US_FROM_VLC_TICK(elapsed));
+    }
+    free( p_data );
+}
+
 int main( void )
 {
     const uint8_t test1_annexbdata[] = { 0, 0, 0, 1, 0x55, 0x55, 0x55, 0x55, 0x55, // 9
@@ -134,5 +186,7 @@ int main( void )
             return i_ret;
     }
 
+    bench_annexb();
+
     return 0;
 }
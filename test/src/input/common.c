@@ -41,6 +41,9 @@ void vlc_run_args_init(struct vlc_run_args *args)
 
     args->name = getenv("VLC_TARGET");
     args->test_demux_controls = getenv_atoi("VLC_DEMUX_CONTROLS");
+
+    int loops = getenv_atoi("VLC_BENCH");
+    args->bench_loops = loops > 0 ? loops : 0;
 }
 
 libvlc_instance_t *libvlc_create(const struct vlc_run_args *args)
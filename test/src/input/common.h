@@ -37,6 +37,9 @@ struct vlc_run_args
 
     /* true to test demux controls */
     bool test_demux_controls;
+
+    /* number of times each input is demuxed in benchmark mode, 0 if off */
+    unsigned bench_loops;
 };
 
 void vlc_run_args_init(struct vlc_run_args *args);
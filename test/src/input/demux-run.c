@@ -53,6 +53,7 @@ struct test_es_out_t
 {
     struct es_out_t out;
     struct es_out_id_t *ids;
+    struct vlc_demux_stats *stats; /* can be NULL */
 #ifdef HAVE_DECODERS
     vlc_object_t *parent;
 #endif
@@ -106,6 +107,11 @@ static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
 
     //debug("[%p] Sent    ES: %zu\n", (void *)idd, block->i_buffer);
     EsOutCheckId(ctx, id);
+    if (ctx->stats != NULL)
+    {
+        ctx->stats->bytes += block->i_buffer;
+        ctx->stats->blocks++;
+    }
 #ifdef HAVE_DECODERS
     if (id->decoder)
         test_decoder_process(id->decoder, block);
@@ -220,7 +226,8 @@ static const struct es_out_callbacks es_out_cbs =
     .destroy = EsOutDestroy,
 };
 
-static es_out_t *test_es_out_create(vlc_object_t *parent)
+static es_out_t *test_es_out_create(vlc_object_t *parent,
+                                    struct vlc_demux_stats *stats)
 {
     struct test_es_out_t *ctx = malloc(sizeof (*ctx));
     if (ctx == NULL)
@@ -230,6 +237,7 @@ static es_out_t *test_es_out_create(vlc_object_t *parent)
     }
 
     ctx->ids = NULL;
+    ctx->stats = stats;
 
     es_out_t *out = &ctx->out;
     out->cbs = &es_out_cbs;
@@ -279,7 +287,8 @@ static void demux_get_meta(demux_t *demux)
     vlc_meta_Delete(p_meta);
 }
 
-static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
+static int demux_process_stream(const struct vlc_run_args *args, stream_t *s,
+                                struct vlc_demux_stats *stats)
 {
     const char *name = args->name;
     if (name == NULL)
@@ -288,10 +297,12 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
     if (s == NULL)
         return -1;
 
-    es_out_t *out = test_es_out_create(VLC_OBJECT(s));
+    es_out_t *out = test_es_out_create(VLC_OBJECT(s), stats);
     if (out == NULL)
         return -1;
 
+    vlc_tick_t start = vlc_tick_now();
+
     demux_t *demux = demux_New(VLC_OBJECT(s), name, s, out);
     if (demux == NULL)
     {
@@ -331,6 +342,9 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
     demux_Delete(demux);
     es_out_Delete(out);
 
+    if (stats != NULL)
+        stats->seconds += secf_from_vlc_tick(vlc_tick_now() - start);
+
     debug("Completed with %" PRIuMAX " iteration(s).\n", i);
 
     return val == VLC_DEMUXER_EOF ? 0 : -1;
@@ -346,7 +360,7 @@ int vlc_demux_process_url(const struct vlc_run_args *args, const char *url)
     if (s == NULL)
         fprintf(stderr, "Error: cannot create input stream: %s\n", url);
 
-    int ret = demux_process_stream(args, s);
+    int ret = demux_process_stream(args, s, NULL);
     libvlc_release(vlc);
     return ret;
 }
@@ -365,6 +379,41 @@ int vlc_demux_process_path(const struct vlc_run_args *args, const char *path)
     return ret;
 }
 
+int vlc_demux_bench_path(const struct vlc_run_args *args, const char *path,
+                         struct vlc_demux_stats *stats)
+{
+    char *url = vlc_path2uri(path, NULL);
+    if (url == NULL)
+    {
+        fprintf(stderr, "Error: cannot convert path to URL: %s\n", path);
+        return -1;
+    }
+
+    libvlc_instance_t *vlc = libvlc_create(args);
+    if (vlc == NULL)
+    {
+        free(url);
+        return -1;
+    }
+
+    int ret = 0;
+    unsigned loops = args->bench_loops ? args->bench_loops : 1;
+
+    /* The stream is opened anew each time, like a new playback would */
+    for (unsigned i = 0; i < loops && ret == 0; i++)
+    {
+        stream_t *s = vlc_access_NewMRL(VLC_OBJECT(vlc->p_libvlc_int), url);
+        if (s == NULL)
+            fprintf(stderr, "Error: cannot create input stream: %s\n", url);
+
+        ret = demux_process_stream(args, s, stats);
+    }
+
+    libvlc_release(vlc);
+    free(url);
+    return ret;
+}
+
 int libvlc_demux_process_memory(libvlc_instance_t *vlc,
                                 const struct vlc_run_args *args,
                                 const unsigned char *buf, size_t length)
@@ -374,7 +423,7 @@ int libvlc_demux_process_memory(libvlc_instance_t *vlc,
     if (s == NULL)
         fprintf(stderr, "Error: cannot create input stream\n");
 
-    return demux_process_stream(args, s);
+    return demux_process_stream(args, s, NULL);
 }
 
 int vlc_demux_process_memory(const struct vlc_run_args *args,
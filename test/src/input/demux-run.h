@@ -26,10 +26,23 @@
 
 #include "common.h"
 
+struct vlc_demux_stats
+{
+    uint64_t bytes; /**< size of the blocks sent to the ES output */
+    uint64_t blocks; /**< number of blocks sent to the ES output */
+    double seconds; /**< time spent demuxing */
+};
+
 int vlc_demux_process_url(const struct vlc_run_args *, const char *url);
 int vlc_demux_process_path(const struct vlc_run_args *, const char *path);
 int vlc_demux_process_memory(const struct vlc_run_args *,
                              const unsigned char *buf, size_t length);
+/**
+ * Demuxes a file args->bench_loops times (at least once) with the same
+ * LibVLC instance, and accumulates the statistics.
+ */
+int vlc_demux_bench_path(const struct vlc_run_args *, const char *path,
+                         struct vlc_demux_stats *);
 int libvlc_demux_process_memory(libvlc_instance_t *vlc,
                                 const struct vlc_run_args *args,
                                 const unsigned char *buf, size_t length);
@@ -444,6 +444,43 @@ static void test_creation_and_type( libvlc_int_t *p_libvlc )
     assert( var_Get( p_libvlc, "bla", &val ) == VLC_ENOVAR );
 }
 
+static void test_many( libvlc_int_t *p_libvlc )
+{
+    /* enough variables to grow the table several times */
+    enum { COUNT = 1000 };
+    char name[16];
+
+    for( unsigned i = 0; i < COUNT; i++ )
+    {
+        sprintf( name, "many-%u", i );
+        assert( var_Create( p_libvlc, name, VLC_VAR_INTEGER ) == VLC_SUCCESS );
+        var_SetInteger( p_libvlc, name, i );
+    }
+
+    /* remove every other variable, the others must remain reachable */
+    for( unsigned i = 0; i < COUNT; i += 2 )
+    {
+        sprintf( name, "many-%u", i );
+        var_Destroy( p_libvlc, name );
+    }
+
+    for( unsigned i = 0; i < COUNT; i++ )
+    {
+        sprintf( name, "many-%u", i );
+        if( i % 2 )
+            assert( var_GetInteger( p_libvlc, name ) == i );
+        else
+            assert( var_Type( p_libvlc, name ) == 0 );
+    }
+
+    for( unsigned i = 1; i < COUNT; i += 2 )
+    {
+        sprintf( name, "many-%u", i );
+        var_Destroy( p_libvlc, name );
+        assert( var_Type( p_libvlc, name ) == 0 );
+    }
+}
+
 static void test_variables( libvlc_instance_t *p_vlc )
 {
     libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
@@ -481,6 +518,9 @@ static void test_variables( libvlc_instance_t *p_vlc )
 
     test_log( "Testing type at creation\n" );
     test_creation_and_type( p_libvlc );
+
+    test_log( "Testing many variables\n" );
+    test_many( p_libvlc );
 }
 
 
@@ -1709,6 +1709,45 @@ test_set_current_media(struct ctx *ctx)
     test_end(ctx);
 }
 
+static void
+test_standby(struct ctx *ctx)
+{
+    test_log("standby\n");
+
+    vlc_player_t *player = ctx->player;
+    struct media_params params = DEFAULT_MEDIA_PARAMS(VLC_TICK_FROM_MS(100));
+
+    player_set_current_mock_media(ctx, "media1", &params, false);
+    player_start(ctx);
+
+    input_item_t *standby = create_mock_media("media2", &params);
+    assert(standby);
+    vlc_player_SetStandbyMedias(player, &standby, 1);
+
+    wait_state(ctx, VLC_PLAYER_STATE_PLAYING);
+
+    /* Switch to the standby media: its tracks and programs are reported as
+     * for any other media */
+    vec_on_current_media_changed *vec = &ctx->report.on_current_media_changed;
+    assert(vec->size == 1);
+    int ret = vlc_player_SetCurrentMedia(player, standby);
+    assert(ret == VLC_SUCCESS);
+    bool success = vlc_vector_push(&ctx->played_medias, standby);
+    assert(success);
+
+    while (vec->size != 2)
+        vlc_player_CondWait(player, &ctx->wait);
+    assert(VEC_LAST(vec) == standby);
+    assert_media_name(VEC_LAST(vec), "media2");
+
+    vlc_player_SetStandbyMedias(player, NULL, 0);
+
+    wait_state(ctx, VLC_PLAYER_STATE_STOPPED);
+    assert_normal_state(ctx);
+
+    test_end(ctx);
+}
+
 static void
 test_delete_while_playback(vlc_object_t *obj, bool start)
 {
@@ -2246,6 +2285,7 @@ main(void)
 
     test_set_current_media(&ctx);
     test_next_media(&ctx);
+    test_standby(&ctx);
     test_seeks(&ctx);
     test_pause(&ctx);
     test_capabilities_pause(&ctx);
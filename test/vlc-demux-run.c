@@ -28,22 +28,134 @@
 # include "config.h"
 #endif
 
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#ifndef _WIN32
+# include <sys/resource.h>
+#endif
 #include "src/input/demux-run.h"
 
+/* Count the heap allocations, by interposing the C library allocator.
+ * Sanitizers interpose it too, so do not count then. */
+#if defined(__has_feature)
+# if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer)
+#  define NO_ALLOC_COUNT 1
+# endif
+#endif
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) \
+ && !defined(NO_ALLOC_COUNT)
+# define HAVE_ALLOC_COUNT 1
+
+static atomic_ullong alloc_count = ATOMIC_VAR_INIT(0);
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+void *malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+static long peak_rss_kb(void)
+{
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        return ru.ru_maxrss; /* kB on Linux */
+#endif
+    return -1;
+}
+
+static void print_json_string(const char *str)
+{
+    putchar('"');
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '"' || *str == '\\')
+            printf("\\%c", *str);
+        else if ((unsigned char)*str < 0x20)
+            printf("\\u%04x", (unsigned char)*str);
+        else
+            putchar(*str);
+    }
+    putchar('"');
+}
+
+/* One JSON object per line and per input */
+static int bench(const struct vlc_run_args *args, const char *filename)
+{
+    struct vlc_demux_stats stats = { 0, 0, 0. };
+#ifdef HAVE_ALLOC_COUNT
+    unsigned long long allocs = atomic_load(&alloc_count);
+#endif
+
+    int ret = vlc_demux_bench_path(args, filename, &stats);
+
+    double secs = stats.seconds;
+    if (secs <= 0.)
+        secs = 1e-9;
+
+    printf("{\"file\":");
+    print_json_string(filename);
+    printf(",\"demux\":");
+    print_json_string(args->name ? args->name : "any");
+    printf(",\"loops\":%u,\"status\":%d,\"bytes\":%"PRIu64
+           ",\"blocks\":%"PRIu64",\"seconds\":%.6f"
+           ",\"mb_per_s\":%.3f,\"blocks_per_s\":%.1f",
+           args->bench_loops, ret, stats.bytes, stats.blocks, secs,
+           stats.bytes / secs / 1e6, stats.blocks / secs);
+#ifdef HAVE_ALLOC_COUNT
+    allocs = atomic_load(&alloc_count) - allocs;
+    printf(",\"allocs_per_block\":%.2f",
+           stats.blocks ? (double)allocs / stats.blocks : 0.);
+#endif
+    printf(",\"peak_rss_kb\":%ld}\n", peak_rss_kb());
+    fflush(stdout);
+    return ret;
+}
+
 int main(int argc, char *argv[])
 {
     const char *filename;
     struct vlc_run_args args;
     vlc_run_args_init(&args);
 
+    if (args.bench_loops > 0 && argc >= 2)
+    {
+        int ret = 0;
+        for (int i = 1; i < argc; i++)
+            if (bench(&args, argv[i]))
+                ret = 1;
+        return ret;
+    }
+
     switch (argc)
     {
         case 2:
             filename = argv[argc - 1];
             break;
         default:
-            fprintf(stderr, "Usage: [VLC_TARGET=demux] %s <filename>\n", argv[0]);
+            fprintf(stderr, "Usage: [VLC_TARGET=demux] %s <filename>\n"
+                    "       VLC_BENCH=<loops> [VLC_TARGET=demux] %s <filename>...\n",
+                    argv[0], argv[0]);
             return 1;
     }
 
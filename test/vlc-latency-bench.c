@@ -0,0 +1,380 @@
+/**
+ * @file vlc-latency-bench.c
+ */
+/*****************************************************************************
+ * Copyright © 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Measures the glass-to-glass latency of the pipeline: a live I420 source
+ * (imem) paints the frame sequence number into the luma plane, and the
+ * memory video output (vmem) decodes it back when the picture is displayed.
+ * The latency distribution is reported as JSON, once per stream output chain:
+ *
+ * vlc-latency-bench [-s WxH] [-r fps] [-l seconds] [-c chain]...
+ *
+ * Without -c, the source is decoded and displayed directly. With a chain,
+ * e.g. -c 'transcode{vcodec=h264}', the pictures go through the chain to
+ * the display stream output.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vlc/vlc.h>
+#include <vlc_common.h>
+#include <vlc_threads.h>
+
+#define SEQ_BITS 32
+
+struct bench
+{
+    unsigned width, height, fps, count;
+    vlc_tick_t period;
+
+    /* source (input thread) */
+    unsigned next;
+    vlc_tick_t start;
+    vlc_tick_t *sent;
+
+    /* sink (video output thread) */
+    uint8_t *planes;
+    bool *shown;
+    vlc_tick_t *latency;
+    unsigned received;
+    unsigned invalid;
+
+    vlc_mutex_t lock;
+    vlc_sem_t done;
+};
+
+static void stamp(uint8_t *luma, unsigned width, unsigned height,
+                  uint32_t seq)
+{
+    unsigned bw = width / SEQ_BITS, bh = height < bw ? height : bw;
+
+    for (unsigned y = 0; y < bh; y++)
+        for (unsigned b = 0; b < SEQ_BITS; b++)
+            memset(luma + y * width + b * bw,
+                   ((seq >> b) & 1) ? 235 : 16, bw);
+}
+
+static uint32_t unstamp(const uint8_t *luma, unsigned pitch, unsigned width,
+                        unsigned height)
+{
+    unsigned bw = width / SEQ_BITS, bh = height < bw ? height : bw;
+    const uint8_t *row = luma + (bh / 2) * pitch;
+    uint32_t seq = 0;
+
+    /* sample the middle of each block, away from the scaling/coding edges */
+    for (unsigned b = 0; b < SEQ_BITS; b++)
+        if (row[b * bw + bw / 2] >= 128)
+            seq |= UINT32_C(1) << b;
+    return seq;
+}
+
+static int source_get(void *data, const char *cookie, int64_t *dts,
+                      int64_t *pts, unsigned *flags, size_t *size, void **buf)
+{
+    struct bench *b = data;
+    (void) cookie;
+
+    if (b->next >= b->count)
+        return 1; /* end of stream */
+
+    size_t luma = b->width * b->height;
+    uint8_t *frame = malloc(luma + 2 * (luma / 4));
+    if (frame == NULL)
+        return 1;
+
+    memset(frame + luma, 128, 2 * (luma / 4));
+    memset(frame, 16, luma);
+
+    unsigned seq = b->next++;
+    stamp(frame, b->width, b->height, seq);
+
+    /* behave like a capture device: the frame exists at its capture time */
+    if (b->start == VLC_TICK_INVALID)
+        b->start = vlc_tick_now();
+    vlc_tick_wait(b->start + seq * b->period);
+
+    vlc_mutex_lock(&b->lock);
+    b->sent[seq] = vlc_tick_now();
+    vlc_mutex_unlock(&b->lock);
+
+    *dts = *pts = seq * b->period;
+    *flags = 0;
+    *size = luma + 2 * (luma / 4);
+    *buf = frame;
+    return 0;
+}
+
+static void source_release(void *data, const char *cookie, size_t size,
+                           void *buf)
+{
+    (void) data; (void) cookie; (void) size;
+    free(buf);
+}
+
+static void *sink_lock(void *data, void **planes)
+{
+    struct bench *b = data;
+    size_t luma = b->width * b->height;
+
+    /* vmem uses the luma pitch for the chroma planes too */
+    planes[0] = b->planes;
+    planes[1] = b->planes + luma;
+    planes[2] = b->planes + luma + luma / 2;
+    return NULL;
+}
+
+static void sink_display(void *data, void *id)
+{
+    struct bench *b = data;
+    vlc_tick_t now = vlc_tick_now();
+    uint32_t seq = unstamp(b->planes, b->width, b->width, b->height);
+    (void) id;
+
+    vlc_mutex_lock(&b->lock);
+    if (seq < b->count && b->sent[seq] != VLC_TICK_INVALID)
+    {   /* count only the first display of a repeated picture */
+        if (!b->shown[seq])
+        {
+            b->shown[seq] = true;
+            b->latency[b->received++] = now - b->sent[seq];
+        }
+    }
+    else
+        b->invalid++;
+    vlc_mutex_unlock(&b->lock);
+}
+
+static void on_stopped(const libvlc_event_t *event, void *data)
+{
+    (void) event;
+    vlc_sem_post(data);
+}
+
+static int cmp_tick(const void *a, const void *b)
+{
+    vlc_tick_t x = *(const vlc_tick_t *)a, y = *(const vlc_tick_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_ms(const vlc_tick_t *sorted, unsigned n, unsigned p)
+{
+    if (n == 0)
+        return 0.;
+    return secf_from_vlc_tick(sorted[(n - 1) * p / 100]) * 1000.;
+}
+
+static int run(struct bench *b, const char *chain)
+{
+    char *sout = NULL;
+    if (chain != NULL && asprintf(&sout, "--sout=#%s:display", chain) < 0)
+        return -1;
+
+    const char *args[4] = { "-q", "--ignore-config", "--no-audio" };
+    int nargs = 3;
+    if (sout != NULL)
+        args[nargs++] = sout;
+
+    libvlc_instance_t *vlc = libvlc_new(nargs, args);
+    free(sout);
+    if (vlc == NULL)
+        return -1;
+
+    libvlc_media_t *media = libvlc_media_new_location(vlc, "imem://");
+    if (media == NULL)
+    {
+        libvlc_release(vlc);
+        return -1;
+    }
+
+    char opt[64];
+    snprintf(opt, sizeof (opt), ":imem-get=%"PRIdPTR,
+             (intptr_t) source_get);
+    libvlc_media_add_option(media, opt);
+    snprintf(opt, sizeof (opt), ":imem-release=%"PRIdPTR,
+             (intptr_t) source_release);
+    libvlc_media_add_option(media, opt);
+    snprintf(opt, sizeof (opt), ":imem-data=%"PRIuPTR, (uintptr_t) b);
+    libvlc_media_add_option(media, opt);
+    libvlc_media_add_option(media, ":imem-cat=2");
+    libvlc_media_add_option(media, ":imem-codec=I420");
+    snprintf(opt, sizeof (opt), ":imem-width=%u", b->width);
+    libvlc_media_add_option(media, opt);
+    snprintf(opt, sizeof (opt), ":imem-height=%u", b->height);
+    libvlc_media_add_option(media, opt);
+    snprintf(opt, sizeof (opt), ":imem-fps=%u/1", b->fps);
+    libvlc_media_add_option(media, opt);
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(media);
+    if (mp == NULL)
+    {
+        libvlc_media_release(media);
+        libvlc_release(vlc);
+        return -1;
+    }
+
+    libvlc_video_set_callbacks(mp, sink_lock, NULL, sink_display, b);
+    libvlc_video_set_format(mp, "I420", b->width, b->height, b->width);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(mp);
+    libvlc_event_attach(em, libvlc_MediaPlayerEndReached, on_stopped,
+                        &b->done);
+    libvlc_event_attach(em, libvlc_MediaPlayerEncounteredError, on_stopped,
+                        &b->done);
+
+    int ret = libvlc_media_player_play(mp);
+    if (ret == 0)
+        vlc_sem_wait(&b->done);
+
+    libvlc_media_player_stop_async(mp);
+    libvlc_media_player_release(mp);
+    libvlc_media_release(media);
+    libvlc_release(vlc);
+    return ret;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-s WxH] [-r fps] [-l seconds] [-c chain]...\n",
+            name);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned width = 640, height = 360, fps = 25, length = 10;
+    const char *chains[16];
+    unsigned nchains = 0;
+    int c;
+
+    while ((c = getopt(argc, argv, "s:r:l:c:")) != -1)
+        switch (c)
+        {
+            case 's':
+                if (sscanf(optarg, "%ux%u", &width, &height) != 2)
+                {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'r':
+                fps = strtoul(optarg, NULL, 10);
+                break;
+            case 'l':
+                length = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                if (nchains < ARRAY_SIZE(chains))
+                    chains[nchains++] = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+
+    /* the blocks must survive 4:2:0 subsampling and block based codecs */
+    if (width < 16 * SEQ_BITS || height < 16 || (width | height) & 1
+     || fps == 0 || length == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (nchains == 0)
+        chains[nchains++] = NULL;
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 0);
+
+    struct bench b = {
+        .width = width, .height = height, .fps = fps,
+        .count = fps * length,
+        .period = vlc_tick_from_samples(1, fps),
+    };
+
+    b.sent = malloc(b.count * sizeof (*b.sent));
+    b.shown = malloc(b.count * sizeof (*b.shown));
+    b.latency = malloc(b.count * sizeof (*b.latency));
+    b.planes = malloc(2 * width * height);
+    if (b.sent == NULL || b.shown == NULL || b.latency == NULL
+     || b.planes == NULL)
+        goto error;
+
+    vlc_mutex_init(&b.lock);
+    vlc_sem_init(&b.done, 0);
+
+    for (unsigned i = 0; i < nchains; i++)
+    {
+        b.next = 0;
+        b.start = VLC_TICK_INVALID;
+        b.received = 0;
+        b.invalid = 0;
+        for (unsigned j = 0; j < b.count; j++)
+        {
+            b.sent[j] = VLC_TICK_INVALID;
+            b.shown[j] = false;
+        }
+
+        if (run(&b, chains[i]))
+            goto error_run;
+
+        qsort(b.latency, b.received, sizeof (*b.latency), cmp_tick);
+
+        double mean = 0.;
+        for (unsigned j = 0; j < b.received; j++)
+            mean += secf_from_vlc_tick(b.latency[j]) * 1000.;
+        if (b.received > 0)
+            mean /= b.received;
+
+        printf("{\"width\":%u,\"height\":%u,\"fps\":%u,\"length\":%u,"
+               "\"chain\":\"%s\",\"sent\":%u,\"received\":%u,"
+               "\"invalid\":%u,\"min\":%.3f,\"p50\":%.3f,\"p90\":%.3f,"
+               "\"p99\":%.3f,\"max\":%.3f,\"mean\":%.3f}\n",
+               width, height, fps, length,
+               chains[i] != NULL ? chains[i] : "", b.next, b.received,
+               b.invalid, percentile_ms(b.latency, b.received, 0),
+               percentile_ms(b.latency, b.received, 50),
+               percentile_ms(b.latency, b.received, 90),
+               percentile_ms(b.latency, b.received, 99),
+               percentile_ms(b.latency, b.received, 100), mean);
+        fflush(stdout);
+    }
+
+    vlc_sem_destroy(&b.done);
+    free(b.planes);
+    free(b.latency);
+    free(b.shown);
+    free(b.sent);
+    return 0;
+
+error_run:
+    vlc_sem_destroy(&b.done);
+error:
+    free(b.planes);
+    free(b.latency);
+    free(b.shown);
+    free(b.sent);
+    return 1;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file vlc-transcode-bench.c
+ */
+/*****************************************************************************
+ * Copyright © 2021 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Transcodes a synthetic source from the mock demuxer, as fast as possible,
+ * into the dummy stream output, and reports the throughput as JSON:
+ *
+ * vlc-transcode-bench [-s WxH] [-r fps] [-l seconds] [-c vcodec]
+ *                     [-e venc] [-m mux]
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <vlc/vlc.h>
+#include <vlc_common.h>
+#include <vlc_threads.h>
+
+static void on_stopped(const libvlc_event_t *event, void *data)
+{
+    (void) event;
+    vlc_sem_post(data);
+}
+
+static double sec_from_timeval(const struct timeval *tv)
+{
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-s WxH] [-r fps] [-l seconds] [-c vcodec] "
+            "[-e venc] [-m mux]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned width = 1280, height = 720, fps = 25, length = 10;
+    const char *vcodec = "h264", *venc = NULL, *mux = "ts";
+    int c;
+
+    while ((c = getopt(argc, argv, "s:r:l:c:e:m:")) != -1)
+        switch (c)
+        {
+            case 's':
+                if (sscanf(optarg, "%ux%u", &width, &height) != 2)
+                {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'r':
+                fps = strtoul(optarg, NULL, 10);
+                break;
+            case 'l':
+                length = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                vcodec = optarg;
+                break;
+            case 'e':
+                venc = optarg;
+                break;
+            case 'm':
+                mux = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+
+    if (width == 0 || height == 0 || fps == 0 || length == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char *sout, *mrl;
+    if (asprintf(&sout, "--sout=#transcode{vcodec=%s%s%s}"
+                 ":std{access=dummy,mux=%s}", vcodec,
+                 venc != NULL ? ",venc=" : "", venc != NULL ? venc : "",
+                 mux) < 0)
+        return 1;
+    if (asprintf(&mrl, "mock://video_track_count=1;video_width=%u;"
+                 "video_height=%u;video_frame_rate=%u;length=%"PRId64,
+                 width, height, fps,
+                 (int64_t) VLC_TICK_FROM_SEC(length)) < 0)
+    {
+        free(sout);
+        return 1;
+    }
+
+    setenv("VLC_PLUGIN_PATH", "../modules", 0);
+
+    const char *args[] = { "-q", "--ignore-config", "--no-audio", sout };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    free(sout);
+    if (vlc == NULL)
+    {
+        free(mrl);
+        return 1;
+    }
+
+    libvlc_media_t *media = libvlc_media_new_location(vlc, mrl);
+    free(mrl);
+    if (media == NULL)
+    {
+        libvlc_release(vlc);
+        return 1;
+    }
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(media);
+    if (mp == NULL)
+    {
+        libvlc_media_release(media);
+        libvlc_release(vlc);
+        return 1;
+    }
+
+    vlc_sem_t sem;
+    vlc_sem_init(&sem, 0);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager(mp);
+    libvlc_event_attach(em, libvlc_MediaPlayerEndReached, on_stopped, &sem);
+    libvlc_event_attach(em, libvlc_MediaPlayerEncounteredError, on_stopped,
+                        &sem);
+
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    vlc_tick_t start = vlc_tick_now();
+
+    int ret = libvlc_media_player_play(mp);
+    if (ret == 0)
+        vlc_sem_wait(&sem);
+
+    vlc_tick_t wall = vlc_tick_now() - start;
+    getrusage(RUSAGE_SELF, &after);
+
+    libvlc_media_stats_t stats;
+    if (!libvlc_media_get_stats(media, &stats))
+        stats.i_decoded_video = 0;
+
+    libvlc_media_player_stop_async(mp);
+    libvlc_media_player_release(mp);
+    libvlc_media_release(media);
+    libvlc_release(vlc);
+    vlc_sem_destroy(&sem);
+
+    if (ret != 0)
+        return 1;
+
+    double secs = secf_from_vlc_tick(wall);
+    printf("{\"width\":%u,\"height\":%u,\"fps\":%u,\"length\":%u,"
+           "\"vcodec\":\"%s\",\"venc\":\"%s\",\"mux\":\"%s\","
+           "\"frames\":%d,\"time\":%.3f,\"throughput\":%.2f,"
+           "\"cpu_user\":%.3f,\"cpu_system\":%.3f,\"max_rss\":%ld}\n",
+           width, height, fps, length, vcodec, venc != NULL ? venc : "",
+           mux, stats.i_decoded_video, secs,
+           secs > 0. ? stats.i_decoded_video / secs : 0.,
+           sec_from_timeval(&after.ru_utime)
+               - sec_from_timeval(&before.ru_utime),
+           sec_from_timeval(&after.ru_stime)
+               - sec_from_timeval(&before.ru_stime),
+           after.ru_maxrss);
+    return 0;
+}